@@ -25,6 +25,18 @@
 #include "kernel/register.h"
 #include "kernel/celltypes.h"
 
+#ifdef YOSYS_LINK_ABC
+namespace abc {
+	typedef struct Abc_Frame_t_ Abc_Frame_t;
+	void Abc_Start();
+	void Abc_Stop();
+	Abc_Frame_t *Abc_FrameGetGlobalFrame();
+	int Cmd_CommandExecute(Abc_Frame_t *pAbc, const char *sCommand);
+	void Abc_FrameGiaInputMiniAig(Abc_Frame_t *pAbc, void *p);
+	void *Abc_FrameGiaOutputMiniAig(Abc_Frame_t *pAbc);
+}
+#endif
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
@@ -66,6 +78,7 @@ struct Index {
 	int index_wires(ModuleInfo &info, RTLIL::Module *m)
 	{
 		int sum = 0;
+		info.windices.reserve(GetSize(m->wires_));
 		for (auto w : m->wires()) {
 			info.windices[w] = sum;
 			sum += w->width;
@@ -137,9 +150,59 @@ struct Index {
 		top_minfo = &modules.at(top);
 	}
 
+	// The AND gates emitted so far for structural hashing, by their (ordered)
+	// inputs. This is a flat table with open addressing instead of a dict, as
+	// it holds one entry per gate: for the largest designs it is the biggest
+	// data structure of the writer, and a dict adds chaining links and a
+	// separate hash bucket array to each entry.
+	struct StrashTable {
+		struct Slot {
+			Lit a, b, out;
+		};
+		std::vector<Slot> slots;
+		size_t used = 0;
+
+		size_t bucket(Lit a, Lit b) const
+		{
+			uint64_t key = (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+			key *= 0x9e3779b97f4a7c15ULL;
+			return (key ^ (key >> 29)) & (slots.size() - 1);
+		}
+
+		const Lit *find(Lit a, Lit b) const
+		{
+			if (slots.empty())
+				return nullptr;
+			for (size_t i = bucket(a, b);; i = (i + 1) & (slots.size() - 1)) {
+				const Slot &slot = slots[i];
+				if (slot.a == Writer::EMPTY_LIT)
+					return nullptr;
+				if (slot.a == a && slot.b == b)
+					return &slot.out;
+			}
+		}
+
+		void insert(Lit a, Lit b, Lit out)
+		{
+			if ((used + 1) * 4 > slots.size() * 3) {
+				std::vector<Slot> old_slots(std::max<size_t>(slots.size() * 2, 1024), Slot{Writer::EMPTY_LIT, Writer::EMPTY_LIT, Writer::EMPTY_LIT});
+				old_slots.swap(slots);
+				used = 0;
+				for (auto &slot : old_slots)
+					if (slot.a != Writer::EMPTY_LIT)
+						insert(slot.a, slot.b, slot.out);
+			}
+			size_t i = bucket(a, b);
+			while (slots[i].a != Writer::EMPTY_LIT)
+				i = (i + 1) & (slots.size() - 1);
+			slots[i] = {a, b, out};
+			used++;
+		}
+	};
+
 	bool const_folding = true;
 	bool strashing = false;
-	dict<std::pair<Lit, Lit>, Lit> cache;
+	StrashTable cache;
 
 	Lit AND(Lit a, Lit b)
 	{
@@ -156,15 +219,12 @@ struct Index {
 			return (static_cast<Writer*>(this))->emit_gate(a, b);
 		} else {
 			if (a < b) std::swap(a, b);
-			auto pair = std::make_pair(a, b);
 
-			if (!cache.count(pair)) {
-				Lit nl = (static_cast<Writer*>(this))->emit_gate(a, b);
-				cache[pair] = nl;
-				return nl;
-			} else {
-				return cache.at(pair);
-			}
+			if (const Lit *found = cache.find(a, b))
+				return *found;
+			Lit nl = (static_cast<Writer*>(this))->emit_gate(a, b);
+			cache.insert(a, b, nl);
+			return nl;
 		}
 	}
 
@@ -1461,4 +1521,238 @@ struct XAiger2Backend : Backend {
 	}
 } XAiger2Backend;
 
+#ifdef YOSYS_LINK_ABC
+// The layout of `Mini_Aig_t` from ABC's src/aig/miniaig/miniaig.h, which is the interface ABC offers for exchanging
+// AIGs with the program it is linked into. Every object takes two entries of `pArray`, holding the two fanin
+// literals of an AND gate, `MINI_AIG_NULL` twice for a primary input, or the driver literal and `MINI_AIG_NULL` for
+// a primary output. Object 0 is the constant false, so literals are numbered the same way as in AIGER files.
+struct MiniAig {
+	int nCap;
+	int nSize;
+	int nRegs;
+	int *pArray;
+};
+
+const static int MINI_AIG_NULL = 0x7FFFFFFF;
+
+struct MiniAigWriter : Index<MiniAigWriter, int, 0, 1> {
+	typedef int Lit;
+
+	const static constexpr Lit EMPTY_LIT = -1;
+
+	static Lit negate(Lit lit) {
+		return lit ^ 1;
+	}
+
+	std::vector<int> objects;
+	std::vector<SigBit> inputs, outputs;
+	int nands = 0;
+
+	Lit add_object(int fanin0, int fanin1)
+	{
+		Lit lit = GetSize(objects);
+		objects.push_back(fanin0);
+		objects.push_back(fanin1);
+		return lit;
+	}
+
+	Lit emit_gate(Lit a, Lit b)
+	{
+		nands++;
+		return add_object(a, b);
+	}
+
+	void build()
+	{
+		add_object(MINI_AIG_NULL, MINI_AIG_NULL);
+
+		for (auto id : top->ports) {
+			Wire *w = top->wire(id);
+			log_assert(w);
+			if (w->port_input)
+			for (int i = 0; i < w->width; i++) {
+				pi_literal(SigBit(w, i)) = add_object(MINI_AIG_NULL, MINI_AIG_NULL);
+				inputs.push_back(SigBit(w, i));
+			}
+		}
+
+		std::vector<Lit> po_lits;
+		for (auto id : top->ports) {
+			Wire *w = top->wire(id);
+			if (w->port_output)
+			for (int i = 0; i < w->width; i++) {
+				po_lits.push_back(eval_po(SigBit(w, i)));
+				outputs.push_back(SigBit(w, i));
+			}
+		}
+		for (auto lit : po_lits)
+			add_object(lit, MINI_AIG_NULL);
+	}
+};
+
+// Replaces the logic of `module` with the AND-inverter graph returned by ABC.
+static void import_mini_aig(Module *module, const MiniAigWriter &writer, const MiniAig *aig)
+{
+	int nobjects = aig->nSize / 2;
+	std::vector<SigBit> bits(nobjects, State::S0);
+	dict<int, SigBit> negated;
+
+	auto lit_bit = [&](int lit) -> SigBit {
+		SigBit bit = bits.at(lit >> 1);
+		if (!(lit & 1))
+			return bit;
+		if (lit == 1)
+			return State::S1;
+		if (!negated.count(lit)) {
+			Wire *w = module->addWire(NEW_ID);
+			module->addNotGate(NEW_ID, bit, w);
+			negated[lit] = w;
+		}
+		return negated.at(lit);
+	};
+
+	std::vector<Cell *> old_cells;
+	for (auto cell : module->cells())
+		if (cell->type.in(KNOWN_OPS))
+			old_cells.push_back(cell);
+	for (auto cell : old_cells)
+		module->remove(cell);
+	module->new_connections({});
+
+	int ninputs = 0, noutputs = 0, nands = 0;
+	for (int id = 1; id < nobjects; id++) {
+		int fanin0 = aig->pArray[2 * id], fanin1 = aig->pArray[2 * id + 1];
+		if (fanin0 == MINI_AIG_NULL) {
+			if (ninputs >= GetSize(writer.inputs))
+				log_error("ABC returned more inputs than were provided for module %s.\n", log_id(module));
+			bits[id] = writer.inputs[ninputs++];
+		} else if (fanin1 == MINI_AIG_NULL) {
+			if (noutputs >= GetSize(writer.outputs))
+				log_error("ABC returned more outputs than were provided for module %s.\n", log_id(module));
+			module->connect(writer.outputs[noutputs++], lit_bit(fanin0));
+		} else {
+			Wire *w = module->addWire(NEW_ID);
+			module->addAndGate(NEW_ID, lit_bit(fanin0), lit_bit(fanin1), w);
+			bits[id] = w;
+			nands++;
+		}
+	}
+	if (ninputs != GetSize(writer.inputs) || noutputs != GetSize(writer.outputs))
+		log_error("ABC returned %d inputs and %d outputs for module %s, expected %d and %d.\n",
+				  ninputs, noutputs, log_id(module), GetSize(writer.inputs), GetSize(writer.outputs));
+
+	log("Imported %d AND gates and %d inverters into module %s.\n", nands, GetSize(negated), log_id(module));
+}
+
+struct AbcMiniPass : Pass {
+	AbcMiniPass() : Pass("abc_mini", "(experimental) optimize combinational logic with the linked-in ABC")
+	{
+		experimental();
+	}
+
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    abc_mini [options] [selection]\n");
+		log("\n");
+		log("This pass hands the combinational logic of each selected module to the ABC\n");
+		log("library linked into Yosys as an in-memory AIG, runs an ABC script on it, and\n");
+		log("replaces the logic of the module with the resulting AIG, made of $_AND_ and\n");
+		log("$_NOT_ cells. Unlike 'abc' and 'abc9', it writes no temporary files and starts\n");
+		log("no processes. It is only available when Yosys is built with LINK_ABC=1.\n");
+		log("\n");
+		log("Modules with cells that 'write_aiger2' cannot ingest are skipped. Internal\n");
+		log("wires lose their drivers and are left for 'opt_clean' to remove.\n");
+		log("\n");
+		log("    -script <commands>\n");
+		log("        run the given ABC commands, which must read and write the AIG in the\n");
+		log("        '&' space (default: \"&st; &syn2\").\n");
+		log("\n");
+		log("    -strash\n");
+		log("        perform structural hashing while building the AIG\n");
+		log("\n");
+	}
+
+	void execute(std::vector<std::string> args, Design *design) override
+	{
+		log_header(design, "Executing ABC_MINI pass (optimizing logic with the linked-in ABC).\n");
+
+		std::string script = "&st; &syn2";
+		bool strashing = false;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-script" && argidx+1 < args.size()) {
+				script = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-strash") {
+				strashing = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		std::vector<Module *> modules;
+		for (auto module : design->selected_whole_modules_warn()) {
+			if (module->has_processes_warn())
+				continue;
+			bool supported = true;
+			for (auto cell : module->cells())
+				if (!cell->type.in(KNOWN_OPS) && !cell->type.in(ID($scopeinfo), ID($specify2), ID($specify3))) {
+					log("Skipping module %s as it contains unsupported cell %s (%s).\n",
+						log_id(module), log_id(cell), log_id(cell->type));
+					supported = false;
+					break;
+				}
+			for (auto id : module->ports)
+				if (module->wire(id)->port_input && module->wire(id)->port_output) {
+					log("Skipping module %s as it has inout port %s.\n", log_id(module), log_id(id));
+					supported = false;
+					break;
+				}
+			if (supported)
+				modules.push_back(module);
+		}
+
+		std::vector<MiniAigWriter> writers(modules.size());
+		design->bufNormalize(true);
+		for (int i = 0; i < GetSize(modules); i++) {
+			writers[i].strashing = strashing;
+			writers[i].setup(modules[i]);
+			writers[i].build();
+		}
+		// see the comment in `write_aiger2`
+		design->bufNormalize(false);
+
+		if (modules.empty())
+			return;
+
+		abc::Abc_Start();
+		abc::Abc_Frame_t *frame = abc::Abc_FrameGetGlobalFrame();
+		for (int i = 0; i < GetSize(modules); i++) {
+			MiniAigWriter &writer = writers[i];
+			log("Passing module %s to ABC as an AIG with %d inputs, %d outputs and %d AND gates.\n",
+				log_id(modules[i]), GetSize(writer.inputs), GetSize(writer.outputs), writer.nands);
+
+			MiniAig input = {GetSize(writer.objects), GetSize(writer.objects), 0, writer.objects.data()};
+			abc::Abc_FrameGiaInputMiniAig(frame, &input);
+			if (abc::Cmd_CommandExecute(frame, script.c_str()) != 0)
+				log_error("ABC: execution of script \"%s\" failed.\n", script.c_str());
+
+			MiniAig *output = (MiniAig *)abc::Abc_FrameGiaOutputMiniAig(frame);
+			if (output == nullptr)
+				log_error("ABC: script \"%s\" left no AIG to read back.\n", script.c_str());
+			import_mini_aig(modules[i], writer, output);
+			// allocated by ABC with malloc()
+			free(output->pArray);
+			free(output);
+		}
+		abc::Abc_Stop();
+	}
+} AbcMiniPass;
+#endif
+
 PRIVATE_NAMESPACE_END
@@ -27,6 +27,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
 #include <string>
+#include <charconv>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -60,13 +61,12 @@ struct BlifDumper
 	RTLIL::Module *module;
 	RTLIL::Design *design;
 	BlifDumperConfig *config;
-	CellTypes ct;
 
 	SigMap sigmap;
 	dict<SigBit, int> init_bits;
 
 	BlifDumper(std::ostream &f, RTLIL::Module *module, RTLIL::Design *design, BlifDumperConfig *config) :
-			f(f), module(module), design(design), config(config), ct(design), sigmap(module)
+			f(f), module(module), design(design), config(config), sigmap(module)
 	{
 		for (Wire *wire : module->wires())
 			if (wire->attributes.count(ID::init)) {
@@ -88,6 +88,27 @@ struct BlifDumper
 
 	pool<SigBit> cstr_bits_seen;
 
+	// Output is collected in a single buffer that is handed to the stream in
+	// large blocks, and the escaped name of every wire and id is computed once.
+	static const size_t buffer_size = 1 << 20;
+	std::string out;
+	dict<RTLIL::IdString, std::string> id_names;
+	dict<RTLIL::Wire*, std::string> wire_names;
+	dict<RTLIL::IdString, const char*> cell_kinds;
+
+	void flush()
+	{
+		f.write(out.data(), out.size());
+		out.clear();
+	}
+
+	void put_int(int value)
+	{
+		char buf[16];
+		auto res = std::to_chars(buf, buf + sizeof(buf), value);
+		out.append(buf, res.ptr);
+	}
+
 	const std::string str(RTLIL::IdString id)
 	{
 		std::string str = RTLIL::unescape_id(id);
@@ -97,37 +118,52 @@ struct BlifDumper
 		return str;
 	}
 
-	const std::string str(RTLIL::SigBit sig)
+	const std::string &cached_str(RTLIL::IdString id)
+	{
+		auto it = id_names.find(id);
+		if (it == id_names.end())
+			it = id_names.emplace(id, str(id)).first;
+		return it->second;
+	}
+
+	void put_id(RTLIL::IdString id)
+	{
+		out += cached_str(id);
+	}
+
+	void put_bit(RTLIL::SigBit sig)
 	{
-		cstr_bits_seen.insert(sig);
+		if (config->noalias_mode)
+			cstr_bits_seen.insert(sig);
 
 		if (sig.wire == NULL) {
-			if (sig == RTLIL::State::S0) return config->false_type == "-" || config->false_type == "+" ? config->false_out.c_str() : "$false";
-			if (sig == RTLIL::State::S1) return config->true_type == "-" || config->true_type == "+" ? config->true_out.c_str() : "$true";
-			return config->undef_type == "-" || config->undef_type == "+" ? config->undef_out.c_str() : "$undef";
+			if (sig == RTLIL::State::S0) out += config->false_type == "-" || config->false_type == "+" ? config->false_out.c_str() : "$false";
+			else if (sig == RTLIL::State::S1) out += config->true_type == "-" || config->true_type == "+" ? config->true_out.c_str() : "$true";
+			else out += config->undef_type == "-" || config->undef_type == "+" ? config->undef_out.c_str() : "$undef";
+			return;
 		}
 
-		std::string str = RTLIL::unescape_id(sig.wire->name);
-		for (size_t i = 0; i < str.size(); i++)
-			if (str[i] == '#' || str[i] == '=' || str[i] == '<' || str[i] == '>')
-				str[i] = '?';
+		auto it = wire_names.find(sig.wire);
+		if (it == wire_names.end())
+			it = wire_names.emplace(sig.wire, str(sig.wire->name)).first;
+		out += it->second;
 
-		if (sig.wire->width != 1)
-			str += stringf("[%d]", sig.wire->upto ? sig.wire->start_offset+sig.wire->width-sig.offset-1 : sig.wire->start_offset+sig.offset);
-
-		return str;
+		if (sig.wire->width != 1) {
+			out += '[';
+			put_int(sig.wire->upto ? sig.wire->start_offset+sig.wire->width-sig.offset-1 : sig.wire->start_offset+sig.offset);
+			out += ']';
+		}
 	}
 
-	const std::string str_init(RTLIL::SigBit sig)
+	void put_init(RTLIL::SigBit sig)
 	{
 		sigmap.apply(sig);
 
-		if (init_bits.count(sig) == 0)
-			return " 2";
-
-		string str = stringf(" %d", init_bits.at(sig));
-
-		return str;
+		auto it = init_bits.find(sig);
+		if (it == init_bits.end())
+			out += " 2";
+		else
+			out += it->second ? " 1" : " 0";
 	}
 
 	const char *subckt_or_gate(std::string cell_type)
@@ -141,30 +177,86 @@ struct BlifDumper
 		return "subckt";
 	}
 
+	const char *subckt_or_gate(RTLIL::IdString cell_type)
+	{
+		auto it = cell_kinds.find(cell_type);
+		if (it == cell_kinds.end())
+			it = cell_kinds.emplace(cell_type, subckt_or_gate(cell_type.str())).first;
+		return it->second;
+	}
+
 	void dump_params(const char *command, dict<IdString, Const> &params)
 	{
 		for (auto &param : params) {
-			f << stringf("%s %s ", command, log_id(param.first));
+			out += command;
+			out += ' ';
+			out += log_id(param.first);
+			out += ' ';
 			if (param.second.flags & RTLIL::CONST_FLAG_STRING) {
 				std::string str = param.second.decode_string();
-				f << stringf("\"");
+				out += '"';
 				for (char ch : str)
-					if (ch == '"' || ch == '\\')
-						f << stringf("\\%c", ch);
-					else if (ch < 32 || ch >= 127)
-						f << stringf("\\%03o", ch);
+					if (ch == '"' || ch == '\\') {
+						out += '\\';
+						out += ch;
+					} else if (ch < 32 || ch >= 127)
+						out += stringf("\\%03o", ch);
 					else
-						f << stringf("%c", ch);
-				f << stringf("\"\n");
-			} else
-				f << stringf("%s\n", param.second.as_string().c_str());
+						out += ch;
+				out += "\"\n";
+			} else {
+				out += param.second.as_string();
+				out += '\n';
+			}
+		}
+	}
+
+	// .names line and cover of a fine-grained gate: the port letters of the
+	// inputs followed by the output, and the rows of the on-set
+	static bool gate_table(RTLIL::IdString type, const char *&ports, const char *&cover)
+	{
+		static const dict<RTLIL::IdString, std::pair<const char*, const char*>> tables = {
+			{ID($_NOT_),    {"AY",    "0 1\n"}},
+			{ID($_AND_),    {"ABY",   "11 1\n"}},
+			{ID($_OR_),     {"ABY",   "1- 1\n-1 1\n"}},
+			{ID($_XOR_),    {"ABY",   "10 1\n01 1\n"}},
+			{ID($_NAND_),   {"ABY",   "0- 1\n-0 1\n"}},
+			{ID($_NOR_),    {"ABY",   "00 1\n"}},
+			{ID($_XNOR_),   {"ABY",   "11 1\n00 1\n"}},
+			{ID($_ANDNOT_), {"ABY",   "10 1\n"}},
+			{ID($_ORNOT_),  {"ABY",   "1- 1\n-0 1\n"}},
+			{ID($_AOI3_),   {"ABCY",  "-00 1\n0-0 1\n"}},
+			{ID($_OAI3_),   {"ABCY",  "00- 1\n--0 1\n"}},
+			{ID($_AOI4_),   {"ABCDY", "-0-0 1\n-00- 1\n0--0 1\n0-0- 1\n"}},
+			{ID($_OAI4_),   {"ABCDY", "00-- 1\n--00 1\n"}},
+			{ID($_MUX_),    {"ABSY",  "1-0 1\n-11 1\n"}},
+			{ID($_NMUX_),   {"ABSY",  "0-0 1\n-01 1\n"}},
+		};
+		auto it = tables.find(type);
+		if (it == tables.end())
+			return false;
+		ports = it->second.first;
+		cover = it->second.second;
+		return true;
+	}
+
+	static RTLIL::IdString port_letter(char ch)
+	{
+		switch (ch) {
+			case 'A': return ID::A;
+			case 'B': return ID::B;
+			case 'C': return ID::C;
+			case 'D': return ID::D;
+			case 'S': return ID::S;
+			default: return ID::Y;
 		}
 	}
 
 	void dump()
 	{
-		f << stringf("\n");
-		f << stringf(".model %s\n", str(module->name).c_str());
+		out += "\n.model ";
+		put_id(module->name);
+		out += '\n';
 
 		std::map<int, RTLIL::Wire*> inputs, outputs;
 
@@ -175,215 +267,134 @@ struct BlifDumper
 				outputs[wire->port_id] = wire;
 		}
 
-		f << stringf(".inputs");
+		out += ".inputs";
 		for (auto &it : inputs) {
 			RTLIL::Wire *wire = it.second;
-			for (int i = 0; i < wire->width; i++)
-				f << stringf(" %s", str(RTLIL::SigSpec(wire, i)).c_str());
+			for (int i = 0; i < wire->width; i++) {
+				out += ' ';
+				put_bit(RTLIL::SigBit(wire, i));
+			}
 		}
-		f << stringf("\n");
+		out += '\n';
 
-		f << stringf(".outputs");
+		out += ".outputs";
 		for (auto &it : outputs) {
 			RTLIL::Wire *wire = it.second;
-			for (int i = 0; i < wire->width; i++)
-				f << stringf(" %s", str(RTLIL::SigSpec(wire, i)).c_str());
+			for (int i = 0; i < wire->width; i++) {
+				out += ' ';
+				put_bit(RTLIL::SigBit(wire, i));
+			}
 		}
-		f << stringf("\n");
+		out += '\n';
 
 		if (module->get_blackbox_attribute()) {
-			f << stringf(".blackbox\n");
-			f << stringf(".end\n");
+			out += ".blackbox\n";
+			out += ".end\n";
 			return;
 		}
 
 		if (!config->impltf_mode) {
 			if (!config->false_type.empty()) {
 				if (config->false_type == "+")
-					f << stringf(".names %s\n", config->false_out.c_str());
+					out += stringf(".names %s\n", config->false_out.c_str());
 				else if (config->false_type != "-")
-					f << stringf(".%s %s %s=$false\n", subckt_or_gate(config->false_type),
+					out += stringf(".%s %s %s=$false\n", subckt_or_gate(config->false_type),
 							config->false_type.c_str(), config->false_out.c_str());
 			} else
-				f << stringf(".names $false\n");
+				out += ".names $false\n";
 			if (!config->true_type.empty()) {
 				if (config->true_type == "+")
-					f << stringf(".names %s\n1\n", config->true_out.c_str());
+					out += stringf(".names %s\n1\n", config->true_out.c_str());
 				else if (config->true_type != "-")
-					f << stringf(".%s %s %s=$true\n", subckt_or_gate(config->true_type),
+					out += stringf(".%s %s %s=$true\n", subckt_or_gate(config->true_type),
 							config->true_type.c_str(), config->true_out.c_str());
 			} else
-				f << stringf(".names $true\n1\n");
+				out += ".names $true\n1\n";
 			if (!config->undef_type.empty()) {
 				if (config->undef_type == "+")
-					f << stringf(".names %s\n", config->undef_out.c_str());
+					out += stringf(".names %s\n", config->undef_out.c_str());
 				else if (config->undef_type != "-")
-					f << stringf(".%s %s %s=$undef\n", subckt_or_gate(config->undef_type),
+					out += stringf(".%s %s %s=$undef\n", subckt_or_gate(config->undef_type),
 							config->undef_type.c_str(), config->undef_out.c_str());
 			} else
-				f << stringf(".names $undef\n");
+				out += ".names $undef\n";
 		}
 
 		for (auto cell : module->cells())
 		{
+			if (out.size() >= buffer_size)
+				flush();
+
 			if (cell->type == ID($scopeinfo))
 				continue;
 
 			if (config->unbuf_types.count(cell->type)) {
 				auto portnames = config->unbuf_types.at(cell->type);
-				f << stringf(".names %s %s\n1 1\n",
-						str(cell->getPort(portnames.first)).c_str(), str(cell->getPort(portnames.second)).c_str());
+				out += ".names ";
+				put_bit(cell->getPort(portnames.first));
+				out += ' ';
+				put_bit(cell->getPort(portnames.second));
+				out += "\n1 1\n";
 				continue;
 			}
 
-			if (!config->icells_mode && cell->type == ID($_NOT_)) {
-				f << stringf(".names %s %s\n0 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_AND_)) {
-				f << stringf(".names %s %s %s\n11 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_OR_)) {
-				f << stringf(".names %s %s %s\n1- 1\n-1 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_XOR_)) {
-				f << stringf(".names %s %s %s\n10 1\n01 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_NAND_)) {
-				f << stringf(".names %s %s %s\n0- 1\n-0 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_NOR_)) {
-				f << stringf(".names %s %s %s\n00 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_XNOR_)) {
-				f << stringf(".names %s %s %s\n11 1\n00 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_ANDNOT_)) {
-				f << stringf(".names %s %s %s\n10 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_ORNOT_)) {
-				f << stringf(".names %s %s %s\n1- 1\n-0 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_AOI3_)) {
-				f << stringf(".names %s %s %s %s\n-00 1\n0-0 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::C)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_OAI3_)) {
-				f << stringf(".names %s %s %s %s\n00- 1\n--0 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(), str(cell->getPort(ID::C)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_AOI4_)) {
-				f << stringf(".names %s %s %s %s %s\n-0-0 1\n-00- 1\n0--0 1\n0-0- 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(),
-						str(cell->getPort(ID::C)).c_str(), str(cell->getPort(ID::D)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_OAI4_)) {
-				f << stringf(".names %s %s %s %s %s\n00-- 1\n--00 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(),
-						str(cell->getPort(ID::C)).c_str(), str(cell->getPort(ID::D)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_MUX_)) {
-				f << stringf(".names %s %s %s %s\n1-0 1\n-11 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(),
-						str(cell->getPort(ID::S)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_NMUX_)) {
-				f << stringf(".names %s %s %s %s\n0-0 1\n-01 1\n",
-						str(cell->getPort(ID::A)).c_str(), str(cell->getPort(ID::B)).c_str(),
-						str(cell->getPort(ID::S)).c_str(), str(cell->getPort(ID::Y)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_FF_)) {
-				f << stringf(".latch %s %s%s\n", str(cell->getPort(ID::D)).c_str(), str(cell->getPort(ID::Q)).c_str(),
-						str_init(cell->getPort(ID::Q)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_DFF_N_)) {
-				f << stringf(".latch %s %s fe %s%s\n", str(cell->getPort(ID::D)).c_str(), str(cell->getPort(ID::Q)).c_str(),
-						str(cell->getPort(ID::C)).c_str(), str_init(cell->getPort(ID::Q)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_DFF_P_)) {
-				f << stringf(".latch %s %s re %s%s\n", str(cell->getPort(ID::D)).c_str(), str(cell->getPort(ID::Q)).c_str(),
-						str(cell->getPort(ID::C)).c_str(), str_init(cell->getPort(ID::Q)).c_str());
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == ID($_DLATCH_N_)) {
-				f << stringf(".latch %s %s al %s%s\n", str(cell->getPort(ID::D)).c_str(), str(cell->getPort(ID::Q)).c_str(),
-						str(cell->getPort(ID::E)).c_str(), str_init(cell->getPort(ID::Q)).c_str());
+			const char *ports, *cover;
+			if (!config->icells_mode && gate_table(cell->type, ports, cover)) {
+				out += ".names";
+				for (const char *p = ports; *p; p++) {
+					out += ' ';
+					put_bit(cell->getPort(port_letter(*p)));
+				}
+				out += '\n';
+				out += cover;
 				goto internal_cell;
 			}
 
-			if (!config->icells_mode && cell->type == ID($_DLATCH_P_)) {
-				f << stringf(".latch %s %s ah %s%s\n", str(cell->getPort(ID::D)).c_str(), str(cell->getPort(ID::Q)).c_str(),
-						str(cell->getPort(ID::E)).c_str(), str_init(cell->getPort(ID::Q)).c_str());
+			if (!config->icells_mode && cell->type.in(ID($_FF_), ID($_DFF_N_), ID($_DFF_P_), ID($_DLATCH_N_), ID($_DLATCH_P_))) {
+				out += ".latch ";
+				put_bit(cell->getPort(ID::D));
+				out += ' ';
+				put_bit(cell->getPort(ID::Q));
+				if (cell->type != ID($_FF_)) {
+					bool is_dff = cell->type.in(ID($_DFF_N_), ID($_DFF_P_));
+					if (cell->type == ID($_DFF_N_)) out += " fe ";
+					else if (cell->type == ID($_DFF_P_)) out += " re ";
+					else if (cell->type == ID($_DLATCH_N_)) out += " al ";
+					else out += " ah ";
+					put_bit(cell->getPort(is_dff ? ID::C : ID::E));
+				}
+				put_init(cell->getPort(ID::Q));
+				out += '\n';
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == ID($lut)) {
-				f << stringf(".names");
+				out += ".names";
 				auto &inputs = cell->getPort(ID::A);
 				auto width = cell->parameters.at(ID::WIDTH).as_int();
 				log_assert(inputs.size() == width);
-				for (int i = width-1; i >= 0; i--)
-					f << stringf(" %s", str(inputs.extract(i, 1)).c_str());
+				for (int i = width-1; i >= 0; i--) {
+					out += ' ';
+					put_bit(inputs[i]);
+				}
 				auto &output = cell->getPort(ID::Y);
 				log_assert(output.size() == 1);
-				f << stringf(" %s", str(output).c_str());
-				f << stringf("\n");
+				out += ' ';
+				put_bit(output);
+				out += '\n';
 				RTLIL::SigSpec mask = cell->parameters.at(ID::LUT);
 				for (int i = 0; i < (1 << width); i++)
 					if (mask[i] == State::S1) {
 						for (int j = width-1; j >= 0; j--) {
-							f << ((i>>j)&1 ? '1' : '0');
+							out += ((i>>j)&1 ? '1' : '0');
 						}
-						f << " 1\n";
+						out += " 1\n";
 					}
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == ID($sop)) {
-				f << stringf(".names");
+				out += ".names";
 				auto &inputs = cell->getPort(ID::A);
 				auto width = cell->parameters.at(ID::WIDTH).as_int();
 				auto depth = cell->parameters.at(ID::DEPTH).as_int();
@@ -391,30 +402,39 @@ struct BlifDumper
 				while (GetSize(table) < 2*width*depth)
 					table.push_back(State::S0);
 				log_assert(inputs.size() == width);
-				for (int i = 0; i < width; i++)
-					f << stringf(" %s", str(inputs.extract(i, 1)).c_str());
+				for (int i = 0; i < width; i++) {
+					out += ' ';
+					put_bit(inputs[i]);
+				}
 				auto &output = cell->getPort(ID::Y);
 				log_assert(output.size() == 1);
-				f << stringf(" %s", str(output).c_str());
-				f << stringf("\n");
+				out += ' ';
+				put_bit(output);
+				out += '\n';
 				for (int i = 0; i < depth; i++) {
 					for (int j = 0; j < width; j++) {
 						bool pat0 = table.at(2*width*i + 2*j + 0) == State::S1;
 						bool pat1 = table.at(2*width*i + 2*j + 1) == State::S1;
-						if (pat0 && !pat1) f << "0";
-						else if (!pat0 && pat1) f << "1";
-						else f << "-";
+						if (pat0 && !pat1) out += '0';
+						else if (!pat0 && pat1) out += '1';
+						else out += '-';
 					}
-					f << " 1\n";
+					out += " 1\n";
 				}
 				goto internal_cell;
 			}
 
-			f << stringf(".%s %s", subckt_or_gate(cell->type.str()), str(cell->type).c_str());
+			out += '.';
+			out += subckt_or_gate(cell->type);
+			out += ' ';
+			put_id(cell->type);
 			for (auto &conn : cell->connections())
 			{
 				if (conn.second.size() == 1) {
-					f << stringf(" %s=%s", str(conn.first).c_str(), str(conn.second[0]).c_str());
+					out += ' ';
+					put_id(conn.first);
+					out += '=';
+					put_bit(conn.second[0]);
 					continue;
 				}
 
@@ -422,21 +442,32 @@ struct BlifDumper
 				Wire *w = m ? m->wire(conn.first) : nullptr;
 
 				if (w == nullptr) {
-					for (int i = 0; i < GetSize(conn.second); i++)
-						f << stringf(" %s[%d]=%s", str(conn.first).c_str(), i, str(conn.second[i]).c_str());
+					for (int i = 0; i < GetSize(conn.second); i++) {
+						out += ' ';
+						put_id(conn.first);
+						out += '[';
+						put_int(i);
+						out += "]=";
+						put_bit(conn.second[i]);
+					}
 				} else {
 					for (int i = 0; i < std::min(GetSize(conn.second), GetSize(w)); i++) {
-						SigBit sig(w, i);
-						f << stringf(" %s[%d]=%s", str(conn.first).c_str(), sig.wire->upto ?
-								sig.wire->start_offset+sig.wire->width-sig.offset-1 :
-								sig.wire->start_offset+sig.offset, str(conn.second[i]).c_str());
+						out += ' ';
+						put_id(conn.first);
+						out += '[';
+						put_int(w->upto ? w->start_offset+w->width-i-1 : w->start_offset+i);
+						out += "]=";
+						put_bit(conn.second[i]);
 					}
 				}
 			}
-			f << stringf("\n");
+			out += '\n';
 
-			if (config->cname_mode)
-				f << stringf(".cname %s\n", str(cell->name).c_str());
+			if (config->cname_mode) {
+				out += ".cname ";
+				put_id(cell->name);
+				out += '\n';
+			}
 			if (config->attr_mode)
 				dump_params(".attr", cell->attributes);
 			if (config->param_mode)
@@ -444,8 +475,11 @@ struct BlifDumper
 
 			if (0) {
 		internal_cell:
-				if (config->iname_mode)
-					f << stringf(".cname %s\n", str(cell->name).c_str());
+				if (config->iname_mode) {
+					out += ".cname ";
+					put_id(cell->name);
+					out += '\n';
+				}
 				if (config->iattr_mode)
 					dump_params(".attr", cell->attributes);
 			}
@@ -454,28 +488,52 @@ struct BlifDumper
 		for (auto &conn : module->connections())
 		for (int i = 0; i < conn.first.size(); i++)
 		{
+			if (out.size() >= buffer_size)
+				flush();
+
 			SigBit lhs_bit = conn.first[i];
 			SigBit rhs_bit = conn.second[i];
 
 			if (config->noalias_mode && cstr_bits_seen.count(lhs_bit) == 0)
 				continue;
 
-			if (config->conn_mode)
-				f << stringf(".conn %s %s\n", str(rhs_bit).c_str(), str(lhs_bit).c_str());
-			else if (!config->buf_type.empty())
-				f << stringf(".%s %s %s=%s %s=%s\n", subckt_or_gate(config->buf_type), config->buf_type.c_str(),
-						config->buf_in.c_str(), str(rhs_bit).c_str(), config->buf_out.c_str(), str(lhs_bit).c_str());
-			else
-				f << stringf(".names %s %s\n1 1\n", str(rhs_bit).c_str(), str(lhs_bit).c_str());
+			if (config->conn_mode) {
+				out += ".conn ";
+				put_bit(rhs_bit);
+				out += ' ';
+				put_bit(lhs_bit);
+				out += '\n';
+			} else if (!config->buf_type.empty()) {
+				out += '.';
+				out += subckt_or_gate(config->buf_type);
+				out += ' ';
+				out += config->buf_type;
+				out += ' ';
+				out += config->buf_in;
+				out += '=';
+				put_bit(rhs_bit);
+				out += ' ';
+				out += config->buf_out;
+				out += '=';
+				put_bit(lhs_bit);
+				out += '\n';
+			} else {
+				out += ".names ";
+				put_bit(rhs_bit);
+				out += ' ';
+				put_bit(lhs_bit);
+				out += "\n1 1\n";
+			}
 		}
 
-		f << stringf(".end\n");
+		out += ".end\n";
 	}
 
 	static void dump(std::ostream &f, RTLIL::Module *module, RTLIL::Design *design, BlifDumperConfig &config)
 	{
 		BlifDumper dumper(f, module, design, &config);
 		dumper.dump();
+		dumper.flush();
 	}
 };
 
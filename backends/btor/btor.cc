@@ -44,6 +44,7 @@ struct BtorWorker
 	bool single_bad;
 	bool cover_mode;
 	bool print_internal_names;
+	bool dedup_mode;
 
 	int next_nid = 1;
 	int initstate_nid = -1;
@@ -98,6 +99,11 @@ struct BtorWorker
 	dict<SigBit, int> ywmap_clock_bits;
 	dict<SigBit, int> ywmap_clock_inputs;
 
+	// -dedup: <nid> of a dropped node => <nid> of the identical earlier node
+	dict<int, int> dedup_alias;
+
+	// -dedup: node text without the leading <nid> => <nid>
+	dict<string, int> dedup_nodes;
 
 	PrettyJson ywmap_json;
 
@@ -105,8 +111,100 @@ struct BtorWorker
 	{
 		va_list ap;
 		va_start(ap, fmt);
-		f << indent << vstringf(fmt, ap);
+		string line = vstringf(fmt, ap);
 		va_end(ap);
+		if (!dedup_mode || dedup_line(line))
+			f << indent << line;
+	}
+
+	int dedup_nid(int nid)
+	{
+		auto it = dedup_alias.find(nid);
+		return it == dedup_alias.end() ? nid : it->second;
+	}
+
+	// Hash-consing on the output side: node references are rewritten to the
+	// nodes that were kept, and an unnamed expression node that repeats an
+	// earlier one is dropped in favour of it. Returns false for a dropped line.
+	bool dedup_line(string &line)
+	{
+		if (line.empty() || line[0] == ';')
+			return true;
+
+		vector<string> tokens;
+		size_t pos = 0;
+		auto next_token = [&]() {
+			size_t start = line.find_first_not_of(' ', pos);
+			if (start == string::npos || line[start] == '\n')
+				return false;
+			pos = line.find_first_of(" \n", start);
+			tokens.push_back(line.substr(start, pos - start));
+			return true;
+		};
+
+		if (!next_token() || !next_token())
+			return true;
+
+		// layout after the <nid> and the operator: the <sid> (if any), the
+		// referenced nodes, then literal arguments, then an optional symbol
+		const string &op = tokens[1];
+		auto op_in = [&](std::initializer_list<const char*> ops) {
+			for (auto o : ops)
+				if (op == o)
+					return true;
+			return false;
+		};
+		bool has_sid = true, is_expr = true;
+		int refs = 2, literals = 0;
+		if (op == "sort" || op == "input" || op == "state")
+			return true;
+		if (op == "init" || op == "next")
+			is_expr = false;
+		else if (op_in({"bad", "constraint", "fair", "output"}))
+			has_sid = false, refs = 1, is_expr = false;
+		else if (op_in({"const", "constd", "consth"}))
+			refs = 0, literals = 1;
+		else if (op_in({"not", "inc", "dec", "neg", "redand", "redor", "redxor"}))
+			refs = 1;
+		else if (op == "slice")
+			refs = 1, literals = 2;
+		else if (op_in({"uext", "sext"}))
+			refs = 1, literals = 1;
+		else if (op_in({"ite", "write"}))
+			refs = 3;
+
+		int num_tokens = 2 + (has_sid ? 1 : 0) + refs + literals;
+		while (GetSize(tokens) < num_tokens)
+			if (!next_token())
+				return true;
+
+		int first_ref = has_sid ? 3 : 2;
+		for (int i = first_ref; i < first_ref + refs; i++) {
+			int ref = atoi(tokens[i].c_str());
+			int node = dedup_nid(std::abs(ref));
+			tokens[i] = std::to_string(ref < 0 ? -node : node);
+		}
+
+		string key;
+		for (int i = 1; i < num_tokens; i++)
+			key += (i > 1 ? " " : "") + tokens[i];
+		string tail = line.substr(pos);
+		bool named = tail.find_first_not_of(" \n") != string::npos;
+
+		if (is_expr) {
+			int nid = atoi(tokens[0].c_str());
+			auto it = dedup_nodes.find(key);
+			if (it != dedup_nodes.end()) {
+				if (!named) {
+					dedup_alias[nid] = it->second;
+					return false;
+				}
+			} else
+				dedup_nodes[key] = nid;
+		}
+
+		line = tokens[0] + " " + key + tail;
+		return true;
 	}
 
 	void infof(const char *fmt, ...) YS_ATTRIBUTE(format(printf, 2, 3))
@@ -1162,8 +1260,8 @@ struct BtorWorker
 		return nid;
 	}
 
-	BtorWorker(std::ostream &f, RTLIL::Module *module, bool verbose, bool single_bad, bool cover_mode, bool print_internal_names, string info_filename, string ywmap_filename) :
-			f(f), sigmap(module), module(module), verbose(verbose), single_bad(single_bad), cover_mode(cover_mode), print_internal_names(print_internal_names), info_filename(info_filename)
+	BtorWorker(std::ostream &f, RTLIL::Module *module, bool verbose, bool single_bad, bool cover_mode, bool print_internal_names, bool dedup_mode, string info_filename, string ywmap_filename) :
+			f(f), sigmap(module), module(module), verbose(verbose), single_bad(single_bad), cover_mode(cover_mode), print_internal_names(print_internal_names), dedup_mode(dedup_mode), info_filename(info_filename)
 	{
 		if (!info_filename.empty())
 			infof("name %s\n", log_id(module));
@@ -1301,7 +1399,7 @@ struct BtorWorker
 					bad_properties.push_back(nid_en_and_not_a);
 				} else {
 					if (cover_mode) {
-						infof("bad %d%s\n", nid_en_and_not_a, getinfo(cell, true).c_str());
+						infof("bad %d%s\n", dedup_nid(nid_en_and_not_a), getinfo(cell, true).c_str());
 					} else {
 						int nid = next_nid++;
 						btorf("%d bad %d%s\n", nid, nid_en_and_not_a, getinfo(cell, true).c_str());
@@ -1472,13 +1570,13 @@ struct BtorWorker
 				switch (it.second)
 				{
 				case 1:
-					infof("posedge %d\n", it.first);
+					infof("posedge %d\n", dedup_nid(it.first));
 					break;
 				case 2:
-					infof("negedge %d\n", it.first);
+					infof("negedge %d\n", dedup_nid(it.first));
 					break;
 				case 3:
-					infof("event %d\n", it.first);
+					infof("event %d\n", dedup_nid(it.first));
 					break;
 				default:
 					log_abort();
@@ -1560,10 +1658,14 @@ struct BtorBackend : public Backend {
 		log("  -ywmap <filename>\n");
 		log("    Create a map file for conversion to and from Yosys witness traces\n");
 		log("\n");
+		log("  -dedup\n");
+		log("    Merge structurally identical nodes, e.g. repeated slices and concats of\n");
+		log("    the same signal. Nodes with symbols are kept.\n");
+		log("\n");
 	}
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
-		bool verbose = false, single_bad = false, cover_mode = false, print_internal_names = false;
+		bool verbose = false, single_bad = false, cover_mode = false, print_internal_names = false, dedup_mode = false;
 		string info_filename;
 		string ywmap_filename;
 
@@ -1602,6 +1704,10 @@ struct BtorBackend : public Backend {
 				ywmap_filename = args[++argidx];
 				continue;
 			}
+			if (args[argidx] == "-dedup") {
+				dedup_mode = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
@@ -1614,7 +1720,7 @@ struct BtorBackend : public Backend {
 		*f << stringf("; BTOR description generated by %s for module %s.\n",
 				yosys_version_str, log_id(topmod));
 
-		BtorWorker(*f, topmod, verbose, single_bad, cover_mode, print_internal_names, info_filename, ywmap_filename);
+		BtorWorker(*f, topmod, verbose, single_bad, cover_mode, print_internal_names, dedup_mode, info_filename, ywmap_filename);
 
 		*f << stringf("; end of yosys output\n");
 	}
@@ -23,6 +23,8 @@
 #include "kernel/utils.h"
 #include "kernel/celltypes.h"
 #include "kernel/mem.h"
+#include "kernel/ff.h"
+#include "kernel/ffinit.h"
 #include "kernel/log.h"
 #include "kernel/fmt.h"
 #include "kernel/scopeinfo.h"
@@ -712,6 +714,13 @@ bool is_valid_clock(const RTLIL::SigSpec& sig) {
 	return sig.is_chunk() && sig.is_bit() && sig[0].wire;
 }
 
+// A part of the eval() schedule of a module that is skipped unless something it reads has changed.
+struct ActivityRegion {
+	std::vector<FlowGraph::Node> nodes;
+	pool<RTLIL::SigBit> edges;
+	bool always = false;
+};
+
 struct CxxrtlWorker {
 	bool split_intf = false;
 	std::string intf_filename;
@@ -719,6 +728,11 @@ struct CxxrtlWorker {
 	std::string print_output = "std::cout";
 	std::ostream *impl_f = nullptr;
 	std::ostream *intf_f = nullptr;
+	// with more than one unit, the method definitions are distributed over
+	// impl_f and the streams in unit_f (see dump_design())
+	int impl_units = 1;
+	std::vector<std::ostream*> unit_f;
+	std::vector<std::string> *impl_chunks = nullptr;
 
 	bool print_wire_types = false;
 	bool print_debug_wire_types = false;
@@ -738,6 +752,12 @@ struct CxxrtlWorker {
 	bool debug_alias = false;
 	bool debug_eval = false;
 
+	int eval_partitions = 1;
+	int lanes = 0;
+	int activity_regions = 0;
+	bool profile = false;
+	bool state_arena = false;
+
 	std::ostringstream f;
 	std::string indent;
 	int temporary = 0;
@@ -752,7 +772,17 @@ struct CxxrtlWorker {
 	dict<const RTLIL::Wire*, WireType> wire_types, debug_wire_types;
 	dict<RTLIL::SigBit, bool> bit_has_state;
 	dict<const RTLIL::Module*, pool<std::string>> blackbox_specializations;
+	// the size of each kind of allocation in the state arena of the module being dumped, and how
+	// many times it is made
+	std::map<std::string, int> arena_allocations;
 	dict<const RTLIL::Module*, bool> eval_converges;
+	dict<const RTLIL::Module*, std::vector<std::vector<FlowGraph::Node>>> partitioned_schedule;
+	dict<const RTLIL::Module*, bool> module_effects;
+	dict<const RTLIL::Module*, std::vector<ActivityRegion>> activity_schedule_regions;
+	dict<const RTLIL::Wire*, pool<int>> activity_wire_regions;
+	dict<std::pair<const RTLIL::Module*, RTLIL::IdString>, pool<int>> activity_memory_regions;
+	// the input ports of the module being dumped with -lanes that clock flip-flops
+	pool<const RTLIL::Wire*> lanes_clock_wires;
 
 	void inc_indent() {
 		indent += "\t";
@@ -2024,6 +2054,18 @@ struct CxxrtlWorker {
 		}
 	}
 
+	// Dumps the declaration of a member that is a part of the state of the design; with -arena, it refers
+	// to an object in the state arena.
+	void dump_state_member(const std::string &type, const std::string &name)
+	{
+		if (state_arena) {
+			f << type << " &" << name << " = *arena.allocate<" << type << ">();\n";
+			arena_allocations["state_arena::size_of<" + type + ">()"]++;
+		} else {
+			f << type << " " << name << ";\n";
+		}
+	}
+
 	void dump_wire(const RTLIL::Wire *wire, bool is_local)
 	{
 		const auto &wire_type = wire_types[wire];
@@ -2038,16 +2080,23 @@ struct CxxrtlWorker {
 			f << "/*input*/ ";
 		else if (wire->port_output)
 			f << "/*output*/ ";
-		f << (wire_type.is_buffered() ? "wire" : "value");
+		std::string type = wire_type.is_buffered() ? "wire" : "value";
 		if (wire->module->has_attribute(ID(cxxrtl_blackbox)) && wire->has_attribute(ID(cxxrtl_width))) {
-			f << "<" << wire->get_string_attribute(ID(cxxrtl_width)) << ">";
+			type += "<" + wire->get_string_attribute(ID(cxxrtl_width)) + ">";
 		} else {
-			f << "<" << wire->width << ">";
+			type += "<" + std::to_string(wire->width) + ">";
 		}
-		f << " " << mangle(wire) << ";\n";
+		if (!is_local && !wire->module->has_attribute(ID(cxxrtl_blackbox)))
+			dump_state_member(type, mangle(wire));
+		else
+			f << type << " " << mangle(wire) << ";\n";
 		if (edge_wires[wire]) {
 			if (!wire_type.is_buffered()) {
-				f << indent << "value<" << wire->width << "> prev_" << mangle(wire) << ";\n";
+				f << indent;
+				if (!is_local && !wire->module->has_attribute(ID(cxxrtl_blackbox)))
+					dump_state_member("value<" + std::to_string(wire->width) + ">", "prev_" + mangle(wire));
+				else
+					f << "value<" << wire->width << "> prev_" << mangle(wire) << ";\n";
 			}
 			for (auto edge_type : edge_types) {
 				if (edge_type.first.wire == wire) {
@@ -2099,6 +2148,7 @@ struct CxxrtlWorker {
 
 	void dump_reset_method(RTLIL::Module *module)
 	{
+		const int MEM_INIT_FILL_THRESHOLD = 16;
 		int mem_init_idx = 0;
 		inc_indent();
 			for (auto wire : module->wires()) {
@@ -2127,23 +2177,52 @@ struct CxxrtlWorker {
 						continue;
 					dump_attrs(&init);
 					int words = GetSize(init.data) / mem.width;
-					f << indent << "static const value<" << mem.width << "> ";
-					f << "mem_init_" << ++mem_init_idx << "[" << words << "] {";
-					inc_indent();
-						for (int n = 0; n < words; n++) {
-							if (n % 4 == 0)
-								f << "\n" << indent;
-							else
-								f << " ";
-							dump_const(init.data, mem.width, n * mem.width, /*fixed_width=*/true);
-							f << ",";
+					// Long runs of the same word (e.g. the zeroes that make up most of a typical ROM image) are
+					// filled in rather than spelled out, which keeps the generated code small.
+					int lit_start = 0;
+					for (int n = 0; n <= words; ) {
+						int run = 0;
+						if (n < words) {
+							Const word = init.data.extract(n * mem.width, mem.width);
+							for (run = 1; n + run < words && run < MEM_INIT_FILL_THRESHOLD; run++)
+								if (init.data.extract((n + run) * mem.width, mem.width) != word)
+									break;
+							if (run == MEM_INIT_FILL_THRESHOLD)
+								while (n + run < words && init.data.extract((n + run) * mem.width, mem.width) == word)
+									run++;
 						}
-					dec_indent();
-					f << "\n";
-					f << indent << "};\n";
-					f << indent << "std::copy(std::begin(mem_init_" << mem_init_idx << "), ";
-					f << "std::end(mem_init_" << mem_init_idx << "), ";
-					f << "&" << mangle(&mem) << ".data[" << stringf("%#x", init.addr.as_int()) << "]);\n";
+						if (n < words && run < MEM_INIT_FILL_THRESHOLD) {
+							n += run;
+							continue;
+						}
+						if (lit_start < n) {
+							f << indent << "static const value<" << mem.width << "> ";
+							f << "mem_init_" << ++mem_init_idx << "[" << n - lit_start << "] {";
+							inc_indent();
+								for (int k = lit_start; k < n; k++) {
+									if ((k - lit_start) % 4 == 0)
+										f << "\n" << indent;
+									else
+										f << " ";
+									dump_const(init.data, mem.width, k * mem.width, /*fixed_width=*/true);
+									f << ",";
+								}
+							dec_indent();
+							f << "\n";
+							f << indent << "};\n";
+							f << indent << "std::copy(std::begin(mem_init_" << mem_init_idx << "), ";
+							f << "std::end(mem_init_" << mem_init_idx << "), ";
+							f << "&" << mangle(&mem) << ".data[" << stringf("%#x", init.addr.as_int() + lit_start) << "]);\n";
+						}
+						if (n == words)
+							break;
+						f << indent << "std::fill(&" << mangle(&mem) << ".data[" << stringf("%#x", init.addr.as_int() + n) << "], ";
+						f << "&" << mangle(&mem) << ".data[" << stringf("%#x", init.addr.as_int() + n + run) << "], ";
+						dump_const(init.data, mem.width, n * mem.width, /*fixed_width=*/true);
+						f << ");\n";
+						n += run;
+						lit_start = n;
+					}
 				}
 			}
 			for (auto cell : module->cells()) {
@@ -2161,14 +2240,74 @@ struct CxxrtlWorker {
 					f << ".reset();\n";
 				}
 			}
+			if (activity_schedule_regions.count(module))
+				f << indent << "std::fill(std::begin(region_dirty), std::end(region_dirty), true);\n";
 		dec_indent();
 	}
 
+	void dump_eval_node(FlowGraph::Node &node)
+	{
+		switch (node.type) {
+			case FlowGraph::Node::Type::CONNECT:
+				dump_connect(node.connect);
+				break;
+			case FlowGraph::Node::Type::CELL_SYNC:
+				dump_cell_sync(node.cell);
+				break;
+			case FlowGraph::Node::Type::CELL_EVAL:
+				dump_cell_eval(node.cell);
+				break;
+			case FlowGraph::Node::Type::EFFECT_SYNC:
+				dump_cell_effect_sync(node.cells);
+				break;
+			case FlowGraph::Node::Type::PROCESS_CASE:
+				if (profile) {
+					f << indent << "{\n";
+					inc_indent();
+						f << indent << "profile_scope profile_process_scope(profile_case_" << mangle_name(node.process->name) << ");\n";
+						dump_process_case(node.process);
+					dec_indent();
+					f << indent << "}\n";
+				} else {
+					dump_process_case(node.process);
+				}
+				break;
+			case FlowGraph::Node::Type::PROCESS_SYNC:
+				if (profile) {
+					f << indent << "{\n";
+					inc_indent();
+						f << indent << "profile_scope profile_process_scope(profile_syncs_" << mangle_name(node.process->name) << ");\n";
+						dump_process_syncs(node.process);
+					dec_indent();
+					f << indent << "}\n";
+				} else {
+					dump_process_syncs(node.process);
+				}
+				break;
+			case FlowGraph::Node::Type::MEM_RDPORT:
+				dump_mem_rdport(node.mem, node.portidx);
+				break;
+			case FlowGraph::Node::Type::MEM_WRPORTS:
+				dump_mem_wrports(node.mem);
+				break;
+		}
+	}
+
+	void dump_mark_regions(const pool<int> &regions)
+	{
+		std::vector<int> sorted_regions(regions.begin(), regions.end());
+		std::sort(sorted_regions.begin(), sorted_regions.end());
+		for (int index : sorted_regions)
+			f << indent << "region_dirty[" << index << "] = true;\n";
+	}
+
 	void dump_eval_method(RTLIL::Module *module)
 	{
 		inc_indent();
 			f << indent << "bool converged = " << (eval_converges.at(module) ? "true" : "false") << ";\n";
 			if (!module->get_bool_attribute(ID(cxxrtl_blackbox))) {
+				if (profile)
+					f << indent << "profile_scope profile_eval_scope(profile_eval);\n";
 				for (auto wire : module->wires()) {
 					if (edge_wires[wire]) {
 						for (auto edge_type : edge_types) {
@@ -2187,33 +2326,76 @@ struct CxxrtlWorker {
 				}
 				for (auto wire : module->wires())
 					dump_wire(wire, /*is_local=*/true);
-				for (auto node : schedule[module]) {
-					switch (node.type) {
-						case FlowGraph::Node::Type::CONNECT:
-							dump_connect(node.connect);
-							break;
-						case FlowGraph::Node::Type::CELL_SYNC:
-							dump_cell_sync(node.cell);
-							break;
-						case FlowGraph::Node::Type::CELL_EVAL:
-							dump_cell_eval(node.cell);
-							break;
-						case FlowGraph::Node::Type::EFFECT_SYNC:
-							dump_cell_effect_sync(node.cells);
-							break;
-						case FlowGraph::Node::Type::PROCESS_CASE:
-							dump_process_case(node.process);
-							break;
-						case FlowGraph::Node::Type::PROCESS_SYNC:
-							dump_process_syncs(node.process);
-							break;
-						case FlowGraph::Node::Type::MEM_RDPORT:
-							dump_mem_rdport(node.mem, node.portidx);
-							break;
-						case FlowGraph::Node::Type::MEM_WRPORTS:
-							dump_mem_wrports(node.mem);
-							break;
+				if (partitioned_schedule.count(module)) {
+					auto &partitions = partitioned_schedule[module];
+					f << indent << "converged &= partition_pool::global().run(" << partitions.size() << ", ";
+					f << "[&](size_t partition) -> bool {\n";
+					inc_indent();
+						f << indent << "bool converged = true;\n";
+						f << indent << "switch (partition) {\n";
+						for (size_t index = 0; index < partitions.size(); index++) {
+							f << indent << "case " << index << ": {\n";
+							inc_indent();
+								for (auto &node : partitions[index])
+									dump_eval_node(node);
+								f << indent << "break;\n";
+							dec_indent();
+							f << indent << "}\n";
+						}
+						f << indent << "}\n";
+						f << indent << "return converged;\n";
+					dec_indent();
+					f << indent << "});\n";
+				} else if (activity_schedule_regions.count(module)) {
+					auto &regions = activity_schedule_regions[module];
+					for (auto wire : module->wires()) {
+						if (!activity_wire_regions.count(wire) || wire_types[wire].is_buffered())
+							continue;
+						f << indent << "if (last_" << mangle(wire) << " != " << mangle(wire) << ") {\n";
+						inc_indent();
+							f << indent << "last_" << mangle(wire) << " = " << mangle(wire) << ";\n";
+							dump_mark_regions(activity_wire_regions[wire]);
+						dec_indent();
+						f << indent << "}\n";
 					}
+					for (size_t index = 0; index < regions.size(); index++) {
+						auto &region = regions[index];
+						if (region.always && profile) {
+							f << indent << "{\n";
+							inc_indent();
+								f << indent << "profile_scope profile_region_scope(profile_region_" << index << ");\n";
+								for (auto &node : region.nodes)
+									dump_eval_node(node);
+							dec_indent();
+							f << indent << "}\n";
+							continue;
+						} else if (region.always) {
+							for (auto &node : region.nodes)
+								dump_eval_node(node);
+							continue;
+						}
+						f << indent << "if (region_dirty[" << index << "]";
+						for (auto bit : region.edges) {
+							if (!edge_types.count(bit))
+								continue;
+							if (edge_types[bit] != RTLIL::STn)
+								f << " || posedge_" << mangle(bit);
+							if (edge_types[bit] != RTLIL::STp)
+								f << " || negedge_" << mangle(bit);
+						}
+						f << ") {\n";
+						inc_indent();
+							f << indent << "region_dirty[" << index << "] = false;\n";
+							if (profile)
+								f << indent << "profile_scope profile_region_scope(profile_region_" << index << ");\n";
+							for (auto &node : region.nodes)
+								dump_eval_node(node);
+						dec_indent();
+						f << indent << "}\n";
+					}
+				} else {
+					for (auto &node : schedule[module])
+						dump_eval_node(node);
 				}
 			}
 			f << indent << "return converged;\n";
@@ -2258,19 +2440,40 @@ struct CxxrtlWorker {
 	void dump_commit_method(RTLIL::Module *module)
 	{
 		inc_indent();
+			if (profile && !module->get_bool_attribute(ID(cxxrtl_blackbox)))
+				f << indent << "profile_scope profile_commit_scope(profile_commit);\n";
 			f << indent << "bool changed = false;\n";
 			for (auto wire : module->wires()) {
 				const auto &wire_type = wire_types[wire];
 				if (wire_type.type == WireType::MEMBER && edge_wires[wire])
 					f << indent << "prev_" << mangle(wire) << " = " << mangle(wire) << ";\n";
-				if (wire_type.is_buffered())
-					f << indent << "if (" << mangle(wire) << ".commit(observer)) changed = true;\n";
+				if (wire_type.is_buffered()) {
+					if (activity_wire_regions.count(wire)) {
+						f << indent << "if (" << mangle(wire) << ".commit(observer)) {\n";
+						inc_indent();
+							f << indent << "changed = true;\n";
+							dump_mark_regions(activity_wire_regions[wire]);
+						dec_indent();
+						f << indent << "}\n";
+					} else {
+						f << indent << "if (" << mangle(wire) << ".commit(observer)) changed = true;\n";
+					}
+				}
 			}
 			if (!module->get_bool_attribute(ID(cxxrtl_blackbox))) {
 				for (auto &mem : mod_memories[module]) {
 					if (!writable_memories.count({module, mem.memid}))
 						continue;
-					f << indent << "if (" << mangle(&mem) << ".commit(observer)) changed = true;\n";
+					if (activity_memory_regions.count({module, mem.memid})) {
+						f << indent << "if (" << mangle(&mem) << ".commit(observer)) {\n";
+						inc_indent();
+							f << indent << "changed = true;\n";
+							dump_mark_regions(activity_memory_regions[{module, mem.memid}]);
+						dec_indent();
+						f << indent << "}\n";
+					} else {
+						f << indent << "if (" << mangle(&mem) << ".commit(observer)) changed = true;\n";
+					}
 				}
 				for (auto cell : module->cells()) {
 					if (is_internal_cell(cell->type))
@@ -2590,6 +2793,29 @@ struct CxxrtlWorker {
 		}
 	}
 
+	void dump_profile_info_method(RTLIL::Module *module)
+	{
+		inc_indent();
+			f << indent << "items.add(path, \"eval\", profile_eval);\n";
+			f << indent << "items.add(path, \"commit\", profile_commit);\n";
+			for (auto proc : module->processes) {
+				std::string name = "process " + RTLIL::unescape_id(proc.second->name);
+				f << indent << "items.add(path, " << escape_cxx_string(name + " case") << ", ";
+				f << "profile_case_" << mangle_name(proc.second->name) << ");\n";
+				f << indent << "items.add(path, " << escape_cxx_string(name + " syncs") << ", ";
+				f << "profile_syncs_" << mangle_name(proc.second->name) << ");\n";
+			}
+			if (activity_schedule_regions.count(module))
+				for (size_t index = 0; index < activity_schedule_regions[module].size(); index++)
+					f << indent << "items.add(path, \"region " << index << "\", profile_region_" << index << ");\n";
+			for (auto cell : module->cells()) {
+				if (is_internal_cell(cell->type) || is_cxxrtl_blackbox_cell(cell))
+					continue;
+				f << indent << mangle(cell) << ".profile_info(items, path + " << escape_cxx_string(get_hdl_name(cell) + ' ') << ");\n";
+			}
+		dec_indent();
+	}
+
 	void dump_module_intf(RTLIL::Module *module)
 	{
 		dump_attrs(module);
@@ -2656,6 +2882,13 @@ struct CxxrtlWorker {
 		} else {
 			f << indent << "struct " << mangle(module) << " : public module {\n";
 			inc_indent();
+				arena_allocations.clear();
+				if (state_arena) {
+					// The arena must be initialized before any of the members allocated in it.
+					f << indent << "std::unique_ptr<state_arena> owned_arena;\n";
+					f << indent << "state_arena &arena;\n";
+					f << "\n";
+				}
 				for (auto wire : module->wires())
 					dump_wire(wire, /*is_local=*/false);
 				for (auto wire : module->wires())
@@ -2663,22 +2896,59 @@ struct CxxrtlWorker {
 				bool has_memories = false;
 				for (auto &mem : mod_memories[module]) {
 					dump_attrs(&mem);
-					f << indent << "memory<" << mem.width << "> " << mangle(&mem)
-					            << " { " << mem.size << "u };\n";
+					f << indent << "memory<" << mem.width << "> " << mangle(&mem) << " { " << mem.size << "u";
+					if (state_arena) {
+						f << ", arena.allocate<value<" << mem.width << ">>(" << mem.size << "u)";
+						arena_allocations[stringf("state_arena::size_of<value<%d>>(%du)", mem.width, mem.size)]++;
+					}
+					f << " };\n";
 					has_memories = true;
 				}
 				if (has_memories)
 					f << "\n";
+				if (activity_schedule_regions.count(module)) {
+					for (auto wire : module->wires())
+						if (activity_wire_regions.count(wire) && !wire_types[wire].is_buffered()) {
+							f << indent;
+							dump_state_member("value<" + std::to_string(wire->width) + ">", "last_" + mangle(wire));
+						}
+					size_t regions = activity_schedule_regions[module].size();
+					if (state_arena) {
+						f << indent << "bool (&region_dirty)[" << regions << "] = arena.allocate_array<bool, " << regions << ">();\n";
+						arena_allocations[stringf("state_arena::size_of<bool>(%zu)", regions)]++;
+					} else {
+						f << indent << "bool region_dirty[" << regions << "];\n";
+					}
+					f << "\n";
+				}
+				if (profile) {
+					f << indent << "profile_counter profile_eval;\n";
+					f << indent << "profile_counter profile_commit;\n";
+					for (auto proc : module->processes) {
+						f << indent << "profile_counter profile_case_" << mangle_name(proc.second->name) << ";\n";
+						f << indent << "profile_counter profile_syncs_" << mangle_name(proc.second->name) << ";\n";
+					}
+					if (activity_schedule_regions.count(module))
+						for (size_t index = 0; index < activity_schedule_regions[module].size(); index++)
+							f << indent << "profile_counter profile_region_" << index << ";\n";
+					f << "\n";
+				}
 				bool has_cells = false;
 				for (auto cell : module->cells()) {
 					// Async and initial effectful cells have additional state, which requires storage.
 					if (is_effectful_cell(cell->type)) {
-						if (cell->getParam(ID::TRG_ENABLE).as_bool() && cell->getParam(ID::TRG_WIDTH).as_int() == 0)
-							f << indent << "value<1> " << mangle(cell) << ";\n"; // async initial cell
-						if (!cell->getParam(ID::TRG_ENABLE).as_bool() && cell->type == ID($print))
-							f << indent << "value<" << (1 + cell->getParam(ID::ARGS_WIDTH).as_int()) << "> " << mangle(cell) << ";\n"; // {EN, ARGS}
-						if (!cell->getParam(ID::TRG_ENABLE).as_bool() && cell->type == ID($check))
-							f << indent << "value<2> " << mangle(cell) << ";\n"; // {EN, A}
+						if (cell->getParam(ID::TRG_ENABLE).as_bool() && cell->getParam(ID::TRG_WIDTH).as_int() == 0) {
+							f << indent;
+							dump_state_member("value<1>", mangle(cell)); // async initial cell
+						}
+						if (!cell->getParam(ID::TRG_ENABLE).as_bool() && cell->type == ID($print)) {
+							f << indent;
+							dump_state_member(stringf("value<%d>", 1 + cell->getParam(ID::ARGS_WIDTH).as_int()), mangle(cell)); // {EN, ARGS}
+						}
+						if (!cell->getParam(ID::TRG_ENABLE).as_bool() && cell->type == ID($check)) {
+							f << indent;
+							dump_state_member("value<2>", mangle(cell)); // {EN, A}
+						}
 					}
 					if (is_internal_cell(cell->type))
 						continue;
@@ -2693,6 +2963,9 @@ struct CxxrtlWorker {
 						f << ", ";
 						dump_metadata_map(cell->attributes);
 						f << ");\n";
+					} else if (state_arena) {
+						f << indent << mangle(cell_module) << " " << mangle(cell) << " {interior(), arena};\n";
+						arena_allocations[mangle(cell_module) + "::arena_size()"]++;
 					} else {
 						f << indent << mangle(cell_module) << " " << mangle(cell) << " {interior()};\n";
 					}
@@ -2700,13 +2973,42 @@ struct CxxrtlWorker {
 				}
 				if (has_cells)
 					f << "\n";
-				f << indent << mangle(module) << "(interior) {}\n";
-				f << indent << mangle(module) << "() {\n";
+				if (state_arena) {
+					f << indent << "static constexpr size_t arena_size() {\n";
+					inc_indent();
+						f << indent << "return";
+						if (arena_allocations.empty())
+							f << " 0";
+						bool first = true;
+						for (auto &it : arena_allocations) {
+							if (!first)
+								f << " +";
+							f << "\n" << indent << indent << it.first;
+							if (it.second > 1)
+								f << " * " << it.second;
+							first = false;
+						}
+						f << ";\n";
+					dec_indent();
+					f << indent << "}\n";
+					f << "\n";
+					f << indent << mangle(module) << "(interior, state_arena &arena) : arena(arena) {}\n";
+					f << indent << mangle(module) << "() : owned_arena(new state_arena(arena_size())), arena(*owned_arena) {\n";
+				} else {
+					f << indent << mangle(module) << "(interior) {}\n";
+					f << indent << mangle(module) << "() {\n";
+				}
 				inc_indent();
 					f << indent << "reset();\n";
 				dec_indent();
 				f << indent << "};\n";
 				f << "\n";
+				if (state_arena) {
+					f << indent << "state_arena *state() override {\n";
+					f << indent << indent << "return &arena;\n";
+					f << indent << "}\n";
+					f << "\n";
+				}
 				f << indent << "void reset() override;\n";
 				f << "\n";
 				f << indent << "bool eval(performer *performer = nullptr) override;\n";
@@ -2720,6 +3022,10 @@ struct CxxrtlWorker {
 				f << indent << indent << "observer observer;\n";
 				f << indent << indent << "return commit<>(observer);\n";
 				f << indent << "}\n";
+				if (profile) {
+					f << "\n";
+					f << indent << "void profile_info(profile_items &items, std::string path = \"\");\n";
+				}
 				if (debug_info) {
 					if (debug_eval) {
 						f << "\n";
@@ -2741,6 +3047,16 @@ struct CxxrtlWorker {
 		}
 	}
 
+	// Ends the definition of a method, which is kept apart in impl_chunks if set.
+	void end_impl_chunk()
+	{
+		f << "\n";
+		if (impl_chunks) {
+			impl_chunks->push_back(f.str());
+			f.str("");
+		}
+	}
+
 	void dump_module_impl(RTLIL::Module *module)
 	{
 		if (module->get_bool_attribute(ID(cxxrtl_blackbox)))
@@ -2748,25 +3064,56 @@ struct CxxrtlWorker {
 		f << indent << "void " << mangle(module) << "::reset() {\n";
 		dump_reset_method(module);
 		f << indent << "}\n";
-		f << "\n";
+		end_impl_chunk();
 		f << indent << "bool " << mangle(module) << "::eval(performer *performer) {\n";
 		dump_eval_method(module);
 		f << indent << "}\n";
+		end_impl_chunk();
+		if (profile) {
+			f << indent << "CXXRTL_EXTREMELY_COLD\n";
+			f << indent << "void " << mangle(module) << "::profile_info(profile_items &items, std::string path) {\n";
+			dump_profile_info_method(module);
+			f << indent << "}\n";
+			end_impl_chunk();
+		}
 		if (debug_info) {
 			if (debug_eval) {
-				f << "\n";
 				f << indent << "void " << mangle(module) << "::debug_eval() {\n";
 				dump_debug_eval_method(module);
 				f << indent << "}\n";
+				end_impl_chunk();
 			}
-			f << "\n";
 			f << indent << "CXXRTL_EXTREMELY_COLD\n";
 			f << indent << "void " << mangle(module) << "::debug_info(debug_items *items, debug_scopes *scopes, "
 			            << "std::string path, metadata_map &&cell_attrs) {\n";
 			dump_debug_info_method(module);
 			f << indent << "}\n";
+			end_impl_chunk();
 		}
-		f << "\n";
+	}
+
+	// Distributes the method definitions in `chunks` over the units, the
+	// largest first, each to the unit with the least code so far. Within a
+	// unit the definitions stay in their original order.
+	std::vector<std::vector<int>> distribute_chunks(const std::vector<std::string> &chunks)
+	{
+		std::vector<int> order;
+		for (int i = 0; i < GetSize(chunks); i++)
+			order.push_back(i);
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+			return chunks[a].size() > chunks[b].size();
+		});
+
+		std::vector<std::vector<int>> units(impl_units);
+		std::vector<size_t> unit_sizes(impl_units);
+		for (int chunk : order) {
+			int unit = std::min_element(unit_sizes.begin(), unit_sizes.end()) - unit_sizes.begin();
+			units[unit].push_back(chunk);
+			unit_sizes[unit] += chunks[chunk].size();
+		}
+		for (auto &unit : units)
+			std::sort(unit.begin(), unit.end());
+		return units;
 	}
 
 	void dump_design(RTLIL::Design *design)
@@ -2825,6 +3172,8 @@ struct CxxrtlWorker {
 			f << "#ifdef __cplusplus\n";
 			f << "\n";
 			f << "#include <cxxrtl/cxxrtl.h>\n";
+			if (profile)
+				f << "#include <cxxrtl/cxxrtl_profile.h>\n";
 			f << "\n";
 			f << "using namespace cxxrtl;\n";
 			f << "\n";
@@ -2844,6 +3193,10 @@ struct CxxrtlWorker {
 			f << "#include \"" << basename(intf_filename) << "\"\n";
 		else
 			f << "#include <cxxrtl/cxxrtl.h>\n";
+		if (profile && !split_intf)
+			f << "#include <cxxrtl/cxxrtl_profile.h>\n";
+		if (!partitioned_schedule.empty())
+			f << "#include <cxxrtl/cxxrtl_parallel.h>\n";
 		f << "\n";
 		f << "#if defined(CXXRTL_INCLUDE_CAPI_IMPL) || \\\n";
 		f << "    defined(CXXRTL_INCLUDE_VCD_CAPI_IMPL)\n";
@@ -2858,10 +3211,39 @@ struct CxxrtlWorker {
 		f << "\n";
 		f << "namespace " << design_ns << " {\n";
 		f << "\n";
-		for (auto module : modules) {
-			if (!split_intf)
-				dump_module_intf(module);
-			dump_module_impl(module);
+		if (impl_units > 1) {
+			log_assert(split_intf);
+			std::string preamble = f.str(); f.str("");
+			std::vector<std::string> chunks;
+			impl_chunks = &chunks;
+			for (auto module : modules)
+				dump_module_impl(module);
+			impl_chunks = nullptr;
+
+			auto units = distribute_chunks(chunks);
+			for (int unit = 1; unit < impl_units; unit++) {
+				std::ostream &unit_out = *unit_f[unit - 1];
+				unit_out << "#include \"" << basename(intf_filename) << "\"\n";
+				if (!partitioned_schedule.empty())
+					unit_out << "#include <cxxrtl/cxxrtl_parallel.h>\n";
+				unit_out << "\n";
+				unit_out << "using namespace cxxrtl_yosys;\n";
+				unit_out << "\n";
+				unit_out << "namespace " << design_ns << " {\n";
+				unit_out << "\n";
+				for (int chunk : units[unit])
+					unit_out << chunks[chunk];
+				unit_out << "} // namespace " << design_ns << "\n";
+			}
+			f << preamble;
+			for (int chunk : units[0])
+				f << chunks[chunk];
+		} else {
+			for (auto module : modules) {
+				if (!split_intf)
+					dump_module_intf(module);
+				dump_module_impl(module);
+			}
 		}
 		f << "} // namespace " << design_ns << "\n";
 		f << "\n";
@@ -2905,6 +3287,292 @@ struct CxxrtlWorker {
 		edge_wires.insert(sigbit.wire);
 	}
 
+	bool module_may_have_effects(RTLIL::Module *module)
+	{
+		if (module_effects.count(module))
+			return module_effects[module];
+
+		// The code of black boxes is unknown, so it may use the performer or share state between instances.
+		bool effects = module->get_bool_attribute(ID(cxxrtl_blackbox));
+		for (auto cell : module->cells()) {
+			if (effects)
+				break;
+			if (is_effectful_cell(cell->type))
+				effects = true;
+			else if (!is_internal_cell(cell->type)) {
+				RTLIL::Module *cell_module = module->design->module(cell->type);
+				effects = cell_module == nullptr || module_may_have_effects(cell_module);
+			}
+		}
+		return module_effects[module] = effects;
+	}
+
+	// Groups the nodes of a module such that no group writes state read or written by another group. Nodes are kept
+	// together when they share a wire with a comb def, a memory, a cell, or a process; flip-flops only write `.next`,
+	// and so do not need to be kept together with the readers of `.curr`. All nodes that may use the performer are
+	// kept together as well, which preserves the order of their effects.
+	void group_nodes(RTLIL::Module *module, const FlowGraph &flow, mfp<FlowGraph::Node*> &groups)
+	{
+		auto merge = [&](FlowGraph::Node *&rep, FlowGraph::Node *node) {
+			if (rep == nullptr)
+				rep = node;
+			else
+				groups.merge(rep, node);
+		};
+
+		for (auto &it : flow.wire_comb_defs) {
+			if (it.second.empty())
+				continue;
+			FlowGraph::Node *rep = nullptr;
+			for (auto node : it.second)
+				merge(rep, node);
+			if (flow.wire_sync_defs.count(it.first))
+				for (auto node : flow.wire_sync_defs.at(it.first))
+					merge(rep, node);
+			if (flow.wire_uses.count(it.first))
+				for (auto node : flow.wire_uses.at(it.first))
+					merge(rep, node);
+		}
+		for (auto &it : flow.wire_sync_defs) {
+			FlowGraph::Node *rep = nullptr;
+			for (auto node : it.second)
+				merge(rep, node);
+		}
+
+		FlowGraph::Node *effects_rep = nullptr;
+		dict<const RTLIL::Cell*, FlowGraph::Node*> cell_reps;
+		dict<const RTLIL::Process*, FlowGraph::Node*> process_reps;
+		dict<RTLIL::IdString, FlowGraph::Node*> memory_reps;
+		for (auto node : flow.nodes) {
+			switch (node->type) {
+				case FlowGraph::Node::Type::CONNECT:
+					break;
+				case FlowGraph::Node::Type::CELL_SYNC:
+				case FlowGraph::Node::Type::CELL_EVAL:
+					merge(cell_reps[node->cell], node);
+					if (is_effectful_cell(node->cell->type))
+						merge(effects_rep, node);
+					else if (!is_internal_cell(node->cell->type)) {
+						RTLIL::Module *cell_module = module->design->module(node->cell->type);
+						if (cell_module == nullptr || module_may_have_effects(cell_module))
+							merge(effects_rep, node);
+					}
+					break;
+				case FlowGraph::Node::Type::EFFECT_SYNC:
+					merge(effects_rep, node);
+					for (auto cell : node->cells)
+						merge(cell_reps[cell], node);
+					break;
+				case FlowGraph::Node::Type::PROCESS_SYNC:
+					for (auto sync : node->process->syncs)
+						for (auto &memwr : sync->mem_write_actions)
+							merge(memory_reps[memwr.memid], node);
+					YS_FALLTHROUGH
+				case FlowGraph::Node::Type::PROCESS_CASE:
+					merge(process_reps[node->process], node);
+					break;
+				case FlowGraph::Node::Type::MEM_RDPORT:
+				case FlowGraph::Node::Type::MEM_WRPORTS:
+					merge(memory_reps[node->mem->memid], node);
+					break;
+			}
+		}
+	}
+
+	// Distributes the groups of scheduled nodes over up to `max_bins` bins, heaviest first, always into the lightest
+	// bin. The bin of every group is recorded in `group_bins`, which allows finding the bin of unscheduled nodes.
+	std::vector<std::vector<FlowGraph::Node*>> distribute_groups(RTLIL::Module *module, mfp<FlowGraph::Node*> &groups,
+	                                                             const std::vector<FlowGraph::Node*> &scheduled_nodes,
+	                                                             int max_bins, dict<int, int> &group_bins)
+	{
+		dict<int, int> group_weights;
+		for (auto node : scheduled_nodes) {
+			int weight = 1;
+			if (node->type == FlowGraph::Node::Type::CELL_EVAL && !is_internal_cell(node->cell->type)) {
+				RTLIL::Module *cell_module = module->design->module(node->cell->type);
+				if (cell_module != nullptr)
+					weight += GetSize(cell_module->cells());
+			}
+			group_weights[groups.lookup(node)] += weight;
+		}
+
+		std::vector<std::pair<int, int>> sorted_groups;
+		for (auto &it : group_weights)
+			sorted_groups.push_back({-it.second, it.first});
+		std::stable_sort(sorted_groups.begin(), sorted_groups.end(),
+			[](const std::pair<int, int> &a, const std::pair<int, int> &b) { return a.first < b.first; });
+
+		int num_bins = std::min(max_bins, GetSize(group_weights));
+		std::vector<int> bin_weights(num_bins);
+		for (auto &it : sorted_groups) {
+			int lightest = std::min_element(bin_weights.begin(), bin_weights.end()) - bin_weights.begin();
+			bin_weights[lightest] -= it.first;
+			group_bins[it.second] = lightest;
+		}
+
+		std::vector<std::vector<FlowGraph::Node*>> bins(num_bins);
+		for (auto node : scheduled_nodes)
+			bins[group_bins.at(groups.lookup(node))].push_back(node);
+		return bins;
+	}
+
+	// Splits the eval() schedule of a module into up to `eval_partitions` partitions that can be evaluated
+	// concurrently.
+	void partition_schedule(RTLIL::Module *module, const FlowGraph &flow, const std::vector<FlowGraph::Node*> &scheduled_nodes)
+	{
+		mfp<FlowGraph::Node*> groups;
+		group_nodes(module, flow, groups);
+
+		dict<int, int> group_partitions;
+		auto bins = distribute_groups(module, groups, scheduled_nodes, eval_partitions, group_partitions);
+		if (GetSize(bins) < 2)
+			return;
+
+		auto &partitions = partitioned_schedule[module];
+		for (auto &bin : bins) {
+			partitions.emplace_back();
+			for (auto node : bin)
+				partitions.back().push_back(*node);
+		}
+
+		log("Module `%s' is evaluated in %d partitions.\n", log_id(module), GetSize(partitions));
+	}
+
+	// Returns whether a node reads a wire through anything other than its clock inputs.
+	bool reads_other_than_clock(const FlowGraph::Node *node, const RTLIL::Wire *wire)
+	{
+		RTLIL::SigSpec sig;
+		switch (node->type) {
+			case FlowGraph::Node::Type::CELL_EVAL:
+				if (!is_internal_cell(node->cell->type) || !node->cell->hasPort(ID::CLK))
+					return true;
+				for (auto conn : node->cell->connections())
+					if (node->cell->input(conn.first) && conn.first != ID::CLK)
+						sig.append(conn.second);
+				break;
+			case FlowGraph::Node::Type::MEM_RDPORT: {
+				auto &port = node->mem->rd_ports[node->portidx];
+				if (!port.clk_enable)
+					return true;
+				sig.append({port.en, port.arst, port.srst, port.addr});
+				for (int j = 0; j < GetSize(node->mem->wr_ports); j++)
+					if (port.transparency_mask[j]) {
+						auto &wrport = node->mem->wr_ports[j];
+						sig.append({wrport.en, wrport.addr, wrport.data});
+					}
+				break;
+			}
+			case FlowGraph::Node::Type::MEM_WRPORTS:
+				for (auto &port : node->mem->wr_ports) {
+					if (!port.clk_enable)
+						return true;
+					sig.append({port.en, port.addr, port.data});
+				}
+				break;
+			default:
+				return true;
+		}
+		for (auto chunk : sig.chunks())
+			if (chunk.wire == wire)
+				return true;
+		return false;
+	}
+
+	// Splits the eval() schedule of a module into up to `activity_regions` regions, each of which is only evaluated
+	// if something it reads has changed since it was last evaluated. A region reads the `.curr` of buffered wires,
+	// which can only change in `commit()`, unbuffered member wires with no comb def (such as top-level inputs),
+	// which are compared against a copy kept since the last evaluation, memories, which can only change in
+	// `commit()`, and edge detectors. Regions that evaluate submodules or have effects are always evaluated,
+	// since their state is not visible to the parent module.
+	void activity_schedule(RTLIL::Module *module, const FlowGraph &flow, const std::vector<FlowGraph::Node*> &scheduled_nodes)
+	{
+		mfp<FlowGraph::Node*> groups;
+		group_nodes(module, flow, groups);
+
+		dict<int, int> group_regions;
+		auto bins = distribute_groups(module, groups, scheduled_nodes, activity_regions, group_regions);
+		if (bins.empty())
+			return;
+
+		SigMap &sigmap = sigmaps[module];
+		auto add_edge = [&](ActivityRegion &region, RTLIL::SigSpec signal) {
+			signal = sigmap(signal);
+			if (!signal.is_fully_const())
+				region.edges.insert(signal[0]);
+		};
+
+		auto &regions = activity_schedule_regions[module];
+		for (auto &bin : bins) {
+			regions.emplace_back();
+			ActivityRegion &region = regions.back();
+			for (auto node : bin) {
+				region.nodes.push_back(*node);
+				switch (node->type) {
+					case FlowGraph::Node::Type::CONNECT:
+						break;
+					case FlowGraph::Node::Type::CELL_SYNC:
+					case FlowGraph::Node::Type::CELL_EVAL:
+						if (!is_internal_cell(node->cell->type) || is_effectful_cell(node->cell->type))
+							region.always = true;
+						else if (node->cell->hasPort(ID::CLK) && is_valid_clock(node->cell->getPort(ID::CLK)))
+							add_edge(region, node->cell->getPort(ID::CLK));
+						break;
+					case FlowGraph::Node::Type::EFFECT_SYNC:
+						region.always = true;
+						break;
+					case FlowGraph::Node::Type::PROCESS_SYNC:
+						for (auto sync : node->process->syncs)
+							if (sync->type == RTLIL::STp || sync->type == RTLIL::STn || sync->type == RTLIL::STe)
+								add_edge(region, sync->signal);
+						break;
+					case FlowGraph::Node::Type::PROCESS_CASE:
+						break;
+					case FlowGraph::Node::Type::MEM_RDPORT:
+						if (node->mem->rd_ports[node->portidx].clk_enable)
+							add_edge(region, node->mem->rd_ports[node->portidx].clk);
+						break;
+					case FlowGraph::Node::Type::MEM_WRPORTS:
+						for (auto &port : node->mem->wr_ports)
+							if (port.clk_enable)
+								add_edge(region, port.clk);
+						break;
+				}
+			}
+		}
+
+		// Unscheduled nodes (such as the drivers of inlined wires) are accounted for via the group they belong to.
+		for (auto &it : flow.wire_uses) {
+			const RTLIL::Wire *wire = it.first;
+			const auto &wire_type = wire_types[wire];
+			if (!wire_type.is_buffered()) {
+				if (wire_type.type != WireType::MEMBER)
+					continue;
+				if (flow.wire_comb_defs.count(wire) && !flow.wire_comb_defs.at(wire).empty())
+					continue; // defined in the same region as all of its uses
+			}
+			for (auto node : it.second) {
+				if (!wire_type.is_buffered() && edge_wires[wire] && !reads_other_than_clock(node, wire))
+					continue; // only the edges matter, and these are checked separately
+				int group = groups.lookup(node);
+				if (group_regions.count(group) && !regions[group_regions[group]].always)
+					activity_wire_regions[wire].insert(group_regions[group]);
+			}
+		}
+		for (auto &mem : mod_memories[module]) {
+			if (!writable_memories.count({module, mem.memid}))
+				continue;
+			for (auto node : flow.nodes)
+				if ((node->type == FlowGraph::Node::Type::MEM_RDPORT || node->type == FlowGraph::Node::Type::MEM_WRPORTS) &&
+						node->mem->memid == mem.memid) {
+					int group = groups.lookup(node);
+					if (group_regions.count(group) && !regions[group_regions[group]].always)
+						activity_memory_regions[{module, mem.memid}].insert(group_regions[group]);
+				}
+		}
+
+		log("Module `%s' is evaluated in %d activity regions.\n", log_id(module), GetSize(regions));
+	}
+
 	void analyze_design(RTLIL::Design *design)
 	{
 		bool has_feedback_arcs = false;
@@ -3205,6 +3873,7 @@ struct CxxrtlWorker {
 			// Emit reachable nodes in eval().
 			// Accumulate sync effectful cells per trigger condition.
 			dict<std::pair<RTLIL::SigSpec, RTLIL::Const>, std::vector<const RTLIL::Cell*>> effect_sync_cells;
+			std::vector<FlowGraph::Node*> scheduled_nodes;
 			for (auto node : node_order)
 				if (live_nodes[node]) {
 					if (node->type == FlowGraph::Node::Type::CELL_EVAL &&
@@ -3213,14 +3882,21 @@ struct CxxrtlWorker {
 							node->cell->getParam(ID::TRG_WIDTH).as_int() != 0)
 						effect_sync_cells[make_pair(node->cell->getPort(ID::TRG), node->cell->getParam(ID::TRG_POLARITY))].push_back(node->cell);
 					else
-						schedule[module].push_back(*node);
+						scheduled_nodes.push_back(node);
 				}
 
 			for (auto &it : effect_sync_cells) {
 				auto node = flow.add_effect_sync_node(it.second);
-				schedule[module].push_back(*node);
+				scheduled_nodes.push_back(node);
 			}
 
+			for (auto node : scheduled_nodes)
+				schedule[module].push_back(*node);
+			if (eval_partitions > 1)
+				partition_schedule(module, flow, scheduled_nodes);
+			if (activity_regions > 0)
+				activity_schedule(module, flow, scheduled_nodes);
+
 			// For maximum performance, the state of the simulation (which is the same as the set of its double buffered
 			// wires, since using a singly buffered wire for any kind of state introduces a race condition) should contain
 			// no wires attached to combinatorial outputs. Feedback wires, by definition, make that impossible. However,
@@ -3427,6 +4103,323 @@ struct CxxrtlWorker {
 		}
 	}
 
+	// With -lanes, the design is emitted as a single struct in which every wire is a `value_lanes<>` and the state
+	// of every flip-flop is a `wire_lanes<>`, so that one call to `eval()` advances `lanes` independent instances of
+	// the design (see <cxxrtl/cxxrtl_batch.h>). This mode supports a much smaller subset of designs than the normal
+	// one: a single flattened module without memories, processes, black boxes, effectful cells, or combinatorial
+	// loops, whose flip-flops are clocked by its input ports. It has neither debug information nor a C API.
+	std::string lanes_type(int width, bool is_wire = false)
+	{
+		return stringf("%s<%d, %d>", is_wire ? "wire_lanes" : "value_lanes", width, lanes);
+	}
+
+	std::string lanes_const(const RTLIL::Const &data)
+	{
+		std::ostringstream const_f;
+		std::swap(f, const_f);
+		dump_const(data);
+		std::swap(f, const_f);
+		return lanes_type(data.size()) + "(" + const_f.str() + ")";
+	}
+
+	std::string lanes_sigspec(const RTLIL::SigSpec &sig)
+	{
+		if (sig.empty())
+			return lanes_type(0) + "()";
+
+		std::string expr;
+		auto chunks = sig.chunks();
+		for (auto it = chunks.rbegin(); it != chunks.rend(); it++) {
+			std::string chunk_expr;
+			if (it->wire == nullptr) {
+				chunk_expr = lanes_const(it->data);
+			} else {
+				chunk_expr = mangle(it->wire);
+				if (lanes_clock_wires.count(it->wire))
+					chunk_expr += ".curr";
+				if (it->offset != 0 || it->width != it->wire->width)
+					chunk_expr += stringf(".slice<%d,%d>()", it->offset + it->width - 1, it->offset);
+			}
+			expr = expr.empty() ? chunk_expr : expr + ".concat(" + chunk_expr + ")";
+		}
+		return expr;
+	}
+
+	std::string lanes_cell_expr(const RTLIL::Cell *cell)
+	{
+		std::string expr;
+		if (is_unary_cell(cell->type) || is_binary_cell(cell->type)) {
+			expr = cell->type.substr(1);
+			if (is_extending_cell(cell->type)) {
+				expr += '_';
+				expr += cell->getParam(ID::A_SIGNED).as_bool() ? 's' : 'u';
+				if (is_binary_cell(cell->type))
+					expr += cell->getParam(ID::B_SIGNED).as_bool() ? 's' : 'u';
+			}
+			expr += stringf("<%d>(", cell->getParam(ID::Y_WIDTH).as_int());
+			expr += lanes_sigspec(cell->getPort(ID::A));
+			if (is_binary_cell(cell->type))
+				expr += ", " + lanes_sigspec(cell->getPort(ID::B));
+			expr += ")";
+		} else if (cell->type == ID($mux)) {
+			expr = "blend(" + lanes_sigspec(cell->getPort(ID::S)) + ", " +
+				lanes_sigspec(cell->getPort(ID::B)) + ", " + lanes_sigspec(cell->getPort(ID::A)) + ")";
+		} else if (cell->type == ID($pmux)) {
+			int width = cell->getParam(ID::WIDTH).as_int();
+			int s_width = cell->getParam(ID::S_WIDTH).as_int();
+			expr = lanes_sigspec(cell->getPort(ID::A));
+			for (int part = s_width - 1; part >= 0; part--)
+				expr = "blend(" + lanes_sigspec(cell->getPort(ID::S).extract(part)) + ", " +
+					lanes_sigspec(cell->getPort(ID::B).extract(part * width, width)) + ", " + expr + ")";
+		} else if (cell->type == ID($concat)) {
+			expr = lanes_sigspec(cell->getPort(ID::B)) + ".concat(" + lanes_sigspec(cell->getPort(ID::A)) + ")";
+		} else if (cell->type == ID($slice)) {
+			int offset = cell->getParam(ID::OFFSET).as_int();
+			expr = lanes_sigspec(cell->getPort(ID::A)) +
+				stringf(".slice<%d,%d>()", offset + cell->getParam(ID::Y_WIDTH).as_int() - 1, offset);
+		} else {
+			log_assert(false);
+		}
+		return expr;
+	}
+
+	void dump_lanes_assign(const RTLIL::SigSpec &lhs, const std::string &expr)
+	{
+		if (lhs.is_wire()) {
+			f << indent << mangle(lhs.as_wire()) << " = " << expr << ";\n";
+			return;
+		}
+
+		std::string tmp = fresh_temporary();
+		f << indent << lanes_type(GetSize(lhs)) << " " << tmp << " = " << expr << ";\n";
+		int offset = 0;
+		for (auto &chunk : lhs.chunks()) {
+			std::string part = tmp + stringf(".slice<%d,%d>()", offset + chunk.width - 1, offset);
+			f << indent << mangle(chunk.wire) << " = ";
+			if (chunk.offset == 0 && chunk.width == chunk.wire->width)
+				f << part << ";\n";
+			else
+				f << mangle(chunk.wire) << stringf(".blit<%d,%d>(", chunk.offset + chunk.width - 1, chunk.offset)
+				  << part << ");\n";
+			offset += chunk.width;
+		}
+	}
+
+	void dump_lanes_ff(const RTLIL::Cell *cell, const FfData &ff, const dict<RTLIL::SigBit, RTLIL::SigBit> &input_bits,
+	                   const SigMap &sigmap)
+	{
+		auto polarized = [&](const RTLIL::SigSpec &sig, bool polarity) {
+			return lanes_sigspec(sig) + (polarity ? "" : ".bit_not()");
+		};
+
+		RTLIL::SigBit clk_bit = input_bits.at(sigmap(ff.sig_clk[0]));
+		std::string update = fresh_temporary();
+		f << indent << "// " << cell->type.str() << " " << cell->name.str() << "\n";
+		f << indent << lanes_type(1) << " " << update << " = active.bit_and(" << mangle(clk_bit.wire)
+		            << (ff.pol_clk ? ".posedge<" : ".negedge<") << clk_bit.offset << ">());\n";
+		if (ff.has_ce && ff.has_srst && !ff.ce_over_srst)
+			f << indent << update << " = " << update << ".bit_and(" << polarized(ff.sig_ce, ff.pol_ce)
+			            << ".bit_or(" << polarized(ff.sig_srst, ff.pol_srst) << "));\n";
+		else if (ff.has_ce)
+			f << indent << update << " = " << update << ".bit_and(" << polarized(ff.sig_ce, ff.pol_ce) << ");\n";
+		std::string data = lanes_sigspec(ff.sig_d);
+		if (ff.has_srst)
+			data = "blend(" + polarized(ff.sig_srst, ff.pol_srst) + ", " + lanes_const(ff.val_srst) + ", " + data + ")";
+		f << indent << mangle(cell) << ".next = blend(" << update << ", " << data << ", "
+		            << mangle(cell) << ".next);\n";
+		if (ff.has_arst) {
+			f << indent << mangle(cell) << ".next = blend(active.bit_and(" << polarized(ff.sig_arst, ff.pol_arst)
+			            << "), " << lanes_const(ff.val_arst) << ", " << mangle(cell) << ".next);\n";
+		}
+	}
+
+	void dump_lanes_design(RTLIL::Design *design)
+	{
+		RTLIL::Module *module = nullptr;
+		for (auto candidate : design->selected_modules()) {
+			if (candidate->get_blackbox_attribute())
+				continue;
+			if (module != nullptr)
+				log_cmd_error("Option -lanes requires a single module, but the design has modules `%s' and `%s'.\n",
+				              log_id(module), log_id(candidate));
+			module = candidate;
+		}
+		if (module == nullptr)
+			log_cmd_error("Option -lanes requires a module.\n");
+		if (!module->processes.empty())
+			log_cmd_error("Module `%s' has processes, which are not supported with -lanes.\n", log_id(module));
+		if (!module->memories.empty())
+			log_cmd_error("Module `%s' has memories, which are not supported with -lanes.\n", log_id(module));
+
+		SigMap sigmap(module);
+		FfInitVals initvals(&sigmap, module);
+
+		dict<RTLIL::SigBit, RTLIL::SigBit> input_bits;
+		for (auto wire : module->wires()) {
+			if (wire->port_input && wire->port_output)
+				log_cmd_error("Port `%s.%s' is bidirectional, which is not supported with -lanes.\n",
+				              log_id(module), log_id(wire));
+			if (wire->port_input)
+				for (auto bit : SigSpec(wire))
+					input_bits[sigmap(bit)] = bit;
+		}
+
+		// Every combinatorial cell, connection and flip-flop output drives its outputs from the inputs, and
+		// is evaluated after all of the drivers of its inputs.
+		struct LanesNode {
+			RTLIL::SigSpec lhs;
+			std::string expr;
+			std::vector<RTLIL::SigSpec> inputs;
+		};
+		std::vector<std::pair<RTLIL::Cell*, FfData>> ffs;
+		lanes_clock_wires.clear();
+		for (auto cell : module->cells()) {
+			if (!is_ff_cell(cell->type))
+				continue;
+			FfData ff(&initvals, cell);
+			if (!ff.has_clk || ff.has_aload || ff.has_sr)
+				log_cmd_error("Cell `%s.%s' of type `%s' is not supported with -lanes.\n",
+				              log_id(module), log_id(cell), log_id(cell->type));
+			if (!input_bits.count(sigmap(ff.sig_clk[0])))
+				log_cmd_error("Clock of cell `%s.%s' is not driven by an input port, which is required with -lanes.\n",
+				              log_id(module), log_id(cell));
+			lanes_clock_wires.insert(input_bits[sigmap(ff.sig_clk[0])].wire);
+			ffs.emplace_back(cell, ff);
+		}
+
+		std::vector<LanesNode> nodes;
+		for (auto &it : ffs)
+			nodes.push_back({it.second.sig_q, mangle(it.first) + ".curr", {}});
+		for (auto cell : module->cells()) {
+			if (is_ff_cell(cell->type))
+				continue;
+			if (!is_inlinable_cell(cell->type) || cell->type.in(ID($bmux), ID($demux)))
+				log_cmd_error("Cell `%s.%s' of type `%s' is not supported with -lanes.\n",
+				              log_id(module), log_id(cell), log_id(cell->type));
+			std::vector<RTLIL::SigSpec> inputs;
+			for (auto conn : cell->connections())
+				if (cell->input(conn.first))
+					inputs.push_back(conn.second);
+			nodes.push_back({cell->getPort(ID::Y), lanes_cell_expr(cell), inputs});
+		}
+		for (auto conn : module->connections())
+			nodes.push_back({conn.first, lanes_sigspec(conn.second), {conn.second}});
+
+		dict<RTLIL::SigBit, int> drivers;
+		for (int index = 0; index < GetSize(nodes); index++)
+			for (auto bit : nodes[index].lhs) {
+				log_assert(bit.wire != nullptr);
+				if (bit.wire->port_input)
+					log_cmd_error("Input port `%s.%s' is driven within the module.\n", log_id(module), log_id(bit.wire));
+				if (drivers.count(bit))
+					log_cmd_error("Wire %s.%s has multiple drivers!\n", log_id(module), log_id(bit.wire));
+				drivers[bit] = index;
+			}
+
+		std::vector<int> indegree(nodes.size());
+		std::vector<pool<int>> users(nodes.size());
+		for (int index = 0; index < GetSize(nodes); index++)
+			for (auto &input : nodes[index].inputs)
+				for (auto bit : input)
+					if (drivers.count(bit) && users[drivers[bit]].insert(index).second)
+						indegree[index]++;
+		std::vector<int> order;
+		std::set<int> ready;
+		for (int index = 0; index < GetSize(nodes); index++)
+			if (indegree[index] == 0)
+				ready.insert(index);
+		while (!ready.empty()) {
+			int index = *ready.begin();
+			ready.erase(ready.begin());
+			order.push_back(index);
+			for (int user : users[index])
+				if (--indegree[user] == 0)
+					ready.insert(user);
+		}
+		if (GetSize(order) != GetSize(nodes))
+			log_cmd_error("Module `%s' has a combinatorial loop, which is not supported with -lanes.\n", log_id(module));
+
+		std::string name = mangle(module);
+		f << "#include <cxxrtl/cxxrtl_batch.h>\n";
+		f << "\n";
+		f << "using namespace cxxrtl_yosys;\n";
+		f << "\n";
+		f << "namespace " << design_ns << " {\n";
+		f << "\n";
+		f << "// Every member holds the state of " << lanes << " independent instances of module `"
+		  << log_id(module) << "'.\n";
+		f << "struct " << name << " {\n";
+		inc_indent();
+			f << indent << "static constexpr size_t lanes = " << lanes << ";\n";
+			f << indent << "static constexpr lane_mask all_lanes = cxxrtl::all_lanes<" << lanes << ">();\n";
+			f << "\n";
+			for (auto wire : module->wires()) {
+				if (wire->width == 0)
+					continue;
+				f << indent << lanes_type(wire->width, lanes_clock_wires.count(wire)) << " " << mangle(wire) << ";\n";
+			}
+			for (auto &it : ffs) {
+				f << indent << lanes_type(it.second.width, /*is_wire=*/true) << " " << mangle(it.first) << " {";
+				dump_const(it.second.val_init);
+				f << "};\n";
+			}
+			f << "\n";
+			f << indent << "void reset() {\n";
+			inc_indent();
+				f << indent << "*this = " << name << "();\n";
+			dec_indent();
+			f << indent << "}\n";
+			f << "\n";
+			f << indent << "// Evaluates every lane; only the lanes in `mask` update their flip-flops.\n";
+			f << indent << "void eval(lane_mask mask = all_lanes) {\n";
+			inc_indent();
+				f << indent << lanes_type(1) << " active = lanes_of<" << lanes << ">(mask);\n";
+				for (int index : order)
+					dump_lanes_assign(nodes[index].lhs, nodes[index].expr);
+				for (auto &it : ffs)
+					dump_lanes_ff(it.first, it.second, input_bits, sigmap);
+			dec_indent();
+			f << indent << "}\n";
+			f << "\n";
+			f << indent << "// Commits the lanes in `mask`, and returns the mask of the ones whose state has changed.\n";
+			f << indent << "lane_mask commit(lane_mask mask = all_lanes) {\n";
+			inc_indent();
+				f << indent << "lane_mask changed = 0;\n";
+				for (auto wire : module->wires())
+					if (lanes_clock_wires.count(wire))
+						f << indent << "changed |= " << mangle(wire) << ".commit(mask);\n";
+				for (auto &it : ffs)
+					f << indent << "changed |= " << mangle(it.first) << ".commit(mask);\n";
+				f << indent << "return changed;\n";
+			dec_indent();
+			f << indent << "}\n";
+			f << "\n";
+			f << indent << "// Evaluates and commits the lanes in `mask` until each of them settles, and returns the\n";
+			f << indent << "// number of delta cycles taken.\n";
+			f << indent << "size_t step(lane_mask mask = all_lanes) {\n";
+			inc_indent();
+				f << indent << "size_t deltas = 0;\n";
+				f << indent << "do {\n";
+				inc_indent();
+					f << indent << "eval(mask);\n";
+					f << indent << "deltas++;\n";
+					f << indent << "mask &= commit(mask);\n";
+				dec_indent();
+				f << indent << "} while (mask != 0);\n";
+				f << indent << "return deltas;\n";
+			dec_indent();
+			f << indent << "}\n";
+		dec_indent();
+		f << "};\n";
+		f << "\n";
+		f << "constexpr size_t " << name << "::lanes;\n";
+		f << "constexpr lane_mask " << name << "::all_lanes;\n";
+		f << "\n";
+		f << "} // namespace " << design_ns << "\n";
+
+		*impl_f << f.str(); f.str("");
+	}
+
 	void prepare_design(RTLIL::Design *design)
 	{
 		bool did_anything = false;
@@ -3459,7 +4452,8 @@ struct CxxrtlWorker {
 		log_pop();
 		if (did_anything)
 			log_spacer();
-		analyze_design(design);
+		if (lanes == 0)
+			analyze_design(design); // dump_lanes_design() does its own, much simpler, analysis
 	}
 };
 
@@ -3636,6 +4630,15 @@ struct CxxrtlBackend : public Backend {
 		log("        of the interface is derived from filename of the implementation.\n");
 		log("        otherwise, interface and implementation are generated together.\n");
 		log("\n");
+		log("    -split <n>\n");
+		log("        distribute the method definitions of the modules over <n> files that\n");
+		log("        can be compiled in parallel, the largest first, each to the file with\n");
+		log("        the least code so far. requires -header. the first file is the one\n");
+		log("        given by filename, the other ones have \"_1\", \"_2\", ... appended to\n");
+		log("        its base name. all of them have to be compiled and linked together.\n");
+		log("        a single method (e.g. `eval()` of a large flattened module) is never\n");
+		log("        split. if not specified, 1 is used.\n");
+		log("\n");
 		log("    -namespace <ns-name>\n");
 		log("        place the generated code into namespace <ns-name>. if not specified,\n");
 		log("        \"cxxrtl_design\" is used.\n");
@@ -3661,6 +4664,57 @@ struct CxxrtlBackend : public Backend {
 		log("        processes significantly improves evaluation performance at the cost of\n");
 		log("        slight increase in compilation time.\n");
 		log("\n");
+		log("    -parallel <n>\n");
+		log("        split `eval()` of every module into up to <n> partitions that share no\n");
+		log("        state written during evaluation, and evaluate them concurrently on a\n");
+		log("        pool of threads. the number of threads is determined by the environment\n");
+		log("        variable CXXRTL_THREADS, or the number of hardware threads if it is not\n");
+		log("        set. the generated code must be linked with `-pthread`. this is only\n");
+		log("        beneficial for large designs with several independent parts, such as\n");
+		log("        multiple clock domains or cores. if not specified, 1 is used.\n");
+		log("\n");
+		log("    -activity <n>\n");
+		log("        split `eval()` of every module into up to <n> regions, and skip\n");
+		log("        evaluating a region if none of the wires, memories, and clock edges it\n");
+		log("        depends on have changed since it was last evaluated. this is beneficial\n");
+		log("        for designs where most of the logic is idle most of the time. regions\n");
+		log("        that evaluate submodules or have side effects are always evaluated.\n");
+		log("        changes to the state of a module made other than through `commit()` or\n");
+		log("        its top-level inputs (e.g. by writing to `.curr` or to a memory) are not\n");
+		log("        noticed. cannot be used together with `-parallel`.\n");
+		log("\n");
+		log("    -lanes <n>\n");
+		log("        generate a model of the toplevel module that simulates <n> (at most 64)\n");
+		log("        independent instances at once. every wire is a `value_lanes<>` and\n");
+		log("        every flip-flop a `wire_lanes<>` from <cxxrtl/cxxrtl_batch.h>, which\n");
+		log("        store the chunks of all instances next to each other, so that most\n");
+		log("        operations in `eval()` are loops over the instances that the compiler\n");
+		log("        can vectorize. `eval()`, `commit()`, and `step()` take a mask of the\n");
+		log("        instances whose flip-flops may change, which allows the instances to\n");
+		log("        be driven by testbenches with divergent control flow. only a single\n");
+		log("        flattened module without memories, black boxes, $print or $check\n");
+		log("        cells, or combinatorial loops is supported, and its flip-flops must be\n");
+		log("        clocked by input ports. the model has no debug information or C API,\n");
+		log("        and ignores -O and -g. cannot be used together with -parallel,\n");
+		log("        -activity, -profile, -arena, -header, or -split.\n");
+		log("\n");
+		log("    -profile\n");
+		log("        instrument the generated code with counters of how many times, and\n");
+		log("        for how long, `eval()` and `commit()` of every module, every process\n");
+		log("        (with `-noproc`), and every region (with `-activity`) were evaluated.\n");
+		log("        the counters are collected with the `profile_info()` method of the\n");
+		log("        toplevel module, and can be reported with `profile_items::dump()`\n");
+		log("        from <cxxrtl/cxxrtl_profile.h>. the instrumentation has a noticeable\n");
+		log("        overhead, especially for processes.\n");
+		log("\n");
+		log("    -arena\n");
+		log("        allocate the state of the design (wires, memories, and the state of\n");
+		log("        effectful cells, but not black boxes) in a single contiguous block of\n");
+		log("        memory owned by the toplevel module, which can be saved and restored\n");
+		log("        with `memcpy()` through `state()` or `cxxrtl_snapshot_save()` and\n");
+		log("        `cxxrtl_snapshot_restore()` of the C API. members with state refer to\n");
+		log("        the arena, which makes accessing them slightly slower.\n");
+		log("\n");
 		log("    -O <level>\n");
 		log("        set the optimization level. the default is -O%d. higher optimization\n", DEFAULT_OPT_LEVEL);
 		log("        levels dramatically decrease compile and run time, and highest level\n");
@@ -3748,6 +4802,32 @@ struct CxxrtlBackend : public Backend {
 				noproc = true;
 				continue;
 			}
+			if (args[argidx] == "-parallel" && argidx+1 < args.size()) {
+				worker.eval_partitions = std::stoi(args[++argidx]);
+				if (worker.eval_partitions < 1)
+					log_cmd_error("Invalid number of partitions %d.\n", worker.eval_partitions);
+				continue;
+			}
+			if (args[argidx] == "-activity" && argidx+1 < args.size()) {
+				worker.activity_regions = std::stoi(args[++argidx]);
+				if (worker.activity_regions < 1)
+					log_cmd_error("Invalid number of activity regions %d.\n", worker.activity_regions);
+				continue;
+			}
+			if (args[argidx] == "-lanes" && argidx+1 < args.size()) {
+				worker.lanes = std::stoi(args[++argidx]);
+				if (worker.lanes < 1 || worker.lanes > 64)
+					log_cmd_error("Invalid number of lanes %d.\n", worker.lanes);
+				continue;
+			}
+			if (args[argidx] == "-profile") {
+				worker.profile = true;
+				continue;
+			}
+			if (args[argidx] == "-arena") {
+				worker.state_arena = true;
+				continue;
+			}
 			if (args[argidx] == "-Og") {
 				log_warning("The `-Og` option has been removed. Use `-g3` instead for complete "
 				            "design coverage regardless of optimization level.\n");
@@ -3779,6 +4859,12 @@ struct CxxrtlBackend : public Backend {
 				worker.split_intf = true;
 				continue;
 			}
+			if (args[argidx] == "-split" && argidx+1 < args.size()) {
+				worker.impl_units = std::stoi(args[++argidx]);
+				if (worker.impl_units < 1)
+					log_cmd_error("Invalid number of files %d.\n", worker.impl_units);
+				continue;
+			}
 			if (args[argidx] == "-namespace" && argidx+1 < args.size()) {
 				worker.design_ns = args[++argidx];
 				continue;
@@ -3795,6 +4881,13 @@ struct CxxrtlBackend : public Backend {
 		}
 		extra_args(f, filename, args, argidx);
 
+		if (worker.eval_partitions > 1 && worker.activity_regions > 0)
+			log_cmd_error("Options -parallel and -activity are mutually exclusive.\n");
+		if (worker.lanes > 0 && (worker.eval_partitions > 1 || worker.activity_regions > 0 || worker.profile ||
+		                         worker.state_arena || worker.split_intf || worker.impl_units > 1))
+			log_cmd_error("Option -lanes cannot be used together with -parallel, -activity, -profile, -arena, "
+			              "-header, or -split.\n");
+
 		worker.print_wire_types = print_wire_types;
 		worker.print_debug_wire_types = print_debug_wire_types;
 		worker.run_hierarchy = !nohierarchy;
@@ -3860,8 +4953,28 @@ struct CxxrtlBackend : public Backend {
 		}
 		worker.impl_f = f;
 
+		std::vector<std::unique_ptr<std::ofstream>> unit_files;
+		if (worker.impl_units > 1) {
+			if (!worker.split_intf)
+				log_cmd_error("Option -split must be used with -header.\n");
+
+			std::string base = filename.substr(0, filename.rfind('.'));
+			std::string ext = filename.rfind('.') != std::string::npos ? filename.substr(filename.rfind('.')) : ".cc";
+			for (int unit = 1; unit < worker.impl_units; unit++) {
+				std::string unit_filename = stringf("%s_%d%s", base.c_str(), unit, ext.c_str());
+				unit_files.emplace_back(new std::ofstream(unit_filename, std::ofstream::trunc));
+				if (unit_files.back()->fail())
+					log_cmd_error("Can't open file `%s' for writing: %s\n",
+					              unit_filename.c_str(), strerror(errno));
+				worker.unit_f.push_back(unit_files.back().get());
+			}
+		}
+
 		worker.prepare_design(design);
-		worker.dump_design(design);
+		if (worker.lanes > 0)
+			worker.dump_lanes_design(design);
+		else
+			worker.dump_design(design);
 	}
 } CxxrtlBackend;
 
@@ -72,6 +72,23 @@ size_t cxxrtl_step(cxxrtl_handle handle) {
 	return handle->module->step();
 }
 
+size_t cxxrtl_snapshot_size(cxxrtl_handle handle) {
+	cxxrtl::state_arena *state = handle->module->state();
+	return state ? state->size : 0;
+}
+
+void cxxrtl_snapshot_save(cxxrtl_handle handle, void *snapshot) {
+	cxxrtl::state_arena *state = handle->module->state();
+	assert(state != nullptr);
+	state->save(snapshot);
+}
+
+void cxxrtl_snapshot_restore(cxxrtl_handle handle, const void *snapshot) {
+	cxxrtl::state_arena *state = handle->module->state();
+	assert(state != nullptr);
+	state->restore(snapshot);
+}
+
 struct cxxrtl_object *cxxrtl_get_parts(cxxrtl_handle handle, const char *name, size_t *parts) {
 	auto it = handle->objects.table.find(name);
 	if (it == handle->objects.table.end())
@@ -87,6 +104,69 @@ void cxxrtl_enum(cxxrtl_handle handle, void *data,
 		callback(data, it.first.c_str(), static_cast<cxxrtl_object*>(&it.second[0]), it.second.size());
 }
 
+struct _cxxrtl_object_set {
+	// Objects that are adjacent both in the buffer and in memory are merged into one range.
+	struct range {
+		uint32_t *curr;
+		uint32_t *next;
+		size_t offset;
+		size_t chunks;
+	};
+
+	std::vector<range> ranges;
+	std::vector<cxxrtl_outline> outlines;
+	size_t size = 0;
+};
+
+cxxrtl_object_set cxxrtl_object_set_create() {
+	return new _cxxrtl_object_set;
+}
+
+void cxxrtl_object_set_destroy(cxxrtl_object_set set) {
+	delete set;
+}
+
+size_t cxxrtl_object_set_add(cxxrtl_object_set set, cxxrtl_object *object) {
+	size_t offset = set->size;
+	size_t chunks = ((object->width + 31) / 32) * object->depth;
+	set->size += chunks;
+
+	if (object->outline != nullptr &&
+			std::find(set->outlines.begin(), set->outlines.end(), object->outline) == set->outlines.end())
+		set->outlines.push_back(object->outline);
+
+	if (chunks == 0)
+		return offset;
+	if (!set->ranges.empty()) {
+		_cxxrtl_object_set::range &last = set->ranges.back();
+		if (last.curr + last.chunks == object->curr &&
+				((last.next == nullptr && object->next == nullptr) ||
+				 (last.next != nullptr && last.next + last.chunks == object->next))) {
+			last.chunks += chunks;
+			return offset;
+		}
+	}
+	set->ranges.push_back({object->curr, object->next, offset, chunks});
+	return offset;
+}
+
+size_t cxxrtl_object_set_size(cxxrtl_object_set set) {
+	return set->size;
+}
+
+void cxxrtl_object_set_gather(cxxrtl_object_set set, uint32_t *buffer) {
+	for (cxxrtl_outline outline : set->outlines)
+		outline->eval();
+	for (const _cxxrtl_object_set::range &range : set->ranges)
+		memcpy(&buffer[range.offset], range.curr, range.chunks * sizeof(uint32_t));
+}
+
+void cxxrtl_object_set_scatter(cxxrtl_object_set set, const uint32_t *buffer) {
+	for (const _cxxrtl_object_set::range &range : set->ranges)
+		if (range.next != nullptr)
+			memcpy(range.next, &buffer[range.offset], range.chunks * sizeof(uint32_t));
+}
+
 void cxxrtl_outline_eval(cxxrtl_outline outline) {
 	outline->eval();
 }
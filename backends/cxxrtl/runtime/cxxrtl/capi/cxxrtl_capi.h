@@ -86,6 +86,24 @@ int cxxrtl_commit(cxxrtl_handle handle);
 // Returns the number of delta cycles.
 size_t cxxrtl_step(cxxrtl_handle handle);
 
+// Get the size of a snapshot of the design state.
+//
+// Returns 0 if the design was not generated with the `-arena` option, in which case snapshots cannot be
+// taken or restored.
+size_t cxxrtl_snapshot_size(cxxrtl_handle handle);
+
+// Copy the state of the design to `snapshot`, which must be at least `cxxrtl_snapshot_size(handle)` bytes long.
+//
+// The snapshot includes the values of all wires and memories, but not the state of black boxes. It must be taken
+// in between `cxxrtl_commit` (or `cxxrtl_step`) and `cxxrtl_eval`, and may only be restored into a design handle
+// created from the same generated code.
+void cxxrtl_snapshot_save(cxxrtl_handle handle, void *snapshot);
+
+// Replace the state of the design with the contents of `snapshot`.
+//
+// Like `cxxrtl_reset`, this operation keeps all of the interior pointers obtained with e.g. `cxxrtl_get` valid.
+void cxxrtl_snapshot_restore(cxxrtl_handle handle, const void *snapshot);
+
 // Type of a simulated object.
 //
 // The type of a simulated object indicates the way it is stored and the operations that are legal
@@ -304,6 +322,41 @@ void cxxrtl_enum(cxxrtl_handle handle, void *data,
                  void (*callback)(void *data, const char *name,
                                   struct cxxrtl_object *object, size_t parts));
 
+// Opaque reference to an object set.
+//
+// An object set is an ordered collection of simulated objects whose bits can be copied to or from
+// a single contiguous buffer with one call, which avoids the overhead of accessing every object
+// individually (e.g. through a foreign function interface) when many objects are probed each cycle.
+//
+// In the buffer, the bits of every object are laid out as in its `curr` array (i.e. as
+// `((width + 31) / 32) * depth` chunks), one object after another, in the order they were added.
+typedef struct _cxxrtl_object_set *cxxrtl_object_set;
+
+// Create an empty object set.
+cxxrtl_object_set cxxrtl_object_set_create();
+
+// Release all resources used by an object set.
+void cxxrtl_object_set_destroy(cxxrtl_object_set set);
+
+// Add an object to an object set.
+//
+// The object must stay valid (i.e. the design it belongs to must not be destroyed) for as long as
+// the object set is used. Returns the offset of the bits of the object in the buffer, in chunks.
+size_t cxxrtl_object_set_add(cxxrtl_object_set set, struct cxxrtl_object *object);
+
+// Get the size of the buffer of an object set, in chunks.
+size_t cxxrtl_object_set_size(cxxrtl_object_set set);
+
+// Copy the bits of every object in an object set from its `curr` array to `buffer`.
+//
+// Outlines of outline objects in the set are evaluated first, once each.
+void cxxrtl_object_set_gather(cxxrtl_object_set set, uint32_t *buffer);
+
+// Copy the bits of every object in an object set from `buffer` to its `next` array.
+//
+// Objects that cannot be modified (whose `next` pointer is NULL) are skipped.
+void cxxrtl_object_set_scatter(cxxrtl_object_set set, const uint32_t *buffer);
+
 // Opaque reference to an outline.
 //
 // An outline is a group of outline objects that are evaluated simultaneously. The identity of
@@ -37,6 +37,7 @@
 #include <map>
 #include <algorithm>
 #include <memory>
+#include <new>
 #include <functional>
 #include <sstream>
 #include <iostream>
@@ -363,11 +364,12 @@ struct value : public expr_base<value<Bits>> {
 		return !is_zero();
 	}
 
+	// The reductions below have no early exit, which allows the compiler to vectorize them for wide values.
 	bool is_zero() const {
+		chunk::type bits = 0;
 		for (size_t n = 0; n < chunks; n++)
-			if (data[n] != 0)
-				return false;
-		return true;
+			bits |= data[n];
+		return bits == 0;
 	}
 
 	bool is_neg() const {
@@ -375,10 +377,10 @@ struct value : public expr_base<value<Bits>> {
 	}
 
 	bool operator ==(const value<Bits> &other) const {
+		chunk::type diff = 0;
 		for (size_t n = 0; n < chunks; n++)
-			if (data[n] != other.data[n])
-				return false;
-		return true;
+			diff |= data[n] ^ other.data[n];
+		return diff == 0;
 	}
 
 	bool operator !=(const value<Bits> &other) const {
@@ -548,11 +550,17 @@ struct value : public expr_base<value<Bits>> {
 		value<Bits> result;
 		bool carry = CarryIn;
 		for (size_t n = 0; n < result.chunks; n++) {
-			result.data[n] = data[n] + (Invert ? ~other.data[n] : other.data[n]) + carry;
-			if (result.chunks - 1 == n)
-				result.data[result.chunks - 1] &= result.msb_mask;
-			carry = (result.data[n] <  data[n]) ||
-			        (result.data[n] == data[n] && carry);
+			// Computing the carry from a double width sum keeps the carry chain free of branches and comparisons.
+			constexpr size_t msb_chunk_bits = Bits % chunk::bits != 0 ? Bits % chunk::bits : chunk::bits;
+			chunk::type mask = chunk::mask;
+			size_t bits = chunk::bits;
+			if (result.chunks - 1 == n) {
+				mask = msb_mask;
+				bits = msb_chunk_bits;
+			}
+			wide_chunk_t sum = wide_chunk_t(data[n]) + ((Invert ? ~other.data[n] : other.data[n]) & mask) + carry;
+			result.data[n] = chunk::type(sum) & mask;
+			carry = (sum >> bits) != 0;
 		}
 		return {result, carry};
 	}
@@ -569,18 +577,19 @@ struct value : public expr_base<value<Bits>> {
 		return value<Bits>().sub(*this);
 	}
 
+	// Comparisons start at the most significant chunk instead of computing a full difference, so that only
+	// the chunks up to the first difference are examined.
 	bool ucmp(const value<Bits> &other) const {
-		bool carry;
-		std::tie(std::ignore, carry) = alu</*Invert=*/true, /*CarryIn=*/true>(other);
-		return !carry; // a.ucmp(b) ≡ a u< b
+		for (size_t n = chunks; n-- > 0;)
+			if (data[n] != other.data[n])
+				return data[n] < other.data[n];
+		return false; // a.ucmp(b) ≡ a u< b
 	}
 
 	bool scmp(const value<Bits> &other) const {
-		value<Bits> result;
-		bool carry;
-		std::tie(result, carry) = alu</*Invert=*/true, /*CarryIn=*/true>(other);
-		bool overflow = (is_neg() == !other.is_neg()) && (is_neg() != result.is_neg());
-		return result.is_neg() ^ overflow; // a.scmp(b) ≡ a s< b
+		if (is_neg() != other.is_neg())
+			return is_neg();
+		return ucmp(other); // a.scmp(b) ≡ a s< b
 	}
 
 	template<size_t ResultBits>
@@ -820,10 +829,21 @@ std::ostream &operator<<(std::ostream &os, const wire<Bits> &val) {
 
 template<size_t Width>
 struct memory {
+	// The storage of a memory is usually owned by it, but may also be a part of a `state_arena`.
+	struct storage_deleter {
+		bool owned;
+
+		void operator()(value<Width> *ptr) const {
+			if (owned)
+				delete[] ptr;
+		}
+	};
+
 	const size_t depth;
-	std::unique_ptr<value<Width>[]> data;
+	std::unique_ptr<value<Width>[], storage_deleter> data;
 
-	explicit memory(size_t depth) : depth(depth), data(new value<Width>[depth]) {}
+	explicit memory(size_t depth) : depth(depth), data(new value<Width>[depth], storage_deleter { true }) {}
+	memory(size_t depth, value<Width> *storage) : depth(depth), data(storage, storage_deleter { false }) {}
 
 	memory(const memory<Width> &) = delete;
 	memory<Width> &operator=(const memory<Width> &) = delete;
@@ -1536,8 +1556,71 @@ struct debug_scopes {
 // and the constructor of interior modules that should not call it.
 struct interior {};
 
+// A single contiguous block of memory that holds all of the state of a design: wires, memories, and the state of
+// effectful cells. A design generated with the `-arena` option allocates its state here (rather than embedding it in
+// the module objects), which makes it possible to take and restore a snapshot of it with a single `memcpy()`.
+//
+// The state of black boxes is not a part of the arena. Snapshots must be taken and restored in between `commit()`
+// and `eval()`, when there are no pending memory writes.
+struct state_arena {
+	static constexpr size_t alignment = alignof(uint64_t);
+
+	const size_t size;
+
+	explicit state_arena(size_t size) : size(size), storage(new uint64_t[(size + alignment - 1) / alignment]()) {}
+
+	state_arena(const state_arena &) = delete;
+	state_arena &operator=(const state_arena &) = delete;
+
+	// The amount of space taken by `allocate<T>(count)`.
+	template<class T>
+	static constexpr size_t size_of(size_t count = 1) {
+		return (sizeof(T) * count + alignment - 1) / alignment * alignment;
+	}
+
+	// Internal CXXRTL use only.
+	template<class T>
+	T *allocate(size_t count = 1) {
+		static_assert(alignof(T) <= alignment, "object is overaligned");
+		static_assert(std::is_trivially_copyable<T>::value, "object cannot be snapshotted");
+		assert(used + size_of<T>(count) <= size);
+		T *ptr = reinterpret_cast<T*>(reinterpret_cast<char*>(storage.get()) + used);
+		for (size_t index = 0; index < count; index++)
+			new (&ptr[index]) T();
+		used += size_of<T>(count);
+		return ptr;
+	}
+
+	// Internal CXXRTL use only.
+	template<class T, size_t Count>
+	T (&allocate_array())[Count] {
+		return *reinterpret_cast<T(*)[Count]>(allocate<T>(Count));
+	}
+
+	void *data() {
+		return storage.get();
+	}
+
+	const void *data() const {
+		return storage.get();
+	}
+
+	void save(void *snapshot) const {
+		memcpy(snapshot, storage.get(), size);
+	}
+
+	void restore(const void *snapshot) {
+		memcpy(storage.get(), snapshot, size);
+	}
+
+private:
+	std::unique_ptr<uint64_t[]> storage;
+	size_t used = 0;
+};
+
 // The core API of the `module` class consists of only four virtual methods: `reset()`, `eval()`,
-// `commit`, and `debug_info()`. (The virtual destructor is made necessary by C++.) Every other method
+// `commit`, and `debug_info()`. (The virtual destructor is made necessary by C++, and `state()` only
+// returns something in designs generated with the `-arena` option.) Every other method
 // is a convenience method, and exists solely to simplify some common pattern for C++ API consumers.
 // No behavior may be added to such convenience methods that other parts of CXXRTL can rely on, since
 // there is no guarantee they will be called (and, for example, other CXXRTL libraries will often call
@@ -1580,6 +1663,11 @@ struct module {
 		(void)items, (void)scopes, (void)path, (void)cell_attrs;
 	}
 
+	// The arena with the state of the design, if it has one.
+	virtual state_arena *state() {
+		return nullptr;
+	}
+
 	// Compatibility method.
 #if __has_attribute(deprecated)
 	__attribute__((deprecated("Use `debug_info(&items, /*scopes=*/nullptr, path);` instead.")))
@@ -0,0 +1,627 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2023  Catherine <whitequark@whitequark.org>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// This file is included by the designs generated with `write_cxxrtl -lanes <n>`. It is not used in any other designs.
+
+#ifndef CXXRTL_BATCH_H
+#define CXXRTL_BATCH_H
+
+#include <cstdint>
+
+#include <cxxrtl/cxxrtl.h>
+
+namespace cxxrtl {
+
+// A set of lanes, with lane `n` corresponding to bit `n`.
+typedef uint64_t lane_mask;
+
+template<size_t Lanes>
+constexpr lane_mask all_lanes() {
+	return Lanes == 64 ? ~lane_mask(0) : (lane_mask(1) << Lanes) - 1;
+}
+
+// A batch of `Lanes` independent values of the same width, one per simulated instance of a design. The storage is
+// chunk-major and lane-minor: `data[n][lane]` is the chunk `n` of the value in `lane`, so that every operation is
+// a loop over chunks whose body is a loop over lanes that performs the same operation on contiguous memory, which
+// the compiler can vectorize. The invariants are the same as for `value<Bits>`; in particular, the bits above
+// `Bits` in the most significant chunk of every lane are always zero.
+//
+// Operations that are a lane-wise combination of chunks (bitwise operations, additions, comparisons, extensions,
+// slices and concatenations) are implemented here directly; other operations (multiplications, divisions, and
+// shifts by a variable amount) are performed one lane at a time using the operations of `value<Bits>`.
+template<size_t Bits, size_t Lanes>
+struct value_lanes {
+	static_assert(Lanes > 0 && Lanes <= 64, "the number of lanes must be between 1 and 64");
+
+	static constexpr size_t bits = Bits;
+	static constexpr size_t lanes = Lanes;
+
+	using chunk = chunk_traits<chunk_t>;
+	static constexpr chunk::type msb_mask = value<Bits>::msb_mask;
+
+	static constexpr size_t chunks = value<Bits>::chunks;
+	chunk::type data[chunks][Lanes] = {};
+
+	value_lanes() = default;
+
+	// Replicates `other` to every lane, which is how constants are represented.
+	explicit value_lanes(const value<Bits> &other) {
+		for (size_t n = 0; n < chunks; n++)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				data[n][lane] = other.data[n];
+	}
+
+	value_lanes(const value_lanes<Bits, Lanes> &) = default;
+	value_lanes<Bits, Lanes> &operator=(const value_lanes<Bits, Lanes> &) = default;
+
+	// A (no-op) helper that mirrors `value<Bits>::val()`.
+	CXXRTL_ALWAYS_INLINE
+	const value_lanes<Bits, Lanes> &val() const {
+		return *this;
+	}
+
+	// Access to the value of a single lane.
+	value<Bits> get(size_t lane) const {
+		value<Bits> result;
+		for (size_t n = 0; n < chunks; n++)
+			result.data[n] = data[n][lane];
+		return result;
+	}
+
+	void set(size_t lane, const value<Bits> &other) {
+		for (size_t n = 0; n < chunks; n++)
+			data[n][lane] = other.data[n];
+	}
+
+	template<class IntegerT>
+	CXXRTL_ALWAYS_INLINE
+	IntegerT get(size_t lane) const {
+		return get(lane).template get<IntegerT>();
+	}
+
+	template<class IntegerT>
+	CXXRTL_ALWAYS_INLINE
+	void set(size_t lane, IntegerT other) {
+		value<Bits> lane_value;
+		lane_value.template set<IntegerT>(other);
+		set(lane, lane_value);
+	}
+
+	// Extensions and truncations.
+	template<size_t NewBits>
+	value_lanes<NewBits, Lanes> zcast() const {
+		value_lanes<NewBits, Lanes> result;
+		for (size_t n = 0; n < result.chunks && n < chunks; n++)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				result.data[n][lane] = data[n][lane];
+		result.clear_msb();
+		return result;
+	}
+
+	template<size_t NewBits>
+	value_lanes<NewBits, Lanes> scast() const {
+		value_lanes<NewBits, Lanes> result = zcast<NewBits>();
+		if (NewBits > Bits && Bits > 0) {
+			constexpr size_t sign_chunk = Bits == 0 ? 0 : (Bits - 1) / chunk::bits;
+			constexpr size_t sign_bit   = Bits == 0 ? 0 : (Bits - 1) % chunk::bits;
+			for (size_t lane = 0; lane < Lanes; lane++) {
+				chunk::type fill = chunk::type(0) - ((data[sign_chunk][lane] >> sign_bit) & 1);
+				result.data[sign_chunk][lane] |= fill & ~msb_mask;
+				for (size_t n = sign_chunk + 1; n < result.chunks; n++)
+					result.data[n][lane] = fill;
+			}
+			result.clear_msb();
+		}
+		return result;
+	}
+
+	// Slices, concatenations, and partial writes, with the same arguments as `value<Bits>::slice()`,
+	// `value<Bits>::concat()` and `value<Bits>::blit()`.
+	template<size_t Stop, size_t Start>
+	value_lanes<Stop - Start + 1, Lanes> slice() const {
+		static_assert(Stop >= Start && Stop < Bits, "slice() must be within the value");
+		constexpr size_t shift_chunks = Start / chunk::bits;
+		constexpr size_t shift_bits   = Start % chunk::bits;
+		value_lanes<Stop - Start + 1, Lanes> result;
+		for (size_t n = 0; n < result.chunks; n++) {
+			bool has_carry = shift_chunks + n + 1 < chunks;
+			for (size_t lane = 0; lane < Lanes; lane++) {
+				chunk::type carry = 0;
+				if (has_carry)
+					carry = (shift_bits == 0) ? 0 : data[shift_chunks + n + 1][lane] << (chunk::bits - shift_bits);
+				result.data[n][lane] = (data[shift_chunks + n][lane] >> shift_bits) | carry;
+			}
+		}
+		result.clear_msb();
+		return result;
+	}
+
+	template<size_t Stop, size_t Start>
+	value_lanes<Bits, Lanes> blit(const value_lanes<Stop - Start + 1, Lanes> &source) const {
+		static_assert(Stop >= Start && Stop < Bits, "blit() must be within the value");
+		constexpr size_t shift_chunks = Start / chunk::bits;
+		constexpr size_t shift_bits   = Start % chunk::bits;
+		value_lanes<Bits, Lanes> result;
+		for (size_t n = 0; n < chunks; n++) {
+			size_t chunk_start = n * chunk::bits, chunk_stop = chunk_start + chunk::bits - 1;
+			chunk::type field = 0;
+			if (Start <= chunk_stop && Stop >= chunk_start) {
+				size_t field_start = (Start > chunk_start ? Start : chunk_start) - chunk_start;
+				size_t field_stop  = (Stop < chunk_stop ? Stop : chunk_stop) - chunk_start;
+				field = (chunk::mask >> (chunk::bits - 1 - field_stop)) & (chunk::mask << field_start);
+			}
+			bool has_source = n >= shift_chunks && n - shift_chunks < source.chunks;
+			bool has_carry = n >= shift_chunks + 1 && n - shift_chunks - 1 < source.chunks;
+			for (size_t lane = 0; lane < Lanes; lane++) {
+				chunk::type shifted = 0;
+				if (has_source)
+					shifted |= source.data[n - shift_chunks][lane] << shift_bits;
+				if (has_carry)
+					shifted |= (shift_bits == 0) ? 0
+						: source.data[n - shift_chunks - 1][lane] >> (chunk::bits - shift_bits);
+				result.data[n][lane] = (data[n][lane] & ~field) | (shifted & field);
+			}
+		}
+		return result;
+	}
+
+	template<size_t LowBits>
+	value_lanes<Bits + LowBits, Lanes> concat(const value_lanes<LowBits, Lanes> &low) const {
+		return low.template zcast<Bits + LowBits>().template blit<Bits + LowBits - 1, LowBits>(*this);
+	}
+
+	// Bitwise operations.
+	value_lanes<Bits, Lanes> bit_not() const {
+		value_lanes<Bits, Lanes> result;
+		for (size_t n = 0; n < chunks; n++)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				result.data[n][lane] = ~data[n][lane];
+		result.clear_msb();
+		return result;
+	}
+
+	value_lanes<Bits, Lanes> bit_and(const value_lanes<Bits, Lanes> &other) const {
+		value_lanes<Bits, Lanes> result;
+		for (size_t n = 0; n < chunks; n++)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				result.data[n][lane] = data[n][lane] & other.data[n][lane];
+		return result;
+	}
+
+	value_lanes<Bits, Lanes> bit_or(const value_lanes<Bits, Lanes> &other) const {
+		value_lanes<Bits, Lanes> result;
+		for (size_t n = 0; n < chunks; n++)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				result.data[n][lane] = data[n][lane] | other.data[n][lane];
+		return result;
+	}
+
+	value_lanes<Bits, Lanes> bit_xor(const value_lanes<Bits, Lanes> &other) const {
+		value_lanes<Bits, Lanes> result;
+		for (size_t n = 0; n < chunks; n++)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				result.data[n][lane] = data[n][lane] ^ other.data[n][lane];
+		return result;
+	}
+
+	// Arithmetic operations. The carry of every lane is propagated separately.
+	template<bool Invert, bool CarryIn>
+	value_lanes<Bits, Lanes> alu(const value_lanes<Bits, Lanes> &other) const {
+		value_lanes<Bits, Lanes> result;
+		chunk::type carry[Lanes];
+		for (size_t lane = 0; lane < Lanes; lane++)
+			carry[lane] = CarryIn;
+		for (size_t n = 0; n < chunks; n++) {
+			chunk::type mask = (n == chunks - 1) ? msb_mask : chunk::mask;
+			for (size_t lane = 0; lane < Lanes; lane++) {
+				wide_chunk_t sum = wide_chunk_t(data[n][lane]) +
+					((Invert ? ~other.data[n][lane] : other.data[n][lane]) & mask) + carry[lane];
+				result.data[n][lane] = chunk::type(sum) & mask;
+				carry[lane] = chunk::type(sum >> chunk::bits);
+			}
+		}
+		return result;
+	}
+
+	value_lanes<Bits, Lanes> add(const value_lanes<Bits, Lanes> &other) const {
+		return alu</*Invert=*/false, /*CarryIn=*/false>(other);
+	}
+
+	value_lanes<Bits, Lanes> sub(const value_lanes<Bits, Lanes> &other) const {
+		return alu</*Invert=*/true, /*CarryIn=*/true>(other);
+	}
+
+	value_lanes<Bits, Lanes> neg() const {
+		return value_lanes<Bits, Lanes>().sub(*this);
+	}
+
+	// Reductions and comparisons, which produce a 1-bit value in every lane. Unlike the ones of `value<Bits>`,
+	// these have no early exit, since the lanes would diverge.
+	value_lanes<1, Lanes> is_nonzero() const {
+		chunk::type bits[Lanes] = {};
+		for (size_t n = 0; n < chunks; n++)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				bits[lane] |= data[n][lane];
+		value_lanes<1, Lanes> result;
+		for (size_t lane = 0; lane < Lanes; lane++)
+			result.data[0][lane] = bits[lane] != 0;
+		return result;
+	}
+
+	value_lanes<1, Lanes> is_neg() const {
+		constexpr size_t sign_chunk = Bits == 0 ? 0 : (Bits - 1) / chunk::bits;
+		constexpr size_t sign_bit   = Bits == 0 ? 0 : (Bits - 1) % chunk::bits;
+		value_lanes<1, Lanes> result;
+		if (Bits > 0)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				result.data[0][lane] = (data[sign_chunk][lane] >> sign_bit) & 1;
+		return result;
+	}
+
+	value_lanes<1, Lanes> eq(const value_lanes<Bits, Lanes> &other) const {
+		return bit_xor(other).is_nonzero().bit_not();
+	}
+
+	value_lanes<1, Lanes> ucmp(const value_lanes<Bits, Lanes> &other) const {
+		chunk::type less[Lanes] = {}, decided[Lanes] = {};
+		for (size_t n = chunks; n-- > 0;) {
+			for (size_t lane = 0; lane < Lanes; lane++) {
+				less[lane] |= ~decided[lane] & (data[n][lane] < other.data[n][lane]);
+				decided[lane] |= data[n][lane] != other.data[n][lane];
+			}
+		}
+		value_lanes<1, Lanes> result;
+		for (size_t lane = 0; lane < Lanes; lane++)
+			result.data[0][lane] = less[lane] & 1;
+		return result; // a.ucmp(b) ≡ a u< b
+	}
+
+	value_lanes<1, Lanes> scmp(const value_lanes<Bits, Lanes> &other) const {
+		value_lanes<1, Lanes> sign = is_neg(), other_sign = other.is_neg(), unsigned_less = ucmp(other);
+		value_lanes<1, Lanes> result;
+		for (size_t lane = 0; lane < Lanes; lane++)
+			result.data[0][lane] = (sign.data[0][lane] != other_sign.data[0][lane])
+				? sign.data[0][lane] : unsigned_less.data[0][lane];
+		return result; // a.scmp(b) ≡ a s< b
+	}
+
+	void clear_msb() {
+		if (chunks > 0)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				data[chunks - 1][lane] &= msb_mask;
+	}
+};
+
+template<size_t Bits, size_t Lanes>
+constexpr size_t value_lanes<Bits, Lanes>::bits;
+
+template<size_t Bits, size_t Lanes>
+constexpr size_t value_lanes<Bits, Lanes>::lanes;
+
+template<size_t Bits, size_t Lanes>
+constexpr chunk_t value_lanes<Bits, Lanes>::msb_mask;
+
+template<size_t Bits, size_t Lanes>
+constexpr size_t value_lanes<Bits, Lanes>::chunks;
+
+// Returns `if_one` in the lanes where `sel` is 1, and `if_zero` in the other lanes; the equivalent of the `?:`
+// operator used for `value<Bits>`.
+template<size_t Bits, size_t Lanes>
+value_lanes<Bits, Lanes> blend(const value_lanes<1, Lanes> &sel,
+                               const value_lanes<Bits, Lanes> &if_one, const value_lanes<Bits, Lanes> &if_zero) {
+	value_lanes<Bits, Lanes> result;
+	for (size_t n = 0; n < result.chunks; n++)
+		for (size_t lane = 0; lane < Lanes; lane++) {
+			chunk_t mask = chunk_t(0) - sel.data[0][lane];
+			result.data[n][lane] = (if_one.data[n][lane] & mask) | (if_zero.data[n][lane] & ~mask);
+		}
+	return result;
+}
+
+// Converts a lane mask to a 1-bit value in every lane, and back.
+template<size_t Lanes>
+value_lanes<1, Lanes> lanes_of(lane_mask mask) {
+	value_lanes<1, Lanes> result;
+	for (size_t lane = 0; lane < Lanes; lane++)
+		result.data[0][lane] = (mask >> lane) & 1;
+	return result;
+}
+
+template<size_t Lanes>
+lane_mask mask_of(const value_lanes<1, Lanes> &lanes) {
+	lane_mask result = 0;
+	for (size_t lane = 0; lane < Lanes; lane++)
+		result |= lane_mask(lanes.data[0][lane]) << lane;
+	return result;
+}
+
+// The lane-major counterpart of `wire<Bits>`, with `curr` and `next` states. It is not copyable, for the same reason
+// as `wire<Bits>` is not.
+template<size_t Bits, size_t Lanes>
+struct wire_lanes {
+	static constexpr size_t bits = Bits;
+	static constexpr size_t lanes = Lanes;
+
+	value_lanes<Bits, Lanes> curr;
+	value_lanes<Bits, Lanes> next;
+
+	wire_lanes() = default;
+	explicit wire_lanes(const value<Bits> &init) : curr(init), next(init) {}
+
+	wire_lanes(const wire_lanes<Bits, Lanes> &) = delete;
+	wire_lanes<Bits, Lanes> &operator=(const wire_lanes<Bits, Lanes> &) = delete;
+
+	wire_lanes(wire_lanes<Bits, Lanes> &&) = default;
+	wire_lanes<Bits, Lanes> &operator=(wire_lanes<Bits, Lanes> &&) = default;
+
+	template<class IntegerT>
+	CXXRTL_ALWAYS_INLINE
+	IntegerT get(size_t lane) const {
+		return curr.template get<IntegerT>(lane);
+	}
+
+	template<class IntegerT>
+	CXXRTL_ALWAYS_INLINE
+	void set(size_t lane, IntegerT other) {
+		next.template set<IntegerT>(lane, other);
+	}
+
+	// Clock edges of a single bit, detected in every lane.
+	template<size_t Bit>
+	value_lanes<1, Lanes> posedge() const {
+		return curr.template slice<Bit, Bit>().bit_not().bit_and(next.template slice<Bit, Bit>());
+	}
+
+	template<size_t Bit>
+	value_lanes<1, Lanes> negedge() const {
+		return curr.template slice<Bit, Bit>().bit_and(next.template slice<Bit, Bit>().bit_not());
+	}
+
+	// Copies `next` to `curr` in the lanes of `mask`, and returns the mask of the lanes where they differed. The
+	// lanes outside of `mask` keep their pending `next` state until they are committed.
+	lane_mask commit(lane_mask mask) {
+		chunk_t diff[Lanes] = {}, keep[Lanes];
+		for (size_t lane = 0; lane < Lanes; lane++)
+			keep[lane] = chunk_t(0) - chunk_t((mask >> lane) & 1);
+		for (size_t n = 0; n < curr.chunks; n++)
+			for (size_t lane = 0; lane < Lanes; lane++) {
+				diff[lane] |= (curr.data[n][lane] ^ next.data[n][lane]) & keep[lane];
+				curr.data[n][lane] = (next.data[n][lane] & keep[lane]) | (curr.data[n][lane] & ~keep[lane]);
+			}
+		lane_mask changed = 0;
+		for (size_t lane = 0; lane < Lanes; lane++)
+			changed |= lane_mask(diff[lane] != 0) << lane;
+		return changed;
+	}
+};
+
+template<size_t Bits, size_t Lanes>
+constexpr size_t wire_lanes<Bits, Lanes>::bits;
+
+template<size_t Bits, size_t Lanes>
+constexpr size_t wire_lanes<Bits, Lanes>::lanes;
+
+} // namespace cxxrtl
+
+// Lane-major definitions of internal Yosys cells, with the same names and template arguments as the ones in
+// <cxxrtl/cxxrtl.h>, so that the generated code is the same regardless of the layout.
+namespace cxxrtl_yosys {
+
+using namespace cxxrtl;
+
+// Cells without a lane-major implementation are evaluated one lane at a time.
+#define CXXRTL_LANEWISE_UNARY(name) \
+	template<size_t BitsY, size_t BitsA, size_t Lanes> \
+	value_lanes<BitsY, Lanes> name(const value_lanes<BitsA, Lanes> &a) { \
+		value_lanes<BitsY, Lanes> result; \
+		for (size_t lane = 0; lane < Lanes; lane++) \
+			result.set(lane, name<BitsY>(a.get(lane))); \
+		return result; \
+	}
+
+#define CXXRTL_LANEWISE_BINARY(name) \
+	template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes> \
+	value_lanes<BitsY, Lanes> name(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) { \
+		value_lanes<BitsY, Lanes> result; \
+		for (size_t lane = 0; lane < Lanes; lane++) \
+			result.set(lane, name<BitsY>(a.get(lane), b.get(lane))); \
+		return result; \
+	}
+
+// Logic operations
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> logic_not(const value_lanes<BitsA, Lanes> &a) {
+	return a.is_nonzero().bit_not().template zcast<BitsY>();
+}
+
+template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes>
+value_lanes<BitsY, Lanes> logic_and(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) {
+	return a.is_nonzero().bit_and(b.is_nonzero()).template zcast<BitsY>();
+}
+
+template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes>
+value_lanes<BitsY, Lanes> logic_or(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) {
+	return a.is_nonzero().bit_or(b.is_nonzero()).template zcast<BitsY>();
+}
+
+// Reduction operations
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> reduce_and(const value_lanes<BitsA, Lanes> &a) {
+	return a.bit_not().is_nonzero().bit_not().template zcast<BitsY>();
+}
+
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> reduce_or(const value_lanes<BitsA, Lanes> &a) {
+	return a.is_nonzero().template zcast<BitsY>();
+}
+
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> reduce_bool(const value_lanes<BitsA, Lanes> &a) {
+	return a.is_nonzero().template zcast<BitsY>();
+}
+
+CXXRTL_LANEWISE_UNARY(reduce_xor)
+CXXRTL_LANEWISE_UNARY(reduce_xnor)
+
+// Bitwise operations
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> not_u(const value_lanes<BitsA, Lanes> &a) {
+	return a.template zcast<BitsY>().bit_not();
+}
+
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> not_s(const value_lanes<BitsA, Lanes> &a) {
+	return a.template scast<BitsY>().bit_not();
+}
+
+#define CXXRTL_LANES_BITWISE(name, op, invert) \
+	template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes> \
+	value_lanes<BitsY, Lanes> name##_uu(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) { \
+		value_lanes<BitsY, Lanes> result = a.template zcast<BitsY>().op(b.template zcast<BitsY>()); \
+		return invert ? result.bit_not() : result; \
+	} \
+	template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes> \
+	value_lanes<BitsY, Lanes> name##_ss(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) { \
+		value_lanes<BitsY, Lanes> result = a.template scast<BitsY>().op(b.template scast<BitsY>()); \
+		return invert ? result.bit_not() : result; \
+	}
+
+CXXRTL_LANES_BITWISE(and,  bit_and, false)
+CXXRTL_LANES_BITWISE(or,   bit_or,  false)
+CXXRTL_LANES_BITWISE(xor,  bit_xor, false)
+CXXRTL_LANES_BITWISE(xnor, bit_xor, true)
+
+// Shift operations
+CXXRTL_LANEWISE_BINARY(shl_uu)
+CXXRTL_LANEWISE_BINARY(shl_su)
+CXXRTL_LANEWISE_BINARY(sshl_uu)
+CXXRTL_LANEWISE_BINARY(sshl_su)
+CXXRTL_LANEWISE_BINARY(shr_uu)
+CXXRTL_LANEWISE_BINARY(shr_su)
+CXXRTL_LANEWISE_BINARY(sshr_uu)
+CXXRTL_LANEWISE_BINARY(sshr_su)
+CXXRTL_LANEWISE_BINARY(shift_uu)
+CXXRTL_LANEWISE_BINARY(shift_su)
+CXXRTL_LANEWISE_BINARY(shift_us)
+CXXRTL_LANEWISE_BINARY(shift_ss)
+CXXRTL_LANEWISE_BINARY(shiftx_uu)
+CXXRTL_LANEWISE_BINARY(shiftx_su)
+CXXRTL_LANEWISE_BINARY(shiftx_us)
+CXXRTL_LANEWISE_BINARY(shiftx_ss)
+
+// Comparison operations
+#define CXXRTL_LANES_COMPARE(name, expr) \
+	template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes> \
+	value_lanes<BitsY, Lanes> name##_uu(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) { \
+		constexpr size_t BitsExt = max(BitsA, BitsB); \
+		value_lanes<BitsExt, Lanes> x = a.template zcast<BitsExt>(), y = b.template zcast<BitsExt>(); \
+		return (expr).template zcast<BitsY>(); \
+	} \
+	template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes> \
+	value_lanes<BitsY, Lanes> name##_ss(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) { \
+		constexpr size_t BitsExt = max(BitsA, BitsB); \
+		value_lanes<BitsExt, Lanes> x = a.template scast<BitsExt>(), y = b.template scast<BitsExt>(); \
+		return (expr).template zcast<BitsY>(); \
+	}
+
+CXXRTL_LANES_COMPARE(eq,  x.eq(y))
+CXXRTL_LANES_COMPARE(ne,  x.eq(y).bit_not())
+CXXRTL_LANES_COMPARE(eqx, x.eq(y))
+CXXRTL_LANES_COMPARE(nex, x.eq(y).bit_not())
+
+// The signedness of the comparison is the same as the one of the extension.
+#define CXXRTL_LANES_ORDER(name, expr_u, expr_s) \
+	template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes> \
+	value_lanes<BitsY, Lanes> name##_uu(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) { \
+		constexpr size_t BitsExt = max(BitsA, BitsB); \
+		value_lanes<BitsExt, Lanes> x = a.template zcast<BitsExt>(), y = b.template zcast<BitsExt>(); \
+		return (expr_u).template zcast<BitsY>(); \
+	} \
+	template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes> \
+	value_lanes<BitsY, Lanes> name##_ss(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) { \
+		constexpr size_t BitsExt = max(BitsA, BitsB); \
+		value_lanes<BitsExt, Lanes> x = a.template scast<BitsExt>(), y = b.template scast<BitsExt>(); \
+		return (expr_s).template zcast<BitsY>(); \
+	}
+
+CXXRTL_LANES_ORDER(gt, y.ucmp(x),           y.scmp(x))
+CXXRTL_LANES_ORDER(ge, x.ucmp(y).bit_not(), x.scmp(y).bit_not())
+CXXRTL_LANES_ORDER(lt, x.ucmp(y),           x.scmp(y))
+CXXRTL_LANES_ORDER(le, y.ucmp(x).bit_not(), y.scmp(x).bit_not())
+
+// Arithmetic operations
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> pos_u(const value_lanes<BitsA, Lanes> &a) {
+	return a.template zcast<BitsY>();
+}
+
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> pos_s(const value_lanes<BitsA, Lanes> &a) {
+	return a.template scast<BitsY>();
+}
+
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> neg_u(const value_lanes<BitsA, Lanes> &a) {
+	return a.template zcast<BitsY>().neg();
+}
+
+template<size_t BitsY, size_t BitsA, size_t Lanes>
+value_lanes<BitsY, Lanes> neg_s(const value_lanes<BitsA, Lanes> &a) {
+	return a.template scast<BitsY>().neg();
+}
+
+template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes>
+value_lanes<BitsY, Lanes> add_uu(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) {
+	return a.template zcast<BitsY>().add(b.template zcast<BitsY>());
+}
+
+template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes>
+value_lanes<BitsY, Lanes> add_ss(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) {
+	return a.template scast<BitsY>().add(b.template scast<BitsY>());
+}
+
+template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes>
+value_lanes<BitsY, Lanes> sub_uu(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) {
+	return a.template zcast<BitsY>().sub(b.template zcast<BitsY>());
+}
+
+template<size_t BitsY, size_t BitsA, size_t BitsB, size_t Lanes>
+value_lanes<BitsY, Lanes> sub_ss(const value_lanes<BitsA, Lanes> &a, const value_lanes<BitsB, Lanes> &b) {
+	return a.template scast<BitsY>().sub(b.template scast<BitsY>());
+}
+
+CXXRTL_LANEWISE_BINARY(mul_uu)
+CXXRTL_LANEWISE_BINARY(mul_ss)
+CXXRTL_LANEWISE_BINARY(div_uu)
+CXXRTL_LANEWISE_BINARY(div_ss)
+CXXRTL_LANEWISE_BINARY(mod_uu)
+CXXRTL_LANEWISE_BINARY(mod_ss)
+CXXRTL_LANEWISE_BINARY(modfloor_uu)
+CXXRTL_LANEWISE_BINARY(modfloor_ss)
+CXXRTL_LANEWISE_BINARY(divfloor_uu)
+CXXRTL_LANEWISE_BINARY(divfloor_ss)
+
+#undef CXXRTL_LANEWISE_UNARY
+#undef CXXRTL_LANEWISE_BINARY
+#undef CXXRTL_LANES_BITWISE
+#undef CXXRTL_LANES_COMPARE
+#undef CXXRTL_LANES_ORDER
+
+} // namespace cxxrtl_yosys
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2023  Catherine <whitequark@whitequark.org>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef CXXRTL_FST_H
+#define CXXRTL_FST_H
+
+// This header requires the FST writer library, which is included with Yosys in `libs/fst`. To use it, add that
+// directory to the include path, and compile and link `fstapi.cc`, `fastlz.cc`, and `lz4.cc` from it together with
+// zlib. The parallel writer additionally requires compiling `fstapi.cc` with `-DFST_WRITER_PARALLEL` and pthreads.
+#include <fstapi.h>
+
+#include <cxxrtl/cxxrtl.h>
+
+namespace cxxrtl {
+
+// A waveform writer with the same interface as `vcd_writer`, except that it writes a file directly instead of
+// accumulating text in a buffer. Values are passed to the FST library in their native chunk representation, which
+// avoids formatting them as text, and the FST library compresses the value changes, optionally on a separate thread.
+class fst_writer {
+	struct variable {
+		fstHandle handle;
+		size_t width;
+		chunk_t *curr;
+		size_t cache_offset;
+		debug_outline *outline;
+		bool *outline_warm;
+	};
+
+	void *context;
+	std::vector<std::string> current_scope;
+	std::map<debug_outline*, bool> outlines;
+	std::vector<variable> variables;
+	std::vector<chunk_t> cache;
+	std::map<chunk_t*, size_t> aliases;
+	bool streaming = false;
+
+	void emit_scope(const std::vector<std::string> &scope) {
+		assert(!streaming);
+		size_t same_scope_count = 0;
+		while ((same_scope_count < current_scope.size()) &&
+			   (same_scope_count < scope.size()) &&
+			   (current_scope[same_scope_count] == scope[same_scope_count])) {
+			same_scope_count++;
+		}
+		while (current_scope.size() > same_scope_count) {
+			fstWriterSetUpscope(context);
+			current_scope.pop_back();
+		}
+		while (current_scope.size() < scope.size()) {
+			fstWriterSetScope(context, FST_ST_VCD_MODULE, scope[current_scope.size()].c_str(), nullptr);
+			current_scope.push_back(scope[current_scope.size()]);
+		}
+	}
+
+	void emit_var(size_t width, chunk_t *curr, bool constant, debug_outline *outline, enum fstVarType type,
+	              uint32_t flags, const std::string &name, size_t lsb_at, bool multipart) {
+		assert(!streaming);
+		// FST has no representation for zero-width variables.
+		if (width == 0)
+			return;
+
+		std::string full_name = name;
+		if (multipart || name.back() == ']' || lsb_at != 0) {
+			if (width == 1)
+				full_name += " [" + std::to_string(lsb_at) + "]";
+			else
+				full_name += " [" + std::to_string(lsb_at + width - 1) + ":" + std::to_string(lsb_at) + "]";
+		}
+
+		enum fstVarDir direction = FST_VD_IMPLICIT;
+		if ((flags & debug_item::INOUT) == debug_item::INOUT)
+			direction = FST_VD_INOUT;
+		else if (flags & debug_item::INPUT)
+			direction = FST_VD_INPUT;
+		else if (flags & debug_item::OUTPUT)
+			direction = FST_VD_OUTPUT;
+
+		// Items that share storage are added as aliases of the first such item, which the FST library stores once.
+		auto alias_it = aliases.find(curr);
+		if (alias_it != aliases.end()) {
+			fstWriterCreateVar(context, type, direction, width, full_name.c_str(), variables[alias_it->second].handle);
+			return;
+		}
+
+		auto outline_it = outlines.emplace(outline, /*warm=*/(outline == nullptr)).first;
+		const size_t chunks = (width + (sizeof(chunk_t) * 8 - 1)) / (sizeof(chunk_t) * 8);
+		variable var;
+		var.handle = fstWriterCreateVar(context, type, direction, width, full_name.c_str(), 0);
+		var.width = width;
+		var.curr = curr;
+		var.cache_offset = constant ? (size_t)-1 : cache.size();
+		var.outline = outline_it->first;
+		var.outline_warm = &outline_it->second;
+		if (!constant)
+			cache.insert(cache.end(), &curr[0], &curr[chunks]);
+		aliases[curr] = variables.size();
+		variables.push_back(var);
+	}
+
+	void emit_value(const variable &var) {
+		static_assert(sizeof(chunk_t) == sizeof(uint32_t), "a chunk is expected to be 32-bit");
+		if (var.width <= 32)
+			fstWriterEmitValueChange32(context, var.handle, var.width, var.curr[0]);
+		else
+			fstWriterEmitValueChangeVec32(context, var.handle, var.width, var.curr);
+	}
+
+	void reset_outlines() {
+		for (auto &outline_it : outlines)
+			outline_it.second = /*warm=*/(outline_it.first == nullptr);
+	}
+
+	bool test_variable(const variable &var) {
+		if (var.cache_offset == (size_t)-1)
+			return false; // constant
+		if (!*var.outline_warm) {
+			var.outline->eval();
+			*var.outline_warm = true;
+		}
+		const size_t chunks = (var.width + (sizeof(chunk_t) * 8 - 1)) / (sizeof(chunk_t) * 8);
+		if (std::equal(&var.curr[0], &var.curr[chunks], &cache[var.cache_offset])) {
+			return false;
+		} else {
+			std::copy(&var.curr[0], &var.curr[chunks], &cache[var.cache_offset]);
+			return true;
+		}
+	}
+
+	static std::vector<std::string> split_hierarchy(const std::string &hier_name) {
+		std::vector<std::string> hierarchy;
+		size_t prev = 0;
+		while (true) {
+			size_t curr = hier_name.find_first_of(' ', prev);
+			if (curr == std::string::npos) {
+				hierarchy.push_back(hier_name.substr(prev));
+				break;
+			} else {
+				hierarchy.push_back(hier_name.substr(prev, curr - prev));
+				prev = curr + 1;
+			}
+		}
+		return hierarchy;
+	}
+
+public:
+	// Creates a writer for `filename`. If `parallel` is true, the FST library compresses and writes value changes
+	// on a separate thread; the FST library exits if it was built without support for that.
+	fst_writer(const std::string &filename, bool parallel = false)
+			: context(fstWriterCreate(filename.c_str(), /*use_compressed_hier=*/1)) {
+		assert(context != nullptr);
+		fstWriterSetPackType(context, FST_WR_PT_LZ4);
+		if (parallel)
+			fstWriterSetParallelMode(context, 1);
+	}
+
+	fst_writer(const fst_writer &) = delete;
+	fst_writer &operator=(const fst_writer &) = delete;
+
+	~fst_writer() {
+		fstWriterClose(context);
+	}
+
+	void timescale(unsigned number, const std::string &unit) {
+		assert(!streaming);
+		assert(number == 1 || number == 10 || number == 100);
+		assert(unit == "s" || unit == "ms" || unit == "us" ||
+		       unit == "ns" || unit == "ps" || unit == "fs");
+		fstWriterSetTimescaleFromString(context, (std::to_string(number) + unit).c_str());
+	}
+
+	void add(const std::string &hier_name, const debug_item &item, bool multipart = false) {
+		std::vector<std::string> scope = split_hierarchy(hier_name);
+		std::string name = scope.back();
+		scope.pop_back();
+
+		emit_scope(scope);
+		switch (item.type) {
+			// Not the best naming but oh well...
+			case debug_item::VALUE:
+				emit_var(item.width, item.curr, /*constant=*/item.next == nullptr, nullptr,
+				         FST_VT_VCD_WIRE, item.flags, name, item.lsb_at, multipart);
+				break;
+			case debug_item::WIRE:
+				emit_var(item.width, item.curr, /*constant=*/false, nullptr,
+				         FST_VT_VCD_REG, item.flags, name, item.lsb_at, multipart);
+				break;
+			case debug_item::MEMORY: {
+				const size_t stride = (item.width + (sizeof(chunk_t) * 8 - 1)) / (sizeof(chunk_t) * 8);
+				for (size_t index = 0; index < item.depth; index++) {
+					chunk_t *nth_curr = &item.curr[stride * index];
+					std::string nth_name = name + '[' + std::to_string(index) + ']';
+					emit_var(item.width, nth_curr, /*constant=*/false, nullptr,
+					         FST_VT_VCD_REG, item.flags, nth_name, item.lsb_at, multipart);
+				}
+				break;
+			}
+			case debug_item::ALIAS:
+				// See the comment in `vcd_writer::add()`.
+				emit_var(item.width, item.curr, /*constant=*/false, nullptr,
+				         FST_VT_VCD_WIRE, item.flags, name, item.lsb_at, multipart);
+				break;
+			case debug_item::OUTLINE:
+				emit_var(item.width, item.curr, /*constant=*/false, item.outline,
+				         FST_VT_VCD_WIRE, item.flags, name, item.lsb_at, multipart);
+				break;
+		}
+	}
+
+	template<class Filter>
+	void add(const debug_items &items, const Filter &filter) {
+		// `debug_items` is a map, so the items are already sorted in an order optimal for emitting scopes.
+		for (auto &it : items.table)
+			for (auto &part : it.second)
+				if (filter(it.first, part))
+					add(it.first, part, it.second.size() > 1);
+	}
+
+	void add(const debug_items &items) {
+		this->add(items, [](const std::string &, const debug_item &) {
+			return true;
+		});
+	}
+
+	void add_without_memories(const debug_items &items) {
+		this->add(items, [](const std::string &, const debug_item &item) {
+			return item.type != debug_item::MEMORY;
+		});
+	}
+
+	void sample(uint64_t timestamp) {
+		bool first_sample = !streaming;
+		if (first_sample) {
+			emit_scope({});
+			streaming = true;
+		}
+		reset_outlines();
+		fstWriterEmitTimeChange(context, timestamp);
+		for (auto &var : variables)
+			if (test_variable(var) || first_sample)
+				emit_value(var);
+	}
+
+	// Writes the value changes accumulated so far to the file, e.g. to make them visible to a waveform viewer.
+	void flush() {
+		fstWriterFlushContext(context);
+	}
+};
+
+}
+
+#endif
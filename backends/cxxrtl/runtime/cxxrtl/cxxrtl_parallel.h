@@ -0,0 +1,179 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2023  Catherine <whitequark@whitequark.org>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// This file is included by designs generated with `write_cxxrtl -parallel <n>`.
+
+#ifndef CXXRTL_PARALLEL_H
+#define CXXRTL_PARALLEL_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <cxxrtl/cxxrtl.h>
+
+namespace cxxrtl {
+
+// A pool of worker threads that evaluates the partitions of a module's `eval()` concurrently. The partitions of
+// a module share no state that is written during evaluation, so they can run in any order; the calling thread
+// takes part in the evaluation and returns once all partitions have been evaluated.
+//
+// The pool is created on first use with one worker less than `std::thread::hardware_concurrency()`, or with
+// one worker less than the value of the `CXXRTL_THREADS` environment variable if it is set. Partitions are
+// evaluated on the calling thread instead when the pool has no workers, when it is already busy evaluating
+// another module (e.g. a submodule evaluated from within a partition, or another simulation running on a
+// different thread), or when there is only one partition.
+class partition_pool {
+	typedef bool (*thunk_t)(void *context, size_t index);
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeup;
+
+	std::atomic<bool> stopping;
+	std::atomic<bool> busy;
+	std::atomic<uint64_t> generation;
+	std::atomic<size_t> next_index;
+	std::atomic<size_t> finished_workers;
+	std::atomic<bool> all_converged;
+
+	// The current job; only written while no worker is inside `work()`.
+	thunk_t thunk = nullptr;
+	void *context = nullptr;
+	size_t count = 0;
+
+	static bool &in_partition() {
+		static thread_local bool flag = false;
+		return flag;
+	}
+
+	void work() {
+		size_t index;
+		while ((index = next_index.fetch_add(1, std::memory_order_relaxed)) < count)
+			if (!thunk(context, index))
+				all_converged.store(false, std::memory_order_relaxed);
+	}
+
+	void worker_loop() {
+		in_partition() = true;
+		uint64_t seen = 0;
+		while (true) {
+			// Spin for a while before going to sleep, since the next cycle is usually not far away.
+			uint64_t current;
+			for (size_t spin = 0; spin < 4096; spin++) {
+				current = generation.load(std::memory_order_acquire);
+				if (current != seen)
+					break;
+				std::this_thread::yield();
+			}
+			if (current == seen) {
+				std::unique_lock<std::mutex> lock(mutex);
+				wakeup.wait(lock, [&] {
+					return generation.load(std::memory_order_acquire) != seen;
+				});
+				current = generation.load(std::memory_order_acquire);
+			}
+			seen = current;
+			if (stopping.load(std::memory_order_relaxed))
+				return;
+			work();
+			finished_workers.fetch_add(1, std::memory_order_release);
+		}
+	}
+
+public:
+	explicit partition_pool(size_t threads)
+			: stopping(false), busy(false), generation(0), next_index(0), finished_workers(0), all_converged(true) {
+		for (size_t i = 1; i < threads; i++)
+			workers.emplace_back([this] { worker_loop(); });
+	}
+
+	partition_pool(const partition_pool &) = delete;
+	partition_pool &operator=(const partition_pool &) = delete;
+
+	~partition_pool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping.store(true, std::memory_order_relaxed);
+			generation.fetch_add(1, std::memory_order_release);
+		}
+		wakeup.notify_all();
+		for (auto &worker : workers)
+			worker.join();
+	}
+
+	static partition_pool &global() {
+		static partition_pool pool([] {
+			const char *threads = std::getenv("CXXRTL_THREADS");
+			if (threads != nullptr && std::atoi(threads) > 0)
+				return (size_t)std::atoi(threads);
+			return (size_t)std::thread::hardware_concurrency();
+		}());
+		return pool;
+	}
+
+	size_t threads() const {
+		return workers.size() + 1;
+	}
+
+	// Evaluates `partition(index)` for every index below `partitions`, and returns whether all of them converged.
+	template<class Fn>
+	bool run(size_t partitions, Fn &&partition) {
+		if (workers.empty() || partitions < 2 || in_partition() || busy.exchange(true, std::memory_order_acquire)) {
+			bool converged = true;
+			for (size_t index = 0; index < partitions; index++)
+				converged &= partition(index);
+			return converged;
+		}
+
+		typedef typename std::remove_reference<Fn>::type fn_t;
+		thunk = [](void *context, size_t index) -> bool {
+			return (*static_cast<fn_t *>(context))(index);
+		};
+		context = (void *)&partition;
+		count = partitions;
+		next_index.store(0, std::memory_order_relaxed);
+		finished_workers.store(0, std::memory_order_relaxed);
+		all_converged.store(true, std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			generation.fetch_add(1, std::memory_order_release);
+		}
+		wakeup.notify_all();
+
+		// Barrier: every worker acknowledges every job, so none of them can observe the next one half-written.
+		in_partition() = true;
+		work();
+		while (finished_workers.load(std::memory_order_acquire) != workers.size())
+			std::this_thread::yield();
+		in_partition() = false;
+
+		bool converged = all_converged.load(std::memory_order_relaxed);
+		busy.store(false, std::memory_order_release);
+		return converged;
+	}
+};
+
+} // namespace cxxrtl
+
+#endif
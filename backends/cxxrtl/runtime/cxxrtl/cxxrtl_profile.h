@@ -0,0 +1,128 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2023  Catherine <whitequark@whitequark.org>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// This file is included by designs generated with `write_cxxrtl -profile`.
+
+#ifndef CXXRTL_PROFILE_H
+#define CXXRTL_PROFILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CXXRTL_PROFILE_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CXXRTL_PROFILE_RDTSC
+#endif
+
+namespace cxxrtl {
+
+// Returns a monotonic timestamp. This is the CPU timestamp counter where it is available, since it is much cheaper
+// to read than the system clock; otherwise, it is the time in nanoseconds. Either way, only the ratios between
+// the numbers of ticks spent in different parts of a design are meaningful.
+inline uint64_t profile_ticks() {
+#if defined(CXXRTL_PROFILE_RDTSC)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// The number of times a part of a design was evaluated and the number of ticks spent evaluating it, including
+// the time spent in nested parts (e.g. submodules).
+struct profile_counter {
+	uint64_t count = 0;
+	uint64_t ticks = 0;
+};
+
+// Accounts the time between its construction and destruction to a counter.
+class profile_scope {
+	profile_counter &counter;
+	uint64_t start;
+
+public:
+	explicit profile_scope(profile_counter &counter) : counter(counter), start(profile_ticks()) {}
+
+	profile_scope(const profile_scope &) = delete;
+	profile_scope &operator=(const profile_scope &) = delete;
+
+	~profile_scope() {
+		counter.count++;
+		counter.ticks += profile_ticks() - start;
+	}
+};
+
+// A collection of the profile counters of a design, filled in by the `profile_info()` method of the toplevel
+// module. The names of the counters use the same hierarchy separator as `debug_items`.
+struct profile_items {
+	std::vector<std::pair<std::string, profile_counter*>> table;
+
+	void add(const std::string &path, const std::string &name, profile_counter &counter) {
+		table.emplace_back(path + name, &counter);
+	}
+
+	size_t size() const {
+		return table.size();
+	}
+
+	const profile_counter *find(const std::string &name) const {
+		for (auto &it : table)
+			if (it.first == name)
+				return it.second;
+		return nullptr;
+	}
+
+	// Clears all counters, e.g. to exclude the startup of a simulation from its profile.
+	void reset() {
+		for (auto &it : table)
+			*it.second = profile_counter();
+	}
+
+	// Writes a report with one line per counter, the most expensive first. The share of the ticks is relative to
+	// the counter with the most ticks, which is normally the `eval` counter of the toplevel module.
+	void dump(std::ostream &os) const {
+		std::vector<std::pair<std::string, profile_counter*>> sorted(table);
+		std::stable_sort(sorted.begin(), sorted.end(),
+			[](const std::pair<std::string, profile_counter*> &a, const std::pair<std::string, profile_counter*> &b) {
+				return a.second->ticks > b.second->ticks;
+			});
+		uint64_t total = sorted.empty() ? 0 : sorted.front().second->ticks;
+		os << "       ticks      %        count  ticks/count  name\n";
+		for (auto &it : sorted) {
+			char line[96];
+			snprintf(line, sizeof(line), "%12llu %6.2f %12llu %12.1f  ",
+			         (unsigned long long)it.second->ticks,
+			         total ? 100.0 * it.second->ticks / total : 0.0,
+			         (unsigned long long)it.second->count,
+			         it.second->count ? (double)it.second->ticks / it.second->count : 0.0);
+			os << line << it.first << "\n";
+		}
+	}
+};
+
+} // namespace cxxrtl
+
+#endif
@@ -30,8 +30,15 @@
 #include <cstring>
 #include <cstdio>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
+#if defined(CXXRTL_REPLAY_LZ4)
+#include <lz4.h>
+#endif
+
 #include <cxxrtl/cxxrtl.h>
 #include <cxxrtl/cxxrtl_time.h>
 
@@ -46,8 +53,10 @@
 // degree of detail see the source code. The format is considered fully internal to CXXRTL and is subject to change
 // without notice.
 //
-// <file>           ::= <file-header> <definitions> <sample>+
+// <file>           ::= <file-header> <block>+
 // <file-header>    ::= 0x52585843 0x00004c54
+// <block>          ::= 0xc0000020 <block-flags> <size> <stored-size> <pointer> <time> <payload>
+// <log-data>       ::= <definitions> <sample>+
 // <definitions>    ::= <packet-define>* <packet-end>
 // <sample>         ::= <packet-sample> (<packet-change> | <packet-diag>)* <packet-end>
 // <packet-define>  ::= 0xc0000000 ...
@@ -61,6 +70,12 @@
 // <packet-assume>  ::= 0xc0000013 <message> <source-location>
 // <packet-end>     ::= 0xFFFFFFFF
 //
+// The log data is the concatenation of the payloads of all blocks, where the payload of a block with the compressed
+// flag is an LZ4 block (which requires defining `CXXRTL_REPLAY_LZ4` and linking with liblz4 both when recording and
+// when replaying). Packets may span the boundary between blocks. Every complete sample starts a new block, which has
+// the checkpoint flag and repeats the pointer and time of the sample in its header; this allows the player to find
+// every complete sample by reading only the block headers.
+//
 // The replay log contains sample data, however, it does not cover the entire design. Rather, it only contains sample
 // data for the subset of debug items containing _design state_: inputs and registers/latches. This keeps its size to
 // a minimum, and recording speed to a maximum. The player samples any missing data by setting the design state items
@@ -99,7 +114,7 @@
 // the log. It is done once.
 //
 // During rewinding, the player begins reading at the latest non-incremental sample that still lies before the requested
-// sample time. It continues reading incremental samples after that point until it reaches the requested sample time.
+// sample time, found using the checkpoints in the block headers. It continues reading incremental samples after that point until it reaches the requested sample time.
 // This process is very cheap as the design is not evaluated; it is essentially a (convoluted) memory copy operation.
 //
 // During replaying, the player evaluates the design at the current time, which causes all debug items to assume
@@ -154,7 +169,7 @@ public:
 	// Numeric identifier assigned to a debug item within a replay log. Range limited to [1, MAXIMUM_IDENT].
 	typedef uint32_t ident_t;
 
-	static constexpr uint16_t VERSION = 0x0400;
+	static constexpr uint16_t VERSION = 0x0500;
 
 	static constexpr uint64_t HEADER_MAGIC = 0x00004c5452585843;
 	static constexpr uint64_t VERSION_MASK = 0xffff000000000000;
@@ -180,17 +195,44 @@ public:
 
 	static constexpr uint32_t PACKET_END     = 0xffffffff;
 
+	static constexpr uint32_t PACKET_BLOCK   = 0xc0000020;
+	enum block_flag : uint32_t {
+		BLOCK_COMPRESSED = 1,
+		BLOCK_CHECKPOINT = 2,
+	};
+	static constexpr size_t BLOCK_HEADER_WORDS = 8;
+
 	// Writing spools.
 
 	class writer {
+		struct block_header {
+			uint32_t flags = 0;
+			pointer_t pointer = 0;
+			time timestamp;
+		};
+
 		int fd;
 		size_t position;
 		std::vector<uint32_t> buffer;
+		block_header header;
+		std::vector<char> scratch;
+
+		// When writing in the background, `flush()` hands the buffer over to the writer thread, which compresses it
+		// and writes it to the file while the recorder fills the other one.
+		bool background;
+		std::thread worker;
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::vector<uint32_t> pending_buffer;
+		size_t pending_size = 0;
+		block_header pending_header;
+		bool pending = false;
+		bool stopping = false;
 
 		// These functions aren't overloaded because of implicit numeric conversions.
 
 		void emit_word(uint32_t word) {
-			if (position + 1 == buffer.size())
+			if (position == buffer.size())
 				flush();
 			buffer[position++] = word;
 		}
@@ -233,13 +275,60 @@ public:
 			emit_word(raw_timestamp.data[2]);
 		}
 
+		void write_all(const void *data, size_t data_size) {
+			size_t data_written = write(fd, data, data_size);
+			assert(data_size == data_written);
+			(void)data_written;
+		}
+
+		void write_block(const block_header &header, const uint32_t *words, size_t count) {
+			uint32_t flags = header.flags;
+			const char *payload = reinterpret_cast<const char *>(words);
+			size_t payload_size = count * sizeof(uint32_t);
+#if defined(CXXRTL_REPLAY_LZ4)
+			scratch.resize(LZ4_compressBound(payload_size));
+			int compressed_size = LZ4_compress_default(payload, scratch.data(), payload_size, scratch.size());
+			if (compressed_size > 0 && (size_t)compressed_size < payload_size) {
+				flags |= BLOCK_COMPRESSED;
+				payload = scratch.data();
+				payload_size = compressed_size;
+			}
+#endif
+			const value<time::bits> &raw_timestamp(header.timestamp);
+			uint32_t block_words[BLOCK_HEADER_WORDS] = {
+				PACKET_BLOCK, flags, (uint32_t)count, (uint32_t)payload_size, header.pointer,
+				raw_timestamp.data[0], raw_timestamp.data[1], raw_timestamp.data[2],
+			};
+			write_all(block_words, sizeof(block_words));
+			write_all(payload, payload_size);
+			uint32_t padding = 0;
+			if (payload_size % sizeof(uint32_t) != 0)
+				write_all(&padding, sizeof(uint32_t) - payload_size % sizeof(uint32_t));
+		}
+
+		void work() {
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true) {
+				cond.wait(lock, [this] { return pending || stopping; });
+				if (!pending)
+					return;
+				lock.unlock();
+				write_block(pending_header, pending_buffer.data(), pending_size);
+				lock.lock();
+				pending = false;
+				cond.notify_all();
+			}
+		}
+
 	public:
-		// Creates a writer, and transfers ownership of `fd`, which must be open for appending.
+		// Creates a writer, and transfers ownership of `fd`, which must be open for appending. If `background` is true,
+		// the blocks are compressed and written to the file by a separate thread.
 		//
-		// The buffer size is currently fixed to a "reasonably large" size, determined empirically by measuring writer
-		// performance on a representative design; large but not so large it would e.g. cause address space exhaustion
-		// on 32-bit platforms.
-		writer(spool &spool) : fd(spool.take_write()), position(0), buffer(32 * 1024 * 1024) {
+		// The buffer size determines the size of the blocks in the file, which is also the granularity at which
+		// incremental samples are decompressed when seeking. It is large enough for `write()` calls to be infrequent,
+		// but small enough for random access to remain fast.
+		writer(spool &spool, bool background = false)
+				: fd(spool.take_write()), position(0), buffer(4 * 1024 * 1024), background(background) {
 			assert(fd != -1);
 #if !defined(WIN32)
 			int result = ftruncate(fd, 0);
@@ -247,9 +336,13 @@ public:
 			int result = _chsize_s(fd, 0);
 #endif
 			assert(result == 0);
+			(void)result;
 		}
 
-		writer(writer &&moved) : fd(moved.fd), position(moved.position), buffer(moved.buffer) {
+		writer(writer &&moved)
+				: fd(moved.fd), position(moved.position), buffer(std::move(moved.buffer)), header(moved.header),
+				  background(moved.background) {
+			assert(!moved.worker.joinable() && "a writer cannot be moved once it has started writing in the background");
 			moved.fd = -1;
 			moved.position = 0;
 		}
@@ -258,26 +351,59 @@ public:
 		writer &operator=(const writer &) = delete;
 
 		// Both write() calls and fwrite() calls are too expensive to perform implicitly. The API consumer must determine
-		// the optimal time to flush the writer and do that explicitly for best performance.
+		// the optimal time to flush the writer and do that explicitly for best performance. Every flush ends a block.
+		// When writing in the background, this function returns as soon as the writer thread accepts the block.
 		void flush() {
 			assert(fd != -1);
-			size_t data_size = position * sizeof(uint32_t);
-			size_t data_written = write(fd, buffer.data(), data_size);
-			assert(data_size == data_written);
+			if (position == 0)
+				return;
+			if (!background) {
+				write_block(header, buffer.data(), position);
+			} else {
+				std::unique_lock<std::mutex> lock(mutex);
+				if (!worker.joinable())
+					worker = std::thread([this] { work(); });
+				cond.wait(lock, [this] { return !pending; });
+				std::swap(buffer, pending_buffer);
+				buffer.resize(pending_buffer.size());
+				pending_size = position;
+				pending_header = header;
+				pending = true;
+				cond.notify_all();
+			}
 			position = 0;
+			header = block_header();
+		}
+
+		// Flushes the writer and waits until every block has been written to the file.
+		void sync() {
+			flush();
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [this] { return !pending; });
 		}
 
 		~writer() {
 			if (fd != -1) {
 				flush();
+				if (worker.joinable()) {
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						stopping = true;
+					}
+					cond.notify_all();
+					worker.join();
+				}
 				close(fd);
 			}
 		}
 
 		void write_magic() {
+			assert(position == 0 && !worker.joinable());
 			// `CXXRTL` followed by version in binary. This header will read backwards on big-endian machines, which allows
-			// detection of this case, both visually and programmatically.
-			emit_dword(((uint64_t)VERSION << 48) | HEADER_MAGIC);
+			// detection of this case, both visually and programmatically. It is the only part of the file outside a block.
+			uint64_t magic = ((uint64_t)VERSION << 48) | HEADER_MAGIC;
+			uint32_t magic_words[2] = { (uint32_t)(magic >> 0), (uint32_t)(magic >> 32) };
+			write_all(magic_words, sizeof(magic_words));
 		}
 
 		void write_define(ident_t ident, const std::string &name, size_t part_index, size_t chunks, size_t depth) {
@@ -290,6 +416,13 @@ public:
 		}
 
 		void write_sample(bool incremental, pointer_t pointer, const time &timestamp) {
+			// Complete samples always start a new block, which makes them reachable without reading the preceding blocks.
+			if (!incremental) {
+				flush();
+				header.flags |= BLOCK_CHECKPOINT;
+				header.pointer = pointer;
+				header.timestamp = timestamp;
+			}
 			uint32_t flags = (incremental ? sample_flag::INCREMENTAL : 0);
 			emit_word(PACKET_SAMPLE);
 			emit_word(flags);
@@ -334,13 +467,94 @@ public:
 	// Reading spools.
 
 	class reader {
+	public:
+		typedef uint64_t pos_t;
+
+	private:
+		struct block_info {
+			uint64_t file_offset; // of the payload
+			pos_t start; // in words, counting from the start of the first block
+			uint32_t flags;
+			size_t words;
+			size_t stored_bytes;
+			pointer_t pointer;
+			time timestamp;
+		};
+
 		FILE *f;
+		std::vector<block_info> blocks; // every block found so far, in file order
+		uint64_t next_block_offset = 0;
+		size_t next_block = 0; // index of the block after the one in `data`
+		std::vector<uint32_t> data;
+		size_t offset = 0; // in words, within `data`
+		std::vector<char> scratch;
+		size_t checkpointed_blocks = 0; // number of blocks already passed to `read_checkpoints()`
+
+		// Finds the block following the last one found so far. Returns `false` if there is no such block, or if it has
+		// not been completely written yet.
+		bool find_block() {
+			uint32_t block_words[BLOCK_HEADER_WORDS];
+			if (fseek(f, next_block_offset, SEEK_SET) != 0 ||
+					fread(block_words, sizeof(uint32_t), BLOCK_HEADER_WORDS, f) != BLOCK_HEADER_WORDS)
+				return false;
+			assert(block_words[0] == PACKET_BLOCK);
+
+			block_info block;
+			block.file_offset = next_block_offset + sizeof(block_words);
+			block.start = blocks.empty() ? 0 : blocks.back().start + blocks.back().words;
+			block.flags = block_words[1];
+			block.words = block_words[2];
+			block.stored_bytes = block_words[3];
+			block.pointer = block_words[4];
+			value<time::bits> raw_timestamp;
+			raw_timestamp.data[0] = block_words[5];
+			raw_timestamp.data[1] = block_words[6];
+			raw_timestamp.data[2] = block_words[7];
+			block.timestamp = time(raw_timestamp);
+
+			uint64_t end_offset = block.file_offset +
+				(block.stored_bytes + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t);
+			if (fseek(f, 0, SEEK_END) != 0 || (uint64_t)ftell(f) < end_offset)
+				return false;
+			blocks.push_back(block);
+			next_block_offset = end_offset;
+			return true;
+		}
+
+		bool load_block(size_t index) {
+			if (index == blocks.size() && !find_block())
+				return false;
+			const block_info &block = blocks.at(index);
+			data.resize(block.words);
+			fseek(f, block.file_offset, SEEK_SET);
+			if (block.flags & BLOCK_COMPRESSED) {
+#if defined(CXXRTL_REPLAY_LZ4)
+				scratch.resize(block.stored_bytes);
+				size_t bytes_read = fread(scratch.data(), 1, block.stored_bytes, f);
+				assert(bytes_read == block.stored_bytes);
+				int data_size = LZ4_decompress_safe(scratch.data(), reinterpret_cast<char *>(data.data()),
+				                                    block.stored_bytes, block.words * sizeof(uint32_t));
+				assert(data_size >= 0 && (size_t)data_size == block.words * sizeof(uint32_t));
+				(void)bytes_read, (void)data_size;
+#else
+				assert(false && "Replay log is compressed, but CXXRTL_REPLAY_LZ4 is not defined");
+#endif
+			} else {
+				size_t words_read = fread(data.data(), sizeof(uint32_t), block.words, f);
+				assert(words_read == block.words);
+				(void)words_read;
+			}
+			next_block = index + 1;
+			offset = 0;
+			return true;
+		}
 
 		uint32_t absorb_word() {
-			// If we're at end of file, `fread` will not write to `word`, and `PACKET_END` will be returned.
-			uint32_t word = PACKET_END;
-			fread(&word, sizeof(word), 1, f);
-			return word;
+			// If we're at end of file, `PACKET_END` will be returned.
+			while (offset == data.size())
+				if (!load_block(next_block))
+					return PACKET_END;
+			return data[offset++];
 		}
 
 		uint64_t absorb_dword() {
@@ -384,14 +598,15 @@ public:
 		}
 
 	public:
-		typedef uint64_t pos_t;
-
 		// Creates a reader, and transfers ownership of `fd`, which must be open for reading.
 		reader(spool &spool) : f(fdopen(spool.take_read(), "r")) {
 			assert(f != nullptr);
 		}
 
-		reader(reader &&moved) : f(moved.f) {
+		reader(reader &&moved)
+				: f(moved.f), blocks(std::move(moved.blocks)), next_block_offset(moved.next_block_offset),
+				  next_block(moved.next_block), data(std::move(moved.data)), offset(moved.offset),
+				  checkpointed_blocks(moved.checkpointed_blocks) {
 			moved.f = nullptr;
 		}
 
@@ -403,18 +618,54 @@ public:
 				fclose(f);
 		}
 
+		// Positions count words of the uncompressed log data, and are only valid within the reader that returned them.
 		pos_t position() {
-			return ftell(f);
+			if (next_block == 0)
+				return 0;
+			return blocks[next_block - 1].start + offset;
 		}
 
 		void rewind(pos_t position) {
-			fseek(f, position, SEEK_SET);
+			// Find the last block that starts at or before `position`; `position` could also be at the end of that block.
+			size_t index = blocks.size();
+			while (index > 0 && blocks[index - 1].start > position)
+				index--;
+			if (index == 0) {
+				assert(position == 0);
+				next_block = 0;
+				data.clear();
+				offset = 0;
+				return;
+			}
+			if (next_block != index)
+				load_block(index - 1);
+			offset = position - blocks[index - 1].start;
+			assert(offset <= data.size());
+		}
+
+		// Calls `fn(pointer, timestamp, position)` for every complete sample in the blocks written since the last call.
+		// Only the block headers are read, so this is cheap even for very long recordings.
+		template<class Fn>
+		void read_checkpoints(Fn &&fn) {
+			while (find_block())
+				continue;
+			for (; checkpointed_blocks < blocks.size(); checkpointed_blocks++) {
+				const block_info &block = blocks[checkpointed_blocks];
+				if (block.flags & BLOCK_CHECKPOINT)
+					fn(block.pointer, block.timestamp, block.start);
+			}
 		}
 
 		void read_magic() {
-			uint64_t magic = absorb_dword();
+			uint32_t magic_words[2] = {};
+			fseek(f, 0, SEEK_SET);
+			size_t words_read = fread(magic_words, sizeof(uint32_t), 2, f);
+			assert(words_read == 2);
+			(void)words_read;
+			uint64_t magic = ((uint64_t)magic_words[1] << 32) | magic_words[0];
 			assert((magic & ~VERSION_MASK) == HEADER_MAGIC);
 			assert((magic >> 48) == VERSION);
+			next_block_offset = sizeof(magic_words);
 		}
 
 		bool read_define(ident_t &ident, std::string &name, size_t &part_index, size_t &chunks, size_t &depth) {
@@ -549,11 +800,19 @@ class recorder {
 	bool streaming = false; // whether variable definitions have been written
 	spool::pointer_t pointer = 0;
 	time timestamp;
+	size_t checkpoint_interval = 0;
+	size_t samples_since_checkpoint = 0;
 
 public:
 	template<typename ...Args>
 	recorder(Args &&...args) : writer(std::forward<Args>(args)...) {}
 
+	// If `interval` is not zero, every `interval`-th call to `record_incremental()` records a complete sample instead,
+	// which bounds the amount of log data that the player has to read to rewind to any sample.
+	void set_checkpoint_interval(size_t interval) {
+		checkpoint_interval = interval;
+	}
+
 	void start(module &module, std::string top_path = "") {
 		debug_items items;
 		module.debug_info(&items, /*scopes=*/nullptr, top_path);
@@ -602,6 +861,7 @@ public:
 	void record_complete() {
 		assert(streaming);
 
+		samples_since_checkpoint = 0;
 		writer.write_sample(/*incremental=*/false, pointer++, timestamp);
 		for (auto var : variables) {
 			assert(var.ident != 0);
@@ -619,6 +879,12 @@ public:
 	bool record_incremental(ModuleT &module) {
 		assert(streaming);
 
+		if (checkpoint_interval != 0 && ++samples_since_checkpoint >= checkpoint_interval) {
+			bool changed = module.commit();
+			record_complete();
+			return changed;
+		}
+
 		struct : observer {
 			std::unordered_map<const chunk_t*, spool::ident_t> *ident_lookup;
 			spool::writer *writer;
@@ -662,6 +928,10 @@ public:
 	void flush() {
 		writer.flush();
 	}
+
+	void sync() {
+		writer.sync();
+	}
 };
 
 // A CXXRTL player reads samples from a spool, and changes the design state accordingly. To start reading samples,
@@ -684,6 +954,16 @@ class player {
 	std::map<spool::pointer_t, spool::reader::pos_t, std::greater<spool::pointer_t>> index_by_pointer;
 	std::map<time, spool::reader::pos_t, std::greater<time>> index_by_timestamp;
 
+	// Adds the complete samples written since the last call to the index, without reading the samples themselves.
+	void index_checkpoints() {
+		reader.read_checkpoints([this](spool::pointer_t pointer, const time &timestamp, spool::reader::pos_t position) {
+			if (!index_by_pointer.count(pointer))
+				index_by_pointer[pointer] = position;
+			if (!index_by_timestamp.count(timestamp))
+				index_by_timestamp[timestamp] = position;
+		});
+	}
+
 	bool peek_sample(spool::pointer_t &pointer, time &timestamp) {
 		bool incremental;
 		auto position = reader.position();
@@ -772,6 +1052,7 @@ public:
 
 		// The pointers in the replay log start from one that is greater than `at_pointer`. In this case the pointer will
 		// never be reached.
+		index_checkpoints();
 		assert(index_by_pointer.size() > 0);
 		if (at_pointer < index_by_pointer.rbegin()->first)
 			return false;
@@ -802,6 +1083,7 @@ public:
 
 		// The timestamps in the replay log start from one that is greater than `at_or_before_timestamp`. In this case
 		// the timestamp will never be reached. Otherwise, this function will always succeed.
+		index_checkpoints();
 		assert(index_by_timestamp.size() > 0);
 		if (at_or_before_timestamp < index_by_timestamp.rbegin()->first)
 			return false;
@@ -845,11 +1127,12 @@ public:
 
 		// It is possible (though not very useful) to have several complete samples with the same timestamp in a row.
 		// Ensure that we associate the timestamp with the position of the first such complete sample. (This condition
-		// works because the player never jumps over a sample.)
-		if (!incremental && !index_by_pointer.count(pointer)) {
-			assert(!index_by_timestamp.count(timestamp));
-			index_by_pointer[pointer] = position;
-			index_by_timestamp[timestamp] = position;
+		// works because both the player and `index_checkpoints()` never jump over a sample.)
+		if (!incremental) {
+			if (!index_by_pointer.count(pointer))
+				index_by_pointer[pointer] = position;
+			if (!index_by_timestamp.count(timestamp))
+				index_by_timestamp[timestamp] = position;
 		}
 
 		uint32_t header;
@@ -38,8 +38,8 @@ struct EdifNames
 {
 	int counter;
 	char delim_left, delim_right;
-	std::set<std::string> generated_names, used_names;
-	std::map<std::string, std::string> name_map;
+	pool<std::string> generated_names, used_names;
+	dict<std::string, std::string> name_map;
 
 	EdifNames() : counter(1), delim_left('['), delim_right(']') { }
 
@@ -52,8 +52,9 @@ struct EdifNames
 			return new_id != id ? stringf("(rename %s \"%s\")", new_id.c_str(), id.c_str()) : id;
 		}
 
-		if (name_map.count(id) > 0)
-			return name_map.at(id);
+		auto it = name_map.find(id);
+		if (it != name_map.end())
+			return it->second;
 		if (generated_names.count(id) > 0)
 			goto do_rename;
 		if (id == "GND" || id == "VCC")
@@ -141,6 +142,23 @@ struct EdifBackend : public Backend {
 		CellTypes ct(design);
 		EdifNames edif_names;
 
+		// the netlist is collected in a buffer that is written out in large
+		// blocks, and the EDIF reference of every id is looked up only once
+		std::string out;
+		dict<RTLIL::IdString, std::string> edif_refs;
+
+		auto flush = [&]() {
+			f->write(out.data(), out.size());
+			out.clear();
+		};
+
+		auto edif_ref = [&](RTLIL::IdString id) -> const std::string & {
+			auto it = edif_refs.find(id);
+			if (it == edif_refs.end())
+				it = edif_refs.emplace(id, edif_names(RTLIL::unescape_id(id), false)).first;
+			return it->second;
+		};
+
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++)
 		{
@@ -227,41 +245,41 @@ struct EdifBackend : public Backend {
 		if (top_module_name.empty())
 			log_error("No module found in design!\n");
 
-		*f << stringf("(edif %s\n", EDIF_DEF(top_module_name));
-		*f << stringf("  (edifVersion 2 0 0)\n");
-		*f << stringf("  (edifLevel 0)\n");
-		*f << stringf("  (keywordMap (keywordLevel 0))\n");
-		*f << stringf("  (comment \"Generated by %s\")\n", yosys_version_str);
+		out += stringf("(edif %s\n", EDIF_DEF(top_module_name));
+		out += stringf("  (edifVersion 2 0 0)\n");
+		out += stringf("  (edifLevel 0)\n");
+		out += stringf("  (keywordMap (keywordLevel 0))\n");
+		out += stringf("  (comment \"Generated by %s\")\n", yosys_version_str);
 
-		*f << stringf("  (external LIB\n");
-		*f << stringf("    (edifLevel 0)\n");
-		*f << stringf("    (technology (numberDefinition))\n");
+		out += stringf("  (external LIB\n");
+		out += stringf("    (edifLevel 0)\n");
+		out += stringf("    (technology (numberDefinition))\n");
 
 		if (!nogndvcc)
 		{
-			*f << stringf("    (cell GND\n");
-			*f << stringf("      (cellType GENERIC)\n");
-			*f << stringf("      (view VIEW_NETLIST\n");
-			*f << stringf("        (viewType NETLIST)\n");
-			*f << stringf("        (interface (port %c (direction OUTPUT)))\n", gndvccy ? 'Y' : 'G');
-			*f << stringf("      )\n");
-			*f << stringf("    )\n");
-
-			*f << stringf("    (cell VCC\n");
-			*f << stringf("      (cellType GENERIC)\n");
-			*f << stringf("      (view VIEW_NETLIST\n");
-			*f << stringf("        (viewType NETLIST)\n");
-			*f << stringf("        (interface (port %c (direction OUTPUT)))\n", gndvccy ? 'Y' : 'P');
-			*f << stringf("      )\n");
-			*f << stringf("    )\n");
+			out += stringf("    (cell GND\n");
+			out += stringf("      (cellType GENERIC)\n");
+			out += stringf("      (view VIEW_NETLIST\n");
+			out += stringf("        (viewType NETLIST)\n");
+			out += stringf("        (interface (port %c (direction OUTPUT)))\n", gndvccy ? 'Y' : 'G');
+			out += stringf("      )\n");
+			out += stringf("    )\n");
+
+			out += stringf("    (cell VCC\n");
+			out += stringf("      (cellType GENERIC)\n");
+			out += stringf("      (view VIEW_NETLIST\n");
+			out += stringf("        (viewType NETLIST)\n");
+			out += stringf("        (interface (port %c (direction OUTPUT)))\n", gndvccy ? 'Y' : 'P');
+			out += stringf("      )\n");
+			out += stringf("    )\n");
 		}
 
 		for (auto &cell_it : lib_cell_ports) {
-			*f << stringf("    (cell %s\n", EDIF_DEF(cell_it.first));
-			*f << stringf("      (cellType GENERIC)\n");
-			*f << stringf("      (view VIEW_NETLIST\n");
-			*f << stringf("        (viewType NETLIST)\n");
-			*f << stringf("        (interface\n");
+			out += stringf("    (cell %s\n", EDIF_DEF(cell_it.first));
+			out += stringf("      (cellType GENERIC)\n");
+			out += stringf("      (view VIEW_NETLIST\n");
+			out += stringf("        (viewType NETLIST)\n");
+			out += stringf("        (interface\n");
 			for (auto &port_it : cell_it.second) {
 				const char *dir = "INOUT";
 				if (ct.cell_known(cell_it.first)) {
@@ -283,19 +301,19 @@ struct EdifBackend : public Backend {
 					}
 				}
 				if (width == 1)
-					*f << stringf("          (port %s (direction %s))\n", EDIF_DEF(port_it.first), dir);
+					out += stringf("          (port %s (direction %s))\n", EDIF_DEF(port_it.first), dir);
 				else {
 					int b[2];
 					b[upto ? 0 : 1] = start;
 					b[upto ? 1 : 0] = start+width-1;
-					*f << stringf("          (port (array %s %d) (direction %s))\n", EDIF_DEFR(port_it.first, port_rename, b[0], b[1]), width, dir);
+					out += stringf("          (port (array %s %d) (direction %s))\n", EDIF_DEFR(port_it.first, port_rename, b[0], b[1]), width, dir);
 				}
 			}
-			*f << stringf("        )\n");
-			*f << stringf("      )\n");
-			*f << stringf("    )\n");
+			out += stringf("        )\n");
+			out += stringf("      )\n");
+			out += stringf("    )\n");
 		}
-		*f << stringf("  )\n");
+		out += stringf("  )\n");
 
 		std::vector<RTLIL::Module*> sorted_modules;
 
@@ -327,15 +345,15 @@ struct EdifBackend : public Backend {
 		}
 
 
-		*f << stringf("  (library DESIGN\n");
-		*f << stringf("    (edifLevel 0)\n");
-		*f << stringf("    (technology (numberDefinition))\n");
+		out += stringf("  (library DESIGN\n");
+		out += stringf("    (edifLevel 0)\n");
+		out += stringf("    (technology (numberDefinition))\n");
 
 		auto add_prop = [&](IdString name, Const val) {
 			if ((val.flags & RTLIL::CONST_FLAG_STRING) != 0)
-				*f << stringf("\n            (property %s (string \"%s\"))", EDIF_DEF(name), val.decode_string().c_str());
+				out += stringf("\n            (property %s (string \"%s\"))", EDIF_DEF(name), val.decode_string().c_str());
 			else if (val.size() <= 32 && RTLIL::SigSpec(val).is_fully_def())
-				*f << stringf("\n            (property %s (integer %u))", EDIF_DEF(name), val.as_int());
+				out += stringf("\n            (property %s (integer %u))", EDIF_DEF(name), val.as_int());
 			else {
 				std::string hex_string = "";
 				for (auto i = 0; i < val.size(); i += 4) {
@@ -347,7 +365,7 @@ struct EdifBackend : public Backend {
 					char digit_str[2] = { "0123456789abcdef"[digit_value], 0 };
 					hex_string = std::string(digit_str) + hex_string;
 				}
-				*f << stringf("\n            (property %s (string \"%d'h%s\"))", EDIF_DEF(name), GetSize(val), hex_string.c_str());
+				out += stringf("\n            (property %s (string \"%d'h%s\"))", EDIF_DEF(name), GetSize(val), hex_string.c_str());
 			}
 		};
 		for (auto module : sorted_modules)
@@ -356,13 +374,13 @@ struct EdifBackend : public Backend {
 				continue;
 
 			SigMap sigmap(module);
-			std::map<RTLIL::SigSpec, std::set<std::pair<std::string, bool>>> net_join_db;
+			dict<RTLIL::SigBit, std::vector<std::pair<std::string, bool>>> net_join_db;
 
-			*f << stringf("    (cell %s\n", EDIF_DEF(module->name));
-			*f << stringf("      (cellType GENERIC)\n");
-			*f << stringf("      (view VIEW_NETLIST\n");
-			*f << stringf("        (viewType NETLIST)\n");
-			*f << stringf("        (interface\n");
+			out += stringf("    (cell %s\n", EDIF_DEF(module->name));
+			out += stringf("      (cellType GENERIC)\n");
+			out += stringf("      (view VIEW_NETLIST\n");
+			out += stringf("        (viewType NETLIST)\n");
+			out += stringf("        (interface\n");
 
 			for (auto cell : module->cells()) {
 				for (auto &conn : cell->connections())
@@ -437,87 +455,108 @@ struct EdifBackend : public Backend {
 				else if (!wire->port_input)
 					dir = "OUTPUT";
 				if (wire->width == 1) {
-					*f << stringf("          (port %s (direction %s)", EDIF_DEF(wire->name), dir);
+					out += stringf("          (port %s (direction %s)", EDIF_DEF(wire->name), dir);
 					if (attr_properties)
 						for (auto &p : wire->attributes)
 							add_prop(p.first, p.second);
-					*f << ")\n";
-					RTLIL::SigSpec sig = sigmap(RTLIL::SigSpec(wire));
-					net_join_db[sig].insert(make_pair(stringf("(portRef %s)", EDIF_REF(wire->name)), wire->port_input));
+					out += ")\n";
+					RTLIL::SigBit sig = sigmap(RTLIL::SigBit(wire));
+					net_join_db[sig].emplace_back("(portRef " + edif_ref(wire->name) + ")", wire->port_input);
 				} else {
 					int b[2];
 					b[wire->upto ? 0 : 1] = wire->start_offset;
 					b[wire->upto ? 1 : 0] = wire->start_offset + GetSize(wire) - 1;
-					*f << stringf("          (port (array %s %d) (direction %s)", EDIF_DEFR(wire->name, port_rename, b[0], b[1]), wire->width, dir);
+					out += stringf("          (port (array %s %d) (direction %s)", EDIF_DEFR(wire->name, port_rename, b[0], b[1]), wire->width, dir);
 					if (attr_properties)
 						for (auto &p : wire->attributes)
 							add_prop(p.first, p.second);
 
-					*f << ")\n";
+					out += ")\n";
 					for (int i = 0; i < wire->width; i++) {
-						RTLIL::SigSpec sig = sigmap(RTLIL::SigSpec(wire, i));
-						net_join_db[sig].insert(make_pair(stringf("(portRef (member %s %d))", EDIF_REF(wire->name), lsbidx ? i : GetSize(wire)-i-1), wire->port_input));
+						RTLIL::SigBit sig = sigmap(RTLIL::SigBit(wire, i));
+						net_join_db[sig].emplace_back(stringf("(portRef (member %s %d))", edif_ref(wire->name).c_str(), lsbidx ? i : GetSize(wire)-i-1), wire->port_input);
 					}
 				}
 			}
 
-			*f << stringf("        )\n");
-			*f << stringf("        (contents\n");
+			out += stringf("        )\n");
+			out += stringf("        (contents\n");
 
 			if (!nogndvcc) {
-				*f << stringf("          (instance GND (viewRef VIEW_NETLIST (cellRef GND (libraryRef LIB))))\n");
-				*f << stringf("          (instance VCC (viewRef VIEW_NETLIST (cellRef VCC (libraryRef LIB))))\n");
+				out += stringf("          (instance GND (viewRef VIEW_NETLIST (cellRef GND (libraryRef LIB))))\n");
+				out += stringf("          (instance VCC (viewRef VIEW_NETLIST (cellRef VCC (libraryRef LIB))))\n");
 			}
 
 			for (auto cell : module->cells()) {
-				*f << stringf("          (instance %s\n", EDIF_DEF(cell->name));
-				*f << stringf("            (viewRef VIEW_NETLIST (cellRef %s%s))", EDIF_REF(cell->type),
-						lib_cell_ports.count(cell->type) > 0 ? " (libraryRef LIB)" : "");
+				if (out.size() >= (1 << 20))
+					flush();
+				out += "          (instance ";
+				out += edif_names(RTLIL::unescape_id(cell->name), true);
+				out += "\n            (viewRef VIEW_NETLIST (cellRef ";
+				out += edif_ref(cell->type);
+				out += lib_cell_ports.count(cell->type) > 0 ? " (libraryRef LIB)" : "";
+				out += "))";
 				for (auto &p : cell->parameters)
 					add_prop(p.first, p.second);
 				if (attr_properties)
 					for (auto &p : cell->attributes)
 						add_prop(p.first, p.second);
 
-				*f << stringf(")\n");
+				out += ")\n";
+				auto m = design->module(cell->type);
+				std::string instance_ref = " (instanceRef " + edif_ref(cell->name) + "))";
 				for (auto &p : cell->connections()) {
-					RTLIL::SigSpec sig = sigmap(p.second);
-					for (int i = 0; i < GetSize(sig); i++)
-						if (sig[i].wire == NULL && sig[i] != RTLIL::State::S0 && sig[i] != RTLIL::State::S1)
+					auto w = m ? m->wire(p.first) : nullptr;
+					int width = w ? GetSize(w) : GetSize(p.second);
+					bool is_output = cell->output(p.first);
+					for (int i = 0; i < GetSize(p.second); i++) {
+						RTLIL::SigBit bit = sigmap(p.second[i]);
+						if (bit.wire == NULL && bit != RTLIL::State::S0 && bit != RTLIL::State::S1)
 							log_warning("Bit %d of cell port %s.%s.%s driven by %s will be left unconnected in EDIF output.\n",
-									i, log_id(module), log_id(cell), log_id(p.first), log_signal(sig[i]));
+									i, log_id(module), log_id(cell), log_id(p.first), log_signal(bit));
 						else {
-							int member_idx = lsbidx ? i : GetSize(sig)-i-1;
-							auto m = design->module(cell->type);
-							int width = sig.size();
-							if (m) {
-								auto w = m->wire(p.first);
-								if (w) {
-									member_idx = lsbidx ? i : GetSize(w)-i-1;
-									width = GetSize(w);
-								}
-							}
+							int member_idx = lsbidx ? i : width-i-1;
+							std::string ref = "(portRef ";
 							if (width == 1)
-								net_join_db[sig[i]].insert(make_pair(stringf("(portRef %s (instanceRef %s))", EDIF_REF(p.first), EDIF_REF(cell->name)), cell->output(p.first)));
+								ref += edif_ref(p.first);
 							else {
-								net_join_db[sig[i]].insert(make_pair(stringf("(portRef (member %s %d) (instanceRef %s))",
-										EDIF_REF(p.first), member_idx, EDIF_REF(cell->name)), cell->output(p.first)));
+								ref += "(member ";
+								ref += edif_ref(p.first);
+								ref += ' ';
+								ref += std::to_string(member_idx);
+								ref += ')';
 							}
+							ref += instance_ref;
+							net_join_db[bit].emplace_back(std::move(ref), is_output);
 						}
+					}
 				}
 			}
 
+			// nets are written in the order of their single-bit SigSpec, and
+			// the references of each net in sorted order without duplicates
+			std::vector<RTLIL::SigSpec> nets;
 			for (auto &it : net_join_db) {
-				RTLIL::SigBit sig = it.first;
+				std::sort(it.second.begin(), it.second.end());
+				it.second.erase(std::unique(it.second.begin(), it.second.end()), it.second.end());
+				nets.push_back(it.first);
+			}
+			std::sort(nets.begin(), nets.end());
+
+			for (auto &net : nets) {
+				if (out.size() >= (1 << 20))
+					flush();
+				RTLIL::SigBit sig = net.as_bit();
+				auto &refs = net_join_db.at(sig);
 				if (sig.wire == NULL && sig != RTLIL::State::S0 && sig != RTLIL::State::S1) {
 					if (sig == RTLIL::State::Sx) {
-						for (auto &ref : it.second)
+						for (auto &ref : refs)
 							log_warning("Exporting x-bit on %s as zero bit.\n", ref.first.c_str());
 						sig = RTLIL::State::S0;
 					} else if (sig == RTLIL::State::Sz) {
 						continue;
 					} else {
-						for (auto &ref : it.second)
+						for (auto &ref : refs)
 							log_error("Don't know how to handle %s on %s.\n", log_signal(sig), ref.first.c_str());
 						log_abort();
 					}
@@ -533,22 +572,25 @@ struct EdifBackend : public Backend {
 						if (netname[i] == ' ' || netname[i] == '\\')
 							netname.erase(netname.begin() + i--);
 				}
-				*f << stringf("          (net %s (joined\n", EDIF_DEF(netname));
-				for (auto &ref : it.second)
-					*f << stringf("              %s\n", ref.first.c_str());
+				out += stringf("          (net %s (joined\n", EDIF_DEF(netname));
+				for (auto &ref : refs) {
+					out += "              ";
+					out += ref.first;
+					out += '\n';
+				}
 				if (sig.wire == NULL) {
 					if (nogndvcc)
 						log_error("Design contains constant nodes (map with \"hilomap\" first).\n");
 					if (sig == RTLIL::State::S0)
-						*f << stringf("            (portRef %c (instanceRef GND))\n", gndvccy ? 'Y' : 'G');
+						out += stringf("            (portRef %c (instanceRef GND))\n", gndvccy ? 'Y' : 'G');
 					if (sig == RTLIL::State::S1)
-						*f << stringf("            (portRef %c (instanceRef VCC))\n", gndvccy ? 'Y' : 'P');
+						out += stringf("            (portRef %c (instanceRef VCC))\n", gndvccy ? 'Y' : 'P');
 				}
-				*f << stringf("            )");
+				out += stringf("            )");
 				if (attr_properties && sig.wire != NULL)
 					for (auto &p : sig.wire->attributes)
 						add_prop(p.first, p.second);
-				*f << stringf("\n          )\n");
+				out += stringf("\n          )\n");
 			}
 
 			for (auto wire : module->wires())
@@ -571,19 +613,19 @@ struct EdifBackend : public Backend {
 
 					if (keepmode)
 					{
-						*f << stringf("          (net %s (joined\n", EDIF_DEF(netname));
+						out += stringf("          (net %s (joined\n", EDIF_DEF(netname));
 
 						auto &refs = net_join_db.at(mapped_sig);
 						for (auto &ref : refs)
 							if (ref.second)
-								*f << stringf("              %s\n", ref.first.c_str());
-						*f << stringf("            )");
+								out += stringf("              %s\n", ref.first.c_str());
+						out += stringf("            )");
 
 						if (attr_properties && raw_sig.wire != NULL)
 							for (auto &p : raw_sig.wire->attributes)
 								add_prop(p.first, p.second);
 
-						*f << stringf("\n          )\n");
+						out += stringf("\n          )\n");
 					}
 					else
 					{
@@ -592,17 +634,18 @@ struct EdifBackend : public Backend {
 				}
 			}
 
-			*f << stringf("        )\n");
-			*f << stringf("      )\n");
-			*f << stringf("    )\n");
+			out += stringf("        )\n");
+			out += stringf("      )\n");
+			out += stringf("    )\n");
 		}
-		*f << stringf("  )\n");
+		out += stringf("  )\n");
 
-		*f << stringf("  (design %s\n", EDIF_DEF(top_module_name));
-		*f << stringf("    (cellRef %s (libraryRef DESIGN))\n", EDIF_REF(top_module_name));
-		*f << stringf("  )\n");
+		out += stringf("  (design %s\n", EDIF_DEF(top_module_name));
+		out += stringf("    (cellRef %s (libraryRef DESIGN))\n", EDIF_REF(top_module_name));
+		out += stringf("  )\n");
 
-		*f << stringf(")\n");
+		out += stringf(")\n");
+		flush();
 	}
 } EdifBackend;
 
@@ -23,78 +23,107 @@
 
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <string>
 #include <iostream>
 #include <algorithm>
 
+// A bit vector of width n, stored in 64-bit limbs with the least significant limb first. The bits of the
+// last limb above n are always zero, which lets comparisons and reductions work on whole limbs. For n <= 64, a
+// signal is a single native integer, and the loops over limbs below are unrolled by the compiler.
 template<size_t n>
 class Signal {
     template<size_t m> friend class Signal;
-    std::array<bool, n> _bits;
+    static constexpr size_t limb_bits = 64;
+    static constexpr size_t limbs = (n + limb_bits - 1) / limb_bits;
+    static constexpr uint64_t top_mask = n % limb_bits == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (n % limb_bits)) - 1;
+    std::array<uint64_t, limbs> _limbs{};
+
+    void mask() { _limbs[limbs - 1] &= top_mask; }
+
+    // returns the 64 bits starting at bit `offset`, with bits past the end of the signal read as zero
+    uint64_t word_at(size_t offset) const
+    {
+        size_t index = offset / limb_bits, shift = offset % limb_bits;
+        if(index >= limbs)
+            return 0;
+        uint64_t word = _limbs[index] >> shift;
+        if(shift != 0 && index + 1 < limbs)
+            word |= _limbs[index + 1] << (limb_bits - shift);
+        return word;
+    }
+
+    Signal<n> shift_left(size_t amount) const
+    {
+        Signal<n> ret;
+        if(amount >= n)
+            return ret;
+        size_t index = amount / limb_bits, shift = amount % limb_bits;
+        for(size_t i = limbs; i-- > index; ) {
+            ret._limbs[i] = _limbs[i - index] << shift;
+            if(shift != 0 && i > index)
+                ret._limbs[i] |= _limbs[i - index - 1] >> (limb_bits - shift);
+        }
+        ret.mask();
+        return ret;
+    }
+
+    Signal<n> shift_right(size_t amount) const
+    {
+        Signal<n> ret;
+        if(amount >= n)
+            return ret;
+        for(size_t i = 0; i < limbs; i++)
+            ret._limbs[i] = word_at(amount + i * limb_bits);
+        return ret;
+    }
+
 public:
     Signal() { }
     Signal(uint32_t val)
     {
-        for(size_t i = 0; i < n; i++)
-            if(i < 32)
-                _bits[i] = val & (1<<i);
-            else
-                _bits[i] = false;
+        _limbs[0] = val;
+        mask();
     }
 
     Signal(std::initializer_list<uint32_t> vals)
     {
-        size_t k, i;
-
-        k = 0;
-        for (auto val : vals) {
-            for(i = 0; i < 32; i++)
-                if(i + k < n)
-                    _bits[i + k] = val & (1<<i);
-            k += 32;
-        }
-        for(; k < n; k++)
-            _bits[k] = false;
+        *this = from_array(vals);
     }
 
     template<typename T>
     static Signal from_array(T vals)
     {
-        size_t k, i;
         Signal ret;
-
-        k = 0;
+        size_t k = 0;
         for (auto val : vals) {
-            for(i = 0; i < 32; i++)
-                if(i + k < n)
-                    ret._bits[i + k] = val & (1<<i);
+            if(k < n)
+                ret._limbs[k / limb_bits] |= (uint64_t)(uint32_t)val << (k % limb_bits);
             k += 32;
         }
-        for(; k < n; k++)
-            ret._bits[k] = false;
+        ret.mask();
         return ret;
     }
 
     static Signal from_signed(int32_t val)
     {
-        Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            if(i < 32)
-                ret._bits[i] = val & (1<<i);
-            else
-                ret._bits[i] = val < 0;
+        Signal<n> ret = repeat(val < 0);
+        ret._limbs[0] = (uint64_t)(int64_t)val;
+        ret.mask();
         return ret;
     }
     static Signal repeat(bool b)
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = b;
+        if(b) {
+            ret._limbs.fill(~(uint64_t)0);
+            ret.mask();
+        }
         return ret;
     }
 
     int size() const { return n; }
-    bool operator[](int i) const { assert(n >= 0 && i < n); return _bits[i]; }
+    bool operator[](int i) const { assert(n >= 0 && i < n); return (_limbs[i / limb_bits] >> (i % limb_bits)) & 1; }
 
     template<size_t m>
     Signal<m> slice(size_t offset) const
@@ -102,52 +131,60 @@ public:
         Signal<m> ret;
 
         assert(offset + m <= n);
-        std::copy(_bits.begin() + offset, _bits.begin() + offset + m, ret._bits.begin());
+        for(size_t i = 0; i < Signal<m>::limbs; i++)
+            ret._limbs[i] = word_at(offset + i * limb_bits);
+        ret.mask();
         return ret;
     }
 
     bool any() const
     {
-        for(int i = 0; i < n; i++)
-            if(_bits[i])
+        for(size_t i = 0; i < limbs; i++)
+            if(_limbs[i] != 0)
                 return true;
         return false;
     }
 
     bool all() const
     {
-        for(int i = 0; i < n; i++)
-            if(!_bits[i])
+        for(size_t i = 0; i + 1 < limbs; i++)
+            if(_limbs[i] != ~(uint64_t)0)
                 return false;
-        return true;
+        return _limbs[limbs - 1] == top_mask;
     }
 
     bool parity() const
     {
-        bool result = false;
-        for(int i = 0; i < n; i++)
-            result ^= _bits[i];
-        return result;
+        uint64_t x = 0;
+        for(size_t i = 0; i < limbs; i++)
+            x ^= _limbs[i];
+        for(size_t shift = limb_bits / 2; shift > 0; shift /= 2)
+            x ^= x >> shift;
+        return x & 1;
     }
 
-    bool sign() const { return _bits[n-1]; }
+    bool sign() const { return (*this)[n-1]; }
 
     template<typename T>
     T as_numeric() const
     {
         T ret = 0;
-        for(size_t i = 0; i < std::min<size_t>(sizeof(T) * 8, n); i++)
-            if(_bits[i])
-                ret |= ((T)1)<<i;
+        for(size_t i = 0; i < limbs && i * limb_bits < sizeof(T) * 8; i++)
+            ret |= ((T)_limbs[i]) << (i * limb_bits);
         return ret;
     }
 
     template<typename T>
     T as_numeric_clamped() const
     {
-        for(size_t i = sizeof(T) * 8; i < n; i++)
-            if(_bits[i])
+        constexpr size_t bits = sizeof(T) * 8;
+        for(size_t i = 0; i < limbs; i++) {
+            size_t low = i * limb_bits;
+            if(low + limb_bits <= bits)
+                continue;
+            if(low >= bits ? _limbs[i] != 0 : (_limbs[i] >> (bits - low)) != 0)
                 return ~((T)0);
+        }
         return as_numeric<T>();
     }
 
@@ -157,7 +194,7 @@ private:
     std::string as_string_p2(int b) const {
         std::string ret;
         for(int i = (n - 1) - (n - 1) % b; i >= 0; i -= b)
-            ret += "0123456789abcdef"[(*this >> Signal<32>(i)).as_int() & ((1<<b)-1)];
+            ret += "0123456789abcdef"[word_at(i) & ((1<<b)-1)];
         return ret;
     }
     std::string as_string_b10() const {
@@ -198,57 +235,68 @@ public:
     Signal<n> operator ~() const
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = !_bits[i];
+        for(size_t i = 0; i < limbs; i++)
+            ret._limbs[i] = ~_limbs[i];
+        ret.mask();
         return ret;
     }
 
     Signal<n> operator -() const
     {
-        Signal<n> ret;
-        int x = 1;
-        for(size_t i = 0; i < n; i++) {
-            x += (int)!_bits[i];
-            ret._bits[i] = (x & 1) != 0;
-            x >>= 1;
-        }
-        return ret;
+        return Signal<n>(0) - *this;
     }
 
     Signal<n> operator +(Signal<n> const &b) const
     {
         Signal<n> ret;
-        int x = 0;
-        for(size_t i = 0; i < n; i++){
-            x += (int)_bits[i] + (int)b._bits[i];
-            ret._bits[i] = x & 1;
-            x >>= 1;
+        uint64_t carry = 0;
+        for(size_t i = 0; i < limbs; i++){
+            uint64_t sum = _limbs[i] + carry;
+            carry = sum < carry;
+            ret._limbs[i] = sum + b._limbs[i];
+            carry += ret._limbs[i] < sum;
         }
+        ret.mask();
         return ret;
     }
 
     Signal<n> operator -(Signal<n> const &b) const
     {
         Signal<n> ret;
-        int x = 1;
-        for(size_t i = 0; i < n; i++){
-            x += (int)_bits[i] + (int)!b._bits[i];
-            ret._bits[i] = x & 1;
-            x >>= 1;
+        uint64_t borrow = 0;
+        for(size_t i = 0; i < limbs; i++){
+            uint64_t diff = _limbs[i] - b._limbs[i];
+            uint64_t next_borrow = _limbs[i] < b._limbs[i];
+            next_borrow |= diff < borrow;
+            ret._limbs[i] = diff - borrow;
+            borrow = next_borrow;
         }
+        ret.mask();
         return ret;
     }
 
     Signal<n> operator *(Signal<n> const &b) const
     {
         Signal<n> ret;
-        int x = 0;
-        for(size_t i = 0; i < n; i++){
-            for(size_t j = 0; j <= i; j++)
-                x += (int)_bits[j] & (int)b._bits[i-j];
-            ret._bits[i] = x & 1;
-            x >>= 1;
+        if constexpr (limbs == 1) {
+            ret._limbs[0] = _limbs[0] * b._limbs[0];
+        } else {
+            // schoolbook multiplication on 32-bit digits, so that every partial product fits into 64 bits
+            constexpr size_t digits = limbs * 2;
+            auto digit = [](Signal<n> const &s, size_t i) { return (s._limbs[i / 2] >> (i % 2 * 32)) & 0xffffffff; };
+            std::array<uint64_t, digits> product{};
+            for(size_t i = 0; i < digits; i++) {
+                uint64_t carry = 0;
+                for(size_t j = 0; i + j < digits; j++) {
+                    uint64_t t = digit(*this, i) * digit(b, j) + product[i + j] + carry;
+                    product[i + j] = t & 0xffffffff;
+                    carry = t >> 32;
+                }
+            }
+            for(size_t i = 0; i < limbs; i++)
+                ret._limbs[i] = product[2 * i] | (product[2 * i + 1] << 32);
         }
+        ret.mask();
         return ret;
     }
 
@@ -256,14 +304,23 @@ private:
     Signal<n> divmod(Signal<n> const &b, bool modulo) const
     {
         if(!b.any()) return 0;
+        if constexpr (limbs == 1) {
+            Signal<n> ret;
+            ret._limbs[0] = modulo ? _limbs[0] % b._limbs[0] : _limbs[0] / b._limbs[0];
+            return ret;
+        }
+        // restoring division, skipping the leading zeros of the dividend
         Signal<n> q = 0;
         Signal<n> r = 0;
-        for(size_t i = n; i-- != 0; ){
-            r = r << Signal<1>(1);
-            r._bits[0] = _bits[i];
+        size_t i = n;
+        while(i > 0 && _limbs[(i - 1) / limb_bits] == 0)
+            i -= (i - 1) % limb_bits + 1;
+        while(i-- != 0){
+            r = r.shift_left(1);
+            r._limbs[0] |= (*this)[i];
             if(r >= b){
                 r = r - b;
-                q._bits[i] = true;
+                q._limbs[i / limb_bits] |= (uint64_t)1 << (i % limb_bits);
             }
         }
         return modulo ? r : q;
@@ -275,115 +332,101 @@ public:
 
     bool operator ==(Signal<n> const &b) const
     {
-        for(size_t i = 0; i < n; i++)
-            if(_bits[i] != b._bits[i])
-                return false;
-        return true;
+        return _limbs == b._limbs;
     }
 
     bool operator >=(Signal<n> const &b) const
     {
-        for(size_t i = n; i-- != 0; )
-            if(_bits[i] != b._bits[i])
-                return _bits[i];
+        for(size_t i = limbs; i-- != 0; )
+            if(_limbs[i] != b._limbs[i])
+                return _limbs[i] > b._limbs[i];
         return true;
     }
 
     bool operator >(Signal<n> const &b) const
     {
-        for(size_t i = n; i-- != 0; )
-            if(_bits[i] != b._bits[i])
-                return _bits[i];
+        for(size_t i = limbs; i-- != 0; )
+            if(_limbs[i] != b._limbs[i])
+                return _limbs[i] > b._limbs[i];
         return false;
     }
 
     bool operator !=(Signal<n> const &b) const { return !(*this == b); }
-    bool operator <=(Signal<n> const &b) const { return b <= *this; }
-    bool operator <(Signal<n> const &b) const { return b < *this; }
+    bool operator <=(Signal<n> const &b) const { return b >= *this; }
+    bool operator <(Signal<n> const &b) const { return b > *this; }
 
     bool signed_greater_than(Signal<n> const &b) const
     {
-        if(_bits[n-1] != b._bits[n-1])
-            return b._bits[n-1];
+        if(sign() != b.sign())
+            return b.sign();
         return *this > b;
     }
 
     bool signed_greater_equal(Signal<n> const &b) const
     {
-        if(_bits[n-1] != b._bits[n-1])
-            return b._bits[n-1];
+        if(sign() != b.sign())
+            return b.sign();
         return *this >= b;
     }
 
     Signal<n> operator &(Signal<n> const &b) const
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = _bits[i] && b._bits[i];
+        for(size_t i = 0; i < limbs; i++)
+            ret._limbs[i] = _limbs[i] & b._limbs[i];
         return ret;
     }
 
     Signal<n> operator |(Signal<n> const &b) const
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = _bits[i] || b._bits[i];
+        for(size_t i = 0; i < limbs; i++)
+            ret._limbs[i] = _limbs[i] | b._limbs[i];
         return ret;
     }
 
     Signal<n> operator ^(Signal<n> const &b) const
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = _bits[i] != b._bits[i];
+        for(size_t i = 0; i < limbs; i++)
+            ret._limbs[i] = _limbs[i] ^ b._limbs[i];
         return ret;
     }
 
     template<size_t nb>
     Signal<n> operator <<(Signal<nb> const &b) const
     {
-        Signal<n> ret = 0;
-        size_t amount = b.template as_numeric_clamped<size_t>();
-        if(amount < n)
-            std::copy(_bits.begin(), _bits.begin() + (n - amount), ret._bits.begin() + amount);
-        return ret;
+        return shift_left(b.template as_numeric_clamped<size_t>());
     }
 
     template<size_t nb>
     Signal<n> operator >>(Signal<nb> const &b) const
     {
-        Signal<n> ret = 0;
-        size_t amount = b.template as_numeric_clamped<size_t>();
-        if(amount < n)
-            std::copy(_bits.begin() + amount, _bits.end(), ret._bits.begin());
-        return ret;
+        return shift_right(b.template as_numeric_clamped<size_t>());
     }
 
     template<size_t nb>
     Signal<n> arithmetic_shift_right(Signal<nb> const &b) const
     {
-        Signal<n> ret = Signal::repeat(sign());
         size_t amount = b.template as_numeric_clamped<size_t>();
-        if(amount < n)
-            std::copy(_bits.begin() + amount, _bits.end(), ret._bits.begin());
+        Signal<n> ret = shift_right(amount);
+        if(sign())
+            ret = ret | ~repeat(true).shift_right(amount);
         return ret;
     }
 
     template<size_t m>
     Signal<n+m> concat(Signal<m> const& b) const
     {
-        Signal<n + m> ret;
-        std::copy(_bits.begin(), _bits.end(), ret._bits.begin());
-        std::copy(b._bits.begin(), b._bits.end(), ret._bits.begin() + n);
-        return ret;
+        return zero_extend<n + m>() | b.template zero_extend<n + m>().shift_left(n);
     }
 
     template<size_t m>
     Signal<m> zero_extend() const
     {
         assert(m >= n);
-        Signal<m> ret = 0;
-        std::copy(_bits.begin(), _bits.end(), ret._bits.begin());
+        Signal<m> ret;
+        std::copy(_limbs.begin(), _limbs.end(), ret._limbs.begin());
         return ret;
     }
 
@@ -391,8 +434,9 @@ public:
     Signal<m> sign_extend() const
     {
         assert(m >= n);
-        Signal<m> ret = Signal<m>::repeat(sign());
-        std::copy(_bits.begin(), _bits.end(), ret._bits.begin());
+        Signal<m> ret = zero_extend<m>();
+        if(sign())
+            ret = ret | Signal<m>::repeat(true).shift_left(n);
         return ret;
     }
 };
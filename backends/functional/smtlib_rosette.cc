@@ -225,10 +225,15 @@ struct SmtrModule {
 				return scope(n.id(), n.name());
 		};
 		visitor.n = node_to_sexpr;
+		// most nodes share a few sorts, print each of them only once
+		dict<Functional::Sort, std::string> sort_comments;
 		for(auto n : ir)
 			if(!inlined(n)) {
 				w.open(list("let", list(list(node_to_sexpr(n), n.visit(visitor)))), false);
-				w.comment(SmtrSort(n.sort()).to_sexpr().to_string(), true);
+				auto it = sort_comments.find(n.sort());
+				if(it == sort_comments.end())
+					it = sort_comments.emplace(n.sort(), SmtrSort(n.sort()).to_sexpr().to_string()).first;
+				w.comment(it->second, true);
 			}
 		w.open(list("cons"));
 		output_struct.write_value(w, [&](IdString name) { return node_to_sexpr(ir.output(name).value()); });
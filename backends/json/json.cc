@@ -24,12 +24,69 @@
 #include "kernel/cellaigs.h"
 #include "kernel/log.h"
 #include <string>
+#include <charconv>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// Output buffer for the JSON text. Values are formatted straight into the
+// string. A buffer with a stream passes its contents on in large chunks, one
+// without collects the text rendered by a parallel job.
+struct JsonBuffer
+{
+	static const size_t chunk_size = 1 << 20;
+
+	std::ostream *f;
+	std::string buf;
+
+	JsonBuffer(std::ostream *f = nullptr) : f(f) { }
+	~JsonBuffer() { flush(); }
+
+	void flush()
+	{
+		if (f != nullptr && !buf.empty()) {
+			f->write(buf.data(), buf.size());
+			buf.clear();
+		}
+	}
+
+	void check()
+	{
+		if (f != nullptr && buf.size() >= chunk_size)
+			flush();
+	}
+
+	void append(JsonBuffer &other)
+	{
+		buf += other.buf;
+		other.buf.clear();
+		check();
+	}
+
+	JsonBuffer &operator<<(const char *str) { buf += str; return *this; }
+	JsonBuffer &operator<<(const std::string &str) { buf += str; return *this; }
+	JsonBuffer &operator<<(char c) { buf += c; return *this; }
+
+	JsonBuffer &operator<<(int value)
+	{
+		char tmp[16];
+		buf.append(tmp, std::to_chars(tmp, tmp + sizeof(tmp), value).ptr);
+		return *this;
+	}
+
+	JsonBuffer &operator<<(unsigned int value)
+	{
+		char tmp[16];
+		buf.append(tmp, std::to_chars(tmp, tmp + sizeof(tmp), value).ptr);
+		return *this;
+	}
+};
+
 struct JsonWriter
 {
+	// number of cells or nets rendered by one parallel job
+	static const int chunk_size = 4096;
+
 	std::ostream &f;
 	bool use_selection;
 	bool aig_mode;
@@ -37,71 +94,88 @@ struct JsonWriter
 	bool scopeinfo_mode;
 
 	Design *design;
-	Module *module;
-
-	SigMap sigmap;
-	int sigidcounter;
-	dict<SigBit, string> sigids;
 	pool<Aig> aig_models;
 
+	// Everything about a module that needs the signal map or lookups in
+	// shared tables. It is collected serially, so that the text itself can
+	// be rendered on several threads.
+	struct ModuleInfo
+	{
+		Module *module;
+		vector<Wire*> ports, netnames;
+		vector<Cell*> cells;
+		vector<RTLIL::Memory*> memories;
+		vector<string> cell_models;
+		vector<bool> cell_known;
+		// bit ids in output order, -1 to -4 stand for "0", "1", "z" and "x"
+		vector<int> bits;
+		vector<int> port_bits, cell_bits, netname_bits;
+		// directions of the connections of known cells: 0 output, 1 input, 2 inout
+		vector<char> directions;
+		vector<int> cell_directions;
+	};
+
 	JsonWriter(std::ostream &f, bool use_selection, bool aig_mode, bool compat_int_mode, bool scopeinfo_mode) :
 			f(f), use_selection(use_selection), aig_mode(aig_mode),
 			compat_int_mode(compat_int_mode), scopeinfo_mode(scopeinfo_mode) { }
 
-	string get_string(string str)
+	void write_string(JsonBuffer &out, const string &str)
 	{
-		string newstr = "\"";
-		for (char c : str) {
+		out.buf += '"';
+		size_t start = 0;
+		for (size_t i = 0; i < str.size(); i++) {
+			char c = str[i];
+			const char *escaped;
 			if (c == '\\')
-				newstr += "\\\\";
+				escaped = "\\\\";
 			else if (c == '"')
-				newstr += "\\\"";
+				escaped = "\\\"";
 			else if (c == '\b')
-				newstr += "\\b";
+				escaped = "\\b";
 			else if (c == '\f')
-				newstr += "\\f";
+				escaped = "\\f";
 			else if (c == '\n')
-				newstr += "\\n";
+				escaped = "\\n";
 			else if (c == '\r')
-				newstr += "\\r";
+				escaped = "\\r";
 			else if (c == '\t')
-				newstr += "\\t";
+				escaped = "\\t";
 			else if (c < 0x20)
-				newstr += stringf("\\u%04X", c);
+				escaped = nullptr;
+			else
+				continue;
+			out.buf.append(str, start, i - start);
+			if (escaped != nullptr)
+				out.buf += escaped;
 			else
-				newstr += c;
+				out.buf += stringf("\\u%04X", c);
+			start = i + 1;
 		}
-		return newstr + "\"";
+		out.buf.append(str, start, string::npos);
+		out.buf += '"';
 	}
 
-	string get_name(IdString name)
+	void write_name(JsonBuffer &out, IdString name)
 	{
-		return get_string(RTLIL::unescape_id(name));
+		write_string(out, RTLIL::unescape_id(name));
 	}
 
-	string get_bits(SigSpec sig)
+	void write_bits(JsonBuffer &out, const vector<int> &bits, int begin, int end)
 	{
-		bool first = true;
-		string str = "[";
-		for (auto bit : sigmap(sig)) {
-			str += first ? " " : ", ";
-			first = false;
-			if (sigids.count(bit) == 0) {
-				string &s = sigids[bit];
-				if (bit.wire == nullptr) {
-					if (bit == State::S0) s = "\"0\"";
-					else if (bit == State::S1) s = "\"1\"";
-					else if (bit == State::Sz) s = "\"z\"";
-					else s = "\"x\"";
-				} else
-					s = stringf("%d", sigidcounter++);
-			}
-			str += sigids[bit];
+		static const char *const const_bits[] = { "\"0\"", "\"1\"", "\"z\"", "\"x\"" };
+
+		out << '[';
+		for (int i = begin; i < end; i++) {
+			out << (i == begin ? " " : ", ");
+			if (bits[i] >= 0)
+				out << bits[i];
+			else
+				out << const_bits[-bits[i] - 1];
 		}
-		return str + " ]";
+		out << " ]";
 	}
 
-	void write_parameter_value(const Const &value)
+	void write_parameter_value(JsonBuffer &out, const Const &value)
 	{
 		if ((value.flags & RTLIL::ConstFlags::CONST_FLAG_STRING) != 0) {
 			string str = value.decode_string();
@@ -119,170 +193,280 @@ struct JsonWriter
 			}
 			if (state < 2)
 				str += " ";
-			f << get_string(str);
+			write_string(out, str);
 		} else if (compat_int_mode && GetSize(value) <= 32 && value.is_fully_def()) {
 			if ((value.flags & RTLIL::ConstFlags::CONST_FLAG_SIGNED) != 0)
-				f << stringf("%d", value.as_int());
+				out << value.as_int();
 			else
-				f << stringf("%u", value.as_int());
+				out << (unsigned int)value.as_int();
 		} else {
-			f << get_string(value.as_string());
+			write_string(out, value.as_string());
 		}
 	}
 
-	void write_parameters(const dict<IdString, Const> &parameters, bool for_module=false)
+	void write_parameters(JsonBuffer &out, const dict<IdString, Const> &parameters, bool for_module=false)
 	{
 		bool first = true;
 		for (auto &param : parameters) {
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s%s: ", for_module ? "" : "    ", get_name(param.first).c_str());
-			write_parameter_value(param.second);
+			out << (first ? "\n" : ",\n");
+			out << (for_module ? "        " : "            ");
+			write_name(out, param.first);
+			out << ": ";
+			write_parameter_value(out, param.second);
 			first = false;
 		}
 	}
 
-	void write_module(Module *module_)
+	void collect_module(ModuleInfo &info, Module *module)
 	{
-		module = module_;
 		log_assert(module->design == design);
-		sigmap.set(module);
-		sigids.clear();
-
-		// reserve 0 and 1 to avoid confusion with "0" and "1"
-		sigidcounter = 2;
 
 		if (module->has_processes()) {
 			log_error("Module %s contains processes, which are not supported by JSON backend (run `proc` first).\n", log_id(module));
 		}
 
-		f << stringf("    %s: {\n", get_name(module->name).c_str());
+		SigMap sigmap(module);
+		dict<SigBit, int> sigids;
+
+		// reserve 0 and 1 to avoid confusion with "0" and "1"
+		int sigidcounter = 2;
 
-		f << stringf("      \"attributes\": {");
-		write_parameters(module->attributes, /*for_module=*/true);
-		f << stringf("\n      },\n");
+		auto add_bits = [&](const SigSpec &sig) {
+			for (auto bit : sigmap(sig)) {
+				if (bit.wire == nullptr) {
+					if (bit == State::S0) info.bits.push_back(-1);
+					else if (bit == State::S1) info.bits.push_back(-2);
+					else if (bit == State::Sz) info.bits.push_back(-3);
+					else info.bits.push_back(-4);
+				} else {
+					int &id = sigids[bit];
+					if (id == 0)
+						id = sigidcounter++;
+					info.bits.push_back(id);
+				}
+			}
+		};
 
-		if (module->parameter_default_values.size()) {
-			f << stringf("      \"parameter_default_values\": {");
-			write_parameters(module->parameter_default_values, /*for_module=*/true);
-			f << stringf("\n      },\n");
-		}
+		info.module = module;
 
-		f << stringf("      \"ports\": {");
-		bool first = true;
 		for (auto n : module->ports) {
 			Wire *w = module->wire(n);
 			if (use_selection && !module->selected(w))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(n).c_str());
-			f << stringf("          \"direction\": \"%s\",\n", w->port_input ? w->port_output ? "inout" : "input" : "output");
-			if (w->start_offset)
-				f << stringf("          \"offset\": %d,\n", w->start_offset);
-			if (w->upto)
-				f << stringf("          \"upto\": 1,\n");
-			if (w->is_signed)
-				f << stringf("          \"signed\": %d,\n", w->is_signed);
-			f << stringf("          \"bits\": %s\n", get_bits(w).c_str());
-			f << stringf("        }");
-			first = false;
+			info.ports.push_back(w);
+			info.port_bits.push_back(GetSize(info.bits));
+			add_bits(w);
 		}
-		f << stringf("\n      },\n");
+		info.port_bits.push_back(GetSize(info.bits));
 
-		f << stringf("      \"cells\": {");
-		first = true;
 		for (auto c : module->cells()) {
 			if (use_selection && !module->selected(c))
 				continue;
 			if (!scopeinfo_mode && c->type == ID($scopeinfo))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(c->name).c_str());
-			f << stringf("          \"hide_name\": %s,\n", c->name[0] == '$' ? "1" : "0");
-			f << stringf("          \"type\": %s,\n", get_name(c->type).c_str());
+			info.cells.push_back(c);
 			if (aig_mode) {
-				Aig aig(c);
-				if (!aig.name.empty()) {
-					f << stringf("          \"model\": \"%s\",\n", aig.name.c_str());
+				const Aig &aig = Aig::cached(c);
+				if (!aig.name.empty())
 					aig_models.insert(aig);
-				}
+				info.cell_models.push_back(aig.name);
 			}
-			f << stringf("          \"parameters\": {");
-			write_parameters(c->parameters);
-			f << stringf("\n          },\n");
-			f << stringf("          \"attributes\": {");
-			write_parameters(c->attributes);
-			f << stringf("\n          },\n");
-			if (c->known()) {
-				f << stringf("          \"port_directions\": {");
-				bool first2 = true;
-				for (auto &conn : c->connections()) {
-					string direction = "output";
-					if (c->input(conn.first))
-						direction = c->output(conn.first) ? "inout" : "input";
-					f << stringf("%s\n", first2 ? "" : ",");
-					f << stringf("            %s: \"%s\"", get_name(conn.first).c_str(), direction.c_str());
-					first2 = false;
-				}
-				f << stringf("\n          },\n");
+			bool known = c->known();
+			info.cell_known.push_back(known);
+			info.cell_directions.push_back(GetSize(info.directions));
+			info.cell_bits.push_back(GetSize(info.bits));
+			for (auto &conn : c->connections()) {
+				if (known)
+					info.directions.push_back(c->input(conn.first) ? c->output(conn.first) ? 2 : 1 : 0);
+				add_bits(conn.second);
 			}
-			f << stringf("          \"connections\": {");
+		}
+		info.cell_bits.push_back(GetSize(info.bits));
+
+		for (auto &it : module->memories)
+			if (!use_selection || module->selected(it.second))
+				info.memories.push_back(it.second);
+
+		for (auto w : module->wires()) {
+			if (use_selection && !module->selected(w))
+				continue;
+			info.netnames.push_back(w);
+			info.netname_bits.push_back(GetSize(info.bits));
+			add_bits(w);
+		}
+		info.netname_bits.push_back(GetSize(info.bits));
+	}
+
+	void write_cell(JsonBuffer &out, const ModuleInfo &info, int index)
+	{
+		static const char *const directions[] = { "output", "input", "inout" };
+
+		Cell *c = info.cells[index];
+		out << (index == 0 ? "\n" : ",\n");
+		out << "        ";
+		write_name(out, c->name);
+		out << ": {\n";
+		out << "          \"hide_name\": " << (c->name[0] == '$' ? "1" : "0") << ",\n";
+		out << "          \"type\": ";
+		write_name(out, c->type);
+		out << ",\n";
+		if (aig_mode && !info.cell_models[index].empty())
+			out << "          \"model\": \"" << info.cell_models[index] << "\",\n";
+		out << "          \"parameters\": {";
+		write_parameters(out, c->parameters);
+		out << "\n          },\n";
+		out << "          \"attributes\": {";
+		write_parameters(out, c->attributes);
+		out << "\n          },\n";
+		if (info.cell_known[index]) {
+			out << "          \"port_directions\": {";
+			int dir = info.cell_directions[index];
 			bool first2 = true;
 			for (auto &conn : c->connections()) {
-				f << stringf("%s\n", first2 ? "" : ",");
-				f << stringf("            %s: %s", get_name(conn.first).c_str(), get_bits(conn.second).c_str());
+				out << (first2 ? "\n" : ",\n");
+				out << "            ";
+				write_name(out, conn.first);
+				out << ": \"" << directions[int(info.directions[dir++])] << "\"";
 				first2 = false;
 			}
-			f << stringf("\n          }\n");
-			f << stringf("        }");
-			first = false;
+			out << "\n          },\n";
+		}
+		out << "          \"connections\": {";
+		int bit = info.cell_bits[index];
+		bool first2 = true;
+		for (auto &conn : c->connections()) {
+			out << (first2 ? "\n" : ",\n");
+			out << "            ";
+			write_name(out, conn.first);
+			out << ": ";
+			write_bits(out, info.bits, bit, bit + GetSize(conn.second));
+			bit += GetSize(conn.second);
+			first2 = false;
 		}
-		f << stringf("\n      },\n");
+		out << "\n          }\n";
+		out << "        }";
+	}
 
-		if (!module->memories.empty()) {
-			f << stringf("      \"memories\": {");
-			first = true;
-			for (auto &it : module->memories) {
-				if (use_selection && !module->selected(it.second))
-					continue;
-				f << stringf("%s\n", first ? "" : ",");
-				f << stringf("        %s: {\n", get_name(it.second->name).c_str());
-				f << stringf("          \"hide_name\": %s,\n", it.second->name[0] == '$' ? "1" : "0");
-				f << stringf("          \"attributes\": {");
-				write_parameters(it.second->attributes);
-				f << stringf("\n          },\n");
-				f << stringf("          \"width\": %d,\n", it.second->width);
-				f << stringf("          \"start_offset\": %d,\n", it.second->start_offset);
-				f << stringf("          \"size\": %d\n", it.second->size);
-				f << stringf("        }");
-				first = false;
+	void write_netname(JsonBuffer &out, const ModuleInfo &info, int index)
+	{
+		Wire *w = info.netnames[index];
+		out << (index == 0 ? "\n" : ",\n");
+		out << "        ";
+		write_name(out, w->name);
+		out << ": {\n";
+		out << "          \"hide_name\": " << (w->name[0] == '$' ? "1" : "0") << ",\n";
+		out << "          \"bits\": ";
+		write_bits(out, info.bits, info.netname_bits[index], info.netname_bits[index + 1]);
+		out << ",\n";
+		if (w->start_offset)
+			out << "          \"offset\": " << w->start_offset << ",\n";
+		if (w->upto)
+			out << "          \"upto\": 1,\n";
+		if (w->is_signed)
+			out << "          \"signed\": " << int(w->is_signed) << ",\n";
+		out << "          \"attributes\": {";
+		write_parameters(out, w->attributes);
+		out << "\n          }\n";
+		out << "        }";
+	}
+
+	// Render count items in order. Large lists are split into chunks that are
+	// rendered on parallel threads and then appended in order.
+	void write_items(JsonBuffer &out, int count, const std::function<void(JsonBuffer&, int)> &render)
+	{
+		int threads = Pass::parallel_threads(design);
+		if (threads <= 1 || count < 2 * chunk_size) {
+			for (int i = 0; i < count; i++) {
+				render(out, i);
+				out.check();
 			}
-			f << stringf("\n      },\n");
+			return;
 		}
 
-		f << stringf("      \"netnames\": {");
-		first = true;
-		for (auto w : module->wires()) {
-			if (use_selection && !module->selected(w))
-				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(w->name).c_str());
-			f << stringf("          \"hide_name\": %s,\n", w->name[0] == '$' ? "1" : "0");
-			f << stringf("          \"bits\": %s,\n", get_bits(w).c_str());
+		int num_chunks = (count + chunk_size - 1) / chunk_size;
+		int round_size = 4 * threads;
+		for (int first = 0; first < num_chunks; first += round_size) {
+			int n = std::min(round_size, num_chunks - first);
+			vector<JsonBuffer> chunks(n);
+			Pass::parallel_for(design, n, [&](int i) {
+				int begin = (first + i) * chunk_size;
+				int end = std::min(count, begin + chunk_size);
+				for (int k = begin; k < end; k++)
+					render(chunks[i], k);
+			});
+			for (auto &chunk : chunks)
+				out.append(chunk);
+		}
+	}
+
+	void write_module(JsonBuffer &out, const ModuleInfo &info)
+	{
+		Module *module = info.module;
+
+		out << "    ";
+		write_name(out, module->name);
+		out << ": {\n";
+
+		out << "      \"attributes\": {";
+		write_parameters(out, module->attributes, /*for_module=*/true);
+		out << "\n      },\n";
+
+		if (module->parameter_default_values.size()) {
+			out << "      \"parameter_default_values\": {";
+			write_parameters(out, module->parameter_default_values, /*for_module=*/true);
+			out << "\n      },\n";
+		}
+
+		out << "      \"ports\": {";
+		for (int i = 0; i < GetSize(info.ports); i++) {
+			Wire *w = info.ports[i];
+			out << (i == 0 ? "\n" : ",\n");
+			out << "        ";
+			write_name(out, w->name);
+			out << ": {\n";
+			out << "          \"direction\": \"" << (w->port_input ? w->port_output ? "inout" : "input" : "output") << "\",\n";
 			if (w->start_offset)
-				f << stringf("          \"offset\": %d,\n", w->start_offset);
+				out << "          \"offset\": " << w->start_offset << ",\n";
 			if (w->upto)
-				f << stringf("          \"upto\": 1,\n");
+				out << "          \"upto\": 1,\n";
 			if (w->is_signed)
-				f << stringf("          \"signed\": %d,\n", w->is_signed);
-			f << stringf("          \"attributes\": {");
-			write_parameters(w->attributes);
-			f << stringf("\n          }\n");
-			f << stringf("        }");
-			first = false;
+				out << "          \"signed\": " << int(w->is_signed) << ",\n";
+			out << "          \"bits\": ";
+			write_bits(out, info.bits, info.port_bits[i], info.port_bits[i + 1]);
+			out << "\n";
+			out << "        }";
+		}
+		out << "\n      },\n";
+
+		out << "      \"cells\": {";
+		write_items(out, GetSize(info.cells), [&](JsonBuffer &o, int i) { write_cell(o, info, i); });
+		out << "\n      },\n";
+
+		if (!module->memories.empty()) {
+			out << "      \"memories\": {";
+			for (int i = 0; i < GetSize(info.memories); i++) {
+				RTLIL::Memory *mem = info.memories[i];
+				out << (i == 0 ? "\n" : ",\n");
+				out << "        ";
+				write_name(out, mem->name);
+				out << ": {\n";
+				out << "          \"hide_name\": " << (mem->name[0] == '$' ? "1" : "0") << ",\n";
+				out << "          \"attributes\": {";
+				write_parameters(out, mem->attributes);
+				out << "\n          },\n";
+				out << "          \"width\": " << mem->width << ",\n";
+				out << "          \"start_offset\": " << mem->start_offset << ",\n";
+				out << "          \"size\": " << mem->size << "\n";
+				out << "        }";
+			}
+			out << "\n      },\n";
 		}
-		f << stringf("\n      }\n");
 
-		f << stringf("    }");
+		out << "      \"netnames\": {";
+		write_items(out, GetSize(info.netnames), [&](JsonBuffer &o, int i) { write_netname(o, info, i); });
+		out << "\n      }\n";
+
+		out << "    }";
 	}
 
 	void write_design(Design *design_)
@@ -290,48 +474,84 @@ struct JsonWriter
 		design = design_;
 		design->sort();
 
-		f << stringf("{\n");
-		f << stringf("  \"creator\": %s,\n", get_string(yosys_version_str).c_str());
-		f << stringf("  \"modules\": {\n");
+		JsonBuffer out(&f);
+		out << "{\n";
+		out << "  \"creator\": ";
+		write_string(out, yosys_version_str);
+		out << ",\n";
+		out << "  \"modules\": {\n";
+
+		// Small modules are collected into batches that are rendered in
+		// parallel, large modules parallelize over their cells and nets.
+		int threads = Pass::parallel_threads(design);
 		vector<Module*> modules = use_selection ? design->selected_modules() : design->modules();
+		vector<ModuleInfo> batch;
+		int batch_size = 0;
 		bool first_module = true;
+
+		auto flush_batch = [&]() {
+			vector<JsonBuffer> texts(GetSize(batch));
+			Pass::parallel_for(design, GetSize(batch), [&](int i) { write_module(texts[i], batch[i]); });
+			for (auto &text : texts) {
+				if (!first_module)
+					out << ",\n";
+				out.append(text);
+				first_module = false;
+			}
+			batch.clear();
+			batch_size = 0;
+		};
+
 		for (auto mod : modules) {
+			ModuleInfo info;
+			collect_module(info, mod);
+			int size = GetSize(info.cells) + GetSize(info.netnames);
+			if (threads > 1 && size < 2 * chunk_size) {
+				batch.push_back(std::move(info));
+				batch_size += size;
+				if (batch_size >= 16 * chunk_size)
+					flush_batch();
+				continue;
+			}
+			flush_batch();
 			if (!first_module)
-				f << stringf(",\n");
-			write_module(mod);
+				out << ",\n";
+			write_module(out, info);
 			first_module = false;
 		}
-		f << stringf("\n  }");
+		flush_batch();
+
+		out << "\n  }";
 		if (!aig_models.empty()) {
-			f << stringf(",\n  \"models\": {\n");
+			out << ",\n  \"models\": {\n";
 			bool first_model = true;
 			for (auto &aig : aig_models) {
 				if (!first_model)
-					f << stringf(",\n");
-				f << stringf("    \"%s\": [\n", aig.name.c_str());
+					out << ",\n";
+				out << "    \"" << aig.name << "\": [\n";
 				int node_idx = 0;
 				for (auto &node : aig.nodes) {
 					if (node_idx != 0)
-						f << stringf(",\n");
-					f << stringf("      /* %3d */ [ ", node_idx);
+						out << ",\n";
+					out << stringf("      /* %3d */ [ ", node_idx);
 					if (node.portbit >= 0)
-						f << stringf("\"%sport\", \"%s\", %d", node.inverter ? "n" : "",
-								log_id(node.portname), node.portbit);
+						out << "\"" << (node.inverter ? "n" : "") << "port\", \"" << log_id(node.portname) << "\", " << node.portbit;
 					else if (node.left_parent < 0 && node.right_parent < 0)
-						f << stringf("\"%s\"", node.inverter ? "true" : "false");
+						out << "\"" << (node.inverter ? "true" : "false") << "\"";
 					else
-						f << stringf("\"%s\", %d, %d", node.inverter ? "nand" : "and", node.left_parent, node.right_parent);
+						out << "\"" << (node.inverter ? "nand" : "and") << "\", " << node.left_parent << ", " << node.right_parent;
 					for (auto &op : node.outports)
-						f << stringf(", \"%s\", %d", log_id(op.first), op.second);
-					f << stringf(" ]");
+						out << ", \"" << log_id(op.first) << "\", " << op.second;
+					out << " ]";
 					node_idx++;
 				}
-				f << stringf("\n    ]");
+				out << "\n    ]";
 				first_model = false;
 			}
-			f << stringf("\n  }");
+			out << "\n  }";
 		}
-		f << stringf("\n}\n");
+		out << "\n}\n";
+		out.flush();
 	}
 };
 
@@ -358,6 +578,10 @@ struct JsonBackend : public Backend {
 		log("    -noscopeinfo\n");
 		log("        don't include $scopeinfo cells in the output\n");
 		log("\n");
+		log("Modules, and the cells and nets of large modules, are rendered on up to\n");
+		log("'parallel.threads' threads (see 'scratchpad'). The output does not depend on\n");
+		log("the number of threads.\n");
+		log("\n");
 		log("\n");
 		log("The general syntax of the JSON output created by this command is as follows:\n");
 		log("\n");
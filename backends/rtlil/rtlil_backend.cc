@@ -24,6 +24,7 @@
 
 #include "rtlil_backend.h"
 #include "kernel/yosys.h"
+#include "kernel/rtlil_binary.h"
 #include <errno.h>
 
 USING_YOSYS_NAMESPACE
@@ -425,7 +426,7 @@ YOSYS_NAMESPACE_END
 PRIVATE_NAMESPACE_BEGIN
 
 struct RTLILBackend : public Backend {
-	RTLILBackend() : Backend("rtlil", "write design to RTLIL file") { }
+	RTLILBackend() : Backend("rtlil", "write design to RTLIL file") { keeps_shared_modules(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -438,10 +439,18 @@ struct RTLILBackend : public Backend {
 		log("    -selected\n");
 		log("        only write selected parts of the design.\n");
 		log("\n");
+		log("    -binary\n");
+		log("        write the compact binary encoding of RTLIL instead of text. Binary\n");
+		log("        files are much faster to write and read back, and are detected\n");
+		log("        automatically by read_rtlil. With -selected, selected modules are\n");
+		log("        written in full, as the binary format can't refer to unselected\n");
+		log("        wires.\n");
+		log("\n");
 	}
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		bool selected = false;
+		bool binary = false;
 
 		log_header(design, "Executing RTLIL backend.\n");
 
@@ -452,13 +461,21 @@ struct RTLILBackend : public Backend {
 				selected = true;
 				continue;
 			}
+			if (arg == "-binary") {
+				binary = true;
+				continue;
+			}
 			break;
 		}
-		extra_args(f, filename, args, argidx);
+		extra_args(f, filename, args, argidx, binary);
 
 		design->sort();
 
 		log("Output filename: %s\n", filename.c_str());
+		if (binary) {
+			RTLIL_BINARY::dump_design(*f, design, selected);
+			return;
+		}
 		*f << stringf("# Generated by %s\n", yosys_version_str);
 		RTLIL_BACKEND::dump_design(*f, design, selected, true, false);
 	}
@@ -34,7 +34,7 @@ struct Smt2Worker
 	CellTypes ct;
 	SigMap sigmap;
 	RTLIL::Module *module;
-	bool bvmode, memmode, wiresmode, verbose, statebv, statedt, forallmode;
+	bool bvmode, memmode, wiresmode, verbose, statebv, statedt, forallmode, dedup_mode;
 	dict<IdString, int> &mod_stbv_width;
 	int idcounter = 0, statebv_width = 0;
 
@@ -53,6 +53,7 @@ struct Smt2Worker
 	std::map<Mem*, int> memarrays;
 	std::map<int, int> bvsizes;
 	dict<IdString, char*> ids;
+	dict<std::string, int> dedup_defines;
 
 	bool is_smtlib2_module;
 
@@ -114,10 +115,10 @@ struct Smt2Worker
 			decls.push_back(decl_str + "\n");
 	}
 
-	Smt2Worker(RTLIL::Module *module, bool bvmode, bool memmode, bool wiresmode, bool verbose, bool statebv, bool statedt, bool forallmode,
+	Smt2Worker(RTLIL::Module *module, bool bvmode, bool memmode, bool wiresmode, bool verbose, bool statebv, bool statedt, bool forallmode, bool dedup_mode,
 		   dict<IdString, int> &mod_stbv_width, dict<IdString, dict<IdString, pair<bool, bool>>> &mod_clk_cache)
 	    : ct(module->design), sigmap(module), module(module), bvmode(bvmode), memmode(memmode), wiresmode(wiresmode), verbose(verbose),
-	      statebv(statebv), statedt(statedt), forallmode(forallmode), mod_stbv_width(mod_stbv_width),
+	      statebv(statebv), statedt(statedt), forallmode(forallmode), dedup_mode(dedup_mode), mod_stbv_width(mod_stbv_width),
 	      is_smtlib2_module(module->has_attribute(ID::smtlib2_module))
 	{
 		pool<SigBit> noclock;
@@ -303,7 +304,7 @@ struct Smt2Worker
 		log_assert(bvmode);
 		sigmap.apply(sig);
 
-		log_assert(bvsizes.count(id) == 0);
+		log_assert(bvsizes.count(id) == 0 || (dedup_mode && bvsizes.at(id) == GetSize(sig)));
 		bvsizes[id] = GetSize(sig);
 
 		for (int i = 0; i < GetSize(sig); i++) {
@@ -325,6 +326,20 @@ struct Smt2Worker
 			sigmap.add(sig[i], RTLIL::State::S0);
 	}
 
+	// With -dedup, returns the id of an earlier function with the same sort and
+	// body. Otherwise returns -1 and, for -dedup, records idcounter for them.
+	int dedup_define(const std::string &sort, const std::string &expr)
+	{
+		if (!dedup_mode)
+			return -1;
+		std::string key = sort + " " + expr;
+		auto it = dedup_defines.find(key);
+		if (it != dedup_defines.end())
+			return it->second;
+		dedup_defines[key] = idcounter;
+		return -1;
+	}
+
 	std::string get_bool(RTLIL::SigBit bit, const char *state_name = "state")
 	{
 		sigmap.apply(bit);
@@ -449,9 +464,13 @@ struct Smt2Worker
 		if (verbose)
 			log("%*s-> import cell: %s\n", 2+2*GetSize(recursive_cells), "", log_id(cell));
 
-		decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
-				get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(bit)));
-		register_bool(bit, idcounter++);
+		int id = dedup_define("Bool", processed_expr);
+		if (id < 0) {
+			decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
+					get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(bit)));
+			id = idcounter++;
+		}
+		register_bool(bit, id);
 		recursive_cells.erase(cell);
 	}
 
@@ -500,13 +519,21 @@ struct Smt2Worker
 			log("%*s-> import cell: %s\n", 2+2*GetSize(recursive_cells), "", log_id(cell));
 
 		if (type == 'b') {
-			decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
-					get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(sig_y)));
-			register_boolvec(sig_y, idcounter++);
+			int id = dedup_define("Bool", processed_expr);
+			if (id < 0) {
+				decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
+						get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(sig_y)));
+				id = idcounter++;
+			}
+			register_boolvec(sig_y, id);
 		} else {
-			decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) (_ BitVec %d) %s) ; %s\n",
-					get_id(module), idcounter, get_id(module), GetSize(sig_y), processed_expr.c_str(), log_signal(sig_y)));
-			register_bv(sig_y, idcounter++);
+			int id = dedup_define(stringf("(_ BitVec %d)", GetSize(sig_y)), processed_expr);
+			if (id < 0) {
+				decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) (_ BitVec %d) %s) ; %s\n",
+						get_id(module), idcounter, get_id(module), GetSize(sig_y), processed_expr.c_str(), log_signal(sig_y)));
+				id = idcounter++;
+			}
+			register_bv(sig_y, id);
 		}
 
 		recursive_cells.erase(cell);
@@ -530,9 +557,13 @@ struct Smt2Worker
 		if (verbose)
 			log("%*s-> import cell: %s\n", 2+2*GetSize(recursive_cells), "", log_id(cell));
 
-		decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
-				get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(sig_y)));
-		register_boolvec(sig_y, idcounter++);
+		int id = dedup_define("Bool", processed_expr);
+		if (id < 0) {
+			decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
+					get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(sig_y)));
+			id = idcounter++;
+		}
+		register_boolvec(sig_y, id);
 		recursive_cells.erase(cell);
 	}
 
@@ -752,9 +783,13 @@ struct Smt2Worker
 					log("%*s-> import cell: %s\n", 2+2*GetSize(recursive_cells), "", log_id(cell));
 
 				RTLIL::SigSpec sig = sigmap(cell->getPort(ID::Y));
-				decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) (_ BitVec %d) %s) ; %s\n",
-						get_id(module), idcounter, get_id(module), width, processed_expr.c_str(), log_signal(sig)));
-				register_bv(sig, idcounter++);
+				int id = dedup_define(stringf("(_ BitVec %d)", width), processed_expr);
+				if (id < 0) {
+					decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) (_ BitVec %d) %s) ; %s\n",
+							get_id(module), idcounter, get_id(module), width, processed_expr.c_str(), log_signal(sig)));
+					id = idcounter++;
+				}
+				register_bv(sig, id);
 				recursive_cells.erase(cell);
 				return;
 			}
@@ -1698,6 +1733,10 @@ struct Smt2Backend : public Backend {
 		log("        create '<mod>_n' functions for all public wires. by default only ports,\n");
 		log("        registers, and wires with the 'keep' attribute are exported.\n");
 		log("\n");
+		log("    -dedup\n");
+		log("        only create one function for cells that compute the same expression\n");
+		log("        from the same inputs, and use it for all of them.\n");
+		log("\n");
 		log("    -tpl <template_file>\n");
 		log("        use the given template file. the line containing only the token '%%%%'\n");
 		log("        is replaced with the regular output of this command.\n");
@@ -1759,7 +1798,7 @@ struct Smt2Backend : public Backend {
 	{
 		std::ifstream template_f;
 		bool bvmode = true, memmode = true, wiresmode = false, verbose = false, statebv = false, statedt = false;
-		bool forallmode = false;
+		bool forallmode = false, dedup_mode = false;
 		dict<std::string, std::string> solver_options;
 
 		log_header(design, "Executing SMT2 backend.\n");
@@ -1809,6 +1848,10 @@ struct Smt2Backend : public Backend {
 				verbose = true;
 				continue;
 			}
+			if (args[argidx] == "-dedup") {
+				dedup_mode = true;
+				continue;
+			}
 			if (args[argidx] == "-solver-option" && argidx+2 < args.size()) {
 				solver_options.emplace(args[argidx+1], args[argidx+2]);
 				argidx += 2;
@@ -1903,7 +1946,7 @@ struct Smt2Backend : public Backend {
 
 			log("Creating SMT-LIBv2 representation of module %s.\n", log_id(module));
 
-			Smt2Worker worker(module, bvmode, memmode, wiresmode, verbose, statebv, statedt, forallmode, mod_stbv_width, mod_clk_cache);
+			Smt2Worker worker(module, bvmode, memmode, wiresmode, verbose, statebv, statedt, forallmode, dedup_mode, mod_stbv_width, mod_clk_cache);
 			worker.run();
 			worker.write(*f);
 
@@ -1579,6 +1579,22 @@ def get_active_assert_map(step, active):
 
     return assert_map
 
+
+design_assert_keys = None
+
+def get_step_assert_exprs(step, assert_expr_map):
+    # While all design assertions of a step are active and there are no
+    # additional constraints, refer to the design's combined assertion function
+    # instead of restating every assertion for each new step.
+    global design_assert_keys
+    if design_assert_keys is None:
+        design_assert_keys = set(get_assert_map(topmod, "state", topmod).keys())
+
+    if design_assert_keys and step not in constr_asserts and design_assert_keys.issubset(assert_expr_map.keys()):
+        return ["(|%s_a| s%d)" % (topmod, step)]
+
+    return [assert_data[0] for assert_data in assert_expr_map.values()]
+
 assume_enables = {}
 
 def declare_assume_enables():
@@ -2019,7 +2035,7 @@ else:  # not tempind, covermode
                     for i in range(step, last_check_step+1):
                         assert_expr_map = get_active_assert_map(i, active_assert_keys)
                         active_assert_maps[i] = assert_expr_map
-                        active_assert_exprs.extend(assert_data[0] for assert_data in assert_expr_map.values())
+                        active_assert_exprs.extend(get_step_assert_exprs(i, assert_expr_map))
 
                     if active_assert_exprs:
                         if len(active_assert_exprs) == 1:
@@ -2093,8 +2109,8 @@ else:  # not tempind, covermode
             if (constr_final_start is not None) or (last_check_step+1 != num_steps):
                 for i in range(step, last_check_step+1):
                     assert_expr_map = get_active_assert_map(i, active_assert_keys)
-                    for assert_data in assert_expr_map.values():
-                        smt_assert(assert_data[0])
+                    for expr in get_step_assert_exprs(i, assert_expr_map):
+                        smt_assert(expr)
 
             if constr_final_start is not None:
                 for i in range(step, last_check_step+1):
@@ -37,22 +37,32 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 bool verbose, norename, noattr, attr2comment, noexpr, nodec, nohex, nostr, extmem, defparam, decimal, siminit, systemverilog, simple_lhs, noparallelcase;
-int auto_name_counter, auto_name_offset, auto_name_digits, extmem_counter;
-dict<RTLIL::IdString, int> auto_name_map;
-std::set<RTLIL::IdString> reg_wires;
+int extmem_counter;
 std::string auto_prefix, extmem_prefix;
 
-RTLIL::Module *active_module;
-dict<RTLIL::SigBit, RTLIL::State> active_initdata;
-SigMap active_sigmap;
-IdString initial_id;
+// State of the module being dumped. Modules are dumped on worker threads, so
+// each thread points to the state of its module, and threads that dump cells
+// of the same module share (and only read) it.
+struct DumpState
+{
+	int auto_name_counter = 0, auto_name_offset = 0, auto_name_digits = 1;
+	dict<RTLIL::IdString, int> auto_name_map;
+	std::set<RTLIL::IdString> reg_wires;
+
+	RTLIL::Module *active_module = nullptr;
+	dict<RTLIL::SigBit, RTLIL::State> active_initdata;
+	SigMap active_sigmap;
+	IdString initial_id;
+};
+
+thread_local DumpState *dump_state;
 
 void reset_auto_counter_id(RTLIL::IdString id, bool may_rename)
 {
 	const char *str = id.c_str();
 
 	if (*str == '$' && may_rename && !norename)
-		auto_name_map[id] = auto_name_counter++;
+		dump_state->auto_name_map[id] = dump_state->auto_name_counter++;
 
 	if (str[0] != '\\' || str[1] != '_' || str[2] == 0)
 		return;
@@ -65,15 +75,16 @@ void reset_auto_counter_id(RTLIL::IdString id, bool may_rename)
 	}
 
 	int num = atoi(str+2);
-	if (num >= auto_name_offset)
-		auto_name_offset = num + 1;
+	if (num >= dump_state->auto_name_offset)
+		dump_state->auto_name_offset = num + 1;
 }
 
 void reset_auto_counter(RTLIL::Module *module)
 {
-	auto_name_map.clear();
-	auto_name_counter = 0;
-	auto_name_offset = 0;
+	dump_state->auto_name_map.clear();
+	dump_state->auto_name_map.reserve(GetSize(module->wires_) + GetSize(module->cells_));
+	dump_state->auto_name_counter = 0;
+	dump_state->auto_name_offset = 0;
 
 	reset_auto_counter_id(module->name, false);
 
@@ -88,18 +99,18 @@ void reset_auto_counter(RTLIL::Module *module)
 	for (auto it = module->processes.begin(); it != module->processes.end(); ++it)
 		reset_auto_counter_id(it->second->name, false);
 
-	auto_name_digits = 1;
-	for (size_t i = 10; i < auto_name_offset + auto_name_map.size(); i = i*10)
-		auto_name_digits++;
+	dump_state->auto_name_digits = 1;
+	for (size_t i = 10; i < dump_state->auto_name_offset + dump_state->auto_name_map.size(); i = i*10)
+		dump_state->auto_name_digits++;
 
 	if (verbose)
-		for (auto it = auto_name_map.begin(); it != auto_name_map.end(); ++it)
-			log("  renaming `%s' to `%s_%0*d_'.\n", it->first.c_str(), auto_prefix.c_str(), auto_name_digits, auto_name_offset + it->second);
+		for (auto it = dump_state->auto_name_map.begin(); it != dump_state->auto_name_map.end(); ++it)
+			log("  renaming `%s' to `%s_%0*d_'.\n", it->first.c_str(), auto_prefix.c_str(), dump_state->auto_name_digits, dump_state->auto_name_offset + it->second);
 }
 
 std::string next_auto_id()
 {
-	return stringf("%s_%0*d_", auto_prefix.c_str(), auto_name_digits, auto_name_offset + auto_name_counter++);
+	return stringf("%s_%0*d_", auto_prefix.c_str(), dump_state->auto_name_digits, dump_state->auto_name_offset + dump_state->auto_name_counter++);
 }
 
 std::string id(RTLIL::IdString internal_id, bool may_rename = true)
@@ -107,8 +118,11 @@ std::string id(RTLIL::IdString internal_id, bool may_rename = true)
 	const char *str = internal_id.c_str();
 	bool do_escape = false;
 
-	if (may_rename && auto_name_map.count(internal_id) != 0)
-		return stringf("%s_%0*d_", auto_prefix.c_str(), auto_name_digits, auto_name_offset + auto_name_map[internal_id]);
+	if (may_rename) {
+		auto it = dump_state->auto_name_map.find(internal_id);
+		if (it != dump_state->auto_name_map.end())
+			return stringf("%s_%0*d_", auto_prefix.c_str(), dump_state->auto_name_digits, dump_state->auto_name_offset + it->second);
+	}
 
 	if (*str == '\\')
 		str++;
@@ -169,7 +183,7 @@ bool is_reg_wire(RTLIL::SigSpec sig, std::string &reg_name)
 
 	RTLIL::SigChunk chunk = sig.as_chunk();
 
-	if (reg_wires.count(chunk.wire->name) == 0)
+	if (dump_state->reg_wires.count(chunk.wire->name) == 0)
 		return false;
 
 	reg_name = id(chunk.wire->name);
@@ -316,9 +330,9 @@ void dump_reg_init(std::ostream &f, SigSpec sig)
 	Const initval;
 	bool gotinit = false;
 
-	for (auto bit : active_sigmap(sig)) {
-		if (active_initdata.count(bit)) {
-			initval.bits().push_back(active_initdata.at(bit));
+	for (auto bit : dump_state->active_sigmap(sig)) {
+		if (dump_state->active_initdata.count(bit)) {
+			initval.bits().push_back(dump_state->active_initdata.at(bit));
 			gotinit = true;
 		} else {
 			initval.bits().push_back(State::Sx);
@@ -336,22 +350,21 @@ void dump_sigchunk(std::ostream &f, const RTLIL::SigChunk &chunk, bool no_decima
 	if (chunk.wire == NULL) {
 		dump_const(f, chunk.data, chunk.width, chunk.offset, no_decimal);
 	} else {
+		f << id(chunk.wire->name);
 		if (chunk.width == chunk.wire->width && chunk.offset == 0) {
-			f << stringf("%s", id(chunk.wire->name).c_str());
+			// whole wire
 		} else if (chunk.width == 1) {
 			if (chunk.wire->upto)
-				f << stringf("%s[%d]", id(chunk.wire->name).c_str(), (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset);
+				f << '[' << (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset << ']';
 			else
-				f << stringf("%s[%d]", id(chunk.wire->name).c_str(), chunk.offset + chunk.wire->start_offset);
+				f << '[' << chunk.offset + chunk.wire->start_offset << ']';
 		} else {
 			if (chunk.wire->upto)
-				f << stringf("%s[%d:%d]", id(chunk.wire->name).c_str(),
-						(chunk.wire->width - (chunk.offset + chunk.width - 1) - 1) + chunk.wire->start_offset,
-						(chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset);
+				f << '[' << (chunk.wire->width - (chunk.offset + chunk.width - 1) - 1) + chunk.wire->start_offset
+						<< ':' << (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset << ']';
 			else
-				f << stringf("%s[%d:%d]", id(chunk.wire->name).c_str(),
-						(chunk.offset + chunk.width - 1) + chunk.wire->start_offset,
-						chunk.offset + chunk.wire->start_offset);
+				f << '[' << (chunk.offset + chunk.width - 1) + chunk.wire->start_offset
+						<< ':' << chunk.offset + chunk.wire->start_offset << ']';
 		}
 	}
 }
@@ -366,13 +379,13 @@ void dump_sigspec(std::ostream &f, const RTLIL::SigSpec &sig)
 	if (sig.is_chunk()) {
 		dump_sigchunk(f, sig.as_chunk());
 	} else {
-		f << stringf("{ ");
+		f << "{ ";
 		for (auto it = sig.chunks().rbegin(); it != sig.chunks().rend(); ++it) {
 			if (it != sig.chunks().rbegin())
-				f << stringf(", ");
+				f << ", ";
 			dump_sigchunk(f, *it, true);
 		}
-		f << stringf(" }");
+		f << " }";
 	}
 }
 
@@ -398,16 +411,16 @@ void dump_attributes(std::ostream &f, std::string indent, dict<RTLIL::IdString,
 
 void dump_wire(std::ostream &f, std::string indent, RTLIL::Wire *wire)
 {
-	dump_attributes(f, indent, wire->attributes, "\n", /*modattr=*/false, /*regattr=*/reg_wires.count(wire->name));
+	dump_attributes(f, indent, wire->attributes, "\n", /*modattr=*/false, /*regattr=*/dump_state->reg_wires.count(wire->name));
 #if 0
 	if (wire->port_input && !wire->port_output)
-		f << stringf("%s" "input %s", indent.c_str(), reg_wires.count(wire->name) ? "reg " : "");
+		f << stringf("%s" "input %s", indent.c_str(), dump_state->reg_wires.count(wire->name) ? "reg " : "");
 	else if (!wire->port_input && wire->port_output)
-		f << stringf("%s" "output %s", indent.c_str(), reg_wires.count(wire->name) ? "reg " : "");
+		f << stringf("%s" "output %s", indent.c_str(), dump_state->reg_wires.count(wire->name) ? "reg " : "");
 	else if (wire->port_input && wire->port_output)
-		f << stringf("%s" "inout %s", indent.c_str(), reg_wires.count(wire->name) ? "reg " : "");
+		f << stringf("%s" "inout %s", indent.c_str(), dump_state->reg_wires.count(wire->name) ? "reg " : "");
 	else
-		f << stringf("%s" "%s ", indent.c_str(), reg_wires.count(wire->name) ? "reg" : "wire");
+		f << stringf("%s" "%s ", indent.c_str(), dump_state->reg_wires.count(wire->name) ? "reg" : "wire");
 	if (wire->width != 1)
 		f << stringf("[%d:%d] ", wire->width - 1 + wire->start_offset, wire->start_offset);
 	f << stringf("%s;\n", id(wire->name).c_str());
@@ -426,7 +439,7 @@ void dump_wire(std::ostream &f, std::string indent, RTLIL::Wire *wire)
 		f << stringf("%s" "output%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
 	if (wire->port_input && wire->port_output)
 		f << stringf("%s" "inout%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
-	if (reg_wires.count(wire->name)) {
+	if (dump_state->reg_wires.count(wire->name)) {
 		f << stringf("%s" "reg%s %s", indent.c_str(), range.c_str(), id(wire->name).c_str());
 		if (wire->attributes.count(ID::init)) {
 			f << stringf(" = ");
@@ -855,7 +868,7 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 					int start_i = i, width = 1;
 					SigBit wen_bit = port.en[sub * mem.width + i];
 
-					while (i+1 < mem.width && active_sigmap(port.en[sub * mem.width + i+1]) == active_sigmap(wen_bit))
+					while (i+1 < mem.width && dump_state->active_sigmap(port.en[sub * mem.width + i+1]) == dump_state->active_sigmap(wen_bit))
 						i++, width++;
 
 					if (wen_bit == State::S0)
@@ -972,7 +985,7 @@ std::string cellname(RTLIL::Cell *cell)
 		if (wire->width != 1)
 			cell_name += stringf("[%d]", wire->start_offset + sig[0].offset);
 
-		if (active_module && active_module->count_id(cell_name) > 0)
+		if (dump_state->active_module && dump_state->active_module->count_id(cell_name) > 0)
 				goto no_special_reg_name;
 
 		return id(cell_name);
@@ -1065,112 +1078,92 @@ void dump_cell_expr_check(std::ostream &f, std::string indent, const RTLIL::Cell
 	f << stringf(");\n");
 }
 
-bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
+bool dump_cell_expr_gate(std::ostream &f, const std::string &indent, RTLIL::Cell *cell)
 {
-	if (cell->type == ID($_NOT_)) {
-		f << stringf("%s" "assign ", indent.c_str());
+	// The fine-grained cells make up most of a gate-level netlist, so the ports
+	// are looked up by their static IDs instead of through dump_cell_expr_port().
+	const IdString &type = cell->type;
+
+	if (type == ID($_NOT_)) {
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
-		f << stringf("~");
+		f << " = ~";
 		dump_attributes(f, "", cell->attributes, " ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		dump_sigspec(f, cell->getPort(ID::A));
+		f << ";\n";
 		return true;
 	}
 
-	if (cell->type.in(ID($_BUF_), ID($buf))) {
-		f << stringf("%s" "assign ", indent.c_str());
+	if (type.in(ID($_BUF_), ID($buf))) {
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		f << " = ";
+		dump_sigspec(f, cell->getPort(ID::A));
+		f << ";\n";
 		return true;
 	}
 
-	if (cell->type.in(ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_))) {
-		f << stringf("%s" "assign ", indent.c_str());
+	if (type.in(ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_))) {
+		bool inverted = type.in(ID($_NAND_), ID($_NOR_), ID($_XNOR_));
+		bool inverted_b = type.in(ID($_ANDNOT_), ID($_ORNOT_));
+		const char *op = type.in(ID($_AND_), ID($_NAND_), ID($_ANDNOT_)) ? "&" :
+				type.in(ID($_OR_), ID($_NOR_), ID($_ORNOT_)) ? "|" : "^";
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
-		if (cell->type.in(ID($_NAND_), ID($_NOR_), ID($_XNOR_)))
-			f << stringf("~(");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(" ");
-		if (cell->type.in(ID($_AND_), ID($_NAND_), ID($_ANDNOT_)))
-			f << stringf("&");
-		if (cell->type.in(ID($_OR_), ID($_NOR_), ID($_ORNOT_)))
-			f << stringf("|");
-		if (cell->type.in(ID($_XOR_), ID($_XNOR_)))
-			f << stringf("^");
+		f << (inverted ? " = ~(" : " = ");
+		dump_sigspec(f, cell->getPort(ID::A));
+		f << ' ' << op;
 		dump_attributes(f, "", cell->attributes, " ");
-		f << stringf(" ");
-		if (cell->type.in(ID($_ANDNOT_), ID($_ORNOT_)))
-			f << stringf("~(");
-		dump_cell_expr_port(f, cell, "B", false);
-		if (cell->type.in(ID($_NAND_), ID($_NOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_)))
-			f << stringf(")");
-		f << stringf(";\n");
+		f << (inverted_b ? " ~(" : " ");
+		dump_sigspec(f, cell->getPort(ID::B));
+		f << (inverted || inverted_b ? ");\n" : ";\n");
 		return true;
 	}
 
-	if (cell->type == ID($_MUX_)) {
-		f << stringf("%s" "assign ", indent.c_str());
+	if (type.in(ID($_MUX_), ID($_NMUX_))) {
+		bool inverted = type == ID($_NMUX_);
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
-		dump_cell_expr_port(f, cell, "S", false);
-		f << stringf(" ? ");
+		f << (inverted ? " = !(" : " = ");
+		dump_sigspec(f, cell->getPort(ID::S));
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, " ");
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(" : ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		dump_sigspec(f, cell->getPort(ID::B));
+		f << " : ";
+		dump_sigspec(f, cell->getPort(ID::A));
+		f << (inverted ? ");\n" : ";\n");
 		return true;
 	}
 
-	if (cell->type == ID($_NMUX_)) {
-		f << stringf("%s" "assign ", indent.c_str());
+	if (type.in(ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_))) {
+		bool aoi = type.in(ID($_AOI3_), ID($_AOI4_));
+		bool four = type.in(ID($_AOI4_), ID($_OAI4_));
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = !(");
-		dump_cell_expr_port(f, cell, "S", false);
-		f << stringf(" ? ");
+		f << " = ~((";
+		dump_sigspec(f, cell->getPort(ID::A));
+		f << (aoi ? " & " : " | ");
+		dump_sigspec(f, cell->getPort(ID::B));
+		f << (aoi ? ") |" : ") &");
 		dump_attributes(f, "", cell->attributes, " ");
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(" : ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(");\n");
+		f << (four ? " (" : " ");
+		dump_sigspec(f, cell->getPort(ID::C));
+		if (four) {
+			f << (aoi ? " & " : " | ");
+			dump_sigspec(f, cell->getPort(ID::D));
+			f << "));\n";
+		} else
+			f << ");\n";
 		return true;
 	}
 
-	if (cell->type.in(ID($_AOI3_), ID($_OAI3_))) {
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ~((");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(cell->type == ID($_AOI3_) ? " & " : " | ");
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(cell->type == ID($_AOI3_) ? ") |" : ") &");
-		dump_attributes(f, "", cell->attributes, " ");
-		f << stringf(" ");
-		dump_cell_expr_port(f, cell, "C", false);
-		f << stringf(");\n");
-		return true;
-	}
+	return false;
+}
 
-	if (cell->type.in(ID($_AOI4_), ID($_OAI4_))) {
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ~((");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(cell->type == ID($_AOI4_) ? " & " : " | ");
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(cell->type == ID($_AOI4_) ? ") |" : ") &");
-		dump_attributes(f, "", cell->attributes, " ");
-		f << stringf(" (");
-		dump_cell_expr_port(f, cell, "C", false);
-		f << stringf(cell->type == ID($_AOI4_) ? " & " : " | ");
-		dump_cell_expr_port(f, cell, "D", false);
-		f << stringf("));\n");
+bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
+{
+	if (dump_cell_expr_gate(f, indent, cell))
 		return true;
-	}
 
 #define HANDLE_UNIOP(_type, _operator) \
 	if (cell->type ==_type) { dump_cell_expr_uniop(f, indent, cell, _operator); return true; }
@@ -1911,14 +1904,19 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	}
 
 	std::string cell_name = cellname(cell);
-	if (cell_name != id(cell->name))
-		f << stringf(" %s /* %s */ (", cell_name.c_str(), id(cell->name).c_str());
+	std::string cell_id = id(cell->name);
+	if (cell_name != cell_id)
+		f << " " << cell_name << " /* " << cell_id << " */ (";
 	else
-		f << stringf(" %s (", cell_name.c_str());
+		f << " " << cell_name << " (";
 
 	bool first_arg = true;
+	bool has_numbered_ports = false;
+	for (auto &conn : cell->connections())
+		if (conn.first[0] == '$')
+			has_numbered_ports = true;
 	std::set<RTLIL::IdString> numbered_ports;
-	for (int i = 1; true; i++) {
+	for (int i = 1; has_numbered_ports; i++) {
 		char str[16];
 		snprintf(str, 16, "$%d", i);
 		for (auto it = cell->connections().begin(); it != cell->connections().end(); ++it) {
@@ -1936,17 +1934,17 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	found_numbered_port:;
 	}
 	for (auto it = cell->connections().begin(); it != cell->connections().end(); ++it) {
-		if (numbered_ports.count(it->first))
+		if (has_numbered_ports && numbered_ports.count(it->first))
 			continue;
 		if (!first_arg)
-			f << stringf(",");
+			f << ",";
 		first_arg = false;
-		f << stringf("\n%s  .%s(", indent.c_str(), id(it->first).c_str());
+		f << "\n" << indent << "  ." << id(it->first) << "(";
 		if (it->second.size() > 0)
 			dump_sigspec(f, it->second);
-		f << stringf(")");
+		f << ")";
 	}
-	f << stringf("\n%s" ");\n", indent.c_str());
+	f << "\n" << indent << ");\n";
 
 	if (defparam && cell->parameters.size() > 0) {
 		for (auto it = cell->parameters.begin(); it != cell->parameters.end(); ++it) {
@@ -2023,18 +2021,18 @@ void dump_conn(std::ostream &f, std::string indent, const RTLIL::SigSpec &left,
 {
 	bool all_chunks_wires = true;
 	for (auto &chunk : left.chunks())
-		if (chunk.is_wire() && reg_wires.count(chunk.wire->name))
+		if (chunk.is_wire() && dump_state->reg_wires.count(chunk.wire->name))
 			all_chunks_wires = false;
 	if (!simple_lhs && all_chunks_wires) {
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, left);
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, right);
-		f << stringf(";\n");
+		f << ";\n";
 	} else {
 		int offset = 0;
 		for (auto &chunk : left.chunks()) {
-			if (chunk.is_wire() && reg_wires.count(chunk.wire->name))
+			if (chunk.is_wire() && dump_state->reg_wires.count(chunk.wire->name))
 				f << stringf("%s" "always%s\n%s  ", indent.c_str(), systemverilog ? "_comb" : " @*", indent.c_str());
 			else
 				f << stringf("%s" "assign ", indent.c_str());
@@ -2191,7 +2189,7 @@ void case_body_find_regs(RTLIL::CaseRule *cs)
 	for (auto it = cs->actions.begin(); it != cs->actions.end(); ++it) {
 		for (auto &c : it->first.chunks())
 			if (c.wire != NULL)
-				reg_wires.insert(c.wire->name);
+				dump_state->reg_wires.insert(c.wire->name);
 	}
 }
 
@@ -2203,14 +2201,14 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 		for (auto it2 = (*it)->actions.begin(); it2 != (*it)->actions.end(); it2++) {
 			for (auto &c : it2->first.chunks())
 				if (c.wire != NULL)
-					reg_wires.insert(c.wire->name);
+					dump_state->reg_wires.insert(c.wire->name);
 		}
 		return;
 	}
 
 	f << stringf("%s" "always%s begin\n", indent.c_str(), systemverilog ? "_comb" : " @*");
 	if (!systemverilog)
-		f << indent + "  " << "if (" << id(initial_id) << ") begin end\n";
+		f << indent + "  " << "if (" << id(dump_state->initial_id) << ") begin end\n";
 	dump_case_body(f, indent, &proc->root_case, true);
 
 	std::string backup_indent = indent;
@@ -2271,23 +2269,89 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 	}
 }
 
-void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
+// Cells are dumped in chunks of this size on worker threads if there are
+// enough consecutive cells that can be dumped concurrently.
+static const int CELL_CHUNK_SIZE = 4096;
+
+// Only cells that don't take fresh names from next_auto_id() and whose names
+// don't depend on the module's name tables (the register cells, see
+// cellname()) can be dumped out of order.
+bool concurrent_dump_cell(RTLIL::Cell *cell)
+{
+	if (RTLIL::builtin_ff_cell_types().count(cell->type))
+		return false;
+	if (cell->type[0] != '$' || noexpr)
+		return !cell->is_mem_cell();
+	return cell->type.in(ID($_NOT_), ID($_BUF_), ID($buf), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_),
+			ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_NMUX_),
+			ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_));
+}
+
+void dump_cells(std::ostream &f, std::string indent, RTLIL::Module *module)
+{
+	std::vector<RTLIL::Cell*> cells = module->cells().to_vector();
+	int threads = Pass::parallel_threads(module->design);
+
+	// hashlib tables rehash lazily on lookup, so look up the renaming table
+	// once before it is shared with the worker threads
+	dump_state->auto_name_map.count(module->name);
+	DumpState *state = dump_state;
+
+	int j = 0;
+	for (int i = 0; i < GetSize(cells);)
+	{
+		// [i, j) is the current run of cells that can be dumped concurrently
+		if (j <= i) {
+			j = i;
+			if (threads > 1)
+				while (j < GetSize(cells) && concurrent_dump_cell(cells[j]))
+					j++;
+		}
+
+		if (j - i < 2 * CELL_CHUNK_SIZE) {
+			for (j = std::max(j, i + 1); i < j; i++)
+				dump_cell(f, indent, cells[i]);
+			continue;
+		}
+
+		// a limited number of chunks at a time, so that the output of a huge
+		// module is not kept in memory in full
+		int num_chunks = std::min((j - i + CELL_CHUNK_SIZE - 1) / CELL_CHUNK_SIZE, 16 * threads);
+		std::vector<std::string> chunks(num_chunks);
+		Pass::parallel_for(module->design, num_chunks, [&](int k) {
+			DumpState *saved_state = dump_state;
+			dump_state = state;
+			std::ostringstream buf;
+			for (int c = i + k * CELL_CHUNK_SIZE; c < std::min(j, i + (k + 1) * CELL_CHUNK_SIZE); c++)
+				dump_cell(buf, indent, cells[c]);
+			chunks[k] = buf.str();
+			dump_state = saved_state;
+		});
+		for (auto &chunk : chunks)
+			f << chunk;
+		i = std::min(j, i + num_chunks * CELL_CHUNK_SIZE);
+	}
+}
+
+void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module, RTLIL::IdString initial_id)
 {
 	std::map<std::pair<RTLIL::SigSpec, RTLIL::Const>, std::vector<const RTLIL::Cell*>> sync_effect_cells;
 
-	reg_wires.clear();
+	DumpState state;
+	dump_state = &state;
+	state.initial_id = initial_id;
 	reset_auto_counter(module);
-	active_module = module;
-	active_sigmap.set(module);
-	active_initdata.clear();
+	dump_state->active_module = module;
+	dump_state->active_sigmap.set(module);
+	dump_state->active_initdata.clear();
 
 	for (auto wire : module->wires())
 		if (wire->attributes.count(ID::init)) {
-			SigSpec sig = active_sigmap(wire);
+			SigSpec sig = dump_state->active_sigmap(wire);
 			Const val = wire->attributes.at(ID::init);
 			for (int i = 0; i < GetSize(sig) && i < GetSize(val); i++)
 				if (val[i] == State::S0 || val[i] == State::S1)
-					active_initdata[sig[i]] = val[i];
+					dump_state->active_initdata[sig[i]] = val[i];
 		}
 
 	bool has_sync_rules = false;
@@ -2332,7 +2396,7 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 				if (reg_bits.count(std::pair<RTLIL::Wire*,int>(wire, i)) == 0)
 					goto this_wire_aint_reg;
 			if (wire->width)
-				reg_wires.insert(wire->name);
+				dump_state->reg_wires.insert(wire->name);
 		this_wire_aint_reg:;
 		}
 	}
@@ -2351,10 +2415,8 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 		}
 	}
 	f << stringf(");\n");
-	if (!systemverilog && !module->processes.empty()) {
-		initial_id = NEW_ID;
-		f << indent + "  " << "reg " << id(initial_id) << " = 0;\n";
-	}
+	if (!systemverilog && !module->processes.empty())
+		f << indent + "  " << "reg " << id(dump_state->initial_id) << " = 0;\n";
 
 	for (auto w : module->wires())
 		dump_wire(f, indent + "  ", w);
@@ -2362,8 +2424,7 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 	for (auto &mem : Mem::get_all_memories(module))
 		dump_memory(f, indent + "  ", mem);
 
-	for (auto cell : module->cells())
-		dump_cell(f, indent + "  ", cell);
+	dump_cells(f, indent + "  ", module);
 
 	for (auto &it : sync_effect_cells)
 		dump_sync_effect(f, indent + "  ", it.first.first, it.first.second, it.second);
@@ -2375,9 +2436,7 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 		dump_conn(f, indent + "  ", it->first, it->second);
 
 	f << stringf("%s" "endmodule\n", indent.c_str());
-	active_module = NULL;
-	active_sigmap.clear();
-	active_initdata.clear();
+	dump_state = nullptr;
 }
 
 struct VerilogBackend : public Backend {
@@ -2467,6 +2526,10 @@ struct VerilogBackend : public Backend {
 		log("    -v\n");
 		log("        verbose output (print new names of all renamed wires and cells)\n");
 		log("\n");
+		log("Modules, and the cells of large modules, are converted to Verilog on up to\n");
+		log("'parallel.threads' threads (see 'scratchpad'). The output does not depend on\n");
+		log("the number of threads.\n");
+		log("\n");
 		log("Note that RTLIL processes can't always be mapped directly to Verilog\n");
 		log("always blocks. This frontend should only be used to export an RTLIL\n");
 		log("netlist, i.e. after the \"proc\" pass has been used to convert all\n");
@@ -2497,9 +2560,6 @@ struct VerilogBackend : public Backend {
 		bool blackboxes = false;
 		bool selected = false;
 
-		auto_name_map.clear();
-		reg_wires.clear();
-
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
 			std::string arg = args[argidx];
@@ -2596,7 +2656,8 @@ struct VerilogBackend : public Backend {
 
 		design->sort();
 
-		*f << stringf("/* Generated by %s */\n", yosys_version_str);
+		std::vector<RTLIL::Module*> modules;
+		std::vector<RTLIL::IdString> initial_ids;
 		for (auto module : design->modules()) {
 			if (module->get_blackbox_attribute() != blackboxes)
 				continue;
@@ -2605,12 +2666,49 @@ struct VerilogBackend : public Backend {
 					log_cmd_error("Can't handle partially selected module %s!\n", log_id(module->name));
 				continue;
 			}
-			log("Dumping module `%s'.\n", module->name.c_str());
-			dump_module(*f, "", module);
+			modules.push_back(module);
+			// assigned up front, so the names don't depend on the order modules are dumped in
+			initial_ids.push_back(!systemverilog && !module->processes.empty() ? NEW_ID : IdString());
 		}
 
-		auto_name_map.clear();
-		reg_wires.clear();
+		// the first keyword lookup settles the table before it is shared with worker threads
+		id(ID::A, false);
+
+		// Small modules are dumped in batches on worker threads. Large modules
+		// are dumped one at a time, with their cells chunked across threads.
+		// -extmem numbers the memory files in module order, so it dumps serially.
+		std::vector<int> batch;
+		int batch_cells = 0;
+		auto dump_batch = [&]() {
+			std::vector<std::string> buffers(GetSize(batch));
+			Pass::parallel_for(design, GetSize(batch), [&](int k) {
+				RTLIL::Module *module = modules[batch[k]];
+				log("Dumping module `%s'.\n", module->name.c_str());
+				std::ostringstream buf;
+				dump_module(buf, "", module, initial_ids[batch[k]]);
+				buffers[k] = buf.str();
+			});
+			for (auto &buffer : buffers)
+				*f << buffer;
+			batch.clear();
+			batch_cells = 0;
+		};
+
+		*f << stringf("/* Generated by %s */\n", yosys_version_str);
+		for (int i = 0; i < GetSize(modules); i++) {
+			int num_cells = GetSize(modules[i]->cells_);
+			if (extmem || num_cells >= 2 * CELL_CHUNK_SIZE) {
+				dump_batch();
+				log("Dumping module `%s'.\n", modules[i]->name.c_str());
+				dump_module(*f, "", modules[i], initial_ids[i]);
+				continue;
+			}
+			batch.push_back(i);
+			batch_cells += num_cells;
+			if (batch_cells >= 16 * CELL_CHUNK_SIZE)
+				dump_batch();
+		}
+		dump_batch();
 	}
 } VerilogBackend;
 
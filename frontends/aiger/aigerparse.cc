@@ -223,10 +223,19 @@ AigerReader::AigerReader(RTLIL::Design *design, std::istream &f, RTLIL::IdString
 {
 	module = new RTLIL::Module;
 	module->name = module_name;
+	literal_prefix = stringf("$aiger%d$", aiger_autoidx);
 	if (design->module(module->name))
 		log_error("Duplicate definition of module %s!\n", log_id(module->name));
 }
 
+void AigerReader::reserve_tables()
+{
+	// size the tables from the header instead of growing them while reading
+	literal_wires.assign(2 * (size_t(M) + 1), nullptr);
+	module->wires_.reserve(module->wires_.size() + size_t(M) + I + L + O + 1);
+	module->cells_.reserve(module->cells_.size() + size_t(A) + L);
+}
+
 void AigerReader::parse_aiger()
 {
 	std::string header;
@@ -260,6 +269,7 @@ end_of_header:
 	line_count = 1;
 	piNum = 0;
 	flopNum = 0;
+	reserve_tables();
 
 	if (header == "aag")
 		parse_aiger_ascii();
@@ -338,17 +348,30 @@ static uint32_t parse_xaiger_literal(std::istream &f)
 
 RTLIL::Wire* AigerReader::createWireIfNotExists(RTLIL::Module *module, unsigned literal)
 {
+	// all literal wires of the module are created here, so the cache is
+	// authoritative for the literals it covers
+	bool cached = module == this->module && literal < literal_wires.size();
+	if (cached && literal_wires[literal] != nullptr)
+		return literal_wires[literal];
+
 	const unsigned variable = literal >> 1;
 	const bool invert = literal & 1;
-	RTLIL::IdString wire_name(stringf("$aiger%d$%d%s", aiger_autoidx, variable, invert ? "b" : ""));
-	RTLIL::Wire *wire = module->wire(wire_name);
+	std::string wire_name = literal_prefix;
+	wire_name += std::to_string(variable);
+	if (invert)
+		wire_name += 'b';
+	RTLIL::Wire *wire = cached ? nullptr : module->wire(wire_name);
 	if (wire) return wire;
 	log_debug2("Creating %s\n", wire_name.c_str());
 	wire = module->addWire(wire_name);
 	wire->port_input = wire->port_output = false;
+	if (cached)
+		literal_wires[literal] = wire;
 	if (!invert) return wire;
-	RTLIL::IdString wire_inv_name(stringf("$aiger%d$%d", aiger_autoidx, variable));
-	RTLIL::Wire *wire_inv = module->wire(wire_inv_name);
+	if (!wire_name.empty())
+		wire_name.pop_back();
+	RTLIL::IdString wire_inv_name(wire_name);
+	RTLIL::Wire *wire_inv = cached ? literal_wires[literal ^ 1] : module->wire(wire_inv_name);
 	if (wire_inv) {
 		if (module->cell(wire_inv_name)) return wire;
 	}
@@ -356,10 +379,12 @@ RTLIL::Wire* AigerReader::createWireIfNotExists(RTLIL::Module *module, unsigned
 		log_debug2("Creating %s\n", wire_inv_name.c_str());
 		wire_inv = module->addWire(wire_inv_name);
 		wire_inv->port_input = wire_inv->port_output = false;
+		if (cached)
+			literal_wires[literal ^ 1] = wire_inv;
 	}
 
 	log_debug2("Creating %s = ~%s\n", wire_name.c_str(), wire_inv_name.c_str());
-	module->addNotGate(stringf("$not$aiger%d$%d", aiger_autoidx, variable), wire_inv, wire);
+	module->addNotGate("$not" + wire_name, wire_inv, wire);
 
 	return wire;
 }
@@ -388,6 +413,7 @@ void AigerReader::parse_xaiger()
 	line_count = 1;
 	piNum = 0;
 	flopNum = 0;
+	reserve_tables();
 
 	if (header == "aag")
 		parse_aiger_ascii();
@@ -638,12 +664,17 @@ void AigerReader::parse_aiger_ascii()
 	}
 }
 
-static unsigned parse_next_delta_literal(std::istream &f, unsigned ref)
+static unsigned parse_next_delta_literal(std::streambuf *sb, unsigned ref)
 {
+	// read through the buffer of the stream, this is the inner loop for
+	// large binary AIGs
 	unsigned x = 0, i = 0;
-	unsigned char ch;
-	while ((ch = f.get()) & 0x80)
+	int ch;
+	while ((ch = sb->sbumpc()) & 0x80) {
+		if (ch == std::char_traits<char>::eof())
+			log_error("Unexpected end of file in AND section!\n");
 		x |= (ch & 0x7f) << (7 * i++);
+	}
 	return ref - (x | (ch << (7 * i)));
 }
 
@@ -748,10 +779,11 @@ void AigerReader::parse_aiger_binary()
 		std::getline(f, line); // Ignore up to start of next line
 
 	// Parse AND
+	std::streambuf *sb = f.rdbuf();
 	l1 = (I+L+1) << 1;
 	for (unsigned i = 0; i < A; ++i, ++line_count, l1 += 2) {
-		l2 = parse_next_delta_literal(f, l1);
-		l3 = parse_next_delta_literal(f, l2);
+		l2 = parse_next_delta_literal(sb, l1);
+		l3 = parse_next_delta_literal(sb, l2);
 
 		log_debug2("%d %d %d is an AND\n", l1, l2, l3);
 		log_assert(!(l1 & 1));
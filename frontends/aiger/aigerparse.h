@@ -47,12 +47,17 @@ struct AigerReader
     std::vector<RTLIL::Cell*> boxes;
     std::vector<int> mergeability, initial_state;
 
+    // the wire of every literal, filled by createWireIfNotExists()
+    std::vector<RTLIL::Wire*> literal_wires;
+    std::string literal_prefix;
+
     AigerReader(RTLIL::Design *design, std::istream &f, RTLIL::IdString module_name, RTLIL::IdString clk_name, std::string map_filename, bool wideports);
     void parse_aiger();
     void parse_xaiger();
     void parse_aiger_ascii();
     void parse_aiger_binary();
     void post_process();
+    void reserve_tables();
 
     RTLIL::Wire* createWireIfNotExists(RTLIL::Module *module, unsigned literal);
 };
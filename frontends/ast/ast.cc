@@ -28,9 +28,15 @@
  */
 
 #include "kernel/yosys.h"
+#include "kernel/rtlil_binary.h"
+#include "kernel/contenthash.h"
+#include "kernel/slab.h"
 #include "libs/sha1/sha1.h"
 #include "ast.h"
 
+#include <fstream>
+#include <unordered_set>
+
 YOSYS_NAMESPACE_BEGIN
 
 using namespace AST;
@@ -199,9 +205,39 @@ bool AstNode::get_bool_attribute(RTLIL::IdString id)
 	return attr->integer != 0;
 }
 
+const std::string *AstFilename::intern(const std::string &str)
+{
+	// never destroyed, as nodes may outlive static destruction
+	static std::unordered_set<std::string> *names = new std::unordered_set<std::string>;
+	static const std::string *last_name = nullptr;
+
+	// consecutive nodes almost always come from the same file
+	if (last_name == nullptr || *last_name != str)
+		last_name = &*names->insert(str).first;
+	return last_name;
+}
+
+static SlabPool<AstNode> &astnode_pool()
+{
+	// never destroyed, as nodes may outlive static destruction
+	static SlabPool<AstNode> *pool = new SlabPool<AstNode>;
+	return *pool;
+}
+
+void *AstNode::operator new(size_t size)
+{
+	log_assert(size == sizeof(AstNode));
+	return astnode_pool().allocate();
+}
+
+void AstNode::operator delete(void *ptr)
+{
+	astnode_pool().deallocate(ptr);
+}
+
 // create new node (AstNode constructor)
 // (the optional child arguments make it easier to create AST trees)
-AstNode::AstNode(AstNodeType type, AstNode *child1, AstNode *child2, AstNode *child3, AstNode *child4)
+AstNode::AstNode(AstNodeType type, AstNode *child1, AstNode *child2, AstNode *child3, AstNode *child4) : filename(current_filename)
 {
 	static unsigned int hashidx_count = 123456789;
 	hashidx_count = mkhash_xorshift(hashidx_count);
@@ -209,7 +245,6 @@ AstNode::AstNode(AstNodeType type, AstNode *child1, AstNode *child2, AstNode *ch
 	astnodes++;
 
 	this->type = type;
-	filename = current_filename;
 	is_input = false;
 	is_output = false;
 	is_reg = false;
@@ -1075,7 +1110,7 @@ std::string AstNode::loc_string() const
 
 void AST::set_src_attr(RTLIL::AttrObject *obj, const AstNode *ast)
 {
-	obj->attributes[ID::src] = ast->loc_string();
+	obj->set_src_attribute(ast->loc_string());
 }
 
 static bool param_has_no_default(const AstNode *param) {
@@ -1363,8 +1398,23 @@ static void rename_in_package_stmts(AstNode *pkg)
 }
 
 // create AstModule instances for all modules in the AST tree and add them to 'design'
+// check if the AST of a module can still be used by derive(), expand_interfaces()
+// or reprocess_if_necessary()
+static bool ast_needed_after_process(AstModule *module)
+{
+	if (module->get_bool_attribute(ID::is_interface) || !module->avail_parameters.empty())
+		return true;
+	for (const AstNode *node : module->ast->children)
+		if (node->type == AST_PARAMETER || node->type == AST_INTERFACEPORT || node->type == AST_DEFPARAM)
+			return true;
+	for (const RTLIL::Cell *cell : module->cells())
+		if (cell->has_attribute(ID::reprocess_after))
+			return true;
+	return false;
+}
+
 void AST::process(RTLIL::Design *design, AstNode *ast, bool nodisplay, bool dump_ast1, bool dump_ast2, bool no_dump_ptr, bool dump_vlog1, bool dump_vlog2, bool dump_rtlil,
-		bool nolatches, bool nomeminit, bool nomem2reg, bool mem2reg, bool noblackbox, bool lib, bool nowb, bool noopt, bool icells, bool pwires, bool nooverwrite, bool overwrite, bool defer, bool autowire)
+		bool nolatches, bool nomeminit, bool nomem2reg, bool mem2reg, bool noblackbox, bool lib, bool nowb, bool noopt, bool icells, bool pwires, bool nooverwrite, bool overwrite, bool defer, bool autowire, bool stream)
 {
 	current_ast = ast;
 	current_ast_mod = nullptr;
@@ -1390,7 +1440,7 @@ void AST::process(RTLIL::Design *design, AstNode *ast, bool nodisplay, bool dump
 	ast->fixup_hierarchy_flags(true);
 
 	log_assert(current_ast->type == AST_DESIGN);
-	for (AstNode *child : current_ast->children)
+	for (AstNode *&child : current_ast->children)
 	{
 		if (child->type == AST_MODULE || child->type == AST_INTERFACE)
 		{
@@ -1447,8 +1497,30 @@ void AST::process(RTLIL::Design *design, AstNode *ast, bool nodisplay, bool dump
 				}
 			}
 
-			process_module(design, child, defer_local);
+			RTLIL::Module *module = process_module(design, child, defer_local);
 			current_ast_mod = nullptr;
+
+			// with -lib, -defer keeps a stub that 'hierarchy' turns into the
+			// blackbox (without deriving it) once a cell uses the module
+			if (defer && lib) {
+				bool param_defaults = true;
+				for (const AstNode *node : child->children)
+					if (node->type == AST_PARAMETER && param_has_no_default(node))
+						param_defaults = false;
+				if (param_defaults)
+					module->set_bool_attribute(ID::blackbox);
+			}
+
+			if (stream) {
+				// the simplified AST is not needed once the RTLIL is generated,
+				// and the unsimplified copy is only needed for deriving
+				delete child;
+				child = nullptr;
+				if (!defer_local && !ast_needed_after_process(static_cast<AstModule*>(module))) {
+					delete static_cast<AstModule*>(module)->ast;
+					static_cast<AstModule*>(module)->ast = nullptr;
+				}
+			}
 		}
 		else if (child->type == AST_PACKAGE) {
 			// process enum/other declarations
@@ -1470,6 +1542,9 @@ void AST::process(RTLIL::Design *design, AstNode *ast, bool nodisplay, bool dump
 			current_scope.clear();
 		}
 	}
+
+	if (stream)
+		current_ast->children.erase(std::remove(current_ast->children.begin(), current_ast->children.end(), nullptr), current_ast->children.end());
 }
 
 // AstModule destructor
@@ -1569,6 +1644,8 @@ bool AstModule::reprocess_if_necessary(RTLIL::Design *design)
 		if (design->module(modname) || design->module("$abstract" + modname)) {
 			log("Reprocessing module %s because instantiated module %s has become available.\n",
 					log_id(name), log_id(modname));
+			if (ast == nullptr)
+				log_error("Can't reprocess module %s: its AST was released by `read_verilog -stream'.\n", log_id(name));
 			loadconfig();
 			process_and_replace_module(design, this, ast, NULL);
 			return true;
@@ -1581,6 +1658,8 @@ bool AstModule::reprocess_if_necessary(RTLIL::Design *design)
 // from AST. The interface members are copied into the AST module with the prefix of the interface.
 void AstModule::expand_interfaces(RTLIL::Design *design, const dict<RTLIL::IdString, RTLIL::Module*> &local_interfaces)
 {
+	if (ast == nullptr)
+		log_error("Can't expand interfaces in module %s: its AST was released by `read_verilog -stream'.\n", log_id(name));
 	loadconfig();
 
 	AstNode *new_ast = ast->clone();
@@ -1676,6 +1755,8 @@ RTLIL::IdString AstModule::derive(RTLIL::Design *design, const dict<RTLIL::IdStr
 	if (!design->has(new_modname)) {
 		if (!new_ast) {
 			auto mod = dynamic_cast<AstModule*>(design->module(modname));
+			if (mod->ast == nullptr)
+				log_error("Can't derive module `%s' for interfaces: its AST was released by `read_verilog -stream'.\n", log_id(mod->name));
 			new_ast = mod->ast->clone();
 		}
 		modname = new_modname;
@@ -1738,6 +1819,204 @@ RTLIL::IdString AstModule::derive(RTLIL::Design *design, const dict<RTLIL::IdStr
 	return modname;
 }
 
+// On-disk cache of derived modules, used when the scratchpad variable
+// ast.derive_cache is set to a directory. An entry is keyed by a hash of the
+// module's AST with the parameters already applied (which includes the
+// source locations and everything read_verilog put into the AST) and of the
+// frontend options, and holds the log output of the elaboration followed by
+// the derived module as binary RTLIL. Modules whose elaboration depended on
+// other modules of the design, on files read by $readmem or on DPI calls are
+// not cached.
+
+static const char derive_cache_magic[] = "yosys-derive-cache\n";
+
+static void hash_ast(std::string &buf, const AstNode *node)
+{
+	auto add_int = [&](long long value) {
+		buf += std::to_string(value);
+		buf += ',';
+	};
+	auto add_str = [&](const std::string &str) {
+		add_int(GetSize(str));
+		buf += str;
+	};
+
+	if (node == nullptr) {
+		buf += '-';
+		return;
+	}
+
+	buf += '(';
+	add_int(node->type);
+	add_str(node->str);
+	for (auto bit : node->bits)
+		buf += char('0' + bit);
+	buf += ',';
+	bool flags[] = {node->is_input, node->is_output, node->is_reg, node->is_logic, node->is_signed, node->is_string,
+			node->is_wand, node->is_wor, node->range_valid, node->range_swapped, node->was_checked, node->is_unsized,
+			node->is_custom_type, node->is_enum, node->basic_prep, node->lookahead, node->in_lvalue, node->in_param,
+			node->in_lvalue_from_above, node->in_param_from_above};
+	for (bool flag : flags)
+		buf += flag ? '1' : '0';
+	add_int(node->port_id);
+	add_int(node->range_left);
+	add_int(node->range_right);
+	add_int(node->integer);
+	add_str(stringf("%a", node->realvalue));
+	for (auto &dim : node->dimensions) {
+		add_int(dim.range_right);
+		add_int(dim.range_width);
+		add_int(dim.range_swapped);
+	}
+	add_int(node->unpacked_dimensions);
+	add_str(node->filename);
+	add_int(node->location.first_line);
+	add_int(node->location.first_column);
+	add_int(node->location.last_line);
+	add_int(node->location.last_column);
+	for (auto &attr : node->attributes) {
+		add_str(attr.first.str());
+		hash_ast(buf, attr.second);
+	}
+	buf += ';';
+	for (auto child : node->children)
+		hash_ast(buf, child);
+	buf += ')';
+}
+
+static std::string derive_cache_filename(RTLIL::Design *design, const AstNode *new_ast)
+{
+	std::string dir = design->scratchpad_get_string("ast.derive_cache");
+	if (dir.empty())
+		return std::string();
+
+	std::string key = stringf("%s\n%d\n", yosys_version_str, RTLIL_BINARY::version);
+	bool flags[] = {flag_nolatches, flag_nomeminit, flag_nomem2reg, flag_mem2reg, flag_noblackbox, flag_lib,
+			flag_nowb, flag_noopt, flag_icells, flag_pwires, flag_autowire};
+	for (bool flag : flags)
+		key += flag ? '1' : '0';
+	key += '\n';
+	hash_ast(key, new_ast);
+	return dir + "/" + content_hash(key) + ".derive";
+}
+
+static void write_cache_uint(std::ostream &f, uint32_t value)
+{
+	f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void write_cache_string(std::ostream &f, const std::string &str)
+{
+	write_cache_uint(f, GetSize(str));
+	f.write(str.data(), str.size());
+}
+
+static bool read_cache_uint(const std::string &data, size_t &pos, uint32_t &value)
+{
+	if (data.size() - pos < sizeof(value))
+		return false;
+	memcpy(&value, data.data() + pos, sizeof(value));
+	pos += sizeof(value);
+	return true;
+}
+
+static bool read_cache_string(const std::string &data, size_t &pos, std::string &str)
+{
+	uint32_t size;
+	if (!read_cache_uint(data, pos, size) || data.size() - pos < size)
+		return false;
+	str = data.substr(pos, size);
+	pos += size;
+	return true;
+}
+
+static bool load_derived_module(RTLIL::Design *design, AstNode *new_ast, const std::string &filename, bool quiet)
+{
+	std::ifstream f(filename, std::ifstream::binary);
+	if (f.fail())
+		return false;
+	std::stringstream buffer;
+	buffer << f.rdbuf();
+	std::string data = buffer.str();
+
+	size_t pos = strlen(derive_cache_magic);
+	if (data.compare(0, pos, derive_cache_magic) != 0)
+		return false;
+
+	std::vector<LogBuffer::Entry> entries;
+	uint32_t num_entries;
+	if (!read_cache_uint(data, pos, num_entries))
+		return false;
+	for (uint32_t i = 0; i < num_entries; i++) {
+		LogBuffer::Entry entry;
+		uint32_t kind;
+		if (!read_cache_uint(data, pos, kind) || !read_cache_string(data, pos, entry.prefix) ||
+				!read_cache_string(data, pos, entry.text))
+			return false;
+		entry.kind = LogBuffer::Kind(kind);
+		entries.push_back(entry);
+	}
+	if (!RTLIL_BINARY::has_magic(data.data() + pos, data.size() - pos))
+		return false;
+
+	RTLIL::Design cached_design;
+	RTLIL_BINARY::parse_design(data.data() + pos, data.size() - pos, &cached_design, RTLIL_BINARY::ReadOptions());
+	RTLIL::Module *cached_module = cached_design.module(new_ast->str);
+	if (cached_module == nullptr || GetSize(cached_design.modules()) != 1)
+		return false;
+
+	if (!quiet)
+		log("Loading RTLIL representation for module `%s' from derive cache.\n", new_ast->str.c_str());
+	LogBuffer log_buffer;
+	log_buffer.entries = std::move(entries);
+	log_buffer.replay();
+
+	AstModule *module = new AstModule;
+	module->name = new_ast->str;
+	cached_module->cloneInto(module);
+	module->ast = new_ast->clone();
+	module->nolatches = flag_nolatches;
+	module->nomeminit = flag_nomeminit;
+	module->nomem2reg = flag_nomem2reg;
+	module->mem2reg = flag_mem2reg;
+	module->noblackbox = flag_noblackbox;
+	module->lib = flag_lib;
+	module->nowb = flag_nowb;
+	module->noopt = flag_noopt;
+	module->icells = flag_icells;
+	module->pwires = flag_pwires;
+	module->autowire = flag_autowire;
+	design->add(module);
+	return true;
+}
+
+static void store_derived_module(RTLIL::Design *design, RTLIL::Module *module, const std::string &filename, const LogBuffer &log_buffer)
+{
+	if (!create_directory(design->scratchpad_get_string("ast.derive_cache"))) {
+		log_warning("Failed to create derive cache directory %s.\n", design->scratchpad_get_string("ast.derive_cache").c_str());
+		return;
+	}
+
+	RTLIL::Design cached_design;
+	RTLIL::Module *cached_module = new RTLIL::Module;
+	cached_module->name = module->name;
+	module->cloneInto(cached_module);
+	cached_design.add(cached_module);
+
+	bool ok = write_file_atomically(filename, [&](std::ostream &f) {
+		f << derive_cache_magic;
+		write_cache_uint(f, GetSize(log_buffer.entries));
+		for (auto &entry : log_buffer.entries) {
+			write_cache_uint(f, entry.kind);
+			write_cache_string(f, entry.prefix);
+			write_cache_string(f, entry.text);
+		}
+		RTLIL_BINARY::dump_design(f, &cached_design, false);
+	});
+	if (!ok)
+		log_warning("Failed to write derive cache entry %s.\n", filename.c_str());
+}
+
 // create a new parametric module (when needed) and return the name of the generated module - without support for interfaces
 RTLIL::IdString AstModule::derive(RTLIL::Design *design, const dict<RTLIL::IdString, RTLIL::Const> &parameters, bool /*mayfail*/)
 {
@@ -1748,7 +2027,34 @@ RTLIL::IdString AstModule::derive(RTLIL::Design *design, const dict<RTLIL::IdStr
 
 	if (!design->has(modname) && new_ast) {
 		new_ast->str = modname;
-		process_module(design, new_ast, false, NULL, quiet);
+		std::string cache_filename;
+		if (!log_buffer_active())
+			cache_filename = derive_cache_filename(design, new_ast);
+		if (cache_filename.empty()) {
+			process_module(design, new_ast, false, NULL, quiet);
+		} else if (!load_derived_module(design, new_ast, cache_filename, quiet)) {
+			// capture the log output, so that it can be replayed when loading
+			// the module from the cache
+			LogBuffer log_buffer;
+			simplify_used_context = false;
+			log_buffer_install(&log_buffer);
+			try {
+				process_module(design, new_ast, false, NULL, quiet);
+			} catch (const log_buffered_error &e) {
+				log_buffer_install(nullptr);
+				log_buffer.replay();
+				e.raise();
+			} catch (...) {
+				log_buffer_install(nullptr);
+				log_buffer.replay();
+				throw;
+			}
+			log_buffer_install(nullptr);
+			LogBuffer replayed = log_buffer;
+			log_buffer.replay();
+			if (!simplify_used_context)
+				store_derived_module(design, design->module(modname), cache_filename, replayed);
+		}
 		design->module(modname)->check();
 	} else if (!quiet) {
 		log("Found cached RTLIL representation for module `%s'.\n", modname.c_str());
@@ -1792,6 +2098,13 @@ std::string AstModule::derive_common(RTLIL::Design *design, const dict<RTLIL::Id
 	if (stripped_name.compare(0, 9, "$abstract") == 0)
 		stripped_name = stripped_name.substr(9);
 
+	if (ast == nullptr) {
+		// only modules without parameters have their AST released
+		if (parameters.size())
+			log_error("Can't derive module `%s' with parameters: its AST was released by `read_verilog -stream'.\n", log_id(name));
+		return stripped_name;
+	}
+
 	int para_counter = 0;
 	std::vector<std::pair<RTLIL::IdString, RTLIL::Const>> named_parameters;
 	for (const auto child : ast->children) {
@@ -1888,7 +2201,7 @@ RTLIL::Module *AstModule::clone() const
 	new_mod->name = name;
 	cloneInto(new_mod);
 
-	new_mod->ast = ast->clone();
+	new_mod->ast = ast ? ast->clone() : nullptr;
 	new_mod->nolatches = nolatches;
 	new_mod->nomeminit = nomeminit;
 	new_mod->nomem2reg = nomem2reg;
@@ -172,6 +172,24 @@ namespace AST
 	// convert an node type to a string (e.g. for debug output)
 	std::string type2str(AstNodeType type);
 
+	// The source file name of an AstNode. Names are interned, so that all
+	// nodes from the same file share one string, and are never freed.
+	struct AstFilename
+	{
+		AstFilename() : str_(intern(std::string())) { }
+		AstFilename(const std::string &str) : str_(intern(str)) { }
+		AstFilename &operator=(const std::string &str) { str_ = intern(str); return *this; }
+
+		operator const std::string &() const { return *str_; }
+		const std::string &str() const { return *str_; }
+		const char *c_str() const { return str_->c_str(); }
+		bool empty() const { return str_->empty(); }
+
+	private:
+		const std::string *str_;
+		static const std::string *intern(const std::string &str);
+	};
+
 	// The AST is built using instances of this struct
 	struct AstNode
 	{
@@ -192,12 +210,9 @@ namespace AST
 		// node content - most of it is unused in most node types
 		std::string str;
 		std::vector<RTLIL::State> bits;
-		bool is_input, is_output, is_reg, is_logic, is_signed, is_string, is_wand, is_wor, range_valid, range_swapped, was_checked, is_unsized, is_custom_type;
 		int port_id, range_left, range_right;
 		uint32_t integer;
 		double realvalue;
-		// set for IDs typed to an enumeration, not used
-		bool is_enum;
 
 		// Declared range for array dimension.
 		struct dimension_t {
@@ -214,27 +229,36 @@ namespace AST
 		// this is set by simplify and used during RTLIL generation
 		AstNode *id2ast;
 
-		// this is used by simplify to detect if basic analysis has been performed already on the node
-		bool basic_prep;
-
-		// this is used for ID references in RHS expressions that should use the "new" value for non-blocking assignments
-		bool lookahead;
-
 		// this is the original sourcecode location that resulted in this AST node
 		// it is automatically set by the constructor using AST::current_filename and
 		// the AST::get_line_num() callback function.
-		std::string filename;
+		AstFilename filename;
 		AstSrcLocType location;
 
+		// node flags, kept as bitfields to keep the node small
+		bool is_input : 1, is_output : 1, is_reg : 1, is_logic : 1, is_signed : 1, is_string : 1, is_wand : 1, is_wor : 1;
+		bool range_valid : 1, range_swapped : 1, was_checked : 1, is_unsized : 1, is_custom_type : 1;
+		// set for IDs typed to an enumeration, not used
+		bool is_enum : 1;
+
+		// this is used by simplify to detect if basic analysis has been performed already on the node
+		bool basic_prep : 1;
+
+		// this is used for ID references in RHS expressions that should use the "new" value for non-blocking assignments
+		bool lookahead : 1;
+
 		// are we embedded in an lvalue, param?
 		// (see fixup_hierarchy_flags)
-		bool in_lvalue;
-		bool in_param;
-		bool in_lvalue_from_above;
-		bool in_param_from_above;
+		bool in_lvalue : 1;
+		bool in_param : 1;
+		bool in_lvalue_from_above : 1;
+		bool in_param_from_above : 1;
 
 		// creating and deleting nodes
+		// (nodes are allocated from a pool shared by all ASTs, which is not thread-safe)
 		AstNode(AstNodeType type = AST_NONE, AstNode *child1 = nullptr, AstNode *child2 = nullptr, AstNode *child3 = nullptr, AstNode *child4 = nullptr);
+		static void *operator new(size_t size);
+		static void operator delete(void *ptr);
 		AstNode *clone() const;
 		void cloneInto(AstNode *other) const;
 		void delete_children();
@@ -386,7 +410,7 @@ namespace AST
 
 	// process an AST tree (ast must point to an AST_DESIGN node) and generate RTLIL code
 	void process(RTLIL::Design *design, AstNode *ast, bool nodisplay, bool dump_ast1, bool dump_ast2, bool no_dump_ptr, bool dump_vlog1, bool dump_vlog2, bool dump_rtlil, bool nolatches, bool nomeminit,
-			bool nomem2reg, bool mem2reg, bool noblackbox, bool lib, bool nowb, bool noopt, bool icells, bool pwires, bool nooverwrite, bool overwrite, bool defer, bool autowire);
+			bool nomem2reg, bool mem2reg, bool noblackbox, bool lib, bool nowb, bool noopt, bool icells, bool pwires, bool nooverwrite, bool overwrite, bool defer, bool autowire, bool stream = false);
 
 	// parametric modules are supported directly by the AST library
 	// therefore we need our own derivate of RTLIL::Module with overloaded virtual functions
@@ -435,6 +459,11 @@ namespace AST
 	// used to provide simplify() access to the current design for looking up
 	// modules, ports, wires, etc.
 	void set_simplify_design_context(const RTLIL::Design *design);
+
+	// set by simplify() when its result depends on more than the AST of the
+	// module, i.e. on other modules of the design, on files read by $readmem
+	// or on DPI calls (see AstModule::derive())
+	extern bool simplify_used_context;
 }
 
 namespace AST_INTERNAL
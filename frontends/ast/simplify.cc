@@ -602,16 +602,46 @@ static std::string prefix_id(const std::string &prefix, const std::string &str)
 
 // direct access to this global should be limited to the following two functions
 static const RTLIL::Design *simplify_design_context = nullptr;
+bool AST::simplify_used_context = false;
+
+// Results of constant function calls while a module is simplified, keyed by
+// the function declaration in the current scope and the argument values.
+// The declarations and the parameters they may refer to don't change while
+// the module is simplified, so the cache is dropped with the design context.
+static std::map<std::pair<const AstNode*, std::string>, AstNode*> const_function_cache;
+
+static void clear_const_function_cache()
+{
+	for (auto &it : const_function_cache)
+		delete it.second;
+	const_function_cache.clear();
+}
+
+static std::string const_function_args_key(const std::vector<AstNode*> &args)
+{
+	std::string key;
+	for (auto arg : args) {
+		if (arg->type == AST_CONSTANT) {
+			key += arg->is_signed ? 's' : 'u';
+			key += RTLIL::Const(arg->bits).as_string();
+		} else
+			key += stringf("r%a", arg->realvalue);
+		key += ',';
+	}
+	return key;
+}
 
 void AST::set_simplify_design_context(const RTLIL::Design *design)
 {
 	log_assert(!simplify_design_context || !design);
 	simplify_design_context = design;
+	clear_const_function_cache();
 }
 
 // lookup the module with the given name in the current design context
 static const RTLIL::Module* lookup_module(const std::string &name)
 {
+	simplify_used_context = true;
 	return simplify_design_context->module(name);
 }
 
@@ -3787,6 +3817,7 @@ skip_dynamic_range_lvalue_expansion:;
 				}
 
 				newNode = dpi_call(rtype, fname, argtypes, args);
+				simplify_used_context = true;
 
 				for (auto arg : args)
 					delete arg;
@@ -3896,12 +3927,27 @@ skip_dynamic_range_lvalue_expansion:;
 			}
 
 			if (all_args_const) {
+				// failed evaluations are not cached, they may have to report an error
+				bool use_cache = simplify_design_context != nullptr;
+				std::pair<const AstNode*, std::string> cache_key;
+				if (use_cache) {
+					cache_key = {current_scope.at(str), const_function_args_key(children)};
+					auto it = const_function_cache.find(cache_key);
+					if (it != const_function_cache.end()) {
+						newNode = it->second->clone();
+						delete decl;
+						goto apply_newNode;
+					}
+				}
+
 				AstNode *func_workspace = decl->clone();
 				func_workspace->set_in_param_flag(true);
 				func_workspace->str = prefix_id(prefix, "$result");
 				newNode = func_workspace->eval_const_function(this, in_param || require_const_eval);
 				delete func_workspace;
 				if (newNode) {
+					if (use_cache)
+						const_function_cache[cache_key] = newNode->clone();
 					delete decl;
 					goto apply_newNode;
 				}
@@ -4440,6 +4486,8 @@ AstNode *AstNode::readmem(bool is_readmemh, std::string mem_filename, AstNode *m
 	for (int i = 0; i < mem_width; i++)
 		en_bits.push_back(State::S1);
 
+	simplify_used_context = true;
+
 	std::ifstream f;
 	f.open(mem_filename.c_str());
 	if (f.fail()) {
@@ -4448,7 +4496,7 @@ AstNode *AstNode::readmem(bool is_readmemh, std::string mem_filename, AstNode *m
 #else
 		char slash = '/';
 #endif
-		std::string path = filename.substr(0, filename.find_last_of(slash)+1);
+		std::string path = filename.str().substr(0, filename.str().find_last_of(slash)+1);
 		f.open(path + mem_filename.c_str());
 		yosys_input_files.insert(path + mem_filename);
 	} else {
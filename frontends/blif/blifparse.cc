@@ -23,9 +23,8 @@ YOSYS_NAMESPACE_BEGIN
 
 const int lut_input_plane_limit = 12;
 
-static bool read_next_line(char *&buffer, size_t &buffer_size, int &line_count, std::istream &f)
+static bool read_next_line(char *&buffer, size_t &buffer_size, int &line_count, const char *&ptr, const char *end)
 {
-	string strbuf;
 	int buffer_len = 0;
 	buffer[0] = 0;
 
@@ -45,18 +44,48 @@ static bool read_next_line(char *&buffer, size_t &buffer_size, int &line_count,
 			if (buffer_len > 0 && buffer[buffer_len-1] == '\\')
 				buffer[--buffer_len] = 0;
 			line_count++;
-			if (!std::getline(f, strbuf))
+			if (ptr == end)
 				return false;
-			while (buffer_size-buffer_len < strbuf.size()+1) {
+			const char *eol = (const char*)memchr(ptr, '\n', end - ptr);
+			size_t len = (eol ? eol : end) - ptr;
+			while (buffer_size-buffer_len < len+1) {
 				buffer_size *= 2;
 				buffer = (char*)realloc(buffer, buffer_size);
 			}
-			strcpy(buffer+buffer_len, strbuf.c_str());
+			memcpy(buffer+buffer_len, ptr, len);
+			buffer[buffer_len+len] = 0;
+			ptr = eol ? eol+1 : end;
 		} else
 			return true;
 	}
 }
 
+// count the cells of the model starting at ptr, so that the tables of the
+// module can be sized before it is read
+static int count_model_cells(const char *ptr, const char *end)
+{
+	auto starts_with = [](const char *line, const char *line_end, const char *cmd) {
+		size_t len = strlen(cmd);
+		return size_t(line_end - line) >= len && !memcmp(line, cmd, len) &&
+				(size_t(line_end - line) == len || strchr(" \t\r", line[len]));
+	};
+
+	int count = 0;
+	while (ptr != end) {
+		const char *eol = (const char*)memchr(ptr, '\n', end - ptr);
+		const char *line_end = eol ? eol : end;
+		if (*ptr == '.') {
+			if (starts_with(ptr, line_end, ".end"))
+				break;
+			if (starts_with(ptr, line_end, ".names") || starts_with(ptr, line_end, ".gate") ||
+					starts_with(ptr, line_end, ".subckt") || starts_with(ptr, line_end, ".latch"))
+				count++;
+		}
+		ptr = eol ? eol+1 : end;
+	}
+	return count;
+}
+
 static std::pair<RTLIL::IdString, int> wideports_split(std::string name)
 {
 	int pos = -1;
@@ -84,8 +113,9 @@ failed:
 	return std::pair<RTLIL::IdString, int>(RTLIL::IdString(), 0);
 }
 
-void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool run_clean, bool sop_mode, bool wideports)
+void parse_blif(RTLIL::Design *design, const char *data, size_t size, IdString dff_name, bool run_clean, bool sop_mode, bool wideports)
 {
+	const char *ptr = data, *end = data + size;
 	RTLIL::Module *module = nullptr;
 	RTLIL::Const *lutptr = NULL;
 	RTLIL::Cell *sopcell = NULL;
@@ -94,28 +124,37 @@ void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool
 	std::string err_reason;
 	int blif_maxnum = 0, sopmode = -1;
 
-	auto blif_wire = [&](const std::string &wire_name) -> Wire*
+	// names are escaped into a reused buffer
+	std::string id_buffer;
+	auto escaped_id = [&](const char *name) -> const std::string& {
+		id_buffer.clear();
+		if (name[0] != '\\' && name[0] != '$')
+			id_buffer += '\\';
+		id_buffer += name;
+		return id_buffer;
+	};
+
+	auto blif_wire = [&](const char *wire_name) -> Wire*
 	{
 		if (wire_name[0] == '$')
 		{
-			for (int i = 0; i+1 < GetSize(wire_name); i++)
+			for (int i = 0; wire_name[i] && wire_name[i+1]; i++)
 			{
 				if (wire_name[i] != '$')
 					continue;
 
 				int len = 0;
-				while (i+len+1 < GetSize(wire_name) && '0' <= wire_name[i+len+1] && wire_name[i+len+1] <= '9')
+				while ('0' <= wire_name[i+len+1] && wire_name[i+len+1] <= '9')
 					len++;
 
 				if (len > 0) {
-					string num_str = wire_name.substr(i+1, len);
-					int num = atoi(num_str.c_str()) & 0x0fffffff;
+					int num = atoi(wire_name+i+1) & 0x0fffffff;
 					blif_maxnum = std::max(blif_maxnum, num);
 				}
 			}
 		}
 
-		IdString wire_id = RTLIL::escape_id(wire_name);
+		IdString wire_id = escaped_id(wire_name);
 		Wire *wire = module->wire(wire_id);
 
 		if (wire == nullptr)
@@ -135,7 +174,7 @@ void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool
 
 	while (1)
 	{
-		if (!read_next_line(buffer, buffer_size, line_count, f)) {
+		if (!read_next_line(buffer, buffer_size, line_count, ptr, end)) {
 			if (module != nullptr)
 				goto error;
 			free(buffer);
@@ -176,6 +215,9 @@ void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool
 				obj_parameters = nullptr;
 				if (design->module(module->name))
 					log_error("Duplicate definition of module %s in line %d!\n", log_id(module->name), line_count);
+				int num_cells = count_model_cells(ptr, end);
+				module->cells_.reserve(num_cells);
+				module->wires_.reserve(num_cells);
 				design->add(module);
 				continue;
 			}
@@ -271,7 +313,7 @@ void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool
 				char *p;
 				while ((p = strtok(NULL, " \t\r\n")) != NULL)
 				{
-					RTLIL::IdString wire_name(stringf("\\%s", p));
+					RTLIL::IdString wire_name(escaped_id(p));
 					RTLIL::Wire *wire = module->wire(wire_name);
 					if (wire == nullptr)
 						wire = module->addWire(wire_name);
@@ -482,7 +524,7 @@ void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool
 				{
 					RTLIL::State state = RTLIL::State::Sa;
 					while (1) {
-						if (!read_next_line(buffer, buffer_size, line_count, f))
+						if (!read_next_line(buffer, buffer_size, line_count, ptr, end))
 							goto error;
 						for (int i = 0; buffer[i]; i++) {
 							if (buffer[i] == ' ' || buffer[i] == '\t')
@@ -621,6 +663,15 @@ error_with_reason:
 	log_error("Syntax error in line %d: %s\n", line_count, err_reason.c_str());
 }
 
+void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool run_clean, bool sop_mode, bool wideports)
+{
+	std::string data;
+	char chunk[65536];
+	while (f.read(chunk, sizeof(chunk)) || f.gcount() > 0)
+		data.append(chunk, f.gcount());
+	parse_blif(design, data.data(), data.size(), dff_name, run_clean, sop_mode, wideports);
+}
+
 struct BlifFrontend : public Frontend {
 	BlifFrontend() : Frontend("blif", "read BLIF file") { }
 	void help() override
@@ -661,7 +712,9 @@ struct BlifFrontend : public Frontend {
 		}
 		extra_args(f, filename, args, argidx);
 
-		parse_blif(design, *f, "", true, sop_mode, wideports);
+		read_input_data(f, filename, [&](const char *data, size_t size) {
+			parse_blif(design, data, size, "", true, sop_mode, wideports);
+		});
 	}
 } BlifFrontend;
 
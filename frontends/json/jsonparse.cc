@@ -18,236 +18,264 @@
  */
 
 #include "kernel/yosys.h"
+#include <climits>
 
 YOSYS_NAMESPACE_BEGIN
 
-struct JsonNode
+// A scalar JSON value: a string (type S) or an integer number (type N).
+// Real numbers are kept as strings, as that is how they are imported.
+struct JsonScalar
 {
-	char type; // S=String, N=Number, A=Array, D=Dict
+	char type = 0;
 	string data_string;
-	int64_t data_number;
-	vector<JsonNode*> data_array;
-	dict<string, JsonNode*> data_dict;
-	vector<string> data_dict_keys;
-
-	JsonNode(std::istream &f)
-	{
-		type = 0;
-		data_number = 0;
-
-		while (1)
-		{
-			int ch = f.get();
-
-			if (ch == EOF)
-				log_error("Unexpected EOF in JSON file.\n");
+	int64_t data_number = 0;
+};
 
-			if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
-				continue;
+// Streaming JSON reader. Values are consumed while they are read, so that
+// no tree of the input needs to be built. Like the original tree parser,
+// commas and colons are treated as whitespace.
+struct JsonReader
+{
+	std::istream &f;
+	std::vector<char> buffer;
+	size_t pos = 0, len = 0;
+	string digits;
 
-			if (ch == '"')
-			{
-				type = 'S';
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						log_error("Unexpected EOF in JSON string.\n");
-
-					if (ch == '"')
-						break;
-
-					if (ch == '\\') {
-						ch = f.get();
-
-						switch (ch) {
-							case EOF: log_error("Unexpected EOF in JSON string.\n"); break;
-							case '"':
-							case '/':
-							case '\\':           break;
-							case 'b': ch = '\b'; break;
-							case 'f': ch = '\f'; break;
-							case 'n': ch = '\n'; break;
-							case 'r': ch = '\r'; break;
-							case 't': ch = '\t'; break;
-							case 'u':
-								int val = 0;
-								for (int i = 0; i < 4; i++) {
-									ch = f.get();
-									val <<= 4;
-									if (ch >= '0' && '9' >= ch) {
-										val += ch - '0';
-									} else if (ch >= 'A' && 'F' >= ch) {
-										val += 10 + ch - 'A';
-									} else if (ch >= 'a' && 'f' >= ch) {
-										val += 10 + ch - 'a';
-									} else
-										log_error("Unexpected non-digit character in \\uXXXX sequence: %c.\n", ch);
-								}
-								if (val < 128)
-									ch = val;
-								else
-									log_error("Unsupported \\uXXXX sequence in JSON string: %04X.\n", val);
-								break;
-						}
-					}
+	JsonReader(std::istream &f) : f(f), buffer(1 << 16) { }
 
-					data_string += ch;
-				}
+	bool fill()
+	{
+		f.read(buffer.data(), buffer.size());
+		len = f.gcount();
+		pos = 0;
+		return len > 0;
+	}
 
-				break;
-			}
+	int peek()
+	{
+		if (pos == len && !fill())
+			return EOF;
+		return (unsigned char)buffer[pos];
+	}
 
-			if (('0' <= ch && ch <= '9') || ch == '-')
-			{
-				bool negative = false;
-				type = 'N';
-				if (ch == '-') {
-					data_number = 0;
-				       	negative = true;
-				} else {
-					data_number = ch - '0';
-				}
+	int get()
+	{
+		int ch = peek();
+		if (ch != EOF)
+			pos++;
+		return ch;
+	}
 
-				data_string += ch;
+	// skip whitespace and the given separator, returns the next character
+	int skip_space(char separator = 0)
+	{
+		while (1) {
+			int ch = peek();
+			if (ch == EOF)
+				log_error("Unexpected EOF in JSON file.\n");
+			if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n' && ch != separator)
+				return ch;
+			pos++;
+		}
+	}
 
-				while (1)
-				{
-					ch = f.get();
+	// returns the type of the next value (S, N, A or D) without consuming it
+	char next_value()
+	{
+		int ch = skip_space();
+		if (ch == '"')
+			return 'S';
+		if (('0' <= ch && ch <= '9') || ch == '-')
+			return 'N';
+		if (ch == '[')
+			return 'A';
+		if (ch == '{')
+			return 'D';
+		log_error("Unexpected character in JSON file: '%c'\n", ch);
+	}
 
-					if (ch == EOF)
-						break;
+	void read_string(string &str)
+	{
+		str.clear();
+		log_assert(get() == '"');
 
-					if (ch == '.')
-						goto parse_real;
+		while (1)
+		{
+			// copy plain characters out of the buffer in one go
+			size_t start = pos;
+			while (pos < len && buffer[pos] != '"' && buffer[pos] != '\\')
+				pos++;
+			str.append(buffer.data() + start, pos - start);
 
-					if (ch < '0' || '9' < ch) {
-						f.unget();
-						break;
-					}
+			int ch = get();
 
-					data_number = data_number*10 + (ch - '0');
-					data_string += ch;
-				}
+			if (ch == EOF)
+				log_error("Unexpected EOF in JSON string.\n");
 
-				data_number = negative ? -data_number : data_number;
-				data_string = "";
+			if (ch == '"')
 				break;
 
-			parse_real:
-				type = 'S';
-				data_number = 0;
-				data_string += ch;
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						break;
+			if (ch != '\\')
+				continue;
 
-					if (ch < '0' || '9' < ch) {
-						f.unget();
-						break;
+			ch = get();
+
+			switch (ch) {
+				case EOF: log_error("Unexpected EOF in JSON string.\n"); break;
+				case '"':
+				case '/':
+				case '\\':           break;
+				case 'b': ch = '\b'; break;
+				case 'f': ch = '\f'; break;
+				case 'n': ch = '\n'; break;
+				case 'r': ch = '\r'; break;
+				case 't': ch = '\t'; break;
+				case 'u':
+					int val = 0;
+					for (int i = 0; i < 4; i++) {
+						ch = get();
+						val <<= 4;
+						if (ch >= '0' && '9' >= ch) {
+							val += ch - '0';
+						} else if (ch >= 'A' && 'F' >= ch) {
+							val += 10 + ch - 'A';
+						} else if (ch >= 'a' && 'f' >= ch) {
+							val += 10 + ch - 'a';
+						} else
+							log_error("Unexpected non-digit character in \\uXXXX sequence: %c.\n", ch);
 					}
-
-					data_string += ch;
-				}
-
-				break;
+					if (val < 128)
+						ch = val;
+					else
+						log_error("Unsupported \\uXXXX sequence in JSON string: %04X.\n", val);
+					break;
 			}
 
-			if (ch == '[')
-			{
-				type = 'A';
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						log_error("Unexpected EOF in JSON file.\n");
+			str += ch;
+		}
+	}
 
-					if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ',')
-						continue;
+	void read_number(JsonScalar &value)
+	{
+		int ch = get();
+		bool negative = ch == '-';
+		int64_t number = negative ? 0 : ch - '0';
 
-					if (ch == ']')
-						break;
-
-					f.unget();
-					data_array.push_back(new JsonNode(f));
-				}
+		// the digits are only kept in case this turns out to be a real number
+		digits.clear();
+		digits += ch;
 
+		while (1)
+		{
+			ch = peek();
+			if (ch < '0' || '9' < ch)
 				break;
-			}
-
-			if (ch == '{')
-			{
-				type = 'D';
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						log_error("Unexpected EOF in JSON file.\n");
-
-					if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ',')
-						continue;
-
-					if (ch == '}')
-						break;
-
-					f.unget();
-					JsonNode key(f);
-
-					while (1)
-					{
-						ch = f.get();
-
-						if (ch == EOF)
-							log_error("Unexpected EOF in JSON file.\n");
-
-						if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ':')
-							continue;
+			number = number*10 + (ch - '0');
+			digits += ch;
+			pos++;
+		}
 
-						f.unget();
-						break;
-					}
+		if (ch != '.') {
+			value.type = 'N';
+			value.data_number = negative ? -number : number;
+			return;
+		}
 
-					JsonNode *value = new JsonNode(f);
+		// real numbers are imported as strings
+		pos++;
+		value.type = 'S';
+		value.data_number = 0;
+		value.data_string = digits + '.';
+		while (1)
+		{
+			ch = peek();
+			if (ch < '0' || '9' < ch)
+				break;
+			value.data_string += ch;
+			pos++;
+		}
+	}
 
-					if (key.type != 'S')
-						log_error("Unexpected non-string key in JSON dict.\n");
+	// reads a string or number, returns false (without consuming anything)
+	// for arrays and dicts
+	bool read_scalar(JsonScalar &value)
+	{
+		char type = next_value();
+		if (type == 'S') {
+			value.type = 'S';
+			value.data_number = 0;
+			read_string(value.data_string);
+			return true;
+		}
+		if (type == 'N') {
+			read_number(value);
+			return true;
+		}
+		return false;
+	}
 
-					data_dict[key.data_string] = value;
-					data_dict_keys.push_back(key.data_string);
+	void skip_value()
+	{
+		JsonScalar scratch;
+		int depth = 0;
+		do {
+			char type = next_value();
+			if (type == 'S' || type == 'N') {
+				read_scalar(scratch);
+			} else {
+				pos++;
+				depth++;
+			}
+			while (depth > 0) {
+				int ch = skip_space(',');
+				if (ch == ':') {
+					pos++;
+					continue;
 				}
-
-				break;
+				if (ch != ']' && ch != '}')
+					break;
+				pos++;
+				depth--;
 			}
+		} while (depth > 0);
+	}
 
-			log_error("Unexpected character in JSON file: '%c'\n", ch);
-		}
+	void begin(char ch)
+	{
+		log_assert(skip_space() == ch);
+		pos++;
+	}
+
+	// moves to the next element of an array, returns false at its end
+	bool array_next()
+	{
+		if (skip_space(',') != ']')
+			return true;
+		pos++;
+		return false;
 	}
 
-	~JsonNode()
+	// reads the next key of a dict, returns false at its end
+	bool dict_next(string &key)
 	{
-		for (auto it : data_array)
-			delete it;
-		for (auto &it : data_dict)
-			delete it.second;
+		if (skip_space(',') == '}') {
+			pos++;
+			return false;
+		}
+		if (next_value() != 'S')
+			log_error("Unexpected non-string key in JSON dict.\n");
+		read_string(key);
+		skip_space(':');
+		return true;
 	}
 };
 
-Const json_parse_attr_param_value(JsonNode *node)
+Const json_parse_attr_param_value(const JsonScalar &node)
 {
 	Const value;
 
-	if (node->type == 'S') {
-		string &s = node->data_string;
+	if (node.type == 'S') {
+		const string &s = node.data_string;
 		size_t cursor = s.find_first_not_of("01xz");
 		if (cursor == string::npos) {
 			value = Const::from_string(s);
@@ -257,16 +285,10 @@ Const json_parse_attr_param_value(JsonNode *node)
 			value = Const(s);
 		}
 	} else
-	if (node->type == 'N') {
-		value = Const(node->data_number, 32);
-		if (node->data_number < 0)
+	if (node.type == 'N') {
+		value = Const(node.data_number, 32);
+		if (node.data_number < 0)
 			value.flags |= RTLIL::CONST_FLAG_SIGNED;
-	} else
-	if (node->type == 'A') {
-		log_error("JSON attribute or parameter value is an array.\n");
-	} else
-	if (node->type == 'D') {
-		log_error("JSON attribute or parameter value is a dict.\n");
 	} else {
 		log_abort();
 	}
@@ -274,20 +296,130 @@ Const json_parse_attr_param_value(JsonNode *node)
 	return value;
 }
 
-void json_parse_attr_param(dict<IdString, Const> &results, JsonNode *node)
+void json_parse_attr_param(dict<IdString, Const> &results, JsonReader &reader)
 {
-	if (node->type != 'D')
+	if (reader.next_value() != 'D')
 		log_error("JSON attributes or parameters node is not a dictionary.\n");
 
-	for (auto it : node->data_dict)
+	// collected first, so that the results are inserted in the same order as
+	// they were when the whole JSON tree was built
+	dict<string, JsonScalar> values;
+	string key;
+	reader.begin('{');
+	while (reader.dict_next(key)) {
+		JsonScalar &value = values[key];
+		if (!reader.read_scalar(value))
+			log_error("JSON attribute or parameter value is %s.\n", reader.next_value() == 'A' ? "an array" : "a dict");
+	}
+
+	for (auto &it : values)
+		results[RTLIL::escape_id(it.first.c_str())] = json_parse_attr_param_value(it.second);
+}
+
+// Signal bits are stored as the bit index from the JSON file, constant bits
+// as json_const_bit plus the State value.
+static const int json_const_bit = INT_MIN;
+
+static bool json_bit_is_const(int bit)
+{
+	return bit < json_const_bit + 8;
+}
+
+template<typename Context>
+void json_parse_bits(std::vector<int> &bits, JsonReader &reader, Context context)
+{
+	bits.clear();
+	JsonScalar bitval;
+	reader.begin('[');
+	while (reader.array_next())
 	{
-		IdString key = RTLIL::escape_id(it.first.c_str());
-		Const value = json_parse_attr_param_value(it.second);
-		results[key] = value;
+		int i = GetSize(bits);
+
+		if (!reader.read_scalar(bitval))
+			log_error("%s has invalid bit value on bit %d.\n", context().c_str(), i);
+
+		if (bitval.type == 'S') {
+			if (bitval.data_string == "0")
+				bits.push_back(json_const_bit + State::S0);
+			else if (bitval.data_string == "1")
+				bits.push_back(json_const_bit + State::S1);
+			else if (bitval.data_string == "x")
+				bits.push_back(json_const_bit + State::Sx);
+			else if (bitval.data_string == "z")
+				bits.push_back(json_const_bit + State::Sz);
+			else
+				log_error("%s has invalid '%s' bit string value on bit %d.\n",
+						context().c_str(), bitval.data_string.c_str(), i);
+		} else {
+			bits.push_back(bitval.data_number);
+		}
 	}
 }
 
-void json_import(Design *design, string &modname, JsonNode *node)
+// optional integer property (only used if it is a number)
+struct JsonOptInt
+{
+	bool valid = false;
+	int64_t value = 0;
+
+	void read(JsonReader &reader)
+	{
+		JsonScalar scalar;
+		if (reader.read_scalar(scalar)) {
+			valid = scalar.type == 'N';
+			value = scalar.data_number;
+		} else
+			reader.skip_value();
+	}
+};
+
+struct JsonPortEntry
+{
+	char direction_type = 0, bits_type = 0;
+	string direction;
+	std::vector<int> bits;
+	JsonOptInt upto, is_signed, offset;
+};
+
+struct JsonNetEntry
+{
+	char bits_type = 0;
+	std::vector<int> bits;
+	JsonOptInt upto, offset;
+	dict<IdString, Const> attributes;
+};
+
+struct JsonCellEntry
+{
+	char type_type = 0, connections_type = 0;
+	string type;
+	dict<string, std::vector<int>> connections;
+	dict<IdString, Const> attributes, parameters;
+};
+
+struct JsonMemoryEntry
+{
+	char width_type = 0, size_type = 0;
+	int64_t width = 0, size = 0;
+	JsonOptInt start_offset;
+	dict<IdString, Const> attributes;
+};
+
+static void json_entry_dict(JsonReader &reader, const char *fmt, const string &name)
+{
+	if (reader.next_value() != 'D')
+		log_error(fmt, log_id(RTLIL::escape_id(name.c_str())));
+	reader.begin('{');
+}
+
+static void json_section_dict(JsonReader &reader, const char *what)
+{
+	if (reader.next_value() != 'D')
+		log_error("JSON %s node is not a dictionary.\n", what);
+	reader.begin('{');
+}
+
+void json_import(Design *design, string &modname, JsonReader &reader)
 {
 	log("Importing module %s from JSON tree.\n", modname.c_str());
 
@@ -299,319 +431,348 @@ void json_import(Design *design, string &modname, JsonNode *node)
 
 	design->add(module);
 
-	if (node->data_dict.count("attributes"))
-		json_parse_attr_param(module->attributes, node->data_dict.at("attributes"));
-
-	dict<int, SigBit> signal_bits;
+	if (reader.next_value() != 'D') {
+		reader.skip_value();
+		return;
+	}
 
-	if (node->data_dict.count("ports"))
+	// The sections of the module are read into compact entries first, and
+	// imported in a fixed order afterwards, as the import of netnames and
+	// cells depends on the ports.
+	bool has_ports = false;
+	std::vector<string> port_keys;
+	dict<string, JsonPortEntry> ports;
+	dict<string, JsonNetEntry> netnames;
+	dict<string, JsonCellEntry> cells;
+	dict<string, JsonMemoryEntry> memories;
+
+	string key, name, field;
+	reader.begin('{');
+	while (reader.dict_next(key))
 	{
-		JsonNode *ports_node = node->data_dict.at("ports");
+		if (key == "attributes") {
+			json_parse_attr_param(module->attributes, reader);
+		} else
+		if (key == "ports") {
+			has_ports = true;
+			json_section_dict(reader, "ports");
+			while (reader.dict_next(name)) {
+				port_keys.push_back(name);
+				JsonPortEntry &port = ports[name] = JsonPortEntry();
+				json_entry_dict(reader, "JSON port node '%s' is not a dictionary.\n", name);
+				while (reader.dict_next(field)) {
+					if (field == "direction") {
+						port.direction_type = reader.next_value();
+						if (port.direction_type == 'S')
+							reader.read_string(port.direction);
+						else
+							reader.skip_value();
+					} else if (field == "bits") {
+						port.bits_type = reader.next_value();
+						if (port.bits_type == 'A')
+							json_parse_bits(port.bits, reader, [&]() {
+								return stringf("JSON port node '%s'", log_id(RTLIL::escape_id(name.c_str())));
+							});
+						else
+							reader.skip_value();
+					} else if (field == "upto") {
+						port.upto.read(reader);
+					} else if (field == "signed") {
+						port.is_signed.read(reader);
+					} else if (field == "offset") {
+						port.offset.read(reader);
+					} else
+						reader.skip_value();
+				}
+			}
+		} else
+		if (key == "netnames") {
+			json_section_dict(reader, "netnames");
+			while (reader.dict_next(name)) {
+				JsonNetEntry &net = netnames[name] = JsonNetEntry();
+				json_entry_dict(reader, "JSON netname node '%s' is not a dictionary.\n", name);
+				while (reader.dict_next(field)) {
+					if (field == "bits") {
+						net.bits_type = reader.next_value();
+						if (net.bits_type == 'A')
+							json_parse_bits(net.bits, reader, [&]() {
+								return stringf("JSON netname node '%s'", log_id(RTLIL::escape_id(name.c_str())));
+							});
+						else
+							reader.skip_value();
+					} else if (field == "upto") {
+						net.upto.read(reader);
+					} else if (field == "offset") {
+						net.offset.read(reader);
+					} else if (field == "attributes") {
+						json_parse_attr_param(net.attributes, reader);
+					} else
+						reader.skip_value();
+				}
+			}
+		} else
+		if (key == "cells") {
+			json_section_dict(reader, "cells");
+			while (reader.dict_next(name)) {
+				JsonCellEntry &cell = cells[name] = JsonCellEntry();
+				json_entry_dict(reader, "JSON cells node '%s' is not a dictionary.\n", name);
+				while (reader.dict_next(field)) {
+					if (field == "type") {
+						cell.type_type = reader.next_value();
+						if (cell.type_type == 'S')
+							reader.read_string(cell.type);
+						else
+							reader.skip_value();
+					} else if (field == "connections") {
+						cell.connections_type = reader.next_value();
+						if (cell.connections_type != 'D') {
+							reader.skip_value();
+							continue;
+						}
+						cell.connections.clear();
+						string conn_name;
+						reader.begin('{');
+						while (reader.dict_next(conn_name)) {
+							if (reader.next_value() != 'A')
+								log_error("JSON cells node '%s' connection '%s' is not an array.\n",
+										log_id(RTLIL::escape_id(name.c_str())), log_id(RTLIL::escape_id(conn_name.c_str())));
+							json_parse_bits(cell.connections[conn_name], reader, [&]() {
+								return stringf("JSON cells node '%s' connection '%s'",
+										log_id(RTLIL::escape_id(name.c_str())), log_id(RTLIL::escape_id(conn_name.c_str())));
+							});
+						}
+					} else if (field == "attributes") {
+						json_parse_attr_param(cell.attributes, reader);
+					} else if (field == "parameters") {
+						json_parse_attr_param(cell.parameters, reader);
+					} else
+						reader.skip_value();
+				}
+			}
+		} else
+		if (key == "memories") {
+			json_section_dict(reader, "memories");
+			while (reader.dict_next(name)) {
+				JsonMemoryEntry &mem = memories[name] = JsonMemoryEntry();
+				json_entry_dict(reader, "JSON memory node '%s' is not a dictionary.\n", name);
+				while (reader.dict_next(field)) {
+					if (field == "width" || field == "size") {
+						JsonScalar scalar;
+						char type = reader.next_value();
+						if (!reader.read_scalar(scalar))
+							reader.skip_value();
+						else
+							type = scalar.type;
+						(field == "width" ? mem.width_type : mem.size_type) = type;
+						(field == "width" ? mem.width : mem.size) = scalar.data_number;
+					} else if (field == "start_offset") {
+						mem.start_offset.read(reader);
+					} else if (field == "attributes") {
+						json_parse_attr_param(mem.attributes, reader);
+					} else
+						reader.skip_value();
+				}
+			}
+		} else
+			reader.skip_value();
+	}
 
-		if (ports_node->type != 'D')
-			log_error("JSON ports node is not a dictionary.\n");
+	dict<int, SigBit> signal_bits;
 
-		for (int port_id = 1; port_id <= GetSize(ports_node->data_dict_keys); port_id++)
+	if (has_ports)
+	{
+		for (int port_id = 1; port_id <= GetSize(port_keys); port_id++)
 		{
-			IdString port_name = RTLIL::escape_id(ports_node->data_dict_keys[port_id-1].c_str());
-			JsonNode *port_node = ports_node->data_dict.at(ports_node->data_dict_keys[port_id-1]);
-
-			if (port_node->type != 'D')
-				log_error("JSON port node '%s' is not a dictionary.\n", log_id(port_name));
+			IdString port_name = RTLIL::escape_id(port_keys[port_id-1].c_str());
+			JsonPortEntry &port = ports.at(port_keys[port_id-1]);
 
-			if (port_node->data_dict.count("direction") == 0)
+			if (port.direction_type == 0)
 				log_error("JSON port node '%s' has no direction attribute.\n", log_id(port_name));
 
-			if (port_node->data_dict.count("bits") == 0)
+			if (port.bits_type == 0)
 				log_error("JSON port node '%s' has no bits attribute.\n", log_id(port_name));
 
-			JsonNode *port_direction_node = port_node->data_dict.at("direction");
-			JsonNode *port_bits_node = port_node->data_dict.at("bits");
-
-			if (port_direction_node->type != 'S')
+			if (port.direction_type != 'S')
 				log_error("JSON port node '%s' has non-string direction attribute.\n", log_id(port_name));
 
-			if (port_bits_node->type != 'A')
+			if (port.bits_type != 'A')
 				log_error("JSON port node '%s' has non-array bits attribute.\n", log_id(port_name));
 
 			Wire *port_wire = module->wire(port_name);
 
 			if (port_wire == nullptr)
-				port_wire = module->addWire(port_name, GetSize(port_bits_node->data_array));
+				port_wire = module->addWire(port_name, GetSize(port.bits));
 
-			if (port_node->data_dict.count("upto") != 0) {
-				JsonNode *val = port_node->data_dict.at("upto");
-				if (val->type == 'N')
-					port_wire->upto = val->data_number != 0;
-			}
+			if (port.upto.valid)
+				port_wire->upto = port.upto.value != 0;
 
-			if (port_node->data_dict.count("signed") != 0) {
-				JsonNode *val = port_node->data_dict.at("signed");
-				if (val->type == 'N')
-					port_wire->is_signed = val->data_number != 0;
-			}
+			if (port.is_signed.valid)
+				port_wire->is_signed = port.is_signed.value != 0;
 
-			if (port_node->data_dict.count("offset") != 0) {
-				JsonNode *val = port_node->data_dict.at("offset");
-				if (val->type == 'N')
-					port_wire->start_offset = val->data_number;
-			}
+			if (port.offset.valid)
+				port_wire->start_offset = port.offset.value;
 
-			if (port_direction_node->data_string == "input") {
+			if (port.direction == "input") {
 				port_wire->port_input = true;
 			} else
-			if (port_direction_node->data_string == "output") {
+			if (port.direction == "output") {
 				port_wire->port_output = true;
 			} else
-			if (port_direction_node->data_string == "inout") {
+			if (port.direction == "inout") {
 				port_wire->port_input = true;
 				port_wire->port_output = true;
 			} else
-				log_error("JSON port node '%s' has invalid '%s' direction attribute.\n", log_id(port_name), port_direction_node->data_string.c_str());
+				log_error("JSON port node '%s' has invalid '%s' direction attribute.\n", log_id(port_name), port.direction.c_str());
 
 			port_wire->port_id = port_id;
 
-			for (int i = 0; i < GetSize(port_bits_node->data_array); i++)
+			for (int i = 0; i < GetSize(port.bits); i++)
 			{
-				JsonNode *bitval_node = port_bits_node->data_array.at(i);
+				int bitidx = port.bits[i];
 				SigBit sigbit(port_wire, i);
 
-				if (bitval_node->type == 'S') {
-					if (bitval_node->data_string == "0")
-						module->connect(sigbit, State::S0);
-					else if (bitval_node->data_string == "1")
-						module->connect(sigbit, State::S1);
-					else if (bitval_node->data_string == "x")
-						module->connect(sigbit, State::Sx);
-					else if (bitval_node->data_string == "z")
-						module->connect(sigbit, State::Sz);
-					else
-						log_error("JSON port node '%s' has invalid '%s' bit string value on bit %d.\n",
-								log_id(port_name), bitval_node->data_string.c_str(), i);
+				if (json_bit_is_const(bitidx)) {
+					module->connect(sigbit, State(bitidx - json_const_bit));
 				} else
-				if (bitval_node->type == 'N') {
-					int bitidx = bitval_node->data_number;
-					if (signal_bits.count(bitidx)) {
-						if (port_wire->port_output) {
-							module->connect(sigbit, signal_bits.at(bitidx));
-						} else {
-							module->connect(signal_bits.at(bitidx), sigbit);
-							signal_bits[bitidx] = sigbit;
-						}
+				if (signal_bits.count(bitidx)) {
+					if (port_wire->port_output) {
+						module->connect(sigbit, signal_bits.at(bitidx));
 					} else {
+						module->connect(signal_bits.at(bitidx), sigbit);
 						signal_bits[bitidx] = sigbit;
 					}
-				} else
-					log_error("JSON port node '%s' has invalid bit value on bit %d.\n", log_id(port_name), i);
+				} else {
+					signal_bits[bitidx] = sigbit;
+				}
 			}
 		}
 
 		module->fixup_ports();
 	}
+	ports.clear();
 
-	if (node->data_dict.count("netnames"))
+	for (auto &net : netnames)
 	{
-		JsonNode *netnames_node = node->data_dict.at("netnames");
-
-		if (netnames_node->type != 'D')
-			log_error("JSON netnames node is not a dictionary.\n");
-
-		for (auto &net : netnames_node->data_dict)
-		{
-			IdString net_name = RTLIL::escape_id(net.first.c_str());
-			JsonNode *net_node = net.second;
-
-			if (net_node->type != 'D')
-				log_error("JSON netname node '%s' is not a dictionary.\n", log_id(net_name));
+		IdString net_name = RTLIL::escape_id(net.first.c_str());
+		JsonNetEntry &net_entry = net.second;
 
-			if (net_node->data_dict.count("bits") == 0)
-				log_error("JSON netname node '%s' has no bits attribute.\n", log_id(net_name));
+		if (net_entry.bits_type == 0)
+			log_error("JSON netname node '%s' has no bits attribute.\n", log_id(net_name));
 
-			JsonNode *bits_node = net_node->data_dict.at("bits");
+		if (net_entry.bits_type != 'A')
+			log_error("JSON netname node '%s' has non-array bits attribute.\n", log_id(net_name));
 
-			if (bits_node->type != 'A')
-				log_error("JSON netname node '%s' has non-array bits attribute.\n", log_id(net_name));
+		Wire *wire = module->wire(net_name);
 
-			Wire *wire = module->wire(net_name);
+		if (wire == nullptr)
+			wire = module->addWire(net_name, GetSize(net_entry.bits));
 
-			if (wire == nullptr)
-				wire = module->addWire(net_name, GetSize(bits_node->data_array));
+		if (net_entry.upto.valid)
+			wire->upto = net_entry.upto.value != 0;
 
-			if (net_node->data_dict.count("upto") != 0) {
-				JsonNode *val = net_node->data_dict.at("upto");
-				if (val->type == 'N')
-					wire->upto = val->data_number != 0;
-			}
+		if (net_entry.offset.valid)
+			wire->start_offset = net_entry.offset.value;
 
-			if (net_node->data_dict.count("offset") != 0) {
-				JsonNode *val = net_node->data_dict.at("offset");
-				if (val->type == 'N')
-					wire->start_offset = val->data_number;
-			}
+		for (int i = 0; i < GetSize(net_entry.bits); i++)
+		{
+			int bitidx = net_entry.bits[i];
+			SigBit sigbit(wire, i);
 
-			for (int i = 0; i < GetSize(bits_node->data_array); i++)
-			{
-				JsonNode *bitval_node = bits_node->data_array.at(i);
-				SigBit sigbit(wire, i);
-
-				if (bitval_node->type == 'S') {
-					if (bitval_node->data_string == "0")
-						module->connect(sigbit, State::S0);
-					else if (bitval_node->data_string == "1")
-						module->connect(sigbit, State::S1);
-					else if (bitval_node->data_string == "x")
-						module->connect(sigbit, State::Sx);
-					else if (bitval_node->data_string == "z")
-						module->connect(sigbit, State::Sz);
-					else
-						log_error("JSON netname node '%s' has invalid '%s' bit string value on bit %d.\n",
-								log_id(net_name), bitval_node->data_string.c_str(), i);
-				} else
-				if (bitval_node->type == 'N') {
-					int bitidx = bitval_node->data_number;
-					if (signal_bits.count(bitidx)) {
-						if (sigbit != signal_bits.at(bitidx))
-							module->connect(sigbit, signal_bits.at(bitidx));
-					} else {
-						signal_bits[bitidx] = sigbit;
-					}
-				} else
-					log_error("JSON netname node '%s' has invalid bit value on bit %d.\n", log_id(net_name), i);
+			if (json_bit_is_const(bitidx)) {
+				module->connect(sigbit, State(bitidx - json_const_bit));
+			} else
+			if (signal_bits.count(bitidx)) {
+				if (sigbit != signal_bits.at(bitidx))
+					module->connect(sigbit, signal_bits.at(bitidx));
+			} else {
+				signal_bits[bitidx] = sigbit;
 			}
-
-			if (net_node->data_dict.count("attributes"))
-				json_parse_attr_param(wire->attributes, net_node->data_dict.at("attributes"));
 		}
+
+		for (auto &attr : net_entry.attributes)
+			wire->attributes[attr.first] = attr.second;
 	}
+	netnames.clear();
 
-	if (node->data_dict.count("cells"))
+	for (auto &cell_it : cells)
 	{
-		JsonNode *cells_node = node->data_dict.at("cells");
-
-		if (cells_node->type != 'D')
-			log_error("JSON cells node is not a dictionary.\n");
-
-		for (auto &cell_node_it : cells_node->data_dict)
-		{
-			IdString cell_name = RTLIL::escape_id(cell_node_it.first.c_str());
-			JsonNode *cell_node = cell_node_it.second;
-
-			if (cell_node->type != 'D')
-				log_error("JSON cells node '%s' is not a dictionary.\n", log_id(cell_name));
-
-			if (cell_node->data_dict.count("type") == 0)
-				log_error("JSON cells node '%s' has no type attribute.\n", log_id(cell_name));
+		IdString cell_name = RTLIL::escape_id(cell_it.first.c_str());
+		JsonCellEntry &cell_entry = cell_it.second;
 
-			JsonNode *type_node = cell_node->data_dict.at("type");
+		if (cell_entry.type_type == 0)
+			log_error("JSON cells node '%s' has no type attribute.\n", log_id(cell_name));
 
-			if (type_node->type != 'S')
-				log_error("JSON cells node '%s' has a non-string type.\n", log_id(cell_name));
+		if (cell_entry.type_type != 'S')
+			log_error("JSON cells node '%s' has a non-string type.\n", log_id(cell_name));
 
-			IdString cell_type = RTLIL::escape_id(type_node->data_string.c_str());
+		IdString cell_type = RTLIL::escape_id(cell_entry.type.c_str());
 
-			Cell *cell = module->addCell(cell_name, cell_type);
+		Cell *cell = module->addCell(cell_name, cell_type);
 
-			if (cell_node->data_dict.count("connections") == 0)
-				log_error("JSON cells node '%s' has no connections attribute.\n", log_id(cell_name));
+		if (cell_entry.connections_type == 0)
+			log_error("JSON cells node '%s' has no connections attribute.\n", log_id(cell_name));
 
-			JsonNode *connections_node = cell_node->data_dict.at("connections");
+		if (cell_entry.connections_type != 'D')
+			log_error("JSON cells node '%s' has non-dictionary connections attribute.\n", log_id(cell_name));
 
-			if (connections_node->type != 'D')
-				log_error("JSON cells node '%s' has non-dictionary connections attribute.\n", log_id(cell_name));
+		for (auto &conn_it : cell_entry.connections)
+		{
+			IdString conn_name = RTLIL::escape_id(conn_it.first.c_str());
+			SigSpec sig;
 
-			for (auto &conn_it : connections_node->data_dict)
+			for (int bitidx : conn_it.second)
 			{
-				IdString conn_name = RTLIL::escape_id(conn_it.first.c_str());
-				JsonNode *conn_node = conn_it.second;
-
-				if (conn_node->type != 'A')
-					log_error("JSON cells node '%s' connection '%s' is not an array.\n", log_id(cell_name), log_id(conn_name));
-
-				SigSpec sig;
-
-				for (int i = 0; i < GetSize(conn_node->data_array); i++)
-				{
-					JsonNode *bitval_node = conn_node->data_array.at(i);
-
-					if (bitval_node->type == 'S') {
-						if (bitval_node->data_string == "0")
-							sig.append(State::S0);
-						else if (bitval_node->data_string == "1")
-							sig.append(State::S1);
-						else if (bitval_node->data_string == "x")
-							sig.append(State::Sx);
-						else if (bitval_node->data_string == "z")
-							sig.append(State::Sz);
-						else
-							log_error("JSON cells node '%s' connection '%s' has invalid '%s' bit string value on bit %d.\n",
-									log_id(cell_name), log_id(conn_name), bitval_node->data_string.c_str(), i);
-					} else
-					if (bitval_node->type == 'N') {
-						int bitidx = bitval_node->data_number;
-						if (signal_bits.count(bitidx) == 0)
-							signal_bits[bitidx] = module->addWire(NEW_ID);
-						sig.append(signal_bits.at(bitidx));
-					} else
-						log_error("JSON cells node '%s' connection '%s' has invalid bit value on bit %d.\n",
-								log_id(cell_name), log_id(conn_name), i);
-
+				if (json_bit_is_const(bitidx)) {
+					sig.append(State(bitidx - json_const_bit));
+				} else {
+					if (signal_bits.count(bitidx) == 0)
+						signal_bits[bitidx] = module->addWire(NEW_ID);
+					sig.append(signal_bits.at(bitidx));
 				}
-
-				cell->setPort(conn_name, sig);
 			}
 
-			if (cell_node->data_dict.count("attributes"))
-				json_parse_attr_param(cell->attributes, cell_node->data_dict.at("attributes"));
-
-			if (cell_node->data_dict.count("parameters"))
-				json_parse_attr_param(cell->parameters, cell_node->data_dict.at("parameters"));
+			cell->setPort(conn_name, sig);
 		}
+
+		for (auto &attr : cell_entry.attributes)
+			cell->attributes[attr.first] = attr.second;
+
+		for (auto &param : cell_entry.parameters)
+			cell->parameters[param.first] = param.second;
+
+		// release the entry as soon as the cell exists
+		cell_entry = JsonCellEntry();
 	}
+	cells.clear();
 
-	if (node->data_dict.count("memories"))
+	for (auto &memory_node_it : memories)
 	{
-		JsonNode *memories_node = node->data_dict.at("memories");
+		IdString memory_name = RTLIL::escape_id(memory_node_it.first.c_str());
+		JsonMemoryEntry &mem_entry = memory_node_it.second;
 
-		if (memories_node->type != 'D')
-			log_error("JSON memories node is not a dictionary.\n");
+		RTLIL::Memory *mem = new RTLIL::Memory;
+		mem->name = memory_name;
 
-		for (auto &memory_node_it : memories_node->data_dict)
-		{
-			IdString memory_name = RTLIL::escape_id(memory_node_it.first.c_str());
-			JsonNode *memory_node = memory_node_it.second;
-
-			RTLIL::Memory *mem = new RTLIL::Memory;
-			mem->name = memory_name;
-
-			if (memory_node->type != 'D')
-				log_error("JSON memory node '%s' is not a dictionary.\n", log_id(memory_name));
-
-			if (memory_node->data_dict.count("width") == 0)
-				log_error("JSON memory node '%s' has no width attribute.\n", log_id(memory_name));
-			JsonNode *width_node = memory_node->data_dict.at("width");
-			if (width_node->type != 'N')
-				log_error("JSON memory node '%s' has a non-number width.\n", log_id(memory_name));
-			mem->width = width_node->data_number;
-
-			if (memory_node->data_dict.count("size") == 0)
-				log_error("JSON memory node '%s' has no size attribute.\n", log_id(memory_name));
-			JsonNode *size_node = memory_node->data_dict.at("size");
-			if (size_node->type != 'N')
-				log_error("JSON memory node '%s' has a non-number size.\n", log_id(memory_name));
-			mem->size = size_node->data_number;
-
-			mem->start_offset = 0;
-			if (memory_node->data_dict.count("start_offset") != 0) {
-				JsonNode *val = memory_node->data_dict.at("start_offset");
-				if (val->type == 'N')
-					mem->start_offset = val->data_number;
-			}
+		if (mem_entry.width_type == 0)
+			log_error("JSON memory node '%s' has no width attribute.\n", log_id(memory_name));
+		if (mem_entry.width_type != 'N')
+			log_error("JSON memory node '%s' has a non-number width.\n", log_id(memory_name));
+		mem->width = mem_entry.width;
 
-			if (memory_node->data_dict.count("attributes"))
-				json_parse_attr_param(mem->attributes, memory_node->data_dict.at("attributes"));
+		if (mem_entry.size_type == 0)
+			log_error("JSON memory node '%s' has no size attribute.\n", log_id(memory_name));
+		if (mem_entry.size_type != 'N')
+			log_error("JSON memory node '%s' has a non-number size.\n", log_id(memory_name));
+		mem->size = mem_entry.size;
 
-			module->memories[mem->name] = mem;
-		}
+		mem->start_offset = 0;
+		if (mem_entry.start_offset.valid)
+			mem->start_offset = mem_entry.start_offset.value;
+
+		for (auto &attr : mem_entry.attributes)
+			mem->attributes[attr.first] = attr.second;
+
+		module->memories[mem->name] = mem;
 	}
 
 	// remove duplicates from connections array
@@ -646,20 +807,28 @@ struct JsonFrontend : public Frontend {
 		}
 		extra_args(f, filename, args, argidx);
 
-		JsonNode root(*f);
+		// modules are imported while the file is read, without building a
+		// tree of the whole file first
+		JsonReader reader(*f);
 
-		if (root.type != 'D')
+		if (reader.next_value() != 'D')
 			log_error("JSON root node is not a dictionary.\n");
 
-		if (root.data_dict.count("modules") != 0)
+		string key, modname;
+		reader.begin('{');
+		while (reader.dict_next(key))
 		{
-			JsonNode *modules = root.data_dict.at("modules");
+			if (key != "modules") {
+				reader.skip_value();
+				continue;
+			}
 
-			if (modules->type != 'D')
+			if (reader.next_value() != 'D')
 				log_error("JSON modules node is not a dictionary.\n");
 
-			for (auto &it : modules->data_dict)
-				json_import(design, it.first, it.second);
+			reader.begin('{');
+			while (reader.dict_next(modname))
+				json_import(design, modname, reader);
 		}
 	}
 } JsonFrontend;
@@ -471,6 +471,20 @@ struct LibertyFrontend : public Frontend {
 		log("    -unit_delay\n");
 		log("        import combinational timing arcs under the unit delay model\n");
 		log("\n");
+		log("    -only_cell <pattern>\n");
+		log("        only import the cells with names matching the given pattern. This\n");
+		log("        option can be used multiple times. The other cells are skipped when\n");
+		log("        reading the file.\n");
+		log("\n");
+		log("    -only_used\n");
+		log("        only import the cells that are instantiated in the current design\n");
+		log("\n");
+		log("When the scratchpad variable 'liberty.cache' is set to a directory name, the\n");
+		log("parsed liberty files are stored in a binary cache in that directory, and\n");
+		log("are loaded from there as long as the liberty file is unchanged. The cache is\n");
+		log("also used by other commands reading liberty files (e.g. dfflibmap, clockgate\n");
+		log("and stat).\n");
+		log("\n");
 	}
 	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -483,6 +497,10 @@ struct LibertyFrontend : public Frontend {
 		bool flag_ignore_miss_data_latch = false;
 		bool flag_ignore_buses = false;
 		bool flag_unit_delay = false;
+		bool flag_only_used = false;
+		// timing and power tables are never imported
+		LibertyFilter filter;
+		filter.skip_groups = LibertyFilter::timing_groups();
 		std::vector<std::string> attributes;
 
 		size_t argidx;
@@ -530,6 +548,15 @@ struct LibertyFrontend : public Frontend {
 				flag_unit_delay = true;
 				continue;
 			}
+			if (arg == "-only_cell" && argidx+1 < args.size()) {
+				filter.all_cells = false;
+				filter.cell_patterns.push_back(args[++argidx]);
+				continue;
+			}
+			if (arg == "-only_used") {
+				flag_only_used = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
@@ -539,7 +566,21 @@ struct LibertyFrontend : public Frontend {
 
 		log_header(design, "Executing Liberty frontend: %s\n", filename.c_str());
 
-		LibertyParser parser(*f);
+		if (flag_only_used) {
+			filter.all_cells = false;
+			for (auto module : design->modules())
+				for (auto cell : module->cells())
+					if (!cell->type.begins_with("$"))
+						filter.cell_names.insert(RTLIL::unescape_id(cell->type));
+		}
+
+		// plain files are memory-mapped and may be loaded from the cache
+		std::unique_ptr<LibertyParser> parser_ptr;
+		if (dynamic_cast<std::ifstream*>(f) != nullptr)
+			parser_ptr.reset(new LibertyParser(filename, design->scratchpad_get_string("liberty.cache"), &filter));
+		else
+			parser_ptr.reset(new LibertyParser(*f, &filter));
+		LibertyParser &parser = *parser_ptr;
 		int cell_count = 0;
 
 		std::map<std::string, std::tuple<int, int, bool>> global_type_map;
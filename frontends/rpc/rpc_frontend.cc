@@ -28,6 +28,7 @@
 #include <sys/wait.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/stat.h>
 extern char **environ;
 #endif
 
@@ -70,15 +71,30 @@ static std::string get_last_error_str() {
 
 using json11::Json;
 
+struct RpcDerived {
+	std::string frontend, source, path;
+	int fd = -1;
+};
+
 struct RpcServer {
 	std::string name;
+	bool binary = false;
+	bool cache = false;
+	dict<std::string, RTLIL::Design*> derive_cache;
 
 	RpcServer(const std::string &name) : name(name) { }
-	virtual ~RpcServer() { }
+	virtual ~RpcServer() {
+		for (auto &it : derive_cache)
+			delete it.second;
+	}
 
 	virtual void write(const std::string &data) = 0;
 	virtual std::string read() = 0;
 
+	// file descriptors passed along with the last response, if the transport supports it
+	virtual bool can_receive_fds() { return false; }
+	virtual int take_fd() { return -1; }
+
 	Json call(const Json &json_request) {
 		std::string request;
 		json_request.dump(request);
@@ -115,7 +131,7 @@ struct RpcServer {
 		return modules;
 	}
 
-	std::pair<std::string, std::string> derive_module(const std::string &module, const dict<RTLIL::IdString, RTLIL::Const> &parameters) {
+	RpcDerived derive_module(const std::string &module, const dict<RTLIL::IdString, RTLIL::Const> &parameters) {
 		Json::object json_parameters;
 		for (auto &param : parameters) {
 			std::string type, value;
@@ -135,22 +151,35 @@ struct RpcServer {
 				{ "value", value },
 			};
 		}
-		Json response = call(Json::object {
+		Json::object json_request = {
 			{ "method", "derive" },
 			{ "module", module },
 			{ "parameters", json_parameters },
-		});
+		};
+		if (binary) {
+			Json::array transfer = { "path" };
+			if (can_receive_fds())
+				transfer.push_back("fd");
+			json_request["transfer"] = transfer;
+		}
+		Json response = call(json_request);
 		bool is_valid = true;
-		std::string frontend, source;
+		RpcDerived derived;
 		if (response["frontend"].is_string())
-			frontend = response["frontend"].string_value();
+			derived.frontend = response["frontend"].string_value();
 		else is_valid = false;
 		if (response["source"].is_string())
-			source = response["source"].string_value();
-		else is_valid = false;
+			derived.source = response["source"].string_value();
+		else if (binary && response["path"].is_string())
+			derived.path = response["path"].string_value();
+		else if (binary && response["fd"].bool_value() && can_receive_fds()) {
+			derived.fd = take_fd();
+			if (derived.fd < 0)
+				log_cmd_error("RPC frontend did not pass a file descriptor with its response.\n");
+		} else is_valid = false;
 		if (!is_valid)
 			log_cmd_error("RPC frontend returned malformed response: %s\n", response.dump().c_str());
-		return std::make_pair(frontend, source);
+		return derived;
 	}
 };
 
@@ -181,13 +210,37 @@ struct RpcModule : RTLIL::Module {
 
 		if (design->has(derived_name)) {
 			log("Found cached RTLIL representation for module `%s'.\n", derived_name.c_str());
+		} else if (server->derive_cache.count(derived_name)) {
+			log("Found cached RPC response for module `%s'.\n", derived_name.c_str());
+			for (auto module : server->derive_cache.at(derived_name)->modules()) {
+				RTLIL::Module *copy = module->clone();
+				copy->design = design;
+				design->modules_[copy->name] = copy;
+			}
 		} else {
-			std::string command, input;
-			std::tie(command, input) = server->derive_module(stripped_name.substr(1), parameters);
+			RpcDerived response = server->derive_module(stripped_name.substr(1), parameters);
 
-			std::istringstream input_stream(input);
 			RTLIL::Design *derived_design = new RTLIL::Design;
-			Frontend::frontend_call(derived_design, &input_stream, "<rpc>" + derived_name.substr(8), command);
+			if (!response.path.empty() || response.fd >= 0) {
+				// the response is in a file or shared memory object; opening it as a plain file lets the
+				// frontend map it instead of reading it through a stream
+				std::string filename = response.path;
+#ifndef _WIN32
+				if (response.fd >= 0)
+					filename = stringf("/dev/fd/%d", response.fd);
+#endif
+				std::ifstream input_file(filename, std::ifstream::binary);
+				if (input_file.fail())
+					log_cmd_error("Can't open RPC response `%s' for reading: %s\n", filename.c_str(), strerror(errno));
+				Frontend::frontend_call(derived_design, &input_file, filename, response.frontend);
+#ifndef _WIN32
+				if (response.fd >= 0)
+					close(response.fd);
+#endif
+			} else {
+				std::istringstream input_stream(response.source);
+				Frontend::frontend_call(derived_design, &input_stream, "<rpc>" + derived_name.substr(8), response.frontend);
+			}
 			derived_design->check();
 
 			dict<std::string, std::string> name_mangling;
@@ -223,6 +276,16 @@ struct RpcModule : RTLIL::Module {
 				derived_design->modules_.erase(module.first);
 			}
 
+			if (server->cache) {
+				RTLIL::Design *cached_design = new RTLIL::Design;
+				for (auto &it : name_mangling) {
+					RTLIL::Module *copy = design->module(it.second)->clone();
+					copy->design = cached_design;
+					cached_design->modules_[copy->name] = copy;
+				}
+				server->derive_cache[derived_name] = cached_design;
+			}
+
 			delete derived_design;
 		}
 
@@ -231,6 +294,7 @@ struct RpcModule : RTLIL::Module {
 
 	RTLIL::Module *clone() const override {
 		RpcModule *new_mod = new RpcModule;
+		new_mod->name = name;
 		new_mod->server = server;
 		cloneInto(new_mod);
 		return new_mod;
@@ -290,9 +354,66 @@ struct HandleRpcServer : RpcServer {
 struct FdRpcServer : RpcServer {
 	int fdsend, fdrecv;
 	pid_t pid;
+	bool is_socket = false;
+	std::vector<int> received_fds;
 
 	FdRpcServer(const std::string &name, int fdsend, int fdrecv, pid_t pid = -1)
-		: RpcServer(name), fdsend(fdsend), fdrecv(fdrecv), pid(pid) { }
+		: RpcServer(name), fdsend(fdsend), fdrecv(fdrecv), pid(pid)
+	{
+		struct stat st;
+		is_socket = fstat(fdrecv, &st) == 0 && S_ISSOCK(st.st_mode);
+	}
+
+	bool can_receive_fds() override {
+		return is_socket;
+	}
+
+	int take_fd() override {
+		if (received_fds.empty())
+			return -1;
+		int fd = received_fds.front();
+		received_fds.erase(received_fds.begin());
+		return fd;
+	}
+
+	void close_received_fds() {
+		for (int fd : received_fds)
+			close(fd);
+		received_fds.clear();
+	}
+
+	ssize_t receive(char *buffer, size_t length) {
+		if (!is_socket)
+			return ::read(fdrecv, buffer, length);
+
+		// sockets may carry file descriptors (SCM_RIGHTS) along with the response
+		struct iovec iov;
+		iov.iov_base = buffer;
+		iov.iov_len = length;
+		union {
+			char buf[CMSG_SPACE(sizeof(int) * 4)];
+			struct cmsghdr align;
+		} control;
+		struct msghdr msg = {};
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+
+		ssize_t result = ::recvmsg(fdrecv, &msg, 0);
+		if (result > 0)
+			for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+				if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+					continue;
+				int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+				for (int i = 0; i < count; i++) {
+					int fd;
+					memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+					received_fds.push_back(fd);
+				}
+			}
+		return result;
+	}
 
 	void check_pid() {
 		if (pid == -1) return;
@@ -317,14 +438,17 @@ struct FdRpcServer : RpcServer {
 	}
 
 	std::string read() override {
+		close_received_fds();
 		std::string data;
 		ssize_t offset = 0;
 		while (data.length() == 0 || data[data.length() - 1] != '\n') {
 			data.resize(data.length() + 1024);
 			check_pid();
-			ssize_t result = ::read(fdrecv, &data[offset], data.length() - offset);
+			ssize_t result = receive(&data[offset], data.length() - offset);
 			if (result == -1)
 				log_cmd_error("read failed: %s\n", strerror(errno));
+			if (result == 0)
+				log_cmd_error("read failed: RPC frontend closed the connection\n");
 			offset += result;
 			data.resize(offset);
 			size_t term_pos = data.find('\n', offset);
@@ -335,6 +459,7 @@ struct FdRpcServer : RpcServer {
 	}
 
 	~FdRpcServer() {
+		close_received_fds();
 		close(fdsend);
 		if (fdrecv != fdsend)
 			close(fdrecv);
@@ -350,8 +475,8 @@ struct RpcFrontend : public Pass {
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
 		log("\n");
-		log("    connect_rpc -exec <command> [args...]\n");
-		log("    connect_rpc -path <path>\n");
+		log("    connect_rpc [options] -exec <command> [args...]\n");
+		log("    connect_rpc [options] -path <path>\n");
 		log("\n");
 		log("Load modules using an out-of-process frontend.\n");
 		log("\n");
@@ -363,6 +488,14 @@ struct RpcFrontend : public Pass {
 		log("        connect to Unix domain socket at <path>. (Unix)\n");
 		log("        connect to bidirectional byte-type named pipe at <path>. (Windows)\n");
 		log("\n");
+		log("    -binary\n");
+		log("        allow the frontend to return derived modules out of band, see below.\n");
+		log("\n");
+		log("    -cache\n");
+		log("        keep a copy of every derived module, so that a module that is derived\n");
+		log("        again with the same parameters (e.g. after 'design -reset') does not\n");
+		log("        call back into the frontend.\n");
+		log("\n");
 		log("A simple JSON-based, newline-delimited protocol is used for communicating with\n");
 		log("the frontend. Yosys requests data from the frontend by sending exactly 1 line\n");
 		log("of JSON. Frontend responds with data or error message by replying with exactly\n");
@@ -389,6 +522,22 @@ struct RpcFrontend : public Pass {
 		log("        frontend to return anyconvenient representation of the module. the\n");
 		log("        derived module is cached,so the response should be the same whenever the\n");
 		log("        same set of parameters is provided.\n");
+		log("\n");
+		log("With -binary, derive requests carry an additional \"transfer\": [\"path\", ...]\n");
+		log("field, and instead of \"source\" the frontend may respond with either of:\n");
+		log("\n");
+		log("    <- {\"frontend\": \"<frontend>\", \"path\": \"<path>\"}\n");
+		log("        the source is in the file <path>, e.g. a file in /dev/shm. the file is\n");
+		log("        mapped into memory and parsed in place; it is not removed afterwards.\n");
+		log("\n");
+		log("    <- {\"frontend\": \"<frontend>\", \"fd\": true}\n");
+		log("        the source is in a file or shared memory object whose descriptor is\n");
+		log("        passed with SCM_RIGHTS along with the response. only offered (\"fd\" in\n");
+		log("        \"transfer\") when connected with -path on Unix.\n");
+		log("\n");
+		log("Both avoid quoting the source into JSON. Together with the binary RTLIL format\n");
+		log("(see 'write_rtlil -binary'), which 'read_rtlil' detects automatically, large\n");
+		log("generated modules are imported without a text round trip.\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -396,9 +545,18 @@ struct RpcFrontend : public Pass {
 
 		std::vector<std::string> command;
 		std::string path;
+		bool binary = false, cache = false;
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
 			std::string arg = args[argidx];
+			if (arg == "-binary") {
+				binary = true;
+				continue;
+			}
+			if (arg == "-cache") {
+				cache = true;
+				continue;
+			}
 			if (arg == "-exec" && argidx+1 < args.size()) {
 				command.insert(command.begin(), args.begin() + argidx + 1, args.end());
 				argidx = args.size()-1;
@@ -584,6 +742,8 @@ cleanup_path:
 
 		if (!server)
 			log_cmd_error("Failed to connect to RPC frontend.\n");
+		server->binary = binary;
+		server->cache = cache;
 
 		for (auto &module_name : server->get_module_names()) {
 			log("Linking module `%s'.\n", module_name.c_str());
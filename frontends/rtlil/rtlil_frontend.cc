@@ -25,6 +25,7 @@
 #include "rtlil_frontend.h"
 #include "kernel/register.h"
 #include "kernel/log.h"
+#include "kernel/rtlil_binary.h"
 
 void rtlil_frontend_yyerror(char const *s)
 {
@@ -60,12 +61,19 @@ struct RTLILFrontend : public Frontend {
 		log("    -lib\n");
 		log("        only create empty blackbox modules\n");
 		log("\n");
+		log("    -legacy\n");
+		log("        use the flex/bison based parser instead of the default hand-written\n");
+		log("        one. both accept the same language.\n");
+		log("\n");
+		log("Files written with 'write_rtlil -binary' are detected automatically.\n");
+		log("\n");
 	}
 	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		RTLIL_FRONTEND::flag_nooverwrite = false;
 		RTLIL_FRONTEND::flag_overwrite = false;
 		RTLIL_FRONTEND::flag_lib = false;
+		bool flag_legacy = false;
 
 		log_header(design, "Executing RTLIL frontend.\n");
 
@@ -86,12 +94,35 @@ struct RTLILFrontend : public Frontend {
 				RTLIL_FRONTEND::flag_lib = true;
 				continue;
 			}
+			if (arg == "-legacy") {
+				flag_legacy = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
 
 		log("Input filename: %s\n", filename.c_str());
 
+		// text RTLIL never starts with a non-ASCII character
+		if (f->peek() == (unsigned char)RTLIL_BINARY::magic[0]) {
+			RTLIL_BINARY::ReadOptions options;
+			options.nooverwrite = RTLIL_FRONTEND::flag_nooverwrite;
+			options.overwrite = RTLIL_FRONTEND::flag_overwrite;
+			options.lib = RTLIL_FRONTEND::flag_lib;
+			read_input_data(f, filename, [&](const char *data, size_t size) {
+				RTLIL_BINARY::parse_design(data, size, design, options);
+			});
+			return;
+		}
+
+		if (!flag_legacy) {
+			read_input_data(f, filename, [&](const char *data, size_t size) {
+				RTLIL_FRONTEND::parse_text(data, size, design);
+			});
+			return;
+		}
+
 		RTLIL_FRONTEND::lexin = f;
 		RTLIL_FRONTEND::current_design = design;
 		rtlil_frontend_yydebug = false;
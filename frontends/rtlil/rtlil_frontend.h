@@ -35,6 +35,9 @@ namespace RTLIL_FRONTEND {
 	extern bool flag_nooverwrite;
 	extern bool flag_overwrite;
 	extern bool flag_lib;
+
+	// parse RTLIL text with the hand-written parser (see rtlil_text.cc)
+	void parse_text(const char *data, size_t size, RTLIL::Design *design);
 }
 
 YOSYS_NAMESPACE_END
@@ -163,7 +163,10 @@ param_defval_stmt:
 
 attr_stmt:
 	TOK_ATTRIBUTE TOK_ID constant EOL {
-		attrbuf[$2] = *$3;
+		if (RTLIL::IdString($2) == ID::src && ($3->flags & RTLIL::CONST_FLAG_STRING))
+			attrbuf[$2] = RTLIL::Const::interned($3->decode_string());
+		else
+			attrbuf[$2] = *$3;
 		delete $3;
 		free($2);
 	};
@@ -0,0 +1,783 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Hand-written parser for the RTLIL text representation. It accepts the
+ *  same language as the flex/bison parser (rtlil_lexer.l, rtlil_parser.y),
+ *  but works on the whole input in memory: identifiers are interned directly
+ *  from the input buffer and no per-token strings are allocated.
+ *
+ */
+
+#include "rtlil_frontend.h"
+#include "kernel/log.h"
+#include <climits>
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+enum TokenKind {
+	TOK_EOF, TOK_EOL, TOK_ID, TOK_VALUE, TOK_INT, TOK_STRING, TOK_INVALID, TOK_CHAR,
+	TOK_AUTOIDX, TOK_MODULE, TOK_ATTRIBUTE, TOK_PARAMETER, TOK_SIGNED, TOK_REAL,
+	TOK_WIRE, TOK_MEMORY, TOK_WIDTH, TOK_UPTO, TOK_OFFSET, TOK_SIZE, TOK_INPUT,
+	TOK_OUTPUT, TOK_INOUT, TOK_CELL, TOK_CONNECT, TOK_SWITCH, TOK_CASE, TOK_ASSIGN,
+	TOK_SYNC, TOK_LOW, TOK_HIGH, TOK_POSEDGE, TOK_NEGEDGE, TOK_EDGE, TOK_ALWAYS,
+	TOK_GLOBAL, TOK_INIT, TOK_UPDATE, TOK_MEMWR, TOK_PROCESS, TOK_END
+};
+
+const std::pair<const char*, TokenKind> keywords[] = {
+	{"autoidx", TOK_AUTOIDX}, {"module", TOK_MODULE}, {"attribute", TOK_ATTRIBUTE},
+	{"parameter", TOK_PARAMETER}, {"signed", TOK_SIGNED}, {"real", TOK_REAL},
+	{"wire", TOK_WIRE}, {"memory", TOK_MEMORY}, {"width", TOK_WIDTH}, {"upto", TOK_UPTO},
+	{"offset", TOK_OFFSET}, {"size", TOK_SIZE}, {"input", TOK_INPUT}, {"output", TOK_OUTPUT},
+	{"inout", TOK_INOUT}, {"cell", TOK_CELL}, {"connect", TOK_CONNECT}, {"switch", TOK_SWITCH},
+	{"case", TOK_CASE}, {"assign", TOK_ASSIGN}, {"sync", TOK_SYNC}, {"low", TOK_LOW},
+	{"high", TOK_HIGH}, {"posedge", TOK_POSEDGE}, {"negedge", TOK_NEGEDGE}, {"edge", TOK_EDGE},
+	{"always", TOK_ALWAYS}, {"global", TOK_GLOBAL}, {"init", TOK_INIT}, {"update", TOK_UPDATE},
+	{"memwr", TOK_MEMWR}, {"process", TOK_PROCESS}, {"end", TOK_END},
+};
+
+struct TextParser
+{
+	const char *ptr, *end;
+	int line = 1;
+
+	// the lookahead token: its kind, its text (a slice of the input, except
+	// for strings, which are unescaped into str) and its value for TOK_INT
+	TokenKind tok;
+	const char *tok_begin;
+	size_t tok_len;
+	int tok_int;
+	char tok_char;
+	std::string str;
+
+	RTLIL::Design *design;
+	RTLIL::Module *module = nullptr;
+	RTLIL::Process *process = nullptr;
+	std::vector<std::vector<RTLIL::SwitchRule*>*> switch_stack;
+	std::vector<RTLIL::CaseRule*> case_stack;
+	dict<RTLIL::IdString, RTLIL::Const> attrbuf;
+
+	TextParser(const char *data, size_t size, RTLIL::Design *design) : ptr(data), end(data + size), design(design)
+	{
+		next();
+	}
+
+	[[noreturn]] void error(const std::string &msg)
+	{
+		log_error("Parser error in line %d: %s\n", line, msg.c_str());
+	}
+
+	[[noreturn]] void syntax_error()
+	{
+		error("syntax error");
+	}
+
+	void warning(const std::string &msg)
+	{
+		log_warning("In line %d: %s\n", line, msg.c_str());
+	}
+
+	static bool is_space(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+	void lex_string()
+	{
+		// the raw text between the quotes, a backslash escapes any character
+		// except for a newline
+		const char *begin = ptr;
+		while (1) {
+			if (ptr == end) {
+				tok = TOK_EOF;
+				return;
+			}
+			char c = *ptr;
+			if (c == '"')
+				break;
+			if (c == '\\' && ptr+1 != end && ptr[1] != '\n')
+				ptr++;
+			if (*ptr == '\n')
+				line++;
+			ptr++;
+		}
+		const char *raw_end = ptr++;
+
+		// the same unescaping as in rtlil_lexer.l
+		str.clear();
+		for (const char *p = begin; p != raw_end; p++) {
+			char c = *p;
+			if (c == '\\' && p+1 != raw_end) {
+				c = *++p;
+				if (c == 'n')
+					c = '\n';
+				else if (c == 't')
+					c = '\t';
+				else if ('0' <= c && c <= '7') {
+					c = c - '0';
+					if (p+1 != raw_end && '0' <= p[1] && p[1] <= '7')
+						c = c * 8 + *++p - '0';
+					if (p+1 != raw_end && '0' <= p[1] && p[1] <= '7')
+						c = c * 8 + *++p - '0';
+				}
+			}
+			str += c;
+		}
+		tok = TOK_STRING;
+	}
+
+	void next()
+	{
+		while (ptr != end && (*ptr == ' ' || *ptr == '\t' || *ptr == '#')) {
+			if (*ptr == '#')
+				while (ptr != end && *ptr != '\n')
+					ptr++;
+			else
+				ptr++;
+		}
+
+		tok_begin = ptr;
+		if (ptr == end) {
+			tok = TOK_EOF;
+			tok_len = 0;
+			return;
+		}
+
+		char c = *ptr;
+		if (c == '\r' || c == '\n') {
+			while (ptr != end && (*ptr == '\r' || *ptr == '\n'))
+				if (*ptr++ == '\n')
+					line++;
+			tok = TOK_EOL;
+		} else if ('a' <= c && c <= 'z') {
+			while (ptr != end && 'a' <= *ptr && *ptr <= 'z')
+				ptr++;
+			tok = TOK_INVALID;
+			for (auto &kw : keywords)
+				if (size_t(ptr - tok_begin) == strlen(kw.first) && !memcmp(tok_begin, kw.first, ptr - tok_begin)) {
+					tok = kw.second;
+					break;
+				}
+		} else if ((c == '\\' || c == '$') && ptr+1 != end && !is_space(ptr[1])) {
+			while (ptr != end && !is_space(*ptr))
+				ptr++;
+			tok = TOK_ID;
+		} else if (('0' <= c && c <= '9') || (c == '-' && ptr+1 != end && '0' <= ptr[1] && ptr[1] <= '9')) {
+			ptr++;
+			while (ptr != end && '0' <= *ptr && *ptr <= '9')
+				ptr++;
+			if (c != '-' && ptr != end && *ptr == '\'') {
+				ptr++;
+				if (ptr != end && *ptr == 's')
+					ptr++;
+				while (ptr != end && strchr("01xzm-", *ptr) && *ptr)
+					ptr++;
+				tok = TOK_VALUE;
+			} else {
+				std::string digits(tok_begin, ptr);
+				char *endp = nullptr;
+				errno = 0;
+				long value = strtol(digits.c_str(), &endp, 10);
+				if (errno == ERANGE || value < INT_MIN || value > INT_MAX) {
+					tok = TOK_INVALID;
+				} else {
+					tok = TOK_INT;
+					tok_int = value;
+				}
+			}
+		} else if (c == '"') {
+			ptr++;
+			lex_string();
+		} else {
+			ptr++;
+			tok = TOK_CHAR;
+			tok_char = c;
+		}
+		tok_len = ptr - tok_begin;
+	}
+
+	bool is_char(char c) const
+	{
+		return tok == TOK_CHAR && tok_char == c;
+	}
+
+	void expect(TokenKind kind)
+	{
+		if (tok != kind)
+			syntax_error();
+		next();
+	}
+
+	void expect_char(char c)
+	{
+		if (!is_char(c))
+			syntax_error();
+		next();
+	}
+
+	void expect_eol()
+	{
+		expect(TOK_EOL);
+		while (tok == TOK_EOL)
+			next();
+	}
+
+	int expect_int()
+	{
+		if (tok != TOK_INT)
+			syntax_error();
+		int value = tok_int;
+		next();
+		return value;
+	}
+
+	// take the identifier token and intern it, the scratch buffer avoids a
+	// heap allocation per identifier
+	std::string id_scratch;
+	RTLIL::IdString expect_id()
+	{
+		if (tok != TOK_ID)
+			syntax_error();
+		id_scratch.assign(tok_begin, tok_len);
+		RTLIL::IdString id(id_scratch);
+		next();
+		return id;
+	}
+
+	void check_dangling()
+	{
+		if (attrbuf.size() != 0)
+			error("dangling attribute");
+	}
+
+	bool is_constant() const
+	{
+		return tok == TOK_VALUE || tok == TOK_INT || tok == TOK_STRING;
+	}
+
+	RTLIL::Const parse_constant()
+	{
+		RTLIL::Const value;
+		if (tok == TOK_VALUE) {
+			const char *p = tok_begin, *q = tok_begin + tok_len;
+			long width = 0;
+			while (p != q && '0' <= *p && *p <= '9')
+				width = std::min(width * 10 + (*p++ - '0'), (long)INT_MAX + 1);
+			bool is_signed = false;
+			if (p != q && *p == '\'')
+				p++;
+			if (p != q && *p == 's') {
+				is_signed = true;
+				p++;
+			}
+			std::vector<RTLIL::State> bits;
+			bits.reserve(std::min<long>(width, q - p));
+			for (const char *b = q; b != p; b--) {
+				RTLIL::State bit = RTLIL::Sx;
+				switch (b[-1]) {
+				case '0': bit = RTLIL::S0; break;
+				case '1': bit = RTLIL::S1; break;
+				case 'x': bit = RTLIL::Sx; break;
+				case 'z': bit = RTLIL::Sz; break;
+				case '-': bit = RTLIL::Sa; break;
+				case 'm': bit = RTLIL::Sm; break;
+				}
+				bits.push_back(bit);
+			}
+			if (bits.size() == 0)
+				bits.push_back(RTLIL::Sx);
+			int int_width = (int)width;
+			if ((int)bits.size() < int_width)
+				bits.resize(int_width, bits.back() == RTLIL::S1 ? RTLIL::S0 : bits.back());
+			if ((int)bits.size() > int_width)
+				bits.resize(std::max(int_width, 0));
+			value = RTLIL::Const(bits);
+			if (is_signed)
+				value.flags |= RTLIL::CONST_FLAG_SIGNED;
+		} else if (tok == TOK_INT) {
+			value = RTLIL::Const(tok_int, 32);
+		} else if (tok == TOK_STRING) {
+			value = RTLIL::Const(str);
+		} else
+			syntax_error();
+		next();
+		return value;
+	}
+
+	bool is_sigspec() const
+	{
+		return is_constant() || tok == TOK_ID || is_char('{');
+	}
+
+	RTLIL::SigSpec parse_sigspec()
+	{
+		RTLIL::SigSpec sig;
+		if (is_constant()) {
+			sig = parse_constant();
+		} else if (tok == TOK_ID) {
+			id_scratch.assign(tok_begin, tok_len);
+			RTLIL::Wire *wire = module->wire(id_scratch);
+			if (wire == nullptr)
+				error(stringf("RTLIL error: wire %s not found", id_scratch.c_str()));
+			sig = wire;
+			next();
+		} else if (is_char('{')) {
+			next();
+			std::vector<RTLIL::SigSpec> parts;
+			int width = 0;
+			while (is_sigspec()) {
+				parts.push_back(parse_sigspec());
+				width += parts.back().size();
+			}
+			expect_char('}');
+			// the first part is the most significant one
+			std::vector<RTLIL::SigChunk> chunks;
+			for (auto it = parts.rbegin(); it != parts.rend(); it++)
+				for (auto &chunk : it->chunks())
+					chunks.push_back(chunk);
+			sig = RTLIL::SigSpec(chunks);
+			log_assert(sig.size() == width);
+		} else
+			syntax_error();
+
+		while (is_char('[')) {
+			next();
+			int hi = expect_int();
+			if (is_char(':')) {
+				next();
+				int lo = expect_int();
+				// checked before the token after ']' is read, so that the
+				// line number matches the one the bison parser reports
+				if (!is_char(']'))
+					syntax_error();
+				if (hi >= sig.size() || hi < 0 || hi < lo)
+					error("invalid slice");
+				next();
+				sig = sig.extract(lo, hi - lo + 1);
+			} else {
+				if (!is_char(']'))
+					syntax_error();
+				if (hi >= sig.size() || hi < 0)
+					error("bit index out of range");
+				next();
+				sig = sig.extract(hi);
+			}
+		}
+		return sig;
+	}
+
+	void parse_attr_stmt()
+	{
+		expect(TOK_ATTRIBUTE);
+		RTLIL::IdString name = expect_id();
+		RTLIL::Const value = parse_constant();
+		expect_eol();
+		if (name == ID::src && (value.flags & RTLIL::CONST_FLAG_STRING))
+			attrbuf[name] = RTLIL::Const::interned(value.decode_string());
+		else
+			attrbuf[name] = std::move(value);
+	}
+
+	void parse_module()
+	{
+		expect(TOK_MODULE);
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		bool delete_current_module = false;
+		if (design->has(name)) {
+			RTLIL::Module *existing_mod = design->module(name);
+			if (!RTLIL_FRONTEND::flag_overwrite && (RTLIL_FRONTEND::flag_lib || (attrbuf.count(ID::blackbox) && attrbuf.at(ID::blackbox).as_bool()))) {
+				log("Ignoring blackbox re-definition of module %s.\n", name.c_str());
+				delete_current_module = true;
+			} else if (!RTLIL_FRONTEND::flag_nooverwrite && !RTLIL_FRONTEND::flag_overwrite && !existing_mod->get_bool_attribute(ID::blackbox)) {
+				error(stringf("RTLIL error: redefinition of module %s.", name.c_str()));
+			} else if (RTLIL_FRONTEND::flag_nooverwrite) {
+				log("Ignoring re-definition of module %s.\n", name.c_str());
+				delete_current_module = true;
+			} else {
+				log("Replacing existing%s module %s.\n", existing_mod->get_bool_attribute(ID::blackbox) ? " blackbox" : "", name.c_str());
+				design->remove(existing_mod);
+			}
+		}
+		module = new RTLIL::Module;
+		module->name = name;
+		module->attributes = std::move(attrbuf);
+		attrbuf.clear();
+		if (!delete_current_module)
+			design->add(module);
+
+		while (tok != TOK_END)
+		{
+			switch (tok) {
+			case TOK_PARAMETER: {
+				next();
+				RTLIL::IdString param = expect_id();
+				module->avail_parameters(param);
+				if (tok != TOK_EOL)
+					module->parameter_default_values[param] = parse_constant();
+				expect_eol();
+				break;
+			}
+			case TOK_ATTRIBUTE:
+				parse_attr_stmt();
+				break;
+			case TOK_WIRE:
+				parse_wire();
+				break;
+			case TOK_MEMORY:
+				parse_memory();
+				break;
+			case TOK_CELL:
+				parse_cell();
+				break;
+			case TOK_PROCESS:
+				parse_process();
+				break;
+			case TOK_CONNECT: {
+				next();
+				RTLIL::SigSpec lhs = parse_sigspec();
+				RTLIL::SigSpec rhs = parse_sigspec();
+				expect_eol();
+				check_dangling();
+				module->connect(lhs, rhs);
+				break;
+			}
+			default:
+				syntax_error();
+			}
+		}
+		check_dangling();
+		next();
+
+		module->fixup_ports();
+		if (delete_current_module)
+			delete module;
+		else if (RTLIL_FRONTEND::flag_lib)
+			module->makeblackbox();
+		module = nullptr;
+		expect_eol();
+	}
+
+	void parse_wire()
+	{
+		expect(TOK_WIRE);
+		int width = 1, start_offset = 0, port_id = 0;
+		bool upto = false, is_signed = false, port_input = false, port_output = false;
+		while (tok != TOK_ID)
+		{
+			switch (tok) {
+			case TOK_WIDTH:
+				next();
+				if (tok == TOK_INVALID)
+					error("RTLIL error: invalid wire width");
+				width = expect_int();
+				break;
+			case TOK_UPTO:
+				next();
+				upto = true;
+				break;
+			case TOK_SIGNED:
+				next();
+				is_signed = true;
+				break;
+			case TOK_OFFSET:
+				next();
+				start_offset = expect_int();
+				break;
+			case TOK_INPUT:
+			case TOK_OUTPUT:
+			case TOK_INOUT:
+				port_input = tok != TOK_OUTPUT;
+				port_output = tok != TOK_INPUT;
+				next();
+				port_id = expect_int();
+				break;
+			default:
+				syntax_error();
+			}
+		}
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		if (module->wire(name) != nullptr)
+			error(stringf("RTLIL error: redefinition of wire %s.", name.c_str()));
+		RTLIL::Wire *wire = module->addWire(name, width);
+		wire->attributes = std::move(attrbuf);
+		attrbuf.clear();
+		wire->start_offset = start_offset;
+		wire->upto = upto;
+		wire->is_signed = is_signed;
+		wire->port_id = port_id;
+		wire->port_input = port_input;
+		wire->port_output = port_output;
+	}
+
+	void parse_memory()
+	{
+		expect(TOK_MEMORY);
+		RTLIL::Memory *memory = new RTLIL::Memory;
+		memory->attributes = std::move(attrbuf);
+		attrbuf.clear();
+		while (tok != TOK_ID)
+		{
+			TokenKind option = tok;
+			if (option != TOK_WIDTH && option != TOK_SIZE && option != TOK_OFFSET)
+				syntax_error();
+			next();
+			int value = expect_int();
+			if (option == TOK_WIDTH)
+				memory->width = value;
+			else if (option == TOK_SIZE)
+				memory->size = value;
+			else
+				memory->start_offset = value;
+		}
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		if (module->memories.count(name) != 0)
+			error(stringf("RTLIL error: redefinition of memory %s.", name.c_str()));
+		memory->name = name;
+		module->memories[name] = memory;
+	}
+
+	void parse_cell()
+	{
+		expect(TOK_CELL);
+		RTLIL::IdString type = expect_id();
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		if (module->cell(name) != nullptr)
+			error(stringf("RTLIL error: redefinition of cell %s.", name.c_str()));
+		RTLIL::Cell *cell = module->addCell(name, type);
+		cell->attributes = std::move(attrbuf);
+		attrbuf.clear();
+
+		while (tok != TOK_END)
+		{
+			if (tok == TOK_PARAMETER) {
+				next();
+				int flags = 0;
+				if (tok == TOK_SIGNED) {
+					flags = RTLIL::CONST_FLAG_SIGNED;
+					next();
+				} else if (tok == TOK_REAL) {
+					flags = RTLIL::CONST_FLAG_REAL;
+					next();
+				}
+				RTLIL::IdString param = expect_id();
+				RTLIL::Const &value = cell->parameters[param];
+				value = parse_constant();
+				value.flags |= flags;
+				expect_eol();
+			} else if (tok == TOK_CONNECT) {
+				next();
+				RTLIL::IdString port = expect_id();
+				RTLIL::SigSpec sig = parse_sigspec();
+				expect_eol();
+				if (cell->hasPort(port))
+					error(stringf("RTLIL error: redefinition of cell port %s.", port.c_str()));
+				cell->setPort(port, std::move(sig));
+			} else
+				syntax_error();
+		}
+		next();
+		expect_eol();
+	}
+
+	void parse_case_body()
+	{
+		while (1)
+		{
+			if (tok == TOK_ATTRIBUTE) {
+				parse_attr_stmt();
+			} else if (tok == TOK_SWITCH) {
+				parse_switch();
+			} else if (tok == TOK_ASSIGN) {
+				next();
+				RTLIL::SigSpec lhs = parse_sigspec();
+				RTLIL::SigSpec rhs = parse_sigspec();
+				expect_eol();
+				check_dangling();
+
+				// See https://github.com/YosysHQ/yosys/pull/4765 for discussion on this
+				// warning
+				if (!switch_stack.back()->empty()) {
+					warning("case rule assign statements after switch statements may cause unexpected behaviour. "
+						"The assign statement is reordered to come before all switch statements.");
+				}
+
+				case_stack.back()->actions.push_back(RTLIL::SigSig(lhs, rhs));
+			} else
+				return;
+		}
+	}
+
+	void parse_switch()
+	{
+		expect(TOK_SWITCH);
+		RTLIL::SwitchRule *rule = new RTLIL::SwitchRule;
+		rule->signal = parse_sigspec();
+		expect_eol();
+		rule->attributes = std::move(attrbuf);
+		attrbuf.clear();
+		switch_stack.back()->push_back(rule);
+
+		while (tok == TOK_ATTRIBUTE)
+			parse_attr_stmt();
+
+		while (tok == TOK_CASE)
+		{
+			next();
+			RTLIL::CaseRule *case_rule = new RTLIL::CaseRule;
+			case_rule->attributes = std::move(attrbuf);
+			attrbuf.clear();
+			rule->cases.push_back(case_rule);
+			switch_stack.push_back(&case_rule->switches);
+			case_stack.push_back(case_rule);
+
+			// the grammar also accepts a leading comma
+			if (is_sigspec())
+				case_rule->compare.push_back(parse_sigspec());
+			while (is_char(',')) {
+				next();
+				case_rule->compare.push_back(parse_sigspec());
+			}
+			expect_eol();
+			parse_case_body();
+
+			switch_stack.pop_back();
+			case_stack.pop_back();
+		}
+
+		expect(TOK_END);
+		expect_eol();
+	}
+
+	void parse_process()
+	{
+		expect(TOK_PROCESS);
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		if (module->processes.count(name) != 0)
+			error(stringf("RTLIL error: redefinition of process %s.", name.c_str()));
+		process = module->addProcess(name);
+		process->attributes = std::move(attrbuf);
+		attrbuf.clear();
+		switch_stack.clear();
+		switch_stack.push_back(&process->root_case.switches);
+		case_stack.clear();
+		case_stack.push_back(&process->root_case);
+
+		parse_case_body();
+
+		while (tok == TOK_SYNC)
+		{
+			next();
+			RTLIL::SyncRule *rule = new RTLIL::SyncRule;
+			switch (tok) {
+			case TOK_LOW: rule->type = RTLIL::ST0; break;
+			case TOK_HIGH: rule->type = RTLIL::ST1; break;
+			case TOK_POSEDGE: rule->type = RTLIL::STp; break;
+			case TOK_NEGEDGE: rule->type = RTLIL::STn; break;
+			case TOK_EDGE: rule->type = RTLIL::STe; break;
+			case TOK_ALWAYS: rule->type = RTLIL::STa; break;
+			case TOK_GLOBAL: rule->type = RTLIL::STg; break;
+			case TOK_INIT: rule->type = RTLIL::STi; break;
+			default:
+				delete rule;
+				syntax_error();
+			}
+			bool has_signal = tok == TOK_LOW || tok == TOK_HIGH || tok == TOK_POSEDGE || tok == TOK_NEGEDGE || tok == TOK_EDGE;
+			next();
+			if (has_signal)
+				rule->signal = parse_sigspec();
+			expect_eol();
+			process->syncs.push_back(rule);
+
+			while (1)
+			{
+				if (tok == TOK_UPDATE) {
+					next();
+					RTLIL::SigSpec lhs = parse_sigspec();
+					RTLIL::SigSpec rhs = parse_sigspec();
+					expect_eol();
+					rule->actions.push_back(RTLIL::SigSig(lhs, rhs));
+				} else if (tok == TOK_ATTRIBUTE || tok == TOK_MEMWR) {
+					while (tok == TOK_ATTRIBUTE)
+						parse_attr_stmt();
+					expect(TOK_MEMWR);
+					RTLIL::MemWriteAction act;
+					act.memid = expect_id();
+					act.address = parse_sigspec();
+					act.data = parse_sigspec();
+					act.enable = parse_sigspec();
+					act.priority_mask = parse_constant();
+					expect_eol();
+					act.attributes = std::move(attrbuf);
+					attrbuf.clear();
+					rule->mem_write_actions.push_back(std::move(act));
+				} else
+					break;
+			}
+		}
+
+		expect(TOK_END);
+		expect_eol();
+		process = nullptr;
+	}
+
+	void parse()
+	{
+		while (tok == TOK_EOL)
+			next();
+		attrbuf.clear();
+
+		while (tok != TOK_EOF)
+		{
+			if (tok == TOK_MODULE) {
+				parse_module();
+			} else if (tok == TOK_ATTRIBUTE) {
+				parse_attr_stmt();
+			} else if (tok == TOK_AUTOIDX) {
+				next();
+				int value = expect_int();
+				expect_eol();
+				autoidx = max(autoidx, value);
+			} else
+				syntax_error();
+		}
+
+		check_dangling();
+	}
+};
+
+} // namespace
+
+void RTLIL_FRONTEND::parse_text(const char *data, size_t size, RTLIL::Design *design)
+{
+	TextParser parser(data, size, design);
+	parser.parse();
+}
+
+YOSYS_NAMESPACE_END
@@ -21,6 +21,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
+#include "kernel/rtlil_binary.h"
 #include "libs/sha1/sha1.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -417,10 +418,10 @@ void VerificImporter::import_attributes(dict<RTLIL::IdString, RTLIL::Const> &att
 
 #ifdef VERIFIC_LINEFILE_INCLUDES_COLUMNS 
 	if (obj->Linefile())
-		attributes[ID::src] = stringf("%s:%d.%d-%d.%d", LineFile::GetFileName(obj->Linefile()), obj->Linefile()->GetLeftLine(), obj->Linefile()->GetLeftCol(), obj->Linefile()->GetRightLine(), obj->Linefile()->GetRightCol());
+		attributes[ID::src] = RTLIL::Const::interned(stringf("%s:%d.%d-%d.%d", LineFile::GetFileName(obj->Linefile()), obj->Linefile()->GetLeftLine(), obj->Linefile()->GetLeftCol(), obj->Linefile()->GetRightLine(), obj->Linefile()->GetRightCol()));
 #else
 	if (obj->Linefile())
-		attributes[ID::src] = stringf("%s:%d", LineFile::GetFileName(obj->Linefile()), LineFile::GetLineNo(obj->Linefile()));
+		attributes[ID::src] = RTLIL::Const::interned(stringf("%s:%d", LineFile::GetFileName(obj->Linefile()), LineFile::GetLineNo(obj->Linefile())));
 #endif
 
 	FOREACH_ATTRIBUTE(obj, mi, attr) {
@@ -2986,11 +2987,131 @@ void verific_cleanup()
 	verific_import_pending = false;
 }
 
+// Import the netlists in nl_todo and everything they instantiate. With more
+// than one job, the netlists known at the start of each round are imported
+// in forked processes (Verific is not thread safe) and the new modules are
+// merged back as binary RTLIL, in the next round follow the netlists that the
+// jobs found through instances. All netlists exist before the import starts,
+// so the pointers found by a job are valid in the parent process as well.
+static void import_netlists(RTLIL::Design *design, std::map<std::string,Netlist*> &nl_todo, int jobs,
+		const std::function<void(RTLIL::Design*, Netlist*, std::map<std::string,Netlist*>&)> &import_one)
+{
+	std::map<std::string,Netlist*> nl_done;
+
+	while (!nl_todo.empty())
+	{
+		std::vector<Netlist*> batch;
+		if (jobs > 1)
+			for (auto &it : nl_todo)
+				if (nl_done.count(it.first) == 0)
+					batch.push_back(it.second);
+
+		if (GetSize(batch) <= 1) {
+			auto it = nl_todo.begin();
+			Netlist *nl = it->second;
+			if (nl_done.count(it->first) == 0) {
+				nl_done[it->first] = it->second;
+				import_one(design, nl, nl_todo);
+			}
+			nl_todo.erase(it);
+			continue;
+		}
+
+		for (auto &it : nl_todo)
+			nl_done[it.first] = it.second;
+		nl_todo.clear();
+
+		// largest netlists first, each to the group with the fewest instances so far
+		std::stable_sort(batch.begin(), batch.end(), [](Netlist *a, Netlist *b) {
+			return a->NumOfInsts() > b->NumOfInsts();
+		});
+		int batch_jobs = std::min(jobs, GetSize(batch));
+		std::vector<std::vector<Netlist*>> groups(batch_jobs);
+		std::vector<unsigned> group_insts(batch_jobs);
+		for (auto nl : batch) {
+			int group = std::min_element(group_insts.begin(), group_insts.end()) - group_insts.begin();
+			groups[group].push_back(nl);
+			group_insts[group] += nl->NumOfInsts() + 1;
+		}
+
+		pool<RTLIL::IdString> old_modules;
+		for (auto module : design->modules())
+			old_modules.insert(module->name);
+
+		log("Importing %d netlists in %d jobs.\n", GetSize(batch), batch_jobs);
+
+		auto job_main = [&](int i, const std::string &prefix) {
+			std::map<std::string,Netlist*> found;
+			for (auto nl : groups[i])
+				import_one(design, nl, found);
+
+			RTLIL::Selection selection(false);
+			for (auto module : design->modules())
+				if (!old_modules.count(module->name))
+					selection.selected_modules.insert(module->name);
+			design->selection_stack.back() = selection;
+			{
+				std::ofstream out(prefix + ".rtlil", std::ios::binary);
+				RTLIL_BINARY::dump_design(out, design, true);
+			}
+
+			// one "<pointer> <key>" line per instantiated netlist, keys may contain spaces
+			std::ofstream found_out(prefix + ".todo");
+			for (auto &it : found)
+				found_out << stringf("%p", (void*)it.second) << " " << it.first << "\n";
+			std::ofstream error_out(prefix + ".err", std::ios::binary);
+			error_out << verific_error_msg;
+			std::ofstream autoidx_out(prefix + ".autoidx");
+			autoidx_out << autoidx << "\n";
+		};
+
+		auto merge = [&](int i, const std::string &prefix, bool success) {
+			std::ifstream rtlil_in(prefix + ".rtlil", std::ios::binary);
+			std::ifstream found_in(prefix + ".todo");
+			std::ifstream error_in(prefix + ".err", std::ios::binary);
+			std::ifstream autoidx_in(prefix + ".autoidx");
+			int job_autoidx = 0;
+			if (!success || !rtlil_in || !found_in || !error_in || !(autoidx_in >> job_autoidx))
+				return stringf("Verific import job %d (netlist %s and %d more netlists) failed.", i,
+						groups[i].front()->Owner()->Name(), GetSize(groups[i]) - 1);
+
+			// operator modules and blackboxes may be imported by several jobs
+			std::string data((std::istreambuf_iterator<char>(rtlil_in)), std::istreambuf_iterator<char>());
+			RTLIL_BINARY::ReadOptions options;
+			options.nooverwrite = true;
+			RTLIL_BINARY::parse_design(data.data(), data.size(), design, options);
+			autoidx = std::max(autoidx, job_autoidx);
+
+			std::string line;
+			while (std::getline(found_in, line)) {
+				size_t pos = line.find(' ');
+				void *ptr = nullptr;
+				if (pos == std::string::npos || sscanf(line.substr(0, pos).c_str(), "%p", &ptr) != 1)
+					return stringf("Verific import job %d left a malformed netlist list.", i);
+				std::string key = line.substr(pos + 1);
+				if (nl_done.count(key) == 0)
+					nl_todo.emplace(key, static_cast<Netlist*>(ptr));
+			}
+
+			if (verific_error_msg.empty())
+				verific_error_msg = std::string((std::istreambuf_iterator<char>(error_in)), std::istreambuf_iterator<char>());
+			return std::string();
+		};
+
+		if (!Pass::fork_jobs(batch_jobs, job_main, merge)) {
+			// no fork() on this platform, import the batch here
+			for (auto nl : batch)
+				import_one(design, nl, nl_todo);
+			jobs = 1;
+		}
+	}
+}
+
 std::string verific_import(Design *design, const std::map<std::string,std::string> &parameters, std::string top)
 {
 	verific_sva_fsm_limit = 16;
 
-	std::map<std::string,Netlist*> nl_todo, nl_done;
+	std::map<std::string,Netlist*> nl_todo;
 
 	Map verific_params(STRING_HASH);
 	for (const auto &i : parameters)
@@ -3019,16 +3140,10 @@ std::string verific_import(Design *design, const std::map<std::string,std::strin
 	for (auto nl : nl_todo)
 		worker.run(nl.second);
 
-	while (!nl_todo.empty()) {
-		auto it = nl_todo.begin();
-		Netlist *nl = it->second;
-		if (nl_done.count(it->first) == 0) {
-			VerificImporter importer(false, false, false, false, false, false, false);
-			nl_done[it->first] = it->second;
-			importer.import_netlist(design, nl, nl_todo, top_mod_names.count(nl->CellBaseName()));
-		}
-		nl_todo.erase(it);
-	}
+	import_netlists(design, nl_todo, 1, [&](RTLIL::Design *target, Netlist *nl, std::map<std::string,Netlist*> &todo) {
+		VerificImporter importer(false, false, false, false, false, false, false);
+		importer.import_netlist(target, nl, todo, top_mod_names.count(nl->CellBaseName()));
+	});
 
 	verific_cleanup();
 	if (!verific_error_msg.empty())
@@ -3244,6 +3359,12 @@ struct VerificPass : public Pass {
 		log("  -pp <filename>\n");
 		log("    Pretty print design after elaboration to specified file.\n");
 		log("\n");
+		log("  -jobs <N>\n");
+		log("    Import independent netlists into RTLIL in up to N forked processes.\n");
+		log("    The netlists are partitioned by their number of instances, and the\n");
+		log("    resulting design is the same as with a single job, apart from the order\n");
+		log("    of the modules. Not available on Windows.\n");
+		log("\n");
 		log("The following additional import options are useful for debugging the Verific\n");
 		log("bindings (for Yosys and/or Verific developers):\n");
 		log("\n");
@@ -3990,7 +4111,7 @@ struct VerificPass : public Pass {
 
 		if (GetSize(args) > argidx && args[argidx] == "-import")
 		{
-			std::map<std::string,Netlist*> nl_todo, nl_done;
+			std::map<std::string,Netlist*> nl_todo;
 			bool mode_all = false, mode_gates = false, mode_keep = false;
 			bool mode_nosva = false, mode_names = false, mode_verific = false;
 			bool mode_autocover = false, mode_fullinit = false;
@@ -3998,6 +4119,7 @@ struct VerificPass : public Pass {
 			bool split_complex_ports = true;
 			string dumpfile;
 			string ppfile;
+			int jobs = 1;
 			Map parameters(STRING_HASH);
 
 			for (argidx++; argidx < GetSize(args); argidx++) {
@@ -4080,6 +4202,10 @@ struct VerificPass : public Pass {
 					ppfile = args[++argidx];
 					continue;
 				}
+				if (args[argidx] == "-jobs" && argidx+1 < GetSize(args)) {
+					jobs = atoi(args[++argidx].c_str());
+					continue;
+				}
 				break;
 			}
 
@@ -4150,17 +4276,11 @@ struct VerificPass : public Pass {
 				veri_writer.WriteFile(dumpfile.c_str(), Netlist::PresentDesign());
 			}
 #endif
-			while (!nl_todo.empty()) {
-				auto it = nl_todo.begin();
-				Netlist *nl = it->second;
-				if (nl_done.count(it->first) == 0) {
-					VerificImporter importer(mode_gates, mode_keep, mode_nosva,
-							mode_names, mode_verific, mode_autocover, mode_fullinit);
-					nl_done[it->first] = it->second;
-					importer.import_netlist(design, nl, nl_todo, top_mod_names.count(nl->CellBaseName()));
-				}
-				nl_todo.erase(it);
-			}
+			import_netlists(design, nl_todo, jobs, [&](RTLIL::Design *target, Netlist *nl, std::map<std::string,Netlist*> &todo) {
+				VerificImporter importer(mode_gates, mode_keep, mode_nosva,
+						mode_names, mode_verific, mode_autocover, mode_fullinit);
+				importer.import_netlist(target, nl, todo, top_mod_names.count(nl->CellBaseName()));
+			});
 
 			verific_cleanup();
 			goto check_error;
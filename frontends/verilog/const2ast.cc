@@ -59,6 +59,44 @@ static int my_decimal_div_by_two(std::vector<uint8_t> &digits)
 	return carry;
 }
 
+// convert a decimal number to binary, nine digits at a time using 32-bit limbs; returns
+// false if there are digits that are not decimal, which my_decimal_div_by_two() reports
+static bool my_decimal_to_bin(std::vector<RTLIL::State> &data, const std::vector<uint8_t> &digits)
+{
+	std::vector<uint32_t> limbs;
+	for (size_t i = 0; i < digits.size();) {
+		uint32_t chunk = 0, factor = 1;
+		for (int n = 0; n < 9 && i < digits.size(); n++, i++) {
+			if (digits[i] >= 10)
+				return false;
+			chunk = chunk * 10 + digits[i];
+			factor *= 10;
+		}
+		uint64_t carry = chunk;
+		for (auto &limb : limbs) {
+			uint64_t v = uint64_t(limb) * factor + carry;
+			limb = uint32_t(v);
+			carry = v >> 32;
+		}
+		if (carry)
+			limbs.push_back(uint32_t(carry));
+	}
+
+	if (limbs.empty()) {
+		// a number with only zero digits still has one bit
+		if (!digits.empty())
+			data.push_back(State::S0);
+		return true;
+	}
+	for (size_t i = 0; i < limbs.size(); i++)
+		for (int j = 0; j < 32; j++) {
+			if (i + 1 == limbs.size() && (limbs[i] >> j) == 0)
+				break;
+			data.push_back((limbs[i] >> j) & 1 ? State::S1 : State::S0);
+		}
+	return true;
+}
+
 // find the number of significant bits in a binary number (not including the sign bit)
 static int my_ilog2(int x)
 {
@@ -96,6 +134,10 @@ static void my_strtobin(std::vector<RTLIL::State> &data, const char *str, int le
 	data.clear();
 
 	if (base == 10) {
+		if (!my_decimal_to_bin(data, digits))
+			data.clear();
+		else
+			digits.clear();
 		while (!digits.empty())
 			data.push_back(my_decimal_div_by_two(digits) ? State::S1 : State::S0);
 	} else {
@@ -41,12 +41,17 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef YOSYS_ENABLE_THREADS
+#include <mutex>
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 using namespace VERILOG_FRONTEND;
 
-static std::list<std::string> output_code;
-static std::list<std::string> input_buffer;
-static size_t input_buffer_charp;
+static thread_local std::list<std::string> output_code;
+static thread_local std::list<std::string> input_buffer;
+static thread_local size_t input_buffer_charp;
+static thread_local preproc_trace_t *preproc_trace;
 
 static void return_char(char ch)
 {
@@ -97,6 +102,38 @@ static std::string skip_spaces()
 	return spaces;
 }
 
+static bool is_space_char(char ch)
+{
+	return ch == ' ' || ch == '\t';
+}
+
+static bool is_ident_char(char ch)
+{
+	return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_' || ch == '$';
+}
+
+// append the run of characters accepted by pred to token, taking whole ranges
+// of the input buffers instead of going through next_char() for each of them
+static void append_run(std::string &token, bool (*pred)(char))
+{
+	while (!input_buffer.empty()) {
+		const std::string &buf = input_buffer.front();
+		size_t end = input_buffer_charp;
+		while (end < buf.size() && pred(buf[end]))
+			end++;
+		token.append(buf, input_buffer_charp, end - input_buffer_charp);
+		if (end < buf.size()) {
+			input_buffer_charp = end;
+			if (buf[end] != '\r')
+				return;
+			input_buffer_charp++;
+		} else {
+			input_buffer_charp = 0;
+			input_buffer.pop_front();
+		}
+	}
+}
+
 static std::string next_token(bool pass_newline = false)
 {
 	std::string token;
@@ -114,15 +151,9 @@ static std::string next_token(bool pass_newline = false)
 		return token;
 	}
 
-	if (ch == ' ' || ch == '\t')
+	if (is_space_char(ch))
 	{
-		while ((ch = next_char()) != 0) {
-			if (ch != ' ' && ch != '\t') {
-				return_char(ch);
-				break;
-			}
-			token += ch;
-		}
+		append_run(token, is_space_char);
 	}
 	else if (ch == '"')
 	{
@@ -193,20 +224,16 @@ static std::string next_token(bool pass_newline = false)
 	}
 	else
 	{
-		const char *ok = "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ$0123456789";
-		if (ch == '`' || strchr(ok, ch) != NULL)
+		if (ch == '`' || is_ident_char(ch))
 		{
 			char first = ch;
 			ch = next_char();
 			if (first == '`' && (ch == '"' || ch == '`')) {
 				token += ch;
-			} else do {
-					if (strchr(ok, ch) == NULL) {
-						return_char(ch);
-						break;
-					}
-					token += ch;
-				} while ((ch = next_char()) != 0);
+			} else if (ch != 0) {
+				return_char(ch);
+				append_run(token, is_ident_char);
+			}
 		}
 	}
 	return token;
@@ -385,22 +412,152 @@ void define_map_t::log() const
 	}
 }
 
-static void input_file(std::istream &f, std::string filename)
+static std::string read_text(std::istream &f)
 {
-	char buffer[513];
+	std::string text;
+	char buffer[4096];
 	int rc;
 
+	while ((rc = readsome(f, buffer, sizeof(buffer))) > 0)
+		text.append(buffer, rc);
+	return text;
+}
+
+static void input_file(const std::string &text, const std::string &filename)
+{
 	insert_input("");
 	auto it = input_buffer.begin();
 
+	// the text is split into chunks, as insert_input() copies the rest of
+	// the current chunk
 	input_buffer.insert(it, "`file_push \"" + filename + "\"\n");
-	while ((rc = readsome(f, buffer, sizeof(buffer)-1)) > 0) {
-		buffer[rc] = 0;
-		input_buffer.insert(it, buffer);
-	}
+	for (size_t pos = 0; pos < text.size(); pos += 4096)
+		input_buffer.insert(it, text.substr(pos, 4096));
 	input_buffer.insert(it, "\n`file_pop\n");
 }
 
+// Skip whitespace, comments and string literals starting at pos, returning the
+// position of the next directive (or npos). Sets only_space if nothing but
+// whitespace and comments was skipped.
+static size_t find_directive(const std::string &text, size_t pos, bool &only_space)
+{
+	only_space = true;
+	while (pos < text.size()) {
+		char ch = text[pos];
+		if (ch == '`')
+			return pos;
+		if (ch == '/' && pos+1 < text.size() && text[pos+1] == '/') {
+			pos = text.find('\n', pos);
+			continue;
+		}
+		if (ch == '/' && pos+1 < text.size() && text[pos+1] == '*') {
+			pos = text.find("*/", pos+2);
+			if (pos != std::string::npos)
+				pos += 2;
+			continue;
+		}
+		if (ch == '"') {
+			for (pos++; pos < text.size() && text[pos] != '"'; pos++)
+				if (text[pos] == '\\')
+					pos++;
+		}
+		if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n')
+			only_space = false;
+		pos++;
+	}
+	return std::string::npos;
+}
+
+// Returns the name of the include guard macro if the whole file is wrapped
+// in a single `ifndef NAME ... `endif block, or an empty string otherwise.
+static std::string find_include_guard(const std::string &text)
+{
+	auto directive_at = [&](size_t pos, std::string &name) {
+		size_t end = pos + 1;
+		while (end < text.size() && is_ident_char(text[end]))
+			end++;
+		name = text.substr(pos, end - pos);
+		return end;
+	};
+
+	bool only_space;
+	size_t pos = find_directive(text, 0, only_space);
+	if (pos == std::string::npos || !only_space)
+		return std::string();
+
+	std::string directive, guard;
+	pos = directive_at(pos, directive);
+	if (directive != "`ifndef")
+		return std::string();
+	while (pos < text.size() && is_space_char(text[pos]))
+		pos++;
+	size_t guard_end = pos;
+	while (guard_end < text.size() && is_ident_char(text[guard_end]))
+		guard_end++;
+	guard = text.substr(pos, guard_end - pos);
+	if (guard.empty())
+		return std::string();
+
+	int depth = 1;
+	pos = guard_end;
+	while (depth > 0) {
+		pos = find_directive(text, pos, only_space);
+		if (pos == std::string::npos)
+			return std::string();
+		pos = directive_at(pos, directive);
+		if (directive == "`ifdef" || directive == "`ifndef")
+			depth++;
+		else if (directive == "`endif")
+			depth--;
+		else if (depth == 1 && (directive == "`else" || directive == "`elsif"))
+			return std::string();
+	}
+
+	find_directive(text, pos, only_space);
+	return only_space ? guard : std::string();
+}
+
+// Include files are cached for the whole session, together with the name of
+// their include guard macro. Entries are validated against the contents of
+// the file (see file_content_key()).
+struct include_file_t
+{
+	std::string text;
+	std::string guard;
+	std::string key;
+};
+
+#ifdef YOSYS_ENABLE_THREADS
+static std::mutex include_cache_mutex;
+#endif
+static dict<std::string, std::shared_ptr<const include_file_t>> include_cache;
+
+static std::shared_ptr<const include_file_t> load_include_file(std::istream &f, const std::string &filename)
+{
+	std::string key = file_content_key(filename);
+
+	if (!key.empty()) {
+#ifdef YOSYS_ENABLE_THREADS
+		std::lock_guard<std::mutex> lock(include_cache_mutex);
+#endif
+		auto it = include_cache.find(filename);
+		if (it != include_cache.end() && it->second->key == key)
+			return it->second;
+	}
+
+	auto file = std::make_shared<include_file_t>();
+	file->text = read_text(f);
+	file->guard = find_include_guard(file->text);
+	if (!key.empty()) {
+		file->key = key;
+#ifdef YOSYS_ENABLE_THREADS
+		std::lock_guard<std::mutex> lock(include_cache_mutex);
+#endif
+		include_cache[filename] = file;
+	}
+	return file;
+}
+
 // Read tokens to get one argument (either a macro argument at a callsite or a default argument in a
 // macro definition). Writes the argument to dest. Returns true if we finished with ')' (the end of
 // the argument list); false if we finished with ','.
@@ -458,6 +615,14 @@ static bool read_argument(std::string &dest)
 
 using macro_arg_stack_t = std::stack<std::pair<std::string, define_body_t>>;
 
+static const define_body_t *find_define(const define_map_t &defines, const std::string &name)
+{
+	// only lookups of macros not (re)defined by us depend on the defines we started with
+	if (preproc_trace && !preproc_trace->undefine_all && !preproc_trace->changes.count(name))
+		preproc_trace->lookups.insert(name);
+	return defines.find(name);
+}
+
 static void restore_macro_arg(define_map_t &defines, macro_arg_stack_t &macro_arg_stack)
 {
 	log_assert(!macro_arg_stack.empty());
@@ -493,7 +658,7 @@ static bool try_expand_macro(define_map_t &defines, macro_arg_stack_t &macro_arg
 
 	// This token looks like a macro name (`foo).
 	std::string macro_name = tok.substr(1);
-	const define_body_t *body = defines.find(tok.substr(1));
+	const define_body_t *body = find_define(defines, tok.substr(1));
 
 	if (! body) {
 		// Apparently not a name we know.
@@ -521,7 +686,7 @@ static bool try_expand_macro(define_map_t &defines, macro_arg_stack_t &macro_arg
 			args.push_back(arg);
 		}
 		for (const auto &pr : body->args.get_vals(name, args)) {
-			if (const define_body_t *existing = defines.find(pr.first)) {
+			if (const define_body_t *existing = find_define(defines, pr.first)) {
 				macro_arg_stack.push({pr.first, *existing});
 				insert_input("`__restore_macro_arg ");
 			}
@@ -739,6 +904,8 @@ read_define(const std::string &filename,
 		// printf("define: >>%s<< -> >>%s<<\n", name.c_str(), value.c_str());
 		defines_map.add(name, value, (state == 2) ? &args : nullptr);
 		global_defines_cache.add(name, value, (state == 2) ? &args : nullptr);
+		if (preproc_trace)
+			preproc_trace->changes.insert(name);
 	} else {
 		log_file_error(filename, 0, "Invalid name for macro definition: >>%s<<.\n", name.c_str());
 	}
@@ -749,7 +916,8 @@ frontend_verilog_preproc(std::istream                 &f,
                          std::string                   filename,
                          const define_map_t           &pre_defines,
                          define_map_t                 &global_defines_cache,
-                         const std::list<std::string> &include_dirs)
+                         const std::list<std::string> &include_dirs,
+                         preproc_trace_t              *trace)
 {
 	define_map_t defines;
 	defines.merge(pre_defines);
@@ -772,8 +940,9 @@ frontend_verilog_preproc(std::istream                 &f,
 	output_code.clear();
 	input_buffer.clear();
 	input_buffer_charp = 0;
+	preproc_trace = trace;
 
-	input_file(f, filename);
+	input_file(read_text(f), filename);
 
 	while (!input_buffer.empty())
 	{
@@ -814,7 +983,7 @@ frontend_verilog_preproc(std::istream                 &f,
 				ifdef_pass_level--;
 				ifdef_fail_level = 1;
 				ifdef_already_satisfied = true;
-			} else if (ifdef_fail_level == 1 && !ifdef_already_satisfied && defines.find(name)) {
+			} else if (ifdef_fail_level == 1 && !ifdef_already_satisfied && find_define(defines, name)) {
 				ifdef_fail_level = 0;
 				ifdef_pass_level++;
 				ifdef_already_satisfied = true;
@@ -825,7 +994,7 @@ frontend_verilog_preproc(std::istream                 &f,
 		if (tok == "`ifdef") {
 			skip_spaces();
 			std::string name = next_token(true);
-			if (ifdef_fail_level > 0 || !defines.find(name)) {
+			if (ifdef_fail_level > 0 || !find_define(defines, name)) {
 				ifdef_fail_level++;
 			} else {
 				ifdef_pass_level++;
@@ -839,7 +1008,7 @@ frontend_verilog_preproc(std::istream                 &f,
 		if (tok == "`ifndef") {
 			skip_spaces();
 			std::string name = next_token(true);
-			if (ifdef_fail_level > 0 || defines.find(name)) {
+			if (ifdef_fail_level > 0 || find_define(defines, name)) {
 				ifdef_fail_level++;
 			} else {
 				ifdef_pass_level++;
@@ -912,8 +1081,15 @@ frontend_verilog_preproc(std::istream                 &f,
 			if (ff.fail()) {
 				output_code.push_back("`file_notfound " + fn);
 			} else {
-				input_file(ff, fixed_fn);
-				yosys_input_files.insert(fixed_fn);
+				auto file = load_include_file(ff, fixed_fn);
+				// a file that is entirely guarded by a macro that is already
+				// defined would not produce any output
+				if (file->guard.empty() || !find_define(defines, file->guard))
+					input_file(file->text, fixed_fn);
+				if (preproc_trace)
+					preproc_trace->include_files.push_back(fixed_fn);
+				else
+					yosys_input_files.insert(fixed_fn);
 			}
 			continue;
 		}
@@ -948,6 +1124,8 @@ frontend_verilog_preproc(std::istream                 &f,
 			// printf("undef: >>%s<<\n", name.c_str());
 			defines.erase(name);
 			global_defines_cache.erase(name);
+			if (preproc_trace)
+				preproc_trace->changes.insert(name);
 			continue;
 		}
 
@@ -961,13 +1139,18 @@ frontend_verilog_preproc(std::istream                 &f,
 		}
 
 		if (tok == "`resetall") {
-			default_nettype_wire = true;
+			if (preproc_trace)
+				preproc_trace->resetall = true;
+			else
+				default_nettype_wire = true;
 			continue;
 		}
 
 		if (tok == "`undefineall" && sv_mode) {
 			defines.clear();
 			global_defines_cache.clear();
+			if (preproc_trace)
+				preproc_trace->undefine_all = true;
 			continue;
 		}
 
@@ -993,6 +1176,7 @@ frontend_verilog_preproc(std::istream                 &f,
 	output_code.clear();
 	input_buffer.clear();
 	input_buffer_charp = 0;
+	preproc_trace = nullptr;
 
 	return output;
 }
@@ -28,6 +28,7 @@
 #include <iosfwd>
 #include <list>
 #include <memory>
+#include <set>
 #include <string>
 
 YOSYS_NAMESPACE_BEGIN
@@ -64,6 +65,20 @@ struct define_map_t
 };
 
 
+// What a run of the preprocessor depends on and what it changes besides its
+// output. When a trace is given, the preprocessor leaves the included files
+// and `resetall to the caller instead of updating the globals itself.
+struct preproc_trace_t
+{
+	// macros looked up before being (re)defined or undefined by the file
+	std::set<std::string> lookups;
+	// macros defined or undefined in the global defines
+	std::set<std::string> changes;
+	bool undefine_all = false;
+	bool resetall = false;
+	std::vector<std::string> include_files;
+};
+
 struct define_map_t;
 
 std::string
@@ -71,7 +86,8 @@ frontend_verilog_preproc(std::istream                 &f,
                          std::string                   filename,
                          const define_map_t           &pre_defines,
                          define_map_t                 &global_defines_cache,
-                         const std::list<std::string> &include_dirs);
+                         const std::list<std::string> &include_dirs,
+                         preproc_trace_t              *trace = nullptr);
 
 YOSYS_NAMESPACE_END
 
@@ -32,6 +32,11 @@
 #include "libs/sha1/sha1.h"
 #include <stdarg.h>
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <atomic>
+#  include <thread>
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 using namespace VERILOG_FRONTEND;
 
@@ -63,6 +68,146 @@ static void add_package_types(dict<std::string, AST::AstNode *> &user_types, std
 	}
 }
 
+#ifdef YOSYS_ENABLE_THREADS
+// Preprocesses the files given to one read_verilog command on several
+// threads. The files of a round are preprocessed concurrently, each starting
+// from the global defines at the start of the round, and a result is only
+// used if none of the macros the file looked up was (re)defined or undefined
+// by an earlier file of the round. Otherwise a new round is started at that
+// file. This gives the same output and defines as preprocessing the files one
+// after the other.
+struct ParallelPreproc
+{
+	struct Job {
+		std::istream *f;
+		std::string filename;
+		std::string text;
+		bool loaded = false;
+		define_map_t defines;
+		preproc_trace_t trace;
+		std::string code;
+		LogBuffer log_buffer;
+		std::exception_ptr error;
+	};
+
+	std::vector<Job> jobs;
+	const define_map_t &pre_defines;
+	const std::list<std::string> &include_dirs;
+	int threads;
+
+	int round_end = 0;
+	std::set<std::string> round_changes;
+	bool round_undefine_all = false;
+
+	ParallelPreproc(const std::vector<std::pair<std::string, std::istream*>> &inputs, const define_map_t &pre_defines,
+			const std::list<std::string> &include_dirs, int threads) :
+			jobs(inputs.size()), pre_defines(pre_defines), include_dirs(include_dirs), threads(threads)
+	{
+		for (int i = 0; i < GetSize(inputs); i++) {
+			jobs[i].filename = inputs[i].first;
+			jobs[i].f = inputs[i].second;
+		}
+	}
+
+	void run(Job &job)
+	{
+		log_buffer_install(&job.log_buffer);
+		try {
+			if (!job.loaded) {
+				std::stringstream buffer;
+				buffer << job.f->rdbuf();
+				job.text = buffer.str();
+				job.loaded = true;
+			}
+			std::istringstream f(job.text);
+			job.code = frontend_verilog_preproc(f, job.filename, pre_defines, job.defines, include_dirs, &job.trace);
+		} catch (...) {
+			job.error = std::current_exception();
+		}
+		log_buffer_install(nullptr);
+	}
+
+	void start_round(int begin, const define_map_t &global_defines)
+	{
+		round_end = std::min(GetSize(jobs), begin + 4 * threads);
+		round_changes.clear();
+		round_undefine_all = false;
+
+		for (int i = begin; i < round_end; i++) {
+			Job &job = jobs[i];
+			job.defines.clear();
+			job.defines.merge(global_defines);
+			job.trace = preproc_trace_t();
+			job.log_buffer.clear();
+			job.error = nullptr;
+		}
+
+		std::atomic<int> next_job(begin);
+		auto thread_main = [&]() {
+			for (int i = next_job.fetch_add(1); i < round_end; i = next_job.fetch_add(1))
+				run(jobs[i]);
+		};
+
+		std::vector<std::thread> pool;
+		for (int i = 0; i < std::min(threads, round_end - begin); i++)
+			pool.emplace_back(thread_main);
+		for (auto &thread : pool)
+			thread.join();
+	}
+
+	bool speculation_valid(const Job &job) const
+	{
+		if (round_undefine_all)
+			return false;
+		for (auto &name : job.trace.lookups)
+			if (round_changes.count(name))
+				return false;
+		return true;
+	}
+
+	// Returns the preprocessor output for the i-th file and applies its
+	// changes to the defines; must be called in file order.
+	std::string get(int i, define_map_t &global_defines)
+	{
+		if (i >= round_end || !speculation_valid(jobs[i]))
+			start_round(i, global_defines);
+
+		Job &job = jobs[i];
+		job.log_buffer.replay();
+		if (job.error != nullptr) {
+			try {
+				std::rethrow_exception(job.error);
+			} catch (const log_buffered_error &e) {
+				e.raise();
+			}
+		}
+
+		if (job.trace.undefine_all) {
+			global_defines.clear();
+			global_defines.merge(job.defines);
+			round_undefine_all = true;
+		} else {
+			for (auto &name : job.trace.changes) {
+				if (const define_body_t *body = job.defines.find(name))
+					global_defines.add(name, *body);
+				else
+					global_defines.erase(name);
+			}
+		}
+		round_changes.insert(job.trace.changes.begin(), job.trace.changes.end());
+
+		for (auto &fn : job.trace.include_files)
+			yosys_input_files.insert(fn);
+		if (job.trace.resetall)
+			default_nettype_wire = true;
+
+		job.defines.clear();
+		job.text = std::string();
+		return std::move(job.code);
+	}
+};
+#endif
+
 struct VerilogFrontend : public Frontend {
 	VerilogFrontend() : Frontend("verilog", "read modules from Verilog file") { }
 	void help() override
@@ -206,6 +351,17 @@ struct VerilogFrontend : public Frontend {
 		log("        only read the abstract syntax tree and defer actual compilation\n");
 		log("        to a later 'hierarchy' command. Useful in cases where the default\n");
 		log("        parameters of modules yield invalid or not synthesizable code.\n");
+		log("        together with -lib, only a stub of each module is kept, and\n");
+		log("        'hierarchy' creates the blackbox module once a cell uses it. This\n");
+		log("        speeds up reading large cell libraries of which only a few cells\n");
+		log("        are used.\n");
+		log("\n");
+		log("    -stream\n");
+		log("        release the abstract syntax tree of each module as soon as its RTLIL\n");
+		log("        representation has been generated. The AST is only kept for modules\n");
+		log("        that may still need to be derived (e.g. modules with parameters or\n");
+		log("        interface ports). This reduces the peak memory usage while reading\n");
+		log("        large designs.\n");
 		log("\n");
 		log("    -noautowire\n");
 		log("        make the default of `default_nettype be \"none\" instead of \"wire\".\n");
@@ -233,6 +389,11 @@ struct VerilogFrontend : public Frontend {
 		log("SYNTHESIS or FORMAL is defined automatically, unless -nosynthesis is used.\n");
 		log("In addition, read_verilog always defines the macro YOSYS.\n");
 		log("\n");
+		log("When Yosys uses more than one thread (see 'yosys -j'), the files given to\n");
+		log("a single read_verilog command are preprocessed concurrently. The result,\n");
+		log("including the macros left defined for later files, is the same as when\n");
+		log("reading the files one after the other.\n");
+		log("\n");
 		log("See the Yosys README file for a list of non-standard Verilog features\n");
 		log("supported by the Yosys Verilog front-end.\n");
 		log("\n");
@@ -259,6 +420,7 @@ struct VerilogFrontend : public Frontend {
 		bool flag_nooverwrite = false;
 		bool flag_overwrite = false;
 		bool flag_defer = false;
+		bool flag_stream = false;
 		bool flag_noblackbox = false;
 		bool flag_nowb = false;
 		bool flag_nosynthesis = false;
@@ -427,6 +589,10 @@ struct VerilogFrontend : public Frontend {
 				flag_defer = true;
 				continue;
 			}
+			if (arg == "-stream") {
+				flag_stream = true;
+				continue;
+			}
 			if (arg == "-noautowire") {
 				default_nettype_wire = false;
 				continue;
@@ -470,73 +636,111 @@ struct VerilogFrontend : public Frontend {
 
 		extra_args(f, filename, args, argidx);
 
-		log_header(design, "Executing Verilog-2005 frontend: %s\n", filename.c_str());
-
-		log("Parsing %s%s input from `%s' to AST representation.\n",
-				formal_mode ? "formal " : "", sv_mode ? "SystemVerilog" : "Verilog", filename.c_str());
-
-		AST::current_filename = filename;
-		AST::set_line_num = &frontend_verilog_yyset_lineno;
-		AST::get_line_num = &frontend_verilog_yyget_lineno;
-
-		current_ast = new AST::AstNode(AST::AST_DESIGN);
-
-		lexin = f;
-		std::string code_after_preproc;
+		// With several threads, all files of this command are read here and
+		// preprocessed concurrently. Parsing and AST::process() still run one
+		// file after the other.
+		std::vector<std::pair<std::string, std::istream*>> inputs;
+		inputs.push_back({filename, f});
+		int threads = parallel_threads(design);
+		if (!flag_nopp && threads > 1 && !log_buffer_active())
+			while (!next_args.empty()) {
+				std::vector<std::string> next_file_args = next_args;
+				std::istream *next_f = nullptr;
+				std::string next_filename;
+				extra_args(next_f, next_filename, next_file_args, argidx);
+				inputs.push_back({next_filename, next_f});
+			}
+
+#ifdef YOSYS_ENABLE_THREADS
+		std::unique_ptr<ParallelPreproc> parallel_preproc;
+		if (GetSize(inputs) > 1)
+			parallel_preproc.reset(new ParallelPreproc(inputs, defines_map, include_dirs, threads));
+#endif
+
+		bool default_nettype_option = default_nettype_wire;
+		for (int input_idx = 0; input_idx < GetSize(inputs); input_idx++)
+		{
+			filename = inputs[input_idx].first;
+			std::istream *input = inputs[input_idx].second;
+			default_nettype_wire = default_nettype_option;
+
+			log_header(design, "Executing Verilog-2005 frontend: %s\n", filename.c_str());
+
+			log("Parsing %s%s input from `%s' to AST representation.\n",
+					formal_mode ? "formal " : "", sv_mode ? "SystemVerilog" : "Verilog", filename.c_str());
+
+			AST::current_filename = filename;
+			AST::set_line_num = &frontend_verilog_yyset_lineno;
+			AST::get_line_num = &frontend_verilog_yyget_lineno;
+
+			current_ast = new AST::AstNode(AST::AST_DESIGN);
+
+			lexin = input;
+			std::string code_after_preproc;
+
+			if (!flag_nopp) {
+#ifdef YOSYS_ENABLE_THREADS
+				if (parallel_preproc)
+					code_after_preproc = parallel_preproc->get(input_idx, *design->verilog_defines);
+				else
+#endif
+					code_after_preproc = frontend_verilog_preproc(*input, filename, defines_map, *design->verilog_defines, include_dirs);
+				if (flag_ppdump)
+					log("-- Verilog code after preprocessor --\n%s-- END OF DUMP --\n", code_after_preproc.c_str());
+				lexin = new std::istringstream(code_after_preproc);
+			}
+
+			// make package typedefs available to parser
+			add_package_types(pkg_user_types, design->verilog_packages);
+
+			UserTypeMap global_types_map;
+			for (auto def : design->verilog_globals) {
+				if (def->type == AST::AST_TYPEDEF) {
+					global_types_map[def->str] = def;
+				}
+			}
 
-		if (!flag_nopp) {
-			code_after_preproc = frontend_verilog_preproc(*f, filename, defines_map, *design->verilog_defines, include_dirs);
-			if (flag_ppdump)
-				log("-- Verilog code after preprocessor --\n%s-- END OF DUMP --\n", code_after_preproc.c_str());
-			lexin = new std::istringstream(code_after_preproc);
-		}
+			log_assert(user_type_stack.empty());
+			// use previous global typedefs as bottom level of user type stack
+			user_type_stack.push_back(std::move(global_types_map));
+			// add a new empty type map to allow overriding existing global definitions
+			user_type_stack.push_back(UserTypeMap());
 
-		// make package typedefs available to parser
-		add_package_types(pkg_user_types, design->verilog_packages);
+			frontend_verilog_yyset_lineno(1);
+			frontend_verilog_yyrestart(NULL);
+			frontend_verilog_yyparse();
+			frontend_verilog_yylex_destroy();
 
-		UserTypeMap global_types_map;
-		for (auto def : design->verilog_globals) {
-			if (def->type == AST::AST_TYPEDEF) {
-				global_types_map[def->str] = def;
+			for (auto &child : current_ast->children) {
+				if (child->type == AST::AST_MODULE)
+					for (auto &attr : attributes)
+						if (child->attributes.count(attr) == 0)
+							child->attributes[attr] = AST::AstNode::mkconst_int(1, false);
 			}
-		}
 
-		log_assert(user_type_stack.empty());
-		// use previous global typedefs as bottom level of user type stack
-		user_type_stack.push_back(std::move(global_types_map));
-		// add a new empty type map to allow overriding existing global definitions
-		user_type_stack.push_back(UserTypeMap());
-
-		frontend_verilog_yyset_lineno(1);
-		frontend_verilog_yyrestart(NULL);
-		frontend_verilog_yyparse();
-		frontend_verilog_yylex_destroy();
-
-		for (auto &child : current_ast->children) {
-			if (child->type == AST::AST_MODULE)
-				for (auto &attr : attributes)
-					if (child->attributes.count(attr) == 0)
-						child->attributes[attr] = AST::AstNode::mkconst_int(1, false);
-		}
+			if (flag_nodpi)
+				error_on_dpi_function(current_ast);
 
-		if (flag_nodpi)
-			error_on_dpi_function(current_ast);
+			AST::process(design, current_ast, flag_nodisplay, flag_dump_ast1, flag_dump_ast2, flag_no_dump_ptr, flag_dump_vlog1, flag_dump_vlog2, flag_dump_rtlil, flag_nolatches,
+					flag_nomeminit, flag_nomem2reg, flag_mem2reg, flag_noblackbox, lib_mode, flag_nowb, flag_noopt, flag_icells, flag_pwires, flag_nooverwrite, flag_overwrite, flag_defer, default_nettype_wire, flag_stream);
 
-		AST::process(design, current_ast, flag_nodisplay, flag_dump_ast1, flag_dump_ast2, flag_no_dump_ptr, flag_dump_vlog1, flag_dump_vlog2, flag_dump_rtlil, flag_nolatches,
-				flag_nomeminit, flag_nomem2reg, flag_mem2reg, flag_noblackbox, lib_mode, flag_nowb, flag_noopt, flag_icells, flag_pwires, flag_nooverwrite, flag_overwrite, flag_defer, default_nettype_wire);
 
+			if (!flag_nopp)
+				delete lexin;
 
-		if (!flag_nopp)
-			delete lexin;
+			// only the previous and new global type maps remain
+			log_assert(user_type_stack.size() == 2);
+			user_type_stack.clear();
 
-		// only the previous and new global type maps remain
-		log_assert(user_type_stack.size() == 2);
-		user_type_stack.clear();
+			delete current_ast;
+			current_ast = NULL;
 
-		delete current_ast;
-		current_ast = NULL;
+			log("Successfully finished Verilog frontend.\n");
+		}
 
-		log("Successfully finished Verilog frontend.\n");
+		// the stream of the first file is owned by the caller
+		for (int input_idx = 1; input_idx < GetSize(inputs); input_idx++)
+			delete inputs[input_idx].second;
 	}
 } VerilogFrontend;
 
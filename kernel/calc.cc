@@ -97,6 +97,146 @@ static RTLIL::Const big2const(const BigInteger &val, int result_len, int undef_b
 	return result;
 }
 
+// Fast path for fully defined operands: the value is unpacked into
+// little-endian 64-bit words, sign- or zero-extended to `width` bits, so
+// that arithmetic and comparisons work a word at a time instead of going
+// bit by bit through BigInteger. Returns false if `val` has x or z bits.
+static bool const2words(const RTLIL::Const &val, bool as_signed, int width, std::vector<uint64_t> &words)
+{
+	int num_bits = GetSize(val);
+	words.assign((width + 63) / 64, 0);
+
+	for (int i = 0; i < num_bits; i++) {
+		RTLIL::State bit = val[i];
+		if (bit == RTLIL::State::S1) {
+			if (i < width)
+				words[i / 64] |= uint64_t(1) << (i % 64);
+		} else if (bit != RTLIL::State::S0)
+			return false;
+	}
+
+	if (as_signed && num_bits > 0 && num_bits < width && val[num_bits-1] == RTLIL::State::S1) {
+		words[num_bits / 64] |= ~uint64_t(0) << (num_bits % 64);
+		for (size_t i = num_bits / 64 + 1; i < words.size(); i++)
+			words[i] = ~uint64_t(0);
+	}
+
+	return true;
+}
+
+static RTLIL::Const words2const(const std::vector<uint64_t> &words, int result_len)
+{
+	std::vector<RTLIL::State> bits(result_len);
+	for (int i = 0; i < result_len; i++)
+		bits[i] = (words[i / 64] >> (i % 64)) & 1 ? RTLIL::State::S1 : RTLIL::State::S0;
+	return RTLIL::Const(bits);
+}
+
+// 64x64 -> 128 bit multiplication, returns the low word
+static uint64_t mul_words(uint64_t a, uint64_t b, uint64_t &hi)
+{
+	uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+	uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+	uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+	uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+	uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+	hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	return (cross << 32) | (lo_lo & 0xffffffff);
+}
+
+// Compares two operands extended to the same number of words as two's
+// complement numbers, returns -1, 0 or 1.
+static int compare_words(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b)
+{
+	for (size_t i = a.size(); i > 0; i--) {
+		if (a[i-1] == b[i-1])
+			continue;
+		if (i == a.size())
+			return int64_t(a[i-1]) < int64_t(b[i-1]) ? -1 : 1;
+		return a[i-1] < b[i-1] ? -1 : 1;
+	}
+	return 0;
+}
+
+// Word-parallel versions of the BigInteger based operations below. They
+// return false if an operand is not fully defined.
+static bool const_compare_words(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int &cmp)
+{
+	// one extra bit so that unsigned operands stay positive
+	int width = max(GetSize(arg1), GetSize(arg2)) + 1;
+	std::vector<uint64_t> a, b;
+	if (!const2words(arg1, signed1, width, a) || !const2words(arg2, signed2, width, b))
+		return false;
+	cmp = compare_words(a, b);
+	return true;
+}
+
+static bool const_addsub_words(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len, bool subtract, RTLIL::Const &result)
+{
+	std::vector<uint64_t> a, b;
+	if (!const2words(arg1, signed1, result_len, a) || !const2words(arg2, signed2, result_len, b))
+		return false;
+
+	uint64_t carry = subtract ? 1 : 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		uint64_t y = subtract ? ~b[i] : b[i];
+		uint64_t sum = a[i] + y;
+		uint64_t carry_out = sum < a[i];
+		sum += carry;
+		carry_out |= sum < carry;
+		a[i] = sum;
+		carry = carry_out;
+	}
+
+	result = words2const(a, result_len);
+	return true;
+}
+
+static bool const_mul_words(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len, RTLIL::Const &result)
+{
+	std::vector<uint64_t> a, b;
+	if (!const2words(arg1, signed1, result_len, a) || !const2words(arg2, signed2, result_len, b))
+		return false;
+
+	size_t n = a.size();
+	std::vector<uint64_t> y(n, 0);
+	for (size_t i = 0; i < n; i++) {
+		if (a[i] == 0)
+			continue;
+		uint64_t carry = 0;
+		for (size_t j = 0; i + j < n; j++) {
+			uint64_t hi, lo = mul_words(a[i], b[j], hi);
+			lo += carry;
+			hi += lo < carry;
+			y[i+j] += lo;
+			hi += y[i+j] < lo;
+			carry = hi;
+		}
+	}
+
+	result = words2const(y, result_len);
+	return true;
+}
+
+// Fully defined operands of up to 63 bits, whose value fits into a signed
+// 64-bit integer, for the operations that have no word-parallel version.
+static bool const2int(const RTLIL::Const &val, bool as_signed, int64_t &result)
+{
+	std::vector<uint64_t> words;
+	if (GetSize(val) > 63 || !const2words(val, as_signed, 64, words))
+		return false;
+	result = int64_t(words[0]);
+	return true;
+}
+
+static RTLIL::Const int2const(int64_t val, int result_len)
+{
+	std::vector<uint64_t> words((result_len + 63) / 64, val < 0 ? ~uint64_t(0) : 0);
+	if (!words.empty())
+		words[0] = uint64_t(val);
+	return words2const(words, result_len);
+}
+
 static RTLIL::State logic_and(RTLIL::State a, RTLIL::State b)
 {
 	if (a == RTLIL::State::S0) return RTLIL::State::S0;
@@ -292,14 +432,25 @@ static RTLIL::Const const_shift_worker(const RTLIL::Const &arg1, const RTLIL::Co
 	if (undef_bit_pos >= 0)
 		return result;
 
+	// shifting further than this does not change the result, clamping keeps
+	// the per-bit position arithmetic out of BigInteger
+	int arg1_size = GetSize(arg1);
+	long long shift;
+	if (offset < BigInteger(-result_len))
+		shift = -result_len;
+	else if (offset > BigInteger(arg1_size))
+		shift = arg1_size;
+	else
+		shift = offset.toInt();
+
 	for (int i = 0; i < result_len; i++) {
-		BigInteger pos = BigInteger(i) + offset;
+		long long pos = i + shift;
 		if (pos < 0)
 			result.bits()[i] = vacant_bits;
-		else if (pos >= BigInteger(GetSize(arg1)))
+		else if (pos >= arg1_size)
 			result.bits()[i] = sign_ext ? arg1.back() : vacant_bits;
 		else
-			result.bits()[i] = arg1[pos.toInt()];
+			result.bits()[i] = arg1[pos];
 	}
 
 	return result;
@@ -343,6 +494,14 @@ RTLIL::Const RTLIL::const_shiftx(const RTLIL::Const &arg1, const RTLIL::Const &a
 
 RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int cmp;
+	if (const_compare_words(arg1, arg2, signed1, signed2, cmp)) {
+		RTLIL::Const result(RTLIL::State::S0, max(result_len, 1));
+		if (cmp < 0)
+			result.bits().front() = RTLIL::State::S1;
+		return result;
+	}
+
 	int undef_bit_pos = -1;
 	bool y = const2big(arg1, signed1, undef_bit_pos) < const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
@@ -354,6 +513,14 @@ RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_le(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int cmp;
+	if (const_compare_words(arg1, arg2, signed1, signed2, cmp)) {
+		RTLIL::Const result(RTLIL::State::S0, max(result_len, 1));
+		if (cmp <= 0)
+			result.bits().front() = RTLIL::State::S1;
+		return result;
+	}
+
 	int undef_bit_pos = -1;
 	bool y = const2big(arg1, signed1, undef_bit_pos) <= const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
@@ -428,6 +595,14 @@ RTLIL::Const RTLIL::const_nex(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int cmp;
+	if (const_compare_words(arg1, arg2, signed1, signed2, cmp)) {
+		RTLIL::Const result(RTLIL::State::S0, max(result_len, 1));
+		if (cmp >= 0)
+			result.bits().front() = RTLIL::State::S1;
+		return result;
+	}
+
 	int undef_bit_pos = -1;
 	bool y = const2big(arg1, signed1, undef_bit_pos) >= const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
@@ -439,6 +614,14 @@ RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int cmp;
+	if (const_compare_words(arg1, arg2, signed1, signed2, cmp)) {
+		RTLIL::Const result(RTLIL::State::S0, max(result_len, 1));
+		if (cmp > 0)
+			result.bits().front() = RTLIL::State::S1;
+		return result;
+	}
+
 	int undef_bit_pos = -1;
 	bool y = const2big(arg1, signed1, undef_bit_pos) > const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
@@ -450,6 +633,10 @@ RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (const_addsub_words(arg1, arg2, signed1, signed2, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)), false, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) + const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)), undef_bit_pos);
@@ -457,6 +644,10 @@ RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (const_addsub_words(arg1, arg2, signed1, signed2, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)), true, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) - const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)), undef_bit_pos);
@@ -464,6 +655,10 @@ RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (const_mul_words(arg1, arg2, signed1, signed2, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)), result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) * const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)), min(undef_bit_pos, 0));
@@ -472,6 +667,13 @@ RTLIL::Const RTLIL::const_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 // truncating division
 RTLIL::Const RTLIL::const_div(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int64_t a_int, b_int;
+	if (const2int(arg1, signed1, a_int) && const2int(arg2, signed2, b_int)) {
+		if (b_int == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		return int2const(a_int / b_int, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)));
+	}
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -486,6 +688,13 @@ RTLIL::Const RTLIL::const_div(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 // truncating modulo
 RTLIL::Const RTLIL::const_mod(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int64_t a_int, b_int;
+	if (const2int(arg1, signed1, a_int) && const2int(arg2, signed2, b_int)) {
+		if (b_int == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		return int2const(a_int % b_int, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)));
+	}
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -499,6 +708,16 @@ RTLIL::Const RTLIL::const_mod(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_divfloor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int64_t a_int, b_int;
+	if (const2int(arg1, signed1, a_int) && const2int(arg2, signed2, b_int)) {
+		if (b_int == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		int64_t y = a_int / b_int;
+		if (a_int % b_int != 0 && (a_int < 0) != (b_int < 0))
+			y--;
+		return int2const(y, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)));
+	}
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -521,6 +740,16 @@ RTLIL::Const RTLIL::const_divfloor(const RTLIL::Const &arg1, const RTLIL::Const
 
 RTLIL::Const RTLIL::const_modfloor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int64_t a_int, b_int;
+	if (const2int(arg1, signed1, a_int) && const2int(arg2, signed2, b_int)) {
+		if (b_int == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		int64_t y = a_int % b_int;
+		if (y != 0 && (a_int < 0) != (b_int < 0))
+			y += b_int;
+		return int2const(y, result_len >= 0 ? result_len : max(GetSize(arg1), GetSize(arg2)));
+	}
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -544,6 +773,35 @@ RTLIL::Const RTLIL::const_modfloor(const RTLIL::Const &arg1, const RTLIL::Const
 
 RTLIL::Const RTLIL::const_pow(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	// with a result of up to 64 bits, the power modulo 2^result_len can be
+	// computed with wrapping 64-bit multiplications
+	int64_t a_int, b_int;
+	if (result_len >= 0 && result_len <= 64 && const2int(arg1, signed1, a_int) && const2int(arg2, signed2, b_int)) {
+		if (a_int == 0 && b_int < 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		if (a_int == 0 && b_int > 0)
+			return RTLIL::Const(RTLIL::State::S0, result_len);
+
+		uint64_t y = 1;
+		if (b_int < 0) {
+			if (a_int < -1 || a_int > 1)
+				y = 0;
+			if (a_int == -1)
+				y = (-b_int % 2) == 0 ? 1 : ~uint64_t(0);
+		}
+		if (b_int > 0) {
+			uint64_t base = a_int < 0 ? -uint64_t(a_int) : uint64_t(a_int);
+			for (uint64_t exp = b_int; exp > 0; exp >>= 1) {
+				if (exp & 1)
+					y *= base;
+				base *= base;
+			}
+			if (a_int < 0 && (b_int & 1))
+				y = -y;
+		}
+		return int2const(int64_t(y), result_len);
+	}
+
 	int undef_bit_pos = -1;
 
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
@@ -19,6 +19,10 @@
 
 #include "kernel/cellaigs.h"
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <mutex>
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 
 AigNode::AigNode()
@@ -253,13 +257,11 @@ struct AigMaker
 	}
 };
 
-Aig::Aig(Cell *cell)
+// The name of the AIG of an internal cell, which encodes its type and all
+// parameters (and so the widths of its ports).
+static string aig_name(Cell *cell)
 {
-	if (cell->type[0] != '$')
-		return;
-
-	AigMaker mk(this, cell);
-	name = cell->type.str();
+	string name = cell->type.str();
 
 	string mkname_last;
 	bool mkname_a_signed = false;
@@ -291,6 +293,17 @@ Aig::Aig(Cell *cell)
 		}
 	}
 
+	return name;
+}
+
+Aig::Aig(Cell *cell)
+{
+	if (cell->type[0] != '$')
+		return;
+
+	AigMaker mk(this, cell);
+	name = aig_name(cell);
+
 	if (cell->type.in(ID($not), ID($_NOT_), ID($pos), ID($buf), ID($_BUF_)))
 	{
 		for (int i = 0; i < GetSize(cell->getPort(ID::Y)); i++) {
@@ -513,4 +526,27 @@ optimize:;
 	new_nodes.swap(nodes);
 }
 
+// The AIGs are only built for the first cell of every name and kept for the
+// rest of the run, there are few distinct names even in large designs.
+static dict<string, std::unique_ptr<Aig>> aig_templates;
+#ifdef YOSYS_ENABLE_THREADS
+static std::mutex aig_templates_mutex;
+#endif
+
+const Aig &Aig::cached(Cell *cell)
+{
+	string key = cell->type[0] == '$' ? aig_name(cell) : string();
+
+#ifdef YOSYS_ENABLE_THREADS
+	std::unique_lock<std::mutex> lock(aig_templates_mutex, std::defer_lock);
+	if (IdString::concurrent_mode())
+		lock.lock();
+#endif
+
+	auto &aig = aig_templates[key];
+	if (aig == nullptr)
+		aig.reset(new Aig(cell));
+	return *aig;
+}
+
 YOSYS_NAMESPACE_END
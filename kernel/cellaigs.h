@@ -43,6 +43,11 @@ struct Aig
 	vector<AigNode> nodes;
 	Aig(Cell *cell);
 
+	// Returns the same AIG as Aig(cell), shared by all cells with the same
+	// type and parameters. Cells with unsupported types get an AIG with an
+	// empty name, like from Aig(cell).
+	static const Aig &cached(Cell *cell);
+
 	bool operator==(const Aig &other) const;
 	[[nodiscard]] Hasher hash_into(Hasher h) const;
 };
@@ -138,6 +138,10 @@ public:
             append_arg(arg.index());
         }
 
+        void clear_args() const
+        {
+            deref().arg_count = 0;
+        }
         void append_arg(int arg) const
         {
             log_assert(arg >= 0 && arg < this->graph_->size());
@@ -189,6 +193,10 @@ public:
     {
         return keys_;
     }
+    void erase_key(Key const &key)
+    {
+        keys_.erase(key);
+    }
 
     ConstRef operator()(Key const &key) const
     {
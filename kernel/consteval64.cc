@@ -0,0 +1,572 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/consteval64.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+typedef std::vector<uint64_t> Lanes;
+
+const uint64_t ALL_LANES = ~uint64_t(0);
+
+Lanes extend(Lanes v, int width, bool is_signed)
+{
+	uint64_t fill = is_signed && !v.empty() ? v.back() : 0;
+	v.resize(width, fill);
+	return v;
+}
+
+Lanes invert(Lanes v)
+{
+	for (auto &w : v)
+		w = ~w;
+	return v;
+}
+
+// a + b + carry, all of the same width
+Lanes add(const Lanes &a, const Lanes &b, uint64_t carry, Lanes *carry_out = nullptr)
+{
+	Lanes y(a.size());
+	if (carry_out)
+		carry_out->resize(a.size());
+	for (size_t i = 0; i < a.size(); i++) {
+		uint64_t t = a[i] ^ b[i];
+		y[i] = t ^ carry;
+		carry = (a[i] & b[i]) | (carry & t);
+		if (carry_out)
+			(*carry_out)[i] = carry;
+	}
+	return y;
+}
+
+uint64_t reduce_or(const Lanes &v)
+{
+	uint64_t r = 0;
+	for (auto w : v)
+		r |= w;
+	return r;
+}
+
+uint64_t reduce_and(const Lanes &v)
+{
+	uint64_t r = ALL_LANES;
+	for (auto w : v)
+		r &= w;
+	return r;
+}
+
+uint64_t reduce_xor(const Lanes &v)
+{
+	uint64_t r = 0;
+	for (auto w : v)
+		r ^= w;
+	return r;
+}
+
+Lanes bool_result(uint64_t value, int width)
+{
+	Lanes y(std::max(width, 1), 0);
+	y[0] = value;
+	y.resize(width);
+	return y;
+}
+
+uint64_t equal(const Lanes &a, const Lanes &b)
+{
+	uint64_t r = ALL_LANES;
+	for (size_t i = 0; i < a.size(); i++)
+		r &= ~(a[i] ^ b[i]);
+	return r;
+}
+
+// a < b for each lane, operands of the same width
+uint64_t less_than(Lanes a, Lanes b, bool is_signed)
+{
+	if (a.empty())
+		return 0;
+	if (is_signed) {
+		a.back() = ~a.back();
+		b.back() = ~b.back();
+	}
+	// a < b iff a + ~b + 1 has no carry out
+	uint64_t carry = ALL_LANES;
+	for (size_t i = 0; i < a.size(); i++) {
+		uint64_t nb = ~b[i];
+		carry = (a[i] & nb) | (carry & (a[i] ^ nb));
+	}
+	return ~carry;
+}
+
+// barrel shifter, the shift amount is unsigned
+Lanes shift(const Lanes &a, const Lanes &amount, bool left, uint64_t fill)
+{
+	int width = GetSize(a);
+	Lanes y = a;
+	for (int k = 0; k < GetSize(amount); k++) {
+		uint64_t sel = amount[k];
+		if (sel == 0)
+			continue;
+		Lanes shifted(width, fill);
+		if (k < 31 && (1 << k) < width) {
+			int dist = 1 << k;
+			for (int i = 0; i < width; i++) {
+				int src = left ? i - dist : i + dist;
+				if (src >= 0 && src < width)
+					shifted[i] = y[src];
+				else
+					shifted[i] = left ? 0 : fill;
+			}
+		} else if (left) {
+			shifted.assign(width, 0);
+		}
+		for (int i = 0; i < width; i++)
+			y[i] = (y[i] & ~sel) | (shifted[i] & sel);
+	}
+	return y;
+}
+
+Lanes multiply(const Lanes &a, const Lanes &b)
+{
+	int width = GetSize(a);
+	Lanes y(width, 0);
+	for (int i = 0; i < width; i++) {
+		if (b[i] == 0)
+			continue;
+		Lanes partial(width, 0);
+		for (int j = i; j < width; j++)
+			partial[j] = a[j-i] & b[i];
+		y = add(y, partial, 0);
+	}
+	return y;
+}
+
+} // namespace
+
+ConstEval64::ConstEval64(RTLIL::Module *module) : module(module), assign_map(module)
+{
+	CellTypes ct;
+	ct.setup_internals();
+	ct.setup_stdcells();
+
+	for (auto cell : module->cells()) {
+		if (!ct.cell_known(cell->type))
+			continue;
+		for (auto &conn : cell->connections())
+			if (ct.cell_output(cell->type, conn.first))
+				for (auto bit : assign_map(conn.second))
+					if (bit.wire != nullptr)
+						sig2driver[bit] = cell;
+	}
+}
+
+void ConstEval64::set(RTLIL::SigBit bit, uint64_t lanes)
+{
+	assign_map.apply(bit);
+	if (bit.wire != nullptr)
+		values[bit] = lanes;
+}
+
+void ConstEval64::set(const RTLIL::SigSpec &sig, const std::vector<uint64_t> &lanes)
+{
+	log_assert(GetSize(sig) == GetSize(lanes));
+	for (int i = 0; i < GetSize(sig); i++)
+		set(sig[i], lanes[i]);
+}
+
+RTLIL::Const ConstEval64::lane(const std::vector<uint64_t> &lanes, int index)
+{
+	log_assert(index >= 0 && index < 64);
+	RTLIL::Const value(RTLIL::State::S0, GetSize(lanes));
+	for (int i = 0; i < GetSize(lanes); i++)
+		if ((lanes[i] >> index) & 1)
+			value.bits()[i] = RTLIL::State::S1;
+	return value;
+}
+
+bool ConstEval64::eval(RTLIL::SigBit bit, uint64_t &value, RTLIL::SigSpec &undef)
+{
+	assign_map.apply(bit);
+	if (bit.wire == nullptr) {
+		value = bit.data == RTLIL::State::S1 ? ALL_LANES : 0;
+		return true;
+	}
+
+	auto it = values.find(bit);
+	if (it == values.end()) {
+		auto driver = sig2driver.find(bit);
+		if (driver == sig2driver.end()) {
+			undef.append(bit);
+			return false;
+		}
+		if (!eval(driver->second, undef))
+			return false;
+		it = values.find(bit);
+		if (it == values.end()) {
+			undef.append(bit);
+			return false;
+		}
+	}
+
+	value = it->second;
+	return true;
+}
+
+bool ConstEval64::eval(const RTLIL::SigSpec &sig, std::vector<uint64_t> &lanes, RTLIL::SigSpec &undef)
+{
+	bool ok = true;
+	lanes.resize(GetSize(sig));
+	for (int i = 0; i < GetSize(sig); i++)
+		if (!eval(sig[i], lanes[i], undef))
+			ok = false;
+	return ok;
+}
+
+bool ConstEval64::eval(const RTLIL::SigSpec &sig, std::vector<uint64_t> &lanes)
+{
+	RTLIL::SigSpec undef;
+	return eval(sig, lanes, undef);
+}
+
+bool ConstEval64::eval(RTLIL::Cell *cell, RTLIL::SigSpec &undef)
+{
+	if (busy.count(cell)) {
+		// combinational loop
+		for (auto &conn : cell->connections())
+			if (cell->output(conn.first))
+				undef.append(conn.second);
+		return false;
+	}
+
+	busy.insert(cell);
+	struct BusyGuard {
+		pool<RTLIL::Cell*> &busy;
+		RTLIL::Cell *cell;
+		~BusyGuard() { busy.erase(cell); }
+	} guard{busy, cell};
+
+	RTLIL::IdString type = cell->type;
+	Lanes a, b, c, d, s, y;
+
+	auto input = [&](RTLIL::IdString port, Lanes &lanes) {
+		return eval(cell->getPort(port), lanes, undef);
+	};
+	auto output = [&](RTLIL::IdString port, const Lanes &lanes) {
+		set(cell->getPort(port), lanes);
+	};
+
+	if (type.in(ID($_BUF_), ID($_NOT_)))
+	{
+		if (!input(ID::A, a))
+			return false;
+		output(ID::Y, type == ID($_NOT_) ? invert(a) : a);
+		return true;
+	}
+
+	if (type.in(ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b))
+			return false;
+		uint64_t va = a[0], vb = b[0], vy;
+		if (type == ID($_AND_)) vy = va & vb;
+		else if (type == ID($_NAND_)) vy = ~(va & vb);
+		else if (type == ID($_OR_)) vy = va | vb;
+		else if (type == ID($_NOR_)) vy = ~(va | vb);
+		else if (type == ID($_XOR_)) vy = va ^ vb;
+		else if (type == ID($_XNOR_)) vy = ~(va ^ vb);
+		else if (type == ID($_ANDNOT_)) vy = va & ~vb;
+		else vy = va | ~vb;
+		output(ID::Y, {vy});
+		return true;
+	}
+
+	if (type.in(ID($_MUX_), ID($_NMUX_)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b) || !input(ID::S, s))
+			return false;
+		uint64_t vy = (a[0] & ~s[0]) | (b[0] & s[0]);
+		output(ID::Y, {type == ID($_NMUX_) ? ~vy : vy});
+		return true;
+	}
+
+	if (type.in(ID($_AOI3_), ID($_OAI3_)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b) || !input(ID::C, c))
+			return false;
+		if (type == ID($_AOI3_))
+			output(ID::Y, {~((a[0] & b[0]) | c[0])});
+		else
+			output(ID::Y, {~((a[0] | b[0]) & c[0])});
+		return true;
+	}
+
+	if (type.in(ID($_AOI4_), ID($_OAI4_)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b) || !input(ID::C, c) || !input(ID::D, d))
+			return false;
+		if (type == ID($_AOI4_))
+			output(ID::Y, {~((a[0] & b[0]) | (c[0] & d[0]))});
+		else
+			output(ID::Y, {~((a[0] | b[0]) & (c[0] | d[0]))});
+		return true;
+	}
+
+	bool signed_a = cell->hasParam(ID::A_SIGNED) && cell->getParam(ID::A_SIGNED).as_bool();
+	bool signed_b = cell->hasParam(ID::B_SIGNED) && cell->getParam(ID::B_SIGNED).as_bool();
+	int width_y = cell->hasPort(ID::Y) ? GetSize(cell->getPort(ID::Y)) : 0;
+
+	if (type.in(ID($not), ID($pos), ID($neg)))
+	{
+		if (!input(ID::A, a))
+			return false;
+		a = extend(a, width_y, signed_a);
+		if (type == ID($not))
+			y = invert(a);
+		else if (type == ID($neg))
+			y = add(Lanes(width_y, 0), invert(a), ALL_LANES);
+		else
+			y = a;
+		output(ID::Y, y);
+		return true;
+	}
+
+	if (type.in(ID($and), ID($or), ID($xor), ID($xnor)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b))
+			return false;
+		a = extend(a, width_y, signed_a);
+		b = extend(b, width_y, signed_b);
+		y.resize(width_y);
+		for (int i = 0; i < width_y; i++) {
+			if (type == ID($and)) y[i] = a[i] & b[i];
+			else if (type == ID($or)) y[i] = a[i] | b[i];
+			else if (type == ID($xor)) y[i] = a[i] ^ b[i];
+			else y[i] = ~(a[i] ^ b[i]);
+		}
+		output(ID::Y, y);
+		return true;
+	}
+
+	if (type.in(ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool), ID($logic_not)))
+	{
+		if (!input(ID::A, a))
+			return false;
+		uint64_t vy;
+		if (type == ID($reduce_and)) vy = reduce_and(a);
+		else if (type == ID($reduce_xor)) vy = reduce_xor(a);
+		else if (type == ID($reduce_xnor)) vy = ~reduce_xor(a);
+		else if (type == ID($logic_not)) vy = ~reduce_or(a);
+		else vy = reduce_or(a);
+		output(ID::Y, bool_result(vy, width_y));
+		return true;
+	}
+
+	if (type.in(ID($logic_and), ID($logic_or)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b))
+			return false;
+		uint64_t vy = type == ID($logic_and) ? reduce_or(a) & reduce_or(b) : reduce_or(a) | reduce_or(b);
+		output(ID::Y, bool_result(vy, width_y));
+		return true;
+	}
+
+	if (type.in(ID($eq), ID($ne), ID($eqx), ID($nex)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b))
+			return false;
+		int width = std::max(GetSize(a), GetSize(b));
+		uint64_t vy = equal(extend(a, width, signed_a && signed_b), extend(b, width, signed_a && signed_b));
+		output(ID::Y, bool_result(type.in(ID($eq), ID($eqx)) ? vy : ~vy, width_y));
+		return true;
+	}
+
+	if (type.in(ID($lt), ID($le), ID($gt), ID($ge)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b))
+			return false;
+		// one extra bit so mixed signedness compares like the integers
+		int width = std::max(GetSize(a), GetSize(b)) + 1;
+		bool is_signed = signed_a || signed_b;
+		a = extend(a, width, signed_a);
+		b = extend(b, width, signed_b);
+		uint64_t vy;
+		if (type == ID($lt)) vy = less_than(a, b, is_signed);
+		else if (type == ID($le)) vy = ~less_than(b, a, is_signed);
+		else if (type == ID($gt)) vy = less_than(b, a, is_signed);
+		else vy = ~less_than(a, b, is_signed);
+		output(ID::Y, bool_result(vy, width_y));
+		return true;
+	}
+
+	if (type.in(ID($add), ID($sub), ID($mul)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b))
+			return false;
+		a = extend(a, width_y, signed_a);
+		b = extend(b, width_y, signed_b);
+		if (type == ID($add))
+			y = add(a, b, 0);
+		else if (type == ID($sub))
+			y = add(a, invert(b), ALL_LANES);
+		else
+			y = multiply(a, b);
+		output(ID::Y, y);
+		return true;
+	}
+
+	if (type.in(ID($shl), ID($sshl), ID($shr), ID($sshr)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b))
+			return false;
+		if (type.in(ID($shl), ID($sshl))) {
+			y = shift(extend(a, width_y, signed_a), b, true, 0);
+		} else {
+			a = extend(a, std::max(width_y, GetSize(a)), signed_a);
+			uint64_t fill = type == ID($sshr) && signed_a && !a.empty() ? a.back() : 0;
+			y = shift(a, b, false, fill);
+			y.resize(width_y);
+		}
+		output(ID::Y, y);
+		return true;
+	}
+
+	if (type.in(ID($mux), ID($bwmux)))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b) || !input(ID::S, s))
+			return false;
+		y.resize(width_y);
+		for (int i = 0; i < width_y; i++) {
+			uint64_t sel = type == ID($mux) ? s[0] : s[i];
+			y[i] = (a[i] & ~sel) | (b[i] & sel);
+		}
+		output(ID::Y, y);
+		return true;
+	}
+
+	if (type == ID($pmux))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b) || !input(ID::S, s))
+			return false;
+		uint64_t none = ~reduce_or(s);
+		y.resize(width_y);
+		for (int i = 0; i < width_y; i++) {
+			y[i] = a[i] & none;
+			for (int j = 0; j < GetSize(s); j++)
+				y[i] |= b[j*width_y + i] & s[j];
+		}
+		output(ID::Y, y);
+		return true;
+	}
+
+	if (type == ID($fa))
+	{
+		if (!input(ID::A, a) || !input(ID::B, b) || !input(ID::C, c))
+			return false;
+		Lanes x(GetSize(a));
+		y.resize(GetSize(a));
+		for (int i = 0; i < GetSize(a); i++) {
+			uint64_t t = a[i] ^ b[i];
+			y[i] = t ^ c[i];
+			x[i] = (a[i] & b[i]) | (c[i] & t);
+		}
+		output(ID::Y, y);
+		output(ID::X, x);
+		return true;
+	}
+
+	if (type == ID($alu))
+	{
+		Lanes ci, bi;
+		if (!input(ID::A, a) || !input(ID::B, b) || !input(ID::CI, ci) || !input(ID::BI, bi))
+			return false;
+		a = extend(a, width_y, signed_a);
+		b = extend(b, width_y, signed_b);
+		for (auto &w : b)
+			w ^= bi[0];
+		Lanes x(width_y), co;
+		for (int i = 0; i < width_y; i++)
+			x[i] = a[i] ^ b[i];
+		y = add(a, b, ci[0], &co);
+		output(ID::Y, y);
+		output(ID::X, x);
+		output(ID::CO, co);
+		return true;
+	}
+
+	if (type == ID($lcu))
+	{
+		Lanes p, g, ci;
+		if (!input(ID::P, p) || !input(ID::G, g) || !input(ID::CI, ci))
+			return false;
+		Lanes co(GetSize(p));
+		uint64_t carry = ci[0];
+		for (int i = 0; i < GetSize(p); i++) {
+			carry = g[i] | (p[i] & carry);
+			co[i] = carry;
+		}
+		output(ID::CO, co);
+		return true;
+	}
+
+	return eval_lanewise(cell, undef);
+}
+
+// fallback for cells without a bit-parallel model: one CellTypes::eval()
+// call per pattern
+bool ConstEval64::eval_lanewise(RTLIL::Cell *cell, RTLIL::SigSpec &undef)
+{
+	if (!cell->hasPort(ID::Y) || cell->type == ID($macc)) {
+		for (auto &conn : cell->connections())
+			if (cell->output(conn.first))
+				undef.append(conn.second);
+		return false;
+	}
+
+	// $bmux and $demux take the select signal as their second argument
+	std::vector<RTLIL::IdString> ports;
+	if (cell->hasPort(ID::S))
+		ports = {ID::A, ID::S};
+	else
+		ports = {ID::A, ID::B, ID::C, ID::D};
+
+	std::vector<Lanes> args(4);
+	for (int i = 0; i < GetSize(ports); i++)
+		if (cell->hasPort(ports[i]) && !eval(cell->getPort(ports[i]), args[i], undef))
+			return false;
+
+	Lanes y(GetSize(cell->getPort(ID::Y)), 0);
+	for (int k = 0; k < 64; k++) {
+		bool eval_err = false;
+		RTLIL::Const value = CellTypes::eval(cell, lane(args[0], k), lane(args[1], k),
+				lane(args[2], k), lane(args[3], k), &eval_err);
+		if (eval_err) {
+			undef.append(cell->getPort(ID::Y));
+			return false;
+		}
+		for (int i = 0; i < GetSize(y) && i < GetSize(value); i++)
+			if (value[i] == RTLIL::State::S1)
+				y[i] |= uint64_t(1) << k;
+	}
+
+	set(cell->getPort(ID::Y), y);
+	return true;
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,73 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef CONSTEVAL64_H
+#define CONSTEVAL64_H
+
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+#include "kernel/celltypes.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Bit-parallel variant of ConstEval: evaluates the combinational cells of a
+// module for 64 input patterns at once. Every signal bit is a uint64_t word
+// with one pattern per bit ("lane"), so one cell evaluation covers all 64
+// patterns. This is meant for random simulation, e.g. to find candidate
+// equivalences before proving them with SAT.
+//
+// The simulation is two-valued: x and z bits in constants evaluate to 0,
+// and a $pmux with more than one active select bit returns the OR of the
+// selected inputs. Gate-level cells and the common word-level cells are
+// simulated natively; other cells CellTypes::eval() can handle are
+// evaluated lane by lane.
+struct ConstEval64
+{
+	RTLIL::Module *module;
+	SigMap assign_map;
+	dict<RTLIL::SigBit, RTLIL::Cell*> sig2driver;
+	dict<RTLIL::SigBit, uint64_t> values;
+	pool<RTLIL::Cell*> busy;
+
+	ConstEval64(RTLIL::Module *module);
+
+	void clear() { values.clear(); }
+
+	// assign the patterns of input bits, one word per bit of sig
+	void set(RTLIL::SigBit bit, uint64_t lanes);
+	void set(const RTLIL::SigSpec &sig, const std::vector<uint64_t> &lanes);
+
+	// Evaluate sig for all patterns. Returns false if sig depends on bits
+	// that neither have been set nor are driven by an evaluable cell, those
+	// bits are added to undef.
+	bool eval(const RTLIL::SigSpec &sig, std::vector<uint64_t> &lanes, RTLIL::SigSpec &undef);
+	bool eval(const RTLIL::SigSpec &sig, std::vector<uint64_t> &lanes);
+
+	// the value of the given pattern in a set of lanes
+	static RTLIL::Const lane(const std::vector<uint64_t> &lanes, int index);
+
+private:
+	bool eval(RTLIL::SigBit bit, uint64_t &value, RTLIL::SigSpec &undef);
+	bool eval(RTLIL::Cell *cell, RTLIL::SigSpec &undef);
+	bool eval_lanewise(RTLIL::Cell *cell, RTLIL::SigSpec &undef);
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
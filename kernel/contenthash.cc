@@ -0,0 +1,279 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/contenthash.h"
+#include "backends/rtlil/rtlil_backend.h"
+
+#include <sstream>
+
+YOSYS_NAMESPACE_BEGIN
+
+// The constants and the algorithm are those of XXH64, so that the first lane
+// (seed 0) gives the standard XXH64 value of the hashed bytes.
+static const uint64_t prime1 = 11400714785074694791ULL;
+static const uint64_t prime2 = 14029467366897019727ULL;
+static const uint64_t prime3 = 1609587929392839161ULL;
+static const uint64_t prime4 = 9650029242287828579ULL;
+static const uint64_t prime5 = 2870177450012600261ULL;
+static const uint64_t second_seed = 0x9e3779b97f4a7c15ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+// little-endian loads, independent of the byte order of the host
+static inline uint64_t read64(const unsigned char *p)
+{
+	uint64_t v = 0;
+	for (int i = 7; i >= 0; i--)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+static inline uint32_t read32(const unsigned char *p)
+{
+	return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+	acc += input * prime2;
+	acc = rotl64(acc, 31);
+	return acc * prime1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t val)
+{
+	acc ^= xxh_round(0, val);
+	return acc * prime1 + prime4;
+}
+
+ContentHash::ContentHash() : buffer_len(0), total_len(0)
+{
+	init(lanes[0], 0);
+	init(lanes[1], second_seed);
+}
+
+void ContentHash::init(State &state, uint64_t seed)
+{
+	state.seed = seed;
+	state.v[0] = seed + prime1 + prime2;
+	state.v[1] = seed + prime2;
+	state.v[2] = seed;
+	state.v[3] = seed - prime1;
+}
+
+void ContentHash::consume(State &state, const unsigned char *stripe)
+{
+	for (int i = 0; i < 4; i++)
+		state.v[i] = xxh_round(state.v[i], read64(stripe + 8*i));
+}
+
+uint64_t ContentHash::finish(const State &state, const unsigned char *tail, size_t tail_len, uint64_t total_len)
+{
+	uint64_t h;
+	if (total_len >= 32) {
+		h = rotl64(state.v[0], 1) + rotl64(state.v[1], 7) + rotl64(state.v[2], 12) + rotl64(state.v[3], 18);
+		for (int i = 0; i < 4; i++)
+			h = xxh_merge(h, state.v[i]);
+	} else
+		h = state.seed + prime5;
+	h += total_len;
+
+	size_t pos = 0;
+	for (; pos + 8 <= tail_len; pos += 8) {
+		h ^= xxh_round(0, read64(tail + pos));
+		h = rotl64(h, 27) * prime1 + prime4;
+	}
+	if (pos + 4 <= tail_len) {
+		h ^= uint64_t(read32(tail + pos)) * prime1;
+		h = rotl64(h, 23) * prime2 + prime3;
+		pos += 4;
+	}
+	for (; pos < tail_len; pos++) {
+		h ^= tail[pos] * prime5;
+		h = rotl64(h, 11) * prime1;
+	}
+
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	h *= prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+void ContentHash::update_bytes(const void *data, size_t len)
+{
+	auto p = static_cast<const unsigned char *>(data);
+	total_len += len;
+
+	if (buffer_len > 0) {
+		size_t n = std::min(len, sizeof(buffer) - buffer_len);
+		memcpy(buffer + buffer_len, p, n);
+		buffer_len += n;
+		p += n;
+		len -= n;
+		if (buffer_len < sizeof(buffer))
+			return;
+		consume(lanes[0], buffer);
+		consume(lanes[1], buffer);
+		buffer_len = 0;
+	}
+
+	for (; len >= 32; p += 32, len -= 32) {
+		consume(lanes[0], p);
+		consume(lanes[1], p);
+	}
+
+	memcpy(buffer, p, len);
+	buffer_len = len;
+}
+
+void ContentHash::update(uint64_t value)
+{
+	unsigned char bytes[8];
+	for (int i = 0; i < 8; i++)
+		bytes[i] = (value >> (8*i)) & 0xff;
+	update_bytes(bytes, sizeof(bytes));
+}
+
+void ContentHash::update(const std::string &str)
+{
+	update(uint64_t(str.size()));
+	update_bytes(str.data(), str.size());
+}
+
+void ContentHash::update(const RTLIL::Const &value)
+{
+	update(int(value.flags));
+	update(value.size());
+	std::vector<unsigned char> bits;
+	bits.reserve(value.size());
+	for (auto bit : value)
+		bits.push_back(bit);
+	update_bytes(bits.data(), bits.size());
+}
+
+void ContentHash::update(const RTLIL::SigSpec &sig)
+{
+	update(sig.size());
+	update(GetSize(sig.chunks()));
+	for (auto &chunk : sig.chunks()) {
+		if (chunk.wire == nullptr) {
+			update(RTLIL::Const(chunk.data));
+			continue;
+		}
+		update(chunk.wire->name);
+		update(chunk.offset);
+		update(chunk.width);
+	}
+}
+
+void ContentHash::update(const dict<RTLIL::IdString, RTLIL::Const> &attrs)
+{
+	update(GetSize(attrs));
+	for (auto &it : attrs) {
+		update(it.first);
+		update(it.second);
+	}
+}
+
+void ContentHash::update(const RTLIL::Module *module)
+{
+	update(module->name);
+	update(module->attributes);
+	update(GetSize(module->ports));
+	for (auto port : module->ports)
+		update(port);
+	update(GetSize(module->avail_parameters));
+	for (auto param : module->avail_parameters)
+		update(param);
+	update(module->parameter_default_values);
+
+	update(GetSize(module->wires_));
+	for (auto &it : module->wires_) {
+		const RTLIL::Wire *wire = it.second;
+		update(wire->name);
+		update(wire->attributes);
+		update(wire->width);
+		update(wire->start_offset);
+		update(wire->port_id);
+		update(wire->port_input);
+		update(wire->port_output);
+		update(wire->upto);
+		update(wire->is_signed);
+	}
+
+	update(GetSize(module->memories));
+	for (auto &it : module->memories) {
+		const RTLIL::Memory *mem = it.second;
+		update(mem->name);
+		update(mem->attributes);
+		update(mem->width);
+		update(mem->start_offset);
+		update(mem->size);
+	}
+
+	update(GetSize(module->cells_));
+	for (auto &it : module->cells_) {
+		const RTLIL::Cell *cell = it.second;
+		update(cell->name);
+		update(cell->type);
+		update(cell->attributes);
+		update(cell->parameters);
+		update(GetSize(cell->connections_));
+		for (auto &conn : cell->connections_) {
+			update(conn.first);
+			update(conn.second);
+		}
+	}
+
+	// processes are rare in the designs that are hashed, so their
+	// contents are hashed in their RTLIL form
+	update(GetSize(module->processes));
+	for (auto &it : module->processes) {
+		std::ostringstream f;
+		RTLIL_BACKEND::dump_proc(f, "", it.second);
+		update(f.str());
+	}
+
+	update(GetSize(module->connections()));
+	for (auto &conn : module->connections()) {
+		update(conn.first);
+		update(conn.second);
+	}
+}
+
+std::string ContentHash::hexdigest() const
+{
+	uint64_t h0 = finish(lanes[0], buffer, buffer_len, total_len);
+	uint64_t h1 = finish(lanes[1], buffer, buffer_len, total_len);
+	return stringf("%016llx%016llx", (unsigned long long)h0, (unsigned long long)h1);
+}
+
+std::string content_hash(const std::string &data)
+{
+	ContentHash hasher;
+	hasher.update_bytes(data.data(), data.size());
+	return hasher.hexdigest();
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,85 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include "kernel/rtlil.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Streaming content hash for cache keys, e.g. the names of files in an
+// on-disk cache. Unlike the Hasher of hashlib, the result only depends on
+// the hashed contents and not on the state of the process (IdString indices
+// or pointers), so it can be compared across runs.
+//
+// The digest is 128 bits wide, computed as two XXH64 streams with different
+// seeds. XXH64 is not a cryptographic hash, but it works on 32 bytes at a
+// time and is many times as fast as SHA-1, which matters when whole designs
+// or library files are hashed.
+//
+// The update() functions for strings, constants and signals include the
+// length of what they hash, so that a sequence of updates can not be
+// confused with a different sequence that has the same concatenation.
+struct ContentHash
+{
+	ContentHash();
+
+	// raw bytes, without a length prefix
+	void update_bytes(const void *data, size_t len);
+
+	void update(uint64_t value);
+	void update(int value) { update(uint64_t(int64_t(value))); }
+	void update(bool value) { update(uint64_t(value)); }
+	void update(const std::string &str);
+	void update(const char *str) { update(std::string(str)); }
+	void update(RTLIL::IdString id) { update(id.str()); }
+	void update(const RTLIL::Const &value);
+	void update(const RTLIL::SigSpec &sig);
+	void update(const dict<RTLIL::IdString, RTLIL::Const> &attrs);
+
+	// the complete contents of a module: ports, attributes, parameters,
+	// wires, memories, cells, processes and connections, in the order in
+	// which they are stored
+	void update(const RTLIL::Module *module);
+
+	// 32 hex digits
+	std::string hexdigest() const;
+
+private:
+	struct State {
+		uint64_t v[4];
+		uint64_t seed;
+	};
+	State lanes[2];
+	unsigned char buffer[32];
+	size_t buffer_len;
+	uint64_t total_len;
+
+	static void init(State &state, uint64_t seed);
+	static void consume(State &state, const unsigned char *stripe);
+	static uint64_t finish(const State &state, const unsigned char *tail, size_t tail_len, uint64_t total_len);
+};
+
+// hexdigest() of the bytes of `data`
+std::string content_hash(const std::string &data);
+
+YOSYS_NAMESPACE_END
+
+#endif
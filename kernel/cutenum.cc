@@ -0,0 +1,350 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/cutenum.h"
+#include "kernel/register.h"
+
+#include <algorithm>
+
+YOSYS_NAMESPACE_BEGIN
+
+uint64_t tt_var(int var)
+{
+	static const uint64_t vars[6] = {
+		0xaaaaaaaaaaaaaaaaULL, 0xccccccccccccccccULL, 0xf0f0f0f0f0f0f0f0ULL,
+		0xff00ff00ff00ff00ULL, 0xffff0000ffff0000ULL, 0xffffffff00000000ULL,
+	};
+	log_assert(var >= 0 && var < 6);
+	return vars[var];
+}
+
+uint64_t tt_mask(int nvars)
+{
+	log_assert(nvars >= 0 && nvars <= 6);
+	return nvars == 6 ? ~uint64_t(0) : (uint64_t(1) << (1 << nvars)) - 1;
+}
+
+uint64_t tt_permute(uint64_t tt, int nvars, const std::vector<int> &varmap)
+{
+	log_assert(GetSize(varmap) == nvars);
+	uint64_t ret = 0;
+	for (int j = 0; j < 1 << nvars; j++) {
+		int m = 0;
+		for (int l = 0; l < nvars; l++)
+			if (j & 1 << l)
+				m |= 1 << varmap[l];
+		if ((tt >> m) & 1)
+			ret |= uint64_t(1) << j;
+	}
+	return ret;
+}
+
+uint64_t tt_negate_input(uint64_t tt, int nvars, int var)
+{
+	int shift = 1 << var;
+	uint64_t v = tt_var(var);
+	return (((tt & v) >> shift) | ((tt & ~v) << shift)) & tt_mask(nvars);
+}
+
+uint64_t tt_p_canonical(uint64_t tt, int nvars)
+{
+	std::vector<int> map;
+	for (int j = 0; j < nvars; j++)
+		map.push_back(j);
+
+	uint64_t repr = ~uint64_t(0);
+	do {
+		repr = std::min(repr, tt_permute(tt, nvars, map));
+	} while (std::next_permutation(map.begin(), map.end()));
+	return repr;
+}
+
+uint64_t tt_npn_canonical(uint64_t tt, int nvars)
+{
+	uint64_t repr = ~uint64_t(0);
+	for (uint64_t out : {tt, ~tt & tt_mask(nvars)})
+		for (int neg = 0; neg < 1 << nvars; neg++) {
+			uint64_t negated = out;
+			for (int v = 0; v < nvars; v++)
+				if (neg & 1 << v)
+					negated = tt_negate_input(negated, nvars, v);
+			repr = std::min(repr, tt_p_canonical(negated, nvars));
+		}
+	return repr;
+}
+
+CutEnum::CutEnum(const SigMap &sigmap, int max_leaves, int max_cuts) :
+		sigmap(sigmap), max_leaves(max_leaves), max_cuts(max_cuts)
+{
+	log_assert(max_leaves >= 1 && max_leaves <= 6);
+}
+
+bool CutEnum::supported(RTLIL::IdString type)
+{
+	return type.in(ID($_BUF_), ID($_NOT_), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_),
+			ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_NMUX_),
+			ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_));
+}
+
+int CutEnum::add_node(RTLIL::SigBit bit)
+{
+	auto it = bit_to_node.find(bit);
+	if (it != bit_to_node.end())
+		return it->second;
+	int node = GetSize(nodes);
+	bit_to_node[bit] = node;
+	nodes.emplace_back();
+	nodes.back().bit = bit;
+	return node;
+}
+
+int CutEnum::node(RTLIL::SigBit bit) const
+{
+	auto it = bit_to_node.find(sigmap(bit));
+	return it == bit_to_node.end() ? -1 : it->second;
+}
+
+bool CutEnum::add_cell(RTLIL::Cell *cell)
+{
+	if (!supported(cell->type))
+		return false;
+
+	RTLIL::SigBit y = sigmap(cell->getPort(ID::Y));
+	if (y.wire == nullptr)
+		return false;
+	int y_node = add_node(y);
+	if (nodes[y_node].cell != nullptr)
+		return false;
+
+	std::vector<int> fanins;
+	for (auto port : {ID::A, ID::B, ID::S, ID::C, ID::D}) {
+		if (!cell->hasPort(port))
+			continue;
+		RTLIL::SigBit bit = sigmap(cell->getPort(port));
+		if (bit.wire == nullptr)
+			fanins.push_back(bit == State::S1 ? const1 : const0);
+		else
+			fanins.push_back(add_node(bit));
+	}
+
+	nodes[y_node].cell = cell;
+	nodes[y_node].type = cell->type;
+	nodes[y_node].fanins = std::move(fanins);
+	return true;
+}
+
+void CutEnum::compute_levels()
+{
+	// 0: not visited, 1: on the stack, 2: done
+	std::vector<char> state(nodes.size());
+	std::vector<std::pair<int, int>> stack;
+
+	for (int root = 0; root < GetSize(nodes); root++)
+	{
+		if (state[root])
+			continue;
+		state[root] = 1;
+		stack.emplace_back(root, 0);
+
+		while (!stack.empty())
+		{
+			int node = stack.back().first;
+			int &next = stack.back().second;
+			const auto &fanins = nodes[node].fanins;
+
+			if (next < GetSize(fanins)) {
+				int fanin = fanins[next++];
+				if (fanin >= 0 && state[fanin] == 0) {
+					state[fanin] = 1;
+					stack.emplace_back(fanin, 0);
+				}
+				continue;
+			}
+
+			// fanins still on the stack close a loop and are left out
+			int level = 0;
+			if (nodes[node].cell != nullptr) {
+				level = 1;
+				for (int fanin : fanins)
+					if (fanin >= 0 && state[fanin] == 2)
+						level = std::max(level, nodes[fanin].level + 1);
+			}
+			nodes[node].level = level;
+			state[node] = 2;
+			stack.pop_back();
+		}
+	}
+}
+
+static uint64_t eval_gate(RTLIL::IdString type, const uint64_t *in)
+{
+	uint64_t a = in[0], b = in[1], c = in[2], d = in[3];
+	if (type == ID($_BUF_))    return a;
+	if (type == ID($_NOT_))    return ~a;
+	if (type == ID($_AND_))    return a & b;
+	if (type == ID($_NAND_))   return ~(a & b);
+	if (type == ID($_OR_))     return a | b;
+	if (type == ID($_NOR_))    return ~(a | b);
+	if (type == ID($_XOR_))    return a ^ b;
+	if (type == ID($_XNOR_))   return ~(a ^ b);
+	if (type == ID($_ANDNOT_)) return a & ~b;
+	if (type == ID($_ORNOT_))  return a | ~b;
+	// the inputs of muxes are in the order A, B, S
+	if (type == ID($_MUX_))    return (c & b) | (~c & a);
+	if (type == ID($_NMUX_))   return ~((c & b) | (~c & a));
+	if (type == ID($_AOI3_))   return ~((a & b) | c);
+	if (type == ID($_OAI3_))   return ~((a | b) & c);
+	if (type == ID($_AOI4_))   return ~((a & b) | (c & d));
+	if (type == ID($_OAI4_))   return ~((a | b) & (c | d));
+	log_abort();
+}
+
+// the truth table of `cut` over the inputs `leaves`, a superset of its leaves
+static uint64_t expand_truth(const CutEnum::Cut &cut, const std::vector<int> &leaves)
+{
+	std::vector<int> pos;
+	for (int leaf : cut.leaves)
+		pos.push_back(std::lower_bound(leaves.begin(), leaves.end(), leaf) - leaves.begin());
+
+	uint64_t ret = 0;
+	for (int j = 0; j < 1 << GetSize(leaves); j++) {
+		int m = 0;
+		for (int k = 0; k < GetSize(pos); k++)
+			if (j & 1 << pos[k])
+				m |= 1 << k;
+		if ((cut.truth >> m) & 1)
+			ret |= uint64_t(1) << j;
+	}
+	return ret;
+}
+
+void CutEnum::enumerate(int node)
+{
+	const Node &n = nodes[node];
+	std::vector<Cut> &result = node_cuts[node];
+	result.clear();
+	result.push_back(Cut{{node}, tt_var(0) & tt_mask(1), 0});
+	if (n.cell == nullptr)
+		return;
+
+	// the cuts each fanin can contribute, constants contribute no leaves
+	std::vector<const Cut*> trivial_cuts;
+	std::vector<std::vector<const Cut*>> fanin_cuts;
+	Cut const_cuts[2] = {Cut{{}, 0, 0}, Cut{{}, 1, 0}};
+	std::vector<Cut> trivial_storage;
+	trivial_storage.reserve(n.fanins.size());
+	for (int fanin : n.fanins) {
+		fanin_cuts.emplace_back();
+		if (fanin < 0) {
+			fanin_cuts.back().push_back(&const_cuts[fanin == const1]);
+		} else if (nodes[fanin].level < n.level) {
+			for (auto &cut : node_cuts[fanin])
+				fanin_cuts.back().push_back(&cut);
+		} else {
+			trivial_storage.push_back(Cut{{fanin}, tt_var(0) & tt_mask(1), 0});
+			fanin_cuts.back().push_back(&trivial_storage.back());
+		}
+	}
+
+	std::vector<Cut> candidates;
+	std::vector<const Cut*> chosen(fanin_cuts.size());
+	std::vector<std::vector<int>> unions(fanin_cuts.size() + 1);
+
+	std::function<void(int)> combine = [&](int idx) {
+		if (idx == GetSize(fanin_cuts)) {
+			const std::vector<int> &leaves = unions[idx];
+			uint64_t in[4] = {0, 0, 0, 0};
+			int depth = 0;
+			for (int i = 0; i < GetSize(chosen); i++) {
+				in[i] = expand_truth(*chosen[i], leaves);
+				depth = std::max(depth, chosen[i]->depth);
+			}
+			uint64_t truth = eval_gate(n.type, in) & tt_mask(GetSize(leaves));
+			candidates.push_back(Cut{leaves, truth, depth + 1});
+			return;
+		}
+		for (auto cut : fanin_cuts[idx]) {
+			std::vector<int> &merged = unions[idx + 1];
+			merged.clear();
+			std::set_union(unions[idx].begin(), unions[idx].end(), cut->leaves.begin(), cut->leaves.end(),
+					std::back_inserter(merged));
+			if (GetSize(merged) > max_leaves)
+				continue;
+			chosen[idx] = cut;
+			combine(idx + 1);
+		}
+	};
+	combine(0);
+
+	// the same leaves always give the same function, keep the shallowest
+	std::sort(candidates.begin(), candidates.end(), [](const Cut &a, const Cut &b) {
+		if (a.leaves.size() != b.leaves.size())
+			return a.leaves.size() < b.leaves.size();
+		if (a.leaves != b.leaves)
+			return a.leaves < b.leaves;
+		return a.depth < b.depth;
+	});
+
+	std::vector<Cut> kept;
+	for (auto &cut : candidates) {
+		bool dominated = false;
+		for (auto &other : kept)
+			if (std::includes(cut.leaves.begin(), cut.leaves.end(), other.leaves.begin(), other.leaves.end())) {
+				dominated = true;
+				break;
+			}
+		if (!dominated)
+			kept.push_back(std::move(cut));
+	}
+
+	std::stable_sort(kept.begin(), kept.end(), [](const Cut &a, const Cut &b) {
+		if (a.leaves.size() != b.leaves.size())
+			return a.leaves.size() < b.leaves.size();
+		return a.depth < b.depth;
+	});
+	if (GetSize(kept) > max_cuts)
+		kept.resize(max_cuts);
+
+	for (auto &cut : kept)
+		result.push_back(std::move(cut));
+}
+
+void CutEnum::run(RTLIL::Design *design)
+{
+	compute_levels();
+
+	std::vector<std::vector<int>> levels;
+	for (int node = 0; node < GetSize(nodes); node++) {
+		int level = nodes[node].level;
+		if (level >= GetSize(levels))
+			levels.resize(level + 1);
+		levels[level].push_back(node);
+	}
+
+	node_cuts.clear();
+	node_cuts.resize(nodes.size());
+
+	// every node only reads the cuts of nodes of lower levels; small levels
+	// are not worth the threads
+	for (auto &level : levels)
+		Pass::parallel_for(design, GetSize(level), [&](int i) { enumerate(level[i]); },
+				GetSize(level) < 64 ? 1 : 0);
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,116 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef CUTENUM_H
+#define CUTENUM_H
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Truth tables of functions of up to 6 inputs, as 64-bit words: bit j is the
+// value of the function for the input assignment j, where input v is set iff
+// bit v of j is set. Bits at and above 1 << nvars are zero.
+
+// the truth table of input `var`
+uint64_t tt_var(int var);
+// all valid bits of a truth table with `nvars` inputs
+uint64_t tt_mask(int nvars);
+// the function with input n renamed to varmap[n]
+uint64_t tt_permute(uint64_t tt, int nvars, const std::vector<int> &varmap);
+// the function with input `var` inverted
+uint64_t tt_negate_input(uint64_t tt, int nvars, int var);
+// the smallest truth table among all input permutations (P class)
+uint64_t tt_p_canonical(uint64_t tt, int nvars);
+// the smallest truth table among all input permutations, input inversions
+// and output inversions (NPN class); exhaustive, so it is meant for few
+// calls or few inputs
+uint64_t tt_npn_canonical(uint64_t tt, int nvars);
+
+// Enumerates the cuts of a netlist of fine-grained gates ($_AND_, $_MUX_,
+// $_AOI3_, ...) bottom up, together with their truth tables. A cut of a node
+// is a set of at most `max_leaves` nodes such that every path from an input
+// of the netlist to the node passes through one of them.
+//
+// The cuts of a node are merged from the cuts of the inputs of its driver,
+// and cuts that contain another cut of the same node are dropped. Of the
+// remaining ones, the `max_cuts` smallest (first by the number of leaves,
+// then by depth) are kept. Nodes of the same level are done in parallel.
+// Gates in combinational loops are treated like inputs by the gates after
+// them on the loop.
+struct CutEnum
+{
+	struct Cut {
+		// node indices, in ascending order
+		std::vector<int> leaves;
+		// with input v of the truth table being leaves[v]
+		uint64_t truth;
+		// the number of gates on the longest path from a leaf
+		int depth;
+	};
+
+	CutEnum(const SigMap &sigmap, int max_leaves = 4, int max_cuts = 32);
+
+	static bool supported(RTLIL::IdString type);
+
+	// Adds a cell of a supported type as the driver of its (mapped) Y output,
+	// returns false for other cells and for already driven outputs.
+	bool add_cell(RTLIL::Cell *cell);
+
+	// Enumerates the cuts of all nodes, with `design` for the thread limit.
+	void run(RTLIL::Design *design);
+
+	int size() const { return GetSize(nodes); }
+	// -1 for bits not used by the added cells
+	int node(RTLIL::SigBit bit) const;
+	RTLIL::SigBit bit(int node) const { return nodes[node].bit; }
+	// nullptr for inputs of the netlist
+	RTLIL::Cell *driver(int node) const { return nodes[node].cell; }
+
+	// The cuts of the node after run(), the first one is the trivial cut
+	// with the node as the only leaf.
+	const std::vector<Cut> &cuts(int node) const { return node_cuts[node]; }
+
+private:
+	// fanin values of constant inputs
+	static const int const0 = -1, const1 = -2;
+
+	struct Node {
+		RTLIL::SigBit bit;
+		RTLIL::Cell *cell = nullptr;
+		RTLIL::IdString type;
+		std::vector<int> fanins;
+		int level = 0;
+	};
+
+	const SigMap &sigmap;
+	int max_leaves, max_cuts;
+	dict<RTLIL::SigBit, int> bit_to_node;
+	std::vector<Node> nodes;
+	std::vector<std::vector<Cut>> node_cuts;
+
+	int add_node(RTLIL::SigBit bit);
+	void compute_levels();
+	void enumerate(int node);
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
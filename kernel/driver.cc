@@ -170,6 +170,8 @@ void yosys_atexit()
 		free(hist_list);
 #endif
 #endif
+
+	Pass::close_trace_json();
 }
 
 #if defined(__OpenBSD__)
@@ -199,13 +201,16 @@ int main(int argc, char **argv)
 	std::string depsfile = "";
 	std::string topmodule = "";
 	std::string perffile = "";
+	std::string tracefile = "";
 	bool scriptfile_tcl = false;
 	bool scriptfile_python = false;
 	bool print_banner = true;
 	bool print_stats = true;
 	bool call_abort = false;
 	bool timing_details = false;
+	int profile_frequency = 0;
 	bool run_shell = true;
+	std::string server_socket;
 	bool run_tcl_shell = false;
 	bool mode_v = false;
 	bool mode_q = false;
@@ -237,12 +242,20 @@ int main(int argc, char **argv)
 			cxxopts::value<std::vector<std::string>>(), "<plugin>")
 		("D,define", "set the specified Verilog define to <value> if supplied via command \"read -define\"",
 			cxxopts::value<std::vector<std::string>>(), "<define>[=<value>]")
+		("j,jobs", "use up to <N> threads in passes that can process modules in parallel. " \
+					"This can be overridden per design with \"scratchpad -set parallel.threads <N>\"",
+			cxxopts::value<int>(), "<N>")
 		("S,synth", "shortcut for calling the \"synth\" command, a default script for transforming " \
 					"the Verilog input to a gate-level netlist. For example: " \
 					"yosys -o output.blif -S input.v " \
 					"For more complex synthesis jobs it is recommended to use the read_* and write_* " \
 					"commands in a script file instead of specifying input and output files on the " \
 					"command line.")
+#ifndef YOSYS_DISABLE_SPAWN
+		("server", "run the scripts received on the Unix domain <socket> as separate jobs, " \
+				   "after the other commands were executed (see 'help server' for details)",
+			cxxopts::value<std::string>(), "<socket>")
+#endif // YOSYS_DISABLE_SPAWN
 		("H", "print the command list")
 		("h,help", "print this help message. If given, print help for <command>.",
 			cxxopts::value<std::string>(), "[<command>]")
@@ -258,11 +271,13 @@ int main(int argc, char **argv)
                       "Implies -q for everything except the 'End of script.' message.",
 			cxxopts::value<int>(), "<level>")
 		("t,timestamp", "annotate all log messages with a time stamp")
-		("d,detailed-timing", "print more detailed timing stats at exit")
+		("d,detailed-timing", "print more detailed timing and memory stats at exit")
 		("l,logfile", "write log messages to <logfile>",
 			cxxopts::value<std::vector<std::string>>(), "<logfile>")
 		("L,line-buffered-logfile", "like -l but open <logfile> in line buffered mode",
 			cxxopts::value<std::vector<std::string>>(), "<logfile>")
+		("async-log", "write the -l log files from a background thread, so that chatty passes " \
+					  "don't wait for the disk")
 		("o,outfile", "write the design to <outfile> on exit",
 			cxxopts::value<std::string>(), "<outfile>")
 		("P,dump-design", "dump the design when printing the specified log header to a file. " \
@@ -290,6 +305,11 @@ int main(int argc, char **argv)
 			cxxopts::value<std::vector<std::string>>(), "<feature>")
 		("g,debug", "globally enable debug log messages")
 		("perffile", "write a JSON performance log to <perffile>", cxxopts::value<std::string>(), "<perffile>")
+		("trace-json", "write a Chrome/Perfetto trace of all pass calls to <tracefile>",
+			cxxopts::value<std::string>(), "<tracefile>")
+		("profile", "sample the running pass and module <hz> times per second of CPU time and " \
+					"print where the time was spent at exit",
+			cxxopts::value<int>()->implicit_value("1000"), "<hz>")
 	;
 
 	options.parse_positional({"infile"});
@@ -348,6 +368,12 @@ int main(int argc, char **argv)
 			passes_commands.insert(passes_commands.end(), cmds.begin(), cmds.end());
 			run_shell = false;
 		}
+#ifndef YOSYS_DISABLE_SPAWN
+		if (result.count("server")) {
+			server_socket = result["server"].as<std::string>();
+			run_shell = false;
+		}
+#endif
 		if (result.count("o")) {
 			output_filename = result["o"].as<std::string>();
 			run_shell = false;
@@ -404,6 +430,7 @@ int main(int argc, char **argv)
 		}
 		if (result.count("r")) topmodule = result["r"].as<std::string>();
 		if (result.count("D")) vlog_defines = result["D"].as<std::vector<std::string>>();
+		if (result.count("j")) yosys_threads = std::max(result["j"].as<int>(), 1);
 		if (result.count("P")) {
 			auto dump_args = result["P"].as<std::vector<std::string>>();
 			for (const auto& arg : dump_args) {
@@ -428,11 +455,15 @@ int main(int argc, char **argv)
 			}
 		}
 		if (result.count("E")) depsfile = result["E"].as<std::string>();
+		if (result.count("async-log"))
+			log_async_begin();
 		if (result.count("x")) {
 			auto ignores = result["x"].as<std::vector<std::string>>();
 			log_experimentals_ignored.insert(ignores.begin(), ignores.end());
 		}
 		if (result.count("perffile")) perffile = result["perffile"].as<std::string>();
+		if (result.count("trace-json")) tracefile = result["trace-json"].as<std::string>();
+		if (result.count("profile")) profile_frequency = result["profile"].as<int>();
 		if (result.count("infile")) {
 			frontend_files = result["infile"].as<std::vector<std::string>>();
 		}
@@ -518,6 +549,12 @@ int main(int argc, char **argv)
 #endif
 	log_error_atexit = yosys_atexit;
 
+	if (!tracefile.empty())
+		Pass::open_trace_json(tracefile);
+
+	if (profile_frequency)
+		Pass::start_profiler(profile_frequency);
+
 	for (auto &fn : plugin_filenames)
 		load_plugin(fn, {});
 
@@ -599,6 +636,9 @@ int main(int argc, char **argv)
 	for (auto it = passes_commands.begin(); it != passes_commands.end(); it++)
 		run_pass(*it);
 
+	if (!server_socket.empty())
+		Pass::call(yosys_design, std::vector<std::string>{"server", server_socket});
+
 	if (run_tcl_shell) {
 #ifdef YOSYS_ENABLE_TCL
 		yosys_tcl_activate_repl();
@@ -641,6 +681,11 @@ int main(int argc, char **argv)
 		log_error("Unexpected warnings found: %d unique messages, %d total, %d expected\n", GetSize(log_warnings),
 					log_warnings_count, log_warnings_count - log_warnings_count_noexpect);
 
+	if (profile_frequency) {
+		Pass::stop_profiler();
+		Pass::print_profile(timing_details ? 100 : 30);
+	}
+
 	if (print_stats)
 	{
 		std::string hash = log_hasher->final().substr(0, 10);
@@ -724,6 +769,27 @@ int main(int argc, char **argv)
 			}
 			log("%s\n", out_count ? "" : " no commands executed");
 		}
+
+		std::set<tuple<int64_t, std::string>> memdat;
+		for (auto &it : pass_register)
+			if (it.second->call_counter && it.second->peak_rss_bytes)
+				memdat.insert(make_tuple(it.second->peak_rss_bytes, it.first));
+
+		if (timing_details && !memdat.empty())
+		{
+			log("Memory use (peak RSS, RSS and heap growth, excluding nested passes):\n");
+			for (auto it = memdat.rbegin(); it != memdat.rend(); it++) {
+				Pass *pass = pass_register.at(std::get<1>(*it));
+				log("%10.2f MB %+10.2f MB %+10.2f MB %s\n", std::get<0>(*it) / (1024.0 * 1024.0),
+						pass->rss_delta_bytes / (1024.0 * 1024.0), pass->heap_delta_bytes / (1024.0 * 1024.0),
+						std::get<1>(*it).c_str());
+			}
+		}
+		else if (!memdat.empty())
+		{
+			log("Peak memory: %.2f MB in %s\n", std::get<0>(*memdat.rbegin()) / (1024.0 * 1024.0),
+					std::get<1>(*memdat.rbegin()).c_str());
+		}
 		if(!perffile.empty())
 		{
 			FILE *f = fopen(perffile.c_str(), "wt");
@@ -740,8 +806,16 @@ int main(int argc, char **argv)
 				if (!first)
 					fprintf(f, ",");
 				fprintf(f, "\n	\"%s\": {\n", std::get<2>(*it).c_str());
+				Pass *pass = pass_register.at(std::get<2>(*it));
 				fprintf(f, "	  \"runtime_ns\": %" PRIu64 ",\n", std::get<0>(*it));
-				fprintf(f, "	  \"num_calls\": %u\n", std::get<1>(*it));
+				fprintf(f, "	  \"num_calls\": %u,\n", std::get<1>(*it));
+				fprintf(f, "	  \"peak_rss_bytes\": %" PRId64 ",\n", pass->peak_rss_bytes);
+				fprintf(f, "	  \"rss_delta_bytes\": %" PRId64 ",\n", pass->rss_delta_bytes);
+				fprintf(f, "	  \"heap_delta_bytes\": %" PRId64 ",\n", pass->heap_delta_bytes);
+				fprintf(f, "	  \"kernel_stats\": {");
+				for (int i = 0; i < KernelStats::NUM_COUNTERS; i++)
+					fprintf(f, "%s\"%s\": %" PRId64, i ? ", " : " ", KernelStats::names[i], pass->kernel_stats_delta[i]);
+				fprintf(f, " }\n");
 				fprintf(f, "	}");
 				first = false;
 			}
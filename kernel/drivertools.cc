@@ -18,6 +18,7 @@
  */
 
 #include "kernel/drivertools.h"
+#include "kernel/register.h"
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -556,6 +557,47 @@ DriverMap::BitMode DriverMap::bit_mode(DriveBit const &bit)
 	}
 }
 
+DriverMap::BitMode DriverMap::id_mode(DriveBitId id)
+{
+	if (id.id < 0)
+		return BitMode::NONE;
+	if (id.id <= (int)State::Sm)
+		return bit_mode(DriveBit((State) id.id));
+	return id_modes[id.id];
+}
+
+std::pair<DriverMap::DriveBitId, bool> DriverMap::allocate_wire(Wire *wire)
+{
+	int offset = next_offset;
+	auto insertion = wire_offsets.emplace(wire, offset);
+	if (insertion.second) {
+		if (wire->width == 1)
+			isolated_drive_bits.emplace(offset, DriveBitWire(wire, 0));
+		else
+			drive_bits.emplace(offset, DriveBitWire(wire, 0));
+		next_offset += wire->width;
+		id_modes.resize(next_offset, BitMode::NONE);
+	}
+	return {insertion.first->second, insertion.second};
+}
+
+std::pair<DriverMap::DriveBitId, bool> DriverMap::allocate_port(Cell *cell, IdString const &port)
+{
+	auto key = std::make_pair(cell, port);
+	int offset = next_offset;
+	auto insertion = port_offsets.emplace(key, offset);
+	if (insertion.second) {
+		int width = cell->connections().at(port).size();
+		if (width == 1 && offset == 0)
+			isolated_drive_bits.emplace(offset, DriveBitPort(cell, port, 0));
+		else
+			drive_bits.emplace(offset, DriveBitPort(cell, port, 0));
+		next_offset += width;
+		id_modes.resize(next_offset, BitMode::NONE);
+	}
+	return {insertion.first->second, insertion.second};
+}
+
 DriverMap::DriveBitId DriverMap::id_from_drive_bit(DriveBit const &bit)
 {
 	switch (bit.type())
@@ -566,33 +608,17 @@ DriverMap::DriveBitId DriverMap::id_from_drive_bit(DriveBit const &bit)
 			return (int)bit.constant();
 		case DriveType::WIRE: {
 			auto const &wire_bit = bit.wire();
-			int offset = next_offset;
-			auto insertion = wire_offsets.emplace(wire_bit.wire, offset);
-			if (insertion.second) {
-				if (wire_bit.wire->width == 1) {
-					log_assert(wire_bit.offset == 0);
-					isolated_drive_bits.emplace(offset, bit);
-				} else
-					drive_bits.emplace(offset, DriveBitWire(wire_bit.wire, 0));
-				next_offset += wire_bit.wire->width;
-			}
-			return insertion.first->second.id + wire_bit.offset;
+			auto allocation = allocate_wire(wire_bit.wire);
+			if (allocation.second)
+				std::fill(id_modes.begin() + allocation.first.id, id_modes.end(), bit_mode(bit));
+			return allocation.first.id + wire_bit.offset;
 		}
 		case DriveType::PORT: {
 			auto const &port_bit = bit.port();
-			auto key = std::make_pair(port_bit.cell, port_bit.port);
-			int offset = next_offset;
-			auto insertion = port_offsets.emplace(key, offset);
-			if (insertion.second) {
-				int width = port_bit.cell->connections().at(port_bit.port).size();
-				if (width == 1 && offset == 0) {
-					log_assert(port_bit.offset == 0);
-					isolated_drive_bits.emplace(offset, bit);
-				} else
-					drive_bits.emplace(offset, DriveBitPort(port_bit.cell, port_bit.port, 0));
-				next_offset += width;
-			}
-			return insertion.first->second.id + port_bit.offset;
+			auto allocation = allocate_port(port_bit.cell, port_bit.port);
+			if (allocation.second)
+				std::fill(id_modes.begin() + allocation.first.id, id_modes.end(), bit_mode(bit));
+			return allocation.first.id + port_bit.offset;
 		}
 		default:
 			log_assert(false && "unsupported DriveType in DriverMap");
@@ -655,28 +681,76 @@ void DriverMap::add(Module *module)
 	for (auto const &conn : module->connections())
 		add(conn.first, conn.second);
 
-	for (auto cell : module->cells())
-		for (auto const &conn : cell->connections())
-			add_port(cell, conn.first, conn.second);
+	// Allocate the ids of all wires and cell ports up front, which leaves
+	// only lookups for the parallel part: classifying the new ranges and
+	// mapping the bits connected to each cell port to ids. The connections
+	// are then added in the same order as with add_port(), so the union-find
+	// and the connection graphs end up the same for any number of threads.
+	std::vector<Wire*> new_wires;
+	for (auto wire : module->wires())
+		if (allocate_wire(wire).second)
+			new_wires.push_back(wire);
+
+	std::vector<Cell*> cells = module->cells().to_vector();
+	std::vector<bool> new_ports;
+	std::vector<int> cell_ports(GetSize(cells) + 1);
+	for (int i = 0; i < GetSize(cells); i++) {
+		cell_ports[i] = GetSize(new_ports);
+		for (auto const &conn : cells[i]->connections())
+			new_ports.push_back(allocate_port(cells[i], conn.first).second);
+	}
+	cell_ports[GetSize(cells)] = GetSize(new_ports);
+
+	int threads = module->design ? Pass::parallel_threads(module->design) : 1;
+
+	Pass::parallel_for(module->design, GetSize(new_wires), [&](int i) {
+		Wire *wire = new_wires[i];
+		int first = wire_offsets.at(wire).id;
+		std::fill(id_modes.begin() + first, id_modes.begin() + first + wire->width, bit_mode(DriveBitWire(wire, 0)));
+	}, threads);
+
+	// for each cell, pairs of the ids of a connected bit and of the port bit
+	std::vector<std::vector<std::pair<DriveBitId, DriveBitId>>> cell_conns(GetSize(cells));
+	Pass::parallel_for(module->design, GetSize(cells), [&](int i) {
+		Cell *cell = cells[i];
+		auto &conns = cell_conns[i];
+		int port_index = cell_ports[i];
+		for (auto const &conn : cell->connections()) {
+			int first = port_offsets.at(std::make_pair(cell, conn.first)).id;
+			if (new_ports[port_index++])
+				std::fill(id_modes.begin() + first, id_modes.begin() + first + GetSize(conn.second),
+						bit_mode(DriveBitPort(cell, conn.first, 0)));
+			int offset = 0;
+			for (auto const &bit : conn.second) {
+				DriveBitId bit_id = bit.wire ? DriveBitId(wire_offsets.at(bit.wire).id + bit.offset) : DriveBitId((int)bit.data);
+				conns.emplace_back(bit_id, first + offset++);
+			}
+		}
+	}, threads);
+
+	for (auto &conns : cell_conns) {
+		for (auto const &it : conns)
+			add_ids(it.first, it.second);
+		decltype(cell_conns)::value_type().swap(conns);
+	}
 }
 
 // Add a single bit connection to the driver map.
 void DriverMap::add(DriveBit const &a, DriveBit const &b)
 {
-	DriveBitId a_id = id_from_drive_bit(a);
-	DriveBitId b_id = id_from_drive_bit(b);
-
-	DriveBitId orig_a_id = a_id;
-	DriveBitId orig_b_id = b_id;
+	add_ids(id_from_drive_bit(a), id_from_drive_bit(b));
+}
 
+void DriverMap::add_ids(DriveBitId a_id, DriveBitId b_id)
+{
 	a_id = same_driver.find(a_id);
 	b_id = same_driver.find(b_id);
 
 	if (a_id == b_id)
 		return;
 
-	BitMode a_mode = bit_mode(orig_a_id == a_id ? a : drive_bit_from_id(a_id));
-	BitMode b_mode = bit_mode(orig_b_id == b_id ? b : drive_bit_from_id(b_id));
+	BitMode a_mode = id_mode(a_id);
+	BitMode b_mode = id_mode(b_id);
 
 	// If either bit is just a wire that we don't need to keep, merge and
 	// use the other end as representative bit.
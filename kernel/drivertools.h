@@ -1193,16 +1193,33 @@ private:
 		DRIVER = 5, // Drives a value
 	};
 
+	// The mode of each allocated DriveBitId, indexed by id. The mode only
+	// depends on the wire or cell port, so this is filled in when the id
+	// range is allocated and lets `add` classify the representative of a bit
+	// without mapping it back to a DriveBit.
+	std::vector<BitMode> id_modes;
+
 	BitMode bit_mode(DriveBit const &bit);
+	BitMode id_mode(DriveBitId id);
 	DriveBitId id_from_drive_bit(DriveBit const &bit);
 	DriveBit drive_bit_from_id(DriveBitId id);
 
+	// Allocate the id range of a wire or cell port if it has none yet. The
+	// modes of a new range are left as BitMode::NONE for the caller to set.
+	std::pair<DriveBitId, bool> allocate_wire(Wire *wire);
+	std::pair<DriveBitId, bool> allocate_port(Cell *cell, IdString const &port);
+
+	void add_ids(DriveBitId a_id, DriveBitId b_id);
+
 	void connect_directed_merge(DriveBitId driven_id, DriveBitId driver_id);
 	void connect_directed_buffer(DriveBitId driven_id, DriveBitId driver_id);
 	void connect_undirected(DriveBitId a_id, DriveBitId b_id);
 
 public:
 
+	// Add all connections of a module. The cell ports are classified and
+	// mapped to ids with up to Pass::parallel_threads() threads, the
+	// resulting map does not depend on the number of threads.
 	void add(Module *module);
 
 	// Add a single bit connection to the driver map.
@@ -771,3 +771,74 @@ void FfData::flip_bits(const pool<int> &bits) {
 
 	sig_q = new_q;
 }
+
+FfCache::FfCache(RTLIL::Module *module) : module(module)
+{
+	initvals.cached = true;
+	module->monitors.insert(this);
+}
+
+FfCache::~FfCache()
+{
+	module->monitors.erase(this);
+}
+
+FfCache &FfCache::cached(RTLIL::Module *module)
+{
+	FfCache *cache = static_cast<FfCache*>(module->cached_ffs_);
+	if (cache == nullptr) {
+		cache = new FfCache(module);
+		module->cached_ffs_ = cache;
+	}
+	if (cache->reload || cache->reload_wires != GetSize(module->wires_) ||
+			cache->reload_init_generation != module->init_generation_) {
+		cache->sigmap.set(module);
+		cache->initvals.set(&cache->sigmap, module);
+		cache->reload = false;
+		cache->reload_wires = GetSize(module->wires_);
+		cache->reload_init_generation = module->init_generation_;
+	}
+	return *cache;
+}
+
+FfData FfCache::ff(RTLIL::Cell *cell)
+{
+	auto it = ffs.find(cell);
+	if (it == ffs.end() || it->second.first != cell->type) {
+		FfData ff(&initvals, cell);
+		ffs[cell] = std::make_pair(cell->type, ff);
+		return ff;
+	}
+
+	// the init values, name and attributes may have changed without
+	// notification
+	FfData ff = it->second.second;
+	ff.name = cell->name;
+	ff.attributes = cell->attributes;
+	ff.val_init = initvals(ff.sig_q);
+	return ff;
+}
+
+void FfCache::notify_connect(RTLIL::Cell *cell, const RTLIL::IdString&, const RTLIL::SigSpec&, const RTLIL::SigSpec&)
+{
+	ffs.erase(cell);
+}
+
+void FfCache::notify_connect(RTLIL::Module *mod, const RTLIL::SigSig&)
+{
+	log_assert(module == mod);
+	reload = true;
+}
+
+void FfCache::notify_connect(RTLIL::Module *mod, const std::vector<RTLIL::SigSig>&)
+{
+	log_assert(module == mod);
+	reload = true;
+}
+
+void FfCache::notify_blackout(RTLIL::Module *mod)
+{
+	log_assert(module == mod);
+	reload = true;
+	ffs.clear();
+}
@@ -221,6 +221,43 @@ struct FfData {
 	void flip_rst_bits(const pool<int> &bits);
 };
 
+// The sigmap, init values and parsed FFs of a module, kept alive across
+// passes like ModIndex::cached(). The cache is owned by the module and is
+// dropped after every pass that is not marked with Pass::keeps_indexes().
+//
+// The sigmap and the init values are rebuilt by cached() after connections
+// were added to the module, wires were added or removed, or init attributes
+// were changed by anything but `initvals` (see Module::init_generation_).
+// They are not updated while a pass runs, just like a SigMap and FfInitVals
+// set up by the pass itself. A parsed FF is dropped when a port of its cell
+// changes, the parameters of an FF cell are assumed to only change together
+// with its ports (as with FfData::emit()).
+struct FfCache : RTLIL::Monitor
+{
+	RTLIL::Module *module;
+	SigMap sigmap;
+	FfInitVals initvals;
+
+	static FfCache &cached(RTLIL::Module *module);
+
+	// same as FfData(&initvals, cell)
+	FfData ff(RTLIL::Cell *cell);
+
+	FfCache(RTLIL::Module *module);
+	~FfCache();
+
+	void notify_connect(RTLIL::Cell *cell, const RTLIL::IdString &port, const RTLIL::SigSpec &old_sig, const RTLIL::SigSpec &sig) override;
+	void notify_connect(RTLIL::Module *mod, const RTLIL::SigSig &sigsig) override;
+	void notify_connect(RTLIL::Module *mod, const std::vector<RTLIL::SigSig> &new_conn) override;
+	void notify_blackout(RTLIL::Module *mod) override;
+
+private:
+	bool reload = true;
+	int reload_wires = 0;
+	uint64_t reload_init_generation = 0;
+	dict<RTLIL::Cell*, std::pair<RTLIL::IdString, FfData>> ffs;
+};
+
 YOSYS_NAMESPACE_END
 
 #endif
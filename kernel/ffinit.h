@@ -30,6 +30,10 @@ struct FfInitVals
 	const SigMap *sigmap;
 	dict<SigBit, std::pair<State,SigBit>> initbits;
 
+	// set for the init values of an FfCache, whose changes don't have to
+	// invalidate the cache (see Module::init_generation_)
+	bool cached = false;
+
 	void set(const SigMap *sigmap_, RTLIL::Module *module)
 	{
 		sigmap = sigmap_;
@@ -90,6 +94,8 @@ struct FfInitVals
 		else if (val == State::Sx)
 			return;
 		log_assert(abit.wire);
+		if (!cached && abit.wire->module)
+			abit.wire->module->init_generation_++;
 		initbits[mbit] = std::make_pair(val,abit);
 		auto it2 = abit.wire->attributes.find(ID::init);
 		if (it2 != abit.wire->attributes.end()) {
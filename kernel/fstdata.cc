@@ -19,6 +19,14 @@
 
 #include "kernel/fstdata.h"
 
+#ifdef YOSYS_ENABLE_THREADS
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
 USING_YOSYS_NAMESPACE
 
 
@@ -63,6 +71,7 @@ FstData::FstData(std::string filename) : ctx(nullptr)
 	}
 	for (int i=0;i<zeros; i++) timescale_str += "0";
 	timescale_str += g_units[unit];
+	is_watched.resize(fstReaderGetMaxHandle(ctx) + 1);
 	extractVarNames();
 }
 
@@ -90,19 +99,30 @@ static void normalize_brackets(std::string &str)
 
 fstHandle FstData::getHandle(std::string name) { 
 	normalize_brackets(name);
-	if (name_to_handle.find(name) != name_to_handle.end())
+	if (name_to_handle.find(name) != name_to_handle.end()) {
+		watchSignal(name_to_handle[name]);
 		return name_to_handle[name];
-	else 
+	} else
 		return 0;
 };
 
 dict<int,fstHandle> FstData::getMemoryHandles(std::string name) { 
-	if (memory_to_handle.find(name) != memory_to_handle.end())
+	if (memory_to_handle.find(name) != memory_to_handle.end()) {
+		for (auto &it : memory_to_handle[name])
+			watchSignal(it.second);
 		return memory_to_handle[name];
-	else 
+	} else
 		return dict<int,fstHandle>();
 };
 
+void FstData::watchSignal(fstHandle signal)
+{
+	if (signal == 0 || signal >= is_watched.size())
+		return;
+	is_watched[signal] = true;
+	any_watched = true;
+}
+
 static std::string remove_spaces(std::string str)
 {
 	str.erase(std::remove(str.begin(), str.end(), ' '), str.end());
@@ -203,22 +223,141 @@ static void reconstruct_clb_attimes(void *user_data, uint64_t pnt_time, fstHandl
 	ptr->reconstruct_callback_attimes(pnt_time, pnt_facidx, pnt_value, plen);
 }
 
-void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t /* plen */)
+#ifdef YOSYS_ENABLE_THREADS
+// Collects the value changes decoded by the FST reader on the prefetch thread into batches, and hands them over
+// to the thread that runs the callback. The number of batches in flight is limited, so that the reader does not
+// run arbitrarily far ahead.
+struct FstPrefetcher
 {
-	if (pnt_time > end_time || !pnt_value) return;
-	// if we are past the timestamp
-	bool is_clock = false;
-	if (!all_samples) {
-		for(auto &s : clk_signals) {
-			if (s==pnt_facidx)  { 
-				is_clock=true;
-				break;
+	static constexpr int batch_size = 16384;
+	static constexpr size_t max_batches = 8;
+
+	struct Batch {
+		std::vector<uint64_t> times;
+		std::vector<fstHandle> handles;
+		std::vector<size_t> offsets;
+		// the values, each one terminated by a null character
+		std::string values;
+	};
+
+	uint64_t end_time;
+	std::mutex mutex;
+	std::condition_variable produced, consumed;
+	std::deque<Batch> queue;
+	Batch current;
+	bool done = false;
+	std::atomic<bool> aborted{false};
+
+	FstPrefetcher(uint64_t end_time) : end_time(end_time) { }
+
+	void add(uint64_t time, fstHandle facidx, const unsigned char *value, uint32_t len)
+	{
+		if (time > end_time || !value || aborted)
+			return;
+		current.times.push_back(time);
+		current.handles.push_back(facidx);
+		current.offsets.push_back(current.values.size());
+		current.values.append((const char *)value, len);
+		current.values.push_back(0);
+		if (GetSize(current.times) >= batch_size)
+			push();
+	}
+
+	void push()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		consumed.wait(lock, [&]() { return queue.size() < max_batches || aborted; });
+		if (!aborted && !current.times.empty())
+			queue.push_back(std::move(current));
+		current = Batch();
+		produced.notify_one();
+	}
+
+	void finish()
+	{
+		push();
+		std::lock_guard<std::mutex> lock(mutex);
+		done = true;
+		produced.notify_one();
+	}
+
+	void abort()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		aborted = true;
+		consumed.notify_one();
+	}
+
+	bool pop(Batch &batch)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		produced.wait(lock, [&]() { return !queue.empty() || done; });
+		if (queue.empty())
+			return false;
+		batch = std::move(queue.front());
+		queue.pop_front();
+		consumed.notify_one();
+		return true;
+	}
+};
+
+static void prefetch_clb_varlen(void *user_data, uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t plen)
+{
+	((FstPrefetcher*)user_data)->add(pnt_time, pnt_facidx, pnt_value, plen);
+}
+
+static void prefetch_clb(void *user_data, uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value)
+{
+	uint32_t plen = (pnt_value) ?  strlen((const char *)pnt_value) : 0;
+	((FstPrefetcher*)user_data)->add(pnt_time, pnt_facidx, pnt_value, plen);
+}
+
+void FstData::iterBlocksPrefetch()
+{
+	FstPrefetcher prefetcher(end_time);
+	std::thread reader([&]() {
+		fstReaderIterBlocks2(ctx, prefetch_clb, prefetch_clb_varlen, &prefetcher, nullptr);
+		prefetcher.finish();
+	});
+
+	// The callback ends the simulation by throwing, in that case the reader still has to be stopped and joined.
+	try {
+		FstPrefetcher::Batch batch;
+		while (prefetcher.pop(batch))
+			for (int i = 0; i < GetSize(batch.times); i++) {
+				auto value = (const unsigned char *)batch.values.data() + batch.offsets[i];
+				reconstruct_callback_attimes(batch.times[i], batch.handles[i], value, strlen((const char *)value));
 			}
-		}
+	} catch (...) {
+		prefetcher.abort();
+		reader.join();
+		throw;
+	}
+	reader.join();
+}
+#else
+void FstData::iterBlocksPrefetch()
+{
+	fstReaderIterBlocks2(ctx, reconstruct_clb_attimes, reconstruct_clb_varlen_attimes, this, nullptr);
+}
+#endif
+
+void FstData::updatePastData()
+{
+	for (auto handle : changed_data) {
+		past_data[handle] = last_data[handle];
+		is_changed[handle] = false;
 	}
+	changed_data.clear();
+}
 
+void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t /* plen */)
+{
+	if (pnt_time > end_time || !pnt_value) return;
+
+	// if we are past the timestamp
 	if (pnt_time > past_time) {
-		past_data = last_data;
+		updatePastData();
 		past_time = pnt_time;
 	}
 
@@ -227,18 +366,25 @@ void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_faci
 			callback(last_time);
 			last_time = pnt_time;
 		} else {
-			if (is_clock) {
-				std::string val = std::string((const char *)pnt_value);
-				std::string prev = past_data[pnt_facidx];
-				if ((prev!="1" && val=="1") || (prev!="0" && val=="0")) {
+			if (is_clock[pnt_facidx]) {
+				const char *val = (const char *)pnt_value;
+				const std::string &prev = past_data[pnt_facidx];
+				if ((prev!="1" && strcmp(val, "1") == 0) || (prev!="0" && strcmp(val, "0") == 0)) {
 					callback(last_time);
 					last_time = pnt_time;
 				}
 			}
 		}
 	}
+
 	// always update last_data
-	last_data[pnt_facidx] =  std::string((const char *)pnt_value);
+	if (!is_watched[pnt_facidx])
+		return;
+	last_data[pnt_facidx] = (const char *)pnt_value;
+	if (!is_changed[pnt_facidx]) {
+		is_changed[pnt_facidx] = true;
+		changed_data.push_back(pnt_facidx);
+	}
 }
 
 void FstData::reconstructAllAtTimes(std::vector<fstHandle> &signal, uint64_t start, uint64_t end, CallbackFunction cb)
@@ -247,26 +393,50 @@ void FstData::reconstructAllAtTimes(std::vector<fstHandle> &signal, uint64_t sta
 	callback = cb;
 	start_time = start;
 	end_time = end;
-	last_data.clear();
 	last_time = start_time;
-	past_data.clear();
 	past_time = start_time;
 	all_samples = clk_signals.empty();
 
+	size_t num_handles = is_watched.size();
+	if (!any_watched)
+		is_watched.assign(num_handles, true);
+	is_clock.assign(num_handles, false);
+	for (auto handle : clk_signals) {
+		if (handle < num_handles)
+			is_clock[handle] = true;
+		watchSignal(handle);
+	}
+	last_data.assign(num_handles, std::string());
+	past_data.assign(num_handles, std::string());
+	changed_data.clear();
+	is_changed.assign(num_handles, false);
+
+	// With clock signals, the times of the changes of other signals are not used, so only the value change blocks
+	// of the watched signals need to be decoded. Without, every change of any signal is a sample.
 	fstReaderSetUnlimitedTimeRange(ctx);
-	fstReaderSetFacProcessMaskAll(ctx);
-	fstReaderIterBlocks2(ctx, reconstruct_clb_attimes, reconstruct_clb_varlen_attimes, this, nullptr);
+	if (all_samples) {
+		fstReaderSetFacProcessMaskAll(ctx);
+	} else {
+		fstReaderClrFacProcessMaskAll(ctx);
+		for (size_t handle = 1; handle < num_handles; handle++)
+			if (is_watched[handle])
+				fstReaderSetFacProcessMask(ctx, handle);
+	}
+	if (prefetch)
+		iterBlocksPrefetch();
+	else
+		fstReaderIterBlocks2(ctx, reconstruct_clb_attimes, reconstruct_clb_varlen_attimes, this, nullptr);
 	if (last_time!=end_time) {
-		past_data = last_data;
+		updatePastData();
 		callback(last_time);
 	}
-	past_data = last_data;
+	updatePastData();
 	callback(end_time);
 }
 
 std::string FstData::valueOf(fstHandle signal)
 {
-	if (past_data.find(signal) == past_data.end()) {
+	if (signal >= past_data.size() || past_data[signal].empty()) {
 		return std::string(handle_to_var[signal].width, 'x');
 	}
 	return past_data[signal];
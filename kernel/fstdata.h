@@ -52,6 +52,15 @@ class FstData
 	void reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t plen);
 	void reconstructAllAtTimes(std::vector<fstHandle> &signal, uint64_t start_time, uint64_t end_time, CallbackFunction cb);
 
+	// Only the values of watched signals are available from valueOf() in the callback of reconstructAllAtTimes(),
+	// and with clock signals only their value change blocks are decoded. Signals looked up with getHandle() and
+	// getMemoryHandles() are watched automatically.
+	void watchSignal(fstHandle signal);
+
+	// If enabled, the value change blocks are read and decoded on a separate thread while the callback of
+	// reconstructAllAtTimes() runs. This has no effect if Yosys was built without thread support.
+	void setPrefetch(bool enable) { prefetch = enable; }
+
 	std::string valueOf(fstHandle signal);
 	fstHandle getHandle(std::string name);
 	dict<int,fstHandle> getMemoryHandles(std::string name);
@@ -59,16 +68,25 @@ class FstData
 	const char *getTimescaleString() { return timescale_str.c_str(); }
 private:
 	void extractVarNames();
+	void updatePastData();
+	void iterBlocksPrefetch();
 
 	struct fstReaderContext *ctx;
 	std::vector<FstVar> vars;
 	std::map<fstHandle, FstVar> handle_to_var;
 	std::map<std::string, fstHandle> name_to_handle;
 	std::map<std::string, dict<int, fstHandle>> memory_to_handle;
-	std::map<fstHandle, std::string> last_data;
+	// values indexed by handle, empty if the signal has no value yet
+	std::vector<std::string> last_data;
 	uint64_t last_time;
-	std::map<fstHandle, std::string> past_data;
+	std::vector<std::string> past_data;
 	uint64_t past_time;
+	// the signals in last_data that were changed since they were copied into past_data
+	std::vector<fstHandle> changed_data;
+	std::vector<bool> is_changed;
+	std::vector<bool> is_watched;
+	std::vector<bool> is_clock;
+	bool any_watched = false;
 	double timescale;
 	std::string timescale_str;
 	uint64_t start_time;
@@ -76,6 +94,7 @@ private:
 	CallbackFunction callback;
 	std::vector<fstHandle> clk_signals;
 	bool all_samples;
+	bool prefetch = false;
 	std::string tmp_file;
 };
 
@@ -727,6 +727,7 @@ IR IR::from_module(Module *module) {
     ctor.process_queue();
     ir.topological_sort();
     ir.forward_buf();
+    ir.optimize();
     return ir;
 }
 
@@ -797,6 +798,327 @@ void IR::forward_buf() {
     _graph.permute(perm, alias);
 }
 
+// Rewrites the nodes of a topologically sorted IR in order, replacing each node with a simpler equivalent where
+// one is known and with an identical node that was seen earlier where there is one. Replaced nodes are turned into
+// buf() nodes pointing at their replacement, so that names and keys are carried over by forward_buf().
+class Optimizer {
+	IR &ir;
+	Factory factory;
+	std::vector<int> replacement;
+	dict<std::tuple<IR::NodeData, Sort, std::vector<int>>, int> unique_nodes;
+
+	static bool is_const(Node n) { return n.fn() == Fn::constant; }
+	static bool is_def(Node n) { return is_const(n) && constant(n).is_fully_def(); }
+	static bool is_zero(Node n) { return is_def(n) && constant(n).is_fully_zero(); }
+	static bool is_ones(Node n) { return is_def(n) && constant(n).is_fully_ones(); }
+	static bool is_one(Node n) { return is_def(n) && constant(n)[0] == State::S1 && constant(n).extract(1, n.width() - 1).is_fully_zero(); }
+	static RTLIL::Const const &constant(Node n) { return n._ref.function().as_const(); }
+	static int offset(Node n) { return n._ref.function().as_int(); }
+
+	Node make_const(RTLIL::Const value) { return canonicalize(factory.constant(std::move(value))); }
+	Node make_bool(bool value) { return make_const(RTLIL::Const(value ? State::S1 : State::S0)); }
+
+	// Returns the node that replaces `n`, whose arguments have already been replaced.
+	Node simplify(Node n)
+	{
+		using namespace RTLIL;
+		switch (n.fn()) {
+		case Fn::buf:
+			return n.arg(0);
+		case Fn::slice: {
+			Node a = n.arg(0);
+			int off = offset(n), width = n.width();
+			if (is_const(a))
+				return make_const(constant(a).extract(off, width));
+			if (a.fn() == Fn::slice)
+				return canonicalize(factory.slice(a.arg(0), offset(a) + off, width));
+			if (a.fn() == Fn::concat) {
+				int low_width = a.arg(0).width();
+				if (off + width <= low_width)
+					return canonicalize(factory.slice(a.arg(0), off, width));
+				if (off >= low_width)
+					return canonicalize(factory.slice(a.arg(1), off - low_width, width));
+			}
+			if (a.fn() == Fn::zero_extend || a.fn() == Fn::sign_extend) {
+				int inner_width = a.arg(0).width();
+				if (off + width <= inner_width)
+					return canonicalize(factory.slice(a.arg(0), off, width));
+				if (a.fn() == Fn::zero_extend && off >= inner_width)
+					return make_const(Const(State::S0, width));
+			}
+			return n;
+		}
+		case Fn::zero_extend:
+		case Fn::sign_extend: {
+			Node a = n.arg(0);
+			bool is_signed = n.fn() == Fn::sign_extend;
+			if (is_const(a)) {
+				Const value = constant(a);
+				if (is_signed)
+					value.exts(n.width());
+				else
+					value.extu(n.width());
+				return make_const(value);
+			}
+			// a zero extended value has a zero sign bit, so sign extending it further is the same as zero extending it
+			if (a.fn() == Fn::zero_extend || (is_signed && a.fn() == Fn::sign_extend))
+				return canonicalize(factory.extend(a.arg(0), n.width(), a.fn() == Fn::sign_extend));
+			return n;
+		}
+		case Fn::concat: {
+			Node a = n.arg(0), b = n.arg(1);
+			if (is_const(a) && is_const(b)) {
+				SigSpec value(constant(a));
+				value.append(constant(b));
+				return make_const(value.as_const());
+			}
+			if (is_zero(b))
+				return canonicalize(factory.extend(a, n.width(), false));
+			if (a.fn() == Fn::slice && b.fn() == Fn::slice && a.arg(0).id() == b.arg(0).id() &&
+					offset(a) + a.width() == offset(b))
+				return canonicalize(factory.slice(a.arg(0), offset(a), n.width()));
+			return n;
+		}
+		case Fn::bitwise_and:
+		case Fn::bitwise_or:
+		case Fn::bitwise_xor: {
+			Node a = n.arg(0), b = n.arg(1);
+			if (is_def(a) && is_def(b)) {
+				if (n.fn() == Fn::bitwise_and)
+					return make_const(const_and(constant(a), constant(b), false, false, n.width()));
+				if (n.fn() == Fn::bitwise_or)
+					return make_const(const_or(constant(a), constant(b), false, false, n.width()));
+				return make_const(const_xor(constant(a), constant(b), false, false, n.width()));
+			}
+			if (is_const(a))
+				std::swap(a, b);
+			if (n.fn() == Fn::bitwise_and) {
+				if (is_zero(b)) return b;
+				if (is_ones(b) || a.id() == b.id()) return a;
+			} else if (n.fn() == Fn::bitwise_or) {
+				if (is_ones(b)) return b;
+				if (is_zero(b) || a.id() == b.id()) return a;
+			} else {
+				if (is_zero(b)) return a;
+				if (a.id() == b.id()) return make_const(Const(State::S0, n.width()));
+			}
+			return n;
+		}
+		case Fn::bitwise_not:
+			if (is_def(n.arg(0)))
+				return make_const(const_not(constant(n.arg(0)), Const(), false, false, n.width()));
+			if (n.arg(0).fn() == Fn::bitwise_not)
+				return n.arg(0).arg(0);
+			return n;
+		case Fn::unary_minus:
+			if (is_def(n.arg(0)))
+				return make_const(const_neg(constant(n.arg(0)), Const(), false, false, n.width()));
+			return n;
+		case Fn::add:
+		case Fn::sub:
+		case Fn::mul: {
+			Node a = n.arg(0), b = n.arg(1);
+			if (is_def(a) && is_def(b)) {
+				if (n.fn() == Fn::add)
+					return make_const(const_add(constant(a), constant(b), false, false, n.width()));
+				if (n.fn() == Fn::sub)
+					return make_const(const_sub(constant(a), constant(b), false, false, n.width()));
+				return make_const(const_mul(constant(a), constant(b), false, false, n.width()));
+			}
+			if (n.fn() == Fn::sub) {
+				if (is_zero(b)) return a;
+				if (a.id() == b.id()) return make_const(Const(State::S0, n.width()));
+				return n;
+			}
+			if (is_const(a))
+				std::swap(a, b);
+			if (n.fn() == Fn::add && is_zero(b)) return a;
+			if (n.fn() == Fn::mul && is_zero(b)) return b;
+			if (n.fn() == Fn::mul && is_one(b)) return a;
+			return n;
+		}
+		case Fn::unsigned_div:
+		case Fn::unsigned_mod: {
+			// division by zero is left to the backends, which do not necessarily agree on its result
+			Node a = n.arg(0), b = n.arg(1);
+			if (is_def(a) && is_def(b) && !is_zero(b)) {
+				if (n.fn() == Fn::unsigned_div)
+					return make_const(const_div(constant(a), constant(b), false, false, n.width()));
+				return make_const(const_mod(constant(a), constant(b), false, false, n.width()));
+			}
+			if (is_one(b))
+				return n.fn() == Fn::unsigned_div ? a : make_const(Const(State::S0, n.width()));
+			return n;
+		}
+		case Fn::reduce_and:
+		case Fn::reduce_or:
+		case Fn::reduce_xor: {
+			Node a = n.arg(0);
+			if (!is_def(a))
+				return n;
+			if (n.fn() == Fn::reduce_and)
+				return make_const(const_reduce_and(constant(a), Const(), false, false, 1));
+			if (n.fn() == Fn::reduce_or)
+				return make_const(const_reduce_or(constant(a), Const(), false, false, 1));
+			return make_const(const_reduce_xor(constant(a), Const(), false, false, 1));
+		}
+		case Fn::equal:
+		case Fn::not_equal:
+		case Fn::signed_greater_than:
+		case Fn::signed_greater_equal:
+		case Fn::unsigned_greater_than:
+		case Fn::unsigned_greater_equal: {
+			Node a = n.arg(0), b = n.arg(1);
+			if (a.id() == b.id())
+				return make_bool(n.fn() == Fn::equal || n.fn() == Fn::signed_greater_equal || n.fn() == Fn::unsigned_greater_equal);
+			if (!is_def(a) || !is_def(b))
+				return n;
+			switch (n.fn()) {
+			case Fn::equal: return make_const(const_eq(constant(a), constant(b), false, false, 1));
+			case Fn::not_equal: return make_const(const_ne(constant(a), constant(b), false, false, 1));
+			case Fn::signed_greater_than: return make_const(const_gt(constant(a), constant(b), true, true, 1));
+			case Fn::signed_greater_equal: return make_const(const_ge(constant(a), constant(b), true, true, 1));
+			case Fn::unsigned_greater_than: return make_const(const_gt(constant(a), constant(b), false, false, 1));
+			default: return make_const(const_ge(constant(a), constant(b), false, false, 1));
+			}
+		}
+		case Fn::logical_shift_left:
+		case Fn::logical_shift_right:
+		case Fn::arithmetic_shift_right: {
+			Node a = n.arg(0), b = n.arg(1);
+			if (is_def(a) && is_def(b)) {
+				if (n.fn() == Fn::logical_shift_left)
+					return make_const(const_shl(constant(a), constant(b), false, false, n.width()));
+				if (n.fn() == Fn::logical_shift_right)
+					return make_const(const_shr(constant(a), constant(b), false, false, n.width()));
+				return make_const(const_sshr(constant(a), constant(b), true, false, n.width()));
+			}
+			if (is_zero(a) || is_zero(b))
+				return a;
+			return n;
+		}
+		case Fn::mux: {
+			Node a = n.arg(0), b = n.arg(1), s = n.arg(2);
+			if (is_def(s))
+				return constant(s).as_bool() ? b : a;
+			if (a.id() == b.id())
+				return a;
+			if (n.width() == 1 && is_zero(a) && is_ones(b))
+				return s;
+			if (n.width() == 1 && is_ones(a) && is_zero(b))
+				return canonicalize(factory.bitwise_not(s));
+			return n;
+		}
+		case Fn::memory_read: {
+			// reading the address that was just written returns the written data
+			Node mem = n.arg(0), addr = n.arg(1);
+			if (mem.fn() == Fn::memory_write && mem.arg(1).id() == addr.id())
+				return mem.arg(2);
+			return n;
+		}
+		default:
+			return n;
+		}
+	}
+
+	// Returns the canonical node equivalent to `n`, whose arguments are already canonical.
+	Node canonicalize(Node n)
+	{
+		Node simplified = simplify(n);
+		if (simplified.id() != n.id())
+			return simplified;
+		std::vector<int> args;
+		for (size_t i = 0; i < n.arg_count(); i++)
+			args.push_back(n.arg(i).id());
+		auto key = std::make_tuple(n._ref.function(), n.sort(), std::move(args));
+		auto it = unique_nodes.find(key);
+		if (it != unique_nodes.end())
+			return ir[it->second];
+		unique_nodes.emplace(std::move(key), n.id());
+		return n;
+	}
+
+public:
+	Optimizer(IR &ir) : ir(ir), factory(ir.factory()) {}
+
+	void run()
+	{
+		// nodes added during the rewrite are canonical by construction
+		int size = ir.size();
+		replacement.resize(size);
+		for (int i = 0; i < size; i++) {
+			Node node = ir[i];
+			bool changed = false;
+			std::vector<int> args;
+			for (size_t j = 0; j < node.arg_count(); j++) {
+				int arg = node.arg(j).id();
+				log_assert(arg < i);
+				args.push_back(replacement[arg]);
+				changed |= args.back() != arg;
+			}
+			if (changed) {
+				auto ref = ir.mutate(node);
+				ref.clear_args();
+				for (int arg : args)
+					ref.append_arg(arg);
+			}
+			Node canonical = canonicalize(ir[i]);
+			replacement[i] = canonical.id();
+			if (canonical.id() != i) {
+				auto ref = ir.mutate(ir[i]);
+				ref.set_function(IR::NodeData(Fn::buf));
+				ref.clear_args();
+				ref.append_arg(canonical.id());
+			}
+		}
+	}
+};
+
+void IR::optimize() {
+	int old_size = size();
+	Optimizer(*this).run();
+
+	// states that none of the outputs depend on are removed, together with the logic computing their next value
+	pool<std::pair<IdString, IdString>> live_states;
+	pool<int> visited;
+	std::vector<int> worklist;
+	for (const auto &[name, output] : _outputs)
+		if (output.has_value())
+			worklist.push_back(output.value().id());
+	while (!worklist.empty()) {
+		Node node = (*this)[worklist.back()];
+		worklist.pop_back();
+		if (!visited.insert(node.id()).second)
+			continue;
+		if (node.fn() == Fn::state) {
+			auto state = node._ref.function().as_idstring_pair();
+			if (live_states.insert(state).second && _states.at(state).has_next_value())
+				worklist.push_back(_states.at(state).next_value().id());
+		}
+		for (size_t i = 0; i < node.arg_count(); i++)
+			worklist.push_back(node.arg(i).id());
+	}
+	// IRState is not assignable, so the live states are copied rather than erasing the dead ones in place.
+	// dict iterates in reverse insertion order, so they are copied back to front to keep the order of the states
+	vector<IRState const*> kept;
+	for (const auto &[name, state] : _states)
+		if (live_states.count(name))
+			kept.push_back(&state);
+		else if (_graph.has_key({name.first, name.second, true}))
+			_graph.erase_key({name.first, name.second, true});
+	int dead_states = GetSize(_states) - GetSize(kept);
+	if (dead_states > 0) {
+		dict<std::pair<IdString, IdString>, IRState> states;
+		for (auto it = kept.rbegin(); it != kept.rend(); ++it)
+			states.emplace({(*it)->name, (*it)->kind}, **it);
+		_states.swap(states);
+	}
+
+	topological_sort();
+	forward_buf();
+	log_debug("Optimized functional IR from %d to %d nodes, removing %d states.\n", old_size, size(), dead_states);
+}
+
 // Quoting routine to make error messages nicer
 static std::string quote_fmt(const char *fmt)
 {
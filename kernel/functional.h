@@ -156,6 +156,7 @@ namespace Functional {
 	class IR;
 	class Factory;
 	class Node;
+	class Optimizer;
 	class IRInput {
 		friend class Factory;
 	public:
@@ -204,6 +205,7 @@ namespace Functional {
 	class IR {
 		friend class Factory;
 		friend class Node;
+		friend class Optimizer;
 		friend class IRInput;
 		friend class IROutput;
 		friend class IRState;
@@ -255,6 +257,9 @@ namespace Functional {
 		Node operator[](int i);
 		void topological_sort();
 		void forward_buf();
+		// simplifies the IR: merges identical nodes, folds constants, simplifies slices and concatenations,
+		// and removes states that do not affect any output. called by from_module()
+		void optimize();
 		IRInput const& input(IdString name, IdString kind) const { return _inputs.at({name, kind}); }
 		IRInput const& input(IdString name) const { return input(name, ID($input)); }
 		IROutput const& output(IdString name, IdString kind) const { return _outputs.at({name, kind}); }
@@ -297,6 +302,7 @@ namespace Functional {
 	class Node {
 		friend class Factory;
 		friend class IR;
+		friend class Optimizer;
 		friend class IRInput;
 		friend class IROutput;
 		friend class IRState;
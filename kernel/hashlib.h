@@ -18,8 +18,17 @@
 #include <variant>
 #include <vector>
 #include <type_traits>
+#include <atomic>
 #include <stdint.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define HASHLIB_SSE2
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#  define HASHLIB_NEON
+#  include <arm_neon.h>
+#endif
+
 #define YS_HASHING_VERSION 1
 
 namespace hashlib {
@@ -49,12 +58,22 @@ namespace hashlib {
  *
  * We implement associative data structures with separate chaining.
  * Linked lists use integers into the indirection hashtable array
- * instead of pointers.
+ * instead of pointers. flat_dict and flat_pool are drop-in variants
+ * that use open addressing instead, see below.
  */
 
 const int hashtable_size_trigger = 2;
 const int hashtable_size_factor = 3;
 
+// A dict with at most this many entries has no hashtable and is searched
+// linearly. Most dicts in a netlist are tiny (cell ports and parameters,
+// attributes), and this saves their hashtable allocation.
+const unsigned int dict_small_size = 8;
+
+// number of hash table rebuilds in all containers, see `internal_stats`
+inline std::atomic<uint64_t> rehash_counter{0};
+inline void count_rehash() { rehash_counter.fetch_add(1, std::memory_order_relaxed); }
+
 namespace legacy {
 	inline uint32_t djb2_add(uint32_t a, uint32_t b) {
 		return ((a << 5) + a) + b;
@@ -354,6 +373,8 @@ template<typename K, typename T, typename OPS = hash_ops<K>> class dict;
 template<typename K, int offset = 0, typename OPS = hash_ops<K>> class idict;
 template<typename K, typename OPS = hash_ops<K>> class pool;
 template<typename K, typename OPS = hash_ops<K>> class mfp;
+template<typename K, typename T, typename OPS = hash_ops<K>> class flat_dict;
+template<typename K, typename OPS = hash_ops<K>> class flat_pool;
 
 template<typename K, typename T, typename OPS>
 class dict {
@@ -390,7 +411,10 @@ class dict {
 
 	void do_rehash()
 	{
+		count_rehash();
 		hashtable.clear();
+		if (entries.size() <= dict_small_size)
+			return;
 		hashtable.resize(hashtable_size(entries.capacity() * hashtable_size_factor), -1);
 
 		for (int i = 0; i < int(entries.size()); i++) {
@@ -404,9 +428,17 @@ class dict {
 	int do_erase(int index, Hasher::hash_t hash)
 	{
 		do_assert(index < int(entries.size()));
-		if (hashtable.empty() || index < 0)
+		if (index < 0)
 			return 0;
 
+		if (hashtable.empty()) {
+			int back_idx = entries.size()-1;
+			if (index != back_idx)
+				entries[index] = std::move(entries[back_idx]);
+			entries.pop_back();
+			return 1;
+		}
+
 		int k = hashtable[hash];
 		do_assert(0 <= k && k < int(entries.size()));
 
@@ -450,13 +482,23 @@ class dict {
 		return 1;
 	}
 
+	int do_lookup_small(const K &key) const
+	{
+		for (int i = 0; i < int(entries.size()); i++)
+			if (ops.cmp(entries[i].udata.first, key))
+				return i;
+		return -1;
+	}
+
 	int do_lookup(const K &key, Hasher::hash_t &hash) const
 	{
 		if (hashtable.empty())
-			return -1;
+			return do_lookup_small(key);
 
 		if (entries.size() * hashtable_size_trigger > hashtable.size()) {
 			((dict*)this)->do_rehash();
+			if (hashtable.empty())
+				return do_lookup_small(key);
 			hash = do_hash(key);
 		}
 
@@ -474,8 +516,10 @@ class dict {
 	{
 		if (hashtable.empty()) {
 			entries.emplace_back(std::pair<K, T>(key, T()), -1);
-			do_rehash();
-			hash = do_hash(key);
+			if (entries.size() > dict_small_size) {
+				do_rehash();
+				hash = do_hash(key);
+			}
 		} else {
 			entries.emplace_back(std::pair<K, T>(key, T()), hashtable[hash]);
 			hashtable[hash] = entries.size() - 1;
@@ -487,8 +531,10 @@ class dict {
 	{
 		if (hashtable.empty()) {
 			entries.emplace_back(value, -1);
-			do_rehash();
-			hash = do_hash(value.first);
+			if (entries.size() > dict_small_size) {
+				do_rehash();
+				hash = do_hash(value.first);
+			}
 		} else {
 			entries.emplace_back(value, hashtable[hash]);
 			hashtable[hash] = entries.size() - 1;
@@ -499,10 +545,11 @@ class dict {
 	int do_insert(std::pair<K, T> &&rvalue, Hasher::hash_t &hash)
 	{
 		if (hashtable.empty()) {
-			auto key = rvalue.first;
 			entries.emplace_back(std::forward<std::pair<K, T>>(rvalue), -1);
-			do_rehash();
-			hash = do_hash(key);
+			if (entries.size() > dict_small_size) {
+				do_rehash();
+				hash = do_hash(entries.back().udata.first);
+			}
 		} else {
 			entries.emplace_back(std::forward<std::pair<K, T>>(rvalue), hashtable[hash]);
 			hashtable[hash] = entries.size() - 1;
@@ -849,6 +896,7 @@ protected:
 
 	void do_rehash()
 	{
+		count_rehash();
 		hashtable.clear();
 		hashtable.resize(hashtable_size(entries.capacity() * hashtable_size_factor), -1);
 
@@ -1178,10 +1226,875 @@ public:
 	const_iterator end() const { return const_iterator(nullptr, -1); }
 };
 
+/**
+ * OPEN ADDRESSING HASH TABLES
+ *
+ * flat_dict and flat_pool have the same interface and the same iteration
+ * order as dict and pool: the elements live in an entries vector in
+ * insertion order and erase() moves the last entry into the freed spot.
+ * Only the index from hashes to entries differs. Instead of chaining,
+ * flat_index uses open addressing with one control byte per slot, in the
+ * style of Swiss tables. A control byte is either empty, deleted, or
+ * holds a 7-bit tag taken from the hash of the entry in that slot. The
+ * slots are probed in aligned groups of 16, matching the tag against all
+ * control bytes of a group at once (with SSE2 or NEON if available), so
+ * that most lookups compare a single key.
+ *
+ * Unlike dict and pool, lookups never rehash, so concurrent lookups on a
+ * const flat_dict or flat_pool are safe.
+ */
+
+class flat_index
+{
+public:
+	static constexpr int group_size = 16;
+	static constexpr int8_t ctrl_empty = -128;
+	static constexpr int8_t ctrl_deleted = -2;
+
+	std::vector<int8_t> ctrl;
+	std::vector<int> slots;
+	int num_used = 0;
+	Hasher::hash_t group_mask = 0;
+
+private:
+#if defined(HASHLIB_SSE2)
+	static constexpr int lane_shift = 0;
+	static inline uint64_t match_tag(const int8_t *group, int8_t tag) {
+		__m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+		return (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+	}
+	static inline uint64_t match_free(const int8_t *group) {
+		return (uint16_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+	}
+#elif defined(HASHLIB_NEON)
+	// one nibble per lane, with only the top bit of each nibble kept
+	static constexpr int lane_shift = 2;
+	static inline uint64_t narrow_mask(uint8x16_t mask) {
+		uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(mask), 4);
+		return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull;
+	}
+	static inline uint64_t match_tag(const int8_t *group, int8_t tag) {
+		return narrow_mask(vceqq_s8(vld1q_s8(group), vdupq_n_s8(tag)));
+	}
+	static inline uint64_t match_free(const int8_t *group) {
+		return narrow_mask(vcltq_s8(vld1q_s8(group), vdupq_n_s8(0)));
+	}
+#else
+	static constexpr int lane_shift = 0;
+	static inline uint64_t match_tag(const int8_t *group, int8_t tag) {
+		uint64_t mask = 0;
+		for (int i = 0; i < group_size; i++)
+			if (group[i] == tag)
+				mask |= uint64_t(1) << i;
+		return mask;
+	}
+	static inline uint64_t match_free(const int8_t *group) {
+		uint64_t mask = 0;
+		for (int i = 0; i < group_size; i++)
+			if (group[i] < 0)
+				mask |= uint64_t(1) << i;
+		return mask;
+	}
+#endif
+
+	static inline uint64_t match_empty(const int8_t *group) {
+		return match_tag(group, ctrl_empty);
+	}
+
+	static inline int first_lane(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctzll(mask) >> lane_shift;
+#else
+		int i = 0;
+		while (!(mask & 1))
+			mask >>= 1, i++;
+		return i >> lane_shift;
+#endif
+	}
+
+	static inline int8_t hash_tag(Hasher::hash_t hash) {
+		return hash & 0x7f;
+	}
+
+	// mixing the hash in makes sure all of its bits select the group
+	inline Hasher::hash_t hash_group(Hasher::hash_t hash) const {
+		return Hasher::hash_t((uint64_t(hash) * 0x9e3779b97f4a7c15ull) >> 32) & group_mask;
+	}
+
+public:
+	int capacity() const { return int(ctrl.size()); }
+
+	// clears the index and makes room for at least min_entries entries
+	void reset(size_t min_entries)
+	{
+		size_t cap = group_size;
+		while (cap < 2 * min_entries)
+			cap *= 2;
+		ctrl.assign(cap, ctrl_empty);
+		slots.assign(cap, -1);
+		num_used = 0;
+		group_mask = cap / group_size - 1;
+	}
+
+	void clear()
+	{
+		ctrl.clear();
+		slots.clear();
+		num_used = 0;
+		group_mask = 0;
+	}
+
+	// true if inserting one more entry requires a reset
+	bool full() const
+	{
+		return 8 * (size_t(num_used) + 1) > 7 * ctrl.size();
+	}
+
+	// returns the entry index for which match(index) is true, or -1
+	template<typename Match>
+	int find(Hasher::hash_t hash, Match match) const
+	{
+		if (ctrl.empty())
+			return -1;
+
+		int8_t tag = hash_tag(hash);
+		Hasher::hash_t group = hash_group(hash);
+
+		for (Hasher::hash_t step = 1; step <= group_mask + 1; step++) {
+			const int8_t *group_ctrl = ctrl.data() + group * group_size;
+			for (uint64_t mask = match_tag(group_ctrl, tag); mask; mask &= mask - 1) {
+				int slot = group * group_size + first_lane(mask);
+				if (match(slots[slot]))
+					return slots[slot];
+			}
+			if (match_empty(group_ctrl))
+				return -1;
+			group = (group + step) & group_mask;
+		}
+		return -1;
+	}
+
+	// returns the slot holding the given entry index
+	int find_slot(Hasher::hash_t hash, int index) const
+	{
+		int8_t tag = hash_tag(hash);
+		Hasher::hash_t group = hash_group(hash);
+
+		for (Hasher::hash_t step = 1; step <= group_mask + 1; step++) {
+			const int8_t *group_ctrl = ctrl.data() + group * group_size;
+			for (uint64_t mask = match_tag(group_ctrl, tag); mask; mask &= mask - 1) {
+				int slot = group * group_size + first_lane(mask);
+				if (slots[slot] == index)
+					return slot;
+			}
+			group = (group + step) & group_mask;
+		}
+		throw std::runtime_error("flat_index::find_slot() failed.");
+	}
+
+	// adds the entry index for the hash, there must be room for it
+	void insert(Hasher::hash_t hash, int index)
+	{
+		Hasher::hash_t group = hash_group(hash);
+
+		for (Hasher::hash_t step = 1; ; step++) {
+			const int8_t *group_ctrl = ctrl.data() + group * group_size;
+			uint64_t mask = match_free(group_ctrl);
+			if (mask) {
+				int slot = group * group_size + first_lane(mask);
+				if (ctrl[slot] == ctrl_empty)
+					num_used++;
+				ctrl[slot] = hash_tag(hash);
+				slots[slot] = index;
+				return;
+			}
+			group = (group + step) & group_mask;
+		}
+	}
+
+	void erase(Hasher::hash_t hash, int index)
+	{
+		int slot = find_slot(hash, index);
+		// A probe sequence only continues past full groups. If this group
+		// has an empty slot it has not been full since the last reset,
+		// so the slot can be made empty instead of leaving a tombstone.
+		if (match_empty(ctrl.data() + slot / group_size * group_size)) {
+			ctrl[slot] = ctrl_empty;
+			num_used--;
+		} else {
+			ctrl[slot] = ctrl_deleted;
+		}
+		slots[slot] = -1;
+	}
+
+	void relocate(Hasher::hash_t hash, int old_index, int new_index)
+	{
+		slots[find_slot(hash, old_index)] = new_index;
+	}
+
+	void swap(flat_index &other)
+	{
+		ctrl.swap(other.ctrl);
+		slots.swap(other.slots);
+		std::swap(num_used, other.num_used);
+		std::swap(group_mask, other.group_mask);
+	}
+};
+
+template<typename K, typename T, typename OPS>
+class flat_dict {
+	struct entry_t
+	{
+		std::pair<K, T> udata;
+		Hasher::hash_t hash;
+
+		entry_t() { }
+		entry_t(const std::pair<K, T> &udata, Hasher::hash_t hash) : udata(udata), hash(hash) { }
+		entry_t(std::pair<K, T> &&udata, Hasher::hash_t hash) : udata(std::move(udata)), hash(hash) { }
+		bool operator<(const entry_t &other) const { return udata.first < other.udata.first; }
+	};
+
+	flat_index index;
+	std::vector<entry_t> entries;
+	OPS ops;
+
+	Hasher::hash_t do_hash(const K &key) const
+	{
+		return ops.hash(key).yield();
+	}
+
+	void do_rehash(size_t min_entries)
+	{
+		count_rehash();
+		index.reset(std::max(min_entries, entries.size()));
+		for (int i = 0; i < int(entries.size()); i++)
+			index.insert(entries[i].hash, i);
+	}
+
+	int do_lookup(const K &key, Hasher::hash_t hash) const
+	{
+		return index.find(hash, [&](int i) {
+			return entries[i].hash == hash && ops.cmp(entries[i].udata.first, key);
+		});
+	}
+
+	template<typename V>
+	int do_insert(V &&value, Hasher::hash_t hash)
+	{
+		if (index.full())
+			do_rehash(entries.size() + 1);
+		entries.emplace_back(std::forward<V>(value), hash);
+		index.insert(hash, entries.size() - 1);
+		return entries.size() - 1;
+	}
+
+	int do_erase(int i)
+	{
+		if (i < 0)
+			return 0;
+
+		index.erase(entries[i].hash, i);
+
+		int back_idx = entries.size()-1;
+		if (i != back_idx) {
+			index.relocate(entries[back_idx].hash, back_idx, i);
+			entries[i] = std::move(entries[back_idx]);
+		}
+		entries.pop_back();
+
+		if (entries.empty())
+			index.clear();
+		return 1;
+	}
+
+public:
+	class const_iterator
+	{
+		friend class flat_dict;
+	protected:
+		const flat_dict *ptr;
+		int index;
+		const_iterator(const flat_dict *ptr, int index) : ptr(ptr), index(index) { }
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef std::pair<K, T> value_type;
+		typedef ptrdiff_t difference_type;
+		typedef std::pair<K, T>* pointer;
+		typedef std::pair<K, T>& reference;
+		const_iterator() { }
+		const_iterator operator++() { index--; return *this; }
+		const_iterator operator+=(int amt) { index -= amt; return *this; }
+		bool operator<(const const_iterator &other) const { return index > other.index; }
+		bool operator==(const const_iterator &other) const { return index == other.index; }
+		bool operator!=(const const_iterator &other) const { return index != other.index; }
+		const std::pair<K, T> &operator*() const { return ptr->entries[index].udata; }
+		const std::pair<K, T> *operator->() const { return &ptr->entries[index].udata; }
+	};
+
+	class iterator
+	{
+		friend class flat_dict;
+	protected:
+		flat_dict *ptr;
+		int index;
+		iterator(flat_dict *ptr, int index) : ptr(ptr), index(index) { }
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef std::pair<K, T> value_type;
+		typedef ptrdiff_t difference_type;
+		typedef std::pair<K, T>* pointer;
+		typedef std::pair<K, T>& reference;
+		iterator() { }
+		iterator operator++() { index--; return *this; }
+		iterator operator+=(int amt) { index -= amt; return *this; }
+		bool operator<(const iterator &other) const { return index > other.index; }
+		bool operator==(const iterator &other) const { return index == other.index; }
+		bool operator!=(const iterator &other) const { return index != other.index; }
+		std::pair<K, T> &operator*() { return ptr->entries[index].udata; }
+		std::pair<K, T> *operator->() { return &ptr->entries[index].udata; }
+		const std::pair<K, T> &operator*() const { return ptr->entries[index].udata; }
+		const std::pair<K, T> *operator->() const { return &ptr->entries[index].udata; }
+		operator const_iterator() const { return const_iterator(ptr, index); }
+	};
+
+	flat_dict()
+	{
+	}
+
+	flat_dict(const flat_dict &other)
+	{
+		entries = other.entries;
+		do_rehash(entries.size());
+	}
+
+	flat_dict(flat_dict &&other)
+	{
+		swap(other);
+	}
+
+	flat_dict &operator=(const flat_dict &other) {
+		entries = other.entries;
+		do_rehash(entries.size());
+		return *this;
+	}
+
+	flat_dict &operator=(flat_dict &&other) {
+		clear();
+		swap(other);
+		return *this;
+	}
+
+	flat_dict(const std::initializer_list<std::pair<K, T>> &list)
+	{
+		for (auto &it : list)
+			insert(it);
+	}
+
+	template<class InputIterator>
+	flat_dict(InputIterator first, InputIterator last)
+	{
+		insert(first, last);
+	}
+
+	template<class InputIterator>
+	void insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
+	std::pair<iterator, bool> insert(const K &key)
+	{
+		Hasher::hash_t hash = do_hash(key);
+		int i = do_lookup(key, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::pair<K, T>(key, T()), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> insert(const std::pair<K, T> &value)
+	{
+		Hasher::hash_t hash = do_hash(value.first);
+		int i = do_lookup(value.first, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(value, hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> insert(std::pair<K, T> &&rvalue)
+	{
+		Hasher::hash_t hash = do_hash(rvalue.first);
+		int i = do_lookup(rvalue.first, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::move(rvalue), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> emplace(K const &key, T const &value)
+	{
+		Hasher::hash_t hash = do_hash(key);
+		int i = do_lookup(key, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::make_pair(key, value), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> emplace(K const &key, T &&rvalue)
+	{
+		Hasher::hash_t hash = do_hash(key);
+		int i = do_lookup(key, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::make_pair(key, std::forward<T>(rvalue)), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> emplace(K &&rkey, T const &value)
+	{
+		Hasher::hash_t hash = do_hash(rkey);
+		int i = do_lookup(rkey, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::make_pair(std::forward<K>(rkey), value), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> emplace(K &&rkey, T &&rvalue)
+	{
+		Hasher::hash_t hash = do_hash(rkey);
+		int i = do_lookup(rkey, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::make_pair(std::forward<K>(rkey), std::forward<T>(rvalue)), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	int erase(const K &key)
+	{
+		return do_erase(do_lookup(key, do_hash(key)));
+	}
+
+	iterator erase(iterator it)
+	{
+		do_erase(it.index);
+		return ++it;
+	}
+
+	int count(const K &key) const
+	{
+		return do_lookup(key, do_hash(key)) < 0 ? 0 : 1;
+	}
+
+	int count(const K &key, const_iterator it) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		return i < 0 || i > it.index ? 0 : 1;
+	}
+
+	iterator find(const K &key)
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return end();
+		return iterator(this, i);
+	}
+
+	const_iterator find(const K &key) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return end();
+		return const_iterator(this, i);
+	}
+
+	T& at(const K &key)
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			throw std::out_of_range("flat_dict::at()");
+		return entries[i].udata.second;
+	}
+
+	const T& at(const K &key) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			throw std::out_of_range("flat_dict::at()");
+		return entries[i].udata.second;
+	}
+
+	const T& at(const K &key, const T &defval) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return defval;
+		return entries[i].udata.second;
+	}
+
+	T& operator[](const K &key)
+	{
+		Hasher::hash_t hash = do_hash(key);
+		int i = do_lookup(key, hash);
+		if (i < 0)
+			i = do_insert(std::pair<K, T>(key, T()), hash);
+		return entries[i].udata.second;
+	}
+
+	template<typename Compare = std::less<K>>
+	void sort(Compare comp = Compare())
+	{
+		std::sort(entries.begin(), entries.end(), [comp](const entry_t &a, const entry_t &b){ return comp(b.udata.first, a.udata.first); });
+		do_rehash(entries.size());
+	}
+
+	void swap(flat_dict &other)
+	{
+		index.swap(other.index);
+		entries.swap(other.entries);
+	}
+
+	bool operator==(const flat_dict &other) const {
+		if (size() != other.size())
+			return false;
+		for (auto &it : entries) {
+			auto oit = other.find(it.udata.first);
+			if (oit == other.end() || !(oit->second == it.udata.second))
+				return false;
+		}
+		return true;
+	}
+
+	bool operator!=(const flat_dict &other) const {
+		return !operator==(other);
+	}
+
+	[[nodiscard]] Hasher hash_into(Hasher h) const {
+		for (auto &it : entries) {
+			Hasher entry_hash;
+			entry_hash.eat(it.udata.first);
+			entry_hash.eat(it.udata.second);
+			h.commutative_eat(entry_hash.yield());
+		}
+		h.eat(entries.size());
+		return h;
+	}
+
+	void reserve(size_t n) {
+		entries.reserve(n);
+		if (2 * n > size_t(index.capacity()))
+			do_rehash(n);
+	}
+	size_t size() const { return entries.size(); }
+	bool empty() const { return entries.empty(); }
+	void clear() { index.clear(); entries.clear(); }
+
+	iterator begin() { return iterator(this, int(entries.size())-1); }
+	iterator element(int n) { return iterator(this, int(entries.size())-1-n); }
+	iterator end() { return iterator(nullptr, -1); }
+
+	const_iterator begin() const { return const_iterator(this, int(entries.size())-1); }
+	const_iterator element(int n) const { return const_iterator(this, int(entries.size())-1-n); }
+	const_iterator end() const { return const_iterator(nullptr, -1); }
+};
+
+template<typename K, typename OPS>
+class flat_pool
+{
+	template<typename, int, typename> friend class idict;
+
+protected:
+	struct entry_t
+	{
+		K udata;
+		Hasher::hash_t hash;
+
+		entry_t() { }
+		entry_t(const K &udata, Hasher::hash_t hash) : udata(udata), hash(hash) { }
+		entry_t(K &&udata, Hasher::hash_t hash) : udata(std::move(udata)), hash(hash) { }
+	};
+
+	flat_index index;
+	std::vector<entry_t> entries;
+	OPS ops;
+
+	Hasher::hash_t do_hash(const K &key) const
+	{
+		return ops.hash(key).yield();
+	}
+
+	void do_rehash(size_t min_entries)
+	{
+		count_rehash();
+		index.reset(std::max(min_entries, entries.size()));
+		for (int i = 0; i < int(entries.size()); i++)
+			index.insert(entries[i].hash, i);
+	}
+
+	int do_lookup(const K &key, Hasher::hash_t hash) const
+	{
+		return index.find(hash, [&](int i) {
+			return entries[i].hash == hash && ops.cmp(entries[i].udata, key);
+		});
+	}
+
+	template<typename V>
+	int do_insert(V &&value, Hasher::hash_t hash)
+	{
+		if (index.full())
+			do_rehash(entries.size() + 1);
+		entries.emplace_back(std::forward<V>(value), hash);
+		index.insert(hash, entries.size() - 1);
+		return entries.size() - 1;
+	}
+
+	int do_erase(int i)
+	{
+		if (i < 0)
+			return 0;
+
+		index.erase(entries[i].hash, i);
+
+		int back_idx = entries.size()-1;
+		if (i != back_idx) {
+			index.relocate(entries[back_idx].hash, back_idx, i);
+			entries[i] = std::move(entries[back_idx]);
+		}
+		entries.pop_back();
+
+		if (entries.empty())
+			index.clear();
+		return 1;
+	}
+
+public:
+	class const_iterator
+	{
+		friend class flat_pool;
+	protected:
+		const flat_pool *ptr;
+		int index;
+		const_iterator(const flat_pool *ptr, int index) : ptr(ptr), index(index) { }
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef K value_type;
+		typedef ptrdiff_t difference_type;
+		typedef K* pointer;
+		typedef K& reference;
+		const_iterator() { }
+		const_iterator operator++() { index--; return *this; }
+		bool operator==(const const_iterator &other) const { return index == other.index; }
+		bool operator!=(const const_iterator &other) const { return index != other.index; }
+		const K &operator*() const { return ptr->entries[index].udata; }
+		const K *operator->() const { return &ptr->entries[index].udata; }
+	};
+
+	class iterator
+	{
+		friend class flat_pool;
+	protected:
+		flat_pool *ptr;
+		int index;
+		iterator(flat_pool *ptr, int index) : ptr(ptr), index(index) { }
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef K value_type;
+		typedef ptrdiff_t difference_type;
+		typedef K* pointer;
+		typedef K& reference;
+		iterator() { }
+		iterator operator++() { index--; return *this; }
+		bool operator==(const iterator &other) const { return index == other.index; }
+		bool operator!=(const iterator &other) const { return index != other.index; }
+		K &operator*() { return ptr->entries[index].udata; }
+		K *operator->() { return &ptr->entries[index].udata; }
+		const K &operator*() const { return ptr->entries[index].udata; }
+		const K *operator->() const { return &ptr->entries[index].udata; }
+		operator const_iterator() const { return const_iterator(ptr, index); }
+	};
+
+	flat_pool()
+	{
+	}
+
+	flat_pool(const flat_pool &other)
+	{
+		entries = other.entries;
+		do_rehash(entries.size());
+	}
+
+	flat_pool(flat_pool &&other)
+	{
+		swap(other);
+	}
+
+	flat_pool &operator=(const flat_pool &other) {
+		entries = other.entries;
+		do_rehash(entries.size());
+		return *this;
+	}
+
+	flat_pool &operator=(flat_pool &&other) {
+		clear();
+		swap(other);
+		return *this;
+	}
+
+	flat_pool(const std::initializer_list<K> &list)
+	{
+		for (auto &it : list)
+			insert(it);
+	}
+
+	template<class InputIterator>
+	flat_pool(InputIterator first, InputIterator last)
+	{
+		insert(first, last);
+	}
+
+	template<class InputIterator>
+	void insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
+	std::pair<iterator, bool> insert(const K &value)
+	{
+		Hasher::hash_t hash = do_hash(value);
+		int i = do_lookup(value, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(value, hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	std::pair<iterator, bool> insert(K &&rvalue)
+	{
+		Hasher::hash_t hash = do_hash(rvalue);
+		int i = do_lookup(rvalue, hash);
+		if (i >= 0)
+			return std::pair<iterator, bool>(iterator(this, i), false);
+		i = do_insert(std::move(rvalue), hash);
+		return std::pair<iterator, bool>(iterator(this, i), true);
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		return insert(K(std::forward<Args>(args)...));
+	}
+
+	int erase(const K &key)
+	{
+		return do_erase(do_lookup(key, do_hash(key)));
+	}
+
+	iterator erase(iterator it)
+	{
+		do_erase(it.index);
+		return ++it;
+	}
+
+	int count(const K &key) const
+	{
+		return do_lookup(key, do_hash(key)) < 0 ? 0 : 1;
+	}
+
+	int count(const K &key, const_iterator it) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		return i < 0 || i > it.index ? 0 : 1;
+	}
+
+	iterator find(const K &key)
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return end();
+		return iterator(this, i);
+	}
+
+	const_iterator find(const K &key) const
+	{
+		int i = do_lookup(key, do_hash(key));
+		if (i < 0)
+			return end();
+		return const_iterator(this, i);
+	}
+
+	bool operator[](const K &key) const
+	{
+		return do_lookup(key, do_hash(key)) >= 0;
+	}
+
+	template<typename Compare = std::less<K>>
+	void sort(Compare comp = Compare())
+	{
+		std::sort(entries.begin(), entries.end(), [comp](const entry_t &a, const entry_t &b){ return comp(b.udata, a.udata); });
+		do_rehash(entries.size());
+	}
+
+	K pop()
+	{
+		iterator it = begin();
+		K ret = *it;
+		erase(it);
+		return ret;
+	}
+
+	void swap(flat_pool &other)
+	{
+		index.swap(other.index);
+		entries.swap(other.entries);
+	}
+
+	bool operator==(const flat_pool &other) const {
+		if (size() != other.size())
+			return false;
+		for (auto &it : entries)
+			if (!other.count(it.udata))
+				return false;
+		return true;
+	}
+
+	bool operator!=(const flat_pool &other) const {
+		return !operator==(other);
+	}
+
+	[[nodiscard]] Hasher hash_into(Hasher h) const {
+		for (auto &it : entries) {
+			h.commutative_eat(it.hash);
+		}
+		h.eat(entries.size());
+		return h;
+	}
+
+	void reserve(size_t n) {
+		entries.reserve(n);
+		if (2 * n > size_t(index.capacity()))
+			do_rehash(n);
+	}
+	size_t size() const { return entries.size(); }
+	bool empty() const { return entries.empty(); }
+	void clear() { index.clear(); entries.clear(); }
+
+	iterator begin() { return iterator(this, int(entries.size())-1); }
+	iterator element(int n) { return iterator(this, int(entries.size())-1-n); }
+	iterator end() { return iterator(nullptr, -1); }
+
+	const_iterator begin() const { return const_iterator(this, int(entries.size())-1); }
+	const_iterator element(int n) const { return const_iterator(this, int(entries.size())-1-n); }
+	const_iterator end() const { return const_iterator(nullptr, -1); }
+};
+
 template<typename K, int offset, typename OPS>
 class idict
 {
-	pool<K, OPS> database;
+	flat_pool<K, OPS> database;
 
 public:
 	class const_iterator
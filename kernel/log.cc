@@ -29,12 +29,28 @@
 #  include <dlfcn.h>
 #endif
 
+#if defined(__linux__)
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+#if defined(__GLIBC__)
+#  include <malloc.h>
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
 #include <vector>
 #include <list>
+#include <deque>
+
+#ifdef YOSYS_ENABLE_THREADS
+#  include <thread>
+#  include <mutex>
+#  include <condition_variable>
+#endif
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -66,14 +82,145 @@ int log_force_debug = 0;
 int log_debug_suppressed = 0;
 
 vector<int> header_count;
-vector<char*> log_id_cache;
-vector<shared_str> string_buf;
-int string_buf_index = -1;
+thread_local vector<char*> log_id_cache;
+thread_local vector<shared_str> string_buf;
+thread_local int string_buf_index = -1;
+static thread_local LogBuffer *log_buffer = nullptr;
 
 static struct timeval initial_tv = { 0, 0 };
 static bool next_print_log = false;
 static int log_newline_count = 0;
 
+#ifdef YOSYS_ENABLE_THREADS
+// Background writer for log files, see log_async_begin(). Messages are queued
+// in order together with the files they go to. Consecutive messages for the
+// same files share one queue entry, so the writer does few large writes.
+struct AsyncLogWriter
+{
+	struct entry_t {
+		std::vector<FILE*> files;
+		std::string text;
+	};
+
+	pool<FILE*> files;
+	size_t max_bytes;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<entry_t> queue;
+	size_t queued_bytes = 0;
+	bool writing = false;
+	bool stopping = false;
+	std::thread thread;
+
+	AsyncLogWriter(const pool<FILE*> &files, size_t max_bytes) : files(files), max_bytes(max_bytes)
+	{
+		thread = std::thread([this]() { run(); });
+	}
+
+	~AsyncLogWriter()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cond.notify_all();
+		thread.join();
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (1) {
+			cond.wait(lock, [this]() { return !queue.empty() || stopping; });
+			if (queue.empty())
+				return;
+			entry_t entry = std::move(queue.front());
+			queue.pop_front();
+			queued_bytes -= entry.text.size();
+			writing = true;
+			lock.unlock();
+			cond.notify_all();
+			for (auto f : entry.files)
+				fwrite(entry.text.data(), 1, entry.text.size(), f);
+			lock.lock();
+			writing = false;
+			cond.notify_all();
+		}
+	}
+
+	// blocks while more than max_bytes are waiting to be written
+	void write(const std::vector<FILE*> &to, const std::string &text)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this]() { return queued_bytes < max_bytes; });
+		if (!queue.empty() && queue.back().files == to)
+			queue.back().text += text;
+		else
+			queue.push_back({to, text});
+		queued_bytes += text.size();
+		lock.unlock();
+		cond.notify_all();
+	}
+
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this]() { return queue.empty() && !writing; });
+		for (auto f : files)
+			fflush(f);
+	}
+};
+
+static AsyncLogWriter *log_async_writer = nullptr;
+#endif
+
+void log_async_begin(size_t max_bytes)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	log_async_end();
+	pool<FILE*> files;
+	for (auto f : log_files)
+		if (f != stdout && f != stderr)
+			files.insert(f);
+	if (!files.empty())
+		log_async_writer = new AsyncLogWriter(files, max_bytes);
+#else
+	(void)max_bytes;
+#endif
+}
+
+void log_async_end()
+{
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_async_writer != nullptr) {
+		log_async_writer->flush();
+		delete log_async_writer;
+		log_async_writer = nullptr;
+	}
+#endif
+}
+
+static void log_write_files(const std::string &str)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_async_writer != nullptr) {
+		static std::vector<FILE*> async_files;
+		async_files.clear();
+		for (auto f : log_files)
+			if (log_async_writer->files.count(f))
+				async_files.push_back(f);
+			else
+				fputs(str.c_str(), f);
+		if (!async_files.empty())
+			log_async_writer->write(async_files, str);
+		return;
+	}
+#endif
+	for (auto f : log_files)
+		fputs(str.c_str(), f);
+}
+
 static void log_id_cache_clear()
 {
 	for (auto p : log_id_cache)
@@ -111,11 +258,30 @@ void logv(const char *format, va_list ap)
 	if (log_make_debug && !ys_debug(1))
 		return;
 
+	// Nothing would see the message, don't even format it. The trailing
+	// newlines for log_spacer() are usually part of the format string.
+	if (log_buffer == nullptr && log_files.empty() && log_streams.empty() && log_hasher == nullptr &&
+			log_scratchpads.empty() && log_warn_regexes.empty() && log_expect_log.empty()) {
+		int len = strlen(format), nnl_pos = len - 1;
+		while (nnl_pos >= 0 && format[nnl_pos] == '\n')
+			nnl_pos--;
+		if (nnl_pos < 0)
+			log_newline_count += len;
+		else
+			log_newline_count = len - nnl_pos - 1;
+		return;
+	}
+
 	std::string str = vstringf(format, ap);
 
 	if (str.empty())
 		return;
 
+	if (log_buffer != nullptr) {
+		log_buffer->entries.push_back({LogBuffer::MESSAGE, std::string(), str});
+		return;
+	}
+
 	size_t nnl_pos = str.find_last_not_of('\n');
 	if (nnl_pos == std::string::npos)
 		log_newline_count += GetSize(str);
@@ -153,15 +319,13 @@ void logv(const char *format, va_list ap)
 		if (!strcmp(format, "%s") && str.back() == '\n')
 			next_print_log = true;
 
-		for (auto f : log_files)
-			fputs(time_str.c_str(), f);
+		log_write_files(time_str);
 
 		for (auto f : log_streams)
 			*f << time_str;
 	}
 
-	for (auto f : log_files)
-		fputs(str.c_str(), f);
+	log_write_files(str);
 
 	for (auto f : log_streams)
 		*f << str;
@@ -207,6 +371,9 @@ void logv_header(RTLIL::Design *design, const char *format, va_list ap)
 {
 	bool pop_errfile = false;
 
+	// headers (and the design dumps they might trigger) are main thread only
+	log_assert(log_buffer == nullptr);
+
 	log_spacer();
 	if (header_count.size() > 0)
 		header_count.back()++;
@@ -248,6 +415,11 @@ static void logv_warning_with_prefix(const char *prefix,
 	std::string message = vstringf(format, ap);
 	bool suppressed = false;
 
+	if (log_buffer != nullptr) {
+		log_buffer->entries.push_back({LogBuffer::WARNING, prefix, message});
+		return;
+	}
+
 	for (auto &re : log_nowarn_regexes)
 		if (std::regex_search(message, re))
 			suppressed = true;
@@ -298,6 +470,14 @@ static void logv_warning_with_prefix(const char *prefix,
 	}
 }
 
+static void log_warning_with_prefix(const char *prefix, const char *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	logv_warning_with_prefix(prefix, format, ap);
+	va_end(ap);
+}
+
 void logv_warning(const char *format, va_list ap)
 {
 	logv_warning_with_prefix("Warning: ", format, ap);
@@ -334,6 +514,9 @@ void log_file_info(const std::string &filename, int lineno,
 static void logv_error_with_prefix(const char *prefix,
                                    const char *format, va_list ap)
 {
+	if (log_buffer != nullptr)
+		throw log_buffered_error{false, prefix, vstringf(format, ap)};
+
 #ifdef EMSCRIPTEN
 	auto backup_log_files = log_files;
 #endif
@@ -379,6 +562,14 @@ static void logv_error_with_prefix(const char *prefix,
 #endif
 }
 
+[[noreturn]]
+static void log_error_with_prefix(const char *prefix, const char *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	logv_error_with_prefix(prefix, format, ap);
+}
+
 void logv_error(const char *format, va_list ap)
 {
 	logv_error_with_prefix("ERROR: ", format, ap);
@@ -457,6 +648,9 @@ void log_cmd_error(const char *format, ...)
 	va_list ap;
 	va_start(ap, format);
 
+	if (log_buffer != nullptr)
+		throw log_buffered_error{true, std::string(), vstringf(format, ap)};
+
 	if (log_cmd_error_throw) {
 		log_last_error = vstringf(format, ap);
 
@@ -482,6 +676,10 @@ void log_cmd_error(const char *format, ...)
 
 void log_spacer()
 {
+	if (log_buffer != nullptr) {
+		log_buffer->entries.push_back({LogBuffer::SPACER, std::string(), std::string()});
+		return;
+	}
 	if (log_newline_count < 2) log("\n");
 	if (log_newline_count < 2) log("\n");
 }
@@ -609,6 +807,14 @@ void log_reset_stack()
 
 void log_flush()
 {
+	if (log_buffer != nullptr)
+		return;
+
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_async_writer != nullptr)
+		log_async_writer->flush();
+#endif
+
 	for (auto f : log_files)
 		fflush(f);
 
@@ -616,6 +822,149 @@ void log_flush()
 		f->flush();
 }
 
+void LogBuffer::replay()
+{
+	for (auto &entry : entries)
+		switch (entry.kind) {
+		case MESSAGE:
+			log("%s", entry.text.c_str());
+			break;
+		case WARNING:
+			log_warning_with_prefix(entry.prefix.c_str(), "%s", entry.text.c_str());
+			break;
+		case SPACER:
+			log_spacer();
+			break;
+		}
+	entries.clear();
+}
+
+void log_buffered_error::raise() const
+{
+	if (cmd_error)
+		log_cmd_error("%s", message.c_str());
+	log_error_with_prefix(prefix.c_str(), "%s", message.c_str());
+}
+
+void log_buffer_install(LogBuffer *buffer)
+{
+	log_buffer = buffer;
+	if (buffer == nullptr) {
+		log_id_cache_clear();
+		string_buf.clear();
+		string_buf_index = -1;
+	}
+}
+
+bool log_buffer_active()
+{
+	return log_buffer != nullptr;
+}
+
+#if defined(__linux__)
+static int read_proc_file(const char *path, char *buffer, int size)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	int len = read(fd, buffer, size - 1);
+	close(fd);
+	if (len < 0)
+		len = 0;
+	buffer[len] = 0;
+	return len;
+}
+
+static bool peak_rss_resettable = true;
+#endif
+
+std::atomic<uint64_t> KernelStats::counters[KernelStats::NUM_COUNTERS];
+
+const char *const KernelStats::names[KernelStats::NUM_COUNTERS] = {
+	"sigspec_pack",
+	"sigspec_unpack",
+	"hashlib_rehash",
+	"wires_created",
+	"wires_destroyed",
+	"cells_created",
+	"cells_destroyed",
+};
+
+uint64_t KernelStats::get(counter_t c)
+{
+	// the hashlib counter lives in hashlib.h, which can't depend on the rest of the kernel
+	if (c == HASHLIB_REHASH)
+		return hashlib::rehash_counter.load(std::memory_order_relaxed);
+	return counters[c].load(std::memory_order_relaxed);
+}
+
+int KernelStats::idstring_count()
+{
+	int count = 0;
+	for (auto &shard : RTLIL::IdString::global_id_index_)
+		count += GetSize(shard);
+	return count;
+}
+
+int64_t MemoryUsage::current_rss()
+{
+#if defined(__linux__)
+	char buffer[128];
+	long long size, resident;
+	if (read_proc_file("/proc/self/statm", buffer, sizeof(buffer)) && sscanf(buffer, "%lld %lld", &size, &resident) == 2)
+		return resident * sysconf(_SC_PAGESIZE);
+#endif
+	return 0;
+}
+
+int64_t MemoryUsage::peak_rss()
+{
+#if defined(__linux__)
+	char buffer[4096];
+	if (read_proc_file("/proc/self/status", buffer, sizeof(buffer))) {
+		const char *p = strstr(buffer, "VmHWM:");
+		long long kb;
+		if (p && sscanf(p + 6, "%lld", &kb) == 1)
+			return kb * 1024;
+	}
+#endif
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__APPLE__)
+	struct rusage ru_buffer;
+	if (getrusage(RUSAGE_SELF, &ru_buffer) == 0) {
+#  if defined(__APPLE__)
+		return ru_buffer.ru_maxrss;
+#  else
+		return ru_buffer.ru_maxrss * 1024LL;
+#  endif
+	}
+#endif
+	return 0;
+}
+
+void MemoryUsage::reset_peak_rss()
+{
+#if defined(__linux__)
+	// "5" resets VmHWM to the current RSS, supported since Linux 4.0
+	if (peak_rss_resettable) {
+		int fd = open("/proc/self/clear_refs", O_WRONLY);
+		if (fd < 0 || write(fd, "5", 1) != 1)
+			peak_rss_resettable = false;
+		if (fd >= 0)
+			close(fd);
+	}
+#endif
+}
+
+int64_t MemoryUsage::heap_in_use()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 mi = mallinfo2();
+	return mi.uordblks + mi.hblkhd;
+#else
+	return 0;
+#endif
+}
+
 void log_dump_val_worker(RTLIL::IdString v) {
 	log("%s", log_id(v));
 }
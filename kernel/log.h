@@ -189,6 +189,41 @@ void log_backtrace(const char *prefix, int levels);
 void log_reset_stack();
 void log_flush();
 
+// Write the current log files (except stdout and stderr) from a background
+// thread, with at most max_bytes waiting to be written. Writes to the log
+// would only block if the writer falls behind by that much. log_flush() waits
+// until everything is written, so a file must not be closed before calling
+// log_flush() or log_async_end(). No-op in builds without threads.
+void log_async_begin(size_t max_bytes = 4 << 20);
+void log_async_end();
+
+// Log output of worker threads (see Pass::parallel_modules()). While a buffer
+// is installed on the current thread, messages and warnings are recorded
+// instead of being printed and errors are thrown as log_buffered_error. The
+// main thread then replays the buffers in a deterministic order.
+struct LogBuffer
+{
+	enum Kind { MESSAGE, WARNING, SPACER };
+	struct Entry {
+		Kind kind;
+		std::string prefix, text;
+	};
+	std::vector<Entry> entries;
+
+	void replay();
+	void clear() { entries.clear(); }
+};
+
+struct log_buffered_error
+{
+	bool cmd_error;
+	std::string prefix, message;
+	[[noreturn]] void raise() const;
+};
+
+void log_buffer_install(LogBuffer *buffer);
+bool log_buffer_active();
+
 struct LogExpectedItem
 {
 	LogExpectedItem(const std::regex &pat, int expected) :
@@ -338,6 +373,48 @@ struct PerformanceTimer
 #endif
 };
 
+// process memory probes for the per-pass statistics, all values in bytes
+// and zero where the platform has no way of measuring them
+struct MemoryUsage
+{
+	static int64_t current_rss();
+
+	// peak RSS since the last reset_peak_rss(), or since process start on
+	// platforms where the peak can't be reset
+	static int64_t peak_rss();
+	static void reset_peak_rss();
+
+	// bytes currently allocated from the heap
+	static int64_t heap_in_use();
+};
+
+// Cheap process-wide event counters of the kernel, for tracking the
+// performance of a flow across Yosys versions. Each pass accounts for the
+// counts that happen while it runs, see Pass::kernel_stats_delta. Printed by
+// `internal_stats` and written to the `-P` performance log.
+struct KernelStats
+{
+	enum counter_t {
+		SIGSPEC_PACK,
+		SIGSPEC_UNPACK,
+		HASHLIB_REHASH,
+		WIRES_CREATED,
+		WIRES_DESTROYED,
+		CELLS_CREATED,
+		CELLS_DESTROYED,
+		NUM_COUNTERS
+	};
+
+	static std::atomic<uint64_t> counters[NUM_COUNTERS];
+	static const char *const names[NUM_COUNTERS];
+
+	static inline void inc(counter_t c) { counters[c].fetch_add(1, std::memory_order_relaxed); }
+	static uint64_t get(counter_t c);
+
+	// number of IdStrings currently in the table
+	static int idstring_count();
+};
+
 // simple API for quickly dumping values when debugging
 
 static inline void log_dump_val_worker(short v) { log("%d", v); }
@@ -52,6 +52,42 @@ void Mem::remove() {
 	}
 }
 
+namespace {
+
+	// Returns true if init_data is what get_init_data() would return for
+	// this memory, so that emit() can keep the INIT parameter of a packed
+	// memory cell instead of building it again.  This holds for the inits
+	// created by mem_from_cell as long as they were not changed.  Returns
+	// false when it cannot tell cheaply (e.g. overlapping inits).
+	bool init_data_matches(const Mem &mem, Const &init_data) {
+		if (GetSize(init_data) != mem.width * mem.size)
+			return false;
+		const std::vector<State> &bits = init_data.bits();
+		int pos = 0;
+		for (auto &init : mem.inits) {
+			if (init.removed)
+				continue;
+			if (!init.en.is_fully_ones())
+				return false;
+			int offset = (init.addr.as_int() - mem.start_offset) * mem.width;
+			int len = GetSize(init.data);
+			if (offset < pos || offset + len > GetSize(bits))
+				return false;
+			for (; pos < offset; pos++)
+				if (bits[pos] != State::Sx)
+					return false;
+			for (auto bit : init.data)
+				if (bits[pos++] != bit)
+					return false;
+		}
+		for (; pos < GetSize(bits); pos++)
+			if (bits[pos] != State::Sx)
+				return false;
+		return true;
+	}
+
+}
+
 void Mem::emit() {
 	check();
 	std::vector<int> rd_left;
@@ -260,7 +296,9 @@ void Mem::emit() {
 				init.cell = nullptr;
 			}
 		}
-		cell->parameters[ID::INIT] = get_init_data();
+		auto init_param = cell->parameters.find(ID::INIT);
+		if (init_param == cell->parameters.end() || !init_data_matches(*this, init_param->second))
+			cell->parameters[ID::INIT] = get_init_data();
 	} else {
 		if (cell) {
 			module->remove(cell);
@@ -440,17 +478,45 @@ void Mem::coalesce_inits() {
 
 Const Mem::get_init_data() const {
 	Const init_data(State::Sx, width * size);
+	std::vector<State> &bits = init_data.bits();
 	for (auto &init : inits) {
 		if (init.removed)
 			continue;
 		int offset = (init.addr.as_int() - start_offset) * width;
-		for (int i = 0; i < GetSize(init.data); i++)
-			if (0 <= i+offset && i+offset < GetSize(init_data) && init.en[i % width] == State::S1)
-				init_data.bits()[i+offset] = init.data[i];
+		bool all_en = init.en.is_fully_ones();
+		int begin = std::max(0, -offset);
+		int end = std::min(GetSize(init.data), GetSize(bits) - offset);
+		for (int i = begin; i < end; i++)
+			if (all_en || init.en[i % width] == State::S1)
+				bits[i+offset] = init.data[i];
 	}
 	return init_data;
 }
 
+MemContents Mem::get_init_contents() const {
+	MemContents contents(std::max(ceil_log2(size), 1), width);
+	for (auto &init : inits) {
+		if (init.removed)
+			continue;
+		int init_start = init.addr.as_int() - start_offset;
+		int begin = std::max(init_start, 0);
+		int end = std::min(init_start + GetSize(init.data) / width, size);
+		if (begin >= end)
+			continue;
+		Const data = init.data.extract((begin - init_start) * width, (end - begin) * width);
+		if (!init.en.is_fully_ones()) {
+			for (int i = begin; i < end; i++) {
+				Const prev = contents[i];
+				for (int j = 0; j < width; j++)
+					if (init.en[j] != State::S1)
+						data.bits()[(i - begin) * width + j] = prev[j];
+			}
+		}
+		contents.insert_concatenated(begin, data);
+	}
+	return contents;
+}
+
 void Mem::check() {
 	int max_wide_log2 = 0;
 	for (auto &port : rd_ports) {
@@ -705,16 +771,23 @@ namespace {
 		res.attributes = cell->attributes;
 		Const &init = cell->parameters.at(ID::INIT);
 		if (!init.is_fully_undef()) {
+			const std::vector<State> &init_bits = init.bits();
+			// a word is initialized if any of its bits is neither x nor z
+			auto word_defined = [&](int pos) {
+				int end = std::min((pos + 1) * res.width, GetSize(init_bits));
+				for (int i = pos * res.width; i < end; i++)
+					if (init_bits[i] != State::Sx && init_bits[i] != State::Sz)
+						return true;
+				return false;
+			};
 			int pos = 0;
 			while (pos < res.size) {
-				Const word = init.extract(pos * res.width, res.width, State::Sx);
-				if (word.is_fully_undef()) {
+				if (!word_defined(pos)) {
 					pos++;
 				} else {
 					int epos;
 					for (epos = pos; epos < res.size; epos++) {
-						Const eword = init.extract(epos * res.width, res.width, State::Sx);
-						if (eword.is_fully_undef())
+						if (!word_defined(epos))
 							break;
 					}
 					MemInit minit;
@@ -833,9 +906,12 @@ namespace {
 
 std::vector<Mem> Mem::get_all_memories(Module *module) {
 	std::vector<Mem> res;
-	MemIndex index(module);
-	for (auto it: module->memories) {
-		res.push_back(mem_from_memory(module, it.second, index));
+	// the index of port cells is only needed for unpacked memories
+	if (!module->memories.empty()) {
+		MemIndex index(module);
+		for (auto it: module->memories) {
+			res.push_back(mem_from_memory(module, it.second, index));
+		}
 	}
 	for (auto cell: module->cells()) {
 		if (cell->type.in(ID($mem), ID($mem_v2)))
@@ -846,10 +922,13 @@ std::vector<Mem> Mem::get_all_memories(Module *module) {
 
 std::vector<Mem> Mem::get_selected_memories(Module *module) {
 	std::vector<Mem> res;
-	MemIndex index(module);
+	std::unique_ptr<MemIndex> index;
 	for (auto it: module->memories) {
-		if (module->design->selected(module, it.second))
-			res.push_back(mem_from_memory(module, it.second, index));
+		if (!module->design->selected(module, it.second))
+			continue;
+		if (!index)
+			index.reset(new MemIndex(module));
+		res.push_back(mem_from_memory(module, it.second, *index));
 	}
 	for (auto cell: module->selected_cells()) {
 		if (cell->type.in(ID($mem), ID($mem_v2)))
@@ -89,6 +89,8 @@ struct MemInit : RTLIL::AttrObject {
 	MemInit() : removed(false), cell(nullptr) {}
 };
 
+class MemContents;
+
 struct Mem : RTLIL::AttrObject {
 	Module *module;
 	IdString memid;
@@ -130,6 +132,11 @@ struct Mem : RTLIL::AttrObject {
 	// the whole memory.  For all non-initialized bits, Sx will be returned.
 	Const get_init_data() const;
 
+	// Like get_init_data, but only stores the initialized words, indexed
+	// by their address minus start_offset.  Use this instead of
+	// get_init_data when looking at individual words of a large memory.
+	MemContents get_init_contents() const;
+
 	// Constructs and returns the helper structures for all memories
 	// in a module.
 	static std::vector<Mem> get_all_memories(Module *module);
@@ -0,0 +1,138 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/modgraph.h"
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+// counting sort of (net, port) entries into offset and port arrays
+void build_ranges(int num_nets, const std::vector<std::pair<int, ModuleGraph::PortBit>> &entries,
+		std::vector<int> &offsets, std::vector<ModuleGraph::PortBit> &ports)
+{
+	offsets.assign(num_nets + 1, 0);
+	for (auto const &entry : entries)
+		offsets[entry.first + 1]++;
+	for (int net = 0; net < num_nets; net++)
+		offsets[net + 1] += offsets[net];
+
+	ports.resize(entries.size());
+	std::vector<int> pos(offsets.begin(), offsets.end() - 1);
+	for (auto const &entry : entries)
+		ports[pos[entry.first]++] = entry.second;
+}
+
+} // namespace
+
+ModuleGraph::ModuleGraph(RTLIL::Module *module, const CellTypes *ct) : module(module)
+{
+	SigMap sigmap(module);
+
+	int num_bits = 0;
+	for (auto wire : module->wires()) {
+		wire_offsets[wire] = num_bits;
+		num_bits += wire->width;
+	}
+
+	// every wire bit points at the net of its canonical bit, which gets its
+	// index when it is seen first
+	bit_nets.assign(num_bits, -1);
+	for (auto wire : module->wires())
+		for (int i = 0; i < wire->width; i++) {
+			RTLIL::SigBit canonical = sigmap(RTLIL::SigBit(wire, i));
+			if (canonical.wire == nullptr)
+				continue;
+			int &net = bit_nets[wire_offsets.at(canonical.wire) + canonical.offset];
+			if (net < 0) {
+				net = GetSize(net_bits);
+				net_bits.push_back(canonical);
+			}
+			bit_nets[wire_offsets.at(wire) + i] = net;
+		}
+
+	net_flags.assign(num_nets(), 0);
+	for (auto wire : module->wires())
+		if (wire->port_input || wire->port_output)
+			for (int i = 0; i < wire->width; i++) {
+				int net = bit_nets[wire_offsets.at(wire) + i];
+				if (net >= 0)
+					net_flags[net] |= (wire->port_input ? 1 : 0) | (wire->port_output ? 2 : 0);
+			}
+
+	std::vector<std::pair<int, PortBit>> driver_entries, sink_entries;
+	input_offsets.push_back(0);
+	output_offsets.push_back(0);
+	for (auto cell : module->cells()) {
+		int index = GetSize(cells_);
+		cells_.push_back(cell);
+		cell_indices[cell] = index;
+
+		bool known = ct && ct->cell_known(cell->type);
+		for (auto &conn : cell->connections()) {
+			bool is_input = known ? ct->cell_input(cell->type, conn.first) : cell->input(conn.first);
+			bool is_output = known ? ct->cell_output(cell->type, conn.first) : cell->output(conn.first);
+			for (int i = 0; i < GetSize(conn.second); i++) {
+				int net = net_index(conn.second[i]);
+				if (is_input) {
+					input_nets.push_back(net);
+					if (net >= 0)
+						sink_entries.push_back({net, {index, conn.first, i}});
+				}
+				if (is_output) {
+					output_nets.push_back(net);
+					if (net >= 0)
+						driver_entries.push_back({net, {index, conn.first, i}});
+				}
+			}
+		}
+
+		input_offsets.push_back(GetSize(input_nets));
+		output_offsets.push_back(GetSize(output_nets));
+	}
+
+	build_ranges(num_nets(), driver_entries, driver_offsets, driver_ports);
+	build_ranges(num_nets(), sink_entries, sink_offsets, sink_ports);
+}
+
+int ModuleGraph::cell_index(RTLIL::Cell *cell) const
+{
+	auto it = cell_indices.find(cell);
+	return it == cell_indices.end() ? -1 : it->second;
+}
+
+int ModuleGraph::net_index(RTLIL::SigBit bit) const
+{
+	if (bit.wire == nullptr)
+		return -1;
+	return bit_nets[wire_offsets.at(bit.wire) + bit.offset];
+}
+
+CsrGraph ModuleGraph::cell_graph() const
+{
+	std::vector<std::pair<int, int>> edges;
+	for (int net = 0; net < num_nets(); net++)
+		for (auto &driver : drivers(net))
+			for (auto &sink : sinks(net))
+				edges.emplace_back(driver.cell, sink.cell);
+	return CsrGraph(num_cells(), edges);
+}
+
+YOSYS_NAMESPACE_END
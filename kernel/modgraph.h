@@ -0,0 +1,111 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef MODGRAPH_H
+#define MODGRAPH_H
+
+#include "kernel/yosys.h"
+#include "kernel/celltypes.h"
+#include "kernel/topo_scc.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Frozen netlist view of a module for read-only analyses. Cells and nets
+// (bits after applying a SigMap) are numbered densely, and the drivers and
+// sinks of every net as well as the input and output nets of every cell are
+// stored as ranges of flat arrays. The view is built in a single pass and
+// does not keep a SigMap around, so it is much smaller than the usual
+// dict<SigBit, pool<...>> maps and can be shared by several analyses.
+//
+// The view is not updated when the module changes; build a new one after
+// modifying the module.
+struct ModuleGraph
+{
+	struct PortBit {
+		int cell;
+		RTLIL::IdString port;
+		int offset;
+	};
+
+	template<typename T>
+	struct Range {
+		const T *begin_, *end_;
+		const T *begin() const { return begin_; }
+		const T *end() const { return end_; }
+		int size() const { return end_ - begin_; }
+		bool empty() const { return begin_ == end_; }
+		const T &operator[](int index) const { return begin_[index]; }
+	};
+
+	RTLIL::Module *module;
+
+	// Port directions come from ct for the cell types it knows, and from
+	// Cell::input() and Cell::output() otherwise.
+	ModuleGraph(RTLIL::Module *module, const CellTypes *ct = nullptr);
+
+	int num_cells() const { return GetSize(cells_); }
+	int num_nets() const { return GetSize(net_bits); }
+
+	RTLIL::Cell *cell(int index) const { return cells_[index]; }
+	// -1 for cells that are not part of the module
+	int cell_index(RTLIL::Cell *cell) const;
+
+	// the canonical bit of a net
+	RTLIL::SigBit net(int index) const { return net_bits[index]; }
+	// -1 for constant bits
+	int net_index(RTLIL::SigBit bit) const;
+
+	Range<PortBit> drivers(int net) const {
+		return {driver_ports.data() + driver_offsets[net], driver_ports.data() + driver_offsets[net + 1]};
+	}
+	Range<PortBit> sinks(int net) const {
+		return {sink_ports.data() + sink_offsets[net], sink_ports.data() + sink_offsets[net + 1]};
+	}
+
+	// one net per bit of each input (or output) port, in connection order,
+	// with -1 for constant bits
+	Range<int> cell_inputs(int cell) const {
+		return {input_nets.data() + input_offsets[cell], input_nets.data() + input_offsets[cell + 1]};
+	}
+	Range<int> cell_outputs(int cell) const {
+		return {output_nets.data() + output_offsets[cell], output_nets.data() + output_offsets[cell + 1]};
+	}
+
+	bool is_module_input(int net) const { return net_flags[net] & 1; }
+	bool is_module_output(int net) const { return net_flags[net] & 2; }
+
+	// cell to cell graph with an edge from each driver to each sink of a net
+	CsrGraph cell_graph() const;
+
+private:
+	std::vector<RTLIL::Cell*> cells_;
+	dict<RTLIL::Cell*, int> cell_indices;
+	dict<RTLIL::Wire*, int> wire_offsets;
+	std::vector<int> bit_nets;
+	std::vector<RTLIL::SigBit> net_bits;
+	std::vector<char> net_flags;
+	std::vector<int> driver_offsets, sink_offsets;
+	std::vector<PortBit> driver_ports, sink_ports;
+	std::vector<int> input_offsets, output_offsets;
+	std::vector<int> input_nets, output_nets;
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -58,19 +58,21 @@ struct ModIndex : public RTLIL::Monitor
 
 	struct SigBitInfo
 	{
-		bool is_input, is_output;
+		// is_keep: the bit is on a wire with the keep attribute (as of the last reload)
+		bool is_input, is_output, is_keep;
 		pool<PortInfo> ports;
 
-		SigBitInfo() : is_input(false), is_output(false) { }
+		SigBitInfo() : is_input(false), is_output(false), is_keep(false) { }
 
 		bool operator==(const SigBitInfo &other) const {
-			return is_input == other.is_input && is_output == other.is_output && ports == other.ports;
+			return is_input == other.is_input && is_output == other.is_output && is_keep == other.is_keep && ports == other.ports;
 		}
 
 		void merge(const SigBitInfo &other)
 		{
 			is_input = is_input || other.is_input;
 			is_output = is_output || other.is_output;
+			is_keep = is_keep || other.is_keep;
 			ports.insert(other.ports.begin(), other.ports.end());
 		}
 	};
@@ -81,6 +83,12 @@ struct ModIndex : public RTLIL::Monitor
 	int auto_reload_counter;
 	bool auto_reload_module;
 
+	// With track_released set, the (mapped) bits that lost a cell port since then, for passes that clean up
+	// after other passes (see `opt_clean -incremental`). Rebuilding the index clears track_released, since the
+	// changes that made the rebuild necessary are not known.
+	bool track_released = false;
+	pool<RTLIL::SigBit> released;
+
 	void port_add(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig)
 	{
 		for (int i = 0; i < GetSize(sig); i++) {
@@ -94,8 +102,11 @@ struct ModIndex : public RTLIL::Monitor
 	{
 		for (int i = 0; i < GetSize(sig); i++) {
 			RTLIL::SigBit bit = sigmap(sig[i]);
-			if (bit.wire)
+			if (bit.wire) {
 				database[bit].ports.erase(PortInfo(cell, port, i));
+				if (track_released)
+					released.insert(bit);
+			}
 		}
 	}
 
@@ -109,18 +120,24 @@ struct ModIndex : public RTLIL::Monitor
 		if (reset_sigmap) {
 			sigmap.clear();
 			sigmap.set(module);
+			track_released = false;
+			released.clear();
 		}
 
 		database.clear();
-		for (auto wire : module->wires())
-			if (wire->port_input || wire->port_output)
+		for (auto wire : module->wires()) {
+			bool is_keep = wire->get_bool_attribute(ID::keep);
+			if (wire->port_input || wire->port_output || is_keep)
 				for (int i = 0; i < GetSize(wire); i++) {
 					RTLIL::SigBit bit = sigmap(RTLIL::SigBit(wire, i));
 					if (bit.wire && wire->port_input)
 						database[bit].is_input = true;
 					if (bit.wire && wire->port_output)
 						database[bit].is_output = true;
+					if (bit.wire && is_keep)
+						database[bit].is_keep = true;
 				}
+		}
 		for (auto cell : module->cells())
 			for (auto &conn : cell->connections())
 				port_add(cell, conn.first, conn.second);
@@ -241,6 +258,30 @@ struct ModIndex : public RTLIL::Monitor
 		module->monitors.erase(this);
 	}
 
+	// Returns an index for the module that is kept alive across passes and
+	// updated through the monitor callbacks, so it only has to be rebuilt
+	// after a blackout. The index is owned by the module and is dropped
+	// after every pass that is not marked with Pass::keeps_indexes(), since
+	// such a pass may have modified the module without notifications.
+	static ModIndex &cached(RTLIL::Module *module)
+	{
+		ModIndex *index = static_cast<ModIndex*>(module->cached_index_);
+		if (index == nullptr) {
+			index = new ModIndex(module);
+			module->cached_index_ = index;
+		}
+		index->auto_reload_counter = 0;
+		if (index->auto_reload_module)
+			index->reload_module();
+		return *index;
+	}
+
+	static void drop_cached(RTLIL::Module *module)
+	{
+		delete module->cached_index_;
+		module->cached_index_ = nullptr;
+	}
+
 	SigBitInfo *query(RTLIL::SigBit bit)
 	{
 		if (auto_reload_module)
@@ -75,6 +75,258 @@ void QuickConeSat::prepare()
 	}
 }
 
+std::vector<bool> QuickConeSat::solveBatch(const std::vector<std::vector<int>> &queries)
+{
+	std::vector<bool> result(GetSize(queries), false);
+
+	std::vector<int> open;
+	for (int i = 0; i < GetSize(queries); i++)
+		open.push_back(i);
+
+	// The queries before `head` in `open` have turned out to be unsatisfiable,
+	// their literals are still part of the model but not looked at.
+	int head = 0;
+	std::vector<int> model_exprs, model_offsets;
+	std::vector<bool> model;
+
+	auto collect_model_exprs = [&]() {
+		model_exprs.clear();
+		model_offsets.clear();
+		for (int i : open) {
+			model_offsets.push_back(GetSize(model_exprs));
+			model_exprs.insert(model_exprs.end(), queries[i].begin(), queries[i].end());
+		}
+	};
+	collect_model_exprs();
+
+	while (head < GetSize(open))
+	{
+		if (!ez->solve(model_exprs, model, queries[open[head]])) {
+			head++;
+			continue;
+		}
+
+		std::vector<int> still_open;
+		for (int k = head; k < GetSize(open); k++) {
+			const std::vector<int> &query = queries[open[k]];
+			bool satisfied = true;
+			for (int j = 0; j < GetSize(query) && satisfied; j++)
+				satisfied = model[model_offsets[k] + j];
+			if (satisfied)
+				result[open[k]] = true;
+			else
+				still_open.push_back(open[k]);
+		}
+
+		open.swap(still_open);
+		head = 0;
+		collect_model_exprs();
+	}
+
+	return result;
+}
+
+bool QuickConeSat::simulate(const std::vector<RTLIL::SigBit> &bits, int rounds, std::vector<std::vector<uint64_t>> &values)
+{
+	values.clear();
+
+	// the one-hot constraints are not part of the netlist
+	if (!imported_onehot.empty())
+		return false;
+
+	dict<SigBit, Cell*> drivers;
+	for (auto cell : imported_cells) {
+		if (!cell->type.in(ID($not), ID($pos), ID($buf), ID($and), ID($or), ID($xor), ID($xnor),
+				ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool),
+				ID($logic_not), ID($logic_and), ID($logic_or), ID($eq), ID($ne), ID($mux),
+				ID($_BUF_), ID($_NOT_), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_),
+				ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_NMUX_)))
+			return false;
+		// a cell driving a constant, or a bit driven by more than one cell,
+		// constrains the signals in its input cone
+		for (auto bit : modwalker.sigmap(cell->getPort(ID::Y))) {
+			if (bit.wire == nullptr || drivers.count(bit))
+				return false;
+			drivers[bit] = cell;
+		}
+	}
+
+	// data[slot*rounds + r] is word r of the values of a bit, slots 0 and 1
+	// hold the constants (SatGen imports x and z bits as 0)
+	std::vector<uint64_t> data(2 * rounds, 0);
+	std::fill(data.begin() + rounds, data.end(), ~uint64_t(0));
+	dict<SigBit, int> slots;
+	uint64_t rng_state = 0x2545f4914f6cdd1dULL;
+
+	// returns the slot of a bit, or -1 if its driver wasn't simulated yet
+	auto slot = [&](SigBit bit) -> int {
+		if (bit.wire == nullptr)
+			return bit == State::S1 ? 1 : 0;
+		auto it = slots.find(bit);
+		if (it != slots.end())
+			return it->second;
+		if (drivers.count(bit))
+			return -1;
+		int s = GetSize(data) / rounds;
+		for (int r = 0; r < rounds; r++) {
+			rng_state ^= rng_state << 13;
+			rng_state ^= rng_state >> 7;
+			rng_state ^= rng_state << 17;
+			data.push_back(rng_state);
+		}
+		slots[bit] = s;
+		return s;
+	};
+
+	auto port_slots = [&](Cell *cell, IdString port, int width, bool is_signed) {
+		std::vector<int> result;
+		for (auto bit : modwalker.sigmap(cell->getPort(port)))
+			result.push_back(slot(bit));
+		while (GetSize(result) < width)
+			result.push_back(is_signed && !result.empty() ? result.back() : 0);
+		return result;
+	};
+
+	auto signed_param = [&](Cell *cell, IdString param) {
+		return cell->hasParam(param) && cell->getParam(param).as_bool();
+	};
+
+	auto eval_cell = [&](Cell *cell) {
+		std::vector<SigBit> sig_y = modwalker.sigmap(cell->getPort(ID::Y));
+		int width = GetSize(sig_y);
+		std::vector<uint64_t> out(width * rounds, 0);
+		auto word = [&](int s, int r) { return data[s * rounds + r]; };
+
+		if (cell->type.in(ID($not), ID($pos), ID($buf), ID($_BUF_), ID($_NOT_))) {
+			std::vector<int> a = port_slots(cell, ID::A, width, signed_param(cell, ID::A_SIGNED));
+			uint64_t inv = cell->type.in(ID($not), ID($_NOT_)) ? ~uint64_t(0) : 0;
+			for (int i = 0; i < width; i++)
+				for (int r = 0; r < rounds; r++)
+					out[i * rounds + r] = word(a[i], r) ^ inv;
+		} else if (cell->type.in(ID($mux), ID($_MUX_), ID($_NMUX_))) {
+			std::vector<int> a = port_slots(cell, ID::A, width, false);
+			std::vector<int> b = port_slots(cell, ID::B, width, false);
+			int s = port_slots(cell, ID::S, 1, false).at(0);
+			uint64_t inv = cell->type == ID($_NMUX_) ? ~uint64_t(0) : 0;
+			for (int i = 0; i < width; i++)
+				for (int r = 0; r < rounds; r++)
+					out[i * rounds + r] = ((word(s, r) & word(b[i], r)) | (~word(s, r) & word(a[i], r))) ^ inv;
+		} else if (cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor),
+				ID($reduce_bool), ID($logic_not), ID($logic_and), ID($logic_or))) {
+			auto reduce = [&](IdString port, IdString type, int r) {
+				uint64_t value = type == ID($reduce_and) ? ~uint64_t(0) : 0;
+				for (int s : port_slots(cell, port, 0, false)) {
+					if (type == ID($reduce_and))
+						value &= word(s, r);
+					else if (type.in(ID($reduce_xor), ID($reduce_xnor)))
+						value ^= word(s, r);
+					else
+						value |= word(s, r);
+				}
+				return type.in(ID($reduce_xnor), ID($logic_not)) ? ~value : value;
+			};
+			for (int r = 0; r < rounds && width > 0; r++) {
+				if (cell->type == ID($logic_and))
+					out[r] = reduce(ID::A, ID($reduce_or), r) & reduce(ID::B, ID($reduce_or), r);
+				else if (cell->type == ID($logic_or))
+					out[r] = reduce(ID::A, ID($reduce_or), r) | reduce(ID::B, ID($reduce_or), r);
+				else
+					out[r] = reduce(ID::A, cell->type, r);
+			}
+		} else {
+			// binary bitwise operations and $eq/$ne
+			bool is_signed = signed_param(cell, ID::A_SIGNED) && signed_param(cell, ID::B_SIGNED);
+			bool compare = cell->type.in(ID($eq), ID($ne));
+			int ext_width = std::max(GetSize(cell->getPort(ID::A)), GetSize(cell->getPort(ID::B)));
+			if (!compare)
+				ext_width = std::max(ext_width, width);
+			std::vector<int> a = port_slots(cell, ID::A, ext_width, is_signed);
+			std::vector<int> b = port_slots(cell, ID::B, ext_width, is_signed);
+			for (int r = 0; r < rounds; r++) {
+				uint64_t equal = ~uint64_t(0);
+				for (int i = 0; i < ext_width; i++) {
+					uint64_t va = word(a[i], r), vb = word(b[i], r), vy;
+					if (cell->type.in(ID($and), ID($_AND_)))
+						vy = va & vb;
+					else if (cell->type == ID($_NAND_))
+						vy = ~(va & vb);
+					else if (cell->type.in(ID($or), ID($_OR_)))
+						vy = va | vb;
+					else if (cell->type == ID($_NOR_))
+						vy = ~(va | vb);
+					else if (cell->type.in(ID($xor), ID($_XOR_)))
+						vy = va ^ vb;
+					else if (cell->type.in(ID($xnor), ID($_XNOR_)))
+						vy = ~(va ^ vb);
+					else if (cell->type == ID($_ANDNOT_))
+						vy = va & ~vb;
+					else if (cell->type == ID($_ORNOT_))
+						vy = va | ~vb;
+					else {
+						equal &= ~(va ^ vb);
+						continue;
+					}
+					if (i < width)
+						out[i * rounds + r] = vy;
+				}
+				if (compare && width > 0)
+					out[r] = cell->type == ID($eq) ? equal : ~equal;
+			}
+		}
+
+		for (int i = 0; i < width; i++) {
+			slots[sig_y[i]] = GetSize(data) / rounds;
+			data.insert(data.end(), out.begin() + i * rounds, out.begin() + (i + 1) * rounds);
+		}
+	};
+
+	// evaluates the drivers of a bit in topological order, returns false
+	// on a combinational loop
+	pool<Cell*> visited;
+	std::vector<Cell*> stack;
+	auto evaluate = [&](SigBit bit) {
+		if (slot(bit) >= 0)
+			return true;
+		stack.push_back(drivers.at(bit));
+		while (!stack.empty()) {
+			Cell *cell = stack.back();
+			if (slots.count(modwalker.sigmap(cell->getPort(ID::Y))[0])) {
+				stack.pop_back();
+				continue;
+			}
+			bool first_visit = visited.insert(cell).second;
+			bool ready = true;
+			for (auto &conn : cell->connections()) {
+				if (!cell->input(conn.first))
+					continue;
+				for (auto input_bit : modwalker.sigmap(conn.second))
+					if (slot(input_bit) < 0) {
+						if (!first_visit)
+							return false;
+						stack.push_back(drivers.at(input_bit));
+						ready = false;
+					}
+			}
+			if (ready) {
+				eval_cell(cell);
+				stack.pop_back();
+			}
+		}
+		return true;
+	};
+
+	std::vector<SigBit> mapped_bits = modwalker.sigmap(bits);
+	for (auto bit : mapped_bits)
+		if (!evaluate(bit))
+			return false;
+
+	for (auto bit : mapped_bits) {
+		int s = slot(bit);
+		values.emplace_back(data.begin() + s * rounds, data.begin() + (s + 1) * rounds);
+	}
+	return true;
+}
+
 int QuickConeSat::cell_complexity(RTLIL::Cell *cell)
 {
 	if (cell->type.in(ID($concat), ID($slice), ID($pos), ID($buf), ID($_BUF_)))
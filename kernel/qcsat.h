@@ -67,6 +67,23 @@ struct QuickConeSat {
 	// the SAT solver.
 	void prepare();
 
+	// Checks a batch of queries, each a set of literals that have to hold
+	// at the same time, and returns for each query whether it is
+	// satisfiable. The model found for one query is checked against the
+	// other open queries before solving them, so a batch of similar
+	// queries (e.g. about neighbouring FFs) takes far fewer solver calls
+	// than there are queries.
+	std::vector<bool> solveBatch(const std::vector<std::vector<int>> &queries);
+
+	// Simulates the imported cells for 64 * `rounds` pseudo-random values
+	// of the signals that the cone does not drive, and returns the values
+	// of the given bits, `rounds` words per bit. Each simulated assignment
+	// is a solution of the SAT model (without constraints added to `ez` by
+	// the caller), so a query that holds in one of them is satisfiable
+	// without asking the solver. Returns false if the imported cells can't
+	// be simulated exactly, e.g. because of unsupported cell types.
+	bool simulate(const std::vector<RTLIL::SigBit> &bits, int rounds, std::vector<std::vector<uint64_t>> &values);
+
 	// Returns the "complexity level" of a given cell.
 	static int cell_complexity(RTLIL::Cell *cell);
 };
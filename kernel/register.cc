@@ -19,70 +19,442 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#include "kernel/modtools.h"
 #include "kernel/json.h"
+#include "kernel/rtlil_binary.h"
+#include "kernel/contenthash.h"
+#include "kernel/spill.h"
+#ifdef YOSYS_ENABLE_THREADS
+#  include "libs/ezsat/ezportfolio.h"
+#endif
+#ifdef YOSYS_ENABLE_IPASIR
+#  include "libs/ezsat/ezipasir.h"
+#endif
 
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <chrono>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && !defined(__wasm)
+#  include <signal.h>
+#  include <sys/time.h>
+#  define YOSYS_ENABLE_PROFILER
+#endif
+
+#ifdef YOSYS_ENABLE_THREADS
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#endif
 
 #ifdef YOSYS_ENABLE_ZLIB
-#include <zlib.h>
+#  include <zlib.h>
+#endif
 
+#ifdef YOSYS_ENABLE_ZSTD
+#  include <zstd.h>
+#endif
+
+#if defined(YOSYS_ENABLE_ZLIB) || defined(YOSYS_ENABLE_ZSTD)
+#ifdef YOSYS_ENABLE_THREADS
+#  include <future>
+#endif
+
+USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
-#define GZ_BUFFER_SIZE 8192
-void decompress_gzip(const std::string &filename, std::stringstream &out)
-{
-	char buffer[GZ_BUFFER_SIZE];
-	int bytes_read;
-	gzFile gzf = gzopen(filename.c_str(), "rb");
-	while(!gzeof(gzf)) {
-		bytes_read = gzread(gzf, reinterpret_cast<void *>(buffer), GZ_BUFFER_SIZE);
-		out.write(buffer, bytes_read);
+#define GZ_BUFFER_SIZE 65536
+#define COMPRESS_BLOCK_SIZE (1 << 20)
+
+/*
+An output streambuf that collects data into blocks of COMPRESS_BLOCK_SIZE
+bytes and hands every full block, and the final partial block once the
+stream is finished, to compress_block().
+*/
+class block_streambuf : public std::streambuf {
+public:
+	block_streambuf() : block(COMPRESS_BLOCK_SIZE)
+	{
+		setp(block.data(), block.data() + block.size());
 	}
-	gzclose(gzf);
-}
+protected:
+	virtual void compress_block(const char *data, size_t size, bool last) = 0;
+	// called by the destructor of the derived class
+	void finish()
+	{
+		if (finished)
+			return;
+		finished = true;
+		compress_block(pbase(), pptr() - pbase(), true);
+	}
+	int_type overflow(int_type c) override
+	{
+		compress_block(pbase(), pptr() - pbase(), false);
+		setp(block.data(), block.data() + block.size());
+		if (!traits_type::eq_int_type(c, traits_type::eof())) {
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+	// data is compressed once a block is full, flushing does not force
+	// out partial blocks
+	int sync() override
+	{
+		return 0;
+	}
+private:
+	std::vector<char> block;
+	bool finished = false;
+};
+
+PRIVATE_NAMESPACE_END
+#endif
+
+#ifdef YOSYS_ENABLE_ZLIB
+PRIVATE_NAMESPACE_BEGIN
 
 /*
-An output stream that uses a stringbuf to buffer data internally,
-using zlib to write gzip-compressed data every time the stream is flushed.
+An input stream that decompresses a gzip file while it is being read.
+Seeking is supported through gzseek(), which decompresses from the start
+again when seeking backwards.
 */
-class gzip_ostream : public std::ostream  {
+class gzip_istream : public std::istream {
 public:
-	gzip_ostream() : std::ostream(nullptr)
+	gzip_istream() : std::istream(nullptr)
 	{
-		rdbuf(&outbuf);
+		rdbuf(&inbuf);
 	}
 	bool open(const std::string &filename)
 	{
-		return outbuf.open(filename);
+		return inbuf.open(filename);
 	}
 private:
-	class gzip_streambuf : public std::stringbuf {
+	class gzip_streambuf : public std::streambuf {
 	public:
-		gzip_streambuf() { };
+		gzip_streambuf() : buffer(GZ_BUFFER_SIZE) { }
 		bool open(const std::string &filename)
 		{
-			gzf = gzopen(filename.c_str(), "wb");
+			gzf = gzopen(filename.c_str(), "rb");
+			if (gzf != nullptr)
+				gzbuffer(gzf, GZ_BUFFER_SIZE);
 			return gzf != nullptr;
 		}
-		virtual int sync() override
+		int_type underflow() override
+		{
+			if (gptr() < egptr())
+				return traits_type::to_int_type(*gptr());
+			int bytes_read = gzread(gzf, reinterpret_cast<void *>(buffer.data()), buffer.size());
+			if (bytes_read < 0) {
+				int errnum;
+				log_error("Failed to decompress gzip input: %s\n", gzerror(gzf, &errnum));
+			}
+			if (bytes_read == 0)
+				return traits_type::eof();
+			setg(buffer.data(), buffer.data(), buffer.data() + bytes_read);
+			return traits_type::to_int_type(*gptr());
+		}
+		pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+		{
+			if (!(which & std::ios_base::in) || dir == std::ios_base::end)
+				return pos_type(off_type(-1));
+			if (dir == std::ios_base::cur) {
+				off_type pos = gztell(gzf) - (egptr() - gptr());
+				if (off == 0)
+					return pos_type(pos);
+				off += pos;
+			}
+			return seekpos(pos_type(off), which);
+		}
+		pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
 		{
-			gzwrite(gzf, reinterpret_cast<const void *>(str().c_str()), unsigned(str().size()));
-			str("");
-			return 0;
+			if (!(which & std::ios_base::in))
+				return pos_type(off_type(-1));
+			setg(buffer.data(), buffer.data(), buffer.data());
+			z_off_t result = gzseek(gzf, z_off_t(off_type(pos)), SEEK_SET);
+			return pos_type(off_type(result < 0 ? -1 : result));
 		}
 		virtual ~gzip_streambuf()
 		{
-			sync();
-			gzclose(gzf);
+			if (gzf != nullptr)
+				gzclose(gzf);
 		}
 	private:
 		gzFile gzf = nullptr;
+		std::vector<char> buffer;
+	} inbuf;
+};
+
+/*
+An output stream that writes a gzip file. The data is split into blocks
+that are compressed independently, each one using the end of the previous
+block as its dictionary, and concatenated as in pigz. With several threads
+the blocks are compressed in parallel.
+*/
+class gzip_ostream : public std::ostream {
+public:
+	gzip_ostream() : std::ostream(nullptr)
+	{
+		rdbuf(&outbuf);
+	}
+	bool open(const std::string &filename, int threads)
+	{
+		return outbuf.open(filename, threads);
+	}
+private:
+	class gzip_streambuf : public block_streambuf {
+	public:
+		bool open(const std::string &filename, int threads)
+		{
+			this->threads = threads;
+			file.open(filename.c_str(), std::ofstream::binary | std::ofstream::trunc);
+			if (file.fail())
+				return false;
+			// magic, deflate, no flags, no mtime, no extra flags, unix
+			static const char header[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3};
+			file.write(header, sizeof(header));
+			return true;
+		}
+		virtual ~gzip_streambuf()
+		{
+			if (!file.is_open())
+				return;
+			finish();
+			unsigned char trailer[8];
+			for (int i = 0; i < 4; i++) {
+				trailer[i] = (crc >> (8 * i)) & 0xff;
+				trailer[4 + i] = (total_size >> (8 * i)) & 0xff;
+			}
+			file.write(reinterpret_cast<const char *>(trailer), sizeof(trailer));
+		}
+	protected:
+		void compress_block(const char *data, size_t size, bool last) override
+		{
+			std::string input(data, size);
+			std::string dict = dictionary;
+			if (size >= 32768) {
+				dictionary.assign(data + size - 32768, 32768);
+			} else {
+				dictionary.append(data, size);
+				if (dictionary.size() > 32768)
+					dictionary.erase(0, dictionary.size() - 32768);
+			}
+
+#ifdef YOSYS_ENABLE_THREADS
+			if (threads > 1) {
+				pending.push_back(std::async(std::launch::async, deflate_block, std::move(input), std::move(dict), last));
+				while (!pending.empty() && (last || GetSize(pending) > threads)) {
+					write_block(pending.front().get());
+					pending.pop_front();
+				}
+				return;
+			}
+#endif
+			write_block(deflate_block(std::move(input), std::move(dict), last));
+		}
+	private:
+		struct compressed_block {
+			std::string data;
+			uLong crc;
+			size_t size;
+		};
+		static compressed_block deflate_block(std::string input, std::string dict, bool last)
+		{
+			compressed_block result;
+			result.size = input.size();
+			result.crc = crc32(0L, reinterpret_cast<const Bytef *>(input.data()), input.size());
+
+			z_stream zs;
+			memset(&zs, 0, sizeof(zs));
+			int ret = deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+			log_assert(ret == Z_OK);
+			if (!dict.empty())
+				deflateSetDictionary(&zs, reinterpret_cast<const Bytef *>(dict.data()), dict.size());
+
+			// every block but the last ends on a byte boundary without
+			// closing the deflate stream, so the blocks can be concatenated
+			int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+			zs.next_in = reinterpret_cast<Bytef *>(&input[0]);
+			zs.avail_in = input.size();
+			result.data.resize(deflateBound(&zs, input.size()) + 64);
+			size_t used = 0;
+			while (1) {
+				zs.next_out = reinterpret_cast<Bytef *>(&result.data[used]);
+				zs.avail_out = result.data.size() - used;
+				ret = deflate(&zs, flush);
+				log_assert(ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR);
+				used = result.data.size() - zs.avail_out;
+				if (zs.avail_out != 0 && (last ? ret == Z_STREAM_END : zs.avail_in == 0))
+					break;
+				result.data.resize(2 * result.data.size());
+			}
+			result.data.resize(used);
+			deflateEnd(&zs);
+			return result;
+		}
+		void write_block(const compressed_block &block)
+		{
+			file.write(block.data.data(), block.data.size());
+			crc = crc32_combine(crc, block.crc, block.size);
+			total_size += block.size;
+		}
+
+		std::ofstream file;
+		int threads = 1;
+		std::string dictionary;
+		uLong crc = crc32(0L, Z_NULL, 0);
+		uint64_t total_size = 0;
+#ifdef YOSYS_ENABLE_THREADS
+		std::deque<std::future<compressed_block>> pending;
+#endif
 	} outbuf;
 };
+
 PRIVATE_NAMESPACE_END
+#endif
+
+#ifdef YOSYS_ENABLE_ZSTD
+PRIVATE_NAMESPACE_BEGIN
+
+/*
+An input stream that decompresses a zstd file while it is being read.
+*/
+class zstd_istream : public std::istream {
+public:
+	zstd_istream() : std::istream(nullptr)
+	{
+		rdbuf(&inbuf);
+	}
+	bool open(const std::string &filename)
+	{
+		return inbuf.open(filename);
+	}
+private:
+	class zstd_streambuf : public std::streambuf {
+	public:
+		zstd_streambuf() : in_buffer(ZSTD_DStreamInSize()), out_buffer(ZSTD_DStreamOutSize()) { }
+		bool open(const std::string &filename)
+		{
+			file.open(filename.c_str(), std::ifstream::binary);
+			if (file.fail())
+				return false;
+			dctx = ZSTD_createDCtx();
+			return dctx != nullptr;
+		}
+		int_type underflow() override
+		{
+			if (gptr() < egptr())
+				return traits_type::to_int_type(*gptr());
+			while (1) {
+				// a full output buffer may leave data in the decoder
+				if (input.pos == input.size && !output_full) {
+					file.read(in_buffer.data(), in_buffer.size());
+					size_t bytes_read = file.gcount();
+					if (bytes_read == 0) {
+						if (frame_open)
+							log_error("Truncated zstd input.\n");
+						return traits_type::eof();
+					}
+					input = {in_buffer.data(), bytes_read, 0};
+				}
+				ZSTD_outBuffer output = {out_buffer.data(), out_buffer.size(), 0};
+				size_t ret = ZSTD_decompressStream(dctx, &output, &input);
+				if (ZSTD_isError(ret))
+					log_error("Failed to decompress zstd input: %s\n", ZSTD_getErrorName(ret));
+				frame_open = ret != 0;
+				output_full = output.pos == output.size;
+				if (output.pos > 0) {
+					setg(out_buffer.data(), out_buffer.data(), out_buffer.data() + output.pos);
+					return traits_type::to_int_type(*gptr());
+				}
+			}
+		}
+		virtual ~zstd_streambuf()
+		{
+			if (dctx != nullptr)
+				ZSTD_freeDCtx(dctx);
+		}
+	private:
+		std::ifstream file;
+		ZSTD_DCtx *dctx = nullptr;
+		std::vector<char> in_buffer, out_buffer;
+		ZSTD_inBuffer input = {nullptr, 0, 0};
+		bool frame_open = false, output_full = false;
+	} inbuf;
+};
 
+/*
+An output stream that writes a zstd file. With several threads, libzstd
+compresses in its own worker threads (if it was built with support for
+them).
+*/
+class zstd_ostream : public std::ostream {
+public:
+	zstd_ostream() : std::ostream(nullptr)
+	{
+		rdbuf(&outbuf);
+	}
+	bool open(const std::string &filename, int threads)
+	{
+		return outbuf.open(filename, threads);
+	}
+private:
+	class zstd_streambuf : public block_streambuf {
+	public:
+		zstd_streambuf() : out_buffer(ZSTD_CStreamOutSize()) { }
+		bool open(const std::string &filename, int threads)
+		{
+			file.open(filename.c_str(), std::ofstream::binary | std::ofstream::trunc);
+			if (file.fail())
+				return false;
+			cctx = ZSTD_createCCtx();
+			if (cctx == nullptr)
+				return false;
+			ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+			ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+			if (threads > 1)
+				ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, threads);
+			return true;
+		}
+		virtual ~zstd_streambuf()
+		{
+			if (cctx == nullptr)
+				return;
+			finish();
+			ZSTD_freeCCtx(cctx);
+		}
+	protected:
+		void compress_block(const char *data, size_t size, bool last) override
+		{
+			ZSTD_inBuffer input = {data, size, 0};
+			ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+			while (1) {
+				ZSTD_outBuffer output = {out_buffer.data(), out_buffer.size(), 0};
+				size_t remaining = ZSTD_compressStream2(cctx, &output, &input, mode);
+				if (ZSTD_isError(remaining))
+					log_error("Failed to write zstd output: %s\n", ZSTD_getErrorName(remaining));
+				file.write(out_buffer.data(), output.pos);
+				if (last ? remaining == 0 : input.pos == input.size)
+					break;
+			}
+		}
+	private:
+		std::ofstream file;
+		ZSTD_CCtx *cctx = nullptr;
+		std::vector<char> out_buffer;
+	} outbuf;
+};
+
+PRIVATE_NAMESPACE_END
 #endif
 
 YOSYS_NAMESPACE_BEGIN
@@ -105,6 +477,11 @@ Pass::Pass(std::string name, std::string short_help) : pass_name(name), short_he
 	first_queued_pass = this;
 	call_counter = 0;
 	runtime_ns = 0;
+	rss_delta_bytes = 0;
+	for (auto &delta : kernel_stats_delta)
+		delta = 0;
+	heap_delta_bytes = 0;
+	peak_rss_bytes = 0;
 }
 
 void Pass::run_register()
@@ -126,6 +503,10 @@ void Pass::init_register()
 		added_pass->on_register();
 }
 
+#ifdef YOSYS_ENABLE_THREADS
+static void stop_worker_pool();
+#endif
+
 void Pass::done_register()
 {
 	for (auto &it : pass_register)
@@ -135,6 +516,10 @@ void Pass::done_register()
 	pass_register.clear();
 	backend_register.clear();
 	log_assert(first_queued_pass == NULL);
+
+#ifdef YOSYS_ENABLE_THREADS
+	stop_worker_pool();
+#endif
 }
 
 void Pass::on_register()
@@ -149,12 +534,230 @@ Pass::~Pass()
 {
 }
 
-Pass::pre_post_exec_state_t Pass::pre_execute()
+// Peak RSS of the pass calls in progress, innermost last. Each entry only
+// covers the time the pass spent outside of nested pass calls, as the
+// kernel's peak is reset whenever a nested call begins or ends.
+static std::vector<int64_t> peak_rss_stack;
+
+static FILE *trace_json_file = nullptr;
+static std::chrono::steady_clock::time_point trace_json_epoch;
+static int trace_json_depth = 0;
+
+void Pass::open_trace_json(const std::string &filename)
+{
+	close_trace_json();
+	trace_json_file = fopen(filename.c_str(), "w");
+	if (trace_json_file == nullptr)
+		log_cmd_error("Can't open trace file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+	trace_json_epoch = std::chrono::steady_clock::now();
+	trace_json_depth = 0;
+	fprintf(trace_json_file, "[\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": %s}}",
+			json11::Json(yosys_version_str).dump().c_str());
+}
+
+void Pass::close_trace_json()
+{
+	if (trace_json_file == nullptr)
+		return;
+	fprintf(trace_json_file, "\n]\n");
+	fclose(trace_json_file);
+	trace_json_file = nullptr;
+}
+
+struct ProfileSlot
+{
+	std::string pass_name, module_name;
+	std::atomic<uint64_t> samples{0};
+};
+
+static bool profile_enabled = false;
+static int profile_frequency = 0;
+static std::map<std::pair<std::string, std::string>, ProfileSlot*> profile_slots;
+#ifdef YOSYS_ENABLE_THREADS
+static std::mutex profile_mutex;
+#endif
+
+// read by the signal handler, so the module slot must not be allocated
+// lazily on first access from the handler
+static std::atomic<ProfileSlot*> profile_pass_slot{nullptr};
+#if defined(__GNUC__) && defined(YOSYS_ENABLE_THREADS)
+static thread_local ProfileSlot *profile_module_slot __attribute__((tls_model("initial-exec"))) = nullptr;
+#elif defined(YOSYS_ENABLE_THREADS)
+static thread_local ProfileSlot *profile_module_slot = nullptr;
+#else
+static ProfileSlot *profile_module_slot = nullptr;
+#endif
+
+static ProfileSlot *profile_slot(const std::string &pass_name, const std::string &module_name)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	std::lock_guard<std::mutex> lock(profile_mutex);
+#endif
+	auto &slot = profile_slots[{pass_name, module_name}];
+	if (slot == nullptr) {
+		slot = new ProfileSlot;
+		slot->pass_name = pass_name;
+		slot->module_name = module_name;
+	}
+	return slot;
+}
+
+#ifdef YOSYS_ENABLE_PROFILER
+static ProfileSlot *profile_idle_slot;
+
+static void profile_signal_handler(int)
+{
+	ProfileSlot *slot = profile_module_slot;
+	if (slot == nullptr)
+		slot = profile_pass_slot.load(std::memory_order_relaxed);
+	if (slot == nullptr)
+		slot = profile_idle_slot;
+	slot->samples.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+void Pass::start_profiler(int frequency)
 {
+#ifdef YOSYS_ENABLE_PROFILER
+	if (frequency <= 0)
+		log_cmd_error("Invalid profiler frequency %d.\n", frequency);
+
+	profile_enabled = true;
+	profile_frequency = frequency;
+	profile_idle_slot = profile_slot(std::string(), std::string());
+	if (current_pass != nullptr)
+		profile_pass_slot = profile_slot(current_pass->pass_name, std::string());
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = profile_signal_handler;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGPROF, &sa, nullptr);
+
+	struct itimerval timer;
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = std::max(1000000 / frequency, 1);
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_PROF, &timer, nullptr);
+#else
+	(void)frequency;
+	log_warning("The sampling profiler is not supported on this platform.\n");
+#endif
+}
+
+void Pass::stop_profiler()
+{
+#ifdef YOSYS_ENABLE_PROFILER
+	if (!profile_enabled)
+		return;
+	struct itimerval timer;
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, nullptr);
+	profile_enabled = false;
+#endif
+}
+
+void Pass::print_profile(int max_lines)
+{
+	std::vector<std::pair<uint64_t, ProfileSlot*>> samples;
+	uint64_t total = 0;
+	for (auto &it : profile_slots) {
+		uint64_t count = it.second->samples.load();
+		if (count == 0)
+			continue;
+		samples.push_back({count, it.second});
+		total += count;
+	}
+	if (total == 0)
+		return;
+
+	std::sort(samples.begin(), samples.end(), [](const std::pair<uint64_t, ProfileSlot*> &a, const std::pair<uint64_t, ProfileSlot*> &b) {
+		return a.first != b.first ? a.first > b.first : a.second->pass_name + a.second->module_name < b.second->pass_name + b.second->module_name;
+	});
+
+	log("\nCPU time by pass and module (%llu samples at %d Hz):\n", (unsigned long long)total, profile_frequency);
+	int lines = 0;
+	uint64_t others = 0;
+	for (auto &it : samples) {
+		if (lines++ >= max_lines) {
+			others += it.first;
+			continue;
+		}
+		const ProfileSlot *slot = it.second;
+		log("%6.2f%% %8.3f sec  %s%s%s\n", 100.0 * it.first / total, double(it.first) / profile_frequency,
+				slot->pass_name.empty() ? "(outside of passes)" : slot->pass_name.c_str(),
+				slot->module_name.empty() ? "" : "  ", slot->module_name.c_str());
+	}
+	if (others != 0)
+		log("%6.2f%% %8.3f sec  (%d more)\n", 100.0 * others / total, double(others) / profile_frequency, GetSize(samples) - max_lines);
+}
+
+ModuleScope::ModuleScope(RTLIL::Module *module) : parent(profile_module_slot)
+{
+	if (profile_enabled)
+		profile_module_slot = profile_slot(current_pass ? current_pass->pass_name : std::string(), RTLIL::unescape_id(module->name));
+}
+
+ModuleScope::~ModuleScope()
+{
+	profile_module_slot = parent;
+}
+
+static void trace_json_event(const char *phase, const std::string &name, const std::vector<std::string> &args, RTLIL::Design *design)
+{
+	double ts = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - trace_json_epoch).count();
+	fprintf(trace_json_file, ",\n{\"name\": %s, \"cat\": \"pass\", \"ph\": \"%s\", \"ts\": %.3f, \"pid\": 1, \"tid\": 1, \"args\": {",
+			json11::Json(name).dump().c_str(), phase, ts);
+
+	const char *sep = "";
+	if (!args.empty()) {
+		std::string command;
+		for (auto &arg : args)
+			command += (command.empty() ? "" : " ") + arg;
+		fprintf(trace_json_file, "\"command\": %s", json11::Json(command).dump().c_str());
+		sep = ", ";
+	}
+	if (design != nullptr) {
+		int num_cells = 0;
+		for (auto module : design->modules())
+			num_cells += GetSize(module->cells());
+		fprintf(trace_json_file, "%s\"modules\": %d, \"cells\": %d", sep, GetSize(design->modules()), num_cells);
+		sep = ", ";
+	}
+	int64_t rss = MemoryUsage::current_rss();
+	if (rss)
+		fprintf(trace_json_file, "%s\"rss_bytes\": %lld", sep, (long long)rss);
+	fprintf(trace_json_file, "}}");
+}
+
+Pass::pre_post_exec_state_t Pass::pre_execute(const std::vector<std::string> &args, RTLIL::Design *design)
+{
+	if (trace_json_file) {
+		trace_json_event("B", pass_name, args, design);
+		trace_json_depth++;
+	}
+
 	pre_post_exec_state_t state;
 	call_counter++;
 	state.begin_ns = PerformanceTimer::query();
+	state.begin_rss = MemoryUsage::current_rss();
+	state.begin_heap = MemoryUsage::heap_in_use();
+	for (int i = 0; i < KernelStats::NUM_COUNTERS; i++)
+		state.begin_stats[i] = KernelStats::get(KernelStats::counter_t(i));
+	if (!peak_rss_stack.empty())
+		peak_rss_stack.back() = std::max(peak_rss_stack.back(), MemoryUsage::peak_rss());
+	MemoryUsage::reset_peak_rss();
+	state.peak_rss_depth = GetSize(peak_rss_stack);
+	peak_rss_stack.push_back(0);
 	state.parent_pass = current_pass;
+	state.design = design;
+	state.profile_pass = profile_pass_slot;
+	state.profile_module = profile_module_slot;
+	if (profile_enabled) {
+		profile_pass_slot = profile_slot(pass_name, std::string());
+		profile_module_slot = nullptr;
+	}
 	current_pass = this;
 	clear_flags();
 	return state;
@@ -167,9 +770,42 @@ void Pass::post_execute(Pass::pre_post_exec_state_t state)
 
 	int64_t time_ns = PerformanceTimer::query() - state.begin_ns;
 	runtime_ns += time_ns;
+
+	int64_t rss_delta = MemoryUsage::current_rss() - state.begin_rss;
+	int64_t heap_delta = MemoryUsage::heap_in_use() - state.begin_heap;
+	rss_delta_bytes += rss_delta;
+	heap_delta_bytes += heap_delta;
+
+	int64_t stats_delta[KernelStats::NUM_COUNTERS];
+	for (int i = 0; i < KernelStats::NUM_COUNTERS; i++) {
+		stats_delta[i] = KernelStats::get(KernelStats::counter_t(i)) - state.begin_stats[i];
+		kernel_stats_delta[i] += stats_delta[i];
+	}
+
+	// nested calls that ended with an error never popped their entries
+	peak_rss_stack.resize(state.peak_rss_depth + 1);
+	peak_rss_bytes = std::max(peak_rss_bytes, std::max(peak_rss_stack.back(), MemoryUsage::peak_rss()));
+	peak_rss_stack.pop_back();
+	MemoryUsage::reset_peak_rss();
+
+	profile_pass_slot = state.profile_pass;
+	profile_module_slot = state.profile_module;
+
 	current_pass = state.parent_pass;
-	if (current_pass)
+	if (current_pass) {
 		current_pass->runtime_ns -= time_ns;
+		current_pass->rss_delta_bytes -= rss_delta;
+		current_pass->heap_delta_bytes -= heap_delta;
+		for (int i = 0; i < KernelStats::NUM_COUNTERS; i++)
+			current_pass->kernel_stats_delta[i] -= stats_delta[i];
+	}
+
+	if (trace_json_file) {
+		trace_json_event("E", pass_name, {}, state.design);
+		// flush complete top-level calls, in case yosys dies later on
+		if (--trace_json_depth <= 0)
+			fflush(trace_json_file);
+	}
 }
 
 void Pass::help()
@@ -193,6 +829,17 @@ void Pass::cmd_log_args(const std::vector<std::string> &args)
 	log("\n");
 }
 
+std::string Pass::converged_key(const std::vector<std::string> &args)
+{
+	std::string key;
+	for (auto &arg : args) {
+		if (!key.empty())
+			key += " ";
+		key += arg;
+	}
+	return key;
+}
+
 void Pass::cmd_error(const std::vector<std::string> &args, size_t argidx, std::string msg)
 {
 	std::string command_text;
@@ -295,6 +942,14 @@ void Pass::call(RTLIL::Design *design, std::string command)
 	call(design, args);
 }
 
+// Passes that are not selection_safe() and backends see the contents of all
+// modules, so spilled modules are read back before they run.
+static void restore_spilled_modules(RTLIL::Design *design)
+{
+	if (design->spill_store && design->spill_store->spilled_count() != 0)
+		design->spill_store->restore_all();
+}
+
 void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 {
 	if (args.size() == 0 || args[0][0] == '#' || args[0][0] == ':')
@@ -313,12 +968,251 @@ void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 	if (pass_register[args[0]]->experimental_flag)
 		log_experimental("%s", args[0].c_str());
 
+	if (!pass_register[args[0]]->keeps_shared_modules_flag)
+		design->unshare_modules();
+	if (!pass_register[args[0]]->selection_safe_flag)
+		restore_spilled_modules(design);
+
 	size_t orig_sel_stack_pos = design->selection_stack.size();
-	auto state = pass_register[args[0]]->pre_execute();
+	auto state = pass_register[args[0]]->pre_execute(args, design);
 	pass_register[args[0]]->execute(args, design);
 	pass_register[args[0]]->post_execute(state);
+	if (!pass_register[args[0]]->keeps_indexes_flag)
+		for (auto module : design->modules()) {
+			ModIndex::drop_cached(module);
+			delete module->cached_timing_;
+			module->cached_timing_ = nullptr;
+			delete module->cached_ffs_;
+			module->cached_ffs_ = nullptr;
+		}
+
+	// Modules stay shared only between commands. A calling pass (or a
+	// Python script) might modify the design without going through here.
+#ifdef WITH_PYTHON
+	design->unshare_modules();
+#else
+	if (current_pass != nullptr && !current_pass->keeps_shared_modules_flag)
+		design->unshare_modules();
+#endif
 	while (design->selection_stack.size() > orig_sel_stack_pos)
 		design->selection_stack.pop_back();
+
+	// Only scripts are known not to hold pointers into modules between the
+	// commands they call.
+	if (design->spill_store && (current_pass == nullptr || current_pass->pass_name == "script" ||
+			dynamic_cast<ScriptPass*>(current_pass) != nullptr))
+		design->spill_store->enforce_budget();
+}
+
+int Pass::parallel_threads(RTLIL::Design *design)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	return std::max(design->scratchpad_get_int("parallel.threads", yosys_threads), 1);
+#else
+	(void)design;
+	return 1;
+#endif
+}
+
+static thread_local int parallel_worker_index = 0;
+
+int Pass::parallel_worker()
+{
+	return parallel_worker_index;
+}
+
+#ifdef YOSYS_ENABLE_THREADS
+// Threads are started when a job first needs them and are then kept for all
+// later jobs, so short parallel_for() calls don't pay for thread creation.
+// The calling thread works on each job as worker 0. Jobs are never nested
+// (workers run serially, see log_buffer_active()), so one batch at a time
+// is enough.
+struct WorkerPool
+{
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	std::vector<std::thread> threads;
+	const std::function<void()> *batch = nullptr;
+	int generation = 0, wanted = 0, joined = 0, active = 0;
+	bool shutdown = false;
+
+	void thread_main(int seen)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			wake.wait(lock, [&]() { return shutdown || generation != seen; });
+			if (shutdown)
+				break;
+			seen = generation;
+			if (joined == wanted)
+				continue;
+			parallel_worker_index = ++joined;
+			const std::function<void()> *job = batch;
+			lock.unlock();
+			(*job)();
+			lock.lock();
+			parallel_worker_index = 0;
+			if (--active == 0)
+				done.notify_all();
+		}
+	}
+
+	// runs job() on `threads` threads, including the calling one
+	void run(int threads, const std::function<void()> &job)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (GetSize(this->threads) < threads - 1)
+			this->threads.emplace_back(&WorkerPool::thread_main, this, generation);
+		batch = &job;
+		wanted = active = threads - 1;
+		joined = 0;
+		generation++;
+		wake.notify_all();
+		lock.unlock();
+
+		job();
+
+		lock.lock();
+		done.wait(lock, [&]() { return active == 0; });
+		batch = nullptr;
+	}
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			shutdown = true;
+			wake.notify_all();
+		}
+		for (auto &thread : threads)
+			thread.join();
+	}
+};
+
+static WorkerPool *worker_pool = nullptr;
+#ifndef _WIN32
+static pid_t worker_pool_pid;
+#endif
+
+static WorkerPool &get_worker_pool()
+{
+#ifndef _WIN32
+	// after fork() (e.g. in the `server` command) the threads are gone, and
+	// so is any chance of joining them, so the child starts a pool of its own
+	if (worker_pool != nullptr && worker_pool_pid != getpid())
+		worker_pool = nullptr;
+	worker_pool_pid = getpid();
+#endif
+	if (worker_pool == nullptr)
+		worker_pool = new WorkerPool;
+	return *worker_pool;
+}
+
+static void stop_worker_pool()
+{
+#ifndef _WIN32
+	if (worker_pool != nullptr && worker_pool_pid != getpid())
+		worker_pool = nullptr;
+#endif
+	delete worker_pool;
+	worker_pool = nullptr;
+}
+
+static void run_parallel_jobs(int threads, int count, const std::function<void(int)> &worker)
+{
+	std::vector<LogBuffer> log_buffers(count);
+	std::vector<int> job_autoidx(count, autoidx);
+	std::vector<std::exception_ptr> errors(count);
+	std::atomic<int> next_job(0);
+	std::atomic<bool> failed(false);
+
+	std::function<void()> thread_main = [&]() {
+		while (!failed.load(std::memory_order_relaxed)) {
+			int i = next_job.fetch_add(1);
+			if (i >= count)
+				break;
+			log_buffer_install(&log_buffers[i]);
+			autoidx_local = &job_autoidx[i];
+			try {
+				worker(i);
+			} catch (...) {
+				errors[i] = std::current_exception();
+				failed.store(true, std::memory_order_relaxed);
+			}
+			autoidx_local = nullptr;
+			log_buffer_install(nullptr);
+		}
+	};
+
+	{
+		IdString::ConcurrentScope concurrent_scope;
+		get_worker_pool().run(threads, thread_main);
+	}
+
+	for (int i = 0; i < count; i++) {
+		autoidx = std::max(autoidx, job_autoidx[i]);
+		log_buffers[i].replay();
+		if (errors[i] == nullptr)
+			continue;
+		try {
+			std::rethrow_exception(errors[i]);
+		} catch (const log_buffered_error &e) {
+			e.raise();
+		}
+	}
+}
+#endif
+
+void Pass::parallel_modules(RTLIL::Design *design, const std::vector<RTLIL::Module*> &modules,
+		const std::function<void(RTLIL::Module*)> &worker)
+{
+	int threads = std::min(parallel_threads(design), GetSize(modules));
+
+	// looking up a module restores it and updates the LRU order of the
+	// spill store, neither of which is safe from a worker
+	bool serial = threads <= 1 || !design->monitors.empty() || design->spill_store != nullptr || log_buffer_active();
+	for (auto module : modules)
+		if (GetSize(module->monitors) > (module->cached_index_ != nullptr) + (module->cached_timing_ != nullptr) +
+				(module->cached_ffs_ != nullptr))
+			serial = true;
+
+	if (serial) {
+		for (auto module : modules) {
+			ModuleScope scope(module);
+			worker(module);
+		}
+		return;
+	}
+
+#ifdef YOSYS_ENABLE_THREADS
+	run_parallel_jobs(threads, GetSize(modules), [&](int i) {
+		ModuleScope scope(modules[i]);
+		worker(modules[i]);
+	});
+#else
+	log_abort();
+#endif
+}
+
+void Pass::parallel_for(RTLIL::Design *design, int count, const std::function<void(int)> &worker, int threads)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	threads = std::min(threads > 0 ? threads : parallel_threads(design), count);
+#else
+	threads = 1;
+#endif
+
+	if (threads <= 1 || (design != nullptr && design->spill_store != nullptr) || log_buffer_active()) {
+		for (int i = 0; i < count; i++)
+			worker(i);
+		return;
+	}
+
+#ifdef YOSYS_ENABLE_THREADS
+	run_parallel_jobs(threads, count, worker);
+#else
+	log_abort();
+#endif
 }
 
 void Pass::call_on_selection(RTLIL::Design *design, const RTLIL::Selection &selection, std::string command)
@@ -373,6 +1267,11 @@ void Pass::call_on_module(RTLIL::Design *design, RTLIL::Module *module, std::vec
 
 bool ScriptPass::check_label(std::string label, std::string info)
 {
+	if (checkpoint_trace != nullptr) {
+		checkpoint_trace->push_back({label, std::string()});
+		return true;
+	}
+
 	if (active_design == nullptr) {
 		log("\n");
 		if (info.empty())
@@ -389,17 +1288,39 @@ bool ScriptPass::check_label(std::string label, std::string info)
 			if (label == active_run_to)
 				block_active = false;
 		}
+
+		auto it = checkpoint_files.find(label);
+		if (block_active && it != checkpoint_files.end()) {
+			// the checkpoint has to include the commands queued so far
+			run_module_jobs();
+			std::string filename = it->second;
+			checkpoint_files.erase(it);
+			bool ok = write_file_atomically(filename, [&](std::ostream &f) {
+				RTLIL_BINARY::dump_design(f, active_design, false);
+			});
+			if (!ok)
+				log_warning("Failed to save checkpoint %s: %s\n", filename.c_str(), strerror(errno));
+			else
+				log("Saved checkpoint for label `%s' to %s.\n", label.c_str(), filename.c_str());
+		}
+
 		return block_active;
 	}
 }
 
 void ScriptPass::run(std::string command, std::string info)
 {
-	if (active_design == nullptr) {
+	if (checkpoint_trace != nullptr) {
+		if (checkpoint_trace->empty())
+			checkpoint_trace->push_back({std::string(), std::string()});
+		checkpoint_trace->back().second += command + "\n";
+	} else if (active_design == nullptr) {
 		if (info.empty())
 			log("        %s\n", command.c_str());
 		else
 			log("        %s    %s\n", command.c_str(), info.c_str());
+	} else if (module_jobs > 1) {
+		queued_commands.push_back({command, true});
 	} else {
 		Pass::call(active_design, command);
 		active_design->check();
@@ -408,24 +1329,573 @@ void ScriptPass::run(std::string command, std::string info)
 
 void ScriptPass::run_nocheck(std::string command, std::string info)
 {
-	if (active_design == nullptr) {
+	if (checkpoint_trace != nullptr) {
+		if (checkpoint_trace->empty())
+			checkpoint_trace->push_back({std::string(), std::string()});
+		checkpoint_trace->back().second += command + "\n";
+	} else if (active_design == nullptr) {
 		if (info.empty())
 			log("        %s\n", command.c_str());
 		else
 			log("        %s    %s\n", command.c_str(), info.c_str());
+	} else if (module_jobs > 1) {
+		queued_commands.push_back({command, false});
 	} else {
 		Pass::call(active_design, command);
 	}
 }
 
+// Traces the commands of script() against an empty design, then hashes the
+// input design together with the commands before each label to find the
+// checkpoint files of the labels. Restores the design from the last label that
+// has a checkpoint and returns that label, or run_from if there is none.
+std::string ScriptPass::resume_checkpoint(RTLIL::Design *design, const std::string &dir, const std::string &run_from, const std::string &run_to)
+{
+	std::vector<std::pair<std::string, std::string>> trace;
+	RTLIL::Design trace_design;
+	trace_design.scratchpad = design->scratchpad;
+
+	active_design = &trace_design;
+	block_active = true;
+	active_run_from.clear();
+	active_run_to.clear();
+	checkpoint_trace = &trace;
+	script();
+	checkpoint_trace = nullptr;
+
+	int first = 0, last = GetSize(trace);
+	for (int i = 0; i < GetSize(trace); i++) {
+		if (!run_from.empty() && trace[i].first == run_from)
+			first = i;
+		if (!run_to.empty() && trace[i].first == run_to)
+			last = i;
+	}
+
+	std::ostringstream design_data;
+	RTLIL_BINARY::dump_design(design_data, design, false);
+
+	ContentHash history;
+	history.update(yosys_version_str);
+	history.update(pass_name);
+	history.update(GetSize(design->scratchpad));
+	for (auto &it : design->scratchpad) {
+		history.update(it.first);
+		history.update(it.second);
+	}
+	history.update(design_data.str());
+
+	std::string resume_label = run_from, resume_file;
+	for (int i = first; i < last; i++)
+	{
+		if (i > first && !trace[i].first.empty()) {
+			std::string filename = dir + "/" + history.hexdigest() + ".rtlil";
+			if (check_file_exists(filename)) {
+				resume_label = trace[i].first;
+				resume_file = filename;
+				checkpoint_files.clear();
+			} else
+				checkpoint_files[trace[i].first] = filename;
+		}
+		history.update(trace[i].first);
+		history.update(trace[i].second);
+	}
+
+	if (!checkpoint_files.empty() && !check_directory_exists(dir) && !create_directory(dir)) {
+		log_warning("Failed to create checkpoint directory %s.\n", dir.c_str());
+		checkpoint_files.clear();
+	}
+
+	if (!resume_file.empty()) {
+		log("Resuming at label `%s' from checkpoint %s.\n", resume_label.c_str(), resume_file.c_str());
+		std::ifstream in(resume_file, std::ios::binary);
+		std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		if (!in || !RTLIL_BINARY::has_magic(data.data(), data.size()))
+			log_cmd_error("Can't read checkpoint %s.\n", resume_file.c_str());
+		while (!design->modules_.empty())
+			design->remove(design->modules_.begin()->second);
+		RTLIL_BINARY::parse_design(data.data(), data.size(), design, RTLIL_BINARY::ReadOptions());
+	}
+
+	return resume_label;
+}
+
 void ScriptPass::run_script(RTLIL::Design *design, std::string run_from, std::string run_to)
 {
+	static bool checkpoint_active = false;
+
 	help_mode = false;
+	checkpoint_files.clear();
+
+	// nested script passes are covered by the checkpoints of the outer one
+	std::string checkpoint_dir = design->scratchpad_get_string("script.checkpoint_dir");
+	bool checkpointing = !checkpoint_dir.empty() && !checkpoint_active && (run_from.empty() || run_from != run_to);
+	if (checkpointing) {
+		run_from = resume_checkpoint(design, checkpoint_dir, run_from, run_to);
+		checkpoint_active = true;
+	}
+
 	active_design = design;
 	block_active = run_from.empty();
 	active_run_from = run_from;
 	active_run_to = run_to;
-	script();
+	module_jobs = 0;
+	queued_commands.clear();
+
+	try {
+		script();
+		end_module_jobs();
+	} catch (...) {
+		if (checkpointing)
+			checkpoint_active = false;
+		checkpoint_files.clear();
+		module_jobs = 0;
+		queued_commands.clear();
+		throw;
+	}
+
+	if (checkpointing)
+		checkpoint_active = false;
+	checkpoint_files.clear();
+}
+
+void ScriptPass::begin_module_jobs(int jobs)
+{
+	end_module_jobs();
+	module_jobs = jobs;
+}
+
+void ScriptPass::end_module_jobs()
+{
+	run_module_jobs();
+	module_jobs = 0;
+}
+
+// The messages between run_module_jobs() and `job_worker' are sequences of
+// chunks, each a line with a tag and the size of the data, then the data.
+static void write_job_chunk(std::ostream &f, const char *tag, const std::string &data)
+{
+	f << tag << " " << data.size() << "\n";
+	f.write(data.data(), data.size());
+}
+
+static bool read_job_chunk(std::istream &f, const char *tag, std::string &data)
+{
+	std::string read_tag;
+	size_t size;
+	if (!(f >> read_tag >> size) || read_tag != tag || f.get() != '\n')
+		return false;
+	data.resize(size);
+	return bool(f.read(&data[0], size));
+}
+
+static std::string shell_quote(const std::string &str)
+{
+	std::string quoted = "'";
+	for (char c : str)
+		if (c == '\'')
+			quoted += "'\\''";
+		else
+			quoted += c;
+	return quoted + "'";
+}
+
+// A blackbox with the ports, parameters and attributes of the module, as
+// makeblackbox() would leave it, without touching the module itself.
+static RTLIL::Module *interface_copy(RTLIL::Module *module)
+{
+	RTLIL::Module *copy = new RTLIL::Module;
+	copy->name = module->name;
+	copy->attributes = module->attributes;
+	copy->avail_parameters = module->avail_parameters;
+	copy->parameter_default_values = module->parameter_default_values;
+	for (auto port : module->ports)
+		copy->addWire(port, module->wire(port));
+	copy->fixup_ports();
+	copy->set_bool_attribute(ID::blackbox);
+	return copy;
+}
+
+// Entries of the module cache (script.module_cache) start with this line,
+// followed by a line with autoidx and the binary RTLIL of the module.
+static const char module_cache_magic[] = "yosys-module-cache-v1\n";
+
+// The commands, the contents of the files they name (techmap rules, cell
+// libraries, ...) and the yosys version, shared by the keys of all modules.
+static std::string module_cache_script_hash(const std::vector<std::pair<std::string, bool>> &commands)
+{
+	ContentHash hasher;
+	hasher.update(module_cache_magic);
+	hasher.update(yosys_version_str);
+	hasher.update(GetSize(commands));
+	for (auto &it : commands) {
+		hasher.update(it.first);
+		hasher.update(it.second);
+		for (auto &token : split_tokens(it.first)) {
+			std::string filename = token;
+			if (filename.compare(0, 2, "+/") == 0)
+				filename = proc_share_dirname() + filename.substr(2);
+			if (!check_file_exists(filename) || check_directory_exists(filename))
+				continue;
+			std::ifstream f(filename, std::ifstream::binary);
+			std::string text((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+			hasher.update(token);
+			hasher.update(content_hash(text));
+		}
+	}
+	return hasher.hexdigest();
+}
+
+// The module itself and the interfaces of the modules it instantiates, which
+// the commands of a module job only see as blackboxes.
+static std::string module_cache_key(RTLIL::Design *design, RTLIL::Module *module, const std::string &script_hash)
+{
+	ContentHash hasher;
+	hasher.update(script_hash);
+	hasher.update(module);
+
+	pool<RTLIL::IdString> types;
+	for (auto cell : module->cells())
+		if (design->module(cell->type) != nullptr)
+			types.insert(cell->type);
+	types.sort(RTLIL::sort_by_id_str());
+	hasher.update(GetSize(types));
+	for (auto type : types) {
+		RTLIL::Module *mod = design->module(type);
+		hasher.update(type);
+		hasher.update(mod->attributes);
+		hasher.update(GetSize(mod->avail_parameters));
+		for (auto param : mod->avail_parameters)
+			hasher.update(param);
+		hasher.update(mod->parameter_default_values);
+		hasher.update(GetSize(mod->ports));
+		for (auto port : mod->ports) {
+			RTLIL::Wire *wire = mod->wire(port);
+			hasher.update(port);
+			hasher.update(wire->width);
+			hasher.update(wire->start_offset);
+			hasher.update(wire->port_input);
+			hasher.update(wire->port_output);
+			hasher.update(wire->upto);
+			hasher.update(wire->is_signed);
+		}
+	}
+	return hasher.hexdigest();
+}
+
+void ScriptPass::run_module_jobs()
+{
+	std::vector<std::pair<std::string, bool>> commands;
+	commands.swap(queued_commands);
+	if (commands.empty())
+		return;
+
+	std::vector<RTLIL::Module*> modules;
+	if (active_design->full_selection())
+		modules = active_design->selected_modules();
+
+	std::vector<RTLIL::IdString> module_order;
+	for (auto module : active_design->modules())
+		module_order.push_back(module->name);
+
+	// With script.module_cache set, the modules that have an entry for their
+	// key are blackboxed while the commands run on the others and replaced
+	// by the cached result afterwards. The results of the others are added
+	// to the cache.
+	std::string cache_dir = active_design->scratchpad_get_string("script.module_cache");
+	std::vector<std::pair<std::string, size_t>> cache_hits;
+	dict<RTLIL::IdString, std::string> cache_misses;
+	if (!cache_dir.empty() && !modules.empty()) {
+		std::string script_hash = module_cache_script_hash(commands);
+		std::vector<RTLIL::Module*> missed_modules;
+		for (auto module : modules) {
+			std::string filename = stringf("%s/%s.rtlilb", cache_dir.c_str(), module_cache_key(active_design, module, script_hash).c_str());
+			std::ifstream f(filename, std::ifstream::binary);
+			std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+			size_t header = sizeof(module_cache_magic) - 1;
+			size_t end = data.find('\n', header);
+			if (data.compare(0, header, module_cache_magic) == 0 && end != std::string::npos) {
+				autoidx = std::max(autoidx, atoi(data.c_str() + header));
+				cache_hits.push_back({std::move(data), end + 1});
+				module->set_bool_attribute(ID::blackbox);
+			} else {
+				cache_misses[module->name] = filename;
+				missed_modules.push_back(module);
+			}
+		}
+		log("Found %d of %d modules in the module cache `%s'.\n", GetSize(cache_hits), GetSize(modules), cache_dir.c_str());
+		modules.swap(missed_modules);
+	}
+
+	// stores the new results, reads the cached ones and restores the order
+	// of the modules, which were added last when read back
+	auto finish = [&](bool reorder) {
+		if (!cache_misses.empty() && !create_directory(cache_dir)) {
+			log_warning("Failed to create module cache directory %s.\n", cache_dir.c_str());
+			cache_misses.clear();
+		}
+		for (auto &it : cache_misses) {
+			RTLIL::Module *module = active_design->module(it.first);
+			if (module == nullptr)
+				continue;
+			bool ok = write_file_atomically(it.second, [&](std::ostream &f) {
+				f << module_cache_magic << autoidx << "\n";
+				RTLIL_BINARY::dump_modules(f, {module});
+			});
+			if (!ok)
+				log_warning("Failed to write module cache entry %s.\n", it.second.c_str());
+		}
+
+		RTLIL_BINARY::ReadOptions options;
+		options.overwrite = true;
+		for (auto &it : cache_hits)
+			RTLIL_BINARY::parse_design(it.first.data() + it.second, it.first.size() - it.second, active_design, options);
+
+		if (!reorder && cache_hits.empty())
+			return;
+		dict<RTLIL::IdString, RTLIL::Module*> ordered;
+		for (auto it = module_order.rbegin(); it != module_order.rend(); ++it)
+			if (active_design->module(*it) != nullptr)
+				ordered[*it] = active_design->module(*it);
+		for (auto &it : active_design->modules_)
+			if (!ordered.count(it.first))
+				ordered[it.first] = it.second;
+		active_design->modules_.swap(ordered);
+		active_design->check();
+	};
+
+	int jobs = std::min(module_jobs, GetSize(modules));
+
+#if defined(_WIN32) || defined(__wasm)
+	jobs = 1;
+#endif
+
+	if (jobs <= 1) {
+		// nothing left to do if all modules came from the cache
+		if (!modules.empty() || cache_hits.empty())
+			for (auto &it : commands) {
+				Pass::call(active_design, it.first);
+				if (it.second)
+					active_design->check();
+			}
+		finish(false);
+		return;
+	}
+
+	// largest modules first, each to the group with the fewest cells so far
+	std::sort(modules.begin(), modules.end(), [](RTLIL::Module *a, RTLIL::Module *b) {
+		if (GetSize(a->cells_) != GetSize(b->cells_))
+			return GetSize(a->cells_) > GetSize(b->cells_);
+		return a->name.str() < b->name.str();
+	});
+	std::vector<std::vector<RTLIL::Module*>> groups(jobs);
+	std::vector<int> group_cells(jobs);
+	for (auto module : modules) {
+		int group = std::min_element(group_cells.begin(), group_cells.end()) - group_cells.begin();
+		groups[group].push_back(module);
+		group_cells[group] += GetSize(module->cells_) + 1;
+	}
+
+	log("Running the next %d commands on %d modules in %d jobs.\n", GetSize(commands), GetSize(modules), jobs);
+
+	std::vector<std::string> workers;
+	for (auto &worker : split_tokens(active_design->scratchpad_get_string("script.remote_workers"), ","))
+		if (worker.find_first_not_of(" \t") != std::string::npos)
+			workers.push_back(worker);
+	if (!workers.empty())
+		log("Sending the jobs to %d remote workers.\n", GetSize(workers));
+
+	// Sends the modules of job i and the blackboxes of the design to a
+	// worker, together with the interfaces of all other modules, which the
+	// worker only sees as blackboxes anyway. The result is written to the
+	// same files a local job writes, only the log and autoidx come back
+	// separately.
+	auto remote_job = [&](int i, const std::string &prefix) {
+		const std::string &worker = workers[i % GetSize(workers)];
+		{
+			pool<RTLIL::Module*> job_modules(groups[i].begin(), groups[i].end());
+			std::vector<std::unique_ptr<RTLIL::Module>> interfaces;
+			std::vector<RTLIL::Module*> request_modules;
+			for (auto module : active_design->modules()) {
+				if (job_modules.count(module) || module->get_blackbox_attribute()) {
+					active_design->unspill(module);
+					request_modules.push_back(module);
+				} else {
+					interfaces.emplace_back(interface_copy(module));
+					request_modules.push_back(interfaces.back().get());
+				}
+			}
+
+			std::ofstream out(prefix + ".request", std::ios::binary);
+			std::string script;
+			for (auto &it : commands)
+				script += (it.second ? "1 " : "0 ") + it.first + "\n";
+			std::ostringstream design_data;
+			RTLIL_BINARY::dump_modules(design_data, request_modules);
+			write_job_chunk(out, "script", script);
+			write_job_chunk(out, "autoidx", std::to_string(autoidx));
+			write_job_chunk(out, "design", design_data.str());
+		}
+
+		std::string command = stringf("%s -q -p job_worker < %s > %s 2> %s", worker.c_str(),
+				shell_quote(prefix + ".request").c_str(), shell_quote(prefix + ".response").c_str(),
+				shell_quote(prefix + ".stderr").c_str());
+#if !defined(YOSYS_DISABLE_SPAWN)
+		int ret = run_command(command);
+#else
+		int ret = -1;
+#endif
+
+		std::ifstream in(prefix + ".response", std::ios::binary);
+		std::string job_log, job_autoidx, design_data;
+		bool complete = read_job_chunk(in, "log", job_log);
+		log("%s", job_log.c_str());
+		complete = complete && read_job_chunk(in, "autoidx", job_autoidx) && read_job_chunk(in, "design", design_data);
+		if (ret != 0 || !complete) {
+			std::ifstream err_in(prefix + ".stderr");
+			std::stringstream err;
+			err << err_in.rdbuf();
+			log("%s", err.str().c_str());
+			log("Remote job on `%s' failed with return code %d.\n", worker.c_str(), ret);
+			return;
+		}
+
+		std::ofstream rtlil_out(prefix + ".rtlil", std::ios::binary);
+		rtlil_out << design_data;
+		std::ofstream autoidx_out(prefix + ".autoidx");
+		autoidx_out << job_autoidx << "\n";
+	};
+
+	auto job_main = [&](int i, const std::string &prefix) {
+		if (!workers.empty()) {
+			remote_job(i, prefix);
+			return;
+		}
+
+		RTLIL::Selection selection(false);
+		for (auto module : groups[i])
+			selection.selected_modules.insert(module->name);
+		for (auto module : active_design->modules())
+			if (!selection.selected_modules.count(module->name) && !module->get_blackbox_attribute())
+				module->set_bool_attribute(ID::blackbox);
+
+		for (auto &it : commands) {
+			Pass::call(active_design, it.first);
+			if (it.second)
+				active_design->check();
+		}
+
+		active_design->selection_stack.back() = selection;
+		{
+			std::ofstream out(prefix + ".rtlil", std::ios::binary);
+			RTLIL_BINARY::dump_design(out, active_design, true);
+		}
+		std::ofstream out(prefix + ".autoidx");
+		out << autoidx << "\n";
+	};
+
+	auto merge = [&](int i, const std::string &prefix, bool success) {
+		std::ifstream rtlil_in(prefix + ".rtlil", std::ios::binary);
+		std::ifstream autoidx_in(prefix + ".autoidx");
+		int job_autoidx = 0;
+		if (!success || !rtlil_in || !(autoidx_in >> job_autoidx))
+			return stringf("Module job %d (%s and %d more modules) failed.", i, log_id(groups[i].front()), GetSize(groups[i]) - 1);
+
+		std::string data((std::istreambuf_iterator<char>(rtlil_in)), std::istreambuf_iterator<char>());
+		RTLIL_BINARY::ReadOptions options;
+		options.overwrite = true;
+		RTLIL_BINARY::parse_design(data.data(), data.size(), active_design, options);
+		autoidx = std::max(autoidx, job_autoidx);
+		return std::string();
+	};
+
+	fork_jobs(jobs, job_main, merge, workers.empty() ? 0 : GetSize(workers));
+	finish(true);
+}
+
+bool Pass::fork_jobs(int jobs, const std::function<void(int, const std::string&)> &job_main,
+		const std::function<std::string(int, const std::string&, bool)> &merge, int max_running)
+{
+#if defined(_WIN32) || defined(__wasm)
+	return false;
+#else
+	std::string tempdir = make_temp_dir(get_base_tmpdir() + "/yosys_jobs_XXXXXX");
+	if (max_running <= 0 || max_running > jobs)
+		max_running = jobs;
+
+	log_flush();
+	// the background log writer does not survive fork()
+	log_async_end();
+
+	dict<pid_t, int> running;
+	std::vector<int> status(jobs);
+	auto wait_one = [&]() {
+		int job_status;
+		pid_t pid = waitpid(-1, &job_status, 0);
+		if (pid < 0) {
+			if (errno == EINTR)
+				return;
+			log_error("Failed to wait for a job: %s\n", strerror(errno));
+		}
+		auto it = running.find(pid);
+		if (it == running.end())
+			return;
+		status[it->second] = job_status;
+		running.erase(it);
+	};
+
+	for (int i = 0; i < jobs; i++) {
+		while (GetSize(running) >= max_running)
+			wait_one();
+
+		std::string prefix = stringf("%s/job%d", tempdir.c_str(), i);
+		pid_t pid = fork();
+		if (pid < 0)
+			log_error("Failed to fork a job: %s\n", strerror(errno));
+		if (pid > 0) {
+			running[pid] = i;
+			continue;
+		}
+
+		FILE *f = fopen((prefix + ".log").c_str(), "w");
+		if (f == nullptr)
+			_exit(1);
+		log_files.clear();
+		log_files.push_back(f);
+		log_streams.clear();
+		log_errfile = nullptr;
+		log_error_stderr = false;
+		yosys_threads = std::max(yosys_threads / max_running, 1);
+
+		// an error must not unwind into the code of the parent
+		try {
+			job_main(i, prefix);
+		} catch (...) {
+			log_flush();
+			_exit(1);
+		}
+		log_flush();
+		fclose(f);
+		_exit(0);
+	}
+
+	while (!running.empty())
+		wait_one();
+
+	// merge in job order, independent of which job finished first
+	std::string error;
+	for (int i = 0; i < jobs && error.empty(); i++) {
+		std::string prefix = stringf("%s/job%d", tempdir.c_str(), i);
+		std::ifstream log_in(prefix + ".log");
+		std::stringstream job_log;
+		job_log << log_in.rdbuf();
+		log("%s", job_log.str().c_str());
+		error = merge(i, prefix, WIFEXITED(status[i]) && WEXITSTATUS(status[i]) == 0);
+	}
+	remove_directory(tempdir);
+	if (!error.empty())
+		log_error("%s\n", error.c_str());
+	return true;
+#endif
 }
 
 void ScriptPass::help_script()
@@ -466,7 +1936,7 @@ void Frontend::execute(std::vector<std::string> args, RTLIL::Design *design)
 	do {
 		std::istream *f = NULL;
 		next_args.clear();
-		auto state = pre_execute();
+		auto state = pre_execute(args, design);
 		execute(f, std::string(), args, design);
 		post_execute(state);
 		args = next_args;
@@ -477,6 +1947,46 @@ void Frontend::execute(std::vector<std::string> args, RTLIL::Design *design)
 FILE *Frontend::current_script_file = NULL;
 std::string Frontend::last_here_document;
 
+void Frontend::read_input_data(std::istream *f, const std::string &filename, const std::function<void(const char *, size_t)> &parse)
+{
+	bool plain_file = dynamic_cast<std::ifstream*>(f) != nullptr;
+
+#ifndef _WIN32
+	// map plain files directly instead of copying them through the stream
+	if (plain_file) {
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd >= 0) {
+			struct stat st;
+			void *data = MAP_FAILED;
+			if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+				data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (data != MAP_FAILED) {
+				madvise(data, st.st_size, MADV_SEQUENTIAL);
+				try {
+					parse((const char *)data, st.st_size);
+				} catch (...) {
+					munmap(data, st.st_size);
+					throw;
+				}
+				munmap(data, st.st_size);
+				return;
+			}
+		}
+	}
+#endif
+
+	std::string buffer;
+	if (plain_file) {
+		// reopen, the frontend may have opened the file in text mode
+		std::ifstream ff(filename.c_str(), std::ifstream::binary);
+		buffer.assign(std::istreambuf_iterator<char>(ff), std::istreambuf_iterator<char>());
+	} else {
+		buffer.assign(std::istreambuf_iterator<char>(*f), std::istreambuf_iterator<char>());
+	}
+	parse(buffer.data(), buffer.size());
+}
+
 void Frontend::extra_args(std::istream *&f, std::string &filename, std::vector<std::string> args, size_t argidx, bool bin_input)
 {
 	bool called_with_fp = f != NULL;
@@ -536,29 +2046,44 @@ void Frontend::extra_args(std::istream *&f, std::string &filename, std::vector<s
 			}
 			f = ff;
 			if (f != NULL) {
-				// Check for gzip magic
-				unsigned char magic[3];
+				// Check for gzip and zstd magic
+				unsigned char magic[4];
 				int n = 0;
-				while (n < 3)
+				while (n < 4)
 				{
 					int c = ff->get();
-					if (c != EOF) {
-						magic[n] = (unsigned char) c;
-					}
-					n++;
+					if (c == EOF)
+						break;
+					magic[n++] = (unsigned char) c;
 				}
-				if (n == 3 && magic[0] == 0x1f && magic[1] == 0x8b) {
+				if (n >= 3 && magic[0] == 0x1f && magic[1] == 0x8b) {
 	#ifdef YOSYS_ENABLE_ZLIB
 					log("Found gzip magic in file `%s', decompressing using zlib.\n", filename.c_str());
 					if (magic[2] != 8)
 						log_cmd_error("gzip file `%s' uses unsupported compression type %02x\n",
 							filename.c_str(), unsigned(magic[2]));
 					delete ff;
-					std::stringstream *df = new std::stringstream();
-					decompress_gzip(filename, *df);
-					f = df;
+					gzip_istream *gf = new gzip_istream;
+					if (!gf->open(filename)) {
+						delete gf;
+						log_cmd_error("Can't open input file `%s' for reading: %s\n", filename.c_str(), strerror(errno));
+					}
+					f = gf;
 	#else
 					log_cmd_error("File `%s' is a gzip file, but Yosys is compiled without zlib.\n", filename.c_str());
+	#endif
+				} else if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+	#ifdef YOSYS_ENABLE_ZSTD
+					log("Found zstd magic in file `%s', decompressing using libzstd.\n", filename.c_str());
+					delete ff;
+					zstd_istream *zf = new zstd_istream;
+					if (!zf->open(filename)) {
+						delete zf;
+						log_cmd_error("Can't open input file `%s' for reading: %s\n", filename.c_str(), strerror(errno));
+					}
+					f = zf;
+	#else
+					log_cmd_error("File `%s' is a zstd file, but Yosys is compiled without zstd.\n", filename.c_str());
 	#endif
 				} else {
 					ff->clear();
@@ -606,14 +2131,16 @@ void Frontend::frontend_call(RTLIL::Design *design, std::istream *f, std::string
 		return;
 	if (frontend_register.count(args[0]) == 0)
 		log_cmd_error("No such frontend: %s\n", args[0].c_str());
+	if (!frontend_register[args[0]]->keeps_shared_modules_flag)
+		design->unshare_modules();
 
 	if (f != NULL) {
-		auto state = frontend_register[args[0]]->pre_execute();
+		auto state = frontend_register[args[0]]->pre_execute(args, design);
 		frontend_register[args[0]]->execute(f, filename, args, design);
 		frontend_register[args[0]]->post_execute(state);
 	} else if (filename == "-") {
 		std::istream *f_cin = &std::cin;
-		auto state = frontend_register[args[0]]->pre_execute();
+		auto state = frontend_register[args[0]]->pre_execute(args, design);
 		frontend_register[args[0]]->execute(f_cin, "<stdin>", args, design);
 		frontend_register[args[0]]->post_execute(state);
 	} else {
@@ -647,7 +2174,8 @@ Backend::~Backend()
 void Backend::execute(std::vector<std::string> args, RTLIL::Design *design)
 {
 	std::ostream *f = NULL;
-	auto state = pre_execute();
+	restore_spilled_modules(design);
+	auto state = pre_execute(args, design);
 	execute(f, std::string(), args, design);
 	post_execute(state);
 	if (f != &std::cout)
@@ -675,10 +2203,16 @@ void Backend::extra_args(std::ostream *&f, std::string &filename, std::vector<st
 
 		filename = arg;
 		rewrite_filename(filename);
-		if (filename.size() > 3 && filename.compare(filename.size()-3, std::string::npos, ".gz") == 0) {
+		auto has_suffix = [&](const char *suffix) {
+			size_t len = strlen(suffix);
+			return filename.size() > len && filename.compare(filename.size()-len, std::string::npos, suffix) == 0;
+		};
+		RTLIL::Design *design = yosys_get_design();
+		int threads = design ? parallel_threads(design) : 1;
+		if (has_suffix(".gz")) {
 #ifdef YOSYS_ENABLE_ZLIB
 			gzip_ostream *gf = new gzip_ostream;
-			if (!gf->open(filename)) {
+			if (!gf->open(filename, threads)) {
 				delete gf;
 				log_cmd_error("Can't open output file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
 			}
@@ -686,6 +2220,19 @@ void Backend::extra_args(std::ostream *&f, std::string &filename, std::vector<st
 			f = gf;
 #else
 			log_cmd_error("Yosys is compiled without zlib support, unable to write gzip output.\n");
+#endif
+		} else if (has_suffix(".zst")) {
+#ifdef YOSYS_ENABLE_ZSTD
+			zstd_ostream *zf = new zstd_ostream;
+			if (!zf->open(filename, threads)) {
+				delete zf;
+				log_cmd_error("Can't open output file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+			}
+			yosys_output_files.insert(filename);
+			f = zf;
+#else
+			(void)threads;
+			log_cmd_error("Yosys is compiled without zstd support, unable to write zstd output.\n");
 #endif
 		} else {
 			std::ofstream *ff = new std::ofstream;
@@ -726,16 +2273,20 @@ void Backend::backend_call(RTLIL::Design *design, std::ostream *f, std::string f
 		return;
 	if (backend_register.count(args[0]) == 0)
 		log_cmd_error("No such backend: %s\n", args[0].c_str());
+	if (!backend_register[args[0]]->keeps_shared_modules_flag)
+		design->unshare_modules();
 
 	size_t orig_sel_stack_pos = design->selection_stack.size();
 
 	if (f != NULL) {
-		auto state = backend_register[args[0]]->pre_execute();
+		restore_spilled_modules(design);
+		auto state = backend_register[args[0]]->pre_execute(args, design);
 		backend_register[args[0]]->execute(f, filename, args, design);
 		backend_register[args[0]]->post_execute(state);
 	} else if (filename == "-") {
 		std::ostream *f_cout = &std::cout;
-		auto state = backend_register[args[0]]->pre_execute();
+		restore_spilled_modules(design);
+		auto state = backend_register[args[0]]->pre_execute(args, design);
 		backend_register[args[0]]->execute(f_cout, "<stdout>", args, design);
 		backend_register[args[0]]->post_execute(state);
 	} else {
@@ -789,7 +2340,7 @@ static struct CellHelpMessages {
 } cell_help_messages;
 
 struct HelpPass : public Pass {
-	HelpPass() : Pass("help", "display help messages") { }
+	HelpPass() : Pass("help", "display help messages") { keeps_shared_modules(); }
 	void help() override
 	{
 		log("\n");
@@ -1156,7 +2707,7 @@ struct HelpPass : public Pass {
 } HelpPass;
 
 struct EchoPass : public Pass {
-	EchoPass() : Pass("echo", "turning echoing back of commands on and off") { }
+	EchoPass() : Pass("echo", "turning echoing back of commands on and off") { keeps_shared_modules(); }
 	void help() override
 	{
 		log("\n");
@@ -1188,6 +2739,87 @@ struct EchoPass : public Pass {
 	}
 } EchoPass;
 
+static std::ostringstream *job_worker_log = nullptr;
+
+static void job_worker_error()
+{
+	write_job_chunk(std::cout, "log", job_worker_log->str());
+	std::cout.flush();
+}
+
+struct JobWorkerPass : public Pass {
+	JobWorkerPass() : Pass("job_worker", "run a module job of a remote synthesis script") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    job_worker\n");
+		log("\n");
+		log("Read a module job from stdin, run its commands and write the log and the\n");
+		log("resulting modules to stdout. Synthesis scripts that run module jobs (e.g.\n");
+		log("'synth_xilinx -jobs') with the scratchpad variable script.remote_workers set\n");
+		log("start this command as '<worker> -q -p job_worker' for each job, where <worker>\n");
+		log("is one of the comma separated commands in script.remote_workers, e.g.\n");
+		log("\n");
+		log("    scratchpad -set script.remote_workers \"ssh -C host1 yosys,ssh -C host2 yosys\"\n");
+		log("\n");
+		log("The design and the results are sent as binary RTLIL. The worker needs the same\n");
+		log("version of yosys and the same plugins as the calling process. This command is\n");
+		log("not meant to be called directly.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		if (args.size() > 1)
+			cmd_error(args, 1, "Extra argument.");
+
+		std::string request((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+		std::istringstream in(request);
+		std::string script, job_autoidx, design_data;
+		if (!read_job_chunk(in, "script", script) || !read_job_chunk(in, "autoidx", job_autoidx) ||
+				!read_job_chunk(in, "design", design_data))
+			log_cmd_error("Malformed job request.\n");
+
+		while (!design->modules_.empty())
+			design->remove(design->modules_.begin()->second);
+		RTLIL_BINARY::parse_design(design_data.data(), design_data.size(), design, RTLIL_BINARY::ReadOptions());
+		autoidx = std::max(autoidx, atoi(job_autoidx.c_str()));
+
+		// the modules of the job are the ones the caller did not blackbox
+		RTLIL::Selection selection(false);
+		for (auto module : design->modules())
+			if (!module->get_blackbox_attribute())
+				selection.selected_modules.insert(module->name);
+
+		std::ostringstream log_stream;
+		job_worker_log = &log_stream;
+		log_streams.push_back(&log_stream);
+		log_error_atexit = job_worker_error;
+
+		std::istringstream script_in(script);
+		std::string line;
+		while (std::getline(script_in, line)) {
+			if (line.size() < 2)
+				continue;
+			Pass::call(design, line.substr(2));
+			if (line[0] == '1')
+				design->check();
+		}
+
+		log_error_atexit = nullptr;
+		log_streams.pop_back();
+		job_worker_log = nullptr;
+
+		design->selection_stack.back() = selection;
+		std::ostringstream out;
+		RTLIL_BINARY::dump_design(out, design, true);
+		write_job_chunk(std::cout, "log", log_stream.str());
+		write_job_chunk(std::cout, "autoidx", std::to_string(autoidx));
+		write_job_chunk(std::cout, "design", out.str());
+		std::cout.flush();
+	}
+} JobWorkerPass;
+
 SatSolver *yosys_satsolver_list;
 SatSolver *yosys_satsolver;
 
@@ -1200,6 +2832,69 @@ struct MinisatSatSolver : public SatSolver {
 	}
 } MinisatSatSolver;
 
+#ifdef YOSYS_ENABLE_THREADS
+struct PortfolioSatSolver : public SatSolver {
+	PortfolioSatSolver() : SatSolver("portfolio") { }
+	ezSAT *create() override {
+		return new ezPortfolio(std::min(std::max(yosys_threads, 2), 4));
+	}
+} PortfolioSatSolver;
+#endif
+
+#ifdef YOSYS_ENABLE_IPASIR
+struct IpasirSatSolver : public SatSolver {
+	IpasirSatSolver() : SatSolver("ipasir") { }
+	ezSAT *create() override {
+		return new ezIpasir();
+	}
+} IpasirSatSolver;
+#endif
+
+struct SatSolverPass : public Pass {
+	SatSolverPass() : Pass("satsolver", "select the SAT solver") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    satsolver [<name>]\n");
+		log("\n");
+		log("Select the SAT solver used by all commands that solve SAT problems internally,\n");
+		log("such as sat, freduce, share, opt_dff -sat, equiv_simple, equiv_induct and\n");
+		log("qbfsat. Without an argument, the available solvers are listed and the selected\n");
+		log("one is marked. Depending on the build options, the solvers are:\n");
+		log("\n");
+		log("    minisat\n");
+		log("        MiniSAT 2.2 with simplification. This is the default.\n");
+		log("\n");
+		log("    portfolio\n");
+		log("        runs 2 to 4 differently configured instances of MiniSAT (as many as\n");
+		log("        set with 'yosys -j') in separate threads and takes the first answer.\n");
+		log("        The models found for hard problems may differ between runs.\n");
+		log("\n");
+		log("    ipasir\n");
+		log("        the incremental solver with an IPASIR interface that was linked into\n");
+		log("        Yosys when building it with ENABLE_IPASIR=1 and IPASIR_LIBS=...\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design*) override
+	{
+		if (args.size() > 2)
+			cmd_error(args, 2, "Unexpected argument.");
+
+		if (args.size() == 2) {
+			SatSolver *solver = yosys_satsolver_list;
+			while (solver != nullptr && solver->name != args[1])
+				solver = solver->next;
+			if (solver == nullptr)
+				log_cmd_error("SAT solver `%s' is not available.\n", args[1].c_str());
+			yosys_satsolver = solver;
+		}
+
+		for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+			log("%s %s\n", solver == yosys_satsolver ? "*" : " ", solver->name.c_str());
+	}
+} SatSolverPass;
+
 struct LicensePass : public Pass {
 	LicensePass() : Pass("license", "print license terms") { }
 	void help() override
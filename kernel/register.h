@@ -25,6 +25,8 @@
 
 YOSYS_NAMESPACE_BEGIN
 
+struct ProfileSlot;
+
 struct Pass
 {
 	std::string pass_name, short_help;
@@ -37,21 +39,78 @@ struct Pass
 
 	int call_counter;
 	int64_t runtime_ns;
+
+	// memory accounting, see MemoryUsage in kernel/log.h. Like runtime_ns,
+	// the deltas and the peak exclude nested pass calls.
+	int64_t rss_delta_bytes;
+	int64_t heap_delta_bytes;
+	int64_t peak_rss_bytes;
+
+	// changes of the KernelStats counters, excluding nested pass calls
+	int64_t kernel_stats_delta[KernelStats::NUM_COUNTERS];
 	bool experimental_flag = false;
 
 	void experimental() {
 		experimental_flag = true;
 	}
 
+	// The pass only modifies the design through the API calls that notify
+	// monitors, so indexes cached with ModIndex::cached() (and the timing
+	// graph of `sta`) stay valid.
+	bool keeps_indexes_flag = false;
+
+	void keeps_indexes() {
+		keeps_indexes_flag = true;
+	}
+
+	// The pass does not modify any modules (or handles shared modules itself,
+	// like the `design` command), so modules shared between designs need not
+	// be unshared before it runs, see RTLIL::Design::add_shared().
+	bool keeps_shared_modules_flag = false;
+
+	void keeps_shared_modules() {
+		keeps_shared_modules_flag = true;
+	}
+
+	// The pass only looks at the contents of modules that it looks up by
+	// name or that are selected, so modules spilled to disk (see
+	// kernel/spill.h) need not be read back before it runs. Spilled modules
+	// are stubs without cells, every other pass sees all of them restored.
+	bool selection_safe_flag = false;
+
+	void selection_safe() {
+		selection_safe_flag = true;
+	}
+
 	struct pre_post_exec_state_t {
 		Pass *parent_pass;
 		int64_t begin_ns;
+		int64_t begin_rss;
+		int64_t begin_heap;
+		uint64_t begin_stats[KernelStats::NUM_COUNTERS];
+		int peak_rss_depth;
+		RTLIL::Design *design;
+		ProfileSlot *profile_pass, *profile_module;
 	};
 
-	pre_post_exec_state_t pre_execute();
+	pre_post_exec_state_t pre_execute(const std::vector<std::string> &args = {}, RTLIL::Design *design = nullptr);
 	void post_execute(pre_post_exec_state_t state);
 
+	// write begin/end events of all pass calls to a Chrome / Perfetto
+	// trace event file (JSON array format)
+	static void open_trace_json(const std::string &filename);
+	static void close_trace_json();
+
+	// sample the running pass and module (see ModuleScope) with a SIGPROF
+	// timer at `frequency` Hz, and print the samples at the end of the run
+	static void start_profiler(int frequency);
+	static void stop_profiler();
+	static void print_profile(int max_lines = 30);
+
 	void cmd_log_args(const std::vector<std::string> &args);
+
+	// key identifying a pass invocation for RTLIL::Module::converged()
+	static std::string converged_key(const std::vector<std::string> &args);
 	void cmd_error(const std::vector<std::string> &args, size_t argidx, std::string msg);
 	void extra_args(std::vector<std::string> args, size_t argidx, RTLIL::Design *design, bool select = true);
 
@@ -64,6 +123,50 @@ struct Pass
 	static void call_on_module(RTLIL::Design *design, RTLIL::Module *module, std::string command);
 	static void call_on_module(RTLIL::Design *design, RTLIL::Module *module, std::vector<std::string> args);
 
+	// Run worker() on each of the given modules, spread over up to
+	// parallel_threads() threads. The worker must only modify its own module
+	// and must not call other passes. Log output is buffered per module and
+	// replayed in module order, and NEW_ID uses a per-module counter, so the
+	// result does not depend on scheduling. Designs with monitors attached are
+	// always processed serially, except for the module-local cached ModIndex
+	// and timing graph, and so are designs with spilling enabled (see
+	// kernel/spill.h).
+	static int parallel_threads(RTLIL::Design *design);
+	static void parallel_modules(RTLIL::Design *design, const std::vector<RTLIL::Module*> &modules,
+			const std::function<void(RTLIL::Module*)> &worker);
+
+	// Run worker(i) for every i in [0, count) with the same threading, log
+	// buffering and error handling as parallel_modules(), for jobs that don't
+	// modify the design (e.g. rendering parts of a module in a backend). A
+	// positive `threads` replaces parallel_threads() as the thread limit, for
+	// jobs that mostly wait on subprocesses (e.g. `abc -j`). Like
+	// parallel_modules(), runs serially when spilling is enabled.
+	static void parallel_for(RTLIL::Design *design, int count, const std::function<void(int)> &worker, int threads = 0);
+
+	template<typename T, typename F>
+	static void parallel_for_each(RTLIL::Design *design, const std::vector<T> &items, F worker, int threads = 0) {
+		parallel_for(design, GetSize(items), [&](int i) { worker(items[i]); }, threads);
+	}
+
+	// Index of the calling thread among the threads of the running
+	// parallel_modules() or parallel_for() job, in [0, thread limit), and 0
+	// outside of parallel jobs. See PerThread below.
+	static int parallel_worker();
+
+	// Run job_main(i, prefix) for every i in [0, jobs) in a forked child
+	// process, for work that is not thread safe (passes, or libraries with
+	// global state). Each child gets a copy of the whole process, logs to
+	// `prefix`.log and can leave its results in other files starting with
+	// `prefix`, e.g. a design written with RTLIL_BINARY::dump_design(). The
+	// parent then replays the log of each job and calls merge(i, prefix,
+	// success), in job order. A non-empty string returned by merge() is
+	// reported as an error once the temporary files are removed. A positive
+	// `max_running` limits the number of children that exist at the same
+	// time, otherwise all jobs are forked at once. Returns false without
+	// running anything where fork() is not available.
+	static bool fork_jobs(int jobs, const std::function<void(int, const std::string&)> &job_main,
+			const std::function<std::string(int, const std::string&, bool)> &merge, int max_running = 0);
+
 	Pass *next_queued_pass;
 	virtual void run_register();
 	static void init_register();
@@ -74,12 +177,74 @@ struct Pass
 	virtual bool replace_existing_pass() const { return false; }
 };
 
+// Thread safety of parallel_modules() and parallel_for() workers (including
+// those of plugins): all threads may concurrently read the design, i.e. look
+// up modules, iterate over wires, cells, connections, attributes and
+// parameters, and query CellTypes and other const helpers that were built
+// before the job started. SigMap lookups update the SigMap (they compress its
+// paths), so each thread needs a SigMap of its own. IdStrings may be created
+// and destroyed freely, and log() and friends as well as log_error() are safe
+// (output is buffered per job and replayed in job order). Modifying a module
+// is only safe in a parallel_modules() worker and only for the worker's own
+// module. Everything else, including Pass::call(), selections, scratchpad
+// writes and the global caches of e.g. ModIndex, needs the job to be
+// finished. Jobs started from within a worker run serially on the worker's
+// thread.
+//
+// Data a worker needs for scratch space or to collect results can be kept
+// per thread: PerThread<T> holds one T per worker thread, and local()
+// returns the one of the calling thread, without any locking.
+template<typename T>
+struct PerThread
+{
+	std::vector<T> slots;
+
+	PerThread(RTLIL::Design *design, int threads = 0) : slots(threads > 0 ? threads : Pass::parallel_threads(design)) { }
+	T &local() { return slots.at(Pass::parallel_worker()); }
+
+	typename std::vector<T>::iterator begin() { return slots.begin(); }
+	typename std::vector<T>::iterator end() { return slots.end(); }
+};
+
+// Collects tasks that are independent of each other and runs them with
+// Pass::parallel_for() on wait(). The same rules as for parallel_for()
+// workers apply to the tasks.
+struct TaskGroup
+{
+	RTLIL::Design *design;
+	std::vector<std::function<void()>> tasks;
+
+	TaskGroup(RTLIL::Design *design) : design(design) { }
+	void add(std::function<void()> task) { tasks.push_back(std::move(task)); }
+	void wait() {
+		std::vector<std::function<void()>> running;
+		running.swap(tasks);
+		Pass::parallel_for(design, GetSize(running), [&](int i) { running[i](); });
+	}
+};
+
+// Attributes the samples of the profiler ('yosys --profile') to the given
+// module of the current pass until the scope ends. Passes that work module
+// by module open one per module, parallel_modules() does it for its workers.
+struct ModuleScope
+{
+	ProfileSlot *parent;
+	ModuleScope(RTLIL::Module *module);
+	~ModuleScope();
+};
+
 struct ScriptPass : Pass
 {
 	bool block_active, help_mode;
 	RTLIL::Design *active_design;
 	std::string active_run_from, active_run_to;
 
+	// with "scratchpad -set script.checkpoint_dir <dir>", run_script() saves
+	// the design at each label and resumes from the last saved label whose
+	// input design and preceding commands are unchanged
+	std::vector<std::pair<std::string, std::string>> *checkpoint_trace = nullptr;
+	dict<std::string, std::string> checkpoint_files;
+
 	ScriptPass(std::string name, std::string short_help = "** document me **") : Pass(name, short_help) { }
 
 	virtual void script() = 0;
@@ -89,6 +254,32 @@ struct ScriptPass : Pass
 	void run_nocheck(std::string command, std::string info = std::string());
 	void run_script(RTLIL::Design *design, std::string run_from = std::string(), std::string run_to = std::string());
 	void help_script();
+
+	// Between begin_module_jobs() and end_module_jobs(), run() only queues
+	// the commands. end_module_jobs() splits the modules into up to `jobs`
+	// groups of similar size and runs the queued commands on each group in a
+	// forked process, with all other modules turned into blackboxes. The
+	// results are read back as binary RTLIL and merged in group order, and
+	// the logs of the groups are replayed in the same order, so the result
+	// only depends on the number of jobs. Only meant for commands that work
+	// module by module. Runs the commands as usual with jobs <= 1, with a
+	// partial selection, and in builds without fork(). With the scratchpad
+	// variable script.remote_workers set to a comma separated list of
+	// commands that start yosys (e.g. over ssh), each group is sent to one
+	// of them instead, see 'help job_worker'. With script.module_cache set
+	// to a directory, the results are cached per module there, under a key
+	// made from the module, the interfaces of the modules it instantiates,
+	// the queued commands, the files they name and the yosys version, and
+	// the modules with a matching entry are taken from the cache instead.
+	void begin_module_jobs(int jobs);
+	void end_module_jobs();
+
+private:
+	int module_jobs = 0;
+	std::vector<std::pair<std::string, bool>> queued_commands;
+
+	std::string resume_checkpoint(RTLIL::Design *design, const std::string &dir, const std::string &run_from, const std::string &run_to);
+	void run_module_jobs();
 };
 
 struct Frontend : Pass
@@ -107,6 +298,10 @@ struct Frontend : Pass
 	static std::vector<std::string> next_args;
 	void extra_args(std::istream *&f, std::string &filename, std::vector<std::string> args, size_t argidx, bool bin_input = false);
 
+	// calls parse with the complete input, plain files are mapped into
+	// memory instead of being copied through the stream
+	static void read_input_data(std::istream *f, const std::string &filename, const std::function<void(const char *, size_t)> &parse);
+
 	static void frontend_call(RTLIL::Design *design, std::istream *f, std::string filename, std::string command);
 	static void frontend_call(RTLIL::Design *design, std::istream *f, std::string filename, std::vector<std::string> args);
 };
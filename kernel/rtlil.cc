@@ -22,6 +22,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/binding.h"
 #include "kernel/sigtools.h"
+#include "kernel/spill.h"
 #include "frontends/verilog/verilog_frontend.h"
 #include "frontends/verilog/preproc.h"
 #include "backends/rtlil/rtlil_backend.h"
@@ -29,21 +30,172 @@
 #include <string.h>
 #include <algorithm>
 #include <optional>
+#ifdef YOSYS_ENABLE_THREADS
+#  include <mutex>
+#endif
 
 YOSYS_NAMESPACE_BEGIN
 
 bool RTLIL::IdString::destruct_guard_ok = false;
 RTLIL::IdString::destruct_guard_t RTLIL::IdString::destruct_guard;
-std::vector<char*> RTLIL::IdString::global_id_storage_;
-dict<char*, int> RTLIL::IdString::global_id_index_;
+RTLIL::IdString::chunked_storage<char*> RTLIL::IdString::global_id_storage_;
+dict<char*, int> RTLIL::IdString::global_id_index_[RTLIL::IdString::index_shards];
+RTLIL::IdString::chunked_storage<RTLIL::IdString::auto_id_t> RTLIL::IdString::global_auto_id_storage_;
+std::vector<int> RTLIL::IdString::global_auto_id_pending_;
+int RTLIL::IdString::global_auto_id_live_;
 #ifndef YOSYS_NO_IDS_REFCNT
-std::vector<int> RTLIL::IdString::global_refcount_storage_;
+RTLIL::IdString::chunked_storage<std::atomic<int>> RTLIL::IdString::global_refcount_storage_;
 std::vector<int> RTLIL::IdString::global_free_idx_list_;
 #endif
 #ifdef YOSYS_USE_STICKY_IDS
 int RTLIL::IdString::last_created_idx_[8];
 int RTLIL::IdString::last_created_idx_ptr_;
 #endif
+int RTLIL::IdString::concurrent_mode_;
+
+#ifdef YOSYS_ENABLE_THREADS
+static std::mutex id_index_shard_mutex[RTLIL::IdString::index_shards];
+static std::mutex id_alloc_mutex;
+#endif
+#ifndef YOSYS_NO_IDS_REFCNT
+static std::vector<int> id_deferred_free_list;
+#endif
+
+void RTLIL::IdString::enter_concurrent_mode()
+{
+	// pending names are materialized lazily from c_str(), which must not
+	// happen while other threads use the index
+	if (concurrent_mode_ == 0)
+		materialize_auto_ids();
+	concurrent_mode_++;
+}
+
+void RTLIL::IdString::leave_concurrent_mode()
+{
+	log_assert(concurrent_mode_ > 0);
+	if (--concurrent_mode_ > 0)
+		return;
+
+#ifndef YOSYS_NO_IDS_REFCNT
+	// Back in single-threaded operation: free everything that dropped to a
+	// refcount of zero and was not picked up again in the meantime.
+	std::vector<int> deferred;
+	std::swap(deferred, id_deferred_free_list);
+	for (int idx : deferred)
+		if (global_id_storage_[idx] != nullptr && global_refcount_storage_[idx].load(std::memory_order_relaxed) == 0)
+			free_reference(idx);
+#endif
+}
+
+RTLIL::IdString RTLIL::IdString::new_auto_id(const char *prefix, int counter)
+{
+	if (concurrent_mode() || yosys_xtrace)
+		return std::string(prefix) + std::to_string(counter);
+
+	IdString id;
+	id.index_ = alloc_index();
+	global_id_storage_[id.index_] = nullptr;
+	global_auto_id_storage_[id.index_] = {prefix, counter};
+#ifndef YOSYS_NO_IDS_REFCNT
+	global_refcount_storage_[id.index_].store(1, std::memory_order_relaxed);
+#endif
+
+	// drop the entries of names that were freed again before their text was
+	// needed, so the list does not grow with the number of NEW_ID calls
+	if (GetSize(global_auto_id_pending_) > 2 * global_auto_id_live_ + 1024) {
+		std::vector<int> pending;
+		for (int idx : global_auto_id_pending_)
+			if (global_id_storage_[idx] == nullptr && global_auto_id_storage_[idx].prefix != nullptr)
+				pending.push_back(idx);
+		std::sort(pending.begin(), pending.end());
+		pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+		global_auto_id_pending_.swap(pending);
+	}
+	global_auto_id_pending_.push_back(id.index_);
+	global_auto_id_live_++;
+	return id;
+}
+
+const char *RTLIL::IdString::materialize_auto_id(int idx)
+{
+	auto_id_t &auto_id = global_auto_id_storage_[idx];
+	log_assert(auto_id.prefix != nullptr);
+	log_assert(!concurrent_mode());
+
+	std::string name = auto_id.prefix + std::to_string(auto_id.counter);
+	char *p = strdup(name.c_str());
+	global_id_storage_[idx] = p;
+	auto_id.prefix = nullptr;
+	global_auto_id_live_--;
+
+	// A name with the same text can only exist if the counter was reused,
+	// then the first one keeps the index entry.
+	global_id_index_[index_shard(p)].emplace(p, idx);
+	return p;
+}
+
+void RTLIL::IdString::materialize_auto_ids()
+{
+	std::vector<int> pending;
+	pending.swap(global_auto_id_pending_);
+	for (int idx : pending)
+		if (global_id_storage_[idx] == nullptr && global_auto_id_storage_[idx].prefix != nullptr)
+			materialize_auto_id(idx);
+}
+
+void RTLIL::IdString::reserve(int n)
+{
+	log_assert(!concurrent_mode());
+	for (auto &index : global_id_index_)
+		index.reserve(index.size() + n / index_shards + 1);
+}
+
+int RTLIL::IdString::get_reference_concurrent(const char *p)
+{
+	int shard = index_shard(p);
+	dict<char*, int> &index = global_id_index_[shard];
+#ifdef YOSYS_ENABLE_THREADS
+	std::lock_guard<std::mutex> shard_lock(id_index_shard_mutex[shard]);
+#endif
+
+	auto it = index.find((char*)p);
+	if (it != index.end())
+		return get_reference(it->second);
+
+	check_new_id(p);
+
+	int idx;
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		std::lock_guard<std::mutex> alloc_lock(id_alloc_mutex);
+#endif
+		idx = alloc_index();
+	}
+
+	global_id_storage_[idx] = strdup(p);
+	index[global_id_storage_[idx]] = idx;
+#ifndef YOSYS_NO_IDS_REFCNT
+	global_refcount_storage_[idx].store(1, std::memory_order_relaxed);
+#endif
+	return idx;
+}
+
+void RTLIL::IdString::put_reference_concurrent(int idx)
+{
+#ifndef YOSYS_NO_IDS_REFCNT
+	if (global_refcount_storage_[idx].fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	// The string may be looked up again by name before the scope ends, so
+	// only remember it here and let leave_concurrent_mode() decide.
+#ifdef YOSYS_ENABLE_THREADS
+	std::lock_guard<std::mutex> alloc_lock(id_alloc_mutex);
+#endif
+	id_deferred_free_list.push_back(idx);
+#else
+	(void)idx;
+#endif
+}
 
 #define X(_id) IdString RTLIL::ID::_id;
 #include "kernel/constids.inc"
@@ -51,6 +203,23 @@ int RTLIL::IdString::last_created_idx_ptr_;
 
 dict<std::string, std::string> RTLIL::constpad;
 
+// RTLIL objects may also be created by worker threads while IdString
+// concurrent mode is active (see Pass::parallel_modules()).
+static unsigned int next_hashidx(std::atomic<unsigned int> &count)
+{
+	unsigned int old_idx = count.load(std::memory_order_relaxed), idx;
+	if (!RTLIL::IdString::concurrent_mode()) {
+		idx = mkhash_xorshift(old_idx);
+		count.store(idx, std::memory_order_relaxed);
+		return idx;
+	}
+	do
+		idx = mkhash_xorshift(old_idx);
+	while (!count.compare_exchange_weak(old_idx, idx, std::memory_order_relaxed));
+	return idx;
+}
+
+
 const pool<IdString> &RTLIL::builtin_ff_cell_types() {
 	static const pool<IdString> res = {
 		ID($sr),
@@ -209,7 +378,7 @@ Const::bitvectype& Const::get_bits() const {
 	return *get_if_bits();
 }
 
-std::string& Const::get_str() const {
+const std::string& Const::get_str() const {
 	check(is_str());
 	return *get_if_str();
 }
@@ -217,10 +386,61 @@ std::string& Const::get_str() const {
 RTLIL::Const::Const(const std::string &str)
 {
 	flags = RTLIL::CONST_FLAG_STRING;
-	new ((void*)&str_) std::string(str);
+	new ((void*)&str_) strtype(std::make_shared<const std::string>(str));
 	tag = backing_tag::string;
 }
 
+namespace {
+	struct interned_string_ops {
+		static inline bool cmp(const std::shared_ptr<const std::string> &a, const std::shared_ptr<const std::string> &b) {
+			return *a == *b;
+		}
+		[[nodiscard]] static inline Hasher hash(const std::shared_ptr<const std::string> &a) {
+			return hash_ops<std::string>::hash(*a);
+		}
+	};
+}
+
+// Strings are only dropped from the table when it has doubled in size since
+// the last cleanup, then every string not used by a Const any more goes.
+static pool<std::shared_ptr<const std::string>, interned_string_ops> interned_strings;
+static int interned_strings_cleanup_size = 1024;
+#ifdef YOSYS_ENABLE_THREADS
+static std::mutex interned_strings_mutex;
+#endif
+
+RTLIL::Const RTLIL::Const::interned(const std::string &str)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	std::unique_lock<std::mutex> lock(interned_strings_mutex, std::defer_lock);
+	if (IdString::concurrent_mode())
+		lock.lock();
+#endif
+
+	// non-owning pointer for the lookup
+	std::shared_ptr<const std::string> key(std::shared_ptr<const std::string>(), &str);
+	auto it = interned_strings.find(key);
+	if (it == interned_strings.end()) {
+		if (GetSize(interned_strings) >= interned_strings_cleanup_size) {
+			for (auto it2 = interned_strings.begin(); it2 != interned_strings.end();) {
+				if (it2->use_count() == 1)
+					it2 = interned_strings.erase(it2);
+				else
+					++it2;
+			}
+			interned_strings_cleanup_size = std::max(1024, 2 * GetSize(interned_strings));
+		}
+		it = interned_strings.insert(std::make_shared<const std::string>(str)).first;
+	}
+
+	Const result;
+	result.bits_.~bitvectype();
+	new ((void*)&result.str_) strtype(*it);
+	result.tag = backing_tag::string;
+	result.flags = RTLIL::CONST_FLAG_STRING;
+	return result;
+}
+
 RTLIL::Const::Const(long long val, int width)
 {
 	flags = RTLIL::CONST_FLAG_NONE;
@@ -260,7 +480,7 @@ RTLIL::Const::Const(const RTLIL::Const &other) {
 	tag = other.tag;
 	flags = other.flags;
 	if (is_str())
-		new ((void*)&str_) std::string(other.get_str());
+		new ((void*)&str_) strtype(other.str_);
 	else if (is_bits())
 		new ((void*)&bits_) bitvectype(other.get_bits());
 	else
@@ -270,9 +490,13 @@ RTLIL::Const::Const(const RTLIL::Const &other) {
 RTLIL::Const::Const(RTLIL::Const &&other) {
 	tag = other.tag;
 	flags = other.flags;
-	if (is_str())
-		new ((void*)&str_) std::string(std::move(other.get_str()));
-	else if (is_bits())
+	if (is_str()) {
+		new ((void*)&str_) strtype(std::move(other.str_));
+		// leave `other` as an empty bit vector, a null string would crash
+		other.str_.~strtype();
+		(void)new ((void*)&other.bits_) bitvectype();
+		other.tag = backing_tag::bits;
+	} else if (is_bits())
 		new ((void*)&bits_) bitvectype(std::move(other.get_bits()));
 	else
 		check(false);
@@ -285,15 +509,15 @@ RTLIL::Const &RTLIL::Const::operator =(const RTLIL::Const &other) {
 			// sketchy zone
 			check(is_bits());
 			bits_.~bitvectype();
-			(void)new ((void*)&str_) std::string();
+			(void)new ((void*)&str_) strtype();
 		}
 		tag = other.tag;
-		get_str() = other.get_str();
+		str_ = other.str_;
 	} else if (other.is_bits()) {
 		if (!is_bits()) {
 			// sketchy zone
 			check(is_str());
-			str_.~string();
+			str_.~strtype();
 			(void)new ((void*)&bits_) bitvectype();
 		}
 		tag = other.tag;
@@ -308,7 +532,7 @@ RTLIL::Const::~Const() {
 	if (is_bits())
 		bits_.~bitvectype();
 	else if (is_str())
-		str_.~string();
+		str_.~strtype();
 	else
 		check(false);
 }
@@ -499,7 +723,7 @@ std::string RTLIL::Const::decode_string() const
 
 int RTLIL::Const::size() const {
 	if (is_str())
-		return 8 * str_.size();
+		return 8 * str_->size();
 	else {
 		check(is_bits());
 		return bits_.size();
@@ -508,7 +732,7 @@ int RTLIL::Const::size() const {
 
 bool RTLIL::Const::empty() const {
 	if (is_str())
-		return str_.empty();
+		return str_->empty();
 	else {
 		check(is_bits());
 		return bits_.empty();
@@ -523,9 +747,10 @@ void RTLIL::Const::bitvectorize() const {
 
 	bitvectype new_bits;
 
-	new_bits.reserve(str_.size() * 8);
-	for (int i = str_.size() - 1; i >= 0; i--) {
-		unsigned char ch = str_[i];
+	const std::string &str = *str_;
+	new_bits.reserve(str.size() * 8);
+	for (int i = str.size() - 1; i >= 0; i--) {
+		unsigned char ch = str[i];
 		for (int j = 0; j < 8; j++) {
 			new_bits.push_back((ch & 1) != 0 ? State::S1 : State::S0);
 			ch = ch >> 1;
@@ -534,7 +759,7 @@ void RTLIL::Const::bitvectorize() const {
 
 	{
 		// sketchy zone
-		str_.~string();
+		str_.~strtype();
 		(void)new ((void*)&bits_) bitvectype(std::move(new_bits));
 		tag = backing_tag::bits;
 	}
@@ -544,8 +769,9 @@ RTLIL::State RTLIL::Const::const_iterator::operator*() const {
 	if (auto bv = parent.get_if_bits())
 		return (*bv)[idx];
 
-	int char_idx = parent.get_str().size() - idx / 8 - 1;
-	bool bit = (parent.get_str()[char_idx] & (1 << (idx % 8)));
+	const std::string &str = parent.get_str();
+	int char_idx = str.size() - idx / 8 - 1;
+	bool bit = (str[char_idx] & (1 << (idx % 8)));
 	return bit ? State::S1 : State::S0;
 }
 
@@ -674,6 +900,8 @@ void RTLIL::AttrObject::set_string_attribute(const RTLIL::IdString& id, string v
 {
 	if (value.empty())
 		attributes.erase(id);
+	else if (id == ID::src)
+		attributes[id] = Const::interned(value);
 	else
 		attributes[id] = value;
 }
@@ -786,10 +1014,8 @@ bool RTLIL::Selection::selected_member(const RTLIL::IdString &mod_name, const RT
 		return true;
 	if (selected_modules.count(mod_name) > 0)
 		return true;
-	if (selected_members.count(mod_name) > 0)
-		if (selected_members.at(mod_name).count(memb_name) > 0)
-			return true;
-	return false;
+	auto it = selected_members.find(mod_name);
+	return it != selected_members.end() && it->second.count(memb_name) > 0;
 }
 
 void RTLIL::Selection::optimize(RTLIL::Design *design)
@@ -852,9 +1078,8 @@ void RTLIL::Selection::optimize(RTLIL::Design *design)
 RTLIL::Design::Design()
   : verilog_defines (new define_map_t)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
 
 	refcount_modules_ = 0;
 	selection_stack.push_back(RTLIL::Selection());
@@ -864,10 +1089,28 @@ RTLIL::Design::Design()
 #endif
 }
 
+// Drops the reference of the design to the module, handing the module over
+// to another design sharing it, or deleting it if there is none.
+static void release_module(RTLIL::Design *design, RTLIL::Module *module)
+{
+	if (module->design != design) {
+		module->sharing_designs_.erase(design);
+		return;
+	}
+
+	if (module->sharing_designs_.empty()) {
+		delete module;
+		return;
+	}
+
+	module->design = *module->sharing_designs_.begin();
+	module->sharing_designs_.erase(module->design);
+}
+
 RTLIL::Design::~Design()
 {
 	for (auto &pr : modules_)
-		delete pr.second;
+		release_module(this, pr.second);
 	for (auto n : bindings_)
 		delete n;
 	for (auto n : verilog_packages)
@@ -894,12 +1137,28 @@ RTLIL::ObjRange<RTLIL::Module*> RTLIL::Design::modules()
 
 RTLIL::Module *RTLIL::Design::module(const RTLIL::IdString& name)
 {
-	return modules_.count(name) ? modules_.at(name) : NULL;
+	auto it = modules_.find(name);
+	if (it == modules_.end())
+		return NULL;
+	if (spill_store)
+		spill_store->access(it->second);
+	return it->second;
 }
 
 const RTLIL::Module *RTLIL::Design::module(const RTLIL::IdString& name) const
 {
-	return modules_.count(name) ? modules_.at(name) : NULL;
+	auto it = modules_.find(name);
+	if (it == modules_.end())
+		return NULL;
+	if (spill_store)
+		spill_store->access(it->second);
+	return it->second;
+}
+
+void RTLIL::Design::unspill(const RTLIL::Module *module) const
+{
+	if (spill_store && module->design == this)
+		spill_store->access(const_cast<RTLIL::Module*>(module));
 }
 
 RTLIL::Module *RTLIL::Design::top_module()
@@ -1038,12 +1297,73 @@ void RTLIL::Design::remove(RTLIL::Module *module)
 
 	log_assert(modules_.at(module->name) == module);
 	log_assert(refcount_modules_ == 0);
+	if (spill_store)
+		spill_store->forget(module);
 	modules_.erase(module->name);
-	delete module;
+	release_module(this, module);
+}
+
+void RTLIL::Design::add_shared(RTLIL::Module *module, bool take_ownership)
+{
+	log_assert(modules_.count(module->name) == 0);
+	log_assert(refcount_modules_ == 0);
+	log_assert(module->design != nullptr && module->design != this);
+	// other designs don't know about the store of the owner
+	module->design->unspill(module);
+	modules_[module->name] = module;
+
+	if (take_ownership) {
+		module->sharing_designs_.insert(module->design);
+		module->design = this;
+	} else {
+		module->sharing_designs_.insert(this);
+	}
+
+	for (auto mon : monitors)
+		mon->notify_module_add(module);
+
+	if (yosys_xtrace) {
+		log("#X# New Shared Module: %s\n", log_id(module));
+		log_backtrace("-X- ", yosys_xtrace-1);
+	}
+}
+
+RTLIL::Module *RTLIL::Design::unshare(RTLIL::Module *module)
+{
+	log_assert(modules_.at(module->name) == module);
+
+	if (module->design != this) {
+		RTLIL::Module *copy = module->clone();
+		copy->design = this;
+		module->sharing_designs_.erase(this);
+		modules_.at(module->name) = copy;
+		return copy;
+	}
+
+	if (!module->sharing_designs_.empty()) {
+		RTLIL::Module *copy = module->clone();
+		copy->design = *module->sharing_designs_.begin();
+		for (auto other : module->sharing_designs_) {
+			if (other != copy->design)
+				copy->sharing_designs_.insert(other);
+			other->modules_.at(module->name) = copy;
+		}
+		module->sharing_designs_.clear();
+	}
+
+	return module;
+}
+
+void RTLIL::Design::unshare_modules()
+{
+	for (auto &it : modules_)
+		if (it.second->design != this || !it.second->sharing_designs_.empty())
+			unshare(it.second);
 }
 
 void RTLIL::Design::rename(RTLIL::Module *module, RTLIL::IdString new_name)
 {
+	module = unshare(module);
 	modules_.erase(module->name);
 	module->name = new_name;
 	add(module);
@@ -1051,6 +1371,9 @@ void RTLIL::Design::rename(RTLIL::Module *module, RTLIL::IdString new_name)
 
 void RTLIL::Design::sort()
 {
+	// sorting a stub would leave the module read back later unsorted
+	if (spill_store && spill_store->spilled_count() != 0)
+		spill_store->restore_all();
 	scratchpad.sort();
 	modules_.sort(sort_by_id_str());
 	for (auto &it : modules_)
@@ -1060,12 +1383,18 @@ void RTLIL::Design::sort()
 void RTLIL::Design::check()
 {
 #ifndef NDEBUG
+	std::vector<RTLIL::Module*> todo;
 	for (auto &it : modules_) {
-		log_assert(this == it.second->design);
+		log_assert(this == it.second->design || it.second->sharing_designs_.count(this));
 		log_assert(it.first == it.second->name);
 		log_assert(!it.first.empty());
-		it.second->check();
+		todo.push_back(it.second);
 	}
+
+	// Module::check() only reads its own module
+	Pass::parallel_modules(this, todo, [](RTLIL::Module *module) {
+		module->check();
+	});
 #endif
 }
 
@@ -1079,22 +1408,33 @@ void RTLIL::Design::optimize()
 		it.second.optimize(this);
 }
 
+// A selected module is about to be accessed, so a spilled one is read back.
 bool RTLIL::Design::selected_module(const RTLIL::IdString& mod_name) const
 {
 	if (!selected_active_module.empty() && mod_name != selected_active_module)
 		return false;
-	if (selection_stack.size() == 0)
-		return true;
-	return selection_stack.back().selected_module(mod_name);
+	if (selection_stack.size() != 0 && !selection_stack.back().selected_module(mod_name))
+		return false;
+	if (spill_store) {
+		auto it = modules_.find(mod_name);
+		if (it != modules_.end())
+			unspill(it->second);
+	}
+	return true;
 }
 
 bool RTLIL::Design::selected_whole_module(const RTLIL::IdString& mod_name) const
 {
 	if (!selected_active_module.empty() && mod_name != selected_active_module)
 		return false;
-	if (selection_stack.size() == 0)
-		return true;
-	return selection_stack.back().selected_whole_module(mod_name);
+	if (selection_stack.size() != 0 && !selection_stack.back().selected_whole_module(mod_name))
+		return false;
+	if (spill_store) {
+		auto it = modules_.find(mod_name);
+		if (it != modules_.end())
+			unspill(it->second);
+	}
+	return true;
 }
 
 bool RTLIL::Design::selected_member(const RTLIL::IdString& mod_name, const RTLIL::IdString& memb_name) const
@@ -1141,20 +1481,19 @@ std::vector<RTLIL::Module*> RTLIL::Design::selected_whole_modules_warn(bool incl
 	std::vector<RTLIL::Module*> result;
 	result.reserve(modules_.size());
 	for (auto &it : modules_)
-		if (it.second->get_blackbox_attribute(include_wb))
+		if (!selected_module(it.first) || it.second->get_blackbox_attribute(include_wb))
 			continue;
 		else if (selected_whole_module(it.first))
 			result.push_back(it.second);
-		else if (selected_module(it.first))
+		else
 			log_warning("Ignoring partially selected module %s.\n", log_id(it.first));
 	return result;
 }
 
 RTLIL::Module::Module()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
 
 	design = nullptr;
 	refcount_wires_ = 0;
@@ -1167,12 +1506,15 @@ RTLIL::Module::Module()
 
 RTLIL::Module::~Module()
 {
+	delete cached_index_;
+	delete cached_timing_;
+	delete cached_ffs_;
 	for (auto &pr : wires_)
-		delete pr.second;
+		destroy(pr.second);
 	for (auto &pr : memories)
 		delete pr.second;
 	for (auto &pr : cells_)
-		delete pr.second;
+		destroy(pr.second);
 	for (auto &pr : processes)
 		delete pr.second;
 	for (auto binding : bindings_)
@@ -1203,7 +1545,7 @@ void RTLIL::Module::makeblackbox()
 	memories.clear();
 
 	for (auto it = cells_.begin(); it != cells_.end(); ++it)
-		delete it->second;
+		destroy(it->second);
 	cells_.clear();
 
 	for (auto it = processes.begin(); it != processes.end(); ++it)
@@ -2303,6 +2645,18 @@ void RTLIL::Module::cloneInto(RTLIL::Module *new_mod) const
 	new_mod->avail_parameters = avail_parameters;
 	new_mod->parameter_default_values = parameter_default_values;
 
+	// Into an empty module nobody listens to, the objects are copied
+	// directly and their signals remapped through a wire pointer map, instead
+	// of going through addWire()/addCell()/connect() and looking up every chunk
+	// by name.
+	bool bulk = new_mod->wires_.empty() && new_mod->cells_.empty() && new_mod->memories.empty() &&
+			new_mod->processes.empty() && new_mod->connections_.empty() && new_mod->monitors.empty() &&
+			(new_mod->design == nullptr || new_mod->design->monitors.empty()) && !yosys_xtrace;
+	if (bulk) {
+		bulk_cloneInto(new_mod);
+		return;
+	}
+
 	for (auto &conn : connections_)
 		new_mod->connect(conn);
 
@@ -2326,6 +2680,11 @@ void RTLIL::Module::cloneInto(RTLIL::Module *new_mod) const
 		RTLIL::Module *mod;
 		void operator()(RTLIL::SigSpec &sig)
 		{
+			if (sig.inline_) {
+				if (sig.inline_bit_.wire != NULL)
+					sig.inline_bit_.wire = mod->wires_.at(sig.inline_bit_.wire->name);
+				return;
+			}
 			sig.pack();
 			for (auto &c : sig.chunks_)
 				if (c.wire != NULL)
@@ -2339,6 +2698,80 @@ void RTLIL::Module::cloneInto(RTLIL::Module *new_mod) const
 	new_mod->fixup_ports();
 }
 
+void RTLIL::Module::bulk_cloneInto(RTLIL::Module *new_mod) const
+{
+	for (auto &attr : attributes)
+		new_mod->attributes[attr.first] = attr.second;
+
+	dict<RTLIL::Wire*, RTLIL::Wire*> wire_map;
+	wire_map.reserve(wires_.size());
+	new_mod->wires_.reserve(wires_.size());
+	for (auto &it : wires_) {
+		const RTLIL::Wire *other = it.second;
+		RTLIL::Wire *wire = new (new_mod->wire_pool_.allocate()) RTLIL::Wire;
+		wire->name = it.first;
+		wire->width = other->width;
+		wire->start_offset = other->start_offset;
+		wire->port_id = other->port_id;
+		wire->port_input = other->port_input;
+		wire->port_output = other->port_output;
+		wire->upto = other->upto;
+		wire->is_signed = other->is_signed;
+		wire->attributes = other->attributes;
+		wire->module = new_mod;
+		new_mod->wires_[it.first] = wire;
+		wire_map[it.second] = wire;
+	}
+
+	auto remap = [&](RTLIL::SigSpec &sig) {
+		if (sig.inline_) {
+			if (sig.inline_bit_.wire != NULL)
+				sig.inline_bit_.wire = wire_map.at(sig.inline_bit_.wire);
+		} else {
+			sig.pack();
+			for (auto &c : sig.chunks_)
+				if (c.wire != NULL)
+					c.wire = wire_map.at(c.wire);
+		}
+		sig.hash_ = 0;
+	};
+
+	new_mod->connections_.reserve(connections_.size());
+	for (auto &conn : connections_) {
+		RTLIL::SigSig new_conn = conn;
+		remap(new_conn.first);
+		remap(new_conn.second);
+		if (new_conn.first.has_const())
+			new_mod->connect(new_conn);
+		else
+			new_mod->connections_.push_back(std::move(new_conn));
+	}
+
+	for (auto &it : memories)
+		new_mod->addMemory(it.first, it.second);
+
+	new_mod->cells_.reserve(cells_.size());
+	for (auto &it : cells_) {
+		const RTLIL::Cell *other = it.second;
+		RTLIL::Cell *cell = new (new_mod->cell_pool_.allocate()) RTLIL::Cell;
+		cell->name = it.first;
+		cell->type = other->type;
+		cell->connections_ = other->connections_;
+		for (auto &conn : cell->connections_)
+			remap(conn.second);
+		cell->parameters = other->parameters;
+		cell->attributes = other->attributes;
+		cell->module = new_mod;
+		new_mod->cells_[it.first] = cell;
+	}
+	new_mod->generation_++;
+
+	for (auto &it : processes)
+		new_mod->addProcess(it.first, it.second)->rewrite_sigspecs(remap);
+
+	new_mod->fixup_ports();
+}
+
 RTLIL::Module *RTLIL::Module::clone() const
 {
 	RTLIL::Module *new_mod = new RTLIL::Module;
@@ -2371,13 +2804,30 @@ bool RTLIL::Module::has_processes_warn() const
 	return !processes.empty();
 }
 
+// resolves the selection state of the module once instead of per member,
+// so whole-module selections cost nothing per object
+template<typename T>
+static void collect_selected(const RTLIL::Design *design, const RTLIL::IdString &mod_name,
+		const dict<RTLIL::IdString, T*> &objects, std::vector<T*> &result)
+{
+	if (!design->selected_module(mod_name))
+		return;
+	if (design->selected_whole_module(mod_name)) {
+		for (auto &it : objects)
+			result.push_back(it.second);
+		return;
+	}
+	const pool<RTLIL::IdString> &names = design->selection_stack.back().selected_members.at(mod_name);
+	for (auto &it : objects)
+		if (names.count(it.first))
+			result.push_back(it.second);
+}
+
 std::vector<RTLIL::Wire*> RTLIL::Module::selected_wires() const
 {
 	std::vector<RTLIL::Wire*> result;
 	result.reserve(wires_.size());
-	for (auto &it : wires_)
-		if (design->selected(this, it.second))
-			result.push_back(it.second);
+	collect_selected(design, name, wires_, result);
 	return result;
 }
 
@@ -2385,9 +2835,7 @@ std::vector<RTLIL::Cell*> RTLIL::Module::selected_cells() const
 {
 	std::vector<RTLIL::Cell*> result;
 	result.reserve(cells_.size());
-	for (auto &it : cells_)
-		if (design->selected(this, it.second))
-			result.push_back(it.second);
+	collect_selected(design, name, cells_, result);
 	return result;
 }
 
@@ -2407,6 +2855,7 @@ void RTLIL::Module::add(RTLIL::Cell *cell)
 	log_assert(refcount_cells_ == 0);
 	cells_[cell->name] = cell;
 	cell->module = this;
+	generation_++;
 }
 
 void RTLIL::Module::add(RTLIL::Process *process)
@@ -2454,13 +2903,28 @@ void RTLIL::Module::remove(const pool<RTLIL::Wire*> &wires)
 	delete_wire_worker.wires_p = &wires;
 	rewrite_sigspecs2(delete_wire_worker);
 
+	if (!wires.empty())
+		init_generation_++;
+
 	for (auto &it : wires) {
 		log_assert(wires_.count(it->name) != 0);
 		wires_.erase(it->name);
-		delete it;
+		destroy(it);
 	}
 }
 
+void RTLIL::Module::remove(const pool<RTLIL::Cell*> &cells)
+{
+	// When only a few cells go, keeping monitors up to date port by port is
+	// cheaper than having them rebuild after a blackout.
+	std::optional<BatchScope> batch;
+	if (GetSize(cells) > GetSize(cells_) / 8)
+		batch.emplace(this);
+
+	for (auto cell : cells)
+		remove(cell);
+}
+
 void RTLIL::Module::remove(RTLIL::Cell *cell)
 {
 	while (!cell->connections_.empty())
@@ -2469,7 +2933,20 @@ void RTLIL::Module::remove(RTLIL::Cell *cell)
 	log_assert(cells_.count(cell->name) != 0);
 	log_assert(refcount_cells_ == 0);
 	cells_.erase(cell->name);
-	delete cell;
+	destroy(cell);
+	generation_++;
+}
+
+void RTLIL::Module::destroy(RTLIL::Wire *wire)
+{
+	wire->~Wire();
+	wire_pool_.deallocate(wire);
+}
+
+void RTLIL::Module::destroy(RTLIL::Cell *cell)
+{
+	cell->~Cell();
+	cell_pool_.deallocate(cell);
 }
 
 void RTLIL::Module::remove(RTLIL::Process *process)
@@ -2483,6 +2960,7 @@ void RTLIL::Module::rename(RTLIL::Wire *wire, RTLIL::IdString new_name)
 {
 	log_assert(wires_[wire->name] == wire);
 	log_assert(refcount_wires_ == 0);
+	blackout();
 	wires_.erase(wire->name);
 	wire->name = new_name;
 	add(wire);
@@ -2492,6 +2970,7 @@ void RTLIL::Module::rename(RTLIL::Cell *cell, RTLIL::IdString new_name)
 {
 	log_assert(cells_[cell->name] == cell);
 	log_assert(refcount_wires_ == 0);
+	blackout();
 	cells_.erase(cell->name);
 	cell->name = new_name;
 	add(cell);
@@ -2508,11 +2987,60 @@ void RTLIL::Module::rename(RTLIL::IdString old_name, RTLIL::IdString new_name)
 		log_abort();
 }
 
+void RTLIL::Module::rename(const dict<RTLIL::Wire*, RTLIL::IdString> &wire_names, const dict<RTLIL::Cell*, RTLIL::IdString> &cell_names)
+{
+	if (wire_names.empty() && cell_names.empty())
+		return;
+
+	log_assert(refcount_wires_ == 0);
+	log_assert(refcount_cells_ == 0);
+	blackout();
+
+	if (!wire_names.empty()) {
+		std::vector<RTLIL::Wire*> order;
+		order.reserve(wires_.size());
+		for (auto &it : wires_)
+			order.push_back(it.second);
+		wires_.clear();
+		wires_.reserve(order.size());
+		// dict iterates from the most recently inserted entry, insert in reverse to keep the order
+		for (auto it = order.rbegin(); it != order.rend(); ++it) {
+			auto n = wire_names.find(*it);
+			if (n != wire_names.end())
+				(*it)->name = n->second;
+			log_assert(wires_.count((*it)->name) == 0);
+			wires_[(*it)->name] = *it;
+		}
+	}
+
+	if (!cell_names.empty()) {
+		std::vector<RTLIL::Cell*> order;
+		order.reserve(cells_.size());
+		for (auto &it : cells_)
+			order.push_back(it.second);
+		cells_.clear();
+		cells_.reserve(order.size());
+		for (auto it = order.rbegin(); it != order.rend(); ++it) {
+			auto n = cell_names.find(*it);
+			if (n != cell_names.end())
+				(*it)->name = n->second;
+			log_assert(cells_.count((*it)->name) == 0);
+			cells_[(*it)->name] = *it;
+		}
+	}
+
+	for (auto &it : wire_names)
+		log_assert(cells_.count(it.second) == 0);
+	for (auto &it : cell_names)
+		log_assert(wires_.count(it.second) == 0);
+}
+
 void RTLIL::Module::swap_names(RTLIL::Wire *w1, RTLIL::Wire *w2)
 {
 	log_assert(wires_[w1->name] == w1);
 	log_assert(wires_[w2->name] == w2);
 	log_assert(refcount_wires_ == 0);
+	blackout();
 
 	wires_.erase(w1->name);
 	wires_.erase(w2->name);
@@ -2528,6 +3056,7 @@ void RTLIL::Module::swap_names(RTLIL::Cell *c1, RTLIL::Cell *c2)
 	log_assert(cells_[c1->name] == c1);
 	log_assert(cells_[c2->name] == c2);
 	log_assert(refcount_cells_ == 0);
+	blackout();
 
 	cells_.erase(c1->name);
 	cells_.erase(c2->name);
@@ -2572,15 +3101,48 @@ static bool fixup_ports_compare(const RTLIL::Wire *a, const RTLIL::Wire *b)
 	return a->port_id < b->port_id;
 }
 
-void RTLIL::Module::connect(const RTLIL::SigSig &conn)
+void RTLIL::Module::blackout()
 {
+	generation_++;
+
+	if (defer_notifications())
+		return;
+
 	for (auto mon : monitors)
-		mon->notify_connect(this, conn);
+		mon->notify_blackout(this);
 
 	if (design)
 		for (auto mon : design->monitors)
+			mon->notify_blackout(this);
+}
+
+bool RTLIL::Module::converged(const std::string &key) const
+{
+	if (design == nullptr || !design->scratchpad_get_bool("opt.skip_converged"))
+		return false;
+	auto it = converged_.find(key);
+	return it != converged_.end() && it->second == generation_;
+}
+
+void RTLIL::Module::mark_converged(const std::string &key)
+{
+	if (design != nullptr && design->scratchpad_get_bool("opt.skip_converged"))
+		converged_[key] = generation_;
+}
+
+void RTLIL::Module::connect(const RTLIL::SigSig &conn)
+{
+	generation_++;
+
+	if (!defer_notifications()) {
+		for (auto mon : monitors)
 			mon->notify_connect(this, conn);
 
+		if (design)
+			for (auto mon : design->monitors)
+				mon->notify_connect(this, conn);
+	}
+
 	// ignore all attempts to assign constants to other constants
 	if (conn.first.has_const()) {
 		RTLIL::SigSig new_conn;
@@ -2610,13 +3172,17 @@ void RTLIL::Module::connect(const RTLIL::SigSpec &lhs, const RTLIL::SigSpec &rhs
 
 void RTLIL::Module::new_connections(const std::vector<RTLIL::SigSig> &new_conn)
 {
-	for (auto mon : monitors)
-		mon->notify_connect(this, new_conn);
+	generation_++;
 
-	if (design)
-		for (auto mon : design->monitors)
+	if (!defer_notifications()) {
+		for (auto mon : monitors)
 			mon->notify_connect(this, new_conn);
 
+		if (design)
+			for (auto mon : design->monitors)
+				mon->notify_connect(this, new_conn);
+	}
+
 	if (yosys_xtrace) {
 		log("#X# New connections vector in %s:\n", log_id(this));
 		for (auto &conn: new_conn)
@@ -2636,6 +3202,8 @@ void RTLIL::Module::fixup_ports()
 {
 	std::vector<RTLIL::Wire*> all_ports;
 
+	blackout();
+
 	for (auto &w : wires_)
 		if (w.second->port_input || w.second->port_output)
 			all_ports.push_back(w.second);
@@ -2653,7 +3221,7 @@ void RTLIL::Module::fixup_ports()
 
 RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, int width)
 {
-	RTLIL::Wire *wire = new RTLIL::Wire;
+	RTLIL::Wire *wire = new (wire_pool_.allocate()) RTLIL::Wire;
 	wire->name = name;
 	wire->width = width;
 	add(wire);
@@ -2676,7 +3244,7 @@ RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, const RTLIL::Wire *oth
 
 RTLIL::Cell *RTLIL::Module::addCell(RTLIL::IdString name, RTLIL::IdString type)
 {
-	RTLIL::Cell *cell = new RTLIL::Cell;
+	RTLIL::Cell *cell = new (cell_pool_.allocate()) RTLIL::Cell;
 	cell->name = name;
 	cell->type = type;
 	add(cell);
@@ -3700,9 +4268,9 @@ RTLIL::SigSpec RTLIL::Module::FutureFF(RTLIL::IdString name, const RTLIL::SigSpe
 
 RTLIL::Wire::Wire()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
+	KernelStats::inc(KernelStats::WIRES_CREATED);
 
 	module = nullptr;
 	width = 1;
@@ -3720,6 +4288,7 @@ RTLIL::Wire::Wire()
 
 RTLIL::Wire::~Wire()
 {
+	KernelStats::inc(KernelStats::WIRES_DESTROYED);
 #ifdef WITH_PYTHON
 	RTLIL::Wire::get_all_wires()->erase(hashidx_);
 #endif
@@ -3735,9 +4304,8 @@ std::map<unsigned int, RTLIL::Wire*> *RTLIL::Wire::get_all_wires(void)
 
 RTLIL::Memory::Memory()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
 
 	width = 1;
 	start_offset = 0;
@@ -3749,16 +4317,15 @@ RTLIL::Memory::Memory()
 
 RTLIL::Process::Process() : module(nullptr)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
 }
 
 RTLIL::Cell::Cell() : module(nullptr)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static std::atomic<unsigned int> hashidx_count(123456789);
+	hashidx_ = next_hashidx(hashidx_count);
+	KernelStats::inc(KernelStats::CELLS_CREATED);
 
 	// log("#memtrace# %p\n", this);
 	memhasher();
@@ -3770,6 +4337,7 @@ RTLIL::Cell::Cell() : module(nullptr)
 
 RTLIL::Cell::~Cell()
 {
+	KernelStats::inc(KernelStats::CELLS_DESTROYED);
 #ifdef WITH_PYTHON
 	RTLIL::Cell::get_all_cells()->erase(hashidx_);
 #endif
@@ -3795,13 +4363,17 @@ void RTLIL::Cell::unsetPort(const RTLIL::IdString& portname)
 
 	if (conn_it != connections_.end())
 	{
-		for (auto mon : module->monitors)
-			mon->notify_connect(this, conn_it->first, conn_it->second, signal);
+		module->generation_++;
 
-		if (module->design)
-			for (auto mon : module->design->monitors)
+		if (!module->defer_notifications()) {
+			for (auto mon : module->monitors)
 				mon->notify_connect(this, conn_it->first, conn_it->second, signal);
 
+			if (module->design)
+				for (auto mon : module->design->monitors)
+					mon->notify_connect(this, conn_it->first, conn_it->second, signal);
+		}
+
 		if (yosys_xtrace) {
 			log("#X# Unconnect %s.%s.%s\n", log_id(this->module), log_id(this), log_id(portname));
 			log_backtrace("-X- ", yosys_xtrace-1);
@@ -3922,13 +4494,17 @@ void RTLIL::Cell::setPort(const RTLIL::IdString& portname, RTLIL::SigSpec signal
 	if (!r.second && conn_it->second == signal)
 		return;
 
-	for (auto mon : module->monitors)
-		mon->notify_connect(this, conn_it->first, conn_it->second, signal);
+	module->generation_++;
 
-	if (module->design)
-		for (auto mon : module->design->monitors)
+	if (!module->defer_notifications()) {
+		for (auto mon : module->monitors)
 			mon->notify_connect(this, conn_it->first, conn_it->second, signal);
 
+		if (module->design)
+			for (auto mon : module->design->monitors)
+				mon->notify_connect(this, conn_it->first, conn_it->second, signal);
+	}
+
 	if (yosys_xtrace) {
 		log("#X# Connect %s.%s.%s = %s (%d)\n", log_id(this->module), log_id(this), log_id(portname), log_signal(signal), GetSize(signal));
 		log_backtrace("-X- ", yosys_xtrace-1);
@@ -4021,11 +4597,15 @@ bool RTLIL::Cell::hasParam(const RTLIL::IdString& paramname) const
 
 void RTLIL::Cell::unsetParam(const RTLIL::IdString& paramname)
 {
+	if (module)
+		module->generation_++;
 	parameters.erase(paramname);
 }
 
 void RTLIL::Cell::setParam(const RTLIL::IdString& paramname, RTLIL::Const value)
 {
+	if (module)
+		module->generation_++;
 	parameters[paramname] = std::move(value);
 }
 
@@ -4253,13 +4833,18 @@ RTLIL::SigSpec::SigSpec(const RTLIL::SigChunk &chunk)
 {
 	cover("kernel.rtlil.sigspec.init.chunk");
 
-	if (chunk.width != 0) {
+	if (chunk.wire != NULL && chunk.width != 0) {
+		set_inline(RTLIL::SigBit(chunk.wire, chunk.offset), chunk.width);
+	} else if (chunk.width == 1) {
+		set_inline(RTLIL::SigBit(chunk.data[0]), 1);
+	} else if (chunk.width != 0) {
 		chunks_.emplace_back(chunk);
 		width_ = chunks_.back().width;
+		hash_ = 0;
 	} else {
 		width_ = 0;
+		hash_ = 0;
 	}
-	hash_ = 0;
 	check();
 }
 
@@ -4267,13 +4852,18 @@ RTLIL::SigSpec::SigSpec(RTLIL::SigChunk &&chunk)
 {
 	cover("kernel.rtlil.sigspec.init.chunk.move");
 
-	if (chunk.width != 0) {
+	if (chunk.wire != NULL && chunk.width != 0) {
+		set_inline(RTLIL::SigBit(chunk.wire, chunk.offset), chunk.width);
+	} else if (chunk.width == 1) {
+		set_inline(RTLIL::SigBit(chunk.data[0]), 1);
+	} else if (chunk.width != 0) {
 		chunks_.emplace_back(std::move(chunk));
 		width_ = chunks_.back().width;
+		hash_ = 0;
 	} else {
 		width_ = 0;
+		hash_ = 0;
 	}
-	hash_ = 0;
 	check();
 }
 
@@ -4281,13 +4871,10 @@ RTLIL::SigSpec::SigSpec(RTLIL::Wire *wire)
 {
 	cover("kernel.rtlil.sigspec.init.wire");
 
-	if (wire->width != 0) {
-		chunks_.emplace_back(wire);
-		width_ = chunks_.back().width;
-	} else {
-		width_ = 0;
-	}
+	width_ = 0;
 	hash_ = 0;
+	if (wire->width != 0)
+		set_inline(RTLIL::SigBit(wire, 0), wire->width);
 	check();
 }
 
@@ -4295,13 +4882,10 @@ RTLIL::SigSpec::SigSpec(RTLIL::Wire *wire, int offset, int width)
 {
 	cover("kernel.rtlil.sigspec.init.wire_part");
 
-	if (width != 0) {
-		chunks_.emplace_back(wire, offset, width);
-		width_ = chunks_.back().width;
-	} else {
-		width_ = 0;
-	}
+	width_ = 0;
 	hash_ = 0;
+	if (width != 0)
+		set_inline(RTLIL::SigBit(wire, offset), width);
 	check();
 }
 
@@ -4334,7 +4918,9 @@ RTLIL::SigSpec::SigSpec(RTLIL::State bit, int width)
 {
 	cover("kernel.rtlil.sigspec.init.state");
 
-	if (width != 0)
+	if (width == 1)
+		set_inline(bit, 1);
+	else if (width != 0)
 		chunks_.emplace_back(bit, width);
 	width_ = width;
 	hash_ = 0;
@@ -4345,7 +4931,9 @@ RTLIL::SigSpec::SigSpec(const RTLIL::SigBit &bit, int width)
 {
 	cover("kernel.rtlil.sigspec.init.bit");
 
-	if (width != 0) {
+	if (width == 1) {
+		set_inline(bit, 1);
+	} else if (width != 0) {
 		if (bit.wire == NULL)
 			chunks_.emplace_back(bit.data, width);
 		else
@@ -4411,10 +4999,27 @@ RTLIL::SigSpec::SigSpec(bool bit)
 	check();
 }
 
+RTLIL::SigChunk RTLIL::SigSpec::inline_chunk() const
+{
+	log_assert(inline_);
+	if (inline_bit_.wire == NULL)
+		return RTLIL::SigChunk(inline_bit_.data);
+	return RTLIL::SigChunk(inline_bit_.wire, inline_bit_.offset, width_);
+}
+
 void RTLIL::SigSpec::pack() const
 {
 	RTLIL::SigSpec *that = (RTLIL::SigSpec*)this;
 
+	KernelStats::inc(KernelStats::SIGSPEC_PACK);
+
+	if (that->inline_) {
+		cover("kernel.rtlil.sigspec.convert.pack_inline");
+		that->chunks_.push_back(inline_chunk());
+		that->inline_ = false;
+		return;
+	}
+
 	if (that->bits_.empty())
 		return;
 
@@ -4451,6 +5056,21 @@ void RTLIL::SigSpec::unpack() const
 {
 	RTLIL::SigSpec *that = (RTLIL::SigSpec*)this;
 
+	KernelStats::inc(KernelStats::SIGSPEC_UNPACK);
+
+	if (that->inline_) {
+		cover("kernel.rtlil.sigspec.convert.unpack_inline");
+		that->bits_.reserve(that->width_);
+		if (inline_bit_.wire == NULL)
+			that->bits_.push_back(inline_bit_);
+		else
+			for (int i = 0; i < that->width_; i++)
+				that->bits_.emplace_back(inline_bit_.wire, inline_bit_.offset + i);
+		that->inline_ = false;
+		that->hash_ = 0;
+		return;
+	}
+
 	if (that->chunks_.empty())
 		return;
 
@@ -4474,18 +5094,29 @@ void RTLIL::SigSpec::updhash() const
 		return;
 
 	cover("kernel.rtlil.sigspec.hash");
-	that->pack();
 
 	Hasher h;
-	for (auto &c : that->chunks_)
-		if (c.wire == NULL) {
-			for (auto &v : c.data)
-				h.eat(v);
+	if (that->inline_) {
+		// must match the hash of the equivalent packed signal
+		if (inline_bit_.wire == NULL) {
+			h.eat(inline_bit_.data);
 		} else {
-			h.eat(c.wire->name.index_);
-			h.eat(c.offset);
-			h.eat(c.width);
+			h.eat(inline_bit_.wire->name.index_);
+			h.eat(inline_bit_.offset);
+			h.eat(width_);
 		}
+	} else {
+		that->pack();
+		for (auto &c : that->chunks_)
+			if (c.wire == NULL) {
+				for (auto &v : c.data)
+					h.eat(v);
+			} else {
+				h.eat(c.wire->name.index_);
+				h.eat(c.offset);
+				h.eat(c.width);
+			}
+	}
 	that->hash_ = h.yield();
 	if (that->hash_ == 0)
 		that->hash_ = 1;
@@ -4503,15 +5134,12 @@ void RTLIL::SigSpec::sort_and_unify()
 	unpack();
 	cover("kernel.rtlil.sigspec.sort_and_unify");
 
-	// A copy of the bits vector is used to prevent duplicating the logic from
-	// SigSpec::SigSpec(std::vector<SigBit>).  This incurrs an extra copy but
-	// that isn't showing up as significant in profiles.
-	std::vector<SigBit> unique_bits = bits_;
-	std::sort(unique_bits.begin(), unique_bits.end());
-	auto last = std::unique(unique_bits.begin(), unique_bits.end());
-	unique_bits.erase(last, unique_bits.end());
+	std::sort(bits_.begin(), bits_.end());
+	bits_.erase(std::unique(bits_.begin(), bits_.end()), bits_.end());
+	width_ = GetSize(bits_);
+	hash_ = 0;
 
-	*this = unique_bits;
+	check();
 }
 
 void RTLIL::SigSpec::replace(const RTLIL::SigSpec &pattern, const RTLIL::SigSpec &with)
@@ -4597,6 +5225,28 @@ void RTLIL::SigSpec::replace(const std::map<RTLIL::SigBit, RTLIL::SigBit> &rules
 	other->check();
 }
 
+// Removes the bits matching `pred` from `bits` and the bits at the same
+// positions from `other_bits`, keeping the order, in a single pass.
+template<typename Pred>
+static int sigspec_remove_bits(std::vector<RTLIL::SigBit> &bits, std::vector<RTLIL::SigBit> *other_bits, Pred pred)
+{
+	int kept = 0;
+	for (int i = 0; i < GetSize(bits); i++) {
+		if (pred(bits[i]))
+			continue;
+		if (kept != i) {
+			bits[kept] = bits[i];
+			if (other_bits != nullptr)
+				(*other_bits)[kept] = (*other_bits)[i];
+		}
+		kept++;
+	}
+	bits.resize(kept);
+	if (other_bits != nullptr)
+		other_bits->resize(kept);
+	return kept;
+}
+
 void RTLIL::SigSpec::remove(const RTLIL::SigSpec &pattern)
 {
 	remove2(pattern, NULL);
@@ -4615,28 +5265,48 @@ void RTLIL::SigSpec::remove2(const RTLIL::SigSpec &pattern, RTLIL::SigSpec *othe
 	else
 		cover("kernel.rtlil.sigspec.remove");
 
+	// Patterns of a few chunks are scanned for each bit, longer ones are
+	// indexed by wire. Either is copied out of the pattern first, as it may
+	// be this SigSpec or `other`.
+	std::vector<RTLIL::SigChunk> few_chunks;
+	dict<RTLIL::Wire*, std::vector<std::pair<int, int>>> wire_ranges;
+	bool indexed = GetSize(pattern.chunks()) > 8;
+	for (auto &chunk : pattern.chunks()) {
+		if (chunk.wire == NULL)
+			continue;
+		if (indexed)
+			wire_ranges[chunk.wire].push_back({chunk.offset, chunk.offset + chunk.width});
+		else
+			few_chunks.push_back(chunk);
+	}
+
 	unpack();
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
 		other->unpack();
 	}
 
-	for (int i = GetSize(bits_) - 1; i >= 0; i--)
-	{
-		if (bits_[i].wire == NULL) continue;
-
-		for (auto &pattern_chunk : pattern.chunks())
-			if (bits_[i].wire == pattern_chunk.wire &&
-				bits_[i].offset >= pattern_chunk.offset &&
-				bits_[i].offset < pattern_chunk.offset + pattern_chunk.width) {
-				bits_.erase(bits_.begin() + i);
-				width_--;
-				if (other != NULL) {
-					other->bits_.erase(other->bits_.begin() + i);
-					other->width_--;
-				}
-				break;
-			}
+	width_ = sigspec_remove_bits(bits_, other ? &other->bits_ : nullptr, [&](const RTLIL::SigBit &bit) {
+		if (bit.wire == NULL)
+			return false;
+		if (indexed) {
+			auto it = wire_ranges.find(bit.wire);
+			if (it == wire_ranges.end())
+				return false;
+			for (auto &range : it->second)
+				if (bit.offset >= range.first && bit.offset < range.second)
+					return true;
+			return false;
+		}
+		for (auto &chunk : few_chunks)
+			if (bit.wire == chunk.wire && bit.offset >= chunk.offset && bit.offset < chunk.offset + chunk.width)
+				return true;
+		return false;
+	});
+	hash_ = 0;
+	if (other != NULL) {
+		other->width_ = width_;
+		other->hash_ = 0;
 	}
 
 	check();
@@ -4667,15 +5337,13 @@ void RTLIL::SigSpec::remove2(const pool<RTLIL::SigBit> &pattern, RTLIL::SigSpec
 		other->unpack();
 	}
 
-	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
-		if (bits_[i].wire != NULL && pattern.count(bits_[i])) {
-			bits_.erase(bits_.begin() + i);
-			width_--;
-			if (other != NULL) {
-				other->bits_.erase(other->bits_.begin() + i);
-				other->width_--;
-			}
-		}
+	width_ = sigspec_remove_bits(bits_, other ? &other->bits_ : nullptr, [&](const RTLIL::SigBit &bit) {
+		return bit.wire != NULL && pattern.count(bit);
+	});
+	hash_ = 0;
+	if (other != NULL) {
+		other->width_ = width_;
+		other->hash_ = 0;
 	}
 
 	check();
@@ -4695,15 +5363,13 @@ void RTLIL::SigSpec::remove2(const std::set<RTLIL::SigBit> &pattern, RTLIL::SigS
 		other->unpack();
 	}
 
-	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
-		if (bits_[i].wire != NULL && pattern.count(bits_[i])) {
-			bits_.erase(bits_.begin() + i);
-			width_--;
-			if (other != NULL) {
-				other->bits_.erase(other->bits_.begin() + i);
-				other->width_--;
-			}
-		}
+	width_ = sigspec_remove_bits(bits_, other ? &other->bits_ : nullptr, [&](const RTLIL::SigBit &bit) {
+		return bit.wire != NULL && pattern.count(bit);
+	});
+	hash_ = 0;
+	if (other != NULL) {
+		other->width_ = width_;
+		other->hash_ = 0;
 	}
 
 	check();
@@ -4723,15 +5389,13 @@ void RTLIL::SigSpec::remove2(const pool<RTLIL::Wire*> &pattern, RTLIL::SigSpec *
 		other->unpack();
 	}
 
-	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
-		if (bits_[i].wire != NULL && pattern.count(bits_[i].wire)) {
-			bits_.erase(bits_.begin() + i);
-			width_--;
-			if (other != NULL) {
-				other->bits_.erase(other->bits_.begin() + i);
-				other->width_--;
-			}
-		}
+	width_ = sigspec_remove_bits(bits_, other ? &other->bits_ : nullptr, [&](const RTLIL::SigBit &bit) {
+		return bit.wire != NULL && pattern.count(bit.wire);
+	});
+	hash_ = 0;
+	if (other != NULL) {
+		other->width_ = width_;
+		other->hash_ = 0;
 	}
 
 	check();
@@ -4818,7 +5482,17 @@ void RTLIL::SigSpec::replace(int offset, const RTLIL::SigSpec &with)
 
 void RTLIL::SigSpec::remove_const()
 {
-	if (packed())
+	if (inline_)
+	{
+		cover("kernel.rtlil.sigspec.remove_const.inline");
+
+		if (inline_bit_.wire == NULL) {
+			inline_ = false;
+			width_ = 0;
+			hash_ = 0;
+		}
+	}
+	else if (packed())
 	{
 		cover("kernel.rtlil.sigspec.remove_const.packed");
 
@@ -4882,7 +5556,13 @@ RTLIL::SigSpec RTLIL::SigSpec::extract(int offset, int length) const
 
 	cover("kernel.rtlil.sigspec.extract_pos");
 
-	if (packed()) {
+	if (inline_) {
+		if (length == 0)
+			return RTLIL::SigSpec();
+		if (inline_bit_.wire == NULL)
+			return *this;
+		return RTLIL::SigSpec(inline_bit_.wire, inline_bit_.offset + offset, length);
+	} else if (packed()) {
 		SigSpec extracted;
 		extracted.width_ = length;
 
@@ -4923,6 +5603,38 @@ void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 
 	cover("kernel.rtlil.sigspec.append");
 
+	if (signal.inline_) {
+		if (signal.inline_bit_.wire == NULL) {
+			append(signal.inline_bit_);
+			return;
+		}
+		if (inline_ && inline_bit_.wire == signal.inline_bit_.wire &&
+				inline_bit_.offset + width_ == signal.inline_bit_.offset) {
+			width_ += signal.width_;
+			hash_ = 0;
+			check();
+			return;
+		}
+		if (inline_)
+			pack();
+		if (packed()) {
+			auto &my_last_c = chunks_.back();
+			if (my_last_c.wire == signal.inline_bit_.wire && my_last_c.offset + my_last_c.width == signal.inline_bit_.offset)
+				my_last_c.width += signal.width_;
+			else
+				chunks_.emplace_back(signal.inline_bit_.wire, signal.inline_bit_.offset, signal.width_);
+		} else {
+			for (int i = 0; i < signal.width_; i++)
+				bits_.emplace_back(signal.inline_bit_.wire, signal.inline_bit_.offset + i);
+		}
+		width_ += signal.width_;
+		check();
+		return;
+	}
+
+	if (inline_)
+		pack();
+
 	if (packed() != signal.packed()) {
 		pack();
 		signal.pack();
@@ -4952,6 +5664,26 @@ void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 
 void RTLIL::SigSpec::append(const RTLIL::SigBit &bit)
 {
+	if (width_ == 0)
+	{
+		cover("kernel.rtlil.sigspec.append_bit.inline");
+		set_inline(bit, 1);
+		check();
+		return;
+	}
+
+	if (inline_)
+	{
+		if (bit.wire != NULL && bit.wire == inline_bit_.wire && inline_bit_.offset + width_ == bit.offset) {
+			cover("kernel.rtlil.sigspec.append_bit.inline");
+			width_++;
+			hash_ = 0;
+			check();
+			return;
+		}
+		pack();
+	}
+
 	if (packed())
 	{
 		cover("kernel.rtlil.sigspec.append_bit.packed");
@@ -4985,7 +5717,8 @@ void RTLIL::SigSpec::extend_u0(int width, bool is_signed)
 {
 	cover("kernel.rtlil.sigspec.extend_u0");
 
-	pack();
+	if (!inline_)
+		pack();
 
 	if (width_ > width)
 		remove(width, width_ - width);
@@ -5017,6 +5750,22 @@ void RTLIL::SigSpec::check(Module *mod) const
 	{
 		cover("kernel.rtlil.sigspec.check.skip");
 	}
+	else if (inline_)
+	{
+		cover("kernel.rtlil.sigspec.check.inline");
+
+		if (inline_bit_.wire == NULL) {
+			log_assert(width_ == 1);
+		} else {
+			log_assert(width_ > 0);
+			log_assert(inline_bit_.offset >= 0);
+			log_assert(inline_bit_.offset + width_ <= inline_bit_.wire->width);
+			if (mod != nullptr)
+				log_assert(inline_bit_.wire->module == mod);
+		}
+		log_assert(chunks_.empty());
+		log_assert(bits_.empty());
+	}
 	else if (packed())
 	{
 		cover("kernel.rtlil.sigspec.check.packed");
@@ -5071,11 +5820,15 @@ bool RTLIL::SigSpec::operator <(const RTLIL::SigSpec &other) const
 	if (width_ != other.width_)
 		return width_ < other.width_;
 
-	pack();
-	other.pack();
+	if (!inline_)
+		pack();
+	if (!other.inline_)
+		other.pack();
 
-	if (chunks_.size() != other.chunks_.size())
-		return chunks_.size() < other.chunks_.size();
+	size_t num_chunks = inline_ ? 1 : chunks_.size();
+	size_t other_num_chunks = other.inline_ ? 1 : other.chunks_.size();
+	if (num_chunks != other_num_chunks)
+		return num_chunks < other_num_chunks;
 
 	updhash();
 	other.updhash();
@@ -5083,6 +5836,17 @@ bool RTLIL::SigSpec::operator <(const RTLIL::SigSpec &other) const
 	if (hash_ != other.hash_)
 		return hash_ < other.hash_;
 
+	if (inline_ || other.inline_) {
+		RTLIL::SigChunk chunk = inline_ ? inline_chunk() : chunks_[0];
+		RTLIL::SigChunk other_chunk = other.inline_ ? other.inline_chunk() : other.chunks_[0];
+		if (chunk != other_chunk) {
+			cover("kernel.rtlil.sigspec.comp_lt.hash_collision");
+			return chunk < other_chunk;
+		}
+		cover("kernel.rtlil.sigspec.comp_lt.equal");
+		return false;
+	}
+
 	for (size_t i = 0; i < chunks_.size(); i++)
 		if (chunks_[i] != other.chunks_[i]) {
 			cover("kernel.rtlil.sigspec.comp_lt.hash_collision");
@@ -5109,6 +5873,16 @@ bool RTLIL::SigSpec::operator ==(const RTLIL::SigSpec &other) const
 	if (width_ == 0)
 		return true;
 
+	if (inline_ || other.inline_) {
+		cover("kernel.rtlil.sigspec.comp_eq.inline");
+		const RTLIL::SigSpec &a = inline_ ? *this : other;
+		const RTLIL::SigSpec &b = inline_ ? other : *this;
+		if (b.inline_)
+			return a.inline_bit_ == b.inline_bit_;
+		b.pack();
+		return GetSize(b.chunks_) == 1 && RTLIL::SigBit(b.chunks_[0], 0) == a.inline_bit_;
+	}
+
 	pack();
 	other.pack();
 
@@ -5135,6 +5909,8 @@ bool RTLIL::SigSpec::is_wire() const
 {
 	cover("kernel.rtlil.sigspec.is_wire");
 
+	if (inline_)
+		return inline_bit_.wire && inline_bit_.wire->width == width_;
 	pack();
 	return GetSize(chunks_) == 1 && chunks_[0].wire && chunks_[0].wire->width == width_;
 }
@@ -5143,6 +5919,8 @@ bool RTLIL::SigSpec::is_chunk() const
 {
 	cover("kernel.rtlil.sigspec.is_chunk");
 
+	if (inline_)
+		return true;
 	pack();
 	return GetSize(chunks_) == 1;
 }
@@ -5151,6 +5929,8 @@ bool RTLIL::SigSpec::is_fully_const() const
 {
 	cover("kernel.rtlil.sigspec.is_fully_const");
 
+	if (inline_)
+		return inline_bit_.wire == NULL;
 	pack();
 	for (auto it = chunks_.begin(); it != chunks_.end(); it++)
 		if (it->width > 0 && it->wire != NULL)
@@ -5222,6 +6002,8 @@ bool RTLIL::SigSpec::has_const() const
 {
 	cover("kernel.rtlil.sigspec.has_const");
 
+	if (inline_)
+		return inline_bit_.wire == NULL;
 	pack();
 	for (auto it = chunks_.begin(); it != chunks_.end(); it++)
 		if (it->width > 0 && it->wire == NULL)
@@ -5310,6 +6092,10 @@ RTLIL::Wire *RTLIL::SigSpec::as_wire() const
 {
 	cover("kernel.rtlil.sigspec.as_wire");
 
+	if (inline_) {
+		log_assert(is_wire());
+		return inline_bit_.wire;
+	}
 	pack();
 	log_assert(is_wire());
 	return chunks_[0].wire;
@@ -5319,6 +6105,8 @@ RTLIL::SigChunk RTLIL::SigSpec::as_chunk() const
 {
 	cover("kernel.rtlil.sigspec.as_chunk");
 
+	if (inline_)
+		return inline_chunk();
 	pack();
 	log_assert(is_chunk());
 	return chunks_[0];
@@ -5329,6 +6117,8 @@ RTLIL::SigBit RTLIL::SigSpec::as_bit() const
 	cover("kernel.rtlil.sigspec.as_bit");
 
 	log_assert(width_ == 1);
+	if (inline_)
+		return inline_bit_;
 	if (packed())
 		return RTLIL::SigBit(*chunks_.begin());
 	else
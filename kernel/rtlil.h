@@ -22,6 +22,7 @@
 
 #include "kernel/yosys_common.h"
 #include "kernel/yosys.h"
+#include "kernel/slab.h"
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -96,10 +97,69 @@ struct RTLIL::IdString
 		~destruct_guard_t() { destruct_guard_ok = false; }
 	} destruct_guard;
 
-	static std::vector<char*> global_id_storage_;
-	static dict<char*, int> global_id_index_;
+	// Storage for the id strings and their refcounts. Entries are kept in
+	// fixed size chunks that are never moved once allocated, so a reference
+	// handed out by c_str() stays valid while other threads intern new
+	// strings (see concurrent mode below). This is POD and zero-initialized.
+	template<typename T>
+	struct chunked_storage
+	{
+		static constexpr int chunk_bits = 16;
+		static constexpr int chunk_size = 1 << chunk_bits;
+		static constexpr int max_chunks = 0x40000000 >> chunk_bits;
+
+		T *chunks_[max_chunks];
+		std::atomic<int> size_;
+
+		inline T &operator[](int idx) const { return chunks_[idx >> chunk_bits][idx & (chunk_size - 1)]; }
+		inline T &at(int idx) const {
+			log_assert(idx >= 0 && idx < size_.load(std::memory_order_relaxed));
+			return (*this)[idx];
+		}
+		inline int size() const { return size_.load(std::memory_order_relaxed); }
+		inline bool empty() const { return size() == 0; }
+
+		// not thread-safe, concurrent callers must serialize growth
+		int grow() {
+			int idx = size();
+			log_assert(idx < 0x40000000);
+			if ((idx & (chunk_size - 1)) == 0)
+				chunks_[idx >> chunk_bits] = new T[chunk_size]();
+			size_.store(idx + 1, std::memory_order_release);
+			return idx;
+		}
+	};
+
+	// The string to index map is split into shards, each guarded by its own
+	// lock in concurrent mode. The shard is selected by a cheap hash over the
+	// tail of the string, which is where autogenerated names differ.
+	static constexpr int index_shards = 64;
+	static inline int index_shard(const char *p) {
+		size_t len = strlen(p);
+		unsigned int h = len;
+		for (size_t i = len > 4 ? len - 4 : 0; i < len; i++)
+			h = h * 33 + (unsigned char)p[i];
+		return h % index_shards;
+	}
+
+	static chunked_storage<char*> global_id_storage_;
+	static dict<char*, int> global_id_index_[index_shards];
+
+	// Names created by NEW_ID are only formatted and entered into the index
+	// when their text is first needed. Until then the entry in
+	// global_id_storage_ is null and the call site prefix and counter are
+	// kept here, at the same index. Looking up any "$auto$" name by text
+	// materializes all pending names first, so a name and its text always
+	// resolve to the same index.
+	struct auto_id_t {
+		const char *prefix;
+		int counter;
+	};
+	static chunked_storage<auto_id_t> global_auto_id_storage_;
+	static std::vector<int> global_auto_id_pending_;
+	static int global_auto_id_live_;
 #ifndef YOSYS_NO_IDS_REFCNT
-	static std::vector<int> global_refcount_storage_;
+	static chunked_storage<std::atomic<int>> global_refcount_storage_;
 	static std::vector<int> global_free_idx_list_;
 #endif
 
@@ -108,15 +168,43 @@ struct RTLIL::IdString
 	static int last_created_idx_[8];
 #endif
 
+	// Concurrent mode: while at least one ConcurrentScope is alive, IdStrings
+	// may be created, copied and destroyed from multiple threads. Index lookups
+	// take the lock of the respective shard, refcounts are updated atomically
+	// and freeing unreferenced strings is deferred until the last scope is left
+	// (so an index can never be recycled while another thread resolves it).
+	// Scopes must only be opened and closed while no worker threads are running.
+	// Today's single-threaded paths are unchanged when no scope is active.
+	static int concurrent_mode_;
+
+	static void enter_concurrent_mode();
+	static void leave_concurrent_mode();
+	static int get_reference_concurrent(const char *p);
+	static void put_reference_concurrent(int idx);
+
+	struct ConcurrentScope {
+		ConcurrentScope() { enter_concurrent_mode(); }
+		~ConcurrentScope() { leave_concurrent_mode(); }
+		ConcurrentScope(const ConcurrentScope &) = delete;
+		ConcurrentScope &operator=(const ConcurrentScope &) = delete;
+	};
+
+	static inline bool concurrent_mode() { return concurrent_mode_ != 0; }
+
+	// Makes room in the string index for n more strings, for passes that are
+	// about to create a large number of names. Not allowed in concurrent mode.
+	static void reserve(int n);
+
 	static inline void xtrace_db_dump()
 	{
 	#ifdef YOSYS_XTRACE_GET_PUT
+		materialize_auto_ids();
 		for (int idx = 0; idx < GetSize(global_id_storage_); idx++)
 		{
 			if (global_id_storage_.at(idx) == nullptr)
 				log("#X# DB-DUMP index %d: FREE\n", idx);
 			else
-				log("#X# DB-DUMP index %d: '%s' (ref %d)\n", idx, global_id_storage_.at(idx), global_refcount_storage_.at(idx));
+				log("#X# DB-DUMP index %d: '%s' (ref %d)\n", idx, global_id_storage_.at(idx), global_refcount_storage_.at(idx).load());
 		}
 	#endif
 	}
@@ -140,67 +228,84 @@ struct RTLIL::IdString
 	{
 		if (idx) {
 	#ifndef YOSYS_NO_IDS_REFCNT
-			global_refcount_storage_[idx]++;
+			std::atomic<int> &refcount = global_refcount_storage_[idx];
+			if (concurrent_mode())
+				refcount.fetch_add(1, std::memory_order_relaxed);
+			else
+				refcount.store(refcount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 	#endif
 	#ifdef YOSYS_XTRACE_GET_PUT
 			if (yosys_xtrace)
-				log("#X# GET-BY-INDEX '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+				log("#X# GET-BY-INDEX '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx).load());
 	#endif
 		}
 		return idx;
 	}
 
-	static int get_reference(const char *p)
+	static inline void check_new_id(const char *p)
 	{
-		log_assert(destruct_guard_ok);
-
-		if (!p[0])
-			return 0;
-
-		auto it = global_id_index_.find((char*)p);
-		if (it != global_id_index_.end()) {
-	#ifndef YOSYS_NO_IDS_REFCNT
-			global_refcount_storage_.at(it->second)++;
-	#endif
-	#ifdef YOSYS_XTRACE_GET_PUT
-			if (yosys_xtrace)
-				log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage_.at(it->second), it->second, global_refcount_storage_.at(it->second));
-	#endif
-			return it->second;
-		}
-
 		log_assert(p[0] == '$' || p[0] == '\\');
 		log_assert(p[1] != 0);
 		for (const char *c = p; *c; c++)
 			if ((unsigned)*c <= (unsigned)' ')
 				log_error("Found control character or space (0x%02x) in string '%s' which is not allowed in RTLIL identifiers\n", *c, p);
+	}
 
+	static inline int alloc_index()
+	{
+		if (global_id_storage_.empty()) {
+			global_id_storage_.grow();
+			global_id_storage_[0] = (char*)"";
+			global_auto_id_storage_.grow();
+	#ifndef YOSYS_NO_IDS_REFCNT
+			global_refcount_storage_.grow();
+	#endif
+			global_id_index_[index_shard("")][global_id_storage_[0]] = 0;
+		}
 	#ifndef YOSYS_NO_IDS_REFCNT
 		if (global_free_idx_list_.empty()) {
-			if (global_id_storage_.empty()) {
-				global_refcount_storage_.push_back(0);
-				global_id_storage_.push_back((char*)"");
-				global_id_index_[global_id_storage_.back()] = 0;
-			}
-			log_assert(global_id_storage_.size() < 0x40000000);
-			global_free_idx_list_.push_back(global_id_storage_.size());
-			global_id_storage_.push_back(nullptr);
-			global_refcount_storage_.push_back(0);
+			global_free_idx_list_.push_back(global_id_storage_.grow());
+			global_auto_id_storage_.grow();
+			global_refcount_storage_.grow();
 		}
-
 		int idx = global_free_idx_list_.back();
 		global_free_idx_list_.pop_back();
-		global_id_storage_.at(idx) = strdup(p);
-		global_id_index_[global_id_storage_.at(idx)] = idx;
-		global_refcount_storage_.at(idx)++;
+		return idx;
 	#else
-		if (global_id_storage_.empty()) {
-			global_id_storage_.push_back((char*)"");
-			global_id_index_[global_id_storage_.back()] = 0;
+		global_auto_id_storage_.grow();
+		return global_id_storage_.grow();
+	#endif
+	}
+
+	static int get_reference(const char *p)
+	{
+		log_assert(destruct_guard_ok);
+
+		if (!p[0])
+			return 0;
+
+		if (concurrent_mode())
+			return get_reference_concurrent(p);
+
+		dict<char*, int> &index = global_id_index_[index_shard(p)];
+		auto it = index.find((char*)p);
+		if (it != index.end())
+			return get_reference(it->second);
+
+		if (!global_auto_id_pending_.empty() && strncmp(p, "$auto$", 6) == 0) {
+			materialize_auto_ids();
+			it = index.find((char*)p);
+			if (it != index.end())
+				return get_reference(it->second);
 		}
-		int idx = global_id_storage_.size();
-		global_id_storage_.push_back(strdup(p));
-		global_id_index_[global_id_storage_.back()] = idx;
+
+		check_new_id(p);
+
+		int idx = alloc_index();
+		global_id_storage_[idx] = strdup(p);
+		index[global_id_storage_[idx]] = idx;
+	#ifndef YOSYS_NO_IDS_REFCNT
+		global_refcount_storage_[idx].store(1, std::memory_order_relaxed);
 	#endif
 
 		if (yosys_xtrace) {
@@ -210,7 +315,7 @@ struct RTLIL::IdString
 
 	#ifdef YOSYS_XTRACE_GET_PUT
 		if (yosys_xtrace)
-			log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+			log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx).load());
 	#endif
 
 	#ifdef YOSYS_USE_STICKY_IDS
@@ -235,28 +340,46 @@ struct RTLIL::IdString
 
 	#ifdef YOSYS_XTRACE_GET_PUT
 		if (yosys_xtrace) {
-			log("#X# PUT '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+			log("#X# PUT '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx).load());
 		}
 	#endif
 
-		int &refcount = global_refcount_storage_[idx];
+		if (concurrent_mode()) {
+			put_reference_concurrent(idx);
+			return;
+		}
+
+		std::atomic<int> &refcount = global_refcount_storage_[idx];
+		int new_refcount = refcount.load(std::memory_order_relaxed) - 1;
+		refcount.store(new_refcount, std::memory_order_relaxed);
 
-		if (--refcount > 0)
+		if (new_refcount > 0)
 			return;
 
-		log_assert(refcount == 0);
+		log_assert(new_refcount == 0);
 		free_reference(idx);
 	}
 	static inline void free_reference(int idx)
 	{
+		if (global_id_storage_[idx] == nullptr) {
+			// a NEW_ID name that was never materialized
+			global_auto_id_storage_[idx].prefix = nullptr;
+			global_auto_id_live_--;
+			global_free_idx_list_.push_back(idx);
+			return;
+		}
+
 		if (yosys_xtrace) {
 			log("#X# Removed IdString '%s' with index %d.\n", global_id_storage_.at(idx), idx);
 			log_backtrace("-X- ", yosys_xtrace-1);
 		}
 
-		global_id_index_.erase(global_id_storage_.at(idx));
-		free(global_id_storage_.at(idx));
-		global_id_storage_.at(idx) = nullptr;
+		dict<char*, int> &index = global_id_index_[index_shard(global_id_storage_[idx])];
+		auto it = index.find(global_id_storage_[idx]);
+		if (it != index.end() && it->second == idx)
+			index.erase(it);
+		free(global_id_storage_[idx]);
+		global_id_storage_[idx] = nullptr;
 		global_free_idx_list_.push_back(idx);
 	}
 #else
@@ -290,13 +413,25 @@ struct RTLIL::IdString
 	}
 
 	inline const char *c_str() const {
-		return global_id_storage_.at(index_);
+		const char *p = global_id_storage_.at(index_);
+		return p ? p : materialize_auto_id(index_);
 	}
 
 	inline std::string str() const {
-		return std::string(global_id_storage_.at(index_));
+		return std::string(c_str());
 	}
 
+	// Create the name `prefix` followed by the decimal counter without
+	// formatting it yet (see global_auto_id_storage_). The prefix must stay
+	// valid for the rest of the process. Outside of single-threaded operation
+	// the name is created right away.
+	static IdString new_auto_id(const char *prefix, int counter);
+
+	// Format and index all names created by new_auto_id() that are still
+	// pending.
+	static void materialize_auto_ids();
+	static const char *materialize_auto_id(int idx);
+
 	inline bool operator<(const IdString &rhs) const {
 		return index_ < rhs.index_;
 	}
@@ -693,12 +828,16 @@ private:
 	friend class KernelRtlilTest;
 	FRIEND_TEST(KernelRtlilTest, ConstStr);
 	using bitvectype = std::vector<RTLIL::State>;
+	// String backed constants are never modified in place, so copies share
+	// one immutable buffer (attributes like src are copied to every cell
+	// derived from an object, e.g. by techmap and flatten).
+	using strtype = std::shared_ptr<const std::string>;
 	enum class backing_tag: bool { bits, string };
 	// Do not access the union or tag even in Const methods unless necessary
 	mutable backing_tag tag;
 	union {
 		mutable bitvectype bits_;
-		mutable std::string str_;
+		mutable strtype str_;
 	};
 
 	// Use these private utilities instead
@@ -706,10 +845,10 @@ private:
 	bool is_str() const { return tag == backing_tag::string; }
 
 	bitvectype* get_if_bits() const { return is_bits() ? &bits_ : NULL; }
-	std::string* get_if_str() const { return is_str() ? &str_ : NULL; }
+	const std::string* get_if_str() const { return is_str() ? str_.get() : NULL; }
 
 	bitvectype& get_bits() const;
-	std::string& get_str() const;
+	const std::string& get_str() const;
 public:
 	Const() : flags(RTLIL::CONST_FLAG_NONE), tag(backing_tag::bits), bits_(std::vector<RTLIL::State>()) {}
 	Const(const std::string &str);
@@ -722,6 +861,12 @@ public:
 	RTLIL::Const &operator =(const RTLIL::Const &other);
 	~Const();
 
+	// A string constant that shares its buffer with every other constant
+	// interned with the same text. Used for src attributes, which many
+	// objects created independently (e.g. by a frontend) carry with the same
+	// value.
+	static Const interned(const std::string &str);
+
 	bool operator <(const RTLIL::Const &other) const;
 	bool operator ==(const RTLIL::Const &other) const;
 	bool operator !=(const RTLIL::Const &other) const;
@@ -978,6 +1123,12 @@ private:
 	std::vector<RTLIL::SigChunk> chunks_; // LSB at index 0
 	std::vector<RTLIL::SigBit> bits_; // LSB at index 0
 
+	// A signal that is a single wire chunk or a single constant bit is
+	// stored without allocating: chunks_ and bits_ are both empty and
+	// inline_bit_ holds the LSB. pack() and unpack() convert it on demand.
+	RTLIL::SigBit inline_bit_;
+	bool inline_ = false;
+
 	void pack() const;
 	void unpack() const;
 	void updhash() const;
@@ -987,10 +1138,19 @@ private:
 	}
 
 	inline void inline_unpack() const {
-		if (!chunks_.empty())
+		if (!chunks_.empty() || inline_)
 			unpack();
 	}
 
+	inline void set_inline(const RTLIL::SigBit &bit, int width) {
+		inline_bit_ = bit;
+		inline_ = true;
+		width_ = width;
+		hash_ = 0;
+	}
+
+	RTLIL::SigChunk inline_chunk() const;
+
 	// Only used by Module::remove(const pool<Wire*> &wires)
 	// but cannot be more specific as it isn't yet declared
 	friend struct RTLIL::Module;
@@ -1021,8 +1181,14 @@ public:
 	inline int size() const { return width_; }
 	inline bool empty() const { return width_ == 0; }
 
-	inline RTLIL::SigBit &operator[](int index) { inline_unpack(); return bits_.at(index); }
-	inline const RTLIL::SigBit &operator[](int index) const { inline_unpack(); return bits_.at(index); }
+	inline RTLIL::SigBit &operator[](int index) {
+		if (inline_ && width_ == 1 && index == 0) { hash_ = 0; return inline_bit_; }
+		inline_unpack(); return bits_.at(index);
+	}
+	inline const RTLIL::SigBit &operator[](int index) const {
+		if (inline_ && width_ == 1 && index == 0) return inline_bit_;
+		inline_unpack(); return bits_.at(index);
+	}
 
 	inline RTLIL::SigSpecIterator begin() { RTLIL::SigSpecIterator it; it.sig_p = this; it.index = 0; return it; }
 	inline RTLIL::SigSpecIterator end() { RTLIL::SigSpecIterator it; it.sig_p = this; it.index = width_; return it; }
@@ -1033,6 +1199,9 @@ public:
 	void sort();
 	void sort_and_unify();
 
+	// The pattern variants index the pattern on each call. To apply the same
+	// rules to many SigSpecs, build a dict (for replace) or pool (for remove)
+	// once and use the overloads taking those.
 	void replace(const RTLIL::SigSpec &pattern, const RTLIL::SigSpec &with);
 	void replace(const RTLIL::SigSpec &pattern, const RTLIL::SigSpec &with, RTLIL::SigSpec *other) const;
 
@@ -1182,6 +1351,7 @@ struct RTLIL::Monitor
 
 // Forward declaration; defined in preproc.h.
 struct define_map_t;
+struct SpillStore;
 
 struct RTLIL::Design
 {
@@ -1205,6 +1375,15 @@ struct RTLIL::Design
 	dict<RTLIL::IdString, RTLIL::Selection> selection_vars;
 	std::string selected_active_module;
 
+	// out-of-core storage of modules, see the `spill` command and
+	// kernel/spill.h; null unless enabled. Spilled modules are read back
+	// when they are looked up with module() or checked with the selected*()
+	// functions, and all of them before a pass that is not selection_safe()
+	// or a backend runs. modules() returns the stubs as they are.
+	std::unique_ptr<SpillStore> spill_store;
+	// reads a spilled module back, no-op for other modules
+	void unspill(const RTLIL::Module *module) const;
+
 	Design();
 	~Design();
 
@@ -1224,6 +1403,17 @@ struct RTLIL::Design
 	void remove(RTLIL::Module *module);
 	void rename(RTLIL::Module *module, RTLIL::IdString new_name);
 
+	// Copy-on-write sharing of modules between designs, used for the designs
+	// saved by the `design` command. A module held by several designs is
+	// owned by module->design, which is the only design allowed to modify it,
+	// and only after unsharing it. unshare() gives every other holder of the
+	// module a private copy and returns the module now held by this design.
+	// Pass::call() unshares all modules before running a pass that is not
+	// marked with Pass::keeps_shared_modules().
+	void add_shared(RTLIL::Module *module, bool take_ownership = false);
+	RTLIL::Module *unshare(RTLIL::Module *module);
+	void unshare_modules();
+
 	void scratchpad_unset(const std::string &varname);
 
 	void scratchpad_set_int(const std::string &varname, int value);
@@ -1298,10 +1488,50 @@ protected:
 	void add(RTLIL::Cell *cell);
 	void add(RTLIL::Process *process);
 
+	// storage for the wires and cells owned by this module
+	SlabPool<RTLIL::Wire> wire_pool_;
+	SlabPool<RTLIL::Cell> cell_pool_;
+	void destroy(RTLIL::Wire *wire);
+	void destroy(RTLIL::Cell *cell);
+
+	// cloneInto() for an empty module without monitors
+	void bulk_cloneInto(RTLIL::Module *new_mod) const;
+
 public:
 	RTLIL::Design *design;
 	pool<RTLIL::Monitor*> monitors;
 
+	// owned ModIndex kept alive across passes, see ModIndex::cached()
+	RTLIL::Monitor *cached_index_ = nullptr;
+
+	// owned timing graph of the `sta` pass, kept alive and dropped like
+	// cached_index_
+	RTLIL::Monitor *cached_timing_ = nullptr;
+
+	// owned init values and parsed FFs, see FfCache::cached(); kept alive
+	// and dropped like cached_index_
+	RTLIL::Monitor *cached_ffs_ = nullptr;
+
+	// designs other than `design` that hold this module as an immutable
+	// copy, see Design::add_shared()
+	pool<RTLIL::Design*> sharing_designs_;
+
+	// incremented by every change to the cells, ports, parameters and
+	// connections of the module that goes through the API (and by blackouts)
+	uint64_t generation_ = 0;
+
+	// incremented by changes of init attributes through FfInitVals, by
+	// passes that change them directly, and by removals of wires
+	uint64_t init_generation_ = 0;
+
+	// generation at which a pass (identified by a key, see converged())
+	// last found nothing to do in the module
+	dict<std::string, uint64_t> converged_;
+
+	// see BatchScope
+	int batch_depth_ = 0;
+	bool batch_blackout_ = false;
+
 	int refcount_wires_;
 	int refcount_cells_;
 
@@ -1342,6 +1572,50 @@ public:
 	std::vector<RTLIL::IdString> ports;
 	void fixup_ports();
 
+	// tell all monitors that the module was changed in a way that is not
+	// covered by the other notifications (e.g. wires removed or renamed)
+	void blackout();
+
+	// While a BatchScope is alive, changes made through the API send no
+	// monitor notifications. Instead a single blackout is sent when the
+	// outermost scope ends, if there are monitors to notify. This is for
+	// changes to a large part of a module (e.g. removing or renaming many
+	// objects), where rebuilding an index once is cheaper than updating it
+	// change by change.
+	struct BatchScope {
+		RTLIL::Module *module;
+		BatchScope(RTLIL::Module *module) : module(module) { module->batch_depth_++; }
+		BatchScope(const BatchScope &) = delete;
+		BatchScope &operator=(const BatchScope &) = delete;
+		~BatchScope() {
+			if (--module->batch_depth_ == 0 && module->batch_blackout_) {
+				module->batch_blackout_ = false;
+				module->blackout();
+			}
+		}
+	};
+
+	// returns true if notifications are currently deferred by a BatchScope
+	bool defer_notifications() {
+		if (batch_depth_ == 0)
+			return false;
+		if (!monitors.empty() || (design && !design->monitors.empty()))
+			batch_blackout_ = true;
+		return true;
+	}
+
+	// Used by the passes in the `opt` loop to skip modules that have already
+	// converged: mark_converged() is called after a run of the pass identified
+	// by key that found nothing to do, and converged() returns true as long as
+	// the module has not changed since. Both only have an effect while the
+	// "opt.skip_converged" scratchpad variable is set.
+	bool converged(const std::string &key) const;
+	void mark_converged(const std::string &key);
+	// Called by passes that report a change to the module, which may have
+	// been made by writing to the members of cells and wires directly
+	// (e.g. Cell::type) and hence not have updated generation_.
+	void mark_changed() { generation_++; }
+
 	pool<pair<RTLIL::Cell*, RTLIL::IdString>> bufNormQueue;
 	void bufNormalize();
 
@@ -1388,6 +1662,7 @@ public:
 
 	// Removing wires is expensive. If you have to remove wires, remove them all at once.
 	void remove(const pool<RTLIL::Wire*> &wires);
+	void remove(const pool<RTLIL::Cell*> &cells);
 	void remove(RTLIL::Cell *cell);
 	void remove(RTLIL::Process *process);
 
@@ -1395,6 +1670,11 @@ public:
 	void rename(RTLIL::Cell *cell, RTLIL::IdString new_name);
 	void rename(RTLIL::IdString old_name, RTLIL::IdString new_name);
 
+	// renames many objects at once, rebuilding the name indexes only once
+	// instead of updating them object by object. the order of the wires and
+	// cells is kept. new names must be unique after all renames are applied.
+	void rename(const dict<RTLIL::Wire*, RTLIL::IdString> &wire_names, const dict<RTLIL::Cell*, RTLIL::IdString> &cell_names);
+
 	void swap_names(RTLIL::Wire *w1, RTLIL::Wire *w2);
 	void swap_names(RTLIL::Cell *c1, RTLIL::Cell *c2);
 
@@ -1897,13 +2177,14 @@ inline const RTLIL::SigBit &RTLIL::SigSpecConstIterator::operator*() const {
 }
 
 inline RTLIL::SigBit::SigBit(const RTLIL::SigSpec &sig) {
-	log_assert(sig.size() == 1 && sig.chunks().size() == 1);
-	*this = SigBit(sig.chunks().front());
+	log_assert(sig.size() == 1);
+	*this = sig.as_bit();
 }
 
 template<typename T>
 void RTLIL::Module::rewrite_sigspecs(T &functor)
 {
+	blackout();
 	for (auto &it : cells_)
 		it.second->rewrite_sigspecs(functor);
 	for (auto &it : processes)
@@ -1917,6 +2198,7 @@ void RTLIL::Module::rewrite_sigspecs(T &functor)
 template<typename T>
 void RTLIL::Module::rewrite_sigspecs2(T &functor)
 {
+	blackout();
 	for (auto &it : cells_)
 		it.second->rewrite_sigspecs2(functor);
 	for (auto &it : processes)
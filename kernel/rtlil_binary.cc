@@ -0,0 +1,658 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/rtlil_binary.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// The PNG trick: a non-ASCII first byte and a trailing newline catch
+// files that went through a text-mode (7-bit or CRLF) conversion.
+const char RTLIL_BINARY::magic[8] = { '\x89', 'R', 'T', 'L', 'I', 'L', '\r', '\n' };
+
+bool RTLIL_BINARY::has_magic(const char *data, size_t size)
+{
+	return size >= sizeof(magic) && memcmp(data, magic, sizeof(magic)) == 0;
+}
+
+namespace {
+
+// Encodings of the bits of a constant. String constants use ENC_BITS,
+// which holds their characters in reverse order.
+enum : unsigned char {
+	ENC_BITS = 0,  // only 0/1 bits, 8 bits per byte, LSB first
+	ENC_STATES = 1 // any RTLIL::State, 2 bits per byte, low nibble first
+};
+
+struct BinaryWriter
+{
+	std::string body;
+	idict<RTLIL::IdString> ids;
+	dict<const RTLIL::Wire*, int> wire_index;
+
+	void uint(uint64_t value)
+	{
+		while (value >= 0x80) {
+			body += char(value | 0x80);
+			value >>= 7;
+		}
+		body += char(value);
+	}
+
+	void sint(int64_t value)
+	{
+		uint((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+	}
+
+	void id(RTLIL::IdString str)
+	{
+		uint(ids(str));
+	}
+
+	template<typename T>
+	void state_bits(const T &bits, int width)
+	{
+		bool binary = true;
+		for (int i = 0; i < width; i++)
+			if (bits[i] != RTLIL::S0 && bits[i] != RTLIL::S1) {
+				binary = false;
+				break;
+			}
+
+		uint(binary ? ENC_BITS : ENC_STATES);
+		uint(width);
+
+		if (binary) {
+			for (int i = 0; i < width; i += 8) {
+				unsigned char byte = 0;
+				for (int j = 0; j < 8 && i+j < width; j++)
+					if (bits[i+j] == RTLIL::S1)
+						byte |= 1 << j;
+				body += char(byte);
+			}
+		} else {
+			for (int i = 0; i < width; i += 2) {
+				unsigned char byte = bits[i];
+				if (i+1 < width)
+					byte |= bits[i+1] << 4;
+				body += char(byte);
+			}
+		}
+	}
+
+	void constant(const RTLIL::Const &value)
+	{
+		uint(value.flags);
+		state_bits(value, value.size());
+	}
+
+	void sigspec(const RTLIL::SigSpec &sig)
+	{
+		const std::vector<RTLIL::SigChunk> &chunks = sig.chunks();
+		uint(chunks.size());
+		for (auto &chunk : chunks) {
+			if (chunk.wire == nullptr) {
+				uint(0);
+				state_bits(chunk.data, chunk.width);
+			} else {
+				uint(wire_index.at(chunk.wire) + 1);
+				uint(chunk.offset);
+				uint(chunk.width);
+			}
+		}
+	}
+
+	void sigsig(const RTLIL::SigSig &conn)
+	{
+		sigspec(conn.first);
+		sigspec(conn.second);
+	}
+
+	void attributes(const dict<RTLIL::IdString, RTLIL::Const> &attrs)
+	{
+		uint(attrs.size());
+		for (auto &it : attrs) {
+			id(it.first);
+			constant(it.second);
+		}
+	}
+
+	void case_rule(const RTLIL::CaseRule *cs)
+	{
+		uint(cs->compare.size());
+		for (auto &sig : cs->compare)
+			sigspec(sig);
+		uint(cs->actions.size());
+		for (auto &action : cs->actions)
+			sigsig(action);
+		uint(cs->switches.size());
+		for (auto sw : cs->switches) {
+			attributes(sw->attributes);
+			sigspec(sw->signal);
+			uint(sw->cases.size());
+			for (auto sw_case : sw->cases) {
+				attributes(sw_case->attributes);
+				case_rule(sw_case);
+			}
+		}
+	}
+
+	void process(const RTLIL::Process *proc)
+	{
+		id(proc->name);
+		attributes(proc->attributes);
+		case_rule(&proc->root_case);
+		uint(proc->syncs.size());
+		for (auto sync : proc->syncs) {
+			uint(sync->type);
+			sigspec(sync->signal);
+			uint(sync->actions.size());
+			for (auto &action : sync->actions)
+				sigsig(action);
+			uint(sync->mem_write_actions.size());
+			for (auto &memwr : sync->mem_write_actions) {
+				id(memwr.memid);
+				attributes(memwr.attributes);
+				sigspec(memwr.address);
+				sigspec(memwr.data);
+				sigspec(memwr.enable);
+				constant(memwr.priority_mask);
+			}
+		}
+	}
+
+	void module(RTLIL::Module *module)
+	{
+		id(module->name);
+		attributes(module->attributes);
+
+		uint(module->avail_parameters.size());
+		for (auto &param : module->avail_parameters) {
+			id(param);
+			auto it = module->parameter_default_values.find(param);
+			if (it == module->parameter_default_values.end()) {
+				uint(0);
+			} else {
+				uint(1);
+				constant(it->second);
+			}
+		}
+
+		wire_index.clear();
+		uint(GetSize(module->wires()));
+		for (auto wire : module->wires()) {
+			wire_index[wire] = GetSize(wire_index);
+			id(wire->name);
+			attributes(wire->attributes);
+			uint(wire->width);
+			sint(wire->start_offset);
+			uint(wire->port_id);
+			uint((wire->port_input ? 1 : 0) | (wire->port_output ? 2 : 0) |
+					(wire->upto ? 4 : 0) | (wire->is_signed ? 8 : 0));
+		}
+
+		uint(module->memories.size());
+		for (auto &it : module->memories) {
+			RTLIL::Memory *memory = it.second;
+			id(memory->name);
+			attributes(memory->attributes);
+			uint(memory->width);
+			sint(memory->start_offset);
+			uint(memory->size);
+		}
+
+		uint(GetSize(module->cells()));
+		for (auto cell : module->cells()) {
+			id(cell->name);
+			id(cell->type);
+			attributes(cell->attributes);
+			uint(cell->parameters.size());
+			for (auto &it : cell->parameters) {
+				id(it.first);
+				constant(it.second);
+			}
+			uint(cell->connections().size());
+			for (auto &it : cell->connections()) {
+				id(it.first);
+				sigspec(it.second);
+			}
+		}
+
+		uint(module->processes.size());
+		for (auto &it : module->processes)
+			process(it.second);
+
+		uint(module->connections().size());
+		for (auto &conn : module->connections())
+			sigsig(conn);
+	}
+};
+
+struct BinaryParser
+{
+	const unsigned char *ptr, *end;
+	const RTLIL_BINARY::ReadOptions &options;
+	std::vector<RTLIL::IdString> ids;
+	std::vector<RTLIL::Wire*> wires;
+	RTLIL::Module *current_module = nullptr;
+
+	BinaryParser(const char *data, size_t size, const RTLIL_BINARY::ReadOptions &options) :
+			ptr((const unsigned char *)data), end((const unsigned char *)data + size), options(options) { }
+
+	[[noreturn]] void error(const char *what)
+	{
+		log_error("Binary RTLIL error: %s.\n", what);
+	}
+
+	uint64_t uint()
+	{
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (ptr == end)
+				error("unexpected end of file");
+			unsigned char byte = *ptr++;
+			value |= uint64_t(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+		error("invalid varint");
+	}
+
+	int64_t sint()
+	{
+		uint64_t value = uint();
+		return int64_t(value >> 1) ^ -int64_t(value & 1);
+	}
+
+	int integer()
+	{
+		uint64_t value = uint();
+		if (value > uint64_t(INT_MAX))
+			error("integer out of range");
+		return value;
+	}
+
+	int sinteger()
+	{
+		int64_t value = sint();
+		if (value < INT_MIN || value > INT_MAX)
+			error("integer out of range");
+		return value;
+	}
+
+	// a count of items that each take at least one byte
+	size_t count()
+	{
+		uint64_t value = uint();
+		if (value > uint64_t(end - ptr))
+			error("unexpected end of file");
+		return value;
+	}
+
+	RTLIL::IdString id()
+	{
+		uint64_t index = uint();
+		if (index >= ids.size())
+			error("invalid string table index");
+		return ids[index];
+	}
+
+	const char *bytes(size_t size)
+	{
+		if (size > size_t(end - ptr))
+			error("unexpected end of file");
+		const char *data = (const char *)ptr;
+		ptr += size;
+		return data;
+	}
+
+	std::vector<RTLIL::State> state_bits()
+	{
+		uint64_t encoding = uint();
+		int width = integer();
+		if (uint64_t(width) > uint64_t(end - ptr) * 8)
+			error("unexpected end of file");
+		std::vector<RTLIL::State> bits(width);
+
+		if (encoding == ENC_BITS) {
+			const unsigned char *data = (const unsigned char *)bytes((uint64_t(width) + 7) / 8);
+			for (int i = 0; i < width; i++)
+				bits[i] = (data[i / 8] >> (i % 8)) & 1 ? RTLIL::S1 : RTLIL::S0;
+		} else if (encoding == ENC_STATES) {
+			const unsigned char *data = (const unsigned char *)bytes((uint64_t(width) + 1) / 2);
+			for (int i = 0; i < width; i++) {
+				int state = (data[i / 2] >> (4 * (i % 2))) & 15;
+				if (state > RTLIL::Sm)
+					error("invalid constant bit");
+				bits[i] = RTLIL::State(state);
+			}
+		} else
+			error("invalid constant encoding");
+
+		return bits;
+	}
+
+	RTLIL::Const constant()
+	{
+		int flags = integer();
+
+		// keep strings string backed, like the text parser does
+		const unsigned char *start = ptr;
+		if ((flags & RTLIL::CONST_FLAG_STRING) && uint() == ENC_BITS) {
+			int width = integer();
+			if (width % 8 == 0) {
+				const char *data = bytes(width / 8);
+				RTLIL::Const value(std::string(std::reverse_iterator<const char *>(data + width / 8),
+						std::reverse_iterator<const char *>(data)));
+				value.flags = flags;
+				return value;
+			}
+		}
+		ptr = start;
+
+		RTLIL::Const value(state_bits());
+		value.flags = flags;
+		return value;
+	}
+
+	RTLIL::SigSpec sigspec()
+	{
+		RTLIL::SigSpec sig;
+		size_t num_chunks = count();
+		for (size_t i = 0; i < num_chunks; i++) {
+			uint64_t wire_ref = uint();
+			if (wire_ref == 0) {
+				sig.append(RTLIL::Const(state_bits()));
+				continue;
+			}
+			if (wire_ref > wires.size())
+				error("invalid wire index");
+			RTLIL::Wire *wire = wires[wire_ref - 1];
+			int offset = integer();
+			int width = integer();
+			if (uint64_t(offset) + width > uint64_t(wire->width))
+				error("invalid slice");
+			sig.append(RTLIL::SigChunk(wire, offset, width));
+		}
+		return sig;
+	}
+
+	RTLIL::SigSig sigsig()
+	{
+		RTLIL::SigSpec first = sigspec();
+		RTLIL::SigSpec second = sigspec();
+		return RTLIL::SigSig(first, second);
+	}
+
+	void attributes(dict<RTLIL::IdString, RTLIL::Const> &attrs)
+	{
+		size_t num_attrs = count();
+		for (size_t i = 0; i < num_attrs; i++) {
+			RTLIL::IdString name = id();
+			RTLIL::Const value = constant();
+			if (name == ID::src && (value.flags & RTLIL::CONST_FLAG_STRING))
+				value = RTLIL::Const::interned(value.decode_string());
+			attrs[name] = std::move(value);
+		}
+	}
+
+	void case_rule(RTLIL::CaseRule *cs)
+	{
+		size_t num_compare = count();
+		for (size_t i = 0; i < num_compare; i++)
+			cs->compare.push_back(sigspec());
+		size_t num_actions = count();
+		for (size_t i = 0; i < num_actions; i++)
+			cs->actions.push_back(sigsig());
+		size_t num_switches = count();
+		for (size_t i = 0; i < num_switches; i++) {
+			RTLIL::SwitchRule *sw = new RTLIL::SwitchRule;
+			cs->switches.push_back(sw);
+			attributes(sw->attributes);
+			sw->signal = sigspec();
+			size_t num_cases = count();
+			for (size_t j = 0; j < num_cases; j++) {
+				RTLIL::CaseRule *sw_case = new RTLIL::CaseRule;
+				sw->cases.push_back(sw_case);
+				attributes(sw_case->attributes);
+				case_rule(sw_case);
+			}
+		}
+	}
+
+	void process()
+	{
+		RTLIL::IdString name = id();
+		if (current_module->processes.count(name) != 0)
+			log_error("Binary RTLIL error: redefinition of process %s.\n", log_id(name));
+		RTLIL::Process *proc = current_module->addProcess(name);
+		attributes(proc->attributes);
+		case_rule(&proc->root_case);
+		size_t num_syncs = count();
+		for (size_t i = 0; i < num_syncs; i++) {
+			RTLIL::SyncRule *sync = new RTLIL::SyncRule;
+			proc->syncs.push_back(sync);
+			uint64_t type = uint();
+			if (type > RTLIL::STi)
+				error("invalid sync type");
+			sync->type = RTLIL::SyncType(type);
+			sync->signal = sigspec();
+			size_t num_actions = count();
+			for (size_t j = 0; j < num_actions; j++)
+				sync->actions.push_back(sigsig());
+			size_t num_memwr = count();
+			for (size_t j = 0; j < num_memwr; j++) {
+				RTLIL::MemWriteAction act;
+				act.memid = id();
+				attributes(act.attributes);
+				act.address = sigspec();
+				act.data = sigspec();
+				act.enable = sigspec();
+				act.priority_mask = constant();
+				sync->mem_write_actions.push_back(std::move(act));
+			}
+		}
+	}
+
+	void module(RTLIL::Design *design)
+	{
+		RTLIL::IdString name = id();
+		dict<RTLIL::IdString, RTLIL::Const> attrs;
+		attributes(attrs);
+
+		// same overwrite rules as the text parser
+		bool delete_current_module = false;
+		if (design->has(name)) {
+			RTLIL::Module *existing_mod = design->module(name);
+			if (!options.overwrite && (options.lib || (attrs.count(ID::blackbox) && attrs.at(ID::blackbox).as_bool()))) {
+				log("Ignoring blackbox re-definition of module %s.\n", log_id(name));
+				delete_current_module = true;
+			} else if (!options.nooverwrite && !options.overwrite && !existing_mod->get_bool_attribute(ID::blackbox)) {
+				log_error("Binary RTLIL error: redefinition of module %s.\n", log_id(name));
+			} else if (options.nooverwrite) {
+				log("Ignoring re-definition of module %s.\n", log_id(name));
+				delete_current_module = true;
+			} else {
+				log("Replacing existing%s module %s.\n", existing_mod->get_bool_attribute(ID::blackbox) ? " blackbox" : "", log_id(name));
+				design->remove(existing_mod);
+			}
+		}
+
+		current_module = new RTLIL::Module;
+		current_module->name = name;
+		current_module->attributes = std::move(attrs);
+		if (!delete_current_module)
+			design->add(current_module);
+
+		size_t num_params = count();
+		for (size_t i = 0; i < num_params; i++) {
+			RTLIL::IdString param = id();
+			current_module->avail_parameters(param);
+			if (uint() != 0)
+				current_module->parameter_default_values[param] = constant();
+		}
+
+		wires.clear();
+		size_t num_wires = count();
+		wires.reserve(num_wires);
+		for (size_t i = 0; i < num_wires; i++) {
+			RTLIL::IdString wire_name = id();
+			if (current_module->count_id(wire_name) != 0)
+				log_error("Binary RTLIL error: redefinition of wire %s.\n", log_id(wire_name));
+			RTLIL::Wire *wire = current_module->addWire(wire_name);
+			attributes(wire->attributes);
+			wire->width = integer();
+			wire->start_offset = sinteger();
+			wire->port_id = integer();
+			uint64_t wire_flags = uint();
+			wire->port_input = (wire_flags & 1) != 0;
+			wire->port_output = (wire_flags & 2) != 0;
+			wire->upto = (wire_flags & 4) != 0;
+			wire->is_signed = (wire_flags & 8) != 0;
+			wires.push_back(wire);
+		}
+
+		size_t num_memories = count();
+		for (size_t i = 0; i < num_memories; i++) {
+			RTLIL::IdString memory_name = id();
+			if (current_module->memories.count(memory_name) != 0)
+				log_error("Binary RTLIL error: redefinition of memory %s.\n", log_id(memory_name));
+			RTLIL::Memory *memory = new RTLIL::Memory;
+			memory->name = memory_name;
+			current_module->memories[memory_name] = memory;
+			attributes(memory->attributes);
+			memory->width = integer();
+			memory->start_offset = sinteger();
+			memory->size = integer();
+		}
+
+		size_t num_cells = count();
+		for (size_t i = 0; i < num_cells; i++) {
+			RTLIL::IdString cell_name = id();
+			RTLIL::IdString cell_type = id();
+			if (current_module->count_id(cell_name) != 0)
+				log_error("Binary RTLIL error: redefinition of cell %s.\n", log_id(cell_name));
+			RTLIL::Cell *cell = current_module->addCell(cell_name, cell_type);
+			attributes(cell->attributes);
+			size_t num_cell_params = count();
+			for (size_t j = 0; j < num_cell_params; j++) {
+				RTLIL::IdString param = id();
+				cell->parameters[param] = constant();
+			}
+			size_t num_ports = count();
+			for (size_t j = 0; j < num_ports; j++) {
+				RTLIL::IdString port = id();
+				if (cell->hasPort(port))
+					log_error("Binary RTLIL error: redefinition of cell port %s.\n", log_id(port));
+				cell->setPort(port, sigspec());
+			}
+		}
+
+		size_t num_processes = count();
+		for (size_t i = 0; i < num_processes; i++)
+			process();
+
+		size_t num_conns = count();
+		for (size_t i = 0; i < num_conns; i++)
+			current_module->connect(sigsig());
+
+		current_module->fixup_ports();
+		if (delete_current_module)
+			delete current_module;
+		else if (options.lib)
+			current_module->makeblackbox();
+		current_module = nullptr;
+	}
+
+	void design(RTLIL::Design *design)
+	{
+		if (!RTLIL_BINARY::has_magic((const char *)ptr, end - ptr))
+			error("missing file magic");
+		ptr += sizeof(RTLIL_BINARY::magic);
+
+		int file_version = integer();
+		if (file_version != RTLIL_BINARY::version)
+			log_error("Binary RTLIL error: unsupported format version %d.\n", file_version);
+
+		autoidx = max(autoidx, integer());
+
+		size_t num_ids = count();
+		ids.reserve(num_ids);
+		for (size_t i = 0; i < num_ids; i++) {
+			size_t size = uint();
+			const char *str = bytes(size);
+			if (size == 0 || (str[0] != '\\' && str[0] != '$'))
+				error("invalid identifier in string table");
+			ids.push_back(RTLIL::IdString(std::string(str, size)));
+		}
+
+		size_t num_modules = count();
+		for (size_t i = 0; i < num_modules; i++)
+			module(design);
+
+		if (ptr != end)
+			error("trailing data after last module");
+	}
+};
+
+} // namespace
+
+void RTLIL_BINARY::dump_design(std::ostream &f, RTLIL::Design *design, bool only_selected)
+{
+	std::vector<RTLIL::Module*> modules;
+	for (auto module : design->modules())
+		if (!only_selected || design->selected(module))
+			modules.push_back(module);
+	dump_modules(f, modules);
+}
+
+void RTLIL_BINARY::dump_modules(std::ostream &f, const std::vector<RTLIL::Module*> &modules)
+{
+	BinaryWriter writer;
+
+	int num_modules = 0;
+	for (auto module : modules) {
+		writer.module(module);
+		num_modules++;
+	}
+
+	std::string header;
+	std::swap(header, writer.body);
+	writer.uint(version);
+	writer.uint(autoidx);
+	writer.uint(writer.ids.size());
+	for (int i = 0; i < GetSize(writer.ids); i++) {
+		const std::string &str = writer.ids[i].str();
+		writer.uint(str.size());
+		writer.body += str;
+	}
+	writer.uint(num_modules);
+	std::swap(header, writer.body);
+
+	f.write(magic, sizeof(magic));
+	f.write(header.data(), header.size());
+	f.write(writer.body.data(), writer.body.size());
+}
+
+void RTLIL_BINARY::parse_design(const char *data, size_t size, RTLIL::Design *design, const ReadOptions &options)
+{
+	BinaryParser parser(data, size, options);
+	parser.design(design);
+}
+
+YOSYS_NAMESPACE_END
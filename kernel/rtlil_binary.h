@@ -0,0 +1,62 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef RTLIL_BINARY_H
+#define RTLIL_BINARY_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// A compact binary encoding of RTLIL, used for fast design checkpoints.
+// It holds exactly what the text format holds (see backends/rtlil), but
+// all identifiers are stored once in a string table, integers and
+// SigSpec chunks are stored as LEB128 varints, wires are referenced by
+// their index in the module and constants are packed 8 (or, when they
+// contain x/z/-/m bits, 2) bits per byte.
+//
+// The file starts with an 8 byte magic which intentionally is not valid
+// text RTLIL, so read_rtlil can tell both formats apart from the first
+// bytes of its input.
+
+namespace RTLIL_BINARY
+{
+	extern const char magic[8];
+	static constexpr int version = 1;
+
+	// true if the buffer starts with the binary RTLIL magic
+	bool has_magic(const char *data, size_t size);
+
+	void dump_design(std::ostream &f, RTLIL::Design *design, bool only_selected);
+	// a design image holding only the given modules
+	void dump_modules(std::ostream &f, const std::vector<RTLIL::Module*> &modules);
+
+	struct ReadOptions {
+		bool nooverwrite = false;
+		bool overwrite = false;
+		bool lib = false;
+	};
+
+	// parse a complete binary RTLIL image, e.g. a mmap()ed file
+	void parse_design(const char *data, size_t size, RTLIL::Design *design, const ReadOptions &options);
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -20,8 +20,220 @@
 #include "kernel/satgen.h"
 #include "kernel/ff.h"
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <mutex>
+#endif
+
 USING_YOSYS_NAMESPACE
 
+namespace {
+
+// A formula recorded on a scratch ezSAT. Node arguments refer to the value
+// table of an instantiation: 0 = false, 1 = true, then the input bits, then
+// the results of the earlier nodes.
+struct SatTemplate
+{
+	std::vector<int> input_widths;
+	std::vector<ezSAT::OpId> ops;
+	std::vector<int> args_begin;
+	std::vector<int> args;
+	std::vector<int> outputs;
+};
+
+std::map<std::string, std::shared_ptr<const SatTemplate>> sat_templates;
+#ifdef YOSYS_ENABLE_THREADS
+std::mutex sat_templates_mutex;
+#endif
+
+std::shared_ptr<const SatTemplate> record_template(const std::vector<int> &input_widths, const SatGen::encoder_t &encoder)
+{
+	ezSAT scratch;
+	auto tpl = std::make_shared<SatTemplate>();
+	tpl->input_widths = input_widths;
+
+	dict<int, int> refs;
+	refs[scratch.CONST_FALSE] = 0;
+	refs[scratch.CONST_TRUE] = 1;
+
+	std::vector<std::vector<int>> inputs;
+	for (int width : input_widths) {
+		inputs.push_back(scratch.vec_var(width));
+		for (int lit : inputs.back())
+			refs[lit] = GetSize(refs);
+	}
+
+	std::vector<int> outputs = encoder(&scratch, inputs);
+
+	// add the nodes reachable from the outputs in dependency order
+	std::vector<std::pair<int, bool>> stack;
+	for (int i = GetSize(outputs)-1; i >= 0; i--)
+		stack.push_back(std::make_pair(outputs[i], false));
+	while (!stack.empty())
+	{
+		auto item = stack.back();
+		stack.pop_back();
+		if (refs.count(item.first))
+			continue;
+
+		log_assert(item.first < 0);
+		ezSAT::OpId op;
+		std::vector<int> args = scratch.lookup_expression(item.first, op);
+
+		if (!item.second) {
+			stack.push_back(std::make_pair(item.first, true));
+			for (int i = GetSize(args)-1; i >= 0; i--)
+				if (!refs.count(args[i]))
+					stack.push_back(std::make_pair(args[i], false));
+			continue;
+		}
+
+		tpl->ops.push_back(op);
+		tpl->args_begin.push_back(GetSize(tpl->args));
+		for (int arg : args)
+			tpl->args.push_back(refs.at(arg));
+		refs[item.first] = GetSize(refs);
+	}
+	tpl->args_begin.push_back(GetSize(tpl->args));
+
+	for (int lit : outputs)
+		tpl->outputs.push_back(refs.at(lit));
+	return tpl;
+}
+
+std::vector<int> encode_mul(ezSAT *ez, const std::vector<int> &a, const std::vector<int> &b, bool compact)
+{
+	std::vector<int> tmp(a.size(), ez->CONST_FALSE);
+	for (int i = 0; i < int(a.size()); i++)
+	{
+		if (compact) {
+			// only the bits from i upwards change, add the partial product a & b[i] to them
+			std::vector<int> upper_tmp(tmp.begin() + i, tmp.end());
+			std::vector<int> partial(a.begin(), a.end() - i);
+			partial = ez->vec_and(partial, std::vector<int>(partial.size(), b.at(i)));
+			upper_tmp = ez->vec_add(upper_tmp, partial);
+			std::copy(upper_tmp.begin(), upper_tmp.end(), tmp.begin() + i);
+			continue;
+		}
+		std::vector<int> shifted_a(a.size(), ez->CONST_FALSE);
+		for (int j = i; j < int(a.size()); j++)
+			shifted_a.at(j) = a.at(j-i);
+		tmp = ez->vec_ite(b.at(i), ez->vec_add(tmp, shifted_a), tmp);
+	}
+	return tmp;
+}
+
+// the result of $div, $mod, $divfloor or $modfloor for b != 0
+std::vector<int> encode_divmod(ezSAT *ez, RTLIL::IdString type, bool is_signed, const std::vector<int> &a, const std::vector<int> &b)
+{
+	std::vector<int> a_u, b_u;
+	if (is_signed) {
+		a_u = ez->vec_ite(a.back(), ez->vec_neg(a), a);
+		b_u = ez->vec_ite(b.back(), ez->vec_neg(b), b);
+	} else {
+		a_u = a;
+		b_u = b;
+	}
+
+	std::vector<int> chain_buf = a_u;
+	std::vector<int> y_u(a_u.size(), ez->CONST_FALSE);
+	for (int i = int(a.size())-1; i >= 0; i--)
+	{
+		chain_buf.insert(chain_buf.end(), chain_buf.size(), ez->CONST_FALSE);
+
+		std::vector<int> b_shl(i, ez->CONST_FALSE);
+		b_shl.insert(b_shl.end(), b_u.begin(), b_u.end());
+		b_shl.insert(b_shl.end(), chain_buf.size()-b_shl.size(), ez->CONST_FALSE);
+
+		y_u.at(i) = ez->vec_ge_unsigned(chain_buf, b_shl);
+		chain_buf = ez->vec_ite(y_u.at(i), ez->vec_sub(chain_buf, b_shl), chain_buf);
+
+		chain_buf.erase(chain_buf.begin() + a_u.size(), chain_buf.end());
+	}
+
+	// modulo calculation
+	std::vector<int> modulo_trunc;
+	int floored_eq_trunc;
+	if (is_signed) {
+		modulo_trunc = ez->vec_ite(a.back(), ez->vec_neg(chain_buf), chain_buf);
+		// floor == trunc when sgn(a) == sgn(b) or trunc == 0
+		floored_eq_trunc = ez->OR(ez->IFF(a.back(), b.back()), ez->NOT(ez->expression(ezSAT::OpOr, modulo_trunc)));
+	} else {
+		modulo_trunc = chain_buf;
+		floored_eq_trunc = ez->CONST_TRUE;
+	}
+
+	if (type == ID($div)) {
+		if (is_signed)
+			return ez->vec_ite(ez->XOR(a.back(), b.back()), ez->vec_neg(y_u), y_u);
+		return y_u;
+	}
+	if (type == ID($mod))
+		return modulo_trunc;
+	if (type == ID($divfloor)) {
+		if (is_signed)
+			return ez->vec_ite(
+				ez->XOR(a.back(), b.back()),
+				ez->vec_neg(ez->vec_ite(
+					ez->vec_reduce_or(modulo_trunc),
+					ez->vec_add(y_u, ez->vec_const_unsigned(1, y_u.size())),
+					y_u
+				)),
+				y_u
+			);
+		return y_u;
+	}
+	log_assert(type == ID($modfloor));
+	return ez->vec_ite(floored_eq_trunc, modulo_trunc, ez->vec_add(modulo_trunc, b));
+}
+
+} // namespace
+
+std::vector<int> SatGen::encodeCached(const std::string &key, const std::vector<std::vector<int>> &inputs, const encoder_t &encoder)
+{
+	std::vector<int> input_widths;
+	for (auto &input : inputs)
+		input_widths.push_back(GetSize(input));
+
+	std::string full_key = key;
+	for (int width : input_widths)
+		full_key += stringf(" %d", width);
+
+	std::shared_ptr<const SatTemplate> tpl;
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		std::lock_guard<std::mutex> lock(sat_templates_mutex);
+#endif
+		auto it = sat_templates.find(full_key);
+		if (it != sat_templates.end())
+			tpl = it->second;
+	}
+
+	if (tpl == nullptr) {
+		tpl = record_template(input_widths, encoder);
+#ifdef YOSYS_ENABLE_THREADS
+		std::lock_guard<std::mutex> lock(sat_templates_mutex);
+#endif
+		sat_templates.emplace(full_key, tpl);
+	}
+
+	std::vector<int> values = {ez->CONST_FALSE, ez->CONST_TRUE};
+	for (auto &input : inputs)
+		values.insert(values.end(), input.begin(), input.end());
+
+	std::vector<int> args;
+	for (int i = 0; i < GetSize(tpl->ops); i++) {
+		args.clear();
+		for (int j = tpl->args_begin[i]; j < tpl->args_begin[i+1]; j++)
+			args.push_back(values[tpl->args[j]]);
+		values.push_back(ez->expression(tpl->ops[i], args));
+	}
+
+	std::vector<int> outputs;
+	for (int ref : tpl->outputs)
+		outputs.push_back(values[ref]);
+	return outputs;
+}
+
 bool SatGen::importCell(RTLIL::Cell *cell, int timestep)
 {
 	bool arith_undef_handled = false;
@@ -722,14 +934,11 @@ bool SatGen::importCell(RTLIL::Cell *cell, int timestep)
 
 		std::vector<int> yy = model_undef ? ez->vec_var(y.size()) : y;
 
-		std::vector<int> tmp(a.size(), ez->CONST_FALSE);
-		for (int i = 0; i < int(a.size()); i++)
-		{
-			std::vector<int> shifted_a(a.size(), ez->CONST_FALSE);
-			for (int j = i; j < int(a.size()); j++)
-				shifted_a.at(j) = a.at(j-i);
-			tmp = ez->vec_ite(b.at(i), ez->vec_add(tmp, shifted_a), tmp);
-		}
+		bool compact = compact_mul;
+		std::vector<int> tmp = encodeCached(compact ? "$mul compact" : "$mul", {a, b},
+				[compact](ezSAT *ez, const std::vector<std::vector<int>> &inputs) {
+					return encode_mul(ez, inputs[0], inputs[1], compact);
+				});
 		ez->assume(ez->vec_eq(tmp, yy));
 
 		if (model_undef) {
@@ -812,68 +1021,14 @@ bool SatGen::importCell(RTLIL::Cell *cell, int timestep)
 
 		std::vector<int> yy = model_undef ? ez->vec_var(y.size()) : y;
 
-		std::vector<int> a_u, b_u;
-		if (cell->parameters[ID::A_SIGNED].as_bool() && cell->parameters[ID::B_SIGNED].as_bool()) {
-			a_u = ez->vec_ite(a.back(), ez->vec_neg(a), a);
-			b_u = ez->vec_ite(b.back(), ez->vec_neg(b), b);
-		} else {
-			a_u = a;
-			b_u = b;
-		}
-
-		std::vector<int> chain_buf = a_u;
-		std::vector<int> y_u(a_u.size(), ez->CONST_FALSE);
-		for (int i = int(a.size())-1; i >= 0; i--)
-		{
-			chain_buf.insert(chain_buf.end(), chain_buf.size(), ez->CONST_FALSE);
-
-			std::vector<int> b_shl(i, ez->CONST_FALSE);
-			b_shl.insert(b_shl.end(), b_u.begin(), b_u.end());
-			b_shl.insert(b_shl.end(), chain_buf.size()-b_shl.size(), ez->CONST_FALSE);
-
-			y_u.at(i) = ez->vec_ge_unsigned(chain_buf, b_shl);
-			chain_buf = ez->vec_ite(y_u.at(i), ez->vec_sub(chain_buf, b_shl), chain_buf);
-
-			chain_buf.erase(chain_buf.begin() + a_u.size(), chain_buf.end());
-		}
-
 		std::vector<int> y_tmp = ignore_div_by_zero ? yy : ez->vec_var(y.size());
 
-		// modulo calculation
-		std::vector<int> modulo_trunc;
-		int floored_eq_trunc;
-		if (cell->parameters[ID::A_SIGNED].as_bool() && cell->parameters[ID::B_SIGNED].as_bool()) {
-			modulo_trunc = ez->vec_ite(a.back(), ez->vec_neg(chain_buf), chain_buf);
-			// floor == trunc when sgn(a) == sgn(b) or trunc == 0
-			floored_eq_trunc = ez->OR(ez->IFF(a.back(), b.back()), ez->NOT(ez->expression(ezSAT::OpOr, modulo_trunc)));
-		} else {
-			modulo_trunc = chain_buf;
-			floored_eq_trunc = ez->CONST_TRUE;
-		}
-
-		if (cell->type == ID($div)) {
-			if (cell->parameters[ID::A_SIGNED].as_bool() && cell->parameters[ID::B_SIGNED].as_bool())
-				ez->assume(ez->vec_eq(y_tmp, ez->vec_ite(ez->XOR(a.back(), b.back()), ez->vec_neg(y_u), y_u)));
-			else
-				ez->assume(ez->vec_eq(y_tmp, y_u));
-		} else if (cell->type == ID($mod)) {
-			ez->assume(ez->vec_eq(y_tmp, modulo_trunc));
-		} else if (cell->type == ID($divfloor)) {
-			if (cell->parameters[ID::A_SIGNED].as_bool() && cell->parameters[ID::B_SIGNED].as_bool())
-				ez->assume(ez->vec_eq(y_tmp, ez->vec_ite(
-					ez->XOR(a.back(), b.back()),
-					ez->vec_neg(ez->vec_ite(
-						ez->vec_reduce_or(modulo_trunc),
-						ez->vec_add(y_u, ez->vec_const_unsigned(1, y_u.size())),
-						y_u
-					)),
-					y_u
-				)));
-			else
-				ez->assume(ez->vec_eq(y_tmp, y_u));
-		} else if (cell->type == ID($modfloor)) {
-			ez->assume(ez->vec_eq(y_tmp, ez->vec_ite(floored_eq_trunc, modulo_trunc, ez->vec_add(modulo_trunc, b))));
-		}
+		IdString type = cell->type;
+		bool is_signed = cell->parameters[ID::A_SIGNED].as_bool() && cell->parameters[ID::B_SIGNED].as_bool();
+		ez->assume(ez->vec_eq(y_tmp, encodeCached(stringf("%s %d", log_id(type), is_signed), {a, b},
+				[type, is_signed](ezSAT *ez, const std::vector<std::vector<int>> &inputs) {
+					return encode_divmod(ez, type, is_signed, inputs[0], inputs[1]);
+				})));
 
 		if (ignore_div_by_zero) {
 			ez->assume(ez->expression(ezSAT::OpOr, b));
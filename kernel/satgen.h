@@ -74,6 +74,9 @@ struct SatGen
 	bool ignore_div_by_zero;
 	bool model_undef;
 	bool def_formal = false;
+	// encode $mul as an and-array of partial products and a chain of adders
+	// instead of selecting between partial sums with multiplexers
+	bool compact_mul = false;
 
 	SatGen(ezSAT *ez, SigMap *sigmap, std::string prefix = std::string()) :
 			ez(ez), sigmap(sigmap), prefix(prefix), ignore_div_by_zero(false), model_undef(false)
@@ -288,6 +291,14 @@ struct SatGen
 	}
 
 	bool importCell(RTLIL::Cell *cell, int timestep = -1);
+
+	// Instantiate the formula computed by encoder for the given input vectors.
+	// The formula is built once per key on fresh literals and cached globally
+	// as a template, later calls with the same key only replay the template
+	// onto the given inputs. The key must determine the formula for the input
+	// widths, e.g. it has to contain the cell type and parameters.
+	typedef std::function<std::vector<int>(ezSAT *ez, const std::vector<std::vector<int>> &inputs)> encoder_t;
+	std::vector<int> encodeCached(const std::string &key, const std::vector<std::vector<int>> &inputs, const encoder_t &encoder);
 };
 
 YOSYS_NAMESPACE_END
@@ -26,7 +26,7 @@ std::ostream &operator<<(std::ostream &os, SExpr const &sexpr) {
         os << sexpr.atom();
     else if(sexpr.is_list()){
         os << "(";
-        auto l = sexpr.list();
+        auto const &l = sexpr.list();
         for(size_t i = 0; i < l.size(); i++) {
             if(i > 0) os << " ";
             os << l[i];
@@ -45,29 +45,40 @@ std::ostream &operator<<(std::ostream &os, SExpr const &sexpr) {
 
 void SExprWriter::nl_if_pending() {
     if(_pending_nl) {
-        os << '\n';
+        _buf += '\n';
         _pos = 0;
         _pending_nl = false;
     }
 }
 
+void SExprWriter::write_buf() {
+    os.write(_buf.data(), _buf.size());
+    _buf.clear();
+}
+
 void SExprWriter::puts(std::string_view s) {
     if(s.empty()) return;
     nl_if_pending();
-    for(auto c : s) {
-        if(c == '\n') {
-            os << c;
-            _pos = 0;
-        } else {
+    // copy whole lines at once, indenting each one that is started
+    while(!s.empty()) {
+        size_t e = s.find('\n');
+        std::string_view line = s.substr(0, e);
+        if(!line.empty()) {
             if(_pos == 0) {
-                for(int i = 0; i < _indent; i++)
-                    os << "  ";
+                _buf.append(2 * _indent, ' ');
                 _pos = 2 * _indent;
             }
-            os << c;
-            _pos++;
+            _buf.append(line.data(), line.size());
+            _pos += line.size();
         }
+        if(e == std::string_view::npos)
+            break;
+        _buf += '\n';
+        _pos = 0;
+        s.remove_prefix(e + 1);
     }
+    if(_buf.size() >= buffer_size)
+        write_buf();
 }
 
 
@@ -85,7 +96,7 @@ int SExprWriter::check_fit(SExpr const &sexpr, int space) {
         space -= 2;
         if(sexpr.list().size() > 1)
             space -= sexpr.list().size() - 1;
-        for(auto arg : sexpr.list()) {
+        for(auto const &arg : sexpr.list()) {
             if(space < 0) break;
             space = check_fit(arg, space);
         }
@@ -98,7 +109,7 @@ void SExprWriter::print(SExpr const &sexpr, bool close, bool indent_rest) {
     if(sexpr.is_atom())
         puts(sexpr.atom());
     else if(sexpr.is_list()) {
-        auto args = sexpr.list();
+        auto const &args = sexpr.list();
         puts("(");
         // Expressions are printed horizontally if they fit on the line.
         // We do the check *after* puts("(") to make sure that _pos is accurate.
@@ -157,7 +168,7 @@ SExprWriter::~SExprWriter() {
     while(!_unclosed_stack.empty())
         pop();
     close(_unclosed.size());
-    nl_if_pending();
+    flush();
 }
 
 YOSYS_NAMESPACE_END
@@ -69,7 +69,12 @@ class SExprWriter {
 	vector<bool> _unclosed;
     // Used only for push() and pop() (stores _unclosed.size())
 	vector<size_t> _unclosed_stack;
+    // Output is collected here and written to os in blocks of about
+    // buffer_size bytes.
+    std::string _buf;
+    static constexpr size_t buffer_size = 1 << 16;
 	void nl_if_pending();
+    void write_buf();
     void puts(std::string_view s);
     int check_fit(SExpr const &sexpr, int space);
     void print(SExpr const &sexpr, bool close = true, bool indent_rest = true);
@@ -77,7 +82,9 @@ public:
     SExprWriter(std::ostream &os, int max_line_width = 80)
         : os(os)
         , _max_line_width(max_line_width)
-    {}
+    {
+        _buf.reserve(buffer_size + max_line_width);
+    }
     // Print an s-expr.
     SExprWriter &operator <<(SExpr const &sexpr) {
         print(sexpr);
@@ -112,6 +119,7 @@ public:
     // Flush any unprinted characters to the std::ostream, but does not close unclosed parentheses.
     void flush() {
         nl_if_pending();
+        write_buf();
     }
     // Destructor closes any unclosed parentheses and flushes.
     ~SExprWriter();
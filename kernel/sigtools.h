@@ -24,58 +24,62 @@
 
 YOSYS_NAMESPACE_BEGIN
 
+// A set of signal bits. The bits of each wire are stored as one bit vector
+// indexed by the offset, which takes a small fraction of the memory of a
+// hash table entry per bit and needs no hashing beyond the wire itself.
 struct SigPool
 {
-	struct bitDef_t : public std::pair<RTLIL::Wire*, int> {
-		bitDef_t() : std::pair<RTLIL::Wire*, int>(NULL, 0) { }
-		bitDef_t(const RTLIL::SigBit &bit) : std::pair<RTLIL::Wire*, int>(bit.wire, bit.offset) { }
-		[[nodiscard]] Hasher hash_into(Hasher h) const {
-			h.eat(first->name);
-			h.eat(second);
-			return h;
-		}
+	struct wire_bits_t {
+		std::vector<bool> bits;
+		int count = 0;
 	};
 
-	pool<bitDef_t> bits;
+	dict<RTLIL::Wire*, wire_bits_t> wires;
+	size_t total_bits = 0;
 
 	void clear()
 	{
-		bits.clear();
+		wires.clear();
+		total_bits = 0;
 	}
 
 	void add(const RTLIL::SigSpec &sig)
 	{
 		for (auto &bit : sig)
 			if (bit.wire != NULL)
-				bits.insert(bit);
+				set_bit(bit.wire, bit.offset);
 	}
 
 	void add(const SigPool &other)
 	{
-		for (auto &bit : other.bits)
-			bits.insert(bit);
+		for (auto &it : other.wires)
+			for (int i = 0; i < GetSize(it.second.bits); i++)
+				if (it.second.bits[i])
+					set_bit(it.first, i);
 	}
 
 	void del(const RTLIL::SigSpec &sig)
 	{
 		for (auto &bit : sig)
 			if (bit.wire != NULL)
-				bits.erase(bit);
+				reset_bit(bit.wire, bit.offset);
 	}
 
 	void del(const SigPool &other)
 	{
-		for (auto &bit : other.bits)
-			bits.erase(bit);
+		for (auto &it : other.wires)
+			for (int i = 0; i < GetSize(it.second.bits); i++)
+				if (it.second.bits[i])
+					reset_bit(it.first, i);
 	}
 
 	void expand(const RTLIL::SigSpec &from, const RTLIL::SigSpec &to)
 	{
 		log_assert(GetSize(from) == GetSize(to));
 		for (int i = 0; i < GetSize(from); i++) {
-			bitDef_t bit_from(from[i]), bit_to(to[i]);
-			if (bit_from.first != NULL && bit_to.first != NULL && bits.count(bit_from) > 0)
-				bits.insert(bit_to);
+			RTLIL::SigBit bit_from = from[i], bit_to = to[i];
+			if (bit_from.wire != NULL && bit_to.wire != NULL && check(bit_from))
+				set_bit(bit_to.wire, bit_to.offset);
 		}
 	}
 
@@ -83,7 +87,7 @@ struct SigPool
 	{
 		RTLIL::SigSpec result;
 		for (auto &bit : sig)
-			if (bit.wire != NULL && bits.count(bit))
+			if (check(bit))
 				result.append(bit);
 		return result;
 	}
@@ -92,20 +96,23 @@ struct SigPool
 	{
 		RTLIL::SigSpec result;
 		for (auto &bit : sig)
-			if (bit.wire != NULL && bits.count(bit) == 0)
+			if (bit.wire != NULL && !check(bit))
 				result.append(bit);
 		return result;
 	}
 
 	bool check(const RTLIL::SigBit &bit) const
 	{
-		return bit.wire != NULL && bits.count(bit);
+		if (bit.wire == NULL)
+			return false;
+		auto it = wires.find(bit.wire);
+		return it != wires.end() && bit.offset < GetSize(it->second.bits) && it->second.bits[bit.offset];
 	}
 
 	bool check_any(const RTLIL::SigSpec &sig) const
 	{
 		for (auto &bit : sig)
-			if (bit.wire != NULL && bits.count(bit))
+			if (check(bit))
 				return true;
 		return false;
 	}
@@ -113,105 +120,133 @@ struct SigPool
 	bool check_all(const RTLIL::SigSpec &sig) const
 	{
 		for (auto &bit : sig)
-			if (bit.wire != NULL && bits.count(bit) == 0)
+			if (bit.wire != NULL && !check(bit))
 				return false;
 		return true;
 	}
 
 	RTLIL::SigSpec export_one() const
 	{
-		for (auto &bit : bits)
-			return RTLIL::SigSpec(bit.first, bit.second);
+		for (auto &it : wires)
+			for (int i = 0; i < GetSize(it.second.bits); i++)
+				if (it.second.bits[i])
+					return RTLIL::SigSpec(it.first, i);
 		return RTLIL::SigSpec();
 	}
 
+	// wire by wire in the order in which the wires were added, and in
+	// increasing offset order within each wire
 	RTLIL::SigSpec export_all() const
 	{
-		pool<RTLIL::SigBit> sig;
-		for (auto &bit : bits)
-			sig.insert(RTLIL::SigBit(bit.first, bit.second));
+		RTLIL::SigSpec sig;
+		for (int n = GetSize(wires)-1; n >= 0; n--) {
+			auto &it = *wires.element(n);
+			for (int i = 0; i < GetSize(it.second.bits); i++)
+				if (it.second.bits[i])
+					sig.append(RTLIL::SigBit(it.first, i));
+		}
 		return sig;
 	}
 
 	size_t size() const
 	{
-		return bits.size();
+		return total_bits;
+	}
+
+private:
+	void set_bit(RTLIL::Wire *wire, int offset)
+	{
+		auto &entry = wires[wire];
+		if (offset >= GetSize(entry.bits))
+			entry.bits.resize(std::max(wire->width, offset + 1));
+		if (!entry.bits[offset]) {
+			entry.bits[offset] = true;
+			entry.count++;
+			total_bits++;
+		}
+	}
+
+	void reset_bit(RTLIL::Wire *wire, int offset)
+	{
+		auto it = wires.find(wire);
+		if (it == wires.end() || offset >= GetSize(it->second.bits) || !it->second.bits[offset])
+			return;
+		it->second.bits[offset] = false;
+		total_bits--;
+		if (--it->second.count == 0)
+			wires.erase(it);
 	}
 };
 
+// A map from signal bits to sets of values. The bits of each wire are one
+// vector indexed by the offset, and the values of a bit are a vector kept
+// sorted by Compare and free of duplicates: most bits have only one or two
+// values, and a std::set would allocate a tree node for each of them.
 template <typename T, class Compare = void>
 struct SigSet
 {
 	static_assert(!std::is_same<Compare,void>::value, "Default value for `Compare' class not found for SigSet<T>. Please specify.");
 
-	struct bitDef_t : public std::pair<RTLIL::Wire*, int> {
-		bitDef_t() : std::pair<RTLIL::Wire*, int>(NULL, 0) { }
-		bitDef_t(const RTLIL::SigBit &bit) : std::pair<RTLIL::Wire*, int>(bit.wire, bit.offset) { }
-		[[nodiscard]] Hasher hash_into(Hasher h) const {
-			h.eat(first->name);
-			h.eat(second);
-			return h;
-		}
-	};
+	typedef std::vector<T> values_t;
 
-	dict<bitDef_t, std::set<T, Compare>> bits;
+	dict<RTLIL::Wire*, std::vector<values_t>> wires;
 
 	void clear()
 	{
-		bits.clear();
+		wires.clear();
 	}
 
 	void insert(const RTLIL::SigSpec &sig, T data)
 	{
 		for (const auto &bit : sig)
 			if (bit.wire != NULL)
-				bits[bit].insert(data);
+				insert_value(values(bit), data);
 	}
 
 	void insert(const RTLIL::SigSpec& sig, const std::set<T> &data)
 	{
 		for (const auto &bit : sig)
-			if (bit.wire != NULL)
-				bits[bit].insert(data.begin(), data.end());
+			if (bit.wire != NULL) {
+				auto &vals = values(bit);
+				for (auto &it : data)
+					insert_value(vals, it);
+			}
 	}
 
 	void erase(const RTLIL::SigSpec& sig)
 	{
 		for (const auto &bit : sig)
-			if (bit.wire != NULL)
-				bits[bit].clear();
+			if (auto vals = find_values(bit))
+				values_t().swap(*vals);
 	}
 
 	void erase(const RTLIL::SigSpec &sig, T data)
 	{
 		for (const auto &bit : sig)
-			if (bit.wire != NULL)
-				bits[bit].erase(data);
+			if (auto vals = find_values(bit))
+				erase_value(*vals, data);
 	}
 
 	void erase(const RTLIL::SigSpec &sig, const std::set<T> &data)
 	{
 		for (const auto &bit : sig)
-			if (bit.wire != NULL)
-				bits[bit].erase(data.begin(), data.end());
+			if (auto vals = find_values(bit))
+				for (auto &it : data)
+					erase_value(*vals, it);
 	}
 
 	void find(const RTLIL::SigSpec &sig, std::set<T> &result)
 	{
 		for (const auto &bit : sig)
-			if (bit.wire != NULL) {
-				auto &data = bits[bit];
-				result.insert(data.begin(), data.end());
-			}
+			if (auto vals = find_values(bit))
+				result.insert(vals->begin(), vals->end());
 	}
 
 	void find(const RTLIL::SigSpec &sig, pool<T> &result)
 	{
 		for (const auto &bit : sig)
-			if (bit.wire != NULL) {
-				auto &data = bits[bit];
-				result.insert(data.begin(), data.end());
-			}
+			if (auto vals = find_values(bit))
+				result.insert(vals->begin(), vals->end());
 	}
 
 	std::set<T> find(const RTLIL::SigSpec &sig)
@@ -224,10 +259,44 @@ struct SigSet
 	bool has(const RTLIL::SigSpec &sig)
 	{
 		for (auto &bit : sig)
-			if (bit.wire != NULL && bits.count(bit))
-				return true;
+			if (auto vals = find_values(bit))
+				if (!vals->empty())
+					return true;
 		return false;
 	}
+
+private:
+	values_t &values(const RTLIL::SigBit &bit)
+	{
+		auto &offsets = wires[bit.wire];
+		if (bit.offset >= GetSize(offsets))
+			offsets.resize(std::max(bit.wire->width, bit.offset + 1));
+		return offsets[bit.offset];
+	}
+
+	values_t *find_values(const RTLIL::SigBit &bit)
+	{
+		if (bit.wire == NULL)
+			return nullptr;
+		auto it = wires.find(bit.wire);
+		if (it == wires.end() || bit.offset >= GetSize(it->second))
+			return nullptr;
+		return &it->second[bit.offset];
+	}
+
+	static void insert_value(values_t &vals, const T &data)
+	{
+		auto it = std::lower_bound(vals.begin(), vals.end(), data, Compare());
+		if (it == vals.end() || Compare()(data, *it))
+			vals.insert(it, data);
+	}
+
+	static void erase_value(values_t &vals, const T &data)
+	{
+		auto it = std::lower_bound(vals.begin(), vals.end(), data, Compare());
+		if (it != vals.end() && !Compare()(data, *it))
+			vals.erase(it);
+	}
 };
 
 template<typename T>
@@ -362,6 +431,69 @@ struct SigMap
 	}
 };
 
+// A SigMap that follows the connections of a module as it changes. New
+// connections are merged in when Module::connect() notifies its monitors,
+// so passes that alternate between lookups and connect() calls don't have
+// to rebuild the map with SigMap::set(). Replacing the connection list with
+// Module::new_connections() or anything that blacks out the module (e.g.
+// removing wires) marks the map stale, it is rebuilt on the next get().
+//
+// Bits added to the map directly with get().add() stay in until the next
+// rebuild, just as with a plain SigMap.
+struct IncrementalSigMap : public RTLIL::Monitor
+{
+	RTLIL::Module *module;
+	SigMap sigmap;
+	bool stale = true;
+
+	IncrementalSigMap(RTLIL::Module *module) : module(module)
+	{
+		module->monitors.insert(this);
+	}
+
+	~IncrementalSigMap()
+	{
+		module->monitors.erase(this);
+	}
+
+	IncrementalSigMap(const IncrementalSigMap &) = delete;
+	IncrementalSigMap &operator=(const IncrementalSigMap &) = delete;
+
+	SigMap &get()
+	{
+		if (stale) {
+			sigmap.set(module);
+			stale = false;
+		}
+		return sigmap;
+	}
+
+	RTLIL::SigBit operator()(RTLIL::SigBit bit) { return get()(bit); }
+	RTLIL::SigSpec operator()(RTLIL::SigSpec sig) { return get()(sig); }
+	RTLIL::SigSpec operator()(RTLIL::Wire *wire) { return get()(wire); }
+
+	void notify_connect(RTLIL::Module *mod, const RTLIL::SigSig &sigsig) override
+	{
+		log_assert(module == mod);
+		// Module::connect() drops constant bits on the left hand side and
+		// notifies again with the remaining bits
+		if (!stale && !sigsig.first.has_const())
+			sigmap.add(sigsig.first, sigsig.second);
+	}
+
+	void notify_connect(RTLIL::Module *mod, const std::vector<RTLIL::SigSig>&) override
+	{
+		log_assert(module == mod);
+		stale = true;
+	}
+
+	void notify_blackout(RTLIL::Module *mod) override
+	{
+		log_assert(module == mod);
+		stale = true;
+	}
+};
+
 YOSYS_NAMESPACE_END
 
 #endif /* SIGTOOLS_H */
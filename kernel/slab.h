@@ -0,0 +1,126 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "kernel/yosys_common.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// A pool allocator for objects of a single type. Storage is carved out of
+// slabs that grow geometrically, freed slots are kept on a free list for
+// reuse, and all slabs are released at once when the pool is destroyed or
+// cleared. A pool is not thread-safe, it is meant to be owned by a single
+// container such as an RTLIL::Module (see Module::addCell()).
+//
+// The pool only manages storage. Callers construct objects with placement
+// new in the memory returned by allocate() and run the destructor before
+// calling deallocate(). T may be incomplete where the pool is declared.
+//
+// Define YOSYS_NO_SLAB_POOL to use plain operator new/delete instead, e.g.
+// for finding use-after-free bugs with a memory sanitizer.
+
+template<typename T>
+class SlabPool
+{
+	static constexpr size_t min_slab_objects = 8;
+	static constexpr size_t max_slab_objects = 4096;
+
+	struct FreeSlot {
+		FreeSlot *next;
+	};
+
+	std::vector<void*> slabs;
+	FreeSlot *free_list = nullptr;
+	size_t next_slab_objects = min_slab_objects;
+	size_t allocated = 0;
+
+	static constexpr size_t slot_size() {
+		size_t size = std::max(sizeof(T), sizeof(FreeSlot));
+		size_t align = std::max(alignof(T), alignof(FreeSlot));
+		return (size + align - 1) / align * align;
+	}
+
+	void grow()
+	{
+		size_t num = next_slab_objects;
+		char *slab = static_cast<char*>(::operator new(num * slot_size()));
+		slabs.push_back(slab);
+		for (size_t i = num; i > 0; i--) {
+			FreeSlot *slot = reinterpret_cast<FreeSlot*>(slab + (i-1) * slot_size());
+			slot->next = free_list;
+			free_list = slot;
+		}
+		next_slab_objects = std::min(2 * next_slab_objects, max_slab_objects);
+	}
+
+public:
+	SlabPool() { }
+	SlabPool(const SlabPool &) = delete;
+	SlabPool &operator=(const SlabPool &) = delete;
+	~SlabPool() { clear(); }
+
+	void *allocate()
+	{
+		allocated++;
+	#ifdef YOSYS_NO_SLAB_POOL
+		return ::operator new(sizeof(T));
+	#else
+		if (free_list == nullptr)
+			grow();
+		FreeSlot *slot = free_list;
+		free_list = slot->next;
+		return slot;
+	#endif
+	}
+
+	void deallocate(void *ptr)
+	{
+		log_assert(allocated > 0);
+		allocated--;
+	#ifdef YOSYS_NO_SLAB_POOL
+		::operator delete(ptr);
+	#else
+		FreeSlot *slot = static_cast<FreeSlot*>(ptr);
+		slot->next = free_list;
+		free_list = slot;
+		if (allocated == 0)
+			clear();
+	#endif
+	}
+
+	// number of live objects
+	size_t size() const { return allocated; }
+
+	// releases all slabs, all objects must have been deallocated
+	void clear()
+	{
+		log_assert(allocated == 0);
+		for (auto slab : slabs)
+			::operator delete(slab);
+		slabs.clear();
+		free_list = nullptr;
+		next_slab_objects = min_slab_objects;
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/spill.h"
+#include "kernel/rtlil_binary.h"
+#include "kernel/modtools.h"
+#include <fstream>
+#include <iterator>
+
+YOSYS_NAMESPACE_BEGIN
+
+SpillStore::SpillStore(RTLIL::Design *design, const std::string &dir) : design(design), dir(dir)
+{
+	if (this->dir.empty()) {
+		this->dir = make_temp_dir(get_base_tmpdir() + "/yosys_spill_XXXXXX");
+		temp_dir = true;
+	} else if (!check_directory_exists(this->dir) && !create_directory(this->dir)) {
+		log_error("Can't create spill directory `%s'.\n", this->dir.c_str());
+	}
+}
+
+SpillStore::~SpillStore()
+{
+	for (auto &it : files)
+		remove(it.second.c_str());
+	if (temp_dir)
+		remove_directory(dir);
+}
+
+bool SpillStore::spill(RTLIL::Module *module)
+{
+	if (files.count(module))
+		return true;
+	if (module->get_blackbox_attribute() || module->design != design || !module->sharing_designs_.empty())
+		return false;
+	if (!design->monitors.empty())
+		return false;
+
+	ModIndex::drop_cached(module);
+	delete module->cached_timing_;
+	module->cached_timing_ = nullptr;
+	delete module->cached_ffs_;
+	module->cached_ffs_ = nullptr;
+	if (!module->monitors.empty())
+		return false;
+
+	std::string filename = stringf("%s/module%d.rtlilb", dir.c_str(), next_file++);
+	std::ofstream f(filename, std::ofstream::binary);
+	RTLIL_BINARY::dump_modules(f, {module});
+	f.close();
+	if (f.fail())
+		log_error("Can't write spill file `%s': %s\n", filename.c_str(), strerror(errno));
+
+	// a stub, not a blackbox: passes that skip blackboxes must not skip
+	// a module just because it is spilled
+	module->makeblackbox();
+	module->attributes.erase(ID::blackbox);
+	files[module] = filename;
+	return true;
+}
+
+void SpillStore::restore(RTLIL::Module *module)
+{
+	auto it = files.find(module);
+	log_assert(it != files.end());
+	std::string filename = it->second;
+	files.erase(it);
+
+	std::ifstream f(filename, std::ifstream::binary);
+	std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+	if (f.bad() || data.empty())
+		log_error("Can't read spill file `%s' of module %s.\n", filename.c_str(), log_id(module));
+
+	RTLIL::Design loaded;
+	RTLIL_BINARY::parse_design(data.data(), data.size(), &loaded, RTLIL_BINARY::ReadOptions());
+	log_assert(GetSize(loaded.modules_) == 1);
+	RTLIL::Module *image = loaded.modules_.begin()->second;
+
+	// the stub only holds the port wires. Its attributes started out as a
+	// copy of those of the image and passes may have changed them since
+	// (e.g. 'hierarchy' sets and removes 'top'), so they are kept.
+	pool<RTLIL::Wire*> stub_wires;
+	for (auto wire : module->wires())
+		stub_wires.insert(wire);
+	module->remove(stub_wires);
+	dict<RTLIL::IdString, RTLIL::Const> attributes;
+	attributes.swap(module->attributes);
+	image->cloneInto(module);
+	module->attributes.swap(attributes);
+
+	remove(filename.c_str());
+	log("Read spilled module %s back from `%s'.\n", log_id(module), dir.c_str());
+}
+
+void SpillStore::restore_all()
+{
+	std::vector<RTLIL::Module*> spilled;
+	for (auto &it : files)
+		spilled.push_back(it.first);
+	for (auto module : spilled)
+		access(module);
+}
+
+void SpillStore::forget(RTLIL::Module *module)
+{
+	auto it = files.find(module);
+	if (it != files.end()) {
+		remove(it->second.c_str());
+		files.erase(it);
+	}
+	last_use.erase(module);
+}
+
+int SpillStore::enforce_budget()
+{
+	if (budget <= 0 || design->refcount_modules_ != 0)
+		return 0;
+
+	int64_t held = 0;
+	std::vector<std::pair<int64_t, RTLIL::Module*>> candidates;
+	for (auto &it : design->modules_) {
+		RTLIL::Module *module = it.second;
+		if (files.count(module) || module->get_blackbox_attribute())
+			continue;
+		held += GetSize(module->cells_);
+		auto use = last_use.find(module);
+		candidates.push_back({use == last_use.end() ? 0 : use->second, module});
+	}
+	if (held <= budget)
+		return 0;
+
+	std::sort(candidates.begin(), candidates.end(), [](const std::pair<int64_t, RTLIL::Module*> &a, const std::pair<int64_t, RTLIL::Module*> &b) {
+		return a.first < b.first;
+	});
+
+	int count = 0;
+	int64_t spilled_cells = 0;
+	for (auto &it : candidates) {
+		if (held <= budget)
+			break;
+		int cells = GetSize(it.second->cells_);
+		if (spill(it.second)) {
+			held -= cells;
+			spilled_cells += cells;
+			count++;
+		}
+	}
+	if (count > 0)
+		log("Spilled %d modules with %lld cells to `%s'.\n", count, (long long)spilled_cells, dir.c_str());
+	return count;
+}
+
+YOSYS_NAMESPACE_END
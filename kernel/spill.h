@@ -0,0 +1,90 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef SPILL_H
+#define SPILL_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Out-of-core storage for the modules of a design (see 'help spill').
+//
+// A spilled module is written to a binary RTLIL file and its contents are
+// replaced by a stub with the same ports, parameters and attributes. The
+// stub is not marked as a blackbox, whether a module is spilled is only
+// recorded here. The RTLIL::Module object itself stays in the design, so
+// pointers to it and its name stay valid. The module is read back into the
+// same object on the next access through Design::module(),
+// Design::selected() or the Design::selected_*modules() helpers, or when the
+// `select` command looks at its members. Pass::call() reads all spilled
+// modules back before passes that are not marked selection_safe() and before
+// backends, so only selection-safe passes ever iterate over the stubs and
+// they only pay for the modules they actually work on.
+struct SpillStore
+{
+	RTLIL::Design *design;
+	std::string dir;
+	// the number of cells kept in memory after each command, 0 for no limit
+	int budget = 0;
+
+	// An empty `dir` creates a temporary directory, which is removed again
+	// together with the store.
+	SpillStore(RTLIL::Design *design, const std::string &dir = std::string());
+	~SpillStore();
+
+	bool is_spilled(const RTLIL::Module *module) const { return files.count(const_cast<RTLIL::Module*>(module)) != 0; }
+	int spilled_count() const { return GetSize(files); }
+
+	// Writes the module to the store and replaces it with a stub. Returns
+	// false for modules that are not spilled, i.e. blackboxes and modules
+	// that are shared with other designs or watched by monitors.
+	bool spill(RTLIL::Module *module);
+
+	// Reads a spilled module back into the same object.
+	void restore(RTLIL::Module *module);
+	void restore_all();
+
+	// Called for each access to a module through the design; restores it
+	// if it is spilled and records the access for the LRU order.
+	void access(RTLIL::Module *module)
+	{
+		last_use[module] = ++clock;
+		if (!files.empty() && files.count(module))
+			restore(module);
+	}
+
+	// Drops the entries of a module that is removed from the design.
+	void forget(RTLIL::Module *module);
+
+	// Spills the least recently used modules until at most `budget` cells
+	// are held in memory, returns the number of spilled modules.
+	int enforce_budget();
+
+private:
+	bool temp_dir = false;
+	int next_file = 0;
+	int64_t clock = 0;
+	dict<RTLIL::Module*, std::string> files;
+	dict<RTLIL::Module*, int64_t> last_use;
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -373,6 +373,7 @@ static int tcl_set_attr(ClientData, Tcl_Interp *interp, int objc, Tcl_Obj *const
 		obj_id = RTLIL::escape_id(Tcl_GetString(objv[i++]));
 	attr_id = RTLIL::escape_id(Tcl_GetString(objv[i++]));
 
+	yosys_design->unshare_modules();
 	RTLIL::Module *mod = yosys_design->module(mod_id);
 	if (!mod)
 		ERROR("module not found")
@@ -496,6 +497,7 @@ static int tcl_set_param(ClientData, Tcl_Interp *interp, int objc, Tcl_Obj *cons
 	cell_id = RTLIL::escape_id(Tcl_GetString(objv[i++]));
 	param_id = RTLIL::escape_id(Tcl_GetString(objv[i++]));
 
+	yosys_design->unshare_modules();
 	RTLIL::Module *mod = yosys_design->module(mod_id);
 	if (!mod)
 		ERROR("module not found")
@@ -532,6 +534,259 @@ static int tcl_set_param(ClientData, Tcl_Interp *interp, int objc, Tcl_Obj *cons
 	return TCL_OK;
 }
 
+// IdStrings are passed to and from Tcl as objects whose internal
+// representation is the IdString itself, so that names returned by the
+// list commands below go back into them without being looked up again.
+// The string representation is the name as accepted by escape_id().
+
+static void tcl_id_free(Tcl_Obj *obj);
+static void tcl_id_dup(Tcl_Obj *src, Tcl_Obj *dup);
+static int tcl_id_from_any(Tcl_Interp *interp, Tcl_Obj *obj);
+
+static Tcl_ObjType tcl_id_type = { "rtlil::id", tcl_id_free, tcl_id_dup, nullptr, tcl_id_from_any };
+
+static void tcl_id_free(Tcl_Obj *obj)
+{
+	delete (IdString *)obj->internalRep.twoPtrValue.ptr1;
+}
+
+static void tcl_id_dup(Tcl_Obj *src, Tcl_Obj *dup)
+{
+	dup->internalRep.twoPtrValue.ptr1 = new IdString(*(IdString *)src->internalRep.twoPtrValue.ptr1);
+	dup->typePtr = &tcl_id_type;
+}
+
+static int tcl_id_from_any(Tcl_Interp *, Tcl_Obj *obj)
+{
+	IdString *id = new IdString(RTLIL::escape_id(Tcl_GetString(obj)));
+	if (obj->typePtr != nullptr && obj->typePtr->freeIntRepProc != nullptr)
+		obj->typePtr->freeIntRepProc(obj);
+	obj->internalRep.twoPtrValue.ptr1 = id;
+	obj->typePtr = &tcl_id_type;
+	return TCL_OK;
+}
+
+static IdString tcl_to_id(Tcl_Obj *obj)
+{
+	if (obj->typePtr != &tcl_id_type)
+		tcl_id_from_any(nullptr, obj);
+	return *(IdString *)obj->internalRep.twoPtrValue.ptr1;
+}
+
+static Tcl_Obj *id_to_tcl(IdString id)
+{
+	static dict<IdString, Tcl_Obj*> cache;
+	auto it = cache.find(id);
+	if (it != cache.end())
+		return it->second;
+
+	// keep the escape where dropping it would change the name or make it
+	// look like an option
+	const std::string &str = id.str();
+	bool keep_escape = str[0] != '\\' || str.size() < 2 || str[1] == '\\' || str[1] == '$' || str[1] == '-';
+	const char *name = keep_escape ? str.c_str() : str.c_str() + 1;
+
+	Tcl_Obj *obj = Tcl_NewStringObj(name, -1);
+	obj->internalRep.twoPtrValue.ptr1 = new IdString(id);
+	obj->typePtr = &tcl_id_type;
+	Tcl_IncrRefCount(obj);
+	cache[id] = obj;
+	return obj;
+}
+
+static Tcl_Obj *const_to_tcl(const RTLIL::Const &value)
+{
+	std::string str = (value.flags & RTLIL::CONST_FLAG_STRING) ? value.decode_string() : value.as_string();
+	return Tcl_NewStringObj(str.data(), str.size());
+}
+
+static Tcl_Obj *sig_to_tcl(const RTLIL::SigSpec &sig)
+{
+	std::string str = log_signal(sig, false);
+	return Tcl_NewStringObj(str.data(), str.size());
+}
+
+static RTLIL::Module *tcl_get_module(Tcl_Interp *interp, Tcl_Obj *obj)
+{
+	RTLIL::Module *mod = yosys_design->module(tcl_to_id(obj));
+	if (!mod)
+		Tcl_SetResult(interp, (char *)"module not found", TCL_STATIC);
+	return mod;
+}
+
+static int tcl_module_list(ClientData, Tcl_Interp *interp, int objc, Tcl_Obj *const[])
+{
+	if (objc != 1)
+		ERROR("bad usage: expected \"module_list\"")
+
+	Tcl_Obj *result = Tcl_NewListObj(0, nullptr);
+	for (auto mod : yosys_design->modules())
+		Tcl_ListObjAppendElement(interp, result, id_to_tcl(mod->name));
+	Tcl_SetObjResult(interp, result);
+	return TCL_OK;
+}
+
+static int tcl_wire_list(ClientData data, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+	bool ports = data != nullptr;
+	if (objc != 2)
+		ERROR(ports ? "bad usage: expected \"port_list <module>\"" : "bad usage: expected \"wire_list <module>\"")
+
+	RTLIL::Module *mod = tcl_get_module(interp, objv[1]);
+	if (!mod)
+		return TCL_ERROR;
+
+	Tcl_Obj *result = Tcl_NewListObj(0, nullptr);
+	if (ports) {
+		for (auto &port : mod->ports)
+			Tcl_ListObjAppendElement(interp, result, id_to_tcl(port));
+	} else {
+		for (auto wire : mod->wires())
+			Tcl_ListObjAppendElement(interp, result, id_to_tcl(wire->name));
+	}
+	Tcl_SetObjResult(interp, result);
+	return TCL_OK;
+}
+
+static int tcl_cell_list(ClientData, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+	int i;
+	bool type_flag = false;
+	for (i = 1; i < objc; i++) {
+		FLAG2(type)
+		break;
+	}
+
+	if (i != objc - 1)
+		ERROR("bad usage: expected \"cell_list [-type] <module>\"")
+
+	RTLIL::Module *mod = tcl_get_module(interp, objv[i]);
+	if (!mod)
+		return TCL_ERROR;
+
+	Tcl_Obj *result = Tcl_NewListObj(0, nullptr);
+	for (auto cell : mod->cells()) {
+		Tcl_ListObjAppendElement(interp, result, id_to_tcl(cell->name));
+		if (type_flag)
+			Tcl_ListObjAppendElement(interp, result, id_to_tcl(cell->type));
+	}
+	Tcl_SetObjResult(interp, result);
+	return TCL_OK;
+}
+
+static int tcl_wire_width(ClientData, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+	if (objc != 3)
+		ERROR("bad usage: expected \"wire_width <module> <wire>\"")
+
+	RTLIL::Module *mod = tcl_get_module(interp, objv[1]);
+	if (!mod)
+		return TCL_ERROR;
+
+	RTLIL::Wire *wire = mod->wire(tcl_to_id(objv[2]));
+	if (!wire)
+		ERROR("wire not found")
+
+	Tcl_SetObjResult(interp, Tcl_NewIntObj(wire->width));
+	return TCL_OK;
+}
+
+static int tcl_cell_type(ClientData, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+	if (objc != 3)
+		ERROR("bad usage: expected \"cell_type <module> <cell>\"")
+
+	RTLIL::Module *mod = tcl_get_module(interp, objv[1]);
+	if (!mod)
+		return TCL_ERROR;
+
+	RTLIL::Cell *cell = mod->cell(tcl_to_id(objv[2]));
+	if (!cell)
+		ERROR("cell not found")
+
+	Tcl_SetObjResult(interp, id_to_tcl(cell->type));
+	return TCL_OK;
+}
+
+static int tcl_get_conn(ClientData, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+	if (objc != 3 && objc != 4)
+		ERROR("bad usage: expected \"get_conn <module> <cell> [<port>]\"")
+
+	RTLIL::Module *mod = tcl_get_module(interp, objv[1]);
+	if (!mod)
+		return TCL_ERROR;
+
+	RTLIL::Cell *cell = mod->cell(tcl_to_id(objv[2]));
+	if (!cell)
+		ERROR("cell not found")
+
+	if (objc == 4) {
+		IdString port = tcl_to_id(objv[3]);
+		if (!cell->hasPort(port))
+			ERROR("port not found")
+		Tcl_SetObjResult(interp, sig_to_tcl(cell->getPort(port)));
+		return TCL_OK;
+	}
+
+	Tcl_Obj *result = Tcl_NewListObj(0, nullptr);
+	for (auto &conn : cell->connections()) {
+		Tcl_ListObjAppendElement(interp, result, id_to_tcl(conn.first));
+		Tcl_ListObjAppendElement(interp, result, sig_to_tcl(conn.second));
+	}
+	Tcl_SetObjResult(interp, result);
+	return TCL_OK;
+}
+
+static int tcl_get_attrs(ClientData data, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+	bool params = data != nullptr;
+	int i;
+	bool mod_flag = false;
+	for (i = 1; i < objc && !params; i++) {
+		FLAG2(mod)
+		break;
+	}
+
+	if (i != objc - 1 - !mod_flag)
+		ERROR(params ? "bad usage: expected \"get_params <module> <cellid>\""
+				: "bad usage: expected \"get_attrs -mod <module>\" or \"get_attrs <module> <identifier>\"")
+
+	RTLIL::Module *mod = tcl_get_module(interp, objv[i++]);
+	if (!mod)
+		return TCL_ERROR;
+
+	const dict<IdString, RTLIL::Const> *values = nullptr;
+	if (mod_flag) {
+		values = &mod->attributes;
+	} else if (params) {
+		RTLIL::Cell *cell = mod->cell(tcl_to_id(objv[i]));
+		if (!cell)
+			ERROR("object not found")
+		values = &cell->parameters;
+	} else {
+		IdString obj_id = tcl_to_id(objv[i]);
+		RTLIL::AttrObject *obj = mod->wire(obj_id);
+		if (!obj)
+			obj = mod->memories.at(obj_id, nullptr);
+		if (!obj)
+			obj = mod->cell(obj_id);
+		if (!obj)
+			obj = mod->processes.at(obj_id, nullptr);
+		if (!obj)
+			ERROR("object not found")
+		values = &obj->attributes;
+	}
+
+	Tcl_Obj *result = Tcl_NewListObj(0, nullptr);
+	for (auto &it : *values) {
+		Tcl_ListObjAppendElement(interp, result, id_to_tcl(it.first));
+		Tcl_ListObjAppendElement(interp, result, const_to_tcl(it.second));
+	}
+	Tcl_SetObjResult(interp, result);
+	return TCL_OK;
+}
+
 int yosys_tcl_iterp_init(Tcl_Interp *interp)
 {
 	if (Tcl_Init(interp)!=TCL_OK)
@@ -542,14 +797,18 @@ int yosys_tcl_iterp_init(Tcl_Interp *interp)
 	Tcl_CreateObjCommand(interp, "rtlil::set_attr", tcl_set_attr, NULL, NULL);
 	Tcl_CreateCommand(interp, "rtlil::get_param", tcl_get_param, NULL, NULL);
 	Tcl_CreateObjCommand(interp, "rtlil::set_param", tcl_set_param, NULL, NULL);
+	Tcl_CreateObjCommand(interp, "rtlil::module_list", tcl_module_list, NULL, NULL);
+	Tcl_CreateObjCommand(interp, "rtlil::wire_list", tcl_wire_list, NULL, NULL);
+	Tcl_CreateObjCommand(interp, "rtlil::port_list", tcl_wire_list, (ClientData)1, NULL);
+	Tcl_CreateObjCommand(interp, "rtlil::cell_list", tcl_cell_list, NULL, NULL);
+	Tcl_CreateObjCommand(interp, "rtlil::wire_width", tcl_wire_width, NULL, NULL);
+	Tcl_CreateObjCommand(interp, "rtlil::cell_type", tcl_cell_type, NULL, NULL);
+	Tcl_CreateObjCommand(interp, "rtlil::get_conn", tcl_get_conn, NULL, NULL);
+	Tcl_CreateObjCommand(interp, "rtlil::get_attrs", tcl_get_attrs, NULL, NULL);
+	Tcl_CreateObjCommand(interp, "rtlil::get_params", tcl_get_attrs, (ClientData)1, NULL);
 
 	// TODO:
 	//
-	// port_list
-	// wire_list
-	// cell_list
-	// wire_width
-	//
 	// add_wire
 	// add_cell
 	// rename_wire
@@ -558,7 +817,6 @@ int yosys_tcl_iterp_init(Tcl_Interp *interp)
 	//
 	// SigSpec land
 	//
-	// get_conn
 	// set_conn
 	// unpack
 	// pack
@@ -566,6 +824,8 @@ int yosys_tcl_iterp_init(Tcl_Interp *interp)
 	// Note (dev jf 24-12-02): Make log_id escape everything that’s not a valid 
 	// verilog identifier before adding any tcl API that returns IdString values
 	// to avoid -option injection
+	// (the list commands above return names through id_to_tcl(), which keeps
+	// the escape of names that start with '-')
 
 	return TCL_OK ;
 }
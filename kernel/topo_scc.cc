@@ -0,0 +1,191 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2024  Jannis Harder <jix@yosyshq.com> <me@jix.one>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/topo_scc.h"
+
+#include <atomic>
+#include <memory>
+#ifdef YOSYS_ENABLE_THREADS
+#include <thread>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+CsrGraph::CsrGraph(int num_nodes, const std::vector<std::pair<int, int>> &edges)
+{
+	// counting sort of the edges by source and by destination
+	succ_offsets.assign(num_nodes + 1, 0);
+	pred_offsets.assign(num_nodes + 1, 0);
+	for (auto const &edge : edges) {
+		log_assert(edge.first >= 0 && edge.first < num_nodes);
+		log_assert(edge.second >= 0 && edge.second < num_nodes);
+		succ_offsets[edge.first + 1]++;
+		pred_offsets[edge.second + 1]++;
+	}
+	for (int node = 0; node < num_nodes; node++) {
+		succ_offsets[node + 1] += succ_offsets[node];
+		pred_offsets[node + 1] += pred_offsets[node];
+	}
+
+	succ_nodes.resize(edges.size());
+	pred_nodes.resize(edges.size());
+	std::vector<int> succ_pos(succ_offsets.begin(), succ_offsets.end() - 1);
+	std::vector<int> pred_pos(pred_offsets.begin(), pred_offsets.end() - 1);
+	for (auto const &edge : edges) {
+		succ_nodes[succ_pos[edge.first]++] = edge.second;
+		pred_nodes[pred_pos[edge.second]++] = edge.first;
+	}
+
+	indices_.assign(num_nodes, -1);
+}
+
+namespace {
+
+// Remove the frontier nodes from the graph by decrementing the remaining
+// degree of their neighbours, the successors when `forward` is set and the
+// predecessors otherwise. Returns the neighbours whose degree dropped to
+// zero, sorted so that the result does not depend on the thread schedule.
+std::vector<int> peel(const CsrGraph &graph, const std::vector<int> &frontier, std::atomic<int> *degree, bool forward, int threads)
+{
+	auto visit = [&](int begin, int end, std::vector<int> &next) {
+		for (int i = begin; i < end; i++) {
+			int node = frontier[i];
+			const int *it = forward ? graph.succ_begin(node) : graph.pred_begin(node);
+			const int *it_end = forward ? graph.succ_end(node) : graph.pred_end(node);
+			for (; it != it_end; ++it)
+				if (degree[*it].fetch_sub(1, std::memory_order_relaxed) == 1)
+					next.push_back(*it);
+		}
+	};
+
+	std::vector<int> next;
+#ifdef YOSYS_ENABLE_THREADS
+	// small frontiers are not worth starting threads for
+	int num_chunks = std::min(threads, GetSize(frontier) / 4096);
+	if (num_chunks > 1) {
+		std::vector<std::vector<int>> partial(num_chunks);
+		std::vector<std::thread> pool;
+		for (int i = 0; i < num_chunks; i++) {
+			int begin = int(int64_t(GetSize(frontier)) * i / num_chunks);
+			int end = int(int64_t(GetSize(frontier)) * (i + 1) / num_chunks);
+			pool.emplace_back([&, i, begin, end]() { visit(begin, end, partial[i]); });
+		}
+		for (auto &thread : pool)
+			thread.join();
+		for (auto &nodes : partial)
+			next.insert(next.end(), nodes.begin(), nodes.end());
+	} else
+#else
+	(void)threads;
+#endif
+		visit(0, GetSize(frontier), next);
+
+	std::sort(next.begin(), next.end());
+	return next;
+}
+
+} // namespace
+
+bool topo_levels(const CsrGraph &graph, std::vector<std::vector<int>> &levels, int threads)
+{
+	int num_nodes = graph.num_nodes();
+	std::unique_ptr<std::atomic<int>[]> degree(new std::atomic<int>[num_nodes]);
+
+	std::vector<int> frontier;
+	for (int node = 0; node < num_nodes; node++) {
+		degree[node].store(graph.in_degree(node), std::memory_order_relaxed);
+		if (graph.in_degree(node) == 0)
+			frontier.push_back(node);
+	}
+
+	levels.clear();
+	int placed = 0;
+	while (!frontier.empty()) {
+		placed += GetSize(frontier);
+		levels.push_back(std::move(frontier));
+		frontier = peel(graph, levels.back(), degree.get(), true, threads);
+	}
+
+	return placed == num_nodes;
+}
+
+int csr_sccs(CsrGraph &graph, std::vector<int> &scc_index, int threads)
+{
+	int num_nodes = graph.num_nodes();
+	std::unique_ptr<std::atomic<int>[]> degree(new std::atomic<int>[num_nodes]);
+	int next_index = 0;
+
+	scc_index.assign(num_nodes, -1);
+
+	// Nodes that only lead into already peeled nodes are single node SCCs.
+	// Peeling them from the sinks up gives them the lowest indices.
+	std::vector<int> frontier;
+	for (int node = 0; node < num_nodes; node++) {
+		degree[node].store(graph.out_degree(node), std::memory_order_relaxed);
+		if (graph.out_degree(node) == 0)
+			frontier.push_back(node);
+	}
+	while (!frontier.empty()) {
+		for (int node : frontier)
+			scc_index[node] = next_index++;
+		frontier = peel(graph, frontier, degree.get(), false, threads);
+	}
+
+	// The same from the sources down among the remaining nodes. All
+	// predecessors of a remaining node are remaining nodes themselves. The
+	// degree of the nodes peeled above is already zero and goes negative here,
+	// so they are not picked up again. These SCCs get the highest indices
+	// once the core is done.
+	std::vector<std::vector<int>> source_levels;
+	for (int node = 0; node < num_nodes; node++) {
+		if (scc_index[node] >= 0)
+			continue;
+		degree[node].store(graph.in_degree(node), std::memory_order_relaxed);
+		if (graph.in_degree(node) == 0)
+			frontier.push_back(node);
+	}
+	while (!frontier.empty()) {
+		for (int node : frontier)
+			scc_index[node] = -2;
+		source_levels.push_back(std::move(frontier));
+		frontier = peel(graph, source_levels.back(), degree.get(), true, threads);
+	}
+
+	// The core that is left (every node has a cycle upstream and downstream)
+	// runs through Tarjan's algorithm. Peeled nodes are marked as already
+	// emitted so the search never enters them.
+	for (int node = 0; node < num_nodes; node++)
+		graph.dfs_index(node) = scc_index[node] == -1 ? -1 : INT_MAX;
+
+	auto component = [&](int *begin, int *end) {
+		for (; begin != end; ++begin)
+			scc_index[*begin] = next_index;
+		next_index++;
+	};
+	TopoSortedSccs<CsrGraph, decltype(component)> sccs(graph, component);
+	sccs.process_all();
+
+	for (auto level = source_levels.rbegin(); level != source_levels.rend(); ++level)
+		for (int node : *level)
+			scc_index[node] = next_index++;
+
+	return next_index;
+}
+
+YOSYS_NAMESPACE_END
@@ -193,6 +193,87 @@ public:
     }
 };
 
+// Compact graph in compressed sparse row form, for large graphs that are
+// built once and traversed many times. Nodes are the integers 0..n-1, the
+// successors and predecessors of each node are stored as ranges of flat
+// arrays. Implements the graph interface used by TopoSortedSccs.
+class CsrGraph {
+public:
+    typedef int node_type;
+
+    struct successor_enumerator {
+        const int *current, *end;
+        bool finished() const { return current == end; }
+        node_type next() {
+            log_assert(!finished());
+            return *current++;
+        }
+    };
+
+    struct node_enumerator {
+        int current, end;
+        bool finished() const { return current == end; }
+        node_type next() {
+            log_assert(!finished());
+            node_type result = current;
+            ++current;
+            return result;
+        }
+    };
+
+private:
+    std::vector<int> succ_offsets, succ_nodes;
+    std::vector<int> pred_offsets, pred_nodes;
+    std::vector<int> indices_;
+
+public:
+    CsrGraph() : succ_offsets(1, 0), pred_offsets(1, 0) {}
+    CsrGraph(int num_nodes, const std::vector<std::pair<int, int>> &edges);
+
+    int num_nodes() const { return GetSize(succ_offsets) - 1; }
+    int num_edges() const { return GetSize(succ_nodes); }
+
+    const int *succ_begin(int node) const { return succ_nodes.data() + succ_offsets[node]; }
+    const int *succ_end(int node) const { return succ_nodes.data() + succ_offsets[node + 1]; }
+    const int *pred_begin(int node) const { return pred_nodes.data() + pred_offsets[node]; }
+    const int *pred_end(int node) const { return pred_nodes.data() + pred_offsets[node + 1]; }
+    int out_degree(int node) const { return succ_offsets[node + 1] - succ_offsets[node]; }
+    int in_degree(int node) const { return pred_offsets[node + 1] - pred_offsets[node]; }
+
+    node_enumerator enumerate_nodes() const {
+        return {0, num_nodes()};
+    }
+
+    successor_enumerator enumerate_successors(int node) const {
+        return {succ_begin(node), succ_end(node)};
+    }
+
+    int &dfs_index(node_type const &node) {
+        return indices_[node];
+    }
+
+    void reset_dfs_indices(int value = -1) {
+        indices_.assign(num_nodes(), value);
+    }
+};
+
+// Group the nodes of an acyclic graph by level: level 0 holds the nodes
+// without predecessors and every other node is one level above its deepest
+// predecessor. Nodes on the same level do not depend on each other, so a
+// caller can process each level in parallel. Levels are computed with up to
+// the given number of threads. Returns false if the graph has a cycle, in
+// which case the nodes on or behind a cycle are missing from all levels.
+bool topo_levels(const CsrGraph &graph, std::vector<std::vector<int>> &levels, int threads = 1);
+
+// Strongly connected components of a graph. Assigns every node the index of
+// its SCC and returns the number of SCCs. Indices are in reverse topological
+// order: an edge between different SCCs always goes from a higher to a lower
+// index. Nodes that cannot be part of a cycle (most nodes of a typical
+// netlist) are first peeled off level by level, using up to the given number
+// of threads, and only the remaining core runs through TopoSortedSccs. A
+// single node SCC may still have a self-loop.
+int csr_sccs(CsrGraph &graph, std::vector<int> &scc_index, int threads = 1);
+
 template<typename G, typename ComponentCallback>
 class TopoSortedSccs
 {
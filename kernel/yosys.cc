@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
+#include "kernel/contenthash.h"
 
 #ifdef YOSYS_ENABLE_READLINE
 #  include <readline/readline.h>
@@ -74,6 +75,10 @@
 #include <signal.h>
 #endif
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <mutex>
+#endif
+
 #include <limits.h>
 #include <errno.h>
 
@@ -81,6 +86,8 @@ YOSYS_NAMESPACE_BEGIN
 
 int autoidx = 1;
 int yosys_xtrace = 0;
+int yosys_threads = 1;
+thread_local int *autoidx_local = nullptr;
 RTLIL::Design *yosys_design = NULL;
 CellTypes yosys_celltypes;
 
@@ -545,6 +552,40 @@ std::string escape_filename_spaces(const std::string& filename)
 	return out;
 }
 
+std::string file_content_key(const std::string &filename)
+{
+	std::ifstream f(filename, std::ifstream::binary);
+	if (f.fail())
+		return std::string();
+
+	ContentHash hasher;
+	hasher.update(filename);
+	char buffer[65536];
+	while (f) {
+		f.read(buffer, sizeof(buffer));
+		hasher.update_bytes(buffer, f.gcount());
+	}
+	if (f.bad())
+		return std::string();
+	return hasher.hexdigest();
+}
+
+bool write_file_atomically(const std::string &filename, const std::function<void(std::ostream&)> &writer)
+{
+	std::string temp_filename = make_temp_file(filename + "_XXXXXX");
+	std::ofstream f(temp_filename, std::ofstream::binary);
+	writer(f);
+	f.close();
+
+	if (f.fail() || rename(temp_filename.c_str(), filename.c_str()) != 0) {
+		int saved_errno = errno;
+		remove(temp_filename.c_str());
+		errno = saved_errno;
+		return false;
+	}
+	return true;
+}
+
 bool already_setup = false;
 
 void yosys_setup()
@@ -565,8 +606,13 @@ void yosys_setup()
 	}
 #endif
 
+	// The other lookups of files next to the executable are deferred until
+	// they are needed, see proc_share_dirname() and proc_abc_executable().
+	// With Python, the share directory is set by the module and is looked up
+	// here, while the interpreter is known to be usable.
+#ifdef WITH_PYTHON
 	init_share_dirname();
-	init_abc_executable_name();
+#endif
 
 #define X(_id) RTLIL::ID::_id = "\\" # _id;
 #include "kernel/constids.inc"
@@ -597,6 +643,7 @@ void yosys_shutdown()
 	delete yosys_design;
 	yosys_design = NULL;
 
+	log_async_end();
 	for (auto f : log_files)
 		if (f != stderr)
 			fclose(f);
@@ -631,6 +678,22 @@ void yosys_shutdown()
 #endif
 }
 
+// NEW_ID may be used from worker threads while IdString concurrent mode is
+// active, in which case the autoidx counter needs to be updated atomically.
+static int next_autoidx()
+{
+	if (autoidx_local != nullptr)
+		return (*autoidx_local)++;
+#ifdef YOSYS_ENABLE_THREADS
+	if (RTLIL::IdString::concurrent_mode()) {
+		static std::mutex autoidx_mutex;
+		std::lock_guard<std::mutex> lock(autoidx_mutex);
+		return autoidx++;
+	}
+#endif
+	return autoidx++;
+}
+
 RTLIL::IdString new_id(std::string file, int line, std::string func)
 {
 #ifdef _WIN32
@@ -645,7 +708,7 @@ RTLIL::IdString new_id(std::string file, int line, std::string func)
 	if (pos != std::string::npos)
 		func = func.substr(pos+1);
 
-	return stringf("$auto$%s:%d:%s$%d", file.c_str(), line, func.c_str(), autoidx++);
+	return stringf("$auto$%s:%d:%s$%d", file.c_str(), line, func.c_str(), next_autoidx());
 }
 
 RTLIL::IdString new_id_suffix(std::string file, int line, std::string func, std::string suffix)
@@ -662,7 +725,43 @@ RTLIL::IdString new_id_suffix(std::string file, int line, std::string func, std:
 	if (pos != std::string::npos)
 		func = func.substr(pos+1);
 
-	return stringf("$auto$%s:%d:%s$%s$%d", file.c_str(), line, func.c_str(), suffix.c_str(), autoidx++);
+	return stringf("$auto$%s:%d:%s$%s$%d", file.c_str(), line, func.c_str(), suffix.c_str(), next_autoidx());
+}
+
+std::string new_id_prefix(std::string file, int line, std::string func)
+{
+#ifdef _WIN32
+	size_t pos = file.find_last_of("/\\");
+#else
+	size_t pos = file.find_last_of('/');
+#endif
+	if (pos != std::string::npos)
+		file = file.substr(pos+1);
+
+	pos = func.find_last_of(':');
+	if (pos != std::string::npos)
+		func = func.substr(pos+1);
+
+	return stringf("$auto$%s:%d:%s$", file.c_str(), line, func.c_str());
+}
+
+RTLIL::IdString new_id_with_prefix(const std::string &prefix)
+{
+	std::string name = prefix;
+	name += std::to_string(next_autoidx());
+	return name;
+}
+
+const char *new_id_site(std::string file, int line, std::string func)
+{
+	// one per call site, kept for the rest of the process as names created
+	// with new_auto_id() refer to it
+	return strdup(new_id_prefix(file, line, func).c_str());
+}
+
+RTLIL::IdString new_id_at(const char *site)
+{
+	return RTLIL::IdString::new_auto_id(site, next_autoidx());
 }
 
 RTLIL::Design *yosys_get_design()
@@ -740,7 +839,7 @@ extern Tcl_Interp *yosys_get_tcl_interp()
 }
 
 struct TclPass : public Pass {
-	TclPass() : Pass("tcl", "execute a TCL script file") { }
+	TclPass() : Pass("tcl", "execute a TCL script file") { keeps_shared_modules(); }
 	void help() override {
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
 		log("\n");
@@ -974,8 +1073,25 @@ void init_abc_executable_name()
 #endif
 }
 
+std::string proc_abc_executable()
+{
+	if (yosys_abc_executable.empty())
+		init_abc_executable_name();
+	return yosys_abc_executable;
+}
+
 std::string proc_share_dirname()
 {
+#ifdef YOSYS_ENABLE_THREADS
+	static std::once_flag init_flag;
+	std::call_once(init_flag, []() {
+		if (yosys_share_dirname.empty())
+			init_share_dirname();
+	});
+#else
+	if (yosys_share_dirname.empty())
+		init_share_dirname();
+#endif
 	if (yosys_share_dirname.empty())
 		log_error("init_share_dirname: unable to determine share/ directory!\n");
 	return yosys_share_dirname;
@@ -1049,6 +1165,8 @@ bool run_frontend(std::string filename, std::string command, RTLIL::Design *desi
 
 	  if (has_extension(filename_trim, ".gz")) {
 	    filename_trim.erase(filename_trim.size() - 3);
+	  } else if (has_extension(filename_trim, ".zst")) {
+	    filename_trim.erase(filename_trim.size() - 4);
 	  }
 
 	  if (has_extension(filename_trim, ".v")) {
@@ -1407,7 +1525,7 @@ struct ShellPass : public Pass {
 
 #if defined(YOSYS_ENABLE_READLINE) || defined(YOSYS_ENABLE_EDITLINE)
 struct HistoryPass : public Pass {
-	HistoryPass() : Pass("history", "show last interactive commands") { }
+	HistoryPass() : Pass("history", "show last interactive commands") { keeps_shared_modules(); }
 	void help() override {
 		log("\n");
 		log("    history\n");
@@ -1431,7 +1549,7 @@ struct HistoryPass : public Pass {
 #endif
 
 struct ScriptCmdPass : public Pass {
-	ScriptCmdPass() : Pass("script", "execute commands from file or wire") { }
+	ScriptCmdPass() : Pass("script", "execute commands from file or wire") { keeps_shared_modules(); }
 	void help() override {
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
 		log("\n");
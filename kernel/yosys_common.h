@@ -34,6 +34,7 @@
 #include <optional>
 #include <stdexcept>
 #include <memory>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 
@@ -160,6 +161,8 @@ using hashlib::dict;
 using hashlib::idict;
 using hashlib::pool;
 using hashlib::mfp;
+using hashlib::flat_dict;
+using hashlib::flat_pool;
 
 // A primitive shared string implementation that does not
 // move its .c_str() when the object is copied or moved.
@@ -318,6 +321,17 @@ bool is_absolute_path(std::string filename);
 void remove_directory(std::string dirname);
 bool create_directory(const std::string& dirname);
 std::string escape_filename_spaces(const std::string& filename);
+// Key for caches of data derived from a file: a hash of the file name and
+// contents, or an empty string if the file can't be read. Unlike the size
+// and modification time it also changes when a file is rewritten within the
+// resolution of the file system timestamps.
+std::string file_content_key(const std::string &filename);
+// Calls writer() on a uniquely named temporary file next to `filename` and
+// then renames it into place, so that other processes (e.g. concurrent runs
+// sharing a cache directory) never read a partially written file, and an
+// interrupted run leaves no truncated file behind. Returns false, with errno
+// set and the temporary file removed, if writing or renaming failed.
+bool write_file_atomically(const std::string &filename, const std::function<void(std::ostream&)> &writer);
 
 template<typename T> int GetSize(const T &obj) { return obj.size(); }
 inline int GetSize(RTLIL::Wire *wire);
@@ -325,13 +339,38 @@ inline int GetSize(RTLIL::Wire *wire);
 extern int autoidx;
 extern int yosys_xtrace;
 
+// Number of threads passes may use for independent work, set with "yosys -j".
+extern int yosys_threads;
+
+// When set, NEW_ID draws indices from this counter instead of autoidx. Workers
+// of Pass::parallel_modules() use this to keep generated names independent of
+// thread scheduling.
+extern thread_local int *autoidx_local;
+
 RTLIL::IdString new_id(std::string file, int line, std::string func);
 RTLIL::IdString new_id_suffix(std::string file, int line, std::string func, std::string suffix);
 
+// For call sites that create many names in a row: NEW_ID_PREFIX formats the
+// part of the name that depends on the call site once, and each call of
+// new_id_with_prefix() returns the name that NEW_ID would return at that site.
+std::string new_id_prefix(std::string file, int line, std::string func);
+RTLIL::IdString new_id_with_prefix(const std::string &prefix);
+
+// NEW_ID formats the call site part of the name once per call site and
+// creates the name with IdString::new_auto_id(), which defers formatting the
+// complete name until its text is used. Most names created by passes like
+// techmap are removed again before that.
+const char *new_id_site(std::string file, int line, std::string func);
+RTLIL::IdString new_id_at(const char *site);
+
 #define NEW_ID \
-	YOSYS_NAMESPACE_PREFIX new_id(__FILE__, __LINE__, __FUNCTION__)
+	YOSYS_NAMESPACE_PREFIX new_id_at([](const char *func) { \
+		static const char *site = YOSYS_NAMESPACE_PREFIX new_id_site(__FILE__, __LINE__, func); \
+		return site; }(__FUNCTION__))
 #define NEW_ID_SUFFIX(suffix) \
 	YOSYS_NAMESPACE_PREFIX new_id_suffix(__FILE__, __LINE__, __FUNCTION__, suffix)
+#define NEW_ID_PREFIX \
+	YOSYS_NAMESPACE_PREFIX new_id_prefix(__FILE__, __LINE__, __FUNCTION__)
 
 // Create a statically allocated IdString object, using for example ID::A or ID($add).
 //
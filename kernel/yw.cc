@@ -103,18 +103,185 @@ static std::vector<IdString> get_path(const json11::Json &json)
 	return result;
 }
 
-ReadWitness::ReadWitness(const std::string &filename) :
-	filename(filename)
+// Splits a JSON document into the values of the top-level object and the
+// items of the "steps" array, without parsing the whole document at once.
+// The values are then parsed separately with json11.
+struct ReadWitness::Reader
+{
+	std::string filename;
+	std::ifstream f;
+	std::streambuf *buf;
+	// 0: before the first step, 1: between steps, 2: after the last step
+	int steps_state = 2;
+
+	Reader(const std::string &filename) : filename(filename), f(filename.c_str(), std::ios::binary), buf(f.rdbuf()) { }
+
+	[[noreturn]] void syntax_error()
+	{
+		log_error("Failed to parse `%s`: JSON syntax error\n", filename.c_str());
+	}
+
+	int peek()
+	{
+		int c = buf->sgetc();
+		while (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+			c = buf->snextc();
+		return c;
+	}
+
+	void expect(char c)
+	{
+		if (peek() != c)
+			syntax_error();
+		buf->sbumpc();
+	}
+
+	// appends the text of a string, including the quotes and escapes
+	void scan_string(std::string *text)
+	{
+		expect('"');
+		if (text)
+			*text += '"';
+		while (true) {
+			int c = buf->sbumpc();
+			if (c == EOF)
+				syntax_error();
+			if (text)
+				*text += c;
+			if (c == '"')
+				return;
+			if (c == '\\') {
+				c = buf->sbumpc();
+				if (c == EOF)
+					syntax_error();
+				if (text)
+					*text += c;
+			}
+		}
+	}
+
+	// appends the text of the next value, or skips it for a null `text`
+	void scan_value(std::string *text)
+	{
+		int depth = 0;
+		do {
+			int c = peek();
+			if (c == EOF)
+				syntax_error();
+			if (c == '"') {
+				scan_string(text);
+				continue;
+			}
+			if (c == '{' || c == '[')
+				depth++;
+			else if (c == '}' || c == ']') {
+				if (depth == 0)
+					syntax_error();
+				depth--;
+			} else if (depth == 0) {
+				// a number or literal at the top level
+				while (c != EOF && c != ',' && c != '}' && c != ']' && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+					if (text)
+						*text += c;
+					c = buf->snextc();
+				}
+				return;
+			}
+			if (text)
+				*text += c;
+			buf->sbumpc();
+		} while (depth > 0);
+	}
+
+	json11::Json parse_value()
+	{
+		std::string text, err;
+		scan_value(&text);
+		json11::Json json = json11::Json::parse(text, err);
+		if (!err.empty())
+			log_error("Failed to parse `%s`: %s\n", filename.c_str(), err.c_str());
+		return json;
+	}
+
+	std::string parse_key()
+	{
+		std::string text, err;
+		scan_string(&text);
+		expect(':');
+		return json11::Json::parse(text, err).string_value();
+	}
+
+	// Reads the members of the top-level object other than "steps". Leaves
+	// the stream at the start of the steps when they follow the other
+	// members, otherwise the file is opened again once they are all read.
+	json11::Json::object read_header()
+	{
+		json11::Json::object header;
+		std::streampos steps_pos = -1;
+
+		expect('{');
+		if (peek() != '}') {
+			while (true) {
+				std::string key = parse_key();
+				if (key == "steps") {
+					if (header.count("format") && header.count("clocks") && header.count("signals")) {
+						start_steps();
+						return header;
+					}
+					steps_pos = buf->pubseekoff(0, std::ios::cur, std::ios::in);
+					scan_value(nullptr);
+				} else
+					header[key] = parse_value();
+				if (peek() == '}')
+					break;
+				expect(',');
+			}
+		}
+
+		if (steps_pos != std::streampos(-1)) {
+			if (buf->pubseekpos(steps_pos, std::ios::in) != steps_pos)
+				log_error("Failed to parse `%s`: Cannot seek to the steps\n", filename.c_str());
+			start_steps();
+		}
+		return header;
+	}
+
+	void start_steps()
+	{
+		expect('[');
+		steps_state = 0;
+	}
+
+	bool next_step(json11::Json &json)
+	{
+		if (steps_state == 2)
+			return false;
+		if (peek() == ']') {
+			buf->sbumpc();
+			steps_state = 2;
+			return false;
+		}
+		if (steps_state == 1)
+			expect(',');
+		steps_state = 1;
+		json = parse_value();
+		return true;
+	}
+};
+
+static std::ifstream &check_open(std::ifstream &f, const std::string &filename)
 {
-	std::ifstream f(filename.c_str());
 	if (f.fail() || GetSize(filename) == 0)
 		log_error("Cannot open file `%s`\n", filename.c_str());
-	std::stringstream buf;
-	buf << f.rdbuf();
-	std::string err;
-	json11::Json json = json11::Json::parse(buf.str(), err);
-	if (!err.empty())
-		log_error("Failed to parse `%s`: %s\n", filename.c_str(), err.c_str());
+	return f;
+}
+
+ReadWitness::ReadWitness(const std::string &filename, bool stream) :
+	filename(filename)
+{
+	reader.reset(new Reader(filename));
+	check_open(reader->f, filename);
+	json11::Json json(reader->read_header());
 
 	std::string format = json["format"].string_value();
 
@@ -165,24 +332,43 @@ ReadWitness::ReadWitness(const std::string &filename) :
 		signals.push_back(signal);
 	}
 
-	for (auto &step_json : json["steps"].array_items()) {
+	if (!stream) {
 		Step step;
-		if (!step_json["bits"].is_string())
-			log_error("Failed to parse `%s`: Expected string as bits value for step %d\n", filename.c_str(), GetSize(steps));
-		step.bits = step_json["bits"].string_value();
-		for (char c : step.bits) {
-			if (c != '0' && c != '1' && c != 'x' && c != '?')
-				log_error("Failed to parse `%s`: Invalid bit '%c' value for step %d\n", filename.c_str(), c, GetSize(steps));
-		}
-		steps.push_back(step);
+		while (next_step(step))
+			steps.push_back(std::move(step));
+		reader.reset();
 	}
 }
 
+ReadWitness::~ReadWitness()
+{
+}
+
+bool ReadWitness::next_step(Step &step)
+{
+	json11::Json step_json;
+	if (reader == nullptr || !reader->next_step(step_json))
+		return false;
+	if (!step_json["bits"].is_string())
+		log_error("Failed to parse `%s`: Expected string as bits value for step %d\n", filename.c_str(), steps_read_);
+	step.bits = step_json["bits"].string_value();
+	for (char c : step.bits) {
+		if (c != '0' && c != '1' && c != 'x' && c != '?')
+			log_error("Failed to parse `%s`: Invalid bit '%c' value for step %d\n", filename.c_str(), c, steps_read_);
+	}
+	steps_read_++;
+	return true;
+}
+
 RTLIL::Const ReadWitness::get_bits(int t, int bits_offset, int width) const
 {
 	log_assert(t >= 0 && t < GetSize(steps));
+	return get_bits(steps[t], bits_offset, width);
+}
 
-	const std::string &bits = steps[t].bits;
+RTLIL::Const ReadWitness::get_bits(const Step &step, int bits_offset, int width)
+{
+	const std::string &bits = step.bits;
 
 	RTLIL::Const result(State::Sa, width);
 	result.bits().reserve(width);
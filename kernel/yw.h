@@ -92,11 +92,27 @@ struct ReadWitness
 	std::string filename;
 	std::vector<Clock> clocks;
 	std::vector<Signal> signals;
+	// all steps, unless the file is read step by step
 	std::vector<Step> steps;
 
-	ReadWitness(const std::string &filename);
+	// Reads the header (format, clocks and signals) and, unless `stream` is
+	// set, all steps. With `stream`, the steps are read one at a time with
+	// next_step(), so that long traces never have to be kept in memory.
+	ReadWitness(const std::string &filename, bool stream = false);
+	~ReadWitness();
+
+	// Reads the next step, returns false after the last one.
+	bool next_step(Step &step);
+	// the number of steps read so far
+	int steps_read() const { return steps_read_; }
 
 	RTLIL::Const get_bits(int t, int bits_offset, int width) const;
+	static RTLIL::Const get_bits(const Step &step, int bits_offset, int width);
+
+private:
+	struct Reader;
+	std::unique_ptr<Reader> reader;
+	int steps_read_ = 0;
 };
 
 template<typename D, typename T>
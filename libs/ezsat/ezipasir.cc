@@ -0,0 +1,150 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "ezipasir.h"
+
+#include <chrono>
+
+// the IPASIR interface, see https://github.com/biotomas/ipasir
+extern "C" {
+	const char *ipasir_signature();
+	void *ipasir_init();
+	void ipasir_release(void *solver);
+	void ipasir_add(void *solver, int lit_or_zero);
+	void ipasir_assume(void *solver, int lit);
+	int ipasir_solve(void *solver);
+	int ipasir_val(void *solver, int lit);
+	void ipasir_set_terminate(void *solver, void *data, int (*terminate)(void *data));
+}
+
+static double ezipasir_now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ezIpasir::ezIpasir()
+{
+	ipasirSolver = nullptr;
+	ipasirVars = 0;
+	foundContradiction = false;
+	terminateTime = 0;
+}
+
+ezIpasir::~ezIpasir()
+{
+	if (ipasirSolver != nullptr)
+		ipasir_release(ipasirSolver);
+}
+
+void ezIpasir::clear()
+{
+	if (ipasirSolver != nullptr) {
+		ipasir_release(ipasirSolver);
+		ipasirSolver = nullptr;
+	}
+	ipasirVars = 0;
+	foundContradiction = false;
+	ezSAT::clear();
+}
+
+const char *ezIpasir::signature()
+{
+	return ipasir_signature();
+}
+
+int ezIpasir::terminateCallback(void *data)
+{
+	ezIpasir *that = (ezIpasir*)data;
+	return that->terminateTime > 0 && ezipasir_now() > that->terminateTime;
+}
+
+bool ezIpasir::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
+{
+	preSolverCallback();
+
+	solverTimoutStatus = false;
+
+	if (foundContradiction) {
+		consumeCnf();
+		return false;
+	}
+
+	std::vector<int> extraClauses, modelIdx;
+
+	for (auto id : assumptions)
+		extraClauses.push_back(bind(id));
+	for (auto id : modelExpressions)
+		modelIdx.push_back(bind(id));
+
+	if (ipasirSolver == nullptr) {
+		ipasirSolver = ipasir_init();
+		ipasir_set_terminate(ipasirSolver, this, terminateCallback);
+	}
+
+	std::vector<std::vector<int>> cnf;
+	consumeCnf(cnf);
+
+	for (auto &clause : cnf) {
+		for (auto idx : clause)
+			ipasir_add(ipasirSolver, idx);
+		ipasir_add(ipasirSolver, 0);
+	}
+
+	// make sure that the solver knows all variables, also those that are only used in the model
+	if (ipasirVars < numCnfVariables()) {
+		ipasirVars = numCnfVariables();
+		ipasir_add(ipasirSolver, ipasirVars);
+		ipasir_add(ipasirSolver, -ipasirVars);
+		ipasir_add(ipasirSolver, 0);
+	}
+
+	for (auto idx : extraClauses)
+		ipasir_assume(ipasirSolver, idx);
+
+	terminateTime = solverTimeout > 0 ? ezipasir_now() + solverTimeout : 0;
+	int result = ipasir_solve(ipasirSolver);
+	terminateTime = 0;
+
+	if (result == 0) {
+		solverTimoutStatus = true;
+		return false;
+	}
+
+	if (result != 10) {
+		if (extraClauses.empty())
+			foundContradiction = true;
+		return false;
+	}
+
+	modelValues.clear();
+	modelValues.resize(modelIdx.size());
+
+	for (size_t i = 0; i < modelIdx.size(); i++)
+	{
+		int idx = modelIdx[i];
+		bool refvalue = true;
+
+		if (idx < 0)
+			idx = -idx, refvalue = false;
+
+		modelValues[i] = (ipasir_val(ipasirSolver, idx) > 0) == refvalue;
+	}
+
+	return true;
+}
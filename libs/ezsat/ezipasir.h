@@ -0,0 +1,47 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef EZIPASIR_H
+#define EZIPASIR_H
+
+#include "ezsat.h"
+
+// A solver backend for any incremental SAT solver that implements the IPASIR interface, such as CaDiCaL. The solver
+// library must be linked in, ezipasir.cc only declares the interface.
+
+class ezIpasir : public ezSAT
+{
+private:
+	void *ipasirSolver;
+	int ipasirVars;
+	bool foundContradiction;
+	double terminateTime;
+
+	static int terminateCallback(void *data);
+
+public:
+	ezIpasir();
+	virtual ~ezIpasir();
+	virtual void clear();
+	virtual bool solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions);
+
+	static const char *signature();
+};
+
+#endif
@@ -31,7 +31,15 @@
 #include <stdint.h>
 #include <cinttypes>
 
-#if !defined(_WIN32) && !defined(__wasm)
+// The alarm signal exists once per process, so with threads (that may run
+// several solvers at the same time) a watchdog thread keeps the timeout.
+#if defined(YOSYS_ENABLE_THREADS)
+#  include <chrono>
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#  define HAS_WATCHDOG
+#elif !defined(_WIN32) && !defined(__wasm)
 #  include <csignal>
 #  include <unistd.h>
 #  define HAS_ALARM
@@ -201,8 +209,37 @@ contradiction:
 	}
 #endif
 
+#if defined(HAS_WATCHDOG)
+	std::mutex watchdog_mutex;
+	std::condition_variable watchdog_cv;
+	bool watchdog_done = false;
+	std::thread watchdog;
+
+	if (solverTimeout > 0) {
+		minisatSolver->clearInterrupt();
+		watchdog = std::thread([&]() {
+			std::unique_lock<std::mutex> lock(watchdog_mutex);
+			if (!watchdog_cv.wait_for(lock, std::chrono::seconds(solverTimeout), [&]() { return watchdog_done; })) {
+				minisatSolver->interrupt();
+				solverTimoutStatus = true;
+			}
+		});
+	}
+#endif
+
 	bool foundSolution = minisatSolver->solve(assumps);
 
+#if defined(HAS_WATCHDOG)
+	if (watchdog.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(watchdog_mutex);
+			watchdog_done = true;
+		}
+		watchdog_cv.notify_one();
+		watchdog.join();
+	}
+#endif
+
 #if defined(HAS_ALARM)
 	if (solverTimeout > 0) {
 		if (alarmHandlerTimeout == 0)
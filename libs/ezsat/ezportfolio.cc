@@ -0,0 +1,198 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// needed for MiniSAT headers (see Minisat Makefile)
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include "ezportfolio.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "../minisat/Solver.h"
+
+// number of conflicts the first configuration may use before the other configurations are started
+#define EZPORTFOLIO_SOLO_CONFLICTS 2000
+
+ezPortfolio::ezPortfolio(int numConfigurations)
+{
+	solvers.resize(numConfigurations < 1 ? 1 : numConfigurations, nullptr);
+	foundContradiction = false;
+}
+
+ezPortfolio::~ezPortfolio()
+{
+	for (auto solver : solvers)
+		delete solver;
+}
+
+void ezPortfolio::clear()
+{
+	for (auto &solver : solvers) {
+		delete solver;
+		solver = nullptr;
+	}
+	foundContradiction = false;
+	ezSAT::clear();
+}
+
+void ezPortfolio::configure(Minisat::Solver *solver, int index)
+{
+	solver->verbosity = 0;
+	switch (index % 4) {
+	case 0:
+		// MiniSAT defaults
+		break;
+	case 1:
+		// geometric restarts, randomized initial activities
+		solver->luby_restart = false;
+		solver->rnd_init_act = true;
+		break;
+	case 2:
+		// no phase saving, some random decisions
+		solver->phase_saving = 0;
+		solver->random_var_freq = 0.02;
+		break;
+	case 3:
+		// faster activity decay, basic clause minimization, random polarities
+		solver->var_decay = 0.85;
+		solver->ccmin_mode = 1;
+		solver->rnd_pol = true;
+		break;
+	}
+	solver->random_seed = 91648253 + 7919 * index;
+}
+
+bool ezPortfolio::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
+{
+	preSolverCallback();
+
+	solverTimoutStatus = false;
+
+	if (foundContradiction) {
+		consumeCnf();
+		return false;
+	}
+
+	std::vector<int> extraClauses, modelIdx;
+
+	for (auto id : assumptions)
+		extraClauses.push_back(bind(id));
+	for (auto id : modelExpressions)
+		modelIdx.push_back(bind(id));
+
+	std::vector<std::vector<int>> cnf;
+	consumeCnf(cnf);
+
+	for (int i = 0; i < int(solvers.size()); i++)
+		if (solvers[i] == nullptr) {
+			solvers[i] = new Minisat::Solver;
+			configure(solvers[i], i);
+		}
+
+	for (auto solver : solvers)
+		while (solver->nVars() < numCnfVariables())
+			solver->newVar();
+
+	for (auto solver : solvers)
+		for (auto &clause : cnf) {
+			Minisat::vec<Minisat::Lit> ps;
+			for (auto idx : clause)
+				ps.push(Minisat::mkLit(idx > 0 ? idx-1 : -idx-1, idx < 0));
+			if (!solver->addClause(ps)) {
+				foundContradiction = true;
+				return false;
+			}
+		}
+
+	Minisat::vec<Minisat::Lit> assumps;
+	for (auto idx : extraClauses)
+		assumps.push(Minisat::mkLit(idx > 0 ? idx-1 : -idx-1, idx < 0));
+
+	// try the first configuration on its own first
+	int winner = 0;
+	solvers[0]->setConfBudget(EZPORTFOLIO_SOLO_CONFLICTS);
+	Minisat::lbool result = solvers[0]->solveLimited(assumps);
+	solvers[0]->budgetOff();
+
+	if (result == Minisat::l_Undef)
+	{
+		std::mutex mutex;
+		std::condition_variable done;
+		winner = -1;
+
+		std::vector<std::thread> threads;
+		for (int i = 0; i < int(solvers.size()); i++)
+			threads.emplace_back([&, i]() {
+				Minisat::lbool r = solvers[i]->solveLimited(assumps);
+				std::lock_guard<std::mutex> lock(mutex);
+				if (winner < 0 && r != Minisat::l_Undef) {
+					winner = i, result = r;
+					for (auto solver : solvers)
+						solver->interrupt();
+					done.notify_all();
+				}
+			});
+
+		if (solverTimeout > 0) {
+			std::unique_lock<std::mutex> lock(mutex);
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(solverTimeout);
+			if (!done.wait_until(lock, deadline, [&]() { return winner >= 0; }))
+				for (auto solver : solvers)
+					solver->interrupt();
+		}
+
+		for (auto &thread : threads)
+			thread.join();
+		for (auto solver : solvers)
+			solver->clearInterrupt();
+
+		if (winner < 0) {
+			solverTimoutStatus = true;
+			return false;
+		}
+	}
+
+	if (result != Minisat::l_True)
+		return false;
+
+	modelValues.clear();
+	modelValues.resize(modelIdx.size());
+
+	for (size_t i = 0; i < modelIdx.size(); i++)
+	{
+		int idx = modelIdx[i];
+		bool refvalue = true;
+
+		if (idx < 0)
+			idx = -idx, refvalue = false;
+
+		Minisat::lbool value = solvers[winner]->modelValue(idx-1);
+		modelValues[i] = (value == Minisat::lbool(refvalue));
+	}
+
+	return true;
+}
@@ -56,6 +56,8 @@ ezSAT::ezSAT()
 	solverTimeout = 0;
 	solverTimoutStatus = false;
 
+	rehash_expressions();
+
 	literal("CONST_TRUE");
 	literal("CONST_FALSE");
 
@@ -202,15 +204,26 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 		abort();
 	}
 
-	std::pair<OpId, std::vector<int>> myExpr(op, myArgs);
 	int id = 0;
+	int numArgs = myArgs.size();
+	unsigned int mask = expressionsTable.size() - 1;
+	unsigned int slot = hash_expression(op, myArgs.data(), numArgs) & mask;
+
+	for (; expressionsTable[slot] != 0; slot = (slot + 1) & mask) {
+		const Expression &expr = expressions[expressionsTable[slot] - 1];
+		if (expr.op == op && expr.numArgs == numArgs && std::equal(myArgs.begin(), myArgs.end(), expressionArgs.begin() + expr.argsBegin)) {
+			id = -expressionsTable[slot];
+			break;
+		}
+	}
 
-	if (expressionsCache.count(myExpr) > 0) {
-		id = expressionsCache.at(myExpr);
-	} else {
-		id = -(int(expressions.size()) + 1);
-		expressionsCache[myExpr] = id;
-		expressions.push_back(myExpr);
+	if (id == 0) {
+		expressions.push_back(Expression{op, int(expressionArgs.size()), numArgs});
+		expressionArgs.insert(expressionArgs.end(), myArgs.begin(), myArgs.end());
+		expressionsTable[slot] = expressions.size();
+		id = -int(expressions.size());
+		if (2 * expressions.size() > expressionsTable.size())
+			rehash_expressions();
 	}
 
 	if (xorRemovedOddTrues)
@@ -222,6 +235,33 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 	return id;
 }
 
+unsigned int ezSAT::hash_expression(OpId op, const int *args, int numArgs)
+{
+	unsigned int h = 5381 + op;
+	for (int i = 0; i < numArgs; i++)
+		h = (h * 33) ^ args[i];
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	return h;
+}
+
+void ezSAT::rehash_expressions()
+{
+	std::vector<int> table(expressionsTable.empty() ? 1024 : 2 * expressionsTable.size());
+	unsigned int mask = table.size() - 1;
+
+	for (int i = 0; i < int(expressions.size()); i++) {
+		const Expression &expr = expressions[i];
+		unsigned int slot = hash_expression(expr.op, expressionArgs.data() + expr.argsBegin, expr.numArgs) & mask;
+		while (table[slot] != 0)
+			slot = (slot + 1) & mask;
+		table[slot] = i + 1;
+	}
+
+	expressionsTable.swap(table);
+}
+
 void ezSAT::lookup_literal(int id, std::string &name) const
 {
 	assert(0 < id && id <= int(literals.size()));
@@ -237,15 +277,16 @@ const std::string &ezSAT::lookup_literal(int id) const
 void ezSAT::lookup_expression(int id, OpId &op, std::vector<int> &args) const
 {
 	assert(0 < -id && -id <= int(expressions.size()));
-	op = expressions[-id - 1].first;
-	args = expressions[-id - 1].second;
+	const Expression &expr = expressions[-id - 1];
+	op = expr.op;
+	args.assign(expressionArgs.begin() + expr.argsBegin, expressionArgs.begin() + expr.argsBegin + expr.numArgs);
 }
 
-const std::vector<int> &ezSAT::lookup_expression(int id, OpId &op) const
+std::vector<int> ezSAT::lookup_expression(int id, OpId &op) const
 {
-	assert(0 < -id && -id <= int(expressions.size()));
-	op = expressions[-id - 1].first;
-	return expressions[-id - 1].second;
+	std::vector<int> args;
+	lookup_expression(id, op, args);
+	return args;
 }
 
 int ezSAT::parse_string(const std::string &)
@@ -543,7 +584,7 @@ std::string ezSAT::cnfLiteralInfo(int idx) const
 	return "<unnamed>";
 }
 
-int ezSAT::bind(int id, bool auto_freeze)
+int ezSAT::bind_enter(int id, bool auto_freeze)
 {
 	addhash(__LINE__);
 	addhash(id);
@@ -573,71 +614,107 @@ int ezSAT::bind(int id, bool auto_freeze)
 	{
 		cnfExpressionVariables[-id-1] = 0;
 
-		// this will recursively call bind(id). within the recursion
+		// this will call bind(id) in a nested loop. within that loop
 		// the cnf is pre-set to 0. an idx is allocated there, then it
 		// is frozen, then it returns here with the new idx already set.
 		if (auto_freeze)
 			freeze(id);
 	}
 
-	if (cnfExpressionVariables[-id-1] == 0)
-	{
-		OpId op;
-		std::vector<int> args;
-		lookup_expression(id, op, args);
-		int idx = 0;
-
-		if (op == OpXor) {
-			while (args.size() > 1) {
-				std::vector<int> newArgs;
-				for (int i = 0; i < int(args.size()); i += 2)
-					if (i+1 == int(args.size())) {
-						newArgs.push_back(args[i]);
-					} else {
-						int sub1 = AND(args[i], NOT(args[i+1]));
-						int sub2 = AND(NOT(args[i]), args[i+1]);
-						newArgs.push_back(OR(sub1, sub2));
-					}
-				args.swap(newArgs);
-			}
-			idx = bind(args.at(0), false);
-			goto assign_idx;
-		}
+	if (cnfExpressionVariables[-id-1] != 0)
+		return cnfExpressionVariables[-id-1];
 
-		if (op == OpIFF) {
-			std::vector<int> invArgs;
-			for (auto arg : args)
-				invArgs.push_back(NOT(arg));
-			int sub1 = expression(OpAnd, args);
-			int sub2 = expression(OpAnd, invArgs);
-			idx = bind(OR(sub1, sub2), false);
-			goto assign_idx;
+	// XOR, IFF and ITE are rewritten to AND/OR expressions, and the idx of
+	// the rewritten expression is used for this one (the "delegate").
+	const Expression &expr = expressions[-id-1];
+	int delegate = 0;
+
+	if (expr.op == OpXor) {
+		std::vector<int> args(expressionArgs.begin() + expr.argsBegin, expressionArgs.begin() + expr.argsBegin + expr.numArgs);
+		while (args.size() > 1) {
+			std::vector<int> newArgs;
+			for (int i = 0; i < int(args.size()); i += 2)
+				if (i+1 == int(args.size())) {
+					newArgs.push_back(args[i]);
+				} else {
+					int sub1 = AND(args[i], NOT(args[i+1]));
+					int sub2 = AND(NOT(args[i]), args[i+1]);
+					newArgs.push_back(OR(sub1, sub2));
+				}
+			args.swap(newArgs);
 		}
+		delegate = args.at(0);
+	}
+	else if (expr.op == OpIFF) {
+		std::vector<int> args(expressionArgs.begin() + expr.argsBegin, expressionArgs.begin() + expr.argsBegin + expr.numArgs);
+		std::vector<int> invArgs;
+		for (auto arg : args)
+			invArgs.push_back(NOT(arg));
+		int sub1 = expression(OpAnd, args);
+		int sub2 = expression(OpAnd, invArgs);
+		delegate = OR(sub1, sub2);
+	}
+	else if (expr.op == OpITE) {
+		int s = expressionArgs[expr.argsBegin], a = expressionArgs[expr.argsBegin+1], b = expressionArgs[expr.argsBegin+2];
+		int sub1 = AND(s, a);
+		int sub2 = AND(NOT(s), b);
+		delegate = OR(sub1, sub2);
+	}
 
-		if (op == OpITE) {
-			int sub1 = AND(args[0], args[1]);
-			int sub2 = AND(NOT(args[0]), args[2]);
-			idx = bind(OR(sub1, sub2), false);
-			goto assign_idx;
-		}
+	bindStack.push_back(BindFrame{id, delegate, int(bindArgs.size())});
+	return 0;
+}
 
-		for (int i = 0; i < int(args.size()); i++)
-			args[i] = bind(args[i], false);
+int ezSAT::bind(int id, bool auto_freeze)
+{
+	int base = bindStack.size();
+	int idx = bind_enter(id, auto_freeze);
 
-		switch (op)
-		{
-			case OpNot: idx = bind_cnf_not(args); break;
-			case OpAnd: idx = bind_cnf_and(args); break;
-			case OpOr:  idx = bind_cnf_or(args);  break;
-			default: abort();
+	if (idx != 0)
+		return idx;
+
+	// the arguments of the expression on top of the stack are bound from left
+	// to right, so the variables and clauses are created in the same order as
+	// by a recursive depth-first traversal.
+	while (int(bindStack.size()) > base)
+	{
+		const BindFrame &frame = bindStack.back();
+		int frameId = frame.id, delegate = frame.delegate, boundBegin = frame.boundBegin;
+		const Expression &expr = expressions[-frameId-1];
+		int numArgs = delegate != 0 ? 1 : expr.numArgs;
+		int numBound = int(bindArgs.size()) - boundBegin;
+
+		if (numBound < numArgs) {
+			int arg = delegate != 0 ? delegate : expressionArgs[expr.argsBegin + numBound];
+			idx = bind_enter(arg, false);
+			if (idx != 0)
+				bindArgs.push_back(idx);
+			continue;
+		}
+
+		if (delegate != 0) {
+			idx = bindArgs[boundBegin];
+		} else {
+			std::vector<int> args(bindArgs.begin() + boundBegin, bindArgs.end());
+			switch (expr.op)
+			{
+				case OpNot: idx = bind_cnf_not(args); break;
+				case OpAnd: idx = bind_cnf_and(args); break;
+				case OpOr:  idx = bind_cnf_or(args);  break;
+				default: abort();
+			}
 		}
 
-	assign_idx:
 		assert(idx != 0);
-		cnfExpressionVariables[-id-1] = idx;
+		cnfExpressionVariables[-frameId-1] = idx;
+
+		bindStack.pop_back();
+		bindArgs.resize(boundBegin);
+		if (int(bindStack.size()) > base)
+			bindArgs.push_back(idx);
 	}
 
-	return cnfExpressionVariables[-id-1];
+	return idx;
 }
 
 void ezSAT::consumeCnf()
@@ -1309,13 +1386,18 @@ void ezSAT::printInternalState(FILE *f) const
 	for (int i = 0; i < int(literals.size()); i++)
 		fprintf(f, "    %d: `%s'\n", i+1, literals[i].c_str());
 
-	fprintf(f, "expressionsCache:\n");
-	for (auto &it : expressionsCache)
-		fprintf(f, "    `%s' -> %d\n", expression2str(it.first).c_str(), it.second);
+	fprintf(f, "expressionsTable (size=%d):\n", int(expressionsTable.size()));
+	for (int i = 0; i < int(expressionsTable.size()); i++)
+		if (expressionsTable[i] != 0)
+			fprintf(f, "    %d: %d\n", i, -expressionsTable[i]);
 
 	fprintf(f, "expressions:\n");
-	for (int i = 0; i < int(expressions.size()); i++)
-		fprintf(f, "    %d: `%s'\n", -i-1, expression2str(expressions[i]).c_str());
+	for (int i = 0; i < int(expressions.size()); i++) {
+		OpId op;
+		std::vector<int> args;
+		lookup_expression(-i-1, op, args);
+		fprintf(f, "    %d: `%s'\n", -i-1, expression2str(std::make_pair(op, args)).c_str());
+	}
 
 	fprintf(f, "cnfVariables (count=%d):\n", cnfVariableCount);
 	for (int i = 0; i < int(cnfLiteralVariables.size()); i++)
@@ -57,8 +57,19 @@ private:
 	std::map<std::string, int> literalsCache;
 	std::vector<std::string> literals;
 
-	std::map<std::pair<OpId, std::vector<int>>, int> expressionsCache;
-	std::vector<std::pair<OpId, std::vector<int>>> expressions;
+	// expression nodes are stored flat: the arguments of all expressions are
+	// kept in one arena, and the unique table is an open-addressing hash table
+	// of expression indices (plus one, zero marks an empty slot).
+	struct Expression {
+		OpId op;
+		int argsBegin, numArgs;
+	};
+	std::vector<Expression> expressions;
+	std::vector<int> expressionArgs;
+	std::vector<int> expressionsTable;
+
+	static unsigned int hash_expression(OpId op, const int *args, int numArgs);
+	void rehash_expressions();
 
 	bool cnfConsumed;
 	int cnfVariableCount, cnfClausesCount;
@@ -69,6 +80,15 @@ private:
 	void add_clause(const std::vector<int> &args, bool argsPolarity, int a = 0, int b = 0, int c = 0);
 	void add_clause(int a, int b = 0, int c = 0);
 
+	// explicit stack for bind(), so that deep expressions do not overflow
+	// the call stack. nested calls (via freeze()) push above their base.
+	struct BindFrame {
+		int id, delegate, boundBegin;
+	};
+	std::vector<BindFrame> bindStack;
+	std::vector<int> bindArgs;
+	int bind_enter(int id, bool auto_freeze);
+
 	int bind_cnf_not(const std::vector<int> &args);
 	int bind_cnf_and(const std::vector<int> &args);
 	int bind_cnf_or(const std::vector<int> &args);
@@ -106,7 +126,7 @@ public:
 	const std::string &lookup_literal(int id) const;
 
 	void lookup_expression(int id, OpId &op, std::vector<int> &args) const;
-	const std::vector<int> &lookup_expression(int id, OpId &op) const;
+	std::vector<int> lookup_expression(int id, OpId &op) const;
 
 	int parse_string(const std::string &text);
 	std::string to_string(int id) const;
@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <mutex>
 #include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -33,6 +34,12 @@
 #  define my_printf printf
 #endif
 
+#if !defined(_YOSYS_) || defined(YOSYS_ENABLE_THREADS)
+#  define SUBCIRCUIT_THREADS
+#  include <atomic>
+#  include <thread>
+#endif
+
 using namespace SubCircuit;
 
 #ifndef _YOSYS_
@@ -296,6 +303,7 @@ class SubCircuit::SolverWorker
 		Graph graph;
 		adjMatrix_t adjMatrix;
 		std::vector<bool> usedNodes;
+		std::map<std::string, int> typeCount;
 	};
 
 	static void printAdjMatrix(const adjMatrix_t &matrix)
@@ -657,6 +665,7 @@ class SubCircuit::SolverWorker
 		std::map<DiEdge, int> edgeTypesMap;
 		std::vector<DiEdge> edgeTypes;
 		std::map<std::pair<int, int>, bool> compareCache;
+		std::mutex compareMutex;
 
 		void add(const Graph &graph, adjMatrix_t &adjMatrix, const std::string &graphId, Solver *userSolver)
 		{
@@ -685,6 +694,7 @@ class SubCircuit::SolverWorker
 				const std::map<std::string, std::set<std::map<std::string, std::string>>> &swapPermutations)
 		{
 			std::pair<int, int> key(needleEdge, haystackEdge);
+			std::lock_guard<std::mutex> lock(compareMutex);
 			if (!compareCache.count(key))
 				compareCache[key] = edgeTypes.at(needleEdge).compare(edgeTypes.at(haystackEdge), swapPorts, swapPermutations);
 			return compareCache[key];
@@ -718,9 +728,49 @@ class SubCircuit::SolverWorker
 	std::map<std::string, std::set<std::map<std::string, std::string>>> swapPermutations;
 	DiCache diCache;
 	bool verbose;
+	int threads;
+
+	// while the search is split over threads, the user callbacks and the
+	// overlap history are only touched with this mutex held
+	mutable std::mutex userMutex;
+	bool inParallel;
 
 	// main solver functions
 
+	bool userCompareNodes(const GraphData &needle, const Graph::Node &nn, const GraphData &haystack, const Graph::Node &hn, const std::map<std::string, std::string> &portMapping) const
+	{
+		std::unique_lock<std::mutex> lock(userMutex, std::defer_lock);
+		if (inParallel)
+			lock.lock();
+		return userSolver->userCompareNodes(needle.graphId, nn.nodeId, nn.userData, haystack.graphId, hn.nodeId, hn.userData, portMapping);
+	}
+
+	static void countTypes(GraphData &gd)
+	{
+		gd.typeCount.clear();
+		for (const auto &node : gd.graph.nodes)
+			gd.typeCount[node.typeId]++;
+	}
+
+	// every needle node is mapped to a different haystack node, so there can
+	// only be a match if the haystack has enough nodes of compatible types
+	bool checkTypeCount(const GraphData &needle, const GraphData &haystack) const
+	{
+		for (const auto &it : needle.typeCount)
+		{
+			int available = 0;
+			if (haystack.typeCount.count(it.first) > 0)
+				available += haystack.typeCount.at(it.first);
+			if (compatibleTypes.count(it.first) > 0)
+				for (const std::string &compatibleTypeId : compatibleTypes.at(it.first))
+					if (haystack.typeCount.count(compatibleTypeId) > 0)
+						available += haystack.typeCount.at(compatibleTypeId);
+			if (available < it.second)
+				return false;
+		}
+		return true;
+	}
+
 	bool matchNodePorts(const Graph &needle, int needleNodeIdx, const Graph &haystack, int haystackNodeIdx, const std::map<std::string, std::string> &swaps) const
 	{
 		const Graph::Node &nn = needle.nodes[needleNodeIdx];
@@ -802,7 +852,7 @@ class SubCircuit::SolverWorker
 		if (swapPorts.count(needle.graph.nodes[needleNodeIdx].typeId) == 0)
 		{
 			if (matchNodePorts(needle.graph, needleNodeIdx, haystack.graph, haystackNodeIdx, currentCandidate) &&
-					userSolver->userCompareNodes(needle.graphId, nn.nodeId, nn.userData, haystack.graphId, hn.nodeId, hn.userData, currentCandidate))
+					userCompareNodes(needle, nn, haystack, hn, currentCandidate))
 				return true;
 
 			if (swapPermutations.count(needle.graph.nodes[needleNodeIdx].typeId) > 0)
@@ -810,7 +860,7 @@ class SubCircuit::SolverWorker
 					std::map<std::string, std::string> currentSubCandidate = currentCandidate;
 					applyPermutation(currentSubCandidate, permutation);
 					if (matchNodePorts(needle.graph, needleNodeIdx, haystack.graph, haystackNodeIdx, currentCandidate) &&
-							userSolver->userCompareNodes(needle.graphId, nn.nodeId, nn.userData, haystack.graphId, hn.nodeId, hn.userData, currentCandidate))
+							userCompareNodes(needle, nn, haystack, hn, currentCandidate))
 						return true;
 				}
 		}
@@ -830,7 +880,7 @@ class SubCircuit::SolverWorker
 				permutateVectorToMapArray(currentCandidate, thisSwapPorts, i);
 
 				if (matchNodePorts(needle.graph, needleNodeIdx, haystack.graph, haystackNodeIdx, currentCandidate) &&
-						userSolver->userCompareNodes(needle.graphId, nn.nodeId, nn.userData, haystack.graphId, hn.nodeId, hn.userData, currentCandidate))
+						userCompareNodes(needle, nn, haystack, hn, currentCandidate))
 					return true;
 
 				if (swapPermutations.count(needle.graph.nodes[needleNodeIdx].typeId) > 0)
@@ -838,7 +888,7 @@ class SubCircuit::SolverWorker
 						std::map<std::string, std::string> currentSubCandidate = currentCandidate;
 						applyPermutation(currentSubCandidate, permutation);
 						if (matchNodePorts(needle.graph, needleNodeIdx, haystack.graph, haystackNodeIdx, currentCandidate) &&
-								userSolver->userCompareNodes(needle.graphId, nn.nodeId, nn.userData, haystack.graphId, hn.nodeId, hn.userData, currentCandidate))
+								userCompareNodes(needle, nn, haystack, hn, currentCandidate))
 							return true;
 					}
 			}
@@ -896,6 +946,9 @@ class SubCircuit::SolverWorker
 						const Graph::Node &needleToNode = needle.graph.nodes[needleNeighbour];
 						const Graph::Node &haystackFromNode = haystack.graph.nodes[j];
 						const Graph::Node &haystackToNode = haystack.graph.nodes[haystackNeighbour];
+						std::unique_lock<std::mutex> lock(userMutex, std::defer_lock);
+						if (inParallel)
+							lock.lock();
 						if (userSolver->userCompareEdge(needle.graphId, needleFromNode.nodeId,  needleFromNode.userData, needleToNode.nodeId,  needleToNode.userData,
 								haystack.graphId, haystackFromNode.nodeId, haystackFromNode.userData, haystackToNode.nodeId, haystackToNode.userData))
 							goto found_match;
@@ -970,7 +1023,7 @@ class SubCircuit::SolverWorker
 		const Graph::Node &hn = haystack.graph.nodes[idxHaystack];
 
 		if (!matchNodePorts(needle.graph, idx, haystack.graph, idxHaystack, currentCandidate) ||
-				!userSolver->userCompareNodes(needle.graphId, nn.nodeId, nn.userData, haystack.graphId, hn.nodeId, hn.userData, currentCandidate))
+				!userCompareNodes(needle, nn, haystack, hn, currentCandidate))
 			return false;
 
 		for (const auto &it_needle : needle.adjMatrix.at(idx))
@@ -1156,6 +1209,10 @@ class SubCircuit::SolverWorker
 				result.mappings[needle.graph.nodes[j].nodeId].portMapping = *portmapCandidates[j].begin();
 			}
 
+			std::unique_lock<std::mutex> lock(userMutex, std::defer_lock);
+			if (inParallel)
+				lock.lock();
+
 			if (!userSolver->userCheckSolution(result)) {
 				if (verbose) {
 					my_printf("\nSolution (rejected by userCheckSolution):\n");
@@ -1186,6 +1243,42 @@ class SubCircuit::SolverWorker
 		std::set<int> activeRow;
 		enumerationMatrix[i].swap(activeRow);
 
+#ifdef SUBCIRCUIT_THREADS
+		// When all solutions are wanted, the subtrees of the top level are
+		// independent of each other, and are searched in parallel. Their
+		// results are collected in the same order as in a serial search.
+		if (iter == 0 && threads > 1 && allowOverlap && limitResults < 0 && !verbose && int(activeRow.size()) >= 2*threads)
+		{
+			std::vector<int> branches(activeRow.begin(), activeRow.end());
+			std::vector<std::vector<Solver::Result>> branchResults(branches.size());
+			std::atomic<int> nextBranch(0);
+
+			auto runBranches = [&]() {
+				for (int k = nextBranch++; k < int(branches.size()); k = nextBranch++) {
+					int j = branches[k];
+					std::vector<std::set<int>> nextEnumerationMatrix = enumerationMatrix;
+					for (int l = 0; l < int(nextEnumerationMatrix.size()); l++)
+						nextEnumerationMatrix[l].erase(j);
+					nextEnumerationMatrix[i].insert(j);
+					ullmannRecursion(branchResults[k], nextEnumerationMatrix, iter+1, needle, haystack, allowOverlap, limitResults);
+				}
+			};
+
+			inParallel = true;
+			std::vector<std::thread> workers;
+			for (int t = 1; t < threads; t++)
+				workers.emplace_back(runBranches);
+			runBranches();
+			for (auto &worker : workers)
+				worker.join();
+			inParallel = false;
+
+			for (auto &it : branchResults)
+				results.insert(results.end(), it.begin(), it.end());
+			return;
+		}
+#endif
+
 		for (int j : activeRow)
 		{
 			// found enough?
@@ -1267,6 +1360,8 @@ class SubCircuit::SolverWorker
 		for (auto &it : graphData)
 		{
 			GraphData &haystack = it.second;
+			if (!checkTypeCount(needle, haystack))
+				continue;
 
 			std::vector<std::set<int>> enumerationMatrix;
 			std::map<std::string, std::set<std::string>> initialMappings;
@@ -1291,6 +1386,7 @@ class SubCircuit::SolverWorker
 		needle.graph = Graph(graph, needle_nodes);
 		needle.graph.markAllExtern();
 		diCache.add(needle.graph, needle.adjMatrix, graphId, userSolver);
+		countTypes(needle);
 
 		std::vector<Solver::Result> ullmannResults;
 		solveForMining(ullmannResults, needle);
@@ -1470,7 +1566,7 @@ class SubCircuit::SolverWorker
 	// interface to the public solver class
 
 protected:
-	SolverWorker(Solver *userSolver) : userSolver(userSolver), verbose(false)
+	SolverWorker(Solver *userSolver) : userSolver(userSolver), verbose(false), threads(1), inParallel(false)
 	{
 	}
 
@@ -1479,6 +1575,11 @@ protected:
 		verbose = true;
 	}
 
+	void setThreads(int threads)
+	{
+		this->threads = std::max(threads, 1);
+	}
+
 	void addGraph(std::string graphId, const Graph &graph)
 	{
 		assert(graphData.count(graphId) == 0);
@@ -1487,6 +1588,7 @@ protected:
 		gd.graphId = graphId;
 		gd.graph = graph;
 		diCache.add(gd.graph, gd.adjMatrix, graphId, userSolver);
+		countTypes(gd);
 	}
 
 	void addCompatibleTypes(std::string needleTypeId, std::string haystackTypeId)
@@ -1520,6 +1622,13 @@ protected:
 		const GraphData &needle = graphData[needleGraphId];
 		GraphData &haystack = graphData[haystackGraphId];
 
+		haystack.usedNodes.resize(haystack.graph.nodes.size());
+		if (!checkTypeCount(needle, haystack)) {
+			if (verbose)
+				my_printf("\nHaystack has too few nodes of the needle's types.\n");
+			return;
+		}
+
 		std::vector<std::set<int>> enumerationMatrix;
 		generateEnumerationMatrix(enumerationMatrix, needle, haystack, initialMappings);
 
@@ -1552,7 +1661,6 @@ protected:
 			printEnumerationMatrix(enumerationMatrix, haystack.graph.nodes.size());
 		}
 
-		haystack.usedNodes.resize(haystack.graph.nodes.size());
 		ullmannRecursion(results, enumerationMatrix, 0, needle, haystack, allowOverlap, maxSolutions > 0 ? results.size() + maxSolutions : -1);
 	}
 
@@ -1628,6 +1736,11 @@ void SubCircuit::Solver::setVerbose()
 	worker->setVerbose();
 }
 
+void SubCircuit::Solver::setThreads(int threads)
+{
+	worker->setThreads(threads);
+}
+
 void SubCircuit::Solver::addGraph(std::string graphId, const Graph &graph)
 {
 	worker->addGraph(graphId, graph);
@@ -2330,7 +2330,8 @@ def gen_wrappers(filename, debug_level_ = 0):
 """)
 	for source in sources:
 		wrapper_file.write("#include \""+source.name+".h\"\n")
-	wrapper_file.write("""
+	wrapper_file.write("""#include "kernel/modgraph.h"
+
 #include <boost/python/module.hpp>
 #include <boost/python/class.hpp>
 #include <boost/python/wrapper.hpp>
@@ -2466,6 +2467,119 @@ namespace YOSYS_PYTHON {
 		Yosys::log_streams.insert(Yosys::log_streams.begin(), output);
 	};
 
+	/// @brief Copy an index array into a memoryview of C ints, which numpy
+	///        (numpy.frombuffer, numpy.asarray) can use without another copy.
+	boost::python::object int_array(const std::vector<int> &data)
+	{
+		boost::python::object bytes(boost::python::handle<>(PyByteArray_FromStringAndSize(
+				reinterpret_cast<const char*>(data.data()), data.size() * sizeof(int))));
+		boost::python::object view(boost::python::handle<>(PyMemoryView_FromObject(bytes.ptr())));
+		return view.attr("cast")("i");
+	}
+
+	/// @brief Export the netlist of a module as flat index arrays, using the
+	///        numbering of Yosys::ModuleGraph (kernel/modgraph.h). Nothing is
+	///        wrapped per cell, wire or bit, names are returned once as lists
+	///        of str and everything else as int memoryviews:
+	///
+	///          cells, cell_type[cell] -> index into types
+	///          wires, net_wire[net], net_offset[net] -> canonical bit of a net
+	///          net_flags[net] -> 1 for module inputs, 2 for module outputs
+	///          driver_start[net] .. driver_start[net+1] -> index into
+	///            driver_cell, driver_port (index into ports), driver_offset
+	///          sink_start, sink_cell, sink_port, sink_offset -> the same for sinks
+	///          input_start[cell] .. input_start[cell+1] -> index into input_net
+	///          output_start, output_net -> the same for outputs, -1 for constants
+	boost::python::dict netlist_arrays(Module *module)
+	{
+		Yosys::RTLIL::Module *mod = module->get_cpp_obj();
+		Yosys::ModuleGraph graph(mod);
+		int num_cells = graph.num_cells();
+		int num_nets = graph.num_nets();
+
+		boost::python::list cells, wires, types, ports;
+		Yosys::dict<Yosys::RTLIL::IdString, int> type_index, port_index;
+		Yosys::dict<Yosys::RTLIL::Wire*, int> wire_index;
+		auto intern = [](boost::python::list &names, Yosys::dict<Yosys::RTLIL::IdString, int> &index, Yosys::RTLIL::IdString name) {
+			auto it = index.find(name);
+			if (it != index.end())
+				return it->second;
+			names.append(name.str());
+			return index[name] = Yosys::GetSize(index);
+		};
+
+		for (auto wire : mod->wires()) {
+			wire_index[wire] = Yosys::GetSize(wire_index);
+			wires.append(wire->name.str());
+		}
+
+		std::vector<int> cell_type, input_start, input_net, output_start, output_net;
+		cell_type.reserve(num_cells);
+		for (int i = 0; i < num_cells; i++) {
+			Yosys::RTLIL::Cell *cell = graph.cell(i);
+			cells.append(cell->name.str());
+			cell_type.push_back(intern(types, type_index, cell->type));
+			input_start.push_back(Yosys::GetSize(input_net));
+			output_start.push_back(Yosys::GetSize(output_net));
+			for (int net : graph.cell_inputs(i))
+				input_net.push_back(net);
+			for (int net : graph.cell_outputs(i))
+				output_net.push_back(net);
+		}
+		input_start.push_back(Yosys::GetSize(input_net));
+		output_start.push_back(Yosys::GetSize(output_net));
+
+		std::vector<int> net_wire, net_offset, net_flags;
+		std::vector<int> driver_start, driver_cell, driver_port, driver_offset;
+		std::vector<int> sink_start, sink_cell, sink_port, sink_offset;
+		net_wire.reserve(num_nets);
+		net_offset.reserve(num_nets);
+		net_flags.reserve(num_nets);
+		for (int i = 0; i < num_nets; i++) {
+			Yosys::RTLIL::SigBit bit = graph.net(i);
+			net_wire.push_back(wire_index.at(bit.wire));
+			net_offset.push_back(bit.offset);
+			net_flags.push_back((graph.is_module_input(i) ? 1 : 0) | (graph.is_module_output(i) ? 2 : 0));
+			driver_start.push_back(Yosys::GetSize(driver_cell));
+			for (auto &port : graph.drivers(i)) {
+				driver_cell.push_back(port.cell);
+				driver_port.push_back(intern(ports, port_index, port.port));
+				driver_offset.push_back(port.offset);
+			}
+			sink_start.push_back(Yosys::GetSize(sink_cell));
+			for (auto &port : graph.sinks(i)) {
+				sink_cell.push_back(port.cell);
+				sink_port.push_back(intern(ports, port_index, port.port));
+				sink_offset.push_back(port.offset);
+			}
+		}
+		driver_start.push_back(Yosys::GetSize(driver_cell));
+		sink_start.push_back(Yosys::GetSize(sink_cell));
+
+		boost::python::dict result;
+		result["cells"] = cells;
+		result["wires"] = wires;
+		result["types"] = types;
+		result["ports"] = ports;
+		result["cell_type"] = int_array(cell_type);
+		result["input_start"] = int_array(input_start);
+		result["input_net"] = int_array(input_net);
+		result["output_start"] = int_array(output_start);
+		result["output_net"] = int_array(output_net);
+		result["net_wire"] = int_array(net_wire);
+		result["net_offset"] = int_array(net_offset);
+		result["net_flags"] = int_array(net_flags);
+		result["driver_start"] = int_array(driver_start);
+		result["driver_cell"] = int_array(driver_cell);
+		result["driver_port"] = int_array(driver_port);
+		result["driver_offset"] = int_array(driver_offset);
+		result["sink_start"] = int_array(sink_start);
+		result["sink_cell"] = int_array(sink_cell);
+		result["sink_port"] = int_array(sink_port);
+		result["sink_offset"] = int_array(sink_offset);
+		return result;
+	}
+
 
 	BOOST_PYTHON_MODULE(libyosys)
 	{
@@ -2475,6 +2589,7 @@ namespace YOSYS_PYTHON {
 		scope().attr("_hidden") = new Initializer();
 
 		def("log_to_stream", &log_to_stream);
+		def("netlist_arrays", &netlist_arrays);
 """)
 
 	for enum in enums:
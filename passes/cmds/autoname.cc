@@ -18,74 +18,148 @@
  */
 
 #include "kernel/yosys.h"
+#include <queue>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-int autoname_worker(Module *module, const dict<Wire*, int>& wire_score)
+// Proposes names for private objects from the names of their neighbours:
+// cells are named after connected public wires, wires after connected public
+// cells. Proposals are handled in order of their score (lower is better), and
+// an object that gets a name proposes names to its neighbours in turn, so all
+// names are found in one pass over the netlist, however deep the anonymous
+// logic is. All renames are applied together at the end.
+struct AutonameWorker
 {
-	dict<Cell*, pair<int, string>> proposed_cell_names;
-	dict<Wire*, pair<int, string>> proposed_wire_names;
-	int best_score = -1;
-
-	for (auto cell : module->selected_cells()) {
-		if (cell->name[0] == '$') {
-			for (auto &conn : cell->connections()) {
-				string suffix;
-				for (auto bit : conn.second)
-					if (bit.wire != nullptr && bit.wire->name[0] != '$') {
-						if (suffix.empty())
-							suffix = stringf("_%s_%s", log_id(cell->type), log_id(conn.first));
-						string new_name(bit.wire->name.str() + suffix);
-						int score = wire_score.at(bit.wire);
-						if (cell->output(conn.first)) score = 0;
-						score = 10000*score + new_name.size();
-						if (!proposed_cell_names.count(cell) || score < proposed_cell_names.at(cell).first) {
-							if (best_score < 0 || score < best_score)
-								best_score = score;
-							proposed_cell_names[cell] = make_pair(score, new_name);
-						}
-					}
-			}
-		} else {
-			for (auto &conn : cell->connections()) {
-				string suffix;
-				for (auto bit : conn.second)
-					if (bit.wire != nullptr && bit.wire->name[0] == '$' && !bit.wire->port_id) {
-						if (suffix.empty())
-							suffix = stringf("_%s", log_id(conn.first));
-						string new_name(cell->name.str() + suffix);
-						int score = wire_score.at(bit.wire);
-						if (cell->output(conn.first)) score = 0;
-						score = 10000*score + new_name.size();
-						if (!proposed_wire_names.count(bit.wire) || score < proposed_wire_names.at(bit.wire).first) {
-							if (best_score < 0 || score < best_score)
-								best_score = score;
-							proposed_wire_names[bit.wire] = make_pair(score, new_name);
-						}
-					}
+	struct Proposal {
+		int score;
+		std::string name;
+		int index;
+		Cell *cell;
+		Wire *wire;
+
+		bool operator<(const Proposal &other) const {
+			// std::priority_queue puts the largest element on top
+			if (score != other.score)
+				return score > other.score;
+			if (name != other.name)
+				return name > other.name;
+			return index > other.index;
+		}
+	};
+
+	Module *module;
+	dict<Wire*, int> wire_score;
+	dict<Wire*, vector<pair<Cell*, IdString>>> wire_users;
+	std::priority_queue<Proposal> queue;
+	dict<Wire*, IdString> wire_names;
+	dict<Cell*, IdString> cell_names;
+	pool<IdString> used_names;
+	int counter = 0;
+
+	AutonameWorker(Module *module) : module(module)
+	{
+		for (auto cell : module->selected_cells())
+		for (auto &conn : cell->connections())
+		for (auto bit : conn.second)
+			if (bit.wire != nullptr) {
+				wire_score[bit.wire]++;
+				auto &users = wire_users[bit.wire];
+				if (users.empty() || users.back() != make_pair(cell, conn.first))
+					users.push_back(make_pair(cell, conn.first));
 			}
+	}
+
+	void propose(Cell *cell, Wire *wire, std::string name, Wire *scored_wire, bool output)
+	{
+		int score = output ? 0 : wire_score.at(scored_wire);
+		score = 10000*score + name.size();
+		queue.push(Proposal{score, std::move(name), counter++, cell, wire});
+	}
+
+	// propose names for the private wires of a public cell
+	void propose_wires(Cell *cell, IdString cell_name)
+	{
+		for (auto &conn : cell->connections()) {
+			bool output = cell->output(conn.first);
+			Wire *last = nullptr;
+			for (auto bit : conn.second)
+				if (bit.wire != nullptr && bit.wire != last && bit.wire->name[0] == '$' && !bit.wire->port_id && !wire_names.count(bit.wire)) {
+					propose(nullptr, bit.wire, cell_name.str() + stringf("_%s", log_id(conn.first)), bit.wire, output);
+					last = bit.wire;
+				}
 		}
 	}
 
-	for (auto &it : proposed_cell_names) {
-		if (best_score*2 < it.second.first)
-			continue;
-		IdString n = module->uniquify(IdString(it.second.second));
-		log_debug("Rename cell %s in %s to %s.\n", log_id(it.first), log_id(module), log_id(n));
-		module->rename(it.first, n);
+	// propose names for the private cells connected to a public wire
+	void propose_cells(Wire *wire, IdString wire_name)
+	{
+		auto it = wire_users.find(wire);
+		if (it == wire_users.end())
+			return;
+		for (auto &user : it->second) {
+			Cell *cell = user.first;
+			if (cell->name[0] == '$' && !cell_names.count(cell))
+				propose(cell, nullptr, wire_name.str() + stringf("_%s_%s", log_id(cell->type), log_id(user.second)),
+						wire, cell->output(user.second));
+		}
 	}
 
-	for (auto &it : proposed_wire_names) {
-		if (best_score*2 < it.second.first)
-			continue;
-		IdString n = module->uniquify(IdString(it.second.second));
-		log_debug("Rename wire %s in %s to %s.\n", log_id(it.first), log_id(module), log_id(n));
-		module->rename(it.first, n);
+	IdString uniquify(const std::string &name)
+	{
+		IdString new_name(name);
+		for (int index = 1; module->count_id(new_name) != 0 || used_names.count(new_name); index++)
+			new_name = stringf("%s_%d", name.c_str(), index);
+		used_names.insert(new_name);
+		return new_name;
 	}
 
-	return proposed_cell_names.size() + proposed_wire_names.size();
-}
+	int run()
+	{
+		for (auto cell : module->selected_cells()) {
+			if (cell->name[0] == '$') {
+				for (auto &conn : cell->connections()) {
+					Wire *last = nullptr;
+					for (auto bit : conn.second)
+						if (bit.wire != nullptr && bit.wire != last && bit.wire->name[0] != '$') {
+							propose(cell, nullptr, bit.wire->name.str() + stringf("_%s_%s", log_id(cell->type), log_id(conn.first)),
+									bit.wire, cell->output(conn.first));
+							last = bit.wire;
+						}
+				}
+			} else
+				propose_wires(cell, cell->name);
+		}
+
+		while (!queue.empty())
+		{
+			Proposal p = queue.top();
+			queue.pop();
+
+			if (p.cell != nullptr) {
+				if (cell_names.count(p.cell))
+					continue;
+				IdString n = uniquify(p.name);
+				log_debug("Rename cell %s in %s to %s.\n", log_id(p.cell), log_id(module), log_id(n));
+				cell_names[p.cell] = n;
+				propose_wires(p.cell, n);
+			} else {
+				if (wire_names.count(p.wire))
+					continue;
+				IdString n = uniquify(p.name);
+				log_debug("Rename wire %s in %s to %s.\n", log_id(p.wire), log_id(module), log_id(n));
+				wire_names[p.wire] = n;
+				propose_cells(p.wire, n);
+			}
+		}
+
+		// every rename is a blackout, send only one for all of them
+		RTLIL::Module::BatchScope batch(module);
+		module->rename(wire_names, cell_names);
+
+		return GetSize(cell_names) + GetSize(wire_names);
+	}
+};
 
 struct AutonamePass : public Pass {
 	AutonamePass() : Pass("autoname", "automatically assign names to objects") { }
@@ -115,22 +189,10 @@ struct AutonamePass : public Pass {
 
 		for (auto module : design->selected_modules())
 		{
-			dict<Wire*, int> wire_score;
-			for (auto cell : module->selected_cells())
-			for (auto &conn : cell->connections())
-			for (auto bit : conn.second)
-				if (bit.wire != nullptr)
-					wire_score[bit.wire]++;
-
-			int count = 0, iter = 0;
-			while (1) {
-				iter++;
-				int n = autoname_worker(module, wire_score);
-				if (!n) break;
-				count += n;
-			}
+			AutonameWorker worker(module);
+			int count = worker.run();
 			if (count > 0)
-				log("Renamed %d objects in module %s (%d iterations).\n", count, log_id(module), iter);
+				log("Renamed %d objects in module %s.\n", count, log_id(module));
 		}
 	}
 } AutonamePass;
@@ -0,0 +1,174 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/register.h"
+#include "kernel/log.h"
+#include <fstream>
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct BatchPass : public Pass {
+	BatchPass() : Pass("batch", "run independent jobs in forked copies of the current state") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    batch [options] [<jobfile>]\n");
+		log("\n");
+		log("Run each job in a forked child process that starts out as a copy of this\n");
+		log("process, including the current design. Everything that was loaded before,\n");
+		log("e.g. cell libraries read with 'read_liberty -lib', techlib models read with\n");
+		log("'read_verilog -lib' and plugins, is therefore shared copy-on-write by all jobs\n");
+		log("instead of being loaded again for each of them. The jobs do not change the\n");
+		log("design of this process.\n");
+		log("\n");
+		log("Each non-empty line of <jobfile> that does not start with '#' is one job.\n");
+		log("A job is a command line as it would be entered at the yosys prompt, i.e.\n");
+		log("commands are separated by ';' and 'script <file>' runs a whole script.\n");
+		log("\n");
+		log("    -job <commands>\n");
+		log("        add a job, in addition to those from <jobfile>. this option can be\n");
+		log("        used multiple times.\n");
+		log("\n");
+		log("    -j <N>\n");
+		log("        run at most N jobs at the same time. The default is the number of\n");
+		log("        threads (see 'yosys -j' and the 'parallel.threads' scratchpad\n");
+		log("        variable). The threads are divided among the running jobs.\n");
+		log("\n");
+		log("    -logdir <dir>\n");
+		log("        write the log of job i (counting from 0) to <dir>/job<i>.log. By\n");
+		log("        default the log of each job is copied to the log of this process\n");
+		log("        once all jobs are done, in job order.\n");
+		log("\n");
+		log("    -nofail\n");
+		log("        only print a warning for failed jobs. By default this command fails\n");
+		log("        when any job failed, after all of them finished.\n");
+		log("\n");
+		log("This command is not available where fork() is not available.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		std::vector<std::string> jobs;
+		std::string logdir;
+		int max_running = 0;
+		bool nofail = false;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-job" && argidx+1 < args.size()) {
+				jobs.push_back(args[++argidx]);
+				continue;
+			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				max_running = atoi(args[++argidx].c_str());
+				if (max_running < 1)
+					log_cmd_error("Invalid number of jobs: %s\n", args[argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-logdir" && argidx+1 < args.size()) {
+				logdir = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-nofail") {
+				nofail = true;
+				continue;
+			}
+			break;
+		}
+		if (argidx+1 < args.size())
+			cmd_error(args, argidx+1, "Extra argument.");
+
+		std::vector<std::string> file_jobs;
+		if (argidx < args.size()) {
+			std::string filename = args[argidx];
+			rewrite_filename(filename);
+			std::ifstream f(filename);
+			if (f.fail())
+				log_cmd_error("Can't open job file `%s': %s\n", filename.c_str(), strerror(errno));
+			std::string line;
+			while (std::getline(f, line)) {
+				size_t start = line.find_first_not_of(" \t\r");
+				if (start == std::string::npos || line[start] == '#')
+					continue;
+				file_jobs.push_back(line.substr(start));
+			}
+		}
+		jobs.insert(jobs.begin(), file_jobs.begin(), file_jobs.end());
+
+		log_header(design, "Executing BATCH pass (running jobs in forked processes).\n");
+
+		if (jobs.empty()) {
+			log("No jobs to run.\n");
+			return;
+		}
+
+		if (max_running == 0)
+			max_running = parallel_threads(design);
+		max_running = std::min(max_running, GetSize(jobs));
+
+		if (!logdir.empty() && !check_directory_exists(logdir) && !create_directory(logdir))
+			log_cmd_error("Can't create log directory `%s'.\n", logdir.c_str());
+
+		log("Running %d jobs, at most %d at a time.\n", GetSize(jobs), max_running);
+		log_push();
+
+		auto job_log = [&](int i) {
+			return stringf("%s/job%d.log", logdir.c_str(), i);
+		};
+
+		auto job_main = [&](int i, const std::string &) {
+			if (!logdir.empty()) {
+				FILE *f = fopen(job_log(i).c_str(), "w");
+				if (f == nullptr)
+					log_error("Can't create log file `%s': %s\n", job_log(i).c_str(), strerror(errno));
+				log_files.clear();
+				log_files.push_back(f);
+			}
+			Pass::call(design, jobs[i]);
+			log_flush();
+		};
+
+		int failed = 0;
+		auto merge = [&](int i, const std::string &, bool success) {
+			if (!success)
+				failed++;
+			log("Job %d %s: %s\n", i, success ? "finished" : "FAILED", jobs[i].c_str());
+			if (!success && !logdir.empty())
+				log("  see %s for details.\n", job_log(i).c_str());
+			return std::string();
+		};
+
+		bool forked = fork_jobs(GetSize(jobs), job_main, merge, max_running);
+		log_pop();
+
+		if (!forked)
+			log_cmd_error("The batch command needs fork(), which is not available on this platform.\n");
+
+		if (failed == 0)
+			log("All %d jobs finished.\n", GetSize(jobs));
+		else if (nofail)
+			log_warning("%d of %d jobs failed.\n", failed, GetSize(jobs));
+		else
+			log_error("%d of %d jobs failed.\n", failed, GetSize(jobs));
+	}
+} BatchPass;
+
+PRIVATE_NAMESPACE_END
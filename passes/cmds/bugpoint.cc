@@ -19,6 +19,11 @@
 
 #include "kernel/yosys.h"
 #include "backends/rtlil/rtlil_backend.h"
+#include <mutex>
+
+#ifndef _WIN32
+#  include <signal.h>
+#endif
 
 USING_YOSYS_NAMESPACE
 using namespace RTLIL_BACKEND;
@@ -92,21 +97,41 @@ struct BugpointPass : public Pass {
 		log("    -runner \"<prefix>\"\n");
 		log("        child process wrapping command, e.g., \"timeout 30\", or valgrind.\n");
 		log("\n");
+		log("    -j <N>\n");
+		log("        try up to N simplifications at the same time, each in its own Yosys\n");
+		log("        process and with its own bugpoint-case-<i>.il and .log files. the first\n");
+		log("        of them (in the order they would have been tried one by one) that still\n");
+		log("        crashes is kept, and the processes for the later ones are stopped.\n");
+		log("\n");
+		log("    -nobulk\n");
+		log("        by default, when cells are considered for removal, bugpoint first tries\n");
+		log("        to remove large groups of cells at once, halving the group size when\n");
+		log("        no group can be removed, before it removes single objects. this option\n");
+		log("        disables the group removal phase.\n");
+		log("\n");
 	}
 
-	bool run_yosys(RTLIL::Design *design, string runner, string yosys_cmd, string yosys_arg)
+	void write_case(RTLIL::Design *design, string case_name)
 	{
 		design->sort();
 
-		std::ofstream f("bugpoint-case.il");
+		std::ofstream f(case_name + ".il");
 		RTLIL_BACKEND::dump_design(f, design, /*only_selected=*/false, /*flag_m=*/true, /*flag_n=*/false);
 		f.close();
+	}
+
+	string case_cmdline(string case_name, string runner, string yosys_cmd, string yosys_arg)
+	{
+		return stringf("%s %s -qq -L %s.log %s %s.il", runner.c_str(), yosys_cmd.c_str(), case_name.c_str(), yosys_arg.c_str(), case_name.c_str());
+	}
 
-		string yosys_cmdline = stringf("%s %s -qq -L bugpoint-case.log %s bugpoint-case.il", runner.c_str(), yosys_cmd.c_str(), yosys_arg.c_str());
-		return run_command(yosys_cmdline) == 0;
+	bool run_yosys(RTLIL::Design *design, string runner, string yosys_cmd, string yosys_arg)
+	{
+		write_case(design, "bugpoint-case");
+		return run_command(case_cmdline("bugpoint-case", runner, yosys_cmd, yosys_arg)) == 0;
 	}
 
-	bool check_logfile(string grep)
+	bool check_logfile(string grep, string logfile = "bugpoint-case.log")
 	{
 		if (grep.empty())
 			return true;
@@ -114,7 +139,7 @@ struct BugpointPass : public Pass {
 		if (grep.size() > 2 && grep.front() == '"' && grep.back() == '"')
 			grep = grep.substr(1, grep.size() - 2);
 
-		std::ifstream f("bugpoint-case.log");
+		std::ifstream f(logfile);
 		while (!f.eof())
 		{
 			string line;
@@ -125,6 +150,93 @@ struct BugpointPass : public Pass {
 		return false;
 	}
 
+	// Check which of the given designs still crash, running up to `jobs` of
+	// them at the same time. Returns the index of the first crashing design,
+	// or -1 if none crashes. A run is stopped as soon as an earlier design is
+	// known to crash, since its result can no longer matter.
+	int run_trials(RTLIL::Design *design, const std::vector<RTLIL::Design*> &trials, bool clean, string runner, string yosys_cmd, string yosys_arg, string grep, int jobs)
+	{
+		if (jobs <= 1 || GetSize(trials) == 1)
+		{
+			for (int i = 0; i < GetSize(trials); i++)
+			{
+				bool crashes;
+				if (clean)
+				{
+					RTLIL::Design *testcase = clean_design(trials[i]);
+					crashes = !run_yosys(testcase, runner, yosys_cmd, yosys_arg);
+					delete testcase;
+				}
+				else
+				{
+					crashes = !run_yosys(trials[i], runner, yosys_cmd, yosys_arg);
+				}
+				if (crashes && check_logfile(grep))
+					return i;
+			}
+			return -1;
+		}
+
+		for (int i = 0; i < GetSize(trials); i++)
+		{
+			RTLIL::Design *testcase = clean_design(trials[i], clean);
+			write_case(testcase, stringf("bugpoint-case-%d", i));
+			if (testcase != trials[i])
+				delete testcase;
+		}
+
+		std::atomic<int> first_crash(GetSize(trials));
+		std::vector<int> pids(GetSize(trials), 0);
+		std::mutex pids_mutex;
+
+		Pass::parallel_for(design, GetSize(trials), [&](int i) {
+			if (first_crash.load() < i)
+				return;
+
+			string case_name = stringf("bugpoint-case-%d", i);
+			string cmdline = case_cmdline(case_name, runner, yosys_cmd, yosys_arg);
+#ifndef _WIN32
+			// the shell writes its PID before it runs the command, so that later
+			// trials can be stopped
+			string pid_file = case_name + ".pid";
+			remove(pid_file.c_str());
+			cmdline = stringf("echo $$ > %s && exec %s", pid_file.c_str(), cmdline.c_str());
+			{
+				std::lock_guard<std::mutex> lock(pids_mutex);
+				pids[i] = -1;
+			}
+#endif
+			bool crashes = run_command(cmdline) != 0 && check_logfile(grep, case_name + ".log");
+#ifndef _WIN32
+			{
+				std::lock_guard<std::mutex> lock(pids_mutex);
+				pids[i] = 0;
+			}
+			remove(pid_file.c_str());
+#endif
+			if (!crashes || first_crash.load() < i)
+				return;
+
+			int expected = first_crash.load();
+			while (i < expected && !first_crash.compare_exchange_weak(expected, i)) { }
+
+#ifndef _WIN32
+			std::lock_guard<std::mutex> lock(pids_mutex);
+			for (int j = i + 1; j < GetSize(trials); j++) {
+				if (pids[j] != -1)
+					continue;
+				std::ifstream f(stringf("bugpoint-case-%d.pid", j));
+				int pid = 0;
+				if (f >> pid)
+					kill(pid, SIGTERM);
+			}
+#endif
+		}, jobs);
+
+		int result = first_crash.load();
+		return result < GetSize(trials) ? result : -1;
+	}
+
 	RTLIL::Design *clean_design(RTLIL::Design *design, bool do_clean = true, bool do_delete = false)
 	{
 		if (!do_clean)
@@ -141,6 +253,46 @@ struct BugpointPass : public Pass {
 		return design_copy;
 	}
 
+	int count_removable_cells(RTLIL::Design *design)
+	{
+		int count = 0;
+		for (auto mod : design->modules())
+			if (!mod->get_blackbox_attribute())
+				for (auto cell : mod->cells())
+					if (!cell->get_bool_attribute(ID::bugpoint_keep))
+						count++;
+		return count;
+	}
+
+	RTLIL::Design *remove_cells(RTLIL::Design *design, int offset, int count)
+	{
+		RTLIL::Design *design_copy = new RTLIL::Design;
+		for (auto module : design->modules())
+			design_copy->add(module->clone());
+
+		log_header(design, "Trying to remove %d cells starting at cell #%d.\n", count, offset);
+
+		int index = 0;
+		for (auto mod : design_copy->modules())
+		{
+			if (mod->get_blackbox_attribute())
+				continue;
+
+			std::vector<Cell*> removed_cells;
+			for (auto cell : mod->cells())
+			{
+				if (cell->get_bool_attribute(ID::bugpoint_keep))
+					continue;
+				if (index >= offset && index < offset + count)
+					removed_cells.push_back(cell);
+				index++;
+			}
+			for (auto cell : removed_cells)
+				mod->remove(cell);
+		}
+		return design_copy;
+	}
+
 	RTLIL::Design *simplify_something(RTLIL::Design *design, int &seed, bool stage2, bool modules, bool ports, bool cells, bool connections, bool processes, bool assigns, bool updates, bool wires)
 	{
 		RTLIL::Design *design_copy = new RTLIL::Design;
@@ -400,7 +552,8 @@ struct BugpointPass : public Pass {
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		string yosys_cmd = "yosys", yosys_arg, grep, runner;
-		bool fast = false, clean = false;
+		bool fast = false, clean = false, bulk = true;
+		int jobs = 1;
 		bool modules = false, ports = false, cells = false, connections = false, processes = false, assigns = false, updates = false, wires = false, has_part = false;
 
 		log_header(design, "Executing BUGPOINT pass (minimize testcases).\n");
@@ -477,6 +630,16 @@ struct BugpointPass : public Pass {
 				has_part = true;
 				continue;
 			}
+			if (args[argidx] == "-j" && argidx + 1 < args.size()) {
+				jobs = atoi(args[++argidx].c_str());
+				if (jobs < 1)
+					log_cmd_error("Invalid number of jobs: %s\n", args[argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-nobulk") {
+				bulk = false;
+				continue;
+			}
 			if (args[argidx] == "-runner" && argidx + 1 < args.size()) {
 				runner = args[++argidx];
 				if (runner.size() && runner.at(0) == '"') {
@@ -513,40 +676,76 @@ struct BugpointPass : public Pass {
 		if (!check_logfile(grep))
 			log_cmd_error("The provided grep string is not found in the log file!\n");
 
-		int seed = 0;
-		bool found_something = false, stage2 = false;
-		while (true)
+		auto accept_trial = [&](std::vector<RTLIL::Design*> &trials, int crashed) {
+			for (int i = 0; i < GetSize(trials); i++) {
+				if (i != crashed) {
+					delete trials[i];
+					continue;
+				}
+				if (crashing_design != design)
+					delete crashing_design;
+				crashing_design = trials[i];
+			}
+			trials.clear();
+		};
+
+		if (cells && bulk)
 		{
-			if (RTLIL::Design *simplified = simplify_something(crashing_design, seed, stage2, modules, ports, cells, connections, processes, assigns, updates, wires))
+			int total = count_removable_cells(crashing_design);
+			for (int chunk = total / 2; chunk >= 2; chunk /= 2)
 			{
-				simplified = clean_design(simplified, fast, /*do_delete=*/true);
-
-				bool crashes;
-				if (clean)
+				int offset = 0;
+				while (offset < total)
 				{
-					RTLIL::Design *testcase = clean_design(simplified);
-					crashes = !run_yosys(testcase, runner, yosys_cmd, yosys_arg);
-					delete testcase;
-				}
-				else
-				{
-					crashes = !run_yosys(simplified, runner, yosys_cmd, yosys_arg);
+					std::vector<RTLIL::Design*> trials;
+					for (int i = 0; i < jobs && offset + i * chunk < total; i++)
+						trials.push_back(clean_design(remove_cells(crashing_design, offset + i * chunk, chunk), fast, /*do_delete=*/true));
+
+					int crashed = run_trials(design, trials, clean, runner, yosys_cmd, yosys_arg, grep, jobs);
+					if (crashed >= 0) {
+						log("Testcase crashes.\n");
+						// the removed cells are gone, so the next group starts at the same index
+						offset += crashed * chunk;
+						accept_trial(trials, crashed);
+						total = count_removable_cells(crashing_design);
+					} else {
+						log("Testcase does not crash.\n");
+						offset += GetSize(trials) * chunk;
+						accept_trial(trials, -1);
+					}
 				}
+			}
+		}
 
-				if (crashes && check_logfile(grep))
+		int seed = 0;
+		bool found_something = false, stage2 = false;
+		while (true)
+		{
+			std::vector<RTLIL::Design*> trials;
+			for (int i = 0; i < jobs; i++) {
+				int trial_seed = seed + i;
+				RTLIL::Design *simplified = simplify_something(crashing_design, trial_seed, stage2, modules, ports, cells, connections, processes, assigns, updates, wires);
+				if (simplified == nullptr)
+					break;
+				trials.push_back(clean_design(simplified, fast, /*do_delete=*/true));
+			}
+
+			if (!trials.empty())
+			{
+				int crashed = run_trials(design, trials, clean, runner, yosys_cmd, yosys_arg, grep, jobs);
+				if (crashed >= 0)
 				{
 					log("Testcase crashes.\n");
-					if (crashing_design != design)
-						delete crashing_design;
-					crashing_design = simplified;
+					// the simplifications before the crashing one didn't crash
+					seed += crashed;
 					found_something = true;
 				}
 				else
 				{
 					log("Testcase does not crash.\n");
-					delete simplified;
-					seed++;
+					seed += GetSize(trials);
 				}
+				accept_trial(trials, crashed);
 			}
 			else
 			{
@@ -21,11 +21,86 @@
 #include "kernel/sigtools.h"
 #include "kernel/celledges.h"
 #include "kernel/celltypes.h"
-#include "kernel/utils.h"
+#include "kernel/topo_scc.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// Graph of wire bits (and helper nodes for cells with overapproximated
+// connectivity) for the logic loop check
+struct LoopGraph
+{
+	idict<std::pair<RTLIL::IdString, int>> nodes;
+	std::vector<std::pair<int, int>> edges;
+
+	void edge(const std::pair<RTLIL::IdString, int> &from, const std::pair<RTLIL::IdString, int> &to)
+	{
+		edges.emplace_back(nodes(from), nodes(to));
+	}
+
+	// Find the SCCs with the iterative (and for the acyclic part parallel)
+	// SCC search of topo_scc.h and return one loop through each SCC that
+	// has a cycle. The nodes of a loop are in edge order, and the last node
+	// has an edge back to the first.
+	std::vector<std::vector<std::pair<RTLIL::IdString, int>>> find_loops(int threads)
+	{
+		std::vector<std::vector<std::pair<RTLIL::IdString, int>>> loops;
+
+		CsrGraph graph(GetSize(nodes), edges);
+		std::vector<int> scc_index;
+		int num_sccs = csr_sccs(graph, scc_index, threads);
+
+		std::vector<int> scc_size(num_sccs), scc_start(num_sccs, -1);
+		for (int i = 0; i < GetSize(nodes); i++) {
+			scc_size[scc_index[i]]++;
+			if (scc_start[scc_index[i]] < 0)
+				scc_start[scc_index[i]] = i;
+		}
+		for (auto &e : edges)
+			if (e.first == e.second && scc_size[scc_index[e.first]] == 1 && scc_start[scc_index[e.first]] >= 0) {
+				loops.push_back({nodes[e.first]});
+				scc_start[scc_index[e.first]] = -1;
+			}
+
+		// breadth-first search within the SCC from its first node back to
+		// itself, so that the loop that is reported is a shortest one
+		dict<int, int> parent;
+		for (int scc = 0; scc < num_sccs; scc++)
+		{
+			if (scc_size[scc] < 2)
+				continue;
+
+			int start = scc_start[scc];
+			parent.clear();
+			std::vector<int> queue = {start};
+			int last = -1;
+			for (int i = 0; i < GetSize(queue) && last < 0; i++)
+				for (auto succ = graph.succ_begin(queue[i]); succ != graph.succ_end(queue[i]); succ++) {
+					if (scc_index[*succ] != scc)
+						continue;
+					if (*succ == start) {
+						last = queue[i];
+						break;
+					}
+					if (parent.count(*succ))
+						continue;
+					parent[*succ] = queue[i];
+					queue.push_back(*succ);
+				}
+			log_assert(last >= 0);
+
+			std::vector<std::pair<RTLIL::IdString, int>> loop;
+			for (int node = last; node != start; node = parent.at(node))
+				loop.push_back(nodes[node]);
+			loop.push_back(nodes[start]);
+			std::reverse(loop.begin(), loop.end());
+			loops.push_back(loop);
+		}
+
+		return loops;
+	}
+};
+
 struct CheckPass : public Pass {
 	CheckPass() : Pass("check", "check for obvious problems in the design") { }
 	void help() override
@@ -59,6 +134,11 @@ struct CheckPass : public Pass {
 		log("    -assert\n");
 		log("        produce a runtime error if any problems are found in the current design\n");
 		log("\n");
+		log("    -cached\n");
+		log("        skip modules that have not changed since they last passed 'check' with\n");
+		log("        the same options. Changes to attributes (such as 'init') and modules\n");
+		log("        with processes are not tracked, so those are always checked.\n");
+		log("\n");
 		log("    -force-detailed-loop-check\n");
 		log("        for the detection of combinatorial loops, use a detailed connectivity\n");
 		log("        model for all internal cells for which it is available. This disables\n");
@@ -76,23 +156,29 @@ struct CheckPass : public Pass {
 		bool assert_mode = false;
 		bool force_detailed_loop_check = false;
 		bool suggest_detail = false;
+		bool cached = false;
+		std::string cache_key = "check";
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
 			if (args[argidx] == "-noinit") {
 				noinit = true;
+				cache_key += " " + args[argidx];
 				continue;
 			}
 			if (args[argidx] == "-initdrv") {
 				initdrv = true;
+				cache_key += " " + args[argidx];
 				continue;
 			}
 			if (args[argidx] == "-mapped") {
 				mapped = true;
+				cache_key += " " + args[argidx];
 				continue;
 			}
 			if (args[argidx] == "-allow-tbuf") {
 				allow_tbuf = true;
+				cache_key += " " + args[argidx];
 				continue;
 			}
 			if (args[argidx] == "-assert") {
@@ -101,6 +187,11 @@ struct CheckPass : public Pass {
 			}
 			if (args[argidx] == "-force-detailed-loop-check") {
 				force_detailed_loop_check = true;
+				cache_key += " " + args[argidx];
+				continue;
+			}
+			if (args[argidx] == "-cached") {
+				cached = true;
 				continue;
 			}
 			break;
@@ -111,6 +202,18 @@ struct CheckPass : public Pass {
 
 		for (auto module : design->selected_whole_modules_warn())
 		{
+			// the result of a module is kept with the generation it had when
+			// it last passed, in the same map that converged() uses
+			bool cacheable = cached && module->processes.empty();
+			if (cacheable) {
+				auto it = module->converged_.find(cache_key);
+				if (it != module->converged_.end() && it->second == module->generation_) {
+					log("Module %s is unchanged since it last passed, skipping.\n", log_id(module));
+					continue;
+				}
+			}
+			int module_start_counter = counter;
+
 			log("Checking module %s...\n", log_id(module));
 
 			SigMap sigmap(module);
@@ -118,7 +221,7 @@ struct CheckPass : public Pass {
 			dict<SigBit, Cell *> driver_cells;
 			dict<SigBit, int> wire_drivers_count;
 			pool<SigBit> used_wires;
-			TopoSort<std::pair<RTLIL::IdString, int>> topo;
+			LoopGraph topo;
 			for (auto &proc_it : module->processes)
 			{
 				std::vector<RTLIL::CaseRule*> all_cases = {&proc_it.second->root_case};
@@ -164,11 +267,11 @@ struct CheckPass : public Pass {
 			}
 
 			struct CircuitEdgesDatabase : AbstractCellEdgesDatabase {
-				TopoSort<std::pair<RTLIL::IdString, int>> &topo;
+				LoopGraph &topo;
 				SigMap sigmap;
 				bool force_detail;
 
-				CircuitEdgesDatabase(TopoSort<std::pair<RTLIL::IdString, int>> &topo, SigMap &sigmap, bool force_detail)
+				CircuitEdgesDatabase(LoopGraph &topo, SigMap &sigmap, bool force_detail)
 					: topo(topo), sigmap(sigmap), force_detail(force_detail) {}
 
 				void add_edge(RTLIL::Cell *cell, RTLIL::IdString from_port, int from_bit,
@@ -329,8 +432,7 @@ struct CheckPass : public Pass {
 					counter++;
 				}
 
-			topo.sort();
-			for (auto &loop : topo.loops) {
+			for (auto &loop : topo.find_loops(parallel_threads(design))) {
 				string message = stringf("found logic loop in module %s:\n", log_id(module));
 
 				// `loop` only contains wire bits, or an occasional special helper node for cells for
@@ -428,6 +530,9 @@ struct CheckPass : public Pass {
 					counter++;
 				}
 			}
+
+			if (cacheable && counter == module_start_counter)
+				module->converged_[cache_key] = module->generation_;
 		}
 
 		log("Found and reported %d problems.\n", counter);
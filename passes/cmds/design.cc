@@ -27,7 +27,7 @@ std::map<std::string, RTLIL::Design*> saved_designs;
 std::vector<RTLIL::Design*> pushed_designs;
 
 struct DesignPass : public Pass {
-	DesignPass() : Pass("design", "save, restore and reset current design") { }
+	DesignPass() : Pass("design", "save, restore and reset current design") { keeps_shared_modules(); }
 	~DesignPass() override {
 		for (auto &it : saved_designs)
 			delete it.second;
@@ -49,6 +49,10 @@ struct DesignPass : public Pass {
 		log("\n");
 		log("Save the current design under the given name.\n");
 		log("\n");
+		log("The modules are not copied right away. They are shared with the saved design\n");
+		log("until the next command that may modify the current design is executed. The\n");
+		log("same applies to the other options that save, load or copy modules.\n");
+		log("\n");
 		log("\n");
 		log("    design -stash <name>\n");
 		log("\n");
@@ -332,6 +336,11 @@ struct DesignPass : public Pass {
 				if (copy_to_design->module(trg_name) != nullptr)
 					copy_to_design->remove(copy_to_design->module(trg_name));
 
+				if (trg_name == mod->name.str()) {
+					copy_to_design->add_shared(mod, copy_to_design == design);
+					continue;
+				}
+
 				RTLIL::Module *t = mod->clone();
 				t->name = trg_name;
 				t->design = copy_to_design;
@@ -344,7 +353,7 @@ struct DesignPass : public Pass {
 			RTLIL::Design *design_copy = new RTLIL::Design;
 
 			for (auto mod : design->modules())
-				design_copy->add(mod->clone());
+				design_copy->add_shared(mod);
 
 			design_copy->selection_stack = design->selection_stack;
 			design_copy->selection_vars = design->selection_vars;
@@ -389,7 +398,7 @@ struct DesignPass : public Pass {
 			RTLIL::Design *saved_design = pop_mode ? pushed_designs.back() : saved_designs.at(load_name);
 
 			for (auto mod : saved_design->modules())
-				design->add(mod->clone());
+				design->add_shared(mod, true);
 
 			design->selection_stack = saved_design->selection_stack;
 			design->selection_vars = saved_design->selection_vars;
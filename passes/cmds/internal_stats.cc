@@ -75,11 +75,27 @@ struct InternalStatsPass : public Pass {
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
-		log("Print internal statistics for developers (experimental)\n");
+		log("\n");
+		log("    internal_stats [options]\n");
+		log("\n");
+		log("Print internal statistics for developers (experimental). This includes the\n");
+		log("size of the IdString table and the kernel event counters (SigSpec packing and\n");
+		log("unpacking, hash table rebuilds, wires and cells created and destroyed) since\n");
+		log("the start of the process.\n");
+		log("\n");
+		log("    -json\n");
+		log("        print the statistics as JSON\n");
+		log("\n");
+		log("    -passes\n");
+		log("        also print the counter changes per pass, excluding nested pass calls\n");
+		log("\n");
+		log("The per-pass counters are also written to the performance log of `yosys -P`.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		bool json_mode = false;
+		bool passes_mode = false;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++)
@@ -88,6 +104,10 @@ struct InternalStatsPass : public Pass {
 				json_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-passes") {
+				passes_mode = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -110,11 +130,39 @@ struct InternalStatsPass : public Pass {
 			log("   \"memory_ast\": %s,\n", std::to_string(ast_bytes).c_str());
 		}
 
-		// stats go here
+		std::vector<Pass*> passes;
+		if (passes_mode)
+			for (auto &it : pass_register)
+				if (it.second->call_counter)
+					passes.push_back(it.second);
 
 		if (json_mode) {
-			log("\n");
+			log("   \"idstrings\": %d,\n", KernelStats::idstring_count());
+			log("   \"kernel_stats\": {");
+			for (int i = 0; i < KernelStats::NUM_COUNTERS; i++)
+				log("%s\"%s\": %llu", i ? ", " : " ", KernelStats::names[i], (unsigned long long) KernelStats::get(KernelStats::counter_t(i)));
+			log(" }%s\n", passes_mode ? "," : "");
+			if (passes_mode) {
+				log("   \"passes\": {\n");
+				for (int i = 0; i < GetSize(passes); i++) {
+					log("      %s: {", json11::Json(passes[i]->pass_name).dump().c_str());
+					for (int j = 0; j < KernelStats::NUM_COUNTERS; j++)
+						log("%s\"%s\": %lld", j ? ", " : " ", KernelStats::names[j], (long long) passes[i]->kernel_stats_delta[j]);
+					log(" }%s\n", i+1 < GetSize(passes) ? "," : "");
+				}
+				log("   }\n");
+			}
 			log("}\n");
+		} else {
+			log("%-20s %12d\n", "idstrings", KernelStats::idstring_count());
+			for (int i = 0; i < KernelStats::NUM_COUNTERS; i++)
+				log("%-20s %12llu\n", KernelStats::names[i], (unsigned long long) KernelStats::get(KernelStats::counter_t(i)));
+			for (auto pass : passes) {
+				log("\nPass %s (%d calls):\n", pass->pass_name.c_str(), pass->call_counter);
+				for (int i = 0; i < KernelStats::NUM_COUNTERS; i++)
+					if (pass->kernel_stats_delta[i])
+						log("  %-18s %+12lld\n", KernelStats::names[i], (long long) pass->kernel_stats_delta[i]);
+			}
 		}
 
 	}
@@ -24,7 +24,7 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 struct LoggerPass : public Pass {
-	LoggerPass() : Pass("logger", "set logger properties") { }
+	LoggerPass() : Pass("logger", "set logger properties") { selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -36,6 +36,18 @@ static RTLIL::SigBit canonical_bit(RTLIL::SigBit bit)
 	return bit;
 }
 
+static inline int ctz64(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(word);
+#else
+	int i = 0;
+	while (!(word & 1))
+		word >>= 1, i++;
+	return i;
+#endif
+}
+
 struct PortarcsPass : Pass {
 	PortarcsPass() : Pass("portarcs", "derive port arcs for propagation delay") {}
 
@@ -139,29 +151,34 @@ struct PortarcsPass : Pass {
 				ordering = sort.sorted;
 			}
 
-			dict<SigBit, int*> annotations;
-			std::vector<std::unique_ptr<int[]>> allocated;
-			std::vector<int*> recycling;
+			// Each bit that is live during the sweep has a slot holding the
+			// set of inputs it depends on, as a bitset, and the maximum delay
+			// from each of them. Delays of inputs not in the set are stale.
+			int n_inputs = inputs.size();
+			int n_words = (n_inputs + 63) / 64;
+			dict<SigBit, int> annotations;
+			std::vector<int> slot_delays;
+			std::vector<uint64_t> slot_reach;
+			std::vector<int> recycling;
+			int n_slots = 0;
 
 			auto alloc_for_bit = [&](SigBit bit) {
 				if (!recycling.empty()) {
 					annotations[bit] = recycling.back();
 					recycling.pop_back();
 				} else {
-					int *p = new int[std::max(1, inputs.size())];
-					allocated.emplace_back(p);
-					annotations[bit] = p;
+					annotations[bit] = n_slots++;
 				}
 			};
 
 			for (auto bit : outputs) {
 				SigBit bit_c = canonical_bit(bit);
-				alloc_for_bit(bit_c);
-
-				// consistency check
-				annotations.at(bit_c)[0] = (intptr_t) bit_c.wire;
+				if (!annotations.count(bit_c))
+					alloc_for_bit(bit_c);
 			}
 
+			// Assign slots backwards, so that a slot is reused once the last
+			// bit reading it was computed.
 			for (int i = ordering.size() - 1; i >= 0; i--) {
 				SigBit bit = ordering[i];
 
@@ -174,48 +191,41 @@ struct PortarcsPass : Pass {
 						auto to = edge.second.get_connection(cell);
 						if (from && to && to.value() == bit) {
 							auto from_c = canonical_bit(from.value());
-							if (from_c.wire) {
-								if (!annotations.count(from_c)) {
-									alloc_for_bit(from_c);
-
-									// consistency check
-									annotations.at(from_c)[0] = (intptr_t) from_c.wire;
-								} else {
-									// consistency check
-									log_assert(annotations.at(from_c)[0] == ((int) (intptr_t) from_c.wire));
-								}
-							}
+							if (from_c.wire && !annotations.count(from_c))
+								alloc_for_bit(from_c);
 						}
 					}
 				}
 
-				if (annotations.count(bit)) {
-					// consistency check
-					log_assert(annotations.at(bit)[0] == ((int) (intptr_t) bit.wire));
-				} else {
+				if (!annotations.count(bit))
 					alloc_for_bit(bit);
-				}
 
 				recycling.push_back(annotations.at(ordering[i]));
 			}
-			log_debug("Allocated %lux%d\n", allocated.size(), inputs.size());
+			log_debug("Allocated %dx%d\n", n_slots, n_inputs);
+			slot_delays.resize(n_slots * n_inputs);
+			slot_reach.resize(n_slots * n_words);
+
+			dict<SigBit, int> input_index;
+			for (int i = 0; i < n_inputs; i++)
+				input_index[inputs[i]] = i;
 
 			for (auto bit : outputs) {
-				int *p = annotations.at(canonical_bit(bit));
-				for (int i = 0; i < inputs.size(); i++)
-					p[i] = -1;
+				uint64_t *reach = slot_reach.data() + annotations.at(canonical_bit(bit)) * n_words;
+				std::fill(reach, reach + n_words, 0);
 			}
 
 			for (int i = 0; i < ordering.size(); i++) {
 				SigBit bit = ordering[i];
-				int *p = annotations.at(bit);
+				int slot = annotations.at(bit);
+				int *p = slot_delays.data() + slot * n_inputs;
+				uint64_t *p_reach = slot_reach.data() + slot * n_words;
+				std::fill(p_reach, p_reach + n_words, 0);
 				if (bit.wire->port_input) {
-					for (int j = 0; j < inputs.size(); j++)
-						p[j] = (j == i) ? 0 : -1;
+					int j = input_index.at(bit);
+					p_reach[j / 64] = uint64_t(1) << (j % 64);
+					p[j] = 0;
 				} else {
-					for (int j = 0; j < inputs.size(); j++)
-						p[j] = -1;
-
 					auto cell = ordering[i].wire->driverCell();
 					auto tdata = tinfo.find(cell->type);
 					log_assert(tdata != tinfo.end());
@@ -225,16 +235,36 @@ struct PortarcsPass : Pass {
 						if (from && to && to.value() == ordering[i]) {
 							auto from_c = canonical_bit(from.value());
 							if (from_c.wire) {
-								int *q = annotations.at(from_c);
-								for (int j = 0; j < inputs.size(); j++)
-									if (q[j] >= 0)
-										p[j] = std::max(p[j], q[j] + delay);
+								int from_slot = annotations.at(from_c);
+								const int *q = slot_delays.data() + from_slot * n_inputs;
+								const uint64_t *q_reach = slot_reach.data() + from_slot * n_words;
+								// only visit the inputs the fanin depends on
+								for (int w = 0; w < n_words; w++) {
+									uint64_t fresh = q_reach[w] & ~p_reach[w];
+									for (uint64_t m = q_reach[w]; m; m &= m - 1) {
+										uint64_t low = m & -m;
+										int j = w * 64 + ctz64(low);
+										if (fresh & low)
+											p[j] = q[j] + delay;
+										else
+											p[j] = std::max(p[j], q[j] + delay);
+									}
+									p_reach[w] |= q_reach[w];
+								}
 							}
 						}
 					}
 				}
 			}
 
+			// the delay of the arc from input i to an output bit, -1 for none
+			auto arc_delay = [&](SigBit bit, int i) {
+				int slot = annotations.at(canonical_bit(bit));
+				if (!(slot_reach[slot * n_words + i / 64] >> (i % 64) & 1))
+					return -1;
+				return slot_delays[slot * n_inputs + i];
+			};
+
 			if (draw_mode) {
 				auto bit_str = [](SigBit bit) {
 					return stringf("%s%d", RTLIL::unescape_id(bit.wire->name.str()).c_str(), bit.offset);
@@ -248,12 +278,9 @@ struct PortarcsPass : Pass {
 				}
 
 				int max_delay = 0;
-				for (auto bit : outputs) {
-					int *p = annotations.at(canonical_bit(bit));
+				for (auto bit : outputs)
 					for (auto i = 0; i < inputs.size(); i++)
-						if (p[i] > max_delay)
-							max_delay = p[i];
-				}
+						max_delay = std::max(max_delay, arc_delay(bit, i));
 
 				log("Delay legend:\n\n");
 				log("    ");
@@ -273,27 +300,26 @@ struct PortarcsPass : Pass {
 
 				for (auto bit : outputs) {
 					log("  %10s  ", bit_str(bit).c_str());
-					int *p = annotations.at(canonical_bit(bit));
 					for (auto i = 0; i < inputs.size(); i++)
-						log("\033[48;5;%dm ", 232 + ((std::max(p[i], 0) * 24) - 1) / max_delay);
+						log("\033[48;5;%dm ", 232 + ((std::max(arc_delay(bit, i), 0) * 24) - 1) / max_delay);
 					log("\033[0m\n");
 				}
 			}
 
 			if (write_mode) {
 				for (auto bit : outputs) {
-					int *p = annotations.at(canonical_bit(bit));
 					for (auto i = 0; i < inputs.size(); i++) {
-						if (p[i] >= 0) {
+						int delay = arc_delay(bit, i);
+						if (delay >= 0) {
 							Cell *spec = m->addCell(NEW_ID, ID($specify2));
 							spec->setParam(ID::SRC_WIDTH, 1);
 							spec->setParam(ID::DST_WIDTH, 1);
-							spec->setParam(ID::T_FALL_MAX, p[i]);
-							spec->setParam(ID::T_FALL_TYP, p[i]);
-							spec->setParam(ID::T_FALL_MIN, p[i]);
-							spec->setParam(ID::T_RISE_MAX, p[i]);
-							spec->setParam(ID::T_RISE_TYP, p[i]);
-							spec->setParam(ID::T_RISE_MIN, p[i]);
+							spec->setParam(ID::T_FALL_MAX, delay);
+							spec->setParam(ID::T_FALL_TYP, delay);
+							spec->setParam(ID::T_FALL_MIN, delay);
+							spec->setParam(ID::T_RISE_MAX, delay);
+							spec->setParam(ID::T_RISE_TYP, delay);
+							spec->setParam(ID::T_RISE_MIN, delay);
 							spec->setParam(ID::SRC_DST_POL, false);
 							spec->setParam(ID::SRC_DST_PEN, false);
 							spec->setParam(ID::FULL, false);
@@ -24,6 +24,7 @@
 #include "kernel/register.h"
 #include "kernel/celltypes.h"
 #include "kernel/sigtools.h"
+#include "kernel/topo_scc.h"
 #include "kernel/log.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -211,6 +212,44 @@ struct SccWorker
 			}
 		}
 
+		if (maxDepth < 0)
+		{
+			// without a depth limit, use the iterative SCC search on a
+			// compact graph, which also copes with very large modules
+			idict<RTLIL::Cell*> cell_ids;
+			for (auto cell : workQueue)
+				cell_ids(cell);
+
+			std::vector<std::pair<int, int>> edges;
+			for (auto cell : workQueue)
+				for (auto nextCell : cellToNextCell[cell])
+					edges.emplace_back(cell_ids.at(cell), cell_ids.at(nextCell));
+
+			CsrGraph graph(GetSize(cell_ids), edges);
+			std::vector<int> scc_index;
+			int num_sccs = csr_sccs(graph, scc_index, Pass::parallel_threads(design));
+
+			std::vector<std::vector<RTLIL::Cell*>> components(num_sccs);
+			for (int i = 0; i < GetSize(cell_ids); i++)
+				components[scc_index[i]].push_back(cell_ids[i]);
+
+			for (auto &cells : components)
+			{
+				if (GetSize(cells) < 2)
+					continue;
+				log("Found an SCC:");
+				pool<RTLIL::Cell*> scc;
+				for (auto c : cells) {
+					log(" %s", RTLIL::id2cstr(c->name));
+					cell2scc[c] = sccList.size();
+					scc.insert(c);
+				}
+				sccList.push_back(scc);
+				log("\n");
+			}
+			workQueue.clear();
+		}
+
 		labelCounter = 0;
 		cellLabels.clear();
 
@@ -26,7 +26,7 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 struct ScratchpadPass : public Pass {
-	ScratchpadPass() : Pass("scratchpad", "get/set values in the scratchpad") { }
+	ScratchpadPass() : Pass("scratchpad", "get/set values in the scratchpad") { selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -62,6 +62,12 @@ struct ScratchpadPass : public Pass {
 		log("by the name of the pass that uses it, e.g. 'opt.did_something'. If the value\n");
 		log("contains whitespace, it must be enclosed in double quotes.\n");
 		log("\n");
+		log("If 'script.checkpoint_dir' is set, script commands such as 'synth' save the\n");
+		log("design in this directory at each label of their script. When the command is\n");
+		log("run again on the same design, it restores the design from the last label that\n");
+		log("is reached by the same commands as before and continues from there.\n");
+		log("The checkpoints are binary RTLIL files, which 'read_rtlil' can also read.\n");
+		log("\n");
 	}
 
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
@@ -30,29 +30,43 @@ using RTLIL::id2cstr;
 
 static std::vector<RTLIL::Selection> work_stack;
 
-static bool match_ids(RTLIL::IdString id, const std::string &pattern)
+// A name pattern, prepared once so that matching it against all objects of
+// a design needs no allocations and only calls patmatch() for names that
+// start with the literal prefix of the pattern.
+struct IdPattern
 {
-	if (id == pattern)
-		return true;
+	std::string pattern, prefix;
+	bool literal;
 
-	const char *id_c = id.c_str();
-	const char *pat_c = pattern.c_str();
-	size_t id_size = strlen(id_c);
-	size_t pat_size = pattern.size();
+	IdPattern(const std::string &pattern) : pattern(pattern)
+	{
+		size_t n = pattern.find_first_of("\\?*[");
+		literal = n == std::string::npos;
+		prefix = pattern.substr(0, n);
+	}
 
-	if (*id_c == '\\' && id_size == 1 + pat_size && memcmp(id_c + 1, pat_c, pat_size) == 0)
-		return true;
-	if (patmatch(pat_c, id_c))
-		return true;
-	if (*id_c == '\\' && patmatch(pat_c, id_c + 1))
-		return true;
-	if (*id_c == '$' && *pat_c == '$') {
-		const char *q = strrchr(id_c, '$');
-		if (pattern == q)
+	bool match_name(const char *name) const
+	{
+		if (literal)
+			return strcmp(name, pattern.c_str()) == 0;
+		return strncmp(name, prefix.c_str(), prefix.size()) == 0 && patmatch(pattern.c_str(), name);
+	}
+
+	bool match(RTLIL::IdString id) const
+	{
+		const char *id_c = id.c_str();
+		if (match_name(id_c))
+			return true;
+		if (*id_c == '\\' && match_name(id_c + 1))
 			return true;
+		if (*id_c == '$' && pattern[0] == '$') {
+			const char *q = strrchr(id_c, '$');
+			if (pattern == q)
+				return true;
+		}
+		return false;
 	}
-	return false;
-}
+};
 
 static bool match_attr_val(const RTLIL::Const &value, const std::string &pattern, char match_op)
 {
@@ -431,6 +445,21 @@ static int parse_comma_list(std::set<RTLIL::IdString> &tokens, const std::string
 	}
 }
 
+static bool expand_rules_match(const std::vector<expand_rule_t> &rules, RTLIL::Cell *cell, RTLIL::IdString port, bool eval_only)
+{
+	if (eval_only && !yosys_celltypes.cell_evaluable(cell->type))
+		return false;
+	for (auto &rule : rules) {
+		if (rule.cell_types.size() > 0 && rule.cell_types.count(cell->type) == 0)
+			continue;
+		if (rule.port_names.size() > 0 && rule.port_names.count(port) == 0)
+			continue;
+		return rule.mode == '+';
+	}
+	// with a trailing '+' rule only explicitly included ports are followed
+	return rules.empty() || rules.back().mode != '+';
+}
+
 static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::vector<expand_rule_t> &rules, std::set<RTLIL::IdString> &limits, int max_objects, char mode, CellTypes &ct, bool eval_only)
 {
 	int sel_objects = 0;
@@ -440,11 +469,14 @@ static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::v
 		if (lhs.selected_whole_module(mod->name) || !lhs.selected_module(mod->name))
 			continue;
 
-		std::set<RTLIL::Wire*> selected_wires;
-		auto selected_members = lhs.selected_members[mod->name];
+		// new members go to lhs_members, the checks below use the snapshot
+		// taken before this round so every call expands by one level
+		auto &lhs_members = lhs.selected_members[mod->name];
+		auto selected_members = lhs_members;
+		pool<RTLIL::Wire*> selected_wires;
 
 		for (auto wire : mod->wires())
-			if (lhs.selected_member(mod->name, wire->name) && limits.count(wire->name) == 0)
+			if (selected_members.count(wire->name) && limits.count(wire->name) == 0)
 				selected_wires.insert(wire);
 
 		for (auto &conn : mod->connections())
@@ -456,50 +488,124 @@ static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::v
 				if (conn_lhs[i].wire == nullptr || conn_rhs[i].wire == nullptr)
 					continue;
 				if (mode != 'i' && selected_wires.count(conn_rhs[i].wire) && selected_members.count(conn_lhs[i].wire->name) == 0)
-					lhs.selected_members[mod->name].insert(conn_lhs[i].wire->name), sel_objects++, max_objects--;
+					lhs_members.insert(conn_lhs[i].wire->name), sel_objects++, max_objects--;
 				if (mode != 'o' && selected_wires.count(conn_lhs[i].wire) && selected_members.count(conn_rhs[i].wire->name) == 0)
-					lhs.selected_members[mod->name].insert(conn_rhs[i].wire->name), sel_objects++, max_objects--;
+					lhs_members.insert(conn_rhs[i].wire->name), sel_objects++, max_objects--;
 			}
 		}
 
 		for (auto cell : mod->cells())
 		for (auto &conn : cell->connections())
 		{
-			char last_mode = '-';
-			if (eval_only && !yosys_celltypes.cell_evaluable(cell->type))
-				goto exclude_match;
-			for (auto &rule : rules) {
-				last_mode = rule.mode;
-				if (rule.cell_types.size() > 0 && rule.cell_types.count(cell->type) == 0)
-					continue;
-				if (rule.port_names.size() > 0 && rule.port_names.count(conn.first) == 0)
-					continue;
-				if (rule.mode == '+')
-					goto include_match;
-				else
-					goto exclude_match;
-			}
-			if (last_mode == '+')
-				goto exclude_match;
-		include_match:
+			if (!expand_rules_match(rules, cell, conn.first, eval_only))
+				continue;
 			is_input = mode == 'x' || ct.cell_input(cell->type, conn.first);
 			is_output = mode == 'x' || ct.cell_output(cell->type, conn.first);
 			for (auto &chunk : conn.second.chunks())
 				if (chunk.wire != nullptr) {
 					if (max_objects != 0 && selected_wires.count(chunk.wire) > 0 && selected_members.count(cell->name) == 0)
 						if (mode == 'x' || (mode == 'i' && is_output) || (mode == 'o' && is_input))
-							lhs.selected_members[mod->name].insert(cell->name), sel_objects++, max_objects--;
+							lhs_members.insert(cell->name), sel_objects++, max_objects--;
 					if (max_objects != 0 && selected_members.count(cell->name) > 0 && limits.count(cell->name) == 0 && selected_members.count(chunk.wire->name) == 0)
 						if (mode == 'x' || (mode == 'i' && is_input) || (mode == 'o' && is_output))
-							lhs.selected_members[mod->name].insert(chunk.wire->name), sel_objects++, max_objects--;
+							lhs_members.insert(chunk.wire->name), sel_objects++, max_objects--;
 				}
-		exclude_match:;
 		}
 	}
 
 	return sel_objects;
 }
 
+// Expand by up to the given number of levels without an object limit. The
+// connectivity of every module is indexed once, and then each level only
+// visits the neighbours of the objects added by the previous level, instead
+// of scanning the whole module for every level.
+static void select_op_expand_indexed(RTLIL::Design *design, RTLIL::Selection &lhs, std::vector<expand_rule_t> &rules, std::set<RTLIL::IdString> &limits, int levels, char mode, CellTypes &ct, bool eval_only)
+{
+	for (auto mod : design->modules())
+	{
+		if (lhs.selected_whole_module(mod->name) || !lhs.selected_module(mod->name))
+			continue;
+
+		auto &lhs_members = lhs.selected_members[mod->name];
+		dict<RTLIL::Wire*, std::vector<RTLIL::Wire*>> wire_wires;
+		dict<RTLIL::Wire*, std::vector<RTLIL::Cell*>> wire_cells;
+		dict<RTLIL::Cell*, std::vector<RTLIL::Wire*>> cell_wires;
+
+		for (auto &conn : mod->connections())
+			for (int i = 0; i < GetSize(conn.first); i++) {
+				RTLIL::Wire *l = conn.first[i].wire, *r = conn.second[i].wire;
+				if (l == nullptr || r == nullptr)
+					continue;
+				if (mode != 'i')
+					wire_wires[r].push_back(l);
+				if (mode != 'o')
+					wire_wires[l].push_back(r);
+			}
+
+		for (auto cell : mod->cells())
+		for (auto &conn : cell->connections())
+		{
+			if (!expand_rules_match(rules, cell, conn.first, eval_only))
+				continue;
+			bool is_input = mode == 'x' || ct.cell_input(cell->type, conn.first);
+			bool is_output = mode == 'x' || ct.cell_output(cell->type, conn.first);
+			bool to_cell = mode == 'x' || (mode == 'i' && is_output) || (mode == 'o' && is_input);
+			bool to_wire = mode == 'x' || (mode == 'i' && is_input) || (mode == 'o' && is_output);
+			for (auto &chunk : conn.second.chunks())
+				if (chunk.wire != nullptr) {
+					if (to_cell)
+						wire_cells[chunk.wire].push_back(cell);
+					if (to_wire)
+						cell_wires[cell].push_back(chunk.wire);
+				}
+		}
+
+		std::vector<RTLIL::Wire*> wire_frontier;
+		std::vector<RTLIL::Cell*> cell_frontier;
+		for (auto wire : mod->wires())
+			if (lhs_members.count(wire->name))
+				wire_frontier.push_back(wire);
+		for (auto cell : mod->cells())
+			if (lhs_members.count(cell->name))
+				cell_frontier.push_back(cell);
+
+		for (int level = 0; level < levels && (!wire_frontier.empty() || !cell_frontier.empty()); level++)
+		{
+			std::vector<RTLIL::Wire*> new_wires;
+			std::vector<RTLIL::Cell*> new_cells;
+
+			for (auto wire : wire_frontier) {
+				if (limits.count(wire->name))
+					continue;
+				auto it = wire_wires.find(wire);
+				if (it != wire_wires.end())
+					for (auto other : it->second)
+						if (lhs_members.insert(other->name).second)
+							new_wires.push_back(other);
+				auto jt = wire_cells.find(wire);
+				if (jt != wire_cells.end())
+					for (auto cell : jt->second)
+						if (lhs_members.insert(cell->name).second)
+							new_cells.push_back(cell);
+			}
+
+			for (auto cell : cell_frontier) {
+				if (limits.count(cell->name))
+					continue;
+				auto it = cell_wires.find(cell);
+				if (it != cell_wires.end())
+					for (auto wire : it->second)
+						if (lhs_members.insert(wire->name).second)
+							new_wires.push_back(wire);
+			}
+
+			wire_frontier.swap(new_wires);
+			cell_frontier.swap(new_cells);
+		}
+	}
+}
+
 static void select_op_expand(RTLIL::Design *design, const std::string &arg, char mode, bool eval_only)
 {
 	int pos = (mode == 'x' ? 2 : 3) + (eval_only ? 1 : 0);
@@ -593,6 +699,11 @@ static void select_op_expand(RTLIL::Design *design, const std::string &arg, char
 	}
 #endif
 
+	if (rem_objects < 0) {
+		select_op_expand_indexed(design, work_stack.back(), rules, limits, levels, mode, ct, eval_only);
+		return;
+	}
+
 	while (levels-- > 0 && rem_objects != 0) {
 		int num_objects = select_op_expand(design, work_stack.back(), rules, limits, rem_objects, mode, ct, eval_only);
 		if (num_objects == 0)
@@ -804,6 +915,10 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 		return;
 	}
 
+	IdPattern mod_pattern(arg_mod.compare(0, 2, "N:") == 0 ? arg_mod.substr(2) : arg_mod);
+	bool memb_prefixed = GetSize(arg_memb) >= 2 && arg_memb[1] == ':' && strchr("wioxmctpn", arg_memb[0]);
+	IdPattern memb_pattern(memb_prefixed ? arg_memb.substr(2) : arg_memb);
+
 	sel.full_selection = false;
 	for (auto mod : design->modules())
 	{
@@ -815,10 +930,10 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 				continue;
 		} else
 		if (arg_mod.compare(0, 2, "N:") == 0) {
-			if (!match_ids(mod->name, arg_mod.substr(2)))
+			if (!mod_pattern.match(mod->name))
 				continue;
 		} else
-		if (!match_ids(mod->name, arg_mod))
+		if (!mod_pattern.match(mod->name))
 			continue;
 		else
 			arg_mod_found[arg_mod] = true;
@@ -828,24 +943,27 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 			continue;
 		}
 
+		// matching members needs the contents of a spilled module
+		design->unspill(mod);
+
 		if (arg_memb.compare(0, 2, "w:") == 0) {
 			for (auto wire : mod->wires())
-				if (match_ids(wire->name, arg_memb.substr(2)))
+				if (memb_pattern.match(wire->name))
 					sel.selected_members[mod->name].insert(wire->name);
 		} else
 		if (arg_memb.compare(0, 2, "i:") == 0) {
 			for (auto wire : mod->wires())
-				if (wire->port_input && match_ids(wire->name, arg_memb.substr(2)))
+				if (wire->port_input && memb_pattern.match(wire->name))
 					sel.selected_members[mod->name].insert(wire->name);
 		} else
 		if (arg_memb.compare(0, 2, "o:") == 0) {
 			for (auto wire : mod->wires())
-				if (wire->port_output && match_ids(wire->name, arg_memb.substr(2)))
+				if (wire->port_output && memb_pattern.match(wire->name))
 					sel.selected_members[mod->name].insert(wire->name);
 		} else
 		if (arg_memb.compare(0, 2, "x:") == 0) {
 			for (auto wire : mod->wires())
-				if ((wire->port_input || wire->port_output) && match_ids(wire->name, arg_memb.substr(2)))
+				if ((wire->port_input || wire->port_output) && memb_pattern.match(wire->name))
 					sel.selected_members[mod->name].insert(wire->name);
 		} else
 		if (arg_memb.compare(0, 2, "s:") == 0) {
@@ -867,12 +985,12 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 		} else
 		if (arg_memb.compare(0, 2, "m:") == 0) {
 			for (auto &it : mod->memories)
-				if (match_ids(it.first, arg_memb.substr(2)))
+				if (memb_pattern.match(it.first))
 					sel.selected_members[mod->name].insert(it.first);
 		} else
 		if (arg_memb.compare(0, 2, "c:") == 0) {
 			for (auto cell : mod->cells())
-				if (match_ids(cell->name, arg_memb.substr(2)))
+				if (memb_pattern.match(cell->name))
 					sel.selected_members[mod->name].insert(cell->name);
 		} else
 		if (arg_memb.compare(0, 2, "t:") == 0) {
@@ -887,13 +1005,13 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 						sel.selected_members[mod->name].insert(cell->name);
 			} else {
 				for (auto cell : mod->cells())
-					if (match_ids(cell->type, arg_memb.substr(2)))
+					if (memb_pattern.match(cell->type))
 						sel.selected_members[mod->name].insert(cell->name);
 			}
 		} else
 		if (arg_memb.compare(0, 2, "p:") == 0) {
 			for (auto &it : mod->processes)
-				if (match_ids(it.first, arg_memb.substr(2)))
+				if (memb_pattern.match(it.first))
 					sel.selected_members[mod->name].insert(it.first);
 		} else
 		if (arg_memb.compare(0, 2, "a:") == 0) {
@@ -919,22 +1037,22 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 			if (arg_memb.compare(0, 2, "n:") == 0)
 				arg_memb = arg_memb.substr(2);
 			for (auto wire : mod->wires())
-				if (match_ids(wire->name, arg_memb)) {
+				if (memb_pattern.match(wire->name)) {
 					sel.selected_members[mod->name].insert(wire->name);
 					arg_memb_found[orig_arg_memb] = true;
 				}
 			for (auto &it : mod->memories)
-				if (match_ids(it.first, arg_memb)) {
+				if (memb_pattern.match(it.first)) {
 					sel.selected_members[mod->name].insert(it.first);
 					arg_memb_found[orig_arg_memb] = true;
 				}
 			for (auto cell : mod->cells())
-				if (match_ids(cell->name, arg_memb)) {
+				if (memb_pattern.match(cell->name)) {
 					sel.selected_members[mod->name].insert(cell->name);
 					arg_memb_found[orig_arg_memb] = true;
 				}
 			for (auto &it : mod->processes)
-				if (match_ids(it.first, arg_memb)) {
+				if (memb_pattern.match(it.first)) {
 					sel.selected_members[mod->name].insert(it.first);
 					arg_memb_found[orig_arg_memb] = true;
 				}
@@ -961,6 +1079,7 @@ static std::string describe_selection_for_assert(RTLIL::Design *design, RTLIL::S
 	for (auto mod : design->modules())
 	{
 		if (sel->selected_module(mod->name)) {
+			design->unspill(mod);
 			if (whole_modules && sel->selected_whole_module(mod->name))
 					desc += stringf("%s\n", id2cstr(mod->name));
 			for (auto wire : mod->wires())
@@ -1033,7 +1152,7 @@ YOSYS_NAMESPACE_END
 PRIVATE_NAMESPACE_BEGIN
 
 struct SelectPass : public Pass {
-	SelectPass() : Pass("select", "modify and view the list of selected objects") { }
+	SelectPass() : Pass("select", "modify and view the list of selected objects") { keeps_shared_modules(); selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -1474,6 +1593,7 @@ struct SelectPass : public Pass {
 				if (sel->selected_whole_module(mod->name) && list_mode)
 					log("%s\n", id2cstr(mod->name));
 				if (sel->selected_module(mod->name) && !list_mod_mode) {
+					design->unspill(mod);
 					for (auto wire : mod->wires())
 						if (sel->selected_member(mod->name, wire->name))
 							LOG_OBJECT("%s/%s\n", id2cstr(mod->name), id2cstr(wire->name))
@@ -1556,6 +1676,7 @@ struct SelectPass : public Pass {
 			sel->optimize(design);
 			for (auto mod : design->modules())
 				if (sel->selected_module(mod->name)) {
+					design->unspill(mod);
 					module_count++;
 					for (auto wire : mod->wires())
 						if (sel->selected_member(mod->name, wire->name))
@@ -1630,7 +1751,7 @@ struct SelectPass : public Pass {
 } SelectPass;
 
 struct CdPass : public Pass {
-	CdPass() : Pass("cd", "a shortcut for 'select -module <name>'") { }
+	CdPass() : Pass("cd", "a shortcut for 'select -module <name>'") { keeps_shared_modules(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -1738,7 +1859,7 @@ static void log_matches(const char *title, Module *module, const T &list)
 }
 
 struct LsPass : public Pass {
-	LsPass() : Pass("ls", "list modules or objects in modules") { }
+	LsPass() : Pass("ls", "list modules or objects in modules") { keeps_shared_modules(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
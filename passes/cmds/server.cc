@@ -0,0 +1,337 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+
+#if !defined(_WIN32)
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <sys/un.h>
+#  include <sys/wait.h>
+#  include <poll.h>
+#  include <signal.h>
+#  include <unistd.h>
+#  include <fstream>
+#endif
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+#if !defined(_WIN32)
+
+#ifdef MSG_NOSIGNAL
+#  define SEND_FLAGS MSG_NOSIGNAL
+#else
+#  define SEND_FLAGS 0
+#endif
+
+std::string job_script_file;
+
+void remove_job_script()
+{
+	remove(job_script_file.c_str());
+}
+
+struct ServerWorker
+{
+	Design *design;
+	std::string socket_path;
+	int max_jobs;
+	int max_requests;
+	bool inherit;
+
+	int listen_fd = -1;
+	dict<pid_t, int> running;
+	int finished = 0, failed = 0;
+
+	ServerWorker(Design *design, std::string socket_path, int max_jobs, int max_requests, bool inherit) :
+			design(design), socket_path(socket_path), max_jobs(max_jobs), max_requests(max_requests), inherit(inherit) { }
+
+	void listen()
+	{
+		struct sockaddr_un addr;
+		if (socket_path.size() >= sizeof(addr.sun_path))
+			log_cmd_error("Socket path '%s' is too long.\n", socket_path.c_str());
+
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+		listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listen_fd < 0)
+			log_cmd_error("Failed to create socket: %s\n", strerror(errno));
+
+		// only replace the socket of an earlier server, never another file
+		struct stat st;
+		if (lstat(socket_path.c_str(), &st) == 0) {
+			if (!S_ISSOCK(st.st_mode)) {
+				close(listen_fd);
+				log_cmd_error("'%s' exists and is not a socket.\n", socket_path.c_str());
+			}
+			unlink(socket_path.c_str());
+		}
+		if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(listen_fd, 64) != 0) {
+			int err = errno;
+			close(listen_fd);
+			log_cmd_error("Failed to listen on socket '%s': %s\n", socket_path.c_str(), strerror(err));
+		}
+	}
+
+	std::string read_script(int fd)
+	{
+		std::string script;
+		char buffer[4096];
+		while (1) {
+			ssize_t n = read(fd, buffer, sizeof(buffer));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				break;
+			script.append(buffer, n);
+		}
+		return script;
+	}
+
+	// Runs in the forked child: everything the job logs goes to the
+	// connection, and the job starts from a design of its own. The warm
+	// caches of the server process are shared copy-on-write.
+	[[noreturn]] void run_job(int fd)
+	{
+		close(listen_fd);
+		for (auto &it : running)
+			close(it.second);
+
+		std::string script = read_script(fd);
+
+		FILE *f = fdopen(fd, "w");
+		if (f == nullptr)
+			_exit(1);
+
+		log_files.clear();
+		log_files.push_back(f);
+		log_streams.clear();
+		log_scratchpads.clear();
+		log_hasher = nullptr;
+		log_errfile = nullptr;
+		log_warnings_count = 0;
+
+		if (!inherit) {
+			design = yosys_design = new RTLIL::Design;
+			saved_designs.clear();
+			pushed_designs.clear();
+		}
+
+		job_script_file = make_temp_file(get_base_tmpdir() + "/yosys_server_XXXXXX");
+		{
+			std::ofstream script_file(job_script_file);
+			script_file << script;
+		}
+
+		log_error_atexit = remove_job_script;
+		run_frontend(job_script_file, "script", design);
+		remove_job_script();
+
+		log("\nEnd of script.\n");
+		log_flush();
+		fclose(f);
+		_exit(0);
+	}
+
+	void reap(bool block)
+	{
+		while (!running.empty())
+		{
+			int status;
+			pid_t pid = waitpid(-1, &status, block ? 0 : WNOHANG);
+			if (pid <= 0)
+				break;
+
+			auto it = running.find(pid);
+			if (it == running.end())
+				continue;
+
+			int code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+			std::string trailer = stringf("YOSYS_SERVER_STATUS %d\n", code);
+			if (send(it->second, trailer.data(), trailer.size(), SEND_FLAGS) < 0)
+				log_warning("Failed to send the status of job %d.\n", int(pid));
+			close(it->second);
+			running.erase(it);
+
+			finished++;
+			if (code != 0)
+				failed++;
+			log("Job %d finished with status %d (%d running).\n", int(pid), code, GetSize(running));
+			log_flush();
+			block = false;
+		}
+	}
+
+	void run()
+	{
+		// a client that closes the connection early must not kill the
+		// server or the job writing its log there, the write fails instead
+		void (*old_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+
+		// the builtin techmap rules are read by most synthesis scripts
+		RTLIL::Design warm_design;
+		Pass::call(&warm_design, "techmap");
+
+		listen();
+		log("Listening on %s with up to %d concurrent jobs.\n", socket_path.c_str(), max_jobs);
+		log_flush();
+
+		int accepted = 0;
+		while (max_requests <= 0 || accepted < max_requests)
+		{
+			if (GetSize(running) >= max_jobs) {
+				reap(true);
+				continue;
+			}
+
+			struct pollfd pfd = { listen_fd, POLLIN, 0 };
+			int ready = poll(&pfd, 1, running.empty() ? -1 : 100);
+			reap(false);
+			if (ready <= 0)
+				continue;
+
+			int fd = accept(listen_fd, nullptr, nullptr);
+			if (fd < 0) {
+				if (errno != EINTR && errno != EAGAIN)
+					log_warning("Failed to accept a connection: %s\n", strerror(errno));
+				continue;
+			}
+
+			log_flush();
+			pid_t pid = fork();
+			if (pid == 0)
+				run_job(fd);
+
+			if (pid < 0) {
+				log_warning("Failed to fork a job: %s\n", strerror(errno));
+				close(fd);
+				continue;
+			}
+
+			running[pid] = fd;
+			accepted++;
+		}
+
+		while (!running.empty())
+			reap(true);
+
+		close(listen_fd);
+		unlink(socket_path.c_str());
+		signal(SIGPIPE, old_sigpipe);
+		log("Served %d jobs, %d of them failed.\n", finished, failed);
+	}
+};
+
+#endif
+
+struct ServerPass : public Pass {
+	ServerPass() : Pass("server", "run scripts received over a socket") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    server [options] <socket>\n");
+		log("\n");
+		log("This command listens on the Unix domain socket <socket> and runs each script\n");
+		log("it receives as a separate job. A client connects, sends the script, closes its\n");
+		log("side of the connection for writing, and then reads the log of the job from\n");
+		log("the connection until it is closed. The last line is 'YOSYS_SERVER_STATUS <n>'\n");
+		log("with the exit status of the job. For example:\n");
+		log("\n");
+		log("    socat -t 3600 - UNIX-CONNECT:yosys.sock < job.ys\n");
+		log("\n");
+		log("Every job runs in a process forked from the server and starts with an empty\n");
+		log("design, so jobs can't influence each other or the server. Everything that was\n");
+		log("loaded before the server was started is inherited without being loaded again:\n");
+		log("plugins, the parsed cells of liberty files, the Verilog include cache, and\n");
+		log("the share directory and executable lookups. This saves the startup cost of a\n");
+		log("new yosys process for every job, which dominates short jobs.\n");
+		log("\n");
+		log("The same holds for the map files kept by 'techmap' and the libraries kept by\n");
+		log("'memory_libmap'. What a job loads into these caches is lost when it ends, so\n");
+		log("the server reads the builtin techmap rules (+/techmap.v) once at startup.\n");
+		log("Other files can be loaded before the server is started by calling the\n");
+		log("commands on an empty design, for example:\n");
+		log("\n");
+		log("    yosys -p 'techmap -map +/ice40/cells_map.v; memory_libmap -lib +/ice40/brams.txt' \\\n");
+		log("        --server yosys.sock\n");
+		log("\n");
+		log("    -j <N>\n");
+		log("        run up to N jobs at the same time. The default is the number of\n");
+		log("        threads set with 'yosys -j' or the number of CPUs.\n");
+		log("\n");
+		log("    -inherit\n");
+		log("        start every job with a copy of the current design instead of an\n");
+		log("        empty design, e.g. for cell libraries loaded with 'read_liberty -lib'\n");
+		log("        or 'read_verilog -lib' before the server was started\n");
+		log("\n");
+		log("    -count <N>\n");
+		log("        stop after N jobs were served (default: run until killed)\n");
+		log("\n");
+		log("This command is also available as 'yosys --server <socket>'. It is not\n");
+		log("available on Windows.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		int max_jobs = 0;
+		int max_requests = 0;
+		bool inherit = false;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				max_jobs = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-count" && argidx+1 < args.size()) {
+				max_requests = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-inherit") {
+				inherit = true;
+				continue;
+			}
+			break;
+		}
+		if (argidx+1 != args.size())
+			cmd_error(args, argidx, "Expected exactly one socket path.");
+
+		log_header(design, "Executing SERVER pass.\n");
+
+#if defined(_WIN32)
+		log_cmd_error("The server command is not available on Windows.\n");
+#else
+		if (max_jobs <= 0)
+			max_jobs = parallel_threads(design);
+
+		// the background log writer does not survive fork()
+		log_async_end();
+
+		ServerWorker worker(design, args[argidx], std::max(max_jobs, 1), max_requests, inherit);
+		worker.run();
+#endif
+	}
+} ServerPass;
+
+PRIVATE_NAMESPACE_END
@@ -20,6 +20,7 @@
 #include "kernel/register.h"
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
+#include "kernel/sigtools.h"
 #include <string.h>
 
 #ifndef _WIN32
@@ -66,8 +67,14 @@ struct ShowWorker
 	bool abbreviateIds;
 	bool notitle;
 	bool href;
+	int limit;
 	int page_counter;
 
+	// with a cell limit, the part of the module that is drawn
+	bool limited;
+	pool<RTLIL::Cell*> shown_cells;
+	pool<RTLIL::Wire*> shown_wires;
+
 	const std::vector<std::pair<std::string, RTLIL::Selection>> &color_selections;
 	const std::vector<std::pair<std::string, RTLIL::Selection>> &label_selections;
 
@@ -240,7 +247,7 @@ struct ShowWorker
 
 		if (sig.is_chunk()) {
 			const RTLIL::SigChunk &c = sig.as_chunk();
-			if (c.wire != nullptr && design->selected_member(module->name, c.wire->name)) {
+			if (c.wire != nullptr && shown(c.wire)) {
 				if (!range_check || c.wire->width == c.width)
 						return stringf("n%d", id2num(c.wire->name));
 			} else {
@@ -412,8 +419,78 @@ struct ShowWorker
 			collect_proc_signals(it, input_signals, output_signals);
 	}
 
+	bool shown(RTLIL::Wire *wire)
+	{
+		return design->selected_member(module->name, wire->name) && (!limited || shown_wires.count(wire));
+	}
+
+	// Pick the cells to draw when there are more selected cells than the limit.
+	// The input cones of the module outputs are walked breadth-first, so the
+	// cells closest to the outputs are drawn, and cells outside of all output
+	// cones fill the rest of the budget. Wires are drawn if they connect to a
+	// drawn cell, other signals at the border of the drawn part are shown as
+	// labelled stubs.
+	void apply_limit()
+	{
+		limited = false;
+		shown_cells.clear();
+		shown_wires.clear();
+
+		if (limit < 0)
+			return;
+
+		std::vector<RTLIL::Cell*> cells = module->selected_cells();
+		if (GetSize(cells) <= limit)
+			return;
+		limited = true;
+
+		SigMap sigmap(module);
+		dict<RTLIL::SigBit, RTLIL::Cell*> drivers;
+		for (auto cell : cells)
+			for (auto &conn : cell->connections())
+				if (ct.cell_output(cell->type, conn.first))
+					for (auto bit : sigmap(conn.second))
+						drivers[bit] = cell;
+
+		std::vector<RTLIL::Cell*> queue;
+		auto visit = [&](const RTLIL::SigSpec &sig) {
+			for (auto bit : sigmap(sig)) {
+				auto it = drivers.find(bit);
+				if (it == drivers.end() || GetSize(shown_cells) >= limit)
+					continue;
+				if (shown_cells.insert(it->second).second)
+					queue.push_back(it->second);
+			}
+		};
+
+		for (auto wire : module->selected_wires())
+			if (wire->port_output)
+				visit(wire);
+		for (int i = 0; i < GetSize(queue); i++)
+			for (auto &conn : queue[i]->connections())
+				if (!ct.cell_output(queue[i]->type, conn.first))
+					visit(conn.second);
+		for (auto cell : cells)
+			if (GetSize(shown_cells) < limit)
+				shown_cells.insert(cell);
+
+		for (auto wire : module->wires())
+			if (wire->port_id)
+				shown_wires.insert(wire);
+		for (auto cell : shown_cells)
+			for (auto &conn : cell->connections())
+				for (auto &c : conn.second.chunks())
+					if (c.wire != nullptr)
+						shown_wires.insert(c.wire);
+
+		log("Showing %d of %d selected cells of module %s, starting at its outputs.\n",
+				GetSize(shown_cells), GetSize(cells), log_id(module));
+	}
+
 	void handle_module()
 	{
+		apply_limit();
+
 		single_idx_count = 0;
 		dot_escape_store.clear();
 		dot_id2num_store.clear();
@@ -429,6 +506,8 @@ struct ShowWorker
 
 		std::map<std::string, std::string> wires_on_demand;
 		for (auto wire : module->selected_wires()) {
+			if (!shown(wire))
+				continue;
 			const char *shape = "diamond";
 			if (wire->port_input || wire->port_output)
 				shape = "octagon";
@@ -462,8 +541,14 @@ struct ShowWorker
 			fprintf(f, "}\n");
 		}
 
+		int omitted_cells = 0;
 		for (auto cell : module->selected_cells())
 		{
+			if (limited && !shown_cells.count(cell)) {
+				omitted_cells++;
+				continue;
+			}
+
 			std::vector<RTLIL::IdString> in_ports, out_ports;
 			std::vector<std::string> in_label_pieces, out_label_pieces;
 
@@ -515,6 +600,9 @@ struct ShowWorker
 						id2num(cell->name), label_string.c_str(), findColor(cell->name).c_str(), src_href.c_str(), code.c_str());
 		}
 
+		if (omitted_cells > 0)
+			fprintf(f, "v%d [ shape=note, label=\"%d more cells not shown\" ];\n", single_idx_count++, omitted_cells);
+
 		for (auto &it : module->processes)
 		{
 			RTLIL::Process *proc = it.second;
@@ -555,12 +643,12 @@ struct ShowWorker
 		{
 			bool found_lhs_wire = false;
 			for (auto &c : conn.first.chunks()) {
-				if (c.wire == nullptr || design->selected_member(module->name, c.wire->name))
+				if (c.wire == nullptr || shown(c.wire))
 					found_lhs_wire = true;
 			}
 			bool found_rhs_wire = false;
 			for (auto &c : conn.second.chunks()) {
-				if (c.wire == nullptr || design->selected_member(module->name, c.wire->name))
+				if (c.wire == nullptr || shown(c.wire))
 					found_rhs_wire = true;
 			}
 			if (!found_lhs_wire || !found_rhs_wire)
@@ -617,12 +705,12 @@ struct ShowWorker
 	}
 
 	ShowWorker(FILE *f, RTLIL::Design *design, std::vector<RTLIL::Design*> &libs, uint32_t colorSeed, bool genWidthLabels,
-			bool genSignedLabels, bool stretchIO, bool enumerateIds, bool abbreviateIds, bool notitle, bool href,
+			bool genSignedLabels, bool stretchIO, bool enumerateIds, bool abbreviateIds, bool notitle, bool href, int limit,
 			const std::vector<std::pair<std::string, RTLIL::Selection>> &color_selections,
 			const std::vector<std::pair<std::string, RTLIL::Selection>> &label_selections, RTLIL::IdString colorattr) :
 			f(f), design(design), currentColor(colorSeed), genWidthLabels(genWidthLabels),
 			genSignedLabels(genSignedLabels), stretchIO(stretchIO), enumerateIds(enumerateIds), abbreviateIds(abbreviateIds),
-			notitle(notitle), href(href), color_selections(color_selections), label_selections(label_selections), colorattr(colorattr)
+			notitle(notitle), href(href), limit(limit), limited(false), color_selections(color_selections), label_selections(label_selections), colorattr(colorattr)
 	{
 		ct.setup_internals();
 		ct.setup_internals_mem();
@@ -739,6 +827,12 @@ struct ShowPass : public Pass {
 		log("        adds href attribute to all items representing cells and wires, using\n");
 		log("        src attribute of origin\n");
 		log("\n");
+		log("    -limit <N>\n");
+		log("        draw at most N cells per module. When more cells are selected, the\n");
+		log("        cells closest to the module outputs are drawn (walking their input\n");
+		log("        cones), and a note gives the number of cells left out. This keeps\n");
+		log("        the graph small enough for graphviz on large modules.\n");
+		log("\n");
 		log("When no <format> is specified, 'dot' is used. When no <format> and <viewer> is\n");
 		log("specified, 'xdot' is used to display the schematic (POSIX systems only).\n");
 		log("\n");
@@ -777,6 +871,7 @@ struct ShowPass : public Pass {
 		bool flag_abbreviate = true;
 		bool flag_notitle = false;
 		bool flag_href = false;
+		int limit = -1;
 		bool custom_prefix = false;
 		std::string background = "&";
 		RTLIL::IdString colorattr;
@@ -868,6 +963,10 @@ struct ShowPass : public Pass {
 				flag_href = true;
 				continue;
 			}
+			if (arg == "-limit" && argidx+1 < args.size()) {
+				limit = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -912,7 +1011,7 @@ struct ShowPass : public Pass {
 				delete lib;
 			log_cmd_error("Can't open dot file `%s' for writing.\n", dot_file.c_str());
 		}
-		ShowWorker worker(f, design, libs, colorSeed, flag_width, flag_signed, flag_stretch, flag_enum, flag_abbreviate, flag_notitle, flag_href, color_selections, label_selections, colorattr);
+		ShowWorker worker(f, design, libs, colorSeed, flag_width, flag_signed, flag_stretch, flag_enum, flag_abbreviate, flag_notitle, flag_href, limit, color_selections, label_selections, colorattr);
 		fclose(f);
 
 		for (auto lib : libs)
@@ -0,0 +1,160 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/register.h"
+#include "kernel/spill.h"
+#include "kernel/log.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct SpillPass : public Pass {
+	SpillPass() : Pass("spill", "move modules out of memory until they are used") { selection_safe(); }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    spill [options] [selection]\n");
+		log("\n");
+		log("Write the selected modules to files on disk and replace them in memory by\n");
+		log("stubs that only keep the ports, parameters and attributes. Before a command\n");
+		log("runs, all spilled modules are read back, unless the command is known to only\n");
+		log("look at the modules it works on (e.g. 'opt' and its sub-passes, 'select').\n");
+		log("Those commands read a spilled module back when they look it up by name or\n");
+		log("check whether it is selected. No command ever sees a stub in place of the\n");
+		log("module, so the results of a script do not change, only the peak memory use.\n");
+		log("\n");
+		log("    -dir <dir>\n");
+		log("        write the files to <dir>. By default a temporary directory is used,\n");
+		log("        which is removed again by 'spill -off' or when the design is deleted.\n");
+		log("        the directory can only be set before the first module is spilled.\n");
+		log("\n");
+		log("    -budget <cells>\n");
+		log("        do not spill the selected modules now, but keep at most this many\n");
+		log("        cells in memory over all modules of the design. Whenever a command\n");
+		log("        called from the command line or from a script finishes, the least\n");
+		log("        recently used modules are spilled until the design is within the\n");
+		log("        budget. A budget of 0 removes the limit.\n");
+		log("\n");
+		log("    -restore\n");
+		log("        read the selected spilled modules back into memory, e.g. to look at\n");
+		log("        them from a plugin. Note that they are spilled again after this\n");
+		log("        command if a cell budget is set.\n");
+		log("\n");
+		log("    -off\n");
+		log("        read all spilled modules back into memory and stop spilling.\n");
+		log("\n");
+		log("Modules that are shared with another design (see 'design -push-copy') or\n");
+		log("watched by a monitor (e.g. the Python bindings) are never spilled.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		std::string dir;
+		int budget = -1;
+		bool restore_mode = false, off_mode = false;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-dir" && argidx+1 < args.size()) {
+				dir = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-budget" && argidx+1 < args.size()) {
+				budget = atoi(args[++argidx].c_str());
+				if (budget < 0)
+					log_cmd_error("Invalid cell budget: %s\n", args[argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-restore") {
+				restore_mode = true;
+				continue;
+			}
+			if (args[argidx] == "-off") {
+				off_mode = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		log_header(design, "Executing SPILL pass (moving modules out of memory).\n");
+
+		if (off_mode) {
+			if (design->spill_store == nullptr) {
+				log("Spilling is not enabled.\n");
+				return;
+			}
+			int count = design->spill_store->spilled_count();
+			design->spill_store->restore_all();
+			design->spill_store.reset();
+			log("Restored %d modules, spilling is disabled.\n", count);
+			return;
+		}
+
+		// Only the selection itself is checked here, Design::selected_*()
+		// would read the modules back.
+		const RTLIL::Selection &selection = design->selection();
+
+		if (restore_mode) {
+			int count = 0;
+			if (design->spill_store != nullptr)
+				for (auto &it : design->modules_)
+					if (selection.selected_module(it.first) && design->spill_store->is_spilled(it.second)) {
+						design->spill_store->restore(it.second);
+						count++;
+					}
+			log("Restored %d modules.\n", count);
+			return;
+		}
+
+		if (design->spill_store == nullptr)
+			design->spill_store.reset(new SpillStore(design, dir));
+		else if (!dir.empty() && dir != design->spill_store->dir) {
+			if (design->spill_store->spilled_count() != 0)
+				log_cmd_error("Modules are already spilled to `%s'.\n", design->spill_store->dir.c_str());
+			design->spill_store.reset(new SpillStore(design, dir));
+		}
+		SpillStore *store = design->spill_store.get();
+
+		if (budget >= 0) {
+			store->budget = budget;
+			if (budget == 0)
+				log("Removed the cell budget.\n");
+			else
+				log("Keeping at most %d cells in memory.\n", budget);
+			return;
+		}
+
+		int count = 0;
+		for (auto &it : design->modules_) {
+			if (!selection.selected_whole_module(it.first) || store->is_spilled(it.second))
+				continue;
+			if (store->spill(it.second)) {
+				log("Spilled module %s.\n", log_id(it.first));
+				count++;
+			} else if (!it.second->get_blackbox_attribute()) {
+				log("Keeping module %s in memory.\n", log_id(it.first));
+			}
+		}
+		log("Spilled %d modules to `%s'.\n", count, store->dir.c_str());
+	}
+} SpillPass;
+
+PRIVATE_NAMESPACE_END
@@ -30,29 +30,17 @@ struct SplitcellsWorker
 	dict<SigBit, tuple<IdString,IdString,int>> bit_drivers_db;
 	dict<SigBit, pool<tuple<IdString,IdString,int>>> bit_users_db;
 
+	// cells to look at, because the users of their outputs changed
+	std::vector<IdString> queue;
+	pool<IdString> queued;
+
 	SplitcellsWorker(Module *module) : module(module), sigmap(module)
 	{
-		for (auto cell : module->cells()) {
-			for (auto conn : cell->connections()) {
-				if (!cell->output(conn.first)) continue;
-				for (int i = 0; i < GetSize(conn.second); i++) {
-					SigBit bit(sigmap(conn.second[i]));
-					bit_drivers_db[bit] = tuple<IdString,IdString,int>(cell->name, conn.first, i);
-				}
-			}
-		}
+		for (auto cell : module->cells())
+			index_outputs(cell);
 
-		for (auto cell : module->cells()) {
-			for (auto conn : cell->connections()) {
-				if (!cell->input(conn.first)) continue;
-				for (int i = 0; i < GetSize(conn.second); i++) {
-					SigBit bit(sigmap(conn.second[i]));
-					if (!bit_drivers_db.count(bit)) continue;
-					bit_users_db[bit].insert(tuple<IdString,IdString,int>(cell->name,
-							conn.first, i-std::get<2>(bit_drivers_db[bit])));
-				}
-			}
-		}
+		for (auto cell : module->cells())
+			index_inputs(cell, true);
 
 		for (auto wire : module->wires()) {
 			if (!wire->name.isPublic()) continue;
@@ -66,6 +54,76 @@ struct SplitcellsWorker
 		}
 	}
 
+	void enqueue(IdString name)
+	{
+		if (queued.insert(name).second)
+			queue.push_back(name);
+	}
+
+	void index_outputs(Cell *cell)
+	{
+		for (auto &conn : cell->connections()) {
+			if (!cell->output(conn.first)) continue;
+			for (int i = 0; i < GetSize(conn.second); i++) {
+				SigBit bit(sigmap(conn.second[i]));
+				bit_drivers_db[bit] = tuple<IdString,IdString,int>(cell->name, conn.first, i);
+			}
+		}
+	}
+
+	// add or remove the cell as a user of the bits on its inputs. when it is
+	// added, the drivers of the bits need to be looked at again
+	void index_inputs(Cell *cell, bool add, bool requeue = false)
+	{
+		for (auto &conn : cell->connections()) {
+			if (!cell->input(conn.first)) continue;
+			for (int i = 0; i < GetSize(conn.second); i++) {
+				SigBit bit(sigmap(conn.second[i]));
+				auto it = bit_drivers_db.find(bit);
+				if (it == bit_drivers_db.end()) continue;
+				tuple<IdString,IdString,int> entry(cell->name, conn.first, i-std::get<2>(it->second));
+				if (add)
+					bit_users_db[bit].insert(entry);
+				else
+					bit_users_db[bit].erase(entry);
+				if (requeue)
+					enqueue(std::get<0>(it->second));
+			}
+		}
+	}
+
+	// update the databases for a cell that was split into slices, the
+	// slices start at the given bit of the output port
+	void replace(Cell *cell, IdString outport, const std::vector<pair<Cell*, int>> &slices)
+	{
+		index_inputs(cell, false);
+
+		SigSpec outsig = cell->getPort(outport);
+		int k = 0;
+		for (int i = 0; i < GetSize(outsig); i++) {
+			while (k+1 < GetSize(slices) && slices[k+1].second <= i)
+				k++;
+			SigBit bit(sigmap(outsig[i]));
+			auto it = bit_drivers_db.find(bit);
+			if (it == bit_drivers_db.end() || std::get<0>(it->second) != cell->name)
+				continue;
+			int lsb = slices[k].second;
+			it->second = tuple<IdString,IdString,int>(slices[k].first->name, outport, i-lsb);
+
+			// the offsets of the users are relative to the driver offset
+			auto users = bit_users_db.find(bit);
+			if (users != bit_users_db.end()) {
+				pool<tuple<IdString,IdString,int>> shifted;
+				for (auto &user : users->second)
+					shifted.insert(tuple<IdString,IdString,int>(std::get<0>(user), std::get<1>(user), std::get<2>(user)+lsb));
+				users->second.swap(shifted);
+			}
+		}
+
+		for (auto &slice : slices)
+			index_inputs(slice.first, true, true);
+	}
+
 	int split(Cell *cell, const std::string &format)
 	{
 		if (cell->type.in("$and", "$mux", "$not", "$or", "$pmux", "$xnor", "$xor"))
@@ -89,6 +147,7 @@ struct SplitcellsWorker
 			if (GetSize(slices) <= 1) return 0;
 			slices.push_back(GetSize(outsig));
 
+			std::vector<pair<Cell*, int>> new_slices;
 			log("Splitting %s cell %s/%s into %d slices:\n", log_id(cell->type), log_id(module), log_id(cell), GetSize(slices)-1);
 			for (int i = 1; i < GetSize(slices); i++)
 			{
@@ -128,8 +187,10 @@ struct SplitcellsWorker
 					slice->setParam(ID::WIDTH, GetSize(slice->getPort(ID::Y)));
 
 				log("  slice %d: %s => %s\n", i, log_id(slice_name), log_signal(slice->getPort(ID::Y)));
+				new_slices.push_back(make_pair(slice, slice_lsb));
 			}
 
+			replace(cell, ID::Y, new_slices);
 			module->remove(cell);
 			return GetSize(slices)-1;
 		}
@@ -156,6 +217,7 @@ struct SplitcellsWorker
 			if (GetSize(slices) <= 1) return 0;
 			slices.push_back(GetSize(outsig));
 
+			std::vector<pair<Cell*, int>> new_slices;
 			log("Splitting %s cell %s/%s into %d slices:\n", log_id(cell->type), log_id(module), log_id(cell), GetSize(slices)-1);
 			for (int i = 1; i < GetSize(slices); i++)
 			{
@@ -187,8 +249,10 @@ struct SplitcellsWorker
 				slice->setParam(ID::WIDTH, GetSize(slice->getPort(ID::Q)));
 
 				log("  slice %d: %s => %s\n", i, log_id(slice_name), log_signal(slice->getPort(ID::Q)));
+				new_slices.push_back(make_pair(slice, slice_lsb));
 			}
 
+			replace(cell, ID::Q, new_slices);
 			module->remove(cell);
 			return GetSize(slices)-1;
 		}
@@ -239,28 +303,33 @@ struct SplitcellsPass : public Pass {
 		if (GetSize(format) < 2) format += "]";
 		if (GetSize(format) < 3) format += ":";
 
-		for (auto module : design->selected_modules())
+		parallel_modules(design, design->selected_modules(), [&](Module *module)
 		{
 			int count_split_pre = 0;
 			int count_split_post = 0;
 
-			while (1) {
-				SplitcellsWorker worker(module);
-				bool did_something = false;
-				for (auto cell : module->selected_cells()) {
-					int n = worker.split(cell, format);
-					did_something |= (n != 0);
-					count_split_pre += (n != 0);
-					count_split_post += n;
-				}
-				if (!did_something)
-					break;
+			// the databases are updated as cells are split, and only the
+			// drivers of the inputs of new slices are looked at again
+			RTLIL::Module::BatchScope batch(module);
+			SplitcellsWorker worker(module);
+			for (auto cell : module->selected_cells())
+				worker.enqueue(cell->name);
+
+			for (int i = 0; i < GetSize(worker.queue); i++) {
+				IdString name = worker.queue[i];
+				worker.queued.erase(name);
+				Cell *cell = module->cell(name);
+				if (cell == nullptr || !module->design->selected(module, cell))
+					continue;
+				int n = worker.split(cell, format);
+				count_split_pre += (n != 0);
+				count_split_post += n;
 			}
 
 			if (count_split_pre)
 				log("Split %d cells in module %s into %d cell slices.\n",
 					count_split_pre, log_id(module), count_split_post);
-		}
+		});
 	}
 } SplitnetsPass;
 
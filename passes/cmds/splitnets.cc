@@ -87,9 +87,13 @@ struct SplitnetsWorker
 
 	void operator()(RTLIL::SigSpec &sig)
 	{
-		for (auto &bit : sig)
-			if (splitmap.count(bit.wire) > 0)
-				bit = splitmap.at(bit.wire).at(bit.offset);
+		for (auto &bit : sig) {
+			if (bit.wire == nullptr)
+				continue;
+			auto it = splitmap.find(bit.wire);
+			if (it != splitmap.end())
+				bit = it->second.at(bit.offset);
+		}
 	}
 };
 
@@ -147,11 +151,25 @@ struct SplitnetsPass : public Pass {
 		// module_ports_db[module_name][old_port_name] = new_port_name_list
 		dict<IdString, dict<IdString, vector<IdString>>> module_ports_db;
 
+		std::vector<RTLIL::Module*> modules;
 		for (auto module : design->selected_modules())
-		{
-			if (module->has_processes_warn())
-				continue;
+			if (!module->has_processes_warn())
+				modules.push_back(module);
+
+		// per module, so that the workers don't share anything
+		std::vector<dict<IdString, vector<IdString>>> module_ports(GetSize(modules));
+		dict<RTLIL::Module*, int> module_index;
+		for (int i = 0; i < GetSize(modules); i++)
+			module_index[modules[i]] = i;
 
+		CellTypes ct;
+		if (flag_driver)
+			ct.setup(design);
+
+		parallel_modules(design, modules, [&](RTLIL::Module *module)
+		{
+			// all wires are replaced at once, notify monitors only once
+			RTLIL::Module::BatchScope batch(module);
 			SplitnetsWorker worker;
 
 			if (flag_ports)
@@ -170,8 +188,6 @@ struct SplitnetsPass : public Pass {
 
 			if (flag_driver)
 			{
-				CellTypes ct(design);
-
 				std::map<RTLIL::Wire*, std::set<int>> split_wires_at;
 
 				for (auto c : module->cells())
@@ -231,7 +247,7 @@ struct SplitnetsPass : public Pass {
 					if (sig == wire)
 						continue;
 
-					vector<IdString> &new_ports = module_ports_db[module->name][wire->name];
+					vector<IdString> &new_ports = module_ports[module_index.at(module)][wire->name];
 
 					for (SigSpec c : sig.chunks())
 						new_ports.push_back(c.as_wire()->name);
@@ -245,7 +261,11 @@ struct SplitnetsPass : public Pass {
 
 			if (flag_ports)
 				module->fixup_ports();
-		}
+		});
+
+		for (int i = 0; i < GetSize(modules); i++)
+			if (!module_ports[i].empty())
+				module_ports_db[modules[i]->name] = std::move(module_ports[i]);
 
 		if (!module_ports_db.empty())
 		{
@@ -22,239 +22,596 @@
 #include "kernel/sigtools.h"
 #include "kernel/timinginfo.h"
 #include <deque>
+#include <optional>
+#include <queue>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-struct StaWorker
+// The timing graph of a module, with the arrival times of all signal bits. It
+// is kept alive across passes (see Module::cached_timing_) and updated through
+// the monitor callbacks: the arcs of a cell are rebuilt when one of its ports
+// is reconnected, and arrival times are then only recomputed in the fan-out
+// cones of the bits whose fan-in changed. A blackout rebuilds everything.
+//
+// Changes to the parameters of a cell or to the timing of a blackbox module
+// are not seen by the monitor. Passes that might make such changes without
+// keeps_indexes() drop the graph, `sta -reset` drops it explicitly.
+struct StaGraph : public RTLIL::Monitor
 {
 	Design *design;
 	Module *module;
 	SigMap sigmap;
+	TimingInfo timing;
+	pool<IdString> unrecognised_cells;
 
-	struct t_data {
-		Cell* driver;
-		IdString dst_port, src_port;
-		vector<tuple<SigBit,int,IdString>> fanouts;
-		SigBit backtrack;
-		t_data() : driver(nullptr) {}
+	struct t_arc {
+		SigBit src, dst;
+		int delay;
+		IdString src_port, dst_port;
 	};
-	dict<SigBit, t_data> data;
-	std::deque<SigBit> queue;
-	struct t_endpoint {
-		Cell *sink;
-		IdString port;
-		int required;
-		t_endpoint() : sink(nullptr), required(0) {}
+	struct t_cell {
+		vector<t_arc> arcs;
+		vector<tuple<SigBit,IdString,int>> required;
+		vector<pair<SigBit,IdString>> outputs;
 	};
-	dict<SigBit, t_endpoint> endpoints;
+	dict<Cell*, t_cell> cells;
+	dict<SigBit, vector<pair<Cell*,int>>> fanins, fanouts;
+	dict<SigBit, pool<Cell*>> users;
+	pool<SigBit> inputs, outputs;
+
+	struct t_backtrack {
+		SigBit src;
+		Cell *driver;
+		IdString src_port, dst_port;
+		bool operator==(const t_backtrack &other) const {
+			return src == other.src && driver == other.driver && src_port == other.src_port && dst_port == other.dst_port;
+		}
+	};
+	dict<SigBit, int> arrival;
+	dict<SigBit, t_backtrack> backtrack;
+	dict<SigBit, pair<Cell*,IdString>> drivers;
 
-	int maxarrival;
-	SigBit maxbit;
+	bool reload;
+	pool<Cell*> dirty_cells;
+	pool<SigBit> dirty_bits;
 
-	pool<SigBit> driven;
+	StaGraph(RTLIL::Module *module) : design(module->design), module(module), reload(true)
+	{
+		module->monitors.insert(this);
+	}
 
-	StaWorker(RTLIL::Module *module) : design(module->design), module(module), sigmap(module), maxarrival(0)
+	~StaGraph()
 	{
-		TimingInfo timing;
+		module->monitors.erase(this);
+	}
 
-		pool<IdString> unrecognised_cells;
+	static StaGraph &cached(RTLIL::Module *module)
+	{
+		StaGraph *graph = static_cast<StaGraph*>(module->cached_timing_);
+		if (graph == nullptr) {
+			graph = new StaGraph(module);
+			module->cached_timing_ = graph;
+		}
+		return *graph;
+	}
 
-		for (auto cell : module->cells())
-		{
-			Module *inst_module = design->module(cell->type);
-			if (!inst_module) {
-				if (unrecognised_cells.insert(cell->type).second)
-					log_warning("Cell type '%s' not recognised! Ignoring.\n", log_id(cell->type));
-				continue;
-			}
+	void notify_connect(RTLIL::Cell *cell, const RTLIL::IdString&, const RTLIL::SigSpec&, const RTLIL::SigSpec&) override
+	{
+		if (!reload)
+			dirty_cells.insert(cell);
+	}
 
-			if (!inst_module->get_blackbox_attribute()) {
-				log_warning("Cell type '%s' is not a black- nor white-box! Ignoring.\n", log_id(cell->type));
-				continue;
-			}
+	void notify_connect(RTLIL::Module *mod, const RTLIL::SigSig &sigsig) override
+	{
+		log_assert(module == mod);
 
-			IdString derived_type = inst_module->derive(design, cell->parameters);
-			inst_module = design->module(derived_type);
-			log_assert(inst_module);
+		if (reload)
+			return;
 
-			if (!timing.count(derived_type)) {
-				auto &t = timing.setup_module(inst_module);
-				if (t.has_inputs && t.comb.empty() && t.arrival.empty() && t.required.empty())
-					log_warning("Module '%s' has no timing arcs!\n", log_id(cell->type));
+		// everything on the bits that are merged is keyed by their old
+		// representatives, so rebuild the cells using them
+		for (auto &sig : {sigsig.first, sigsig.second})
+			for (auto bit : sigmap(sig)) {
+				if (!bit.wire)
+					continue;
+				dirty_bits.insert(bit);
+				auto it = users.find(bit);
+				if (it != users.end())
+					dirty_cells.insert(it->second.begin(), it->second.end());
 			}
+		sigmap.add(sigsig.first, sigsig.second);
+	}
 
-			auto &t = timing.at(derived_type);
-			if (t.comb.empty() && t.arrival.empty() && t.required.empty())
-				continue;
+	void notify_connect(RTLIL::Module *mod, const std::vector<RTLIL::SigSig>&) override
+	{
+		log_assert(module == mod);
+		reload = true;
+	}
+
+	void notify_blackout(RTLIL::Module *mod) override
+	{
+		log_assert(module == mod);
+		reload = true;
+	}
+
+	void remove_cell(Cell *cell)
+	{
+		auto it = cells.find(cell);
+		if (it == cells.end())
+			return;
+
+		auto erase_entries = [cell](vector<pair<Cell*,int>> &entries) {
+			entries.erase(std::remove_if(entries.begin(), entries.end(),
+					[cell](const pair<Cell*,int> &e) { return e.first == cell; }), entries.end());
+		};
+		for (auto &arc : it->second.arcs) {
+			erase_entries(fanins[arc.dst]);
+			erase_entries(fanouts[arc.src]);
+			dirty_bits.insert(arc.dst);
+		}
+		for (auto &o : it->second.outputs) {
+			auto jt = drivers.find(o.first);
+			if (jt != drivers.end() && jt->second.first == cell)
+				drivers.erase(jt);
+			users[o.first].erase(cell);
+		}
+		for (auto &r : it->second.required)
+			users[std::get<0>(r)].erase(cell);
+		for (auto &arc : it->second.arcs) {
+			users[arc.src].erase(cell);
+			users[arc.dst].erase(cell);
+		}
+		cells.erase(it);
+	}
 
-			pool<std::pair<SigBit,TimingInfo::NameBit>> src_bits, dst_bits;
+	void add_cell(Cell *cell)
+	{
+		Module *inst_module = design->module(cell->type);
+		if (!inst_module) {
+			if (unrecognised_cells.insert(cell->type).second)
+				log_warning("Cell type '%s' not recognised! Ignoring.\n", log_id(cell->type));
+			return;
+		}
+
+		if (!inst_module->get_blackbox_attribute()) {
+			log_warning("Cell type '%s' is not a black- nor white-box! Ignoring.\n", log_id(cell->type));
+			return;
+		}
+
+		IdString derived_type = inst_module->derive(design, cell->parameters);
+		inst_module = design->module(derived_type);
+		log_assert(inst_module);
+
+		if (!timing.count(derived_type)) {
+			auto &t = timing.setup_module(inst_module);
+			if (t.has_inputs && t.comb.empty() && t.arrival.empty() && t.required.empty())
+				log_warning("Module '%s' has no timing arcs!\n", log_id(cell->type));
+		}
+
+		auto &t = timing.at(derived_type);
+		if (t.comb.empty() && t.arrival.empty() && t.required.empty())
+			return;
 
-			for (auto &conn : cell->connections()) {
-				auto rhs = sigmap(conn.second);
-				for (auto i = 0; i < GetSize(rhs); i++) {
-					const auto &bit = rhs[i];
-					if (!bit.wire)
+		t_cell &c = cells[cell];
+		pool<std::pair<SigBit,TimingInfo::NameBit>> src_bits, dst_bits;
+
+		for (auto &conn : cell->connections()) {
+			auto rhs = sigmap(conn.second);
+			for (auto i = 0; i < GetSize(rhs); i++) {
+				const auto &bit = rhs[i];
+				if (!bit.wire)
+					continue;
+				TimingInfo::NameBit namebit(conn.first,i);
+				if (cell->input(conn.first)) {
+					src_bits.insert(std::make_pair(bit,namebit));
+
+					auto it = t.required.find(namebit);
+					if (it == t.required.end())
 						continue;
-					TimingInfo::NameBit namebit(conn.first,i);
-					if (cell->input(conn.first)) {
-						src_bits.insert(std::make_pair(bit,namebit));
-
-						auto it = t.required.find(namebit);
-						if (it == t.required.end())
-							continue;
-						auto r = endpoints.insert(bit);
-						if (r.second || r.first->second.required < it->second.first) {
-							r.first->second.sink = cell;
-							r.first->second.port = conn.first;
-							r.first->second.required = it->second.first;
-						}
-					}
-					if (cell->output(conn.first)) {
-						dst_bits.insert(std::make_pair(bit,namebit));
-						auto &d = data[bit];
-						d.driver = cell;
-						d.dst_port = conn.first;
-						driven.insert(bit);
-
-						auto it = t.arrival.find(namebit);
-						if (it == t.arrival.end())
-							continue;
-						const auto &s = it->second.second;
-						if (cell->hasPort(s.name)) {
-							auto s_bit = sigmap(cell->getPort(s.name)[s.offset]);
-							if (s_bit.wire)
-								data[s_bit].fanouts.emplace_back(bit,it->second.first,s.name);
-						}
+					c.required.emplace_back(bit, conn.first, it->second.first);
+				}
+				if (cell->output(conn.first)) {
+					dst_bits.insert(std::make_pair(bit,namebit));
+					c.outputs.emplace_back(bit, conn.first);
+
+					auto it = t.arrival.find(namebit);
+					if (it == t.arrival.end())
+						continue;
+					const auto &s = it->second.second;
+					if (cell->hasPort(s.name)) {
+						auto s_bit = sigmap(cell->getPort(s.name)[s.offset]);
+						if (s_bit.wire)
+							c.arcs.push_back({s_bit, bit, it->second.first, s.name, conn.first});
 					}
 				}
 			}
+		}
 
-			for (const auto &s : src_bits)
-				for (const auto &d : dst_bits) {
-					auto it = t.comb.find(TimingInfo::BitBit(s.second,d.second));
-					if (it == t.comb.end())
-						continue;
-					data[s.first].fanouts.emplace_back(d.first,it->second,s.second.name);
+		for (const auto &s : src_bits)
+			for (const auto &d : dst_bits) {
+				auto it = t.comb.find(TimingInfo::BitBit(s.second,d.second));
+				if (it == t.comb.end())
+					continue;
+				c.arcs.push_back({s.first, d.first, it->second, s.second.name, d.second.name});
+			}
+
+		for (int i = 0; i < GetSize(c.arcs); i++) {
+			auto &arc = c.arcs[i];
+			fanins[arc.dst].emplace_back(cell, i);
+			fanouts[arc.src].emplace_back(cell, i);
+			users[arc.src].insert(cell);
+			users[arc.dst].insert(cell);
+			dirty_bits.insert(arc.dst);
+		}
+		for (auto &o : c.outputs) {
+			drivers[o.first] = std::make_pair(cell, o.second);
+			users[o.first].insert(cell);
+		}
+		for (auto &r : c.required)
+			users[std::get<0>(r)].insert(cell);
+	}
+
+	// Recompute the arrival time of a bit from its fan-in, returns true if
+	// it changed.
+	bool recompute(SigBit bit)
+	{
+		// All primary inputs to arrive at time zero
+		int new_arrival = inputs.count(bit) ? 0 : -1;
+		t_backtrack new_backtrack = {SigBit(), nullptr, IdString(), IdString()};
+
+		auto it = fanins.find(bit);
+		if (it != fanins.end())
+			for (auto &f : it->second) {
+				const auto &arc = cells.at(f.first).arcs[f.second];
+				auto jt = arrival.find(arc.src);
+				if (jt == arrival.end())
+					continue;
+				if (jt->second + arc.delay > new_arrival) {
+					new_arrival = jt->second + arc.delay;
+					new_backtrack = {arc.src, f.first, arc.src_port, arc.dst_port};
 				}
+			}
+
+		auto at = arrival.find(bit);
+		if (new_arrival < 0) {
+			if (at == arrival.end())
+				return false;
+			arrival.erase(at);
+			backtrack.erase(bit);
+			return true;
 		}
 
+		bool changed = at == arrival.end() || at->second != new_arrival;
+		arrival[bit] = new_arrival;
+		if (new_backtrack.driver == nullptr)
+			changed |= backtrack.erase(bit) != 0;
+		else {
+			auto bt = backtrack.find(bit);
+			if (bt == backtrack.end() || !(bt->second == new_backtrack)) {
+				backtrack[bit] = new_backtrack;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	void update()
+	{
+		bool full = reload;
+		if (reload) {
+			sigmap.set(module);
+			cells.clear();
+			fanins.clear();
+			fanouts.clear();
+			users.clear();
+			inputs.clear();
+			arrival.clear();
+			backtrack.clear();
+			drivers.clear();
+			dirty_bits.clear();
+			dirty_cells.clear();
+			for (auto cell : module->cells())
+				dirty_cells.insert(cell);
+			reload = false;
+		}
+
+		// dirty cells that were removed since the last update are dangling
+		// pointers, only use them as keys
+		pool<Cell*> live_cells;
+		if (!full && !dirty_cells.empty())
+			for (auto cell : module->cells())
+				live_cells.insert(cell);
+
+		int changed_cells = GetSize(dirty_cells);
+		for (auto cell : dirty_cells) {
+			remove_cell(cell);
+			if (full || live_cells.count(cell))
+				add_cell(cell);
+		}
+		dirty_cells.clear();
+
+		pool<SigBit> new_inputs;
+		pool<Wire*> changed_wires;
+		outputs.clear();
 		for (auto port_name : module->ports) {
 			auto wire = module->wire(port_name);
-			if (wire->port_input) {
-				for (const auto &b : sigmap(wire)) {
-					queue.emplace_back(b);
-					driven.insert(b);
-				}
-				// All primary inputs to arrive at time zero
-				wire->set_intvec_attribute(ID::sta_arrival, std::vector<int>(GetSize(wire), 0));
-			}
+			if (wire->port_input)
+				for (const auto &b : sigmap(wire))
+					if (b.wire)
+						new_inputs.insert(b);
 			if (wire->port_output)
 				for (const auto &b : sigmap(wire))
 					if (b.wire)
-						endpoints.insert(b);
+						outputs.insert(b);
+		}
+		if (new_inputs != inputs) {
+			for (auto &b : inputs)
+				if (!new_inputs.count(b))
+					dirty_bits.insert(b);
+			for (auto &b : new_inputs)
+				if (!inputs.count(b))
+					dirty_bits.insert(b);
+			inputs = std::move(new_inputs);
+			for (auto port_name : module->ports)
+				if (module->wire(port_name)->port_input)
+					changed_wires.insert(module->wire(port_name));
 		}
-	}
 
-	void run()
-	{
+		std::deque<SigBit> queue(dirty_bits.begin(), dirty_bits.end());
+		pool<SigBit> queued = std::move(dirty_bits);
+		dirty_bits.clear();
+		int recomputed = 0;
+
 		while (!queue.empty()) {
 			auto b = queue.front();
 			queue.pop_front();
-			auto it = data.find(b);
-			if (it == data.end())
+			queued.erase(b);
+			recomputed++;
+			if (!recompute(b))
 				continue;
-			const auto& src_arrivals = b.wire->get_intvec_attribute(ID::sta_arrival);
-			log_assert(GetSize(src_arrivals) == GetSize(b.wire));
-			auto src_arrival = src_arrivals[b.offset];
-			for (const auto &d : it->second.fanouts) {
-				const auto &dst_bit = std::get<0>(d);
-				auto dst_arrivals = dst_bit.wire->get_intvec_attribute(ID::sta_arrival);
-				if (dst_arrivals.empty())
-					dst_arrivals = std::vector<int>(GetSize(dst_bit.wire), -1);
-				else
-					log_assert(GetSize(dst_arrivals) == GetSize(dst_bit.wire));
-				auto &dst_arrival = dst_arrivals[dst_bit.offset];
-				auto new_arrival = src_arrival + std::get<1>(d);
-				if (dst_arrival < new_arrival) {
-					auto dst_wire = dst_bit.wire;
-					dst_arrival = std::max(dst_arrival, new_arrival);
-					dst_wire->set_intvec_attribute(ID::sta_arrival, dst_arrivals);
-					queue.emplace_back(dst_bit);
-
-					data[dst_bit].backtrack = b;
-					data[dst_bit].src_port = std::get<2>(d);
-
-					auto it = endpoints.find(dst_bit);
-					if (it != endpoints.end())
-						new_arrival += it->second.required;
-					if (new_arrival > maxarrival && driven.count(b)) {
-						maxarrival = new_arrival;
-						maxbit = dst_bit;
-					}
+			if (b.wire)
+				changed_wires.insert(b.wire);
+			auto it = fanouts.find(b);
+			if (it == fanouts.end())
+				continue;
+			for (auto &f : it->second) {
+				const auto &dst = cells.at(f.first).arcs[f.second].dst;
+				if (queued.insert(dst).second)
+					queue.push_back(dst);
+			}
+		}
+
+		for (auto wire : changed_wires) {
+			std::vector<int> arrivals(GetSize(wire), -1);
+			bool found = false;
+			for (int i = 0; i < GetSize(wire); i++) {
+				auto it = arrival.find(sigmap(SigBit(wire, i)));
+				if (it != arrival.end()) {
+					arrivals[i] = it->second;
+					found = true;
 				}
 			}
+			if (found)
+				wire->set_intvec_attribute(ID::sta_arrival, arrivals);
+			else
+				wire->attributes.erase(ID::sta_arrival);
 		}
 
-		auto b = maxbit;
-		if (b == SigBit()) {
-			log("No timing paths found.\n");
-			return;
+		if (full)
+			log("Built timing graph for module '%s' with %d timed cells.\n", log_id(module), GetSize(cells));
+		else
+			log("Updated timing graph for module '%s': %d changed cells, %d arrival times recomputed.\n",
+					log_id(module), changed_cells, recomputed);
+	}
+};
+
+struct StaWorker
+{
+	Module *module;
+	StaGraph &graph;
+
+	struct t_endpoint {
+		Cell *sink;
+		IdString port;
+		int required;
+		t_endpoint() : sink(nullptr), required(0) {}
+	};
+	dict<SigBit, t_endpoint> endpoints;
+
+	int maxarrival;
+	SigBit maxbit;
+
+	StaWorker(RTLIL::Module *module) : module(module), graph(StaGraph::cached(module)), maxarrival(0)
+	{
+		graph.update();
+
+		for (auto &it : graph.cells)
+			for (auto &r : it.second.required) {
+				auto e = endpoints.insert(std::get<0>(r));
+				if (e.second || e.first->second.required < std::get<2>(r)) {
+					e.first->second.sink = it.first;
+					e.first->second.port = std::get<1>(r);
+					e.first->second.required = std::get<2>(r);
+				}
+			}
+		for (auto &b : graph.outputs)
+			endpoints.insert(b);
+	}
+
+	bool driven(SigBit bit)
+	{
+		return graph.drivers.count(bit) || graph.inputs.count(bit);
+	}
+
+	struct t_step {
+		SigBit bit;
+		Cell *driver;
+		IdString src_port, dst_port;
+		int delay;
+	};
+
+	// A candidate of the k-best path enumeration: the path from `endpoint`
+	// that follows the backtrack pointers, except that at the deviations of
+	// this candidate and its parents it takes the given fan-in arc instead.
+	struct t_candidate {
+		int value;
+		SigBit endpoint;
+		int parent;
+		SigBit bit;
+		Cell *cell;
+		int arc;
+	};
+
+	bool is_backtrack(SigBit bit, Cell *cell, const StaGraph::t_arc &arc)
+	{
+		auto it = graph.backtrack.find(bit);
+		return it != graph.backtrack.end() && it->second.driver == cell && it->second.src == arc.src &&
+				it->second.src_port == arc.src_port && it->second.dst_port == arc.dst_port;
+	}
+
+	// Follow the path and return its steps in order from the endpoint, the
+	// last step is the primary input the path starts at.
+	vector<t_step> trace(SigBit b, const dict<SigBit, pair<Cell*,int>> &deviations)
+	{
+		vector<t_step> steps;
+		while (true) {
+			auto dt = deviations.find(b);
+			if (dt != deviations.end()) {
+				const auto &arc = graph.cells.at(dt->second.first).arcs[dt->second.second];
+				steps.push_back({b, dt->second.first, arc.src_port, arc.dst_port, arc.delay});
+				b = arc.src;
+				continue;
+			}
+			auto jt = graph.backtrack.find(b);
+			if (jt != graph.backtrack.end()) {
+				int delay = graph.arrival.at(b) - graph.arrival.at(jt->second.src);
+				steps.push_back({b, jt->second.driver, jt->second.src_port, jt->second.dst_port, delay});
+				b = jt->second.src;
+				continue;
+			}
+			if (!graph.inputs.count(b))
+				log_abort();
+			steps.push_back({b, nullptr, IdString(), IdString(), 0});
+			return steps;
 		}
+	}
 
-		log("Latest arrival time in '%s' is %d:\n", log_id(module), maxarrival);
-		auto it = endpoints.find(maxbit);
+	void print_path(const vector<t_step> &steps)
+	{
+		int arrival = graph.arrival.at(steps.back().bit);
+		for (auto &step : steps)
+			arrival += step.delay;
+
+		for (auto &step : steps) {
+			if (step.driver) {
+				log("           %s\n", log_signal(step.bit));
+				log("  %6d %s (%s.%s->%s)\n", arrival, log_id(step.driver), log_id(step.driver->type), log_id(step.src_port), log_id(step.dst_port));
+			} else
+				log("  %6d   %s (%s)\n", arrival, log_signal(step.bit), "<primary input>");
+			arrival -= step.delay;
+		}
+	}
+
+	void print_endpoint(int value, SigBit b, bool warn)
+	{
+		auto it = endpoints.find(b);
 		if (it != endpoints.end() && it->second.sink)
-			log("  %6d %s (%s.%s)\n", maxarrival, log_id(it->second.sink), log_id(it->second.sink->type), log_id(it->second.port));
+			log("  %6d %s (%s.%s)\n", value, log_id(it->second.sink), log_id(it->second.sink->type), log_id(it->second.port));
 		else {
-			log("  %6d (%s)\n", maxarrival, b.wire->port_output ? "<primary output>" : "<unknown>");
-			if (!b.wire->port_output)
+			log("  %6d (%s)\n", value, b.wire->port_output ? "<primary output>" : "<unknown>");
+			if (warn && !b.wire->port_output)
 				log_warning("Critical-path does not terminate in a recognised endpoint.\n");
 		}
-		auto jt = data.find(b);
-		while (jt != data.end()) {
-			int arrival = b.wire->get_intvec_attribute(ID::sta_arrival)[b.offset];
-			if (jt->second.driver) {
-				log("           %s\n", log_signal(b));
-				log("  %6d %s (%s.%s->%s)\n", arrival, log_id(jt->second.driver), log_id(jt->second.driver->type), log_id(jt->second.src_port), log_id(jt->second.dst_port));
-			}
-			else if (b.wire->port_input)
-				log("  %6d   %s (%s)\n", arrival, log_signal(b), "<primary input>");
-			else
-				log_abort();
-			b = jt->second.backtrack;
-			jt = data.find(b);
-		}
+	}
 
-		std::map<int, unsigned> arrival_histogram;
-		for (const auto &i : endpoints) {
-			const auto &b = i.first;
-			if (!driven.count(b))
+	// Enumerate the num_paths longest paths with the deviation algorithm: a
+	// popped path spawns one candidate for every fan-in arc that it does not
+	// take after its last deviation. Every path is found exactly once, and
+	// only the popped paths are expanded, so the run time is linear in the
+	// length of the reported paths (plus the heap) rather than in the graph.
+	void report_paths(int num_paths)
+	{
+		vector<t_candidate> candidates;
+		auto cmp = [&](int a, int b) {
+			if (candidates[a].value != candidates[b].value)
+				return candidates[a].value < candidates[b].value;
+			return a > b;
+		};
+		std::priority_queue<int, vector<int>, decltype(cmp)> heap(cmp);
+
+		// paths end at endpoints and at bits that don't feed anything else
+		for (auto &it : graph.backtrack) {
+			auto jt = endpoints.find(it.first);
+			if (jt == endpoints.end() && graph.fanouts.count(it.first) && !graph.fanouts.at(it.first).empty())
 				continue;
+			int value = graph.arrival.at(it.first) + (jt != endpoints.end() ? jt->second.required : 0);
+			candidates.push_back({value, it.first, -1, SigBit(), nullptr, 0});
+			heap.push(GetSize(candidates)-1);
+		}
 
-			if (!b.wire->attributes.count(ID::sta_arrival)) {
-				log_warning("Endpoint %s.%s has no (* sta_arrival *) value.\n", log_id(module), log_signal(b));
-				continue;
-			}
+		log("\n");
+		log("Top %d paths in '%s':\n", num_paths, log_id(module));
 
-			auto arrival = b.wire->get_intvec_attribute(ID::sta_arrival)[b.offset];
-			if (arrival < 0) {
-				log_warning("Endpoint %s.%s has no (* sta_arrival *) value.\n", log_id(module), log_signal(b));
-				continue;
+		for (int count = 1; count <= num_paths && !heap.empty(); count++)
+		{
+			int index = heap.top();
+			heap.pop();
+			const t_candidate c = candidates[index];
+
+			dict<SigBit, pair<Cell*,int>> deviations;
+			for (int i = index; candidates[i].parent >= 0; i = candidates[i].parent)
+				deviations[candidates[i].bit] = std::make_pair(candidates[i].cell, candidates[i].arc);
+
+			auto steps = trace(c.endpoint, deviations);
+
+			log("\n");
+			log("Path #%d with arrival time %d:\n", count, c.value);
+			print_endpoint(c.value, c.endpoint, false);
+			print_path(steps);
+
+			// the path up to the last deviation is fixed for all children
+			SigBit suffix_start = c.endpoint;
+			if (c.parent >= 0)
+				suffix_start = graph.cells.at(c.cell).arcs[c.arc].src;
+
+			bool in_suffix = false;
+			for (auto &step : steps)
+			{
+				if (step.bit == suffix_start)
+					in_suffix = true;
+				if (!in_suffix)
+					continue;
+
+				auto it = graph.fanins.find(step.bit);
+				if (it == graph.fanins.end())
+					continue;
+				int arrival = graph.arrival.at(step.bit);
+				for (auto &f : it->second) {
+					const auto &arc = graph.cells.at(f.first).arcs[f.second];
+					auto at = graph.arrival.find(arc.src);
+					if (at == graph.arrival.end() || is_backtrack(step.bit, f.first, arc))
+						continue;
+					int slack = arrival - (at->second + arc.delay);
+					candidates.push_back({c.value - slack, c.endpoint, index, step.bit, f.first, f.second});
+					heap.push(GetSize(candidates)-1);
+				}
 			}
-			arrival += i.second.required;
-			arrival_histogram[arrival]++;
 		}
+	}
+
+	void print_histogram(const char *title, const std::map<int, unsigned> &histogram)
+	{
 		// Adapted from https://github.com/YosysHQ/nextpnr/blob/affb12cc27ebf409eade062c4c59bb98569d8147/common/timing.cc#L946-L969
-		if (arrival_histogram.size() > 0) {
+		if (histogram.size() > 0) {
 			unsigned num_bins = 20;
 			unsigned bar_width = 60;
-			auto min_arrival = arrival_histogram.begin()->first;
-			auto max_arrival = arrival_histogram.rbegin()->first;
+			auto min_arrival = histogram.begin()->first;
+			auto max_arrival = histogram.rbegin()->first;
 			auto bin_size = std::max<unsigned>(1, ceil((max_arrival - min_arrival + 1) / float(num_bins)));
 			std::vector<unsigned> bins(num_bins);
 			unsigned max_freq = 0;
-			for (const auto &i : arrival_histogram) {
+			for (const auto &i : histogram) {
 				auto &bin = bins[(i.first - min_arrival) / bin_size];
 				bin += i.second;
 				max_freq = std::max(max_freq, bin);
@@ -262,7 +619,7 @@ struct StaWorker
 			bar_width = std::min(bar_width, max_freq);
 
 			log("\n");
-			log("Arrival histogram:\n");
+			log("%s histogram:\n", title);
 			log(" legend: * represents %d endpoint(s)\n", max_freq / bar_width);
 			log("         + represents [1,%d) endpoint(s)\n", max_freq / bar_width);
 			for (int i = num_bins-1; i >= 0; --i)
@@ -271,10 +628,78 @@ struct StaWorker
 						(bins[i] * bar_width) % max_freq > 0 ? '+' : ' ');
 		}
 	}
+
+	void run(int num_paths, std::optional<int> period)
+	{
+		for (auto &it : graph.backtrack) {
+			auto new_arrival = graph.arrival.at(it.first);
+			auto jt = endpoints.find(it.first);
+			if (jt != endpoints.end())
+				new_arrival += jt->second.required;
+			if (new_arrival > maxarrival) {
+				maxarrival = new_arrival;
+				maxbit = it.first;
+			}
+		}
+
+		if (maxbit == SigBit()) {
+			log("No timing paths found.\n");
+			return;
+		}
+
+		log("Latest arrival time in '%s' is %d:\n", log_id(module), maxarrival);
+		print_endpoint(maxarrival, maxbit, true);
+		print_path(trace(maxbit, {}));
+
+		if (num_paths > 1)
+			report_paths(num_paths);
+
+		std::map<int, unsigned> arrival_histogram, slack_histogram;
+		int failing = 0, worst_slack = 0;
+		long long total_slack = 0;
+		for (const auto &i : endpoints) {
+			const auto &b = i.first;
+			if (!driven(b))
+				continue;
+
+			auto jt = graph.arrival.find(b);
+			if (jt == graph.arrival.end()) {
+				log_warning("Endpoint %s.%s has no (* sta_arrival *) value.\n", log_id(module), log_signal(b));
+				continue;
+			}
+			auto arrival = jt->second + i.second.required;
+			arrival_histogram[arrival]++;
+			if (period) {
+				int slack = *period - arrival;
+				slack_histogram[slack]++;
+				if (slack < 0) {
+					failing++;
+					total_slack += slack;
+					worst_slack = std::min(worst_slack, slack);
+				}
+			}
+		}
+
+		if (period) {
+			log("\n");
+			log("%d of %d endpoints miss the period of %d, worst slack is %d, total negative slack is %lld.\n",
+					failing, sum_counts(arrival_histogram), *period, worst_slack, total_slack);
+			print_histogram("Slack", slack_histogram);
+		} else
+			print_histogram("Arrival", arrival_histogram);
+	}
+
+	static int sum_counts(const std::map<int, unsigned> &histogram)
+	{
+		int sum = 0;
+		for (auto &it : histogram)
+			sum += it.second;
+		return sum;
+	}
 };
 
 struct StaPass : public Pass {
-	StaPass() : Pass("sta", "perform static timing analysis") { }
+	StaPass() : Pass("sta", "perform static timing analysis") { keeps_indexes(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -284,30 +709,64 @@ struct StaPass : public Pass {
 		log("This command performs static timing analysis on the design. (Only considers\n");
 		log("paths within a single module, so the design must be flattened.)\n");
 		log("\n");
+		log("The timing graph and the arrival times are kept with the module. When 'sta'\n");
+		log("is called again, only the cells that were reconnected since are re-read and\n");
+		log("only the arrival times in their fan-out cones are recomputed. The graph is\n");
+		log("dropped by passes that may change the design without notifying monitors.\n");
+		log("\n");
+		log("    -paths <k>\n");
+		log("        after the critical path, also report the k longest paths in order.\n");
+		log("        Paths end at endpoints or at signals that do not drive anything. The\n");
+		log("        paths are enumerated by deviating from the critical paths, so this is\n");
+		log("        fast even for thousands of paths.\n");
+		log("\n");
+		log("    -period <t>\n");
+		log("        report the slack of all endpoints against the given clock period, and\n");
+		log("        print a slack histogram instead of the arrival histogram\n");
+		log("\n");
+		log("    -reset\n");
+		log("        rebuild the timing graph from scratch, e.g. after the parameters of\n");
+		log("        cells or the timing of blackbox modules were changed\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		log_header(design, "Executing STA pass (static timing analysis).\n");
 
-		/*
+		bool reset = false;
+		int num_paths = 1;
+		std::optional<int> period;
+
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
-			if (args[argidx] == "-TODO") {
+			if (args[argidx] == "-paths" && argidx+1 < args.size()) {
+				num_paths = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-period" && argidx+1 < args.size()) {
+				period = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-reset") {
+				reset = true;
 				continue;
 			}
 			break;
 		}
-		*/
-
-		extra_args(args, 1, design);
+		extra_args(args, argidx, design);
 
 		for (Module *module : design->selected_modules())
 		{
 			if (module->has_processes_warn())
 				continue;
 
+			if (reset) {
+				delete module->cached_timing_;
+				module->cached_timing_ = nullptr;
+			}
+
 			StaWorker worker(module);
-			worker.run();
+			worker.run(num_paths, period);
 		}
 	}
 } StaPass;
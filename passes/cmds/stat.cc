@@ -326,49 +326,51 @@ struct statdata_t
 	}
 };
 
-statdata_t hierarchy_worker(std::map<RTLIL::IdString, statdata_t> &mod_stat, RTLIL::IdString mod, int level, bool quiet = false)
+// Sum up the statistics of a module and all the modules instantiated below
+// it. The sum for each module is computed once and kept in `sums`, so shared
+// submodules are not walked again for every instance.
+statdata_t hierarchy_worker(std::map<RTLIL::IdString, statdata_t> &mod_stat, RTLIL::IdString mod, dict<RTLIL::IdString, statdata_t> &sums)
 {
+	auto cached = sums.find(mod);
+	if (cached != sums.end())
+		return cached->second;
+
 	statdata_t mod_data = mod_stat.at(mod);
 	std::map<RTLIL::IdString, unsigned int, RTLIL::sort_by_id_str> num_cells_by_type;
 	num_cells_by_type.swap(mod_data.num_cells_by_type);
 
 	for (auto &it : num_cells_by_type)
 		if (mod_stat.count(it.first) > 0) {
-			if (!quiet)
-				log("     %*s%-*s %6u\n", 2*level, "", 26-2*level, log_id(it.first), it.second);
-			mod_data = mod_data + hierarchy_worker(mod_stat, it.first, level+1, quiet) * it.second;
+			mod_data = mod_data + hierarchy_worker(mod_stat, it.first, sums) * it.second;
 			mod_data.num_cells -= it.second;
 		} else {
 			mod_data.num_cells_by_type[it.first] += it.second;
 		}
 
+	sums[mod] = mod_data;
 	return mod_data;
 }
 
-void read_liberty_cellarea(dict<IdString, cell_area_t> &cell_area, string liberty_file)
+void log_hierarchy(std::map<RTLIL::IdString, statdata_t> &mod_stat, RTLIL::IdString mod, int level)
 {
-	std::ifstream f;
-	f.open(liberty_file.c_str());
-	yosys_input_files.insert(liberty_file);
-	if (f.fail())
-		log_cmd_error("Can't open liberty file `%s': %s\n", liberty_file.c_str(), strerror(errno));
-	LibertyParser libparser(f);
-	f.close();
+	for (auto &it : mod_stat.at(mod).num_cells_by_type)
+		if (mod_stat.count(it.first) > 0) {
+			log("     %*s%-*s %6u\n", 2*level, "", 26-2*level, log_id(it.first), it.second);
+			log_hierarchy(mod_stat, it.first, level+1);
+		}
+}
 
-	for (auto cell : libparser.ast->children)
-	{
-		if (cell->id != "cell" || cell->args.size() != 1)
-			continue;
+void read_liberty_cellarea(dict<IdString, cell_area_t> &cell_area, string liberty_file, string cache_dir)
+{
+	yosys_input_files.insert(liberty_file);
 
-		const LibertyAst *ar = cell->find("area");
-		bool is_flip_flop = cell->find("ff") != nullptr;
-		if (ar != nullptr && !ar->value.empty())
-			cell_area["\\" + cell->args[0]] = {/*area=*/atof(ar->value.c_str()), is_flip_flop};
-	}
+	for (auto &it : liberty_cell_info(liberty_file, cache_dir))
+		if (it.second.has_area)
+			cell_area["\\" + it.first] = {/*area=*/it.second.area, it.second.is_sequential};
 }
 
 struct StatPass : public Pass {
-	StatPass() : Pass("stat", "print some statistics") { }
+	StatPass() : Pass("stat", "print some statistics") { keeps_shared_modules(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -417,7 +419,7 @@ struct StatPass : public Pass {
 			if (args[argidx] == "-liberty" && argidx+1 < args.size()) {
 				string liberty_file = args[++argidx];
 				rewrite_filename(liberty_file);
-				read_liberty_cellarea(cell_area, liberty_file);
+				read_liberty_cellarea(cell_area, liberty_file, design->scratchpad_get_string("liberty.cache"));
 				continue;
 			}
 			if (args[argidx] == "-tech" && argidx+1 < args.size()) {
@@ -488,7 +490,11 @@ struct StatPass : public Pass {
 				log("   %-28s %6d\n", log_id(top_mod->name), 1);
 			}
 
-			statdata_t data = hierarchy_worker(mod_stat, top_mod->name, 0, /*quiet=*/json_mode);
+			if (!json_mode)
+				log_hierarchy(mod_stat, top_mod->name, 0);
+
+			dict<RTLIL::IdString, statdata_t> sums;
+			statdata_t data = hierarchy_worker(mod_stat, top_mod->name, sums);
 
 			if (json_mode)
 				data.log_data_json("design", true);
@@ -19,7 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
-#include "kernel/sigtools.h"
+#include "kernel/modgraph.h"
 #include "kernel/utils.h"
 
 USING_YOSYS_NAMESPACE
@@ -70,39 +70,36 @@ struct TorderPass : public Pass {
 		{
 			log("module %s\n", log_id(module));
 
-			SigMap sigmap(module);
-			dict<SigBit, pool<IdString>> bit_drivers, bit_users;
+			ModuleGraph graph(module);
 			TopoSort<IdString, RTLIL::sort_by_id_str> toposort;
 
-			for (auto cell : module->selected_cells())
-			for (auto conn : cell->connections())
-			{
-				if (stop_db.count(cell->type) && stop_db.at(cell->type).count(conn.first))
-					continue;
-
+			auto is_stopped = [&](RTLIL::Cell *cell, IdString port) {
+				if (stop_db.count(cell->type) && stop_db.at(cell->type).count(port))
+					return true;
 				if (!noautostop && yosys_celltypes.cell_known(cell->type)) {
-					if (conn.first.in(ID::Q, ID::CTRL_OUT, ID::RD_DATA))
-						continue;
-					if (cell->type.in(ID($memrd), ID($memrd_v2)) && conn.first == ID::DATA)
-						continue;
+					if (port.in(ID::Q, ID::CTRL_OUT, ID::RD_DATA))
+						return true;
+					if (cell->type.in(ID($memrd), ID($memrd_v2)) && port == ID::DATA)
+						return true;
 				}
+				return false;
+			};
 
-				if (cell->input(conn.first))
-					for (auto bit : sigmap(conn.second))
-						bit_users[bit].insert(cell->name);
-
-				if (cell->output(conn.first))
-					for (auto bit : sigmap(conn.second))
-						bit_drivers[bit].insert(cell->name);
-
-				toposort.node(cell->name);
-			}
-
-			for (auto &it : bit_users)
-				if (bit_drivers.count(it.first))
-					for (auto driver_cell : bit_drivers.at(it.first))
-					for (auto user_cell : it.second)
-						toposort.edge(driver_cell, user_cell);
+			for (auto cell : module->selected_cells())
+			for (auto conn : cell->connections())
+				if (!is_stopped(cell, conn.first))
+					toposort.node(cell->name);
+
+			auto is_used = [&](const ModuleGraph::PortBit &port) {
+				RTLIL::Cell *cell = graph.cell(port.cell);
+				return module->selected(cell) && !is_stopped(cell, port.port);
+			};
+
+			for (int net = 0; net < graph.num_nets(); net++)
+				for (auto &driver : graph.drivers(net))
+				for (auto &user : graph.sinks(net))
+					if (is_used(driver) && is_used(user))
+						toposort.edge(graph.cell(driver.cell)->name, graph.cell(user.cell)->name);
 
 			toposort.analyze_loops = true;
 			toposort.sort();
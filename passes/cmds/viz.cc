@@ -51,6 +51,7 @@ struct VizConfig {
 	int similar_thresh = 30;
 	int small_group_thresh = 10;
 	int large_group_count = 10;
+	int node_limit = -1;
 	std::vector<std::pair<group_type_t, RTLIL::Selection>> groups;
 };
 
@@ -697,6 +698,12 @@ struct VizWorker
 					effort == config.effort ? "Final" : "Status", GetSize(graph.nodes),
 					GetSize(graph.term_nodes), GetSize(graph.nonterm_nodes),
 					graph.edge_count, graph.tag_count);
+			// the graph is small enough, skip the more expensive merge strategies
+			if (config.node_limit >= 0 && GetSize(graph.nodes) <= config.node_limit && effort < config.effort) {
+				log("  Stopping at effort level %d with %d nodes, within the limit of %d nodes.\n",
+						effort, GetSize(graph.nodes), config.node_limit);
+				break;
+			}
 		}
 	}
 
@@ -876,6 +883,12 @@ struct VizPass : public Pass {
 		log("        aggressive sequence of strategies for merging nodes of the data flow\n");
 		log("        graph. (default: %d)\n", VizConfig().effort);
 		log("\n");
+		log("    -limit <N>\n");
+		log("        stop merging nodes as soon as the graph has at most N nodes, instead of\n");
+		log("        running all strategies up to the effort level. This is much faster on\n");
+		log("        large modules. Graphs with more than N nodes (default: 200) are only\n");
+		log("        written as a dot file and not rendered with graphviz.\n");
+		log("\n");
 		log("When no <format> is specified, 'dot' is used. When no <format> and <viewer> is\n");
 		log("specified, 'xdot' is used to display the schematic (POSIX systems only).\n");
 		log("\n");
@@ -959,6 +972,10 @@ struct VizPass : public Pass {
 				config.effort = arg[1] - '0';
 				continue;
 			}
+			if (arg == "-limit" && argidx+1 < args.size()) {
+				config.node_limit = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -996,12 +1013,13 @@ struct VizPass : public Pass {
 			if (flag_attr)
 				worker.update_attrs();
 
-			if (format != "dot" && GetSize(worker.graph.nodes) > 200) {
+			int max_nodes = config.node_limit < 0 ? 200 : config.node_limit;
+			if (format != "dot" && GetSize(worker.graph.nodes) > max_nodes) {
 				if (format.empty()) {
-					log_warning("Suppressing module in output as graph size exceeds 200 nodes.\n");
+					log_warning("Suppressing module in output as graph size exceeds %d nodes.\n", max_nodes);
 					continue;
 				} else {
-					log_warning("Changing format to 'dot' as graph size exceeds 200 nodes.\n");
+					log_warning("Changing format to 'dot' as graph size exceeds %d nodes.\n", max_nodes);
 					format = "dot";
 				}
 			}
@@ -712,11 +712,28 @@ struct XpropWorker
 			auto &sig_b = cell->getPort(ID::B);
 			auto sig_s = cell->getPort(ID::S);
 
+			auto enc_a = encoded(sig_a);
+			auto enc_b = encoded(sig_b);
+
+			// with a non-x select input, each rail is a plain multiplexer
+			if (!maybe_x(sig_s)) {
+				auto enc_y = encoded(sig_y, true);
+				if (cell->type == ID($bwmux)) {
+					enc_y.connect_0(module->Bwmux(NEW_ID, enc_a.is_0, enc_b.is_0, sig_s));
+					enc_y.connect_1(module->Bwmux(NEW_ID, enc_a.is_1, enc_b.is_1, sig_s));
+					enc_y.connect_x(module->Bwmux(NEW_ID, enc_a.is_x, enc_b.is_x, sig_s));
+				} else {
+					enc_y.connect_0(module->Mux(NEW_ID, enc_a.is_0, enc_b.is_0, sig_s));
+					enc_y.connect_1(module->Mux(NEW_ID, enc_a.is_1, enc_b.is_1, sig_s));
+					enc_y.connect_x(module->Mux(NEW_ID, enc_a.is_x, enc_b.is_x, sig_s));
+				}
+				module->remove(cell);
+				return;
+			}
+
 			if (cell->type == ID($mux))
 				sig_s = SigSpec(sig_s[0], GetSize(sig_y));
 
-			auto enc_a = encoded(sig_a);
-			auto enc_b = encoded(sig_b);
 			auto enc_s = encoded(sig_s);
 			auto enc_y = encoded(sig_y, true);
 
@@ -749,14 +766,12 @@ struct XpropWorker
 				module->And(NEW_ID, enc_s.is_1, module->Sub(NEW_ID, enc_s.is_1, Const(1, width)))
 			});
 
+			// one $pmux per rail, the cases with more than one active select
+			// bit are overridden by all_x
 			auto selected = enc_a;
-
-			for (int i = 0; i < GetSize(enc_s); i++) {
-				auto sel_bit = enc_s.is_1[i];
-				selected.is_0 = module->Mux(NEW_ID, selected.is_0, enc_b.is_0.extract(i * width, width), sel_bit);
-				selected.is_1 = module->Mux(NEW_ID, selected.is_1, enc_b.is_1.extract(i * width, width), sel_bit);
-				selected.is_x = module->Mux(NEW_ID, selected.is_x, enc_b.is_x.extract(i * width, width), sel_bit);
-			}
+			selected.is_0 = module->Pmux(NEW_ID, enc_a.is_0, enc_b.is_0, enc_s.is_1);
+			selected.is_1 = module->Pmux(NEW_ID, enc_a.is_1, enc_b.is_1, enc_s.is_1);
+			selected.is_x = module->Pmux(NEW_ID, enc_a.is_x, enc_b.is_x, enc_s.is_1);
 
 			enc_y.connect_0(module->Mux(NEW_ID, selected.is_0, Const(State::S0, width), all_x));
 			enc_y.connect_1(module->Mux(NEW_ID, selected.is_1, Const(State::S0, width), all_x));
@@ -766,6 +781,28 @@ struct XpropWorker
 			return;
 		}
 
+		if (cell->type.in(ID($bmux), ID($demux)) && !maybe_x(cell->getPort(ID::S))) {
+			auto &sig_y = cell->getPort(ID::Y);
+			auto &sig_a = cell->getPort(ID::A);
+			auto &sig_s = cell->getPort(ID::S);
+
+			auto enc_a = encoded(sig_a);
+			auto enc_y = encoded(sig_y, true);
+
+			if (cell->type == ID($bmux)) {
+				enc_y.connect_0(module->Bmux(NEW_ID, enc_a.is_0, sig_s));
+				enc_y.connect_1(module->Bmux(NEW_ID, enc_a.is_1, sig_s));
+				enc_y.connect_x(module->Bmux(NEW_ID, enc_a.is_x, sig_s));
+			} else {
+				// the outputs that are not selected are 0
+				enc_y.connect_1(module->Demux(NEW_ID, enc_a.is_1, sig_s));
+				enc_y.connect_x(module->Demux(NEW_ID, enc_a.is_x, sig_s));
+				enc_y.auto_0();
+			}
+			module->remove(cell);
+			return;
+		}
+
 		if (cell->type.in(ID($shl), ID($shr), ID($sshl), ID($sshr), ID($shift), ID($shiftx))) {
 			auto &sig_y = cell->getPort(ID::Y);
 			auto &sig_a = cell->getPort(ID::A);
@@ -953,9 +990,9 @@ struct XpropWorker
 			return;
 		}
 
-		if (cell->type == ID($bmux)) // TODO might want to support bmux natively anyway
+		if (cell->type == ID($bmux)) // only supported natively with a non-x select input
 			log("Running 'bmuxmap' preserves x-propagation and can be run before 'xprop'.\n");
-		if (cell->type == ID($demux)) // TODO might want to support demux natively anyway
+		if (cell->type == ID($demux)) // only supported natively with a non-x select input
 			log("Running 'demuxmap' preserves x-propagation and can be run before 'xprop'.\n");
 
 		if (options.required)
@@ -26,6 +26,7 @@ PRIVATE_NAMESPACE_BEGIN
 
 struct EquivMakeWorker
 {
+	Design *design;
 	Module *gold_mod, *gate_mod, *equiv_mod;
 	pool<IdString> wire_names, cell_names;
 	CellTypes ct;
@@ -34,6 +35,7 @@ struct EquivMakeWorker
 	vector<string> blacklists;
 	vector<string> encfiles;
 	bool make_assert;
+	bool simmatch;
 
 	pool<IdString> blacklist_names;
 	dict<IdString, dict<Const, Const>> encdata;
@@ -140,6 +142,207 @@ struct EquivMakeWorker
 		equiv_mod->addAssert(NEW_ID_SUFFIX("assert"), eq_wire, State::S1);
 	}
 
+	// the number of threads for matching `count` names
+	int match_jobs(int count)
+	{
+		return count < 1024 ? 1 : std::min(count / 256, 4 * Pass::parallel_threads(design));
+	}
+
+	// 256 random patterns per signal bit, simulated bit-parallel
+	typedef std::array<uint64_t, 4> SimValue;
+
+	// Used with -simmatch for the wires that only exist on one side. Both
+	// sides are simulated with the same random values on the inputs matched
+	// by name, through the fine-grained gates and the coarse bitwise cells
+	// whose ports all have the same width. Bits that are driven by such a
+	// cell and have a unique value that is not constant are paired with the
+	// bit of the other side that has the same value.
+	vector<pair<SigBit, SigBit>> find_sim_matches(SigMap &assign_map, const vector<IdString> &ids, const vector<pair<Wire*, Wire*>> &matched)
+	{
+		dict<SigBit, SimValue> values;
+		values[State::S0] = SimValue{0, 0, 0, 0};
+		values[State::S1] = SimValue{~0ull, ~0ull, ~0ull, ~0ull};
+
+		pool<SigBit> named_bits;
+		uint64_t seed = 0x9e3779b97f4a7c15ull;
+		for (int k = 0; k < GetSize(ids); k++) {
+			Wire *gold_wire = matched[k].first, *gate_wire = matched[k].second;
+			if (gold_wire == nullptr || gate_wire == nullptr)
+				continue;
+			for (auto bit : assign_map(gold_wire))
+				named_bits.insert(bit);
+			for (auto bit : assign_map(gate_wire))
+				named_bits.insert(bit);
+			if ((!gold_wire->port_input && !gate_wire->port_input) || gold_wire->width != gate_wire->width)
+				continue;
+			for (int i = 0; i < gold_wire->width; i++) {
+				SimValue value;
+				for (auto &word : value) {
+					seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+					word = seed;
+				}
+				values[assign_map(SigBit(gold_wire, i))] = value;
+				values[assign_map(SigBit(gate_wire, i))] = value;
+			}
+		}
+
+		struct SimGate {
+			IdString type;
+			int inputs;
+			SigBit in[4], out;
+			int missing = 0;
+		};
+		vector<SimGate> gates;
+
+		for (auto cell : equiv_mod->cells())
+		{
+			IdString type = cell->type;
+			vector<IdString> ports;
+			if (type.in(ID($_BUF_), ID($_NOT_)))
+				ports = {ID::A};
+			else if (type.in(ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_)))
+				ports = {ID::A, ID::B};
+			else if (type.in(ID($_MUX_), ID($_NMUX_)))
+				ports = {ID::A, ID::B, ID::S};
+			else if (type.in(ID($_AOI3_), ID($_OAI3_)))
+				ports = {ID::A, ID::B, ID::C};
+			else if (type.in(ID($_AOI4_), ID($_OAI4_)))
+				ports = {ID::A, ID::B, ID::C, ID::D};
+			else {
+				static const dict<IdString, IdString> bitwise_types = {
+					{ID($pos), ID($_BUF_)}, {ID($not), ID($_NOT_)}, {ID($and), ID($_AND_)}, {ID($or), ID($_OR_)},
+					{ID($xor), ID($_XOR_)}, {ID($xnor), ID($_XNOR_)}, {ID($mux), ID($_MUX_)}
+				};
+				auto it = bitwise_types.find(type);
+				if (it == bitwise_types.end())
+					continue;
+				type = it->second;
+				int width = GetSize(cell->getPort(ID::Y));
+				ports = {ID::A};
+				if (cell->hasPort(ID::B))
+					ports.push_back(ID::B);
+				bool same_width = true;
+				for (auto port : ports)
+					same_width = same_width && GetSize(cell->getPort(port)) == width;
+				if (!same_width || (cell->type == ID($mux) && GetSize(cell->getPort(ID::S)) != 1))
+					continue;
+				SigSpec y = cell->getPort(ID::Y);
+				for (int i = 0; i < width; i++) {
+					SimGate gate;
+					gate.type = type;
+					gate.inputs = GetSize(ports);
+					for (int j = 0; j < GetSize(ports); j++)
+						gate.in[j] = assign_map(cell->getPort(ports[j])[i]);
+					if (cell->type == ID($mux))
+						gate.in[gate.inputs++] = assign_map(cell->getPort(ID::S)[0]);
+					gate.out = assign_map(y[i]);
+					gates.push_back(gate);
+				}
+				continue;
+			}
+			SimGate gate;
+			gate.type = type;
+			gate.inputs = GetSize(ports);
+			for (int j = 0; j < GetSize(ports); j++)
+				gate.in[j] = assign_map(cell->getPort(ports[j]));
+			gate.out = assign_map(cell->getPort(ID::Y));
+			gates.push_back(gate);
+		}
+
+		// evaluate the gates once all their inputs are known, gates in
+		// loops or behind other cells never are
+		dict<SigBit, vector<int>> readers;
+		vector<int> queue;
+		for (int g = 0; g < GetSize(gates); g++) {
+			for (int j = 0; j < gates[g].inputs; j++)
+				if (!values.count(gates[g].in[j])) {
+					gates[g].missing++;
+					readers[gates[g].in[j]].push_back(g);
+				}
+			if (gates[g].missing == 0)
+				queue.push_back(g);
+		}
+
+		pool<SigBit> simulated;
+		while (!queue.empty())
+		{
+			SimGate &gate = gates[queue.back()];
+			queue.pop_back();
+			if (values.count(gate.out))
+				continue;
+
+			SimValue in[4] = {}, y;
+			for (int j = 0; j < gate.inputs; j++)
+				in[j] = values.at(gate.in[j]);
+			const SimValue &a = in[0], &b = in[1], &c = in[2], &d = in[3];
+			const IdString &type = gate.type;
+			for (int i = 0; i < 4; i++) {
+				if (type == ID($_BUF_)) y[i] = a[i];
+				else if (type == ID($_NOT_)) y[i] = ~a[i];
+				else if (type == ID($_AND_)) y[i] = a[i] & b[i];
+				else if (type == ID($_NAND_)) y[i] = ~(a[i] & b[i]);
+				else if (type == ID($_OR_)) y[i] = a[i] | b[i];
+				else if (type == ID($_NOR_)) y[i] = ~(a[i] | b[i]);
+				else if (type == ID($_XOR_)) y[i] = a[i] ^ b[i];
+				else if (type == ID($_XNOR_)) y[i] = ~(a[i] ^ b[i]);
+				else if (type == ID($_ANDNOT_)) y[i] = a[i] & ~b[i];
+				else if (type == ID($_ORNOT_)) y[i] = a[i] | ~b[i];
+				else if (type == ID($_MUX_)) y[i] = (a[i] & ~c[i]) | (b[i] & c[i]);
+				else if (type == ID($_NMUX_)) y[i] = ~((a[i] & ~c[i]) | (b[i] & c[i]));
+				else if (type == ID($_AOI3_)) y[i] = ~((a[i] & b[i]) | c[i]);
+				else if (type == ID($_OAI3_)) y[i] = ~((a[i] | b[i]) & c[i]);
+				else if (type == ID($_AOI4_)) y[i] = ~((a[i] & b[i]) | (c[i] & d[i]));
+				else y[i] = ~((a[i] | b[i]) & (c[i] | d[i]));
+			}
+
+			values[gate.out] = y;
+			simulated.insert(gate.out);
+			auto it = readers.find(gate.out);
+			if (it != readers.end())
+				for (int r : it->second)
+					if (--gates[r].missing == 0)
+						queue.push_back(r);
+		}
+
+		auto signature = [&](SigBit bit, SimValue &value) {
+			bit = assign_map(bit);
+			if (!simulated.count(bit) || named_bits.count(bit))
+				return false;
+			value = values.at(bit);
+			return value != values.at(State::S0) && value != values.at(State::S1);
+		};
+
+		dict<SimValue, SigBit> gate_bits;
+		pool<SimValue> ambiguous;
+		for (int k = 0; k < GetSize(ids); k++) {
+			Wire *gate_wire = matched[k].second;
+			if (matched[k].first != nullptr || gate_wire == nullptr)
+				continue;
+			SimValue value;
+			for (int i = 0; i < gate_wire->width; i++)
+				if (signature(SigBit(gate_wire, i), value) && !gate_bits.emplace(value, SigBit(gate_wire, i)).second)
+					ambiguous.insert(value);
+		}
+
+		vector<pair<SigBit, SigBit>> sim_matches;
+		for (int k = 0; k < GetSize(ids); k++) {
+			Wire *gold_wire = matched[k].first;
+			if (gold_wire == nullptr || matched[k].second != nullptr)
+				continue;
+			SimValue value;
+			for (int i = 0; i < gold_wire->width; i++) {
+				if (!signature(SigBit(gold_wire, i), value) || ambiguous.count(value))
+					continue;
+				auto it = gate_bits.find(value);
+				if (it == gate_bits.end())
+					continue;
+				sim_matches.push_back({SigBit(gold_wire, i), it->second});
+				gate_bits.erase(it);
+			}
+		}
+		return sim_matches;
+	}
+
 	void find_same_wires()
 	{
 		SigMap assign_map(equiv_mod);
@@ -149,13 +352,35 @@ struct EquivMakeWorker
 		// list of cells without added $equiv cells
 		auto cells_list = equiv_mod->cells().to_vector();
 
-		for (auto id : wire_names)
-		{
-			IdString gold_id = id.str() + "_gold";
-			IdString gate_id = id.str() + "_gate";
+		// the name lookups of the two sides are done in parallel, the
+		// module is only changed in the serial loop below
+		vector<IdString> ids(wire_names.begin(), wire_names.end());
+		vector<pair<Wire*, Wire*>> matched(GetSize(ids));
+		int jobs = match_jobs(GetSize(ids));
+		Pass::parallel_for(design, jobs, [&](int job) {
+			for (int k = job; k < GetSize(ids); k += jobs)
+				matched[k] = {equiv_mod->wire(ids[k].str() + "_gold"), equiv_mod->wire(ids[k].str() + "_gate")};
+		});
+
+		vector<pair<SigBit, SigBit>> sim_matches;
+		if (simmatch)
+			sim_matches = find_sim_matches(assign_map, ids, matched);
+
+		// one $equiv cell and wire per matched bit
+		if (!make_assert) {
+			int new_bits = GetSize(sim_matches);
+			for (auto &it : matched)
+				if (it.first != nullptr && it.second != nullptr && it.first->width == it.second->width)
+					new_bits += it.first->width;
+			equiv_mod->cells_.reserve(GetSize(equiv_mod->cells_) + new_bits);
+			equiv_mod->wires_.reserve(GetSize(equiv_mod->wires_) + GetSize(matched) + GetSize(sim_matches));
+		}
 
-			Wire *gold_wire = equiv_mod->wire(gold_id);
-			Wire *gate_wire = equiv_mod->wire(gate_id);
+		for (int k = 0; k < GetSize(ids); k++)
+		{
+			IdString id = ids[k];
+			Wire *gold_wire = matched[k].first;
+			Wire *gate_wire = matched[k].second;
 
 			if (encdata.count(id))
 			{
@@ -303,6 +528,21 @@ struct EquivMakeWorker
 			}
 		}
 
+		for (auto &it : sim_matches)
+		{
+			log("Presumably equivalent bits by simulation: %s, %s\n", log_signal(it.first), log_signal(it.second));
+
+			if (make_assert) {
+				add_eq_assertion(it.first, it.second);
+				continue;
+			}
+
+			Wire *wire = equiv_mod->addWire(NEW_ID);
+			equiv_mod->addEquiv(NEW_ID, it.first, it.second, wire);
+			rd_signal_map.add(assign_map(it.first), wire);
+			rd_signal_map.add(assign_map(it.second), wire);
+		}
+
 		for (auto c : cells_list)
 		for (auto &conn : c->connections())
 			if (!ct.cell_output(c->type, conn.first)) {
@@ -326,22 +566,37 @@ struct EquivMakeWorker
 	{
 		SigMap assign_map(equiv_mod);
 
-		for (auto id : cell_names)
-		{
-			IdString gold_id = id.str() + "_gold";
-			IdString gate_id = id.str() + "_gate";
+		// the candidate pairs are found in parallel, each pair is only
+		// changed by its own iteration of the serial loop below
+		vector<IdString> ids(cell_names.begin(), cell_names.end());
+		vector<pair<Cell*, Cell*>> matched(GetSize(ids));
+		int jobs = match_jobs(GetSize(ids));
+		Pass::parallel_for(design, jobs, [&](int job) {
+			for (int k = job; k < GetSize(ids); k += jobs)
+			{
+				Cell *gold_cell = equiv_mod->cell(ids[k].str() + "_gold");
+				Cell *gate_cell = equiv_mod->cell(ids[k].str() + "_gate");
 
-			Cell *gold_cell = equiv_mod->cell(gold_id);
-			Cell *gate_cell = equiv_mod->cell(gate_id);
+				if (gold_cell == nullptr || gate_cell == nullptr || gold_cell->type != gate_cell->type || !ct.cell_known(gold_cell->type) ||
+						gold_cell->parameters != gate_cell->parameters || GetSize(gold_cell->connections()) != GetSize(gate_cell->connections()))
+			try_next_cell_name:
+					continue;
 
-			if (gold_cell == nullptr || gate_cell == nullptr || gold_cell->type != gate_cell->type || !ct.cell_known(gold_cell->type) ||
-					gold_cell->parameters != gate_cell->parameters || GetSize(gold_cell->connections()) != GetSize(gate_cell->connections()))
-		try_next_cell_name:
-				continue;
+				for (auto gold_conn : gold_cell->connections())
+					if (!gate_cell->connections().count(gold_conn.first))
+						goto try_next_cell_name;
 
-			for (auto gold_conn : gold_cell->connections())
-				if (!gate_cell->connections().count(gold_conn.first))
-					goto try_next_cell_name;
+				matched[k] = {gold_cell, gate_cell};
+			}
+		});
+
+		for (int k = 0; k < GetSize(ids); k++)
+		{
+			IdString id = ids[k];
+			Cell *gold_cell = matched[k].first;
+			Cell *gate_cell = matched[k].second;
+			if (gold_cell == nullptr)
+				continue;
 
 			log("Presumably equivalent cells: %s %s (%s) -> %s\n",
 					log_id(gold_cell), log_id(gate_cell), log_id(gold_cell->type), log_id(id));
@@ -450,6 +705,13 @@ struct EquivMakePass : public Pass {
 		log("        Check equivalence with $assert cells instead of $equiv.\n");
 		log("        $eqx (===) is used to compare signals.");
 		log("\n");
+		log("    -simmatch\n");
+		log("        Also match the bits of wires that only exist in one of the modules,\n");
+		log("        e.g. because they were renamed, by simulating both modules with the\n");
+		log("        same random values on the inputs. Only the fine-grained gates and\n");
+		log("        coarse bitwise cells with equally wide ports are simulated, and bits\n");
+		log("        with the same unique non-constant values are matched.\n");
+		log("\n");
 		log("Note: The circuit created by this command is not a miter (with something like\n");
 		log("a trigger output), but instead uses $equiv cells to encode the equivalence\n");
 		log("checking problem. Use 'miter -equiv' if you want to create a miter circuit.\n");
@@ -458,9 +720,11 @@ struct EquivMakePass : public Pass {
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		EquivMakeWorker worker;
+		worker.design = design;
 		worker.ct.setup(design);
 		worker.inames = false;
 		worker.make_assert = false;
+		worker.simmatch = false;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++)
@@ -481,6 +745,10 @@ struct EquivMakePass : public Pass {
 				worker.make_assert = true;
 				continue;
 			}
+			if (args[argidx] == "-simmatch") {
+				worker.simmatch = true;
+				continue;
+			}
 			break;
 		}
 
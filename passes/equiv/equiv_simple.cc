@@ -23,14 +23,17 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// The solver of a worker is shared by consecutive groups of $equiv cells, so
+// that their common input cones are only imported once. It is replaced by a
+// new one once it has grown beyond this number of clauses.
+static const int EQUIV_SIMPLE_MAX_CLAUSES = 1000000;
+
 struct EquivSimpleWorker
 {
-	Module *module;
-	const vector<Cell*> &equiv_cells;
 	Cell *equiv_cell;
 
 	SigMap &sigmap;
-	dict<SigBit, Cell*> &bit2driver;
+	const flat_dict<SigBit, Cell*> &bit2driver;
 
 	ezSatPtr ez;
 	SatGen satgen;
@@ -40,9 +43,13 @@ struct EquivSimpleWorker
 
 	pool<pair<Cell*, int>> imported_cells_cache;
 
-	EquivSimpleWorker(const vector<Cell*> &equiv_cells, SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, int max_seq, bool short_cones, bool verbose, bool model_undef) :
-			module(equiv_cells.front()->module), equiv_cells(equiv_cells), equiv_cell(nullptr),
-			sigmap(sigmap), bit2driver(bit2driver), satgen(ez.get(), &sigmap), max_seq(max_seq), short_cones(short_cones), verbose(verbose)
+	// if set, proven cells are collected here instead of being updated
+	// directly, for workers that run in parallel on the same module
+	vector<Cell*> *proven_cells;
+
+	EquivSimpleWorker(SigMap &sigmap, const flat_dict<SigBit, Cell*> &bit2driver, int max_seq, bool short_cones, bool verbose, bool model_undef, vector<Cell*> *proven_cells) :
+			equiv_cell(nullptr), sigmap(sigmap), bit2driver(bit2driver), satgen(ez.get(), &sigmap), max_seq(max_seq), short_cones(short_cones),
+			verbose(verbose), proven_cells(proven_cells)
 	{
 		satgen.model_undef = model_undef;
 	}
@@ -193,9 +200,11 @@ struct EquivSimpleWorker
 				imported_cells_cache.insert(key);
 			}
 
+			// the cut points of the short cones are only defined for this cell,
+			// as the solver is shared with other cells
 			if (satgen.model_undef) {
 				for (auto bit : input_bits)
-					ez->assume(ez->NOT(satgen.importUndefSigBit(bit, step+1)));
+					ez->assume(ez->NOT(satgen.importUndefSigBit(bit, step+1)), ez_context);
 			}
 
 			if (verbose)
@@ -203,7 +212,10 @@ struct EquivSimpleWorker
 
 			if (!ez->solve(ez_context)) {
 				log(verbose ? "    Proved equivalence! Marking $equiv cell as proven.\n" : " success!\n");
-				equiv_cell->setPort(ID::B, equiv_cell->getPort(ID::A));
+				if (proven_cells != nullptr)
+					proven_cells->push_back(equiv_cell);
+				else
+					equiv_cell->setPort(ID::B, equiv_cell->getPort(ID::A));
 				ez->assume(ez->NOT(ez_context));
 				return true;
 			}
@@ -255,7 +267,7 @@ struct EquivSimpleWorker
 		return false;
 	}
 
-	int run()
+	int run(const vector<Cell*> &equiv_cells)
 	{
 		if (GetSize(equiv_cells) > 1) {
 			SigSpec sig;
@@ -301,6 +313,10 @@ struct EquivSimplePass : public Pass {
 		log("    -seq <N>\n");
 		log("        the max. number of time steps to be considered (default = 1)\n");
 		log("\n");
+		log("Consecutive groups share one SAT solver, so that common parts of their input\n");
+		log("cones are only imported once. With 'yosys -j', the groups are distributed\n");
+		log("over several threads, each with its own solver.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, Design *design) override
 	{
@@ -345,7 +361,7 @@ struct EquivSimplePass : public Pass {
 		for (auto module : design->selected_modules())
 		{
 			SigMap sigmap(module);
-			dict<SigBit, Cell*> bit2driver;
+			flat_dict<SigBit, Cell*> bit2driver;
 			dict<SigBit, dict<SigBit, Cell*>> unproven_equiv_cells;
 			int unproven_cells_counter = 0;
 
@@ -374,17 +390,44 @@ struct EquivSimplePass : public Pass {
 							bit2driver[bit] = cell;
 			}
 
+			vector<vector<Cell*>> groups;
 			unproven_equiv_cells.sort();
 			for (auto it : unproven_equiv_cells)
 			{
 				it.second.sort();
-
-				vector<Cell*> cells;
+				groups.emplace_back();
 				for (auto it2 : it.second)
-					cells.push_back(it2.second);
+					groups.back().push_back(it2.second);
+			}
+
+			// The groups are independent. They are processed in consecutive
+			// chunks with one solver each. In parallel, each chunk uses its own
+			// copy of sigmap, which is not thread safe, and the proven cells are
+			// only updated once all chunks are done.
+			int threads = Pass::parallel_threads(design);
+			int jobs = std::min(GetSize(groups), threads > 1 ? 4 * threads : 1);
+			vector<vector<Cell*>> job_proven_cells(jobs);
+			vector<int> job_counter(jobs);
+
+			Pass::parallel_for(design, jobs, [&](int job)
+			{
+				SigMap job_sigmap;
+				if (jobs > 1)
+					job_sigmap = sigmap;
+
+				std::unique_ptr<EquivSimpleWorker> worker;
+				for (int i = job * GetSize(groups) / jobs; i < (job + 1) * GetSize(groups) / jobs; i++) {
+					if (worker == nullptr || worker->ez->numCnfClauses() > EQUIV_SIMPLE_MAX_CLAUSES)
+						worker.reset(new EquivSimpleWorker(jobs > 1 ? job_sigmap : sigmap, bit2driver, max_seq, short_cones, verbose,
+								model_undef, jobs > 1 ? &job_proven_cells[job] : nullptr));
+					job_counter[job] += worker->run(groups[i]);
+				}
+			});
 
-				EquivSimpleWorker worker(cells, sigmap, bit2driver, max_seq, short_cones, verbose, model_undef);
-				success_counter += worker.run();
+			for (int job = 0; job < jobs; job++) {
+				for (auto cell : job_proven_cells[job])
+					cell->setPort(ID::B, cell->getPort(ID::A));
+				success_counter += job_counter[job];
 			}
 		}
 
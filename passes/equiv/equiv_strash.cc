@@ -0,0 +1,335 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+#include "kernel/cellaigs.h"
+#include "kernel/satgen.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+// A structurally hashed AIG of the combinational logic of a module. Literals
+// are 2*node+inverted, node 0 is constant false. Every node carries the values
+// of num_words*64 random input patterns. With use_sat, a new AND node whose
+// values match those of an earlier node is checked for equivalence with SAT
+// and replaced by the earlier node if it is, so that hashing also continues
+// on top of logic that is equivalent but not identical (FRAIG style).
+struct EquivStrashWorker
+{
+	Module *module;
+	SigMap sigmap;
+	dict<SigBit, Cell*> bit2driver;
+
+	int num_words;
+	bool use_sat;
+
+	vector<pair<int, int>> nodes;
+	vector<uint64_t> sim;
+	dict<pair<int, int>, int> strash;
+	dict<uint64_t, int> sim_classes;
+	dict<SigBit, int> bit_lits;
+	pool<Cell*> busy_cells;
+	uint64_t rng;
+
+	ezSatPtr ez;
+	vector<int> ez_nodes;
+
+	int sat_calls, sat_merges;
+
+	EquivStrashWorker(Module *module, int num_words, bool use_sat) : module(module), sigmap(module),
+			num_words(num_words), use_sat(use_sat && num_words > 0), rng(88172645463325252ULL), sat_calls(0), sat_merges(0)
+	{
+		for (auto cell : module->cells())
+			for (auto &conn : cell->connections())
+				if (cell->output(conn.first))
+					for (auto bit : sigmap(conn.second))
+						bit2driver[bit] = cell;
+
+		nodes.push_back(make_pair(-1, -1));
+		sim.insert(sim.end(), num_words, 0);
+		ez_nodes.push_back(ez->CONST_FALSE);
+		if (this->use_sat)
+			find_equivalent(0);
+	}
+
+	uint64_t sim_word(int lit, int word) const
+	{
+		uint64_t value = sim[(lit >> 1) * num_words + word];
+		return (lit & 1) ? ~value : value;
+	}
+
+	int ez_lit(int lit) const
+	{
+		return (lit & 1) ? ez->NOT(ez_nodes[lit >> 1]) : ez_nodes[lit >> 1];
+	}
+
+	int new_input()
+	{
+		int node = GetSize(nodes);
+		nodes.push_back(make_pair(-1, -1));
+		for (int i = 0; i < num_words; i++) {
+			rng ^= rng << 13, rng ^= rng >> 7, rng ^= rng << 17;
+			sim.push_back(rng);
+		}
+		ez_nodes.push_back(use_sat ? ez->frozen_literal() : 0);
+		if (use_sat)
+			find_equivalent(2*node);
+		return 2*node;
+	}
+
+	// Look for an earlier node with the same simulation values (possibly
+	// inverted) and return its literal if SAT proves the two equivalent.
+	int find_equivalent(int lit)
+	{
+		int phase = sim_word(lit, 0) & 1;
+		uint64_t hash = 5381;
+		for (int i = 0; i < num_words; i++)
+			hash = ((hash ^ sim_word(lit ^ phase, i)) * 0x9e3779b97f4a7c15ULL) ^ (hash >> 29);
+
+		auto it = sim_classes.find(hash);
+		if (it == sim_classes.end()) {
+			sim_classes[hash] = lit ^ phase;
+			return -1;
+		}
+
+		int repr = it->second ^ phase;
+		for (int i = 0; i < num_words; i++)
+			if (sim_word(lit, i) != sim_word(repr, i))
+				return -1;
+
+		sat_calls++;
+		if (ez->solve(ez->XOR(ez_lit(lit), ez_lit(repr))))
+			return -1;
+
+		sat_merges++;
+		return repr;
+	}
+
+	int mk_and(int a, int b)
+	{
+		if (a > b)
+			std::swap(a, b);
+		if (a == 0 || a == (b ^ 1))
+			return 0;
+		if (a == 1 || a == b)
+			return b;
+
+		auto key = make_pair(a, b);
+		auto it = strash.find(key);
+		if (it != strash.end())
+			return it->second;
+
+		int node = GetSize(nodes);
+		nodes.push_back(key);
+		for (int i = 0; i < num_words; i++)
+			sim.push_back(sim_word(a, i) & sim_word(b, i));
+
+		if (use_sat) {
+			ez_nodes.push_back(ez->frozen_literal());
+			ez->assume(ez->IFF(ez_nodes.back(), ez->AND(ez_lit(a), ez_lit(b))));
+		} else
+			ez_nodes.push_back(0);
+
+		int lit = 2*node;
+		if (use_sat) {
+			int repr = find_equivalent(lit);
+			if (repr >= 0)
+				lit = repr;
+		}
+
+		strash[key] = lit;
+		return lit;
+	}
+
+	bool import_cell(Cell *cell)
+	{
+		const Aig &aig = Aig::cached(cell);
+		if (aig.name.empty())
+			return false;
+
+		vector<int> lits;
+		for (auto &node : aig.nodes)
+		{
+			int lit;
+			if (node.portbit >= 0)
+				lit = literal(cell->getPort(node.portname)[node.portbit]);
+			else if (node.left_parent < 0 && node.right_parent < 0)
+				lit = 0;
+			else
+				lit = mk_and(lits.at(node.left_parent), lits.at(node.right_parent));
+
+			if (node.inverter)
+				lit ^= 1;
+
+			for (auto &op : node.outports)
+				bit_lits[sigmap(cell->getPort(op.first)[op.second])] = lit;
+
+			lits.push_back(lit);
+		}
+
+		return true;
+	}
+
+	int literal(SigBit bit)
+	{
+		sigmap.apply(bit);
+
+		// undef bits are modelled as zero, as in SatGen without -undef
+		if (bit.wire == nullptr)
+			return bit == State::S1 ? 1 : 0;
+
+		auto it = bit_lits.find(bit);
+		if (it != bit_lits.end())
+			return it->second;
+
+		// register outputs, inputs, and the outputs of cells without an AIG
+		// model are free inputs. so is a bit in a logic loop.
+		auto drv = bit2driver.find(bit);
+		if (drv != bit2driver.end() && !busy_cells.count(drv->second))
+		{
+			Cell *cell = drv->second;
+			busy_cells.insert(cell);
+			if (cell->type == ID($equiv))
+				bit_lits[bit] = literal(cell->getPort(ID::A).as_bit());
+			else if (!RTLIL::builtin_ff_cell_types().count(cell->type))
+				import_cell(cell);
+			busy_cells.erase(cell);
+
+			it = bit_lits.find(bit);
+			if (it != bit_lits.end())
+				return it->second;
+		}
+
+		return bit_lits[bit] = new_input();
+	}
+
+	int run()
+	{
+		int proven = 0, refuted = 0, unproven = 0;
+
+		for (auto cell : module->selected_cells())
+		{
+			if (cell->type != ID($equiv) || cell->getPort(ID::A) == cell->getPort(ID::B))
+				continue;
+
+			int lit_a = literal(cell->getPort(ID::A).as_bit());
+			int lit_b = literal(cell->getPort(ID::B).as_bit());
+
+			if (lit_a == lit_b) {
+				cell->setPort(ID::B, cell->getPort(ID::A));
+				proven++;
+				continue;
+			}
+
+			bool differ = false;
+			for (int i = 0; i < num_words && !differ; i++)
+				differ = sim_word(lit_a, i) != sim_word(lit_b, i);
+
+			if (differ)
+				refuted++;
+			else
+				unproven++;
+		}
+
+		log("  Built AIG with %d nodes from %d signal bits.\n", GetSize(nodes), GetSize(bit_lits));
+		if (use_sat)
+			log("  Merged %d of %d nodes with matching simulation values using SAT.\n", sat_merges, sat_calls);
+		log("  Proved %d $equiv cells. %d are unproven, %d of them differ in simulation.\n",
+				proven, refuted + unproven, refuted);
+
+		return proven;
+	}
+};
+
+struct EquivStrashPass : public Pass {
+	EquivStrashPass() : Pass("equiv_strash", "proving $equiv cells using structural hashing") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    equiv_strash [options] [selection]\n");
+		log("\n");
+		log("This command converts the combinational logic of a module to a structurally\n");
+		log("hashed and-inverter graph (AIG) and marks all $equiv cells as proven whose\n");
+		log("A and B inputs are the same AIG node. Registers, blackbox cells, and cells\n");
+		log("without an AIG model are free inputs.\n");
+		log("\n");
+		log("All AIG nodes are simulated with random input patterns. A node that agrees\n");
+		log("with an earlier node on all patterns is checked for equivalence with SAT,\n");
+		log("and is replaced by the earlier node if they are equivalent. This way the\n");
+		log("structural hashing also continues above logic that was restructured.\n");
+		log("\n");
+		log("This is a quick way to prove the bulk of the $equiv cells of circuits that\n");
+		log("are mostly structurally equal, and to leave only the rest to equiv_simple.\n");
+		log("Like 'equiv_simple' without -undef, it treats undef constants as zero.\n");
+		log("\n");
+		log("    -sim <N>\n");
+		log("        the number of random patterns to simulate, rounded up to a multiple\n");
+		log("        of 64 (default = 256). 0 disables simulation and SAT.\n");
+		log("\n");
+		log("    -nosat\n");
+		log("        do not use SAT to merge nodes that agree in simulation\n");
+		log("\n");
+		log("Only selected $equiv cells are proven, but all cells are used to build\n");
+		log("the AIG.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, Design *design) override
+	{
+		int success_counter = 0;
+		int sim_patterns = 256;
+		bool use_sat = true;
+
+		log_header(design, "Executing EQUIV_STRASH pass.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-sim" && argidx+1 < args.size()) {
+				sim_patterns = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-nosat") {
+				use_sat = false;
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		for (auto module : design->selected_modules())
+		{
+			bool found_equiv = false;
+			for (auto cell : module->selected_cells())
+				if (cell->type == ID($equiv) && cell->getPort(ID::A) != cell->getPort(ID::B))
+					found_equiv = true;
+
+			if (!found_equiv)
+				continue;
+
+			log("Running equiv_strash on module %s:\n", log_id(module));
+			EquivStrashWorker worker(module, (std::max(sim_patterns, 0) + 63) / 64, use_sat);
+			success_counter += worker.run();
+		}
+
+		log("Proved %d previously unproven $equiv cells.\n", success_counter);
+	}
+} EquivStrashPass;
+
+PRIVATE_NAMESPACE_END
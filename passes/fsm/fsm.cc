@@ -62,6 +62,9 @@ struct FsmPass : public Pass {
 		log("    -fullexpand\n");
 		log("        call expand with -full option\n");
 		log("\n");
+		log("    -sat\n");
+		log("        passed through to fsm_extract pass\n");
+		log("\n");
 		log("    -encoding type\n");
 		log("    -fm_set_fsm_file file\n");
 		log("    -encfile file\n");
@@ -85,6 +88,7 @@ struct FsmPass : public Pass {
 		bool flag_expand = false;
 		bool flag_fullexpand = false;
 		bool flag_export = false;
+		bool flag_sat = false;
 		std::string fm_set_fsm_file_opt;
 		std::string encfile_opt;
 		std::string encoding_opt;
@@ -131,13 +135,17 @@ struct FsmPass : public Pass {
 				flag_export = true;
 				continue;
 			}
+			if (arg == "-sat") {
+				flag_sat = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
 		if (!flag_nodetect)
 			Pass::call(design, "fsm_detect");
-		Pass::call(design, "fsm_extract");
+		Pass::call(design, flag_sat ? "fsm_extract -sat" : "fsm_extract");
 
 		Pass::call(design, "fsm_opt");
 		Pass::call(design, "opt_clean");
@@ -27,6 +27,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/consteval.h"
 #include "kernel/celltypes.h"
+#include "kernel/satgen.h"
 #include "fsmdata.h"
 
 USING_YOSYS_NAMESPACE
@@ -253,7 +254,203 @@ undef_bit_in_next_state:
 	}
 }
 
-static void extract_fsm(RTLIL::Wire *wire)
+// The -sat engine: enumerates the transitions of each state as cubes over the ctrl inputs, using one solver for all
+// states. Each satisfying assignment of the ctrl inputs is generalized by dropping the inputs that do not change the
+// next state or ctrl outputs, so that the number of solver calls grows with the number of transitions rather than
+// with the number of ctrl input combinations. Returns false if the ctrl inputs do not determine the next state and
+// ctrl outputs, in which case the caller falls back to the ConstEval engine.
+static bool find_transitions_sat(FsmData &fsm_data, std::map<RTLIL::Const, int> &states, RTLIL::SigSpec ctrl_in,
+		RTLIL::SigSpec ctrl_out, RTLIL::SigSpec dff_in, RTLIL::SigSpec dff_out)
+{
+	CellTypes ct;
+	ct.setup_internals();
+	ct.setup_stdcells();
+
+	ezSatPtr ez;
+	SatGen satgen(ez.get(), &assign_map);
+	satgen.model_undef = true;
+
+	// import the combinational logic between the state register, the ctrl inputs and the outputs
+
+	pool<RTLIL::SigBit> driven_bits, leaf_bits;
+	pool<RTLIL::IdString> imported_cells;
+	std::vector<RTLIL::SigBit> queue;
+	for (auto bit : assign_map(ctrl_out))
+		queue.push_back(bit);
+	for (auto bit : assign_map(dff_in))
+		queue.push_back(bit);
+	for (auto bit : assign_map(ctrl_in))
+		queue.push_back(bit);
+	pool<RTLIL::SigBit> dff_out_bits;
+	for (auto bit : assign_map(dff_out))
+		dff_out_bits.insert(bit);
+
+	while (!queue.empty())
+	{
+		RTLIL::SigBit bit = queue.back();
+		queue.pop_back();
+		if (bit.wire == nullptr || driven_bits.count(bit) || leaf_bits.count(bit))
+			continue;
+
+		std::set<sig2driver_entry_t> cellport_list;
+		if (!dff_out_bits.count(bit))
+			sig2driver.find(bit, cellport_list);
+
+		RTLIL::Cell *cell = nullptr;
+		for (auto &cellport : cellport_list) {
+			RTLIL::Cell *c = module->cells_.at(cellport.first);
+			if (ct.cell_known(c->type) && ct.cell_output(c->type, cellport.second))
+				cell = c;
+		}
+		if (cell == nullptr || imported_cells.count(cell->name)) {
+			if (cell == nullptr)
+				leaf_bits.insert(bit);
+			continue;
+		}
+		if (!satgen.importCell(cell)) {
+			leaf_bits.insert(bit);
+			continue;
+		}
+		imported_cells.insert(cell->name);
+
+		for (auto &conn : cell->connections()) {
+			if (ct.cell_output(cell->type, conn.first)) {
+				for (auto out_bit : assign_map(conn.second))
+					driven_bits.insert(out_bit);
+			} else {
+				for (auto in_bit : assign_map(conn.second))
+					queue.push_back(in_bit);
+			}
+		}
+	}
+
+	// the inputs of the logic, including the state register, are never undef
+	for (auto bit : leaf_bits)
+		if (!driven_bits.count(bit))
+			ez->assume(ez->NOT(satgen.importUndefSigBit(bit)));
+
+	std::vector<int> state_vec = satgen.importSigSpec(dff_out);
+	std::vector<int> ctrl_in_vec = satgen.importSigSpec(ctrl_in);
+	RTLIL::SigSpec out_sig = dff_in;
+	out_sig.append(ctrl_out);
+	std::vector<int> out_vec = satgen.importSigSpec(out_sig);
+	std::vector<int> out_undef_vec = satgen.importUndefSigSpec(out_sig);
+
+	dict<RTLIL::SigBit, int> ctrl_in_bit_indices;
+	for (int i = 0; i < GetSize(ctrl_in); i++)
+		ctrl_in_bit_indices[ctrl_in[i]] = i;
+
+	for (auto &it : ctrl_in_bit_indices)
+		if (exclusive_ctrls.count(it.first) != 0)
+			for (auto &dc_bit : exclusive_ctrls.at(it.first)) {
+				int j = ctrl_in_bit_indices.at(dc_bit, -1);
+				if (j > it.second)
+					ez->assume(ez->NOT(ez->AND(ctrl_in_vec[it.second], ctrl_in_vec[j])));
+			}
+
+	// the clauses that exclude the cubes found so far are only active when this literal is assumed, so that they do not
+	// restrict the generalization of the next cube
+	int blocking_lit = ez->frozen_literal();
+
+	std::vector<int> model_expr = ctrl_in_vec;
+	model_expr.insert(model_expr.end(), out_vec.begin(), out_vec.end());
+	model_expr.insert(model_expr.end(), out_undef_vec.begin(), out_undef_vec.end());
+
+	for (int state_idx = 0; state_idx < int(fsm_data.state_table.size()); state_idx++)
+	{
+		int state_lit = ez->vec_eq(state_vec, satgen.importSigSpec(fsm_data.state_table[state_idx]));
+		std::vector<bool> model, no_model;
+
+		while (ez->solve(model_expr, model, state_lit, blocking_lit))
+		{
+			std::vector<int> cube;
+			for (int i = 0; i < GetSize(ctrl_in); i++)
+				cube.push_back(model[i] ? ctrl_in_vec[i] : ez->NOT(ctrl_in_vec[i]));
+
+			std::vector<int> out_diff;
+			for (int i = 0; i < GetSize(out_sig); i++) {
+				bool is_undef = model[GetSize(ctrl_in) + GetSize(out_sig) + i];
+				bool value = model[GetSize(ctrl_in) + i];
+				out_diff.push_back(is_undef ? ez->NOT(out_undef_vec[i]) : ez->OR(out_undef_vec[i], value ? ez->NOT(out_vec[i]) : out_vec[i]));
+			}
+			int diff_lit = ez->expression(ezSAT::OpOr, out_diff);
+
+			std::vector<int> assumptions = cube;
+			assumptions.push_back(state_lit);
+			assumptions.push_back(diff_lit);
+			if (ez->solve(std::vector<int>(), no_model, assumptions)) {
+				log("  sat engine: ctrl inputs do not determine the transitions of state %s.\n",
+						log_signal(fsm_data.state_table[state_idx]));
+				return false;
+			}
+
+			RTLIL::Const tr_ctrl_in(RTLIL::State::S0, GetSize(ctrl_in));
+			for (int i = 0; i < GetSize(ctrl_in); i++)
+				if (model[i])
+					tr_ctrl_in.bits()[i] = RTLIL::State::S1;
+			for (int i = 0; i < GetSize(ctrl_in); i++) {
+				int lit = assumptions[i];
+				assumptions[i] = ez->CONST_TRUE;
+				if (ez->solve(std::vector<int>(), no_model, assumptions))
+					assumptions[i] = lit;
+				else
+					tr_ctrl_in.bits()[i] = RTLIL::State::Sa;
+			}
+
+			std::vector<int> blocking_cube(assumptions.begin(), assumptions.begin() + GetSize(ctrl_in));
+			ez->assume(ez->OR(ez->NOT(blocking_lit), ez->NOT(state_lit), ez->NOT(ez->expression(ezSAT::OpAnd, blocking_cube))));
+
+			RTLIL::Const next_state, tr_ctrl_out;
+			bool next_state_undef = false;
+			for (int i = 0; i < GetSize(out_sig); i++) {
+				bool is_undef = model[GetSize(ctrl_in) + GetSize(out_sig) + i];
+				RTLIL::State value = is_undef ? RTLIL::State::Sx : model[GetSize(ctrl_in) + i] ? RTLIL::State::S1 : RTLIL::State::S0;
+				if (i < GetSize(dff_in)) {
+					next_state.bits().push_back(value);
+					next_state_undef |= is_undef;
+				} else
+					tr_ctrl_out.bits().push_back(value);
+			}
+
+			FsmData::transition_t tr;
+			tr.ctrl_in = tr_ctrl_in;
+			tr.ctrl_out = tr_ctrl_out;
+
+			for (int i = 0; i < GetSize(ctrl_in); i++)
+				if (tr.ctrl_in[i] == State::S1 && exclusive_ctrls.count(ctrl_in[i]) != 0)
+					for (auto &dc_bit : exclusive_ctrls.at(ctrl_in[i])) {
+						int j = ctrl_in_bit_indices.at(dc_bit, -1);
+						if (j >= 0)
+							tr.ctrl_in.bits().at(j) = RTLIL::State::Sa;
+					}
+
+			if (next_state_undef) {
+				log("  transition: %10s %s -> %10s %s  <ignored undef transition!>\n",
+						log_signal(fsm_data.state_table[state_idx]), log_signal(tr.ctrl_in),
+						log_signal(next_state), log_signal(tr.ctrl_out));
+				continue;
+			}
+
+			if (states.count(next_state) == 0) {
+				log("  transition: %10s %s -> INVALID_STATE(%s) %s  <ignored invalid transition!>\n",
+						log_signal(fsm_data.state_table[state_idx]), log_signal(tr.ctrl_in),
+						log_signal(next_state), log_signal(tr.ctrl_out));
+				continue;
+			}
+
+			tr.state_in = state_idx;
+			tr.state_out = states.at(next_state);
+			fsm_data.transition_table.push_back(tr);
+			log("  transition: %10s %s -> %10s %s\n",
+					log_signal(fsm_data.state_table[state_idx]), log_signal(tr.ctrl_in),
+					log_signal(fsm_data.state_table[tr.state_out]), log_signal(tr.ctrl_out));
+		}
+	}
+
+	return true;
+}
+
+static void extract_fsm(RTLIL::Wire *wire, bool flag_sat)
 {
 	log("Extracting FSM `%s' from module `%s'.\n", wire->name.c_str(), module->name.c_str());
 
@@ -356,14 +553,22 @@ static void extract_fsm(RTLIL::Wire *wire)
 
 	// Create transition table
 
-	ConstEval ce(module), ce_nostop(module);
-	ce.stop(ctrl_in);
-	for (int state_idx = 0; state_idx < int(fsm_data.state_table.size()); state_idx++) {
-		ce.push(), ce_nostop.push();
-		ce.set(dff_out, fsm_data.state_table[state_idx]);
-		ce_nostop.set(dff_out, fsm_data.state_table[state_idx]);
-		find_transitions(ce, ce_nostop, fsm_data, states, state_idx, ctrl_in, ctrl_out, dff_in, RTLIL::SigSpec());
-		ce.pop(), ce_nostop.pop();
+	if (flag_sat && !find_transitions_sat(fsm_data, states, ctrl_in, ctrl_out, dff_in, dff_out)) {
+		log("  falling back to enumerating the transitions with ConstEval.\n");
+		fsm_data.transition_table.clear();
+		flag_sat = false;
+	}
+
+	if (!flag_sat) {
+		ConstEval ce(module), ce_nostop(module);
+		ce.stop(ctrl_in);
+		for (int state_idx = 0; state_idx < int(fsm_data.state_table.size()); state_idx++) {
+			ce.push(), ce_nostop.push();
+			ce.set(dff_out, fsm_data.state_table[state_idx]);
+			ce_nostop.set(dff_out, fsm_data.state_table[state_idx]);
+			find_transitions(ce, ce_nostop, fsm_data, states, state_idx, ctrl_in, ctrl_out, dff_in, RTLIL::SigSpec());
+			ce.pop(), ce_nostop.pop();
+		}
 	}
 
 	// create fsm cell
@@ -419,7 +624,7 @@ struct FsmExtractPass : public Pass {
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
 		log("\n");
-		log("    fsm_extract [selection]\n");
+		log("    fsm_extract [options] [selection]\n");
 		log("\n");
 		log("This pass operates on all signals marked as FSM state signals using the\n");
 		log("'fsm_encoding' attribute. It consumes the logic that creates the state signal\n");
@@ -430,11 +635,29 @@ struct FsmExtractPass : public Pass {
 		log("original encoding. The 'fsm_opt' pass can be used in combination with the\n");
 		log("'opt_clean' pass to eliminate this signal.\n");
 		log("\n");
+		log("    -sat\n");
+		log("        Find the transitions of each state with a SAT solver, as cubes over the\n");
+		log("        control inputs, rather than by evaluating the next state logic for one\n");
+		log("        combination of control inputs at a time. This is much faster for FSMs\n");
+		log("        with many control inputs.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
+		bool flag_sat = false;
+
 		log_header(design, "Executing FSM_EXTRACT pass (extracting FSM from design).\n");
-		extra_args(args, 1, design);
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-sat") {
+				flag_sat = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
 
 		CellTypes ct(design);
 
@@ -474,7 +697,7 @@ struct FsmExtractPass : public Pass {
 				if (wire->attributes.count(ID::fsm_encoding) > 0 && wire->attributes[ID::fsm_encoding].decode_string() != "none")
 					wire_list.push_back(wire);
 			for (auto wire : wire_list)
-				extract_fsm(wire);
+				extract_fsm(wire, flag_sat);
 		}
 
 		assign_map.clear();
@@ -26,6 +26,7 @@
 
 #ifndef _WIN32
 #  include <unistd.h>
+#  include <dirent.h>
 #endif
 
 
@@ -318,6 +319,85 @@ struct IFExpander
 	}
 };
 
+// The module files in the -libdir directories, by module name. Each
+// directory is listed once, when the first module is looked up, instead of
+// probing for files on every lookup.
+struct LibdirIndex
+{
+	struct Entry {
+		std::string filename, frontend;
+		int rank;
+	};
+
+	static const vector<pair<string, string>> &extensions() {
+		static const vector<pair<string, string>> extensions_list =
+			{
+			 {".v", "verilog"},
+			 {".sv", "verilog -sv"},
+			 {".il", "rtlil"}
+			};
+		return extensions_list;
+	}
+
+	std::vector<std::string> libdirs;
+	bool indexed = false;
+	dict<std::string, Entry> files;
+
+	LibdirIndex(const std::vector<std::string> &libdirs) : libdirs(libdirs) { }
+
+	void build()
+	{
+		indexed = true;
+#ifndef _WIN32
+		for (int dir_idx = 0; dir_idx < GetSize(libdirs); dir_idx++) {
+			DIR *dir = opendir(libdirs[dir_idx].c_str());
+			if (dir == nullptr)
+				continue;
+			while (struct dirent *entry = readdir(dir)) {
+				std::string name = entry->d_name;
+				for (int ext_idx = 0; ext_idx < GetSize(extensions()); ext_idx++) {
+					auto &ext = extensions()[ext_idx];
+					if (name.size() <= ext.first.size() || name.compare(name.size() - ext.first.size(), ext.first.size(), ext.first))
+						continue;
+					// earlier directories first, then in the order of the extensions
+					int rank = dir_idx * GetSize(extensions()) + ext_idx;
+					std::string module_name = name.substr(0, name.size() - ext.first.size());
+					auto it = files.find(module_name);
+					if (it == files.end() || it->second.rank > rank)
+						files[module_name] = {libdirs[dir_idx] + "/" + name, ext.second, rank};
+				}
+			}
+			closedir(dir);
+		}
+#endif
+	}
+
+	// returns the file and frontend for a module or nullptr
+	const Entry *lookup(const std::string &module_name)
+	{
+		if (libdirs.empty())
+			return nullptr;
+#ifdef _WIN32
+		for (auto &dir : libdirs)
+			for (auto &ext : extensions()) {
+				std::string filename = dir + "/" + module_name + ext.first;
+				if (check_file_exists(filename)) {
+					files[module_name] = {filename, ext.second, 0};
+					return &files.at(module_name);
+				}
+			}
+		return nullptr;
+#else
+		if (!indexed)
+			build();
+		auto it = files.find(module_name);
+		if (it == files.end())
+			return nullptr;
+		return &it->second;
+#endif
+	}
+};
+
 // Get a module needed by a cell, either by deriving an abstract module or by
 // loading one from a directory in libdirs.
 //
@@ -329,10 +409,18 @@ RTLIL::Module *get_module(RTLIL::Design                  &design,
                           RTLIL::Cell                    &cell,
                           RTLIL::Module                  &parent,
                           bool                            check,
-                          const std::vector<std::string> &libdirs)
+                          LibdirIndex                    &libdirs)
 {
 	std::string cell_type = cell.type.str();
 	RTLIL::Module *abs_mod = design.module("$abstract" + cell_type);
+	if (abs_mod && abs_mod->get_blackbox_attribute()) {
+		// a library stub from `read_verilog -lib -defer': the cells keep
+		// their type and parameters, only the blackbox is materialized
+		IdString mod_name = abs_mod->derive(&design, {});
+		RTLIL::Module *mod = design.module(mod_name);
+		log_assert(mod && mod_name == cell.type);
+		return mod;
+	}
 	if (abs_mod) {
 		cell.type = abs_mod->derive(&design, cell.parameters);
 		cell.parameters.clear();
@@ -346,26 +434,13 @@ RTLIL::Module *get_module(RTLIL::Design                  &design,
 	if (cell_type[0] == '$')
 		return nullptr;
 
-	for (auto &dir : libdirs) {
-		static const vector<pair<string, string>> extensions_list =
-			{
-			 {".v", "verilog"},
-			 {".sv", "verilog -sv"},
-			 {".il", "rtlil"}
-			};
-
-		for (auto &ext : extensions_list) {
-			std::string filename = dir + "/" + RTLIL::unescape_id(cell.type) + ext.first;
-			if (!check_file_exists(filename))
-				continue;
-
-			Frontend::frontend_call(&design, NULL, filename, ext.second);
-			RTLIL::Module *mod = design.module(cell.type);
-			if (!mod)
-				log_error("File `%s' from libdir does not declare module `%s'.\n",
-				          filename.c_str(), cell_type.c_str());
-			return mod;
-		}
+	if (auto entry = libdirs.lookup(RTLIL::unescape_id(cell.type))) {
+		Frontend::frontend_call(&design, NULL, entry->filename, entry->frontend);
+		RTLIL::Module *mod = design.module(cell.type);
+		if (!mod)
+			log_error("File `%s' from libdir does not declare module `%s'.\n",
+			          entry->filename.c_str(), cell_type.c_str());
+		return mod;
 	}
 
 	// We couldn't find the module anywhere. Complain if check is set.
@@ -439,8 +514,12 @@ void check_cell_connections(const RTLIL::Module &module, RTLIL::Cell &cell, RTLI
 	}
 }
 
+// The modules derived so far, by the name of the module they were derived from and their parameters (including the
+// parameter flags, which are not compared by Const::operator==). Cells with the same parameters share one derive() call.
+typedef dict<std::pair<RTLIL::IdString, dict<RTLIL::IdString, std::pair<RTLIL::Const, int>>>, RTLIL::IdString> derived_modules_t;
+
 bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check, bool flag_simcheck, bool flag_smtcheck,
-		   std::vector<std::string> &libdirs)
+		   LibdirIndex &libdirs, derived_modules_t &derived_modules)
 {
 	bool did_something = false;
 	std::map<RTLIL::Cell*, std::pair<int, int>> array_cells;
@@ -527,10 +606,27 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 			continue;
 		}
 
-		cell->type = mod->derive(design,
-					 cell->parameters,
-					 if_expander.interfaces_to_add_to_submodule,
-					 if_expander.modports_used_in_submodule);
+		{
+			std::pair<RTLIL::IdString, dict<RTLIL::IdString, std::pair<RTLIL::Const, int>>> key;
+			bool use_derived = if_expander.interfaces_to_add_to_submodule.empty() &&
+					if_expander.modports_used_in_submodule.empty() && !mod->get_bool_attribute(ID::is_interface);
+			if (use_derived) {
+				key.first = mod->name;
+				for (auto &param : cell->parameters)
+					key.second[param.first] = std::make_pair(param.second, int(param.second.flags));
+			}
+			auto it = use_derived ? derived_modules.find(key) : derived_modules.end();
+			if (it != derived_modules.end() && design->module(it->second) != nullptr) {
+				cell->type = it->second;
+			} else {
+				cell->type = mod->derive(design,
+							 cell->parameters,
+							 if_expander.interfaces_to_add_to_submodule,
+							 if_expander.modports_used_in_submodule);
+				if (use_derived)
+					derived_modules[key] = cell->type;
+			}
+		}
 		cell->parameters.clear();
 		did_something = true;
 
@@ -741,6 +837,11 @@ struct HierarchyPass : public Pass {
 		log("needed. It also resolves assignments to wired logic data types (wand/wor),\n");
 		log("resolves positional module parameters, unrolls array instances, and more.\n");
 		log("\n");
+		log("When the scratchpad variable 'ast.derive_cache' is set to a directory, the\n");
+		log("modules derived from Verilog sources are stored in that directory and are\n");
+		log("loaded from there the next time the same module is derived with the same\n");
+		log("parameters, also by later runs of Yosys.\n");
+		log("\n");
 		log("    -check\n");
 		log("        also check the design hierarchy. this generates an error when\n");
 		log("        an unknown module is used as cell type.\n");
@@ -759,7 +860,8 @@ struct HierarchyPass : public Pass {
 		log("    -libdir <directory>\n");
 		log("        search for files named <module_name>.v in the specified directory\n");
 		log("        for unknown modules and automatically run read_verilog for each\n");
-		log("        unknown module.\n");
+		log("        unknown module. the directory is listed once per run of this command,\n");
+		log("        files added to it while the command runs are not found.\n");
 		log("\n");
 		log("    -keep_positionals\n");
 		log("        per default this pass also converts positional arguments in cells\n");
@@ -1012,7 +1114,7 @@ struct HierarchyPass : public Pass {
 		{
 			std::vector<IdString> abstract_ids;
 			for (auto module : design->modules())
-				if (module->name.begins_with("$abstract"))
+				if (module->name.begins_with("$abstract") && !module->get_blackbox_attribute())
 					abstract_ids.push_back(module->name);
 			for (auto abstract_id : abstract_ids)
 				design->module(abstract_id)->derive(design, {});
@@ -1068,6 +1170,8 @@ struct HierarchyPass : public Pass {
 					mod->attributes.erase(ID::initial_top);
 		}
 
+		LibdirIndex libdir_index(libdirs);
+		derived_modules_t derived_modules;
 		bool did_something = true;
 		while (did_something)
 		{
@@ -1083,7 +1187,7 @@ struct HierarchyPass : public Pass {
 			}
 
 			for (auto module : used_modules) {
-				if (expand_module(design, module, flag_check, flag_simcheck, flag_smtcheck, libdirs))
+				if (expand_module(design, module, flag_check, flag_simcheck, flag_smtcheck, libdir_index, derived_modules))
 					did_something = true;
 			}
 
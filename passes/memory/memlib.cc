@@ -1094,8 +1094,6 @@ Library MemLibrary::parse_library(const std::vector<std::string> &filenames, con
 	for (auto &file: filenames) {
 		Parser(file, res, defines, defines_unused);
 	}
-	for (auto def: defines_unused) {
-		log_warning("define %s not used in the library.\n", def.c_str());
-	}
+	res.defines_unused = defines_unused;
 	return res;
 }
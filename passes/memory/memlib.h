@@ -160,6 +160,8 @@ struct Ram {
 
 struct Library {
 	std::vector<Ram> rams;
+	// The defines passed to the parser that the library never checked.
+	pool<std::string> defines_unused;
 };
 
 Library parse_library(const std::vector<std::string> &filenames, const pool<std::string> &defines);
@@ -129,14 +129,38 @@ struct MemConfig {
 
 typedef std::vector<MemConfig> MemConfigs;
 
+// The SAT queries that the configuration search makes, and that decide its result together with the memory signature.
+enum QueryKind {
+	QueryWrImpliesRd,
+	QueryWrExcludesRd,
+	QueryWrExcludesSrst,
+};
+
+// The result of a configuration search, which can be reused for another memory with the same signature if the
+// SAT queries made by the search have the same results for it.
+struct MemMappingMemo {
+	// The queries in the order they were made, as (kind, write port, read port, result).
+	std::vector<std::tuple<QueryKind, int, int, bool>> queries;
+	MemConfigs cfgs;
+	// The shared clock signals of each config, as indices into the signal bits of the signature, or -1 for unused
+	// and constant clocks, which are kept in the configs.
+	std::vector<std::vector<int>> clocks;
+};
+
 struct MapWorker {
 	Module *module;
 	ModWalker modwalker;
 	SigMap sigmap;
 	SigMap sigmap_xmux;
 	FfInitVals initvals;
+	// Set when the module was changed after modwalker was set up.
+	bool modwalker_stale;
 
-	MapWorker(Module *module) : module(module), modwalker(module->design, module), sigmap(module), sigmap_xmux(module), initvals(&sigmap, module) {
+	MapWorker(Module *module) : module(module), modwalker(module->design, module), sigmap(module), sigmap_xmux(module), initvals(&sigmap, module), modwalker_stale(false) {
+		setup_xmux();
+	}
+
+	void setup_xmux() {
 		for (auto cell : module->cells())
 		{
 			if (cell->type == ID($mux))
@@ -151,6 +175,23 @@ struct MapWorker {
 			}
 		}
 	}
+
+	// Rebuilds the indices after the module was modified.  The modwalker is only needed for SAT queries, and
+	// is by far the most expensive to build, so it is only rebuilt by update_modwalker() when a query is made.
+	void rebuild() {
+		sigmap.set(module);
+		sigmap_xmux.set(module);
+		setup_xmux();
+		initvals.set(&sigmap, module);
+		modwalker_stale = true;
+	}
+
+	void update_modwalker() {
+		if (modwalker_stale) {
+			modwalker.setup(module);
+			modwalker_stale = false;
+		}
+	}
 };
 
 struct SwizzleBit {
@@ -179,6 +220,9 @@ struct MemMapping {
 	double logic_cost;
 	RamKind kind;
 	std::string style;
+	bool init_has_nonx;
+	bool init_has_one;
+	std::vector<std::tuple<QueryKind, int, int, bool>> query_log;
 	dict<int, int> wr_en_cache;
 	dict<std::pair<int, int>, bool> wr_implies_rd_cache;
 	dict<std::pair<int, int>, bool> wr_excludes_rd_cache;
@@ -192,6 +236,20 @@ struct MemMapping {
 			logic_cost = mem.width * mem.size * opts.logic_cost_rom;
 		else
 			logic_cost = mem.width * mem.size * opts.logic_cost_ram;
+		init_has_nonx = false;
+		init_has_one = false;
+		for (auto &init: mem.inits) {
+			if (init.data.is_fully_undef())
+				continue;
+			init_has_nonx = true;
+			for (auto bit: init.data)
+				if (bit == State::S1)
+					init_has_one = true;
+		}
+	}
+
+	// Fills cfgs with all valid mappings of the memory to the library rams.
+	void find_configs() {
 		if (kind == RamKind::Logic)
 			return;
 		for (int i = 0; i < GetSize(lib.rams); i++) {
@@ -247,6 +305,7 @@ struct MemMapping {
 		auto it = wr_en_cache.find(wpidx);
 		if (it != wr_en_cache.end())
 			return it->second;
+		worker.update_modwalker();
 		int res = qcsat.ez->expression(qcsat.ez->OpOr, qcsat.importSig(mem.wr_ports[wpidx].en));
 		wr_en_cache.insert({wpidx, res});
 		return res;
@@ -262,6 +321,7 @@ struct MemMapping {
 		qcsat.prepare();
 		bool res = !qcsat.ez->solve(wr_en, qcsat.ez->NOT(rd_en));
 		wr_implies_rd_cache.insert({key, res});
+		query_log.push_back(std::make_tuple(QueryWrImpliesRd, wpidx, rpidx, res));
 		return res;
 	}
 
@@ -275,6 +335,7 @@ struct MemMapping {
 		qcsat.prepare();
 		bool res = !qcsat.ez->solve(wr_en, rd_en);
 		wr_excludes_rd_cache.insert({key, res});
+		query_log.push_back(std::make_tuple(QueryWrExcludesRd, wpidx, rpidx, res));
 		return res;
 	}
 
@@ -292,9 +353,25 @@ struct MemMapping {
 		qcsat.prepare();
 		bool res = !qcsat.ez->solve(wr_en, srst);
 		wr_excludes_srst_cache.insert({key, res});
+		query_log.push_back(std::make_tuple(QueryWrExcludesSrst, wpidx, rpidx, res));
 		return res;
 	}
 
+	bool query(QueryKind kind, int wpidx, int rpidx) {
+		switch (kind) {
+			case QueryWrImpliesRd:
+				return get_wr_implies_rd(wpidx, rpidx);
+			case QueryWrExcludesRd:
+				return get_wr_excludes_rd(wpidx, rpidx);
+			case QueryWrExcludesSrst:
+				return get_wr_excludes_srst(wpidx, rpidx);
+		}
+		abort();
+	}
+
+	std::string signature(std::vector<SigBit> &sig_bits);
+	MemMappingMemo make_memo(const std::vector<SigBit> &sig_bits);
+	bool replay_memo(const MemMappingMemo &memo, const std::vector<SigBit> &sig_bits);
 	void dump_configs(int stage);
 	void dump_config(MemConfig &cfg);
 	void determine_style();
@@ -481,7 +558,107 @@ void MemMapping::dump_config(MemConfig &cfg) {
 	}
 }
 
-std::pair<bool, Const> search_for_attribute(Mem mem, IdString attr) {
+// Returns a key that covers everything the configuration search looks at, other than the results of its SAT
+// queries.  Signals are represented by the order of their first appearance (separately for the raw signals, which
+// are compared as they are, and the address signals, which are compared under sigmap_xmux), and the raw signal bits
+// are returned in sig_bits.
+std::string MemMapping::signature(std::vector<SigBit> &sig_bits) {
+	dict<SigBit, int> raw_index, addr_index;
+	std::string key;
+	auto add_raw = [&](SigSpec sig) {
+		key += stringf(" %d:", GetSize(sig));
+		for (auto bit: sig) {
+			if (bit.wire == nullptr) {
+				key += stringf("c%d", bit.data);
+				continue;
+			}
+			if (!raw_index.count(bit)) {
+				raw_index[bit] = GetSize(sig_bits);
+				sig_bits.push_back(bit);
+			}
+			key += stringf("w%d", raw_index.at(bit));
+		}
+	};
+	auto add_addr = [&](SigSpec sig) {
+		key += stringf(" %d:", GetSize(sig));
+		for (auto bit: worker.sigmap_xmux(sig)) {
+			if (bit.wire == nullptr) {
+				key += stringf("c%d", bit.data);
+				continue;
+			}
+			if (!addr_index.count(bit)) {
+				int idx = GetSize(addr_index);
+				addr_index[bit] = idx;
+			}
+			key += stringf("w%d", addr_index.at(bit));
+		}
+	};
+	auto add_mask = [&](const std::vector<bool> &mask) {
+		key += " ";
+		for (bool b: mask)
+			key += b ? '1' : '0';
+	};
+
+	key += stringf("%d %d:%s %d %d %d %d %d %d", (int)kind, GetSize(style), style.c_str(), logic_ok,
+			mem.width, mem.size, mem.start_offset, init_has_nonx, init_has_one);
+	for (auto &port: mem.wr_ports) {
+		key += stringf("\nW %d %d %d", port.clk_enable, port.clk_polarity, port.wide_log2);
+		add_raw(port.clk);
+		add_raw(port.en);
+		add_addr(port.addr);
+		add_mask(port.priority_mask);
+	}
+	for (auto &port: mem.rd_ports) {
+		key += stringf("\nR %d %d %d %d %d", port.clk_enable, port.clk_polarity, port.ce_over_srst, port.wide_log2, GetSize(port.data));
+		add_raw(port.clk);
+		add_raw(port.en);
+		add_raw(port.arst);
+		add_raw(port.srst);
+		add_addr(port.addr);
+		add_mask(port.transparency_mask);
+		add_mask(port.collision_x_mask);
+		key += " " + port.arst_value.as_string() + " " + port.srst_value.as_string() + " " + port.init_value.as_string();
+	}
+	return key;
+}
+
+MemMappingMemo MemMapping::make_memo(const std::vector<SigBit> &sig_bits) {
+	dict<SigBit, int> index;
+	for (int i = 0; i < GetSize(sig_bits); i++)
+		index[sig_bits[i]] = i;
+	MemMappingMemo memo;
+	memo.queries = query_log;
+	memo.cfgs = cfgs;
+	for (auto &cfg: memo.cfgs) {
+		std::vector<int> clocks;
+		for (auto &ccfg: cfg.shared_clocks) {
+			if (ccfg.used && ccfg.clk.wire != nullptr) {
+				clocks.push_back(index.at(ccfg.clk));
+				ccfg.clk = SigBit();
+			} else {
+				clocks.push_back(-1);
+			}
+		}
+		memo.clocks.push_back(clocks);
+	}
+	return memo;
+}
+
+// Takes over the configurations of a previous search for a memory with the same signature, if the SAT queries of
+// that search give the same results for this memory.
+bool MemMapping::replay_memo(const MemMappingMemo &memo, const std::vector<SigBit> &sig_bits) {
+	for (auto &it: memo.queries)
+		if (query(std::get<0>(it), std::get<1>(it), std::get<2>(it)) != std::get<3>(it))
+			return false;
+	cfgs = memo.cfgs;
+	for (int i = 0; i < GetSize(cfgs); i++)
+		for (int j = 0; j < GetSize(cfgs[i].shared_clocks); j++)
+			if (memo.clocks[i][j] >= 0)
+				cfgs[i].shared_clocks[j].clk = sig_bits[memo.clocks[i][j]];
+	return true;
+}
+
+std::pair<bool, Const> search_for_attribute(const Mem &mem, IdString attr) {
 	// priority of attributes:
 	// 1. attributes on memory itself
 	// 2. attributes on a read or write port
@@ -637,25 +814,13 @@ bool MemMapping::check_ram_style(const Ram &ram) {
 
 // Handle memory initializer restrictions, if any.
 bool MemMapping::check_init(const Ram &ram) {
-	bool has_nonx = false;
-	bool has_one = false;
-
-	for (auto &init: mem.inits) {
-		if (init.data.is_fully_undef())
-			continue;
-		has_nonx = true;
-		for (auto bit: init.data)
-			if (bit == State::S1)
-				has_one = true;
-	}
-
 	switch (ram.init) {
 		case MemoryInitKind::None:
-			if(has_nonx) log_reject(ram, "does not support initialization");
-			return !has_nonx;
+			if(init_has_nonx) log_reject(ram, "does not support initialization");
+			return !init_has_nonx;
 		case MemoryInitKind::Zero:
-			if(has_one) log_reject(ram, "does not support non-zero initialization");
-			return !has_one;
+			if(init_has_one) log_reject(ram, "does not support non-zero initialization");
+			return !init_has_one;
 		default:
 			return true;
 	}
@@ -2148,6 +2313,9 @@ void MemMapping::emit(const MemConfig &cfg) {
 	mem.remove();
 }
 
+// Keyed by the defines, and the names and contents of the library files (see file_content_key()).
+dict<std::string, std::unique_ptr<Library>> memlib_libraries;
+
 struct MemoryLibMapPass : public Pass {
 	MemoryLibMapPass() : Pass("memory_libmap", "map memories to cells") { }
 	void help() override
@@ -2226,17 +2394,63 @@ struct MemoryLibMapPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
-		Library lib = parse_library(lib_files, defines);
+		std::string lib_key;
+		for (auto &def : defines)
+			lib_key += stringf("-D %s\n", def.c_str());
+		for (auto &fn : lib_files) {
+			std::string filename = fn;
+			rewrite_filename(filename);
+			std::string file_key = file_content_key(filename);
+			if (file_key.empty()) {
+				lib_key.clear();
+				break;
+			}
+			lib_key += file_key + "\n";
+		}
+
+		Library uncached_lib;
+		const Library *lib = &uncached_lib;
+		if (lib_key.empty()) {
+			uncached_lib = parse_library(lib_files, defines);
+		} else {
+			auto it = memlib_libraries.find(lib_key);
+			if (it == memlib_libraries.end())
+				it = memlib_libraries.insert({lib_key, std::unique_ptr<Library>(new Library(parse_library(lib_files, defines)))}).first;
+			else
+				log("Using cached library files.\n");
+			lib = it->second.get();
+		}
+		for (auto &def : lib->defines_unused)
+			log_warning("define %s not used in the library.\n", def.c_str());
 
 		for (auto module : design->selected_modules()) {
 			if (module->has_processes_warn())
 				continue;
 
 			MapWorker worker(module);
+			// Configuration searches by memory signature.  Not used with debug output, which lists the
+			// candidates of every memory.
+			dict<std::string, std::vector<MemMappingMemo>> memos;
 			auto mems = Mem::get_selected_memories(module);
 			for (auto &mem : mems)
 			{
-				MemMapping map(worker, mem, lib, opts);
+				MemMapping map(worker, mem, *lib, opts);
+				if (ys_debug(1)) {
+					map.find_configs();
+				} else {
+					std::vector<SigBit> sig_bits;
+					auto &entries = memos[map.signature(sig_bits)];
+					bool replayed = false;
+					for (auto &memo : entries)
+						if (map.replay_memo(memo, sig_bits)) {
+							replayed = true;
+							break;
+						}
+					if (!replayed) {
+						map.find_configs();
+						entries.push_back(map.make_memo(sig_bits));
+					}
+				}
 				int idx = -1;
 				int best = map.logic_cost;
 				if (!map.logic_ok) {
@@ -2259,11 +2473,15 @@ struct MemoryLibMapPass : public Pass {
 				} else {
 					map.emit(map.cfgs[idx]);
 					// Rebuild indices after modifying module
-					worker = MapWorker(module);
+					worker.rebuild();
 				}
 			}
 		}
 	}
+	void on_shutdown() override
+	{
+		memlib_libraries.clear();
+	}
 } MemoryLibMapPass;
 
 PRIVATE_NAMESPACE_END
@@ -33,6 +33,7 @@ struct MemoryMapWorker
 	bool rom_only = false;
 	bool keepdc = false;
 	bool formal = false;
+	bool sparse = false;
 	dict<RTLIL::IdString, std::vector<RTLIL::Const>> attributes;
 
 	RTLIL::Design *design;
@@ -82,11 +83,21 @@ struct MemoryMapWorker
 		return sstr.str();
 	}
 
-	RTLIL::Wire *addr_decode(RTLIL::SigSpec addr_sig, RTLIL::SigSpec addr_val)
+	// With cache_top unset, only the decoders for the two halves of the address are cached.  They are
+	// shared by many addresses, while the decoder for the full address is only used by one word.
+	RTLIL::Wire *addr_decode(RTLIL::SigSpec addr_sig, RTLIL::SigSpec addr_val, bool cache_top = true)
 	{
 		std::pair<RTLIL::SigSpec, RTLIL::SigSpec> key(addr_sig, addr_val);
 		log_assert(GetSize(addr_sig) == GetSize(addr_val));
 
+		if (!cache_top && GetSize(addr_sig) >= 2) {
+			int split_at = GetSize(addr_sig) / 2;
+			RTLIL::SigBit left_eq = addr_decode(addr_sig.extract(0, split_at), addr_val.extract(0, split_at));
+			RTLIL::SigBit right_eq = addr_decode(addr_sig.extract(split_at, GetSize(addr_sig) - split_at), addr_val.extract(split_at, GetSize(addr_val) - split_at));
+			RTLIL::SigBit bit = module->And(NEW_ID, left_eq, right_eq);
+			return bit.wire;
+		}
+
 		if (decoder_cache.count(key) == 0) {
 			if (GetSize(addr_sig) < 2) {
 				decoder_cache[key] = module->Eq(NEW_ID, addr_sig, addr_val);
@@ -103,6 +114,242 @@ struct MemoryMapWorker
 		return bit.wire;
 	}
 
+	// Creates the FF holding the word at addr and returns its D and Q wires.  For a ROM word, the FF keeps
+	// its value.
+	std::pair<RTLIL::Wire*, RTLIL::Wire*> create_word_ff(Mem &mem, int addr, const RTLIL::SigSpec &w_init, bool rom, bool async_wr, const RTLIL::SigSpec &refclock, bool refclock_pol)
+	{
+		RTLIL::Cell *c;
+		auto ff_id = genid(mem.memid, "", addr);
+
+		if (rom) {
+			// non-static part is a ROM, we only reach this with keepdc
+			if (formal) {
+				c = module->addCell(ff_id, ID($ff));
+			} else {
+				c = module->addCell(ff_id, ID($dff));
+				c->parameters[ID::CLK_POLARITY] = RTLIL::Const(RTLIL::State::S1);
+				c->setPort(ID::CLK, RTLIL::SigSpec(RTLIL::State::S0));
+			}
+		} else if (async_wr) {
+			log_assert(formal); // General async write not implemented yet, checked against above
+			c = module->addCell(ff_id, ID($ff));
+		} else {
+			c = module->addCell(ff_id, ID($dff));
+			c->parameters[ID::CLK_POLARITY] = RTLIL::Const(refclock_pol);
+			c->setPort(ID::CLK, refclock);
+		}
+		c->parameters[ID::WIDTH] = mem.width;
+
+		RTLIL::Wire *w_in = module->addWire(genid(mem.memid, "", addr, "$d"), mem.width);
+		c->setPort(ID::D, w_in);
+
+		std::string w_out_name = stringf("%s[%d]", mem.memid.c_str(), addr);
+		if (module->wires_.count(w_out_name) > 0)
+			w_out_name = genid(mem.memid, "", addr, "$q");
+
+		RTLIL::Wire *w_out = module->addWire(w_out_name, mem.width);
+
+		if (formal && mem.packed && mem.cell->name.c_str()[0] == '\\') {
+			auto hdlname = mem.cell->get_hdlname_attribute();
+			if (hdlname.empty())
+				hdlname.push_back(mem.cell->name.c_str() + 1);
+			hdlname.push_back(stringf("[%d]", addr));
+			w_out->set_hdlname_attribute(hdlname);
+		}
+
+		if (!w_init.is_fully_undef())
+			w_out->attributes[ID::init] = w_init.as_const();
+
+		c->setPort(ID::Q, w_out);
+
+		if (rom)
+			module->connect(RTLIL::SigSig(w_in, w_out));
+		return {w_in, w_out};
+	}
+
+	// Creates the write muxes of the given write ports for the word at addr, between the FF output q and
+	// its input d.  Returns the number of write mux blocks.
+	int create_word_write(Mem &mem, int addr, const std::vector<int> &ports, RTLIL::SigSpec q, RTLIL::SigSpec d)
+	{
+		int count_wrmux = 0;
+		RTLIL::SigSpec sig = q;
+
+		for (int j : ports)
+		{
+			auto &port = mem.wr_ports[j];
+			RTLIL::SigSpec wr_addr = port.addr.extract_end(port.wide_log2);
+			RTLIL::Wire *w_seladdr = addr_decode(wr_addr, RTLIL::SigSpec(addr >> port.wide_log2, GetSize(wr_addr)), !sparse);
+
+			int sub = addr & ((1 << port.wide_log2) - 1);
+
+			int wr_offset = 0;
+			while (wr_offset < mem.width)
+			{
+				int wr_width = 1;
+				RTLIL::SigSpec wr_bit = port.en.extract(wr_offset + sub * mem.width, 1);
+
+				while (wr_offset + wr_width < mem.width) {
+					RTLIL::SigSpec next_wr_bit = port.en.extract(wr_offset + wr_width + sub * mem.width, 1);
+					if (next_wr_bit != wr_bit)
+						break;
+					wr_width++;
+				}
+
+				RTLIL::Wire *w = w_seladdr;
+
+				if (wr_bit != State::S1)
+				{
+					RTLIL::Cell *c = module->addCell(genid(mem.memid, "$wren", addr, "", j, "", wr_offset), ID($and));
+					c->parameters[ID::A_SIGNED] = RTLIL::Const(0);
+					c->parameters[ID::B_SIGNED] = RTLIL::Const(0);
+					c->parameters[ID::A_WIDTH] = RTLIL::Const(1);
+					c->parameters[ID::B_WIDTH] = RTLIL::Const(1);
+					c->parameters[ID::Y_WIDTH] = RTLIL::Const(1);
+					c->setPort(ID::A, w);
+					c->setPort(ID::B, wr_bit);
+
+					w = module->addWire(genid(mem.memid, "$wren", addr, "", j, "", wr_offset, "$y"));
+					c->setPort(ID::Y, RTLIL::SigSpec(w));
+				}
+
+				RTLIL::Cell *c = module->addCell(genid(mem.memid, "$wrmux", addr, "", j, "", wr_offset), ID($mux));
+				c->parameters[ID::WIDTH] = wr_width;
+				c->setPort(ID::A, sig.extract(wr_offset, wr_width));
+				c->setPort(ID::B, port.data.extract(wr_offset + sub * mem.width, wr_width));
+				c->setPort(ID::S, RTLIL::SigSpec(w));
+
+				w = module->addWire(genid(mem.memid, "$wrmux", addr, "", j, "", wr_offset, "$y"), wr_width);
+				c->setPort(ID::Y, w);
+
+				sig.replace(wr_offset, w);
+				wr_offset += wr_width;
+				count_wrmux++;
+			}
+		}
+
+		module->connect(RTLIL::SigSig(d, sig));
+		return count_wrmux;
+	}
+
+	// Maps the memory for the -sparse option.  The words that no write port can address are mapped like the
+	// words of a ROM, and the read multiplexer of each read port is built as a tree over the address range that
+	// leaves out the multiplexers with equal inputs, e.g. in uninitialized or constant regions.  The initial
+	// contents are kept as a MemContents, so that only the words that need a FF are created and stored.
+	void handle_memory_sparse(Mem &mem, const std::set<int> &static_ports, const std::map<int, RTLIL::SigSpec> &static_cells_map,
+			const RTLIL::SigSpec &refclock, bool refclock_pol, bool async_wr, bool static_only)
+	{
+		int abits = ceil_log2(mem.size);
+		int addr_mask = (1 << abits) - 1;
+
+		MemContents contents = mem.get_init_contents();
+
+		// The write ports that can write at all, with the constant bits of their addresses as a mask and value.
+		std::vector<std::tuple<int, int, int>> wr_ports;
+		if (!static_only) {
+			for (int j = 0; j < GetSize(mem.wr_ports); j++) {
+				if (static_ports.count(j))
+					continue;
+				auto &port = mem.wr_ports[j];
+				int mask = 0, value = 0;
+				for (int b = port.wide_log2; b < GetSize(port.addr) && b < 31; b++) {
+					if (port.addr[b] == State::S0)
+						mask |= 1 << b;
+					if (port.addr[b] == State::S1) {
+						mask |= 1 << b;
+						value |= 1 << b;
+					}
+				}
+				wr_ports.emplace_back(j, mask, value);
+			}
+		}
+
+		// The words that are not constant, by their index in the read multiplexers.
+		dict<int, RTLIL::SigSpec> data_read;
+		int count_ff = 0, count_static = 0, count_wrmux = 0;
+
+		for (int i = 0; i < mem.size; i++)
+		{
+			int addr = i + mem.start_offset;
+			int idx = addr & addr_mask;
+			if (static_cells_map.count(addr) > 0) {
+				data_read[idx] = static_cells_map.at(addr);
+				count_static++;
+				continue;
+			}
+
+			std::vector<int> ports;
+			for (auto &it : wr_ports)
+				if ((addr & std::get<1>(it)) == std::get<2>(it))
+					ports.push_back(std::get<0>(it));
+
+			RTLIL::Const w_init = contents[i];
+			if (ports.empty()) {
+				if (!keepdc || w_init.is_fully_def())
+					continue;
+				data_read[idx] = create_word_ff(mem, addr, w_init, true, async_wr, refclock, refclock_pol).second;
+			} else {
+				auto ff = create_word_ff(mem, addr, w_init, false, async_wr, refclock, refclock_pol);
+				data_read[idx] = async_wr ? ff.first : ff.second;
+				count_wrmux += create_word_write(mem, addr, ports, ff.second, ff.first);
+			}
+			count_ff++;
+		}
+
+		log("  created %d %s cells and %d static cells of width %d.\n",
+				count_ff, formal && (static_only || async_wr) ? "$ff" : "$dff", count_static, mem.width);
+
+		int count_dff = 0, count_mux = 0;
+
+		for (int i = 0; i < GetSize(mem.rd_ports); i++)
+		{
+			auto &port = mem.rd_ports[i];
+			if (mem.extract_rdff(i, &initvals))
+				count_dff++;
+			RTLIL::SigSpec rd_addr = port.addr;
+			rd_addr.extend_u0(abits, false);
+			int levels = abits - port.wide_log2;
+
+			// Returns the read data for the 2**bits (wide) words at index base.
+			std::function<RTLIL::SigSpec(int, int)> read_tree = [&](int bits, int base) {
+				RTLIL::SigSpec sig;
+				if (bits == 0) {
+					for (int sub = 0; sub < (1 << port.wide_log2); sub++) {
+						int idx = (base << port.wide_log2) + sub;
+						int k = (idx - mem.start_offset) & addr_mask;
+						if (data_read.count(idx))
+							sig.append(data_read.at(idx));
+						else if (k < mem.size)
+							sig.append(contents[k]);
+						else
+							sig.append(RTLIL::Const(State::Sx, mem.width));
+					}
+					return sig;
+				}
+				RTLIL::SigSpec sig_a = read_tree(bits - 1, base);
+				RTLIL::SigSpec sig_b = read_tree(bits - 1, base + (1 << (bits - 1)));
+				if (sig_a == sig_b)
+					return sig_a;
+				int j = levels - bits, k = base >> bits;
+				RTLIL::Cell *c = module->addCell(genid(mem.memid, "$rdmux", i, "", j, "", k), ID($mux));
+				c->parameters[ID::WIDTH] = GetSize(port.data);
+				c->setPort(ID::A, sig_a);
+				c->setPort(ID::B, sig_b);
+				c->setPort(ID::S, rd_addr.extract(port.wide_log2 + bits - 1, 1));
+				sig = module->addWire(genid(mem.memid, "$rdmux", i, "", j, "", k, "$y"), GetSize(port.data));
+				c->setPort(ID::Y, sig);
+				count_mux++;
+				return sig;
+			};
+
+			module->connect(RTLIL::SigSig(port.data, read_tree(levels, 0)));
+		}
+
+		log("  read interface: %d $dff and %d $mux cells.\n", count_dff, count_mux);
+		log("  write interface: %d write mux blocks.\n", count_wrmux);
+
+		mem.remove();
+	}
+
 	void handle_memory(Mem &mem)
 	{
 		std::set<int> static_ports;
@@ -194,6 +441,11 @@ struct MemoryMapWorker
 
 		log("Mapping memory %s in module %s:\n", mem.memid.c_str(), module->name.c_str());
 
+		if (sparse) {
+			handle_memory_sparse(mem, static_ports, static_cells_map, refclock, refclock_pol, async_wr, static_only);
+			return;
+		}
+
 		int abits = ceil_log2(mem.size);
 		std::vector<RTLIL::SigSpec> data_reg_in(1 << abits);
 		std::vector<RTLIL::SigSpec> data_reg_out(1 << abits);
@@ -218,54 +470,9 @@ struct MemoryMapWorker
 			}
 			else
 			{
-				RTLIL::Cell *c;
-				auto ff_id = genid(mem.memid, "", addr);
-
-				if (static_only) {
-					// non-static part is a ROM, we only reach this with keepdc
-					if (formal) {
-						c = module->addCell(ff_id, ID($ff));
-					} else {
-						c = module->addCell(ff_id, ID($dff));
-						c->parameters[ID::CLK_POLARITY] = RTLIL::Const(RTLIL::State::S1);
-						c->setPort(ID::CLK, RTLIL::SigSpec(RTLIL::State::S0));
-					}
-				} else if (async_wr) {
-					log_assert(formal); // General async write not implemented yet, checked against above
-					c = module->addCell(ff_id, ID($ff));
-				} else {
-					c = module->addCell(ff_id, ID($dff));
-					c->parameters[ID::CLK_POLARITY] = RTLIL::Const(refclock_pol);
-					c->setPort(ID::CLK, refclock);
-				}
-				c->parameters[ID::WIDTH] = mem.width;
-
-				RTLIL::Wire *w_in = module->addWire(genid(mem.memid, "", addr, "$d"), mem.width);
-				data_reg_in[idx] = w_in;
-				c->setPort(ID::D, w_in);
-
-				std::string w_out_name = stringf("%s[%d]", mem.memid.c_str(), addr);
-				if (module->wires_.count(w_out_name) > 0)
-					w_out_name = genid(mem.memid, "", addr, "$q");
-
-				RTLIL::Wire *w_out = module->addWire(w_out_name, mem.width);
-
-				if (formal && mem.packed && mem.cell->name.c_str()[0] == '\\') {
-					auto hdlname = mem.cell->get_hdlname_attribute();
-					if (hdlname.empty())
-						hdlname.push_back(mem.cell->name.c_str() + 1);
-					hdlname.push_back(stringf("[%d]", addr));
-					w_out->set_hdlname_attribute(hdlname);
-				}
-
-				if (!w_init.is_fully_undef())
-					w_out->attributes[ID::init] = w_init.as_const();
-
-				data_reg_out[idx] = w_out;
-				c->setPort(ID::Q, w_out);
-
-				if (static_only)
-					module->connect(RTLIL::SigSig(w_in, w_out));
+				auto ff = create_word_ff(mem, addr, w_init, static_only, async_wr, refclock, refclock_pol);
+				data_reg_in[idx] = ff.first;
+				data_reg_out[idx] = ff.second;
 			}
 		}
 
@@ -323,62 +530,10 @@ struct MemoryMapWorker
 				if (static_cells_map.count(addr) > 0)
 					continue;
 
-				RTLIL::SigSpec sig = data_reg_out[idx];
-
+				std::vector<int> ports;
 				for (int j = 0; j < GetSize(mem.wr_ports); j++)
-				{
-					auto &port = mem.wr_ports[j];
-					RTLIL::SigSpec wr_addr = port.addr.extract_end(port.wide_log2);
-					RTLIL::Wire *w_seladdr = addr_decode(wr_addr, RTLIL::SigSpec(addr >> port.wide_log2, GetSize(wr_addr)));
-
-					int sub = addr & ((1 << port.wide_log2) - 1);
-
-					int wr_offset = 0;
-					while (wr_offset < mem.width)
-					{
-						int wr_width = 1;
-						RTLIL::SigSpec wr_bit = port.en.extract(wr_offset + sub * mem.width, 1);
-
-						while (wr_offset + wr_width < mem.width) {
-							RTLIL::SigSpec next_wr_bit = port.en.extract(wr_offset + wr_width + sub * mem.width, 1);
-							if (next_wr_bit != wr_bit)
-								break;
-							wr_width++;
-						}
-
-						RTLIL::Wire *w = w_seladdr;
-
-						if (wr_bit != State::S1)
-						{
-							RTLIL::Cell *c = module->addCell(genid(mem.memid, "$wren", addr, "", j, "", wr_offset), ID($and));
-							c->parameters[ID::A_SIGNED] = RTLIL::Const(0);
-							c->parameters[ID::B_SIGNED] = RTLIL::Const(0);
-							c->parameters[ID::A_WIDTH] = RTLIL::Const(1);
-							c->parameters[ID::B_WIDTH] = RTLIL::Const(1);
-							c->parameters[ID::Y_WIDTH] = RTLIL::Const(1);
-							c->setPort(ID::A, w);
-							c->setPort(ID::B, wr_bit);
-
-							w = module->addWire(genid(mem.memid, "$wren", addr, "", j, "", wr_offset, "$y"));
-							c->setPort(ID::Y, RTLIL::SigSpec(w));
-						}
-
-						RTLIL::Cell *c = module->addCell(genid(mem.memid, "$wrmux", addr, "", j, "", wr_offset), ID($mux));
-						c->parameters[ID::WIDTH] = wr_width;
-						c->setPort(ID::A, sig.extract(wr_offset, wr_width));
-						c->setPort(ID::B, port.data.extract(wr_offset + sub * mem.width, wr_width));
-						c->setPort(ID::S, RTLIL::SigSpec(w));
-
-						w = module->addWire(genid(mem.memid, "$wrmux", addr, "", j, "", wr_offset, "$y"), wr_width);
-						c->setPort(ID::Y, w);
-
-						sig.replace(wr_offset, w);
-						wr_offset += wr_width;
-						count_wrmux++;
-					}
-				}
-
-				module->connect(RTLIL::SigSig(data_reg_in[idx], sig));
+					ports.push_back(j);
+				count_wrmux += create_word_write(mem, addr, ports, data_reg_out[idx], data_reg_in[idx]);
 			}
 		}
 
@@ -429,6 +584,13 @@ struct MemoryMapPass : public Pass {
 		log("        attributes. It also has limited support for async write ports\n");
 		log("        as generated by clk2fflogic.\n");
 		log("\n");
+		log("    -sparse\n");
+		log("        only create FFs for the words that can be written to (judging by the\n");
+		log("        constant bits of the write addresses) or that need one for -keepdc, and\n");
+		log("        leave out the read multiplexers that select between equal values, e.g.\n");
+		log("        in uninitialized or constant regions. This is meant for very deep\n");
+		log("        memories, e.g. large ROMs mapped for formal verification.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -436,6 +598,7 @@ struct MemoryMapPass : public Pass {
 		bool rom_only = false;
 		bool keepdc = false;
 		bool formal = false;
+		bool sparse = false;
 		dict<RTLIL::IdString, std::vector<RTLIL::Const>> attributes;
 
 		log_header(design, "Executing MEMORY_MAP pass (converting memories to logic and flip-flops).\n");
@@ -488,6 +651,11 @@ struct MemoryMapPass : public Pass {
 				keepdc = true;
 				continue;
 			}
+			if (args[argidx] == "-sparse")
+			{
+				sparse = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -502,6 +670,7 @@ struct MemoryMapPass : public Pass {
 			worker.rom_only = rom_only;
 			worker.keepdc = keepdc;
 			worker.formal = formal;
+			worker.sparse = sparse;
 			worker.run();
 		}
 	}
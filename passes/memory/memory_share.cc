@@ -393,6 +393,39 @@ struct MemoryShareWorker
 
 			log("  Size of unconstrained SAT problem: %d variables, %d clauses\n", qcsat.ez->numCnfVariables(), qcsat.ez->numCnfClauses());
 
+			// simulate the cone first, ports that are active at the same time in
+			// one of the simulated assignments can't be merged, no need to ask the
+			// solver about them
+
+			std::vector<RTLIL::SigBit> en_bits;
+			for (auto idx : group) {
+				std::vector<RTLIL::SigBit> bits = modwalker.sigmap(mem.wr_ports[idx].en);
+				en_bits.insert(en_bits.end(), bits.begin(), bits.end());
+			}
+
+			const int sim_rounds = 4;
+			dict<int, std::vector<uint64_t>> port_active;
+			std::vector<std::vector<uint64_t>> en_values;
+			if (qcsat.simulate(en_bits, sim_rounds, en_values)) {
+				int k = 0;
+				for (auto idx : group) {
+					auto &active = port_active[idx];
+					active.assign(sim_rounds, 0);
+					for (int i = 0; i < GetSize(mem.wr_ports[idx].en); i++, k++)
+						for (int r = 0; r < sim_rounds; r++)
+							active[r] |= en_values[k][r];
+				}
+			}
+
+			auto simulated_together = [&](int idx1, int idx2) {
+				if (port_active.empty())
+					return false;
+				for (int r = 0; r < sim_rounds; r++)
+					if (port_active.at(idx1)[r] & port_active.at(idx2)[r])
+						return true;
+				return false;
+			};
+
 			// now try merging the ports.
 
 			for (int ii = 0; ii < GetSize(group); ii++) {
@@ -406,6 +439,11 @@ struct MemoryShareWorker
 					if (port2.removed)
 						continue;
 
+					if (simulated_together(idx1, idx2)) {
+						log("  According to simulation sharing of port %d with port %d is not possible.\n", idx1, idx2);
+						continue;
+					}
+
 					if (qcsat.ez->solve(port_to_sat_variable.at(idx1), port_to_sat_variable.at(idx2))) {
 						log("  According to SAT solver sharing of port %d with port %d is not possible.\n", idx1, idx2);
 						continue;
@@ -414,6 +452,9 @@ struct MemoryShareWorker
 					log("  Merging port %d into port %d.\n", idx2, idx1);
 					mem.prepare_wr_merge(idx1, idx2, &initvals);
 					port_to_sat_variable.at(idx1) = qcsat.ez->OR(port_to_sat_variable.at(idx1), port_to_sat_variable.at(idx2));
+					if (!port_active.empty())
+						for (int r = 0; r < sim_rounds; r++)
+							port_active.at(idx1)[r] |= port_active.at(idx2)[r];
 
 					RTLIL::SigSpec last_addr = port1.addr;
 					RTLIL::SigSpec last_data = port1.data;
@@ -25,8 +25,58 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// a sub-pass of the main loop, as scheduled with -adaptive
+struct OptStep
+{
+	std::string command;
+	int runs = 0, productive_runs = 0;
+	int64_t runtime_ns = 0;
+
+	// number of runs in a row without a change, and number of loop
+	// iterations that the sub-pass is still postponed for
+	int idle_runs = 0;
+	int postponed = 0;
+
+	OptStep(const std::string &command) : command(command) { }
+};
+
+// Lets the sub-passes skip modules that they already left unchanged and
+// that have not been modified since. The entries are only valid while the
+// scope is active, so they are dropped again when it ends, also when a
+// sub-pass fails and the error is caught further up (e.g. by the shell).
+struct SkipConvergedScope
+{
+	RTLIL::Design *design;
+
+	SkipConvergedScope(RTLIL::Design *design) : design(design)
+	{
+		clear();
+		design->scratchpad_set_bool("opt.skip_converged", true);
+	}
+
+	~SkipConvergedScope()
+	{
+		end();
+	}
+
+	void end()
+	{
+		if (design == nullptr)
+			return;
+		design->scratchpad_unset("opt.skip_converged");
+		clear();
+		design = nullptr;
+	}
+
+	void clear()
+	{
+		for (auto module : design->modules())
+			module->converged_.clear();
+	}
+};
+
 struct OptPass : public Pass {
-	OptPass() : Pass("opt", "perform simple optimizations") { }
+	OptPass() : Pass("opt", "perform simple optimizations") { keeps_indexes(); selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -50,6 +100,14 @@ struct OptPass : public Pass {
 		log("        opt_expr [-mux_undef] [-mux_bool] [-undriven] [-noclkinv] [-fine] [-full] [-keepdc]\n");
 		log("    while <changed design>\n");
 		log("\n");
+		log("When called with -adaptive (and without -fast) the sub-passes of the loop are\n");
+		log("scheduled by how effective they have been so far: A sub-pass that did not\n");
+		log("change the design is postponed for 1, 3 and then 7 iterations of the loop,\n");
+		log("unless it only takes a small fraction of the time of an iteration. The loop\n");
+		log("only ends after an iteration that ran all sub-passes without a change, so the\n");
+		log("result is still a fixpoint of all of them. A summary of the runs of each\n");
+		log("sub-pass is printed at the end.\n");
+		log("\n");
 		log("When called with -fast the following script is used instead:\n");
 		log("\n");
 		log("    do\n");
@@ -74,6 +132,7 @@ struct OptPass : public Pass {
 		bool opt_share = false;
 		bool fast_mode = false;
 		bool noff_mode = false;
+		bool adaptive_mode = false;
 
 		log_header(design, "Executing OPT pass (performing simple optimizations).\n");
 		log_push();
@@ -141,10 +200,16 @@ struct OptPass : public Pass {
 				noff_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-adaptive") {
+				adaptive_mode = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		SkipConvergedScope skip_converged(design);
+
 		if (fast_mode)
 		{
 			while (1) {
@@ -160,6 +225,69 @@ struct OptPass : public Pass {
 			}
 			Pass::call(design, "opt_clean" + opt_clean_args);
 		}
+		else if (adaptive_mode)
+		{
+			Pass::call(design, "opt_expr" + opt_expr_args);
+			Pass::call(design, "opt_merge -nomux" + opt_merge_args);
+
+			std::vector<OptStep> steps;
+			steps.emplace_back("opt_muxtree");
+			steps.emplace_back("opt_reduce" + opt_reduce_args);
+			steps.emplace_back("opt_merge" + opt_merge_args);
+			if (opt_share)
+				steps.emplace_back("opt_share");
+			if (!noff_mode)
+				steps.emplace_back("opt_dff" + opt_dff_args);
+			steps.emplace_back("opt_clean" + opt_clean_args);
+			steps.emplace_back("opt_expr" + opt_expr_args);
+
+			int64_t last_iteration_ns = 0;
+			while (1) {
+				bool did_something = false, postponed_steps = false;
+				int64_t iteration_ns = 0;
+				for (auto &step : steps) {
+					if (step.postponed > 0) {
+						step.postponed--;
+						postponed_steps = true;
+						continue;
+					}
+					design->scratchpad_unset("opt.did_something");
+					int64_t begin_ns = PerformanceTimer::query();
+					Pass::call(design, step.command);
+					int64_t step_ns = PerformanceTimer::query() - begin_ns;
+					iteration_ns += step_ns;
+					step.runs++;
+					step.runtime_ns += step_ns;
+					if (design->scratchpad_get_bool("opt.did_something")) {
+						did_something = true;
+						step.productive_runs++;
+						step.idle_runs = 0;
+						continue;
+					}
+					step.idle_runs++;
+					// postponing a sub-pass that is cheap compared to the
+					// others would only delay its next useful run
+					if (step_ns * 20 >= last_iteration_ns)
+						step.postponed = (1 << std::min(step.idle_runs, 3)) - 1;
+				}
+				last_iteration_ns = iteration_ns;
+				if (!did_something && !postponed_steps)
+					break;
+				if (!did_something) {
+					for (auto &step : steps)
+						step.postponed = 0;
+					log_header(design, "Rerunning OPT passes. (Running postponed passes..)\n");
+				} else
+					log_header(design, "Rerunning OPT passes. (Maybe there is more to do..)\n");
+			}
+
+			log("\n");
+			log("Summary of adaptively scheduled OPT passes:\n");
+			log("     runs  productive   time (s)  command\n");
+			for (auto &step : steps)
+				log("  %7d  %10d  %9.3f  %s\n", step.runs, step.productive_runs,
+						step.runtime_ns / 1e9, step.command.c_str());
+		}
 		else
 		{
 			Pass::call(design, "opt_expr" + opt_expr_args);
@@ -181,6 +309,8 @@ struct OptPass : public Pass {
 			}
 		}
 
+		skip_converged.end();
+
 		design->optimize();
 		design->sort();
 		design->check();
@@ -22,6 +22,7 @@
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
 #include "kernel/ffinit.h"
+#include "kernel/modtools.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
@@ -208,9 +209,9 @@ void rmunused_module_cells(Module *module, bool verbose)
 		module->design->scratchpad_set_bool("opt.did_something", true);
 		if (RTLIL::builtin_ff_cell_types().count(cell->type))
 			ffinit.remove_init(cell->getPort(ID::Q));
-		module->remove(cell);
 		count_rm_cells++;
 	}
+	module->remove(unused);
 
 	for (auto it : mem_unused)
 	{
@@ -348,7 +349,8 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 		}
 	}
 
-	// we are removing all connections
+	// we are removing all connections and rewriting the cell ports in place
+	module->blackout();
 	module->connections_.clear();
 
 	// used signals sigmapped
@@ -400,6 +402,7 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 	}
 
 	// set init attributes on all wires of a connected group
+	module->init_generation_++;
 	for (auto wire : module->wires()) {
 		bool found = false;
 		Const val(State::Sx, wire->width);
@@ -588,8 +591,10 @@ bool rmunused_module_init(RTLIL::Module *module, bool verbose)
 	next_wire:;
 	}
 
-	if (did_something)
+	if (did_something) {
+		module->init_generation_++;
 		module->design->scratchpad_set_bool("opt.did_something", true);
+	}
 
 	return did_something;
 }
@@ -625,8 +630,80 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 		while (rmunused_module_signals(module, purge_mode, verbose)) { }
 }
 
+// Removes the cells whose outputs have lost their last user since the previous run, using the bits recorded by
+// the cached ModIndex of the module. Returns false if the index has not been tracking the module since then, in
+// which case the full cleanup has to run. What this finds is a subset of what the full cleanup finds: cells that
+// are only used by each other, flip-flops (which would need their init attributes updated), cells of unknown
+// types, memories and unused wires are left for the next full cleanup.
+bool rmunused_module_incremental(Module *module, bool verbose)
+{
+	ModIndex &index = ModIndex::cached(module);
+	if (!index.track_released)
+		return false;
+
+	if (verbose)
+		log("Finding unused cells in module %s incrementally..\n", module->name.c_str());
+
+	auto cell_used = [&](Cell *cell) {
+		if (keep_cache.query(cell) || RTLIL::builtin_ff_cell_types().count(cell->type))
+			return true;
+		for (auto &conn : cell->connections()) {
+			if (!ct_all.cell_output(cell->type, conn.first))
+				continue;
+			for (auto bit : conn.second) {
+				ModIndex::SigBitInfo *info = index.query(bit);
+				if (info == nullptr)
+					continue;
+				if (info->is_output || info->is_keep)
+					return true;
+				for (auto &port : info->ports)
+					if (port.cell != cell && (!ct_all.cell_known(port.cell->type) || ct_all.cell_input(port.cell->type, port.port)))
+						return true;
+			}
+		}
+		return false;
+	};
+
+	while (!index.released.empty())
+	{
+		pool<SigBit> bits;
+		bits.swap(index.released);
+
+		std::vector<Cell*> drivers;
+		pool<Cell*, hashlib::hash_ptr_ops> found;
+		for (auto bit : bits)
+			for (auto &port : index.query_ports(bit))
+				if (ct_all.cell_known(port.cell->type) && ct_all.cell_output(port.cell->type, port.port))
+					if (found.insert(port.cell).second)
+						drivers.push_back(port.cell);
+
+		std::sort(drivers.begin(), drivers.end(), RTLIL::sort_by_name_id<RTLIL::Cell>());
+
+		// Removing a cell records its input bits, so its drivers are looked at in the next iteration.
+		for (auto cell : drivers) {
+			if (cell_used(cell))
+				continue;
+			if (verbose)
+				log_debug("  removing unused `%s' cell `%s'.\n", cell->type.c_str(), cell->name.c_str());
+			module->design->scratchpad_set_bool("opt.did_something", true);
+			module->remove(cell);
+			count_rm_cells++;
+		}
+	}
+
+	return true;
+}
+
+// Starts recording the changes to the module for the next run of rmunused_module_incremental().
+void start_incremental(Module *module)
+{
+	ModIndex &index = ModIndex::cached(module);
+	index.track_released = true;
+	index.released.clear();
+}
+
 struct OptCleanPass : public Pass {
-	OptCleanPass() : Pass("opt_clean", "remove unused cells and wires") { }
+	OptCleanPass() : Pass("opt_clean", "remove unused cells and wires") { keeps_indexes(); selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -643,10 +720,20 @@ struct OptCleanPass : public Pass {
 		log("    -purge\n");
 		log("        also remove internal nets if they have a public name\n");
 		log("\n");
+		log("    -incremental\n");
+		log("        only look at the cells whose outputs lost a user since the previous\n");
+		log("        'opt_clean -incremental'. Changes are recorded by the module index that\n");
+		log("        passes like opt_expr and opt_merge keep between passes. If the index\n");
+		log("        was not kept since then, e.g. because another pass ran in between,\n");
+		log("        the full cleanup runs instead. Unused wires, flip-flops, memories,\n");
+		log("        cells of unknown types and cells that only drive each other are\n");
+		log("        only removed by the full cleanup.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		bool purge_mode = false;
+		bool incremental = false;
 
 		log_header(design, "Executing OPT_CLEAN pass (remove unused cells and wires).\n");
 		log_push();
@@ -657,6 +744,10 @@ struct OptCleanPass : public Pass {
 				purge_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-incremental") {
+				incremental = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -672,17 +763,40 @@ struct OptCleanPass : public Pass {
 		count_rm_cells = 0;
 		count_rm_wires = 0;
 
+		std::string key = converged_key(args);
+		bool did_something = design->scratchpad_get_bool("opt.did_something");
+		bool did_full_cleanup = false;
 		for (auto module : design->selected_whole_modules_warn()) {
-			if (module->has_processes_warn())
+			if (module->has_processes_warn() || module->converged(key))
 				continue;
-			rmunused_module(module, purge_mode, true, true);
+			ModuleScope scope(module);
+			uint64_t generation = module->generation_;
+			design->scratchpad_unset("opt.did_something");
+			if (!incremental || !rmunused_module_incremental(module, true)) {
+				rmunused_module(module, purge_mode, true, true);
+				did_full_cleanup = true;
+				if (incremental)
+					start_incremental(module);
+			}
+			if (design->scratchpad_get_bool("opt.did_something")) {
+				module->mark_changed();
+				did_something = true;
+			} else {
+				// rmunused_module() always rebuilds the module connections,
+				// that alone does not count as a change
+				module->generation_ = generation;
+				module->mark_converged(key);
+			}
 		}
+		if (did_something)
+			design->scratchpad_set_bool("opt.did_something", true);
 
 		if (count_rm_cells > 0 || count_rm_wires > 0)
 			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells, count_rm_wires);
 
 		design->optimize();
-		design->sort();
+		if (did_full_cleanup)
+			design->sort();
 		design->check();
 
 		keep_cache.reset();
@@ -693,7 +807,7 @@ struct OptCleanPass : public Pass {
 } OptCleanPass;
 
 struct CleanPass : public Pass {
-	CleanPass() : Pass("clean", "remove unused cells and wires") { }
+	CleanPass() : Pass("clean", "remove unused cells and wires") { keeps_indexes(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -48,8 +48,9 @@ struct OptDffWorker
 
 	Module *module;
 	typedef std::pair<RTLIL::Cell*, int> cell_int_t;
-	SigMap sigmap;
-	FfInitVals initvals;
+	FfCache &ffcache;
+	SigMap &sigmap;
+	FfInitVals &initvals;
 	dict<SigBit, int> bitusers;
 	dict<SigBit, cell_int_t> bit2mux;
 
@@ -61,7 +62,7 @@ struct OptDffWorker
 	// Used as a queue.
 	std::vector<Cell *> dff_cells;
 
-	OptDffWorker(const OptDffOptions &opt, Module *mod) : opt(opt), module(mod), sigmap(mod), initvals(&sigmap, mod) {
+	OptDffWorker(const OptDffOptions &opt, Module *mod) : opt(opt), module(mod), ffcache(FfCache::cached(mod)), sigmap(ffcache.sigmap), initvals(ffcache.initvals) {
 		// Gathering two kinds of information here for every sigmapped SigBit:
 		//
 		// - bitusers: how many users it has (muxes will only be merged into FFs if this is 1, making the FF the only user)
@@ -268,7 +269,7 @@ struct OptDffWorker
 			Cell *cell = dff_cells.back();
 			dff_cells.pop_back();
 			// Break down the FF into pieces.
-			FfData ff(&initvals, cell);
+			FfData ff = ffcache.ff(cell);
 			bool changed = false;
 
 			if (!ff.width) {
@@ -735,18 +736,35 @@ struct OptDffWorker
 	}
 
 	bool run_constbits() {
-		ModWalker modwalker(module->design, module);
-		QuickConeSat qcsat(modwalker);
+		// With -sat, whether a bit can change from its initial value is asked of one solver for the whole
+		// module, which imports the cones of all FF inputs in question at once and answers the queries as a
+		// batch (see QuickConeSat::solveBatch()). The FFs are only changed after all queries have been
+		// answered, so that no cells are removed under ModWalker.
+		std::unique_ptr<ModWalker> modwalker;
+		std::unique_ptr<QuickConeSat> qcsat;
+		if (opt.sat) {
+			modwalker.reset(new ModWalker(module->design, module));
+			qcsat.reset(new QuickConeSat(*modwalker));
+		}
+
+		struct ConstBit {
+			int index;
+			State val;
+			int first_query, num_queries;
+		};
+
+		std::vector<FfData> ffs;
+		std::vector<std::vector<ConstBit>> ff_constbits;
+		std::vector<std::pair<int, int>> query_sigs;
+		std::vector<State> query_vals;
 
-		// Run as a separate sub-pass, so that we don't mutate (non-FF) cells under ModWalker.
-		bool did_something = false;
 		for (auto cell : module->selected_cells()) {
 			if (!RTLIL::builtin_ff_cell_types().count(cell->type))
 				continue;
-			FfData ff(&initvals, cell);
+			FfData ff = ffcache.ff(cell);
 
 			// Now check if any bit can be replaced by a constant.
-			pool<int> removed_sigbits;
+			std::vector<ConstBit> constbits;
 			for (int i = 0; i < ff.width; i++) {
 				State val = ff.val_init[i];
 				if (ff.has_arst)
@@ -761,62 +779,70 @@ struct OptDffWorker
 				}
 				if (val == State::Sm)
 					continue;
-				if (ff.has_clk || ff.has_gclk) {
-					if (!ff.sig_d[i].wire) {
-						val = combine_const(val, ff.sig_d[i].data);
-						if (val == State::Sm)
-							continue;
-					} else {
-						if (!opt.sat)
-							continue;
-						// For each register bit, try to prove that it cannot change from the initial value. If so, remove it
-						if (!modwalker.has_drivers(ff.sig_d.extract(i)))
-							continue;
-						if (val != State::S0 && val != State::S1)
-							continue;
-
-						int init_sat_pi = qcsat.importSigBit(val);
-						int q_sat_pi = qcsat.importSigBit(ff.sig_q[i]);
-						int d_sat_pi = qcsat.importSigBit(ff.sig_d[i]);
-
-						qcsat.prepare();
-
-						// Try to find out whether the register bit can change under some circumstances
-						bool counter_example_found = qcsat.ez->solve(qcsat.ez->IFF(q_sat_pi, init_sat_pi), qcsat.ez->NOT(qcsat.ez->IFF(d_sat_pi, init_sat_pi)));
-
-						// If the register bit cannot change, we can replace it with a constant
-						if (counter_example_found)
-							continue;
-					}
-				}
-				if (ff.has_aload) {
-					if (!ff.sig_ad[i].wire) {
-						val = combine_const(val, ff.sig_ad[i].data);
-						if (val == State::Sm)
-							continue;
+
+				// The inputs (D and AD) that have to be proven to not change the bit from `val`.
+				std::vector<SigBit> sat_inputs;
+				bool can_change = false;
+				auto check_input = [&](SigBit bit) {
+					if (!bit.wire) {
+						val = combine_const(val, bit.data);
+						can_change = val == State::Sm;
+					} else if (!opt.sat || !modwalker->has_drivers(SigSpec(bit)) || (val != State::S0 && val != State::S1)) {
+						can_change = true;
 					} else {
-						if (!opt.sat)
-							continue;
-						// For each register bit, try to prove that it cannot change from the initial value. If so, remove it
-						if (!modwalker.has_drivers(ff.sig_ad.extract(i)))
-							continue;
-						if (val != State::S0 && val != State::S1)
-							continue;
-
-						int init_sat_pi = qcsat.importSigBit(val);
-						int q_sat_pi = qcsat.importSigBit(ff.sig_q[i]);
-						int d_sat_pi = qcsat.importSigBit(ff.sig_ad[i]);
-
-						qcsat.prepare();
-
-						// Try to find out whether the register bit can change under some circumstances
-						bool counter_example_found = qcsat.ez->solve(qcsat.ez->IFF(q_sat_pi, init_sat_pi), qcsat.ez->NOT(qcsat.ez->IFF(d_sat_pi, init_sat_pi)));
-
-						// If the register bit cannot change, we can replace it with a constant
-						if (counter_example_found)
-							continue;
+						sat_inputs.push_back(bit);
 					}
+				};
+				if (ff.has_clk || ff.has_gclk)
+					check_input(ff.sig_d[i]);
+				if (ff.has_aload && !can_change)
+					check_input(ff.sig_ad[i]);
+				if (can_change)
+					continue;
+
+				ConstBit constbit = {i, val, GetSize(query_sigs), GetSize(sat_inputs)};
+				for (auto bit : sat_inputs) {
+					query_sigs.push_back(std::make_pair(qcsat->importSigBit(ff.sig_q[i]), qcsat->importSigBit(bit)));
+					query_vals.push_back(val);
 				}
+				constbits.push_back(constbit);
+			}
+
+			ffs.push_back(ff);
+			ff_constbits.push_back(constbits);
+		}
+
+		// For each register bit, try to find out whether it can change from the initial value under some
+		// circumstances, i.e. whether its input can differ from the value while its output has the value.
+		std::vector<bool> query_sat;
+		if (!query_sigs.empty()) {
+			qcsat->prepare();
+			std::vector<std::vector<int>> queries;
+			for (int k = 0; k < GetSize(query_sigs); k++) {
+				int val_sat_pi = qcsat->importSigBit(query_vals[k]);
+				queries.push_back({qcsat->ez->IFF(query_sigs[k].first, val_sat_pi),
+						qcsat->ez->NOT(qcsat->ez->IFF(query_sigs[k].second, val_sat_pi))});
+			}
+			query_sat = qcsat->solveBatch(queries);
+		}
+
+		bool did_something = false;
+		for (int n = 0; n < GetSize(ffs); n++) {
+			FfData &ff = ffs[n];
+			Cell *cell = ff.cell;
+
+			// If the register bit cannot change, we can replace it with a constant
+			pool<int> removed_sigbits;
+			for (auto &constbit : ff_constbits[n]) {
+				bool can_change = false;
+				for (int k = constbit.first_query; k < constbit.first_query + constbit.num_queries; k++)
+					if (query_sat[k])
+						can_change = true;
+				if (can_change)
+					continue;
+
+				int i = constbit.index;
+				State val = constbit.val;
 				log("Setting constant %d-bit at position %d on %s (%s) from module %s.\n", val ? 1 : 0,
 						i, log_id(cell), log_id(cell->type), log_id(module));
 
@@ -845,7 +871,7 @@ struct OptDffWorker
 };
 
 struct OptDffPass : public Pass {
-	OptDffPass() : Pass("opt_dff", "perform DFF optimizations") { }
+	OptDffPass() : Pass("opt_dff", "perform DFF optimizations") { keeps_indexes(); selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -917,12 +943,20 @@ struct OptDffPass : public Pass {
 		extra_args(args, argidx, design);
 
 		bool did_something = false;
+		std::string key = converged_key(args);
 		for (auto mod : design->selected_modules()) {
+			if (mod->converged(key))
+				continue;
+			ModuleScope scope(mod);
 			OptDffWorker worker(opt, mod);
-			if (worker.run())
-				did_something = true;
+			bool mod_changed = worker.run();
 			if (worker.run_constbits())
+				mod_changed = true;
+			if (mod_changed) {
+				mod->mark_changed();
 				did_something = true;
+			} else
+				mod->mark_converged(key);
 		}
 
 		if (did_something)
@@ -31,6 +31,112 @@ PRIVATE_NAMESPACE_BEGIN
 
 bool did_something;
 
+// Records the changes made to a module, so that a round of replace_const_cells() only has to look at the cells
+// around the changes made since the previous round with the same setting of consume_x, instead of at every cell.
+// What replace_const_cells() does with a cell only depends on the type, parameters and connections of the cell,
+// on the signals that its connections map to, and on which of those signals are driven by inverters; a cell for
+// which none of these changed would come out of the round unchanged.
+struct ConstCellsWorklist : public RTLIL::Monitor
+{
+	RTLIL::Module *module;
+
+	// changes since the last round, for consume_x = false and consume_x = true
+	bool all_dirty[2] = {true, true};
+	pool<RTLIL::Cell*, hashlib::hash_ptr_ops> dirty_cells[2];
+	pool<RTLIL::SigBit> dirty_bits[2];
+
+	// what the current round looks at
+	bool visit_all = true;
+	pool<RTLIL::Cell*, hashlib::hash_ptr_ops> visit_cells;
+	pool<RTLIL::SigBit> visit_bits;
+
+	ConstCellsWorklist(RTLIL::Module *module) : module(module)
+	{
+		module->monitors.insert(this);
+	}
+
+	~ConstCellsWorklist()
+	{
+		module->monitors.erase(this);
+	}
+
+	ConstCellsWorklist(const ConstCellsWorklist &) = delete;
+	ConstCellsWorklist &operator=(const ConstCellsWorklist &) = delete;
+
+	void mark(RTLIL::Cell *cell)
+	{
+		// The cell may already have been removed, which is why the pools of cells hash the pointers themselves.
+		dirty_cells[0].insert(cell);
+		dirty_cells[1].insert(cell);
+	}
+
+	void mark(const RTLIL::SigSpec &sig)
+	{
+		for (auto bit : sig)
+			if (bit.wire != nullptr) {
+				dirty_bits[0].insert(bit);
+				dirty_bits[1].insert(bit);
+			}
+	}
+
+	void notify_connect(RTLIL::Cell *cell, const RTLIL::IdString &, const RTLIL::SigSpec &old_sig, const RTLIL::SigSpec &sig) override
+	{
+		mark(cell);
+		mark(old_sig);
+		mark(sig);
+	}
+
+	void notify_connect(RTLIL::Module *, const RTLIL::SigSig &sigsig) override
+	{
+		mark(sigsig.first);
+		mark(sigsig.second);
+	}
+
+	void notify_connect(RTLIL::Module *, const std::vector<RTLIL::SigSig>&) override
+	{
+		all_dirty[0] = all_dirty[1] = true;
+	}
+
+	void notify_blackout(RTLIL::Module *) override
+	{
+		all_dirty[0] = all_dirty[1] = true;
+	}
+
+	bool visit(RTLIL::Cell *cell, SigMap &assign_map) const
+	{
+		if (visit_all || visit_cells.count(cell))
+			return true;
+		for (auto &conn : cell->connections())
+			for (auto bit : conn.second)
+				if (visit_bits.count(assign_map(bit)))
+					return true;
+		return false;
+	}
+
+	// Starts a round, which looks at the cells affected by the changes recorded for its setting of consume_x.
+	// The signals that the dirty bits map to now include those that the dirty bits were connected to, and so the
+	// signals whose mapping has changed. The outputs of inverters that are looked at are added as well, since
+	// the inverted signal of those may have changed.
+	void begin_round(bool consume_x, SigMap &assign_map, const std::vector<RTLIL::Cell*> &inverters)
+	{
+		visit_all = all_dirty[consume_x];
+		visit_cells.swap(dirty_cells[consume_x]);
+		visit_bits.clear();
+		if (!visit_all) {
+			for (auto bit : dirty_bits[consume_x])
+				visit_bits.insert(assign_map(bit));
+			for (auto cell : inverters)
+				if (visit(cell, assign_map))
+					for (auto bit : cell->getPort(ID::Y))
+						visit_bits.insert(assign_map(bit));
+		}
+
+		all_dirty[consume_x] = false;
+		dirty_cells[consume_x].clear();
+		dirty_bits[consume_x].clear();
+	}
+};
+
 void replace_undriven(RTLIL::Module *module, const CellTypes &ct)
 {
 	SigMap sigmap(module);
@@ -106,10 +212,12 @@ void replace_undriven(RTLIL::Module *module, const CellTypes &ct)
 			if (initval.is_fully_undef()) {
 				log_debug("Removing init attribute from %s/%s.\n", log_id(module), log_id(wire));
 				wire->attributes.erase(ID::init);
+				module->init_generation_++;
 				did_something = true;
 			} else if (initval != wire->attributes.at(ID::init)) {
 				log_debug("Updating init attribute on %s/%s: %s\n", log_id(module), log_id(wire), log_signal(initval));
 				wire->attributes[ID::init] = initval;
+				module->init_generation_++;
 				did_something = true;
 			}
 		}
@@ -393,28 +501,34 @@ int get_highest_hot_index(RTLIL::SigSpec signal)
 	return -1;
 }
 
-void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool consume_x, bool mux_undef, bool mux_bool, bool do_fine, bool keepdc, bool noclkinv)
+void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, SigMap &assign_map, ConstCellsWorklist &worklist, bool consume_x, bool mux_undef, bool mux_bool, bool do_fine, bool keepdc, bool noclkinv)
 {
-	SigMap assign_map(module);
 	dict<RTLIL::SigSpec, RTLIL::SigSpec> invert_map;
+	std::vector<RTLIL::Cell*> inverters;
 
 	for (auto cell : module->cells()) {
 		if (design->selected(module, cell) && cell->type[0] == '$') {
 			if (cell->type.in(ID($_NOT_), ID($not), ID($logic_not)) &&
-					GetSize(cell->getPort(ID::A)) == 1 && GetSize(cell->getPort(ID::Y)) == 1)
+					GetSize(cell->getPort(ID::A)) == 1 && GetSize(cell->getPort(ID::Y)) == 1) {
 				invert_map[assign_map(cell->getPort(ID::Y))] = assign_map(cell->getPort(ID::A));
+				inverters.push_back(cell);
+			}
 			if (cell->type.in(ID($mux), ID($_MUX_)) &&
-					cell->getPort(ID::A) == SigSpec(State::S1) && cell->getPort(ID::B) == SigSpec(State::S0))
+					cell->getPort(ID::A) == SigSpec(State::S1) && cell->getPort(ID::B) == SigSpec(State::S0)) {
 				invert_map[assign_map(cell->getPort(ID::Y))] = assign_map(cell->getPort(ID::S));
+				inverters.push_back(cell);
+			}
 		}
 	}
 
+	worklist.begin_round(consume_x, assign_map, inverters);
+
 	CellTypes ct_memcells;
 	ct_memcells.setup_stdcells_mem();
 
 	if (!noclkinv)
 	for (auto cell : module->cells())
-	if (design->selected(module, cell)) {
+	if (design->selected(module, cell) && worklist.visit(cell, assign_map)) {
 		if (cell->type.in(ID($dff), ID($dffe), ID($dffsr), ID($dffsre), ID($adff), ID($adffe), ID($aldff), ID($aldffe), ID($sdff), ID($sdffe), ID($sdffce), ID($fsm), ID($memrd), ID($memrd_v2), ID($memwr), ID($memwr_v2)))
 			handle_polarity_inv(cell, ID::CLK, ID::CLK_POLARITY, assign_map, invert_map);
 
@@ -491,25 +605,28 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 	}
 
 	TopoSort<RTLIL::Cell*, RTLIL::IdString::compare_ptr_by_name<RTLIL::Cell>> cells;
-	dict<RTLIL::SigBit, Cell*> outbit_to_cell;
+	std::vector<RTLIL::Cell*> visit_cells;
+	dict<RTLIL::SigBit, int> outbit_to_index;
 
 	for (auto cell : module->cells())
-	if (design->selected(module, cell) && yosys_celltypes.cell_evaluable(cell->type)) {
+	if (design->selected(module, cell) && yosys_celltypes.cell_evaluable(cell->type) && worklist.visit(cell, assign_map)) {
+		const int index = cells.node(cell);
 		for (auto &conn : cell->connections())
 		if (yosys_celltypes.cell_output(cell->type, conn.first))
 		for (auto bit : assign_map(conn.second))
-			outbit_to_cell[bit] = cell;
-		cells.node(cell);
+			outbit_to_index[bit] = index;
+		visit_cells.push_back(cell);
 	}
 
-	for (auto cell : module->cells())
-	if (design->selected(module, cell) && yosys_celltypes.cell_evaluable(cell->type)) {
-		const int r_index = cells.node(cell);
+	for (int r_index = 0; r_index < GetSize(visit_cells); r_index++) {
+		RTLIL::Cell *cell = visit_cells[r_index];
 		for (auto &conn : cell->connections())
 		if (yosys_celltypes.cell_input(cell->type, conn.first))
-		for (auto bit : assign_map(conn.second))
-		if (outbit_to_cell.count(bit))
-			cells.edge(cells.node(outbit_to_cell.at(bit)), r_index);
+		for (auto bit : assign_map(conn.second)) {
+			auto it = outbit_to_index.find(bit);
+			if (it != outbit_to_index.end())
+				cells.edge(it->second, r_index);
+		}
 	}
 
 	if (!cells.sort()) {
@@ -520,6 +637,10 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 
 	for (auto cell : cells.sorted)
 	{
+		// changes to the cell itself (e.g. to its type) are not seen by the worklist
+		bool did_something_before = did_something;
+		did_something = false;
+
 #define ACTION_DO(_p_, _s_) do { cover("opt.opt_expr.action_" S__LINE__); replace_cell(assign_map, module, cell, input.as_string(), _p_, _s_); goto next_cell; } while (0)
 #define ACTION_DO_Y(_v_) ACTION_DO(ID::Y, RTLIL::SigSpec(RTLIL::State::S ## _v_))
 
@@ -2197,7 +2318,10 @@ skip_alu_split:
 			}
 		}
 
-	next_cell:;
+	next_cell:
+		if (did_something)
+			worklist.mark(cell);
+		did_something |= did_something_before;
 #undef ACTION_DO
 #undef ACTION_DO_Y
 #undef FOLD_1ARG_CELL
@@ -2205,8 +2329,7 @@ skip_alu_split:
 	}
 }
 
-void replace_const_connections(RTLIL::Module *module) {
-	SigMap assign_map(module);
+void replace_const_connections(RTLIL::Module *module, SigMap &assign_map) {
 	for (auto cell : module->selected_cells())
 	{
 		std::vector<std::pair<RTLIL::IdString, SigSpec>> changes;
@@ -2223,7 +2346,7 @@ void replace_const_connections(RTLIL::Module *module) {
 }
 
 struct OptExprPass : public Pass {
-	OptExprPass() : Pass("opt_expr", "perform const folding and simple expression rewriting") { }
+	OptExprPass() : Pass("opt_expr", "perform const folding and simple expression rewriting") { keeps_indexes(); selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -2308,34 +2431,50 @@ struct OptExprPass : public Pass {
 		extra_args(args, argidx, design);
 
 		CellTypes ct(design);
+		std::string key = converged_key(args);
 		for (auto module : design->selected_modules())
 		{
+			if (module->converged(key))
+				continue;
+
+			ModuleScope scope(module);
 			log("Optimizing module %s.\n", log_id(module));
+			bool module_changed = false;
+
+			// shared by all rounds below instead of a SigMap rebuild per round
+			IncrementalSigMap assign_map(module);
+			ConstCellsWorklist worklist(module);
 
 			if (undriven) {
 				did_something = false;
 				replace_undriven(module, ct);
 				if (did_something)
-					design->scratchpad_set_bool("opt.did_something", true);
+					module_changed = true;
 			}
 
 			do {
 				do {
 					did_something = false;
-					replace_const_cells(design, module, false /* consume_x */, mux_undef, mux_bool, do_fine, keepdc, noclkinv);
+					replace_const_cells(design, module, assign_map.get(), worklist, false /* consume_x */, mux_undef, mux_bool, do_fine, keepdc, noclkinv);
 					if (did_something)
-						design->scratchpad_set_bool("opt.did_something", true);
+						module_changed = true;
 				} while (did_something);
 				if (!keepdc)
-					replace_const_cells(design, module, true /* consume_x */, mux_undef, mux_bool, do_fine, keepdc, noclkinv);
+					replace_const_cells(design, module, assign_map.get(), worklist, true /* consume_x */, mux_undef, mux_bool, do_fine, keepdc, noclkinv);
 				if (did_something)
-					design->scratchpad_set_bool("opt.did_something", true);
+					module_changed = true;
 			} while (did_something);
 
 			did_something = false;
-			replace_const_connections(module);
+			replace_const_connections(module, assign_map.get());
 			if (did_something)
+				module_changed = true;
+
+			if (module_changed) {
+				module->mark_changed();
 				design->scratchpad_set_bool("opt.did_something", true);
+			} else
+				module->mark_converged(key);
 
 			log_suppressed();
 		}
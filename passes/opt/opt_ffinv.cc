@@ -30,7 +30,7 @@ struct OptFfInvWorker
 {
 	int count = 0;
 	RTLIL::Module *module;
-	ModIndex index;
+	ModIndex &index;
 	FfInitVals initvals;
 
 	// Case 1:
@@ -201,7 +201,7 @@ struct OptFfInvWorker
 	}
 
 	OptFfInvWorker(RTLIL::Module *module) :
-		module(module), index(module), initvals(&index.sigmap, module)
+		module(module), index(ModIndex::cached(module)), initvals(&index.sigmap, module)
 	{
 		log("Discovering LUTs.\n");
 
@@ -232,7 +232,7 @@ struct OptFfInvWorker
 };
 
 struct OptFfInvPass : public Pass {
-	OptFfInvPass() : Pass("opt_ffinv", "push inverters through FFs") { }
+	OptFfInvPass() : Pass("opt_ffinv", "push inverters through FFs") { keeps_indexes(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -38,7 +38,7 @@ struct OptLutWorker
 {
 	const std::vector<dlogic_t> &dlogic;
 	RTLIL::Module *module;
-	ModIndex index;
+	ModIndex &index;
 	SigMap sigmap;
 
 	pool<RTLIL::Cell*> luts;
@@ -48,27 +48,74 @@ struct OptLutWorker
 
 	int eliminated_count = 0, combined_count = 0;
 
-	bool evaluate_lut(RTLIL::Cell *lut, dict<SigBit, bool> inputs)
+	// scratch space for evaluate_lut()
+	vector<uint64_t> eval_values;
+
+	// Truth tables of functions of up to `num_vars` variables have one bit per
+	// assignment of the variables, where bit `i` of the index of the entry is
+	// the value of variable `i`, and are packed into 64-bit words. Tables of
+	// fewer than 6 variables repeat within their single word, so tables can
+	// be compared word by word.
+	typedef std::vector<uint64_t> truth_table_t;
+
+	static truth_table_t table_const(int num_vars, bool value)
+	{
+		return truth_table_t(num_vars <= 6 ? 1 : 1 << (num_vars - 6), value ? ~uint64_t(0) : 0);
+	}
+
+	static truth_table_t table_var(int num_vars, int var)
+	{
+		static const uint64_t patterns[6] = {
+			0xaaaaaaaaaaaaaaaaull, 0xccccccccccccccccull, 0xf0f0f0f0f0f0f0f0ull,
+			0xff00ff00ff00ff00ull, 0xffff0000ffff0000ull, 0xffffffff00000000ull,
+		};
+		truth_table_t table = table_const(num_vars, false);
+		for (int k = 0; k < GetSize(table); k++)
+			table[k] = var < 6 ? patterns[var] : ((k >> (var - 6)) & 1) ? ~uint64_t(0) : 0;
+		return table;
+	}
+
+	static bool table_bit(const truth_table_t &table, int index)
+	{
+		return (table[index >> 6] >> (index & 63)) & 1;
+	}
+
+	// Evaluates the LUT for all assignments of the variables at once. The
+	// inputs of the LUT that are connected to a signal in `inputs` have the
+	// given truth table, all others must be constant.
+	truth_table_t evaluate_lut(RTLIL::Cell *lut, const dict<SigBit, truth_table_t> &inputs, int num_vars)
 	{
 		SigSpec lut_input = sigmap(lut->getPort(ID::A));
 		int lut_width = lut->getParam(ID::WIDTH).as_int();
-		Const lut_table = lut->getParam(ID::LUT);
-		int lut_index = 0;
+		const Const &lut_table = lut->getParam(ID::LUT);
+
+		// Select between the halves of the LUT contents by each input in turn,
+		// starting with the least significant one.
+		int words = GetSize(table_const(num_vars, false));
+		vector<uint64_t> &values = eval_values;
+		values.clear();
+		for (int i = 0; i < 1 << lut_width; i++)
+			values.resize(values.size() + words, i < GetSize(lut_table) && lut_table[i] == State::S1 ? ~uint64_t(0) : 0);
 
+		int entries = 1 << lut_width;
 		for (int i = 0; i < lut_width; i++)
 		{
 			SigBit input = sigmap(lut_input[i]);
-			if (inputs.count(input))
-			{
-				lut_index |= inputs[input] << i;
-			}
-			else
-			{
-				lut_index |= SigSpec(lut_input[i]).as_bool() << i;
-			}
+			auto it = inputs.find(input);
+			truth_table_t const_sel;
+			if (it == inputs.end())
+				const_sel = table_const(num_vars, SigSpec(lut_input[i]).as_bool());
+			const truth_table_t &sel = it != inputs.end() ? it->second : const_sel;
+
+			entries /= 2;
+			for (int k = 0; k < entries; k++)
+				for (int w = 0; w < words; w++) {
+					uint64_t value0 = values[2*k*words + w], value1 = values[(2*k+1)*words + w];
+					values[k*words + w] = (value0 & ~sel[w]) | (value1 & sel[w]);
+				}
 		}
 
-		return lut_table.extract(lut_index).as_bool();
+		return truth_table_t(values.begin(), values.begin() + words);
 	}
 
 	void show_stats_by_arity()
@@ -104,7 +151,7 @@ struct OptLutWorker
 	}
 
 	OptLutWorker(const std::vector<dlogic_t> &dlogic, RTLIL::Module *module, int limit) :
-		dlogic(dlogic), module(module), index(module), sigmap(module)
+		dlogic(dlogic), module(module), index(ModIndex::cached(module)), sigmap(module)
 	{
 		log("Discovering LUTs.\n");
 		for (auto cell : module->selected_cells())
@@ -228,28 +275,17 @@ struct OptLutWorker
 					lut_inputs.push_back(sigmap(bit));
 			}
 
-			bool const0_match = true;
-			bool const1_match = true;
-			vector<bool> input_matches;
-			for (size_t i = 0; i < lut_inputs.size(); i++)
-				input_matches.push_back(true);
+			int num_vars = GetSize(lut_inputs);
+			dict<SigBit, truth_table_t> eval_inputs;
+			for (int i = 0; i < num_vars; i++)
+				eval_inputs[lut_inputs[i]] = table_var(num_vars, i);
+			truth_table_t value = evaluate_lut(lut, eval_inputs, num_vars);
 
-			for (int eval = 0; eval < 1 << lut_inputs.size(); eval++)
-			{
-				dict<SigBit, bool> eval_inputs;
-				for (size_t i = 0; i < lut_inputs.size(); i++)
-					eval_inputs[lut_inputs[i]] = (eval >> i) & 1;
-				bool value = evaluate_lut(lut, eval_inputs);
-				if (value != 0)
-					const0_match = false;
-				if (value != 1)
-					const1_match = false;
-				for (size_t i = 0; i < lut_inputs.size(); i++)
-				{
-					if (value != eval_inputs[lut_inputs[i]])
-						input_matches[i] = false;
-				}
-			}
+			bool const0_match = value == table_const(num_vars, false);
+			bool const1_match = value == table_const(num_vars, true);
+			vector<bool> input_matches;
+			for (int i = 0; i < num_vars; i++)
+				input_matches.push_back(value == eval_inputs.at(lut_inputs[i]));
 
 			int input_match = -1;
 			for (size_t i = 0; i < lut_inputs.size(); i++)
@@ -484,17 +520,15 @@ struct OptLutWorker
 					}
 					log_assert(lutR_unique.size() == 0);
 
+					dict<SigBit, truth_table_t> eval_inputs;
+					for (int i = 0; i < GetSize(lutM_new_inputs); i++)
+						eval_inputs[lutM_new_inputs[i]] = table_var(lutM_width, i);
+					eval_inputs[lutA_output] = evaluate_lut(lutA, eval_inputs, lutM_width);
+					truth_table_t lutM_value = evaluate_lut(lutB, eval_inputs, lutM_width);
+
 					RTLIL::Const lutM_new_table(State::Sx, 1 << lutM_width);
 					for (int eval = 0; eval < 1 << lutM_width; eval++)
-					{
-						dict<SigBit, bool> eval_inputs;
-						for (size_t i = 0; i < lutM_new_inputs.size(); i++)
-						{
-							eval_inputs[lutM_new_inputs[i]] = (eval >> i) & 1;
-						}
-						eval_inputs[lutA_output] = evaluate_lut(lutA, eval_inputs);
-						lutM_new_table.bits()[eval] = (RTLIL::State) evaluate_lut(lutB, eval_inputs);
-					}
+						lutM_new_table.bits()[eval] = table_bit(lutM_value, eval) ? State::S1 : State::S0;
 
 					log_debug("  Cell A truth table: %s.\n", lutA->getParam(ID::LUT).as_string().c_str());
 					log_debug("  Cell B truth table: %s.\n", lutB->getParam(ID::LUT).as_string().c_str());
@@ -524,7 +558,7 @@ struct OptLutWorker
 };
 
 struct OptLutPass : public Pass {
-	OptLutPass() : Pass("opt_lut", "optimize LUT cells") { }
+	OptLutPass() : Pass("opt_lut", "optimize LUT cells") { keeps_indexes(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -581,6 +615,9 @@ struct OptLutPass : public Pass {
 		extra_args(args, argidx, design);
 
 		int eliminated_count = 0, combined_count = 0;
+
+	// scratch space for evaluate_lut()
+	vector<uint64_t> eval_values;
 		for (auto module : design->selected_modules())
 		{
 			OptLutWorker worker(dlogic, module, limit - eliminated_count - combined_count);
@@ -52,6 +52,48 @@ struct OptMemPriorityPass : public Pass {
 			for (auto &mem : Mem::get_selected_memories(module)) {
 				bool mem_changed = false;
 				QuickConeSat qcsat(modwalker);
+
+				// import the cones of all ports that take part in a priority
+				// relation at once, and simulate them to find collisions
+				// without asking the solver
+				pool<int> checked_ports;
+				for (int i = 0; i < GetSize(mem.wr_ports); i++)
+					for (int j = 0; j < GetSize(mem.wr_ports); j++)
+						if (mem.wr_ports[i].priority_mask[j] && mem.wr_ports[i].wide_log2 == mem.wr_ports[j].wide_log2) {
+							checked_ports.insert(i);
+							checked_ports.insert(j);
+						}
+				if (checked_ports.empty())
+					continue;
+
+				std::vector<SigBit> sim_bits;
+				for (int i : checked_ports) {
+					for (auto bit : modwalker.sigmap(mem.wr_ports[i].addr))
+						sim_bits.push_back(bit);
+					for (auto bit : modwalker.sigmap(mem.wr_ports[i].en))
+						sim_bits.push_back(bit);
+					qcsat.importSig(mem.wr_ports[i].addr);
+					qcsat.importSig(mem.wr_ports[i].en);
+				}
+				qcsat.prepare();
+
+				const int sim_rounds = 4;
+				dict<SigBit, std::vector<uint64_t>> sim_values;
+				std::vector<std::vector<uint64_t>> values;
+				bool simulated = qcsat.simulate(sim_bits, sim_rounds, values);
+				for (int k = 0; simulated && k < GetSize(sim_bits); k++)
+					sim_values[sim_bits[k]] = values[k];
+				auto sim_word = [&](SigBit bit, int r) -> uint64_t {
+					bit = modwalker.sigmap(bit);
+					if (bit.wire == nullptr)
+						return bit == State::S1 ? ~uint64_t(0) : 0;
+					return sim_values.at(bit)[r];
+				};
+
+				// results of the queries (wen1, wen2, addr_eq), the same
+				// enables and addresses are often shared by many ports and bits
+				dict<std::tuple<int, int, int>, bool> query_cache;
+
 				for (int i = 0; i < GetSize(mem.wr_ports); i++) {
 					auto &wport1 = mem.wr_ports[i];
 					for (int j = 0; j < GetSize(mem.wr_ports); j++) {
@@ -65,27 +107,38 @@ struct OptMemPriorityPass : public Pass {
 						if (wport1.wide_log2 != wport2.wide_log2)
 							continue;
 						// Two ports with priority, let's go.
-						pool<std::pair<SigBit, SigBit>> checked;
 						SigSpec addr1 = wport1.addr;
 						SigSpec addr2 = wport2.addr;
 						int abits = std::max(GetSize(addr1), GetSize(addr2));
 						addr1.extend_u0(abits);
 						addr2.extend_u0(abits);
 						int addr_eq = qcsat.ez->vec_eq(qcsat.importSig(addr1), qcsat.importSig(addr2));
+						std::vector<uint64_t> addr_eq_sim(sim_rounds, ~uint64_t(0));
+						for (int k = 0; simulated && k < abits; k++)
+							for (int r = 0; r < sim_rounds; r++)
+								addr_eq_sim[r] &= ~(sim_word(addr1[k], r) ^ sim_word(addr2[k], r));
 						bool ok = true;
 						for (int k = 0; k < GetSize(wport1.data); k++) {
 							SigBit wen1 = wport1.en[k];
 							SigBit wen2 = wport2.en[k];
-							if (checked.count({wen1, wen2}))
-								continue;
 							int wen1_sat = qcsat.importSigBit(wen1);
 							int wen2_sat = qcsat.importSigBit(wen2);
-							qcsat.prepare();
-							if (qcsat.ez->solve(wen1_sat, wen2_sat, addr_eq)) {
+							auto key = std::make_tuple(wen1_sat, wen2_sat, addr_eq);
+							auto it = query_cache.find(key);
+							if (it == query_cache.end()) {
+								bool collision = false;
+								for (int r = 0; simulated && r < sim_rounds && !collision; r++)
+									collision = (sim_word(wen1, r) & sim_word(wen2, r) & addr_eq_sim[r]) != 0;
+								if (!collision) {
+									qcsat.prepare();
+									collision = qcsat.ez->solve(wen1_sat, wen2_sat, addr_eq);
+								}
+								it = query_cache.emplace(key, collision).first;
+							}
+							if (it->second) {
 								ok = false;
 								break;
 							}
-							checked.insert({wen1, wen2});
 						}
 						if (ok) {
 							total_count++;
@@ -65,90 +65,58 @@ struct OptMergeWorker
 		}
 	}
 
-	std::string int_to_hash_string(unsigned int v)
+	// The connections that identical cells have to agree on: the inputs mapped with assign_map, the (* init *)
+	// value in place of the Q output of a state element, and empty signals for the other outputs.
+	dict<RTLIL::IdString, RTLIL::SigSpec> mapped_connections(const RTLIL::Cell *cell)
 	{
-		if (v == 0)
-			return "0";
-		std::string str = "";
-		while (v > 0) {
-			str += 'a' + (v & 15);
-			v = v >> 4;
+		dict<RTLIL::IdString, RTLIL::SigSpec> conn;
+		conn.reserve(cell->connections_.size());
+
+		for (const auto &it : cell->connections_) {
+			if (cell->output(it.first)) {
+				if (it.first == ID::Q && RTLIL::builtin_ff_cell_types().count(cell->type))
+					conn[it.first] = initvals(it.second);
+				else
+					conn[it.first] = RTLIL::SigSpec();
+			}
+			else
+				conn[it.first] = assign_map(it.second);
 		}
-		return str;
+
+		return conn;
 	}
 
-        uint64_t hash_cell_parameters_and_connections(const RTLIL::Cell *cell)
+	// Brings the connections returned by mapped_connections() into a canonical form, so that cells that only
+	// differ in the order of commutative inputs have the same connections.
+	static void normalize_connections(RTLIL::IdString type, dict<RTLIL::IdString, RTLIL::SigSpec> &conn)
 	{
-		vector<string> hash_conn_strings;
-		std::string hash_string = cell->type.str() + "\n";
-
-		const dict<RTLIL::IdString, RTLIL::SigSpec> *conn = &cell->connections();
-		dict<RTLIL::IdString, RTLIL::SigSpec> alt_conn;
-
-		if (cell->type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($mul),
+		if (type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($mul),
 				ID($logic_and), ID($logic_or), ID($_AND_), ID($_OR_), ID($_XOR_))) {
-			alt_conn = *conn;
-			if (assign_map(alt_conn.at(ID::A)) < assign_map(alt_conn.at(ID::B))) {
-				alt_conn[ID::A] = conn->at(ID::B);
-				alt_conn[ID::B] = conn->at(ID::A);
-			}
-			conn = &alt_conn;
+			if (conn.at(ID::A) < conn.at(ID::B))
+				std::swap(conn.at(ID::A), conn.at(ID::B));
 		} else
-		if (cell->type.in(ID($reduce_xor), ID($reduce_xnor))) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			alt_conn.at(ID::A).sort();
-			conn = &alt_conn;
+		if (type.in(ID($reduce_xor), ID($reduce_xnor))) {
+			conn.at(ID::A).sort();
 		} else
-		if (cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_bool))) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			alt_conn.at(ID::A).sort_and_unify();
-			conn = &alt_conn;
+		if (type.in(ID($reduce_and), ID($reduce_or), ID($reduce_bool))) {
+			conn.at(ID::A).sort_and_unify();
 		} else
-		if (cell->type == ID($pmux)) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			assign_map.apply(alt_conn.at(ID::B));
-			assign_map.apply(alt_conn.at(ID::S));
-			sort_pmux_conn(alt_conn);
-			conn = &alt_conn;
-		}
-
-		for (auto &it : *conn) {
-			RTLIL::SigSpec sig;
-			if (cell->output(it.first)) {
-				if (it.first == ID::Q && RTLIL::builtin_ff_cell_types().count(cell->type)) {
-					// For the 'Q' output of state elements,
-					//   use its (* init *) attribute value
-					sig = initvals(it.second);
-				}
-				else
-					continue;
-			}
-			else
-				sig = assign_map(it.second);
-			string s = "C " + it.first.str() + "=";
-			for (auto &chunk : sig.chunks()) {
-				if (chunk.wire)
-					s += "{" + chunk.wire->name.str() + " " +
-							int_to_hash_string(chunk.offset) + " " +
-							int_to_hash_string(chunk.width) + "}";
-				else
-					s += RTLIL::Const(chunk.data).as_string();
-			}
-			hash_conn_strings.push_back(s + "\n");
+		if (type == ID($pmux)) {
+			sort_pmux_conn(conn);
 		}
+	}
 
-		for (auto &it : cell->parameters)
-			hash_conn_strings.push_back("P " + it.first.str() + "=" + it.second.as_string() + "\n");
-
-		std::sort(hash_conn_strings.begin(), hash_conn_strings.end());
-
-		for (auto it : hash_conn_strings)
-			hash_string += it;
+	// Hashes the type, parameters and connections of a cell, where `conn` is the result of mapped_connections().
+	// This only reads the cell, so it can run on several cells in parallel.
+	static Hasher::hash_t hash_cell(const RTLIL::Cell *cell, dict<RTLIL::IdString, RTLIL::SigSpec> &conn)
+	{
+		normalize_connections(cell->type, conn);
 
-		return std::hash<std::string>{}(hash_string);
+		Hasher h;
+		h.eat(cell->type);
+		h.eat(cell->parameters);
+		h.eat(conn);
+		return h.yield();
 	}
 
 	bool compare_cell_parameters_and_connections(const RTLIL::Cell *cell1, const RTLIL::Cell *cell2)
@@ -165,56 +133,157 @@ struct OptMergeWorker
 			if (!cell2->connections_.count(it.first))
 				return false;
 
-		decltype(Cell::connections_) conn1, conn2;
-		conn1.reserve(cell1->connections_.size());
-		conn2.reserve(cell1->connections_.size());
-
-		for (const auto &it : cell1->connections_) {
-			if (cell1->output(it.first)) {
-				if (it.first == ID::Q && RTLIL::builtin_ff_cell_types().count(cell1->type)) {
-					// For the 'Q' output of state elements,
-					//   use the (* init *) attribute value
-					conn1[it.first] = initvals(it.second);
-					conn2[it.first] = initvals(cell2->getPort(it.first));
-				}
-				else {
-					conn1[it.first] = RTLIL::SigSpec();
-					conn2[it.first] = RTLIL::SigSpec();
+		dict<RTLIL::IdString, RTLIL::SigSpec> conn1 = mapped_connections(cell1);
+		dict<RTLIL::IdString, RTLIL::SigSpec> conn2 = mapped_connections(cell2);
+		normalize_connections(cell1->type, conn1);
+		normalize_connections(cell1->type, conn2);
+
+		return conn1 == conn2;
+	}
+
+	// The cells that may be merged, in the order in which they are first looked at. A cell that has been looked
+	// at is kept in the bucket for its hash, so identical cells found later can be merged into it. When a merge
+	// changes what an input of a cell that was already looked at maps to, the cell is marked stale and looked at
+	// again; the others keep their place and their hash.
+	struct Candidate {
+		RTLIL::Cell *cell;
+		Hasher::hash_t hash = 0, bucket_hash = 0;
+		bool stale = true, in_bucket = false, removed = false;
+		bool pending = false, requeued = false;
+		Candidate(RTLIL::Cell *cell) : cell(cell) {}
+	};
+
+	std::vector<Candidate> candidates;
+	dict<Hasher::hash_t, std::vector<int>> buckets;
+	dict<RTLIL::SigBit, std::vector<int>> consumers;
+	std::vector<int> requeued;
+
+	// Computes the hashes of the given candidates. Mapping the connections is done here, while the rest runs in
+	// parallel. With `index_consumers`, the candidates are also added to `consumers`.
+	void update_hashes(const std::vector<int> &todo, bool index_consumers)
+	{
+		if (todo.empty())
+			return;
+
+		std::vector<dict<RTLIL::IdString, RTLIL::SigSpec>> conns(GetSize(todo));
+		for (int k = 0; k < GetSize(todo); k++) {
+			RTLIL::Cell *cell = candidates[todo[k]].cell;
+			conns[k] = mapped_connections(cell);
+			if (index_consumers)
+				for (auto &it : conns[k])
+					if (!cell->output(it.first))
+						for (auto bit : it.second)
+							if (bit.wire != nullptr)
+								consumers[bit].push_back(todo[k]);
+		}
+
+		int jobs = GetSize(todo) < 1024 ? 1 : std::min(GetSize(todo) / 256, 4 * Pass::parallel_threads(design));
+		Pass::parallel_for(design, jobs, [&](int job) {
+			for (int k = job; k < GetSize(todo); k += jobs)
+				candidates[todo[k]].hash = hash_cell(candidates[todo[k]].cell, conns[k]);
+		});
+
+		for (int i : todo)
+			candidates[i].stale = false;
+	}
+
+	void mark_stale(int i)
+	{
+		Candidate &c = candidates[i];
+		if (c.removed)
+			return;
+		c.stale = true;
+		if (!c.pending && !c.requeued) {
+			c.requeued = true;
+			requeued.push_back(i);
+		}
+	}
+
+	// Adds a connection to assign_map, and marks the candidates whose inputs now map to something else.
+	void add_connection(const RTLIL::SigSpec &from, const RTLIL::SigSpec &to)
+	{
+		std::vector<pair<RTLIL::SigBit, RTLIL::SigBit>> old_reps;
+		for (int k = 0; k < GetSize(from); k++)
+			old_reps.push_back(pair<RTLIL::SigBit, RTLIL::SigBit>(assign_map(from[k]), assign_map(to[k])));
+
+		assign_map.add(from, to);
+
+		for (int k = 0; k < GetSize(from); k++) {
+			RTLIL::SigBit new_rep = assign_map(to[k]);
+			for (auto old_rep : {old_reps[k].first, old_reps[k].second}) {
+				if (old_rep == new_rep || old_rep.wire == nullptr)
+					continue;
+				auto it = consumers.find(old_rep);
+				if (it == consumers.end())
+					continue;
+				std::vector<int> moved;
+				moved.swap(it->second);
+				consumers.erase(it);
+				for (int i : moved)
+					mark_stale(i);
+				if (new_rep.wire != nullptr) {
+					std::vector<int> &users = consumers[new_rep];
+					users.insert(users.end(), moved.begin(), moved.end());
 				}
 			}
-			else {
-				conn1[it.first] = assign_map(it.second);
-				conn2[it.first] = assign_map(cell2->getPort(it.first));
+		}
+	}
+
+	void merge(RTLIL::Cell *cell, RTLIL::Cell *other)
+	{
+		log_debug("  Cell `%s' is identical to cell `%s'.\n", cell->name.c_str(), other->name.c_str());
+		for (auto &it : cell->connections()) {
+			if (cell->output(it.first)) {
+				RTLIL::SigSpec other_sig = other->getPort(it.first);
+				log_debug("    Redirecting output %s: %s = %s\n", it.first.c_str(),
+						log_signal(it.second), log_signal(other_sig));
+				Const init = initvals(other_sig);
+				initvals.remove_init(it.second);
+				initvals.remove_init(other_sig);
+				module->connect(RTLIL::SigSig(it.second, other_sig));
+				add_connection(it.second, other_sig);
+				initvals.set_init(other_sig, init);
 			}
 		}
+		log_debug("    Removing %s cell `%s' from module `%s'.\n", cell->type.c_str(), cell->name.c_str(), module->name.c_str());
+		module->remove(cell);
+		total_count++;
+	}
+
+	// Looks for a cell identical to candidate `i` in its bucket. Of two identical cells, the one that comes first
+	// is kept, unless only the other one has the keep attribute; if both have it, neither is removed.
+	void insert_or_merge(int i)
+	{
+		Candidate &c = candidates[i];
+		std::vector<int> &bucket = buckets[c.hash];
 
-		if (cell1->type == ID($and) || cell1->type == ID($or) || cell1->type == ID($xor) || cell1->type == ID($xnor) || cell1->type == ID($add) || cell1->type == ID($mul) ||
-				cell1->type == ID($logic_and) || cell1->type == ID($logic_or) || cell1->type == ID($_AND_) || cell1->type == ID($_OR_) || cell1->type == ID($_XOR_)) {
-			if (conn1.at(ID::A) < conn1.at(ID::B)) {
-				RTLIL::SigSpec tmp = conn1[ID::A];
-				conn1[ID::A] = conn1[ID::B];
-				conn1[ID::B] = tmp;
+		for (int k = 0; k < GetSize(bucket); k++)
+		{
+			int j = bucket[k];
+			if (!compare_cell_parameters_and_connections(c.cell, candidates[j].cell))
+				continue;
+
+			int keep = std::min(i, j), drop = std::max(i, j);
+			if (candidates[drop].cell->has_keep_attr()) {
+				if (candidates[keep].cell->has_keep_attr())
+					return;
+				std::swap(keep, drop);
 			}
-			if (conn2.at(ID::A) < conn2.at(ID::B)) {
-				RTLIL::SigSpec tmp = conn2[ID::A];
-				conn2[ID::A] = conn2[ID::B];
-				conn2[ID::B] = tmp;
+
+			if (drop == j) {
+				bucket[k] = i;
+				c.in_bucket = true;
+				c.bucket_hash = c.hash;
+				candidates[j].in_bucket = false;
 			}
-		} else
-		if (cell1->type == ID($reduce_xor) || cell1->type == ID($reduce_xnor)) {
-			conn1[ID::A].sort();
-			conn2[ID::A].sort();
-		} else
-		if (cell1->type == ID($reduce_and) || cell1->type == ID($reduce_or) || cell1->type == ID($reduce_bool)) {
-			conn1[ID::A].sort_and_unify();
-			conn2[ID::A].sort_and_unify();
-		} else
-		if (cell1->type == ID($pmux)) {
-			sort_pmux_conn(conn1);
-			sort_pmux_conn(conn2);
+			candidates[drop].removed = true;
+			merge(candidates[drop].cell, candidates[keep].cell);
+			return;
 		}
 
-		return conn1 == conn2;
+		bucket.push_back(i);
+		c.in_bucket = true;
+		c.bucket_hash = c.hash;
 	}
 
 	bool has_dont_care_initval(const RTLIL::Cell *cell)
@@ -251,62 +320,61 @@ struct OptMergeWorker
 
 		initvals.set(&assign_map, module);
 
-		bool did_something = true;
-		while (did_something)
+		for (auto &it : module->cells_) {
+			RTLIL::Cell *cell = it.second;
+			if (!design->selected(module, cell))
+				continue;
+			if (mode_keepdc && has_dont_care_initval(cell))
+				continue;
+			if (!cell->known() || (!mode_share_all && !ct.cell_known(cell->type)))
+				continue;
+			if (cell->type == ID($scopeinfo))
+				continue;
+			candidates.push_back(Candidate(cell));
+		}
+
+		std::vector<int> queue;
+		for (int i = 0; i < GetSize(candidates); i++)
+			queue.push_back(i);
+		update_hashes(queue, true);
+
+		while (!queue.empty())
 		{
-			std::vector<RTLIL::Cell*> cells;
-			cells.reserve(module->cells_.size());
-			for (auto &it : module->cells_) {
-				if (!design->selected(module, it.second))
-					continue;
-				if (mode_keepdc && has_dont_care_initval(it.second))
-					continue;
-				if (ct.cell_known(it.second->type) || (mode_share_all && it.second->known()))
-					cells.push_back(it.second);
-			}
+			for (int i : queue)
+				candidates[i].pending = true;
 
-			did_something = false;
-                        dict<uint64_t, RTLIL::Cell*> sharemap;
-			for (auto cell : cells)
+			for (int i : queue)
 			{
-				if ((!mode_share_all && !ct.cell_known(cell->type)) || !cell->known())
+				Candidate &c = candidates[i];
+				c.pending = false;
+				if (c.removed)
 					continue;
 
-				if (cell->type == ID($scopeinfo))
-					continue;
+				if (c.stale) {
+					dict<RTLIL::IdString, RTLIL::SigSpec> conn = mapped_connections(c.cell);
+					c.hash = hash_cell(c.cell, conn);
+					c.stale = false;
+				}
 
-				uint64_t hash = hash_cell_parameters_and_connections(cell);
-				auto r = sharemap.insert(std::make_pair(hash, cell));
-				if (!r.second) {
-					if (compare_cell_parameters_and_connections(cell, r.first->second)) {
-						if (cell->has_keep_attr()) {
-							if (r.first->second->has_keep_attr())
-								continue;
-							std::swap(r.first->second, cell);
-						}
-
-
-						did_something = true;
-						log_debug("  Cell `%s' is identical to cell `%s'.\n", cell->name.c_str(), r.first->second->name.c_str());
-						for (auto &it : cell->connections()) {
-							if (cell->output(it.first)) {
-								RTLIL::SigSpec other_sig = r.first->second->getPort(it.first);
-								log_debug("    Redirecting output %s: %s = %s\n", it.first.c_str(),
-										log_signal(it.second), log_signal(other_sig));
-								Const init = initvals(other_sig);
-								initvals.remove_init(it.second);
-								initvals.remove_init(other_sig);
-								module->connect(RTLIL::SigSig(it.second, other_sig));
-								assign_map.add(it.second, other_sig);
-								initvals.set_init(other_sig, init);
-							}
-						}
-						log_debug("    Removing %s cell `%s' from module `%s'.\n", cell->type.c_str(), cell->name.c_str(), module->name.c_str());
-						module->remove(cell);
-						total_count++;
-					}
+				if (c.in_bucket) {
+					std::vector<int> &bucket = buckets.at(c.bucket_hash);
+					bucket.erase(std::find(bucket.begin(), bucket.end(), i));
+					c.in_bucket = false;
 				}
+
+				insert_or_merge(i);
 			}
+
+			queue.swap(requeued);
+			requeued.clear();
+			std::sort(queue.begin(), queue.end());
+			std::vector<int> stale;
+			for (int i : queue) {
+				candidates[i].requeued = false;
+				if (candidates[i].stale && !candidates[i].removed)
+					stale.push_back(i);
+			}
+			update_hashes(stale, false);
 		}
 
 		log_suppressed();
@@ -314,7 +382,7 @@ struct OptMergeWorker
 };
 
 struct OptMergePass : public Pass {
-	OptMergePass() : Pass("opt_merge", "consolidate identical cells") { }
+	OptMergePass() : Pass("opt_merge", "consolidate identical cells") { keeps_indexes(); selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -361,15 +429,22 @@ struct OptMergePass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
-		int total_count = 0;
-		for (auto module : design->selected_modules()) {
+		std::atomic<int> total_count(0);
+		std::string key = converged_key(args);
+		parallel_modules(design, design->selected_modules(), [&](RTLIL::Module *module) {
+			if (module->converged(key))
+				return;
 			OptMergeWorker worker(design, module, mode_nomux, mode_share_all, mode_keepdc);
 			total_count += worker.total_count;
-		}
+			if (worker.total_count == 0)
+				module->mark_converged(key);
+			else
+				module->mark_changed();
+		});
 
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
-		log("Removed a total of %d cells.\n", total_count);
+		log("Removed a total of %d cells.\n", total_count.load());
 	}
 } OptMergePass;
 
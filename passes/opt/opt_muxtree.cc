@@ -149,10 +149,13 @@ struct OptMuxtreeWorker
 
 		// Populate mux2info[].ports[]:
 		//	.input_muxes
-		for (int i = 0; i < GetSize(bit2info); i++)
-		for (int j : bit2info[i].mux_users)
-		for (auto &p : mux2info[j].ports) {
-			if (p.input_sigs.count(i))
+		// (in order of increasing input bit, so that the trees are traversed
+		// in the same order as when scanning all bits for each port)
+		for (auto &mi : mux2info)
+		for (auto &p : mi.ports) {
+			vector<int> input_sigs(p.input_sigs.begin(), p.input_sigs.end());
+			std::sort(input_sigs.begin(), input_sigs.end());
+			for (int i : input_sigs)
 				for (int k : bit2info[i].mux_drivers)
 					p.input_muxes.insert(k);
 		}
@@ -179,6 +182,15 @@ struct OptMuxtreeWorker
 			if (GetSize(it.second) > 1)
 				root_muxes.at(it.first) = true;
 
+		// Each tree is walked once per root, plus up to three levels into
+		// the trees of other roots, so the effort is roughly proportional to
+		// the number of muxes and the limit only has to catch pathological cases.
+		glob_abort_cnt = std::max(glob_abort_cnt, 32 * GetSize(mux2info));
+
+		knowledge.known_inactive.resize(GetSize(bit2info));
+		knowledge.known_active.resize(GetSize(bit2info));
+		knowledge.visited_muxes.resize(GetSize(mux2info));
+
 		for (int mux_idx = 0; mux_idx < GetSize(root_muxes); mux_idx++)
 			if (root_muxes.at(mux_idx)) {
 				log_debug("    Root of a mux tree: %s%s\n", log_id(mux2info[mux_idx].cell), root_enable_muxes.at(mux_idx) ? " (pure)" : "");
@@ -301,14 +313,37 @@ struct OptMuxtreeWorker
 		vector<bool> visited_muxes;
 	};
 
-	void eval_mux_port(knowledge_t &knowledge, int mux_idx, int port_idx, bool do_replace_known, bool do_enable_ports, int abort_count)
+	// shared by all root muxes: every entry is back to zero (or false) once
+	// the evaluation of a root mux has finished
+	knowledge_t knowledge;
+
+	// one mux (or one of its ports) on the path from the root mux that is
+	// currently being evaluated
+	struct eval_frame_t
 	{
-		if (glob_abort_cnt == 0)
-			return;
+		int mux_idx;
+		bool do_replace_known;
+		bool do_enable_ports;
+		int abort_count;
+
+		// the ports that could be active, and the next one to evaluate
+		vector<int> ports;
+		int next_port = 0;
+
+		// the port that is being evaluated, and its input muxes that are
+		// not already on the path
+		int port_idx = -1;
+		vector<int> parent_muxes;
+		int next_parent = 0;
+	};
 
-		muxinfo_t &muxinfo = mux2info[mux_idx];
+	vector<eval_frame_t> eval_stack;
 
-		if (do_enable_ports)
+	void enter_mux_port(eval_frame_t &frame, int port_idx)
+	{
+		muxinfo_t &muxinfo = mux2info[frame.mux_idx];
+
+		if (frame.do_enable_ports)
 			muxinfo.ports[port_idx].enabled = true;
 
 		for (int i = 0; i < GetSize(muxinfo.ports); i++) {
@@ -321,29 +356,23 @@ struct OptMuxtreeWorker
 		if (port_idx < GetSize(muxinfo.ports)-1 && !muxinfo.ports[port_idx].const_activated)
 			knowledge.known_active.at(muxinfo.ports[port_idx].ctrl_sig)++;
 
-		vector<int> parent_muxes;
+		frame.port_idx = port_idx;
+		frame.parent_muxes.clear();
+		frame.next_parent = 0;
 		for (int m : muxinfo.ports[port_idx].input_muxes) {
 			if (knowledge.visited_muxes[m])
 				continue;
 			knowledge.visited_muxes[m] = true;
-			parent_muxes.push_back(m);
+			frame.parent_muxes.push_back(m);
 		}
-		for (int m : parent_muxes) {
-			if (root_enable_muxes.at(m))
-				continue;
-			else if (root_muxes.at(m)) {
-				if (abort_count == 0) {
-					root_mux_rerun.insert(m);
-					root_enable_muxes.at(m) = true;
-					log_debug("      Removing pure flag from root mux %s.\n", log_id(mux2info[m].cell));
-				} else
-					eval_mux(knowledge, m, false, do_enable_ports, abort_count - 1);
-			} else
-				eval_mux(knowledge, m, do_replace_known, do_enable_ports, abort_count);
-			if (glob_abort_cnt == 0)
-				return;
-		}
-		for (int m : parent_muxes)
+	}
+
+	void leave_mux_port(eval_frame_t &frame)
+	{
+		muxinfo_t &muxinfo = mux2info[frame.mux_idx];
+		int port_idx = frame.port_idx;
+
+		for (int m : frame.parent_muxes)
 			knowledge.visited_muxes[m] = false;
 
 		if (port_idx < GetSize(muxinfo.ports)-1 && !muxinfo.ports[port_idx].const_activated)
@@ -355,6 +384,8 @@ struct OptMuxtreeWorker
 			if (muxinfo.ports[i].ctrl_sig >= 0)
 				knowledge.known_inactive.at(muxinfo.ports[i].ctrl_sig)--;
 		}
+
+		frame.port_idx = -1;
 	}
 
 	void replace_known(knowledge_t &knowledge, muxinfo_t &muxinfo, IdString portname)
@@ -403,10 +434,12 @@ struct OptMuxtreeWorker
 		}
 	}
 
-	void eval_mux(knowledge_t &knowledge, int mux_idx, bool do_replace_known, bool do_enable_ports, int abort_count)
+	// Pushes a frame for evaluating the given mux, or returns false if the
+	// iteration limit has been reached.
+	bool enter_mux(int mux_idx, bool do_replace_known, bool do_enable_ports, int abort_count)
 	{
 		if (glob_abort_cnt == 0)
-			return;
+			return false;
 		glob_abort_cnt--;
 
 		muxinfo_t &muxinfo = mux2info[mux_idx];
@@ -417,61 +450,116 @@ struct OptMuxtreeWorker
 			replace_known(knowledge, muxinfo, ID::B);
 		}
 
-		// if there is a constant activated port we just use it
+		if (glob_abort_cnt == 0)
+			return false;
+
+		eval_frame_t frame;
+		frame.mux_idx = mux_idx;
+		frame.do_replace_known = do_replace_known;
+		frame.do_enable_ports = do_enable_ports;
+		frame.abort_count = abort_count;
+
+		// the knowledge is the same whenever one of the ports is entered,
+		// so the ports to evaluate can be determined up front
 		for (int port_idx = 0; port_idx < GetSize(muxinfo.ports); port_idx++)
 		{
+			// if there is a constant activated port we just use it
 			portinfo_t &portinfo = muxinfo.ports[port_idx];
 			if (portinfo.const_activated) {
-				eval_mux_port(knowledge, mux_idx, port_idx, do_replace_known, do_enable_ports, abort_count);
-				return;
+				frame.ports.push_back(port_idx);
+				break;
 			}
 		}
 
 		// compare ports with known_active signals. if we find a match, only this
 		// port can be active. do not include the last port (its the default port
 		// that has no control signals).
-		for (int port_idx = 0; port_idx < GetSize(muxinfo.ports)-1; port_idx++)
+		for (int port_idx = 0; frame.ports.empty() && port_idx < GetSize(muxinfo.ports)-1; port_idx++)
 		{
 			portinfo_t &portinfo = muxinfo.ports[port_idx];
 			if (portinfo.const_deactivated)
 				continue;
-			if (knowledge.known_active.at(portinfo.ctrl_sig)) {
-				eval_mux_port(knowledge, mux_idx, port_idx, do_replace_known, do_enable_ports, abort_count);
-				return;
-			}
+			if (knowledge.known_active.at(portinfo.ctrl_sig))
+				frame.ports.push_back(port_idx);
 		}
 
 		// eval all ports that could be activated (control signal is not in
 		// known_inactive or const_deactivated).
-		for (int port_idx = 0; port_idx < GetSize(muxinfo.ports); port_idx++)
-		{
-			portinfo_t &portinfo = muxinfo.ports[port_idx];
-			if (portinfo.const_deactivated)
-				continue;
-			if (port_idx < GetSize(muxinfo.ports)-1)
-				if (knowledge.known_inactive.at(portinfo.ctrl_sig))
+		if (frame.ports.empty())
+			for (int port_idx = 0; port_idx < GetSize(muxinfo.ports); port_idx++)
+			{
+				portinfo_t &portinfo = muxinfo.ports[port_idx];
+				if (portinfo.const_deactivated)
 					continue;
-			eval_mux_port(knowledge, mux_idx, port_idx, do_replace_known, do_enable_ports, abort_count);
+				if (port_idx < GetSize(muxinfo.ports)-1)
+					if (knowledge.known_inactive.at(portinfo.ctrl_sig))
+						continue;
+				frame.ports.push_back(port_idx);
+			}
 
-			if (glob_abort_cnt == 0)
-				return;
-		}
+		eval_stack.push_back(std::move(frame));
+		return true;
 	}
 
+	// Walks the tree of a root mux with an explicit stack, since the trees
+	// (e.g. the priority mux chains of large case statements) can be much
+	// deeper than what the call stack would allow.
 	void eval_root_mux(int mux_idx)
 	{
 		log_assert(glob_abort_cnt > 0);
-		knowledge_t knowledge;
-		knowledge.known_inactive.resize(GetSize(bit2info));
-		knowledge.known_active.resize(GetSize(bit2info));
-		knowledge.visited_muxes.resize(GetSize(mux2info));
+		log_assert(eval_stack.empty());
 		knowledge.visited_muxes[mux_idx] = true;
-		eval_mux(knowledge, mux_idx, true, root_enable_muxes.at(mux_idx), 3);
+
+		if (!enter_mux(mux_idx, true, root_enable_muxes.at(mux_idx), 3)) {
+			eval_stack.clear();
+			return;
+		}
+
+		while (!eval_stack.empty())
+		{
+			eval_frame_t &frame = eval_stack.back();
+
+			if (frame.port_idx < 0) {
+				if (frame.next_port == GetSize(frame.ports)) {
+					eval_stack.pop_back();
+					continue;
+				}
+				enter_mux_port(frame, frame.ports[frame.next_port++]);
+				continue;
+			}
+
+			if (frame.next_parent == GetSize(frame.parent_muxes)) {
+				leave_mux_port(frame);
+				continue;
+			}
+
+			int m = frame.parent_muxes[frame.next_parent++];
+			bool ok = true;
+			if (root_enable_muxes.at(m))
+				continue;
+			else if (root_muxes.at(m)) {
+				if (frame.abort_count == 0) {
+					root_mux_rerun.insert(m);
+					root_enable_muxes.at(m) = true;
+					log_debug("      Removing pure flag from root mux %s.\n", log_id(mux2info[m].cell));
+				} else
+					ok = enter_mux(m, false, frame.do_enable_ports, frame.abort_count - 1);
+			} else
+				ok = enter_mux(m, frame.do_replace_known, frame.do_enable_ports, frame.abort_count);
+
+			if (!ok) {
+				// giving up, the knowledge is not used anymore
+				eval_stack.clear();
+				return;
+			}
+		}
+
+		knowledge.visited_muxes[mux_idx] = false;
 	}
 };
 
 struct OptMuxtreePass : public Pass {
-	OptMuxtreePass() : Pass("opt_muxtree", "eliminate dead trees in multiplexer trees") { }
+	OptMuxtreePass() : Pass("opt_muxtree", "eliminate dead trees in multiplexer trees") { keeps_indexes(); selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -491,11 +579,17 @@ struct OptMuxtreePass : public Pass {
 		extra_args(args, 1, design);
 
 		int total_count = 0;
+		std::string key = converged_key(args);
 		for (auto module : design->selected_whole_modules_warn()) {
-			if (module->has_processes_warn())
+			if (module->has_processes_warn() || module->converged(key))
 				continue;
+			ModuleScope scope(module);
 			OptMuxtreeWorker worker(design, module);
 			total_count += worker.removed_count;
+			if (worker.removed_count == 0)
+				module->mark_converged(key);
+			else
+				module->mark_changed();
 		}
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
@@ -37,7 +37,10 @@ struct OptReduceWorker
 	int total_count;
 	bool did_something;
 
-	void opt_reduce(pool<RTLIL::Cell*> &cells, SigSet<RTLIL::Cell*> &drivers, RTLIL::Cell *cell)
+	// drivers of the (mapped) output bits of all selected $reduce_or and $reduce_and cells
+	dict<RTLIL::SigBit, std::vector<RTLIL::Cell*>> reduce_drivers;
+
+	void opt_reduce(pool<RTLIL::Cell*> &cells, RTLIL::Cell *cell)
 	{
 		if (cells.count(cell) == 0)
 			return;
@@ -45,14 +48,14 @@ struct OptReduceWorker
 
 		RTLIL::SigSpec sig_a = assign_map(cell->getPort(ID::A));
 		sig_a.sort_and_unify();
-		pool<RTLIL::SigBit> new_sig_a_bits;
+		std::vector<RTLIL::SigBit> new_sig_a_bits;
 
 		for (auto &bit : sig_a)
 		{
 			if (bit == RTLIL::State::S0) {
 				if (cell->type == ID($reduce_and)) {
 					new_sig_a_bits.clear();
-					new_sig_a_bits.insert(RTLIL::State::S0);
+					new_sig_a_bits.push_back(RTLIL::State::S0);
 					break;
 				}
 				continue;
@@ -60,34 +63,38 @@ struct OptReduceWorker
 			if (bit == RTLIL::State::S1) {
 				if (cell->type == ID($reduce_or)) {
 					new_sig_a_bits.clear();
-					new_sig_a_bits.insert(RTLIL::State::S1);
+					new_sig_a_bits.push_back(RTLIL::State::S1);
 					break;
 				}
 				continue;
 			}
 			if (bit.wire == NULL) {
-				new_sig_a_bits.insert(bit);
+				new_sig_a_bits.push_back(bit);
 				continue;
 			}
 
 			bool imported_children = false;
-			for (auto child_cell : drivers.find(bit)) {
-				if (child_cell->type == cell->type) {
-					opt_reduce(cells, drivers, child_cell);
+			auto it = reduce_drivers.find(bit);
+			if (it != reduce_drivers.end()) {
+				for (auto child_cell : it->second) {
+					if (child_cell->type != cell->type)
+						continue;
+					opt_reduce(cells, child_cell);
 					if (child_cell->getPort(ID::Y)[0] == bit) {
-						pool<RTLIL::SigBit> child_sig_a_bits = assign_map(child_cell->getPort(ID::A)).to_sigbit_pool();
-						new_sig_a_bits.insert(child_sig_a_bits.begin(), child_sig_a_bits.end());
+						for (auto child_bit : assign_map(child_cell->getPort(ID::A)))
+							new_sig_a_bits.push_back(child_bit);
 					} else
-						new_sig_a_bits.insert(RTLIL::State::S0);
+						new_sig_a_bits.push_back(RTLIL::State::S0);
 					imported_children = true;
 				}
 			}
 			if (!imported_children)
-				new_sig_a_bits.insert(bit);
+				new_sig_a_bits.push_back(bit);
 		}
 
+		std::sort(new_sig_a_bits.begin(), new_sig_a_bits.end());
+		new_sig_a_bits.erase(std::unique(new_sig_a_bits.begin(), new_sig_a_bits.end()), new_sig_a_bits.end());
 		RTLIL::SigSpec new_sig_a(new_sig_a_bits);
-		new_sig_a.sort_and_unify();
 
 		if (GetSize(new_sig_a) == 0)
 			new_sig_a = (cell->type == ID($reduce_or)) ? State::S0 : State::S1;
@@ -110,21 +117,31 @@ struct OptReduceWorker
 		RTLIL::SigSpec sig_s = assign_map(cell->getPort(ID::S));
 
 		RTLIL::SigSpec new_sig_b, new_sig_s;
-		pool<RTLIL::SigSpec> handled_sig;
 
-		handled_sig.insert(sig_a);
-		for (int i = 0; i < sig_s.size(); i++)
+		// group the cases by their B input, in the order of their first occurrence
+		int width = sig_a.size();
+		std::vector<RTLIL::SigBit> bits_b = sig_b.to_sigbit_vector();
+		std::vector<RTLIL::SigBit> bits_s = sig_s.to_sigbit_vector();
+		dict<RTLIL::SigSpec, int> case_groups;
+		std::vector<std::pair<RTLIL::SigSpec, std::vector<RTLIL::SigBit>>> groups;
+
+		for (int i = 0; i < GetSize(bits_s); i++)
 		{
-			RTLIL::SigSpec this_b = sig_b.extract(i*sig_a.size(), sig_a.size());
-			if (handled_sig.count(this_b) > 0)
+			RTLIL::SigSpec this_b(std::vector<RTLIL::SigBit>(bits_b.begin() + i*width, bits_b.begin() + (i+1)*width));
+			if (this_b == sig_a)
 				continue;
+			auto it = case_groups.find(this_b);
+			if (it == case_groups.end()) {
+				case_groups[this_b] = GetSize(groups);
+				groups.emplace_back(this_b, std::vector<RTLIL::SigBit>{bits_s[i]});
+			} else
+				groups[it->second].second.push_back(bits_s[i]);
+		}
 
-			RTLIL::SigSpec this_s = sig_s.extract(i, 1);
-			for (int j = i+1; j < sig_s.size(); j++) {
-				RTLIL::SigSpec that_b = sig_b.extract(j*sig_a.size(), sig_a.size());
-				if (this_b == that_b)
-					this_s.append(sig_s.extract(j, 1));
-			}
+		for (auto &group : groups)
+		{
+			RTLIL::SigSpec &this_b = group.first;
+			RTLIL::SigSpec this_s(group.second);
 
 			if (this_s.size() > 1)
 			{
@@ -141,7 +158,6 @@ struct OptReduceWorker
 
 			new_sig_b.append(this_b);
 			new_sig_s.append(this_s);
-			handled_sig.insert(this_b);
 		}
 
 		if (new_sig_s.size() == 0)
@@ -336,40 +352,40 @@ struct OptReduceWorker
 
 	bool opt_mux_bits(RTLIL::Cell *cell)
 	{
-		SigSpec sig_a = assign_map(cell->getPort(ID::A));
-		SigSpec sig_b;
-		SigSpec sig_y = assign_map(cell->getPort(ID::Y));
+		std::vector<SigBit> sig_a = assign_map(cell->getPort(ID::A)).to_sigbit_vector();
+		std::vector<SigBit> sig_b;
+		std::vector<SigBit> sig_y = assign_map(cell->getPort(ID::Y)).to_sigbit_vector();
 		int width = GetSize(sig_y);
 
 		if (cell->type != ID($bmux))
-			sig_b = assign_map(cell->getPort(ID::B));
+			sig_b = assign_map(cell->getPort(ID::B)).to_sigbit_vector();
 
-		RTLIL::SigSig old_sig_conn;
+		std::vector<SigBit> old_sig_conn_lhs, old_sig_conn_rhs;
 
-		dict<SigSpec, SigBit> consolidated_in_tuples;
+		dict<std::vector<SigBit>, SigBit> consolidated_in_tuples;
 		std::vector<int> swizzle;
+		std::vector<SigBit> in_tuple;
 
 		for (int i = 0; i < width; i++)
 		{
-			SigSpec in_tuple;
 			bool all_tuple_bits_same = true;
 
-			in_tuple.append(sig_a[i]);
+			in_tuple.clear();
 			for (int j = i; j < GetSize(sig_a); j += width) {
-				in_tuple.append(sig_a[j]);
-				if (sig_a[j] != in_tuple[0])
+				in_tuple.push_back(sig_a[j]);
+				if (sig_a[j] != sig_a[i])
 					all_tuple_bits_same = false;
 			}
 			for (int j = i; j < GetSize(sig_b); j += width) {
-				in_tuple.append(sig_b[j]);
-				if (sig_b[j] != in_tuple[0])
+				in_tuple.push_back(sig_b[j]);
+				if (sig_b[j] != sig_a[i])
 					all_tuple_bits_same = false;
 			}
 
 			if (all_tuple_bits_same)
 			{
-				old_sig_conn.first.append(sig_y[i]);
-				old_sig_conn.second.append(sig_a[i]);
+				old_sig_conn_lhs.push_back(sig_y[i]);
+				old_sig_conn_rhs.push_back(sig_a[i]);
 				continue;
 			}
 
@@ -381,8 +397,8 @@ struct OptReduceWorker
 			}
 			else
 			{
-				old_sig_conn.first.append(sig_y[i]);
-				old_sig_conn.second.append(it->second);
+				old_sig_conn_lhs.push_back(sig_y[i]);
+				old_sig_conn_rhs.push_back(it->second);
 			}
 		}
 
@@ -400,23 +416,23 @@ struct OptReduceWorker
 			if (swizzle.empty()) {
 				module->remove(cell);
 			} else {
-				SigSpec new_sig_a;
+				std::vector<SigBit> new_sig_a;
 				for (int i = 0; i < GetSize(sig_a); i += width)
 					for (int j: swizzle)
-						new_sig_a.append(sig_a[i+j]);
+						new_sig_a.push_back(sig_a[i+j]);
 				cell->setPort(ID::A, new_sig_a);
 
 				if (cell->type != ID($bmux)) {
-					SigSpec new_sig_b;
+					std::vector<SigBit> new_sig_b;
 					for (int i = 0; i < GetSize(sig_b); i += width)
 						for (int j: swizzle)
-							new_sig_b.append(sig_b[i+j]);
+							new_sig_b.push_back(sig_b[i+j]);
 					cell->setPort(ID::B, new_sig_b);
 				}
 
-				SigSpec new_sig_y;
+				std::vector<SigBit> new_sig_y;
 				for (int j: swizzle)
-					new_sig_y.append(sig_y[j]);
+					new_sig_y.push_back(sig_y[j]);
 				cell->setPort(ID::Y, new_sig_y);
 
 				cell->parameters[ID::WIDTH] = RTLIL::Const(GetSize(swizzle));
@@ -430,6 +446,7 @@ struct OptReduceWorker
 				}
 			}
 
+			RTLIL::SigSig old_sig_conn(old_sig_conn_lhs, old_sig_conn_rhs);
 			log("      New connections: %s = %s\n", log_signal(old_sig_conn.first), log_signal(old_sig_conn.second));
 			module->connect(old_sig_conn);
 
@@ -440,11 +457,11 @@ struct OptReduceWorker
 	}
 
 	bool opt_demux_bits(RTLIL::Cell *cell) {
-		SigSpec sig_a = assign_map(cell->getPort(ID::A));
-		SigSpec sig_y = assign_map(cell->getPort(ID::Y));
+		std::vector<SigBit> sig_a = assign_map(cell->getPort(ID::A)).to_sigbit_vector();
+		std::vector<SigBit> sig_y = assign_map(cell->getPort(ID::Y)).to_sigbit_vector();
 		int width = GetSize(sig_a);
 
-		RTLIL::SigSig old_sig_conn;
+		std::vector<SigBit> old_sig_conn_lhs, old_sig_conn_rhs;
 
 		dict<SigBit, int> handled_bits;
 		std::vector<int> swizzle;
@@ -455,8 +472,8 @@ struct OptReduceWorker
 			{
 				for (int j = i; j < GetSize(sig_y); j += width)
 				{
-					old_sig_conn.first.append(sig_y[j]);
-					old_sig_conn.second.append(State::S0);
+					old_sig_conn_lhs.push_back(sig_y[j]);
+					old_sig_conn_rhs.push_back(State::S0);
 				}
 				continue;
 			}
@@ -471,8 +488,8 @@ struct OptReduceWorker
 			{
 				for (int j = 0; j < GetSize(sig_y); j += width)
 				{
-					old_sig_conn.first.append(sig_y[i+j]);
-					old_sig_conn.second.append(sig_y[it->second+j]);
+					old_sig_conn_lhs.push_back(sig_y[i+j]);
+					old_sig_conn_rhs.push_back(sig_y[it->second+j]);
 				}
 			}
 		}
@@ -486,15 +503,15 @@ struct OptReduceWorker
 			if (swizzle.empty()) {
 				module->remove(cell);
 			} else {
-				SigSpec new_sig_a;
+				std::vector<SigBit> new_sig_a;
 				for (int j: swizzle)
-					new_sig_a.append(sig_a[j]);
+					new_sig_a.push_back(sig_a[j]);
 				cell->setPort(ID::A, new_sig_a);
 
-				SigSpec new_sig_y;
+				std::vector<SigBit> new_sig_y;
 				for (int i = 0; i < GetSize(sig_y); i += width)
 					for (int j: swizzle)
-						new_sig_y.append(sig_y[i+j]);
+						new_sig_y.push_back(sig_y[i+j]);
 				cell->setPort(ID::Y, new_sig_y);
 
 				cell->parameters[ID::WIDTH] = RTLIL::Const(GetSize(swizzle));
@@ -503,6 +520,7 @@ struct OptReduceWorker
 						log_signal(cell->getPort(ID::Y)));
 			}
 
+			RTLIL::SigSig old_sig_conn(old_sig_conn_lhs, old_sig_conn_rhs);
 			log("      New connections: %s = %s\n", log_signal(old_sig_conn.first), log_signal(old_sig_conn.second));
 			module->connect(old_sig_conn);
 
@@ -553,36 +571,46 @@ struct OptReduceWorker
 		{
 			did_something = false;
 
-			// merge trees of reduce_* cells to one single cell and unify input vectors
-			// (only handle reduce_and and reduce_or for various reasons)
+			// collect all reduce_* and mux-like cells in one sweep over the module, the
+			// former change only their inputs and the latter are handled after them
 
-			const IdString type_list[] = { ID($reduce_or), ID($reduce_and) };
-			for (auto type : type_list)
-			{
-				SigSet<RTLIL::Cell*> drivers;
-				pool<RTLIL::Cell*> cells;
+			pool<RTLIL::Cell*> reduce_or_cells, reduce_and_cells;
+			std::vector<RTLIL::Cell*> mux_cells;
+			reduce_drivers.clear();
 
-				for (auto &cell_it : module->cells_) {
-					RTLIL::Cell *cell = cell_it.second;
-					if (cell->type != type || !design->selected(module, cell))
-						continue;
-					drivers.insert(assign_map(cell->getPort(ID::Y)), cell);
-					cells.insert(cell);
+			for (auto cell : module->selected_cells())
+			{
+				if (cell->type.in(ID($mux), ID($pmux), ID($bmux), ID($demux))) {
+					mux_cells.push_back(cell);
+					continue;
 				}
+				if (cell->type == ID($reduce_or))
+					reduce_or_cells.insert(cell);
+				else if (cell->type == ID($reduce_and))
+					reduce_and_cells.insert(cell);
+				else
+					continue;
+				for (auto bit : assign_map(cell->getPort(ID::Y)))
+					if (bit.wire != nullptr) {
+						auto &bit_drivers = reduce_drivers[bit];
+						if (bit_drivers.empty() || bit_drivers.back() != cell)
+							bit_drivers.push_back(cell);
+					}
+			}
 
-				while (cells.size() > 0) {
-					RTLIL::Cell *cell = *cells.begin();
-					opt_reduce(cells, drivers, cell);
+			// merge trees of reduce_* cells to one single cell and unify input vectors
+			// (only handle reduce_and and reduce_or for various reasons)
+
+			for (auto cells : { &reduce_or_cells, &reduce_and_cells })
+				while (cells->size() > 0) {
+					RTLIL::Cell *cell = *cells->begin();
+					opt_reduce(*cells, cell);
 				}
-			}
 
 			// merge identical inputs on $mux and $pmux cells
 
-			for (auto cell : module->selected_cells())
+			for (auto cell : mux_cells)
 			{
-				if (!cell->type.in(ID($mux), ID($pmux), ID($bmux), ID($demux)))
-					continue;
-
 				// this optimization is to aggressive for most coarse-grain applications.
 				// but we always want it for multiplexers driving write enable ports.
 				if (do_fine || mem_wren_sigs.check_any(assign_map(cell->getPort(ID::Y)))) {
@@ -609,7 +637,7 @@ struct OptReduceWorker
 };
 
 struct OptReducePass : public Pass {
-	OptReducePass() : Pass("opt_reduce", "simplify large MUXes and AND/OR gates") { }
+	OptReducePass() : Pass("opt_reduce", "simplify large MUXes and AND/OR gates") { keeps_indexes(); selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -652,13 +680,24 @@ struct OptReducePass : public Pass {
 		extra_args(args, argidx, design);
 
 		int total_count = 0;
-		for (auto module : design->selected_modules())
+		std::string key = converged_key(args);
+		for (auto module : design->selected_modules()) {
+			if (module->converged(key))
+				continue;
+			ModuleScope scope(module);
+			int module_count = 0;
 			while (1) {
 				OptReduceWorker worker(design, module, do_fine);
-				total_count += worker.total_count;
+				module_count += worker.total_count;
 				if (worker.total_count == 0)
 					break;
 			}
+			if (module_count == 0)
+				module->mark_converged(key);
+			else
+				module->mark_changed();
+			total_count += module_count;
+		}
 
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
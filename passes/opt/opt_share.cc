@@ -336,7 +336,7 @@ ExtSigSpec find_shared_operand(const OpMuxConn* seed, std::vector<const OpMuxCon
 }
 
 struct OptSharePass : public Pass {
-	OptSharePass() : Pass("opt_share", "merge mutually exclusive cells of the same type that share an input signal") {}
+	OptSharePass() : Pass("opt_share", "merge mutually exclusive cells of the same type that share an input signal") { keeps_indexes(); selection_safe(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -358,7 +358,11 @@ struct OptSharePass : public Pass {
 		log_header(design, "Executing OPT_SHARE pass.\n");
 
 		extra_args(args, 1, design);
+		std::string key = converged_key(args);
 		for (auto module : design->selected_modules()) {
+			if (module->converged(key))
+				continue;
+
 			SigMap sigmap(module);
 
 			dict<RTLIL::SigBit, int> bit_users;
@@ -405,8 +409,10 @@ struct OptSharePass : public Pass {
 				}
 			}
 
-			if (!any_shared_operands)
+			if (!any_shared_operands) {
+				module->mark_converged(key);
 				continue;
+			}
 
 			// Operator outputs need to be exclusively connected to the $mux inputs in order to be mergeable. Hence we count to
 			// how many points are operator output bits connected.
@@ -567,6 +573,11 @@ struct OptSharePass : public Pass {
 
 				merge_operators(module, shared.mux, shared.ports, shared.shared_operand, sigmap);
 			}
+
+			if (merged_ops.empty())
+				module->mark_converged(key);
+			else
+				module->mark_changed();
 		}
 	}
 
@@ -1072,7 +1072,7 @@ struct ShareWorker
 		ct.setup_internals();
 		ct.setup_stdcells();
 
-		ModIndex mi(module);
+		ModIndex &mi = ModIndex::cached(module);
 
 		pool<RTLIL::Cell*> queue, covered;
 		queue.insert(cell);
@@ -1108,6 +1108,298 @@ struct ShareWorker
 	}
 
 
+	// ---------------------------------------------------------------------
+	// Simulating the control logic with random inputs, as a pre-filter for SAT
+	// ---------------------------------------------------------------------
+
+	// Every control bit is simulated for 64 random assignments of the inputs of its cone at once, one assignment per
+	// bit of a word. The simulation models exactly the cells that QuickConeSat imports (at its default effort level),
+	// so an assignment that activates both cells of a pair is also a model of the SAT problem for that pair. Bits
+	// that depend on logic that is not simulated have no value, and pairs with such control bits go to the SAT solver.
+
+	dict<RTLIL::SigBit, uint64_t> sim_values;
+	pool<RTLIL::SigBit> sim_unknown;
+	uint64_t sim_rng;
+
+	uint64_t sim_random()
+	{
+		sim_rng ^= sim_rng << 13;
+		sim_rng ^= sim_rng >> 7;
+		sim_rng ^= sim_rng << 17;
+		return sim_rng;
+	}
+
+	static bool sim_cell_supported(RTLIL::Cell *cell)
+	{
+		return cell->type.in(ID($not), ID($pos), ID($buf), ID($and), ID($or), ID($xor), ID($xnor),
+				ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool),
+				ID($logic_not), ID($logic_and), ID($logic_or), ID($eq), ID($ne), ID($eqx), ID($nex),
+				ID($mux), ID($pmux), ID($_BUF_), ID($_NOT_), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_),
+				ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_NMUX_));
+	}
+
+	// Returns the cell that has to be simulated to find the value of `bit`, or nullptr if the value is already known
+	// (which includes free inputs, which get a random value here).
+	RTLIL::Cell *sim_driver(const RTLIL::SigBit &bit)
+	{
+		if (bit.wire == nullptr || sim_values.count(bit) || sim_unknown.count(bit))
+			return nullptr;
+
+		if (bit.wire->get_bool_attribute(ID::onehot)) {
+			sim_unknown.insert(bit);
+			return nullptr;
+		}
+
+		RTLIL::Cell *driver = nullptr;
+		auto it = modwalker.signal_drivers.find(bit);
+		if (it != modwalker.signal_drivers.end())
+			for (auto &pbit : it->second) {
+				if (QuickConeSat::cell_complexity(pbit.cell) > 2)
+					continue;
+				if ((driver != nullptr && driver != pbit.cell) || !sim_cell_supported(pbit.cell)) {
+					sim_unknown.insert(bit);
+					return nullptr;
+				}
+				driver = pbit.cell;
+			}
+
+		if (driver == nullptr)
+			sim_values[bit] = sim_random();
+		return driver;
+	}
+
+	bool sim_sig(const RTLIL::SigSpec &sig, std::vector<uint64_t> &words)
+	{
+		words.clear();
+		for (auto bit : modwalker.sigmap(sig)) {
+			if (bit.wire == nullptr) {
+				words.push_back(bit == RTLIL::State::S1 ? ~uint64_t(0) : 0);
+				continue;
+			}
+			auto it = sim_values.find(bit);
+			if (it == sim_values.end())
+				return false;
+			words.push_back(it->second);
+		}
+		return true;
+	}
+
+	static void sim_extend(std::vector<uint64_t> &words, size_t width, bool is_signed)
+	{
+		while (words.size() < width)
+			words.push_back(is_signed && !words.empty() ? words.back() : 0);
+	}
+
+	static uint64_t sim_reduce_or(const std::vector<uint64_t> &words)
+	{
+		uint64_t result = 0;
+		for (auto w : words)
+			result |= w;
+		return result;
+	}
+
+	// Computes the outputs of a cell from the values of its inputs, following the semantics of SatGen without
+	// undef modeling. Returns false if one of the inputs has no value.
+	bool sim_cell(RTLIL::Cell *cell, std::vector<uint64_t> &y)
+	{
+		std::vector<uint64_t> a, b, s;
+		bool is_signed = cell->hasParam(ID::A_SIGNED) && cell->hasParam(ID::B_SIGNED) &&
+				cell->getParam(ID::A_SIGNED).as_bool() && cell->getParam(ID::B_SIGNED).as_bool();
+		size_t y_width = GetSize(cell->getPort(ID::Y));
+
+		if (!sim_sig(cell->getPort(ID::A), a))
+			return false;
+		if (cell->hasPort(ID::B) && !sim_sig(cell->getPort(ID::B), b))
+			return false;
+		if (cell->hasPort(ID::S) && !sim_sig(cell->getPort(ID::S), s))
+			return false;
+
+		y.clear();
+
+		if (cell->type.in(ID($not), ID($pos), ID($buf), ID($_NOT_), ID($_BUF_))) {
+			sim_extend(a, y_width, cell->hasParam(ID::A_SIGNED) && cell->getParam(ID::A_SIGNED).as_bool());
+			for (size_t i = 0; i < y_width; i++)
+				y.push_back(cell->type.in(ID($not), ID($_NOT_)) ? ~a[i] : a[i]);
+			return true;
+		}
+
+		if (cell->type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_),
+				ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_))) {
+			size_t width = std::max(std::max(a.size(), b.size()), y_width);
+			sim_extend(a, width, is_signed);
+			sim_extend(b, width, is_signed);
+			for (size_t i = 0; i < y_width; i++) {
+				if (cell->type.in(ID($and), ID($_AND_)))
+					y.push_back(a[i] & b[i]);
+				else if (cell->type == ID($_NAND_))
+					y.push_back(~(a[i] & b[i]));
+				else if (cell->type.in(ID($or), ID($_OR_)))
+					y.push_back(a[i] | b[i]);
+				else if (cell->type == ID($_NOR_))
+					y.push_back(~(a[i] | b[i]));
+				else if (cell->type.in(ID($xor), ID($_XOR_)))
+					y.push_back(a[i] ^ b[i]);
+				else if (cell->type.in(ID($xnor), ID($_XNOR_)))
+					y.push_back(~(a[i] ^ b[i]));
+				else if (cell->type == ID($_ANDNOT_))
+					y.push_back(a[i] & ~b[i]);
+				else
+					y.push_back(a[i] | ~b[i]);
+			}
+			return true;
+		}
+
+		if (cell->type.in(ID($mux), ID($_MUX_), ID($_NMUX_))) {
+			for (size_t i = 0; i < y_width; i++) {
+				uint64_t v = (s[0] & b[i]) | (~s[0] & a[i]);
+				y.push_back(cell->type == ID($_NMUX_) ? ~v : v);
+			}
+			return true;
+		}
+
+		if (cell->type == ID($pmux)) {
+			y = a;
+			for (size_t i = 0; i < s.size(); i++)
+				for (size_t j = 0; j < y_width; j++)
+					y[j] = (s[i] & b[i*y_width + j]) | (~s[i] & y[j]);
+			return true;
+		}
+
+		uint64_t result;
+		if (cell->type == ID($reduce_and)) {
+			result = ~uint64_t(0);
+			for (auto w : a)
+				result &= w;
+		} else if (cell->type.in(ID($reduce_or), ID($reduce_bool))) {
+			result = sim_reduce_or(a);
+		} else if (cell->type.in(ID($reduce_xor), ID($reduce_xnor))) {
+			result = 0;
+			for (auto w : a)
+				result ^= w;
+			if (cell->type == ID($reduce_xnor))
+				result = ~result;
+		} else if (cell->type == ID($logic_not)) {
+			result = ~sim_reduce_or(a);
+		} else if (cell->type == ID($logic_and)) {
+			result = sim_reduce_or(a) & sim_reduce_or(b);
+		} else if (cell->type == ID($logic_or)) {
+			result = sim_reduce_or(a) | sim_reduce_or(b);
+		} else {
+			log_assert(cell->type.in(ID($eq), ID($ne), ID($eqx), ID($nex)));
+			size_t width = std::max(a.size(), b.size());
+			sim_extend(a, width, is_signed);
+			sim_extend(b, width, is_signed);
+			uint64_t diff = 0;
+			for (size_t i = 0; i < width; i++)
+				diff |= a[i] ^ b[i];
+			result = cell->type.in(ID($eq), ID($eqx)) ? ~diff : diff;
+		}
+
+		y.push_back(result);
+		while (y.size() < y_width)
+			y.push_back(0);
+		return true;
+	}
+
+	// Simulates the input cone of `bit`. Returns false if the value of the bit is unknown.
+	bool sim_bit(RTLIL::SigBit bit, uint64_t &value)
+	{
+		bit = modwalker.sigmap(bit);
+		if (bit.wire == nullptr) {
+			value = bit == RTLIL::State::S1 ? ~uint64_t(0) : 0;
+			return true;
+		}
+
+		std::vector<RTLIL::Cell*> stack;
+		pool<RTLIL::Cell*> on_stack;
+		std::vector<uint64_t> y;
+
+		if (RTLIL::Cell *driver = sim_driver(bit)) {
+			stack.push_back(driver);
+			on_stack.insert(driver);
+		}
+
+		while (!stack.empty())
+		{
+			RTLIL::Cell *cell = stack.back();
+			bool ready = true;
+
+			for (auto &in_bit : modwalker.cell_inputs[cell]) {
+				RTLIL::Cell *driver = sim_driver(in_bit);
+				if (driver == nullptr)
+					continue;
+				if (on_stack.count(driver)) {
+					// A logic loop; SAT has no trouble with it, but the simulation would.
+					sim_unknown.insert(in_bit);
+					continue;
+				}
+				stack.push_back(driver);
+				on_stack.insert(driver);
+				ready = false;
+				break;
+			}
+
+			if (!ready)
+				continue;
+
+			stack.pop_back();
+			on_stack.erase(cell);
+
+			RTLIL::SigSpec sig_y = modwalker.sigmap(cell->getPort(ID::Y));
+			bool known = sim_cell(cell, y);
+			for (int i = 0; i < GetSize(sig_y); i++) {
+				if (sig_y[i].wire == nullptr || sim_unknown.count(sig_y[i]))
+					continue;
+				if (known)
+					sim_values[sig_y[i]] = y[i];
+				else
+					sim_unknown.insert(sig_y[i]);
+			}
+		}
+
+		auto it = sim_values.find(bit);
+		if (it == sim_values.end())
+			return false;
+		value = it->second;
+		return true;
+	}
+
+	// Returns a word with one bit set for each simulated assignment under which one of the activation patterns
+	// matches, or false if that can not be determined.
+	bool sim_activation(const pool<ssc_pair_t> &activation_patterns, uint64_t &active)
+	{
+		active = 0;
+		for (auto &p : activation_patterns) {
+			uint64_t match = ~uint64_t(0);
+			for (int i = 0; i < GetSize(p.first); i++) {
+				uint64_t value;
+				if (!sim_bit(p.first[i], value))
+					return false;
+				match &= p.second[i] == RTLIL::State::S1 ? value : ~value;
+			}
+			active |= match;
+		}
+		return true;
+	}
+
+	// Activation patterns of pairs of cells that have been found to be exclusive (true) or not (false). The SAT
+	// problem only depends on the patterns, since the ModWalker is not updated while cells are shared, and many
+	// cells tend to be active under the same conditions (e.g. those in the same branch of a case statement).
+	typedef std::pair<std::vector<ssc_pair_t>, std::vector<ssc_pair_t>> exclusive_key_t;
+	std::map<exclusive_key_t, bool> exclusive_cache;
+
+	static exclusive_key_t exclusive_key(const pool<ssc_pair_t> &patterns1, const pool<ssc_pair_t> &patterns2)
+	{
+		exclusive_key_t key(std::vector<ssc_pair_t>(patterns1.begin(), patterns1.end()),
+				std::vector<ssc_pair_t>(patterns2.begin(), patterns2.end()));
+		std::sort(key.first.begin(), key.first.end());
+		std::sort(key.second.begin(), key.second.end());
+		if (key.second < key.first)
+			std::swap(key.first, key.second);
+		return key;
+	}
+
+
 	// -------------
 	// Setup and run
 	// -------------
@@ -1161,6 +1453,10 @@ struct ShareWorker
 		shareable_cells.clear();
 		forbidden_controls_cache.clear();
 		activation_patterns_cache.clear();
+		sim_values.clear();
+		sim_unknown.clear();
+		sim_rng = 88172645463325252ull;
+		exclusive_cache.clear();
 
 		find_terminal_bits();
 		find_shareable_cells();
@@ -1249,67 +1545,106 @@ struct ShareWorker
 				optimize_activation_patterns(filtered_cell_activation_patterns);
 				optimize_activation_patterns(filtered_other_cell_activation_patterns);
 
-				QuickConeSat qcsat(modwalker);
-				if (config.opt_fast) {
-					qcsat.max_cell_outs = 3;
-					qcsat.max_cell_count = 100;
-				}
-
-				std::set<RTLIL::SigBit> bits_queue;
-
-				std::vector<int> cell_active, other_cell_active;
 				RTLIL::SigSpec all_ctrl_signals;
 
 				for (auto &p : filtered_cell_activation_patterns) {
 					log("      Activation pattern for cell %s: %s = %s\n", log_id(cell), log_signal(p.first), log_signal(p.second));
-					cell_active.push_back(qcsat.ez->vec_eq(qcsat.importSig(p.first), qcsat.importSig(p.second)));
 					all_ctrl_signals.append(p.first);
 				}
 
 				for (auto &p : filtered_other_cell_activation_patterns) {
 					log("      Activation pattern for cell %s: %s = %s\n", log_id(other_cell), log_signal(p.first), log_signal(p.second));
-					other_cell_active.push_back(qcsat.ez->vec_eq(qcsat.importSig(p.first), qcsat.importSig(p.second)));
 					all_ctrl_signals.append(p.first);
 				}
 
-				qcsat.prepare();
-
-				int sub1 = qcsat.ez->expression(qcsat.ez->OpOr, cell_active);
-				if (!qcsat.ez->solve(sub1)) {
-					log("      According to the SAT solver the cell %s is never active. Sharing is pointless, we simply remove it.\n", log_id(cell));
-					cells_to_remove.insert(cell);
-					break;
-				}
-
-				int sub2 = qcsat.ez->expression(qcsat.ez->OpOr, other_cell_active);
-				if (!qcsat.ez->solve(sub2)) {
-					log("      According to the SAT solver the cell %s is never active. Sharing is pointless, we simply remove it.\n", log_id(other_cell));
-					cells_to_remove.insert(other_cell);
-					shareable_cells.erase(other_cell);
-					continue;
-				}
-
-				qcsat.ez->non_incremental();
-
 				all_ctrl_signals.sort_and_unify();
-				std::vector<int> sat_model = qcsat.importSig(all_ctrl_signals);
-				std::vector<bool> sat_model_values;
-
-				qcsat.ez->assume(qcsat.ez->AND(sub1, sub2));
 
-				log("      Size of SAT problem: %d variables, %d clauses\n",
-						qcsat.ez->numCnfVariables(), qcsat.ez->numCnfClauses());
+				exclusive_key_t key = exclusive_key(filtered_cell_activation_patterns, filtered_other_cell_activation_patterns);
+				uint64_t sim_active, sim_other_active;
 
-				if (qcsat.ez->solve(sat_model, sat_model_values)) {
-					log("      According to the SAT solver this pair of cells can not be shared.\n");
-					log("      Model from SAT solver: %s = %d'", log_signal(all_ctrl_signals), GetSize(sat_model_values));
-					for (int i = GetSize(sat_model_values)-1; i >= 0; i--)
-						log("%c", sat_model_values[i] ? '1' : '0');
+				if (exclusive_cache.count(key))
+				{
+					if (!exclusive_cache.at(key)) {
+						log("      A pair of cells with the same activation patterns can not be shared.\n");
+						continue;
+					}
+					log("      A pair of cells with the same activation patterns can be shared.\n");
+				}
+				else if (sim_activation(filtered_cell_activation_patterns, sim_active) &&
+						sim_activation(filtered_other_cell_activation_patterns, sim_other_active) &&
+						(sim_active & sim_other_active) != 0)
+				{
+					int lane = 0;
+					while (((sim_active & sim_other_active) >> lane & 1) == 0)
+						lane++;
+
+					log("      According to simulation this pair of cells can not be shared.\n");
+					log("      Model from simulation: %s = %d'", log_signal(all_ctrl_signals), GetSize(all_ctrl_signals));
+					for (int i = GetSize(all_ctrl_signals)-1; i >= 0; i--) {
+						uint64_t value;
+						sim_bit(all_ctrl_signals[i], value);
+						log("%c", (value >> lane & 1) ? '1' : '0');
+					}
 					log("\n");
+					exclusive_cache[key] = false;
 					continue;
 				}
-
-				log("      According to the SAT solver this pair of cells can be shared.\n");
+				else
+				{
+					QuickConeSat qcsat(modwalker);
+					if (config.opt_fast) {
+						qcsat.max_cell_outs = 3;
+						qcsat.max_cell_count = 100;
+					}
+
+					std::vector<int> cell_active, other_cell_active;
+
+					for (auto &p : filtered_cell_activation_patterns)
+						cell_active.push_back(qcsat.ez->vec_eq(qcsat.importSig(p.first), qcsat.importSig(p.second)));
+
+					for (auto &p : filtered_other_cell_activation_patterns)
+						other_cell_active.push_back(qcsat.ez->vec_eq(qcsat.importSig(p.first), qcsat.importSig(p.second)));
+
+					qcsat.prepare();
+
+					int sub1 = qcsat.ez->expression(qcsat.ez->OpOr, cell_active);
+					if (!qcsat.ez->solve(sub1)) {
+						log("      According to the SAT solver the cell %s is never active. Sharing is pointless, we simply remove it.\n", log_id(cell));
+						cells_to_remove.insert(cell);
+						break;
+					}
+
+					int sub2 = qcsat.ez->expression(qcsat.ez->OpOr, other_cell_active);
+					if (!qcsat.ez->solve(sub2)) {
+						log("      According to the SAT solver the cell %s is never active. Sharing is pointless, we simply remove it.\n", log_id(other_cell));
+						cells_to_remove.insert(other_cell);
+						shareable_cells.erase(other_cell);
+						continue;
+					}
+
+					qcsat.ez->non_incremental();
+
+					std::vector<int> sat_model = qcsat.importSig(all_ctrl_signals);
+					std::vector<bool> sat_model_values;
+
+					qcsat.ez->assume(qcsat.ez->AND(sub1, sub2));
+
+					log("      Size of SAT problem: %d variables, %d clauses\n",
+							qcsat.ez->numCnfVariables(), qcsat.ez->numCnfClauses());
+
+					if (qcsat.ez->solve(sat_model, sat_model_values)) {
+						log("      According to the SAT solver this pair of cells can not be shared.\n");
+						log("      Model from SAT solver: %s = %d'", log_signal(all_ctrl_signals), GetSize(sat_model_values));
+						for (int i = GetSize(sat_model_values)-1; i >= 0; i--)
+							log("%c", sat_model_values[i] ? '1' : '0');
+						log("\n");
+						exclusive_cache[key] = false;
+						continue;
+					}
+
+					log("      According to the SAT solver this pair of cells can be shared.\n");
+					exclusive_cache[key] = true;
+				}
 
 				if (find_in_input_cone(cell, other_cell)) {
 					log("      Sharing not possible: %s is in input cone of %s.\n", log_id(other_cell), log_id(cell));
@@ -1406,7 +1741,7 @@ struct ShareWorker
 };
 
 struct SharePass : public Pass {
-	SharePass() : Pass("share", "perform sat-based resource sharing") { }
+	SharePass() : Pass("share", "perform sat-based resource sharing") { keeps_indexes(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -51,7 +51,7 @@ struct WreduceWorker
 {
 	WreduceConfig *config;
 	Module *module;
-	ModIndex mi;
+	ModIndex &mi;
 
 	std::set<Cell*, IdString::compare_ptr_by_name<Cell>> work_queue_cells;
 	std::set<SigBit> work_queue_bits;
@@ -59,7 +59,7 @@ struct WreduceWorker
 	FfInitVals initvals;
 
 	WreduceWorker(WreduceConfig *config, Module *module) :
-			config(config), module(module), mi(module) { }
+			config(config), module(module), mi(ModIndex::cached(module)) { }
 
 	void run_cell_mux(Cell *cell)
 	{
@@ -518,7 +518,7 @@ struct WreduceWorker
 };
 
 struct WreducePass : public Pass {
-	WreducePass() : Pass("wreduce", "reduce the word size of operations if possible") { }
+	WreducePass() : Pass("wreduce", "reduce the word size of operations if possible") { keeps_indexes(); }
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -575,6 +575,8 @@ struct WreducePass : public Pass {
 			if (module->has_processes_warn())
 				continue;
 
+			ModuleScope scope(module);
+
 			for (auto c : module->selected_cells())
 			{
 				if (c->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool),
@@ -358,9 +358,130 @@ with open(outfile, "w") as f:
         print("YOSYS_NAMESPACE_BEGIN", file=f)
         print("", file=f)
 
+    print("#ifndef PMGEN_CACHE", file=f)
+    print("#define PMGEN_CACHE", file=f)
+    print("// The signal users of a module, and the indexes that matchers have built", file=f)
+    print("// for it. A pass that creates several matchers for the same module (e.g.", file=f)
+    print("// for different pattern files, or once per iteration of a loop) can pass", file=f)
+    print("// the same cache to all of them, and they only build what is not already", file=f)
+    print("// cached for the current state of the module.", file=f)
+    print("//", file=f)
+    print("// With `incremental` set, the cache watches the module and after a matcher", file=f)
+    print("// changed it only recomputes the signal users of the cells that changed,", file=f)
+    print("// instead of starting over. This requires that all changes go through", file=f)
+    print("// setPort(), unsetPort() and remove(), i.e. that the pass does not write", file=f)
+    print("// to connections_ directly. Adding connections to the module still causes", file=f)
+    print("// a full rebuild, as they change the SigMap.", file=f)
+    print("struct pmgen_cache {", file=f)
+    print("  struct sigdata_t : RTLIL::Monitor {", file=f)
+    print("    Module *module;", file=f)
+    print("    SigMap sigmap;", file=f)
+    print("    dict<SigBit, vector<Cell*>> sigusers;", file=f)
+    print("    bool sigusers_done = false;", file=f)
+    print("    bool tracking, stale = false;", file=f)
+    print("    pool<Cell*, hashlib::hash_ptr_ops> dirty_cells;", file=f)
+    print("    pool<SigBit> dirty_bits;", file=f)
+    print("", file=f)
+    print("    sigdata_t(Module *module, bool tracking = false) : module(module), sigmap(module), tracking(tracking) {", file=f)
+    print("      if (tracking)", file=f)
+    print("        module->monitors.insert(this);", file=f)
+    print("    }", file=f)
+    print("    ~sigdata_t() {", file=f)
+    print("      if (tracking)", file=f)
+    print("        module->monitors.erase(this);", file=f)
+    print("    }", file=f)
+    print("", file=f)
+    print("    void add(const SigSpec &sig, Cell *cell) {", file=f)
+    print("      for (auto bit : sigmap(sig)) {", file=f)
+    print("        if (bit.wire == nullptr) continue;", file=f)
+    print("        vector<Cell*> &users = sigusers[bit];", file=f)
+    print("        if (users.empty() || users.back() != cell)", file=f)
+    print("          users.push_back(cell);", file=f)
+    print("      }", file=f)
+    print("    }", file=f)
+    print("", file=f)
+    print("    // Remember that the entries of `cell` need to be recomputed, and all", file=f)
+    print("    // bits it may currently be listed for.", file=f)
+    print("    void touch(Cell *cell, const SigSpec &sig) {", file=f)
+    print("      if (!tracking || stale || !sigusers_done || cell == nullptr)", file=f)
+    print("        return;", file=f)
+    print("      auto mark = [&](const SigSpec &s) {", file=f)
+    print("        for (auto bit : sigmap(s))", file=f)
+    print("          if (bit.wire != nullptr)", file=f)
+    print("            dirty_bits.insert(bit);", file=f)
+    print("      };", file=f)
+    print("      if (dirty_cells.insert(cell).second)", file=f)
+    print("        for (auto &conn : cell->connections())", file=f)
+    print("          mark(conn.second);", file=f)
+    print("      mark(sig);", file=f)
+    print("    }", file=f)
+    print("", file=f)
+    print("    // Bring sigusers up to date with the module, returns false if", file=f)
+    print("    // that is not possible and everything has to be rebuilt.", file=f)
+    print("    bool update() {", file=f)
+    print("      if (!tracking || stale)", file=f)
+    print("        return false;", file=f)
+    print("      if (dirty_cells.empty())", file=f)
+    print("        return true;", file=f)
+    print("      for (auto bit : dirty_bits) {", file=f)
+    print("        auto it = sigusers.find(bit);", file=f)
+    print("        if (it == sigusers.end()) continue;", file=f)
+    print("        auto &users = it->second;", file=f)
+    print("        users.erase(std::remove_if(users.begin(), users.end(), [&](Cell *user) {", file=f)
+    print("          return user != nullptr && dirty_cells.count(user);", file=f)
+    print("        }), users.end());", file=f)
+    print("      }", file=f)
+    print("      for (auto cell : module->cells())", file=f)
+    print("        if (dirty_cells.count(cell))", file=f)
+    print("          for (auto &conn : cell->connections())", file=f)
+    print("            add(conn.second, cell);", file=f)
+    print("      dirty_cells.clear();", file=f)
+    print("      dirty_bits.clear();", file=f)
+    print("      return true;", file=f)
+    print("    }", file=f)
+    print("", file=f)
+    print("    void notify_connect(Cell *cell, const IdString&, const SigSpec &old_sig, const SigSpec&) override {", file=f)
+    print("      touch(cell, old_sig);", file=f)
+    print("    }", file=f)
+    print("    void notify_connect(Module*, const SigSig&) override { stale = true; }", file=f)
+    print("    void notify_connect(Module*, const std::vector<SigSig>&) override { stale = true; }", file=f)
+    print("    void notify_blackout(Module*) override { stale = true; }", file=f)
+    print("  };", file=f)
+    print("", file=f)
+    print("  Module *module = nullptr;", file=f)
+    print("  Hasher::hash_t module_hashidx = 0;", file=f)
+    print("  uint64_t generation = 0;", file=f)
+    print("  bool incremental = false;", file=f)
+    print("  std::shared_ptr<sigdata_t> sigdata;", file=f)
+    print("  dict<std::string, std::pair<vector<Cell*>, std::shared_ptr<void>>> indexes;", file=f)
+    print("", file=f)
+    print("  bool valid(Module *mod) const {", file=f)
+    print("    return module == mod && module_hashidx == mod->hashidx_ && generation == mod->generation_;", file=f)
+    print("  }", file=f)
+    print("", file=f)
+    print("  std::shared_ptr<sigdata_t> get_sigdata(Module *mod) {", file=f)
+    print("    if (!valid(mod)) {", file=f)
+    print("      bool same_module = module == mod && module_hashidx == mod->hashidx_;", file=f)
+    print("      if (!same_module || !sigdata || !sigdata->update()) {", file=f)
+    print("        module = mod;", file=f)
+    print("        module_hashidx = mod->hashidx_;", file=f)
+    print("        sigdata = nullptr;", file=f)
+    print("        sigdata = std::make_shared<sigdata_t>(mod, incremental);", file=f)
+    print("      }", file=f)
+    print("      generation = mod->generation_;", file=f)
+    print("      indexes.clear();", file=f)
+    print("    }", file=f)
+    print("    return sigdata;", file=f)
+    print("  }", file=f)
+    print("};", file=f)
+    print("#endif", file=f)
+    print("", file=f)
+
     print("struct {}_pm {{".format(prefix), file=f)
     print("  Module *module;", file=f)
-    print("  SigMap sigmap;", file=f)
+    print("  pmgen_cache *cache;", file=f)
+    print("  std::shared_ptr<pmgen_cache::sigdata_t> sigdata;", file=f)
+    print("  SigMap &sigmap;", file=f)
     print("  std::function<void()> on_accept;", file=f)
     print("  bool setup_done;", file=f)
     print("  bool generate_mode;", file=f)
@@ -392,11 +513,17 @@ with open(outfile, "w") as f:
                     value_types.append(entry[1])
             print("  typedef std::tuple<{}> index_{}_key_type;".format(", ".join(index_types), index), file=f)
             print("  typedef std::tuple<{}> index_{}_value_type;".format(", ".join(value_types), index), file=f)
-            print("  dict<index_{}_key_type, vector<index_{}_value_type>> index_{};".format(index, index, index), file=f)
-    print("  dict<SigBit, pool<Cell*>> sigusers;", file=f)
-    print("  pool<Cell*> blacklist_cells;", file=f)
+    print("", file=f)
+    print("  struct indexes_t {", file=f)
+    for index in range(len(blocks)):
+        if blocks[index]["type"] == "match":
+            print("    dict<index_{}_key_type, vector<index_{}_value_type>> index_{};".format(index, index, index), file=f)
+    print("  };", file=f)
+    print("  std::shared_ptr<indexes_t> indexes;", file=f)
+    print("  dict<SigBit, vector<Cell*>> &sigusers;", file=f)
+    print("  pool<Cell*, hashlib::hash_ptr_ops> blacklist_cells;", file=f)
     print("  pool<Cell*> autoremove_cells;", file=f)
-    print("  dict<Cell*,int> rollback_cache;", file=f)
+    print("  dict<Cell*, int, hashlib::hash_ptr_ops> rollback_cache;", file=f)
     print("  int rollback;", file=f)
     print("", file=f)
 
@@ -422,10 +549,8 @@ with open(outfile, "w") as f:
     print("", file=f)
 
     print("  void add_siguser(const SigSpec &sig, Cell *cell) {", file=f)
-    print("    for (auto bit : sigmap(sig)) {", file=f)
-    print("      if (bit.wire == nullptr) continue;", file=f)
-    print("      sigusers[bit].insert(cell);", file=f)
-    print("    }", file=f)
+    print("    sigdata->touch(cell, sig);", file=f)
+    print("    sigdata->add(sig, cell);", file=f)
     print("  }", file=f)
     print("", file=f)
 
@@ -473,22 +598,28 @@ with open(outfile, "w") as f:
     print("", file=f)
 
     print("  int nusers(const SigSpec &sig) {", file=f)
-    print("    pool<Cell*> users;", file=f)
-    print("    for (auto bit : sigmap(sig))", file=f)
-    print("      for (auto user : sigusers[bit])", file=f)
+    print("    pool<Cell*, hashlib::hash_ptr_ops> users;", file=f)
+    print("    for (auto bit : sigmap(sig)) {", file=f)
+    print("      auto it = sigusers.find(bit);", file=f)
+    print("      if (it == sigusers.end()) continue;", file=f)
+    print("      for (auto user : it->second)", file=f)
     print("        users.insert(user);", file=f)
+    print("    }", file=f)
     print("    return GetSize(users);", file=f)
     print("  }", file=f)
     print("", file=f)
 
-    print("  {}_pm(Module *module, const vector<Cell*> &cells) :".format(prefix), file=f)
-    print("      module(module), sigmap(module), setup_done(false), generate_mode(false), rngseed(12345678) {", file=f)
+    print("  {}_pm(Module *module, const vector<Cell*> &cells, pmgen_cache *cache = nullptr) :".format(prefix), file=f)
+    print("      {}_pm(module, cache) {{".format(prefix), file=f)
     print("    setup(cells);", file=f)
     print("  }", file=f)
     print("", file=f)
 
-    print("  {}_pm(Module *module) :".format(prefix), file=f)
-    print("      module(module), sigmap(module), setup_done(false), generate_mode(false), rngseed(12345678) {", file=f)
+    print("  {}_pm(Module *module, pmgen_cache *cache = nullptr) :".format(prefix), file=f)
+    print("      module(module), cache(cache),", file=f)
+    print("      sigdata(cache ? cache->get_sigdata(module) : std::make_shared<pmgen_cache::sigdata_t>(module)),", file=f)
+    print("      sigmap(sigdata->sigmap), setup_done(false), generate_mode(false), rngseed(12345678),", file=f)
+    print("      sigusers(sigdata->sigusers) {", file=f)
     print("  }", file=f)
     print("", file=f)
 
@@ -502,11 +633,23 @@ with open(outfile, "w") as f:
     current_pattern = None
     print("    log_assert(!setup_done);", file=f)
     print("    setup_done = true;", file=f)
-    print("    for (auto port : module->ports)", file=f)
-    print("      add_siguser(module->wire(port), nullptr);", file=f)
-    print("    for (auto cell : module->cells())", file=f)
-    print("      for (auto &conn : cell->connections())", file=f)
-    print("        add_siguser(conn.second, cell);", file=f)
+    print("    if (!sigdata->sigusers_done) {", file=f)
+    print("      for (auto port : module->ports)", file=f)
+    print("        sigdata->add(module->wire(port), nullptr);", file=f)
+    print("      for (auto cell : module->cells())", file=f)
+    print("        for (auto &conn : cell->connections())", file=f)
+    print("          sigdata->add(conn.second, cell);", file=f)
+    print("      sigdata->sigusers_done = true;", file=f)
+    print("    }", file=f)
+    print("    bool use_cache = cache != nullptr && cache->valid(module) && cache->sigdata == sigdata;", file=f)
+    print("    if (use_cache) {", file=f)
+    print("      auto it = cache->indexes.find(\"{}\");".format(prefix), file=f)
+    print("      if (it != cache->indexes.end() && it->second.first == cells) {", file=f)
+    print("        indexes = std::static_pointer_cast<indexes_t>(it->second.second);", file=f)
+    print("        return;", file=f)
+    print("      }", file=f)
+    print("    }", file=f)
+    print("    indexes = std::make_shared<indexes_t>();", file=f)
     print("    for (auto cell : cells) {", file=f)
 
     for index in range(len(blocks)):
@@ -539,12 +682,14 @@ with open(outfile, "w") as f:
             print("        index_{}_key_type key;".format(index), file=f)
             for field, entry in enumerate(block["index"]):
                 print("        std::get<{}>(key) = {};".format(field, entry[1]), file=f)
-            print("        index_{}[key].push_back(value);".format(index), file=f)
+            print("        indexes->index_{}[key].push_back(value);".format(index), file=f)
             for i in range(loopcnt):
                 print("        }", file=f)
             print("      } while (0);", file=f)
 
     print("    }", file=f)
+    print("    if (use_cache)", file=f)
+    print("      cache->indexes[\"{}\"] = std::make_pair(cells, std::static_pointer_cast<void>(indexes));".format(prefix), file=f)
     print("  }", file=f)
     print("", file=f)
 
@@ -724,13 +869,13 @@ with open(outfile, "w") as f:
             print("    index_{}_key_type key;".format(index), file=f)
             for field, entry in enumerate(block["index"]):
                 print("    std::get<{}>(key) = {};".format(field, entry[2]), file=f)
-            print("    auto cells_ptr = index_{}.find(key);".format(index), file=f)
+            print("    auto cells_ptr = indexes->index_{}.find(key);".format(index), file=f)
 
             if block["semioptional"] or block["genargs"] is not None:
                 print("    bool found_any_match = false;", file=f)
 
             print("", file=f)
-            print("    if (cells_ptr != index_{}.end()) {{".format(index), file=f)
+            print("    if (cells_ptr != indexes->index_{}.end()) {{".format(index), file=f)
             print("      const vector<index_{}_value_type> &cells = cells_ptr->second;".format(index), file=f)
             print("      for (int _pmg_idx = 0; _pmg_idx < GetSize(cells); _pmg_idx++) {", file=f)
             print("        {} = std::get<0>(cells[_pmg_idx]);".format(block["cell"]), file=f)
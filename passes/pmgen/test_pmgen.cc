@@ -139,6 +139,15 @@ struct TestPmgenPass : public Pass {
 		log("Demo for recursive pmgen patterns. Optimize EQ/NE/PMUX circuits.\n");
 		log("\n");
 
+		log("\n");
+		log("    test_pmgen -benchmark [-count <N>] [selection]\n");
+		log("\n");
+		log("Construct the matcher for the test patterns <N> times (default: 10) for each\n");
+		log("module and search for all patterns without changing the design, once with a\n");
+		log("new matcher every time and once with matchers sharing a pmgen_cache, and\n");
+		log("report the time taken.\n");
+		log("\n");
+
 		log("\n");
 		log("    test_pmgen -generate [options] <pattern_name>\n");
 		log("\n");
@@ -203,6 +212,48 @@ struct TestPmgenPass : public Pass {
 			test_pmgen_pm(module, module->selected_cells()).run_eqpmux(opt_eqpmux);
 	}
 
+	void execute_benchmark(std::vector<std::string> args, RTLIL::Design *design)
+	{
+		log_header(design, "Executing TEST_PMGEN pass (-benchmark).\n");
+
+		int count = 10;
+
+		size_t argidx;
+		for (argidx = 2; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-count" && argidx+1 < args.size()) {
+				count = atoi(args[++argidx].c_str());
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		for (auto module : design->selected_modules())
+		{
+			vector<Cell*> cells = module->selected_cells();
+			int matches = 0;
+
+			int64_t time_uncached = PerformanceTimer::query();
+			for (int i = 0; i < count; i++) {
+				test_pmgen_pm pm(module, cells);
+				matches = pm.run_reduce() + pm.run_eqpmux();
+			}
+			time_uncached = PerformanceTimer::query() - time_uncached;
+
+			int64_t time_cached = PerformanceTimer::query();
+			pmgen_cache cache;
+			for (int i = 0; i < count; i++) {
+				test_pmgen_pm pm(module, cells, &cache);
+				log_assert(pm.run_reduce() + pm.run_eqpmux() == matches);
+			}
+			time_cached = PerformanceTimer::query() - time_cached;
+
+			log("Module %s: %d cells, %d matches, %d runs: %.3f seconds, %.3f seconds with shared cache.\n",
+					log_id(module), GetSize(cells), matches, count, time_uncached * 1e-9, time_cached * 1e-9);
+		}
+	}
+
 	void execute_generate(std::vector<std::string> args, RTLIL::Design *design)
 	{
 		log_header(design, "Executing TEST_PMGEN pass (-generate).\n");
@@ -249,6 +300,8 @@ struct TestPmgenPass : public Pass {
 				return execute_reduce_tree(args, design);
 			if (args[1] == "-eqpmux")
 				return execute_eqpmux(args, design);
+			if (args[1] == "-benchmark")
+				return execute_benchmark(args, design);
 			if (args[1] == "-generate")
 				return execute_generate(args, design);
 		}
@@ -66,6 +66,9 @@ struct ProcPass : public Pass {
 		log("        This option is passed through to proc_mux. proc_rmdead is not\n");
 		log("        executed in -ifx mode.\n");
 		log("\n");
+		log("    -demux\n");
+		log("        This option is passed through to proc_mux.\n");
+		log("\n");
 		log("    -noopt\n");
 		log("        Will omit the opt_expr pass.\n");
 		log("\n");
@@ -74,6 +77,7 @@ struct ProcPass : public Pass {
 	{
 		std::string global_arst;
 		bool ifxmode = false;
+		bool demuxmode = false;
 		bool nomux = false;
 		bool noopt = false;
 		bool norom = false;
@@ -96,6 +100,10 @@ struct ProcPass : public Pass {
 				ifxmode = true;
 				continue;
 			}
+			if (args[argidx] == "-demux") {
+				demuxmode = true;
+				continue;
+			}
 			if (args[argidx] == "-noopt") {
 				noopt = true;
 				continue;
@@ -120,7 +128,7 @@ struct ProcPass : public Pass {
 		if (!norom)
 			Pass::call(design, "proc_rom");
 		if (!nomux)
-			Pass::call(design, ifxmode ? "proc_mux -ifx" : "proc_mux");
+			Pass::call(design, ifxmode ? "proc_mux -ifx" : demuxmode ? "proc_mux -demux" : "proc_mux");
 		Pass::call(design, "proc_dlatch");
 		Pass::call(design, "proc_dff");
 		Pass::call(design, "proc_memwr");
@@ -150,8 +150,83 @@ void apply_attrs(RTLIL::Cell *cell, const RTLIL::SwitchRule *sw, const RTLIL::Ca
 	cell->add_strpool_attribute(ID::src, cs->get_strpool_attribute(ID::src));
 }
 
-RTLIL::SigSpec gen_cmp(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
+// With -demux, the cases of a large switch on constant values are decoded by a single $demux cell that is shared
+// by all snippets, instead of one comparator per case and snippet.
+struct SwDecoderCache
 {
+	dict<RTLIL::SwitchRule*, RTLIL::SigSpec> decoders;
+	dict<RTLIL::CaseRule*, RTLIL::SigSpec> ctrl_sigs;
+
+	static bool use_decoder(RTLIL::SwitchRule *sw)
+	{
+		int width = GetSize(sw->signal);
+		if (width < 2 || width > 16 || sw->signal.is_fully_const())
+			return false;
+
+		int patterns = 0;
+		for (auto cs : sw->cases)
+		for (auto &pat : cs->compare) {
+			if (!pat.is_fully_def())
+				return false;
+			patterns++;
+		}
+
+		// the decoder is a 2^width bit wide AND tree, each comparator is about 2*width gates
+		return (1 << width) <= 2 * width * patterns;
+	}
+
+	RTLIL::SigSpec get_decoder(RTLIL::Module *mod, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs)
+	{
+		auto it = decoders.find(sw);
+		if (it != decoders.end())
+			return it->second;
+
+		RTLIL::SigSpec &dec_sig = decoders[sw];
+		if (use_decoder(sw)) {
+			std::string name = stringf("$procmux$%d", autoidx++);
+			dec_sig = mod->addWire(name + "_DEC", 1 << GetSize(sw->signal));
+			RTLIL::Cell *dec_cell = mod->addDemux(name + "_DEMUX", State::S1, sw->signal, dec_sig);
+			apply_attrs(dec_cell, sw, cs);
+		}
+		return dec_sig;
+	}
+
+	// Returns the decoded control signal for the case, or an empty SigSpec if the switch does not use a decoder.
+	RTLIL::SigSpec get_ctrl(RTLIL::Module *mod, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs)
+	{
+		auto it = ctrl_sigs.find(cs);
+		if (it != ctrl_sigs.end())
+			return it->second;
+
+		RTLIL::SigSpec dec_sig = get_decoder(mod, sw, cs);
+		RTLIL::SigSpec &ctrl_sig = ctrl_sigs[cs];
+		if (dec_sig.empty())
+			return ctrl_sig;
+
+		RTLIL::SigSpec sel;
+		for (auto &pat : cs->compare)
+			sel.append(dec_sig[pat.as_const().as_int()]);
+
+		if (GetSize(sel) == 1) {
+			ctrl_sig = sel;
+		} else {
+			std::string name = stringf("$procmux$%d", autoidx++);
+			ctrl_sig = mod->addWire(name + "_CTRL");
+			RTLIL::Cell *any_cell = mod->addReduceOr(name + "_ANY", sel, ctrl_sig);
+			apply_attrs(any_cell, sw, cs);
+		}
+		return ctrl_sig;
+	}
+};
+
+RTLIL::SigSpec gen_cmp(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode, SwDecoderCache *decoders)
+{
+	if (decoders != nullptr) {
+		RTLIL::SigSpec ctrl_sig = decoders->get_ctrl(mod, sw, cs);
+		if (!ctrl_sig.empty())
+			return ctrl_sig;
+	}
+
 	std::stringstream sstr;
 	sstr << "$procmux$" << (autoidx++);
 
@@ -218,7 +293,7 @@ RTLIL::SigSpec gen_cmp(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 	return RTLIL::SigSpec(ctrl_wire);
 }
 
-RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::SigSpec else_signal, RTLIL::Cell *&last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
+RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::SigSpec else_signal, RTLIL::Cell *&last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode, SwDecoderCache *decoders)
 {
 	log_assert(when_signal.size() == else_signal.size());
 
@@ -230,7 +305,7 @@ RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 		return when_signal;
 
 	// compare results
-	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, signal, compare, sw, cs, ifxmode);
+	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, signal, compare, sw, cs, ifxmode, decoders);
 	if (ctrl_sig.size() == 0)
 		return when_signal;
 	log_assert(ctrl_sig.size() == 1);
@@ -252,7 +327,7 @@ RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 	return RTLIL::SigSpec(result_wire);
 }
 
-void append_pmux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::Cell *last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
+void append_pmux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::Cell *last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode, SwDecoderCache *decoders)
 {
 	log_assert(last_mux_cell != NULL);
 	log_assert(when_signal.size() == last_mux_cell->getPort(ID::A).size());
@@ -260,7 +335,7 @@ void append_pmux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::ve
 	if (when_signal == last_mux_cell->getPort(ID::A))
 		return;
 
-	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, signal, compare, sw, cs, ifxmode);
+	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, signal, compare, sw, cs, ifxmode, decoders);
 	log_assert(ctrl_sig.size() == 1);
 	last_mux_cell->type = ID($pmux);
 
@@ -319,7 +394,7 @@ const pool<SigBit> &get_full_case_bits(SnippetSwCache &swcache, RTLIL::SwitchRul
 }
 
 RTLIL::SigSpec signal_to_mux_tree(RTLIL::Module *mod, SnippetSwCache &swcache, dict<RTLIL::SwitchRule*, bool> &swpara,
-		RTLIL::CaseRule *cs, const RTLIL::SigSpec &sig, const RTLIL::SigSpec &defval, bool ifxmode)
+		RTLIL::CaseRule *cs, const RTLIL::SigSpec &sig, const RTLIL::SigSpec &defval, bool ifxmode, SwDecoderCache *decoders)
 {
 	RTLIL::SigSpec result = defval;
 
@@ -399,18 +474,18 @@ RTLIL::SigSpec signal_to_mux_tree(RTLIL::Module *mod, SnippetSwCache &swcache, d
 		for (size_t i = 0; i < sw->cases.size(); i++) {
 			int case_idx = sw->cases.size() - i - 1;
 			RTLIL::CaseRule *cs2 = sw->cases[case_idx];
-			RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, swpara, cs2, sig, initial_val, ifxmode);
+			RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, swpara, cs2, sig, initial_val, ifxmode, decoders);
 			if (last_mux_cell && pgroups[case_idx] == pgroups[case_idx+1])
-				append_pmux(mod, sw->signal, cs2->compare, value, last_mux_cell, sw, cs2, ifxmode);
+				append_pmux(mod, sw->signal, cs2->compare, value, last_mux_cell, sw, cs2, ifxmode, decoders);
 			else
-				result = gen_mux(mod, sw->signal, cs2->compare, value, result, last_mux_cell, sw, cs2, ifxmode);
+				result = gen_mux(mod, sw->signal, cs2->compare, value, result, last_mux_cell, sw, cs2, ifxmode, decoders);
 		}
 	}
 
 	return result;
 }
 
-void proc_mux(RTLIL::Module *mod, RTLIL::Process *proc, bool ifxmode)
+void proc_mux(RTLIL::Module *mod, RTLIL::Process *proc, bool ifxmode, bool demuxmode)
 {
 	log("Creating decoders for process `%s.%s'.\n", mod->name.c_str(), proc->name.c_str());
 
@@ -423,6 +498,8 @@ void proc_mux(RTLIL::Module *mod, RTLIL::Process *proc, bool ifxmode)
 
 	dict<RTLIL::SwitchRule*, bool> swpara;
 
+	SwDecoderCache decoders;
+
 	int cnt = 0;
 	for (int idx : sigsnip.snippets)
 	{
@@ -431,7 +508,8 @@ void proc_mux(RTLIL::Module *mod, RTLIL::Process *proc, bool ifxmode)
 
 		log("%6d/%d: %s\n", ++cnt, GetSize(sigsnip.snippets), log_signal(sig));
 
-		RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, swpara, &proc->root_case, sig, RTLIL::SigSpec(RTLIL::State::Sx, sig.size()), ifxmode);
+		RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, swpara, &proc->root_case, sig, RTLIL::SigSpec(RTLIL::State::Sx, sig.size()), ifxmode,
+				demuxmode ? &decoders : nullptr);
 		mod->connect(RTLIL::SigSig(sig, value));
 	}
 }
@@ -451,10 +529,18 @@ struct ProcMuxPass : public Pass {
 		log("        Use Verilog simulation behavior with respect to undef values in\n");
 		log("        'case' expressions and 'if' conditions.\n");
 		log("\n");
+		log("    -demux\n");
+		log("        Decode large case statements on constant values with a single $demux\n");
+		log("        cell per case statement, instead of a comparator for each case. This\n");
+		log("        is used when the selector is 2 to 16 bits wide and there are enough\n");
+		log("        cases for the decoder to be smaller than the comparators. Has no effect\n");
+		log("        in combination with -ifx.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		bool ifxmode = false;
+		bool demuxmode = false;
 		log_header(design, "Executing PROC_MUX pass (convert decision trees to multiplexers).\n");
 
 		size_t argidx;
@@ -464,6 +550,10 @@ struct ProcMuxPass : public Pass {
 				ifxmode = true;
 				continue;
 			}
+			if (args[argidx] == "-demux") {
+				demuxmode = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -472,7 +562,7 @@ struct ProcMuxPass : public Pass {
 			if (design->selected(mod))
 				for (auto &proc_it : mod->processes)
 					if (design->selected(mod, proc_it.second))
-						proc_mux(mod, proc_it.second, ifxmode);
+						proc_mux(mod, proc_it.second, ifxmode, demuxmode && !ifxmode);
 	}
 } ProcMuxPass;
 
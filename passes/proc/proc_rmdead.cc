@@ -18,12 +18,13 @@
  */
 
 #include "kernel/register.h"
-#include "kernel/bitpattern.h"
 #include "kernel/log.h"
 #include <sstream>
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
+#include <cmath>
+#include <algorithm>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -78,6 +79,160 @@ struct FullyDefinedPool
 	size_t max_patterns;
 };
 
+// Like BitPatternPool, but rather than storing the remaining patterns (taking
+// a wildcard pattern splits each remaining pattern it overlaps into up to one
+// new pattern per bit, which explodes for case statements with thousands of
+// wildcard items), this stores the taken patterns as cubes. Whether a new
+// pattern is covered by the taken ones is decided by splitting it on the bits
+// of the overlapping cubes, which only needs a few steps for decoder-like
+// case statements. Past `max_steps` a pattern is conservatively treated as
+// not covered, so that no reachable case is ever removed.
+struct CubeCoverPool
+{
+	struct Cube {
+		// the bits that are compared, and their values
+		std::vector<uint64_t> mask, value;
+	};
+
+	static const int max_steps = 100000;
+
+	int width, words;
+	bool universe_empty = false, default_reached = false;
+	Cube universe;
+	std::vector<Cube> cubes;
+	int empty_cache = -1;
+
+	CubeCoverPool(const RTLIL::SigSpec &signal)
+		: width(GetSize(signal)), words((GetSize(signal) + 63) / 64)
+	{
+		universe.mask.assign(words, 0);
+		universe.value.assign(words, 0);
+		for (int i = 0; i < width; i++)
+			if (signal[i].wire == nullptr && signal[i].data <= RTLIL::State::S1)
+				set_bit(universe, i, signal[i].data == RTLIL::State::S1);
+		universe_empty = width == 0;
+	}
+
+	static void set_bit(Cube &cube, int i, bool value)
+	{
+		cube.mask[i / 64] |= uint64_t(1) << (i % 64);
+		if (value)
+			cube.value[i / 64] |= uint64_t(1) << (i % 64);
+		else
+			cube.value[i / 64] &= ~(uint64_t(1) << (i % 64));
+	}
+
+	bool intersects(const Cube &a, const Cube &b) const
+	{
+		for (int w = 0; w < words; w++)
+			if ((a.value[w] ^ b.value[w]) & a.mask[w] & b.mask[w])
+				return false;
+		return true;
+	}
+
+	// whether every pattern of b is one of a
+	bool contains(const Cube &a, const Cube &b) const
+	{
+		for (int w = 0; w < words; w++)
+			if ((a.mask[w] & ~b.mask[w]) || ((a.value[w] ^ b.value[w]) & a.mask[w]))
+				return false;
+		return true;
+	}
+
+	bool covered(const Cube &cube, const std::vector<int> &candidates, int &steps) const
+	{
+		if (--steps < 0)
+			return false;
+
+		// the share of the patterns of `cube` that each overlapping cube covers
+		std::vector<int> overlapping;
+		double share = 0;
+		for (int i : candidates) {
+			const Cube &other = cubes[i];
+			if (!intersects(other, cube))
+				continue;
+			if (contains(other, cube))
+				return true;
+			overlapping.push_back(i);
+			int extra_bits = 0;
+			for (int w = 0; w < words; w++)
+				extra_bits += __builtin_popcountll(other.mask[w] & ~cube.mask[w]);
+			share += std::ldexp(1.0, -extra_bits);
+		}
+		if (share < 1.0)
+			return false;
+
+		// split on the bit compared by the most overlapping cubes
+		std::vector<int> bit_count(width);
+		for (int i : overlapping)
+			for (int b = 0; b < width; b++)
+				if ((cubes[i].mask[b / 64] & ~cube.mask[b / 64]) >> (b % 64) & 1)
+					bit_count[b]++;
+		int split = std::max_element(bit_count.begin(), bit_count.end()) - bit_count.begin();
+		log_assert(bit_count[split] > 0);
+
+		Cube half = cube;
+		set_bit(half, split, false);
+		if (!covered(half, overlapping, steps))
+			return false;
+		set_bit(half, split, true);
+		return covered(half, overlapping, steps);
+	}
+
+	bool covered(const Cube &cube) const
+	{
+		std::vector<int> candidates(GetSize(cubes));
+		for (int i = 0; i < GetSize(cubes); i++)
+			candidates[i] = i;
+		int steps = max_steps;
+		return covered(cube, candidates, steps);
+	}
+
+	bool take(RTLIL::SigSpec sig)
+	{
+		if (default_reached || universe_empty)
+			return false;
+
+		Cube cube;
+		cube.mask.assign(words, 0);
+		cube.value.assign(words, 0);
+		for (int i = 0; i < width; i++)
+			if (sig[i].data <= RTLIL::State::S1)
+				set_bit(cube, i, sig[i].data == RTLIL::State::S1);
+		if (!intersects(cube, universe))
+			return false;
+		for (int w = 0; w < words; w++) {
+			cube.value[w] = (cube.value[w] & cube.mask[w]) | (universe.value[w] & universe.mask[w]);
+			cube.mask[w] |= universe.mask[w];
+		}
+
+		if (covered(cube))
+			return false;
+
+		// cubes that the new one covers are no longer needed
+		cubes.erase(std::remove_if(cubes.begin(), cubes.end(), [&](const Cube &other) {
+			return contains(cube, other);
+		}), cubes.end());
+		cubes.push_back(std::move(cube));
+		empty_cache = -1;
+		return true;
+	}
+
+	void take_all()
+	{
+		default_reached = true;
+	}
+
+	bool empty()
+	{
+		if (default_reached || universe_empty)
+			return true;
+		if (empty_cache < 0)
+			empty_cache = covered(universe);
+		return empty_cache;
+	}
+};
+
 void proc_rmdead(RTLIL::SwitchRule *sw, int &counter, int &full_case_counter);
 
 template <class Pool>
@@ -126,7 +281,7 @@ void proc_rmdead(RTLIL::SwitchRule *sw, int &counter, int &full_case_counter)
 	if (can_use_fully_defined_pool(sw))
 		proc_rmdead_impl<FullyDefinedPool>(sw, counter, full_case_counter);
 	else
-		proc_rmdead_impl<BitPatternPool>(sw, counter, full_case_counter);
+		proc_rmdead_impl<CubeCoverPool>(sw, counter, full_case_counter);
 }
 
 struct ProcRmdeadPass : public Pass {
@@ -71,6 +71,23 @@ struct Async2syncPass : public Pass {
 
 			SigBit initstate;
 
+			// the inverted set and clear signals, shared by all FFs with the
+			// same control signal
+			dict<std::pair<SigSpec, bool>, SigSpec> inverted;
+			auto invert = [&](const SigSpec &sig, bool is_fine) {
+				auto key = std::make_pair(sigmap(sig), is_fine);
+				auto it = inverted.find(key);
+				if (it != inverted.end())
+					return it->second;
+				SigSpec inv;
+				if (!is_fine)
+					inv = module->Not(NEW_ID, sig);
+				else
+					inv = module->NotGate(NEW_ID, sig);
+				inverted[key] = inv;
+				return inv;
+			};
+
 			for (auto cell : vector<Cell*>(module->selected_cells()))
 			{
 				if (cell->type.in(ID($print), ID($check)))
@@ -153,17 +170,11 @@ struct Async2syncPass : public Pass {
 						SigSpec sig_clr = ff.sig_clr;
 
 						if (!ff.pol_set) {
-							if (!ff.is_fine)
-								sig_set = module->Not(NEW_ID, sig_set);
-							else
-								sig_set = module->NotGate(NEW_ID, sig_set);
+							sig_set = invert(sig_set, ff.is_fine);
 						}
 
 						if (ff.pol_clr) {
-							if (!ff.is_fine)
-								sig_clr = module->Not(NEW_ID, sig_clr);
-							else
-								sig_clr = module->NotGate(NEW_ID, sig_clr);
+							sig_clr = invert(sig_clr, ff.is_fine);
 						}
 
 						if (!ff.is_fine) {
@@ -284,17 +295,11 @@ struct Async2syncPass : public Pass {
 						SigSpec sig_clr = ff.sig_clr;
 
 						if (!ff.pol_set) {
-							if (!ff.is_fine)
-								sig_set = module->Not(NEW_ID, sig_set);
-							else
-								sig_set = module->NotGate(NEW_ID, sig_set);
+							sig_set = invert(sig_set, ff.is_fine);
 						}
 
 						if (ff.pol_clr) {
-							if (!ff.is_fine)
-								sig_clr = module->Not(NEW_ID, sig_clr);
-							else
-								sig_clr = module->NotGate(NEW_ID, sig_clr);
+							sig_clr = invert(sig_clr, ff.is_fine);
 						}
 
 						if (!ff.is_fine) {
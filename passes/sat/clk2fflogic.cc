@@ -31,6 +31,17 @@ struct SampledSig {
 	SigSpec &operator[](bool get_current) { return get_current ? current : sampled; }
 };
 
+// The sampled control signals and edge detectors of a module, by (mapped
+// signal, polarity, is_fine), shared by all FFs, memory ports and triggered
+// cells with the same control signal. Designs typically have many FFs but
+// few clocks and resets.
+struct SharedControls {
+	const SigMap &sigmap;
+	dict<std::tuple<SigSpec, bool, bool>, SampledSig> level;
+	dict<std::tuple<SigSpec, bool, bool>, SigSpec> edge;
+	SharedControls(const SigMap &sigmap) : sigmap(sigmap) { }
+};
+
 struct Clk2fflogicPass : public Pass {
 	Clk2fflogicPass() : Pass("clk2fflogic", "convert clocked FFs to generic $ff cells") { }
 	void help() override
@@ -57,7 +68,11 @@ struct Clk2fflogicPass : public Pass {
 		log("\n");
 	}
 	// Active-high sampled and current value of a level-triggered control signal. Initial sampled values is low/non-asserted.
-	SampledSig sample_control(Module *module, SigSpec sig, bool polarity, bool is_fine) {
+	SampledSig sample_control(Module *module, SharedControls &shared, SigSpec sig, bool polarity, bool is_fine) {
+		auto key = std::make_tuple(shared.sigmap(sig), polarity, is_fine);
+		auto it = shared.level.find(key);
+		if (it != shared.level.end())
+			return it->second;
 		if (!polarity) {
 			if (is_fine)
 				sig = module->NotGate(NEW_ID, sig);
@@ -72,10 +87,14 @@ struct Clk2fflogicPass : public Pass {
 			module->addFfGate(NEW_ID, sig, sampled_sig);
 		else
 			module->addFf(NEW_ID, sig, sampled_sig);
-		return {sampled_sig, sig};
+		return shared.level[key] = {sampled_sig, sig};
 	}
 	// Active-high trigger signal for an edge-triggered control signal. Initial values is low/non-edge.
-	SigSpec sample_control_edge(Module *module, SigSpec sig, bool polarity, bool is_fine) {
+	SigSpec sample_control_edge(Module *module, SharedControls &shared, SigSpec sig, bool polarity, bool is_fine) {
+		auto key = std::make_tuple(shared.sigmap(sig), polarity, is_fine);
+		auto it = shared.edge.find(key);
+		if (it != shared.edge.end())
+			return it->second;
 		std::string sig_str = log_signal(sig);
 		sig_str.erase(std::remove(sig_str.begin(), sig_str.end(), ' '), sig_str.end());
 		Wire *sampled_sig = module->addWire(NEW_ID_SUFFIX(stringf("%s#sampled", sig_str.c_str())), GetSize(sig));
@@ -84,7 +103,7 @@ struct Clk2fflogicPass : public Pass {
 			module->addFfGate(NEW_ID, sig, sampled_sig);
 		else
 			module->addFf(NEW_ID, sig, sampled_sig);
-		return module->Eqx(NEW_ID, {sampled_sig, sig}, polarity ? SigSpec {State::S0, State::S1} : SigSpec {State::S1, State::S0});
+		return shared.edge[key] = module->Eqx(NEW_ID, {sampled_sig, sig}, polarity ? SigSpec {State::S0, State::S1} : SigSpec {State::S1, State::S0});
 	}
 	// Sampled and current value of a data signal.
 	SampledSig sample_data(Module *module, SigSpec sig, RTLIL::Const init, bool is_fine, bool set_attribute = false) {
@@ -156,6 +175,7 @@ struct Clk2fflogicPass : public Pass {
 		{
 			SigMap sigmap(module);
 			FfInitVals initvals(&sigmap, module);
+			SharedControls shared(sigmap);
 
 			for (auto &mem : Mem::get_selected_memories(module))
 			{
@@ -177,21 +197,7 @@ struct Clk2fflogicPass : public Pass {
 							i, log_id(module), log_id(mem.memid), log_signal(port.clk),
 							log_signal(port.addr), log_signal(port.data));
 
-					Wire *past_clk = module->addWire(NEW_ID_SUFFIX(stringf("%s#%d#past_clk#%s", log_id(mem.memid), i, log_signal(port.clk))));
-					past_clk->attributes[ID::init] = port.clk_polarity ? State::S1 : State::S0;
-					module->addFf(NEW_ID, port.clk, past_clk);
-
-					SigSpec clock_edge_pattern;
-
-					if (port.clk_polarity) {
-						clock_edge_pattern.append(State::S0);
-						clock_edge_pattern.append(State::S1);
-					} else {
-						clock_edge_pattern.append(State::S1);
-						clock_edge_pattern.append(State::S0);
-					}
-
-					SigSpec clock_edge = module->Eqx(NEW_ID, {port.clk, SigSpec(past_clk)}, clock_edge_pattern);
+					SigSpec clock_edge = sample_control_edge(module, shared, port.clk, port.clk_polarity, false);
 
 					SigSpec en_q = module->addWire(NEW_ID_SUFFIX(stringf("%s#%d#en_q", log_id(mem.memid), i)), GetSize(port.en));
 					module->addFf(NEW_ID, port.en, en_q);
@@ -244,7 +250,7 @@ struct Clk2fflogicPass : public Pass {
 						SigSpec sig_trg_sampled;
 
 						for (auto const &bit : sig_trg)
-							sig_trg_sampled.append(sample_control_edge(module, bit, trg_polarity[GetSize(sig_trg_sampled)] == State::S1, false));
+							sig_trg_sampled.append(sample_control_edge(module, shared, bit, trg_polarity[GetSize(sig_trg_sampled)] == State::S1, false));
 						SigSpec sig_args_sampled = sample_data(module, sig_args, Const(State::S0, GetSize(sig_args)), false, false).sampled;
 						SigBit sig_en_sampled = sample_data(module, sig_en, State::S0, false, false).sampled;
 
@@ -304,7 +310,7 @@ struct Clk2fflogicPass : public Pass {
 				if (ff.has_clk) {
 					// The init value for the sampled d is never used, so we can set it to fixed zero, reducing uninit'd FFs
 					auto sampled_d = sample_data(module, ff.sig_d, RTLIL::Const(State::S0, ff.width), ff.is_fine);
-					auto clk_edge = sample_control_edge(module, ff.sig_clk, ff.pol_clk, ff.is_fine);
+					auto clk_edge = sample_control_edge(module, shared, ff.sig_clk, ff.pol_clk, ff.is_fine);
 					next_q = mux(module, next_q, sampled_d.sampled, clk_edge, ff.is_fine);
 				}
 
@@ -314,16 +320,16 @@ struct Clk2fflogicPass : public Pass {
 				// generating a lot of extra logic.
 				bool has_nonconst_aload = ff.has_aload && ff.sig_aload != (ff.pol_aload ? State::S0 : State::S1);
 				if (has_nonconst_aload) {
-					sampled_aload = sample_control(module, ff.sig_aload, ff.pol_aload, ff.is_fine);
+					sampled_aload = sample_control(module, shared, ff.sig_aload, ff.pol_aload, ff.is_fine);
 					// The init value for the sampled ad is never used, so we can set it to fixed zero, reducing uninit'd FFs
 					sampled_ad = sample_data(module, ff.sig_ad, RTLIL::Const(State::S0, ff.width), ff.is_fine);
 				}
 				if (ff.has_sr) {
-					sampled_set = sample_control(module, ff.sig_set, ff.pol_set, ff.is_fine);
-					sampled_clr = sample_control(module, ff.sig_clr, ff.pol_clr, ff.is_fine);
+					sampled_set = sample_control(module, shared, ff.sig_set, ff.pol_set, ff.is_fine);
+					sampled_clr = sample_control(module, shared, ff.sig_clr, ff.pol_clr, ff.is_fine);
 				}
 				if (ff.has_arst)
-					sampled_arst = sample_control(module, ff.sig_arst, ff.pol_arst, ff.is_fine);
+					sampled_arst = sample_control(module, shared, ff.sig_arst, ff.pol_arst, ff.is_fine);
 
 				// First perform updates using _only_ sampled values, then again using _only_ current values. Unlike the previous
 				// implementation, this approach correctly handles all the cases of multiple signals changing simultaneously.
@@ -20,6 +20,7 @@
 #include "kernel/register.h"
 #include "kernel/celltypes.h"
 #include "kernel/consteval.h"
+#include "kernel/consteval64.h"
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/satgen.h"
@@ -33,10 +34,13 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 bool inv_mode;
-int verbose_level, reduce_counter, reduce_stop_at;
+int verbose_level, reduce_counter, reduce_stop_at, sim_patterns;
 typedef std::map<RTLIL::SigBit, std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>>> drivers_t;
 std::string dump_prefix;
 
+// hashes of the random simulation values of a signal and of its inverse
+typedef flat_dict<RTLIL::SigBit, std::pair<uint64_t, uint64_t>> signatures_t;
+
 struct equiv_bit_t
 {
 	int depth;
@@ -239,6 +243,7 @@ struct PerformReduction
 	std::vector<RTLIL::SigBit> out_bits, pi_bits;
 	std::vector<bool> out_inverted;
 	std::vector<int> out_depth;
+	std::vector<const std::pair<uint64_t, uint64_t>*> out_signature;
 	int cone_size;
 
 	int register_cone_worker(std::set<RTLIL::Cell*> &celldone, std::map<RTLIL::SigBit, int> &sigdepth, RTLIL::SigBit out)
@@ -279,9 +284,15 @@ struct PerformReduction
 		return sigdepth.at(out);
 	}
 
-	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, std::vector<RTLIL::SigBit> &bits, int cone_size) :
+	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, std::vector<RTLIL::SigBit> &bits, int cone_size,
+			const signatures_t &signatures) :
 			sigmap(sigmap), drivers(drivers), inv_pairs(inv_pairs), satgen(ez.get(), &sigmap), out_bits(bits), cone_size(cone_size)
 	{
+		for (auto &bit : bits) {
+			auto it = signatures.find(bit);
+			out_signature.push_back(it != signatures.end() ? &it->second : nullptr);
+		}
+
 		satgen.model_undef = true;
 
 		std::set<RTLIL::Cell*> celldone;
@@ -488,15 +499,51 @@ struct PerformReduction
 		}
 	}
 
+	// Split a bucket by the simulation signatures of its signals, so that SAT
+	// only has to shatter groups of signals that agreed on all patterns. A
+	// signal without a signature may be undef or was not simulated, it is
+	// added to every part like an undef signal in the shattering above.
+	void split_by_signature(const std::vector<int> &bucket, std::vector<std::vector<int>> &parts)
+	{
+		std::map<uint64_t, std::vector<int>> by_signature;
+		std::vector<int> unknown;
+
+		for (int idx : bucket) {
+			if (out_signature[idx] == nullptr)
+				unknown.push_back(idx);
+			else
+				by_signature[out_inverted[idx] ? out_signature[idx]->second : out_signature[idx]->first].push_back(idx);
+		}
+
+		if (GetSize(by_signature) <= 1) {
+			parts.push_back(bucket);
+			return;
+		}
+
+		if (verbose_level >= 1)
+			log("  Simulation splits bucket with %d signals into %d parts (%d signals without signature).\n",
+					GetSize(bucket), GetSize(by_signature), GetSize(unknown));
+
+		for (auto &it : by_signature) {
+			parts.push_back(it.second);
+			parts.back().insert(parts.back().end(), unknown.begin(), unknown.end());
+			std::sort(parts.back().begin(), parts.back().end());
+		}
+	}
+
 	void analyze(std::vector<std::vector<equiv_bit_t>> &results, int perc)
 	{
 		std::vector<int> bucket;
 		for (size_t i = 0; i < sat_out.size(); i++)
 			bucket.push_back(i);
 
+		std::vector<std::vector<int>> parts;
+		split_by_signature(bucket, parts);
+
 		std::vector<std::set<int>> results_buf;
 		std::map<int, int> results_map;
-		analyze(results_buf, results_map, bucket, stringf("[%2d%%] %d ", perc, cone_size), "");
+		for (auto &part : parts)
+			analyze(results_buf, results_map, part, stringf("[%2d%%] %d ", perc, cone_size), "");
 
 		for (auto &r : results_buf)
 		{
@@ -569,10 +616,91 @@ struct FreduceWorker
 	drivers_t drivers;
 	std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> inv_pairs;
 
+	dict<RTLIL::SigBit, bool> sim_exact;
+	pool<RTLIL::SigBit> sim_inputs;
+
 	FreduceWorker(RTLIL::Design *design, RTLIL::Module *module) : design(design), module(module), sigmap(module)
 	{
 	}
 
+	// A signal is simulated exactly if its cone only has cells that produce
+	// defined outputs for defined inputs and no undef constants. Only then
+	// can the two-valued simulation tell it apart from other signals.
+	bool is_sim_exact(RTLIL::SigBit bit)
+	{
+		if (bit.wire == NULL)
+			return bit.data == RTLIL::State::S0 || bit.data == RTLIL::State::S1;
+
+		auto it = sim_exact.find(bit);
+		if (it != sim_exact.end())
+			return it->second;
+
+		if (drivers.count(bit) == 0) {
+			sim_inputs.insert(bit);
+			return sim_exact[bit] = true;
+		}
+
+		// a logic loop is not simulated, and reported later by PerformReduction
+		sim_exact[bit] = false;
+
+		std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>> &drv = drivers.at(bit);
+		if (!drv.first->type.in(ID($_BUF_), ID($_NOT_), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_),
+				ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_NMUX_), ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_)) &&
+				!drv.first->type.in(ID($not), ID($pos), ID($neg), ID($and), ID($or), ID($xor), ID($xnor), ID($reduce_and), ID($reduce_or),
+				ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool), ID($logic_not), ID($logic_and), ID($logic_or), ID($add), ID($sub),
+				ID($mul), ID($eq), ID($ne), ID($lt), ID($le), ID($ge), ID($gt), ID($mux), ID($shl), ID($shr), ID($sshl), ID($sshr)))
+			return false;
+
+		for (auto &in_bit : drv.second)
+			if (!is_sim_exact(in_bit))
+				return false;
+
+		return sim_exact[bit] = true;
+	}
+
+	// Simulate the exactly simulated signals in candidates with sim_patterns
+	// random input patterns, 64 at a time, and hash the resulting values.
+	void simulate(const std::vector<RTLIL::SigBit> &candidates, signatures_t &signatures)
+	{
+		std::vector<RTLIL::SigBit> sim_bits;
+		for (auto bit : candidates)
+			if (is_sim_exact(bit))
+				sim_bits.push_back(bit);
+
+		if (sim_bits.empty())
+			return;
+
+		ConstEval64 ce(module);
+		std::vector<std::pair<uint64_t, uint64_t>> hashes(GetSize(sim_bits), std::make_pair(5381, 5381));
+		std::vector<bool> failed(GetSize(sim_bits));
+		uint64_t rng = 88172645463325252ULL;
+
+		for (int word = 0; word < (sim_patterns + 63) / 64; word++)
+		{
+			ce.clear();
+			for (auto bit : sim_inputs) {
+				rng ^= rng << 13, rng ^= rng >> 7, rng ^= rng << 17;
+				ce.set(bit, rng);
+			}
+
+			for (int i = 0; i < GetSize(sim_bits); i++) {
+				std::vector<uint64_t> lanes;
+				if (failed[i] || !ce.eval(sim_bits[i], lanes)) {
+					failed[i] = true;
+					continue;
+				}
+				hashes[i].first = ((hashes[i].first ^ lanes.front()) * 0x9e3779b97f4a7c15ULL) ^ (hashes[i].first >> 29);
+				hashes[i].second = ((hashes[i].second ^ ~lanes.front()) * 0x9e3779b97f4a7c15ULL) ^ (hashes[i].second >> 29);
+			}
+		}
+
+		for (int i = 0; i < GetSize(sim_bits); i++)
+			if (!failed[i])
+				signatures[sim_bits[i]] = hashes[i];
+
+		log("  Simulated %d signal bits with %d random patterns.\n", GetSize(signatures), 64 * ((sim_patterns + 63) / 64));
+	}
+
 	bool find_bit_in_cone(std::set<RTLIL::Cell*> &celldone, RTLIL::SigBit needle, RTLIL::SigBit haystack)
 	{
 		if (needle == haystack)
@@ -667,7 +795,8 @@ struct FreduceWorker
 		log("  Sorted %d signal bits into %d buckets.\n", bits_count, int(buckets.size()));
 
 		int bucket_count = 0;
-		std::vector<std::vector<equiv_bit_t>> equiv;
+		std::vector<std::tuple<std::vector<RTLIL::SigBit>*, int, int>> todo;
+		std::vector<RTLIL::SigBit> sim_candidates;
 		for (auto &bucket : buckets)
 		{
 			bucket_count++;
@@ -675,18 +804,47 @@ struct FreduceWorker
 			if (bucket.second.size() == 1)
 				continue;
 
-			if (bucket.first.size() == 0) {
-				log("  Finding const values for bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
-				for (size_t idx = 0; idx < bucket.second.size(); idx++)
-					worker.analyze_const(equiv, idx);
-			} else {
-				log("  Trying to shatter bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
-				worker.analyze(equiv, 100 * bucket_count / (buckets.size() + 1));
-			}
+			todo.push_back(std::make_tuple(&bucket.second, GetSize(bucket.first), 100 * bucket_count / (buckets.size() + 1)));
+			if (!bucket.first.empty() && sim_patterns > 0)
+				sim_candidates.insert(sim_candidates.end(), bucket.second.begin(), bucket.second.end());
 		}
 
+		signatures_t signatures;
+		simulate(sim_candidates, signatures);
+
+		// The buckets are independent. They are processed in consecutive
+		// chunks, each with its own copy of sigmap, which is not thread safe.
+		int jobs = std::min(GetSize(todo), Pass::parallel_threads(design) > 1 ? 4 * Pass::parallel_threads(design) : 1);
+		std::vector<std::vector<std::vector<equiv_bit_t>>> job_equiv(jobs);
+
+		Pass::parallel_for(design, jobs, [&](int job)
+		{
+			SigMap job_sigmap;
+			if (jobs > 1)
+				job_sigmap = sigmap;
+
+			for (int i = job * GetSize(todo) / jobs; i < (job + 1) * GetSize(todo) / jobs; i++)
+			{
+				std::vector<RTLIL::SigBit> &bucket = *std::get<0>(todo[i]);
+				int cone_size = std::get<1>(todo[i]);
+
+				if (cone_size == 0) {
+					log("  Finding const values for bucket %s%c\n", log_signal(bucket), verbose_level ? ':' : '.');
+					PerformReduction worker(jobs > 1 ? job_sigmap : sigmap, drivers, inv_pairs, bucket, cone_size, signatures);
+					for (size_t idx = 0; idx < bucket.size(); idx++)
+						worker.analyze_const(job_equiv[job], idx);
+				} else {
+					log("  Trying to shatter bucket %s%c\n", log_signal(bucket), verbose_level ? ':' : '.');
+					PerformReduction worker(jobs > 1 ? job_sigmap : sigmap, drivers, inv_pairs, bucket, cone_size, signatures);
+					worker.analyze(job_equiv[job], std::get<2>(todo[i]));
+				}
+			}
+		});
+
+		std::vector<std::vector<equiv_bit_t>> equiv;
+		for (auto &it : job_equiv)
+			equiv.insert(equiv.end(), it.begin(), it.end());
+
 		std::map<RTLIL::SigBit, int> bitusage;
 		CountBitUsage bitusage_worker(sigmap, bitusage);
 		module->rewrite_sigspecs(bitusage_worker);
@@ -777,6 +935,11 @@ struct FreducePass : public Pass {
 		log("    -inv\n");
 		log("        enable explicit handling of inverted signals\n");
 		log("\n");
+		log("    -sim <n>\n");
+		log("        simulate the candidate signals with <n> random input patterns (rounded\n");
+		log("        up to a multiple of 64) and only try to prove signals equivalent that\n");
+		log("        agree on all of them. the default is 1024, 0 disables the simulation.\n");
+		log("\n");
 		log("    -stop <n>\n");
 		log("        stop after <n> reduction operations. this is mostly used for\n");
 		log("        debugging the freduce command itself.\n");
@@ -791,6 +954,9 @@ struct FreducePass : public Pass {
 		log("All selected wires are considered for rewiring. The selected cells cover the\n");
 		log("circuit that is analyzed.\n");
 		log("\n");
+		log("Independent groups of candidate signals are proven in parallel, using the\n");
+		log("number of threads set with 'yosys -j'.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -798,6 +964,7 @@ struct FreducePass : public Pass {
 		reduce_stop_at = 0;
 		verbose_level = 0;
 		inv_mode = false;
+		sim_patterns = 1024;
 		dump_prefix = std::string();
 
 		log_header(design, "Executing FREDUCE pass (perform functional reduction).\n");
@@ -816,6 +983,10 @@ struct FreducePass : public Pass {
 				inv_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-sim" && argidx+1 < args.size()) {
+				sim_patterns = atoi(args[++argidx].c_str());
+				continue;
+			}
 			if (args[argidx] == "-stop" && argidx+1 < args.size()) {
 				reduce_stop_at = atoi(args[++argidx].c_str());
 				continue;
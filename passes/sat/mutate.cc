@@ -19,6 +19,9 @@
 
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
+#include "kernel/consteval64.h"
+#include "kernel/ff.h"
+#include "kernel/ffinit.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -726,6 +729,388 @@ void mutate_cnot(Design *design, const mutate_opts_t &opts, bool one)
 	cell->setPort(opts.port, s);
 }
 
+bool mutate_parse_opt(const std::vector<std::string> &args, size_t &argidx, mutate_opts_t &opts)
+{
+	if (args[argidx] == "-seed" && argidx+1 < args.size()) {
+		opts.seed = atoi(args[++argidx].c_str());
+		return true;
+	}
+	if (args[argidx] == "-none") {
+		opts.none = true;
+		return true;
+	}
+	if (args[argidx] == "-mode" && argidx+1 < args.size()) {
+		opts.mode = args[++argidx];
+		return true;
+	}
+	if (args[argidx] == "-ctrl" && argidx+3 < args.size()) {
+		opts.ctrl_name = RTLIL::escape_id(args[++argidx]);
+		opts.ctrl_width = atoi(args[++argidx].c_str());
+		opts.ctrl_value = atoi(args[++argidx].c_str());
+		return true;
+	}
+	if (args[argidx] == "-module" && argidx+1 < args.size()) {
+		opts.module = RTLIL::escape_id(args[++argidx]);
+		return true;
+	}
+	if (args[argidx] == "-cell" && argidx+1 < args.size()) {
+		opts.cell = RTLIL::escape_id(args[++argidx]);
+		return true;
+	}
+	if (args[argidx] == "-port" && argidx+1 < args.size()) {
+		opts.port = RTLIL::escape_id(args[++argidx]);
+		return true;
+	}
+	if (args[argidx] == "-portbit" && argidx+1 < args.size()) {
+		opts.portbit = atoi(args[++argidx].c_str());
+		return true;
+	}
+	if (args[argidx] == "-ctrlbit" && argidx+1 < args.size()) {
+		opts.ctrlbit = atoi(args[++argidx].c_str());
+		return true;
+	}
+	if (args[argidx] == "-wire" && argidx+1 < args.size()) {
+		opts.wire = RTLIL::escape_id(args[++argidx]);
+		return true;
+	}
+	if (args[argidx] == "-wirebit" && argidx+1 < args.size()) {
+		opts.wirebit = atoi(args[++argidx].c_str());
+		return true;
+	}
+	if (args[argidx] == "-src" && argidx+1 < args.size()) {
+		opts.src.insert(args[++argidx]);
+		return true;
+	}
+	if (args[argidx] == "-cfg" && argidx+2 < args.size()) {
+		if (args[argidx+1] == "pick_cover_prcnt") {
+			opts.pick_cover_prcnt = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+		if (args[argidx+1] == "weight_cover") {
+			opts.weight_cover = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+		if (args[argidx+1] == "weight_pq_w") {
+			opts.weight_pq_w = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+		if (args[argidx+1] == "weight_pq_b") {
+			opts.weight_pq_b = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+		if (args[argidx+1] == "weight_pq_c") {
+			opts.weight_pq_c = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+		if (args[argidx+1] == "weight_pq_s") {
+			opts.weight_pq_s = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+		if (args[argidx+1] == "weight_pq_mw") {
+			opts.weight_pq_mw = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+		if (args[argidx+1] == "weight_pq_mb") {
+			opts.weight_pq_mb = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+		if (args[argidx+1] == "weight_pq_mc") {
+			opts.weight_pq_mc = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+		if (args[argidx+1] == "weight_pq_ms") {
+			opts.weight_pq_ms = atoi(args[argidx+2].c_str());
+			argidx += 2;
+			return true;
+		}
+	}
+	return false;
+}
+
+void mutate_apply(Design *design, const mutate_opts_t &opts)
+{
+	if (opts.mode == "none") {
+		if (!opts.ctrl_name.empty()) {
+			Module *topmod = opts.module.empty() ? design->top_module() : design->module(opts.module);
+			if (topmod)
+				mutate_ctrl_sig(topmod, opts.ctrl_name, opts.ctrl_width);
+		}
+		return;
+	}
+
+	if (opts.module.empty())
+		log_cmd_error("Missing -module argument.\n");
+
+	Module *module = design->module(opts.module);
+	if (module == nullptr)
+		log_cmd_error("Module %s not found.\n", log_id(opts.module));
+
+	if (opts.cell.empty())
+		log_cmd_error("Missing -cell argument.\n");
+
+	Cell *cell = module->cell(opts.cell);
+	if (cell == nullptr)
+		log_cmd_error("Cell %s not found in module %s.\n", log_id(opts.cell), log_id(opts.module));
+
+	if (opts.port.empty())
+		log_cmd_error("Missing -port argument.\n");
+
+	if (!cell->hasPort(opts.port))
+		log_cmd_error("Port %s not found on cell %s.%s.\n", log_id(opts.port), log_id(opts.module), log_id(opts.cell));
+
+	if (opts.portbit < 0)
+		log_cmd_error("Missing -portbit argument.\n");
+
+	if (GetSize(cell->getPort(opts.port)) <= opts.portbit)
+		log_cmd_error("Out-of-range -portbit argument for port %s on cell %s.%s.\n", log_id(opts.port), log_id(opts.module), log_id(opts.cell));
+
+	if (opts.mode == "inv") {
+		mutate_inv(design, opts);
+		return;
+	}
+
+	if (opts.mode == "const0" || opts.mode == "const1") {
+		mutate_const(design, opts, opts.mode == "const1");
+		return;
+	}
+
+	if (opts.ctrlbit < 0)
+		log_cmd_error("Missing -ctrlbit argument.\n");
+
+	if (GetSize(cell->getPort(opts.port)) <= opts.ctrlbit)
+		log_cmd_error("Out-of-range -ctrlbit argument for port %s on cell %s.%s.\n", log_id(opts.port), log_id(opts.module), log_id(opts.cell));
+
+	if (opts.mode == "cnot0" || opts.mode == "cnot1") {
+		mutate_cnot(design, opts, opts.mode == "cnot1");
+		return;
+	}
+
+	log_cmd_error("Invalid mode: %s\n", opts.mode.c_str());
+}
+
+std::vector<mutate_opts_t> mutate_read_list(const std::string &filename)
+{
+	std::ifstream fin(filename);
+	if (!fin.is_open())
+		log_cmd_error("Could not open file \"%s\" with read access.\n", filename.c_str());
+
+	std::vector<mutate_opts_t> list;
+	std::string line;
+	while (std::getline(fin, line))
+	{
+		std::vector<std::string> args = split_tokens(line);
+		if (args.empty() || args[0][0] == '#')
+			continue;
+		if (args[0] != "mutate")
+			log_cmd_error("Unexpected line in mutation list: %s\n", line.c_str());
+
+		mutate_opts_t opts;
+		for (size_t argidx = 1; argidx < args.size(); argidx++)
+			if (!mutate_parse_opt(args, argidx, opts))
+				log_cmd_error("Unexpected argument %s in mutation list: %s\n", args[argidx].c_str(), line.c_str());
+
+		if (opts.ctrl_name.empty())
+			log_cmd_error("Mutation without -ctrl in mutation list: %s\n", line.c_str());
+		if (!list.empty() && (opts.ctrl_name != list.front().ctrl_name || opts.ctrl_width != list.front().ctrl_width))
+			log_cmd_error("All mutations in the list must use the same -ctrl signal: %s\n", line.c_str());
+		list.push_back(opts);
+	}
+	return list;
+}
+
+// Apply all mutations of a list to the design at once, each one active for
+// its own value of the ctrl signal.
+void mutate_apply_list(Design *design, const std::vector<mutate_opts_t> &list)
+{
+	for (auto &opts : list)
+		mutate_apply(design, opts);
+	log("Applied %d mutations.\n", GetSize(list));
+}
+
+// Simulate a design with all mutations applied (see mutate_apply_list) with
+// random input patterns and check which of the mutations change an output.
+// Every mutation runs in its own lane of a ConstEval64, so 63 mutations and
+// the unmutated design in lane 0 are simulated together.
+void mutate_eval(Design *design, const mutate_opts_t &opts, const std::vector<mutate_opts_t> &list, const std::string &filename, int cycles)
+{
+	Module *module = design->top_module();
+	if (module == nullptr)
+		log_cmd_error("No top module found.\n");
+	if (list.empty())
+		log_cmd_error("Empty mutation list.\n");
+
+	IdString ctrl_name = list.front().ctrl_name;
+	int ctrl_width = list.front().ctrl_width;
+
+	Wire *ctrl_wire = module->wire(ctrl_name);
+	if (ctrl_wire == nullptr || !ctrl_wire->port_input || GetSize(ctrl_wire) != ctrl_width)
+		log_cmd_error("Module %s has no %d bit ctrl input %s. Apply the mutations with -apply first.\n",
+				log_id(module), ctrl_width, log_id(ctrl_name));
+	if (ctrl_width > 30)
+		log_cmd_error("Ctrl signal %s is too wide.\n", log_id(ctrl_name));
+
+	// the unmutated design is selected by the ctrl value of a "none"
+	// mutation, or by the first value that no mutation uses
+	std::vector<int> mutants;
+	pool<int> used_values;
+	int none_value = -1;
+	for (auto &entry : list) {
+		used_values.insert(entry.ctrl_value);
+		if (entry.mode == "none")
+			none_value = entry.ctrl_value;
+		else
+			mutants.push_back(entry.ctrl_value);
+	}
+	if (none_value < 0)
+		for (none_value = 0; used_values.count(none_value); none_value++) { }
+	if (none_value >= (1 << ctrl_width))
+		log_cmd_error("No ctrl value is left for the unmutated design.\n");
+
+	SigMap sigmap(module);
+	FfInitVals initvals(&sigmap, module);
+	std::vector<FfData> ffs;
+	std::vector<SigBit> input_bits, output_bits;
+
+	for (auto cell : module->cells())
+	{
+		if (design->module(cell->type) != nullptr)
+			log_cmd_error("Module %s contains an instance of %s. Flatten the design first.\n", log_id(module), log_id(cell->type));
+		if (cell->is_mem_cell())
+			log_cmd_error("Module %s contains memory %s. Run memory_map first.\n", log_id(module), log_id(cell));
+		if (!RTLIL::builtin_ff_cell_types().count(cell->type))
+			continue;
+
+		FfData ff(&initvals, cell);
+		if (ff.has_arst || ff.has_aload || ff.has_sr || (!ff.has_clk && !ff.has_gclk))
+			log_cmd_error("Flip-flop %s of type %s is not supported. Run async2sync or dffunmap first.\n", log_id(cell), log_id(cell->type));
+		ffs.push_back(ff);
+	}
+
+	for (auto wire : module->wires()) {
+		if (wire->port_input && wire != ctrl_wire)
+			for (auto bit : SigSpec(wire))
+				input_bits.push_back(bit);
+		if (wire->port_output)
+			for (auto bit : SigSpec(wire))
+				output_bits.push_back(bit);
+	}
+
+	log("Simulating %d mutations for %d cycles with %s as unmutated ctrl value %d.\n",
+			GetSize(mutants), cycles, log_id(ctrl_name), none_value);
+
+	const int lanes_per_batch = 63;
+	int num_batches = (GetSize(mutants) + lanes_per_batch - 1) / lanes_per_batch;
+	std::vector<uint64_t> killed(num_batches);
+
+	auto eval_lanes = [&](ConstEval64 &ce, const SigSpec &sig, std::vector<uint64_t> &lanes) {
+		SigSpec undef;
+		if (!ce.eval(sig, lanes, undef))
+			log_cmd_error("Failed to evaluate %s in module %s: missing value for %s.\n", log_signal(sig), log_id(module), log_signal(undef));
+	};
+
+	Pass::parallel_for(design, num_batches, [&](int batch)
+	{
+		int first = batch * lanes_per_batch;
+		int num_lanes = 1 + std::min(lanes_per_batch, GetSize(mutants) - first);
+		uint64_t lane_mask = num_lanes == 64 ? ~uint64_t(0) : (uint64_t(1) << num_lanes) - 1;
+
+		std::vector<uint64_t> ctrl_lanes(ctrl_width);
+		for (int lane = 0; lane < num_lanes; lane++) {
+			int value = lane == 0 ? none_value : mutants[first + lane - 1];
+			for (int i = 0; i < ctrl_width; i++)
+				if ((value >> i) & 1)
+					ctrl_lanes[i] |= uint64_t(1) << lane;
+		}
+
+		std::vector<std::vector<uint64_t>> state;
+		for (auto &ff : ffs) {
+			state.emplace_back();
+			for (auto bit : ff.val_init)
+				state.back().push_back(bit == State::S1 ? ~uint64_t(0) : 0);
+		}
+
+		ConstEval64 ce(module);
+		xs128_t rng(opts.seed);
+		uint64_t batch_killed = 0;
+		std::vector<uint64_t> lanes, d, en, rst;
+
+		for (int cycle = 0; cycle < cycles && batch_killed != (lane_mask & ~uint64_t(1)); cycle++)
+		{
+			ce.clear();
+			ce.set(SigSpec(ctrl_wire), ctrl_lanes);
+			for (auto bit : input_bits)
+				ce.set(bit, (rng() & 1) ? ~uint64_t(0) : 0);
+			for (int i = 0; i < GetSize(ffs); i++)
+				ce.set(ffs[i].sig_q, state[i]);
+
+			// a lane is killed when an output differs from lane 0
+			eval_lanes(ce, output_bits, lanes);
+			for (auto word : lanes)
+				batch_killed |= (word ^ (0 - (word & 1))) & lane_mask;
+
+			std::vector<std::vector<uint64_t>> next_state(GetSize(ffs));
+			for (int i = 0; i < GetSize(ffs); i++)
+			{
+				auto &ff = ffs[i];
+				eval_lanes(ce, ff.sig_d, d);
+				uint64_t en_lanes = ~uint64_t(0), rst_lanes = 0;
+				if (ff.has_ce) {
+					eval_lanes(ce, ff.sig_ce, en);
+					en_lanes = ff.pol_ce ? en[0] : ~en[0];
+				}
+				if (ff.has_srst) {
+					eval_lanes(ce, ff.sig_srst, rst);
+					rst_lanes = ff.pol_srst ? rst[0] : ~rst[0];
+					if (ff.ce_over_srst)
+						rst_lanes &= en_lanes;
+				}
+				next_state[i].resize(GetSize(d));
+				for (int j = 0; j < GetSize(d); j++) {
+					uint64_t value = (en_lanes & d[j]) | (~en_lanes & state[i][j]);
+					if (ff.has_srst) {
+						uint64_t srst_value = ff.val_srst[j] == State::S1 ? ~uint64_t(0) : 0;
+						value = (rst_lanes & srst_value) | (~rst_lanes & value);
+					}
+					next_state[i][j] = value;
+				}
+			}
+			state.swap(next_state);
+		}
+
+		killed[batch] = batch_killed;
+	});
+
+	std::ofstream fout;
+	if (!filename.empty()) {
+		fout.open(filename, std::ios::out | std::ios::trunc);
+		if (!fout.is_open())
+			log_error("Could not open file \"%s\" with write access.\n", filename.c_str());
+	}
+
+	int killed_cnt = 0;
+	for (int i = 0; i < GetSize(mutants); i++) {
+		bool is_killed = (killed[i / lanes_per_batch] >> (1 + i % lanes_per_batch)) & 1;
+		killed_cnt += is_killed;
+		string str = stringf("%d %s", mutants[i], is_killed ? "killed" : "survived");
+		if (filename.empty())
+			log("%s\n", str.c_str());
+		else
+			fout << str << std::endl;
+	}
+
+	log("Killed %d of %d mutations (%.2f%%).\n", killed_cnt, GetSize(mutants),
+			mutants.empty() ? 0.0 : 100.0 * killed_cnt / GetSize(mutants));
+}
+
 struct MutatePass : public Pass {
 	MutatePass() : Pass("mutate", "generate or apply design mutations") { }
 	void help() override
@@ -791,12 +1176,46 @@ struct MutatePass : public Pass {
 		log("    -src string\n");
 		log("        Ignored. (They are generated by -list for documentation purposes.)\n");
 		log("\n");
+		log("\n");
+		log("    mutate -apply filename\n");
+		log("\n");
+		log("Apply all mutations of a list generated with 'mutate -list N -ctrl ...' to one\n");
+		log("design. Every mutation is active for its own value of the ctrl signal, so the\n");
+		log("resulting design contains all mutants at once.\n");
+		log("\n");
+		log("\n");
+		log("    mutate -eval filename [options]\n");
+		log("\n");
+		log("Simulate the top module of a design prepared with 'mutate -apply' (and then\n");
+		log("flattened) with random input patterns, and report for each mutation of the\n");
+		log("list whether it changes an output of the module (\"killed\") or not\n");
+		log("(\"survived\"). Each mutation is simulated in its own lane of a 64-bit wide\n");
+		log("bit-parallel simulator, so 63 mutations are evaluated together with the\n");
+		log("unmutated design. The unmutated design is selected by the ctrl value of the\n");
+		log("\"none\" mutation of the list, or else by the first unused ctrl value.\n");
+		log("\n");
+		log("All flip-flops are clocked by one implicit clock, every cycle is one clock\n");
+		log("edge and presents new random values on all inputs. Flip-flops with async\n");
+		log("reset or load and memories are not supported.\n");
+		log("\n");
+		log("    -cycles N\n");
+		log("        Number of cycles to simulate (default: 100)\n");
+		log("\n");
+		log("    -seed N\n");
+		log("        RNG seed for the input patterns\n");
+		log("\n");
+		log("    -o filename\n");
+		log("        Write the results to this file instead of console output\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		mutate_opts_t opts;
 		string filename;
 		string srcsfile;
+		string listfile;
+		bool eval_list = false;
+		int cycles = 100;
 		int N = -1;
 
 		log_header(design, "Executing MUTATE pass.\n");
@@ -816,108 +1235,21 @@ struct MutatePass : public Pass {
 				srcsfile = args[++argidx];
 				continue;
 			}
-			if (args[argidx] == "-seed" && argidx+1 < args.size()) {
-				opts.seed = atoi(args[++argidx].c_str());
-				continue;
-			}
-			if (args[argidx] == "-none") {
-				opts.none = true;
+			if (args[argidx] == "-apply" && argidx+1 < args.size()) {
+				listfile = args[++argidx];
 				continue;
 			}
-			if (args[argidx] == "-mode" && argidx+1 < args.size()) {
-				opts.mode = args[++argidx];
+			if (args[argidx] == "-eval" && argidx+1 < args.size()) {
+				listfile = args[++argidx];
+				eval_list = true;
 				continue;
 			}
-			if (args[argidx] == "-ctrl" && argidx+3 < args.size()) {
-				opts.ctrl_name = RTLIL::escape_id(args[++argidx]);
-				opts.ctrl_width = atoi(args[++argidx].c_str());
-				opts.ctrl_value = atoi(args[++argidx].c_str());
+			if (args[argidx] == "-cycles" && argidx+1 < args.size()) {
+				cycles = atoi(args[++argidx].c_str());
 				continue;
 			}
-			if (args[argidx] == "-module" && argidx+1 < args.size()) {
-				opts.module = RTLIL::escape_id(args[++argidx]);
+			if (mutate_parse_opt(args, argidx, opts))
 				continue;
-			}
-			if (args[argidx] == "-cell" && argidx+1 < args.size()) {
-				opts.cell = RTLIL::escape_id(args[++argidx]);
-				continue;
-			}
-			if (args[argidx] == "-port" && argidx+1 < args.size()) {
-				opts.port = RTLIL::escape_id(args[++argidx]);
-				continue;
-			}
-			if (args[argidx] == "-portbit" && argidx+1 < args.size()) {
-				opts.portbit = atoi(args[++argidx].c_str());
-				continue;
-			}
-			if (args[argidx] == "-ctrlbit" && argidx+1 < args.size()) {
-				opts.ctrlbit = atoi(args[++argidx].c_str());
-				continue;
-			}
-			if (args[argidx] == "-wire" && argidx+1 < args.size()) {
-				opts.wire = RTLIL::escape_id(args[++argidx]);
-				continue;
-			}
-			if (args[argidx] == "-wirebit" && argidx+1 < args.size()) {
-				opts.wirebit = atoi(args[++argidx].c_str());
-				continue;
-			}
-			if (args[argidx] == "-src" && argidx+1 < args.size()) {
-				opts.src.insert(args[++argidx]);
-				continue;
-			}
-			if (args[argidx] == "-cfg" && argidx+2 < args.size()) {
-				if (args[argidx+1] == "pick_cover_prcnt") {
-					opts.pick_cover_prcnt = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-				if (args[argidx+1] == "weight_cover") {
-					opts.weight_cover = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-				if (args[argidx+1] == "weight_pq_w") {
-					opts.weight_pq_w = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-				if (args[argidx+1] == "weight_pq_b") {
-					opts.weight_pq_b = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-				if (args[argidx+1] == "weight_pq_c") {
-					opts.weight_pq_c = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-				if (args[argidx+1] == "weight_pq_s") {
-					opts.weight_pq_s = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-				if (args[argidx+1] == "weight_pq_mw") {
-					opts.weight_pq_mw = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-				if (args[argidx+1] == "weight_pq_mb") {
-					opts.weight_pq_mb = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-				if (args[argidx+1] == "weight_pq_mc") {
-					opts.weight_pq_mc = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-				if (args[argidx+1] == "weight_pq_ms") {
-					opts.weight_pq_ms = atoi(args[argidx+2].c_str());
-					argidx += 2;
-					continue;
-				}
-			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -927,63 +1259,16 @@ struct MutatePass : public Pass {
 			return;
 		}
 
-		if (opts.mode == "none") {
-			if (!opts.ctrl_name.empty()) {
-				Module *topmod = opts.module.empty() ? design->top_module() : design->module(opts.module);
-				if (topmod)
-					mutate_ctrl_sig(topmod, opts.ctrl_name, opts.ctrl_width);
-			}
-			return;
-		}
-
-		if (opts.module.empty())
-			log_cmd_error("Missing -module argument.\n");
-
-		Module *module = design->module(opts.module);
-		if (module == nullptr)
-			log_cmd_error("Module %s not found.\n", log_id(opts.module));
-
-		if (opts.cell.empty())
-			log_cmd_error("Missing -cell argument.\n");
-
-		Cell *cell = module->cell(opts.cell);
-		if (cell == nullptr)
-			log_cmd_error("Cell %s not found in module %s.\n", log_id(opts.cell), log_id(opts.module));
-
-		if (opts.port.empty())
-			log_cmd_error("Missing -port argument.\n");
-
-		if (!cell->hasPort(opts.port))
-			log_cmd_error("Port %s not found on cell %s.%s.\n", log_id(opts.port), log_id(opts.module), log_id(opts.cell));
-
-		if (opts.portbit < 0)
-			log_cmd_error("Missing -portbit argument.\n");
-
-		if (GetSize(cell->getPort(opts.port)) <= opts.portbit)
-			log_cmd_error("Out-of-range -portbit argument for port %s on cell %s.%s.\n", log_id(opts.port), log_id(opts.module), log_id(opts.cell));
-
-		if (opts.mode == "inv") {
-			mutate_inv(design, opts);
-			return;
-		}
-
-		if (opts.mode == "const0" || opts.mode == "const1") {
-			mutate_const(design, opts, opts.mode == "const1");
-			return;
-		}
-
-		if (opts.ctrlbit < 0)
-			log_cmd_error("Missing -ctrlbit argument.\n");
-
-		if (GetSize(cell->getPort(opts.port)) <= opts.ctrlbit)
-			log_cmd_error("Out-of-range -ctrlbit argument for port %s on cell %s.%s.\n", log_id(opts.port), log_id(opts.module), log_id(opts.cell));
-
-		if (opts.mode == "cnot0" || opts.mode == "cnot1") {
-			mutate_cnot(design, opts, opts.mode == "cnot1");
+		if (!listfile.empty()) {
+			std::vector<mutate_opts_t> list = mutate_read_list(listfile);
+			if (eval_list)
+				mutate_eval(design, opts, list, filename, cycles);
+			else
+				mutate_apply_list(design, list);
 			return;
 		}
 
-		log_cmd_error("Invalid mode: %s\n", opts.mode.c_str());
+		mutate_apply(design, opts);
 	}
 } MutatePass;
 
@@ -20,6 +20,11 @@
 #include "kernel/yosys.h"
 #include "kernel/consteval.h"
 #include "qbfsat.h"
+#include <mutex>
+
+#ifndef _WIN32
+#  include <signal.h>
+#endif
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -211,24 +216,31 @@ void assume_miter_outputs(RTLIL::Module *module, bool assume_neg) {
 	module->addAssume("$assume_qbfsat_miter_outputs", wires_to_assume[0], RTLIL::S1);
 }
 
-QbfSolutionType call_qbf_solver(RTLIL::Module *mod, const QbfSolveOptions &opt, const std::string &tempdir_name, const bool quiet = false, const int iter_num = 0) {
+void write_qbf_problem(RTLIL::Module *mod, const QbfSolveOptions &opt, const std::string &problem_file) {
+	std::string smt2_command = "write_smt2 -stbv -wires ";
+	for (auto &solver_opt : opt.solver_options)
+		smt2_command += stringf("-solver-option %s %s ", solver_opt.first.c_str(), solver_opt.second.c_str());
+	smt2_command += problem_file;
+	Pass::call(mod->design, smt2_command);
+}
+
+QbfSolutionType run_qbf_solver(const QbfSolveOptions &opt, const std::string &problem_file, const bool quiet,
+		const std::string &dump_smt2_file, const std::string &pid_file = "", const std::function<void()> &on_line = std::function<void()>()) {
 	//Execute and capture stdout from `yosys-smtbmc -s z3 -t 1 -g --binary [--dump-smt2 <file>]`
 	QbfSolutionType ret;
 	const std::string yosys_smtbmc_exe = proc_self_dirname() + "yosys-smtbmc";
 	const std::string smtbmc_warning = "z3: WARNING:";
-	const std::string smtbmc_cmd = stringf("\"%s\" -s %s %s -t 1 -g --binary %s %s/problem%d.smt2 2>&1",
+	std::string smtbmc_cmd = stringf("\"%s\" -s %s %s -t 1 -g --binary %s %s 2>&1",
 			yosys_smtbmc_exe.c_str(), opt.get_solver_name().c_str(),
 			(opt.timeout != 0? stringf("--timeout %d", opt.timeout) : "").c_str(),
-			(opt.dump_final_smt2? "--dump-smt2 " + opt.dump_final_smt2_file : "").c_str(),
-			tempdir_name.c_str(), iter_num);
-
-	std::string smt2_command = "write_smt2 -stbv -wires ";
-	for (auto &solver_opt : opt.solver_options)
-		smt2_command += stringf("-solver-option %s %s ", solver_opt.first.c_str(), solver_opt.second.c_str());
-	smt2_command += stringf("%s/problem%d.smt2", tempdir_name.c_str(), iter_num);
-	Pass::call(mod->design, smt2_command);
-
-	auto process_line = [&ret, &smtbmc_warning, &opt, &quiet](const std::string &line) {
+			(!dump_smt2_file.empty()? "--dump-smt2 " + dump_smt2_file : "").c_str(),
+			problem_file.c_str());
+#ifndef _WIN32
+	if (!pid_file.empty())
+		smtbmc_cmd = stringf("echo $$ > \"%s\" && exec %s", pid_file.c_str(), smtbmc_cmd.c_str());
+#endif
+
+	auto process_line = [&ret, &smtbmc_warning, &opt, &quiet, &on_line](const std::string &line) {
 		ret.stdout_lines.push_back(line.substr(0, line.size()-1)); //don't include trailing newline
 		auto warning_pos = line.find(smtbmc_warning);
 		if (warning_pos != std::string::npos)
@@ -236,8 +248,9 @@ QbfSolutionType call_qbf_solver(RTLIL::Module *mod, const QbfSolveOptions &opt,
 		else
 			if (opt.show_smtbmc && !quiet)
 				log("smtbmc output: %s", line.c_str());
+		if (on_line)
+			on_line();
 	};
-	log_header(mod->design, "Solving QBF-SAT problem.\n");
 	if (!quiet) log("Launching \"%s\".\n", smtbmc_cmd.c_str());
 	int64_t begin = PerformanceTimer::query();
 	run_command(smtbmc_cmd, process_line);
@@ -249,6 +262,149 @@ QbfSolutionType call_qbf_solver(RTLIL::Module *mod, const QbfSolveOptions &opt,
 	return ret;
 }
 
+QbfSolutionType call_qbf_solver(RTLIL::Module *mod, const QbfSolveOptions &opt, const std::string &tempdir_name, const bool quiet = false, const int iter_num = 0) {
+	const std::string problem_file = stringf("%s/problem%d.smt2", tempdir_name.c_str(), iter_num);
+	write_qbf_problem(mod, opt, problem_file);
+	log_header(mod->design, "Solving QBF-SAT problem.\n");
+	return run_qbf_solver(opt, problem_file, quiet, opt.dump_final_smt2? opt.dump_final_smt2_file : "");
+}
+
+//Pick the bits that are fixed in each cube: the most significant bits of the $anyconst cells, taken
+//alternately from all of them and starting with the widest.
+std::vector<std::pair<RTLIL::IdString, int>> select_cube_bits(RTLIL::Module *module, int num_bits) {
+	std::vector<RTLIL::Cell *> anyconsts;
+	for (auto cell : module->cells())
+		if (cell->type == "$anyconst")
+			anyconsts.push_back(cell);
+	std::sort(anyconsts.begin(), anyconsts.end(), [](RTLIL::Cell *a, RTLIL::Cell *b) {
+		int width_a = GetSize(a->getPort(ID::Y)), width_b = GetSize(b->getPort(ID::Y));
+		return width_a != width_b? width_a > width_b : a->name.str() < b->name.str();
+	});
+
+	std::vector<std::pair<RTLIL::IdString, int>> cube_bits;
+	for (int round = 0; GetSize(cube_bits) < num_bits; ++round) {
+		bool found_bit = false;
+		for (auto cell : anyconsts) {
+			RTLIL::SigSpec port_y = cell->getPort(ID::Y);
+			if (round >= GetSize(port_y) || GetSize(cube_bits) >= num_bits)
+				continue;
+			RTLIL::SigBit bit = port_y[GetSize(port_y) - 1 - round];
+			if (bit.wire != nullptr) {
+				cube_bits.push_back(std::make_pair(bit.wire->name, bit.offset));
+				found_bit = true;
+			}
+		}
+		if (!found_bit)
+			break;
+	}
+	return cube_bits;
+}
+
+//Cube-and-conquer: split the existential space into 2^n cubes by fixing n bits of the $anyconst cells
+//and solve the cubes with parallel solver processes. The problem is SAT if any cube is SAT (the other
+//solvers are then stopped), and UNSAT if all cubes are UNSAT.
+QbfSolutionType call_qbf_solver_cubes(RTLIL::Module *mod, const QbfSolveOptions &opt, const std::string &tempdir_name, const int iter_num = 0) {
+	RTLIL::Design *design = mod->design;
+	std::string module_name = mod->name.str();
+	auto cube_bits = select_cube_bits(mod, opt.cube_bits);
+	int num_cubes = 1 << GetSize(cube_bits);
+
+	if (GetSize(cube_bits) < opt.cube_bits)
+		log_warning("Only found %d $anyconst bits to split on.\n", GetSize(cube_bits));
+	log("Splitting the problem into %d cubes on:", num_cubes);
+	for (auto &it : cube_bits)
+		log(" %s[%d]", log_id(it.first), it.second);
+	log("\n");
+
+	std::vector<std::string> problem_files;
+	for (int cube = 0; cube < num_cubes; ++cube) {
+		Pass::call(design, "design -push-copy");
+		RTLIL::Module *module = design->module(module_name);
+		RTLIL::SigSpec cube_sig;
+		for (auto &it : cube_bits)
+			cube_sig.append(RTLIL::SigBit(module->wire(it.first), it.second));
+		module->addAssume(NEW_ID, module->Eq(NEW_ID, cube_sig, RTLIL::Const(cube, GetSize(cube_sig))), RTLIL::State::S1);
+		problem_files.push_back(stringf("%s/problem%d_cube%d.smt2", tempdir_name.c_str(), iter_num, cube));
+		write_qbf_problem(module, opt, problem_files.back());
+		Pass::call(design, "design -pop");
+	}
+
+	log_header(design, "Solving QBF-SAT problem in %d cubes.\n", num_cubes);
+	std::vector<QbfSolutionType> results(num_cubes);
+	std::vector<int> pids(num_cubes, 0);
+	std::atomic<bool> found_sat(false);
+	std::mutex pids_mutex;
+
+	//Stop the yosys-smtbmc processes of the other cubes, which then shut down their solvers.
+	auto cancel_running = [&]() {
+#ifndef _WIN32
+		std::lock_guard<std::mutex> lock(pids_mutex);
+		for (int cube = 0; cube < num_cubes; ++cube) {
+			if (pids[cube] > 0)
+				kill(pids[cube], SIGTERM);
+			pids[cube] = -1;
+		}
+#endif
+	};
+
+	int64_t begin = PerformanceTimer::query();
+	Pass::parallel_for(design, num_cubes, [&](int cube) {
+		QbfSolutionType &ret = results[cube];
+		if (found_sat.load()) {
+			log("Cube %d: skipped.\n", cube);
+			return;
+		}
+
+		//The shell writes its PID before it execs yosys-smtbmc, so the file is complete once
+		//the first output line arrives.
+		std::string pid_file = problem_files[cube] + ".pid";
+		bool pid_read = false;
+		auto on_line = [&]() {
+#ifndef _WIN32
+			if (pid_read)
+				return;
+			pid_read = true;
+			std::ifstream fin(pid_file.c_str());
+			int pid = 0;
+			if (!(fin >> pid))
+				return;
+			std::lock_guard<std::mutex> lock(pids_mutex);
+			if (pids[cube] < 0 || found_sat.load())
+				kill(pid, SIGTERM);
+			else
+				pids[cube] = pid;
+#endif
+		};
+
+		std::string dump_file = opt.dump_final_smt2? stringf("%s.cube%d", opt.dump_final_smt2_file.c_str(), cube) : "";
+		ret = run_qbf_solver(opt, problem_files[cube], true, dump_file, pid_file, on_line);
+		{
+			std::lock_guard<std::mutex> lock(pids_mutex);
+			if (pids[cube] > 0)
+				pids[cube] = 0;
+		}
+
+		log("Cube %d: %s (%.3f seconds).\n", cube, ret.unknown? "unknown" : ret.sat? "SAT" : "UNSAT", ret.solver_time);
+		if (!ret.unknown && ret.sat && !found_sat.exchange(true))
+			cancel_running();
+	}, opt.cube_jobs);
+	int64_t end = PerformanceTimer::query();
+
+	QbfSolutionType ret;
+	ret.unknown = false;
+	for (auto &result : results) {
+		if (!result.unknown && result.sat) {
+			ret = result;
+			break;
+		}
+		if (result.unknown)
+			ret.unknown = true;
+	}
+	ret.solver_time = (end - begin) / 1e9f;
+	log("Solved %d cubes in %.3f seconds.\n", num_cubes, ret.solver_time);
+	return ret;
+}
+
 QbfSolutionType qbf_solve(RTLIL::Module *mod, const QbfSolveOptions &opt) {
 	QbfSolutionType ret, best_soln;
 	const std::string tempdir_name = make_temp_dir(get_base_tmpdir() + "/yosys-qbfsat-XXXXXX");
@@ -292,7 +448,8 @@ QbfSolutionType qbf_solve(RTLIL::Module *mod, const QbfSolveOptions &opt) {
 	}
 
 	if (opt.nobisection || opt.nooptimize || wire_to_optimize_name == "") {
-		ret = call_qbf_solver(module, opt, tempdir_name, false, 0);
+		ret = opt.cube_bits > 0? call_qbf_solver_cubes(module, opt, tempdir_name, 0)
+		                       : call_qbf_solver(module, opt, tempdir_name, false, 0);
 	} else {
 		//Do the iterated bisection method:
 		unsigned int iter_num = 1;
@@ -318,7 +475,8 @@ QbfSolutionType qbf_solve(RTLIL::Module *mod, const QbfSolveOptions &opt) {
 				log("Trying to solve with %s %s %d.\n", wire_to_optimize_name.c_str(), (maximize? ">=" : "<="), cur_thresh);
 			}
 
-			ret = call_qbf_solver(module, opt, tempdir_name, false, iter_num);
+			ret = opt.cube_bits > 0? call_qbf_solver_cubes(module, opt, tempdir_name, iter_num)
+			                       : call_qbf_solver(module, opt, tempdir_name, false, iter_num);
 			Pass::call(design, "design -pop");
 			module = design->module(module_name);
 
@@ -460,6 +618,22 @@ QbfSolveOptions parse_args(const std::vector<std::string> &args) {
 			}
 			continue;
 		}
+		else if (args[opt.argidx] == "-cubes") {
+			if (args.size() <= opt.argidx + 1)
+				log_cmd_error("number of cube bits not specified.\n");
+			opt.cube_bits = atoi(args[++opt.argidx].c_str());
+			if (opt.cube_bits < 1 || opt.cube_bits > 16)
+				log_cmd_error("number of cube bits must be between 1 and 16.\n");
+			continue;
+		}
+		else if (args[opt.argidx] == "-j") {
+			if (args.size() <= opt.argidx + 1)
+				log_cmd_error("number of jobs not specified.\n");
+			opt.cube_jobs = atoi(args[++opt.argidx].c_str());
+			if (opt.cube_jobs < 1)
+				log_cmd_error("number of jobs must be greater than 0.\n");
+			continue;
+		}
 		else if (args[opt.argidx] == "-sat") {
 			opt.sat = true;
 			continue;
@@ -557,6 +731,17 @@ struct QbfSatPass : public Pass {
 		log("    -O0, -O1, -O2\n");
 		log("        Control the use of ABC to simplify the QBF-SAT problem before solving.\n");
 		log("\n");
+		log("    -cubes <n>\n");
+		log("        Split the problem into 2^n cubes by fixing n of the most significant\n");
+		log("        bits of the \"$anyconst\" cells, and solve the cubes with parallel\n");
+		log("        solver processes. When one cube is satisfiable, the solvers for the\n");
+		log("        remaining cubes are stopped. The problem is unsatisfiable only if all\n");
+		log("        cubes are. -timeout applies to each cube. (default: no splitting)\n");
+		log("\n");
+		log("    -j <num>\n");
+		log("        With -cubes, run up to <num> solver processes at the same time.\n");
+		log("        (default: the number of threads set with 'yosys -j')\n");
+		log("\n");
 		log("    -sat\n");
 		log("        Generate an error if the solver does not return \"sat\".\n");
 		log("\n");
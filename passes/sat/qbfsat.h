@@ -33,6 +33,7 @@ struct QbfSolveOptions {
 	enum OptimizationLevel{O0, O1, O2} oflag = O0;
 	dict<std::string, std::string> solver_options;
 	int timeout = 0;
+	int cube_bits = 0, cube_jobs = 0;
 	std::string specialize_soln_file = "";
 	std::string write_soln_soln_file = "";
 	std::string dump_final_smt2_file = "";
@@ -23,6 +23,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/utils.h"
 #include "kernel/satgen.h"
+#include "kernel/cellaigs.h"
 
 #include <algorithm>
 #include <queue>
@@ -75,15 +76,76 @@ struct InvBit {
     bool inverted;
 };
 
-typedef uint64_t equiv_cls_t;
-static const int sim_length = sizeof(equiv_cls_t) * 8;
+// The values of a bit in all simulated patterns, 64 patterns per word
+static const int sim_words = 4;
+static const int sim_length = sim_words * 64;
+
+struct equiv_cls_t {
+    uint64_t words[sim_words] = {};
+
+    static equiv_cls_t all(bool value)
+    {
+        equiv_cls_t result;
+        for (auto &word : result.words)
+            word = value ? ~uint64_t(0) : 0;
+        return result;
+    }
+
+    bool get(int t) const { return (words[t / 64] >> (t % 64)) & 1; }
+    void set(int t) { words[t / 64] |= uint64_t(1) << (t % 64); }
+
+    equiv_cls_t operator~() const
+    {
+        equiv_cls_t result;
+        for (int i = 0; i < sim_words; i++)
+            result.words[i] = ~words[i];
+        return result;
+    }
+    equiv_cls_t operator&(const equiv_cls_t &other) const
+    {
+        equiv_cls_t result;
+        for (int i = 0; i < sim_words; i++)
+            result.words[i] = words[i] & other.words[i];
+        return result;
+    }
+
+    bool operator==(const equiv_cls_t &other) const
+    {
+        for (int i = 0; i < sim_words; i++)
+            if (words[i] != other.words[i])
+                return false;
+        return true;
+    }
+    bool operator!=(const equiv_cls_t &other) const { return !(*this == other); }
+    [[nodiscard]] Hasher hash_into(Hasher h) const
+    {
+        for (auto word : words)
+            h.eat(word);
+        return h;
+    }
+
+    int popcount() const
+    {
+        int result = 0;
+        for (auto word : words)
+            result += __builtin_popcountll(word);
+        return result;
+    }
+
+    std::string str() const
+    {
+        std::string result;
+        for (int i = sim_words - 1; i >= 0; i--)
+            result += stringf("%016" PRIx64, words[i]);
+        return result;
+    }
+};
 
 struct RecoverModuleWorker {
     Design *design = nullptr;
     Module *mod, *flat = nullptr;
     RecoverModuleWorker(Module *mod) : design(mod->design), mod(mod) {};
 
-    ConstEval *ce = nullptr;
     SigMap *sigmap = nullptr;
 
     dict<IdBit, SigBit> flat2orig;
@@ -97,7 +159,6 @@ struct RecoverModuleWorker {
         flat = design->addModule(NEW_ID);
         mod->cloneInto(flat);
         Pass::call_on_module(design, flat, "flatten -wb");
-        ce = new ConstEval(flat);
         sigmap = new SigMap(flat);
         // Create a mapping from primary name-bit in the box-flattened module to original sigbit
         SigMap orig_sigmap(mod);
@@ -152,58 +213,8 @@ struct RecoverModuleWorker {
         }
     }
 
-    // Mapping from bit to (candidate) equivalence classes
-    dict<IdBit, equiv_cls_t> bit2cls;
-    void sim_cycle(int t, const dict<IdBit, RTLIL::State> &anchors)
-    {
-        ce->clear();
-        for (auto anchor : anchors) {
-            SigBit bit = (*sigmap)(SigBit(flat->wire(anchor.first.name), anchor.first.bit));
-            // Ignore in the rare case that it's already determined
-            SigSpec res(bit);
-            if (ce->eval(res))
-                continue;
-            ce->set(bit, anchor.second);
-        }
-        // Only evaluate IdBits that exist in the non-flat design; as they are all we care about
-        for (auto idbit : flat2orig) {
-            if (anchors.count(idbit.first))
-                continue;
-            SigBit bit = (*sigmap)(SigBit(flat->wire(idbit.first.name), idbit.first.bit));
-            SigSpec res(bit);
-            if (!ce->eval(res))
-                continue;
-            if (res != State::S0 && res != State::S1)
-                continue;
-            // Update equivalence classes
-            if (res == State::S1)
-                bit2cls[idbit.first] = bit2cls[idbit.first] | (equiv_cls_t(1) << t);
-        }
-    }
-
-    // Update the equivalence class groupings
-    void group_classes(dict<equiv_cls_t, std::pair<pool<IdBit>, pool<InvBit>>> &cls2bits, bool is_gate)
-    {
-        equiv_cls_t all_ones = 0;
-        for (int i = 0; i < sim_length; i++) all_ones |= (equiv_cls_t(1) << i);
-        for (auto pair : bit2cls) {
-            if (pair.second == 0 || pair.second == all_ones)
-                continue; // skip stuck-ats
-            if (is_gate) {
-                // True doesn't exist in gold; but inverted does
-                if (!cls2bits.count(pair.second) && cls2bits.count(pair.second ^ all_ones))
-                    cls2bits[pair.second ^ all_ones].second.emplace(pair.first, true);
-                else
-                    cls2bits[pair.second].second.emplace(pair.first, false);
-            } else {
-                cls2bits[pair.second].first.insert(pair.first);
-            }
-        }
-    }
-
-    // Compute depths of IdBits
-    dict<IdBit, int> bit2depth;
-    void compute_depths(const dict<IdBit, IdBit> &anchor_bits)
+    // The cells of the module in topological order, with the edges through anchor bits removed
+    std::vector<Cell*> sorted_cells(const pool<IdBit> &anchor_bits)
     {
         dict<SigBit, pool<IdString>> bit_drivers, bit_users;
         TopoSort<IdString, RTLIL::sort_by_id_str> toposort;
@@ -234,8 +245,154 @@ struct RecoverModuleWorker {
                     toposort.edge(driver_cell, user_cell);
 
         toposort.sort();
-        for (auto cell_name : toposort.sorted) {
-            Cell *cell = flat->cell(cell_name);
+        std::vector<Cell*> result;
+        for (auto cell_name : toposort.sorted)
+            result.push_back(flat->cell(cell_name));
+        return result;
+    }
+
+    // Cells without an AIG are simulated one pattern at a time, if they are
+    // evaluable and have no other inputs than these
+    bool sim_slow_cell(Cell *cell, dict<SigBit, equiv_cls_t> &values, const pool<SigBit> &anchor_sigbits)
+    {
+        if (!yosys_celltypes.cell_evaluable(cell->type) || !cell->hasPort(ID::Y))
+            return false;
+        for (auto &conn : cell->connections())
+            if (!conn.first.in(ID::A, ID::B, ID::S, ID::Y))
+                return false;
+
+        std::vector<equiv_cls_t> args[3];
+        IdString arg_ports[3] = {ID::A, ID::B, ID::S};
+        for (int i = 0; i < 3; i++) {
+            if (!cell->hasPort(arg_ports[i]))
+                continue;
+            for (auto bit : (*sigmap)(cell->getPort(arg_ports[i]))) {
+                if (bit == State::S0 || bit == State::S1)
+                    args[i].push_back(equiv_cls_t::all(bit == State::S1));
+                else if (values.count(bit))
+                    args[i].push_back(values.at(bit));
+                else
+                    return false;
+            }
+        }
+
+        SigSpec y = (*sigmap)(cell->getPort(ID::Y));
+        std::vector<equiv_cls_t> y_values(GetSize(y));
+        pool<int> y_undef;
+        for (int t = 0; t < sim_length; t++) {
+            Const arg_consts[3];
+            for (int i = 0; i < 3; i++) {
+                std::vector<State> bits;
+                for (auto &value : args[i])
+                    bits.push_back(value.get(t) ? State::S1 : State::S0);
+                arg_consts[i] = Const(bits);
+            }
+            bool err = false;
+            Const result = CellTypes::eval(cell, arg_consts[0], arg_consts[1], arg_consts[2], &err);
+            if (err)
+                return false;
+            for (int i = 0; i < GetSize(y); i++) {
+                State bit = i < GetSize(result) ? result[i] : State::S0;
+                if (bit == State::S1)
+                    y_values[i].set(t);
+                else if (bit != State::S0)
+                    y_undef.insert(i);
+            }
+        }
+        for (int i = 0; i < GetSize(y); i++)
+            if (y[i].wire && !y_undef.count(i) && !anchor_sigbits.count(y[i]))
+                values[y[i]] = y_values[i];
+        return true;
+    }
+
+    // Mapping from bit to (candidate) equivalence classes
+    dict<IdBit, equiv_cls_t> bit2cls;
+
+    // Simulates all patterns at once, with the anchors set to the given values
+    void simulate(const dict<IdBit, equiv_cls_t> &anchors)
+    {
+        dict<SigBit, equiv_cls_t> values;
+        pool<SigBit> anchor_sigbits;
+        pool<IdBit> anchor_bits;
+        for (auto &anchor : anchors) {
+            SigBit bit = (*sigmap)(id2bit(anchor.first));
+            values[bit] = anchor.second;
+            anchor_sigbits.insert(bit);
+            anchor_bits.insert(anchor.first);
+        }
+
+        // Bits that can't be evaluated (e.g. outputs of flip-flops that are
+        // not anchors, or of cells that depend on them) get no value
+        std::vector<equiv_cls_t> node_values;
+        for (auto cell : sorted_cells(anchor_bits)) {
+            const Aig &aig = Aig::cached(cell);
+            if (aig.name.empty()) {
+                sim_slow_cell(cell, values, anchor_sigbits);
+                continue;
+            }
+            node_values.clear();
+            for (auto &node : aig.nodes) {
+                equiv_cls_t value;
+                if (node.portbit >= 0) {
+                    SigBit bit = (*sigmap)(cell->getPort(node.portname)[node.portbit]);
+                    if (bit == State::S0 || bit == State::S1)
+                        value = equiv_cls_t::all(bit == State::S1);
+                    else if (values.count(bit))
+                        value = values.at(bit);
+                    else
+                        goto next_cell;
+                } else if (node.left_parent >= 0 && node.right_parent >= 0) {
+                    value = node_values[node.left_parent] & node_values[node.right_parent];
+                }
+                if (node.inverter)
+                    value = ~value;
+                node_values.push_back(value);
+                for (auto &port : node.outports) {
+                    SigBit bit = (*sigmap)(cell->getPort(port.first)[port.second]);
+                    if (bit.wire && !anchor_sigbits.count(bit))
+                        values[bit] = value;
+                }
+            }
+        next_cell:;
+        }
+
+        // Only IdBits that exist in the non-flat design are of interest
+        for (auto idbit : flat2orig) {
+            if (anchors.count(idbit.first))
+                continue;
+            SigBit bit = (*sigmap)(id2bit(idbit.first));
+            if (values.count(bit))
+                bit2cls[idbit.first] = values.at(bit);
+        }
+    }
+
+    // Update the equivalence class groupings
+    void group_classes(dict<equiv_cls_t, std::pair<pool<IdBit>, pool<InvBit>>> &cls2bits, bool is_gate)
+    {
+        equiv_cls_t all_zeros = equiv_cls_t::all(false), all_ones = equiv_cls_t::all(true);
+        for (auto pair : bit2cls) {
+            if (pair.second == all_zeros || pair.second == all_ones)
+                continue; // skip stuck-ats
+            if (is_gate) {
+                // True doesn't exist in gold; but inverted does
+                if (!cls2bits.count(pair.second) && cls2bits.count(~pair.second))
+                    cls2bits[~pair.second].second.emplace(pair.first, true);
+                else
+                    cls2bits[pair.second].second.emplace(pair.first, false);
+            } else {
+                cls2bits[pair.second].first.insert(pair.first);
+            }
+        }
+    }
+
+    // Compute depths of IdBits
+    dict<IdBit, int> bit2depth;
+    void compute_depths(const dict<IdBit, IdBit> &anchors)
+    {
+        pool<IdBit> anchor_bits;
+        for (auto &anchor : anchors)
+            anchor_bits.insert(anchor.first);
+        for (auto cell : sorted_cells(anchor_bits)) {
             int cell_depth = 0;
             for (auto conn : cell->connections()) {
                 if (!cell->input(conn.first))
@@ -269,9 +426,10 @@ struct RecoverModuleWorker {
 
     // Set up the SAT problem for an IdBit
     // the value side of 'anchors' will be populated with the SAT variable for anchor bits
-    int setup_sat(SatGen *sat, const std::string &prefix, IdBit bit, const dict<IdBit, IdBit> &anchor_bits, dict<IdBit, int> &anchor2var)
+    // 'thread_sigmap' is a copy of 'sigmap' that belongs to the calling thread
+    int setup_sat(SatGen *sat, SigMap *thread_sigmap, const std::string &prefix, IdBit bit, const dict<IdBit, IdBit> &anchor_bits, dict<IdBit, int> &anchor2var)
     {
-        sat->setContext(sigmap, prefix);
+        sat->setContext(thread_sigmap, prefix);
         pool<IdString> imported_cells;
         int result = sat->importSigBit(id2bit(bit));
         // Recursively import driving cells
@@ -302,7 +460,7 @@ struct RecoverModuleWorker {
             for (auto conn : driver->connections()) {
                 if (!driver->input(conn.first))
                     continue;
-                for (SigBit in_bit : (*sigmap)(conn.second)) {
+                for (SigBit in_bit : (*thread_sigmap)(conn.second)) {
                     if (!in_bit.wire)
                         continue;
                     IdBit in_idbit(in_bit.wire->name, in_bit.offset);
@@ -436,7 +594,6 @@ struct RecoverModuleWorker {
 
     ~RecoverModuleWorker()
     {
-        delete ce;
         delete sigmap;
         if (flat)
             design->remove(flat);
@@ -530,26 +687,40 @@ struct RecoverNamesWorker {
         return ((rng_val >> (rng_bit++)) & 0x1) ? RTLIL::State::S1 : RTLIL::State::S0;
     }
 
-    int popcount(equiv_cls_t cls) {
-    	int result = 0;
-    	for (unsigned i = 0; i < 8*sizeof(equiv_cls_t); i++)
-    		if ((cls >> i) & 0x1)
-    			++result;
-    	return result;
+    equiv_cls_t random_cls()
+    {
+        equiv_cls_t result;
+        for (int t = 0; t < sim_length; t++)
+            if (next_randbit() == RTLIL::State::S1)
+                result.set(t);
+        return result;
     }
 
-    bool prove_equiv(RecoverModuleWorker &gold_worker, RecoverModuleWorker &gate_worker,
+    // The SigMaps of the gold and gate modules for one thread
+    struct ThreadSigMaps {
+        SigMap gold, gate;
+        bool ready = false;
+    };
+
+    enum ProofResult {
+        PROVEN,
+        FAILED,
+        GOLD_TOO_LARGE,
+        GATE_TOO_LARGE
+    };
+
+    ProofResult prove_equiv(RecoverModuleWorker &gold_worker, RecoverModuleWorker &gate_worker, ThreadSigMaps &sigmaps,
             const dict<IdBit, IdBit> &gold_anchors, const dict<IdBit, IdBit> &gate_anchors,
             IdBit gold_bit, IdBit gate_bit, bool invert) {
         ezSatPtr ez;
         SatGen satgen(ez.get(), nullptr);
         dict<IdBit, int> anchor2var_gold, anchor2var_gate;
-        int gold_var = gold_worker.setup_sat(&satgen, "gold", gold_bit, gold_anchors, anchor2var_gold);
+        int gold_var = gold_worker.setup_sat(&satgen, &sigmaps.gold, "gold", gold_bit, gold_anchors, anchor2var_gold);
         if (gold_var == -1)
-            return false;
-        int gate_var = gate_worker.setup_sat(&satgen, "gate", gate_bit, gate_anchors, anchor2var_gate);
+            return GOLD_TOO_LARGE;
+        int gate_var = gate_worker.setup_sat(&satgen, &sigmaps.gate, "gate", gate_bit, gate_anchors, anchor2var_gate);
         if (gate_var == -1)
-            return false;
+            return GATE_TOO_LARGE;
         // Assume anchors are equal
         for (auto anchor : anchor2var_gate) {
             IdBit gold_anchor = gate_anchors.at(anchor.first);
@@ -558,7 +729,51 @@ struct RecoverNamesWorker {
             ez->assume(ez->IFF(anchor.second, anchor2var_gold.at(gold_anchor)));
         }
         // Prove equivalence
-        return !ez->solve(ez->NOT(ez->IFF(gold_var, invert ? ez->NOT(gate_var) : gate_var)));
+        return ez->solve(ez->NOT(ez->IFF(gold_var, invert ? ez->NOT(gate_var) : gate_var))) ? FAILED : PROVEN;
+    }
+
+    // The most SAT proofs attempted for one equivalence class; large classes
+    // are mostly made of bits that the simulation could not tell apart
+    const int max_class_proofs = 64;
+
+    // Tries to prove the gate bits of an equivalence class equivalent to its
+    // gold bits, returns the pairs that were proven
+    std::vector<std::pair<IdBit, InvBit>> solve_class(RecoverModuleWorker &gold_worker, RecoverModuleWorker &gate_worker,
+            ThreadSigMaps &sigmaps, const dict<IdBit, IdBit> &gold_anchors, const dict<IdBit, IdBit> &gate_anchors,
+            const equiv_cls_t &cls, const pool<IdBit> &gold_bits, const pool<InvBit> &gate_bits)
+    {
+        std::vector<std::pair<IdBit, InvBit>> result;
+        log_debug("equivalence class: %s\n", cls.str().c_str());
+        // Gate bits that are solved, or whose logic cone is too large for SAT
+        pool<IdBit> done_gate;
+        int proofs = 0;
+        for (IdBit gold_bit : gold_bits) {
+            for (auto gate_bit : gate_bits) {
+                if (done_gate.count(gate_bit.bit))
+                    continue;
+                if (proofs++ == max_class_proofs) {
+                    log_debug("   giving up after %d proofs\n", max_class_proofs);
+                    return result;
+                }
+                log_debug("   attempting to prove %s[%d] == %s%s[%d]\n", log_id(gold_bit.name), gold_bit.bit,
+                    gate_bit.inverted ? "" : "!", log_id(gate_bit.bit.name), gate_bit.bit.bit);
+                ProofResult proof = prove_equiv(gold_worker, gate_worker, sigmaps, gold_anchors, gate_anchors,
+                    gold_bit, gate_bit.bit, gate_bit.inverted);
+                if (proof == GOLD_TOO_LARGE)
+                    break;
+                if (proof == GATE_TOO_LARGE)
+                    done_gate.insert(gate_bit.bit);
+                if (proof != PROVEN)
+                    continue;
+                log_debug("       success!\n");
+                result.emplace_back(gate_bit.bit, InvBit(gold_bit, gate_bit.inverted));
+                done_gate.insert(gate_bit.bit);
+            }
+            // All solved...
+            if (GetSize(done_gate) == GetSize(gate_bits))
+                break;
+        }
+        return result;
     }
 
     void analyse_mod(Module *gate_mod)
@@ -585,17 +800,15 @@ struct RecoverNamesWorker {
                 gate_anchors[gate_bit] = gold_bit.first;
             }
         }
-        // Run a random-value combinational simulation to find candidate equivalence classes
-        dict<IdBit, RTLIL::State> gold_anchor_vals, gate_anchor_vals;
+        // Run a random-value combinational simulation of all patterns at once to find candidate equivalence classes
+        dict<IdBit, equiv_cls_t> gold_anchor_vals, gate_anchor_vals;
         rng_init();
-        for (int t = 0; t < sim_length; t++) {
-            for (auto anchor : gold_anchors) {
-                gold_anchor_vals[anchor.first] = next_randbit();
-                gate_anchor_vals[anchor.second] = gold_anchor_vals[anchor.first];
-            }
-            gold_worker.sim_cycle(t, gold_anchor_vals);
-            gate_worker.sim_cycle(t, gate_anchor_vals);
+        for (auto anchor : gold_anchors) {
+            gold_anchor_vals[anchor.first] = random_cls();
+            gate_anchor_vals[anchor.second] = gold_anchor_vals[anchor.first];
         }
+        gold_worker.simulate(gold_anchor_vals);
+        gate_worker.simulate(gate_anchor_vals);
         log_debug("%d candidate equiv classes in gold; %d in gate\n", GetSize(gold_worker.bit2cls), GetSize(gate_worker.bit2cls));
         // Group bits by equivalence classes together
         dict<equiv_cls_t, std::pair<pool<IdBit>, pool<InvBit>>> cls2bits;
@@ -621,43 +834,52 @@ struct RecoverNamesWorker {
             });
         // The magic result we've worked hard for....
         dict<IdBit, InvBit> gate2gold;
-        // Solve starting from shallowest
-        for (auto cls : cls_depth) {
-        	int pop = popcount(cls.first);
-        	// Equivalence classes with only one set bit are invariably a waste of SAT time
-        	if (pop == 1 || pop == (8*sizeof(equiv_cls_t) - 1))
-        		continue;
-
-        	log_debug("equivalence class: %016" PRIx64 "\n", cls.first);
-            const pool<IdBit> &gold_bits = cls2bits.at(cls.first).first;
-            const pool<InvBit> &gate_bits = cls2bits.at(cls.first).second;
-            if (gold_bits.empty() || gate_bits.empty())
-                continue;
-            pool<IdBit> solved_gate;
-            if (GetSize(gold_bits) > 10)
-                continue; // large equivalence classes are not very interesting; skip
-            for (IdBit gold_bit : gold_bits) {
-                for (auto gate_bit : gate_bits) {
-                    if (solved_gate.count(gate_bit.bit))
-                        continue;
-                    log_debug("   attempting to prove %s[%d] == %s%s[%d]\n", log_id(gold_bit.name), gold_bit.bit,
-                        gate_bit.inverted ? "" : "!", log_id(gate_bit.bit.name), gate_bit.bit.bit);
-                    if (!prove_equiv(gold_worker, gate_worker, gold_anchors, gate_anchors, gold_bit, gate_bit.bit, gate_bit.inverted))
-                        continue;
-                    log_debug("       success!\n");
-                    // Success!
-                    gate2gold[gate_bit.bit] = InvBit(gold_bit, gate_bit.inverted);
-                    if (!gate_bit.inverted) {
+        // Solve starting from shallowest. The classes of the same depth are
+        // solved in parallel, with the anchors found at the lower depths.
+        PerThread<ThreadSigMaps> thread_sigmaps(design);
+        for (int i = 0, j; i < GetSize(cls_depth); i = j) {
+            std::vector<equiv_cls_t> level;
+            for (j = i; j < GetSize(cls_depth) && cls_depth[j].second == cls_depth[i].second; j++) {
+                const equiv_cls_t &cls = cls_depth[j].first;
+                int pop = cls.popcount();
+                // Equivalence classes with only one set bit are invariably a waste of SAT time
+                if (pop == 1 || pop == sim_length - 1)
+                    continue;
+                const pool<IdBit> &gold_bits = cls2bits.at(cls).first;
+                const pool<InvBit> &gate_bits = cls2bits.at(cls).second;
+                if (gold_bits.empty() || gate_bits.empty())
+                    continue;
+                if (GetSize(gold_bits) > 10)
+                    continue; // large equivalence classes are not very interesting; skip
+                level.push_back(cls);
+            }
+
+            // A lookup brings the hashtables of the dicts shared by the threads
+            // up to date, later lookups don't modify them
+            gold_anchors.count(IdBit());
+            gate_anchors.count(IdBit());
+            std::vector<std::vector<std::pair<IdBit, InvBit>>> level_results(GetSize(level));
+            Pass::parallel_for(design, GetSize(level), [&](int k) {
+                ThreadSigMaps &sigmaps = thread_sigmaps.local();
+                if (!sigmaps.ready) {
+                    sigmaps.gold.set(gold_worker.flat);
+                    sigmaps.gate.set(gate_worker.flat);
+                    sigmaps.ready = true;
+                }
+                const auto &bits = cls2bits.at(level[k]);
+                level_results[k] = solve_class(gold_worker, gate_worker, sigmaps, gold_anchors, gate_anchors,
+                    level[k], bits.first, bits.second);
+            });
+
+            for (auto &results : level_results)
+                for (auto &result : results) {
+                    gate2gold[result.first] = result.second;
+                    if (!result.second.inverted) {
                         // Only add as anchor if not inverted
-                        gold_anchors[gold_bit] = gate_bit.bit;
-                        gate_anchors[gate_bit.bit] = gold_bit;
+                        gold_anchors[result.second.bit] = result.first;
+                        gate_anchors[result.first] = result.second.bit;
                     }
-                    solved_gate.insert(gate_bit.bit);
                 }
-                // All solved...
-                if (GetSize(solved_gate) == GetSize(gate_bits))
-                    break;
-            }
         }
         log("Recovered %d net name pairs in module `%s' out.\n", GetSize(gate2gold), log_id(gate_mod));
         gate_worker.do_rename(gold_mod, gate2gold, buffer_types);
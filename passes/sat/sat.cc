@@ -58,6 +58,9 @@ struct SatHelper
 	std::vector<std::string> sets_def, sets_any_undef, sets_all_undef;
 	std::map<int, std::vector<std::string>> sets_def_at, sets_any_undef_at, sets_all_undef_at;
 
+	// when set, only these cells are imported (see -prove-each-assert)
+	const pool<RTLIL::Cell*> *cone = nullptr;
+
 	// model variables
 	std::vector<std::string> shows;
 	SigPool show_signal_pool;
@@ -65,6 +68,11 @@ struct SatHelper
 	int max_timestep, timeout;
 	bool gotTimeout;
 
+	// when non-zero, the constraints that only apply to the base case of a
+	// temporal induction proof (initial state and per-timestep constraints)
+	// are conditional on this literal (see -tempinduct-incremental).
+	int init_context;
+
 	SatHelper(RTLIL::Design *design, RTLIL::Module *module, bool enable_undef, bool set_def_formal) :
 		design(design), module(module), sigmap(module), ct(design), satgen(ez.get(), &sigmap)
 	{
@@ -78,6 +86,15 @@ struct SatHelper
 		max_timestep = -1;
 		timeout = 0;
 		gotTimeout = false;
+		init_context = 0;
+	}
+
+	void assume_init(int id)
+	{
+		if (init_context)
+			ez->assume(id, init_context);
+		else
+			ez->assume(id);
 	}
 
 	void check_undef_enabled(const RTLIL::SigSpec &sig)
@@ -127,6 +144,8 @@ struct SatHelper
 			big_rhs.append(rhs);
 		}
 
+		RTLIL::SigSpec global_lhs = big_lhs, global_rhs = big_rhs;
+
 		for (auto &s : sets_at[timestep])
 		{
 			RTLIL::SigSpec lhs, rhs;
@@ -162,7 +181,11 @@ struct SatHelper
 
 		log("Final constraint equation: %s = %s\n", log_signal(big_lhs), log_signal(big_rhs));
 		check_undef_enabled(big_lhs), check_undef_enabled(big_rhs);
-		ez->assume(satgen.signals_eq(big_lhs, big_rhs, timestep));
+		if (init_context && (!sets_at[timestep].empty() || !unsets_at[timestep].empty())) {
+			assume_init(satgen.signals_eq(big_lhs, big_rhs, timestep));
+			ez->assume(satgen.signals_eq(global_lhs, global_rhs, timestep), ez->NOT(init_context));
+		} else
+			ez->assume(satgen.signals_eq(big_lhs, big_rhs, timestep));
 
 		// 0 = sets_def
 		// 1 = sets_any_undef
@@ -190,6 +213,8 @@ struct SatHelper
 			sets_def_undef[2].insert(sig);
 		}
 
+		std::set<RTLIL::SigSpec> global_def_undef[3] = { sets_def_undef[0], sets_def_undef[1], sets_def_undef[2] };
+
 		for (auto &s : sets_def_at[timestep]) {
 			RTLIL::SigSpec sig;
 			if (!RTLIL::SigSpec::parse_sel(sig, design, module, s))
@@ -217,21 +242,33 @@ struct SatHelper
 			sets_def_undef[2].insert(sig);
 		}
 
-		for (int t = 0; t < 3; t++)
-		for (auto &sig : sets_def_undef[t]) {
-			log("Import %s constraint for this timestep: %s\n", t == 0 ? "def" : t == 1 ? "any_undef" : "all_undef", log_signal(sig));
-			std::vector<int> undef_sig = satgen.importUndefSigSpec(sig, timestep);
-			if (t == 0)
-				ez->assume(ez->NOT(ez->expression(ezSAT::OpOr, undef_sig)));
-			if (t == 1)
-				ez->assume(ez->expression(ezSAT::OpOr, undef_sig));
-			if (t == 2)
-				ez->assume(ez->expression(ezSAT::OpAnd, undef_sig));
-		}
+		auto import_def_undef = [&](const std::set<RTLIL::SigSpec> (&def_undef)[3], bool log_constraints) {
+			std::vector<int> constraints;
+			for (int t = 0; t < 3; t++)
+			for (auto &sig : def_undef[t]) {
+				if (log_constraints)
+					log("Import %s constraint for this timestep: %s\n", t == 0 ? "def" : t == 1 ? "any_undef" : "all_undef", log_signal(sig));
+				std::vector<int> undef_sig = satgen.importUndefSigSpec(sig, timestep);
+				if (t == 0)
+					constraints.push_back(ez->NOT(ez->expression(ezSAT::OpOr, undef_sig)));
+				if (t == 1)
+					constraints.push_back(ez->expression(ezSAT::OpOr, undef_sig));
+				if (t == 2)
+					constraints.push_back(ez->expression(ezSAT::OpAnd, undef_sig));
+			}
+			return constraints;
+		};
+
+		if (init_context && (!sets_def_at[timestep].empty() || !sets_any_undef_at[timestep].empty() || !sets_all_undef_at[timestep].empty())) {
+			assume_init(ez->expression(ezSAT::OpAnd, import_def_undef(sets_def_undef, true)));
+			ez->assume(ez->expression(ezSAT::OpAnd, import_def_undef(global_def_undef, false)), ez->NOT(init_context));
+		} else
+			for (int constraint : import_def_undef(sets_def_undef, true))
+				ez->assume(constraint);
 
 		int import_cell_counter = 0;
 		for (auto cell : module->cells())
-			if (design->selected(module, cell)) {
+			if (design->selected(module, cell) && (cone == nullptr || cone->count(cell))) {
 				// log("Import cell: %s\n", RTLIL::id2cstr(cell->name));
 				if (satgen.importCell(cell, timestep)) {
 					for (auto &p : cell->connections())
@@ -276,7 +313,8 @@ struct SatHelper
 				for (int i = 0; i < lhs.size(); i++) {
 					RTLIL::SigSpec bit = lhs.extract(i, 1);
 					if (rhs[i] == State::Sx || !satgen.initial_state.check_all(bit)) {
-						if (rhs[i] != State::Sx)
+						// registers outside of the cone are expected to be missing
+						if (rhs[i] != State::Sx && cone == nullptr)
 							removed_bits.append(bit);
 						lhs.remove(i, 1);
 						rhs.remove(i, 1);
@@ -324,7 +362,7 @@ struct SatHelper
 			if (set_init_def) {
 				RTLIL::SigSpec rem = satgen.initial_state.export_all();
 				std::vector<int> undef_rem = satgen.importUndefSigSpec(rem, 1);
-				ez->assume(ez->NOT(ez->expression(ezSAT::OpOr, undef_rem)));
+				assume_init(ez->NOT(ez->expression(ezSAT::OpOr, undef_rem)));
 			}
 
 			if (set_init_undef) {
@@ -349,7 +387,7 @@ struct SatHelper
 
 			log("Final init constraint equation: %s = %s\n", log_signal(big_lhs), log_signal(big_rhs));
 			check_undef_enabled(big_lhs), check_undef_enabled(big_rhs);
-			ez->assume(satgen.signals_eq(big_lhs, big_rhs, timestep));
+			assume_init(satgen.signals_eq(big_lhs, big_rhs, timestep));
 		}
 	}
 
@@ -885,6 +923,31 @@ void print_timeout()
 	log("\n");
 }
 
+// Adds the cells in the fanin of `sig` (across registers) to `cone`.
+void add_fanin_cone(pool<RTLIL::Cell*> &cone, const SigMap &sigmap, const dict<RTLIL::SigBit, RTLIL::Cell*> &drivers,
+		const CellTypes &ct, const RTLIL::SigSpec &sig)
+{
+	std::vector<RTLIL::SigBit> queue;
+	for (auto bit : sigmap(sig))
+		queue.push_back(bit);
+	pool<RTLIL::SigBit> visited;
+	while (!queue.empty()) {
+		RTLIL::SigBit bit = queue.back();
+		queue.pop_back();
+		if (bit.wire == nullptr || visited.count(bit))
+			continue;
+		visited.insert(bit);
+		auto it = drivers.find(bit);
+		if (it == drivers.end() || cone.count(it->second))
+			continue;
+		cone.insert(it->second);
+		for (auto &conn : it->second->connections())
+			if (ct.cell_input(it->second->type, conn.first))
+				for (auto in_bit : sigmap(conn.second))
+					queue.push_back(in_bit);
+	}
+}
+
 void print_qed()
 {
 	log("\n");
@@ -957,6 +1020,10 @@ struct SatPass : public Pass {
 		log("    -ignore_div_by_zero\n");
 		log("        ignore all solutions that involve a division by zero\n");
 		log("\n");
+		log("    -compact_mul\n");
+		log("        encode $mul cells as an array of partial products and adders, which\n");
+		log("        gives fewer clauses for wide multipliers\n");
+		log("\n");
 		log("    -ignore_unknown_cells\n");
 		log("        ignore all cells that can not be matched to a SAT model\n");
 		log("\n");
@@ -1030,6 +1097,14 @@ struct SatPass : public Pass {
 		log("        -maxsteps <N>\". Use -initsteps if you just want to set a\n");
 		log("        minimal induction length.\n");
 		log("\n");
+		log("    -tempinduct-incremental\n");
+		log("        Perform a temporal induction proof, but unroll the circuit only once\n");
+		log("        and solve the base case and the induction step in the same solver.\n");
+		log("        The initial state and the -set-at style constraints only apply to\n");
+		log("        the base case queries. This avoids importing each time step twice\n");
+		log("        and keeps the learned clauses for all queries. Not supported for\n");
+		log("        designs with $initstate cells.\n");
+		log("\n");
 		log("    -prove <signal> <value>\n");
 		log("        Attempt to proof that <signal> is always <value>.\n");
 		log("\n");
@@ -1040,6 +1115,14 @@ struct SatPass : public Pass {
 		log("    -prove-asserts\n");
 		log("        Prove that all asserts in the design hold.\n");
 		log("\n");
+		log("    -prove-each-assert\n");
+		log("        Like -prove-asserts, but prove every $assert cell on its own, with only\n");
+		log("        the cells in its cone of influence (and in the ones of the -set* options\n");
+		log("        and of the $assume cells) in the solver. The proofs run in parallel,\n");
+		log("        -timeout applies to each of them, and the result is reported for every\n");
+		log("        assert. With -verify, an error is returned if any assert fails. Not\n");
+		log("        supported with -tempinduct, -prove, -prove-x, or the model dumps.\n");
+		log("\n");
 		log("    -prove-skip <N>\n");
 		log("        Do not enforce the prove-condition for the first <N> time steps.\n");
 		log("\n");
@@ -1080,11 +1163,11 @@ struct SatPass : public Pass {
 		std::vector<std::string> shows, sets_def, sets_any_undef, sets_all_undef;
 		int loopcount = 0, seq_len = 0, maxsteps = 0, initsteps = 0, timeout = 0, prove_skip = 0;
 		bool verify = false, fail_on_timeout = false, enable_undef = false, set_def_inputs = false, set_def_formal = false;
-		bool ignore_div_by_zero = false, set_init_undef = false, set_init_zero = false, max_undef = false;
-		bool tempinduct = false, prove_asserts = false, show_inputs = false, show_outputs = false;
+		bool ignore_div_by_zero = false, compact_mul = false, set_init_undef = false, set_init_zero = false, max_undef = false;
+		bool tempinduct = false, prove_asserts = false, prove_each_assert = false, show_inputs = false, show_outputs = false;
 		bool show_regs = false, show_public = false, show_all = false;
 		bool ignore_unknown_cells = false, falsify = false, tempinduct_def = false, set_init_def = false;
-		bool tempinduct_baseonly = false, tempinduct_inductonly = false, set_assumes = false;
+		bool tempinduct_baseonly = false, tempinduct_inductonly = false, tempinduct_incremental = false, set_assumes = false;
 		int tempinduct_skip = 0, stepsize = 1;
 		std::string vcd_file_name, json_file_name, cnf_file_name;
 
@@ -1138,6 +1221,10 @@ struct SatPass : public Pass {
 				ignore_div_by_zero = true;
 				continue;
 			}
+			if (args[argidx] == "-compact_mul") {
+				compact_mul = true;
+				continue;
+			}
 			if (args[argidx] == "-enable_undef") {
 				enable_undef = true;
 				continue;
@@ -1202,6 +1289,11 @@ struct SatPass : public Pass {
 				tempinduct_inductonly = true;
 				continue;
 			}
+			if (args[argidx] == "-tempinduct-incremental") {
+				tempinduct = true;
+				tempinduct_incremental = true;
+				continue;
+			}
 			if (args[argidx] == "-tempinduct-skip" && argidx+1 < args.size()) {
 				tempinduct_skip = atoi(args[++argidx].c_str());
 				continue;
@@ -1223,6 +1315,11 @@ struct SatPass : public Pass {
 				prove_asserts = true;
 				continue;
 			}
+			if (args[argidx] == "-prove-each-assert") {
+				prove_asserts = true;
+				prove_each_assert = true;
+				continue;
+			}
 			if (args[argidx] == "-prove-skip" && argidx+1 < args.size()) {
 				prove_skip = atoi(args[++argidx].c_str());
 				continue;
@@ -1391,7 +1488,153 @@ struct SatPass : public Pass {
 				shows.push_back(wire->name.str());
 		}
 
-		if (tempinduct)
+		auto configure = [&](SatHelper &sathelper) {
+			sathelper.sets = sets;
+			sathelper.set_assumes = set_assumes;
+			sathelper.prove = prove;
+			sathelper.prove_x = prove_x;
+			sathelper.prove_asserts = prove_asserts;
+			sathelper.sets_at = sets_at;
+			sathelper.unsets_at = unsets_at;
+			sathelper.shows = shows;
+			sathelper.timeout = timeout;
+			sathelper.sets_def = sets_def;
+			sathelper.sets_any_undef = sets_any_undef;
+			sathelper.sets_all_undef = sets_all_undef;
+			sathelper.sets_def_at = sets_def_at;
+			sathelper.sets_any_undef_at = sets_any_undef_at;
+			sathelper.sets_all_undef_at = sets_all_undef_at;
+			sathelper.sets_init = sets_init;
+			sathelper.set_init_def = set_init_def;
+			sathelper.set_init_undef = set_init_undef;
+			sathelper.set_init_zero = set_init_zero;
+			sathelper.satgen.ignore_div_by_zero = ignore_div_by_zero;
+			sathelper.satgen.compact_mul = compact_mul;
+			sathelper.ignore_unknown_cells = ignore_unknown_cells;
+		};
+
+		if (prove_each_assert)
+		{
+			if (tempinduct || prove.size() || prove_x.size())
+				log_cmd_error("Option -prove-each-assert can't be used together with -tempinduct, -prove, or -prove-x!\n");
+			if (loopcount > 0 || max_undef || !vcd_file_name.empty() || !json_file_name.empty() || !cnf_file_name.empty())
+				log_cmd_error("The options -max, -all, -max_undef, and the model dumps are not supported with -prove-each-assert!\n");
+
+			SigMap sigmap(module);
+			CellTypes ct(design);
+			dict<RTLIL::SigBit, RTLIL::Cell*> drivers;
+			std::vector<RTLIL::Cell*> asserts;
+			pool<RTLIL::Cell*> base_cone;
+			for (auto cell : module->cells()) {
+				if (!design->selected(module, cell))
+					continue;
+				if (cell->type == ID($assert))
+					asserts.push_back(cell);
+				if (cell->type == ID($assume) && set_assumes)
+					base_cone.insert(cell);
+				for (auto &conn : cell->connections())
+					if (ct.cell_output(cell->type, conn.first))
+						for (auto bit : sigmap(conn.second))
+							if (bit.wire)
+								drivers[bit] = cell;
+			}
+
+			// The constraints apply to every proof, so their cones are always included.
+			auto add_constraint_cone = [&](const std::string &lhs_str, const std::string *rhs_str) {
+				RTLIL::SigSpec lhs, rhs;
+				if (!RTLIL::SigSpec::parse_sel(lhs, design, module, lhs_str))
+					log_cmd_error("Failed to parse lhs set expression `%s'.\n", lhs_str.c_str());
+				add_fanin_cone(base_cone, sigmap, drivers, ct, lhs);
+				if (rhs_str != nullptr) {
+					if (!RTLIL::SigSpec::parse_rhs(lhs, rhs, module, *rhs_str))
+						log_cmd_error("Failed to parse rhs set expression `%s'.\n", rhs_str->c_str());
+					add_fanin_cone(base_cone, sigmap, drivers, ct, rhs);
+				}
+			};
+			for (auto &s : sets)
+				add_constraint_cone(s.first, &s.second);
+			for (auto &s : sets_init)
+				add_constraint_cone(s.first, &s.second);
+			for (auto &it : sets_at)
+				for (auto &s : it.second)
+					add_constraint_cone(s.first, &s.second);
+			for (auto sig_strs : {&sets_def, &sets_any_undef, &sets_all_undef})
+				for (auto &s : *sig_strs)
+					add_constraint_cone(s, nullptr);
+			for (auto sig_strs_at : {&sets_def_at, &sets_any_undef_at, &sets_all_undef_at})
+				for (auto &it : *sig_strs_at)
+					for (auto &s : it.second)
+						add_constraint_cone(s, nullptr);
+			for (auto cell : pool<RTLIL::Cell*>(base_cone))
+				if (cell->type == ID($assume))
+					add_fanin_cone(base_cone, sigmap, drivers, ct, SigSpec({cell->getPort(ID::A), cell->getPort(ID::EN)}));
+
+			log("\nProving %d asserts separately.\n", GetSize(asserts));
+
+			enum { PROVEN, FAILED, TIMED_OUT };
+			std::vector<pool<RTLIL::Cell*>> cones(GetSize(asserts), base_cone);
+			std::vector<int> results(GetSize(asserts));
+			for (int i = 0; i < GetSize(asserts); i++) {
+				cones[i].insert(asserts[i]);
+				add_fanin_cone(cones[i], sigmap, drivers, ct, SigSpec({asserts[i]->getPort(ID::A), asserts[i]->getPort(ID::EN)}));
+			}
+
+			Pass::parallel_for(design, GetSize(asserts), [&](int i) {
+				log("\nProving assert %s (%d cells in its cone of influence):\n", log_id(asserts[i]), GetSize(cones[i]));
+
+				SatHelper sathelper(design, module, enable_undef, set_def_formal);
+				configure(sathelper);
+				sathelper.cone = &cones[i];
+
+				if (seq_len == 0) {
+					sathelper.setup();
+					sathelper.ez->assume(sathelper.ez->NOT(sathelper.setup_proof()));
+				} else {
+					std::vector<int> prove_bits;
+					for (int timestep = 1; timestep <= seq_len; timestep++) {
+						sathelper.setup(timestep, timestep == 1);
+						if (timestep > prove_skip)
+							prove_bits.push_back(sathelper.setup_proof(timestep));
+					}
+					sathelper.ez->assume(sathelper.ez->NOT(sathelper.ez->expression(ezSAT::OpAnd, prove_bits)));
+				}
+				sathelper.generate_model();
+
+				log("\nSolving problem with %d variables and %d clauses..\n",
+						sathelper.ez->numCnfVariables(), sathelper.ez->numCnfClauses());
+				if (sathelper.solve()) {
+					results[i] = FAILED;
+					log("Assert %s: FAIL!\n", log_id(asserts[i]));
+					sathelper.print_model();
+				} else if (sathelper.gotTimeout) {
+					results[i] = TIMED_OUT;
+					log("Assert %s: TIMEOUT!\n", log_id(asserts[i]));
+				} else {
+					results[i] = PROVEN;
+					log("Assert %s: SUCCESS!\n", log_id(asserts[i]));
+				}
+			});
+
+			int counts[3] = {};
+			log("\n");
+			for (int i = 0; i < GetSize(asserts); i++) {
+				counts[results[i]]++;
+				log("  %-7s %s\n", results[i] == PROVEN ? "PASS" : results[i] == FAILED ? "FAIL" : "TIMEOUT", log_id(asserts[i]));
+			}
+			log("%d asserts passed, %d failed, %d timed out.\n", counts[PROVEN], counts[FAILED], counts[TIMED_OUT]);
+
+			if (verify && counts[FAILED]) {
+				log("\n");
+				log_error("Called with -verify and proof did fail!\n");
+			}
+			if (falsify && counts[PROVEN] == GetSize(asserts) && !asserts.empty()) {
+				log("\n");
+				log_error("Called with -falsify and proof did succeed!\n");
+			}
+			if (fail_on_timeout && counts[TIMED_OUT])
+				log_error("Called with -verify and proof did time out!\n");
+		}
+		else if (tempinduct)
 		{
 			if (loopcount > 0 || max_undef)
 				log_cmd_error("The options -max, -all, and -max_undef are not supported for temporal induction proofs!\n");
@@ -1419,8 +1662,165 @@ struct SatPass : public Pass {
 			basecase.set_init_undef = set_init_undef;
 			basecase.set_init_zero = set_init_zero;
 			basecase.satgen.ignore_div_by_zero = ignore_div_by_zero;
+			basecase.satgen.compact_mul = compact_mul;
 			basecase.ignore_unknown_cells = ignore_unknown_cells;
 
+			if (tempinduct_incremental)
+			{
+				// A single unrolling is shared by the base case and the induction step. Time
+				// step seq_len+1 of the base case is time step 1 of the induction step, the
+				// first seq_len time steps are unconstrained in the induction step queries.
+				SatHelper &sathelper = basecase;
+				int init_context = sathelper.ez->frozen_literal("tempinduct_init");
+				int unique_state_timestep = 0;
+				int next_property = 0;
+
+				for (auto cell : module->cells())
+					if (cell->type == ID($initstate) && design->selected(module, cell))
+						log_cmd_error("Option -tempinduct-incremental is not supported for designs with $initstate cells.\n");
+
+				sathelper.init_context = init_context;
+
+				for (int timestep = 1; timestep <= seq_len; timestep++)
+					sathelper.setup(timestep, timestep == 1);
+
+				// the states of the induction step are unique from its time step 3 on,
+				// the base case additionally requires the first two states to differ.
+				auto force_unique_state = [&](int timestep) {
+					if (timestep == seq_len + 2) {
+						RTLIL::SigSpec state_signals = sathelper.satgen.initial_state.export_all();
+						sathelper.assume_init(sathelper.ez->NOT(sathelper.satgen.signals_eq(state_signals, state_signals, seq_len + 1, timestep)));
+					} else if (timestep > seq_len + 2 && timestep > unique_state_timestep) {
+						sathelper.force_unique_state(seq_len + 1, timestep);
+						unique_state_timestep = timestep;
+					}
+				};
+
+				for (int inductlen = 1; inductlen <= maxsteps || maxsteps == 0; inductlen++)
+				{
+					log("\n** Trying induction with length %d **\n", inductlen);
+
+					// phase 1: proving base case
+
+					int property = next_property;
+					if (property == 0) {
+						sathelper.setup(seq_len + inductlen, seq_len + inductlen == 1);
+						property = sathelper.setup_proof(seq_len + inductlen);
+						if (tempinduct_def && inductlen == 1) {
+							std::vector<int> undef_state = sathelper.satgen.importUndefSigSpec(sathelper.satgen.initial_state.export_all(), seq_len + 1);
+							sathelper.ez->assume(sathelper.ez->NOT(sathelper.ez->expression(ezSAT::OpOr, undef_state)), sathelper.ez->NOT(init_context));
+						}
+					}
+					if (inductlen > 1)
+						force_unique_state(seq_len + inductlen);
+
+					if (!tempinduct_inductonly && tempinduct_skip < inductlen)
+					{
+						sathelper.generate_model();
+
+						log("\n[base case %d] Solving problem with %d variables and %d clauses..\n",
+								inductlen, sathelper.ez->numCnfVariables(), sathelper.ez->numCnfClauses());
+						log_flush();
+
+						if (sathelper.solve(init_context, sathelper.ez->NOT(property))) {
+							log("SAT temporal induction proof finished - model found for base case: FAIL!\n");
+							print_proof_failed();
+							sathelper.print_model();
+							if(!vcd_file_name.empty())
+								sathelper.dump_model_to_vcd(vcd_file_name);
+							if(!json_file_name.empty())
+								sathelper.dump_model_to_json(json_file_name);
+							goto tip_failed;
+						}
+
+						if (sathelper.gotTimeout)
+							goto timeout;
+
+						log("Base case for induction length %d proven.\n", inductlen);
+					}
+					else if (!tempinduct_inductonly)
+					{
+						log("\n[base case %d] Skipping prove for this step (-tempinduct-skip %d).",
+								inductlen, tempinduct_skip);
+						log("\n[base case %d] Problem size so far: %d variables and %d clauses.\n",
+								inductlen, sathelper.ez->numCnfVariables(), sathelper.ez->numCnfClauses());
+					}
+
+					// the property holds in the base case and is the induction hypothesis
+					sathelper.ez->assume(property);
+					next_property = 0;
+
+					// phase 2: proving induction step
+
+					if (tempinduct_baseonly)
+						continue;
+
+					sathelper.setup(seq_len + inductlen + 1);
+					next_property = sathelper.setup_proof(seq_len + inductlen + 1);
+					sathelper.generate_model();
+					if (inductlen > 1)
+						force_unique_state(seq_len + inductlen + 1);
+
+					if (inductlen <= tempinduct_skip || inductlen <= initsteps || inductlen % stepsize != 0)
+					{
+						if (inductlen < tempinduct_skip)
+							log("\n[induction step %d] Skipping prove for this step (-tempinduct-skip %d).",
+									inductlen, tempinduct_skip);
+						if (inductlen < initsteps)
+							log("\n[induction step %d] Skipping prove for this step (-initsteps %d).",
+									inductlen, tempinduct_skip);
+						if (inductlen % stepsize != 0)
+							log("\n[induction step %d] Skipping prove for this step (-stepsize %d).",
+									inductlen, stepsize);
+						log("\n[induction step %d] Problem size so far: %d variables and %d clauses.\n",
+								inductlen, sathelper.ez->numCnfVariables(), sathelper.ez->numCnfClauses());
+						continue;
+					}
+
+					if (!cnf_file_name.empty())
+					{
+						rewrite_filename(cnf_file_name);
+						FILE *f = fopen(cnf_file_name.c_str(), "w");
+						if (!f)
+							log_cmd_error("Can't open output file `%s' for writing: %s\n", cnf_file_name.c_str(), strerror(errno));
+
+						log("Dumping CNF to file `%s'.\n", cnf_file_name.c_str());
+						cnf_file_name.clear();
+
+						sathelper.ez->printDIMACS(f, false);
+						fclose(f);
+					}
+
+					log("\n[induction step %d] Solving problem with %d variables and %d clauses..\n",
+							inductlen, sathelper.ez->numCnfVariables(), sathelper.ez->numCnfClauses());
+					log_flush();
+
+					if (!sathelper.solve(sathelper.ez->NOT(init_context), sathelper.ez->NOT(next_property))) {
+						if (sathelper.gotTimeout)
+							goto timeout;
+						log("Induction step proven: SUCCESS!\n");
+						print_qed();
+						goto tip_success;
+					}
+
+					log("Induction step failed. Incrementing induction length.\n");
+					sathelper.print_model();
+				}
+
+				if (tempinduct_baseonly) {
+					log("\nReached maximum number of time steps -> proved base case for %d steps: SUCCESS!\n", maxsteps);
+					goto tip_success;
+				}
+
+				log("\nReached maximum number of time steps -> proof failed.\n");
+				if(!vcd_file_name.empty())
+					sathelper.dump_model_to_vcd(vcd_file_name);
+				if(!json_file_name.empty())
+					sathelper.dump_model_to_json(json_file_name);
+				print_proof_failed();
+				goto tip_failed;
+			}
+
 			for (int timestep = 1; timestep <= seq_len; timestep++)
 				if (!tempinduct_inductonly)
 					basecase.setup(timestep, timestep == 1);
@@ -1436,6 +1836,7 @@ struct SatPass : public Pass {
 			inductstep.sets_any_undef = sets_any_undef;
 			inductstep.sets_all_undef = sets_all_undef;
 			inductstep.satgen.ignore_div_by_zero = ignore_div_by_zero;
+			inductstep.satgen.compact_mul = compact_mul;
 			inductstep.ignore_unknown_cells = ignore_unknown_cells;
 
 			if (!tempinduct_baseonly) {
@@ -1587,28 +1988,7 @@ struct SatPass : public Pass {
 				log_cmd_error("The options -maxsteps is only supported for temporal induction proofs!\n");
 
 			SatHelper sathelper(design, module, enable_undef, set_def_formal);
-
-			sathelper.sets = sets;
-			sathelper.set_assumes = set_assumes;
-			sathelper.prove = prove;
-			sathelper.prove_x = prove_x;
-			sathelper.prove_asserts = prove_asserts;
-			sathelper.sets_at = sets_at;
-			sathelper.unsets_at = unsets_at;
-			sathelper.shows = shows;
-			sathelper.timeout = timeout;
-			sathelper.sets_def = sets_def;
-			sathelper.sets_any_undef = sets_any_undef;
-			sathelper.sets_all_undef = sets_all_undef;
-			sathelper.sets_def_at = sets_def_at;
-			sathelper.sets_any_undef_at = sets_any_undef_at;
-			sathelper.sets_all_undef_at = sets_all_undef_at;
-			sathelper.sets_init = sets_init;
-			sathelper.set_init_def = set_init_def;
-			sathelper.set_init_undef = set_init_undef;
-			sathelper.set_init_zero = set_init_zero;
-			sathelper.satgen.ignore_div_by_zero = ignore_div_by_zero;
-			sathelper.ignore_unknown_cells = ignore_unknown_cells;
+			configure(sathelper);
 
 			if (seq_len == 0) {
 				sathelper.setup();
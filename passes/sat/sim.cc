@@ -99,6 +99,107 @@ struct DisplayOutput {
 	{ }
 };
 
+// The changes of the traced signals in each step of the simulation, for the output writers. Only the first step is
+// kept in memory, as memory words that are traced later add their initial value to it. The later steps are appended
+// to a temporary file, so that the memory used does not grow with the length of the simulation.
+struct OutputData
+{
+	int first_time = 0;
+	std::map<int,Const> first_data;
+	int num_steps = 0;
+	// the signals that change after the first step
+	std::set<int> later_signals;
+
+	std::string spool_filename;
+	FILE *spool = nullptr;
+	std::vector<unsigned char> buffer;
+
+	~OutputData()
+	{
+		if (spool != nullptr) {
+			fclose(spool);
+			remove(spool_filename.c_str());
+		}
+	}
+
+	bool empty() const { return num_steps == 0; }
+
+	void put_int(int value)
+	{
+		unsigned char bytes[sizeof(int)];
+		memcpy(bytes, &value, sizeof(int));
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(int));
+	}
+
+	int get_int()
+	{
+		int value;
+		if (fread(&value, sizeof(int), 1, spool) != 1)
+			log_error("Failed to read simulation results from `%s'.\n", spool_filename.c_str());
+		return value;
+	}
+
+	void add_step(int time, std::map<int,Const> &data)
+	{
+		if (num_steps++ == 0) {
+			first_time = time;
+			first_data.swap(data);
+			return;
+		}
+
+		if (spool == nullptr) {
+			spool_filename = make_temp_file(get_base_tmpdir() + "/yosys_sim_XXXXXX");
+			spool = fopen(spool_filename.c_str(), "w+b");
+			if (spool == nullptr)
+				log_error("Failed to open `%s' for writing simulation results.\n", spool_filename.c_str());
+		}
+
+		buffer.clear();
+		put_int(time);
+		put_int(GetSize(data));
+		for (auto &it : data) {
+			later_signals.insert(it.first);
+			put_int(it.first);
+			put_int(GetSize(it.second));
+			for (auto bit : it.second)
+				buffer.push_back((unsigned char)bit);
+		}
+		if (fwrite(buffer.data(), 1, buffer.size(), spool) != buffer.size())
+			log_error("Failed to write simulation results to `%s'.\n", spool_filename.c_str());
+	}
+
+	void for_each_step(const std::function<void(int, const std::map<int,Const>&)> &worker)
+	{
+		if (num_steps == 0)
+			return;
+		worker(first_time, first_data);
+		if (spool == nullptr)
+			return;
+
+		fflush(spool);
+		rewind(spool);
+		std::map<int,Const> data;
+		for (int step = 1; step < num_steps; step++) {
+			data.clear();
+			int time = get_int();
+			int count = get_int();
+			for (int i = 0; i < count; i++) {
+				int id = get_int();
+				int size = get_int();
+				buffer.resize(size);
+				if (fread(buffer.data(), 1, size, spool) != size_t(size))
+					log_error("Failed to read simulation results from `%s'.\n", spool_filename.c_str());
+				std::vector<State> bits(size);
+				for (int j = 0; j < size; j++)
+					bits[j] = State(buffer[j]);
+				data.emplace(id, Const(bits));
+			}
+			worker(time, data);
+		}
+		fseek(spool, 0, SEEK_END);
+	}
+};
+
 struct SimShared
 {
 	bool debug = false;
@@ -114,7 +215,7 @@ struct SimShared
 	SimulationMode sim_mode = SimulationMode::sim;
 	bool cycles_set = false;
 	std::vector<std::unique_ptr<OutputWriter>> outputfiles;
-	std::vector<std::pair<int,std::map<int,Const>>> output_data;
+	OutputData output_data;
 	bool ignore_x = false;
 	bool date = false;
 	bool multiclock = false;
@@ -125,8 +226,20 @@ struct SimShared
 	bool serious_asserts = false;
 	bool fst_noinit = false;
 	bool initstate = true;
+	bool levelize = false;
+	bool parallel = false;
 };
 
+struct SimInstance;
+
+// While the children of an instance are updated in separate threads (see SimInstance::for_children()), trace ids
+// for memory words are not assigned directly, as they must not depend on the scheduling. Instead the words are
+// collected here per thread and registered afterwards, in the order of a serial simulation.
+static thread_local std::vector<std::tuple<SimInstance*, IdString, int>> *deferred_memory_addrs = nullptr;
+
+// The minimum number of cells in a set of child instances for -parallel to update them in separate threads.
+static const int PARALLEL_MIN_CELLS = 1000;
+
 void zinit(State &v)
 {
 	if (v != State::S1)
@@ -163,6 +276,36 @@ struct SimInstance
 	pool<IdString> dirty_memories;
 	pool<SimInstance*> dirty_children;
 
+	// the number of cells in this instance and all instances below it
+	int subtree_cells = 0;
+	// values for the output ports of this instance, which are copied into the parent once all of its children have
+	// been updated
+	std::vector<std::pair<SigSpec, Const>> pending_outports;
+
+	// With -levelize, the evaluable cells are compiled once into comb_cells, which refer to their input and output
+	// nets by pointers into state_nets (which does not change after construction), and are evaluated in topological
+	// order. Each cell is then evaluated at most once for each change of the other state of the simulation.
+	struct comb_cell_t
+	{
+		Cell *cell;
+		int level;
+		bool queued;
+		std::vector<Const> inputs;
+		std::vector<std::vector<std::pair<int, const State*>>> input_nets;
+		std::vector<SigBit> input_bits;
+		std::vector<SigBit> output_bits;
+		std::vector<State*> output_nets;
+		// for each output bit: whether it also needs to go through dirty_bits, and the cells reading it
+		std::vector<bool> output_notify;
+		std::vector<const std::vector<int>*> output_readers;
+	};
+
+	bool levelized = false;
+	std::vector<comb_cell_t> comb_cells;
+	dict<SigBit, std::vector<int>> comb_readers;
+	std::vector<std::vector<int>> comb_queue;
+	int comb_queued = 0;
+
 	struct ff_state_t
 	{
 		Const past_d;
@@ -182,6 +325,8 @@ struct SimInstance
 		std::vector<Const> past_wr_addr;
 		std::vector<Const> past_wr_data;
 		Const data;
+		// The initial contents, only built when words are looked up for the output traces.
+		std::unique_ptr<MemContents> init_contents;
 	};
 
 	struct print_state_t
@@ -358,6 +503,13 @@ struct SimInstance
 
 		std::sort(print_database.begin(), print_database.end());
 
+		subtree_cells = GetSize(module->cells());
+		for (auto &it : children)
+			subtree_cells += it.second->subtree_cells;
+
+		if (shared->levelize && !shared->debug)
+			setup_levelized();
+
 		if (shared->zinit)
 		{
 			for (auto &it : ff_database)
@@ -381,6 +533,184 @@ struct SimInstance
 		}
 	}
 
+	void setup_levelized()
+	{
+		dict<SigBit, int> comb_drivers;
+
+		for (auto cell : module->cells())
+		{
+			if (ff_database.count(cell) || formal_database.count(cell) || mem_cells.count(cell) || children.count(cell))
+				continue;
+			if (!yosys_celltypes.cell_evaluable(cell->type) || !cell->hasPort(ID::A) || !cell->hasPort(ID::Y) || cell->hasPort(ID::D))
+				continue;
+
+			// the same port patterns as in update_cell()
+			std::vector<IdString> ports;
+			if (!cell->hasPort(ID::C) && !cell->hasPort(ID::S))
+				ports = {ID::A, ID::B};
+			else if (cell->hasPort(ID::B) && cell->hasPort(ID::C) && !cell->hasPort(ID::S))
+				ports = {ID::A, ID::B, ID::C};
+			else if (!cell->hasPort(ID::B) && !cell->hasPort(ID::C))
+				ports = {ID::A, ID::S};
+			else if (!cell->hasPort(ID::C))
+				ports = {ID::A, ID::B, ID::S};
+			else
+				continue;
+
+			comb_cell_t cc;
+			cc.cell = cell;
+			cc.level = -1;
+			cc.queued = false;
+			for (auto port : ports) {
+				SigSpec sig = cell->hasPort(port) ? sigmap(cell->getPort(port)) : SigSpec();
+				Const value;
+				std::vector<std::pair<int, const State*>> nets;
+				for (int i = 0; i < GetSize(sig); i++) {
+					if (sig[i].wire == nullptr) {
+						value.bits().push_back(sig[i].data);
+					} else if (state_nets.count(sig[i])) {
+						value.bits().push_back(State::Sx);
+						nets.emplace_back(i, &state_nets.at(sig[i]));
+					} else {
+						value.bits().push_back(State::Sz);
+					}
+					cc.input_bits.push_back(sig[i]);
+				}
+				cc.inputs.push_back(value);
+				cc.input_nets.push_back(nets);
+			}
+			for (auto bit : sigmap(cell->getPort(ID::Y))) {
+				cc.output_bits.push_back(bit);
+				cc.output_nets.push_back(bit.wire ? &state_nets.at(bit) : nullptr);
+				if (bit.wire)
+					comb_drivers[bit] = GetSize(comb_cells);
+			}
+			comb_cells.push_back(cc);
+		}
+
+		// levelize, and give up on it for modules with combinational loops
+
+		for (int root = 0; root < GetSize(comb_cells); root++)
+		{
+			if (comb_cells[root].level != -1)
+				continue;
+
+			// level -2 marks the cells on the stack
+			std::vector<std::pair<int, int>> stack;
+			comb_cells[root].level = -2;
+			stack.emplace_back(root, 0);
+
+			while (!stack.empty())
+			{
+				comb_cell_t &cc = comb_cells[stack.back().first];
+				int &next_input = stack.back().second;
+
+				if (next_input < GetSize(cc.input_bits)) {
+					auto drv = comb_drivers.find(cc.input_bits[next_input++]);
+					if (drv == comb_drivers.end())
+						continue;
+					comb_cell_t &drv_cc = comb_cells[drv->second];
+					if (drv_cc.level == -2) {
+						log("Found a combinational loop through cell %s in %s, not levelizing it.\n",
+								log_id(drv_cc.cell), hiername().c_str());
+						comb_cells.clear();
+						return;
+					}
+					if (drv_cc.level == -1) {
+						drv_cc.level = -2;
+						stack.emplace_back(drv->second, 0);
+					}
+					continue;
+				}
+
+				int level = 0;
+				for (auto bit : cc.input_bits) {
+					auto drv = comb_drivers.find(bit);
+					if (drv != comb_drivers.end())
+						level = std::max(level, comb_cells[drv->second].level + 1);
+				}
+				cc.level = level;
+				stack.pop_back();
+			}
+		}
+
+		// the compiled cells are no longer scheduled through upd_cells
+
+		int max_level = -1;
+		for (int idx = 0; idx < GetSize(comb_cells); idx++) {
+			comb_cell_t &cc = comb_cells[idx];
+			max_level = std::max(max_level, cc.level);
+			pool<SigBit> seen_bits;
+			for (auto bit : cc.input_bits) {
+				if (!seen_bits.insert(bit).second)
+					continue;
+				comb_readers[bit].push_back(idx);
+				auto it = upd_cells.find(bit);
+				if (it != upd_cells.end()) {
+					it->second.erase(cc.cell);
+					if (it->second.empty())
+						upd_cells.erase(it);
+				}
+			}
+		}
+		comb_queue.resize(max_level + 1);
+
+		for (auto &cc : comb_cells) {
+			for (auto bit : cc.output_bits) {
+				cc.output_notify.push_back(upd_cells.count(bit) || upd_outports.count(bit));
+				auto it = comb_readers.find(bit);
+				cc.output_readers.push_back(it == comb_readers.end() ? nullptr : &it->second);
+			}
+		}
+
+		levelized = true;
+	}
+
+	void queue_comb_cell(int idx)
+	{
+		comb_cell_t &cc = comb_cells[idx];
+		if (cc.queued)
+			return;
+		cc.queued = true;
+		comb_queue[cc.level].push_back(idx);
+		comb_queued++;
+	}
+
+	void update_comb_cells()
+	{
+		for (auto &queue : comb_queue)
+		{
+			for (int k = 0; k < GetSize(queue); k++)
+			{
+				comb_cell_t &cc = comb_cells[queue[k]];
+				cc.queued = false;
+
+				for (int i = 0; i < GetSize(cc.inputs); i++)
+					for (auto &it : cc.input_nets[i])
+						cc.inputs[i].bits()[it.first] = *it.second;
+
+				Const value = GetSize(cc.inputs) == 2 ? CellTypes::eval(cc.cell, cc.inputs[0], cc.inputs[1]) :
+						CellTypes::eval(cc.cell, cc.inputs[0], cc.inputs[1], cc.inputs[2]);
+				log_assert(GetSize(cc.output_nets) <= GetSize(value));
+
+				for (int i = 0; i < GetSize(cc.output_nets); i++) {
+					State *net = cc.output_nets[i];
+					if (net == nullptr || value[i] == State::Sa || *net == value[i])
+						continue;
+					*net = value[i];
+					if (cc.output_notify[i])
+						dirty_bits.insert(cc.output_bits[i]);
+					if (cc.output_readers[i] != nullptr)
+						for (int reader : *cc.output_readers[i])
+							queue_comb_cell(reader);
+				}
+			}
+			comb_queued -= GetSize(queue);
+			queue.clear();
+		}
+		log_assert(comb_queued == 0);
+	}
+
 	~SimInstance()
 	{
 		for (auto child : children)
@@ -633,10 +963,19 @@ struct SimInstance
 				if (upd_outports.count(bit) && parent != nullptr)
 					for (auto wire : upd_outports.at(bit))
 						queue_outports.insert(wire);
+
+				if (levelized && comb_readers.count(bit))
+					for (int idx : comb_readers.at(bit))
+						queue_comb_cell(idx);
 			}
 
 			dirty_bits.clear();
 
+			if (comb_queued > 0) {
+				update_comb_cells();
+				continue;
+			}
+
 			if (!queue_cells.empty())
 			{
 				for (auto cell : queue_cells)
@@ -651,18 +990,22 @@ struct SimInstance
 			dirty_memories.clear();
 
 			for (auto wire : queue_outports)
-				if (instance->hasPort(wire->name)) {
-					Const value = get_state(wire);
-					parent->set_state(instance->getPort(wire->name), value);
-				}
+				if (instance->hasPort(wire->name))
+					pending_outports.emplace_back(instance->getPort(wire->name), get_state(wire));
 
 			queue_outports.clear();
 
-			for (auto child : dirty_children)
-				child->update_ph1();
-
+			std::vector<SimInstance*> todo(dirty_children.begin(), dirty_children.end());
 			dirty_children.clear();
 
+			for_children(todo, [](SimInstance *child) { child->update_ph1(); return false; });
+
+			for (auto child : todo) {
+				for (auto &it : child->pending_outports)
+					set_state(it.first, it.second);
+				child->pending_outports.clear();
+			}
+
 			if (dirty_bits.empty())
 				break;
 		}
@@ -781,15 +1124,57 @@ struct SimInstance
 			}
 		}
 
+		std::vector<SimInstance*> todo;
 		for (auto it : children)
-			if (it.second->update_ph2(gclk, stable_past_update)) {
-				dirty_children.insert(it.second);
+			todo.push_back(it.second);
+
+		std::vector<bool> child_changed = for_children(todo, [&](SimInstance *child) {
+			return child->update_ph2(gclk, stable_past_update);
+		});
+
+		for (int i = 0; i < GetSize(todo); i++)
+			if (child_changed[i]) {
+				dirty_children.insert(todo[i]);
 				did_something = true;
 			}
 
 		return did_something;
 	}
 
+	// Runs worker on each of the given children and returns its results. With -parallel, large sets of children are
+	// updated in separate threads, which is safe as long as the worker only changes the state of the child and the
+	// instances below it.
+	std::vector<bool> for_children(const std::vector<SimInstance*> &todo, const std::function<bool(SimInstance*)> &worker)
+	{
+		std::vector<bool> results(GetSize(todo));
+
+		int cells = 0;
+		for (auto child : todo)
+			cells += child->subtree_cells;
+
+		if (!shared->parallel || shared->debug || GetSize(todo) < 2 || cells < PARALLEL_MIN_CELLS ||
+				deferred_memory_addrs != nullptr || Pass::parallel_threads(module->design) < 2) {
+			for (int i = 0; i < GetSize(todo); i++)
+				results[i] = worker(todo[i]);
+			return results;
+		}
+
+		std::vector<char> job_results(GetSize(todo));
+		std::vector<std::vector<std::tuple<SimInstance*, IdString, int>>> memory_addrs(GetSize(todo));
+		Pass::parallel_for(module->design, GetSize(todo), [&](int i) {
+			deferred_memory_addrs = &memory_addrs[i];
+			job_results[i] = worker(todo[i]);
+			deferred_memory_addrs = nullptr;
+		});
+
+		for (auto &addrs : memory_addrs)
+			for (auto &it : addrs)
+				std::get<0>(it)->register_memory_addr(std::get<1>(it), std::get<2>(it));
+		for (int i = 0; i < GetSize(todo); i++)
+			results[i] = job_results[i];
+		return results;
+	}
+
 	static void log_source(RTLIL::AttrObject *src)
 	{
 		for (auto src : src->get_strpool_attribute(ID::src))
@@ -1089,6 +1474,10 @@ struct SimInstance
 
 	void register_memory_addr(IdString memid, int addr)
 	{
+		if (deferred_memory_addrs != nullptr) {
+			deferred_memory_addrs->emplace_back(this, memid, addr);
+			return;
+		}
 		auto &mdb = mem_database.at(memid);
 		auto &mem = *mdb.mem;
 		int index = addr - mem.start_offset;
@@ -1103,9 +1492,12 @@ struct SimInstance
 			auto init_it = trace_mem_init_database.find(std::make_pair(memid, addr));
 			if (init_it != trace_mem_init_database.end())
 				data = init_it->second;
-			else
-				data = mem.get_init_data().extract(index * mem.width, mem.width);
-			shared->output_data.front().second.emplace(output_id, data);
+			else {
+				if (!mdb.init_contents)
+					mdb.init_contents.reset(new MemContents(mem.get_init_contents()));
+				data = (*mdb.init_contents)[index];
+			}
+			shared->output_data.first_data.emplace(output_id, data);
 		}
 		trace_mem_database[memid].emplace(index, make_pair(output_id, data));
 
@@ -1308,25 +1700,18 @@ struct SimWorker : SimShared
 	{
 		std::map<int,Const> data;
 		top->register_output_step_values(&data);
-		output_data.emplace_back(t, data);
+		if (output_data.empty() || !outputfiles.empty())
+			output_data.add_step(t, data);
 	}
 
 	void write_output_files()
 	{
 		std::map<int, bool> use_signal;
-		bool first = ignore_x;
-		for(auto& d : output_data)
-		{
-			if (first) {
-				for (auto &data : d.second)
-					use_signal[data.first] = !data.second.is_fully_undef();
-				first = false;
-			} else {
-				for (auto &data : d.second)
-					use_signal[data.first] = true;
-			}
-			if (!ignore_x) break;
-		}
+		for (auto &data : output_data.first_data)
+			use_signal[data.first] = !ignore_x || !data.second.is_fully_undef();
+		if (ignore_x)
+			for (auto id : output_data.later_signals)
+				use_signal[id] = true;
 		for(auto& writer : outputfiles)
 			writer->write(use_signal);
 		
@@ -1460,6 +1845,7 @@ struct SimWorker : SimShared
 	{
 		log_assert(top == nullptr);
 		fst = new FstData(sim_filename);
+		fst->setPrefetch(Pass::parallel_threads(topmod->design) > 1);
 
 		if (scope.empty())
 			log_error("Scope must be defined for co-simulation.\n");
@@ -1857,8 +2243,16 @@ struct SimWorker : SimShared
 		int addr;
 	};
 
+	struct YwClockCheck {
+		IdPath path;
+		int bits_offset;
+		State expected;
+	};
+
 	struct YwHierarchy {
 		dict<IdPath, FoundYWPath> paths;
+		// inactive clock values that every step is expected to have
+		std::vector<YwClockCheck> clock_checks;
 	};
 
 	YwHierarchy prepare_yw_hierarchy(const ReadWitness &yw)
@@ -1932,11 +2326,7 @@ struct SimWorker : SimShared
 					int clock_bits_offset = signal.bits_offset + (offset - signal.offset);
 
 					State expected = clock_input.second ? State::S0 : State::S1;
-
-					for (int t = 0; t < GetSize(yw.steps); t++) {
-						if (yw.get_bits(t, clock_bits_offset, 1) != expected)
-							log_warning("Yosys witness trace has an unexpected value for the clock input `%s` in step %d.\n", signal.path.str().c_str(), t);
-					}
+					hierarchy.clock_checks.push_back({signal.path, clock_bits_offset, expected});
 				}
 			}
 		}
@@ -1945,10 +2335,15 @@ struct SimWorker : SimShared
 		return hierarchy;
 	}
 
-	void set_yw_state(const ReadWitness &yw, const YwHierarchy &hierarchy, int t)
+	void check_yw_clocks(const YwHierarchy &hierarchy, const ReadWitness::Step &step, int t)
 	{
-		log_assert(t >= 0 && t < GetSize(yw.steps));
+		for (auto &check : hierarchy.clock_checks)
+			if (ReadWitness::get_bits(step, check.bits_offset, 1) != check.expected)
+				log_warning("Yosys witness trace has an unexpected value for the clock input `%s` in step %d.\n", check.path.str().c_str(), t);
+	}
 
+	void set_yw_state(const ReadWitness &yw, const YwHierarchy &hierarchy, const ReadWitness::Step &step, int t)
+	{
 		for (auto &signal : yw.signals) {
 			if (signal.init_only && t >= 1)
 				continue;
@@ -1957,7 +2352,7 @@ struct SimWorker : SimShared
 				continue;
 			auto &found_path = found_path_it->second;
 
-			Const value = yw.get_bits(t, signal.bits_offset, signal.width);
+			Const value = ReadWitness::get_bits(step, signal.bits_offset, signal.width);
 
 			if (debug)
 				log("yw: set %s to %s\n", signal.path.str().c_str(), log_const(value));
@@ -2005,18 +2400,22 @@ struct SimWorker : SimShared
 		if (multiclock)
 			log_warning("The -multiclock option is not required and ignored when reading a Yosys witness file.\n");
 
-		ReadWitness yw(sim_filename);
+		// the steps are read one at a time while simulating
+		ReadWitness yw(sim_filename, true);
+		ReadWitness::Step step;
 
 		top = new SimInstance(this, scope, topmod);
 		register_signals();
 
 		YwHierarchy hierarchy = prepare_yw_hierarchy(yw);
 
-		if (yw.steps.empty()) {
+		bool have_step = yw.next_step(step);
+		if (!have_step) {
 			log_warning("Yosys witness file `%s` contains no time steps\n", yw.filename.c_str());
 		} else {
+			check_yw_clocks(hierarchy, step, 0);
 			top->set_initstate_outputs(initstate ? State::S1 : State::S0);
-			set_yw_state(yw, hierarchy, 0);
+			set_yw_state(yw, hierarchy, step, 0);
 			set_yw_clocks(yw, hierarchy, true);
 			initialize_stable_past();
 			register_output_step(0);
@@ -2031,12 +2430,17 @@ struct SimWorker : SimShared
 			top->set_initstate_outputs(State::S0);
 		}
 
-		for (int cycle = 1; cycle < GetSize(yw.steps) + append; cycle++)
+		for (int cycle = 1;; cycle++)
 		{
+			have_step = have_step && yw.next_step(step);
+			if (!have_step && cycle >= yw.steps_read() + append)
+				break;
 			if (verbose)
 				log("Simulating cycle %d.\n", cycle);
-			if (cycle < GetSize(yw.steps))
-				set_yw_state(yw, hierarchy, cycle);
+			if (have_step) {
+				check_yw_clocks(hierarchy, step, cycle);
+				set_yw_state(yw, hierarchy, step, cycle);
+			}
 			set_yw_clocks(yw, hierarchy, true);
 			update(true);
 			register_output_step(10 * cycle);
@@ -2050,7 +2454,7 @@ struct SimWorker : SimShared
 			}
 		}
 
-		register_output_step(10 * (GetSize(yw.steps) + append));
+		register_output_step(10 * (yw.steps_read() + append));
 		write_output_files();
 	}
 
@@ -2124,6 +2528,7 @@ struct SimWorker : SimShared
 	void generate_tb(Module *topmod, std::string tb_filename, int numcycles)
 	{
 		fst = new FstData(sim_filename);
+		fst->setPrefetch(Pass::parallel_threads(topmod->design) > 1);
 
 		if (scope.empty())
 			log_error("Scope must be defined for co-simulation.\n");
@@ -2248,6 +2653,9 @@ struct SimWorker : SimShared
 		log("Writing data to `%s`\n", (tb_filename+".txt").c_str());
 		std::ofstream data_file(tb_filename+".txt");
 		std::stringstream initstate;
+		for (auto var : fst->getVars())
+			if (var.is_reg && (var.scope == scope || var.scope.find(scope+".") == 0))
+				fst->watchSignal(var.id);
 		try {
 			fst->reconstructAllAtTimes(fst_clock, startCount, stopCount, [&](uint64_t time) {
 				for(auto &item : clocks)
@@ -2373,10 +2781,10 @@ struct VCDWriter : public OutputWriter
 
 		vcdfile << stringf("$enddefinitions $end\n");
 
-		for(auto& d : worker->output_data)
+		worker->output_data.for_each_step([&](int time, const std::map<int,Const> &step_data)
 		{
-			vcdfile << stringf("#%d\n", d.first);
-			for (auto &data : d.second)
+			vcdfile << stringf("#%d\n", time);
+			for (auto &data : step_data)
 			{
 				if (!use_signal.at(data.first)) continue;
 				Const value = data.second;
@@ -2391,7 +2799,7 @@ struct VCDWriter : public OutputWriter
 				}
 				vcdfile << stringf(" n%d\n", data.first);
 			}
-		}
+		});
 	}
 
 	std::ofstream vcdfile;
@@ -2422,6 +2830,11 @@ struct FSTWriter : public OutputWriter
 
 		fstWriterSetPackType(fstfile, FST_WR_PT_FASTLZ);
 		fstWriterSetRepackOnClose(fstfile, 1);
+#ifdef FST_WRITER_PARALLEL
+		// compress the value change blocks in a separate thread while the next block is collected
+		if (Pass::parallel_threads(worker->top->module->design) > 1)
+			fstWriterSetParallelMode(fstfile, 1);
+#endif
 	   
 	   	worker->top->write_output_header(
 			[this](IdString name) { fstWriterSetScope(fstfile, FST_ST_VCD_MODULE, stringf("%s",log_id(name)).c_str(), nullptr); },
@@ -2435,10 +2848,10 @@ struct FSTWriter : public OutputWriter
 			}
 		);
 
-		for(auto& d : worker->output_data)
+		worker->output_data.for_each_step([&](int time, const std::map<int,Const> &step_data)
 		{
-			fstWriterEmitTimeChange(fstfile, d.first);
-			for (auto &data : d.second)
+			fstWriterEmitTimeChange(fstfile, time);
+			for (auto &data : step_data)
 			{
 				if (!use_signal.at(data.first)) continue;
 				Const value = data.second;
@@ -2453,7 +2866,7 @@ struct FSTWriter : public OutputWriter
 				}
 				fstWriterEmitValueChange(fstfile, mapping[data.first], ss.str().c_str());
 			}
-		}
+		});
 	}
 
 	struct fstContext *fstfile = nullptr;
@@ -2517,10 +2930,13 @@ struct AIWWriter : public OutputWriter
 
 		std::map<int, Yosys::RTLIL::Const> current;
 		bool first = true;
-		for (auto iter = worker->output_data.begin(); iter != std::prev(worker->output_data.end()); ++iter)
+		int step = 0;
+		worker->output_data.for_each_step([&](int, const std::map<int,Const> &step_data)
 		{
-			auto& d = *iter;
-			for (auto &data : d.second)
+			// the last step is not written
+			if (++step == worker->output_data.num_steps)
+				return;
+			for (auto &data : step_data)
 			{
 				current[data.first] = data.second;
 			}
@@ -2547,7 +2963,7 @@ struct AIWWriter : public OutputWriter
 					skip = true;
 			}
 			if (skip)
-				continue;
+				return;
 			for (int i = 0; i <= max_input; i++)
 			{
 				if (aiw_inputs.count(i)) {
@@ -2571,7 +2987,7 @@ struct AIWWriter : public OutputWriter
 				aiwfile << '0';
 			}
 			aiwfile << '\n';
-		} 
+		});
 	}
 
 	std::ofstream aiwfile;
@@ -2596,6 +3012,8 @@ struct SimPass : public Pass {
 		log("\n");
 		log("    -fst <filename>\n");
 		log("        write the simulation results to the given FST file\n");
+		log("        (with 'yosys -j' set to more than one thread, value changes are\n");
+		log("        compressed in a separate thread)\n");
 		log("\n");
 		log("    -aiw <filename>\n");
 		log("        write the simulation results to an AIGER witness file\n");
@@ -2632,6 +3050,20 @@ struct SimPass : public Pass {
 		log("    -zinit\n");
 		log("        zero-initialize all uninitialized regs and memories\n");
 		log("\n");
+		log("    -levelize\n");
+		log("        compile the combinational cells of each module into a list that is\n");
+		log("        evaluated in topological order, instead of re-evaluating a cell each\n");
+		log("        time one of its inputs changes. This is much faster for large designs.\n");
+		log("        Modules with combinational loops are simulated as without this option.\n");
+		log("        Has no effect together with -d.\n");
+		log("\n");
+		log("    -parallel\n");
+		log("        update the instances of submodules of a module in separate threads,\n");
+		log("        using the number of threads set with 'yosys -j'. This only helps for\n");
+		log("        designs with several large instances. Prints and assertions are still\n");
+		log("        evaluated serially, so the output does not change. Has no effect\n");
+		log("        together with -d.\n");
+		log("\n");
 		log("    -timescale <string>\n");
 		log("        include the specified timescale declaration in the vcd\n");
 		log("\n");
@@ -2651,6 +3083,8 @@ struct SimPass : public Pass {
 		log("        read simulation or formal results file\n");
 		log("            File formats supported: FST, VCD, AIW, WIT and .yw\n");
 		log("            VCD support requires vcd2fst external tool to be present\n");
+		log("            With 'yosys -j' set to more than one thread, an FST file is\n");
+		log("            decoded in a separate thread while the simulation runs\n");
 		log("\n");
 		log("    -append <integer>\n");
 		log("        number of extra clock cycles to simulate for a Yosys witness input\n");
@@ -2793,6 +3227,14 @@ struct SimPass : public Pass {
 				worker.zinit = true;
 				continue;
 			}
+			if (args[argidx] == "-levelize") {
+				worker.levelize = true;
+				continue;
+			}
+			if (args[argidx] == "-parallel") {
+				worker.parallel = true;
+				continue;
+			}
 			if (args[argidx] == "-r" && argidx+1 < args.size()) {
 				std::string sim_filename = args[++argidx];
 				rewrite_filename(sim_filename);
@@ -48,6 +48,7 @@
 #include "kernel/ff.h"
 #include "kernel/cost.h"
 #include "kernel/log.h"
+#include "passes/techmap/abc_cache.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -62,6 +63,15 @@
 #  include <dirent.h>
 #endif
 
+#if !defined(_WIN32) && !defined(__wasm) && !defined(YOSYS_LINK_ABC)
+#  define ABC_SERVER_SUPPORTED
+#  include <fcntl.h>
+#  include <signal.h>
+#  include <termios.h>
+#  include <sys/wait.h>
+#  include <mutex>
+#endif
+
 #include "frontends/blif/blifparse.h"
 
 #ifdef YOSYS_LINK_ABC
@@ -129,6 +139,56 @@ dict<int, std::string> pi_map, po_map;
 
 int undef_bits_lost;
 
+// The state of one ABC invocation between extracting its netlist and re-integrating the results. With `abc -j`,
+// the jobs of all modules and clock domains are kept while their ABC processes run concurrently.
+struct abc_job_t
+{
+	RTLIL::Module *module = nullptr;
+	int map_autoidx = 0;
+	std::vector<gate_t> signal_list;
+	dict<int, std::string> pi_map, po_map;
+	bool had_init = false;
+	bool clk_polarity = true, en_polarity = true, arst_polarity = true, srst_polarity = true;
+	RTLIL::SigSpec clk_sig, en_sig, arst_sig, srst_sig;
+
+	std::string tempdir_name, exe_file, command;
+	bool builtin_lib = true, sop_mode = false, cleanup = true, show_tempdir = false;
+	// With `abc -server`, the commands that load the library, which the server process runs once when it starts.
+	bool use_server = false;
+	std::string server_init;
+	// With the `abc.cache` scratchpad variable, the cache directory, and the file in it that holds (or will hold)
+	// the result of this job.
+	std::string cache_dir, cache_filename;
+	int count_output = 0;
+
+	int ret = 0;
+	bool logged_output = false;
+	std::vector<std::string> output;
+};
+
+// Exchanges the state saved in a job with the global state used by the functions below.
+void swap_job_state(abc_job_t &job)
+{
+	std::swap(module, job.module);
+	std::swap(map_autoidx, job.map_autoidx);
+	std::swap(signal_list, job.signal_list);
+	std::swap(pi_map, job.pi_map);
+	std::swap(po_map, job.po_map);
+	std::swap(had_init, job.had_init);
+	std::swap(clk_polarity, job.clk_polarity);
+	std::swap(en_polarity, job.en_polarity);
+	std::swap(arst_polarity, job.arst_polarity);
+	std::swap(srst_polarity, job.srst_polarity);
+	std::swap(clk_sig, job.clk_sig);
+	std::swap(en_sig, job.en_sig);
+	std::swap(arst_sig, job.arst_sig);
+	std::swap(srst_sig, job.srst_sig);
+}
+
+// Connections of cells that were extracted for another clock domain of the current module, whose ABC results have
+// not been re-integrated yet (only with `abc -j`). These signals must remain ports of the netlist.
+std::vector<RTLIL::SigSpec> pending_ports;
+
 int map_signal(RTLIL::SigBit bit, gate_type_t gate_type = G(NONE), int in1 = -1, int in2 = -1, int in3 = -1, int in4 = -1)
 {
 	assign_map.apply(bit);
@@ -651,8 +711,10 @@ struct abc_output_filter
 	std::string linebuf;
 	std::string tempdir_name;
 	bool show_tempdir;
+	const dict<int, std::string> &pi_map, &po_map;
 
-	abc_output_filter(std::string tempdir_name, bool show_tempdir) : tempdir_name(tempdir_name), show_tempdir(show_tempdir)
+	abc_output_filter(const abc_job_t &job) :
+			tempdir_name(job.tempdir_name), show_tempdir(job.show_tempdir), pi_map(job.pi_map), po_map(job.po_map)
 	{
 		got_cr = false;
 		escape_seq_state = 0;
@@ -703,11 +765,212 @@ struct abc_output_filter
 	}
 };
 
-void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
+#ifdef ABC_SERVER_SUPPORTED
+// A long-lived ABC process that runs the scripts of many jobs (`abc -server`), so that a large library only has to
+// be read once. Commands are written to the standard input of ABC. Its output goes to a pseudo-terminal rather than
+// a pipe, since ABC would otherwise buffer it; a job is done once ABC has echoed a line that marks its end.
+struct AbcServer
+{
+	pid_t pid = -1;
+	int input_fd = -1, output_fd = -1;
+	std::string pending;
+	int marker_counter = 0;
+	bool alive = false;
+
+	AbcServer(const AbcServer &) = delete;
+	AbcServer &operator=(const AbcServer &) = delete;
+
+	AbcServer(const std::string &exe_file)
+	{
+		int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+		if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0) {
+			if (master_fd >= 0)
+				close(master_fd);
+			return;
+		}
+		int slave_fd = open(ptsname(master_fd), O_RDWR | O_NOCTTY);
+		int input_pipe[2];
+		if (slave_fd < 0 || pipe(input_pipe) != 0) {
+			close(master_fd);
+			if (slave_fd >= 0)
+				close(slave_fd);
+			return;
+		}
+
+		// pass the output through unchanged (no CR before each LF)
+		struct termios tio;
+		if (tcgetattr(slave_fd, &tio) == 0) {
+			tio.c_oflag &= ~OPOST;
+			tcsetattr(slave_fd, TCSANOW, &tio);
+		}
+		fcntl(master_fd, F_SETFD, FD_CLOEXEC);
+		fcntl(input_pipe[1], F_SETFD, FD_CLOEXEC);
+
+		pid = fork();
+		if (pid == 0) {
+			setsid();
+			dup2(input_pipe[0], 0);
+			dup2(slave_fd, 1);
+			dup2(slave_fd, 2);
+			close(input_pipe[0]);
+			close(slave_fd);
+			execlp(exe_file.c_str(), exe_file.c_str(), "-s", (char *)nullptr);
+			_exit(127);
+		}
+
+		close(input_pipe[0]);
+		close(slave_fd);
+		input_fd = input_pipe[1];
+		output_fd = master_fd;
+		alive = pid > 0;
+	}
+
+	~AbcServer()
+	{
+		if (alive)
+			send("quit\n");
+		if (input_fd >= 0)
+			close(input_fd);
+		if (output_fd >= 0)
+			close(output_fd);
+		if (pid > 0)
+			waitpid(pid, nullptr, 0);
+	}
+
+	bool send(const std::string &text)
+	{
+		// a write to a process that has exited must not raise SIGPIPE in Yosys
+		struct sigaction ignore = {}, saved;
+		ignore.sa_handler = SIG_IGN;
+		sigaction(SIGPIPE, &ignore, &saved);
+		size_t done = 0;
+		while (alive && done < text.size()) {
+			ssize_t n = write(input_fd, text.data() + done, text.size() - done);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				alive = false;
+			else
+				done += n;
+		}
+		sigaction(SIGPIPE, &saved, nullptr);
+		return alive;
+	}
+
+	// Strips the prompts that ABC prints before reading each command, e.g. "abc 01> ".
+	static std::string strip_prompts(std::string line)
+	{
+		while (line.compare(0, 4, "abc ") == 0) {
+			size_t pos = 4;
+			while (pos < line.size() && isdigit((unsigned char)line[pos]))
+				pos++;
+			if (pos == 4 || line.compare(pos, 2, "> ") != 0)
+				break;
+			line = line.substr(pos + 2);
+		}
+		return line;
+	}
+
+	// Runs `commands` and passes the lines that ABC prints to `process_line`, until ABC has finished them.
+	// Returns false if ABC has exited, in which case this server can not be used anymore.
+	bool run(const std::string &commands, const std::function<void(const std::string&)> &process_line)
+	{
+		std::string marker = stringf("YOSYS-ABC-SERVER-DONE-%d", ++marker_counter);
+		if (!send(commands + "\necho " + marker + "\n"))
+			return false;
+
+		char buf[4096];
+		while (true) {
+			size_t pos;
+			while ((pos = pending.find('\n')) != std::string::npos) {
+				std::string line = strip_prompts(pending.substr(0, pos + 1));
+				pending = pending.substr(pos + 1);
+				size_t end = line.find_last_not_of(" \r\n");
+				if (line.substr(0, end == std::string::npos ? 0 : end + 1) == marker)
+					return true;
+				process_line(line);
+			}
+			ssize_t n = read(output_fd, buf, sizeof(buf));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0) {
+				if (!pending.empty())
+					process_line(strip_prompts(pending) + "\n");
+				pending.clear();
+				alive = false;
+				return false;
+			}
+			pending.append(buf, n);
+		}
+	}
+};
+
+// The idle server processes, by executable and library. A job takes a server out of the pool while it runs, so
+// that concurrent jobs (`abc -j`) get a server process each.
+struct AbcServerPool
+{
+	std::mutex mutex;
+	dict<std::string, std::vector<AbcServer*>> idle;
+
+	~AbcServerPool()
+	{
+		shutdown();
+	}
+
+	void shutdown()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto &it : idle)
+			for (auto server : it.second)
+				delete server;
+		idle.clear();
+	}
+
+	// Runs the script of `job` on a server process, starting one if there is no idle one.
+	int run(const abc_job_t &job, const std::function<void(const std::string&)> &process_line)
+	{
+		std::string key = job.exe_file + "\n" + job.server_init;
+		AbcServer *server = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = idle.find(key);
+			if (it != idle.end() && !it->second.empty()) {
+				server = it->second.back();
+				it->second.pop_back();
+			}
+		}
+
+		if (server == nullptr) {
+			process_line(stringf("Starting ABC server process `%s'.\n", job.exe_file.c_str()));
+			server = new AbcServer(job.exe_file);
+			if (!job.server_init.empty() && !server->run(job.server_init, process_line)) {
+				delete server;
+				return 1;
+			}
+		}
+
+		if (!server->run(job.command, process_line)) {
+			delete server;
+			return 1;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		idle[key].push_back(server);
+		return 0;
+	}
+};
+
+AbcServerPool abc_servers;
+#endif
+
+// Extracts the netlist of `cells` and writes the ABC script and libraries to a temporary directory. The state
+// needed to run ABC and to re-integrate its results is moved from the globals into `job`.
+void abc_module_prepare(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
 		std::vector<std::string> &liberty_files, std::vector<std::string> &genlib_files, std::string constr_file,
 		bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str, bool keepff, std::string delay_target,
 		std::string sop_inputs, std::string sop_products, std::string lutin_shared, bool fast_mode,
-		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, bool abc_dress, std::vector<std::string> &dont_use_cells)
+		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, bool abc_dress, std::vector<std::string> &dont_use_cells,
+		abc_job_t &job)
 {
 	module = current_module;
 	map_autoidx = autoidx++;
@@ -800,19 +1063,25 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 	std::string abc_script = stringf("read_blif \"%s/input.blif\"; ", tempdir_name.c_str());
 
 	if (!liberty_files.empty() || !genlib_files.empty()) {
+		std::string library_script;
 		std::string dont_use_args;
 		for (std::string dont_use_cell : dont_use_cells) {
 			dont_use_args += stringf("-X \"%s\" ", dont_use_cell.c_str());
 		}
 		bool first_lib = true;
 		for (std::string liberty_file : liberty_files) {
-			abc_script += stringf("read_lib %s %s -w \"%s\" ; ", dont_use_args.c_str(), first_lib ? "" : "-m", liberty_file.c_str());
+			library_script += stringf("read_lib %s %s -w \"%s\" ; ", dont_use_args.c_str(), first_lib ? "" : "-m", liberty_file.c_str());
 			first_lib = false;
 		}
 		for (std::string liberty_file : genlib_files)
-			abc_script += stringf("read_library \"%s\"; ", liberty_file.c_str());
+			library_script += stringf("read_library \"%s\"; ", liberty_file.c_str());
 		if (!constr_file.empty())
-			abc_script += stringf("read_constr -v \"%s\"; ", constr_file.c_str());
+			library_script += stringf("read_constr -v \"%s\"; ", constr_file.c_str());
+		// a server process reads the library once, and keeps it loaded for all the jobs it runs
+		if (job.use_server)
+			job.server_init = library_script;
+		else
+			abc_script += library_script;
 	} else
 	if (!lut_costs.empty())
 		abc_script += stringf("read_lut %s/lutdefs.txt; ", tempdir_name.c_str());
@@ -922,6 +1191,9 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 	if (srst_sig.size() != 0)
 		mark_port(srst_sig);
 
+	for (auto &sig : pending_ports)
+		mark_port(sig);
+
 	handle_loops();
 
 	buffer = stringf("%s/input.blif", tempdir_name.c_str());
@@ -1105,68 +1377,148 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			fclose(f);
 		}
 
-		buffer = stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
-		log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
+		if (job.use_server) {
+			buffer = stringf("source %s/abc.script", tempdir_name.c_str());
+			log("Running ABC server command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
+		} else {
+			buffer = stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
+			log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
+		}
+		job.command = buffer;
+
+		if (!job.cache_dir.empty()) {
+			std::vector<std::string> other_files = liberty_files;
+			other_files.insert(other_files.end(), genlib_files.begin(), genlib_files.end());
+			if (!constr_file.empty())
+				other_files.push_back(constr_file);
+			if (!script_file.empty() && script_file[0] != '+')
+				other_files.push_back(script_file);
+			job.cache_filename = abc_cache_filename(job.cache_dir, exe_file + "\n" + job.server_init, tempdir_name,
+					{"input.blif", "abc.script", "lutdefs.txt", "stdcells.genlib"}, other_files);
+		}
+	}
+
+	job.tempdir_name = tempdir_name;
+	job.exe_file = exe_file;
+	job.builtin_lib = liberty_files.empty() && genlib_files.empty();
+	job.sop_mode = sop_mode;
+	job.cleanup = cleanup;
+	job.show_tempdir = show_tempdir;
+	job.count_output = count_output;
+	swap_job_state(job);
+}
+
+// Runs ABC for a prepared job. If `live` is false, the output of ABC is kept in the job instead of being logged,
+// which makes this safe to call for several jobs concurrently; abc_module_integrate() logs it afterwards.
+void abc_module_run(abc_job_t &job, bool live)
+{
+	if (job.count_output == 0)
+		return;
+
+	job.logged_output = live;
+	std::function<void(const std::string&)> process_line;
+	if (live)
+		process_line = std::bind(&abc_output_filter::next_line, abc_output_filter(job), std::placeholders::_1);
+	else
+		process_line = [&](const std::string &line) { job.output.push_back(line); };
+
+	std::string output_filename = stringf("%s/output.blif", job.tempdir_name.c_str());
+	std::vector<std::string> output_lines;
+	if (!job.cache_filename.empty()) {
+		if (abc_cache_load(job.cache_filename, job.tempdir_name, output_filename, process_line)) {
+			job.ret = 0;
+			return;
+		}
+		process_line = [&output_lines, process_line](const std::string &line) {
+			output_lines.push_back(line);
+			process_line(line);
+		};
+	}
 
 #ifndef YOSYS_LINK_ABC
-		abc_output_filter filt(tempdir_name, show_tempdir);
-		int ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
+#ifdef ABC_SERVER_SUPPORTED
+	if (job.use_server)
+		job.ret = abc_servers.run(job, process_line);
+	else
+#endif
+		job.ret = run_command(job.command, process_line);
 #else
-		string temp_stdouterr_name = stringf("%s/stdouterr.txt", tempdir_name.c_str());
-		FILE *temp_stdouterr_w = fopen(temp_stdouterr_name.c_str(), "w");
-		if (temp_stdouterr_w == NULL)
-			log_error("ABC: cannot open a temporary file for output redirection");
-		fflush(stdout);
-		fflush(stderr);
-		FILE *old_stdout = fopen(temp_stdouterr_name.c_str(), "r"); // need any fd for renumbering
-		FILE *old_stderr = fopen(temp_stdouterr_name.c_str(), "r"); // need any fd for renumbering
+	log_assert(live);
+	const std::string &tempdir_name = job.tempdir_name;
+	const std::string &exe_file = job.exe_file;
+	string temp_stdouterr_name = stringf("%s/stdouterr.txt", tempdir_name.c_str());
+	FILE *temp_stdouterr_w = fopen(temp_stdouterr_name.c_str(), "w");
+	if (temp_stdouterr_w == NULL)
+		log_error("ABC: cannot open a temporary file for output redirection");
+	fflush(stdout);
+	fflush(stderr);
+	FILE *old_stdout = fopen(temp_stdouterr_name.c_str(), "r"); // need any fd for renumbering
+	FILE *old_stderr = fopen(temp_stdouterr_name.c_str(), "r"); // need any fd for renumbering
 #if defined(__wasm)
 #define fd_renumber(from, to) (void)__wasi_fd_renumber(from, to)
 #else
 #define fd_renumber(from, to) dup2(from, to)
 #endif
-		fd_renumber(fileno(stdout), fileno(old_stdout));
-		fd_renumber(fileno(stderr), fileno(old_stderr));
-		fd_renumber(fileno(temp_stdouterr_w), fileno(stdout));
-		fd_renumber(fileno(temp_stdouterr_w), fileno(stderr));
-		fclose(temp_stdouterr_w);
-		// These needs to be mutable, supposedly due to getopt
-		char *abc_argv[5];
-		string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
-		abc_argv[0] = strdup(exe_file.c_str());
-		abc_argv[1] = strdup("-s");
-		abc_argv[2] = strdup("-f");
-		abc_argv[3] = strdup(tmp_script_name.c_str());
-		abc_argv[4] = 0;
-		int ret = abc::Abc_RealMain(4, abc_argv);
-		free(abc_argv[0]);
-		free(abc_argv[1]);
-		free(abc_argv[2]);
-		free(abc_argv[3]);
-		fflush(stdout);
-		fflush(stderr);
-		fd_renumber(fileno(old_stdout), fileno(stdout));
-		fd_renumber(fileno(old_stderr), fileno(stderr));
-		fclose(old_stdout);
-		fclose(old_stderr);
-		std::ifstream temp_stdouterr_r(temp_stdouterr_name);
-		abc_output_filter filt(tempdir_name, show_tempdir);
-		for (std::string line; std::getline(temp_stdouterr_r, line); )
-			filt.next_line(line + "\n");
-		temp_stdouterr_r.close();
+	fd_renumber(fileno(stdout), fileno(old_stdout));
+	fd_renumber(fileno(stderr), fileno(old_stderr));
+	fd_renumber(fileno(temp_stdouterr_w), fileno(stdout));
+	fd_renumber(fileno(temp_stdouterr_w), fileno(stderr));
+	fclose(temp_stdouterr_w);
+	// These needs to be mutable, supposedly due to getopt
+	char *abc_argv[5];
+	string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
+	abc_argv[0] = strdup(exe_file.c_str());
+	abc_argv[1] = strdup("-s");
+	abc_argv[2] = strdup("-f");
+	abc_argv[3] = strdup(tmp_script_name.c_str());
+	abc_argv[4] = 0;
+	job.ret = abc::Abc_RealMain(4, abc_argv);
+	free(abc_argv[0]);
+	free(abc_argv[1]);
+	free(abc_argv[2]);
+	free(abc_argv[3]);
+	fflush(stdout);
+	fflush(stderr);
+	fd_renumber(fileno(old_stdout), fileno(stdout));
+	fd_renumber(fileno(old_stderr), fileno(stderr));
+	fclose(old_stdout);
+	fclose(old_stderr);
+	std::ifstream temp_stdouterr_r(temp_stdouterr_name);
+	for (std::string line; std::getline(temp_stdouterr_r, line); )
+		process_line(line + "\n");
+	temp_stdouterr_r.close();
 #endif
-		if (ret != 0)
-			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
 
-		buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
+	if (!job.cache_filename.empty() && job.ret == 0)
+		abc_cache_store(job.cache_filename, job.tempdir_name, output_filename, output_lines);
+}
+
+// Logs the output of ABC for a job that has run, and replaces the extracted cells with the cells mapped by ABC.
+void abc_module_integrate(RTLIL::Design *design, abc_job_t &job)
+{
+	if (job.count_output > 0 && !job.logged_output) {
+		abc_output_filter filt(job);
+		for (auto &line : job.output)
+			filt.next_line(line);
+	}
+
+	swap_job_state(job);
+	const std::string &tempdir_name = job.tempdir_name;
+
+	if (job.count_output > 0)
+	{
+		if (job.ret != 0)
+			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", job.command.c_str(), job.ret);
+
+		std::string buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
 		std::ifstream ifs;
 		ifs.open(buffer);
 		if (ifs.fail())
 			log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
 
-		bool builtin_lib = liberty_files.empty() && genlib_files.empty();
+		bool builtin_lib = job.builtin_lib;
 		RTLIL::Design *mapped_design = new RTLIL::Design;
-		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
+		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, job.sop_mode);
 
 		ifs.close();
 
@@ -1442,7 +1794,7 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		log("Don't call ABC as there is nothing to map.\n");
 	}
 
-	if (cleanup)
+	if (job.cleanup)
 	{
 		log("Removing temp directory.\n");
 		remove_directory(tempdir_name);
@@ -1629,6 +1981,20 @@ struct AbcPass : public Pass {
 		log("        this attribute is a unique integer for each ABC process started. This\n");
 		log("        is useful for debugging the partitioning of clock domains.\n");
 		log("\n");
+		log("    -j <num>\n");
+		log("        run up to <num> ABC processes at the same time. the netlists of all\n");
+		log("        selected modules (and with -dff, of all their clock domains) are\n");
+		log("        extracted first, and the results are re-integrated in the same order\n");
+		log("        after all ABC processes have finished. the result is the same for every\n");
+		log("        <num> greater than 1.\n");
+		log("\n");
+		log("    -server\n");
+		log("        run the ABC scripts in ABC processes that are kept running for the rest\n");
+		log("        of the session and reused by later 'abc -server' calls with the same\n");
+		log("        executable and -liberty/-genlib/-constr files. these files are read\n");
+		log("        only once by each process, so changes to them are not noticed later.\n");
+		log("        not available on Windows, or when ABC is linked into Yosys.\n");
+		log("\n");
 		log("    -dress\n");
 		log("        run the 'dress' command after all other ABC commands. This aims to\n");
 		log("        preserve naming by an equivalence check between the original and\n");
@@ -1637,6 +2003,12 @@ struct AbcPass : public Pass {
 		log("When no target cell library is specified the Yosys standard cell library is\n");
 		log("loaded into ABC before the ABC script is executed.\n");
 		log("\n");
+		log("When the scratchpad variable 'abc.cache' is set to a directory name, the\n");
+		log("results of ABC are stored in that directory, and are reused when the same\n");
+		log("netlist is mapped again with the same script, options and library files.\n");
+		log("An updated ABC executable is not noticed, so the cache should be cleared\n");
+		log("when ABC changes.\n");
+		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
 		log("ABC on logic snippets extracted from your design. You will not get any useful\n");
@@ -1659,7 +2031,7 @@ struct AbcPass : public Pass {
 		pi_map.clear();
 		po_map.clear();
 
-		std::string exe_file = yosys_abc_executable;
+		std::string exe_file = proc_abc_executable();
 		std::string script_file, default_liberty_file, constr_file, clk_str;
 		std::vector<std::string> liberty_files, genlib_files, dont_use_cells;
 		std::string delay_target, sop_inputs, sop_products, lutin_shared = "-S 1";
@@ -1667,6 +2039,9 @@ struct AbcPass : public Pass {
 		bool show_tempdir = false, sop_mode = false;
 		bool abc_dress = false;
 		vector<int> lut_costs;
+		int num_jobs = 1;
+		bool use_server = false;
+		std::string cache_dir;
 		markgroups = false;
 
 		map_mux4 = false;
@@ -1700,6 +2075,8 @@ struct AbcPass : public Pass {
 		map_mux8 = design->scratchpad_get_bool("abc.mux8", map_mux8);
 		map_mux16 = design->scratchpad_get_bool("abc.mux16", map_mux16);
 		abc_dress = design->scratchpad_get_bool("abc.dress", abc_dress);
+		use_server = design->scratchpad_get_bool("abc.server", use_server);
+		cache_dir = design->scratchpad_get_string("abc.cache", cache_dir);
 		g_arg = design->scratchpad_get_string("abc.g", g_arg);
 
 		fast_mode = design->scratchpad_get_bool("abc.fast", fast_mode);
@@ -1796,6 +2173,16 @@ struct AbcPass : public Pass {
 				map_mux16 = true;
 				continue;
 			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				num_jobs = atoi(args[++argidx].c_str());
+				if (num_jobs < 1)
+					log_cmd_error("Invalid number of jobs: %s\n", args[argidx].c_str());
+				continue;
+			}
+			if (arg == "-server") {
+				use_server = true;
+				continue;
+			}
 			if (arg == "-dress") {
 				abc_dress = true;
 				continue;
@@ -2042,6 +2429,33 @@ struct AbcPass : public Pass {
 			// enabled_gates.insert("NMUX");
 		}
 
+#ifndef ABC_SERVER_SUPPORTED
+		if (use_server) {
+			log("Ignoring -server, since ABC server processes are not supported by this build.\n");
+			use_server = false;
+		}
+#endif
+#ifdef YOSYS_LINK_ABC
+		if (num_jobs > 1) {
+			log("Ignoring -j, since ABC is linked into this build and can only run one netlist at a time.\n");
+			num_jobs = 1;
+		}
+#endif
+
+		// Without -j, each netlist is mapped as soon as it has been extracted. With -j, the netlists of all modules
+		// and clock domains are extracted first, ABC runs on all of them concurrently, and then the results are
+		// re-integrated in the order the netlists were extracted in, so the result does not depend on scheduling.
+		std::vector<abc_job_t> jobs;
+		auto job_prepared = [&]() {
+			if (num_jobs > 1) {
+				log_pop();
+				return;
+			}
+			abc_module_run(jobs.back(), true);
+			abc_module_integrate(design, jobs.back());
+			jobs.clear();
+		};
+
 		for (auto mod : design->selected_modules())
 		{
 			if (mod->processes.size() > 0) {
@@ -2051,10 +2465,16 @@ struct AbcPass : public Pass {
 
 			assign_map.set(mod);
 			initvals.set(&assign_map, mod);
+			pending_ports.clear();
 
 			if (!dff_mode || !clk_str.empty()) {
-				abc_module(design, mod, script_file, exe_file, liberty_files, genlib_files, constr_file, cleanup, lut_costs, dff_mode, clk_str, keepff,
-						delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, mod->selected_cells(), show_tempdir, sop_mode, abc_dress, dont_use_cells);
+				jobs.emplace_back();
+				jobs.back().use_server = use_server;
+				jobs.back().cache_dir = cache_dir;
+				abc_module_prepare(design, mod, script_file, exe_file, liberty_files, genlib_files, constr_file, cleanup, lut_costs, dff_mode, clk_str, keepff,
+						delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, mod->selected_cells(), show_tempdir, sop_mode, abc_dress, dont_use_cells,
+						jobs.back());
+				job_prepared();
 				continue;
 			}
 
@@ -2215,12 +2635,46 @@ struct AbcPass : public Pass {
 				arst_sig = assign_map(std::get<5>(it.first));
 				srst_polarity = std::get<6>(it.first);
 				srst_sig = assign_map(std::get<7>(it.first));
-				abc_module(design, mod, script_file, exe_file, liberty_files, genlib_files, constr_file, cleanup, lut_costs, !clk_sig.empty(), "$",
-						keepff, delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, it.second, show_tempdir, sop_mode, abc_dress, dont_use_cells);
+				std::vector<RTLIL::SigSpec> domain_ports;
+				if (num_jobs > 1)
+					for (auto cell : it.second)
+						for (auto &conn : cell->connections())
+							domain_ports.push_back(conn.second);
+				jobs.emplace_back();
+				jobs.back().use_server = use_server;
+				jobs.back().cache_dir = cache_dir;
+				abc_module_prepare(design, mod, script_file, exe_file, liberty_files, genlib_files, constr_file, cleanup, lut_costs, !clk_sig.empty(), "$",
+						keepff, delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, it.second, show_tempdir, sop_mode, abc_dress, dont_use_cells,
+						jobs.back());
+				job_prepared();
+				pending_ports.insert(pending_ports.end(), domain_ports.begin(), domain_ports.end());
 				assign_map.set(mod);
 			}
 		}
 
+		if (!jobs.empty())
+		{
+			int count_netlists = 0;
+			for (auto &job : jobs)
+				count_netlists += job.count_output > 0;
+			log_header(design, "Running ABC on %d netlists with up to %d processes.\n", count_netlists, num_jobs);
+			Pass::parallel_for(design, GetSize(jobs), [&](int i) { abc_module_run(jobs[i], false); }, num_jobs);
+
+			RTLIL::Module *integrated_module = nullptr;
+			for (auto &job : jobs) {
+				if (job.module != integrated_module) {
+					integrated_module = job.module;
+					assign_map.set(integrated_module);
+					initvals.set(&assign_map, integrated_module);
+				}
+				log_push();
+				abc_module_integrate(design, job);
+				assign_map.set(integrated_module);
+			}
+			jobs.clear();
+		}
+		pending_ports.clear();
+
 		assign_map.clear();
 		signal_list.clear();
 		signal_map.clear();
@@ -2230,6 +2684,13 @@ struct AbcPass : public Pass {
 
 		log_pop();
 	}
+
+#ifdef ABC_SERVER_SUPPORTED
+	void on_shutdown() override
+	{
+		abc_servers.shutdown();
+	}
+#endif
 } AbcPass;
 
 PRIVATE_NAMESPACE_END
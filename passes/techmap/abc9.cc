@@ -171,6 +171,13 @@ struct Abc9Pass : public ScriptPass
 		log("    -box <file>\n");
 		log("        pass this file with box library to ABC.\n");
 		log("\n");
+		log("    -j <num>\n");
+		log("        extract the netlists of all selected modules first, and then run up to\n");
+		log("        <num> ABC processes concurrently (see 'abc9_exe -j'). the results are\n");
+		log("        reintegrated in the order of the modules. (default: 1)\n");
+		log("\n");
+		log("See 'help abc9_exe' for the 'abc9.cache' scratchpad variable.\n");
+		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
 		log("ABC on logic snippets extracted from your design. You will not get any useful\n");
@@ -188,6 +195,7 @@ struct Abc9Pass : public ScriptPass
 	bool dff_mode, cleanup;
 	bool lut_mode;
 	int maxlut;
+	int num_jobs;
 	std::string box_file;
 
 	void clear_flags() override
@@ -198,6 +206,7 @@ struct Abc9Pass : public ScriptPass
 		cleanup = true;
 		lut_mode = false;
 		maxlut = 0;
+		num_jobs = 1;
 		box_file = "";
 	}
 
@@ -250,6 +259,12 @@ struct Abc9Pass : public ScriptPass
 				maxlut = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				num_jobs = atoi(args[++argidx].c_str());
+				if (num_jobs < 1)
+					log_cmd_error("Invalid number of jobs: %s\n", args[argidx].c_str());
+				continue;
+			}
 			if (arg == "-run" && argidx+1 < args.size()) {
 				size_t pos = args[argidx+1].find(':');
 				if (pos == std::string::npos)
@@ -393,6 +408,42 @@ struct Abc9Pass : public ScriptPass
 				auto selected_modules = active_design->selected_modules();
 				active_design->selection_stack.emplace_back(false);
 
+				// With -j, the netlists of all modules are extracted first and then mapped by a single abc9_exe
+				// command. The LUT and box libraries do not depend on the module, so they are only written into
+				// the temp dir of the first module in that case.
+				bool batch_mode = num_jobs > 1;
+				std::string library_dir;
+				std::vector<std::tuple<RTLIL::Module*, std::string, bool>> extracted;
+
+				auto abc9_exe_cmd = [&](const std::vector<std::string> &tempdir_names) {
+					std::string cmd = exe_cmd.str();
+					if (batch_mode)
+						cmd += stringf(" -j %d", num_jobs);
+					for (auto &tempdir_name : tempdir_names)
+						cmd += stringf(" -cwd %s", tempdir_name.c_str());
+					if (!lut_mode)
+						cmd += stringf(" -lut %s/input.lut", library_dir.c_str());
+					if (box_file.empty())
+						cmd += stringf(" -box %s/input.box", library_dir.c_str());
+					else
+						cmd += stringf(" -box %s", box_file.c_str());
+					return cmd;
+				};
+
+				auto reintegrate = [&](RTLIL::Module *mod, const std::string &tempdir_name, bool mapped) {
+					if (mapped) {
+						run_nocheck(stringf("read_aiger -xaiger -wideports -module_name %s$abc9 -map %s/input.sym %s/output.aig", log_id(mod), tempdir_name.c_str(), tempdir_name.c_str()));
+						run_nocheck(stringf("abc9_ops -reintegrate %s", dff_mode ? "-dff" : ""));
+					}
+
+					if (cleanup) {
+						log("Removing temp directory.\n");
+						remove_directory(tempdir_name);
+					}
+					mod->check();
+					active_design->selection().selected_modules.clear();
+				};
+
 				for (auto mod : selected_modules) {
 					if (mod->processes.size() > 0) {
 						log("Skipping module %s as it contains processes.\n", log_id(mod));
@@ -413,10 +464,13 @@ struct Abc9Pass : public ScriptPass
 					tempdir_name += proc_program_prefix() + "yosys-abc-XXXXXX";
 					tempdir_name = make_temp_dir(tempdir_name);
 
-					if (!lut_mode)
-						run_nocheck(stringf("abc9_ops -write_lut %s/input.lut", tempdir_name.c_str()));
-					if (box_file.empty())
-						run_nocheck(stringf("abc9_ops -write_box %s/input.box", tempdir_name.c_str()));
+					if (!batch_mode || library_dir.empty()) {
+						library_dir = tempdir_name;
+						if (!lut_mode)
+							run_nocheck(stringf("abc9_ops -write_lut %s/input.lut", tempdir_name.c_str()));
+						if (box_file.empty())
+							run_nocheck(stringf("abc9_ops -write_box %s/input.box", tempdir_name.c_str()));
+					}
 					run_nocheck(stringf("write_xaiger -map %s/input.sym %s %s/input.xaig", tempdir_name.c_str(), dff_mode ? "-dff" : "", tempdir_name.c_str()));
 
 					int num_outputs = active_design->scratchpad_get_int("write_xaiger.num_outputs");
@@ -427,31 +481,36 @@ struct Abc9Pass : public ScriptPass
 							log_id(mod),
 							active_design->scratchpad_get_int("write_xaiger.num_inputs"),
 							num_outputs);
-					if (num_outputs) {
-						std::string abc9_exe_cmd;
-						abc9_exe_cmd += stringf("%s -cwd %s", exe_cmd.str().c_str(), tempdir_name.c_str());
-						if (!lut_mode)
-							abc9_exe_cmd += stringf(" -lut %s/input.lut", tempdir_name.c_str());
-						if (box_file.empty())
-							abc9_exe_cmd += stringf(" -box %s/input.box", tempdir_name.c_str());
-						else
-							abc9_exe_cmd += stringf(" -box %s", box_file.c_str());
-						run_nocheck(abc9_exe_cmd);
-						run_nocheck(stringf("read_aiger -xaiger -wideports -module_name %s$abc9 -map %s/input.sym %s/output.aig", log_id(mod), tempdir_name.c_str(), tempdir_name.c_str()));
-						run_nocheck(stringf("abc9_ops -reintegrate %s", dff_mode ? "-dff" : ""));
-					}
-					else
+					if (!num_outputs)
 						log("Don't call ABC as there is nothing to map.\n");
 
-					if (cleanup) {
-						log("Removing temp directory.\n");
-						remove_directory(tempdir_name);
+					if (batch_mode) {
+						extracted.emplace_back(mod, tempdir_name, num_outputs > 0);
+						active_design->selection().selected_modules.clear();
+					} else {
+						if (num_outputs)
+							run_nocheck(abc9_exe_cmd({tempdir_name}));
+						reintegrate(mod, tempdir_name, num_outputs > 0);
 					}
-					mod->check();
-					active_design->selection().selected_modules.clear();
 					log_pop();
 				}
 
+				if (batch_mode) {
+					std::vector<std::string> tempdir_names;
+					for (auto &it : extracted)
+						if (std::get<2>(it))
+							tempdir_names.push_back(std::get<1>(it));
+					if (!tempdir_names.empty())
+						run_nocheck(abc9_exe_cmd(tempdir_names));
+
+					for (auto &it : extracted) {
+						log_push();
+						active_design->selection().select(std::get<0>(it));
+						reintegrate(std::get<0>(it), std::get<1>(it), std::get<2>(it));
+						log_pop();
+					}
+				}
+
 				active_design->selection_stack.pop_back();
 			}
 		}
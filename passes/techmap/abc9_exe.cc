@@ -24,6 +24,7 @@
 
 #include "kernel/register.h"
 #include "kernel/log.h"
+#include "passes/techmap/abc_cache.h"
 
 #ifndef _WIN32
 #  include <unistd.h>
@@ -164,9 +165,10 @@ struct abc9_output_filter
 	}
 };
 
-void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe_file,
-		vector<int> lut_costs, bool dff_mode, std::string delay_target, std::string /*lutin_shared*/, bool fast_mode,
-		bool show_tempdir, std::string box_file, std::string lut_file,
+// Writes the ABC script (and LUT library) into `tempdir_name` and returns the command that runs it.
+std::string abc9_module_prepare(RTLIL::Design *design, std::string script_file, std::string exe_file,
+		vector<int> lut_costs, bool dff_mode, std::string delay_target, bool fast_mode,
+		std::string box_file, std::string lut_file,
 		std::vector<std::string> liberty_files, std::string wire_delay, std::string tempdir_name,
 		std::string constr_file, std::vector<std::string> dont_use_cells)
 {
@@ -261,8 +263,6 @@ void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe
 
 	std::string buffer;
 
-	log_header(design, "Executing ABC9.\n");
-
 	if (!lut_costs.empty()) {
 		buffer = stringf("%s/lutdefs.txt", tempdir_name.c_str());
 		f = fopen(buffer.c_str(), "wt");
@@ -274,11 +274,61 @@ void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe
 	}
 
 	buffer = stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
+	return buffer;
+}
+
+void abc9_module_check(const std::string &buffer, const std::string &tempdir_name, int ret)
+{
+	if (ret != 0) {
+		if (check_file_exists(stringf("%s/output.aig", tempdir_name.c_str())))
+			log_warning("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+		else
+			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+	}
+}
+
+// With the `abc9.cache` scratchpad variable, returns the file that holds (or will hold) the result of ABC for the
+// files in `tempdir_name`.
+std::string abc9_cache_filename(RTLIL::Design *design, std::string script_file, std::string exe_file,
+		std::string box_file, std::string lut_file, std::vector<std::string> liberty_files, std::string tempdir_name,
+		std::string constr_file)
+{
+	std::string cache_dir = design->scratchpad_get_string("abc9.cache");
+	if (cache_dir.empty())
+		return std::string();
+
+	// The box and LUT files written by `abc9` are in the temp dir of another netlist, so they are keyed by contents.
+	std::vector<std::string> other_files = liberty_files, content_files = {box_file};
+	if (!lut_file.empty())
+		content_files.push_back(lut_file);
+	if (!constr_file.empty())
+		other_files.push_back(constr_file);
+	if (!script_file.empty() && script_file[0] != '+')
+		other_files.push_back(script_file);
+	return abc_cache_filename(cache_dir, exe_file, tempdir_name, {"input.xaig", "abc.script", "lutdefs.txt"},
+			other_files, content_files);
+}
+
+void abc9_module_run(const std::string &buffer, YS_MAYBE_UNUSED const std::string &exe_file, const std::string &tempdir_name, bool show_tempdir,
+		const std::string &cache_filename)
+{
 	log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
 
+	std::function<void(const std::string&)> process_line =
+			std::bind(&abc9_output_filter::next_line, abc9_output_filter(tempdir_name, show_tempdir), std::placeholders::_1);
+	std::string output_filename = stringf("%s/output.aig", tempdir_name.c_str());
+	std::vector<std::string> output_lines;
+	if (!cache_filename.empty()) {
+		if (abc_cache_load(cache_filename, tempdir_name, output_filename, process_line))
+			return;
+		process_line = [&output_lines, process_line](const std::string &line) {
+			output_lines.push_back(line);
+			process_line(line);
+		};
+	}
+
 #ifndef YOSYS_LINK_ABC
-	abc9_output_filter filt(tempdir_name, show_tempdir);
-	int ret = run_command(buffer, std::bind(&abc9_output_filter::next_line, filt, std::placeholders::_1));
+	int ret = run_command(buffer, process_line);
 #else
 	string temp_stdouterr_name = stringf("%s/stdouterr.txt", tempdir_name.c_str());
 	FILE *temp_stdouterr_w = fopen(temp_stdouterr_name.c_str(), "w");
@@ -318,16 +368,61 @@ void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe
 	fclose(old_stdout);
 	fclose(old_stderr);
 	std::ifstream temp_stdouterr_r(temp_stdouterr_name);
-	abc9_output_filter filt(tempdir_name, show_tempdir);
 	for (std::string line; std::getline(temp_stdouterr_r, line); )
-		filt.next_line(line + "\n");
+		process_line(line + "\n");
 	temp_stdouterr_r.close();
 #endif
-	if (ret != 0) {
-		if (check_file_exists(stringf("%s/output.aig", tempdir_name.c_str())))
-			log_warning("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
-		else
-			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+	if (!cache_filename.empty() && ret == 0)
+		abc_cache_store(cache_filename, tempdir_name, output_filename, output_lines);
+	abc9_module_check(buffer, tempdir_name, ret);
+}
+
+void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe_file,
+		vector<int> lut_costs, bool dff_mode, std::string delay_target, std::string /*lutin_shared*/, bool fast_mode,
+		bool show_tempdir, std::string box_file, std::string lut_file,
+		std::vector<std::string> liberty_files, std::string wire_delay, const std::vector<std::string> &tempdir_names,
+		std::string constr_file, std::vector<std::string> dont_use_cells, int num_jobs)
+{
+	log_header(design, "Executing ABC9.\n");
+
+	if (num_jobs == 1 || GetSize(tempdir_names) == 1) {
+		for (auto &tempdir_name : tempdir_names) {
+			std::string buffer = abc9_module_prepare(design, script_file, exe_file, lut_costs, dff_mode, delay_target, fast_mode,
+					box_file, lut_file, liberty_files, wire_delay, tempdir_name, constr_file, dont_use_cells);
+			abc9_module_run(buffer, exe_file, tempdir_name, show_tempdir,
+					abc9_cache_filename(design, script_file, exe_file, box_file, lut_file, liberty_files, tempdir_name, constr_file));
+		}
+		return;
+	}
+
+	// Run the ABC processes concurrently, and log their output afterwards in the order of the `-cwd` options.
+	std::vector<std::string> commands, cache_filenames;
+	for (auto &tempdir_name : tempdir_names) {
+		commands.push_back(abc9_module_prepare(design, script_file, exe_file, lut_costs, dff_mode, delay_target, fast_mode,
+				box_file, lut_file, liberty_files, wire_delay, tempdir_name, constr_file, dont_use_cells));
+		cache_filenames.push_back(abc9_cache_filename(design, script_file, exe_file, box_file, lut_file, liberty_files,
+				tempdir_name, constr_file));
+	}
+
+	log("Running ABC on %d netlists with up to %d processes.\n", GetSize(commands), num_jobs);
+	std::vector<int> rets(GetSize(commands));
+	std::vector<std::vector<std::string>> outputs(GetSize(commands));
+	Pass::parallel_for(design, GetSize(commands), [&](int i) {
+		auto process_line = [&](const std::string &line) { outputs[i].push_back(line); };
+		std::string output_filename = stringf("%s/output.aig", tempdir_names[i].c_str());
+		if (!cache_filenames[i].empty() && abc_cache_load(cache_filenames[i], tempdir_names[i], output_filename, process_line))
+			return;
+		rets[i] = run_command(commands[i], process_line);
+		if (!cache_filenames[i].empty() && rets[i] == 0)
+			abc_cache_store(cache_filenames[i], tempdir_names[i], output_filename, outputs[i]);
+	}, num_jobs);
+
+	for (int i = 0; i < GetSize(commands); i++) {
+		log("Running ABC command: %s\n", replace_tempdir(commands[i], tempdir_names[i], show_tempdir).c_str());
+		abc9_output_filter filt(tempdir_names[i], show_tempdir);
+		for (auto &line : outputs[i])
+			filt.next_line(line);
+		abc9_module_check(commands[i], tempdir_names[i], rets[i]);
 	}
 }
 
@@ -423,7 +518,19 @@ struct Abc9ExePass : public Pass {
 		log("    -cwd <dir>\n");
 		log("        use this as the current working directory, inside which the 'input.xaig'\n");
 		log("        file is expected. temporary files will be created in this directory, and\n");
-		log("        the mapped result will be written to 'output.aig'.\n");
+		log("        the mapped result will be written to 'output.aig'. this option can be\n");
+		log("        given more than once to map several netlists with the same options.\n");
+		log("\n");
+		log("    -j <num>\n");
+		log("        run up to <num> ABC processes concurrently when more than one '-cwd'\n");
+		log("        option is given. their output is logged in the order of the '-cwd'\n");
+		log("        options once all of them have finished. (default: 1)\n");
+		log("\n");
+		log("When the scratchpad variable 'abc9.cache' is set to a directory name, the\n");
+		log("results of ABC are stored in that directory, and are reused when the same\n");
+		log("netlist is mapped again with the same script, options and library files.\n");
+		log("An updated ABC executable is not noticed, so the cache should be cleared\n");
+		log("when ABC changes.\n");
 		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
@@ -439,11 +546,12 @@ struct Abc9ExePass : public Pass {
 	{
 		log_header(design, "Executing ABC9_EXE pass (technology mapping using ABC9).\n");
 
-		std::string exe_file = yosys_abc_executable;
+		std::string exe_file = proc_abc_executable();
 		std::string script_file, clk_str, box_file, lut_file, constr_file;
 		std::vector<std::string> liberty_files, dont_use_cells;
 		std::string delay_target, lutin_shared = "-S 1", wire_delay;
-		std::string tempdir_name;
+		std::vector<std::string> tempdir_names;
+		int num_jobs = 1;
 		bool fast_mode = false, dff_mode = false;
 		bool show_tempdir = false;
 		vector<int> lut_costs;
@@ -526,7 +634,13 @@ struct Abc9ExePass : public Pass {
 				continue;
 			}
 			if (arg == "-cwd" && argidx+1 < args.size()) {
-				tempdir_name = args[++argidx];
+				tempdir_names.push_back(args[++argidx]);
+				continue;
+			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				num_jobs = atoi(args[++argidx].c_str());
+				if (num_jobs < 1)
+					log_cmd_error("Invalid number of jobs: %s\n", args[argidx].c_str());
 				continue;
 			}
 			if (arg == "-liberty" && argidx+1 < args.size()) {
@@ -598,14 +712,20 @@ struct Abc9ExePass : public Pass {
 		if (!box_file.empty() && !is_absolute_path(box_file) && box_file[0] != '+')
 			box_file = std::string(pwd) + "/" + box_file;
 
-		if (tempdir_name.empty())
+		if (tempdir_names.empty())
 			log_cmd_error("abc9_exe '-cwd' option is mandatory.\n");
 
+#ifdef YOSYS_LINK_ABC
+		if (num_jobs > 1) {
+			log("Ignoring -j, since ABC is linked into this build and can only run one netlist at a time.\n");
+			num_jobs = 1;
+		}
+#endif
 
 		abc9_module(design, script_file, exe_file, lut_costs, dff_mode,
 				delay_target, lutin_shared, fast_mode, show_tempdir,
-				box_file, lut_file, liberty_files, wire_delay, tempdir_name,
-				constr_file, dont_use_cells);
+				box_file, lut_file, liberty_files, wire_delay, tempdir_names,
+				constr_file, dont_use_cells, num_jobs);
 	}
 } Abc9ExePass;
 
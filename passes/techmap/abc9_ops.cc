@@ -880,8 +880,63 @@ void prep_xaiger(RTLIL::Module *module, bool dff)
 	}
 }
 
+// Identifies everything prep_lut() and prep_box() read from a module: its
+// attributes (other than the box id assigned by prep_box()), its ports and
+// its specify cells. The generated libraries are reused as long as the keys
+// of all contributing modules are unchanged. Names are hashed as strings,
+// so that the key survives re-deriving or re-reading a box module.
+std::string library_key(RTLIL::Module *module)
+{
+	Hasher h;
+	int num_specify = 0;
+	for (auto &it : module->attributes)
+		if (it.first != ID::abc9_box_id) {
+			h.eat(it.first.str());
+			h.eat(it.second);
+		}
+	for (auto port_name : module->ports) {
+		auto wire = module->wire(port_name);
+		h.eat(port_name.str());
+		h.eat(wire->width);
+		h.eat(wire->port_input);
+		h.eat(wire->port_output);
+		h.eat(wire->get_bool_attribute(ID::abc9_carry));
+	}
+	for (auto cell : module->cells())
+		if (cell->type.in(ID($specify2), ID($specify3), ID($specrule))) {
+			h.eat(cell->type.str());
+			for (auto &param : cell->parameters) {
+				h.eat(param.first.str());
+				h.eat(param.second);
+			}
+			for (auto &conn : cell->connections()) {
+				h.eat(conn.first.str());
+				for (auto &chunk : conn.second.chunks()) {
+					if (chunk.wire == nullptr) {
+						h.eat(RTLIL::Const(chunk.data));
+						continue;
+					}
+					h.eat(chunk.wire->name.str());
+					h.eat(chunk.offset);
+					h.eat(chunk.width);
+				}
+			}
+			num_specify++;
+		}
+	return stringf("%s:%d:%08x;", module->name.c_str(), num_specify, h.yield());
+}
+
 void prep_lut(RTLIL::Design *design, int maxlut)
 {
+	std::string key = stringf("%d;", maxlut);
+	for (auto module : design->modules())
+		if (module->attributes.count(ID::abc9_lut))
+			key += library_key(module);
+	if (design->scratchpad.count("abc9_ops.lut_library") && design->scratchpad_get_string("abc9_ops.lut_library_key") == key) {
+		log("Reusing the LUT library of the previous call.\n");
+		return;
+	}
+
 	TimingInfo timing;
 
 	struct t_lut {
@@ -948,6 +1003,7 @@ void prep_lut(RTLIL::Design *design, int maxlut)
 		ss << std::endl;
 	}
 	design->scratchpad_set_string("abc9_ops.lut_library", ss.str());
+	design->scratchpad_set_string("abc9_ops.lut_library_key", key);
 }
 
 void write_lut(RTLIL::Module *module, const std::string &dst) {
@@ -959,6 +1015,24 @@ void write_lut(RTLIL::Module *module, const std::string &dst) {
 
 void prep_box(RTLIL::Design *design)
 {
+	std::string key;
+	std::vector<RTLIL::Module*> box_modules;
+	for (auto module : design->modules()) {
+		auto it = module->attributes.find(ID::abc9_box);
+		if (it != module->attributes.end() && it->second.as_bool()) {
+			key += library_key(module);
+			box_modules.push_back(module);
+		}
+	}
+	if (design->scratchpad.count("abc9_ops.box_library") && design->scratchpad_get_string("abc9_ops.box_library_key") == key) {
+		// the ids are assigned in the same order as below
+		int abc9_box_id = 1;
+		for (auto module : box_modules)
+			module->attributes[ID::abc9_box_id] = abc9_box_id++;
+		log("Reusing the box library of the previous call.\n");
+		return;
+	}
+
 	TimingInfo timing;
 
 	int abc9_box_id = 1;
@@ -1127,6 +1201,7 @@ void prep_box(RTLIL::Design *design)
 		ss << "(dummy) 1 0 0 0";
 
 	design->scratchpad_set_string("abc9_ops.box_library", ss.str());
+	design->scratchpad_set_string("abc9_ops.box_library_key", key);
 }
 
 void write_box(RTLIL::Module *module, const std::string &dst) {
@@ -1147,9 +1222,13 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 	if (mapped_mod == NULL)
 		log_error("ABC output file does not contain a module `%s$abc'.\n", log_id(module));
 
+	// wires (and below, cells) of the mapped module are referred to through
+	// these maps instead of looking up their remapped names
+	dict<RTLIL::Wire*, RTLIL::Wire*> wire_map;
 	for (auto w : mapped_mod->wires()) {
 		auto nw = module->addWire(remap_name(w->name), GetSize(w));
 		nw->start_offset = w->start_offset;
+		wire_map[w] = nw;
 		// Remove all (* init *) since they only exist on $_DFF_[NP]_
 		w->attributes.erase(ID::init);
 	}
@@ -1224,8 +1303,18 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 			boxes.emplace_back(cell);
 	}
 
-	dict<SigBit, pool<IdString>> bit_drivers, bit_users;
-	TopoSort<IdString, RTLIL::sort_by_id_str> toposort;
+	// cells are numbered in name order, so that the topological order below
+	// (and thus the order in which $_NOT_ cells are handled) is the same as
+	// that of a TopoSort by name
+	std::vector<RTLIL::Cell*> mapped_cells = mapped_mod->cells().to_vector();
+	std::sort(mapped_cells.begin(), mapped_cells.end(), [](RTLIL::Cell *a, RTLIL::Cell *b) {
+		return RTLIL::sort_by_id_str()(a->name, b->name);
+	});
+	dict<RTLIL::Cell*, int> mapped_index;
+	for (int i = 0; i < GetSize(mapped_cells); i++)
+		mapped_index[mapped_cells[i]] = i;
+
+	dict<SigBit, std::vector<int>> bit_drivers, bit_users;
 	dict<RTLIL::Cell*,RTLIL::Cell*> not2drivers;
 	dict<SigBit, std::vector<RTLIL::Cell*>> bit2sinks;
 
@@ -1238,27 +1327,25 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 			SigBit D = mapped_cell->getPort(ID::D);
 			SigBit Q = mapped_cell->getPort(ID::Q);
 			if (D.wire)
-				D.wire = module->wires_.at(remap_name(D.wire->name));
-			Q.wire = module->wires_.at(remap_name(Q.wire->name));
+				D.wire = wire_map.at(D.wire);
+			Q.wire = wire_map.at(Q.wire);
 			module->connect(Q, D);
 			continue;
 		}
 
-		// TODO: Speed up toposort -- we care about NOT ordering only
-		toposort.node(mapped_cell->name);
+		int mapped_id = mapped_index.at(mapped_cell);
 
 		if (mapped_cell->type == ID($_NOT_)) {
 			RTLIL::SigBit a_bit = mapped_cell->getPort(ID::A);
 			RTLIL::SigBit y_bit = mapped_cell->getPort(ID::Y);
-			bit_users[a_bit].insert(mapped_cell->name);
+			bit_users[a_bit].push_back(mapped_id);
 			// Ignore inouts for topo ordering
 			if (y_bit.wire && !(y_bit.wire->port_input && y_bit.wire->port_output))
-				bit_drivers[y_bit].insert(mapped_cell->name);
+				bit_drivers[y_bit].push_back(mapped_id);
 
 			if (!a_bit.wire) {
 				mapped_cell->setPort(ID::Y, module->addWire(NEW_ID));
-				RTLIL::Wire *wire = module->wire(remap_name(y_bit.wire->name));
-				log_assert(wire);
+				RTLIL::Wire *wire = wire_map.at(y_bit.wire);
 				module->connect(RTLIL::SigBit(wire, y_bit.offset), State::S1);
 			}
 			else {
@@ -1281,8 +1368,8 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 					// If a driver couldn't be found (could be from PI or box CI)
 					// then implement using a LUT
 					RTLIL::Cell *cell = module->addLut(remap_name(stringf("$lut%s", mapped_cell->name.c_str())),
-							RTLIL::SigBit(module->wires_.at(remap_name(a_bit.wire->name)), a_bit.offset),
-							RTLIL::SigBit(module->wires_.at(remap_name(y_bit.wire->name)), y_bit.offset),
+							RTLIL::SigBit(wire_map.at(a_bit.wire), a_bit.offset),
+							RTLIL::SigBit(wire_map.at(y_bit.wire), y_bit.offset),
 							RTLIL::Const::from_string("01"));
 					bit2sinks[cell->getPort(ID::A)].push_back(cell);
 					cell_stats[ID($lut)]++;
@@ -1305,7 +1392,7 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 						continue;
 					//log_assert(c.width == 1);
 					if (c.wire)
-						c.wire = module->wires_.at(remap_name(c.wire->name));
+						c.wire = wire_map.at(c.wire);
 					newsig.append(c);
 				}
 				cell->setPort(mapped_conn.first, newsig);
@@ -1314,13 +1401,13 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 					for (auto i : newsig)
 						bit2sinks[i].push_back(cell);
 					for (auto i : mapped_conn.second)
-						bit_users[i].insert(mapped_cell->name);
+						bit_users[i].push_back(mapped_id);
 				}
 				if (cell->output(mapped_conn.first))
 					for (auto i : mapped_conn.second)
 						// Ignore inouts for topo ordering
 						if (i.wire && !(i.wire->port_input && i.wire->port_output))
-							bit_drivers[i].insert(mapped_cell->name);
+							bit_drivers[i].push_back(mapped_id);
 			}
 		}
 		else {
@@ -1332,9 +1419,9 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 				SigBit I = mapped_cell->getPort(ID(i));
 				SigBit O = mapped_cell->getPort(ID(o));
 				if (I.wire)
-					I.wire = module->wires_.at(remap_name(I.wire->name));
+					I.wire = wire_map.at(I.wire);
 				log_assert(O.wire);
-				O.wire = module->wires_.at(remap_name(O.wire->name));
+				O.wire = wire_map.at(O.wire);
 				module->connect(O, I);
 				continue;
 			}
@@ -1374,16 +1461,16 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 					old_q = existing_cell->getPort(port_name);
 				}
 				auto new_q = outputs[0];
-				new_q.wire = module->wires_.at(remap_name(new_q.wire->name));
+				new_q.wire = wire_map.at(new_q.wire);
 				module->connect(old_q,  new_q);
 			}
 			else {
 				for (const auto &i : inputs)
-					bit_users[i].insert(mapped_cell->name);
+					bit_users[i].push_back(mapped_id);
 				for (const auto &i : outputs)
 					// Ignore inouts for topo ordering
 					if (i.wire && !(i.wire->port_input && i.wire->port_output))
-						bit_drivers[i].insert(mapped_cell->name);
+						bit_drivers[i].push_back(mapped_id);
 			}
 
 			int input_count = 0, output_count = 0;
@@ -1407,7 +1494,7 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 						continue;
 					//log_assert(c.width == 1);
 					if (c.wire)
-						c.wire = module->wires_.at(remap_name(c.wire->name));
+						c.wire = wire_map.at(c.wire);
 					newsig.append(c);
 				}
 
@@ -1430,14 +1517,14 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 		if (!conn.first.is_fully_const()) {
 			auto chunks = conn.first.chunks();
 			for (auto &c : chunks)
-				c.wire = module->wires_.at(remap_name(c.wire->name));
+				c.wire = wire_map.at(c.wire);
 			conn.first = std::move(chunks);
 		}
 		if (!conn.second.is_fully_const()) {
 			auto chunks = conn.second.chunks();
 			for (auto &c : chunks)
 				if (c.wire)
-					c.wire = module->wires_.at(remap_name(c.wire->name));
+					c.wire = wire_map.at(c.wire);
 			conn.second = std::move(chunks);
 		}
 		module->connect(conn);
@@ -1453,7 +1540,7 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 		RTLIL::Wire *wire = module->wire(port);
 		log_assert(wire);
 
-		RTLIL::Wire *remap_wire = module->wire(remap_name(port));
+		RTLIL::Wire *remap_wire = wire_map.at(mapped_wire);
 		RTLIL::SigSpec signal(wire, remap_wire->start_offset-wire->start_offset, GetSize(remap_wire));
 		log_assert(GetSize(signal) >= GetSize(remap_wire));
 
@@ -1483,17 +1570,50 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 	//   outputs, only one of which is complemented) and when the driver
 	//   is a LUT, then clone the LUT so that it can be inverted without
 	//   increasing depth/delay.
-	for (auto &it : bit_users)
-		if (bit_drivers.count(it.first))
-			for (auto driver_cell : bit_drivers.at(it.first))
+	std::vector<std::vector<int>> cell_drivers(GetSize(mapped_cells));
+	for (auto &it : bit_users) {
+		auto jt = bit_drivers.find(it.first);
+		if (jt != bit_drivers.end())
+			for (auto driver_cell : jt->second)
 			for (auto user_cell : it.second)
-				toposort.edge(driver_cell, user_cell);
-	bool no_loops = toposort.sort();
-	log_assert(no_loops);
+				cell_drivers[user_cell].push_back(driver_cell);
+	}
+
+	// depth-first post-order with the drivers visited in index order, which
+	// is the order TopoSort produces
+	std::vector<int> sorted;
+	std::vector<char> visited(GetSize(mapped_cells));
+	std::vector<std::pair<int, int>> stack;
+	for (auto &drivers : cell_drivers) {
+		std::sort(drivers.begin(), drivers.end());
+		drivers.erase(std::unique(drivers.begin(), drivers.end()), drivers.end());
+	}
+	for (int root = 0; root < GetSize(mapped_cells); root++) {
+		if (visited[root])
+			continue;
+		visited[root] = 1;
+		stack.push_back({root, 0});
+		while (!stack.empty()) {
+			int cell = stack.back().first;
+			int next = stack.back().second++;
+			if (next < GetSize(cell_drivers[cell])) {
+				int driver = cell_drivers[cell][next];
+				// no loops
+				log_assert(visited[driver] != 1);
+				if (!visited[driver]) {
+					visited[driver] = 1;
+					stack.push_back({driver, 0});
+				}
+			} else {
+				visited[cell] = 2;
+				sorted.push_back(cell);
+				stack.pop_back();
+			}
+		}
+	}
 
-	for (auto ii = toposort.sorted.rbegin(); ii != toposort.sorted.rend(); ii++) {
-		RTLIL::Cell *not_cell = mapped_mod->cell(*ii);
-		log_assert(not_cell);
+	for (auto ii = sorted.rbegin(); ii != sorted.rend(); ii++) {
+		RTLIL::Cell *not_cell = mapped_cells[*ii];
 		if (not_cell->type != ID($_NOT_))
 			continue;
 		auto it = not2drivers.find(not_cell);
@@ -1504,8 +1624,8 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 		RTLIL::SigBit y_bit = not_cell->getPort(ID::Y);
 		RTLIL::Const driver_mask;
 
-		a_bit.wire = module->wires_.at(remap_name(a_bit.wire->name));
-		y_bit.wire = module->wires_.at(remap_name(y_bit.wire->name));
+		a_bit.wire = wire_map.at(a_bit.wire);
+		y_bit.wire = wire_map.at(y_bit.wire);
 
 		auto jt = bit2sinks.find(a_bit);
 		if (jt == bit2sinks.end())
@@ -1551,7 +1671,7 @@ clone_lut:
 				y_bit,
 				driver_mask);
 		for (auto &bit : cell->connections_.at(ID::A)) {
-			bit.wire = module->wires_.at(remap_name(bit.wire->name));
+			bit.wire = wire_map.at(bit.wire);
 			bit2sinks[bit].push_back(cell);
 		}
 	}
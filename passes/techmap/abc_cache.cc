@@ -0,0 +1,143 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "passes/techmap/abc_cache.h"
+#include "kernel/contenthash.h"
+#include <fstream>
+#include <sstream>
+
+YOSYS_NAMESPACE_BEGIN
+
+// An entry holds the length of the output of ABC, that output, and then the mapped netlist.
+static const char abc_cache_magic[] = "yosys-abc-cache 1\n";
+
+// Replaces every occurrence of `from` in `text` with `to`; cache entries store the output of ABC with the temp dir
+// name replaced by a placeholder.
+static std::string abc_cache_subst(std::string text, const std::string &from, const std::string &to)
+{
+	for (size_t pos = 0; (pos = text.find(from, pos)) != std::string::npos; pos += to.size())
+		text.replace(pos, from.size(), to);
+	return text;
+}
+
+std::string abc_cache_filename(const std::string &cache_dir, const std::string &prefix, const std::string &tempdir_name,
+		const std::vector<std::string> &temp_files, const std::vector<std::string> &other_files,
+		const std::vector<std::string> &content_files)
+{
+	auto read_file = [](const std::string &filename, std::string &text) {
+		std::ifstream f(filename, std::ifstream::binary);
+		if (f.fail())
+			return false;
+		std::stringstream buffer;
+		buffer << f.rdbuf();
+		text = buffer.str();
+		return true;
+	};
+
+	ContentHash hasher;
+	hasher.update(abc_cache_magic);
+	hasher.update(prefix + "\n");
+	for (auto &name : temp_files) {
+		std::string text;
+		if (!read_file(stringf("%s/%s", tempdir_name.c_str(), name.c_str()), text))
+			continue;
+		for (int i = 0; i < GetSize(content_files); i++)
+			text = abc_cache_subst(text, content_files[i], stringf("<abc-cache-file-%d>", i));
+		text = abc_cache_subst(text, tempdir_name, "<abc-temp-dir>");
+		hasher.update(stringf("%s\n%zu\n", name.c_str(), text.size()));
+		hasher.update(text);
+	}
+	for (auto &name : content_files) {
+		std::string text;
+		if (!read_file(name, text))
+			return std::string();
+		hasher.update(stringf("%zu\n", text.size()));
+		hasher.update(text);
+	}
+	for (auto &name : other_files) {
+		std::string file_key = file_content_key(name);
+		if (file_key.empty())
+			return std::string();
+		hasher.update(file_key);
+	}
+	return cache_dir + "/" + hasher.hexdigest() + ".abccache";
+}
+
+bool abc_cache_load(const std::string &cache_filename, const std::string &tempdir_name, const std::string &output_filename,
+		const std::function<void(const std::string&)> &process_line)
+{
+	std::ifstream f(cache_filename, std::ifstream::binary);
+	if (f.fail())
+		return false;
+	std::stringstream buffer;
+	buffer << f.rdbuf();
+	std::string data = buffer.str();
+
+	size_t pos = sizeof(abc_cache_magic) - 1;
+	size_t end = data.find('\n', pos);
+	if (data.compare(0, pos, abc_cache_magic) != 0 || end == std::string::npos)
+		return false;
+	size_t output_size = strtoull(data.c_str() + pos, nullptr, 10);
+	if (output_size > data.size() - end - 1) {
+		log_warning("Ignoring corrupt ABC cache entry %s.\n", cache_filename.c_str());
+		return false;
+	}
+
+	std::ofstream out(output_filename, std::ofstream::binary);
+	out.write(data.data() + end + 1 + output_size, data.size() - end - 1 - output_size);
+	out.close();
+	if (out.fail())
+		return false;
+
+	log("Using cached ABC result %s.\n", cache_filename.c_str());
+	std::string output = abc_cache_subst(data.substr(end + 1, output_size), "<abc-temp-dir>", tempdir_name);
+	for (size_t line_start = 0; line_start < output.size(); ) {
+		size_t line_end = output.find('\n', line_start);
+		line_end = line_end == std::string::npos ? output.size() : line_end + 1;
+		process_line(output.substr(line_start, line_end - line_start));
+		line_start = line_end;
+	}
+	return true;
+}
+
+void abc_cache_store(const std::string &cache_filename, const std::string &tempdir_name, const std::string &output_filename,
+		const std::vector<std::string> &output)
+{
+	std::ifstream in(output_filename, std::ifstream::binary);
+	if (in.fail())
+		return;
+
+	std::string cache_dir = cache_filename.substr(0, cache_filename.rfind('/'));
+	if (!create_directory(cache_dir)) {
+		log_warning("Failed to create ABC cache directory %s.\n", cache_dir.c_str());
+		return;
+	}
+
+	std::string text;
+	for (auto &line : output)
+		text += abc_cache_subst(line, tempdir_name, "<abc-temp-dir>");
+
+	bool ok = write_file_atomically(cache_filename, [&](std::ostream &f) {
+		f << abc_cache_magic << text.size() << "\n" << text << in.rdbuf();
+	});
+	if (!ok)
+		log_warning("Failed to write ABC cache entry %s.\n", cache_filename.c_str());
+}
+
+YOSYS_NAMESPACE_END
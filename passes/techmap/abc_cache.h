@@ -0,0 +1,52 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef ABC_CACHE_H
+#define ABC_CACHE_H
+
+#include "kernel/yosys.h"
+#include <functional>
+
+YOSYS_NAMESPACE_BEGIN
+
+// The on-disk cache of ABC results used by the `abc` and `abc9_exe` passes. An entry holds the output of ABC and
+// the netlist it wrote, and is keyed by the contents of the files that ABC reads from the temp dir (with the temp
+// dir name removed), and by the name and contents of the other files it reads (see file_content_key()), e.g.
+// libraries.
+
+// Returns the name of the cache entry in `cache_dir` for the `temp_files` in `tempdir_name`, or an empty string if
+// one of the other files does not exist. `prefix` is any other text that affects the result of ABC. The files in
+// `content_files` are keyed by their contents rather than by their names, e.g. because they are in a different
+// temp dir that is referred to by the temp files.
+std::string abc_cache_filename(const std::string &cache_dir, const std::string &prefix, const std::string &tempdir_name,
+		const std::vector<std::string> &temp_files, const std::vector<std::string> &other_files,
+		const std::vector<std::string> &content_files = {});
+
+// Writes the netlist of a cache entry to `output_filename`, and passes the output of ABC to `process_line`.
+// Returns false if there is no valid entry.
+bool abc_cache_load(const std::string &cache_filename, const std::string &tempdir_name, const std::string &output_filename,
+		const std::function<void(const std::string&)> &process_line);
+
+// Stores the netlist in `output_filename`, and the `output` of ABC, as a cache entry.
+void abc_cache_store(const std::string &cache_filename, const std::string &tempdir_name, const std::string &output_filename,
+		const std::vector<std::string> &output);
+
+YOSYS_NAMESPACE_END
+
+#endif
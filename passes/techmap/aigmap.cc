@@ -72,18 +72,19 @@ struct AigmapPass : public Pass {
 			dict<IdString, int> stat_not_replaced;
 			int orig_num_cells = GetSize(module->cells());
 
+			// structural hashing of the new gates, across all replaced cells
+			dict<pair<SigBit, SigBit>, SigBit> and_cache, nand_cache;
+			dict<SigBit, SigBit> not_cache;
+
 			pool<IdString> new_sel;
 			for (auto cell : module->selected_cells())
 			{
-				Aig aig(cell);
-
-				if (cell->type.in(ID($_AND_), ID($_NOT_)))
-					aig.name.clear();
+				const Aig &aig = Aig::cached(cell);
 
-				if (nand_mode && cell->type == ID($_NAND_))
-					aig.name.clear();
+				bool skip = aig.name.empty() || cell->type.in(ID($_AND_), ID($_NOT_)) ||
+						(nand_mode && cell->type == ID($_NAND_));
 
-				if (aig.name.empty()) {
+				if (skip) {
 					not_replaced_count++;
 					stat_not_replaced[cell->type]++;
 					if (select_mode)
@@ -92,12 +93,10 @@ struct AigmapPass : public Pass {
 				}
 
 				vector<SigBit> sigs;
-				dict<pair<int, int>, SigBit> and_cache;
 
-				for (int node_idx = 0; node_idx < GetSize(aig.nodes); node_idx++)
+				for (auto &node : aig.nodes)
 				{
 					SigBit bit;
-					auto &node = aig.nodes[node_idx];
 
 					if (node.portbit >= 0) {
 						bit = cell->getPort(node.portname)[node.portbit];
@@ -107,33 +106,45 @@ struct AigmapPass : public Pass {
 					} else {
 						SigBit A = sigs.at(node.left_parent);
 						SigBit B = sigs.at(node.right_parent);
+						pair<SigBit, SigBit> key = A < B ? make_pair(A, B) : make_pair(B, A);
 						if (nand_mode && node.inverter) {
-							bit = module->addWire(NEW_ID);
-							auto gate = module->addNandGate(NEW_ID, A, B, bit);
-							if (select_mode)
-								new_sel.insert(gate->name);
-
+							auto it = nand_cache.find(key);
+							if (it != nand_cache.end()) {
+								bit = it->second;
+							} else {
+								bit = module->addWire(NEW_ID);
+								auto gate = module->addNandGate(NEW_ID, A, B, bit);
+								if (select_mode)
+									new_sel.insert(gate->name);
+								nand_cache[key] = bit;
+							}
 							goto skip_inverter;
 						} else {
-							pair<int, int> key(node.left_parent, node.right_parent);
-							if (and_cache.count(key))
-								bit = and_cache.at(key);
-							else {
+							auto it = and_cache.find(key);
+							if (it != and_cache.end()) {
+								bit = it->second;
+							} else {
 								bit = module->addWire(NEW_ID);
 								auto gate = module->addAndGate(NEW_ID, A, B, bit);
 								if (select_mode)
 									new_sel.insert(gate->name);
+								and_cache[key] = bit;
 							}
 						}
 					}
 
 					if (node.inverter) {
-						SigBit new_bit = module->addWire(NEW_ID);
-						auto gate = module->addNotGate(NEW_ID, bit, new_bit);
-						bit = new_bit;
-						if (select_mode)
-							new_sel.insert(gate->name);
-
+						auto it = not_cache.find(bit);
+						if (it != not_cache.end()) {
+							bit = it->second;
+						} else {
+							SigBit new_bit = module->addWire(NEW_ID);
+							auto gate = module->addNotGate(NEW_ID, bit, new_bit);
+							if (select_mode)
+								new_sel.insert(gate->name);
+							not_cache[bit] = new_bit;
+							bit = new_bit;
+						}
 					}
 
 				skip_inverter:
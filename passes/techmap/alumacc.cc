@@ -34,6 +34,8 @@ struct AlumaccWorker
 		RTLIL::Cell *cell;
 		RTLIL::SigSpec y;
 		int users;
+		// per port: the node driving it, and the node merged in its place
+		std::vector<maccnode_t*> drivers, merged;
 	};
 
 	struct alunode_t
@@ -222,57 +224,108 @@ struct AlumaccWorker
 		return acc_shift > width;
 	}
 
-	void merge_macc()
+	// The ports of a node with the ports of the nodes merged into it
+	// inserted in their place, with do_subtract flipped for the ports of
+	// subtracted nodes.
+	static std::vector<Macc::port_t> merged_ports(maccnode_t *n)
 	{
-		while (1)
-		{
-			pool<maccnode_t*> delete_nodes;
+		std::vector<Macc::port_t> ports;
+		// (node, next port, subtract) of the nodes that are being flattened,
+		// without recursion for long chains of merged nodes
+		std::vector<std::tuple<maccnode_t*, int, bool>> stack = {{n, 0, false}};
+		while (!stack.empty()) {
+			auto &top = stack.back();
+			maccnode_t *node = std::get<0>(top);
+			int i = std::get<1>(top)++;
+			bool subtract = std::get<2>(top);
+			if (i == GetSize(node->macc.ports)) {
+				stack.pop_back();
+				continue;
+			}
+			auto &port = node->macc.ports[i];
+			if (node->merged[i] != nullptr) {
+				stack.emplace_back(node->merged[i], 0, subtract != port.do_subtract);
+				continue;
+			}
+			ports.push_back(port);
+			ports.back().do_subtract = subtract != port.do_subtract;
+		}
+		return ports;
+	}
 
-			for (auto &it : sig_macc)
-			{
-				auto n = it.second;
+	void merge_macc()
+	{
+		// the node driving each port, if any, for merging nodes into the
+		// nodes that use them
+		for (auto &it : sig_macc) {
+			auto n = it.second;
+			n->merged.assign(GetSize(n->macc.ports), nullptr);
+			n->drivers.clear();
+			for (auto &port : n->macc.ports) {
+				auto other_it = GetSize(port.in_b) > 0 ? sig_macc.end() : sig_macc.find(port.in_a);
+				n->drivers.push_back(other_it == sig_macc.end() ? nullptr : other_it->second);
+			}
+		}
 
-				if (delete_nodes.count(n))
+		// visit the drivers of each node before the node, so that a node is
+		// complete by the time it is merged into its user, in a single pass;
+		// edges that close a loop are never merged
+		std::vector<maccnode_t*> order;
+		dict<maccnode_t*, int> state; // 1: on the stack, 2: done
+		for (auto &it : sig_macc) {
+			if (state.count(it.second))
+				continue;
+			std::vector<std::pair<maccnode_t*, int>> stack = {{it.second, 0}};
+			state[it.second] = 1;
+			while (!stack.empty()) {
+				auto n = stack.back().first;
+				int i = stack.back().second++;
+				if (i == GetSize(n->drivers)) {
+					state[n] = 2;
+					order.push_back(n);
+					stack.pop_back();
 					continue;
+				}
+				auto other_n = n->drivers[i];
+				if (other_n == nullptr)
+					continue;
+				if (!state.count(other_n)) {
+					state[other_n] = 1;
+					stack.emplace_back(other_n, 0);
+				} else if (state.at(other_n) == 1)
+					n->drivers[i] = nullptr;
+			}
+		}
 
-				for (int i = 0; i < GetSize(n->macc.ports); i++)
-				{
-					auto &port = n->macc.ports[i];
-
-					if (GetSize(port.in_b) > 0 || sig_macc.count(port.in_a) == 0)
-						continue;
-
-					auto other_n = sig_macc.at(port.in_a);
+		pool<maccnode_t*> delete_nodes;
+		for (auto n : order)
+			for (int i = 0; i < GetSize(n->macc.ports); i++)
+			{
+				auto &port = n->macc.ports[i];
+				auto other_n = n->drivers[i];
 
-					if (other_n->users > 1)
-						continue;
+				if (other_n == nullptr || other_n->users > 1 || delete_nodes.count(other_n))
+					continue;
 
-					if (GetSize(other_n->y) != GetSize(n->y) && macc_may_overflow(other_n->macc, GetSize(other_n->y), port.is_signed))
+				if (GetSize(other_n->y) != GetSize(n->y)) {
+					Macc other_macc;
+					other_macc.ports = merged_ports(other_n);
+					if (macc_may_overflow(other_macc, GetSize(other_n->y), port.is_signed))
 						continue;
-
-					log("  merging $macc model for %s into %s.\n", log_id(other_n->cell), log_id(n->cell));
-
-					bool do_subtract = port.do_subtract;
-					for (int j = 0; j < GetSize(other_n->macc.ports); j++) {
-						if (do_subtract)
-							other_n->macc.ports[j].do_subtract = !other_n->macc.ports[j].do_subtract;
-						if (j == 0)
-							n->macc.ports[i--] = other_n->macc.ports[j];
-						else
-							n->macc.ports.push_back(other_n->macc.ports[j]);
-					}
-
-					delete_nodes.insert(other_n);
 				}
+
+				log("  merging $macc model for %s into %s.\n", log_id(other_n->cell), log_id(n->cell));
+				n->merged[i] = other_n;
+				delete_nodes.insert(other_n);
 			}
 
-			if (delete_nodes.empty())
-				break;
+		for (auto &it : sig_macc)
+			if (!delete_nodes.count(it.second))
+				it.second->macc.ports = merged_ports(it.second);
 
-			for (auto n : delete_nodes) {
-				sig_macc.erase(n->y);
-				delete n;
-			}
+		for (auto n : delete_nodes) {
+			sig_macc.erase(n->y);
+			delete n;
 		}
 	}
 
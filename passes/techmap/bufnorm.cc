@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
+#include <atomic>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -236,21 +237,25 @@ struct BufnormPass : public Pass {
 
 		log_header(design, "Executing BUFNORM pass (convert to buffer-normalized form).\n");
 
-		int count_removed_buffers = 0;
-		int count_updated_buffers = 0;
-		int count_kept_buffers = 0;
-		int count_created_buffers = 0;
-		int count_updated_cellports = 0;
+		// shared by the module workers
+		std::atomic<int> count_removed_buffers{0};
+		std::atomic<int> count_updated_buffers{0};
+		std::atomic<int> count_kept_buffers{0};
+		std::atomic<int> count_created_buffers{0};
+		std::atomic<int> count_updated_cellports{0};
 
 		if (!nomode_mode && (pos_mode || bits_mode || conn_mode)) {
 			if (design->selection().full_selection)
 				design->bufNormalize(false);
 		}
 
-		for (auto module : design->selected_modules())
+		parallel_modules(design, design->selected_modules(), [&](RTLIL::Module *module)
 		{
 			log("Buffer-normalizing module %s.\n", log_id(module));
 
+			// most cells are touched, notify monitors only once
+			RTLIL::Module::BatchScope batch(module);
+
 			SigMap sigmap(module);
 			module->new_connections({});
 
@@ -508,11 +513,11 @@ struct BufnormPass : public Pass {
 					}
 				}
 			}
-		}
+		});
 
 		log("Summary: removed %d, updated %d, kept %d, and created %d buffers, and updated %d cell ports.\n",
-				count_removed_buffers, count_updated_buffers, count_kept_buffers,
-				count_created_buffers, count_updated_cellports);
+				count_removed_buffers.load(), count_updated_buffers.load(), count_kept_buffers.load(),
+				count_created_buffers.load(), count_updated_cellports.load());
 
 		if (!nomode_mode && !(pos_mode || bits_mode || conn_mode)) {
 			if (design->selection().full_selection)
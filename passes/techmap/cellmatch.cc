@@ -4,6 +4,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/consteval.h"
 #include "kernel/utils.h"
+#include "kernel/cutenum.h"
 
 #include <algorithm>
 
@@ -42,51 +43,6 @@ SigSpec module_outputs(Module *m)
 	return ret;
 }
 
-// Permute the inputs of a single-output k-LUT according to varmap
-uint64_t permute_lut(uint64_t lut, const std::vector<int> &varmap)
-{
-	int k = varmap.size();
-	uint64_t ret = 0;
-	// Index j iterates over all bits in lut.
-	// When (j & 1 << n) is true,
-	//  (lut & 1 << j) represents an output value where input var n is set.
-	// We use this fact to permute the LUT such that
-	// every variable n is remapped to varmap[n].
-	for (int j = 0; j < 1 << k; j++) {
-		int m = 0;
-		for (int l = 0; l < k; l++)
-		if (j & 1 << l)
-			m |= 1 << varmap[l];
-		if (lut & 1 << m)
-			ret |= 1 << j;
-	}
-	return ret;
-}
-
-// Find the LUT with the minimum integer representation
-// such that it is a permutation of the given lut.
-// The resulting LUT becomes the "fingerprint" of the "permutation class".
-// This function checks all possible input permutations.
-uint64_t p_class(int k, uint64_t lut)
-{
-	std::vector<int> map;
-	for (int j = 0; j < k; j++)
-		map.push_back(j);
-
-	uint64_t repr = ~(uint64_t) 0;
-	std::vector<int> repr_vars;
-	while (true) {
-		uint64_t perm = permute_lut(lut, map);
-		if (perm <= repr) {
-			repr = perm;
-			repr_vars = map;
-		}
-		if (!std::next_permutation(map.begin(), map.end()))
-			break;
-	}
-	return repr;
-}
-
 // Represent module m as N single-output k-LUTs
 // where k is the number of module inputs,
 //   and N is the number of module outputs.
@@ -130,7 +86,7 @@ bool derive_module_luts(Module *m, std::vector<uint64_t> &luts)
 			log_assert(ceval.eval(bit));
 
 			if (bit[0] == State::S1)
-				luts[j] |= 1 << i;
+				luts[j] |= uint64_t(1) << i;
 		}
 	}
 
@@ -201,7 +157,7 @@ struct CellmatchPass : Pass {
 			if (!derive_module_luts(m, luts))
 				continue;
 			for (auto lut : luts)
-				p_classes.insert(p_class(ninputs, lut));
+				p_classes.insert(tt_p_canonical(lut, ninputs));
 
 			log_debug("Registered %s\n", log_id(m));
 
@@ -226,7 +182,7 @@ struct CellmatchPass : Pass {
 				int no = 0;
 				for (auto bit : outputs) {
 					log_assert(bit.is_wire());
-					bit.wire->attributes[ID(p_class)] = p_class(inputs.size(), luts[no]);
+					bit.wire->attributes[ID(p_class)] = tt_p_canonical(luts[no], inputs.size());
 					bit.wire->attributes[ID(lut)] = Const(luts[no++], 1 << inputs.size());
 				}
 			}
@@ -234,7 +190,7 @@ struct CellmatchPass : Pass {
 			// fingerprint
 			pool<uint64_t> p_classes;
 			for (auto lut : luts)
-				p_classes.insert(p_class(inputs.size(), lut));
+				p_classes.insert(tt_p_canonical(lut, inputs.size()));
 
 			for (auto target : targets[p_classes]) {
 				log_debug("Candidate %s for matching to %s\n", log_id(target.module), log_id(m));
@@ -264,7 +220,7 @@ struct CellmatchPass : Pass {
 						int out_no = 0;
 						bool match = true;
 						for (auto lut : luts) {
-							if (permute_lut(target.luts[output_map[out_no++]], input_map) != lut) {
+							if (tt_permute(target.luts[output_map[out_no++]], inputs.size(), input_map) != lut) {
 								match = false;
 								break;
 							}
@@ -307,14 +307,11 @@ struct ClockgatePass : public Pass {
 
 		if (!liberty_files.empty()) {
 			LibertyMergedCells merged;
+			LibertyFilter filter;
+			filter.skip_groups = LibertyFilter::timing_groups();
 			for (auto path : liberty_files) {
-				std::ifstream f;
-				f.open(path.c_str());
-				if (f.fail())
-					log_cmd_error("Can't open liberty file `%s': %s\n", path.c_str(), strerror(errno));
-				LibertyParser p(f);
+				LibertyParser p(path, design->scratchpad_get_string("liberty.cache"), &filter);
 				merged.merge(p);
-				f.close();
 			}
 			std::tie(pos_icg_desc, neg_icg_desc) =
 				find_icgs(merged.cells, dont_use_cells);
@@ -182,6 +182,16 @@ struct DffLegalizePass : public Pass {
 	SigMap sigmap;
 	FfInitVals initvals;
 
+	// What legalize_ff does with the FFs of one signature (cell type and
+	// init value): FFs that would be emitted unchanged are kept as they are,
+	// instead of being taken apart and emitted again.  Valid for one call.
+	struct FfPlan {
+		bool keep;
+		bool has_ce;
+		bool has_srst;
+	};
+	dict<std::pair<IdString, State>, FfPlan> plans;
+
 	int flip_initmask(int mask) {
 		int res = mask & INIT_X;
 		if (mask & INIT_0)
@@ -240,6 +250,37 @@ struct DffLegalizePass : public Pass {
 		}
 	}
 
+	int get_ff_neg(const FfData &ff) {
+		int res = 0;
+		if (ff.has_sr) {
+			if (!ff.pol_clr)
+				res |= NEG_R;
+			if (!ff.pol_set)
+				res |= NEG_S;
+		}
+		if (ff.has_arst) {
+			if (!ff.pol_arst)
+				res |= NEG_R;
+		}
+		if (ff.has_srst) {
+			if (!ff.pol_srst)
+				res |= NEG_R;
+		}
+		if (ff.has_aload) {
+			if (!ff.pol_aload)
+				res |= NEG_L;
+		}
+		if (ff.has_clk) {
+			if (!ff.pol_clk)
+				res |= NEG_C;
+		}
+		if (ff.has_ce) {
+			if (!ff.pol_ce)
+				res |= NEG_CE;
+		}
+		return res;
+	}
+
 	int get_initmask(FfData &ff) {
 		int res = 0;
 		if (ff.val_init[0] == State::S0)
@@ -885,6 +926,34 @@ struct DffLegalizePass : public Pass {
 		}
 	}
 
+	FfPlan make_plan(Cell *cell) {
+		FfData ff(&initvals, cell);
+		FfPlan plan = {true, false, false};
+		if (ff.has_gclk || !ff.is_fine)
+			return plan;
+		plan.has_ce = ff.has_ce;
+		plan.has_srst = ff.has_srst;
+		// All the legalize_* functions go straight to legalize_finish when
+		// the cell is supported as it is, and it then only has to fix up
+		// undefined reset values.
+		int initmask = get_initmask(ff);
+		plan.keep = (supported_cells_neg[get_ff_type(ff)][get_ff_neg(ff)] & initmask) &&
+				!(ff.has_arst && !ff.val_arst.is_fully_def()) &&
+				!(ff.has_srst && !ff.val_srst.is_fully_def());
+		return plan;
+	}
+
+	const FfPlan &get_plan(Cell *cell) {
+		// Fine FFs are one bit wide, and coarse FFs are always kept.
+		const SigSpec &sig_q = cell->getPort(ID::Q);
+		State init = GetSize(sig_q) == 1 ? initvals(sig_q[0]) : State::Sx;
+		auto key = std::make_pair(cell->type, init);
+		auto it = plans.find(key);
+		if (it != plans.end())
+			return it->second;
+		return plans[key] = make_plan(cell);
+	}
+
 	void legalize_ff(FfData &ff) {
 		if (ff.has_gclk)
 			return;
@@ -949,33 +1018,7 @@ struct DffLegalizePass : public Pass {
 		int ff_type = get_ff_type(ff);
 		int initmask = get_initmask(ff);
 		log_assert(supported_cells[ff_type] & initmask);
-		int ff_neg = 0;
-		if (ff.has_sr) {
-			if (!ff.pol_clr)
-				ff_neg |= NEG_R;
-			if (!ff.pol_set)
-				ff_neg |= NEG_S;
-		}
-		if (ff.has_arst) {
-			if (!ff.pol_arst)
-				ff_neg |= NEG_R;
-		}
-		if (ff.has_srst) {
-			if (!ff.pol_srst)
-				ff_neg |= NEG_R;
-		}
-		if (ff.has_aload) {
-			if (!ff.pol_aload)
-				ff_neg |= NEG_L;
-		}
-		if (ff.has_clk) {
-			if (!ff.pol_clk)
-				ff_neg |= NEG_C;
-		}
-		if (ff.has_ce) {
-			if (!ff.pol_ce)
-				ff_neg |= NEG_CE;
-		}
+		int ff_neg = get_ff_neg(ff);
 		if (!(supported_cells_neg[ff_type][ff_neg] & initmask)) {
 			// Cell is supported, but not with those polarities.
 			// Will need to add some inverters.
@@ -1206,9 +1249,16 @@ unrecognized:
 						srst_used[ff.sig_srst[0]] += ff.width;
 				}
 			}
+			std::vector<Cell*> ff_cells;
 			for (auto cell : module->selected_cells())
+				if (RTLIL::builtin_ff_cell_types().count(cell->type))
+					ff_cells.push_back(cell);
+
+			RTLIL::Module::BatchScope batch(module);
+			for (auto cell : ff_cells)
 			{
-				if (!RTLIL::builtin_ff_cell_types().count(cell->type))
+				const FfPlan &plan = get_plan(cell);
+				if (plan.keep && !(mince && plan.has_ce) && !(minsrst && plan.has_srst))
 					continue;
 				FfData ff(&initvals, cell);
 				legalize_ff(ff);
@@ -1219,6 +1269,7 @@ unrecognized:
 		initvals.clear();
 		ce_used.clear();
 		srst_used.clear();
+		plans.clear();
 	}
 } DffLegalizePass;
 
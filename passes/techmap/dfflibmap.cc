@@ -32,6 +32,11 @@ struct cell_mapping {
 };
 static std::map<RTLIL::IdString, cell_mapping> cell_mappings;
 
+// The mappings found for a set of liberty files and -dont_use patterns, for
+// the rest of the session. Keyed like liberty_cell_info(), by the file names
+// and contents, followed by the -dont_use patterns.
+static dict<std::string, std::map<RTLIL::IdString, cell_mapping>> cell_mappings_cache;
+
 static void logmap(IdString dff)
 {
 	if (cell_mappings.count(dff) == 0) {
@@ -467,6 +472,43 @@ static void find_cell_sr(std::vector<const LibertyAst *> cells, IdString cell_ty
 	}
 }
 
+static void find_cell_mappings(RTLIL::Design *design, const std::vector<std::string> &liberty_files, std::vector<std::string> &dont_use_cells)
+{
+	LibertyMergedCells merged;
+	LibertyFilter filter;
+	filter.skip_groups = LibertyFilter::timing_groups();
+	for (auto path : liberty_files) {
+		LibertyParser p(path, design->scratchpad_get_string("liberty.cache"), &filter);
+		merged.merge(p);
+	}
+
+	find_cell(merged.cells, ID($_DFF_N_), false, false, false, false, false, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFF_P_), true, false, false, false, false, false, dont_use_cells);
+
+	find_cell(merged.cells, ID($_DFF_NN0_), false, true, false, false, false, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFF_NN1_), false, true, false, true, false, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFF_NP0_), false, true, true, false, false, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFF_NP1_), false, true, true, true, false, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFF_PN0_), true, true, false, false, false, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFF_PN1_), true, true, false, true, false, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFF_PP0_), true, true, true, false, false, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFF_PP1_), true, true, true, true, false, false, dont_use_cells);
+
+	find_cell(merged.cells, ID($_DFFE_NN_), false, false, false, false, true, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFFE_NP_), false, false, false, false, true, true, dont_use_cells);
+	find_cell(merged.cells, ID($_DFFE_PN_), true, false, false, false, true, false, dont_use_cells);
+	find_cell(merged.cells, ID($_DFFE_PP_), true, false, false, false, true, true, dont_use_cells);
+
+	find_cell_sr(merged.cells, ID($_DFFSR_NNN_), false, false, false, false, false, dont_use_cells);
+	find_cell_sr(merged.cells, ID($_DFFSR_NNP_), false, false, true, false, false, dont_use_cells);
+	find_cell_sr(merged.cells, ID($_DFFSR_NPN_), false, true, false, false, false, dont_use_cells);
+	find_cell_sr(merged.cells, ID($_DFFSR_NPP_), false, true, true, false, false, dont_use_cells);
+	find_cell_sr(merged.cells, ID($_DFFSR_PNN_), true, false, false, false, false, dont_use_cells);
+	find_cell_sr(merged.cells, ID($_DFFSR_PNP_), true, false, true, false, false, dont_use_cells);
+	find_cell_sr(merged.cells, ID($_DFFSR_PPN_), true, true, false, false, false, dont_use_cells);
+	find_cell_sr(merged.cells, ID($_DFFSR_PPP_), true, true, true, false, false, dont_use_cells);
+}
+
 static void dfflibmap(RTLIL::Design *design, RTLIL::Module *module)
 {
 	log("Mapping DFF cells in module `%s':\n", module->name.c_str());
@@ -492,7 +534,7 @@ static void dfflibmap(RTLIL::Design *design, RTLIL::Module *module)
 
 		module->remove(cell);
 
-		cell_mapping &cm = cell_mappings[cell_type];
+		const cell_mapping &cm = cell_mappings.at(cell_type);
 		RTLIL::Cell *new_cell = module->addCell(cell_name, cm.cell_name);
 
 		new_cell->set_src_attribute(src);
@@ -572,6 +614,11 @@ struct DfflibmapPass : public Pass {
 		log("This argument can be called multiple times with different cell names. This\n");
 		log("argument also supports simple glob patterns in the cell name.\n");
 		log("\n");
+		log("The cell mappings found for a set of liberty files and -dont_use options\n");
+		log("are kept for the rest of the session and reused as long as the files don't\n");
+		log("change. See 'help read_liberty' for the 'liberty.cache' scratchpad variable,\n");
+		log("which also skips parsing the files in later sessions.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -628,42 +675,21 @@ struct DfflibmapPass : public Pass {
 		if (liberty_files.empty())
 			log_cmd_error("Missing `-liberty liberty_file' option!\n");
 
-		LibertyMergedCells merged;
-		for (auto path : liberty_files) {
-			std::ifstream f;
-			f.open(path.c_str());
-			if (f.fail())
-				log_cmd_error("Can't open liberty file `%s': %s\n", path.c_str(), strerror(errno));
-			LibertyParser p(f);
-			merged.merge(p);
-			f.close();
+		std::string cache_key;
+		for (auto &path : liberty_files) {
+			cache_key += path + "\n" + file_content_key(path) + "\n";
+		}
+		for (auto &pattern : dont_use_cells)
+			cache_key += "dont_use " + pattern + "\n";
+
+		auto cached = cell_mappings_cache.find(cache_key);
+		if (cached != cell_mappings_cache.end()) {
+			log("Using cached dff cell mappings of the liberty files.\n");
+			cell_mappings = cached->second;
+		} else {
+			find_cell_mappings(design, liberty_files, dont_use_cells);
+			cell_mappings_cache[cache_key] = cell_mappings;
 		}
-
-		find_cell(merged.cells, ID($_DFF_N_), false, false, false, false, false, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFF_P_), true, false, false, false, false, false, dont_use_cells);
-
-		find_cell(merged.cells, ID($_DFF_NN0_), false, true, false, false, false, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFF_NN1_), false, true, false, true, false, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFF_NP0_), false, true, true, false, false, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFF_NP1_), false, true, true, true, false, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFF_PN0_), true, true, false, false, false, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFF_PN1_), true, true, false, true, false, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFF_PP0_), true, true, true, false, false, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFF_PP1_), true, true, true, true, false, false, dont_use_cells);
-
-		find_cell(merged.cells, ID($_DFFE_NN_), false, false, false, false, true, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFFE_NP_), false, false, false, false, true, true, dont_use_cells);
-		find_cell(merged.cells, ID($_DFFE_PN_), true, false, false, false, true, false, dont_use_cells);
-		find_cell(merged.cells, ID($_DFFE_PP_), true, false, false, false, true, true, dont_use_cells);
-
-		find_cell_sr(merged.cells, ID($_DFFSR_NNN_), false, false, false, false, false, dont_use_cells);
-		find_cell_sr(merged.cells, ID($_DFFSR_NNP_), false, false, true, false, false, dont_use_cells);
-		find_cell_sr(merged.cells, ID($_DFFSR_NPN_), false, true, false, false, false, dont_use_cells);
-		find_cell_sr(merged.cells, ID($_DFFSR_NPP_), false, true, true, false, false, dont_use_cells);
-		find_cell_sr(merged.cells, ID($_DFFSR_PNN_), true, false, false, false, false, dont_use_cells);
-		find_cell_sr(merged.cells, ID($_DFFSR_PNP_), true, false, true, false, false, dont_use_cells);
-		find_cell_sr(merged.cells, ID($_DFFSR_PPN_), true, true, false, false, false, dont_use_cells);
-		find_cell_sr(merged.cells, ID($_DFFSR_PPP_), true, true, true, false, false, dont_use_cells);
 
 		log("  final dff cell mappings:\n");
 		logmap_all();
@@ -681,9 +707,14 @@ struct DfflibmapPass : public Pass {
 		}
 
 		if (!prepare_mode && !info_mode) {
+			std::vector<RTLIL::Module*> modules;
 			for (auto module : design->selected_modules())
 				if (!module->get_blackbox_attribute())
-					dfflibmap(design, module);
+					modules.push_back(module);
+			// each cell is replaced on its own, within its module
+			parallel_modules(design, modules, [&](RTLIL::Module *module) {
+				dfflibmap(design, module);
+			});
 		}
 
 		log_pop();
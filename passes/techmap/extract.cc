@@ -427,6 +427,9 @@ struct ExtractPass : public Pass {
 		log("    -mine_max_fanout <num>\n");
 		log("        don't consider internal signals with more than <num> connections\n");
 		log("\n");
+		log("When mining, the search for the matches of a subcircuit is split over as many\n");
+		log("threads as set with 'yosys -j'.\n");
+		log("\n");
 		log("The modules in the map file may have the attribute 'extract_order' set to an\n");
 		log("integer value. Then this value is used to determine the order in which the pass\n");
 		log("tries to map the modules to the design (ascending, default value is 0).\n");
@@ -559,6 +562,7 @@ struct ExtractPass : public Pass {
 			break;
 		}
 		extra_args(args, argidx, design);
+		solver.setThreads(parallel_threads(design));
 
 		if (!nodefaultswaps) {
 			solver.addSwappablePorts("$and",       "\\A", "\\B");
@@ -19,7 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
-#include "kernel/consteval.h"
+#include "kernel/cutenum.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -30,7 +30,6 @@ struct ExtractFaConfig
 	bool enable_ha = false;
 	bool verbose = false;
 	int maxdepth = 20;
-	int maxbreadth = 6;
 };
 
 // http://svn.clairexen.net/handicraft/2016/bindec/bindec.c
@@ -51,8 +50,8 @@ struct ExtractFaWorker
 {
 	const ExtractFaConfig &config;
 	Module *module;
-	ConstEval ce;
-	SigMap &sigmap;
+	SigMap sigmap;
+	CutEnum cutenum;
 
 	dict<SigBit, Cell*> driver;
 	pool<SigBit> handled_bits;
@@ -81,17 +80,16 @@ struct ExtractFaWorker
 	dict<int, func3_maj_info_t> func3_maj_info;
 
 	ExtractFaWorker(const ExtractFaConfig &config, Module *module) :
-			config(config), module(module), ce(module), sigmap(ce.assign_map)
+			config(config), module(module), sigmap(module), cutenum(sigmap, 3)
 	{
 		for (auto cell : module->selected_cells())
 		{
-			if (cell->type.in( ID($_BUF_), ID($_NOT_), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_),
-					ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_NMUX_),
-					ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_)))
+			if (CutEnum::supported(cell->type))
 			{
 				SigBit y = sigmap(SigBit(cell->getPort(ID::Y)));
 				log_assert(driver.count(y) == 0);
 				driver[y] = cell;
+				cutenum.add_cell(cell);
 			}
 		}
 
@@ -153,37 +151,27 @@ struct ExtractFaWorker
 		}
 	}
 
-	void check_partition(SigBit root, pool<SigBit> &leaves)
+	void check_cut(SigBit root, const CutEnum::Cut &cut)
 	{
-		if (config.enable_ha && GetSize(leaves) == 2)
-		{
-			leaves.sort();
-
-			SigBit A = SigSpec(leaves)[0];
-			SigBit B = SigSpec(leaves)[1];
-
-			int func = 0;
-			for (int i = 0; i < 4; i++)
-			{
-				bool a_value = (i & 1) != 0;
-				bool b_value = (i & 2) != 0;
-
-				ce.push();
-				ce.set(A, a_value ? State::S1 : State::S0);
-				ce.set(B, b_value ? State::S1 : State::S0);
-
-				SigSpec sig = root;
-
-				if (!ce.eval(sig)) {
-					ce.pop();
-					return;
-				}
-
-				if (sig == State::S1)
-					func |= 1 << i;
+		int nleaves = GetSize(cut.leaves);
+		if (!(config.enable_ha && nleaves == 2) && !(config.enable_fa && nleaves == 3))
+			return;
 
-				ce.pop();
-			}
+		// the functions are recorded with the leaves in the order of their bits
+		std::vector<SigBit> leaves;
+		for (int leaf : cut.leaves)
+			leaves.push_back(cutenum.bit(leaf));
+		std::vector<SigBit> sorted = leaves;
+		std::sort(sorted.begin(), sorted.end());
+		std::vector<int> varmap;
+		for (auto bit : leaves)
+			varmap.push_back(std::find(sorted.begin(), sorted.end(), bit) - sorted.begin());
+		int func = tt_permute(cut.truth, nleaves, varmap);
+
+		if (nleaves == 2)
+		{
+			SigBit A = sorted[0];
+			SigBit B = sorted[1];
 
 			// log("%04d %s %s -> %s\n", bindec(func), log_signal(A), log_signal(B), log_signal(root));
 
@@ -193,39 +181,11 @@ struct ExtractFaWorker
 			count_func2++;
 			func2[tuple<SigBit, SigBit>(A, B)][func].insert(root);
 		}
-
-		if (config.enable_fa && GetSize(leaves) == 3)
+		else
 		{
-			leaves.sort();
-
-			SigBit A = SigSpec(leaves)[0];
-			SigBit B = SigSpec(leaves)[1];
-			SigBit C = SigSpec(leaves)[2];
-
-			int func = 0;
-			for (int i = 0; i < 8; i++)
-			{
-				bool a_value = (i & 1) != 0;
-				bool b_value = (i & 2) != 0;
-				bool c_value = (i & 4) != 0;
-
-				ce.push();
-				ce.set(A, a_value ? State::S1 : State::S0);
-				ce.set(B, b_value ? State::S1 : State::S0);
-				ce.set(C, c_value ? State::S1 : State::S0);
-
-				SigSpec sig = root;
-
-				if (!ce.eval(sig)) {
-					ce.pop();
-					return;
-				}
-
-				if (sig == State::S1)
-					func |= 1 << i;
-
-				ce.pop();
-			}
+			SigBit A = sorted[0];
+			SigBit B = sorted[1];
+			SigBit C = sorted[2];
 
 			// log("%08d %s %s %s -> %s\n", bindec(func), log_signal(A), log_signal(B), log_signal(C), log_signal(root));
 
@@ -237,47 +197,6 @@ struct ExtractFaWorker
 		}
 	}
 
-	void find_partitions(SigBit root, pool<SigBit> &leaves, pool<pool<SigBit>> &cache, int maxdepth, int maxbreadth)
-	{
-		if (cache.count(leaves))
-			return;
-
-		// log("%*s[%d] %s:", 20-maxdepth, "", maxdepth, log_signal(root));
-		// for (auto bit : leaves)
-		// 	log(" %s", log_signal(bit));
-		// log("\n");
-
-		cache.insert(leaves);
-		check_partition(root, leaves);
-
-		if (maxdepth == 0)
-			return;
-
-		for (SigBit bit : leaves)
-		{
-			if (driver.count(bit) == 0)
-				continue;
-
-			Cell *cell = driver.at(bit);
-			pool<SigBit> new_leaves = leaves;
-
-			new_leaves.erase(bit);
-			for (auto port : {ID::A, ID::B, ID::C, ID::D}) {
-				if (!cell->hasPort(port))
-					continue;
-				auto bit = sigmap(SigBit(cell->getPort(port)));
-				if (!bit.wire)
-					continue;
-				new_leaves.insert(bit);
-			}
-
-			if (GetSize(new_leaves) > maxbreadth)
-				continue;
-
-			find_partitions(root, new_leaves, cache, maxdepth-1, maxbreadth);
-		}
-	}
-
 	void assign_new_driver(SigBit bit, SigBit new_driver)
 	{
 		Cell *cell = driver.at(bit);
@@ -291,14 +210,14 @@ struct ExtractFaWorker
 	{
 		log("Extracting full/half adders from %s:\n", log_id(module));
 
+		cutenum.run(module->design);
+
 		for (auto it : driver)
 		{
 			if (it.second->type.in(ID($_BUF_), ID($_NOT_)))
 				continue;
 
 			SigBit root = it.first;
-			pool<SigBit> leaves = { root };
-			pool<pool<SigBit>> cache;
 
 			if (config.verbose)
 				log("  checking %s\n", log_signal(it.first));
@@ -306,7 +225,9 @@ struct ExtractFaWorker
 			count_func2 = 0;
 			count_func3 = 0;
 
-			find_partitions(root, leaves, cache, config.maxdepth, config.maxbreadth);
+			for (auto &cut : cutenum.cuts(cutenum.node(root)))
+				if (cut.depth <= config.maxdepth)
+					check_cut(root, cut);
 
 			if (config.verbose && count_func2 > 0)
 				log("    extracted %d two-input functions\n", count_func2);
@@ -553,10 +474,11 @@ struct ExtractFaPass : public Pass {
 		log("        All types are enabled if none of this options is used\n");
 		log("\n");
 		log("    -d <int>\n");
-		log("        Set maximum depth for extracted logic cones (default=20)\n");
+		log("        Set maximum depth for extracted logic cones, in gates (default=20)\n");
 		log("\n");
 		log("    -b <int>\n");
-		log("        Set maximum breadth for extracted logic cones (default=6)\n");
+		log("        Accepted for compatibility, the logic cones are found bottom up and\n");
+		log("        their breadth is not limited any more.\n");
 		log("\n");
 		log("    -v\n");
 		log("        Verbose output\n");
@@ -589,7 +511,7 @@ struct ExtractFaPass : public Pass {
 				continue;
 			}
 			if (args[argidx] == "-b" && argidx+2 < args.size()) {
-				config.maxbreadth = atoi(args[++argidx].c_str());
+				++argidx;
 				continue;
 			}
 			break;
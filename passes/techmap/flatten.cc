@@ -55,6 +55,105 @@ void map_sigspec(const dict<RTLIL::Wire*, RTLIL::Wire*> &map, RTLIL::SigSpec &si
 	sig = chunks;
 }
 
+// The parts of a template that are the same for all of its instances, collected once per template.
+struct FlattenTemplate
+{
+	std::vector<RTLIL::Wire*> wires;
+	std::vector<RTLIL::Cell*> cells;
+	dict<RTLIL::Wire*, int> wire_index;
+
+	// Names of the wires and cells without the name of the instance, see concat_name(): the name of an
+	// object in an instance is `prefix + instance name + suffix`.
+	std::vector<bool> wire_public, cell_public;
+	std::vector<std::string> wire_suffixes, cell_suffixes;
+
+	// For each chunk of each cell connection and each module connection, the index of its wire, or -1.
+	std::vector<std::vector<std::vector<int>>> cell_chunk_wires;
+	std::vector<std::pair<std::vector<int>, std::vector<int>>> conn_chunk_wires;
+
+	dict<IdString, IdString> positional_ports;
+	pool<SigBit> driven;
+
+	static std::string name_suffix(IdString object_name, const std::string &separator)
+	{
+		if (object_name[0] == '\\')
+			return separator + (object_name.c_str() + 1);
+		std::string object_name_str = object_name.str();
+		if (object_name_str.substr(0, 8) == "$flatten")
+			object_name_str.erase(0, 8);
+		return separator + object_name_str;
+	}
+
+	std::vector<int> chunk_wires(const RTLIL::SigSpec &sig) const
+	{
+		std::vector<int> indices;
+		for (auto &chunk : sig.chunks())
+			indices.push_back(chunk.wire ? wire_index.at(chunk.wire) : -1);
+		return indices;
+	}
+
+	FlattenTemplate(RTLIL::Module *tpl, const std::string &separator)
+	{
+		for (auto tpl_wire : tpl->wires()) {
+			wire_index[tpl_wire] = GetSize(wires);
+			wires.push_back(tpl_wire);
+			wire_public.push_back(tpl_wire->name[0] == '\\');
+			wire_suffixes.push_back(name_suffix(tpl_wire->name, separator));
+			if (tpl_wire->port_id > 0)
+				positional_ports.emplace(stringf("$%d", tpl_wire->port_id), tpl_wire->name);
+		}
+
+		for (auto tpl_cell : tpl->cells()) {
+			cells.push_back(tpl_cell);
+			cell_public.push_back(tpl_cell->name[0] == '\\');
+			cell_suffixes.push_back(name_suffix(tpl_cell->name, separator));
+			cell_chunk_wires.emplace_back();
+			for (auto &tpl_conn : tpl_cell->connections()) {
+				cell_chunk_wires.back().push_back(chunk_wires(tpl_conn.second));
+				if (tpl_cell->output(tpl_conn.first))
+					for (auto bit : tpl_conn.second)
+						driven.insert(bit);
+			}
+		}
+
+		for (auto &tpl_conn : tpl->connections()) {
+			conn_chunk_wires.emplace_back(chunk_wires(tpl_conn.first), chunk_wires(tpl_conn.second));
+			for (auto bit : tpl_conn.first)
+				driven.insert(bit);
+		}
+	}
+
+	void map_sigspec(const std::vector<RTLIL::Wire*> &new_wires, const std::vector<int> &indices, RTLIL::SigSpec &sig) const
+	{
+		vector<SigChunk> chunks = sig;
+		log_assert(GetSize(chunks) == GetSize(indices));
+		for (int i = 0; i < GetSize(chunks); i++)
+			if (indices[i] >= 0)
+				chunks[i].wire = new_wires[indices[i]];
+		sig = chunks;
+	}
+};
+
+// The names of the wires and cells of one instance of a template.
+struct FlattenNames
+{
+	std::vector<IdString> wires, cells;
+
+	FlattenNames() {}
+
+	FlattenNames(const FlattenTemplate &image, RTLIL::Cell *cell)
+	{
+		const std::string &cell_name = cell->name.str();
+		auto make_name = [&](bool is_public, const std::string &suffix) {
+			return is_public ? cell_name + suffix : "$flatten" + cell_name + suffix;
+		};
+		for (int i = 0; i < GetSize(image.wires); i++)
+			wires.push_back(make_name(image.wire_public[i], image.wire_suffixes[i]));
+		for (int i = 0; i < GetSize(image.cells); i++)
+			cells.push_back(make_name(image.cell_public[i], image.cell_suffixes[i]));
+	}
+};
+
 struct FlattenWorker
 {
 	bool ignore_wb = false;
@@ -62,6 +161,17 @@ struct FlattenWorker
 	bool create_scopename = false;
 	std::string separator = ".";
 
+	// Templates are only used once they have been flattened themselves, and do not change afterwards.
+	dict<RTLIL::Module*, std::unique_ptr<FlattenTemplate>> templates;
+
+	const FlattenTemplate &template_image(RTLIL::Module *tpl, const std::string &separator)
+	{
+		auto &image = templates[tpl];
+		if (image == nullptr)
+			image.reset(new FlattenTemplate(tpl, separator));
+		return *image;
+	}
+
 	template<class T>
 	void map_attributes(RTLIL::Cell *cell, T *object, IdString orig_object_name)
 	{
@@ -108,7 +218,8 @@ struct FlattenWorker
 		}
 	}
 
-	void flatten_cell(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, SigMap &sigmap, std::vector<RTLIL::Cell*> &new_cells, const std::string &separator)
+	void flatten_cell(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, SigMap &sigmap, std::vector<RTLIL::Cell*> &new_cells, const std::string &separator,
+			const FlattenTemplate &image, const FlattenNames &names)
 	{
 		// Copy the contents of the flattened cell
 
@@ -120,15 +231,12 @@ struct FlattenWorker
 			design->select(module, new_memory);
 		}
 
-		dict<RTLIL::Wire*, RTLIL::Wire*> wire_map;
-		dict<IdString, IdString> positional_ports;
-		for (auto tpl_wire : tpl->wires()) {
-			if (tpl_wire->port_id > 0)
-				positional_ports.emplace(stringf("$%d", tpl_wire->port_id), tpl_wire->name);
-
+		std::vector<RTLIL::Wire*> new_wires(GetSize(image.wires));
+		for (int i = 0; i < GetSize(image.wires); i++) {
+			RTLIL::Wire *tpl_wire = image.wires[i];
 			RTLIL::Wire *new_wire = nullptr;
 			if (tpl_wire->name[0] == '\\') {
-				RTLIL::Wire *hier_wire = module->wire(concat_name(cell, tpl_wire->name, separator));
+				RTLIL::Wire *hier_wire = module->wire(names.wires[i]);
 				if (hier_wire != nullptr && hier_wire->get_bool_attribute(ID::hierconn)) {
 					hier_wire->attributes.erase(ID::hierconn);
 					if (GetSize(hier_wire) < GetSize(tpl_wire)) {
@@ -140,29 +248,35 @@ struct FlattenWorker
 				}
 			}
 			if (new_wire == nullptr) {
-				new_wire = module->addWire(map_name(cell, tpl_wire, separator), tpl_wire);
+				new_wire = module->addWire(module->uniquify(names.wires[i]), tpl_wire);
 				new_wire->port_input = new_wire->port_output = false;
 				new_wire->port_id = false;
 			}
 
 			map_attributes(cell, new_wire, tpl_wire->name);
-			wire_map[tpl_wire] = new_wire;
+			new_wires[i] = new_wire;
 			design->select(module, new_wire);
 		}
 
-		for (auto &tpl_proc_it : tpl->processes) {
-			RTLIL::Process *new_proc = module->addProcess(map_name(cell, tpl_proc_it.second, separator), tpl_proc_it.second);
-			map_attributes(cell, new_proc, tpl_proc_it.second->name);
-			for (auto new_proc_sync : new_proc->syncs)
-				for (auto &memwr_action : new_proc_sync->mem_write_actions)
-					memwr_action.memid = memory_map.at(memwr_action.memid).str();
-			auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
-			new_proc->rewrite_sigspecs(rewriter);
-			design->select(module, new_proc);
+		if (!tpl->processes.empty()) {
+			dict<RTLIL::Wire*, RTLIL::Wire*> wire_map;
+			for (int i = 0; i < GetSize(image.wires); i++)
+				wire_map[image.wires[i]] = new_wires[i];
+			for (auto &tpl_proc_it : tpl->processes) {
+				RTLIL::Process *new_proc = module->addProcess(map_name(cell, tpl_proc_it.second, separator), tpl_proc_it.second);
+				map_attributes(cell, new_proc, tpl_proc_it.second->name);
+				for (auto new_proc_sync : new_proc->syncs)
+					for (auto &memwr_action : new_proc_sync->mem_write_actions)
+						memwr_action.memid = memory_map.at(memwr_action.memid).str();
+				auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
+				new_proc->rewrite_sigspecs(rewriter);
+				design->select(module, new_proc);
+			}
 		}
 
-		for (auto tpl_cell : tpl->cells()) {
-			RTLIL::Cell *new_cell = module->addCell(map_name(cell, tpl_cell, separator), tpl_cell);
+		for (int i = 0; i < GetSize(image.cells); i++) {
+			RTLIL::Cell *tpl_cell = image.cells[i];
+			RTLIL::Cell *new_cell = module->addCell(module->uniquify(names.cells[i]), tpl_cell);
 			map_attributes(cell, new_cell, tpl_cell->name);
 			if (new_cell->has_memid()) {
 				IdString memid = new_cell->getParam(ID::MEMID).decode_string();
@@ -171,36 +285,37 @@ struct FlattenWorker
 				IdString memid = new_cell->getParam(ID::MEMID).decode_string();
 				new_cell->setParam(ID::MEMID, Const(concat_name(cell, memid, separator).str()));
 			}
-			auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
+			int conn_idx = 0;
+			auto rewriter = [&](RTLIL::SigSpec &sig) { image.map_sigspec(new_wires, image.cell_chunk_wires[i][conn_idx++], sig); };
 			new_cell->rewrite_sigspecs(rewriter);
 			design->select(module, new_cell);
 			new_cells.push_back(new_cell);
 		}
 
+		int conn_idx = 0;
 		for (auto &tpl_conn_it : tpl->connections()) {
 			RTLIL::SigSig new_conn = tpl_conn_it;
-			map_sigspec(wire_map, new_conn.first);
-			map_sigspec(wire_map, new_conn.second);
+			image.map_sigspec(new_wires, image.conn_chunk_wires[conn_idx].first, new_conn.first);
+			image.map_sigspec(new_wires, image.conn_chunk_wires[conn_idx].second, new_conn.second);
 			module->connect(new_conn);
+			conn_idx++;
 		}
 
 		// Attach port connections of the flattened cell
 
-		pool<SigBit> tpl_driven;
-		for (auto tpl_cell : tpl->cells())
-			for (auto &tpl_conn : tpl_cell->connections())
-				if (tpl_cell->output(tpl_conn.first))
-					for (auto bit : tpl_conn.second)
-						tpl_driven.insert(bit);
-		for (auto &tpl_conn : tpl->connections())
-			for (auto bit : tpl_conn.first)
-				tpl_driven.insert(bit);
+		auto map_port_sigspec = [&](RTLIL::SigSpec &sig) {
+			vector<SigChunk> chunks = sig;
+			for (auto &chunk : chunks)
+				if (chunk.wire != nullptr && chunk.wire->module == tpl)
+					chunk.wire = new_wires[image.wire_index.at(chunk.wire)];
+			sig = chunks;
+		};
 
 		for (auto &port_it : cell->connections())
 		{
 			IdString port_name = port_it.first;
-			if (positional_ports.count(port_name) > 0)
-				port_name = positional_ports.at(port_name);
+			if (image.positional_ports.count(port_name) > 0)
+				port_name = image.positional_ports.at(port_name);
 			if (tpl->wire(port_name) == nullptr || tpl->wire(port_name)->port_id == 0) {
 				if (port_name.begins_with("$"))
 					log_error("Can't map port `%s' of cell `%s' to template `%s'!\n",
@@ -225,7 +340,7 @@ struct FlattenWorker
 			} else {
 				SigSpec sig_tpl = tpl_wire, sig_mod = port_it.second;
 				for (int i = 0; i < GetSize(sig_tpl) && i < GetSize(sig_mod); i++) {
-					if (tpl_driven.count(sig_tpl[i])) {
+					if (image.driven.count(sig_tpl[i])) {
 						new_conn.first.append(sig_mod[i]);
 						new_conn.second.append(sig_tpl[i]);
 					} else {
@@ -234,8 +349,8 @@ struct FlattenWorker
 					}
 				}
 			}
-			map_sigspec(wire_map, new_conn.first, module);
-			map_sigspec(wire_map, new_conn.second, module);
+			map_port_sigspec(new_conn.first);
+			map_port_sigspec(new_conn.second);
 
 			if (new_conn.second.size() > new_conn.first.size())
 				new_conn.second.remove(new_conn.first.size(), new_conn.second.size() - new_conn.first.size());
@@ -287,6 +402,35 @@ struct FlattenWorker
 
 		SigMap sigmap(module);
 		std::vector<RTLIL::Cell*> worklist = module->selected_cells();
+
+		// Building the names of the objects of all instances is independent of the order in which they are
+		// flattened, so this is done up front, in parallel. Storage for the new objects is allocated up front too.
+		std::vector<RTLIL::Cell*> instances;
+		std::vector<const FlattenTemplate*> instance_images;
+		int new_wires = 0, new_cells = 0;
+		for (auto cell : worklist) {
+			RTLIL::Module *tpl = design->module(cell->type);
+			if (tpl == nullptr || tpl->get_blackbox_attribute(ignore_wb) ||
+					cell->get_bool_attribute(ID::keep_hierarchy) || tpl->get_bool_attribute(ID::keep_hierarchy))
+				continue;
+			instances.push_back(cell);
+			instance_images.push_back(&template_image(tpl, separator));
+			new_wires += GetSize(instance_images.back()->wires);
+			new_cells += GetSize(instance_images.back()->cells);
+		}
+		std::vector<FlattenNames> instance_names(GetSize(instances));
+		IdString::reserve(new_wires + new_cells);
+		int jobs = std::min(GetSize(instances), 4 * Pass::parallel_threads(design));
+		Pass::parallel_for(design, jobs, [&](int job) {
+			for (int i = job; i < GetSize(instances); i += jobs)
+				instance_names[i] = FlattenNames(*instance_images[i], instances[i]);
+		});
+		dict<RTLIL::Cell*, int> instance_index;
+		for (int i = 0; i < GetSize(instances); i++)
+			instance_index[instances[i]] = i;
+		module->wires_.reserve(module->wires_.size() + new_wires);
+		module->cells_.reserve(module->cells_.size() + new_cells);
+
 		while (!worklist.empty())
 		{
 			RTLIL::Cell *cell = worklist.back();
@@ -309,7 +453,12 @@ struct FlattenWorker
 			// If a design is fully selected and has a top module defined, topological sorting ensures that all cells
 			// added during flattening are black boxes, and flattening is finished in one pass. However, when flattening
 			// individual modules, this isn't the case, and the newly added cells might have to be flattened further.
-			flatten_cell(design, module, cell, tpl, sigmap, worklist, separator);
+			const FlattenTemplate &image = template_image(tpl, separator);
+			auto it = instance_index.find(cell);
+			if (it != instance_index.end())
+				flatten_cell(design, module, cell, tpl, sigmap, worklist, separator, image, instance_names[it->second]);
+			else
+				flatten_cell(design, module, cell, tpl, sigmap, worklist, separator, image, FlattenNames(image, cell));
 		}
 	}
 };
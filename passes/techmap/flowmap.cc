@@ -460,7 +460,12 @@ struct FlowmapWorker
 	// Gate IR
 	pool<RTLIL::SigBit> nodes, inputs, outputs;
 	dict<RTLIL::SigBit, pool<RTLIL::SigBit>> edges_fw, edges_bw;
-	dict<RTLIL::SigBit, int> labels;
+	flat_dict<RTLIL::SigBit, int> labels;
+
+	// Read-only views of `edges_bw` and `inputs` for labeling, which looks nodes up from several threads at once.
+	// Unlike dict and pool, flat_dict and flat_pool never rehash on lookup.
+	flat_dict<RTLIL::SigBit, const pool<RTLIL::SigBit>*> label_preds;
+	flat_pool<RTLIL::SigBit> label_inputs;
 
 	// LUT IR
 	pool<RTLIL::SigBit> lut_nodes;
@@ -468,6 +473,10 @@ struct FlowmapWorker
 	dict<RTLIL::SigBit, pool<RTLIL::SigBit>> lut_edges_fw, lut_edges_bw;
 	dict<RTLIL::SigBit, int> lut_depths, lut_altitudes, lut_slacks;
 
+	// Results of cut_lut_at_gate(), kept while relaxing for successive depth bounds. The result for a LUT only changes
+	// when that LUT is broken.
+	dict<RTLIL::SigBit, dict<RTLIL::SigBit, pair<pool<RTLIL::SigBit>, pool<RTLIL::SigBit>>>> lut_cuts;
+
 	int gate_count = 0, lut_count = 0, packed_count = 0;
 	int gate_area = 0, lut_area = 0;
 
@@ -542,7 +551,7 @@ struct FlowmapWorker
 		{
 			auto node = worklist.pop();
 			subgraph.insert(node);
-			for (auto source : edges_bw[node])
+			for (auto source : *label_preds.at(node))
 			{
 				if (!subgraph[source])
 					worklist.insert(source);
@@ -562,14 +571,14 @@ struct FlowmapWorker
 			auto node = worklist.pop();
 			visited.insert(node);
 
-			auto collapsed_node = labels[node] == p ? sink : node;
+			auto collapsed_node = labels.at(node) == p ? sink : node;
 			if (node != collapsed_node)
 				flow_graph.collapsed[collapsed_node].insert(node);
 			flow_graph.nodes.insert(collapsed_node);
 
-			for (auto node_pred : edges_bw[node])
+			for (auto node_pred : *label_preds.at(node))
 			{
-				auto collapsed_node_pred = labels[node_pred] == p ? sink : node_pred;
+				auto collapsed_node_pred = labels.at(node_pred) == p ? sink : node_pred;
 				if (node_pred != collapsed_node_pred)
 					flow_graph.collapsed[collapsed_node_pred].insert(node_pred);
 				if (collapsed_node != collapsed_node_pred)
@@ -577,7 +586,7 @@ struct FlowmapWorker
 					flow_graph.edges_bw[collapsed_node].insert(collapsed_node_pred);
 					flow_graph.edges_fw[collapsed_node_pred].insert(collapsed_node);
 				}
-				if (inputs[node_pred])
+				if (label_inputs.count(node_pred))
 				{
 					flow_graph.edges_bw[collapsed_node_pred].insert(flow_graph.source);
 					flow_graph.edges_fw[flow_graph.source].insert(collapsed_node_pred);
@@ -668,6 +677,80 @@ struct FlowmapWorker
 		}
 	}
 
+	struct NodeLabel
+	{
+		int label;
+		pool<RTLIL::SigBit> lut_gates, lut_inputs;
+	};
+
+	// Computes the label of `sink` and the gates and inputs of the LUT rooted in it, which only depends on the labels
+	// of the nodes in its fan-in cone. The gate IR is only read through `label_preds` and `label_inputs`, so several
+	// nodes can be labeled at once.
+	NodeLabel label_node(RTLIL::SigBit sink, int debug_num)
+	{
+		if (debug)
+			log("Examining subgraph %d rooted in %s.\n", debug_num, log_signal(sink));
+
+		pool<RTLIL::SigBit> subgraph = find_subgraph(sink);
+
+		int p = 1;
+		for (auto subgraph_node : subgraph)
+			p = max(p, labels.at(subgraph_node));
+
+		NodeLabel result;
+		FlowGraph flow_graph = build_flow_graph(sink, p);
+		int flow = flow_graph.maximum_flow(order);
+		pool<RTLIL::SigBit> x, xi;
+		if (flow <= order)
+		{
+			result.label = p;
+			auto cut = flow_graph.edge_cut();
+			x = cut.first;
+			xi = cut.second;
+		}
+		else
+		{
+			result.label = p + 1;
+			x = subgraph;
+			x.erase(sink);
+			xi.insert(sink);
+		}
+
+		pool<RTLIL::SigBit> k;
+		for (auto xi_node : xi)
+		{
+			for (auto xi_node_pred : *label_preds.at(xi_node))
+				if (x[xi_node_pred])
+					k.insert(xi_node_pred);
+		}
+		log_assert((int)k.size() <= order);
+
+		if (debug)
+		{
+			log("  Maximum flow: %d. Assigned label %d.\n", flow, result.label);
+			dump_dot_graph(stringf("flowmap-%d-sub.dot", debug_num), GraphMode::Cut, subgraph, {}, {}, {x, xi});
+			log("  Dumped subgraph to `flowmap-%d-sub.dot`.\n", debug_num);
+			flow_graph.dump_dot_graph(stringf("flowmap-%d-flow.dot", debug_num));
+			log("  Dumped flow graph to `flowmap-%d-flow.dot`.\n", debug_num);
+			log("    LUT inputs:");
+			for (auto k_node : k)
+				log(" %s", log_signal(k_node));
+			log(".\n");
+			log("    LUT packed gates:");
+			for (auto xi_node : xi)
+				log(" %s", log_signal(xi_node));
+			log(".\n");
+		}
+
+		result.lut_gates = std::move(xi);
+		result.lut_inputs = std::move(k);
+		return result;
+	}
+
+	// The nodes are labeled one topological level at a time. A node only depends on the labels of its predecessors,
+	// which are all on lower levels, so the nodes on one level are labeled in parallel, each with its own flow graph.
+	// The results are committed in the order of the nodes on the level, which does not depend on the number of
+	// threads. Nodes on a combinational loop are never labeled.
 	void label_nodes()
 	{
 		for (auto node : nodes)
@@ -680,90 +763,62 @@ struct FlowmapWorker
 				labels[input] = 0;
 		}
 
-		pool<RTLIL::SigBit> worklist = nodes;
-		int debug_num = 0;
-		while (!worklist.empty())
+		for (auto node : nodes)
+			edges_bw[node];
+		for (auto node : nodes)
+			label_preds[node] = &edges_bw.at(node);
+		label_inputs = flat_pool<RTLIL::SigBit>(inputs.begin(), inputs.end());
+
+		dict<RTLIL::SigBit, int> unlabeled_preds;
+		vector<RTLIL::SigBit> level;
+		for (auto node : nodes)
 		{
-			auto sink = worklist.pop();
-			if (labels[sink] != -1)
+			if (labels[node] != -1)
 				continue;
+			int count = 0;
+			for (auto node_pred : edges_bw[node])
+				if (labels[node_pred] == -1)
+					count++;
+			unlabeled_preds[node] = count;
+			if (count == 0)
+				level.push_back(node);
+		}
 
-			bool inputs_have_labels = true;
-			for (auto sink_input : edges_bw[sink])
+		int threads = debug ? 1 : Pass::parallel_threads(module->design);
+		int debug_num = 0;
+		while (!level.empty())
+		{
+			vector<NodeLabel> results(level.size());
+			int jobs = threads > 1 ? min(GetSize(level), 4 * threads) : 1;
+			Pass::parallel_for(module->design, jobs, [&](int job) {
+				for (int i = job; i < GetSize(level); i += jobs)
+					results[i] = label_node(level[i], debug_num + i + 1);
+			}, threads);
+			debug_num += GetSize(level);
+
+			vector<RTLIL::SigBit> next_level;
+			for (int i = 0; i < GetSize(level); i++)
 			{
-				if (labels[sink_input] == -1)
+				RTLIL::SigBit sink = level[i];
+				labels[sink] = results[i].label;
+				lut_gates[sink] = std::move(results[i].lut_gates);
+				lut_edges_bw[sink] = std::move(results[i].lut_inputs);
+				for (auto k_node : lut_edges_bw[sink])
+					lut_edges_fw[k_node].insert(sink);
+
+				for (auto sink_succ : edges_fw[sink])
 				{
-					inputs_have_labels = false;
-					break;
+					auto it = unlabeled_preds.find(sink_succ);
+					if (it != unlabeled_preds.end() && --it->second == 0)
+						next_level.push_back(sink_succ);
 				}
 			}
-			if (!inputs_have_labels)
-				continue;
-
-			if (debug)
-			{
-				debug_num++;
-				log("Examining subgraph %d rooted in %s.\n", debug_num, log_signal(sink));
-			}
-
-			pool<RTLIL::SigBit> subgraph = find_subgraph(sink);
-
-			int p = 1;
-			for (auto subgraph_node : subgraph)
-				p = max(p, labels[subgraph_node]);
-
-			FlowGraph flow_graph = build_flow_graph(sink, p);
-			int flow = flow_graph.maximum_flow(order);
-			pool<RTLIL::SigBit> x, xi;
-			if (flow <= order)
-			{
-				labels[sink] = p;
-				auto cut = flow_graph.edge_cut();
-				x = cut.first;
-				xi = cut.second;
-			}
-			else
-			{
-				labels[sink] = p + 1;
-				x = subgraph;
-				x.erase(sink);
-				xi.insert(sink);
-			}
-			lut_gates[sink] = xi;
-
-			pool<RTLIL::SigBit> k;
-			for (auto xi_node : xi)
-			{
-				for (auto xi_node_pred : edges_bw[xi_node])
-					if (x[xi_node_pred])
-						k.insert(xi_node_pred);
-			}
-			log_assert((int)k.size() <= order);
-			lut_edges_bw[sink] = k;
-			for (auto k_node : k)
-				lut_edges_fw[k_node].insert(sink);
-
-			if (debug)
-			{
-				log("  Maximum flow: %d. Assigned label %d.\n", flow, labels[sink]);
-				dump_dot_graph(stringf("flowmap-%d-sub.dot", debug_num), GraphMode::Cut, subgraph, {}, {}, {x, xi});
-				log("  Dumped subgraph to `flowmap-%d-sub.dot`.\n", debug_num);
-				flow_graph.dump_dot_graph(stringf("flowmap-%d-flow.dot", debug_num));
-				log("  Dumped flow graph to `flowmap-%d-flow.dot`.\n", debug_num);
-				log("    LUT inputs:");
-				for (auto k_node : k)
-					log(" %s", log_signal(k_node));
-				log(".\n");
-				log("    LUT packed gates:");
-				for (auto xi_node : xi)
-					log(" %s", log_signal(xi_node));
-				log(".\n");
-			}
-
-			for (auto sink_succ : edges_fw[sink])
-				worklist.insert(sink_succ);
+			level.swap(next_level);
 		}
 
+		label_preds.clear();
+		label_inputs.clear();
+
 		if (debug)
 		{
 			dump_dot_graph("flowmap-labeled.dot", GraphMode::Label);
@@ -882,6 +937,15 @@ struct FlowmapWorker
 		return {gate_inputs, other_inputs};
 	}
 
+	const pair<pool<RTLIL::SigBit>, pool<RTLIL::SigBit>> &cached_cut_lut_at_gate(RTLIL::SigBit lut, RTLIL::SigBit lut_gate)
+	{
+		auto &cuts = lut_cuts[lut];
+		auto it = cuts.find(lut_gate);
+		if (it == cuts.end())
+			it = cuts.insert({lut_gate, cut_lut_at_gate(lut, lut_gate)}).first;
+		return it->second;
+	}
+
 	void compute_lut_distances(dict<RTLIL::SigBit, int> &lut_distances, bool forward,
 	                          pool<RTLIL::SigBit> initial = {}, pool<RTLIL::SigBit> *changed = nullptr)
 	{
@@ -1051,8 +1115,8 @@ struct FlowmapWorker
 
 				int r_ex, r_im, r_slk;
 
-				auto cut_inputs = cut_lut_at_gate(lut, lut_gate);
-				pool<RTLIL::SigBit> gate_inputs = cut_inputs.first, other_inputs = cut_inputs.second;
+				auto &cut_inputs = cached_cut_lut_at_gate(lut, lut_gate);
+				const pool<RTLIL::SigBit> &gate_inputs = cut_inputs.first, &other_inputs = cut_inputs.second;
 				if (gate_inputs.empty() && (int)other_inputs.size() >= order)
 				{
 					if (debug_relax)
@@ -1252,8 +1316,9 @@ struct FlowmapWorker
 				log("    Removing breaking gate %s from LUT.\n", log_signal(breaking_gate));
 			lut_gates[breaking_lut].erase(breaking_gate);
 
-			auto cut_inputs = cut_lut_at_gate(breaking_lut, breaking_gate);
+			auto cut_inputs = cached_cut_lut_at_gate(breaking_lut, breaking_gate);
 			pool<RTLIL::SigBit> gate_inputs = cut_inputs.first, other_inputs = cut_inputs.second;
+			lut_cuts.erase(breaking_lut);
 
 			pool<RTLIL::SigBit> worklist = lut_gates[breaking_lut];
 			pool<RTLIL::SigBit> elim_gates = gate_inputs;
@@ -1484,6 +1549,9 @@ struct FlowmapPass : public Pass {
 		log("be evaluated with the `eval` pass, including cells with multiple output ports\n");
 		log("and multi-bit input and output ports.\n");
 		log("\n");
+		log("Cells on the same topological level are labeled in parallel, using as many\n");
+		log("threads as set with 'yosys -j' (except with -debug).\n");
+		log("\n");
 		log("    -maxlut k\n");
 		log("        perform technology mapping for a k-LUT architecture. if not specified,\n");
 		log("        defaults to 3.\n");
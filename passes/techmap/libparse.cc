@@ -26,8 +26,16 @@
 #include <iostream>
 #include <sstream>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #ifndef FILTERLIB
 #include "kernel/log.h"
+#include "kernel/contenthash.h"
 #endif
 
 using namespace Yosys;
@@ -232,20 +240,19 @@ int LibertyParser::lexer(std::string &str)
 
 	// eat whitespace
 	do {
-		c = f.get();
+		c = get();
 	} while (c == ' ' || c == '\t' || c == '\r');
 
 	// search for identifiers, numbers, plus or minus.
 	if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '_' || c == '-' || c == '+' || c == '.') {
-		str = static_cast<char>(c);
+		size_t start = pos - 1;
 		while (1) {
-			c = f.get();
-			if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '_' || c == '-' || c == '+' || c == '.')
-				str += c;
-			else
+			c = get();
+			if (!(('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '_' || c == '-' || c == '+' || c == '.'))
 				break;
 		}
-		f.unget();
+		unget();
+		str.assign(data + start, pos - start);
 		if (str == "+" || str == "-") {
 			/* Single operator is not an identifier */
 			// fprintf(stderr, "LEX: char >>%s<<\n", str.c_str());
@@ -264,55 +271,53 @@ int LibertyParser::lexer(std::string &str)
 #ifdef FILTERLIB
 		str += c;
 #endif
-		while (1) {
-			c = f.get();
-			if (c == '\n')
-				line++;
-			if (c == '"') {
+		const char *end = pos < size ? (const char*)memchr(data + pos, '"', size - pos) : nullptr;
+		if (end == nullptr)
+			error("Unterminated string.");
+		size_t len = end - (data + pos);
+		str.append(data + pos, len);
+		line += std::count(data + pos, end, '\n');
+		pos += len + 1;
 #ifdef FILTERLIB
-				str += c;
+		str += '"';
 #endif
-				break;
-			}
-			str += c;
-		}
 		// fprintf(stderr, "LEX: string >>%s<<\n", str.c_str());
 		return 'v';
 	}
 
 	// if it wasn't a string, perhaps it's a comment or a forward slash?
 	if (c == '/') {
-		c = f.get();
+		c = get();
 		if (c == '*') {         // start of '/*' block comment
 			int last_c = 0;
 			while (c > 0 && (last_c != '*' || c != '/')) {
 				last_c = c;
-				c = f.get();
+				c = get();
 				if (c == '\n')
 					line++;
 			}
 			return lexer(str);
 		} else if (c == '/') {  // start of '//' line comment
 			while (c > 0 && c != '\n')
-				c = f.get();
+				c = get();
 			line++;
 			return lexer(str);
 		}
-		f.unget();
+		unget();
 		// fprintf(stderr, "LEX: char >>/<<\n");
 		return '/';             // a single '/' charater.
 	}
 
 	// check for a backslash
 	if (c == '\\') {
-		c = f.get();		
+		c = get();		
 		if (c == '\r')
-			c = f.get();
+			c = get();
 		if (c == '\n') {
 			line++;
 			return lexer(str);
 		}
-		f.unget();
+		unget();
 		return '\\';
 	}
 
@@ -332,7 +337,314 @@ int LibertyParser::lexer(std::string &str)
 	return c;
 }
 
-LibertyAst *LibertyParser::parse()
+#ifndef _WIN32
+static const char *map_file(const std::string &filename, size_t &length)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+	struct stat st;
+	void *addr = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		length = st.st_size;
+		addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (addr == MAP_FAILED)
+		return nullptr;
+	madvise(addr, length, MADV_SEQUENTIAL);
+	return static_cast<const char*>(addr);
+}
+#endif
+
+void LibertyParser::read_stream(std::istream &f)
+{
+	std::stringstream buffer;
+	buffer << f.rdbuf();
+	text = buffer.str();
+	data = text.data();
+	size = text.size();
+}
+
+void LibertyParser::unmap_file()
+{
+#ifndef _WIN32
+	if (mapping != nullptr)
+		munmap(mapping, mapping_size);
+#endif
+	mapping = nullptr;
+}
+
+LibertyParser::LibertyParser(std::istream &f, const LibertyFilter *filter) :
+		data(nullptr), size(0), pos(0), mapping(nullptr), mapping_size(0), line(1)
+{
+#ifndef FILTERLIB
+	this->filter = filter;
+#else
+	(void)filter;
+#endif
+	read_stream(f);
+	ast = parse();
+}
+
+#ifndef FILTERLIB
+
+// The binary cache stores the AST in pre-order: id, value, the args and the
+// number of children for each node. Entries are keyed by the name and contents
+// of the parsed file.
+static const char liberty_cache_magic[] = "yosys-liberty-cache 1\n";
+
+static std::string liberty_cache_filename(const std::string &filename, const std::string &cache_dir, const LibertyFilter *filter)
+{
+	std::string file_key = file_content_key(filename);
+	if (file_key.empty())
+		return std::string();
+	std::string key = liberty_cache_magic + file_key + "\n";
+	if (filter != nullptr)
+		key += filter->key();
+	return cache_dir + "/" + content_hash(key) + ".libcache";
+}
+
+static void write_cache_uint(std::ostream &f, uint32_t value)
+{
+	f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void write_cache_string(std::ostream &f, const std::string &str)
+{
+	write_cache_uint(f, GetSize(str));
+	f.write(str.data(), str.size());
+}
+
+static void write_cache_ast(std::ostream &f, const LibertyAst *ast)
+{
+	write_cache_string(f, ast->id);
+	write_cache_string(f, ast->value);
+	write_cache_uint(f, GetSize(ast->args));
+	for (auto &arg : ast->args)
+		write_cache_string(f, arg);
+	write_cache_uint(f, GetSize(ast->children));
+	for (auto child : ast->children)
+		write_cache_ast(f, child);
+}
+
+static bool read_cache_uint(const char *data, size_t size, size_t &pos, uint32_t &value)
+{
+	if (size - pos < sizeof(value))
+		return false;
+	memcpy(&value, data + pos, sizeof(value));
+	pos += sizeof(value);
+	return true;
+}
+
+static bool read_cache_string(const char *data, size_t size, size_t &pos, std::string &str)
+{
+	uint32_t len;
+	if (!read_cache_uint(data, size, pos, len) || size - pos < len)
+		return false;
+	str.assign(data + pos, len);
+	pos += len;
+	return true;
+}
+
+static bool read_cache_ast(const char *data, size_t size, size_t &pos, LibertyAst *ast)
+{
+	uint32_t count;
+	if (!read_cache_string(data, size, pos, ast->id) || !read_cache_string(data, size, pos, ast->value))
+		return false;
+	if (!read_cache_uint(data, size, pos, count))
+		return false;
+	ast->args.resize(count);
+	for (auto &arg : ast->args)
+		if (!read_cache_string(data, size, pos, arg))
+			return false;
+	if (!read_cache_uint(data, size, pos, count))
+		return false;
+	ast->children.reserve(count);
+	for (uint32_t i = 0; i < count; i++) {
+		ast->children.push_back(new LibertyAst);
+		if (!read_cache_ast(data, size, pos, ast->children.back()))
+			return false;
+	}
+	return true;
+}
+
+static LibertyAst *load_liberty_cache(const std::string &cache_filename)
+{
+	std::ifstream f(cache_filename, std::ifstream::binary);
+	if (f.fail())
+		return nullptr;
+	std::stringstream buffer;
+	buffer << f.rdbuf();
+	std::string data = buffer.str();
+
+	size_t pos = sizeof(liberty_cache_magic) - 1;
+	if (data.compare(0, pos, liberty_cache_magic) != 0)
+		return nullptr;
+	uint32_t has_ast;
+	if (!read_cache_uint(data.data(), data.size(), pos, has_ast))
+		return nullptr;
+	if (!has_ast)
+		return nullptr;
+	LibertyAst *ast = new LibertyAst;
+	if (!read_cache_ast(data.data(), data.size(), pos, ast) || pos != data.size()) {
+		log_warning("Ignoring corrupt liberty cache entry %s.\n", cache_filename.c_str());
+		delete ast;
+		return nullptr;
+	}
+	return ast;
+}
+
+static void store_liberty_cache(const LibertyAst *ast, const std::string &cache_filename, const std::string &cache_dir)
+{
+	if (!create_directory(cache_dir)) {
+		log_warning("Failed to create liberty cache directory %s.\n", cache_dir.c_str());
+		return;
+	}
+
+	bool ok = write_file_atomically(cache_filename, [&](std::ostream &f) {
+		f << liberty_cache_magic;
+		write_cache_uint(f, ast != nullptr);
+		if (ast != nullptr)
+			write_cache_ast(f, ast);
+	});
+	if (!ok)
+		log_warning("Failed to write liberty cache entry %s.\n", cache_filename.c_str());
+}
+
+#endif
+
+LibertyParser::LibertyParser(const std::string &filename, const std::string &cache_dir, const LibertyFilter *filter) :
+		data(nullptr), size(0), pos(0), mapping(nullptr), mapping_size(0), line(1), ast(nullptr)
+{
+	std::string cache_filename;
+#ifndef FILTERLIB
+	this->filter = filter;
+	if (!cache_dir.empty()) {
+		cache_filename = liberty_cache_filename(filename, cache_dir, filter);
+		if (!cache_filename.empty()) {
+			ast = load_liberty_cache(cache_filename);
+			if (ast != nullptr) {
+				log("Loaded liberty file `%s' from cache.\n", filename.c_str());
+				return;
+			}
+		}
+	}
+#else
+	(void)cache_dir;
+	(void)filter;
+#endif
+
+#ifndef _WIN32
+	data = map_file(filename, size);
+	if (data != nullptr) {
+		mapping = const_cast<char*>(data);
+		mapping_size = size;
+	} else
+#endif
+	{
+		std::ifstream f(filename.c_str());
+		if (f.fail()) {
+#ifndef FILTERLIB
+			log_cmd_error("Can't open liberty file `%s': %s\n", filename.c_str(), strerror(errno));
+#else
+			fprintf(stderr, "Can't open liberty file `%s': %s\n", filename.c_str(), strerror(errno));
+			exit(1);
+#endif
+		}
+		read_stream(f);
+	}
+
+	ast = parse();
+	unmap_file();
+	text.clear();
+
+#ifndef FILTERLIB
+	if (!cache_filename.empty())
+		store_liberty_cache(ast, cache_filename, cache_dir);
+#endif
+}
+
+#ifndef FILTERLIB
+
+bool LibertyFilter::match_cell(const std::string &name) const
+{
+	if (all_cells || cell_names.count(name))
+		return true;
+	for (auto &pattern : cell_patterns)
+		if (patmatch(pattern.c_str(), name.c_str()))
+			return true;
+	return false;
+}
+
+std::string LibertyFilter::key() const
+{
+	std::vector<std::string> groups(skip_groups.begin(), skip_groups.end());
+	std::sort(groups.begin(), groups.end());
+	std::string key = "skip";
+	for (auto &group : groups)
+		key += " " + group;
+	if (!all_cells) {
+		std::vector<std::string> names(cell_names.begin(), cell_names.end());
+		std::sort(names.begin(), names.end());
+		key += "\ncells";
+		for (auto &name : names)
+			key += " " + name;
+		key += "\npatterns";
+		for (auto &pattern : cell_patterns)
+			key += " " + pattern;
+	}
+	return key + "\n";
+}
+
+pool<std::string> LibertyFilter::timing_groups()
+{
+	return {"timing", "internal_power", "leakage_power", "leakage_current", "dynamic_current",
+			"receiver_capacitance", "intrinsic_parasitic", "ccsn_first_stage", "ccsn_last_stage"};
+}
+
+bool LibertyParser::skip_group(const LibertyAst *ast, int depth) const
+{
+	if (filter == nullptr || depth == 0)
+		return false;
+	if (filter->skip_groups.count(ast->id))
+		return true;
+	return depth == 1 && ast->id == "cell" && ast->args.size() == 1 && !filter->match_cell(ast->args[0]);
+}
+
+// skip to the '}' matching an already consumed '{' without tokenizing
+void LibertyParser::skip_block()
+{
+	int level = 1;
+	while (pos < size) {
+		char c = data[pos++];
+		if (c == '\n') {
+			line++;
+		} else if (c == '"') {
+			const char *end = (const char*)memchr(data + pos, '"', size - pos);
+			size_t len = end ? end - (data + pos) + 1 : size - pos;
+			line += std::count(data + pos, data + pos + len, '\n');
+			pos += len;
+		} else if (c == '/' && pos < size && data[pos] == '*') {
+			size_t end = std::string_view(data, size).find("*/", pos + 1);
+			end = end == std::string_view::npos ? size : end + 2;
+			line += std::count(data + pos, data + end, '\n');
+			pos = end;
+		} else if (c == '/' && pos < size && data[pos] == '/') {
+			const char *end = (const char*)memchr(data + pos, '\n', size - pos);
+			pos = end ? end - data : size;
+		} else if (c == '{') {
+			level++;
+		} else if (c == '}') {
+			if (--level == 0)
+				return;
+		}
+	}
+}
+
+#endif
+
+LibertyAst *LibertyParser::parse(int depth)
 {
 	std::string str;
 
@@ -486,10 +798,24 @@ LibertyAst *LibertyParser::parse()
 		}
 
 		if (tok == '{') {
+#ifndef FILTERLIB
+			if (skip_group(ast, depth)) {
+				skip_block();
+				skipped = true;
+				break;
+			}
+#endif
 			while (1) {
-				LibertyAst *child = parse();
+				LibertyAst *child = parse(depth + 1);
 				if (child == NULL)
 					break;
+#ifndef FILTERLIB
+				if (skipped) {
+					skipped = false;
+					delete child;
+					continue;
+				}
+#endif
 				ast->children.push_back(child);
 			}
 			break;
@@ -516,6 +842,60 @@ void LibertyParser::error(const std::string &str) const
 	log_error("%s", ss.str().c_str());
 }
 
+const dict<std::string, LibertyCellInfo> &Yosys::liberty_cell_info(const std::string &filename, const std::string &cache_dir)
+{
+	static dict<std::string, dict<std::string, LibertyCellInfo>> cell_info_cache;
+
+	std::string key = filename + "\n" + file_content_key(filename);
+
+	auto it = cell_info_cache.find(key);
+	if (it != cell_info_cache.end()) {
+		log("Using cached cell data of liberty file `%s'.\n", filename.c_str());
+		return it->second;
+	}
+
+	LibertyFilter filter;
+	filter.skip_groups = LibertyFilter::timing_groups();
+	LibertyParser parser(filename, cache_dir, &filter);
+
+	dict<std::string, LibertyCellInfo> cells;
+	for (auto cell : parser.ast->children)
+	{
+		if (cell->id != "cell" || cell->args.size() != 1)
+			continue;
+
+		LibertyCellInfo &info = cells[cell->args[0]];
+		const LibertyAst *ar = cell->find("area");
+		if (ar != nullptr && !ar->value.empty()) {
+			info.area = atof(ar->value.c_str());
+			info.has_area = true;
+		}
+		const LibertyAst *leakage = cell->find("cell_leakage_power");
+		if (leakage != nullptr)
+			info.leakage = atof(leakage->value.c_str());
+		info.is_sequential = cell->find("ff") != nullptr;
+
+		std::vector<const LibertyAst*> pins;
+		for (auto child : cell->children) {
+			if (child->id == "pin")
+				pins.push_back(child);
+			else if (child->id == "bus" || child->id == "bundle")
+				for (auto pin : child->children)
+					if (pin->id == "pin")
+						pins.push_back(pin);
+		}
+		for (auto pin : pins) {
+			const LibertyAst *cap = pin->find("capacitance");
+			if (cap == nullptr)
+				continue;
+			for (auto &name : pin->args)
+				info.pin_capacitance[name] = atof(cap->value.c_str());
+		}
+	}
+
+	return cell_info_cache[key] = std::move(cells);
+}
+
 #else
 
 void LibertyParser::error() const
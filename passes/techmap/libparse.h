@@ -90,13 +90,59 @@ namespace Yosys
 		bool eval(dict<std::string, bool>& values);
 	};
 
+#ifndef FILTERLIB
+	// Restricts the parts of a liberty file that are loaded. Groups named in
+	// skip_groups are skipped by the lexer without building an AST for them.
+	// Unless all_cells is set, only cells listed in cell_names or matching one
+	// of the patterns in cell_patterns are loaded.
+	struct LibertyFilter
+	{
+		pool<std::string> skip_groups;
+		bool all_cells = true;
+		pool<std::string> cell_names;
+		std::vector<std::string> cell_patterns;
+
+		bool match_cell(const std::string &name) const;
+		std::string key() const;
+
+		// timing and power groups, which none of the commands reading liberty
+		// files use
+		static pool<std::string> timing_groups();
+	};
+#else
+	// yosys-filterlib is built without the kernel, so it doesn't support filters,
+	// which need hashlib
+	struct LibertyFilter;
+#endif
+
 	class LibertyMergedCells;
 	class LibertyParser
 	{
 		friend class LibertyMergedCells;
 	private:
-		std::istream &f;
+		// the text being parsed, either copied from a stream into text or
+		// memory-mapped from a file
+		std::string text;
+		const char *data;
+		size_t size, pos;
+		void *mapping;
+		size_t mapping_size;
 		int line;
+#ifndef FILTERLIB
+		const LibertyFilter *filter = nullptr;
+		bool skipped = false;
+#endif
+
+		int get() {
+			if (pos < size)
+				return (unsigned char)data[pos++];
+			pos++;
+			return EOF;
+		}
+		void unget() { pos--; }
+
+		void read_stream(std::istream &f);
+		void unmap_file();
 
 		/* lexer return values:
 		   'v': identifier, string, array range [...] -> str holds the token string
@@ -105,15 +151,24 @@ namespace Yosys
 		*/
 		int lexer(std::string &str);
 
-		LibertyAst *parse();
+		LibertyAst *parse(int depth = 0);
+#ifndef FILTERLIB
+		bool skip_group(const LibertyAst *ast, int depth) const;
+		void skip_block();
+#endif
 		void error() const;
 		void error(const std::string &str) const;
 
 	public:
 		const LibertyAst *ast;
 
-		LibertyParser(std::istream &f) : f(f), line(1), ast(parse()) {}
-		~LibertyParser() { if (ast) delete ast; }
+		LibertyParser(std::istream &f, const LibertyFilter *filter = nullptr);
+
+		// Parse the file with the given name, which is memory-mapped when
+		// possible. If cache_dir is not empty, the parsed AST is stored in
+		// and loaded from a binary cache in that directory.
+		LibertyParser(const std::string &filename, const std::string &cache_dir = std::string(), const LibertyFilter *filter = nullptr);
+		~LibertyParser() { if (ast) delete ast; unmap_file(); }
 	};
 
 	class LibertyMergedCells
@@ -144,6 +199,23 @@ namespace Yosys
 		}
 	};
 
+	// The data of a liberty cell that commands estimating area, power or
+	// load need, without the rest of its AST.
+	struct LibertyCellInfo
+	{
+		double area = 0;
+		bool has_area = false;
+		double leakage = 0;
+		bool is_sequential = false;
+		dict<std::string, double> pin_capacitance;
+	};
+
+	// Return the cell data of a liberty file. Files are parsed once (with
+	// the timing and power groups skipped) and kept for the rest of the
+	// session, keyed by the file name and contents, so
+	// repeated calls e.g. of `stat -liberty` don't parse the file again.
+	const dict<std::string, LibertyCellInfo> &liberty_cell_info(const std::string &filename, const std::string &cache_dir = std::string());
+
 }
 
 #endif
@@ -45,6 +45,8 @@ struct MuxcoverWorker
 	{
 		SigBit root;
 		dict<SigBit, Cell*> muxes;
+		// the sigmapped A, B and S inputs of the muxes
+		dict<SigBit, std::array<SigBit, 3>> mux_inputs;
 		dict<SigBit, newmux_t> newmuxes;
 	};
 
@@ -140,9 +142,11 @@ struct MuxcoverWorker
 				SigBit bit = wavefront.pop();
 				if (sig_to_mux.count(bit) && (bit == rootsig || !roots.count(bit))) {
 					Cell *c = sig_to_mux.at(bit);
+					SigBit a = sigmap(c->getPort(ID::A)), b = sigmap(c->getPort(ID::B));
 					tree.muxes[bit] = c;
-					wavefront.insert(sigmap(c->getPort(ID::A)));
-					wavefront.insert(sigmap(c->getPort(ID::B)));
+					tree.mux_inputs[bit] = {a, b, sigmap(c->getPort(ID::S))};
+					wavefront.insert(a);
+					wavefront.insert(b);
 				}
 			}
 
@@ -155,10 +159,11 @@ struct MuxcoverWorker
 		log("    Finished treeification: Found %d trees.\n", GetSize(tree_list));
 	}
 
-	bool follow_muxtree(SigBit &ret_bit, tree_t &tree, SigBit bit, const char *path, bool first_layer = true)
+	bool follow_muxtree(SigBit &ret_bit, const tree_t &tree, SigBit bit, const char *path, bool first_layer = true)
 	{
 		if (*path) {
-			if (tree.muxes.count(bit) == 0) {
+			auto it = tree.mux_inputs.find(bit);
+			if (it == tree.mux_inputs.end()) {
 				if (first_layer || nopartial)
 					return false;
 				while (path[0] && path[1])
@@ -169,8 +174,8 @@ struct MuxcoverWorker
 					ret_bit = bit;
 				return true;
 			}
-			char port_name[3] = {'\\', *path, 0};
-			return follow_muxtree(ret_bit, tree, sigmap(tree.muxes.at(bit)->getPort(port_name)), path+1, false);
+			int port = *path == 'A' ? 0 : *path == 'B' ? 1 : 2;
+			return follow_muxtree(ret_bit, tree, it->second[port], path+1, false);
 		} else {
 			ret_bit = bit;
 			return true;
@@ -234,7 +239,10 @@ struct MuxcoverWorker
 	int sum_best_covers(tree_t &tree, const vector<SigBit> &bits)
 	{
 		int sum = 0;
-		for (auto bit : pool<SigBit>(bits.begin(), bits.end())) {
+		for (auto it = bits.begin(); it != bits.end(); it++) {
+			SigBit bit = *it;
+			if (std::find(bits.begin(), it, bit) != it)
+				continue;
 			int cost = tree.newmuxes.at(bit).cost;
 			log_debug("        Best cost for %s: %d\n", log_signal(bit), cost);
 			sum += cost;
@@ -498,13 +506,49 @@ struct MuxcoverWorker
 		return best_mux.cost;
 	}
 
-	void implement_best_cover(tree_t &tree, SigBit bit, int count_muxes_by_type[4])
+	// Finds the best covers for all muxes of the tree in the order in which
+	// find_best_cover() would recurse into them from the root (inputs before
+	// the mux, A before B), but with an explicit stack, so that deep trees
+	// don't recurse deeply. The order matters because the decoder muxes are
+	// shared between the covers.
+	void find_tree_covers(tree_t &tree)
 	{
-		newmux_t mux = tree.newmuxes.at(bit);
+		vector<pair<SigBit, int>> stack;
+		stack.emplace_back(tree.root, 0);
+		while (!stack.empty()) {
+			SigBit bit = stack.back().first;
+			auto it = tree.mux_inputs.find(bit);
+			if (it != tree.mux_inputs.end() && stack.back().second < 2) {
+				SigBit inbit = it->second[stack.back().second++];
+				if (!tree.newmuxes.count(inbit))
+					stack.emplace_back(inbit, 0);
+				continue;
+			}
+			stack.pop_back();
+			find_best_cover(tree, bit);
+		}
+	}
 
-		for (auto inbit : mux.inputs)
-			implement_best_cover(tree, inbit, count_muxes_by_type);
+	void implement_tree_cover(tree_t &tree, int count_muxes_by_type[4])
+	{
+		// inputs before the muxes that use them, with an explicit stack
+		// for the same reason as in find_tree_covers()
+		vector<pair<SigBit, int>> stack;
+		stack.emplace_back(tree.root, 0);
+		while (!stack.empty()) {
+			SigBit bit = stack.back().first;
+			const newmux_t &mux = tree.newmuxes.at(bit);
+			if (stack.back().second < GetSize(mux.inputs)) {
+				stack.emplace_back(mux.inputs[stack.back().second++], 0);
+				continue;
+			}
+			stack.pop_back();
+			implement_best_cover(bit, mux, count_muxes_by_type);
+		}
+	}
 
+	void implement_best_cover(SigBit bit, const newmux_t &mux, int count_muxes_by_type[4])
+	{
 		for (auto selbit : mux.selects)
 			implement_decode_mux(selbit);
 
@@ -586,8 +630,8 @@ struct MuxcoverWorker
 	{
 		int count_muxes_by_type[4] = {0, 0, 0, 0};
 		log_debug("    Searching for best cover for tree at %s.\n", log_signal(tree.root));
-		find_best_cover(tree, tree.root);
-		implement_best_cover(tree, tree.root, count_muxes_by_type);
+		find_tree_covers(tree);
+		implement_tree_cover(tree, count_muxes_by_type);
 		log("    Replaced tree at %s: %d MUX2, %d MUX4, %d MUX8, %d MUX16\n", log_signal(tree.root),
 				count_muxes_by_type[0], count_muxes_by_type[1], count_muxes_by_type[2], count_muxes_by_type[3]);
 		for (auto &it : tree.muxes)
@@ -605,7 +649,7 @@ struct MuxcoverWorker
 		if (!nodecode) {
 			log_debug("    Populating cache of decoder muxes.\n");
 			for (auto &tree : tree_list) {
-				find_best_cover(tree, tree.root);
+				find_tree_covers(tree);
 				tree.newmuxes.clear();
 			}
 		}
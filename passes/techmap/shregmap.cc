@@ -103,10 +103,16 @@ struct ShregmapWorker
 	pool<Cell*> remove_cells;
 
 	FfInitVals initvals;
-	dict<SigBit, Cell*> sigbit_chain_next;
-	dict<SigBit, Cell*> sigbit_chain_prev;
+	dict<SigBit, int> sigbit_chain_next;
+	dict<SigBit, int> sigbit_chain_prev;
 	pool<SigBit> sigbit_with_non_chain_users;
-	pool<Cell*> chain_start_cells;
+
+	// the FFs that can be part of a chain, by dense index, the index of the
+	// FF that each one drives (or -1), and which of them start a chain
+	vector<Cell*> chain_cells;
+	vector<int> chain_next;
+	vector<bool> chain_start;
+	vector<int> chain_start_cells;
 
 	void make_sigbit_chain_next_prev()
 	{
@@ -131,7 +137,10 @@ struct ShregmapWorker
 
 				if (opts.init || initval == State::Sx || (opts.zinit && initval == State::S0))
 				{
-					auto r = sigbit_chain_next.insert(std::make_pair(d_bit, cell));
+					int index = GetSize(chain_cells);
+					chain_cells.push_back(cell);
+
+					auto r = sigbit_chain_next.insert(std::make_pair(d_bit, index));
 					if (!r.second) {
 						// Insertion not successful means that d_bit is already
 						// connected to another register, thus mark it as a
@@ -145,10 +154,10 @@ struct ShregmapWorker
 						Wire *wire = module->addWire(NEW_ID);
 						module->connect(wire, d_bit);
 						sigmap.add(wire, d_bit);
-						sigbit_chain_next.insert(std::make_pair(wire, cell));
+						sigbit_chain_next.insert(std::make_pair(wire, index));
 					}
 
-					sigbit_chain_prev[q_bit] = cell;
+					sigbit_chain_prev[q_bit] = index;
 					continue;
 				}
 			}
@@ -158,10 +167,48 @@ struct ShregmapWorker
 					for (auto bit : sigmap(conn.second))
 						sigbit_with_non_chain_users.insert(bit);
 		}
+
+		chain_next.resize(GetSize(chain_cells));
+		for (int i = 0; i < GetSize(chain_cells); i++) {
+			Cell *cell = chain_cells[i];
+			IdString q_port = opts.ffcells.at(cell->type).second;
+			auto it = sigbit_chain_next.find(sigmap(cell->getPort(q_port).as_bit()));
+			chain_next[i] = it != sigbit_chain_next.end() ? it->second : -1;
+		}
+	}
+
+	// true if the two FFs differ only in their data input and output
+	bool same_ff_controls(Cell *c1, Cell *c2)
+	{
+		if (c1->type != c2->type)
+			return false;
+
+		if (c1->parameters != c2->parameters)
+			return false;
+
+		IdString d_port = opts.ffcells.at(c1->type).first;
+		IdString q_port = opts.ffcells.at(c1->type).second;
+
+		int count = 0;
+		for (auto &conn : c1->connections()) {
+			if (conn.first == d_port || conn.first == q_port)
+				continue;
+			auto it = c2->connections().find(conn.first);
+			if (it == c2->connections().end() || it->second != conn.second)
+				return false;
+			count++;
+		}
+		for (auto &conn : c2->connections())
+			if (conn.first != d_port && conn.first != q_port)
+				count--;
+
+		return count == 0;
 	}
 
 	void find_chain_start_cells()
 	{
+		chain_start.resize(GetSize(chain_cells));
+
 		for (auto it : sigbit_chain_next)
 		{
 			if (opts.tech == nullptr && sigbit_with_non_chain_users.count(it.first))
@@ -169,55 +216,27 @@ struct ShregmapWorker
 
 			if (sigbit_chain_prev.count(it.first) != 0)
 			{
-				Cell *c1 = sigbit_chain_prev.at(it.first);
-				Cell *c2 = it.second;
-
-				if (c1->type != c2->type)
-					goto start_cell;
-
-				if (c1->parameters != c2->parameters)
-					goto start_cell;
-
-				IdString d_port = opts.ffcells.at(c1->type).first;
-				IdString q_port = opts.ffcells.at(c1->type).second;
-
-				auto c1_conn = c1->connections();
-				auto c2_conn = c2->connections();
-
-				c1_conn.erase(d_port);
-				c1_conn.erase(q_port);
-
-				c2_conn.erase(d_port);
-				c2_conn.erase(q_port);
-
-				if (c1_conn != c2_conn)
+				if (!same_ff_controls(chain_cells[sigbit_chain_prev.at(it.first)], chain_cells[it.second]))
 					goto start_cell;
 
 				continue;
 			}
 
 		start_cell:
-			chain_start_cells.insert(it.second);
+			chain_start[it.second] = true;
+			chain_start_cells.push_back(it.second);
 		}
 	}
 
-	vector<Cell*> create_chain(Cell *start_cell)
+	vector<Cell*> create_chain(int start_index)
 	{
 		vector<Cell*> chain;
 
-		Cell *c = start_cell;
-		while (c != nullptr)
-		{
-			chain.push_back(c);
-
-			IdString q_port = opts.ffcells.at(c->type).second;
-			SigBit q_bit = sigmap(c->getPort(q_port).as_bit());
-
-			if (sigbit_chain_next.count(q_bit) == 0)
-				break;
-
-			c = sigbit_chain_next.at(q_bit);
-			if (chain_start_cells.count(c) != 0)
+		int i = start_index;
+		while (1) {
+			chain.push_back(chain_cells[i]);
+			i = chain_next[i];
+			if (i < 0 || chain_start[i])
 				break;
 		}
 
@@ -347,12 +366,14 @@ struct ShregmapWorker
 
 	void cleanup()
 	{
-		for (auto cell : remove_cells)
-			module->remove(cell);
+		module->remove(remove_cells);
 
 		remove_cells.clear();
 		sigbit_chain_next.clear();
 		sigbit_chain_prev.clear();
+		chain_cells.clear();
+		chain_next.clear();
+		chain_start.clear();
 		chain_start_cells.clear();
 	}
 
@@ -363,8 +384,10 @@ struct ShregmapWorker
 		make_sigbit_chain_next_prev();
 		find_chain_start_cells();
 
-		for (auto c : chain_start_cells) {
-			vector<Cell*> chain = create_chain(c);
+		// last start cell first, the order in which they were processed
+		// when they were kept in a pool, so that the results don't change
+		for (int i = GetSize(chain_start_cells)-1; i >= 0; i--) {
+			vector<Cell*> chain = create_chain(chain_start_cells[i]);
 			process_chain(chain);
 		}
 
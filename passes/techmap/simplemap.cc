@@ -27,6 +27,26 @@
 USING_YOSYS_NAMESPACE
 YOSYS_NAMESPACE_BEGIN
 
+// Emits the fine-grained gates that replace one coarse-grain cell. All gates
+// get a copy of the src attribute of the cell (which shares its string), and
+// their names are generated from a prefix that is only formatted once.
+struct SimplemapGates
+{
+	RTLIL::Module *module;
+	std::string name_prefix;
+	RTLIL::Const src;
+
+	SimplemapGates(RTLIL::Module *module, RTLIL::Cell *cell, std::string name_prefix) :
+			module(module), name_prefix(std::move(name_prefix)), src(cell->attributes.at(ID::src, RTLIL::Const())) { }
+
+	RTLIL::Cell *add(RTLIL::IdString type)
+	{
+		RTLIL::Cell *gate = module->addCell(new_id_with_prefix(name_prefix), type);
+		gate->attributes[ID::src] = src;
+		return gate;
+	}
+};
+
 void simplemap_not(RTLIL::Module *module, RTLIL::Cell *cell)
 {
 	RTLIL::SigSpec sig_a = cell->getPort(ID::A);
@@ -34,9 +54,9 @@ void simplemap_not(RTLIL::Module *module, RTLIL::Cell *cell)
 
 	sig_a.extend_u0(GetSize(sig_y), cell->parameters.at(ID::A_SIGNED).as_bool());
 
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
 	for (int i = 0; i < GetSize(sig_y); i++) {
-		RTLIL::Cell *gate = module->addCell(NEW_ID, ID($_NOT_));
-		gate->attributes[ID::src] = cell->attributes[ID::src];
+		RTLIL::Cell *gate = gates.add(ID($_NOT_));
 		gate->setPort(ID::A, sig_a[i]);
 		gate->setPort(ID::Y, sig_y[i]);
 	}
@@ -79,9 +99,9 @@ void simplemap_bitop(RTLIL::Module *module, RTLIL::Cell *cell)
 	if (cell->type == ID($bweqx)) gate_type = ID($_XNOR_);
 	log_assert(!gate_type.empty());
 
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
 	for (int i = 0; i < GetSize(sig_y); i++) {
-		RTLIL::Cell *gate = module->addCell(NEW_ID, gate_type);
-		gate->attributes[ID::src] = cell->attributes[ID::src];
+		RTLIL::Cell *gate = gates.add(gate_type);
 		gate->setPort(ID::A, sig_a[i]);
 		gate->setPort(ID::B, sig_b[i]);
 		gate->setPort(ID::Y, sig_y[i]);
@@ -118,6 +138,7 @@ void simplemap_reduce(RTLIL::Module *module, RTLIL::Cell *cell)
 	if (cell->type == ID($reduce_bool)) gate_type = ID($_OR_);
 	log_assert(!gate_type.empty());
 
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
 	RTLIL::Cell *last_output_cell = NULL;
 
 	while (sig_a.size() > 1)
@@ -131,8 +152,7 @@ void simplemap_reduce(RTLIL::Module *module, RTLIL::Cell *cell)
 				continue;
 			}
 
-			RTLIL::Cell *gate = module->addCell(NEW_ID, gate_type);
-			gate->attributes[ID::src] = cell->attributes[ID::src];
+			RTLIL::Cell *gate = gates.add(gate_type);
 			gate->setPort(ID::A, sig_a[i]);
 			gate->setPort(ID::B, sig_a[i+1]);
 			gate->setPort(ID::Y, sig_t[i/2]);
@@ -144,8 +164,7 @@ void simplemap_reduce(RTLIL::Module *module, RTLIL::Cell *cell)
 
 	if (cell->type == ID($reduce_xnor)) {
 		RTLIL::SigSpec sig_t = module->addWire(NEW_ID);
-		RTLIL::Cell *gate = module->addCell(NEW_ID, ID($_NOT_));
-		gate->attributes[ID::src] = cell->attributes[ID::src];
+		RTLIL::Cell *gate = gates.add(ID($_NOT_));
 		gate->setPort(ID::A, sig_a);
 		gate->setPort(ID::Y, sig_t);
 		last_output_cell = gate;
@@ -161,6 +180,8 @@ void simplemap_reduce(RTLIL::Module *module, RTLIL::Cell *cell)
 
 static void logic_reduce(RTLIL::Module *module, RTLIL::SigSpec &sig, RTLIL::Cell *cell)
 {
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
+
 	while (sig.size() > 1)
 	{
 		RTLIL::SigSpec sig_t = module->addWire(NEW_ID, sig.size() / 2);
@@ -172,8 +193,7 @@ static void logic_reduce(RTLIL::Module *module, RTLIL::SigSpec &sig, RTLIL::Cell
 				continue;
 			}
 
-			RTLIL::Cell *gate = module->addCell(NEW_ID, ID($_OR_));
-			gate->attributes[ID::src] = cell->attributes[ID::src];
+			RTLIL::Cell *gate = gates.add(ID($_OR_));
 			gate->setPort(ID::A, sig[i]);
 			gate->setPort(ID::B, sig[i+1]);
 			gate->setPort(ID::Y, sig_t[i/2]);
@@ -201,8 +221,8 @@ void simplemap_lognot(RTLIL::Module *module, RTLIL::Cell *cell)
 		sig_y = sig_y.extract(0, 1);
 	}
 
-	RTLIL::Cell *gate = module->addCell(NEW_ID, ID($_NOT_));
-	gate->attributes[ID::src] = cell->attributes[ID::src];
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
+	RTLIL::Cell *gate = gates.add(ID($_NOT_));
 	gate->setPort(ID::A, sig_a);
 	gate->setPort(ID::Y, sig_y);
 }
@@ -230,8 +250,8 @@ void simplemap_logbin(RTLIL::Module *module, RTLIL::Cell *cell)
 	if (cell->type == ID($logic_or))  gate_type = ID($_OR_);
 	log_assert(!gate_type.empty());
 
-	RTLIL::Cell *gate = module->addCell(NEW_ID, gate_type);
-	gate->attributes[ID::src] = cell->attributes[ID::src];
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
+	RTLIL::Cell *gate = gates.add(gate_type);
 	gate->setPort(ID::A, sig_a);
 	gate->setPort(ID::B, sig_b);
 	gate->setPort(ID::Y, sig_y);
@@ -271,9 +291,9 @@ void simplemap_mux(RTLIL::Module *module, RTLIL::Cell *cell)
 	RTLIL::SigSpec sig_b = cell->getPort(ID::B);
 	RTLIL::SigSpec sig_y = cell->getPort(ID::Y);
 
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
 	for (int i = 0; i < GetSize(sig_y); i++) {
-		RTLIL::Cell *gate = module->addCell(NEW_ID, ID($_MUX_));
-		gate->attributes[ID::src] = cell->attributes[ID::src];
+		RTLIL::Cell *gate = gates.add(ID($_MUX_));
 		gate->setPort(ID::A, sig_a[i]);
 		gate->setPort(ID::B, sig_b[i]);
 		gate->setPort(ID::S, cell->getPort(ID::S));
@@ -288,9 +308,9 @@ void simplemap_bwmux(RTLIL::Module *module, RTLIL::Cell *cell)
 	RTLIL::SigSpec sig_s = cell->getPort(ID::S);
 	RTLIL::SigSpec sig_y = cell->getPort(ID::Y);
 
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
 	for (int i = 0; i < GetSize(sig_y); i++) {
-		RTLIL::Cell *gate = module->addCell(NEW_ID, ID($_MUX_));
-		gate->attributes[ID::src] = cell->attributes[ID::src];
+		RTLIL::Cell *gate = gates.add(ID($_MUX_));
 		gate->setPort(ID::A, sig_a[i]);
 		gate->setPort(ID::B, sig_b[i]);
 		gate->setPort(ID::S, sig_s[i]);
@@ -304,9 +324,9 @@ void simplemap_tribuf(RTLIL::Module *module, RTLIL::Cell *cell)
 	RTLIL::SigSpec sig_e = cell->getPort(ID::EN);
 	RTLIL::SigSpec sig_y = cell->getPort(ID::Y);
 
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
 	for (int i = 0; i < GetSize(sig_y); i++) {
-		RTLIL::Cell *gate = module->addCell(NEW_ID, ID($_TBUF_));
-		gate->attributes[ID::src] = cell->attributes[ID::src];
+		RTLIL::Cell *gate = gates.add(ID($_TBUF_));
 		gate->setPort(ID::A, sig_a[i]);
 		gate->setPort(ID::E, sig_e);
 		gate->setPort(ID::Y, sig_y[i]);
@@ -318,13 +338,13 @@ void simplemap_bmux(RTLIL::Module *module, RTLIL::Cell *cell)
 	SigSpec sel = cell->getPort(ID::S);
 	SigSpec data = cell->getPort(ID::A);
 	int width = GetSize(cell->getPort(ID::Y));
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
 
 	for (int idx = 0; idx < GetSize(sel); idx++) {
 		SigSpec new_data = module->addWire(NEW_ID, GetSize(data)/2);
 		for (int i = 0; i < GetSize(new_data); i += width) {
 			for (int k = 0; k < width; k++) {
-				RTLIL::Cell *gate = module->addCell(NEW_ID, ID($_MUX_));
-				gate->attributes[ID::src] = cell->attributes[ID::src];
+				RTLIL::Cell *gate = gates.add(ID($_MUX_));
 				gate->setPort(ID::A, data[i*2+k]);
 				gate->setPort(ID::B, data[i*2+width+k]);
 				gate->setPort(ID::S, sel[idx]);
@@ -342,12 +362,12 @@ void simplemap_lut(RTLIL::Module *module, RTLIL::Cell *cell)
 	SigSpec lut_ctrl = cell->getPort(ID::A);
 	SigSpec lut_data = cell->getParam(ID::LUT);
 	lut_data.extend_u0(1 << cell->getParam(ID::WIDTH).as_int());
+	SimplemapGates gates(module, cell, NEW_ID_PREFIX);
 
 	for (int idx = 0; GetSize(lut_data) > 1; idx++) {
 		SigSpec new_lut_data = module->addWire(NEW_ID, GetSize(lut_data)/2);
 		for (int i = 0; i < GetSize(lut_data); i += 2) {
-			RTLIL::Cell *gate = module->addCell(NEW_ID, ID($_MUX_));
-			gate->attributes[ID::src] = cell->attributes[ID::src];
+			RTLIL::Cell *gate = gates.add(ID($_MUX_));
 			gate->setPort(ID::A, lut_data[i]);
 			gate->setPort(ID::B, lut_data[i+1]);
 			gate->setPort(ID::S, lut_ctrl[idx]);
@@ -505,20 +525,47 @@ struct SimplemapPass : public Pass {
 		dict<IdString, void(*)(RTLIL::Module*, RTLIL::Cell*)> mappers;
 		simplemap_get_mappers(mappers);
 
-		for (auto mod : design->modules()) {
-			if (!design->selected(mod) || mod->get_blackbox_attribute())
-				continue;
-			std::vector<RTLIL::Cell*> cells = mod->cells();
-			for (auto cell : cells) {
+		std::vector<RTLIL::Module*> modules;
+		for (auto mod : design->modules())
+			if (design->selected(mod) && !mod->get_blackbox_attribute())
+				modules.push_back(mod);
+
+		// Collect the cells up front, so that the cell storage of each module and
+		// the string index can be sized for the gates that are about to be added.
+		// The widest port of a cell is an estimate of the number of its gates.
+		std::vector<std::vector<RTLIL::Cell*>> module_cells(GetSize(modules));
+		int total_gates = 0;
+		for (int i = 0; i < GetSize(modules); i++) {
+			RTLIL::Module *mod = modules[i];
+			int module_gates = 0;
+			for (auto cell : mod->cells()) {
 				if (mappers.count(cell->type) == 0)
 					continue;
 				if (!design->selected(mod, cell))
 					continue;
+				module_cells[i].push_back(cell);
+				int cell_gates = 0;
+				for (auto &conn : cell->connections())
+					cell_gates = max(cell_gates, GetSize(conn.second));
+				module_gates += cell_gates;
+			}
+			mod->cells_.reserve(mod->cells_.size() + module_gates);
+			total_gates += module_gates;
+		}
+		RTLIL::IdString::reserve(total_gates);
+
+		dict<RTLIL::Module*, int> module_index;
+		for (int i = 0; i < GetSize(modules); i++)
+			module_index[modules[i]] = i;
+
+		parallel_modules(design, modules, [&](RTLIL::Module *mod) {
+			RTLIL::Module::BatchScope batch(mod);
+			for (auto cell : module_cells[module_index.at(mod)]) {
 				log("Mapping %s.%s (%s).\n", log_id(mod), log_id(cell), log_id(cell->type));
 				mappers.at(cell->type)(mod, cell);
 				mod->remove(cell);
 			}
-		}
+		});
 	}
 } SimplemapPass;
 
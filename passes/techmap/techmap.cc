@@ -60,14 +60,37 @@ void apply_prefix(IdString prefix, RTLIL::SigSpec &sig, RTLIL::Module *module)
 	sig = chunks;
 }
 
+// A map file read by techmap, which is kept for the rest of the session so that the same file is not parsed again
+// by every techmap call (e.g. +/techmap.v, which is read by every call without -map). The templates derived from
+// its modules are kept as well, as they were before any _TECHMAP_DO_ commands ran on them.
+struct TechmapLibrary
+{
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Design *derived = new RTLIL::Design;
+	dict<std::pair<IdString, dict<IdString, RTLIL::Const>>, IdString> derived_names;
+
+	~TechmapLibrary() {
+		delete design;
+		delete derived;
+	}
+};
+
+// Keyed by the frontend command, and the name and contents of the file (see file_content_key()).
+dict<std::string, std::unique_ptr<TechmapLibrary>> techmap_libraries;
+
 struct TechmapWorker
 {
 	dict<IdString, void(*)(RTLIL::Module*, RTLIL::Cell*)> simplemap_mappers;
 	dict<std::pair<IdString, dict<IdString, RTLIL::Const>>, RTLIL::Module*> techmap_cache;
 	dict<RTLIL::Module*, bool> techmap_do_cache;
+	// The templates for which CONSTMAP has created specialized copies.
+	pool<IdString> constmapped_tpls;
 	pool<RTLIL::Module*> module_queue;
 	dict<Module*, SigMap> sigmaps;
 
+	// The libraries that the modules of the map design were cloned from.
+	dict<IdString, TechmapLibrary*> template_libraries;
+
 	pool<string> log_msg_cache;
 
 	struct TechmapWireData {
@@ -77,12 +100,90 @@ struct TechmapWorker
 
 	typedef dict<IdString, std::vector<TechmapWireData>> TechmapWires;
 
+	// The parts of the instantiation of a template that do not depend on the cell being mapped.
+	struct TechmapTemplateInfo {
+		bool has_replace_cell = false;
+		dict<IdString, IdString> positional_ports;
+		pool<SigBit> written_bits;
+	};
+
+	dict<RTLIL::Module*, TechmapTemplateInfo> template_infos;
+
+	// Whether a template has any of the parameters that describe the connections of the cell being mapped.
+	dict<RTLIL::Module*, bool> template_port_params;
+
+	bool has_port_params(RTLIL::Module *tpl)
+	{
+		auto it = template_port_params.find(tpl);
+		if (it != template_port_params.end())
+			return it->second;
+
+		bool result = false;
+		for (auto &param : tpl->avail_parameters)
+			if (param == ID::_TECHMAP_BITS_CONNMAP_ || param.begins_with("\\_TECHMAP_CONSTMSK_") ||
+					param.begins_with("\\_TECHMAP_CONSTVAL_") || param.begins_with("\\_TECHMAP_WIREINIT_") ||
+					param.begins_with("\\_TECHMAP_CONNMAP_"))
+				result = true;
+		template_port_params[tpl] = result;
+		return result;
+	}
+
+	const TechmapTemplateInfo &template_info(RTLIL::Module *tpl)
+	{
+		auto it = template_infos.find(tpl);
+		if (it != template_infos.end())
+			return it->second;
+
+		TechmapTemplateInfo &info = template_infos[tpl];
+		for (auto tpl_cell : tpl->cells()) {
+			if (tpl_cell->name.ends_with("_TECHMAP_REPLACE_"))
+				info.has_replace_cell = true;
+			for (auto &conn : tpl_cell->connections())
+				if (tpl_cell->output(conn.first))
+					for (auto bit : conn.second)
+						info.written_bits.insert(bit);
+		}
+		for (auto &conn : tpl->connections())
+			for (auto bit : conn.first)
+				info.written_bits.insert(bit);
+		for (auto tpl_w : tpl->wires())
+			if (tpl_w->port_id > 0)
+				info.positional_ports.emplace(stringf("$%d", tpl_w->port_id), tpl_w->name);
+		return info;
+	}
+
 	bool extern_mode = false;
 	bool assert_mode = false;
 	bool recursive_mode = false;
 	bool autoproc_mode = false;
 	bool ignore_wb = false;
 
+	IdString derive_template(RTLIL::Design *map, RTLIL::Module *tpl, const dict<IdString, RTLIL::Const> &parameters)
+	{
+		TechmapLibrary *library = template_libraries.at(tpl->name, nullptr);
+		if (library == nullptr)
+			return tpl->derive(map, parameters);
+
+		std::pair<IdString, dict<IdString, RTLIL::Const>> key(tpl->name, parameters);
+		auto it = library->derived_names.find(key);
+		if (it != library->derived_names.end()) {
+			if (map->module(it->second) == nullptr) {
+				log("Using cached derived template `%s'.\n", log_id(it->second));
+				map->add(library->derived->module(it->second)->clone());
+			}
+			return it->second;
+		}
+
+		// Only a module that is newly created by deriving is unaffected by _TECHMAP_DO_ commands.
+		int num_modules = GetSize(map->modules_);
+		IdString derived_name = tpl->derive(map, parameters);
+		if (GetSize(map->modules_) > num_modules && library->derived->module(derived_name) == nullptr) {
+			library->derived->add(map->module(derived_name)->clone());
+			library->derived_names.emplace(std::move(key), derived_name);
+		}
+		return derived_name;
+	}
+
 	std::string constmap_tpl_name(SigMap &sigmap, RTLIL::Module *tpl, RTLIL::Cell *cell, bool verbose)
 	{
 		std::string constmap_info;
@@ -157,13 +258,11 @@ struct TechmapWorker
 
 		std::string orig_cell_name;
 		pool<string> extra_src_attrs = cell->get_strpool_attribute(ID::src);
+		const TechmapTemplateInfo &info = template_info(tpl);
 
 		orig_cell_name = cell->name.str();
-		for (auto tpl_cell : tpl->cells())
-			if (tpl_cell->name.ends_with("_TECHMAP_REPLACE_")) {
-				module->rename(cell, stringf("$techmap%d", autoidx++) + cell->name.str());
-				break;
-			}
+		if (info.has_replace_cell)
+			module->rename(cell, stringf("$techmap%d", autoidx++) + cell->name.str());
 
 		dict<IdString, IdString> memory_renames;
 
@@ -177,19 +276,16 @@ struct TechmapWorker
 			design->select(module, m);
 		}
 
-		dict<IdString, IdString> positional_ports;
+		const dict<IdString, IdString> &positional_ports = info.positional_ports;
 		dict<Wire*, IdString> temp_renamed_wires;
 		pool<SigBit> autopurge_tpl_bits;
 
 		for (auto tpl_w : tpl->wires())
 		{
-			if (tpl_w->port_id > 0)
+			if (tpl_w->port_id > 0 && tpl_w->get_bool_attribute(ID::techmap_autopurge))
 			{
 				IdString posportname = stringf("$%d", tpl_w->port_id);
-				positional_ports.emplace(posportname, tpl_w->name);
-
-				if (tpl_w->get_bool_attribute(ID::techmap_autopurge) &&
-						(!cell->hasPort(tpl_w->name) || !GetSize(cell->getPort(tpl_w->name))) &&
+				if ((!cell->hasPort(tpl_w->name) || !GetSize(cell->getPort(tpl_w->name))) &&
 						(!cell->hasPort(posportname) || !GetSize(cell->getPort(posportname))))
 				{
 					if (sigmaps.count(tpl) == 0)
@@ -228,15 +324,7 @@ struct TechmapWorker
 			}
 		}
 
-		pool<SigBit> tpl_written_bits;
-		for (auto tpl_cell : tpl->cells())
-		for (auto &conn : tpl_cell->connections())
-			if (tpl_cell->output(conn.first))
-				for (auto bit : conn.second)
-					tpl_written_bits.insert(bit);
-		for (auto &conn : tpl->connections())
-			for (auto bit : conn.first)
-				tpl_written_bits.insert(bit);
+		const pool<SigBit> &tpl_written_bits = info.written_bits;
 
 		SigMap port_signal_map;
 
@@ -424,13 +512,9 @@ struct TechmapWorker
 		bool did_something = false;
 		LogMakeDebugHdl mkdebug;
 
-		SigMap sigmap(module);
-		FfInitVals initvals(&sigmap, module);
-
-		TopoSort<RTLIL::Cell*, IdString::compare_ptr_by_name<RTLIL::Cell>> cells;
-		dict<RTLIL::Cell*, pool<RTLIL::SigBit>> cell_to_inbit;
-		dict<RTLIL::SigBit, pool<RTLIL::Cell*>> outbit_to_cell;
-
+		// collect the cells that have not been looked at yet first, so that the last iteration, which usually finds
+		// nothing to map, doesn't need to index the whole module
+		std::vector<std::pair<RTLIL::Cell*, const pool<IdString>*>> worklist;
 		for (auto cell : module->selected_cells())
 		{
 			if (handled_cells.count(cell) > 0)
@@ -440,12 +524,34 @@ struct TechmapWorker
 			if (in_recursion && cell->type.begins_with("\\$"))
 				cell_type = cell_type.substr(1);
 
-			if (celltypeMap.count(cell_type) == 0) {
+			auto it = celltypeMap.find(cell_type);
+			if (it == celltypeMap.end()) {
 				if (assert_mode && cell_type.back() != '_')
 					log_error("(ASSERT MODE) No matching template cell for type %s found.\n", log_id(cell_type));
+				// the type of a cell is only changed by mapping it, so there is no need to look at it again
+				// (this is not true for templates, which the _TECHMAP_DO_ commands may modify)
+				if (!in_recursion)
+					handled_cells.insert(cell);
 				continue;
 			}
 
+			worklist.emplace_back(cell, &it->second);
+		}
+
+		if (worklist.empty())
+			return false;
+
+		SigMap sigmap(module);
+		FfInitVals initvals(&sigmap, module);
+
+		TopoSort<RTLIL::Cell*, IdString::compare_ptr_by_name<RTLIL::Cell>> cells;
+		dict<RTLIL::Cell*, pool<RTLIL::SigBit>> cell_to_inbit;
+		dict<RTLIL::SigBit, pool<RTLIL::Cell*>> outbit_to_cell;
+
+		for (auto &it : worklist)
+		{
+			RTLIL::Cell *cell = it.first;
+
 			for (auto &conn : cell->connections())
 			{
 				RTLIL::SigSpec sig = sigmap(conn.second);
@@ -454,7 +560,7 @@ struct TechmapWorker
 				if (GetSize(sig) == 0)
 					continue;
 
-				for (auto &tpl_name : celltypeMap.at(cell_type)) {
+				for (auto &tpl_name : *it.second) {
 					RTLIL::Module *tpl = map->module(tpl_name);
 					RTLIL::Wire *port = tpl->wire(conn.first);
 					if (port && port->port_input)
@@ -634,62 +740,66 @@ struct TechmapWorker
 				if (tpl->avail_parameters.count(ID::_TECHMAP_CELLNAME_) != 0)
 					parameters.emplace(ID::_TECHMAP_CELLNAME_, RTLIL::unescape_id(cell->name));
 
-				for (auto &conn : cell->connections()) {
-					if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONSTMSK_%s_", log_id(conn.first))) != 0) {
-						std::vector<RTLIL::SigBit> v = sigmap(conn.second).to_sigbit_vector();
-						for (auto &bit : v)
-							bit = RTLIL::SigBit(bit.wire == nullptr ? RTLIL::State::S1 : RTLIL::State::S0);
-						parameters.emplace(stringf("\\_TECHMAP_CONSTMSK_%s_", log_id(conn.first)), RTLIL::SigSpec(v).as_const());
-					}
-					if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONSTVAL_%s_", log_id(conn.first))) != 0) {
-						std::vector<RTLIL::SigBit> v = sigmap(conn.second).to_sigbit_vector();
-						for (auto &bit : v)
-							if (bit.wire != nullptr)
-								bit = RTLIL::SigBit(RTLIL::State::Sx);
-						parameters.emplace(stringf("\\_TECHMAP_CONSTVAL_%s_", log_id(conn.first)), RTLIL::SigSpec(v).as_const());
-					}
-					if (tpl->avail_parameters.count(stringf("\\_TECHMAP_WIREINIT_%s_", log_id(conn.first))) != 0) {
-						parameters.emplace(stringf("\\_TECHMAP_WIREINIT_%s_", log_id(conn.first)), initvals(conn.second));
-					}
-				}
-
+				// skip building the names of these parameters for every port when the template has none of them
+				if (has_port_params(tpl))
 				{
-					int unique_bit_id_counter = 0;
-					dict<RTLIL::SigBit, int> unique_bit_id;
-					unique_bit_id[RTLIL::State::S0] = unique_bit_id_counter++;
-					unique_bit_id[RTLIL::State::S1] = unique_bit_id_counter++;
-					unique_bit_id[RTLIL::State::Sx] = unique_bit_id_counter++;
-					unique_bit_id[RTLIL::State::Sz] = unique_bit_id_counter++;
-
-					for (auto &conn : cell->connections())
-						if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONNMAP_%s_", log_id(conn.first))) != 0) {
-							for (auto &bit : sigmap(conn.second))
-								if (unique_bit_id.count(bit) == 0)
-									unique_bit_id[bit] = unique_bit_id_counter++;
+					for (auto &conn : cell->connections()) {
+						if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONSTMSK_%s_", log_id(conn.first))) != 0) {
+							std::vector<RTLIL::SigBit> v = sigmap(conn.second).to_sigbit_vector();
+							for (auto &bit : v)
+								bit = RTLIL::SigBit(bit.wire == nullptr ? RTLIL::State::S1 : RTLIL::State::S0);
+							parameters.emplace(stringf("\\_TECHMAP_CONSTMSK_%s_", log_id(conn.first)), RTLIL::SigSpec(v).as_const());
+						}
+						if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONSTVAL_%s_", log_id(conn.first))) != 0) {
+							std::vector<RTLIL::SigBit> v = sigmap(conn.second).to_sigbit_vector();
+							for (auto &bit : v)
+								if (bit.wire != nullptr)
+									bit = RTLIL::SigBit(RTLIL::State::Sx);
+							parameters.emplace(stringf("\\_TECHMAP_CONSTVAL_%s_", log_id(conn.first)), RTLIL::SigSpec(v).as_const());
 						}
+						if (tpl->avail_parameters.count(stringf("\\_TECHMAP_WIREINIT_%s_", log_id(conn.first))) != 0) {
+							parameters.emplace(stringf("\\_TECHMAP_WIREINIT_%s_", log_id(conn.first)), initvals(conn.second));
+						}
+					}
 
-					// Find highest bit set
-					int bits = 0;
-					for (int i = 0; i < 32; i++)
-						if (((unique_bit_id_counter-1) & (1 << i)) != 0)
-							bits = i;
-					// Increment index by one to get number of bits
-					bits++;
-					if (tpl->avail_parameters.count(ID::_TECHMAP_BITS_CONNMAP_))
-						parameters[ID::_TECHMAP_BITS_CONNMAP_] = bits;
-
-					for (auto &conn : cell->connections())
-						if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONNMAP_%s_", log_id(conn.first))) != 0) {
-							RTLIL::Const value;
-							for (auto &bit : sigmap(conn.second)) {
-								int val = unique_bit_id.at(bit);
-								for (int i = 0; i < bits; i++) {
-									value.bits().push_back((val & 1) != 0 ? State::S1 : State::S0);
-									val = val >> 1;
+					{
+						int unique_bit_id_counter = 0;
+						dict<RTLIL::SigBit, int> unique_bit_id;
+						unique_bit_id[RTLIL::State::S0] = unique_bit_id_counter++;
+						unique_bit_id[RTLIL::State::S1] = unique_bit_id_counter++;
+						unique_bit_id[RTLIL::State::Sx] = unique_bit_id_counter++;
+						unique_bit_id[RTLIL::State::Sz] = unique_bit_id_counter++;
+
+						for (auto &conn : cell->connections())
+							if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONNMAP_%s_", log_id(conn.first))) != 0) {
+								for (auto &bit : sigmap(conn.second))
+									if (unique_bit_id.count(bit) == 0)
+										unique_bit_id[bit] = unique_bit_id_counter++;
+							}
+
+						// Find highest bit set
+						int bits = 0;
+						for (int i = 0; i < 32; i++)
+							if (((unique_bit_id_counter-1) & (1 << i)) != 0)
+								bits = i;
+						// Increment index by one to get number of bits
+						bits++;
+						if (tpl->avail_parameters.count(ID::_TECHMAP_BITS_CONNMAP_))
+							parameters[ID::_TECHMAP_BITS_CONNMAP_] = bits;
+
+						for (auto &conn : cell->connections())
+							if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONNMAP_%s_", log_id(conn.first))) != 0) {
+								RTLIL::Const value;
+								for (auto &bit : sigmap(conn.second)) {
+									int val = unique_bit_id.at(bit);
+									for (int i = 0; i < bits; i++) {
+										value.bits().push_back((val & 1) != 0 ? State::S1 : State::S0);
+										val = val >> 1;
+									}
 								}
+								parameters.emplace(stringf("\\_TECHMAP_CONNMAP_%s_", log_id(conn.first)), value);
 							}
-							parameters.emplace(stringf("\\_TECHMAP_CONNMAP_%s_", log_id(conn.first)), value);
-						}
+					}
 				}
 
 				if (0) {
@@ -703,7 +813,7 @@ struct TechmapWorker
 					} else {
 						if (parameters.size() != 0) {
 							mkdebug.on();
-							derived_name = tpl->derive(map, parameters);
+							derived_name = derive_template(map, tpl, parameters);
 							tpl = map->module(derived_name);
 							log_continue = true;
 						}
@@ -711,9 +821,11 @@ struct TechmapWorker
 					}
 				}
 
-				RTLIL::Module *constmapped_tpl = map->module(constmap_tpl_name(sigmap, tpl, cell, false));
-				if (constmapped_tpl != nullptr)
-					tpl = constmapped_tpl;
+				if (constmapped_tpls.count(tpl->name)) {
+					RTLIL::Module *constmapped_tpl = map->module(constmap_tpl_name(sigmap, tpl, cell, false));
+					if (constmapped_tpl != nullptr)
+						tpl = constmapped_tpl;
+				}
 
 				if (techmap_do_cache.count(tpl) == 0)
 				{
@@ -773,6 +885,7 @@ struct TechmapWorker
 								IdString new_tpl_name = constmap_tpl_name(sigmap, tpl, cell, true);
 								log("Creating constmapped module `%s'.\n", log_id(new_tpl_name));
 								log_assert(map->module(new_tpl_name) == nullptr);
+								constmapped_tpls.insert(tpl->name);
 
 								RTLIL::Module *new_tpl = map->addModule(new_tpl_name);
 								tpl->cloneInto(new_tpl);
@@ -996,6 +1109,10 @@ struct TechmapPass : public Pass {
 		log("        transforms the internal RTL cells to the internal gate\n");
 		log("        library.\n");
 		log("\n");
+		log("        map files are read only once per session, together with the\n");
+		log("        templates derived from them, and are read again when the file\n");
+		log("        contents change.\n");
+		log("\n");
 		log("    -map %%<design-name>\n");
 		log("        like -map above, but with an in-memory design instead of a file.\n");
 		log("\n");
@@ -1212,23 +1329,49 @@ struct TechmapPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
+		if (map_files.empty())
+			map_files.push_back("+/techmap.v");
+
 		RTLIL::Design *map = new RTLIL::Design;
-		if (map_files.empty()) {
-			Frontend::frontend_call(map, nullptr, "+/techmap.v", verilog_frontend);
-		} else {
-			for (auto &fn : map_files)
-				if (fn.compare(0, 1, "%") == 0) {
-					if (!saved_designs.count(fn.substr(1))) {
+		for (auto &fn : map_files)
+			if (fn.compare(0, 1, "%") == 0) {
+				if (!saved_designs.count(fn.substr(1))) {
+					delete map;
+					log_cmd_error("Can't open saved design `%s'.\n", fn.c_str()+1);
+				}
+				for (auto mod : saved_designs.at(fn.substr(1))->modules())
+					if (!map->module(mod->name))
+						map->add(mod->clone());
+			} else {
+				std::string frontend = (fn.size() > 3 && fn.compare(fn.size()-3, std::string::npos, ".il") == 0 ? "rtlil" : verilog_frontend);
+				std::string filename = fn;
+				rewrite_filename(filename);
+				std::string file_key = file_content_key(filename);
+				if (file_key.empty()) {
+					Frontend::frontend_call(map, nullptr, fn, frontend);
+					continue;
+				}
+
+				std::string key = frontend + "\n" + file_key;
+				auto &library = techmap_libraries[key];
+				if (library == nullptr) {
+					library.reset(new TechmapLibrary);
+					try {
+						Frontend::frontend_call(library->design, nullptr, fn, frontend);
+					} catch (...) {
+						techmap_libraries.erase(key);
 						delete map;
-						log_cmd_error("Can't open saved design `%s'.\n", fn.c_str()+1);
+						throw;
 					}
-					for (auto mod : saved_designs.at(fn.substr(1))->modules())
-						if (!map->module(mod->name))
-							map->add(mod->clone());
-				} else {
-					Frontend::frontend_call(map, nullptr, fn, (fn.size() > 3 && fn.compare(fn.size()-3, std::string::npos, ".il") == 0 ? "rtlil" : verilog_frontend));
-				}
-		}
+				} else
+					log("Using cached map file `%s'.\n", fn.c_str());
+
+				for (auto mod : library->design->modules())
+					if (!map->module(mod->name)) {
+						map->add(mod->clone());
+						worker.template_libraries[mod->name] = library.get();
+					}
+			}
 
 		log_header(design, "Continuing TECHMAP pass.\n");
 
@@ -1306,6 +1449,10 @@ struct TechmapPass : public Pass {
 
 		log_pop();
 	}
+	void on_shutdown() override
+	{
+		techmap_libraries.clear();
+	}
 } TechmapPass;
 
 PRIVATE_NAMESPACE_END
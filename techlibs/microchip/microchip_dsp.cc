@@ -36,7 +36,7 @@ void microchip_dsp_pack(microchip_dsp_pm &pm)
 	Cell *cell = st.dsp;
 	// pack pre-adder
 	if (st.preAdderStatic) {
-		SigSpec &pasub = cell->connections_.at(ID(PASUB));
+		SigSpec pasub = cell->getPort(ID(PASUB));
 		log("  static PASUB preadder %s (%s)\n", log_id(st.preAdderStatic), log_id(st.preAdderStatic->type));
 		bool D_SIGNED = st.preAdderStatic->getParam(ID::B_SIGNED).as_bool();
 		bool B_SIGNED = st.preAdderStatic->getParam(ID::A_SIGNED).as_bool();
@@ -55,13 +55,14 @@ void microchip_dsp_pack(microchip_dsp_pm &pm)
 			pasub[0] = State::S1;
 		else
 			log_assert(!"strange pre-adder type");
+		cell->setPort(ID(PASUB), pasub);
 
 		pm.autoremove(st.preAdderStatic);
 	}
 	// pack post-adder
 	if (st.postAdderStatic) {
 		log("  postadder %s (%s)\n", log_id(st.postAdderStatic), log_id(st.postAdderStatic->type));
-		SigSpec &sub = cell->connections_.at(ID(SUB));
+		SigSpec sub = cell->getPort(ID(SUB));
 		// Post-adder in MACC_PA also supports subtraction
 		//   Determines the sign of the output from the multiplier.
 		if (st.postAdderStatic->type == ID($add))
@@ -70,6 +71,7 @@ void microchip_dsp_pack(microchip_dsp_pm &pm)
 			sub[0] = State::S1;
 		else
 			log_assert(!"strange post-adder type");
+		cell->setPort(ID(SUB), sub);
 
 		if (st.useFeedBack) {
 			cell->setPort(ID(CDIN_FDBK_SEL), {State::S0, State::S1});
@@ -165,7 +167,9 @@ void microchip_dsp_pack(microchip_dsp_pm &pm)
 		if (st.ffP) {
 			SigSpec P; // unused
 			f(P, st.ffP, ID(P_EN), ID(P_SRST_N), ID(P_BYPASS));
-			st.ffP->connections_.at(ID::Q).replace(st.sigP, pm.module->addWire(NEW_ID, GetSize(st.sigP)));
+			SigSpec Q = st.ffP->getPort(ID::Q);
+			Q.replace(st.sigP, pm.module->addWire(NEW_ID, GetSize(st.sigP)));
+			st.ffP->setPort(ID::Q, Q);
 		}
 
 		log("  clock: %s (%s)\n", log_signal(st.clock), "posedge");
@@ -323,6 +327,11 @@ struct MicrochipDspPass : public Pass {
 			if (design->scratchpad_get_bool("microchip_dsp.multonly"))
 				continue;
 
+			// The matchers below share their index of signal users,
+			// which is updated for the cells changed by each of them
+			pmgen_cache cache;
+			cache.incremental = true;
+
 			{
 				// For more details on PolarFire MACC_PA, consult
 				//   the "PolarFire FPGA Macro Library Guide"
@@ -333,7 +342,7 @@ struct MicrochipDspPass : public Pass {
 				//   check for an accumulator pattern based on whether
 				//   a post-adder and PREG are both present AND
 				//   if PREG feeds into this post-adder.
-				microchip_dsp_pm pm(module, module->selected_cells());
+				microchip_dsp_pm pm(module, module->selected_cells(), &cache);
 				pm.run_microchip_dsp_pack(microchip_dsp_pack);
 			}
 
@@ -346,13 +355,13 @@ struct MicrochipDspPass : public Pass {
 			//   PREG of an upstream DSP that had not been visited
 			//   yet
 			{
-				microchip_dsp_CREG_pm pm(module, module->selected_cells());
+				microchip_dsp_CREG_pm pm(module, module->selected_cells(), &cache);
 				pm.run_microchip_dsp_packC(microchip_dsp_packC);
 			}
 
 			// Lastly, identify and utilise PCOUT -> PCIN chains
 			{
-				microchip_dsp_cascade_pm pm(module, module->selected_cells());
+				microchip_dsp_cascade_pm pm(module, module->selected_cells(), &cache);
 				pm.run_microchip_dsp_cascade();
 			}
 		}
@@ -126,6 +126,20 @@ struct SynthXilinxPass : public ScriptPass
 		log("    -flatten\n");
 		log("        flatten design before synthesis\n");
 		log("\n");
+		log("    -jobs <N>\n");
+		log("        run the module-local commands from 'prepare' to 'fine' on up to\n");
+		log("        <N> groups of modules in parallel processes. the result does not\n");
+		log("        depend on the order in which the jobs finish. ignored with -flatten.\n");
+		log("        see 'help job_worker' for running the jobs on other hosts.\n");
+		log("\n");
+		log("The results of the commands from 'prepare' to 'fine' are reused across runs\n");
+		log("for the modules that did not change when the scratchpad variable\n");
+		log("script.module_cache is set to a cache directory (e.g. 'scratchpad -set\n");
+		log("script.module_cache <dir>'). A module counts as changed when its contents,\n");
+		log("the interfaces of the modules it instantiates, the options of synth_xilinx\n");
+		log("or the files read by these commands change. As with -jobs, this does not\n");
+		log("happen with -flatten.\n");
+		log("\n");
 		log("    -dff\n");
 		log("        run 'abc'/'abc9' with -dff option\n");
 		log("\n");
@@ -149,6 +163,7 @@ struct SynthXilinxPass : public ScriptPass
 	int widemux;
 	int lut_size;
 	int widelut_size;
+	int jobs;
 
 	void clear_flags() override
 	{
@@ -174,6 +189,7 @@ struct SynthXilinxPass : public ScriptPass
 		flatten_before_abc = false;
 		widemux = 0;
 		lut_size = 6;
+		jobs = 1;
 	}
 
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
@@ -212,6 +228,10 @@ struct SynthXilinxPass : public ScriptPass
 				flatten = true;
 				continue;
 			}
+			if (args[argidx] == "-jobs" && argidx+1 < args.size()) {
+				jobs = atoi(args[++argidx].c_str());
+				continue;
+			}
 			if (args[argidx] == "-flatten_before_abc") {
 				flatten_before_abc = true;
 				continue;
@@ -353,6 +373,10 @@ struct SynthXilinxPass : public ScriptPass
 			run(stringf("hierarchy -check %s", top_opt.c_str()));
 		}
 
+		// the commands up to 'fine' work module by module
+		if (!flatten && !help_mode)
+			begin_module_jobs(jobs);
+
 		if (check_label("prepare")) {
 			run("proc");
 			if (flatten || help_mode)
@@ -607,6 +631,8 @@ struct SynthXilinxPass : public ScriptPass
 			run("opt -fast");
 		}
 
+		end_module_jobs();
+
 		if (check_label("map_cells")) {
 			// Needs to be done before logic optimization, so that inverters (inserted
 			// here because of negative-polarity output enable) are handled.
@@ -0,0 +1,155 @@
+#include <benchmark/benchmark.h>
+
+#include "kernel/rtlil.h"
+
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+// Keys as they typically occur in passes: dense indices such as cell or
+// wire numbers, random values such as hashes, and the bits of a few wide
+// wires, as used in the SigBit keyed maps of nearly every pass.
+
+static std::vector<int> dense_keys(int n)
+{
+	std::vector<int> keys(n);
+	for (int i = 0; i < n; i++)
+		keys[i] = i;
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+	return keys;
+}
+
+static std::vector<int> random_keys(int n)
+{
+	std::vector<int> keys(n);
+	std::mt19937 rng(2);
+	for (auto &key : keys)
+		key = rng();
+	return keys;
+}
+
+struct BitKeys
+{
+	Design design;
+	std::vector<SigBit> keys;
+
+	BitKeys(int n)
+	{
+		Module *mod = design.addModule(ID(bench));
+		for (int i = 0; GetSize(keys) < n; i++) {
+			Wire *wire = mod->addWire(stringf("\\w%d", i), 32);
+			for (int j = 0; j < 32 && GetSize(keys) < n; j++)
+				keys.push_back(SigBit(wire, j));
+		}
+		std::shuffle(keys.begin(), keys.end(), std::mt19937(3));
+	}
+};
+
+template<typename Dict, typename Key>
+static void insert(benchmark::State &state, const std::vector<Key> &keys)
+{
+	for (auto _ : state) {
+		Dict d;
+		for (auto &key : keys)
+			d[key] = 1;
+		benchmark::DoNotOptimize(d.size());
+	}
+	state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template<typename Dict, typename Key>
+static void lookup(benchmark::State &state, const std::vector<Key> &keys)
+{
+	Dict d;
+	for (int i = 0; i < GetSize(keys); i += 2)
+		d[keys[i]] = i;
+
+	// half of the lookups miss
+	for (auto _ : state) {
+		int found = 0;
+		for (auto &key : keys)
+			found += d.count(key);
+		benchmark::DoNotOptimize(found);
+	}
+	state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template<typename Dict, typename Key>
+static void iterate(benchmark::State &state, const std::vector<Key> &keys)
+{
+	Dict d;
+	for (auto &key : keys)
+		d[key] = 1;
+
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto &it : d)
+			sum += it.second;
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template<typename Dict, typename Key>
+static void erase(benchmark::State &state, const std::vector<Key> &keys)
+{
+	for (auto _ : state) {
+		state.PauseTiming();
+		Dict d;
+		for (auto &key : keys)
+			d[key] = 1;
+		state.ResumeTiming();
+		for (auto &key : keys)
+			d.erase(key);
+		benchmark::DoNotOptimize(d.size());
+	}
+	state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+static void BM_DictDenseInsert(benchmark::State &state) { insert<dict<int, int>>(state, dense_keys(state.range(0))); }
+static void BM_DictDenseLookup(benchmark::State &state) { lookup<dict<int, int>>(state, dense_keys(state.range(0))); }
+static void BM_DictDenseIterate(benchmark::State &state) { iterate<dict<int, int>>(state, dense_keys(state.range(0))); }
+static void BM_DictDenseErase(benchmark::State &state) { erase<dict<int, int>>(state, dense_keys(state.range(0))); }
+static void BM_DictRandomInsert(benchmark::State &state) { insert<dict<int, int>>(state, random_keys(state.range(0))); }
+static void BM_DictRandomLookup(benchmark::State &state) { lookup<dict<int, int>>(state, random_keys(state.range(0))); }
+static void BM_FlatDictRandomInsert(benchmark::State &state) { insert<flat_dict<int, int>>(state, random_keys(state.range(0))); }
+static void BM_FlatDictRandomLookup(benchmark::State &state) { lookup<flat_dict<int, int>>(state, random_keys(state.range(0))); }
+static void BM_StdMapRandomInsert(benchmark::State &state) { insert<std::unordered_map<int, int>>(state, random_keys(state.range(0))); }
+static void BM_StdMapRandomLookup(benchmark::State &state) { lookup<std::unordered_map<int, int>>(state, random_keys(state.range(0))); }
+
+static void BM_DictSigBitInsert(benchmark::State &state) { BitKeys k(state.range(0)); insert<dict<SigBit, int>>(state, k.keys); }
+static void BM_DictSigBitLookup(benchmark::State &state) { BitKeys k(state.range(0)); lookup<dict<SigBit, int>>(state, k.keys); }
+static void BM_DictSigBitIterate(benchmark::State &state) { BitKeys k(state.range(0)); iterate<dict<SigBit, int>>(state, k.keys); }
+static void BM_DictSigBitErase(benchmark::State &state) { BitKeys k(state.range(0)); erase<dict<SigBit, int>>(state, k.keys); }
+
+static void BM_PoolSigBitInsert(benchmark::State &state)
+{
+	BitKeys k(state.range(0));
+	for (auto _ : state) {
+		pool<SigBit> p;
+		for (auto &key : k.keys)
+			p.insert(key);
+		benchmark::DoNotOptimize(p.size());
+	}
+	state.SetItemsProcessed(state.iterations() * k.keys.size());
+}
+
+#define SIZES RangeMultiplier(16)->Range(1 << 8, 1 << 20)
+
+BENCHMARK(BM_DictDenseInsert)->SIZES;
+BENCHMARK(BM_DictDenseLookup)->SIZES;
+BENCHMARK(BM_DictDenseIterate)->SIZES;
+BENCHMARK(BM_DictDenseErase)->SIZES;
+BENCHMARK(BM_DictRandomInsert)->SIZES;
+BENCHMARK(BM_DictRandomLookup)->SIZES;
+BENCHMARK(BM_FlatDictRandomInsert)->SIZES;
+BENCHMARK(BM_FlatDictRandomLookup)->SIZES;
+BENCHMARK(BM_StdMapRandomInsert)->SIZES;
+BENCHMARK(BM_StdMapRandomLookup)->SIZES;
+BENCHMARK(BM_DictSigBitInsert)->SIZES;
+BENCHMARK(BM_DictSigBitLookup)->SIZES;
+BENCHMARK(BM_DictSigBitIterate)->SIZES;
+BENCHMARK(BM_DictSigBitErase)->SIZES;
+BENCHMARK(BM_PoolSigBitInsert)->SIZES;
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+
+#include "kernel/rtlil.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Names in the style of those created by the frontends and by NEW_ID, which
+// share long prefixes and differ only at the end.
+static std::vector<std::string> make_names(int n, const char *tag)
+{
+	std::vector<std::string> names;
+	for (int i = 0; i < n; i++)
+		names.push_back(stringf("$auto$bench.cc:%d:%s$%d", i % 97, tag, i));
+	return names;
+}
+
+static void BM_IdStringCreate(benchmark::State &state)
+{
+	int round = 0;
+	for (auto _ : state) {
+		state.PauseTiming();
+		auto names = make_names(state.range(0), stringf("create%d", round++).c_str());
+		std::vector<IdString> ids;
+		ids.reserve(names.size());
+		state.ResumeTiming();
+		for (auto &name : names)
+			ids.emplace_back(name);
+		benchmark::DoNotOptimize(ids.data());
+		// destroying the last reference frees the name again
+		state.PauseTiming();
+		ids.clear();
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_IdStringLookup(benchmark::State &state)
+{
+	auto names = make_names(state.range(0), "lookup");
+	std::vector<IdString> keep(names.begin(), names.end());
+	for (auto _ : state)
+		for (auto &name : names)
+			benchmark::DoNotOptimize(IdString(name));
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_IdStringCopy(benchmark::State &state)
+{
+	auto names = make_names(state.range(0), "copy");
+	std::vector<IdString> ids(names.begin(), names.end());
+	for (auto _ : state) {
+		std::vector<IdString> copy = ids;
+		benchmark::DoNotOptimize(copy.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_IdStringCompare(benchmark::State &state)
+{
+	auto names = make_names(state.range(0), "compare");
+	std::vector<IdString> ids(names.begin(), names.end());
+	for (auto _ : state) {
+		std::vector<IdString> sorted = ids;
+		std::sort(sorted.begin(), sorted.end(), RTLIL::sort_by_id_str());
+		benchmark::DoNotOptimize(sorted.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_IdStringStr(benchmark::State &state)
+{
+	auto names = make_names(state.range(0), "str");
+	std::vector<IdString> ids(names.begin(), names.end());
+	for (auto _ : state) {
+		size_t len = 0;
+		for (auto &id : ids)
+			len += id.str().size();
+		benchmark::DoNotOptimize(len);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_IdStringCreate)->RangeMultiplier(16)->Range(1 << 8, 1 << 16);
+BENCHMARK(BM_IdStringLookup)->RangeMultiplier(16)->Range(1 << 8, 1 << 16);
+BENCHMARK(BM_IdStringCopy)->RangeMultiplier(16)->Range(1 << 8, 1 << 16);
+BENCHMARK(BM_IdStringCompare)->RangeMultiplier(16)->Range(1 << 8, 1 << 16);
+BENCHMARK(BM_IdStringStr)->RangeMultiplier(16)->Range(1 << 8, 1 << 16);
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,174 @@
+#include <benchmark/benchmark.h>
+
+#include "kernel/sigtools.h"
+
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+// A module with `n` wires of 32 bits, and signals that are built from their
+// bits the way cell ports usually are: whole wires, slices, and scattered
+// bits mixed with constants.
+struct SigFixture
+{
+	Design design;
+	Module *mod;
+	std::vector<Wire*> wires;
+	std::mt19937 rng{4};
+
+	SigFixture(int n)
+	{
+		mod = design.addModule(ID(bench));
+		for (int i = 0; i < n; i++)
+			wires.push_back(mod->addWire(stringf("\\w%d", i), 32));
+	}
+
+	SigSpec chunked(int width)
+	{
+		SigSpec sig;
+		while (sig.size() < width) {
+			Wire *wire = wires[rng() % wires.size()];
+			int offset = rng() % 32;
+			int len = std::min(1 + int(rng() % (32 - offset)), width - sig.size());
+			sig.append(SigSpec(wire, offset, len));
+		}
+		return sig;
+	}
+
+	SigSpec scattered(int width)
+	{
+		SigSpec sig;
+		for (int i = 0; i < width; i++) {
+			if (rng() % 8 == 0)
+				sig.append(rng() % 2 ? State::S1 : State::S0);
+			else
+				sig.append(SigBit(wires[rng() % wires.size()], rng() % 32));
+		}
+		return sig;
+	}
+};
+
+static void BM_SigSpecUnpack(benchmark::State &state)
+{
+	SigFixture f(64);
+	SigSpec sig = f.chunked(state.range(0));
+	for (auto _ : state) {
+		SigSpec copy = sig;
+		benchmark::DoNotOptimize(copy[copy.size() / 2]);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_SigSpecPack(benchmark::State &state)
+{
+	SigFixture f(64);
+	std::vector<SigBit> bits = f.chunked(state.range(0)).to_sigbit_vector();
+	for (auto _ : state) {
+		SigSpec sig(bits);
+		benchmark::DoNotOptimize(sig.chunks().size());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_SigSpecHash(benchmark::State &state)
+{
+	SigFixture f(64);
+	SigSpec sig = f.scattered(state.range(0));
+	for (auto _ : state) {
+		SigSpec copy = sig;
+		benchmark::DoNotOptimize(run_hash(copy));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_SigSpecExtract(benchmark::State &state)
+{
+	SigFixture f(64);
+	SigSpec sig = f.chunked(state.range(0));
+	int width = sig.size();
+	for (auto _ : state)
+		for (int offset = 0; offset + 8 <= width; offset += 8)
+			benchmark::DoNotOptimize(sig.extract(offset, 8));
+	state.SetItemsProcessed(state.iterations() * (width / 8));
+}
+
+static void BM_SigSpecReplace(benchmark::State &state)
+{
+	SigFixture f(64);
+	SigSpec sig = f.scattered(state.range(0));
+	SigSpec pattern = f.scattered(64);
+	SigSpec with = f.scattered(64);
+	for (auto _ : state) {
+		SigSpec copy = sig;
+		copy.replace(pattern, with);
+		benchmark::DoNotOptimize(copy.size());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_SigSpecRemove(benchmark::State &state)
+{
+	SigFixture f(64);
+	SigSpec sig = f.scattered(state.range(0));
+	SigSpec pattern = f.scattered(64);
+	for (auto _ : state) {
+		SigSpec copy = sig;
+		copy.remove(pattern);
+		benchmark::DoNotOptimize(copy.size());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_SigSpecSortAndUnify(benchmark::State &state)
+{
+	SigFixture f(64);
+	SigSpec sig = f.scattered(state.range(0));
+	for (auto _ : state) {
+		SigSpec copy = sig;
+		copy.sort_and_unify();
+		benchmark::DoNotOptimize(copy.size());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// a module where every wire is connected to a random earlier one, so that
+// SigMap has to merge long chains
+static void connect_chains(SigFixture &f)
+{
+	for (int i = 1; i < GetSize(f.wires); i++)
+		f.mod->connect(f.wires[i], f.wires[f.rng() % i]);
+}
+
+static void BM_SigMapBuild(benchmark::State &state)
+{
+	SigFixture f(state.range(0));
+	connect_chains(f);
+	for (auto _ : state) {
+		SigMap sigmap(f.mod);
+		benchmark::DoNotOptimize(&sigmap);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0) * 32);
+}
+
+static void BM_SigMapApply(benchmark::State &state)
+{
+	SigFixture f(state.range(0));
+	connect_chains(f);
+	SigMap sigmap(f.mod);
+	SigSpec sig = f.scattered(4096);
+	for (auto _ : state)
+		benchmark::DoNotOptimize(sigmap(sig));
+	state.SetItemsProcessed(state.iterations() * sig.size());
+}
+
+BENCHMARK(BM_SigSpecUnpack)->RangeMultiplier(8)->Range(8, 1 << 15);
+BENCHMARK(BM_SigSpecPack)->RangeMultiplier(8)->Range(8, 1 << 15);
+BENCHMARK(BM_SigSpecHash)->RangeMultiplier(8)->Range(8, 1 << 15);
+BENCHMARK(BM_SigSpecExtract)->RangeMultiplier(8)->Range(64, 1 << 15);
+BENCHMARK(BM_SigSpecReplace)->RangeMultiplier(8)->Range(64, 1 << 15);
+BENCHMARK(BM_SigSpecRemove)->RangeMultiplier(8)->Range(64, 1 << 15);
+BENCHMARK(BM_SigSpecSortAndUnify)->RangeMultiplier(8)->Range(64, 1 << 15);
+BENCHMARK(BM_SigMapBuild)->RangeMultiplier(8)->Range(64, 1 << 15);
+BENCHMARK(BM_SigMapApply)->RangeMultiplier(8)->Range(64, 1 << 15);
+
+YOSYS_NAMESPACE_END
@@ -12,6 +12,32 @@ run_subtest () {
 run_subtest value
 run_subtest value_fuzz
 
+../../yosys -p "read_verilog test_parallel.v; write_cxxrtl cxxrtl-test-batch-design.cc"
+
+../../yosys -p "read_verilog test_lanes.v; write_cxxrtl -namespace cxxrtl_scalar cxxrtl-test-lanes-scalar.cc"
+../../yosys -p "read_verilog test_lanes.v; write_cxxrtl -lanes 5 -namespace cxxrtl_lanes cxxrtl-test-lanes-design.cc"
+run_subtest lanes
+
+../../yosys -p "read_verilog test_parallel.v; write_cxxrtl -activity 4 -namespace cxxrtl_activity cxxrtl-test-activity-design.cc"
+run_subtest activity
+
+../../yosys -p "read_verilog test_parallel.v; write_cxxrtl -profile -activity 4 -namespace cxxrtl_profile cxxrtl-test-profile-design.cc"
+run_subtest profile
+
+../../yosys -p "read_verilog test_parallel.v; write_cxxrtl -arena -activity 4 -namespace cxxrtl_arena cxxrtl-test-arena-design.cc"
+run_subtest arena
+
+${CC:-gcc} -std=c++11 -O2 -pthread -o cxxrtl-test-replay -I../../backends/cxxrtl/runtime test_replay.cc -lstdc++
+./cxxrtl-test-replay
+
+${CC:-gcc} -std=c++11 -O2 -o cxxrtl-test-fst -I../../backends/cxxrtl/runtime -I../../libs/fst test_fst.cc \
+    ../../libs/fst/fstapi.cc ../../libs/fst/fastlz.cc ../../libs/fst/lz4.cc -lstdc++ -lz
+./cxxrtl-test-fst
+
 # Compile-only test.
 ../../yosys -p "read_verilog test_unconnected_output.v; proc; clean; write_cxxrtl cxxrtl-test-unconnected_output.cc"
 ${CC:-gcc} -std=c++11 -c -o cxxrtl-test-unconnected_output -I../../backends/cxxrtl/runtime cxxrtl-test-unconnected_output.cc
+
+# Compile-only test.
+../../yosys -p "read_verilog test_parallel.v; write_cxxrtl -parallel 4 cxxrtl-test-parallel.cc"
+${CC:-gcc} -std=c++11 -pthread -c -o cxxrtl-test-parallel -I../../backends/cxxrtl/runtime cxxrtl-test-parallel.cc
@@ -0,0 +1,88 @@
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "cxxrtl/cxxrtl.h"
+#include "cxxrtl/cxxrtl_fst.h"
+
+static std::string to_binary(uint64_t value, size_t width)
+{
+    std::string result;
+    for (size_t bit = width; bit-- > 0;)
+        result += (value >> bit) & 1 ? '1' : '0';
+    return result;
+}
+
+int main()
+{
+    const size_t samples = 1000;
+
+    {
+        cxxrtl::value<8> in;
+        cxxrtl::wire<40> count;
+        cxxrtl::debug_items items;
+        items.add("top in", cxxrtl::debug_item(in, 0, cxxrtl::debug_item::INPUT));
+        items.add("top count", cxxrtl::debug_item(count, 0, cxxrtl::debug_item::DRIVEN_SYNC));
+        items.add("top sub count_alias", cxxrtl::debug_item(count, 0, cxxrtl::debug_item::DRIVEN_SYNC));
+
+        cxxrtl::observer observer;
+        cxxrtl::fst_writer writer("cxxrtl-test-fst.fst");
+        writer.timescale(1, "ns");
+        writer.add(items);
+        for (size_t sample = 0; sample < samples; sample++) {
+            in.set<uint8_t>(sample % 3 == 0 ? sample : 0);
+            count.next = count.curr.add(in.zcast<40>()).shl(cxxrtl::value<8>(sample % 2 ? 3u : 0u));
+            count.commit(observer);
+            writer.sample(sample);
+        }
+    }
+
+    void *reader = fstReaderOpen("cxxrtl-test-fst.fst");
+    assert(reader != nullptr);
+    assert(fstReaderGetVarCount(reader) == 3);
+    assert(fstReaderGetTimescale(reader) == -9);
+
+    std::map<std::string, fstHandle> handles;
+    std::string scope;
+    while (struct fstHier *hier = fstReaderIterateHier(reader)) {
+        if (hier->htyp == FST_HT_SCOPE)
+            scope += std::string(hier->u.scope.name) + ".";
+        else if (hier->htyp == FST_HT_UPSCOPE)
+            scope = scope.substr(0, scope.rfind('.', scope.size() - 2) + 1);
+        else if (hier->htyp == FST_HT_VAR)
+            handles[scope + hier->u.var.name] = hier->u.var.handle;
+    }
+    assert(handles.count("top.in") && handles.count("top.count") && handles.count("top.sub.count_alias"));
+    assert(handles["top.count"] == handles["top.sub.count_alias"]);
+
+    struct change {
+        uint64_t time;
+        std::string value;
+    };
+    std::map<fstHandle, std::vector<change>> changes;
+    fstReaderSetFacProcessMaskAll(reader);
+    fstReaderIterBlocks(reader, [](void *changes, uint64_t time, fstHandle handle, const unsigned char *value) {
+        (*(std::map<fstHandle, std::vector<change>> *)changes)[handle].push_back({time, (const char *)value});
+    }, &changes, nullptr);
+    fstReaderClose(reader);
+
+    // Only actual changes must be written, except for the initial values.
+    cxxrtl::value<40> count;
+    std::string last_count;
+    size_t count_index = 0;
+    for (size_t sample = 0; sample < samples; sample++) {
+        cxxrtl::value<8> in;
+        in.set<uint8_t>(sample % 3 == 0 ? sample : 0);
+        count = count.add(in.zcast<40>()).shl(cxxrtl::value<8>(sample % 2 ? 3u : 0u));
+        std::string count_value = to_binary(count.get<uint64_t>(), 40);
+        if (count_value != last_count) {
+            const change &actual = changes[handles["top.count"]].at(count_index++);
+            assert(actual.time == sample && actual.value == count_value);
+            last_count = count_value;
+        }
+    }
+    assert(count_index == changes[handles["top.count"]].size());
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+module lanes(
+    input             clk_a,
+                      clk_b,
+                      rst,
+                      en,
+    input      [7:0]  in,
+    input      [2:0]  sel,
+    output reg [7:0]  acc = 0,
+    output reg [15:0] prod = 0,
+    output reg [7:0]  out,
+    output            lt
+);
+    reg [7:0] cnt = 3;
+    always @(posedge clk_a or posedge rst)
+        if (rst)
+            cnt <= 0;
+        else
+            cnt <= cnt + 1;
+    always @(posedge clk_b)
+        if (rst)
+            acc <= 8'h5a;
+        else if (en)
+            acc <= acc + (in >> sel);
+    always @(negedge clk_b)
+        if (en)
+            prod <= {acc, cnt} * in;
+
+    always @(*)
+        case (sel)
+            0: out = acc ^ cnt;
+            1: out = acc - in;
+            2: out = {in[3:0], cnt[7:4]};
+            3: out = -in;
+            default: out = prod[11:4];
+        endcase
+    assign lt = $signed(in) < $signed(acc);
+endmodule
@@ -0,0 +1,23 @@
+module parallel(
+    input        clk_a,
+                 clk_b,
+    input  [7:0] in,
+    output [7:0] out,
+    output [7:0] rd
+);
+    reg [7:0] a = 0, b = 0;
+    always @(posedge clk_a)
+        a <= a + 1;
+    always @(posedge clk_b)
+        b <= b + in;
+
+    reg [7:0] mem [0:15];
+    reg [7:0] rd_q;
+    always @(posedge clk_b)
+        mem[a[3:0]] <= a * in;
+    always @(posedge clk_a)
+        rd_q <= mem[b[3:0]];
+
+    assign out = a ^ b;
+    assign rd = rd_q;
+endmodule
@@ -0,0 +1,32 @@
+#include <cassert>
+#include <cstdint>
+#include <sstream>
+
+#include "cxxrtl-test-profile-design.cc"
+
+int main()
+{
+    cxxrtl_profile::p_parallel top;
+    size_t deltas = 0;
+    for (int cycle = 0; cycle < 100; cycle++) {
+        top.p_clk__a.set<bool>(cycle & 1);
+        top.p_clk__b.set<bool>(cycle & 2);
+        deltas += top.step();
+    }
+
+    cxxrtl::profile_items items;
+    top.profile_info(items, "top ");
+    assert(items.find("top eval") != nullptr);
+    assert(items.find("top eval")->count == deltas);
+    assert(items.find("top commit")->count == deltas);
+    assert(items.find("top region 0") != nullptr);
+
+    std::ostringstream report;
+    items.dump(report);
+    assert(report.str().find("top eval\n") != std::string::npos);
+
+    items.reset();
+    assert(items.find("top eval")->count == 0 && items.find("top eval")->ticks == 0);
+
+    return 0;
+}
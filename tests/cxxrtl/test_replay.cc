@@ -0,0 +1,100 @@
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "cxxrtl/cxxrtl.h"
+#include "cxxrtl/cxxrtl_replay.h"
+
+struct counter {
+    cxxrtl::value<8> in;
+    cxxrtl::wire<40> count;
+    cxxrtl::memory<8> history {4};
+
+    void eval() {
+        count.next = count.curr.add(in.zcast<40>());
+        history.update(count.curr.slice<1, 0>().val().get<size_t>(), in, cxxrtl::value<8>().bit_not());
+    }
+
+    template<class ObserverT>
+    bool commit(ObserverT &observer) {
+        bool changed = false;
+        if (count.commit(observer)) changed = true;
+        if (history.commit(observer)) changed = true;
+        return changed;
+    }
+
+    bool commit() {
+        cxxrtl::observer observer;
+        return commit(observer);
+    }
+
+    void debug_info(cxxrtl::debug_items &items) {
+        items.add("in", cxxrtl::debug_item(in, 0, cxxrtl::debug_item::INPUT));
+        items.add("count", cxxrtl::debug_item(count, 0, cxxrtl::debug_item::DRIVEN_SYNC));
+        items.add("history", cxxrtl::debug_item(history, 0));
+    }
+};
+
+void test_replay(bool background, size_t checkpoint_interval)
+{
+    const size_t samples = 20000;
+    std::vector<uint64_t> counts;
+
+    {
+        counter design;
+        cxxrtl::debug_items items;
+        design.debug_info(items);
+
+        cxxrtl::spool spool("cxxrtl-test-replay.log");
+        cxxrtl::recorder recorder(spool, background);
+        recorder.set_checkpoint_interval(checkpoint_interval);
+        recorder.start(items);
+        recorder.record_complete();
+        counts.push_back(design.count.get<uint64_t>());
+        for (size_t sample = 1; sample < samples; sample++) {
+            design.in.set<uint8_t>(sample * 37);
+            design.eval();
+            recorder.advance_time(cxxrtl::time(0, 1000));
+            recorder.record_incremental(design);
+            counts.push_back(design.count.get<uint64_t>());
+            if (sample % 1000 == 0)
+                recorder.record_diagnostic(cxxrtl::diagnostic(cxxrtl::diagnostic::PRINT, "tick", __FILE__, __LINE__));
+        }
+    }
+
+    counter design;
+    cxxrtl::debug_items items;
+    design.debug_info(items);
+
+    cxxrtl::spool spool("cxxrtl-test-replay.log");
+    cxxrtl::player player(spool);
+    player.start(items);
+
+    // Seek forward and backward, in both cases landing on a sample that's not a checkpoint.
+    std::vector<cxxrtl::diagnostic> diagnostics;
+    for (size_t target : {samples - 2, size_t(12345), size_t(7), samples / 2 + 1}) {
+        assert(player.rewind_to_or_before(cxxrtl::time(0, 1000 * target), &diagnostics));
+        assert(player.current_time() == cxxrtl::time(0, 1000 * target));
+        assert(design.count.get<uint64_t>() == counts[target]);
+    }
+
+    // Replay from the start until the end, counting the diagnostics on the way.
+    assert(player.rewind_to(0, &diagnostics));
+    size_t replayed = 0, ticks = 0;
+    while (player.replay(&diagnostics))
+        replayed++;
+    for (auto &diagnostic : diagnostics)
+        if (diagnostic.message == "tick")
+            ticks++;
+    assert(ticks == samples / 1000 - 1);
+    assert(replayed == samples - 1 + ticks);
+    assert(design.count.get<uint64_t>() == counts.back());
+}
+
+int main()
+{
+    test_replay(/*background=*/false, /*checkpoint_interval=*/0);
+    test_replay(/*background=*/false, /*checkpoint_interval=*/1000);
+    test_replay(/*background=*/true, /*checkpoint_interval=*/100);
+    return 0;
+}
@@ -50,6 +50,19 @@ int main()
         assert(val.template bmux<4>(sel).get<uint64_t>() == 0xfu);
     }
 
+    {
+        // carries and comparisons should propagate across all chunks of wide values
+        cxxrtl::value<100> a(0xffffffffu, 0xffffffffu, 0xffffffffu, 0x7u);
+        cxxrtl::value<100> b(1u, 0u, 0u, 0u);
+        cxxrtl::value<100> c = a.add(b);
+        assert(c == (cxxrtl::value<100>(0u, 0u, 0u, 0x8u)));
+        assert(c.sub(b) == a);
+        assert(b.ucmp(a) && !a.ucmp(b) && !a.ucmp(a));
+        assert(c.scmp(a) && !a.scmp(c) && !c.scmp(c));
+        assert(a.sub(c).is_neg() && a.sub(c).bit_not().is_zero());
+        assert(cxxrtl::value<100>().sub(b) == cxxrtl::value<100>().bit_not());
+    }
+
     {
         // stream operator smoke test
         cxxrtl::value<8> val(0x1fu);
@@ -229,6 +229,56 @@ struct SubTest : BinaryOperationBase
 	}
 } sub;
 
+struct UcmpTest : BinaryOperationBase
+{
+	UcmpTest()
+	{
+		std::printf("Randomized tests for value::ucmp:\n");
+		test_binary_operation(*this);
+	}
+
+	uint64_t reference_impl(size_t bits, uint64_t a, uint64_t b)
+	{
+		return a < b;
+	}
+
+	template<size_t Bits>
+	cxxrtl::value<Bits> testing_impl(cxxrtl::value<Bits> a, cxxrtl::value<Bits> b)
+	{
+		return cxxrtl::value<Bits>((cxxrtl::chunk_t)a.ucmp(b));
+	}
+
+	void tweak_input(uint64_t &a, uint64_t &b)
+	{
+		if (rand_int<int>(0, 3) == 0) b = a; // Make equality likely
+	}
+} ucmp;
+
+struct ScmpTest : BinaryOperationBase
+{
+	ScmpTest()
+	{
+		std::printf("Randomized tests for value::scmp:\n");
+		test_binary_operation(*this);
+	}
+
+	uint64_t reference_impl(size_t bits, uint64_t a, uint64_t b)
+	{
+		return sext(bits, a) < sext(bits, b);
+	}
+
+	template<size_t Bits>
+	cxxrtl::value<Bits> testing_impl(cxxrtl::value<Bits> a, cxxrtl::value<Bits> b)
+	{
+		return cxxrtl::value<Bits>((cxxrtl::chunk_t)a.scmp(b));
+	}
+
+	void tweak_input(uint64_t &a, uint64_t &b)
+	{
+		if (rand_int<int>(0, 3) == 0) b = a; // Make equality likely
+	}
+} scmp;
+
 struct CtlzTest
 {
 	CtlzTest()
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+#
+# Compares two result files of run.py (or of cxxrtl.py) and lists the
+# benchmarks and passes that got slower or use more memory than the given
+# tolerance:
+#
+#   python3 compare.py baseline.json results.json
+
+import sys
+import json
+import argparse
+
+parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('baseline', help='results of the reference version')
+parser.add_argument('results', help='results of the version to check')
+parser.add_argument('-t', '--tolerance', type=float, default=0.10,
+                    help='relative increase that is reported as a regression')
+parser.add_argument('--min-time', type=float, default=0.05,
+                    help='ignore runtimes below this many seconds in both files')
+parser.add_argument('-f', '--fail', action='store_true', help='exit with status 1 if there are regressions')
+args = parser.parse_args()
+
+with open(args.baseline) as f:
+    baseline = json.load(f)
+with open(args.results) as f:
+    results = json.load(f)
+
+print(f"baseline: {baseline.get('generator', '?')}")
+print(f"results:  {results.get('generator', '?')}")
+print()
+
+regressions = 0
+
+# with higher_is_better, a decrease beyond the tolerance is a regression
+def check(what, old, new, unit, scale, min_value=0, higher_is_better=False):
+    global regressions
+    if max(old, new) < min_value:
+        return
+    ratio = new / old if old else float('inf')
+    worse = ratio < 1 - args.tolerance if higher_is_better else ratio > 1 + args.tolerance
+    better = ratio > 1 + args.tolerance if higher_is_better else ratio < 1 - args.tolerance
+    mark = ""
+    if worse:
+        mark = "  REGRESSION"
+        regressions += 1
+    elif better:
+        mark = "  improved"
+    print(f"  {what:32s} {old / scale:10.3f} {new / scale:10.3f} {unit:2s} {ratio:6.2f}x{mark}")
+
+if baseline.get("kind") != results.get("kind"):
+    sys.exit("The result files are of different kinds.")
+
+for name, new in results["benchmarks"].items():
+    old = baseline["benchmarks"].get(name)
+    if old is None:
+        print(f"{name}: not in baseline")
+        continue
+    if old["params"] != new["params"]:
+        print(f"{name}: different parameters, skipped")
+        continue
+
+    print(f"{name}:")
+    if results.get("kind") == "cxxrtl":
+        for level, data in new["levels"].items():
+            if level not in old["levels"]:
+                continue
+            ref = old["levels"][level]
+            check(f"{level} write_cxxrtl", ref["write_ns"], data["write_ns"], "s", 1e9, args.min_time * 1e9)
+            check(f"{level} compile time", ref["compile_s"], data["compile_s"], "s", 1, args.min_time)
+            check(f"{level} code size", ref["code_bytes"], data["code_bytes"], "KB", 1024)
+            check(f"{level} simulation", ref["cycles_per_s"], data["cycles_per_s"], "M/s", 1e6, higher_is_better=True)
+        continue
+    check("wall time", old["wall_s"], new["wall_s"], "s", 1, args.min_time)
+    check("peak RSS", old["peak_rss_bytes"], new["peak_rss_bytes"], "MB", 1024 * 1024)
+    for pass_name, data in new["passes"].items():
+        if pass_name in old["passes"]:
+            check(pass_name, old["passes"][pass_name]["runtime_ns"], data["runtime_ns"], "s", 1e9, args.min_time * 1e9)
+
+print()
+print(f"{regressions} regressions with a tolerance of {args.tolerance * 100:.0f}%.")
+
+if args.fail and regressions:
+    sys.exit(1)
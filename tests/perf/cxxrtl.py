@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+#
+# Generates C++ models of synthetic designs with write_cxxrtl at each
+# optimization level, compiles them with cxxrtl_bench.cc and writes the
+# runtime of write_cxxrtl, the compile time, the size of the generated code
+# and the simulation speed in cycles per second as JSON:
+#
+#   python3 cxxrtl.py -o cxxrtl.json
+#   python3 compare.py baseline.json cxxrtl.json
+
+import os
+import json
+import time
+import shlex
+import argparse
+import subprocess
+from pathlib import Path
+
+from generate import CXXRTL_BENCHMARKS, CXXRTL_SCALES
+
+basedir = Path(__file__).resolve().parent
+
+parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('-y', '--yosys', default=str(basedir / '../../yosys'),
+                    help='yosys executable to benchmark')
+parser.add_argument('--cxx', default=os.environ.get('CXX', 'c++'), help='C++ compiler')
+parser.add_argument('--cxxflags', default='-std=c++14 -O2', help='flags for compiling the models')
+parser.add_argument('-s', '--scale', choices=CXXRTL_SCALES.keys(), default='small',
+                    help='size of the generated designs')
+parser.add_argument('-O', '--levels', default='0,1,2,3,4,5,6',
+                    help='comma separated write_cxxrtl optimization levels')
+parser.add_argument('-c', '--cycles', type=int, default=20000, help='clock cycles to simulate')
+parser.add_argument('-r', '--repeat', type=int, default=1,
+                    help='run each simulation this many times and keep the fastest run')
+parser.add_argument('-o', '--output', default='cxxrtl.json', help='JSON file to write')
+parser.add_argument('-w', '--workdir', default='work', help='directory for generated files')
+parser.add_argument('benchmarks', nargs='*', help='benchmarks to run (default: all)')
+args = parser.parse_args()
+
+if os.sep in args.yosys:
+    args.yosys = str(Path(args.yosys).resolve())
+runtime = (basedir / '../../backends/cxxrtl/runtime').resolve()
+driver = basedir / 'cxxrtl_bench.cc'
+
+workdir = Path(args.workdir)
+workdir.mkdir(parents=True, exist_ok=True)
+
+selected = args.benchmarks or list(CXXRTL_BENCHMARKS.keys())
+for name in selected:
+    if name not in CXXRTL_BENCHMARKS:
+        parser.error(f"unknown benchmark '{name}', available: {', '.join(CXXRTL_BENCHMARKS.keys())}")
+
+def run(cmd, what):
+    start = time.perf_counter()
+    proc = subprocess.run(cmd, cwd=workdir, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if proc.returncode != 0:
+        raise SystemExit(f"{what} failed:\n{proc.stdout}")
+    return time.perf_counter() - start, proc.stdout
+
+results = {"kind": "cxxrtl", "scale": args.scale, "cycles": args.cycles, "benchmarks": {}}
+
+for name in selected:
+    params = CXXRTL_SCALES[args.scale][name]
+    verilog = workdir / f"{name}.v"
+    verilog.write_text(CXXRTL_BENCHMARKS[name](**params))
+
+    checksum = None
+    levels = {}
+    for level in args.levels.split(','):
+        model = f"{name}_O{level}.cc"
+        binary = f"{name}_O{level}"
+        perffile = f"{model}.perf.json"
+        run([args.yosys, '-q', '--perffile', perffile, '-l', f"{model}.log",
+             '-p', f"read_verilog {verilog.name}; hierarchy -top top; write_cxxrtl -O{level} {model}"],
+            f"write_cxxrtl -O{level} on {name}")
+        with open(workdir / perffile) as f:
+            perf = json.load(f)
+        results["generator"] = perf["generator"]
+
+        compile_s, _ = run([*shlex.split(args.cxx), *shlex.split(args.cxxflags), '-I', str(runtime),
+                            f"-DBENCH_DESIGN=\"{model}\"", '-o', binary, str(driver)],
+                           f"compiling {model}")
+
+        sim = None
+        for _ in range(args.repeat):
+            _, output = run([f"./{binary}", str(args.cycles)], f"simulating {binary}")
+            data = json.loads(output)
+            if sim is None or data["cycles_per_s"] > sim["cycles_per_s"]:
+                sim = data
+        if checksum is not None and sim["checksum"] != checksum:
+            print(f"warning: {binary} computed different outputs than at the previous level")
+        checksum = sim["checksum"]
+
+        levels[f"O{level}"] = {
+            "write_ns": perf["passes"]["write_cxxrtl"]["runtime_ns"],
+            "compile_s": round(compile_s, 4),
+            "code_bytes": (workdir / model).stat().st_size,
+            "binary_bytes": (workdir / binary).stat().st_size,
+            "cycles_per_s": sim["cycles_per_s"],
+        }
+        print(f"{name:12s} -O{level} {levels[f'O{level}']['write_ns'] / 1e9:8.3f} s write "
+              f"{compile_s:8.2f} s compile {levels[f'O{level}']['code_bytes'] / 1024:9.1f} KB "
+              f"{sim['cycles_per_s']:14.1f} cycles/s")
+
+    results["benchmarks"][name] = {"params": params, "levels": levels}
+
+with open(args.output, "w") as f:
+    json.dump(results, f, indent=2)
+    f.write("\n")
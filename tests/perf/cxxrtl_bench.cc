@@ -0,0 +1,76 @@
+// Simulation driver for the benchmarks of cxxrtl.py. The generated design is
+// included with -DBENCH_DESIGN='"<file>.cc"'. The top module is clocked
+// through its `clk` input for the given number of cycles while all other
+// inputs get pseudo random values, with `rst` only set for the first cycles.
+// Prints the number of cycles simulated per second and a checksum of the
+// outputs, which must not depend on the optimization level.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include BENCH_DESIGN
+
+int main(int argc, char **argv)
+{
+	long cycles = argc > 1 ? atol(argv[1]) : 100000;
+
+	cxxrtl_design::p_top top;
+	cxxrtl::debug_items items;
+	top.debug_info(&items, nullptr, "");
+
+	cxxrtl::debug_item *clk = nullptr, *rst = nullptr;
+	std::vector<cxxrtl::debug_item*> inputs, outputs;
+	for (auto &it : items.table) {
+		// only the ports of the top module, which have no scope
+		if (it.first.find(' ') != std::string::npos)
+			continue;
+		for (auto &part : it.second) {
+			if ((part.flags & cxxrtl::debug_item::INPUT) && part.next != nullptr) {
+				if (it.first == "clk")
+					clk = &part;
+				else if (it.first == "rst")
+					rst = &part;
+				else
+					inputs.push_back(&part);
+			} else if (part.flags & cxxrtl::debug_item::OUTPUT) {
+				outputs.push_back(&part);
+			}
+		}
+	}
+	if (clk == nullptr) {
+		fprintf(stderr, "The design has no clk input.\n");
+		return 1;
+	}
+
+	uint32_t seed = 1;
+	uint64_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (long cycle = 0; cycle < cycles; cycle++) {
+		for (auto input : inputs) {
+			size_t chunks = (input->width + 31) / 32;
+			for (size_t i = 0; i < chunks; i++) {
+				seed ^= seed << 13, seed ^= seed >> 17, seed ^= seed << 5;
+				input->next[i] = seed;
+			}
+			if (input->width % 32 != 0)
+				input->next[chunks - 1] &= (1u << (input->width % 32)) - 1;
+		}
+		if (rst != nullptr)
+			rst->next[0] = cycle < 2;
+		clk->next[0] = 0;
+		top.step();
+		clk->next[0] = 1;
+		top.step();
+		for (auto output : outputs)
+			checksum = checksum * 31 + output->curr[0];
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	printf("{\"cycles\": %ld, \"seconds\": %.6f, \"cycles_per_s\": %.1f, \"checksum\": \"%016llx\"}\n",
+		cycles, elapsed.count(), cycles / elapsed.count(), (unsigned long long)checksum);
+	return 0;
+}
@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+#
+# Generators for the synthetic benchmark designs used by run.py. Each one is
+# parameterized so that the same structure can be scaled up, see SCALES.
+
+import sys
+import argparse
+
+
+class Benchmark:
+    def __init__(self, generate, passes):
+        self.generate = generate
+        self.passes = passes
+
+    def script(self, verilog, name):
+        lines = [f"read_verilog {verilog}", "hierarchy -top top"]
+        lines += self.passes
+        lines += [f"write_rtlil {name}.il", f"write_verilog -noattr {name}_out.v", f"write_json {name}.json"]
+        return "\n".join(lines) + "\n"
+
+
+# a balanced tree of adders over 2**depth inputs, registered at the output
+def adder_tree(depth, width):
+    n = 2 ** depth
+    out = []
+    out.append(f"module top(input clk, input [{n * width - 1}:0] in, output reg [{width + depth - 1}:0] y);")
+    level = [f"in[{i * width} +: {width}]" for i in range(n)]
+    for d in range(depth):
+        w = width + d + 1
+        nxt = []
+        for i in range(0, len(level), 2):
+            wire = f"s{d}_{i // 2}"
+            out.append(f"wire [{w - 1}:0] {wire} = {level[i]} + {level[i + 1]};")
+            nxt.append(wire)
+        level = nxt
+    out.append(f"always @(posedge clk) y <= {level[0]};")
+    out.append("endmodule")
+    return "\n".join(out) + "\n"
+
+
+# nested case statements that become trees of wide $pmux cells
+def pmux_tree(levels, cases, width):
+    sel_bits = max(1, (cases - 1).bit_length())
+    out = []
+    out.append(f"module top(input clk, input [{levels * sel_bits - 1}:0] sel, "
+               f"input [{cases * width - 1}:0] in, output reg [{width - 1}:0] out);")
+    for l in range(levels):
+        out.append(f"reg [{width - 1}:0] m{l};")
+    out.append("always @* begin")
+    for l in range(levels):
+        prev = "in" if l == 0 else f"m{l - 1}"
+        out.append(f"  case (sel[{l * sel_bits} +: {sel_bits}])")
+        for c in range(cases):
+            if l == 0:
+                src = f"in[{c * width} +: {width}]"
+            else:
+                src = f"{prev} ^ in[{c * width} +: {width}]" if c % 2 else f"{prev} + {c}"
+            out.append(f"    {c}: m{l} = {src};")
+        out.append(f"    default: m{l} = {width}'d0;")
+        out.append("  endcase")
+    out.append("end")
+    out.append(f"always @(posedge clk) out <= m{levels - 1};")
+    out.append("endmodule")
+    return "\n".join(out) + "\n"
+
+
+# a hierarchy of `levels` levels with `fanout` instances per level, so that
+# flatten has fanout**levels leaf instances to inline
+def hierarchy(levels, fanout, width):
+    out = []
+    out.append(f"module leaf(input clk, input [{width - 1}:0] a, b, output reg [{width - 1}:0] y);")
+    out.append("always @(posedge clk) y <= (a & b) + (a ^ b);")
+    out.append("endmodule")
+    child = "leaf"
+    for l in range(levels):
+        name = "top" if l == levels - 1 else f"level{l}"
+        out.append(f"module {name}(input clk, input [{width - 1}:0] a, b, output [{width - 1}:0] y);")
+        for i in range(1, fanout + 1):
+            out.append(f"wire [{width - 1}:0] c{i};")
+        for i in range(fanout):
+            out.append(f"{child} u{i} (.clk(clk), .a({'a' if i == 0 else f'c{i}'}), .b(b), .y(c{i + 1}));")
+        out.append(f"assign y = c{fanout};")
+        out.append("endmodule")
+        child = name
+    return "\n".join(out) + "\n"
+
+
+# `count` memories with two write ports and two read ports each
+def memory(count, abits, dbits):
+    out = []
+    out.append(f"module top(input clk, input [{abits - 1}:0] wa0, wa1, ra0, ra1, "
+               f"input [{dbits - 1}:0] wd0, wd1, input we0, we1, output [{dbits - 1}:0] rd);")
+    for i in range(count):
+        out.append(f"reg [{dbits - 1}:0] mem{i} [0:{2 ** abits - 1}];")
+        out.append(f"reg [{dbits - 1}:0] q{i}a, q{i}b;")
+        out.append(f"always @(posedge clk) begin")
+        out.append(f"  if (we0) mem{i}[wa0] <= wd0 ^ {i};")
+        out.append(f"  if (we1) mem{i}[wa1] <= wd1 + {i};")
+        out.append(f"  q{i}a <= mem{i}[ra0];")
+        out.append(f"  q{i}b <= mem{i}[ra1 ^ {i}];")
+        out.append("end")
+    out.append("assign rd = " + " ^ ".join(f"q{i}a ^ q{i}b" for i in range(count)) + ";")
+    out.append("endmodule")
+    return "\n".join(out) + "\n"
+
+
+# a small load/store CPU with `regs` (at most 16) registers of `width` bits
+# running a random program of `length` instructions from a ROM; instructions
+# are op[31:28] rd[27:24] ra[23:20] rb[19:16] imm[15:0]
+def cpu(regs, width, length, dwords, seed=1):
+    assert regs <= 16
+    rbits = max(1, (regs - 1).bit_length())
+    pbits = max(1, (length - 1).bit_length())
+    dbits = max(1, (dwords - 1).bit_length())
+    def rand():
+        nonlocal seed
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff
+        return seed >> 8
+    out = []
+    out.append(f"module top(input clk, rst, input [{width - 1}:0] in, output reg [{width - 1}:0] out);")
+    out.append(f"reg [31:0] rom [0:{length - 1}];")
+    out.append("initial begin")
+    for i in range(length):
+        op = rand() % 12
+        insn = (op << 28) | ((rand() % regs) << 24) | ((rand() % regs) << 20) | ((rand() % regs) << 16) | (rand() & 0xffff)
+        out.append(f"  rom[{i}] = 32'h{insn:08x};")
+    out.append("end")
+    out.append(f"reg [{width - 1}:0] rf [0:{regs - 1}];")
+    out.append(f"reg [{width - 1}:0] dmem [0:{dwords - 1}];")
+    out.append(f"reg [{pbits - 1}:0] pc;")
+    out.append(f"wire [31:0] insn = rom[pc];")
+    out.append(f"wire [3:0] op = insn[31:28];")
+    out.append(f"wire [{rbits - 1}:0] rd = insn[24 +: {rbits}], ra = insn[20 +: {rbits}], rb = insn[16 +: {rbits}];")
+    out.append(f"wire [{width - 1}:0] a = rf[ra], b = rf[rb], imm = {{{{{width - 16}{{insn[15]}}}}, insn[15:0]}};")
+    out.append(f"reg [{width - 1}:0] res;")
+    out.append("reg wr, taken;")
+    out.append("always @* begin")
+    out.append("  wr = 1; taken = 0; res = 0;")
+    out.append("  case (op)")
+    out.append("    0: res = a + b;")
+    out.append("    1: res = a - b;")
+    out.append("    2: res = a ^ b;")
+    out.append("    3: res = a & b;")
+    out.append("    4: res = a | b;")
+    out.append("    5: res = a << b[4:0];")
+    out.append("    6: res = a >> b[4:0];")
+    out.append("    7: res = a + imm;")
+    out.append(f"    8: res = dmem[a[{dbits - 1}:0] ^ imm[{dbits - 1}:0]];")
+    out.append("    9: wr = 0;")
+    out.append("    10: begin wr = 0; taken = a == b; end")
+    out.append("    default: res = in ^ a;")
+    out.append("  endcase")
+    out.append("end")
+    out.append("always @(posedge clk) begin")
+    out.append("  if (rst) begin")
+    out.append("    pc <= 0;")
+    out.append("    out <= 0;")
+    out.append("  end else begin")
+    out.append(f"    pc <= taken ? insn[{pbits - 1}:0] : pc + 1;")
+    out.append("    if (wr) rf[rd] <= res;")
+    out.append(f"    if (op == 9) dmem[a[{dbits - 1}:0] ^ imm[{dbits - 1}:0]] <= b;")
+    out.append("    out <= out ^ res;")
+    out.append("  end")
+    out.append("end")
+    out.append("endmodule")
+    return "\n".join(out) + "\n"
+
+
+# `stages` pipeline stages of wide multiply, shift and xor over `width` bits
+def datapath(width, stages):
+    out = []
+    out.append(f"module top(input clk, input [{width - 1}:0] in, output [{width - 1}:0] y);")
+    prev = "in"
+    for i in range(stages):
+        out.append(f"reg [{width - 1}:0] p{i};")
+        k = (0x9e3779b97f4a7c15 * (i + 1)) & ((1 << 64) - 1)
+        out.append(f"always @(posedge clk) p{i} <= ({prev} * {width}'h{k:x}) ^ ({prev} >> {i % 13 + 3}) ^ in;")
+        prev = f"p{i}"
+    out.append(f"assign y = {prev};")
+    out.append("endmodule")
+    return "\n".join(out) + "\n"
+
+
+BENCHMARKS = {
+    "adder_tree": Benchmark(adder_tree, ["proc", "opt", "alumacc", "opt", "techmap", "opt -fast", "abc -fast", "opt_clean"]),
+    "pmux_tree": Benchmark(pmux_tree, ["proc", "opt", "opt -full", "techmap", "opt -fast", "abc -fast", "opt_clean"]),
+    "hierarchy": Benchmark(hierarchy, ["proc", "flatten", "opt", "techmap", "opt -fast", "abc -fast", "opt_clean"]),
+    "memory": Benchmark(memory, ["proc", "opt", "memory", "opt", "techmap", "opt -fast", "abc -fast", "opt_clean"]),
+}
+
+SCALES = {
+    "small": {
+        "adder_tree": dict(depth=6, width=16),
+        "pmux_tree": dict(levels=4, cases=32, width=16),
+        "hierarchy": dict(levels=3, fanout=8, width=8),
+        "memory": dict(count=4, abits=6, dbits=16),
+    },
+    "medium": {
+        "adder_tree": dict(depth=9, width=24),
+        "pmux_tree": dict(levels=8, cases=128, width=32),
+        "hierarchy": dict(levels=4, fanout=12, width=16),
+        "memory": dict(count=16, abits=8, dbits=32),
+    },
+    "large": {
+        "adder_tree": dict(depth=12, width=32),
+        "pmux_tree": dict(levels=16, cases=256, width=64),
+        "hierarchy": dict(levels=4, fanout=20, width=16),
+        "memory": dict(count=32, abits=10, dbits=32),
+    },
+}
+
+# the designs simulated by cxxrtl.py; all have a top module with a `clk`
+# input, an optional `rst` input and other inputs that get random values
+CXXRTL_BENCHMARKS = {
+    "cpu": cpu,
+    "datapath": datapath,
+    "memory": memory,
+    "hierarchy": hierarchy,
+}
+
+CXXRTL_SCALES = {
+    "small": {
+        "cpu": dict(regs=16, width=32, length=256, dwords=256),
+        "datapath": dict(width=256, stages=8),
+        "memory": dict(count=4, abits=6, dbits=16),
+        "hierarchy": dict(levels=3, fanout=8, width=8),
+    },
+    "medium": {
+        "cpu": dict(regs=16, width=32, length=1024, dwords=1024),
+        "datapath": dict(width=1024, stages=16),
+        "memory": dict(count=16, abits=8, dbits=32),
+        "hierarchy": dict(levels=4, fanout=12, width=16),
+    },
+    "large": {
+        "cpu": dict(regs=16, width=64, length=4096, dwords=4096),
+        "datapath": dict(width=4096, stages=32),
+        "memory": dict(count=32, abits=10, dbits=32),
+        "hierarchy": dict(levels=4, fanout=20, width=16),
+    },
+}
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="print a generated benchmark design")
+    parser.add_argument('benchmark', choices=BENCHMARKS.keys())
+    parser.add_argument('-s', '--scale', choices=SCALES.keys(), default='small')
+    parser.add_argument('--script', action='store_true', help='print the yosys script instead')
+    args = parser.parse_args()
+    if args.script:
+        sys.stdout.write(BENCHMARKS[args.benchmark].script(f"{args.benchmark}.v", args.benchmark))
+    else:
+        sys.stdout.write(BENCHMARKS[args.benchmark].generate(**SCALES[args.scale][args.benchmark]))
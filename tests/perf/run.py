@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+#
+# Runs synthetic benchmark designs through the key passes of yosys and writes
+# the runtime and memory use of each run as JSON:
+#
+#   python3 run.py -o results.json
+#   python3 compare.py baseline.json results.json
+#
+# The pass times and memory stats come from 'yosys --perffile', the peak RSS
+# and wall time of the whole run are measured here.
+
+import os
+import json
+import time
+import argparse
+import subprocess
+from pathlib import Path
+
+from generate import BENCHMARKS, SCALES
+
+parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('-y', '--yosys', default=str(Path(__file__).resolve().parent / '../../yosys'),
+                    help='yosys executable to benchmark')
+parser.add_argument('-s', '--scale', choices=SCALES.keys(), default='small',
+                    help='size of the generated designs')
+parser.add_argument('-r', '--repeat', type=int, default=1,
+                    help='run each benchmark this many times and keep the fastest run')
+parser.add_argument('-j', '--jobs', type=int, default=1,
+                    help='threads for yosys passes that can process modules in parallel')
+parser.add_argument('-o', '--output', default='perf.json', help='JSON file to write')
+parser.add_argument('-w', '--workdir', default='work', help='directory for generated files')
+parser.add_argument('benchmarks', nargs='*', help='benchmarks to run (default: all)')
+args = parser.parse_args()
+
+if os.sep in args.yosys:
+    args.yosys = str(Path(args.yosys).resolve())
+
+workdir = Path(args.workdir)
+workdir.mkdir(parents=True, exist_ok=True)
+
+selected = args.benchmarks or list(BENCHMARKS.keys())
+for name in selected:
+    if name not in BENCHMARKS:
+        parser.error(f"unknown benchmark '{name}', available: {', '.join(BENCHMARKS.keys())}")
+
+def run_yosys(script, perffile, logfile):
+    cmd = [args.yosys, '-q', '-j', str(args.jobs), '--perffile', str(perffile), '-l', str(logfile), '-s', str(script)]
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, cwd=workdir, stdout=subprocess.DEVNULL)
+    _, status, rusage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    if os.waitstatus_to_exitcode(status) != 0:
+        raise SystemExit(f"yosys failed on {script}, see {workdir / logfile}")
+    # ru_maxrss is in kilobytes on Linux and in bytes on macOS
+    peak_rss = rusage.ru_maxrss if os.uname().sysname == 'Darwin' else rusage.ru_maxrss * 1024
+    with open(workdir / perffile) as f:
+        perf = json.load(f)
+    return wall, peak_rss, perf
+
+results = {"scale": args.scale, "jobs": args.jobs, "benchmarks": {}}
+
+for name in selected:
+    params = SCALES[args.scale][name]
+    verilog = workdir / f"{name}.v"
+    script = workdir / f"{name}.ys"
+    verilog.write_text(BENCHMARKS[name].generate(**params))
+    script.write_text(BENCHMARKS[name].script(verilog.name, name))
+
+    best = None
+    for _ in range(args.repeat):
+        run = run_yosys(script.name, f"{name}.perf.json", f"{name}.log")
+        if best is None or run[0] < best[0]:
+            best = run
+
+    wall, peak_rss, perf = best
+    results["generator"] = perf["generator"]
+    results["benchmarks"][name] = {
+        "params": params,
+        "wall_s": round(wall, 4),
+        "peak_rss_bytes": peak_rss,
+        "passes": {
+            pass_name: {key: data[key] for key in ("runtime_ns", "num_calls", "peak_rss_bytes")}
+            for pass_name, data in perf["passes"].items()
+        },
+    }
+    print(f"{name:16s} {wall:8.2f} s {peak_rss / (1024 * 1024):9.1f} MB")
+
+with open(args.output, "w") as f:
+    json.dump(results, f, indent=2)
+    f.write("\n")
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "kernel/consteval64.h"
+#include "kernel/consteval.h"
+
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelConstEval64Test, MatchesConstEval)
+{
+	Design design;
+	Module *mod = design.addModule(ID(top));
+	Wire *a = mod->addWire(ID(a), 6);
+	Wire *b = mod->addWire(ID(b), 4);
+	Wire *s = mod->addWire(ID(s), 1);
+
+	std::vector<SigSpec> outputs;
+	auto out = [&](int width) {
+		Wire *w = mod->addWire(NEW_ID, width);
+		outputs.push_back(w);
+		return SigSpec(w);
+	};
+
+	for (bool is_signed : {false, true}) {
+		mod->addAdd(NEW_ID, a, b, out(7), is_signed);
+		mod->addSub(NEW_ID, a, b, out(5), is_signed);
+		mod->addMul(NEW_ID, a, b, out(8), is_signed);
+		mod->addNeg(NEW_ID, b, out(6), is_signed);
+		mod->addNot(NEW_ID, b, out(6), is_signed);
+		mod->addXor(NEW_ID, a, b, out(7), is_signed);
+		mod->addEq(NEW_ID, a, b, out(1), is_signed);
+		mod->addLt(NEW_ID, a, b, out(1), is_signed);
+		mod->addGe(NEW_ID, b, a, out(2), is_signed);
+		mod->addShl(NEW_ID, a, b, out(8), is_signed);
+		mod->addShr(NEW_ID, a, b, out(8), is_signed);
+		mod->addSshr(NEW_ID, a, b, out(5), is_signed);
+		mod->addReduceXor(NEW_ID, a, out(1), is_signed);
+		mod->addLogicAnd(NEW_ID, a, b, out(1), is_signed);
+	}
+	SigSpec b6 = b;
+	b6.extend_u0(6);
+	mod->addMux(NEW_ID, a, b6, s, out(6));
+	mod->addPmux(NEW_ID, SigSpec(b), SigSpec({SigSpec(a).extract(0, 4), SigSpec(b)}), SigSpec({SigBit(a, 5), SigBit(s)}), out(4));
+	mod->addMuxGate(NEW_ID, SigBit(a, 0), SigBit(b, 0), s, out(1));
+	mod->addAoi3Gate(NEW_ID, SigBit(a, 1), SigBit(b, 1), SigBit(a, 2), out(1));
+	// not natively supported, goes through CellTypes::eval() per lane
+	mod->addDiv(NEW_ID, a, b, out(6), false);
+
+	ConstEval64 ce64(mod);
+	std::mt19937 rng(1);
+	std::vector<uint64_t> lanes_a(6), lanes_b(4), lanes_s(1);
+	for (auto &w : lanes_a) w = uint64_t(rng()) << 32 | rng();
+	for (auto &w : lanes_b) w = uint64_t(rng()) << 32 | rng();
+	for (auto &w : lanes_s) w = uint64_t(rng()) << 32 | rng();
+	// make sure every mux input is selected in some lane, and both
+	// $pmux selects are never active at once
+	lanes_a[5] &= ~lanes_s[0];
+	ce64.set(a, lanes_a);
+	ce64.set(b, lanes_b);
+	ce64.set(s, lanes_s);
+
+	std::vector<std::vector<uint64_t>> results(outputs.size());
+	for (size_t i = 0; i < outputs.size(); i++)
+		ASSERT_TRUE(ce64.eval(outputs[i], results[i]));
+
+	for (int k = 0; k < 64; k++) {
+		ConstEval ce(mod);
+		ce.set(a, ConstEval64::lane(lanes_a, k));
+		ce.set(b, ConstEval64::lane(lanes_b, k));
+		ce.set(s, ConstEval64::lane(lanes_s, k));
+		for (size_t i = 0; i < outputs.size(); i++) {
+			SigSpec sig = outputs[i];
+			ASSERT_TRUE(ce.eval(sig));
+			EXPECT_EQ(ConstEval64::lane(results[i], k), sig.as_const()) << log_signal(outputs[i]) << " lane " << k;
+		}
+	}
+
+	// unset inputs are reported
+	ConstEval64 partial(mod);
+	partial.set(b, lanes_b);
+	std::vector<uint64_t> y;
+	SigSpec undef;
+	EXPECT_FALSE(partial.eval(outputs[0], y, undef));
+	EXPECT_EQ(undef, SigSpec(a));
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "kernel/contenthash.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelContentHashTest, Xxh64Vectors)
+{
+	// the first half of the digest is plain XXH64 with seed 0
+	EXPECT_EQ(content_hash("").substr(0, 16), "ef46db3751d8e999");
+	EXPECT_EQ(content_hash("abc").substr(0, 16), "44bc2cf5ad770999");
+	EXPECT_EQ(content_hash("Nobody inspects the spammish repetition").substr(0, 16), "fbcea83c8a378bf1");
+}
+
+TEST(KernelContentHashTest, Streaming)
+{
+	std::string data;
+	for (int i = 0; i < 1000; i++)
+		data += char(i * 7);
+
+	ContentHash hasher;
+	for (size_t i = 0; i < data.size(); i += 13)
+		hasher.update_bytes(data.data() + i, std::min<size_t>(13, data.size() - i));
+	EXPECT_EQ(hasher.hexdigest(), content_hash(data));
+
+	// updates with a length prefix are not confused by moving the boundary
+	ContentHash a, b;
+	a.update("ab");
+	a.update("c");
+	b.update("a");
+	b.update("bc");
+	EXPECT_NE(a.hexdigest(), b.hexdigest());
+}
+
+static Module *build(Design &design, int width)
+{
+	Module *mod = design.addModule(ID(top));
+	Wire *a = mod->addWire(ID(a), width);
+	Wire *y = mod->addWire(ID(y), width);
+	a->port_input = true;
+	y->port_output = true;
+	mod->fixup_ports();
+	mod->addNot(ID(inv), a, y);
+	mod->set_bool_attribute(ID::keep);
+	return mod;
+}
+
+TEST(KernelContentHashTest, Module)
+{
+	// the hash only depends on the contents, not on the design or on the
+	// order in which names were created
+	Design design1, design2;
+	IdString unrelated("\\unrelated_name_created_first");
+	Module *mod1 = build(design1, 4);
+	Module *mod2 = build(design2, 4);
+
+	ContentHash h1, h2;
+	h1.update(mod1);
+	h2.update(mod2);
+	EXPECT_EQ(h1.hexdigest(), h2.hexdigest());
+
+	Design design3;
+	Module *mod3 = build(design3, 4);
+	mod3->cell(ID(inv))->setParam(ID::A_SIGNED, true);
+	ContentHash h3;
+	h3.update(mod3);
+	EXPECT_NE(h1.hexdigest(), h3.hexdigest());
+
+	Design design4;
+	ContentHash h4;
+	h4.update(build(design4, 5));
+	EXPECT_NE(h1.hexdigest(), h4.hexdigest());
+}
+
+YOSYS_NAMESPACE_END
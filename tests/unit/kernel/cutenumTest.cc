@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "kernel/cutenum.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelCutEnumTest, TruthTables)
+{
+	uint64_t a = tt_var(0) & tt_mask(2), b = tt_var(1) & tt_mask(2);
+	EXPECT_EQ(a & b, 0x8u);
+	EXPECT_EQ(tt_permute(a & ~b & tt_mask(2), 2, {1, 0}), ~a & b & tt_mask(2));
+	EXPECT_EQ(tt_negate_input(a & b, 2, 0), ~a & b & tt_mask(2));
+
+	// a & ~b and ~a & b are in the same P class, all ANDs and ORs of two
+	// inputs are in the same NPN class
+	EXPECT_EQ(tt_p_canonical(a & ~b & tt_mask(2), 2), tt_p_canonical(~a & b & tt_mask(2), 2));
+	EXPECT_EQ(tt_npn_canonical(a & b, 2), tt_npn_canonical(a | b, 2));
+	EXPECT_NE(tt_npn_canonical(a & b, 2), tt_npn_canonical(a ^ b, 2));
+
+	// the upper half of a 6-input truth table is not lost
+	EXPECT_EQ(tt_permute(tt_var(5), 6, {1, 2, 3, 4, 5, 0}), tt_var(0));
+}
+
+TEST(KernelCutEnumTest, FullAdder)
+{
+	Design design;
+	Module *mod = design.addModule(ID(top));
+	Wire *a = mod->addWire(ID(a)), *b = mod->addWire(ID(b)), *c = mod->addWire(ID(c));
+	SigBit ab = mod->XorGate(NEW_ID, a, b);
+	SigBit sum = mod->XorGate(NEW_ID, ab, c);
+	SigBit carry = mod->OrGate(NEW_ID, mod->AndGate(NEW_ID, a, b), mod->AndGate(NEW_ID, ab, c));
+
+	SigMap sigmap(mod);
+	CutEnum cutenum(sigmap, 3);
+	for (auto cell : mod->cells())
+		EXPECT_TRUE(cutenum.add_cell(cell));
+	cutenum.run(&design);
+
+	auto find_cut = [&](SigBit root) {
+		for (auto &cut : cutenum.cuts(cutenum.node(root)))
+			if (GetSize(cut.leaves) == 3)
+				return cut;
+		return CutEnum::Cut{{}, 0, 0};
+	};
+
+	// both functions are symmetric, so the order of the leaves does not matter
+	pool<SigBit> inputs = {a, b, c};
+	CutEnum::Cut sum_cut = find_cut(sum), carry_cut = find_cut(carry);
+	ASSERT_EQ(GetSize(sum_cut.leaves), 3);
+	for (int leaf : sum_cut.leaves)
+		EXPECT_TRUE(inputs.count(cutenum.bit(leaf)));
+	EXPECT_EQ(sum_cut.truth, 0x96u);
+	EXPECT_EQ(sum_cut.depth, 2);
+	ASSERT_EQ(GetSize(carry_cut.leaves), 3);
+	for (int leaf : carry_cut.leaves)
+		EXPECT_TRUE(inputs.count(cutenum.bit(leaf)));
+	EXPECT_EQ(carry_cut.truth, 0xe8u);
+	EXPECT_EQ(cutenum.cuts(cutenum.node(a)).size(), 1u);
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include "kernel/ff.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelFfTest, CachedFfData)
+{
+	Design design;
+	Module *mod = design.addModule(ID(top));
+	Wire *clk = mod->addWire(ID(clk));
+	Wire *d = mod->addWire(ID(d), 2);
+	Wire *q = mod->addWire(ID(q), 2);
+	q->attributes[ID::init] = Const(1, 2);
+	Cell *cell = mod->addDff(ID(ff), clk, d, q);
+
+	FfCache &cache = FfCache::cached(mod);
+	EXPECT_EQ(&FfCache::cached(mod), &cache);
+	FfData ff = cache.ff(cell);
+	EXPECT_TRUE(ff.has_clk);
+	EXPECT_EQ(ff.val_init, Const(1, 2));
+
+	// changes through the cached init values are seen by the parsed FFs
+	cache.initvals.set_init(SigSpec(q), Const(2, 2));
+	EXPECT_EQ(&FfCache::cached(mod), &cache);
+	EXPECT_EQ(cache.ff(cell).val_init, Const(2, 2));
+
+	// direct changes are seen once the init generation is bumped
+	q->attributes[ID::init] = Const(3, 2);
+	mod->init_generation_++;
+	EXPECT_EQ(FfCache::cached(mod).ff(cell).val_init, Const(3, 2));
+
+	// a port change drops the parsed FF
+	Wire *en = mod->addWire(ID(en));
+	cell->type = ID($dffe);
+	cell->setPort(ID::EN, en);
+	cell->setParam(ID::EN_POLARITY, true);
+	FfData ff2 = FfCache::cached(mod).ff(cell);
+	EXPECT_TRUE(ff2.has_ce);
+	EXPECT_EQ(ff2.sig_ce, SigSpec(en));
+	EXPECT_EQ(ff2.val_init, Const(3, 2));
+
+	// a new connection rebuilds the sigmap
+	Wire *r = mod->addWire(ID(r), 2);
+	mod->connect(r, q);
+	EXPECT_EQ(FfCache::cached(mod).initvals(SigSpec(r)), Const(3, 2));
+
+	delete mod->cached_ffs_;
+	mod->cached_ffs_ = nullptr;
+	EXPECT_TRUE(mod->monitors.empty());
+}
+
+YOSYS_NAMESPACE_END
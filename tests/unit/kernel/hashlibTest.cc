@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys_common.h"
+
+#include <map>
+#include <random>
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelHashlibTest, FlatDictMatchesDict)
+{
+	dict<int, int> ref;
+	flat_dict<int, int> d;
+	std::mt19937 rng(42);
+
+	for (int i = 0; i < 20000; i++) {
+		int key = rng() % 2000;
+		switch (rng() % 4) {
+		case 0:
+			EXPECT_EQ(d.erase(key), ref.erase(key));
+			break;
+		case 1:
+			EXPECT_EQ(d.count(key), ref.count(key));
+			break;
+		default:
+			d[key] += i;
+			ref[key] += i;
+			break;
+		}
+	}
+
+	ASSERT_EQ(d.size(), ref.size());
+	auto it = d.begin();
+	for (auto &ref_it : ref) {
+		ASSERT_NE(it, d.end());
+		EXPECT_EQ(*it, ref_it);
+		++it;
+	}
+	EXPECT_EQ(it, d.end());
+}
+
+TEST(KernelHashlibTest, FlatPoolMatchesPool)
+{
+	pool<std::string> ref;
+	flat_pool<std::string> p;
+
+	for (int i = 0; i < 1000; i++) {
+		std::string key = stringf("key%d", (i * 37) % 500);
+		EXPECT_EQ(p.insert(key).second, ref.insert(key).second);
+		if (i % 3 == 0) {
+			std::string erase_key = stringf("key%d", i % 500);
+			EXPECT_EQ(p.erase(erase_key), ref.erase(erase_key));
+		}
+	}
+
+	ASSERT_EQ(p.size(), ref.size());
+	auto it = p.begin();
+	for (auto &key : ref) {
+		EXPECT_EQ(*it, key);
+		++it;
+	}
+
+	flat_pool<std::string> copy = p;
+	EXPECT_EQ(copy, p);
+	copy.sort();
+	EXPECT_EQ(copy, p);
+	EXPECT_EQ(*copy.begin(), *std::min_element(ref.begin(), ref.end()));
+}
+
+TEST(KernelHashlibTest, IdictIndices)
+{
+	idict<std::string> ids;
+	for (int i = 0; i < 100; i++)
+		EXPECT_EQ(ids(stringf("id%d", i)), i);
+	for (int i = 99; i >= 0; i--)
+		EXPECT_EQ(ids(stringf("id%d", i)), i);
+	EXPECT_EQ(ids.at("id7"), 7);
+	EXPECT_EQ(ids.at("missing", -1), -1);
+	EXPECT_EQ(ids[42], "id42");
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "kernel/modgraph.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelModgraphTest, DriversAndSinks)
+{
+	Design design;
+	Module *mod = design.addModule(ID(top));
+	Wire *a = mod->addWire(ID(a), 2);
+	a->port_input = true;
+	Wire *y = mod->addWire(ID(y), 2);
+	y->port_output = true;
+	Wire *t = mod->addWire(ID(t), 2);
+	Wire *alias = mod->addWire(ID(alias), 2);
+	mod->connect(alias, t);
+	mod->fixup_ports();
+
+	Cell *inv = mod->addNot(ID(inv), a, t);
+	Cell *conj = mod->addAnd(ID(conj), alias, SigSpec({State::S1, SigBit(a, 0)}), y);
+
+	CellTypes ct;
+	ct.setup_internals();
+	ModuleGraph graph(mod, &ct);
+	EXPECT_EQ(graph.num_cells(), 2);
+	EXPECT_EQ(graph.num_nets(), 6);
+	EXPECT_EQ(graph.cell(graph.cell_index(inv)), inv);
+	EXPECT_EQ(graph.net_index(State::S1), -1);
+
+	// bits connected through the module's connections share a net
+	int net = graph.net_index(SigBit(t, 1));
+	EXPECT_EQ(net, graph.net_index(SigBit(alias, 1)));
+	ASSERT_EQ(graph.drivers(net).size(), 1);
+	EXPECT_EQ(graph.drivers(net)[0].cell, graph.cell_index(inv));
+	EXPECT_EQ(graph.drivers(net)[0].port, ID::Y);
+	EXPECT_EQ(graph.drivers(net)[0].offset, 1);
+	ASSERT_EQ(graph.sinks(net).size(), 1);
+	EXPECT_EQ(graph.sinks(net)[0].cell, graph.cell_index(conj));
+	EXPECT_EQ(graph.sinks(net)[0].port, ID::A);
+
+	int a0 = graph.net_index(SigBit(a, 0));
+	EXPECT_TRUE(graph.is_module_input(a0));
+	EXPECT_FALSE(graph.is_module_output(a0));
+	EXPECT_EQ(graph.drivers(a0).size(), 0);
+	EXPECT_EQ(graph.sinks(a0).size(), 2);
+	EXPECT_TRUE(graph.is_module_output(graph.net_index(SigBit(y, 0))));
+
+	auto inputs = graph.cell_inputs(graph.cell_index(conj));
+	std::vector<int> input_nets(inputs.begin(), inputs.end());
+	std::vector<int> expected = {-1, graph.net_index(SigBit(t, 0)), net, a0};
+	std::sort(input_nets.begin(), input_nets.end());
+	std::sort(expected.begin(), expected.end());
+	EXPECT_EQ(input_nets, expected);
+
+	CsrGraph cells = graph.cell_graph();
+	ASSERT_EQ(cells.num_nodes(), 2);
+	EXPECT_EQ(cells.out_degree(graph.cell_index(inv)), 2);
+	EXPECT_EQ(cells.out_degree(graph.cell_index(conj)), 0);
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "kernel/modtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelModtoolsTest, CachedModIndex)
+{
+	Design design;
+	Module *mod = design.addModule(ID(top));
+	Wire *a = mod->addWire(ID(a));
+	Wire *y = mod->addWire(ID(y));
+	a->port_input = true;
+	y->port_output = true;
+	mod->fixup_ports();
+	Cell *cell = mod->addNot(ID(inv), a, y);
+
+	ModIndex &index = ModIndex::cached(mod);
+	EXPECT_EQ(&ModIndex::cached(mod), &index);
+	EXPECT_TRUE(index.query_is_input(a));
+	EXPECT_TRUE(index.query_is_output(y));
+	EXPECT_EQ(GetSize(index.query_ports(y)), 1);
+
+	// notified edits are applied incrementally
+	Wire *b = mod->addWire(ID(b));
+	cell->setPort(ID::A, b);
+	EXPECT_FALSE(index.auto_reload_module);
+	EXPECT_EQ(GetSize(index.query_ports(a)), 0);
+	EXPECT_EQ(GetSize(index.query_ports(b)), 1);
+	index.check();
+
+	// renaming a wire is a blackout and forces a reload
+	mod->rename(b, ID(c));
+	EXPECT_TRUE(index.auto_reload_module);
+	EXPECT_EQ(&ModIndex::cached(mod), &index);
+	EXPECT_FALSE(index.auto_reload_module);
+	EXPECT_EQ(GetSize(index.query_ports(mod->wire(ID(c)))), 1);
+
+	ModIndex::drop_cached(mod);
+	EXPECT_EQ(mod->cached_index_, nullptr);
+	EXPECT_TRUE(mod->monitors.empty());
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelRegisterTest, ParallelForEach)
+{
+	Design design;
+	design.scratchpad_set_int("parallel.threads", 4);
+
+	std::vector<int> items;
+	for (int i = 0; i < 1000; i++)
+		items.push_back(i);
+
+	// the pool is reused between jobs, run a few to exercise that
+	for (int round = 0; round < 10; round++) {
+		PerThread<long> sums(&design);
+		EXPECT_EQ(GetSize(sums.slots), Pass::parallel_threads(&design));
+		Pass::parallel_for_each(&design, items, [&](int item) {
+			sums.local() += item;
+		});
+		long total = 0;
+		for (long sum : sums)
+			total += sum;
+		EXPECT_EQ(total, 999 * 1000 / 2);
+	}
+	EXPECT_EQ(Pass::parallel_worker(), 0);
+}
+
+TEST(KernelRegisterTest, TaskGroup)
+{
+	Design design;
+	design.scratchpad_set_int("parallel.threads", 3);
+
+	std::vector<int> results(5);
+	TaskGroup group(&design);
+	for (int i = 0; i < GetSize(results); i++)
+		group.add([&results, i]() { results[i] = i * i; });
+	group.wait();
+	EXPECT_TRUE(group.tasks.empty());
+
+	for (int i = 0; i < GetSize(results); i++)
+		EXPECT_EQ(results[i], i * i);
+}
+
+YOSYS_NAMESPACE_END
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include "kernel/rtlil.h"
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <thread>
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 
 namespace RTLIL {
@@ -20,6 +24,10 @@ namespace RTLIL {
 		KernelRtlilTest() {
 			if (log_files.empty()) log_files.emplace_back(stdout);
 		}
+
+		static const std::string *string_buffer(const Const &c) {
+			return c.get_if_str();
+		}
 	};
 
 	TEST_F(KernelRtlilTest, ConstAssignCompare)
@@ -44,6 +52,17 @@ namespace RTLIL {
 			EXPECT_TRUE(c1.is_str());
 			EXPECT_TRUE(c2.is_str());
 			EXPECT_TRUE(c3.is_str());
+			// copies share the string buffer
+			EXPECT_EQ(c1.get_if_str(), c3.get_if_str());
+			c3.bits()[0] = State::S0;
+			EXPECT_TRUE(c3.is_bits());
+			EXPECT_EQ(c1.decode_string(), "foo");
+			EXPECT_EQ(c2.decode_string(), "foo");
+			// moving takes over the buffer without another reference
+			const std::string *buf = c2.get_if_str();
+			Const c4(std::move(c2));
+			EXPECT_EQ(c4.get_if_str(), buf);
+			EXPECT_EQ(c2.size(), 0);
 		}
 
 		{
@@ -90,6 +109,370 @@ namespace RTLIL {
 
 	}
 
+	TEST_F(KernelRtlilTest, ConstArith)
+	{
+		Const a(-3, 8), b(5, 8);
+		EXPECT_EQ(const_add(a, b, true, true, 16), Const(2, 16));
+		EXPECT_EQ(const_add(a, b, false, false, 16), Const(258, 16));
+		EXPECT_EQ(const_sub(b, a, true, true, 16), Const(8, 16));
+		EXPECT_EQ(const_mul(a, b, true, true, 16), Const(-15, 16));
+		EXPECT_EQ(const_lt(a, b, true, true, 1), Const(State::S1));
+		EXPECT_EQ(const_lt(a, b, false, false, 1), Const(State::S0));
+		EXPECT_EQ(const_shl(b, Const(62, 8), false, false, 70).extract(62, 8), Const(5, 8));
+
+		// carries across 64-bit words
+		Const ones(State::S1, 100);
+		EXPECT_EQ(const_add(ones, Const(1, 2), false, false, 101), Const(State::S0, 100).extract(0, 101, State::S1));
+		EXPECT_EQ(const_mul(ones, ones, false, false, 100), Const(1, 100));
+
+		Const undef(State::Sx, 4);
+		EXPECT_EQ(const_add(undef, b, false, false, 8), Const(State::Sx, 8));
+
+		Const c(-7, 8), d(2, 8);
+		EXPECT_EQ(const_div(c, d, true, true, 8), Const(-3, 8));
+		EXPECT_EQ(const_mod(c, d, true, true, 8), Const(-1, 8));
+		EXPECT_EQ(const_divfloor(c, d, true, true, 8), Const(-4, 8));
+		EXPECT_EQ(const_modfloor(c, d, true, true, 8), Const(1, 8));
+		EXPECT_EQ(const_div(c, Const(0, 8), true, true, 8), Const(State::Sx, 8));
+		EXPECT_EQ(const_pow(Const(3, 8), Const(5, 8), false, false, 8), Const(243, 8));
+		EXPECT_EQ(const_pow(Const(-3, 8), Const(3, 8), true, false, 16), Const(-27, 16));
+		EXPECT_EQ(const_pow(Const(-1, 8), Const(-3, 8), true, true, 8), Const(-1, 8));
+
+		// operands too wide for the 64-bit fast path give the same results
+		Const c_wide = c.extract(0, 70, State::S1);
+		EXPECT_EQ(const_div(c_wide, d, true, true, 8), Const(-3, 8));
+		EXPECT_EQ(const_modfloor(c_wide, d, true, true, 8), Const(1, 8));
+		EXPECT_EQ(const_pow(c_wide, Const(3, 8), true, false, 16), Const(-343, 16));
+	}
+
+	TEST_F(KernelRtlilTest, ModuleObjectStorage)
+	{
+		Design design;
+		Module *mod = design.addModule(ID(top));
+		std::vector<Cell*> cells;
+		for (int i = 0; i < 100; i++) {
+			Wire *wire = mod->addWire(stringf("\\w%d", i), i + 1);
+			cells.push_back(mod->addNot(stringf("\\c%d", i), wire, mod->addWire(NEW_ID, i + 1)));
+		}
+		EXPECT_EQ(GetSize(mod->cells()), 100);
+
+		for (int i = 0; i < 100; i += 2)
+			mod->remove(cells[i]);
+		EXPECT_EQ(GetSize(mod->cells()), 50);
+		for (int i = 1; i < 100; i += 2)
+			EXPECT_EQ(mod->cell(stringf("\\c%d", i)), cells[i]);
+
+		// freed slots are reused
+		Cell *cell = mod->addNot(ID(again), mod->wire(ID(w0)), mod->addWire(NEW_ID));
+		EXPECT_NE(std::find(cells.begin(), cells.end(), cell), cells.end());
+
+		std::vector<Cell*> all_cells = mod->cells();
+		for (auto cell : all_cells)
+			mod->remove(cell);
+		pool<Wire*> all_wires;
+		for (auto wire : mod->wires())
+			all_wires.insert(wire);
+		mod->remove(all_wires);
+		EXPECT_EQ(GetSize(mod->cells()), 0);
+		EXPECT_EQ(GetSize(mod->wires()), 0);
+	}
+
+	TEST_F(KernelRtlilTest, ModuleConverged)
+	{
+		Design design;
+		Module *mod = design.addModule(ID(top));
+		Wire *a = mod->addWire(ID(a));
+		Wire *y = mod->addWire(ID(y));
+
+		// only tracked while the opt pass enables it
+		mod->mark_converged("opt_expr");
+		EXPECT_FALSE(mod->converged("opt_expr"));
+
+		design.scratchpad_set_bool("opt.skip_converged", true);
+		mod->mark_converged("opt_expr");
+		EXPECT_TRUE(mod->converged("opt_expr"));
+		EXPECT_FALSE(mod->converged("opt_merge"));
+
+		Cell *cell = mod->addNot(ID(inv), a, y);
+		EXPECT_FALSE(mod->converged("opt_expr"));
+		mod->mark_converged("opt_expr");
+		cell->setPort(ID::A, a);
+		EXPECT_TRUE(mod->converged("opt_expr"));
+		cell->setParam(ID::A_SIGNED, true);
+		EXPECT_FALSE(mod->converged("opt_expr"));
+		mod->mark_converged("opt_expr");
+		mod->connect(y, a);
+		EXPECT_FALSE(mod->converged("opt_expr"));
+	}
+
+	TEST_F(KernelRtlilTest, ModuleBatchScope)
+	{
+		struct CountingMonitor : Monitor {
+			int connects = 0, blackouts = 0;
+			void notify_connect(Cell*, const IdString&, const SigSpec&, const SigSpec&) override { connects++; }
+			void notify_connect(Module*, const SigSig&) override { connects++; }
+			void notify_blackout(Module*) override { blackouts++; }
+		} monitor;
+
+		Design design;
+		Module *mod = design.addModule(ID(top));
+		Wire *a = mod->addWire(ID(a));
+		Wire *y = mod->addWire(ID(y));
+		mod->monitors.insert(&monitor);
+
+		{
+			Module::BatchScope batch(mod);
+			pool<Cell*> cells;
+			for (int i = 0; i < 10; i++)
+				cells.insert(mod->addNot(stringf("\\inv%d", i), a, y));
+			mod->rename(a, ID(b));
+			mod->connect(y, a);
+			{
+				Module::BatchScope nested(mod);
+				mod->remove(cells);
+			}
+			EXPECT_EQ(monitor.blackouts, 0);
+		}
+		EXPECT_EQ(monitor.connects, 0);
+		EXPECT_EQ(monitor.blackouts, 1);
+		EXPECT_EQ(GetSize(mod->cells()), 0);
+		EXPECT_EQ(mod->wire(ID(b)), a);
+
+		mod->connect(y, a);
+		EXPECT_EQ(monitor.connects, 1);
+		mod->monitors.erase(&monitor);
+	}
+
+	TEST_F(KernelRtlilTest, SigSpecSingleChunk)
+	{
+		std::unique_ptr<Module> mod = std::make_unique<Module>();
+		Wire *a = mod->addWire(ID(a), 4);
+		Wire *b = mod->addWire(ID(b), 1);
+
+		SigSpec sig_a(a);
+		SigSpec sig_a_bits;
+		for (int i = 0; i < 4; i++)
+			sig_a_bits.append(SigBit(a, i));
+		SigSpec sig_a_vec(std::vector<SigBit>{SigBit(a, 0), SigBit(a, 1), SigBit(a, 2), SigBit(a, 3)});
+		SigSpec sig_a_chunks({SigSpec(a, 2, 2), SigSpec(a, 0, 2)});
+
+		EXPECT_TRUE(sig_a.is_wire());
+		EXPECT_EQ(sig_a, sig_a_bits);
+		EXPECT_EQ(sig_a, sig_a_vec);
+		EXPECT_EQ(sig_a, sig_a_chunks);
+		EXPECT_EQ(sig_a.hash_into(Hasher()).yield(), sig_a_vec.hash_into(Hasher()).yield());
+		EXPECT_FALSE(sig_a < sig_a_vec || sig_a_vec < sig_a);
+		EXPECT_EQ(sig_a.extract(1, 2), SigSpec(a, 1, 2));
+		EXPECT_EQ(GetSize(sig_a.chunks()), 1);
+		EXPECT_EQ(sig_a.bits()[3], SigBit(a, 3));
+
+		SigSpec sig_b = b;
+		EXPECT_EQ(sig_b.as_bit(), SigBit(b));
+		EXPECT_EQ(sig_b[0], SigBit(b));
+		sig_b[0] = State::S1;
+		EXPECT_TRUE(sig_b.is_fully_const());
+		EXPECT_EQ(sig_b, SigSpec(State::S1));
+		EXPECT_EQ(sig_b.as_const(), Const(State::S1));
+
+		SigSpec sig_mixed = b;
+		sig_mixed.append(State::S0);
+		sig_mixed.append(SigSpec(a, 0, 2));
+		sig_mixed.append(SigSpec(a, 2, 2));
+		EXPECT_EQ(sig_mixed, SigSpec({SigSpec(a), State::S0, b}));
+		sig_mixed.remove_const();
+		EXPECT_EQ(sig_mixed, SigSpec({SigSpec(a), b}));
+	}
+
+	TEST_F(KernelRtlilTest, SigSpecRemoveSortUnify)
+	{
+		std::unique_ptr<Module> mod = std::make_unique<Module>();
+		Wire *a = mod->addWire(ID(a), 32);
+		Wire *b = mod->addWire(ID(b), 4);
+
+		// every other bit of `a`, enough chunks for the indexed lookup
+		SigSpec pattern;
+		for (int i = 0; i < 32; i += 2)
+			pattern.append(SigBit(a, i));
+		pattern.append(SigBit(b, 3));
+
+		SigSpec sig = SigSpec({SigSpec(b), SigSpec(a), State::S1});
+		SigSpec other = SigSpec(State::S0, GetSize(sig));
+		for (int i = 0; i < GetSize(other); i++)
+			other[i] = i % 2 ? State::S1 : State::S0;
+
+		SigSpec removed = sig;
+		removed.remove2(pattern, &other);
+		SigSpec expected = State::S1;
+		for (int i = 1; i < 32; i += 2)
+			expected.append(SigBit(a, i));
+		expected.append(SigSpec(b, 0, 3));
+		EXPECT_EQ(removed, expected);
+		// the kept bits of `other` are the ones at the kept positions: 0, the
+		// even ones up to 32 for the odd bits of `a`, then 33 to 35 for `b`
+		SigSpec expected_other = SigSpec(State::S0, 17);
+		expected_other.append(State::S1);
+		expected_other.append(State::S0);
+		expected_other.append(State::S1);
+		EXPECT_EQ(other, expected_other);
+
+		// a few chunks are scanned directly, with the pattern aliasing the signal
+		SigSpec self = SigSpec(a, 0, 4);
+		self.remove(self);
+		EXPECT_EQ(GetSize(self), 0);
+
+		SigSpec from_pool = sig;
+		from_pool.remove(pattern.to_sigbit_pool());
+		EXPECT_EQ(from_pool, expected);
+
+		SigSpec unify = SigSpec({SigSpec(a, 4, 2), SigSpec(b), SigSpec(a, 0, 6), State::S0});
+		unify.sort_and_unify();
+		SigSpec sorted = unify;
+		sorted.sort();
+		EXPECT_EQ(unify, sorted);
+		EXPECT_EQ(GetSize(unify), 11);
+		EXPECT_EQ(unify.to_sigbit_pool(), SigSpec({SigSpec(a, 0, 6), SigSpec(b), State::S0}).to_sigbit_pool());
+	}
+
+	TEST_F(KernelRtlilTest, ModuleClone)
+	{
+		std::unique_ptr<Module> mod = std::make_unique<Module>();
+		mod->name = ID(top);
+		Wire *a = mod->addWire(ID(a), 4);
+		a->port_input = true;
+		Wire *b = mod->addWire(ID(b), 1);
+		Wire *y = mod->addWire(ID(y), 4);
+		y->port_output = true;
+		mod->fixup_ports();
+		mod->addAnd(ID(g), a, SigSpec(b).repeat(4), y);
+		mod->connect(SigSpec(b), SigSpec(a, 2));
+		Process *proc = mod->addProcess(ID(p));
+		proc->root_case.actions.push_back(SigSig(SigSpec(y, 0, 2), SigSpec(a, 1, 2)));
+
+		std::unique_ptr<Module> copy(mod->clone());
+		Wire *ca = copy->wire(ID(a)), *cb = copy->wire(ID(b)), *cy = copy->wire(ID(y));
+		ASSERT_TRUE(ca && cb && cy);
+		EXPECT_NE(ca, a);
+		EXPECT_EQ(ca->module, copy.get());
+		EXPECT_EQ(ca->port_id, 1);
+		EXPECT_EQ(cy->port_id, 2);
+		EXPECT_EQ(copy->ports, mod->ports);
+
+		Cell *cg = copy->cell(ID(g));
+		ASSERT_TRUE(cg != nullptr);
+		EXPECT_EQ(cg->module, copy.get());
+		EXPECT_EQ(cg->getPort(ID::A), SigSpec(ca));
+		EXPECT_EQ(cg->getPort(ID::B), SigSpec(cb).repeat(4));
+		EXPECT_EQ(cg->getPort(ID::Y), SigSpec(cy));
+
+		ASSERT_EQ(GetSize(copy->connections()), 1);
+		EXPECT_EQ(copy->connections()[0].first, SigSpec(cb));
+		EXPECT_EQ(copy->connections()[0].second, SigSpec(ca, 2));
+
+		Process *cp = copy->processes.at(ID(p));
+		ASSERT_EQ(GetSize(cp->root_case.actions), 1);
+		EXPECT_EQ(cp->root_case.actions[0].first, SigSpec(cy, 0, 2));
+		EXPECT_EQ(cp->root_case.actions[0].second, SigSpec(ca, 1, 2));
+	}
+
+	TEST_F(KernelRtlilTest, ConstInterned)
+	{
+		Const a = Const::interned("file.v:1.2-3.4");
+		Const b = Const::interned(std::string("file.v:") + "1.2-3.4");
+		EXPECT_EQ(a, b);
+		EXPECT_TRUE(a.flags & CONST_FLAG_STRING);
+		EXPECT_EQ(a.decode_string(), "file.v:1.2-3.4");
+
+		// unused strings are dropped as the table grows, used ones stay valid
+		for (int i = 0; i < 5000; i++)
+			Const::interned(stringf("file.v:%d.1-%d.2", i, i));
+		EXPECT_EQ(a.decode_string(), "file.v:1.2-3.4");
+		EXPECT_EQ(Const::interned("file.v:1.2-3.4"), a);
+
+		Design design;
+		Module *mod = design.addModule(ID(top));
+		Wire *w = mod->addWire(ID(w));
+		w->set_src_attribute("file.v:1.2-3.4");
+		EXPECT_EQ(w->attributes.at(ID::src), a);
+		EXPECT_EQ(w->get_src_attribute(), "file.v:1.2-3.4");
+		EXPECT_EQ(string_buffer(w->attributes.at(ID::src)), string_buffer(a));
+	}
+
+	TEST_F(KernelRtlilTest, ConstInternedRtlilFrontend)
+	{
+		yosys_setup();
+		const char *text =
+			"module \\top\n"
+			"  attribute \\src \"file.v:1.2-3.4\"\n"
+			"  wire \\a\n"
+			"  attribute \\src \"file.v:1.2-3.4\"\n"
+			"  wire \\b\n"
+			"end\n";
+
+		for (auto command : {"read_rtlil", "read_rtlil -legacy"}) {
+			Design design;
+			std::istringstream f(text);
+			Frontend::frontend_call(&design, &f, "<input>", command);
+			Module *mod = design.module(ID(top));
+			ASSERT_NE(mod, nullptr);
+			const Const &src_a = mod->wire(ID(a))->attributes.at(ID::src);
+			const Const &src_b = mod->wire(ID(b))->attributes.at(ID::src);
+			EXPECT_EQ(src_a.decode_string(), "file.v:1.2-3.4");
+			EXPECT_EQ(string_buffer(src_a), string_buffer(src_b)) << command;
+		}
+	}
+
+	TEST_F(KernelRtlilTest, IdStringAutoId)
+	{
+		int first = autoidx;
+		int line = __LINE__; IdString a = NEW_ID; IdString b = NEW_ID;
+		EXPECT_NE(a, b);
+
+		// looking up the text before the name was printed finds the same name
+		std::string expected = stringf("$auto$rtlilTest.cc:%d:TestBody$%d", line, first);
+		EXPECT_EQ(IdString(expected), a);
+		EXPECT_EQ(a.str(), expected);
+		EXPECT_TRUE(b.begins_with("$auto$rtlilTest.cc:"));
+		EXPECT_EQ(b.str(), stringf("$auto$rtlilTest.cc:%d:TestBody$%d", line, first + 1));
+
+		// names freed before they were printed leave no trace
+		for (int i = 0; i < 5000; i++)
+			IdString tmp = NEW_ID;
+		line = __LINE__; IdString c = NEW_ID;
+		EXPECT_EQ(c.str(), stringf("$auto$rtlilTest.cc:%d:TestBody$%d", line, first + 5002));
+		EXPECT_EQ(IdString(c.str()), c);
+	}
+
+#ifdef YOSYS_ENABLE_THREADS
+	TEST_F(KernelRtlilTest, IdStringConcurrentInterning)
+	{
+		const int num_threads = 4;
+		const int num_ids = 1000;
+		std::vector<std::vector<IdString>> ids(num_threads);
+
+		{
+			IdString::ConcurrentScope scope;
+			std::vector<std::thread> threads;
+			for (int t = 0; t < num_threads; t++)
+				threads.emplace_back([&, t]() {
+					for (int i = 0; i < num_ids; i++) {
+						ids[t].push_back(stringf("\\concurrent_%d", i));
+						IdString tmp = stringf("\\concurrent_tmp_%d_%d", t, i);
+						ids[t].push_back(tmp);
+					}
+				});
+			for (auto &thread : threads)
+				thread.join();
+		}
+
+		for (int t = 1; t < num_threads; t++)
+			for (int i = 0; i < num_ids; i++)
+				EXPECT_EQ(ids[t][2*i], ids[0][2*i]);
+		for (int i = 0; i < num_ids; i++)
+			EXPECT_EQ(ids[0][2*i].str(), stringf("\\concurrent_%d", i));
+		EXPECT_EQ(ids[1][1].str(), "\\concurrent_tmp_1_0");
+	}
+#endif
+
 	class WireRtlVsHdlIndexConversionTest :
 		public KernelRtlilTest,
 		public testing::WithParamInterface<std::tuple<bool, int, int>>
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelSigtoolsTest, IncrementalSigMap)
+{
+	Design design;
+	Module *mod = design.addModule(ID(top));
+	Wire *a = mod->addWire(ID(a), 2);
+	Wire *b = mod->addWire(ID(b), 2);
+	Wire *c = mod->addWire(ID(c), 2);
+
+	IncrementalSigMap sigmap(mod);
+	EXPECT_EQ(sigmap(a), SigSpec(a));
+
+	// connections are merged in without a rebuild
+	mod->connect(a, b);
+	EXPECT_FALSE(sigmap.stale);
+	EXPECT_EQ(sigmap(a), sigmap(b));
+	mod->connect(b, State::S1);
+	EXPECT_EQ(sigmap(a), SigSpec(State::S1, 2));
+
+	// constant bits on the left hand side are ignored, as by connect()
+	mod->connect(SigSpec({State::S0, SigBit(c, 0)}), SigSpec(a));
+	EXPECT_EQ(sigmap(SigBit(c, 0)), State::S1);
+	EXPECT_EQ(sigmap(SigBit(c, 1)), SigBit(c, 1));
+
+	// replacing the connection list forces a rebuild
+	mod->new_connections({});
+	EXPECT_TRUE(sigmap.stale);
+	EXPECT_EQ(sigmap(a), SigSpec(a));
+	EXPECT_FALSE(sigmap.stale);
+
+	SigMap full(mod);
+	for (auto wire : mod->wires())
+		EXPECT_EQ(sigmap(wire), full(wire));
+}
+
+TEST(KernelSigtoolsTest, SigPool)
+{
+	Design design;
+	Module *mod = design.addModule(ID(top));
+	Wire *a = mod->addWire(ID(a), 4);
+	Wire *b = mod->addWire(ID(b), 4);
+
+	SigPool pool;
+	pool.add(std::vector<SigBit>{SigBit(b, 2), State::S1, SigBit(a, 3), SigBit(a, 0)});
+	pool.add(SigBit(a, 3));
+	EXPECT_EQ(pool.size(), 3u);
+	EXPECT_TRUE(pool.check(SigBit(a, 0)));
+	EXPECT_FALSE(pool.check(SigBit(a, 1)));
+	EXPECT_FALSE(pool.check(State::S1));
+	EXPECT_TRUE(pool.check_any(a));
+	EXPECT_FALSE(pool.check_all(a));
+	EXPECT_EQ(pool.extract(a), SigSpec(std::vector<SigBit>{SigBit(a, 0), SigBit(a, 3)}));
+	EXPECT_EQ(pool.remove(a), SigSpec(std::vector<SigBit>{SigBit(a, 1), SigBit(a, 2)}));
+
+	// wires in the order they were added, bits in offset order
+	EXPECT_EQ(pool.export_all(), SigSpec(std::vector<SigBit>{SigBit(b, 2), SigBit(a, 0), SigBit(a, 3)}));
+	EXPECT_EQ(pool.export_one(), SigSpec(SigBit(a, 0)));
+
+	pool.expand(SigSpec(b), SigSpec(a));
+	EXPECT_TRUE(pool.check(SigBit(a, 2)));
+	pool.del(SigSpec(a));
+	EXPECT_EQ(pool.size(), 1u);
+	EXPECT_FALSE(pool.check_any(a));
+
+	SigPool other;
+	other.add(SigSpec(b));
+	pool.add(other);
+	EXPECT_TRUE(pool.check_all(b));
+	pool.del(other);
+	EXPECT_EQ(pool.size(), 0u);
+	EXPECT_EQ(pool.export_one(), SigSpec());
+}
+
+TEST(KernelSigtoolsTest, SigSet)
+{
+	Design design;
+	Module *mod = design.addModule(ID(top));
+	Wire *a = mod->addWire(ID(a), 2);
+	Wire *b = mod->addWire(ID(b), 2);
+
+	SigSet<int> set;
+	set.insert(a, 3);
+	set.insert(SigBit(a, 1), 1);
+	set.insert(SigBit(a, 1), 3);
+	set.insert(SigBit(b, 0), std::set<int>{2, 1});
+	EXPECT_EQ(set.find(SigBit(a, 0)), std::set<int>({3}));
+	EXPECT_EQ(set.find(SigBit(a, 1)), std::set<int>({1, 3}));
+	EXPECT_EQ(set.find(SigSpec({SigBit(a, 0), SigBit(b, 0)})), std::set<int>({1, 2, 3}));
+	EXPECT_TRUE(set.has(b));
+	EXPECT_FALSE(set.has(SigBit(b, 1)));
+
+	set.erase(SigBit(a, 1), 3);
+	EXPECT_EQ(set.find(SigBit(a, 1)), std::set<int>({1}));
+	set.erase(b);
+	EXPECT_FALSE(set.has(b));
+	EXPECT_TRUE(set.find(b).empty());
+
+	pool<int> found;
+	set.find(a, found);
+	EXPECT_EQ(GetSize(found), 2);
+}
+
+YOSYS_NAMESPACE_END
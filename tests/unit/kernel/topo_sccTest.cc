@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include "kernel/topo_scc.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelTopoSccTest, CsrSccs)
+{
+	// 0 -> 1 <-> 2 -> 3, 3 -> 4 -> 5 -> 3, 5 -> 6, 7 (isolated)
+	std::vector<std::pair<int, int>> edges = {
+		{0, 1}, {1, 2}, {2, 1}, {2, 3}, {3, 4}, {4, 5}, {5, 3}, {5, 6},
+	};
+	CsrGraph graph(8, edges);
+	EXPECT_EQ(graph.num_edges(), 8);
+	EXPECT_EQ(graph.out_degree(5), 2);
+	EXPECT_EQ(graph.in_degree(3), 2);
+
+	std::vector<int> scc_index;
+	int num_sccs = csr_sccs(graph, scc_index);
+	EXPECT_EQ(num_sccs, 5);
+	EXPECT_EQ(scc_index[1], scc_index[2]);
+	EXPECT_EQ(scc_index[3], scc_index[4]);
+	EXPECT_EQ(scc_index[3], scc_index[5]);
+	EXPECT_NE(scc_index[0], scc_index[1]);
+	EXPECT_NE(scc_index[1], scc_index[3]);
+
+	// edges between SCCs go from higher to lower indices
+	for (auto &edge : edges)
+		if (scc_index[edge.first] != scc_index[edge.second]) {
+			EXPECT_GT(scc_index[edge.first], scc_index[edge.second]);
+		}
+
+	std::vector<std::vector<int>> levels;
+	EXPECT_FALSE(topo_levels(graph, levels));
+}
+
+TEST(KernelTopoSccTest, TopoLevels)
+{
+	CsrGraph graph(5, {{0, 2}, {1, 2}, {2, 3}, {0, 3}});
+	std::vector<std::vector<int>> levels;
+	EXPECT_TRUE(topo_levels(graph, levels));
+	std::vector<std::vector<int>> expected = {{0, 1, 4}, {2}, {3}};
+	EXPECT_EQ(levels, expected);
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+set -ex
+
+# mutate -apply must build the same design as running the mutation list as a
+# script, and mutate -eval must kill exactly the mutations that change an
+# output, checked with sat for each mutation
+cat > mutate_eval.v <<EOT
+module top (input [1:0] a, b, input c, output [1:0] y, output z);
+	assign y = c ? a + b : a & b;
+	assign z = (a == b) | (c & a[0]);
+endmodule
+EOT
+
+../../yosys -q -p "read_verilog mutate_eval.v; proc; mutate -list 20 -seed 1 -none -ctrl mutsel 8 0 -o mutate_eval.list"
+test $(grep -c '^mutate ' mutate_eval.list) -gt 2
+
+../../yosys -q -p "read_verilog mutate_eval.v; proc; design -save orig" \
+	-p "script mutate_eval.list; design -stash gold" \
+	-p "design -load orig; mutate -apply mutate_eval.list; write_rtlil mutate_eval.il" \
+	-p "design -copy-from gold -as gold top; rename top gate" \
+	-p "miter -equiv -flatten -make_assert gold gate miter; sat -verify -prove-asserts miter"
+
+# 5 input bits, so 500 random cycles hit every input pattern
+../../yosys -q -p "read_rtlil mutate_eval.il; hierarchy -top top; mutate -eval mutate_eval.list -cycles 500 -seed 1 -o mutate_eval.out"
+test $(wc -l < mutate_eval.out) -eq $(grep -vc -- '-mode none' mutate_eval.list)
+
+none=$(awk '/-mode none/ { for (i = 1; i < NF; i++) if ($i == "-ctrl") print $(i+3) }' mutate_eval.list)
+while read value result; do
+	cat > mutate_eval_wrap.v <<EOT
+module wrap (input [1:0] a, b, input c, output diff);
+	wire [1:0] y0, y1;
+	wire z0, z1;
+	top u0 (.mutsel(8'd$none), .a(a), .b(b), .c(c), .y(y0), .z(z0));
+	top u1 (.mutsel(8'd$value), .a(a), .b(b), .c(c), .y(y1), .z(z1));
+	assign diff = {y0, z0} != {y1, z1};
+endmodule
+EOT
+	../../yosys -p "read_rtlil mutate_eval.il; read_verilog mutate_eval_wrap.v; hierarchy -top wrap; flatten; sat -prove diff 0" > mutate_eval_sat.log
+	if grep -q 'SAT proof finished - model found: FAIL!' mutate_eval_sat.log; then
+		test $result = killed
+	else
+		grep -q 'SAT proof finished - no model found: SUCCESS!' mutate_eval_sat.log
+		test $result = survived
+	fi
+done < mutate_eval.out
+
+rm -f mutate_eval.v mutate_eval.list mutate_eval.il mutate_eval.out mutate_eval_wrap.v mutate_eval_sat.log
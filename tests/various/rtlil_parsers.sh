@@ -0,0 +1,89 @@
+#!/usr/bin/env bash
+# The default RTLIL parser and the flex/bison one selected with -legacy read
+# the same designs and report the same errors in the same lines.
+
+set -e
+trap 'echo "ERROR in rtlil_parsers.sh" >&2; exit 1' ERR
+mkdir -p temp
+
+for f in rtlil_parsers.il ../opt/opt_lut_elim.il ../opt/opt_lut_port.il ../sim/vector_assign.il; do
+	../../yosys -q -p "read_rtlil $f; write_rtlil temp/rtlil_parsers_default.il"
+	../../yosys -q -p "read_rtlil -legacy $f; write_rtlil temp/rtlil_parsers_legacy.il"
+	cmp temp/rtlil_parsers_default.il temp/rtlil_parsers_legacy.il
+done
+
+# reads the input from stdin, both parsers have to reject it with $1
+check_error() {
+	cat > temp/rtlil_parsers_error.il
+	for parser in default legacy; do
+		flag=
+		if [ $parser = legacy ]; then flag=-legacy; fi
+		if ../../yosys -q -p "read_rtlil $flag temp/rtlil_parsers_error.il" > temp/rtlil_parsers_$parser.log 2>&1; then
+			echo "read_rtlil $flag accepted invalid input" >&2
+			exit 1
+		fi
+		grep -F "ERROR: $1" temp/rtlil_parsers_$parser.log
+	done
+	diff <(grep "ERROR:" temp/rtlil_parsers_default.log) <(grep "ERROR:" temp/rtlil_parsers_legacy.log)
+}
+
+check_error 'Parser error in line 2: syntax error' <<'EOT'
+module \top
+  wire width \a
+end
+EOT
+
+check_error 'Parser error in line 2: syntax error' <<'EOT'
+module \top
+  wire frob \a
+end
+EOT
+
+check_error 'Parser error in line 3: syntax error' <<'EOT'
+module \top
+  wire \a
+EOT
+
+check_error 'Parser error in line 2: RTLIL error: wire \a not found' <<'EOT'
+module \top
+  connect \a 1'0
+end
+EOT
+
+check_error 'Parser error in line 4: RTLIL error: redefinition of wire \a.' <<'EOT'
+module \top
+  wire \a
+  wire \a
+end
+EOT
+
+check_error 'Parser error in line 4: RTLIL error: redefinition of module \top.' <<'EOT'
+module \top
+end
+module \top
+end
+EOT
+
+check_error 'Parser error in line 3: bit index out of range' <<'EOT'
+module \top
+  wire width 2 \a
+  connect \a [2] 1'0
+end
+EOT
+
+check_error 'Parser error in line 3: invalid slice' <<'EOT'
+module \top
+  wire width 4 \a
+  connect \a [1:2] 2'00
+end
+EOT
+
+check_error 'Parser error in line 3: dangling attribute' <<'EOT'
+module \top
+  attribute \keep 1
+end
+EOT
+
+check_error 'Parser error in line 2: dangling attribute' <<'EOT'
+attribute \keep 1
+EOT
@@ -0,0 +1,19 @@
+#!/usr/bin/env bash
+set -ex
+rm -rf script_checkpoint.d script_checkpoint_*.log script_checkpoint_*.il
+cmd="scratchpad -set script.checkpoint_dir script_checkpoint.d; synth -top uut"
+../../yosys -q -l script_checkpoint_1.log -p "$cmd; write_rtlil script_checkpoint_1.il" async.v
+test $(grep -c "Saved checkpoint for label" script_checkpoint_1.log) -eq 3
+for f in script_checkpoint.d/*.rtlil; do
+	head -c 6 $f | grep -q RTLIL
+done
+../../yosys -q -l script_checkpoint_2.log -p "$cmd; write_rtlil script_checkpoint_2.il" async.v
+grep -q "Resuming at label \`check'" script_checkpoint_2.log
+! grep -q "Saved checkpoint" script_checkpoint_2.log
+# the resumed run ends with the same design as the full run
+cmp script_checkpoint_1.il script_checkpoint_2.il
+../../yosys -q -l script_checkpoint_3.log -p "$cmd -noabc; write_rtlil script_checkpoint_3.il" async.v
+grep -q "Resuming at label \`fine'" script_checkpoint_3.log
+../../yosys -q -p "synth -top uut -noabc; write_rtlil script_checkpoint_4.il" async.v
+cmp script_checkpoint_3.il script_checkpoint_4.il
+rm -rf script_checkpoint.d script_checkpoint_*.log script_checkpoint_*.il
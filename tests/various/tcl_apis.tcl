@@ -61,3 +61,38 @@ rtlil::set_attr -mod -sint top prime 87178291199
 if {[rtlil::get_attr -mod -int top prime] != 87178291199} {
 	error "bad int roundtrip 7"
 }
+
+if {[lsort [rtlil::module_list]] != "m top"} {
+	error "bad module list"
+}
+
+if {[rtlil::cell_list -type top] != "inst m"} {
+	error "bad cell list"
+}
+
+# names returned by the list commands are valid arguments
+foreach wire [rtlil::wire_list top] {
+	if {[rtlil::wire_width top $wire] != 1} {
+		error "bad wire width"
+	}
+}
+foreach cell [rtlil::cell_list top] {
+	if {[rtlil::cell_type top $cell] != "m"} {
+		error "bad cell type"
+	}
+	if {[rtlil::get_conn top $cell] != ""} {
+		error "bad connections"
+	}
+}
+
+if {[dict get [rtlil::get_attrs -mod top] foo] != "bar"} {
+	error "bad module attributes"
+}
+
+if {![dict exists [rtlil::get_attrs top w] dont_touch]} {
+	error "bad wire attributes"
+}
+
+if {[dict get [rtlil::get_params top inst] PARAM] != "11111111111111111111111111111101"} {
+	error "bad cell parameters"
+}
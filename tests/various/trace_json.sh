@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+
+trap 'echo "ERROR in trace_json.sh" >&2; exit 1' ERR
+
+mkdir -p temp
+../../yosys -q --trace-json temp/trace_json.json -p "opt -fast; stat"
+
+# begin and end events must pair up, with nested calls inside their parents
+python3 - temp/trace_json.json << "EOT"
+import json, sys
+events = [e for e in json.load(open(sys.argv[1])) if e["ph"] in "BE"]
+stack = []
+for e in events:
+	if e["ph"] == "B":
+		stack.append(e)
+	else:
+		assert stack.pop()["ts"] <= e["ts"]
+assert not stack
+names = [e["name"] for e in events if e["ph"] == "B"]
+assert names[0] == "opt" and "opt_clean" in names and names[-1] == "stat", names
+assert events[0]["args"]["command"] == "opt -fast"
+assert "cells" in events[0]["args"]
+EOT
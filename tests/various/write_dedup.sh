@@ -0,0 +1,53 @@
+#!/usr/bin/env bash
+set -ex
+
+# write_btor -dedup and write_smt2 -dedup drop repeated expressions; the
+# result must describe the same model as the normal output
+cat > write_dedup.v <<EOT
+module top #(parameter FAIL = 0) (input clk, input [7:0] a, b, output [3:0] y, z);
+	reg [7:0] r = 0;
+	always @(posedge clk) r <= a ^ b;
+	assign y = r[3:0] & a[3:0];
+	assign z = (r[3:0] & a[3:0]) | {r[1:0], r[1:0]};
+	always @* begin
+		assert(y == (r[3:0] & a[3:0]));
+		assert(z[1:0] == (y[1:0] | r[1:0]));
+		if (FAIL)
+			assert(r[3:0] != 4'hf);
+	end
+endmodule
+EOT
+
+for fail in 0 1; do
+	../../yosys -q -p "read_verilog -formal write_dedup.v; chparam -set FAIL $fail top; prep -top top; flatten; chformal -lower" \
+		-p "write_btor -i write_dedup_$fail.info write_dedup_$fail.btor" \
+		-p "write_btor -dedup -i write_dedup_${fail}_dedup.info write_dedup_${fail}_dedup.btor" \
+		-p "write_smt2 write_dedup_$fail.smt2" \
+		-p "write_smt2 -dedup write_dedup_${fail}_dedup.smt2"
+
+	# repeated slices and ANDs are dropped, inputs, states and properties are not
+	test $(grep -vc '^;' write_dedup_${fail}_dedup.btor) -lt $(grep -vc '^;' write_dedup_$fail.btor)
+	for op in input state bad; do
+		test $(grep -c "^[0-9]* $op " write_dedup_${fail}_dedup.btor) -eq $(grep -c "^[0-9]* $op " write_dedup_$fail.btor)
+	done
+	test $(grep -c '^(define-fun' write_dedup_${fail}_dedup.smt2) -lt $(grep -c '^(define-fun' write_dedup_$fail.smt2)
+
+	# the info file only refers to nodes that are still written
+	awk '$1 ~ /^[0-9]+$/ { nids[$1] = 1 }
+		FILENAME ~ /\.info$/ && ($1 == "bad" || $1 == "posedge" || $1 == "negedge" || $1 == "event") && !($2 in nids) { print "missing node " $2; exit 1 }' \
+		write_dedup_${fail}_dedup.btor write_dedup_${fail}_dedup.info
+	test $(grep -c '^bad ' write_dedup_${fail}_dedup.info) -eq $(grep -c '^bad ' write_dedup_$fail.info)
+
+	# both outputs give the same verdict
+	if command -v btormc > /dev/null; then
+		test "$(btormc -kmax 4 write_dedup_$fail.btor | head -n 1)" = "$(btormc -kmax 4 write_dedup_${fail}_dedup.btor | head -n 1)"
+	fi
+	if command -v yices-smt2 > /dev/null; then
+		status=0; ../../yosys-smtbmc -s yices -t 4 write_dedup_$fail.smt2 > write_dedup_$fail.out || status=$?
+		status_dedup=0; ../../yosys-smtbmc -s yices -t 4 write_dedup_${fail}_dedup.smt2 > write_dedup_${fail}_dedup.out || status_dedup=$?
+		test $status -eq $status_dedup
+		if [ $fail = 0 ]; then test $status -eq 0; else test $status -ne 0; fi
+	fi
+done
+
+rm -f write_dedup.v write_dedup_*.btor write_dedup_*.info write_dedup_*.smt2 write_dedup_*.out